@@ -16,27 +16,70 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/node_hash_map.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/carnot/carnot.h"
 #include "src/carnot/engine_state.h"
 #include "src/carnot/exec/exec_graph.h"
+#include "src/carnot/exec/ml/transformer_executor.h"
 #include "src/carnot/funcs/builtins/builtins.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/plan.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
+#include "src/carnot/planner/plan_cache.h"
+#include "src/carnot/result_cache.h"
 #include "src/carnot/udf/registry.h"
+#include "src/common/metrics/named_timer.h"
 #include "src/common/perf/perf.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int32(carnot_plan_cache_size, gflags::Int32FromEnv("PL_CARNOT_PLAN_CACHE_SIZE", 128),
+             "The number of compiled plans that Carnot keeps around for the queries that it "
+             "executes again. 0 disables the plan cache.");
+DEFINE_int32(carnot_result_cache_size, gflags::Int32FromEnv("PL_CARNOT_RESULT_CACHE_SIZE", 0),
+             "The number of query results that Carnot keeps around for identical plans that read "
+             "local tables. 0 disables the result cache.");
+DEFINE_int32(carnot_result_cache_bucket_ms,
+             gflags::Int32FromEnv("PL_CARNOT_RESULT_CACHE_BUCKET_MS", 10000),
+             "The time buckets in which executions of the same plan share a cached result, which "
+             "bounds how stale a result gets, as the data that arrives in the meantime isn't in "
+             "it.");
+DEFINE_int32(carnot_transformer_warm_executors,
+             gflags::Int32FromEnv("PL_CARNOT_TRANSFORMER_WARM_EXECUTORS", 0),
+             "The number of Transformer model executors that Carnot loads when it starts, so that "
+             "the first queries that embed text don't pay for loading the model.");
+
 namespace px {
 namespace carnot {
 
 using types::DataType;
 
+namespace {
+
+// Whether the plan writes to the table store, where the batches outlive the query.
+bool HasMemorySink(const planpb::Plan& plan) {
+  for (const auto& pf : plan.nodes()) {
+    for (const auto& node : pf.nodes()) {
+      if (node.op().op_type() == planpb::MEMORY_SINK_OPERATOR) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 class CarnotImpl final : public Carnot {
  public:
   ~CarnotImpl() override;
@@ -61,15 +104,58 @@ class CarnotImpl final : public Carnot {
   Status ExecuteQuery(const std::string& query, const sole::uuid& query_id,
                       types::Time64NSValue time_now, bool analyze) override;
 
-  Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze) override;
+  Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze,
+                     std::shared_ptr<exec::QueryScheduler::Ticket> ticket) override;
+
+  Status RegisterContinuousQuery(const std::string& query, const sole::uuid& query_id,
+                                 types::Time64NSValue time_now) override;
+  Status RegisterContinuousPlan(const planpb::Plan& plan, const sole::uuid& query_id) override;
+  Status TickContinuousQuery(const sole::uuid& query_id) override;
+  Status UnregisterContinuousQuery(const sole::uuid& query_id) override;
 
   void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) override {
     agent_md_callback_ = func;
   };
 
+  void RegisterResultStreamMuxStubGenerator(
+      const exec::ResultStreamMuxStubGenerator& stub_generator) override {
+    engine_state_->set_result_stream_mux_pool(
+        std::make_unique<exec::ResultStreamMuxPool>(stub_generator));
+  }
+
+  void RegisterMemorySinkCallback(const std::string& table_name,
+                                  exec::MemorySinkCallback callback) override {
+    engine_state_->set_memory_sink_callback(table_name, std::move(callback));
+  }
+
   const udf::Registry* FuncRegistry() const override { return engine_state_->func_registry(); }
 
+  int64_t QueryMemoryBytes() const override {
+    return engine_state_->query_memory_tracker().bytes();
+  }
+
+  exec::QueryScheduler* query_scheduler() override { return engine_state_->query_scheduler(); }
+
  private:
+  // The state of a registered continuous query, which outlives the calls that drive it.
+  struct ContinuousQuery {
+    plan::Plan plan;
+    std::unique_ptr<exec::ExecState> exec_state;
+    std::unique_ptr<plan::PlanState> plan_state;
+    std::unique_ptr<table_store::schema::Schema> schema;
+    std::vector<std::unique_ptr<exec::ExecutionGraph>> exec_graphs;
+    int64_t exec_time_ns = 0;
+    // Serializes the ticks of the query, and the tick with the teardown.
+    absl::Mutex lock;
+  };
+
+  StatusOr<planpb::Plan> CompileToPlan(const std::string& query, types::Time64NSValue time_now);
+  StatusOr<planpb::Plan> CompileToPlanUncached(const std::string& query,
+                                               types::Time64NSValue time_now);
+  // Identifies the tables and their relations that queries are compiled against.
+  std::string SchemaVersion();
+  StatusOr<ContinuousQuery*> GetContinuousQuery(const sole::uuid& query_id);
+
   Status RegisterUDFs(exec::ExecState* exec_state, plan::Plan* plan);
 
   Status RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan::PlanFragment* pf);
@@ -93,6 +179,8 @@ class CarnotImpl final : public Carnot {
   AgentMetadataCallbackFunc agent_md_callback_;
   planner::compiler::Compiler compiler_;
   std::unique_ptr<EngineState> engine_state_;
+  std::unique_ptr<planner::PlanCache<planpb::Plan>> plan_cache_;
+  std::unique_ptr<ResultCache> result_cache_;
 
   std::shared_ptr<grpc::ServerCredentials> grpc_server_creds_;
   std::unique_ptr<std::thread> grpc_server_thread_;
@@ -102,6 +190,10 @@ class CarnotImpl final : public Carnot {
 
   // The id of the agent that owns this Carnot instance.
   sole::uuid agent_id_;
+
+  absl::Mutex continuous_queries_lock_;
+  absl::node_hash_map<sole::uuid, std::unique_ptr<ContinuousQuery>> continuous_queries_
+      ABSL_GUARDED_BY(continuous_queries_lock_);
 };
 
 Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registry> func_registry,
@@ -121,11 +213,41 @@ Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registr
   PL_ASSIGN_OR_RETURN(engine_state_, EngineState::CreateDefault(
                                          std::move(func_registry), table_store, stub_generator,
                                          add_auth_to_grpc_context_func, grpc_router_.get()));
+  if (FLAGS_carnot_transformer_warm_executors > 0) {
+    engine_state_->model_pool()->WarmUp<exec::ml::TransformerExecutor>(
+        FLAGS_carnot_transformer_warm_executors);
+  }
+  plan_cache_ =
+      std::make_unique<planner::PlanCache<planpb::Plan>>(std::max(FLAGS_carnot_plan_cache_size, 0));
+  if (FLAGS_carnot_result_cache_size > 0 && FLAGS_carnot_result_cache_bucket_ms > 0) {
+    result_cache_ = std::make_unique<ResultCache>(FLAGS_carnot_result_cache_size);
+  }
   return Status::OK();
 }
 
-Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& query_id,
-                                types::Time64NSValue time_now, bool analyze) {
+std::string CarnotImpl::SchemaVersion() {
+  auto rel_map = table_store()->GetRelationMap();
+  std::map<std::string, std::string> sorted_relations;
+  for (const auto& [name, relation] : *rel_map) {
+    sorted_relations[name] = relation.DebugString();
+  }
+  std::string version;
+  for (const auto& [name, relation] : sorted_relations) {
+    absl::StrAppend(&version, name, relation, "\n");
+  }
+  return version;
+}
+
+StatusOr<planpb::Plan> CarnotImpl::CompileToPlan(const std::string& query,
+                                                 types::Time64NSValue time_now) {
+  auto key = planner::PlanCacheKey(query, {}, SchemaVersion());
+  return plan_cache_->GetOrCompile(key, time_now, [&](types::Time64NSValue compile_time) {
+    return CompileToPlanUncached(query, compile_time);
+  });
+}
+
+StatusOr<planpb::Plan> CarnotImpl::CompileToPlanUncached(const std::string& query,
+                                                         types::Time64NSValue time_now) {
   // Compile the query.
   auto compiler_state = engine_state_->CreateLocalExecutionCompilerState(time_now);
   PL_ASSIGN_OR_RETURN(auto logical_plan, compiler_.CompileToIR(query, compiler_state.get()));
@@ -134,8 +256,13 @@ Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& quer
   // rules in these test envs.
   planner::distributed::AnnotateAbortableSourcesForLimitsRule rule;
   PL_RETURN_IF_ERROR(rule.Execute(logical_plan.get()));
-  PL_ASSIGN_OR_RETURN(auto plan_proto, logical_plan->ToProto());
-  return ExecutePlan(plan_proto, query_id, analyze);
+  return logical_plan->ToProto();
+}
+
+Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& query_id,
+                                types::Time64NSValue time_now, bool analyze) {
+  PL_ASSIGN_OR_RETURN(auto plan_proto, CompileToPlan(query, time_now));
+  return ExecutePlan(plan_proto, query_id, analyze, /* ticket */ nullptr);
 }
 
 /**
@@ -172,6 +299,7 @@ Status CarnotImpl::RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan:
         return WalkExpression(exec_state, *filter.expression());
       })
       .OnLimit(no_op)
+      .OnTopK(no_op)
       .OnMemorySink(no_op)
       .OnMemorySource(no_op)
       .OnUnion(no_op)
@@ -217,6 +345,7 @@ void CarnotImpl::GRPCServerFunc() {
 
   builder.AddListeningPort(server_address, grpc_server_creds_);
   builder.RegisterService(grpc_router_.get());
+  builder.RegisterService(grpc_router_->mux_service());
   grpc_server_ = builder.BuildAndStart();
   std::cout << "Server listening on " << server_address << std::endl;
   CHECK(grpc_server_ != nullptr);
@@ -274,7 +403,10 @@ Status SendFinalExecutionStatsToOutgoingConns(
 }
 
 Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
-                               bool analyze) {
+                               bool analyze, std::shared_ptr<exec::QueryScheduler::Ticket> ticket) {
+  profiler::ScopedProfileTag profile_tag("carnot_query", query_id.str());
+  static auto* execute_plan_timer = new metrics::NamedTimer("carnot", "execute_plan");
+  metrics::ScopedNamedTimer scoped_timer(execute_plan_timer);
   auto timer = ElapsedTimer();
   plan::Plan plan;
 
@@ -283,6 +415,10 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // For each of the plan fragments in the plan, execute the query.
   std::vector<std::string> output_table_strs;
   auto exec_state = engine_state_->CreateExecState(query_id);
+  exec_state->set_query_ticket(std::move(ticket));
+  if (analyze && FLAGS_carnot_query_trace_events > 0) {
+    exec_state->EnableQueryTrace();
+  }
 
   // TODO(michellenguyen/zasgar, PP-2579): We should periodically update the metadata state for
   // long-running queries after a certain time duration or number of row batches processed. For now,
@@ -294,9 +430,28 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
 
   PL_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
 
+  // Identical plans that only read local tables are answered from the result cache within a time
+  // bucket, by replaying the recorded inputs of their sinks.
+  std::string result_cache_key;
+  std::shared_ptr<const CachedResult> cached_result;
+  std::shared_ptr<CachedResult> recorded_result;
+  if (result_cache_ != nullptr && !analyze && IsResultCacheable(logical_plan)) {
+    result_cache_key = ResultCacheKey(logical_plan, CurrentTimeNS(),
+                                      FLAGS_carnot_result_cache_bucket_ms * 1000 * 1000LL);
+    cached_result = result_cache_->Get(result_cache_key);
+    if (cached_result == nullptr) {
+      recorded_result = std::make_shared<CachedResult>();
+    }
+  }
+  // The arena of the query would be kept alive by the batches that outlive it.
+  if (recorded_result != nullptr || HasMemorySink(logical_plan)) {
+    exec_state->DisableArenaMemPool();
+  }
+
   auto plan_state = engine_state_->CreatePlanState();
   int64_t bytes_processed = 0;
   int64_t rows_processed = 0;
+  int64_t peak_memory_bytes = 0;
   queryresultspb::AgentExecutionStats agent_operator_exec_stats;
   ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
   timer.Start();
@@ -309,12 +464,25 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
             auto exec_graph = exec::ExecutionGraph();
             PL_RETURN_IF_ERROR(exec_graph.Init(schema.get(), plan_state.get(), exec_state.get(), pf,
                                                /* collect_exec_node_stats */ analyze));
-            PL_RETURN_IF_ERROR(exec_graph.Execute());
+            if (cached_result != nullptr) {
+              auto it = cached_result->fragment_sink_inputs.find(pf->id());
+              if (it == cached_result->fragment_sink_inputs.end()) {
+                return error::Internal("Cached result has no plan fragment $0", pf->id());
+              }
+              PL_RETURN_IF_ERROR(exec_graph.ReplaySinkInputs(it->second));
+            } else {
+              if (recorded_result != nullptr) {
+                exec_graph.RecordSinkInputs(&recorded_result->fragment_sink_inputs[pf->id()]);
+              }
+              PL_RETURN_IF_ERROR(exec_graph.Execute());
+            }
             std::vector<std::string> frag_sinks = exec_graph.OutputTables();
             output_table_strs.insert(output_table_strs.end(), frag_sinks.begin(), frag_sinks.end());
             auto exec_stats = exec_graph.GetStats();
             bytes_processed += exec_stats.bytes_processed;
             rows_processed += exec_stats.rows_processed;
+            // The fragments share the memory pool of the query.
+            peak_memory_bytes = std::max(peak_memory_bytes, exec_stats.peak_memory_bytes);
 
             if (analyze) {
               for (int64_t node_id : pf->dag().TopologicalSort()) {
@@ -352,6 +520,9 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
           })
           .Walk(&plan);
   PL_RETURN_IF_ERROR(s);
+  if (recorded_result != nullptr) {
+    result_cache_->Put(result_cache_key, std::move(recorded_result));
+  }
 
   std::vector<uuidpb::UUID> incoming_agents;
   for (const auto& id : logical_plan.incoming_agent_ids()) {
@@ -376,6 +547,10 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   agent_operator_exec_stats.set_execution_time_ns(exec_time_ns);
   agent_operator_exec_stats.set_bytes_processed(bytes_processed);
   agent_operator_exec_stats.set_records_processed(rows_processed);
+  agent_operator_exec_stats.set_peak_memory_bytes(peak_memory_bytes);
+  if (exec_state->query_trace() != nullptr) {
+    agent_operator_exec_stats.set_chrome_trace_json(exec_state->query_trace()->ToChromeTraceJSON());
+  }
 
   std::vector<queryresultspb::AgentExecutionStats> all_agent_stats;
   if (analyze) {
@@ -391,6 +566,150 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                                                 agent_operator_exec_stats, all_agent_stats);
 }
 
+Status CarnotImpl::RegisterContinuousQuery(const std::string& query, const sole::uuid& query_id,
+                                           types::Time64NSValue time_now) {
+  PL_ASSIGN_OR_RETURN(auto plan_proto, CompileToPlan(query, time_now));
+  return RegisterContinuousPlan(plan_proto, query_id);
+}
+
+Status CarnotImpl::RegisterContinuousPlan(const planpb::Plan& logical_plan,
+                                          const sole::uuid& query_id) {
+  // The memory sources stream, so that they keep their position in the table between ticks.
+  planpb::Plan streaming_plan = logical_plan;
+  for (auto& pf : *streaming_plan.mutable_nodes()) {
+    for (auto& node : *pf.mutable_nodes()) {
+      auto* op = node.mutable_op();
+      if (op->op_type() == planpb::GRPC_SOURCE_OPERATOR) {
+        return error::InvalidArgument(
+            "Continuous queries can only read from local tables, but query $0 has a GRPC source",
+            query_id.str());
+      }
+      if (op->op_type() == planpb::MEMORY_SOURCE_OPERATOR) {
+        op->mutable_mem_source_op()->set_streaming(true);
+      }
+    }
+  }
+
+  auto query = std::make_unique<ContinuousQuery>();
+  PL_RETURN_IF_ERROR(query->plan.Init(streaming_plan));
+  query->exec_state = engine_state_->CreateExecState(query_id);
+  auto metadata_state = GetMetadataState();
+  if (metadata_state) {
+    query->exec_state->set_metadata_state(metadata_state);
+  }
+  PL_RETURN_IF_ERROR(RegisterUDFs(query->exec_state.get(), &query->plan));
+  if (HasMemorySink(streaming_plan)) {
+    query->exec_state->DisableArenaMemPool();
+  }
+  query->plan_state = engine_state_->CreatePlanState();
+  query->schema = std::make_unique<table_store::schema::Schema>();
+
+  auto s = plan::PlanWalker()
+               .OnPlanFragment([&](auto* pf) {
+                 auto exec_graph = std::make_unique<exec::ExecutionGraph>();
+                 PL_RETURN_IF_ERROR(exec_graph->Init(query->schema.get(), query->plan_state.get(),
+                                                     query->exec_state.get(), pf,
+                                                     /* collect_exec_node_stats */ false));
+                 PL_RETURN_IF_ERROR(exec_graph->Open());
+                 query->exec_graphs.push_back(std::move(exec_graph));
+                 return Status::OK();
+               })
+               .Walk(&query->plan);
+  if (!s.ok()) {
+    for (const auto& exec_graph : query->exec_graphs) {
+      PL_UNUSED(exec_graph->Close());
+    }
+    return s;
+  }
+
+  absl::MutexLock lock(&continuous_queries_lock_);
+  if (continuous_queries_.contains(query_id)) {
+    for (const auto& exec_graph : query->exec_graphs) {
+      PL_UNUSED(exec_graph->Close());
+    }
+    return error::AlreadyExists("Continuous query $0 is already registered", query_id.str());
+  }
+  continuous_queries_[query_id] = std::move(query);
+  return Status::OK();
+}
+
+StatusOr<CarnotImpl::ContinuousQuery*> CarnotImpl::GetContinuousQuery(const sole::uuid& query_id) {
+  absl::MutexLock lock(&continuous_queries_lock_);
+  auto it = continuous_queries_.find(query_id);
+  if (it == continuous_queries_.end()) {
+    return error::NotFound("Continuous query $0 is not registered", query_id.str());
+  }
+  return it->second.get();
+}
+
+Status CarnotImpl::TickContinuousQuery(const sole::uuid& query_id) {
+  PL_ASSIGN_OR_RETURN(auto query, GetContinuousQuery(query_id));
+  absl::MutexLock lock(&query->lock);
+  auto timer = ElapsedTimer();
+  timer.Start();
+  for (const auto& exec_graph : query->exec_graphs) {
+    PL_RETURN_IF_ERROR(exec_graph->ExecuteAvailable());
+  }
+  timer.Stop();
+  query->exec_time_ns += timer.ElapsedTime_us() * 1000;
+  return Status::OK();
+}
+
+Status CarnotImpl::UnregisterContinuousQuery(const sole::uuid& query_id) {
+  std::unique_ptr<ContinuousQuery> query;
+  {
+    absl::MutexLock lock(&continuous_queries_lock_);
+    auto it = continuous_queries_.find(query_id);
+    if (it == continuous_queries_.end()) {
+      return error::NotFound("Continuous query $0 is not registered", query_id.str());
+    }
+    query = std::move(it->second);
+    continuous_queries_.erase(it);
+  }
+  // Wait for a tick that is still running.
+  absl::MutexLock lock(&query->lock);
+
+  // The streaming sources never send an eos themselves, so end the stream here and close the
+  // nodes, even if ending the stream failed.
+  Status status = Status::OK();
+  int64_t bytes_processed = 0;
+  int64_t rows_processed = 0;
+  int64_t peak_memory_bytes = 0;
+  for (const auto& exec_graph : query->exec_graphs) {
+    for (int64_t source_id : exec_graph->sources()) {
+      PL_ASSIGN_OR_RETURN(auto node, exec_graph->node(source_id));
+      auto source = static_cast<exec::SourceNode*>(node);
+      if (!source->HasBatchesRemaining()) {
+        continue;
+      }
+      query->exec_state->SetCurrentSource(source_id);
+      auto s = source->SendEndOfStream(query->exec_state.get());
+      if (!s.ok()) {
+        status = s;
+      }
+    }
+    auto s = exec_graph->Close();
+    if (!s.ok()) {
+      status = s;
+    }
+    auto exec_stats = exec_graph->GetStats();
+    bytes_processed += exec_stats.bytes_processed;
+    rows_processed += exec_stats.rows_processed;
+    peak_memory_bytes = std::max(peak_memory_bytes, exec_stats.peak_memory_bytes);
+  }
+  PL_RETURN_IF_ERROR(status);
+
+  queryresultspb::AgentExecutionStats agent_stats;
+  ToProto(agent_id_, agent_stats.mutable_agent_id());
+  agent_stats.set_execution_time_ns(query->exec_time_ns);
+  agent_stats.set_bytes_processed(bytes_processed);
+  agent_stats.set_records_processed(rows_processed);
+  agent_stats.set_peak_memory_bytes(peak_memory_bytes);
+  return SendFinalExecutionStatsToOutgoingConns(query_id, query->exec_state->OutgoingServers(),
+                                                engine_state_->add_auth_to_grpc_context_func(),
+                                                agent_stats, {agent_stats});
+}
+
 CarnotImpl::~CarnotImpl() {
   if (grpc_server_ && grpc_server_thread_) {
     grpc_server_->Shutdown();
@@ -25,12 +25,18 @@
 #include <vector>
 
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/query_scheduler.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/queryresultspb/query_results.pb.h"
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_plan_cache_size);
+DECLARE_int32(carnot_result_cache_size);
+DECLARE_int32(carnot_result_cache_bucket_ms);
+DECLARE_int32(carnot_transformer_warm_executors);
+
 namespace px {
 namespace carnot {
 
@@ -67,20 +73,76 @@ class Carnot : public NotCopyable {
    * Executes the given logical plan.
    *
    * @param plan the plan protobuf describing what should be compiled.
+   * @param ticket the ticket the query was started with by the query scheduler, if any.
    * @return a Carnot Return with output_tables if successful. Error status otherwise.
    */
   virtual Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id,
-                             bool analyze = false) = 0;
+                             bool analyze = false,
+                             std::shared_ptr<exec::QueryScheduler::Ticket> ticket = nullptr) = 0;
+
+  /**
+   * Registers a continuous query, which keeps the compiled plan and its execution graphs alive
+   * across refreshes instead of re-running the whole query each time. The memory sources of the
+   * plan run in infinite-stream mode, so every TickContinuousQuery() resumes them from where the
+   * previous tick stopped and only the rows added since then are pushed through the plan.
+   *
+   * @param query the query in the form of a string.
+   * @param time_now the current time.
+   * @return an error if the query can't be compiled or doesn't run over local tables.
+   */
+  virtual Status RegisterContinuousQuery(const std::string& query, const sole::uuid& query_id,
+                                         types::Time64NSValue time_now) = 0;
+  virtual Status RegisterContinuousPlan(const planpb::Plan& plan, const sole::uuid& query_id) = 0;
+
+  /**
+   * Pushes the data that was added to the source tables since the last tick through the
+   * continuous query. Returns once there's no more data available, without waiting for new data.
+   */
+  virtual Status TickContinuousQuery(const sole::uuid& query_id) = 0;
+
+  /**
+   * Ends the stream of the continuous query, which flushes the operators that only produce
+   * results at the end of the stream, and releases the execution graphs.
+   */
+  virtual Status UnregisterContinuousQuery(const sole::uuid& query_id) = 0;
 
   /**
    * Registers the callback for updating the agents metadata state.
    */
   virtual void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) = 0;
 
+  /**
+   * Registers the generator of the stubs that the GRPC sinks multiplex their result streams to
+   * other Carnot instances over, when FLAGS_carnot_grpc_sink_multiplex_streams is set. Must be
+   * called before any query is executed.
+   */
+  virtual void RegisterResultStreamMuxStubGenerator(
+      const exec::ResultStreamMuxStubGenerator& stub_generator) = 0;
+
+  /**
+   * Registers the callback that the memory sinks of the given table hand their row batches to as
+   * they are produced, instead of writing them to the table store. Large results then don't have
+   * to be held in memory until the query completes; see exec::RowBatchQueue for a bounded queue to
+   * read them from another thread. An empty callback unregisters it. Must not be called while
+   * queries are executing.
+   */
+  virtual void RegisterMemorySinkCallback(const std::string& table_name,
+                                          exec::MemorySinkCallback callback) = 0;
+
   /**
    * Returns a const pointer to carnot's function registry.
    */
   virtual const udf::Registry* FuncRegistry() const = 0;
+
+  /**
+   * Returns the bytes of memory currently held by the queries running in carnot.
+   */
+  virtual int64_t QueryMemoryBytes() const = 0;
+
+  /**
+   * Returns the scheduler that hands out the run slots to the queries started by the agent.
+   */
+  virtual exec::QueryScheduler* query_scheduler() = 0;
 };
 
 }  // namespace carnot
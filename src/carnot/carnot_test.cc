@@ -112,6 +112,125 @@ TEST_F(CarnotTest, basic) {
   EXPECT_TRUE(rb2.ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST_F(CarnotTest, result_cache_replays_results_within_bucket) {
+  gflags::FlagSaver flag_saver;
+  FLAGS_carnot_result_cache_size = 8;
+  // A bucket long enough that the executions below all fall into the same one.
+  FLAGS_carnot_result_cache_bucket_ms = 3600 * 1000;
+  auto carnot = Carnot::Create(sole::uuid4(), table_store_,
+                               std::bind(&exec::LocalGRPCResultSinkServer::StubGenerator,
+                                         result_server_.get(), std::placeholders::_1))
+                    .ConsumeValueOrDie();
+
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1','col2'])",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  ASSERT_OK(carnot->ExecuteQuery(query, sole::uuid4(), 0));
+  ASSERT_OK(carnot->ExecuteQuery(query, sole::uuid4(), 0));
+
+  // The second execution replays the results of the first one, without reading the table.
+  auto output_batches = result_server_->query_results("test_output");
+  ASSERT_EQ(4, output_batches.size());
+  for (size_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(output_batches[i].DebugString(), output_batches[i + 2].DebugString());
+  }
+
+  // The data that arrives in the meantime doesn't change the result within the bucket.
+  std::vector<types::Float64Value> col1_in3 = {2.5};
+  std::vector<types::Int64Value> col2_in3 = {7};
+  auto rb = table_store::schema::RowBatch(
+      table_store::schema::RowDescriptor({types::FLOAT64, types::INT64}), 1);
+  ASSERT_OK(rb.AddColumn(types::ToArrow(col1_in3, arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(types::ToArrow(col2_in3, arrow::default_memory_pool())));
+  ASSERT_OK(table_store_->GetTable("test_table")->WriteRowBatch(rb));
+  ASSERT_OK(carnot->ExecuteQuery(query, sole::uuid4(), 0));
+
+  std::vector<int64_t> records_processed;
+  for (const auto& req : result_server_->raw_query_results()) {
+    if (req.has_execution_and_timing_info()) {
+      records_processed.push_back(
+          req.execution_and_timing_info().execution_stats().records_processed());
+    }
+  }
+  EXPECT_THAT(records_processed, ::testing::ElementsAre(5, 0, 0));
+  output_batches = result_server_->query_results("test_output");
+  ASSERT_EQ(6, output_batches.size());
+  for (size_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(output_batches[i].DebugString(), output_batches[i + 4].DebugString());
+  }
+}
+
+TEST_F(CarnotTest, continuous_query_pushes_deltas) {
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1','col2'])",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  auto query_id = sole::uuid4();
+  ASSERT_OK(carnot_->RegisterContinuousQuery(query, query_id, 0));
+
+  ASSERT_OK(carnot_->TickContinuousQuery(query_id));
+  EXPECT_EQ(2, result_server_->query_results("test_output").size());
+  // Nothing was added to the table, so there's nothing to push.
+  ASSERT_OK(carnot_->TickContinuousQuery(query_id));
+  EXPECT_EQ(2, result_server_->query_results("test_output").size());
+
+  std::vector<types::Float64Value> col1_in3 = {7.5};
+  std::vector<types::Int64Value> col2_in3 = {8};
+  auto rb3 = table_store::schema::RowBatch(
+      table_store::schema::RowDescriptor({types::FLOAT64, types::INT64}), 1);
+  ASSERT_OK(rb3.AddColumn(types::ToArrow(col1_in3, arrow::default_memory_pool())));
+  ASSERT_OK(rb3.AddColumn(types::ToArrow(col2_in3, arrow::default_memory_pool())));
+  ASSERT_OK(table_store_->GetTable("test_table")->WriteRowBatch(rb3));
+
+  // Only the new rows are scanned on the next tick.
+  ASSERT_OK(carnot_->TickContinuousQuery(query_id));
+  auto output_batches = result_server_->query_results("test_output");
+  ASSERT_EQ(3, output_batches.size());
+  EXPECT_TRUE(output_batches[2].ColumnAt(0)->Equals(
+      types::ToArrow(col1_in3, arrow::default_memory_pool())));
+  EXPECT_TRUE(output_batches[2].ColumnAt(1)->Equals(
+      types::ToArrow(col2_in3, arrow::default_memory_pool())));
+
+  ASSERT_OK(carnot_->UnregisterContinuousQuery(query_id));
+  auto exec_stats = result_server_->exec_stats().ConsumeValueOrDie();
+  EXPECT_EQ(6, exec_stats.execution_stats().records_processed());
+
+  EXPECT_NOT_OK(carnot_->TickContinuousQuery(query_id));
+  EXPECT_NOT_OK(carnot_->UnregisterContinuousQuery(query_id));
+}
+
+TEST_F(CarnotTest, continuous_query_flushes_aggs_on_unregister) {
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1','col2'])",
+          "df = df.agg(sum=('col2', px.sum))",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  auto query_id = sole::uuid4();
+  ASSERT_OK(carnot_->RegisterContinuousQuery(query, query_id, 0));
+  ASSERT_OK(carnot_->TickContinuousQuery(query_id));
+  // The blocking aggregate only produces its result at the end of the stream.
+  for (const auto& rb : result_server_->query_results("test_output")) {
+    EXPECT_EQ(0, rb.num_rows());
+  }
+
+  ASSERT_OK(carnot_->UnregisterContinuousQuery(query_id));
+  auto output_batches = result_server_->query_results("test_output");
+  ASSERT_LT(0, output_batches.size());
+  EXPECT_TRUE(output_batches.back().eos());
+  EXPECT_TRUE(output_batches.back().ColumnAt(0)->Equals(
+      types::ToArrow(std::vector<types::Int64Value>{17}, arrow::default_memory_pool())));
+}
+
 TEST_F(CarnotTest, register_metadata) {
   auto callback_calls = 0;
   carnot_->RegisterAgentMetadataCallback(
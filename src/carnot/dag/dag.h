@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -72,6 +73,11 @@ class DAG {
 
   std::unordered_set<int64_t> Orphans();
   std::unordered_set<int64_t> TransitiveDepsFrom(int64_t node);
+
+  /**
+   * @brief Returns the nodes in topological order. The order is computed once and reused until
+   * the DAG changes.
+   */
   std::vector<int64_t> TopologicalSort() const;
 
   std::vector<int64_t> DependenciesOf(int64_t node) const {
@@ -97,6 +103,10 @@ class DAG {
   void DeleteParentEdges(int64_t to_node);
   void DeleteDependentEdges(int64_t from_node);
 
+  std::vector<int64_t> ComputeTopologicalSort() const;
+  // Called by every change to the nodes or edges.
+  void InvalidateTopologicalSort() { std::atomic_store(&topological_sort_, {}); }
+
   // Store all the integer id's as nodes.
   absl::flat_hash_set<int64_t> nodes_;
 
@@ -108,6 +118,9 @@ class DAG {
   absl::flat_hash_map<int64_t, std::vector<int64_t>> reverse_edges_by_node_;
   // Used for quick lookups of edges which get really expensive at scale.
   absl::flat_hash_map<int64_t, absl::flat_hash_set<int64_t>> forward_edges_map_;
+  // The cached result of TopologicalSort(), or null. Accessed atomically, so that concurrent
+  // readers of the DAG can fill it in.
+  mutable std::shared_ptr<const std::vector<int64_t>> topological_sort_;
 };
 
 }  // namespace plan
@@ -100,6 +100,26 @@ TEST_F(DAGTest, topological_sort) {
   EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(5, 3, 6));
 }
 
+TEST_F(DAGTest, topological_sort_after_edge_changes) {
+  EXPECT_THAT(dag_.TopologicalSort(),
+              AnyOf(ElementsAre(20, 5, 8, 3, 6), ElementsAre(5, 20, 8, 3, 6)));
+
+  // The cached order is recomputed when the edges change.
+  dag_.AddEdge(6, 20);
+  EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(5, 8, 3, 6, 20));
+  dag_.ReplaceParentEdge(20, 6, 8);
+  EXPECT_THAT(dag_.TopologicalSort(), ElementsAre(5, 8, 3, 20, 6));
+  dag_.DeleteEdge(8, 20);
+  EXPECT_THAT(dag_.TopologicalSort(),
+              AnyOf(ElementsAre(20, 5, 8, 3, 6), ElementsAre(5, 20, 8, 3, 6)));
+
+  // Copies keep the order of the DAG they were copied from.
+  DAG copy = dag_;
+  copy.DeleteNode(20);
+  EXPECT_EQ(4, copy.TopologicalSort().size());
+  EXPECT_EQ(5, dag_.TopologicalSort().size());
+}
+
 using DAGDeathTest = DAGTest;
 TEST_F(DAGDeathTest, check_add_duplicate) { EXPECT_DEBUG_DEATH(dag_.AddNode(5), ".*"); }
 
@@ -20,9 +20,13 @@
 
 #include <arrow/memory_pool.h>
 #include <memory>
+#include <string>
 #include <utility>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/query_scheduler.h"
 #include "src/carnot/exec/ml/model_pool.h"
 #include "src/carnot/funcs/funcs.h"
 #include "src/carnot/plan/plan_state.h"
@@ -75,9 +79,12 @@ class EngineState : public NotCopyable {
 
   table_store::TableStore* table_store() { return table_store_.get(); }
   std::unique_ptr<exec::ExecState> CreateExecState(const sole::uuid& query_id) {
-    return std::make_unique<exec::ExecState>(func_registry_.get(), table_store_, stub_generator_,
-                                             query_id, model_pool_.get(), grpc_router_,
-                                             add_auth_to_grpc_context_func_);
+    auto exec_state = std::make_unique<exec::ExecState>(
+        func_registry_.get(), table_store_, stub_generator_, query_id, model_pool_.get(),
+        grpc_router_, add_auth_to_grpc_context_func_, &query_memory_tracker_);
+    exec_state->set_result_stream_mux_pool(result_stream_mux_pool_.get());
+    exec_state->set_memory_sink_callbacks(&memory_sink_callbacks_);
+    return exec_state;
   }
 
   std::unique_ptr<plan::PlanState> CreatePlanState() {
@@ -89,9 +96,11 @@ class EngineState : public NotCopyable {
     auto rel_map = table_store_->GetRelationMap();
     // Use an empty string for query result address, because the local execution mode should use
     // the Local GRPC result server to send results to.
-    return std::make_unique<planner::CompilerState>(std::move(rel_map), registry_info_.get(),
-                                                    time_now, /* result address */ "",
-                                                    /* ssl target name override*/ "");
+    auto compiler_state = std::make_unique<planner::CompilerState>(
+        std::move(rel_map), registry_info_.get(), time_now, /* result address */ "",
+        /* ssl target name override*/ "");
+    compiler_state->set_table_row_counts(table_store_->GetTableRowCounts());
+    return compiler_state;
   }
 
   const udf::Registry* func_registry() const { return func_registry_.get(); }
@@ -101,6 +110,24 @@ class EngineState : public NotCopyable {
 
   exec::ml::ModelPool* model_pool() const { return model_pool_.get(); }
 
+  // Counts the memory of all of the queries, which their trackers also consume.
+  const exec::MemoryTracker& query_memory_tracker() const { return query_memory_tracker_; }
+
+  exec::QueryScheduler* query_scheduler() { return &query_scheduler_; }
+
+  void set_result_stream_mux_pool(std::unique_ptr<exec::ResultStreamMuxPool> pool) {
+    result_stream_mux_pool_ = std::move(pool);
+  }
+
+  void set_memory_sink_callback(const std::string& table_name,
+                                exec::MemorySinkCallback callback) {
+    if (callback) {
+      memory_sink_callbacks_[table_name] = std::move(callback);
+    } else {
+      memory_sink_callbacks_.erase(table_name);
+    }
+  }
+
  private:
   std::unique_ptr<udf::Registry> func_registry_;
   std::shared_ptr<table_store::TableStore> table_store_;
@@ -109,6 +136,10 @@ class EngineState : public NotCopyable {
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_context_func_;
   exec::GRPCRouter* grpc_router_ = nullptr;
   std::unique_ptr<exec::ml::ModelPool> model_pool_;
+  exec::MemoryTracker query_memory_tracker_{"Queries", /* limit_bytes */ 0};
+  exec::QueryScheduler query_scheduler_;
+  std::unique_ptr<exec::ResultStreamMuxPool> result_stream_mux_pool_;
+  absl::flat_hash_map<std::string, exec::MemorySinkCallback> memory_sink_callbacks_;
 };
 
 }  // namespace carnot
@@ -20,9 +20,16 @@
 
 #include <arrow/array.h>
 #include <arrow/array/builder_base.h>
+#include <arrow/array/builder_binary.h>
 #include <arrow/status.h>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <magic_enum.hpp>
 
@@ -35,6 +42,11 @@
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
+DEFINE_int64(carnot_partial_agg_max_groups,
+             gflags::Int64FromEnv("PL_CARNOT_PARTIAL_AGG_MAX_GROUPS", 64 * 1024),
+             "The maximum number of groups a partial aggregate holds before it emits its partial "
+             "results early. Set to 0 to only emit at the end of the stream.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -47,10 +59,12 @@ using table_store::schema::RowDescriptor;
 
 namespace {
 template <types::DataType DT>
-void ExtractIntoGroupArgs(std::vector<GroupArgs>* group_args, arrow::Array* col, int rt_col_idx) {
-  auto num_rows = col->length();
+void ExtractIntoGroupArgs(std::vector<GroupArgs>* group_args, const RowBatch& rb,
+                          arrow::Array* col, int rt_col_idx) {
+  auto num_rows = rb.num_selected_rows();
   for (auto row_idx = 0; row_idx < num_rows; ++row_idx) {
-    ExtractIntoRowTuple<DT>((*group_args)[row_idx].rt, col, rt_col_idx, row_idx);
+    ExtractIntoRowTuple<DT>((*group_args)[row_idx].rt, col, rt_col_idx,
+                            rb.SelectedRowIndex(row_idx));
   }
 }
 
@@ -68,14 +82,62 @@ template <types::DataType DT>
 void ExtractToColumnWrapper(const std::vector<GroupArgs>& group_args,
                             const table_store::schema::RowBatch& rb, size_t col_idx,
                             size_t rb_col_idx) {
-  size_t num_rows = rb.num_rows();
+  size_t num_rows = rb.num_selected_rows();
   DCHECK(num_rows <= group_args.size());
   for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
     DCHECK(group_args[row_idx].av != nullptr);
     auto col_wrapper = group_args[row_idx].av->agg_cols[col_idx].get();
     auto arr = rb.ColumnAt(rb_col_idx).get();
-    types::ExtractValueToColumnWrapper<DT>(col_wrapper, arr, row_idx);
+    types::ExtractValueToColumnWrapper<DT>(col_wrapper, arr, rb.SelectedRowIndex(row_idx));
+  }
+}
+
+// Single fixed size group keys are widened to a uint128 so that a single index type can be used.
+template <types::DataType DT>
+absl::uint128 FixedSizeKeyAt(const arrow::Array* col, int64_t row_idx) {
+  auto val = types::GetValueFromArrowArray<DT>(col, row_idx);
+  if constexpr (DT == types::UINT128) {
+    return types::UInt128Value(val).val;
+  } else {
+    return static_cast<uint64_t>(val);
+  }
+}
+
+bool IsSupportedFixedSizeKey(types::DataType dt) {
+  switch (dt) {
+    case types::BOOLEAN:
+    case types::INT64:
+    case types::TIME64NS:
+    case types::UINT128:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Serialized partial aggregates of all of the UDAs are stored in a single string, with each UDA
+// state prefixed by its length.
+using SerializedLength = uint32_t;
+
+void AppendSerializedState(std::string_view state, std::string* out) {
+  SerializedLength len = state.size();
+  out->append(reinterpret_cast<const char*>(&len), sizeof(len));
+  out->append(state);
+}
+
+StatusOr<std::string_view> ConsumeSerializedState(std::string_view* data) {
+  SerializedLength len;
+  if (data->size() < sizeof(len)) {
+    return error::InvalidArgument("Serialized partial aggregate is truncated");
   }
+  std::memcpy(&len, data->data(), sizeof(len));
+  data->remove_prefix(sizeof(len));
+  if (data->size() < len) {
+    return error::InvalidArgument("Serialized partial aggregate is truncated");
+  }
+  std::string_view state = data->substr(0, len);
+  data->remove_prefix(len);
+  return state;
 }
 
 }  // namespace
@@ -106,11 +168,22 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     }
   }
 
-  size_t output_size = plan_node_->values().size() + plan_node_->groups().size();
+  // Partial aggregates output all of the serialized values in a single column.
+  size_t num_value_cols = EmitsPartialAggs() ? 1 : plan_node_->values().size();
+  size_t output_size = num_value_cols + plan_node_->groups().size();
   if (output_size != output_descriptor_->size()) {
     return error::InvalidArgument("Output size mismatch in aggregate");
   }
 
+  if (MergesPartialAggs()) {
+    // The serialized partial aggregates are the last column of the partial aggregate output.
+    serialized_col_idx_ = input_descriptor_->size() - 1;
+    if (serialized_col_idx_ < 0 || input_descriptor_->type(serialized_col_idx_) != types::STRING) {
+      return error::InvalidArgument(
+          "Aggregate merging partial results expects serialized aggregates as the last column");
+    }
+  }
+
   if (HasNoGroups()) {
     return Status::OK();
   }
@@ -128,18 +201,36 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     group_data_types_.emplace_back(input_descriptor_->type(group.idx));
   }
 
-  auto values_size = plan_node_->values().size();
-  for (size_t i = 0; i < values_size; ++i) {
+  for (size_t i = 0; i < num_value_cols; ++i) {
     auto values_idx = i + groups_size;
     DCHECK(values_idx < output_descriptor_->size());
     value_data_types_.emplace_back(output_descriptor_->type(values_idx));
   }
+  single_fixed_size_key_ = groups_size == 1 && IsSupportedFixedSizeKey(group_data_types_[0]);
+  ordered_leading_group_ = plan_node_->ordered_leading_group() &&
+                           (group_data_types_[0] == types::INT64 ||
+                            group_data_types_[0] == types::TIME64NS);
 
+  if (MergesPartialAggs()) {
+    // The value expressions refer to the input of the partial aggregate, so there are no input
+    // columns to store.
+    return Status::OK();
+  }
   return CreateColumnMapping();
 }
 
 Status AggNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
+  hash_table_memory_.set_tracker(exec_state->memory_tracker());
+  if (EmitsPartialAggs() || MergesPartialAggs()) {
+    for (const auto& value : plan_node_->values()) {
+      auto def = exec_state->GetUDADefinition(value->uda_id());
+      if (!def->supports_partial()) {
+        return error::InvalidArgument("UDA '$0' does not support partial aggregation",
+                                      value->name());
+      }
+    }
+  }
   return Status::OK();
 }
 
@@ -162,6 +253,7 @@ Status AggNode::CloseImpl(ExecState*) {
   group_args_chunk_.clear();
   group_args_pool_.Clear();
   udas_pool_.Clear();
+  hash_table_memory_.Reset();
 
   return Status::OK();
 }
@@ -170,20 +262,69 @@ bool AggNode::ReadyToEmitBatches(const RowBatch& rb) const {
   return rb.eos() || (rb.eow() && plan_node_->windowed());
 }
 
+bool AggNode::ExceedsPartialAggBudget() const {
+  return EmitsPartialAggs() && FLAGS_carnot_partial_agg_max_groups > 0 &&
+         static_cast<int64_t>(agg_hash_map_.size()) >= FLAGS_carnot_partial_agg_max_groups;
+}
+
 Status AggNode::ClearAggState(ExecState* exec_state) {
   if (HasNoGroups()) {
     udas_no_groups_.clear();
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
   }
   agg_hash_map_.clear();
+  fixed_size_key_index_.clear();
+  // The group keys and agg values are owned by the pools, so release them as well, otherwise
+  // memory keeps growing across windows and partial flushes.
+  group_args_chunk_.clear();
+  group_args_pool_.Clear();
+  udas_pool_.Clear();
+  hash_table_memory_.Reset();
   return Status::OK();
 }
 
+int64_t AggNode::HashTableBytes() const {
+  constexpr int64_t kEstimatedUDAStateBytes = 64;
+  int64_t group_bytes = sizeof(RowTuple) + sizeof(AggHashValue) +
+                        group_data_types_.size() * sizeof(types::FixedSizeValueUnion) +
+                        plan_node_->values().size() * (sizeof(UDAInfo) + kEstimatedUDAStateBytes);
+  // Each slot of a flat hash map also has a control byte.
+  int64_t slot_bytes = sizeof(AggHashMap::value_type) + 1;
+  int64_t bytes = agg_hash_map_.size() * group_bytes + agg_hash_map_.capacity() * slot_bytes;
+  if (single_fixed_size_key_) {
+    bytes += fixed_size_key_index_.capacity() *
+             (sizeof(decltype(fixed_size_key_index_)::value_type) + 1);
+  }
+  return bytes;
+}
+
 Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb) {
+  if (rb.has_selection()) {
+    // The UDAs are updated with entire arrow arrays, so the selected rows need to be copied out.
+    PL_ASSIGN_OR_RETURN(auto compacted_rb, rb.CompactSelection());
+    return AggregateGroupByNone(exec_state, *compacted_rb);
+  }
   auto values = plan_node_->values();
-  for (size_t i = 0; i < values.size(); ++i) {
-    PL_RETURN_IF_ERROR(
-        EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
+  if (MergesPartialAggs()) {
+    PL_RETURN_IF_ERROR(MergePartialAggregates(rb));
+  } else {
+    for (size_t i = 0; i < values.size(); ++i) {
+      PL_RETURN_IF_ERROR(
+          EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
+    }
+  }
+
+  if (ReadyToEmitBatches(rb) && EmitsPartialAggs()) {
+    RowBatch output_rb(*output_descriptor_, 1);
+    auto builder = types::MakeArrowBuilder(types::STRING, exec_state->exec_mem_pool());
+    PL_RETURN_IF_ERROR(SerializeUDAInfoValues(udas_no_groups_, builder.get()));
+    SharedArray out_col;
+    PL_RETURN_IF_ERROR(builder->Finish(&out_col));
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(out_col));
+    output_rb.set_eow(rb.eow());
+    output_rb.set_eos(rb.eos());
+    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+    return ClearAggState(exec_state);
   }
 
   if (ReadyToEmitBatches(rb)) {
@@ -206,9 +347,8 @@ Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb)
   return Status::OK();
 }
 
-Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
+void AggNode::GrowGroupArgs(size_t num_rows) {
   // Grow the group_args_chunk_ to be the size of the RowBatch.
-  size_t num_rows = rb.num_rows();
   if (group_args_chunk_.size() < num_rows) {
     int prev_size = group_args_chunk_.size();
     group_args_chunk_.reserve(num_rows);
@@ -216,6 +356,10 @@ Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
       group_args_chunk_.emplace_back(CreateGroupArgsRowTuple());
     }
   }
+}
+
+Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
+  GrowGroupArgs(rb.num_selected_rows());
 
   // Scan through all the group args in column order and extract the entire column.
   for (size_t idx = 0; idx < plan_node_->groups().size(); idx++) {
@@ -225,7 +369,7 @@ Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
     auto dt = group_data_types_[idx];
     auto col = rb.ColumnAt(grp.idx).get();
 
-#define TYPE_CASE(_dt_) ExtractIntoGroupArgs<_dt_>(&group_args_chunk_, col, idx);
+#define TYPE_CASE(_dt_) ExtractIntoGroupArgs<_dt_>(&group_args_chunk_, rb, col, idx);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -236,7 +380,7 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
   PL_UNUSED(exec_state);
   // Loop through all the row and basically store the values into column chunk based on which
   // group they belong to.
-  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+  for (auto row_idx = 0; row_idx < rb.num_selected_rows(); ++row_idx) {
     auto& ga = group_args_chunk_[row_idx];
     AggHashValue* val = nullptr;
     // Check to see if in hash
@@ -254,8 +398,34 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
     }
     ga.av = val;
   }
+  return ExtractAggValues(rb);
+}
 
-  auto values = plan_node_->values();
+template <types::DataType DT>
+Status AggNode::HashRowBatchSingleFixedSizeKey(ExecState* exec_state, const RowBatch& rb) {
+  GrowGroupArgs(rb.num_selected_rows());
+  DCHECK_EQ(plan_node_->groups().size(), 1ULL);
+  auto col = rb.ColumnAt(plan_node_->groups()[0].idx).get();
+  for (auto row_idx = 0; row_idx < rb.num_selected_rows(); ++row_idx) {
+    auto& ga = group_args_chunk_[row_idx];
+    auto col_row_idx = rb.SelectedRowIndex(row_idx);
+    auto key = FixedSizeKeyAt<DT>(col, col_row_idx);
+    auto it = fixed_size_key_index_.find(key);
+    if (it == fixed_size_key_index_.end()) {
+      // Only new groups need a RowTuple, which then gets handed over to the agg hash map.
+      ExtractIntoRowTuple<DT>(ga.rt, col, 0, col_row_idx);
+      ga.av = CreateAggHashValue(exec_state);
+      agg_hash_map_[ga.rt] = ga.av;
+      fixed_size_key_index_[key] = ga.av;
+      ga.rt = nullptr;
+    } else {
+      ga.av = it->second;
+    }
+  }
+  return ExtractAggValues(rb);
+}
+
+Status AggNode::ExtractAggValues(const RowBatch& rb) {
   // Now extract the values in the agg hash value.
   for (size_t i = 0; i < stored_cols_data_types_.size(); ++i) {
     const auto& rb_col_idx = stored_cols_to_plan_idx_[i];
@@ -324,12 +494,18 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
       PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
 #undef TYPE_CASE
     }
-    // Actually Finalize the UDA based on the column wrapper chunks.
-    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
-    for (size_t i = 0; i < val->udas.size(); ++i) {
-      const auto& uda_info = val->udas[i];
-      PL_RETURN_IF_ERROR(uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(),
-                                                     value_builders[i].get()));
+    if (!MergesPartialAggs()) {
+      // Actually Finalize the UDA based on the column wrapper chunks.
+      PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
+    }
+    if (EmitsPartialAggs()) {
+      PL_RETURN_IF_ERROR(SerializeUDAInfoValues(val->udas, value_builders[0].get()));
+    } else {
+      for (size_t i = 0; i < val->udas.size(); ++i) {
+        const auto& uda_info = val->udas[i];
+        PL_RETURN_IF_ERROR(uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(),
+                                                       value_builders[i].get()));
+      }
     }
   }
 
@@ -348,7 +524,7 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
   return Status::OK();
 }
 
-Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
+Status AggNode::UpdateGroups(ExecState* exec_state, const RowBatch& rb) {
   // Extracts the row tuples (column wise).
   // TODO(zasgar): PL-455 - Chunk this so we don't create a crazy number of row tuples if the batch
   // is large. The process is as follows:
@@ -356,20 +532,167 @@ Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb
   // 2. Hash row batch and update agg values.
   // 3. If the agg values are large then run aggregate and compact.
   // 4. Reset state to prepare for next row batch.
-  // 5. If it's the last batch then emit the values.
-  PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
-  PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
-  if (plan_node_->values().size() > 0) {
-    PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_rows()));
+  if (single_fixed_size_key_) {
+    switch (group_data_types_[0]) {
+      case types::BOOLEAN:
+        PL_RETURN_IF_ERROR(HashRowBatchSingleFixedSizeKey<types::BOOLEAN>(exec_state, rb));
+        break;
+      case types::INT64:
+        PL_RETURN_IF_ERROR(HashRowBatchSingleFixedSizeKey<types::INT64>(exec_state, rb));
+        break;
+      case types::TIME64NS:
+        PL_RETURN_IF_ERROR(HashRowBatchSingleFixedSizeKey<types::TIME64NS>(exec_state, rb));
+        break;
+      case types::UINT128:
+        PL_RETURN_IF_ERROR(HashRowBatchSingleFixedSizeKey<types::UINT128>(exec_state, rb));
+        break;
+      default:
+        return error::Internal("Unexpected fixed size group key type $0",
+                               magic_enum::enum_name(group_data_types_[0]));
+    }
+  } else {
+    PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
+    PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
+  }
+  if (MergesPartialAggs()) {
+    PL_RETURN_IF_ERROR(MergePartialAggregates(rb));
+  } else if (plan_node_->values().size() > 0) {
+    PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_selected_rows()));
   }
   PL_RETURN_IF_ERROR(ResetGroupArgs());
-  if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, agg_hash_map_.size());
-    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, &output_rb));
-    output_rb.set_eow(rb.eow());
-    output_rb.set_eos(rb.eos());
-    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
-    PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+  return hash_table_memory_.Set(HashTableBytes());
+}
+
+Status AggNode::EmitGroups(ExecState* exec_state, bool eow, bool eos) {
+  RowBatch output_rb(*output_descriptor_, agg_hash_map_.size());
+  PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, &output_rb));
+  output_rb.set_eow(eow);
+  output_rb.set_eos(eos);
+  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+  return ClearAggState(exec_state);
+}
+
+int64_t AggNode::LeadingGroupAt(const RowBatch& rb, int64_t row_idx) const {
+  auto col = rb.ColumnAt(plan_node_->groups()[0].idx).get();
+  auto idx = rb.SelectedRowIndex(row_idx);
+  if (group_data_types_[0] == types::TIME64NS) {
+    return types::GetValueFromArrowArray<types::TIME64NS>(col, idx);
+  }
+  return types::GetValueFromArrowArray<types::INT64>(col, idx);
+}
+
+StatusOr<RowBatch> AggNode::EmitClosedGroups(ExecState* exec_state, const RowBatch& rb) {
+  const int64_t num_rows = rb.num_selected_rows();
+  const int64_t prev_leading_group = seen_leading_group_ ? open_leading_group_
+                                                         : std::numeric_limits<int64_t>::min();
+
+  // Find the first row of the last value of the first group. The rows before it, and the groups
+  // seen so far, don't belong to the last value, so their groups are complete once added.
+  int64_t lo = 0;
+  int64_t last_leading_group = prev_leading_group;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    int64_t leading_group = LeadingGroupAt(rb, i);
+    if (leading_group < last_leading_group) {
+      // The input isn't ordered after all, e.g. because the source interleaves the batches of the
+      // tablets of a table that the agent tabletized. The groups that were emitted can't be taken
+      // back, but from here on the groups are only emitted at the end of the stream.
+      VLOG(1) << "The input of the aggregate isn't ordered by its first group, falling back to "
+                 "blocking aggregation.";
+      ordered_leading_group_ = false;
+      return rb;
+    }
+    if (leading_group > last_leading_group) {
+      lo = i;
+      last_leading_group = leading_group;
+    }
+  }
+
+  const bool has_open_groups = !agg_hash_map_.empty();
+  open_leading_group_ = last_leading_group;
+  seen_leading_group_ = true;
+  if (lo == 0) {
+    if (has_open_groups && last_leading_group > prev_leading_group) {
+      PL_RETURN_IF_ERROR(EmitGroups(exec_state, /* eow */ false, /* eos */ false));
+    }
+    return rb;
+  }
+
+  std::vector<int64_t> closed_rows;
+  std::vector<int64_t> open_rows;
+  closed_rows.reserve(lo);
+  open_rows.reserve(num_rows - lo);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    (i < lo ? closed_rows : open_rows).push_back(rb.SelectedRowIndex(i));
+  }
+
+  // The columns are shared, only the selection differs.
+  RowBatch closed_rb = rb;
+  closed_rb.set_selection(std::make_shared<const std::vector<int64_t>>(std::move(closed_rows)));
+  closed_rb.set_eow(false);
+  closed_rb.set_eos(false);
+  PL_RETURN_IF_ERROR(UpdateGroups(exec_state, closed_rb));
+  PL_RETURN_IF_ERROR(EmitGroups(exec_state, /* eow */ false, /* eos */ false));
+
+  RowBatch open_rb = rb;
+  open_rb.set_selection(std::make_shared<const std::vector<int64_t>>(std::move(open_rows)));
+  return open_rb;
+}
+
+Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
+  if (ordered_leading_group_ && rb.num_selected_rows() > 0) {
+    PL_ASSIGN_OR_RETURN(RowBatch open_rb, EmitClosedGroups(exec_state, rb));
+    PL_RETURN_IF_ERROR(UpdateGroups(exec_state, open_rb));
+  } else {
+    PL_RETURN_IF_ERROR(UpdateGroups(exec_state, rb));
+  }
+
+  // If it's the last batch then emit the values.
+  bool ready_to_emit = ReadyToEmitBatches(rb);
+  if (ready_to_emit || ExceedsPartialAggBudget()) {
+    // Early flushes of partial aggregates are mid-stream, so they never carry eow/eos.
+    return EmitGroups(exec_state, ready_to_emit && rb.eow(), ready_to_emit && rb.eos());
+  }
+  return Status::OK();
+}
+
+Status AggNode::SerializeUDAInfoValues(const std::vector<UDAInfo>& udas,
+                                       arrow::ArrayBuilder* builder) {
+  std::string serialized;
+  for (const auto& uda_info : udas) {
+    PL_ASSIGN_OR_RETURN(auto state,
+                        uda_info.def->Serialize(uda_info.uda.get(), function_ctx_.get()));
+    AppendSerializedState(state, &serialized);
+  }
+  PL_RETURN_IF_ERROR(static_cast<arrow::StringBuilder*>(builder)->Append(serialized));
+  return Status::OK();
+}
+
+Status AggNode::MergeSerializedUDAInfoValues(const std::vector<UDAInfo>& udas,
+                                             std::string_view data) {
+  for (const auto& uda_info : udas) {
+    PL_ASSIGN_OR_RETURN(auto state, ConsumeSerializedState(&data));
+    // Deserialize restores the entire UDA state, so the partial UDA doesn't need to be initialized.
+    auto partial = uda_info.def->Make();
+    PL_RETURN_IF_ERROR(uda_info.def->Deserialize(partial.get(), function_ctx_.get(),
+                                                 types::StringValue(state.data(), state.size())));
+    PL_RETURN_IF_ERROR(uda_info.def->Merge(uda_info.uda.get(), partial.get(), function_ctx_.get()));
+  }
+  if (!data.empty()) {
+    return error::InvalidArgument("Serialized partial aggregate has $0 unexpected trailing bytes",
+                                  data.size());
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergePartialAggregates(const RowBatch& rb) {
+  DCHECK_GE(serialized_col_idx_, 0);
+  auto col = static_cast<arrow::StringArray*>(rb.ColumnAt(serialized_col_idx_).get());
+  for (auto row_idx = 0; row_idx < rb.num_selected_rows(); ++row_idx) {
+    int32_t len;
+    const uint8_t* data = col->GetValue(rb.SelectedRowIndex(row_idx), &len);
+    std::string_view serialized(reinterpret_cast<const char*>(data), len);
+    const auto& udas = HasNoGroups() ? udas_no_groups_ : group_args_chunk_[row_idx].av->udas;
+    PL_RETURN_IF_ERROR(MergeSerializedUDAInfoValues(udas, serialized));
   }
   return Status::OK();
 }
@@ -520,11 +843,14 @@ Status AggNode::CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_s
   CHECK_EQ(val->size(), 0ULL);
 
   for (const auto& value : plan_node_->values()) {
-    std::vector<types::DataType> types;
-    types.reserve(value->Deps().size());
-    for (auto* dep : value->Deps()) {
-      PL_ASSIGN_OR_RETURN(auto type, GetTypeOfDep(*dep));
-      types.push_back(type);
+    // When merging partial aggregates the deps refer to the partial aggregate's input.
+    if (!MergesPartialAggs()) {
+      std::vector<types::DataType> types;
+      types.reserve(value->Deps().size());
+      for (auto* dep : value->Deps()) {
+        PL_ASSIGN_OR_RETURN(auto type, GetTypeOfDep(*dep));
+        types.push_back(type);
+      }
     }
     auto def = exec_state->GetUDADefinition(value->uda_id());
     auto uda = def->Make();
@@ -21,12 +21,17 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/numeric/int128.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/memory_tracker.h"
 #include "src/carnot/exec/row_tuple.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/scalar_expression.h"
@@ -40,6 +45,8 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int64(carnot_partial_agg_max_groups);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -70,6 +77,8 @@ class AggNode : public ProcessingNode {
   AggNode() = default;
   virtual ~AggNode() = default;
 
+  bool SupportsSelection() const override { return true; }
+
  protected:
   Status AggregateGroupByNone(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status AggregateGroupByClause(ExecState* exec_state, const table_store::schema::RowBatch& rb);
@@ -85,17 +94,39 @@ class AggNode : public ProcessingNode {
  private:
   AggHashMap agg_hash_map_;
   bool HasNoGroups() const { return plan_node_->groups().empty(); }
+  // A partial aggregate (the PEM side of a split aggregate) emits serialized UDA states instead of
+  // finalized values. A merge aggregate (the Kelvin side) consumes those serialized states. A
+  // combining aggregate sits in between and does both.
+  bool EmitsPartialAggs() const {
+    return plan_node_->combine_partial_aggs() ||
+           (plan_node_->partial_agg() && !plan_node_->finalize_results());
+  }
+  bool MergesPartialAggs() const {
+    return plan_node_->combine_partial_aggs() ||
+           (plan_node_->finalize_results() && !plan_node_->partial_agg());
+  }
+  // Partial aggregates don't need to see all of the data, so once the hash map grows past
+  // FLAGS_carnot_partial_agg_max_groups we flush the partial results and start over.
+  bool ExceedsPartialAggBudget() const;
   // ReadyToEmitBatches returns true when the input stream has reached a point where output batches
   // can be emitted. In the windowed aggregate case, this happens whenever end of window (eow) is
   // reached. In the blocking aggregate case, this happens at eos only.
   bool ReadyToEmitBatches(const table_store::schema::RowBatch& rb) const;
   // When we see a new window, we need to be able to clear the aggregate state.
   Status ClearAggState(ExecState* exec_state);
+  // An estimate of the memory of the groups in the hash map, for the query's memory tracker. The
+  // UDA states and variable size group keys are counted at a fixed size.
+  int64_t HashTableBytes() const;
 
   Status EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UDAInfo& uda_info,
                                           plan::AggregateExpression* expr,
                                           const table_store::schema::RowBatch& rb);
   Status EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val);
+  // Appends the serialized state of all the UDAs as a single value to the builder.
+  Status SerializeUDAInfoValues(const std::vector<UDAInfo>& udas, arrow::ArrayBuilder* builder);
+  // Deserializes the partial aggregates in the input and merges them into the UDAs.
+  Status MergeSerializedUDAInfoValues(const std::vector<UDAInfo>& udas, std::string_view data);
+  Status MergePartialAggregates(const table_store::schema::RowBatch& rb);
   StatusOr<types::DataType> GetTypeOfDep(const plan::ScalarExpression& expr) const;
 
   // Store information about aggregate node from the query planner.
@@ -124,6 +155,9 @@ class AggNode : public ProcessingNode {
   ObjectPool group_args_pool_{"group_args_pool"};
   ObjectPool udas_pool_{"udas_pool"};
 
+  // The input column holding the serialized partial aggregates, when merging partial aggregates.
+  int64_t serialized_col_idx_ = -1;
+
   std::vector<types::DataType> group_data_types_;
   std::vector<types::DataType> value_data_types_;
 
@@ -131,17 +165,50 @@ class AggNode : public ProcessingNode {
   // This vector holds pointers to the row_tuples which are managed by the group_args_pool_.
 
   std::vector<GroupArgs> group_args_chunk_;
+
+  // Group-bys on a single fixed size key (ie. upid or a time bin) look up groups by the raw key
+  // value, so a RowTuple is only built the first time a group is seen. The index points at the
+  // same values as agg_hash_map_, which remains the source of truth for the output.
+  bool single_fixed_size_key_ = false;
+  absl::flat_hash_map<absl::uint128, AggHashValue*> fixed_size_key_index_;
+
+  // Set when the input is ordered by the (int64 or time) first group, see ordered_leading_group in
+  // the plan. Only the groups of the latest value of the first group are then kept open, all the
+  // others are emitted as soon as a batch moves past them.
+  bool ordered_leading_group_ = false;
+  // The latest value of the first group, once a row was seen. Rows with an earlier value would
+  // belong to groups that were emitted already, so they turn ordered_leading_group_ off.
+  int64_t open_leading_group_ = 0;
+  bool seen_leading_group_ = false;
   // END: Variables specific to GroupBy Agg.
 
+  // Holds the estimated size of the hash map in the memory tracker of the query.
+  MemoryReservation hash_table_memory_;
+
   // Creates a mapping between plan cols and stored cols (see above comment).
   Status CreateColumnMapping();
 
+  void GrowGroupArgs(size_t num_rows);
   Status ExtractRowTupleForBatch(const table_store::schema::RowBatch& rb);
   Status HashRowBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  template <types::DataType DT>
+  Status HashRowBatchSingleFixedSizeKey(ExecState* exec_state,
+                                        const table_store::schema::RowBatch& rb);
+  // Copies the agg value input columns into the AggHashValue of each row's group.
+  Status ExtractAggValues(const table_store::schema::RowBatch& rb);
   Status EvaluatePartialAggregates(ExecState* exec_state, size_t num_records);
   Status ResetGroupArgs();
   Status ConvertAggHashMapToRowBatch(ExecState* exec_state,
                                      table_store::schema::RowBatch* output_rb);
+  // Adds the rows of the batch to their groups.
+  Status UpdateGroups(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Sends all of the groups to the children and clears them.
+  Status EmitGroups(ExecState* exec_state, bool eow, bool eos);
+  // Emits the groups that the batch closes, when the input is ordered by the first group. Returns
+  // the rows of the batch that are left to aggregate.
+  StatusOr<table_store::schema::RowBatch> EmitClosedGroups(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  int64_t LeadingGroupAt(const table_store::schema::RowBatch& rb, int64_t row_idx) const;
 
   AggHashValue* CreateAggHashValue(ExecState* exec_state);
   RowTuple* CreateGroupArgsRowTuple() {
@@ -19,6 +19,8 @@
 #include "src/carnot/exec/agg_node.h"
 
 #include <algorithm>
+#include <cstring>
+#include <string>
 
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
@@ -71,6 +73,36 @@ class MinSumWithInitUDA : public udf::UDA {
   types::Int64Value sum_ = 0;
 };
 
+// Same as MinSumUDA but supports partial aggregation.
+class MinSumPartialUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg1, types::Int64Value arg2) {
+    sum_ = sum_.val + std::min(arg1.val, arg2.val);
+  }
+  void Merge(udf::FunctionContext*, const MinSumPartialUDA& other) {
+    sum_ = sum_.val + other.sum_.val;
+  }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+  types::StringValue Serialize(udf::FunctionContext*) {
+    return types::StringValue(reinterpret_cast<const char*>(&sum_.val), sizeof(sum_.val));
+  }
+  Status Deserialize(udf::FunctionContext*, const types::StringValue& data) {
+    std::memcpy(&sum_.val, data.data(), sizeof(sum_.val));
+    return Status::OK();
+  }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
+// The partial aggregate output for a single MinSumPartialUDA.
+types::StringValue SerializedMinSum(int64_t sum) {
+  uint32_t len = sizeof(sum);
+  std::string out(reinterpret_cast<const char*>(&len), sizeof(len));
+  out.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+  return out;
+}
+
 constexpr char kBlockingNoGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -152,6 +184,66 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kOrderedLeadingGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  ordered_leading_group: true
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 2
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 2
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  groups {
+     node: 0
+     index: 1
+  }
+  group_names: "bin"
+  group_names: "g2"
+  value_names: "value1"
+})";
+
+constexpr char kBlockingSingleGroupValuesAfterKeyAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 2
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
 constexpr char kWindowedNoGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -270,6 +362,95 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kPartialSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: true
+  finalize_results: false
+  values {
+    name: "minsum_partial"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+    id: 2
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
+constexpr char kMergeSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: false
+  finalize_results: true
+  values {
+    name: "minsum_partial"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+    id: 2
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
+constexpr char kCombineSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  combine_partial_aggs: true
+  values {
+    name: "minsum_partial"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+    id: 2
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
 std::unique_ptr<ExecState> MakeTestExecState(udf::Registry* registry) {
   auto table_store = std::make_shared<table_store::TableStore>();
   return std::make_unique<ExecState>(registry, table_store, MockResultSinkStubGenerator,
@@ -288,11 +469,13 @@ class AggNodeTest : public ::testing::Test {
     func_registry_ = std::make_unique<udf::Registry>("test");
     EXPECT_TRUE(func_registry_->Register<MinSumUDA>("minsum").ok());
     EXPECT_TRUE(func_registry_->Register<MinSumWithInitUDA>("minsum_w_init").ok());
+    EXPECT_TRUE(func_registry_->Register<MinSumPartialUDA>("minsum_partial").ok());
 
     exec_state_ = MakeTestExecState(func_registry_.get());
     EXPECT_OK(exec_state_->AddUDA(0, "minsum",
                                   std::vector<types::DataType>({types::INT64, types::INT64})));
     EXPECT_OK(exec_state_->AddUDA(1, "minsum_w_init", {types::INT64, types::INT64, types::INT64}));
+    EXPECT_OK(exec_state_->AddUDA(2, "minsum_partial", {types::INT64, types::INT64}));
   }
 
  protected:
@@ -382,6 +565,97 @@ TEST_F(AggNodeTest, single_group_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, single_group_with_selection) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // The unselected rows would change every group if they were aggregated.
+  RowBatchBuilder first_rb(input_rd, 6, /*eow*/ false, /*eos*/ false);
+  first_rb.AddColumn<types::Int64Value>({1, 1, 7, 2, 1, 2})
+      .AddColumn<types::Int64Value>({2, 3, 9, 3, 0, 1});
+  first_rb.get().set_selection(
+      std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 1, 3, 5}));
+
+  RowBatchBuilder second_rb(input_rd, 5, true, true);
+  second_rb.AddColumn<types::Int64Value>({5, 6, 3, 2, 4})
+      .AddColumn<types::Int64Value>({1, 5, 3, 0, 8});
+  second_rb.get().set_selection(
+      std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 1, 2, 4}));
+
+  tester.ConsumeNext(first_rb.get(), 0, 0)
+      .ConsumeNext(second_rb.get(), 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({2, 3, 3, 4, 1, 5})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, no_groups_with_selection) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingNoGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  RowBatchBuilder first_rb(input_rd, 5, /*eow*/ false, /*eos*/ false);
+  first_rb.AddColumn<types::Int64Value>({1, 2, 100, 3, 4})
+      .AddColumn<types::Int64Value>({2, 5, 100, 6, 8});
+  first_rb.get().set_selection(
+      std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 1, 3, 4}));
+
+  tester.ConsumeNext(first_rb.get(), 0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Int64Value>({Int64Value(23)})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_uint128_group_blocking) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingSingleGroupValuesAfterKeyAgg);
+  RowDescriptor input_rd(
+      {types::DataType::UINT128, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::UINT128, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::UInt128Value>({{1, 2}, {1, 3}, {1, 2}, {2, 2}})
+                       .AddColumn<types::Int64Value>({2, 2, 2, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::UInt128Value>({{1, 3}, {1, 2}})
+                       .AddColumn<types::Int64Value>({2, 2})
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::UInt128Value>({{1, 2}, {1, 3}, {2, 2}})
+                          .AddColumn<types::Int64Value>({6, 3, 1})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
@@ -413,6 +687,124 @@ TEST_F(AggNodeTest, multiple_groups_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, ordered_leading_group_emits_closed_groups) {
+  auto plan_node = PlanNodeFromPbtxt(kOrderedLeadingGroupAgg);
+  RowDescriptor input_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      // The groups of bin 10 are complete once bin 20 starts.
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({10, 10, 20, 20})
+                       .AddColumn<types::Int64Value>({1, 2, 1, 1})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Time64NSValue>({10, 10})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .get(),
+                      false)
+      // Bin 20 continues.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, false, false)
+                       .AddColumn<types::Time64NSValue>({20, 20})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({5, 6})
+                       .get(),
+                   0, 0)
+      // A batch that starts with a new bin closes the previous one.
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, false, false)
+                       .AddColumn<types::Time64NSValue>({30})
+                       .AddColumn<types::Int64Value>({1})
+                       .AddColumn<types::Int64Value>({7})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Time64NSValue>({20, 20})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({12, 6})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({30, 40})
+                       .AddColumn<types::Int64Value>({1, 1})
+                       .AddColumn<types::Int64Value>({1, 8})
+                       .get(),
+                   0, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Time64NSValue>({30})
+                          .AddColumn<types::Int64Value>({1})
+                          .AddColumn<types::Int64Value>({8})
+                          .get(),
+                      false)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Time64NSValue>({40})
+                          .AddColumn<types::Int64Value>({1})
+                          .AddColumn<types::Int64Value>({8})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, ordered_leading_group_falls_back_on_unordered_input) {
+  auto plan_node = PlanNodeFromPbtxt(kOrderedLeadingGroupAgg);
+  RowDescriptor input_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({10, 10, 20})
+                       .AddColumn<types::Int64Value>({1, 2, 1})
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Time64NSValue>({10, 10})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .get(),
+                      false)
+      // The batch of another tablet goes back to bin 10, so nothing more is emitted before eos.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 20})
+                       .AddColumn<types::Int64Value>({3, 1})
+                       .AddColumn<types::Int64Value>({4, 5})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, false, false)
+                       .AddColumn<types::Time64NSValue>({30})
+                       .AddColumn<types::Int64Value>({1})
+                       .AddColumn<types::Int64Value>({6})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<types::Time64NSValue>({40})
+                       .AddColumn<types::Int64Value>({1})
+                       .AddColumn<types::Int64Value>({7})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Time64NSValue>({20, 10, 30, 40})
+                          .AddColumn<types::Int64Value>({1, 3, 1, 1})
+                          .AddColumn<types::Int64Value>({8, 4, 6, 7})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_with_string_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
@@ -610,6 +1002,98 @@ TEST_F(AggNodeTest, single_group_blocking_init_args) {
       .Close();
 }
 
+TEST_F(AggNodeTest, partial_agg_flushes_at_group_budget) {
+  FLAGS_carnot_partial_agg_max_groups = 2;
+  auto plan_node = PlanNodeFromPbtxt(kPartialSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::StringValue>({SerializedMinSum(2), SerializedMinSum(3)})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, true, true)
+                       .AddColumn<types::Int64Value>({5, 1, 5})
+                       .AddColumn<types::Int64Value>({1, 5, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 5})
+                          .AddColumn<types::StringValue>({SerializedMinSum(1), SerializedMinSum(4)})
+                          .get(),
+                      false)
+      .Close();
+  FLAGS_carnot_partial_agg_max_groups = 64 * 1024;
+}
+
+TEST_F(AggNodeTest, merge_partial_aggs) {
+  auto plan_node = PlanNodeFromPbtxt(kMergeSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::StringValue>({SerializedMinSum(2), SerializedMinSum(3)})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({1, 5})
+                       .AddColumn<types::StringValue>({SerializedMinSum(1), SerializedMinSum(4)})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 5})
+                          .AddColumn<types::Int64Value>({3, 3, 4})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, combine_partial_aggs) {
+  auto plan_node = PlanNodeFromPbtxt(kCombineSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::StringValue>({SerializedMinSum(2), SerializedMinSum(3)})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({1, 5})
+                       .AddColumn<types::StringValue>({SerializedMinSum(1), SerializedMinSum(4)})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 5})
+                          .AddColumn<types::StringValue>(
+                              {SerializedMinSum(3), SerializedMinSum(3), SerializedMinSum(4)})
+                          .get(),
+                      false)
+      .Close();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/arena_memory_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+DEFINE_bool(carnot_query_arena_mem_pool,
+            gflags::BoolFromEnv("PL_CARNOT_QUERY_ARENA_MEM_POOL", true),
+            "Whether queries allocate their intermediate data from an arena of their own, which is "
+            "released as a whole when the query ends, instead of from the default memory pool.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+ArenaMemoryPool::Ptr ArenaMemoryPool::Create(arrow::MemoryPool* upstream, int64_t chunk_size,
+                                             std::shared_ptr<MemoryTracker> tracker) {
+  DCHECK_GE(chunk_size, kMaxBlockSize);
+  // The constructor is private, so std::make_unique can't be used.
+  return Ptr(new ArenaMemoryPool(upstream, chunk_size, std::move(tracker)));
+}
+
+ArenaMemoryPool::~ArenaMemoryPool() {
+  for (uint8_t* chunk : chunks_) {
+    upstream_->Free(chunk, chunk_size_);
+  }
+  if (tracker_ != nullptr) {
+    tracker_->Release(reserved_bytes_);
+  }
+}
+
+void ArenaMemoryPool::ReserveLocked(int64_t bytes) {
+  reserved_bytes_ += bytes;
+  if (tracker_ != nullptr) {
+    tracker_->Consume(bytes);
+  }
+}
+
+int ArenaMemoryPool::SizeClass(int64_t size) {
+  // The smallest power of two that holds the size, counting from kMinBlockSize.
+  uint64_t block_size = std::max(size, kMinBlockSize);
+  return 64 - __builtin_clzll(block_size - 1) - 6;
+}
+
+arrow::Status ArenaMemoryPool::AllocateBlockLocked(int size_class, uint8_t** out) {
+  uint8_t* block = free_lists_[size_class];
+  if (block != nullptr) {
+    std::memcpy(&free_lists_[size_class], block, sizeof(uint8_t*));
+    *out = block;
+    return arrow::Status::OK();
+  }
+  int64_t block_size = BlockSize(size_class);
+  if (chunk_remaining_ < block_size) {
+    // The rest of the chunk is left unused. Chunks are allocated from the upstream pool, which
+    // aligns them to 64 bytes, and the size classes keep the blocks aligned.
+    uint8_t* chunk;
+    ARROW_RETURN_NOT_OK(upstream_->Allocate(chunk_size_, &chunk));
+    chunks_.push_back(chunk);
+    ReserveLocked(chunk_size_);
+    chunk_pos_ = chunk;
+    chunk_remaining_ = chunk_size_;
+  }
+  *out = chunk_pos_;
+  chunk_pos_ += block_size;
+  chunk_remaining_ -= block_size;
+  return arrow::Status::OK();
+}
+
+arrow::Status ArenaMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  absl::MutexLock lock(&lock_);
+  DCHECK(!released_);
+  if (size > kMaxBlockSize) {
+    ARROW_RETURN_NOT_OK(upstream_->Allocate(size, out));
+    ReserveLocked(size);
+  } else {
+    ARROW_RETURN_NOT_OK(AllocateBlockLocked(SizeClass(size), out));
+  }
+  ++num_buffers_;
+  bytes_allocated_ += size;
+  max_memory_ = std::max(max_memory_, bytes_allocated_);
+  return arrow::Status::OK();
+}
+
+arrow::Status ArenaMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (old_size <= kMaxBlockSize && new_size <= kMaxBlockSize &&
+      SizeClass(old_size) == SizeClass(new_size)) {
+    // The block already holds the new size.
+    absl::MutexLock lock(&lock_);
+    bytes_allocated_ += new_size - old_size;
+    max_memory_ = std::max(max_memory_, bytes_allocated_);
+    return arrow::Status::OK();
+  }
+  uint8_t* out;
+  ARROW_RETURN_NOT_OK(Allocate(new_size, &out));
+  std::memcpy(out, *ptr, std::min(old_size, new_size));
+  Free(*ptr, old_size);
+  *ptr = out;
+  return arrow::Status::OK();
+}
+
+void ArenaMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  bool done;
+  {
+    absl::MutexLock lock(&lock_);
+    if (size > kMaxBlockSize) {
+      upstream_->Free(buffer, size);
+      ReserveLocked(-size);
+    } else {
+      int size_class = SizeClass(size);
+      std::memcpy(buffer, &free_lists_[size_class], sizeof(uint8_t*));
+      free_lists_[size_class] = buffer;
+    }
+    --num_buffers_;
+    bytes_allocated_ -= size;
+    done = DoneLocked();
+  }
+  if (done) {
+    delete this;
+  }
+}
+
+void ArenaMemoryPool::Release() {
+  bool done;
+  {
+    absl::MutexLock lock(&lock_);
+    released_ = true;
+    done = DoneLocked();
+    if (!done) {
+      VLOG(1) << absl::Substitute(
+          "Keeping the arena of a finished query, $0 buffers ($1 bytes) outlive it.", num_buffers_,
+          bytes_allocated_);
+    }
+  }
+  if (done) {
+    delete this;
+  }
+}
+
+int64_t ArenaMemoryPool::bytes_allocated() const {
+  absl::MutexLock lock(&lock_);
+  return bytes_allocated_;
+}
+
+int64_t ArenaMemoryPool::max_memory() const {
+  absl::MutexLock lock(&lock_);
+  return max_memory_;
+}
+
+int64_t ArenaMemoryPool::reserved_bytes() const {
+  absl::MutexLock lock(&lock_);
+  return reserved_bytes_;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/exec/memory_tracker.h"
+#include "src/common/base/base.h"
+
+DECLARE_bool(carnot_query_arena_mem_pool);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ArenaMemoryPool is an arrow::MemoryPool for the intermediate data of a single query.
+ *
+ * Allocations of up to kMaxBlockSize bytes are rounded up to a power of two size class, and carved
+ * out of large chunks allocated from the upstream pool. Freed blocks go to a free list per size
+ * class, for the query to reuse, rather than back to malloc. Larger allocations are passed on to
+ * the upstream pool. All of the chunks are released at once, when the pool is.
+ *
+ * Buffers that outlive the query, e.g. rows that are cached or written to a table, keep the pool
+ * alive: the owner releases the pool rather than deleting it, and the pool deletes itself once
+ * the last of its buffers is freed. Data known to outlive the query should still be allocated from
+ * the upstream pool, so that it doesn't hold on to the chunks of the query.
+ *
+ * The bytes the pool holds from the upstream pool are counted by the memory tracker, if any.
+ */
+class ArenaMemoryPool : public arrow::MemoryPool {
+ public:
+  static constexpr int64_t kMinBlockSize = 64;
+  static constexpr int64_t kMaxBlockSize = 64 * 1024;
+  static constexpr int64_t kDefaultChunkSize = 1024 * 1024;
+
+  // Releases the pool when the owner is done with it.
+  struct Releaser {
+    void operator()(ArenaMemoryPool* pool) const { pool->Release(); }
+  };
+  using Ptr = std::unique_ptr<ArenaMemoryPool, Releaser>;
+
+  static Ptr Create(arrow::MemoryPool* upstream = arrow::default_memory_pool(),
+                    int64_t chunk_size = kDefaultChunkSize,
+                    std::shared_ptr<MemoryTracker> tracker = nullptr);
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  // The bytes of the buffers allocated from the pool and not freed yet.
+  int64_t bytes_allocated() const override;
+  // The peak of bytes_allocated().
+  int64_t max_memory() const override;
+  // The bytes the pool holds from the upstream pool, for its chunks and large allocations.
+  int64_t reserved_bytes() const;
+
+ private:
+  // The number of power of two size classes from kMinBlockSize to kMaxBlockSize.
+  static constexpr int kNumSizeClasses = 11;
+
+  ArenaMemoryPool(arrow::MemoryPool* upstream, int64_t chunk_size,
+                  std::shared_ptr<MemoryTracker> tracker)
+      : upstream_(upstream), chunk_size_(chunk_size), tracker_(std::move(tracker)) {}
+  ~ArenaMemoryPool() override;
+
+  static int SizeClass(int64_t size);
+  static int64_t BlockSize(int size_class) { return kMinBlockSize << size_class; }
+
+  // Deletes the pool once all of its buffers are freed.
+  void Release();
+  // Counts the bytes taken from (or, if negative, returned to) the upstream pool.
+  void ReserveLocked(int64_t bytes) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  arrow::Status AllocateBlockLocked(int size_class, uint8_t** out)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Returns true if the pool is released and has no buffers left, so that it can be deleted.
+  bool DoneLocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return released_ && num_buffers_ == 0;
+  }
+
+  arrow::MemoryPool* const upstream_;
+  const int64_t chunk_size_;
+  const std::shared_ptr<MemoryTracker> tracker_;
+
+  mutable absl::Mutex lock_;
+  // The freed blocks of each size class, each holding a pointer to the next.
+  std::array<uint8_t*, kNumSizeClasses> free_lists_ ABSL_GUARDED_BY(lock_) = {};
+  std::vector<uint8_t*> chunks_ ABSL_GUARDED_BY(lock_);
+  // The unused part of the last chunk.
+  uint8_t* chunk_pos_ ABSL_GUARDED_BY(lock_) = nullptr;
+  int64_t chunk_remaining_ ABSL_GUARDED_BY(lock_) = 0;
+
+  int64_t num_buffers_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t bytes_allocated_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t max_memory_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t reserved_bytes_ ABSL_GUARDED_BY(lock_) = 0;
+  bool released_ ABSL_GUARDED_BY(lock_) = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+#include "src/carnot/exec/arena_memory_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(ArenaMemoryPoolTest, reuses_freed_blocks) {
+  auto pool = ArenaMemoryPool::Create();
+
+  uint8_t* a;
+  uint8_t* b;
+  ASSERT_TRUE(pool->Allocate(100, &a).ok());
+  ASSERT_TRUE(pool->Allocate(120, &b).ok());
+  EXPECT_NE(a, b);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a) % 64);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(b) % 64);
+  EXPECT_EQ(220, pool->bytes_allocated());
+  EXPECT_EQ(ArenaMemoryPool::kDefaultChunkSize, pool->reserved_bytes());
+
+  // Blocks of the same size class are reused.
+  pool->Free(a, 100);
+  uint8_t* c;
+  ASSERT_TRUE(pool->Allocate(65, &c).ok());
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(185, pool->bytes_allocated());
+  EXPECT_EQ(220, pool->max_memory());
+
+  pool->Free(b, 120);
+  pool->Free(c, 65);
+  EXPECT_EQ(0, pool->bytes_allocated());
+  EXPECT_EQ(220, pool->max_memory());
+}
+
+TEST(ArenaMemoryPoolTest, reallocates) {
+  auto pool = ArenaMemoryPool::Create();
+
+  uint8_t* buf;
+  ASSERT_TRUE(pool->Allocate(70, &buf).ok());
+  std::memset(buf, 7, 70);
+  uint8_t* orig = buf;
+
+  // Reallocating within the size class keeps the block.
+  ASSERT_TRUE(pool->Reallocate(70, 128, &buf).ok());
+  EXPECT_EQ(orig, buf);
+
+  ASSERT_TRUE(pool->Reallocate(128, 100 * 1024, &buf).ok());
+  EXPECT_NE(orig, buf);
+  EXPECT_EQ(7, buf[0]);
+  EXPECT_EQ(7, buf[69]);
+  EXPECT_EQ(100 * 1024, pool->bytes_allocated());
+  EXPECT_EQ(ArenaMemoryPool::kDefaultChunkSize + 100 * 1024, pool->reserved_bytes());
+
+  pool->Free(buf, 100 * 1024);
+  EXPECT_EQ(0, pool->bytes_allocated());
+  EXPECT_EQ(ArenaMemoryPool::kDefaultChunkSize, pool->reserved_bytes());
+}
+
+TEST(ArenaMemoryPoolTest, counts_reserved_bytes_in_tracker) {
+  auto tracker = std::make_shared<MemoryTracker>("Query 1", /* limit_bytes */ 0);
+  auto pool = ArenaMemoryPool::Create(arrow::default_memory_pool(),
+                                      ArenaMemoryPool::kDefaultChunkSize, tracker);
+
+  uint8_t* small;
+  uint8_t* large;
+  ASSERT_TRUE(pool->Allocate(100, &small).ok());
+  ASSERT_TRUE(pool->Allocate(100 * 1024, &large).ok());
+  EXPECT_EQ(ArenaMemoryPool::kDefaultChunkSize + 100 * 1024, tracker->bytes());
+
+  pool->Free(large, 100 * 1024);
+  pool->Free(small, 100);
+  EXPECT_EQ(ArenaMemoryPool::kDefaultChunkSize, tracker->bytes());
+  pool.reset();
+  EXPECT_EQ(0, tracker->bytes());
+}
+
+TEST(ArenaMemoryPoolTest, outlives_release_while_buffers_remain) {
+  auto pool = ArenaMemoryPool::Create(arrow::default_memory_pool(),
+                                      /* chunk_size */ ArenaMemoryPool::kMaxBlockSize);
+  int64_t upstream_bytes = arrow::default_memory_pool()->bytes_allocated();
+
+  ArenaMemoryPool* raw_pool = pool.get();
+  uint8_t* buf;
+  ASSERT_TRUE(raw_pool->Allocate(ArenaMemoryPool::kMaxBlockSize, &buf).ok());
+  std::memset(buf, 1, ArenaMemoryPool::kMaxBlockSize);
+  EXPECT_EQ(upstream_bytes + ArenaMemoryPool::kMaxBlockSize,
+            arrow::default_memory_pool()->bytes_allocated());
+
+  // The buffer is still usable after the query releases the pool, and the chunks are freed with it.
+  pool.reset();
+  EXPECT_EQ(1, buf[ArenaMemoryPool::kMaxBlockSize - 1]);
+  raw_pool->Free(buf, ArenaMemoryPool::kMaxBlockSize);
+  EXPECT_EQ(upstream_bytes, arrow::default_memory_pool()->bytes_allocated());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
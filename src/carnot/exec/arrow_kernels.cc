@@ -0,0 +1,334 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/arrow_kernels.h"
+
+#include <arrow/builder.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/match.h>
+
+#include "src/shared/types/types.h"
+
+DEFINE_bool(carnot_use_arrow_kernels, gflags::BoolFromEnv("PL_CARNOT_USE_ARROW_KERNELS", true),
+            "Whether the arrow native expression evaluator runs common builtins as kernels on the "
+            "arrow arrays instead of through the UDF wrappers.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+using types::DataType;
+
+// Reads the values of an argument that is an array.
+template <DataType DT>
+class ArrayReader {
+ public:
+  using native_type = typename types::DataTypeTraits<DT>::native_type;
+  using arrow_array_type = typename types::DataTypeTraits<DT>::arrow_array_type;
+
+  explicit ArrayReader(const arrow::Array& array)
+      : values_(static_cast<const arrow_array_type&>(array).raw_values()) {}
+  native_type operator[](int64_t idx) const { return values_[idx]; }
+
+ private:
+  const native_type* values_;
+};
+
+template <>
+class ArrayReader<DataType::BOOLEAN> {
+ public:
+  explicit ArrayReader(const arrow::Array& array)
+      : array_(static_cast<const arrow::BooleanArray&>(array)) {}
+  bool operator[](int64_t idx) const { return array_.Value(idx); }
+
+ private:
+  const arrow::BooleanArray& array_;
+};
+
+template <>
+class ArrayReader<DataType::STRING> {
+ public:
+  explicit ArrayReader(const arrow::Array& array)
+      : array_(static_cast<const arrow::StringArray&>(array)) {}
+  std::string_view operator[](int64_t idx) const {
+    int32_t length = 0;
+    const uint8_t* data = array_.GetValue(idx, &length);
+    return std::string_view(reinterpret_cast<const char*>(data), length);
+  }
+
+ private:
+  const arrow::StringArray& array_;
+};
+
+// Reads the value of an argument that is a constant, for every row.
+template <DataType DT>
+class ConstantReader {
+ public:
+  using native_type = typename types::DataTypeTraits<DT>::native_type;
+
+  explicit ConstantReader(const plan::ScalarValue& val) : value_(Value(val)) {}
+  native_type operator[](int64_t) const { return value_; }
+
+ private:
+  static native_type Value(const plan::ScalarValue& val) {
+    if constexpr (DT == DataType::BOOLEAN) {
+      return val.BoolValue();
+    } else if constexpr (DT == DataType::FLOAT64) {
+      return val.Float64Value();
+    } else if constexpr (DT == DataType::TIME64NS) {
+      return val.Time64NSValue();
+    } else {
+      static_assert(DT == DataType::INT64);
+      return val.Int64Value();
+    }
+  }
+
+  const native_type value_;
+};
+
+template <>
+class ConstantReader<DataType::STRING> {
+ public:
+  explicit ConstantReader(const plan::ScalarValue& val) : value_(val.StringValue()) {}
+  std::string_view operator[](int64_t) const { return value_; }
+
+ private:
+  const std::string value_;
+};
+
+template <typename TOp, DataType TOut, typename... TReaders>
+StatusOr<std::shared_ptr<arrow::Array>> Apply(int64_t num_rows, const TReaders&... readers) {
+  typename types::DataTypeTraits<TOut>::arrow_builder_type builder(arrow::default_memory_pool());
+  PL_RETURN_IF_ERROR(builder.Reserve(num_rows));
+  for (int64_t i = 0; i < num_rows; ++i) {
+    builder.UnsafeAppend(TOp::Apply(readers[i]...));
+  }
+  std::shared_ptr<arrow::Array> output;
+  PL_RETURN_IF_ERROR(builder.Finish(&output));
+  return output;
+}
+
+template <typename TOp, DataType TOut, DataType TArg>
+StatusOr<std::shared_ptr<arrow::Array>> UnaryKernel(const std::vector<ArrowKernelArg>& args,
+                                                    int64_t num_rows) {
+  if (args[0].constant != nullptr) {
+    return Apply<TOp, TOut>(num_rows, ConstantReader<TArg>(*args[0].constant));
+  }
+  return Apply<TOp, TOut>(num_rows, ArrayReader<TArg>(*args[0].array));
+}
+
+// The readers are picked once per batch, so that the loop over the rows doesn't branch on them.
+template <typename TOp, DataType TOut, DataType TLHS, DataType TRHS>
+StatusOr<std::shared_ptr<arrow::Array>> BinaryKernel(const std::vector<ArrowKernelArg>& args,
+                                                     int64_t num_rows) {
+  const ArrowKernelArg& lhs = args[0];
+  const ArrowKernelArg& rhs = args[1];
+  if (lhs.constant != nullptr && rhs.constant != nullptr) {
+    return Apply<TOp, TOut>(num_rows, ConstantReader<TLHS>(*lhs.constant),
+                            ConstantReader<TRHS>(*rhs.constant));
+  }
+  if (lhs.constant != nullptr) {
+    return Apply<TOp, TOut>(num_rows, ConstantReader<TLHS>(*lhs.constant),
+                            ArrayReader<TRHS>(*rhs.array));
+  }
+  if (rhs.constant != nullptr) {
+    return Apply<TOp, TOut>(num_rows, ArrayReader<TLHS>(*lhs.array),
+                            ConstantReader<TRHS>(*rhs.constant));
+  }
+  return Apply<TOp, TOut>(num_rows, ArrayReader<TLHS>(*lhs.array), ArrayReader<TRHS>(*rhs.array));
+}
+
+// The ops match the semantics of the builtin UDFs of the same names.
+struct AddOp {
+  template <typename T1, typename T2>
+  static auto Apply(T1 a, T2 b) {
+    return a + b;
+  }
+};
+struct SubtractOp {
+  template <typename T1, typename T2>
+  static auto Apply(T1 a, T2 b) {
+    return a - b;
+  }
+};
+struct MultiplyOp {
+  template <typename T1, typename T2>
+  static auto Apply(T1 a, T2 b) {
+    return a * b;
+  }
+};
+struct DivideOp {
+  template <typename T1, typename T2>
+  static double Apply(T1 a, T2 b) {
+    return static_cast<double>(a) / static_cast<double>(b);
+  }
+};
+struct EqualOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a == b;
+  }
+};
+struct NotEqualOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a != b;
+  }
+};
+struct GreaterThanOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a > b;
+  }
+};
+struct GreaterThanEqualOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a >= b;
+  }
+};
+struct LessThanOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a < b;
+  }
+};
+struct LessThanEqualOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a <= b;
+  }
+};
+struct LogicalAndOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a && b;
+  }
+};
+struct LogicalOrOp {
+  template <typename T>
+  static bool Apply(T a, T b) {
+    return a || b;
+  }
+};
+struct LogicalNotOp {
+  template <typename T>
+  static bool Apply(T a) {
+    return !a;
+  }
+};
+struct ContainsOp {
+  static bool Apply(std::string_view a, std::string_view b) { return absl::StrContains(a, b); }
+};
+
+// Kernels are keyed by the UDF name, return type and argument types.
+using KernelKey = std::tuple<std::string, DataType, std::vector<DataType>>;
+using KernelMap = absl::flat_hash_map<KernelKey, ArrowKernel>;
+
+template <typename TOp, DataType TOut, DataType TArg>
+void AddUnaryKernel(KernelMap* kernels, const std::string& name) {
+  kernels->emplace(KernelKey{name, TOut, {TArg}}, &UnaryKernel<TOp, TOut, TArg>);
+}
+
+template <typename TOp, DataType TOut, DataType TLHS, DataType TRHS>
+void AddBinaryKernel(KernelMap* kernels, const std::string& name) {
+  kernels->emplace(KernelKey{name, TOut, {TLHS, TRHS}}, &BinaryKernel<TOp, TOut, TLHS, TRHS>);
+}
+
+template <typename TOp>
+void AddArithmeticKernels(KernelMap* kernels, const std::string& name) {
+  AddBinaryKernel<TOp, DataType::INT64, DataType::INT64, DataType::INT64>(kernels, name);
+  AddBinaryKernel<TOp, DataType::FLOAT64, DataType::FLOAT64, DataType::INT64>(kernels, name);
+  AddBinaryKernel<TOp, DataType::FLOAT64, DataType::INT64, DataType::FLOAT64>(kernels, name);
+  AddBinaryKernel<TOp, DataType::FLOAT64, DataType::FLOAT64, DataType::FLOAT64>(kernels, name);
+}
+
+template <typename TOp, DataType... TArgs>
+void AddPredicateKernels(KernelMap* kernels, const std::string& name) {
+  (AddBinaryKernel<TOp, DataType::BOOLEAN, TArgs, TArgs>(kernels, name), ...);
+}
+
+KernelMap* CreateKernels() {
+  auto kernels = new KernelMap();
+  AddArithmeticKernels<AddOp>(kernels, "add");
+  AddBinaryKernel<AddOp, DataType::TIME64NS, DataType::TIME64NS, DataType::INT64>(kernels, "add");
+  AddBinaryKernel<AddOp, DataType::TIME64NS, DataType::INT64, DataType::TIME64NS>(kernels, "add");
+  AddArithmeticKernels<SubtractOp>(kernels, "subtract");
+  AddBinaryKernel<SubtractOp, DataType::INT64, DataType::TIME64NS, DataType::INT64>(kernels,
+                                                                                     "subtract");
+  AddBinaryKernel<SubtractOp, DataType::INT64, DataType::TIME64NS, DataType::TIME64NS>(kernels,
+                                                                                        "subtract");
+  AddBinaryKernel<SubtractOp, DataType::INT64, DataType::INT64, DataType::TIME64NS>(kernels,
+                                                                                     "subtract");
+  AddArithmeticKernels<MultiplyOp>(kernels, "multiply");
+  AddBinaryKernel<DivideOp, DataType::FLOAT64, DataType::INT64, DataType::INT64>(kernels, "divide");
+  AddBinaryKernel<DivideOp, DataType::FLOAT64, DataType::FLOAT64, DataType::INT64>(kernels,
+                                                                                    "divide");
+  AddBinaryKernel<DivideOp, DataType::FLOAT64, DataType::INT64, DataType::FLOAT64>(kernels,
+                                                                                    "divide");
+  AddBinaryKernel<DivideOp, DataType::FLOAT64, DataType::FLOAT64, DataType::FLOAT64>(kernels,
+                                                                                      "divide");
+
+  // Floating point equality is approximate in the builtins, so it's left to them. The string
+  // variants of greaterThanEqual and lessThanEqual are strict comparisons in the builtins.
+  AddPredicateKernels<EqualOp, DataType::INT64, DataType::BOOLEAN, DataType::STRING,
+                       DataType::TIME64NS>(kernels, "equal");
+  AddPredicateKernels<NotEqualOp, DataType::INT64, DataType::BOOLEAN, DataType::STRING,
+                       DataType::TIME64NS>(kernels, "notEqual");
+  AddPredicateKernels<GreaterThanOp, DataType::INT64, DataType::FLOAT64, DataType::STRING>(
+      kernels, "greaterThan");
+  AddPredicateKernels<LessThanOp, DataType::INT64, DataType::FLOAT64, DataType::STRING>(
+      kernels, "lessThan");
+  AddPredicateKernels<GreaterThanEqualOp, DataType::INT64, DataType::FLOAT64,
+                       DataType::TIME64NS>(kernels, "greaterThanEqual");
+  AddPredicateKernels<LessThanEqualOp, DataType::INT64, DataType::FLOAT64, DataType::TIME64NS>(
+      kernels, "lessThanEqual");
+
+  AddPredicateKernels<LogicalAndOp, DataType::BOOLEAN, DataType::INT64>(kernels, "logicalAnd");
+  AddPredicateKernels<LogicalOrOp, DataType::BOOLEAN, DataType::INT64>(kernels, "logicalOr");
+  AddUnaryKernel<LogicalNotOp, DataType::BOOLEAN, DataType::BOOLEAN>(kernels, "logicalNot");
+  AddUnaryKernel<LogicalNotOp, DataType::BOOLEAN, DataType::INT64>(kernels, "logicalNot");
+
+  AddBinaryKernel<ContainsOp, DataType::BOOLEAN, DataType::STRING, DataType::STRING>(kernels,
+                                                                                     "contains");
+  return kernels;
+}
+
+}  // namespace
+
+ArrowKernel GetArrowKernel(const udf::ScalarUDFDefinition& def) {
+  static const KernelMap* const kKernels = CreateKernels();
+  if (!FLAGS_carnot_use_arrow_kernels || !def.init_arguments().empty()) {
+    return nullptr;
+  }
+  auto it = kKernels->find(KernelKey{def.name(), def.exec_return_type(), def.exec_arguments()});
+  if (it == kKernels->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <memory>
+#include <vector>
+
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/carnot/udf/udf_definition.h"
+#include "src/common/base/base.h"
+
+DECLARE_bool(carnot_use_arrow_kernels);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * An argument of an ArrowKernel. It's either an array with a value for every row, or a constant
+ * that applies to all of the rows.
+ */
+struct ArrowKernelArg {
+  std::shared_ptr<arrow::Array> array;
+  const plan::ScalarValue* constant = nullptr;
+};
+
+/**
+ * An ArrowKernel evaluates a builtin UDF directly on arrow arrays. Constant arguments are read as
+ * is rather than expanded into arrays, strings are compared in place, and the result is appended
+ * straight into the output array.
+ */
+using ArrowKernel = StatusOr<std::shared_ptr<arrow::Array>> (*)(
+    const std::vector<ArrowKernelArg>& args, int64_t num_rows);
+
+/**
+ * Returns the kernel for the UDF, or nullptr if it has to be evaluated with the UDF itself.
+ *
+ * The builtins are recognized by their name, argument types and return type, so this relies on
+ * them keeping their math_ops and string_ops semantics.
+ */
+ArrowKernel GetArrowKernel(const udf::ScalarUDFDefinition& def);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/arrow_kernels.h"
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/strings/match.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using types::ToArrow;
+using udf::FunctionContext;
+
+class ContainsUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::StringValue v1, types::StringValue v2) {
+    return absl::StrContains(v1, v2);
+  }
+};
+
+class LogicalAndUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::BoolValue v1, types::BoolValue v2) {
+    return v1.val && v2.val;
+  }
+};
+
+class SubtractUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Time64NSValue v1, types::Int64Value v2) {
+    return v1.val - v2.val;
+  }
+};
+
+class ConcatUDF : public udf::ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue v1, types::StringValue v2) {
+    return v1 + v2;
+  }
+};
+
+class ApproxEqualUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::Float64Value v1, types::Float64Value v2) {
+    return std::abs(v1.val - v2.val) < 1e-6;
+  }
+};
+
+class ArrowKernelsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    registry_ = std::make_unique<udf::Registry>("test_registry");
+    EXPECT_OK(registry_->Register<ContainsUDF>("contains"));
+    EXPECT_OK(registry_->Register<LogicalAndUDF>("logicalAnd"));
+    EXPECT_OK(registry_->Register<SubtractUDF>("subtract"));
+    EXPECT_OK(registry_->Register<ConcatUDF>("add"));
+    EXPECT_OK(registry_->Register<ApproxEqualUDF>("equal"));
+  }
+
+  ArrowKernel KernelOf(const std::string& name, const std::vector<types::DataType>& arg_types) {
+    auto def_or_s = registry_->GetScalarUDFDefinition(name, arg_types);
+    EXPECT_OK(def_or_s);
+    return GetArrowKernel(*def_or_s.ConsumeValueOrDie());
+  }
+
+  std::unique_ptr<plan::ScalarValue> Constant(const std::string& pbtxt) {
+    planpb::ScalarValue pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(pbtxt, &pb));
+    auto val = std::make_unique<plan::ScalarValue>();
+    EXPECT_OK(val->Init(pb));
+    return val;
+  }
+
+  std::unique_ptr<udf::Registry> registry_;
+};
+
+TEST_F(ArrowKernelsTest, only_matching_builtins_have_kernels) {
+  EXPECT_NE(nullptr, KernelOf("contains", {types::STRING, types::STRING}));
+  EXPECT_NE(nullptr, KernelOf("logicalAnd", {types::BOOLEAN, types::BOOLEAN}));
+  EXPECT_NE(nullptr, KernelOf("subtract", {types::TIME64NS, types::INT64}));
+  // String concatenation and approximate float equality are left to the UDFs.
+  EXPECT_EQ(nullptr, KernelOf("add", {types::STRING, types::STRING}));
+  EXPECT_EQ(nullptr, KernelOf("equal", {types::FLOAT64, types::FLOAT64}));
+}
+
+TEST_F(ArrowKernelsTest, string_column_and_constant) {
+  ArrowKernel kernel = KernelOf("contains", {types::STRING, types::STRING});
+  ASSERT_NE(nullptr, kernel);
+
+  std::vector<types::StringValue> haystacks = {"abcd", "bcd", "", "xxabxx"};
+  auto needle = Constant(R"(data_type: STRING string_value: "ab")");
+  std::vector<ArrowKernelArg> args = {{ToArrow(haystacks, arrow::default_memory_pool()), nullptr},
+                                      {nullptr, needle.get()}};
+  auto output_or_s = kernel(args, haystacks.size());
+  ASSERT_OK(output_or_s);
+  auto output = std::static_pointer_cast<arrow::BooleanArray>(output_or_s.ConsumeValueOrDie());
+  ASSERT_EQ(4, output->length());
+  EXPECT_TRUE(output->Value(0));
+  EXPECT_FALSE(output->Value(1));
+  EXPECT_FALSE(output->Value(2));
+  EXPECT_TRUE(output->Value(3));
+}
+
+TEST_F(ArrowKernelsTest, boolean_and_time_columns) {
+  std::vector<types::BoolValue> lhs = {true, true, false, false};
+  std::vector<types::BoolValue> rhs = {true, false, true, false};
+  std::vector<ArrowKernelArg> args = {{ToArrow(lhs, arrow::default_memory_pool()), nullptr},
+                                      {ToArrow(rhs, arrow::default_memory_pool()), nullptr}};
+  auto and_or_s = KernelOf("logicalAnd", {types::BOOLEAN, types::BOOLEAN})(args, lhs.size());
+  ASSERT_OK(and_or_s);
+  auto and_output = std::static_pointer_cast<arrow::BooleanArray>(and_or_s.ConsumeValueOrDie());
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    EXPECT_EQ(lhs[i].val && rhs[i].val, and_output->Value(i)) << i;
+  }
+
+  std::vector<types::Time64NSValue> times = {100, 250, 1000};
+  auto offset = Constant(R"(data_type: INT64 int64_value: 50)");
+  auto sub_or_s = KernelOf("subtract", {types::TIME64NS, types::INT64})(
+      {{ToArrow(times, arrow::default_memory_pool()), nullptr}, {nullptr, offset.get()}},
+      times.size());
+  ASSERT_OK(sub_or_s);
+  auto sub_output = std::static_pointer_cast<arrow::Int64Array>(sub_or_s.ConsumeValueOrDie());
+  EXPECT_EQ(50, sub_output->Value(0));
+  EXPECT_EQ(200, sub_output->Value(1));
+  EXPECT_EQ(950, sub_output->Value(2));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/as_of_join_node.h"
+
+#include <arrow/memory_pool.h>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include <absl/strings/str_join.h>
+#include <absl/strings/substitute.h>
+#include <magic_enum.hpp>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/udf_wrapper.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+constexpr size_t kDefaultAsOfJoinRowBatchSize = 1024;
+
+template <types::DataType DT>
+Status AppendDefaultValue(arrow::ArrayBuilder* builder) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(ValueType()));
+}
+
+template <types::DataType DT>
+Status AppendRowTupleValue(arrow::ArrayBuilder* builder, const RowTuple& rt, size_t idx) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(rt.GetValue<ValueType>(idx)));
+}
+
+bool IsTimeType(types::DataType type) {
+  return type == types::TIME64NS || type == types::INT64;
+}
+
+}  // namespace
+
+std::string AsOfJoinNode::DebugStringImpl() {
+  return absl::Substitute("Exec::AsOfJoinNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
+}
+
+Status AsOfJoinNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::JOIN_OPERATOR);
+  if (input_descriptors_.size() != 2) {
+    return error::InvalidArgument("Join operator expects a two input relations, got $0",
+                                  input_descriptors_.size());
+  }
+  const auto* join_plan_node = static_cast<const plan::JoinOperator*>(&plan_node);
+  plan_node_ = std::make_unique<plan::JoinOperator>(*join_plan_node);
+  if (!plan_node_->as_of()) {
+    return error::InvalidArgument("AsOfJoinNode expects an as-of join");
+  }
+  output_rows_per_batch_ = plan_node_->rows_per_batch() == 0 ? kDefaultAsOfJoinRowBatchSize
+                                                             : plan_node_->rows_per_batch();
+  emit_unmatched_left_rows_ = plan_node_->type() == planpb::JoinOperator::LEFT_OUTER;
+  tolerance_ns_ = plan_node_->tolerance_ns();
+
+  time_col_indices_[0] = plan_node_->left_time_column_index();
+  time_col_indices_[1] = plan_node_->right_time_column_index();
+  for (size_t parent_index = 0; parent_index < 2; ++parent_index) {
+    const auto& input_descriptor = input_descriptors_[parent_index];
+    if (time_col_indices_[parent_index] >= static_cast<int64_t>(input_descriptor.size())) {
+      return error::InvalidArgument("As-of join time column $0 is out of range",
+                                    time_col_indices_[parent_index]);
+    }
+    time_data_types_[parent_index] = input_descriptor.type(time_col_indices_[parent_index]);
+    if (!IsTimeType(time_data_types_[parent_index])) {
+      return error::InvalidArgument("As-of join time columns must be times or integers, got $0",
+                                    magic_enum::enum_name(time_data_types_[parent_index]));
+    }
+  }
+
+  for (const auto& eq_condition : plan_node_->equality_conditions()) {
+    int64_t left_index = eq_condition.left_column_index();
+    int64_t right_index = eq_condition.right_column_index();
+    if (input_descriptors_[0].type(left_index) != input_descriptors_[1].type(right_index)) {
+      return error::InvalidArgument("As-of join keys must have the same types");
+    }
+    key_data_types_.emplace_back(input_descriptors_[0].type(left_index));
+    key_indices_[0].emplace_back(left_index);
+    key_indices_[1].emplace_back(right_index);
+  }
+
+  for (const auto& output_col : plan_node_->output_columns()) {
+    size_t parent_index = output_col.parent_index();
+    int64_t column_index = output_col.column_index();
+    auto dt = input_descriptors_[parent_index].type(column_index);
+    if (parent_index == 0) {
+      output_columns_.push_back(OutputColumn{parent_index, column_index, dt});
+      continue;
+    }
+    output_columns_.push_back(
+        OutputColumn{parent_index, static_cast<int64_t>(right_value_indices_.size()), dt});
+    right_value_indices_.push_back(column_index);
+    right_value_types_.push_back(dt);
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::InitializeColumnBuilders() {
+  for (size_t i = 0; i < output_descriptor_->size(); ++i) {
+    column_builders_[i] =
+        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+    PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
+  }
+  num_output_rows_ = 0;
+  return Status::OK();
+}
+
+Status AsOfJoinNode::PrepareImpl(ExecState*) {
+  column_builders_.resize(output_descriptor_->size());
+  return InitializeColumnBuilders();
+}
+
+Status AsOfJoinNode::OpenImpl(ExecState*) {
+  lookup_key_ = std::make_unique<RowTuple>(&key_data_types_);
+  return Status::OK();
+}
+
+Status AsOfJoinNode::CloseImpl(ExecState*) {
+  right_rows_.clear();
+  pending_left_batches_.clear();
+  column_builders_.clear();
+  return Status::OK();
+}
+
+int64_t AsOfJoinNode::TimeAt(const RowBatch& rb, size_t parent_index, int64_t row_idx) const {
+  auto col = rb.ColumnAt(time_col_indices_[parent_index]).get();
+  if (time_data_types_[parent_index] == types::TIME64NS) {
+    return types::GetValueFromArrowArray<types::TIME64NS>(col, row_idx);
+  }
+  return types::GetValueFromArrowArray<types::INT64>(col, row_idx);
+}
+
+void AsOfJoinNode::ExtractKey(const RowBatch& rb, size_t parent_index, int64_t row_idx) {
+  lookup_key_->Reset();
+  for (size_t k = 0; k < key_data_types_.size(); ++k) {
+    auto col = rb.ColumnAt(key_indices_[parent_index][k]).get();
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(lookup_key_.get(), col, k, row_idx);
+    PL_SWITCH_FOREACH_DATATYPE(key_data_types_[k], TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+Status AsOfJoinNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb,
+                                     size_t parent_index) {
+  if (sent_eos_) {
+    // Every left row has been joined already, the rest of the right parent isn't needed.
+    return Status::OK();
+  }
+  if (parent_index == 1) {
+    BufferRightRows(rb);
+    right_eos_ = right_eos_ || rb.eos();
+  } else {
+    if (rb.num_selected_rows() > 0) {
+      pending_left_batches_.push_back(rb);
+    }
+    left_eos_ = left_eos_ || rb.eos();
+  }
+  return JoinReadyLeftRows(exec_state);
+}
+
+void AsOfJoinNode::BufferRightRows(const RowBatch& rb) {
+  for (int64_t i = 0; i < rb.num_selected_rows(); ++i) {
+    int64_t row_idx = rb.SelectedRowIndex(i);
+    int64_t time = TimeAt(rb, 1, row_idx);
+    right_watermark_ = std::max(right_watermark_, time);
+
+    ExtractKey(rb, 1, row_idx);
+    KeyRows* key_rows = nullptr;
+    auto it = right_rows_.find(lookup_key_.get());
+    if (it != right_rows_.end()) {
+      key_rows = it->second.get();
+    } else {
+      auto new_key_rows = std::make_unique<KeyRows>();
+      new_key_rows->key = std::move(lookup_key_);
+      lookup_key_ = std::make_unique<RowTuple>(&key_data_types_);
+      key_rows = new_key_rows.get();
+      right_rows_.emplace(key_rows->key.get(), std::move(new_key_rows));
+    }
+
+    auto values = std::make_unique<RowTuple>(&right_value_types_);
+    for (size_t v = 0; v < right_value_types_.size(); ++v) {
+      auto col = rb.ColumnAt(right_value_indices_[v]).get();
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(values.get(), col, v, row_idx);
+      PL_SWITCH_FOREACH_DATATYPE(right_value_types_[v], TYPE_CASE);
+#undef TYPE_CASE
+    }
+
+    // Rows arrive in time order, but a late row is still put in its place.
+    auto pos = key_rows->rows.end();
+    while (pos != key_rows->rows.begin() && std::prev(pos)->time > time) {
+      --pos;
+    }
+    key_rows->rows.insert(pos, RightRow{time, std::move(values)});
+  }
+}
+
+const RowTuple* AsOfJoinNode::MatchLeftRow(const RowBatch& rb, int64_t row_idx, int64_t time) {
+  ExtractKey(rb, 0, row_idx);
+  auto it = right_rows_.find(lookup_key_.get());
+  if (it == right_rows_.end()) {
+    return nullptr;
+  }
+  auto& rows = it->second->rows;
+  // The later left rows are at or after this one, so the right rows before the latest one at or
+  // before it can't be matched anymore.
+  while (rows.size() > 1 && rows[1].time <= time) {
+    rows.pop_front();
+  }
+  if (rows.front().time < time - tolerance_ns_) {
+    rows.pop_front();
+  }
+  if (rows.empty()) {
+    right_rows_.erase(it);
+    return nullptr;
+  }
+  if (rows.front().time > time) {
+    return nullptr;
+  }
+  return rows.front().values.get();
+}
+
+void AsOfJoinNode::ExpireRightRows(int64_t time) {
+  for (auto it = right_rows_.begin(); it != right_rows_.end();) {
+    auto& rows = it->second->rows;
+    while (rows.size() > 1 && rows[1].time <= time) {
+      rows.pop_front();
+    }
+    if (!rows.empty() && rows.front().time < time - tolerance_ns_) {
+      rows.pop_front();
+    }
+    if (rows.empty()) {
+      right_rows_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  last_expired_time_ = time;
+  left_rows_since_expiry_ = 0;
+}
+
+Status AsOfJoinNode::AppendOutputRow(const RowBatch& rb, int64_t row_idx,
+                                     const RowTuple* right_values) {
+  for (const auto& [i, col] : Enumerate(output_columns_)) {
+    auto builder = column_builders_[i].get();
+    if (col.parent_index == 0) {
+      auto input_col = rb.ColumnAt(col.index).get();
+#define TYPE_CASE(_dt_)                                    \
+  PL_RETURN_IF_ERROR(table_store::schema::CopyValue<_dt_>( \
+      builder, types::GetValueFromArrowArray<_dt_>(input_col, row_idx)))
+      PL_SWITCH_FOREACH_DATATYPE(col.type, TYPE_CASE);
+#undef TYPE_CASE
+    } else if (right_values == nullptr) {
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendDefaultValue<_dt_>(builder))
+      PL_SWITCH_FOREACH_DATATYPE(col.type, TYPE_CASE);
+#undef TYPE_CASE
+    } else {
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendRowTupleValue<_dt_>(builder, *right_values, col.index))
+      PL_SWITCH_FOREACH_DATATYPE(col.type, TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+  ++num_output_rows_;
+  return Status::OK();
+}
+
+Status AsOfJoinNode::SendOutputBatch(ExecState* exec_state, bool eos) {
+  PL_ASSIGN_OR_RETURN(auto output_batch, RowBatch::FromColumnBuilders(*output_descriptor_, eos,
+                                                                      eos, &column_builders_));
+  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *output_batch));
+  sent_eos_ = eos;
+  return InitializeColumnBuilders();
+}
+
+Status AsOfJoinNode::JoinReadyLeftRows(ExecState* exec_state) {
+  bool waiting_for_right = false;
+  while (!pending_left_batches_.empty() && !waiting_for_right) {
+    const RowBatch& rb = pending_left_batches_.front();
+    for (; next_left_row_ < rb.num_selected_rows(); ++next_left_row_) {
+      int64_t row_idx = rb.SelectedRowIndex(next_left_row_);
+      int64_t time = TimeAt(rb, 0, row_idx);
+      // Right rows with the same time as the latest one can still arrive.
+      if (!right_eos_ && time >= right_watermark_) {
+        waiting_for_right = true;
+        break;
+      }
+      // Expiring the keys that the left rows don't look up takes a pass over all of them, so it's
+      // only done once the left time has moved by the tolerance, and after as many rows as keys.
+      if (++left_rows_since_expiry_ >= right_rows_.size() &&
+          time - tolerance_ns_ > last_expired_time_) {
+        ExpireRightRows(time);
+      }
+
+      const RowTuple* right_values = MatchLeftRow(rb, row_idx, time);
+      if (right_values != nullptr || emit_unmatched_left_rows_) {
+        PL_RETURN_IF_ERROR(AppendOutputRow(rb, row_idx, right_values));
+      }
+      if (num_output_rows_ >= output_rows_per_batch_) {
+        PL_RETURN_IF_ERROR(SendOutputBatch(exec_state, /* eos */ false));
+      }
+    }
+    if (!waiting_for_right) {
+      pending_left_batches_.pop_front();
+      next_left_row_ = 0;
+    }
+  }
+
+  if (left_eos_ && pending_left_batches_.empty()) {
+    return SendOutputBatch(exec_state, /* eos */ true);
+  }
+  if (num_output_rows_ > 0) {
+    return SendOutputBatch(exec_state, /* eos */ false);
+  }
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/array/builder_base.h>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * AsOfJoinNode joins each row of the left parent with the latest row of the right parent that has
+ * the same keys, and a time at or before the time of the left row, by at most the tolerance.
+ *
+ * Both parents must be ordered by their time columns, which are merged as they stream in. A left
+ * row is matched once the right parent has moved past its time, or has ended. Per key, only the
+ * latest right row before the left parent, and the right rows ahead of it, are kept, and they are
+ * expired once they fall out of the tolerance. So each row is visited a constant number of times
+ * and the state is bounded by the skew of the parents, rather than by their size.
+ *
+ * The output follows the order of the left parent. Unmatched left rows are dropped by inner joins,
+ * and get default values for their right columns in left joins.
+ */
+class AsOfJoinNode : public ProcessingNode {
+ public:
+  AsOfJoinNode() = default;
+  virtual ~AsOfJoinNode() = default;
+
+  bool SupportsSelection() const override { return true; }
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  struct RightRow {
+    int64_t time;
+    std::unique_ptr<RowTuple> values;
+  };
+  struct KeyRows {
+    std::unique_ptr<RowTuple> key;
+    // The buffered right rows of the key, ordered by time.
+    std::deque<RightRow> rows;
+  };
+  struct OutputColumn {
+    size_t parent_index;
+    // The index of the input column for left columns, and the index in the buffered right row
+    // values for right columns.
+    int64_t index;
+    types::DataType type;
+  };
+
+  int64_t TimeAt(const table_store::schema::RowBatch& rb, size_t parent_index,
+                 int64_t row_idx) const;
+  void ExtractKey(const table_store::schema::RowBatch& rb, size_t parent_index, int64_t row_idx);
+
+  void BufferRightRows(const table_store::schema::RowBatch& rb);
+  // Matches and emits the left rows whose match can't change anymore.
+  Status JoinReadyLeftRows(ExecState* exec_state);
+  // Returns the right row that the left row matches, if there is one, and drops the rows of the
+  // key that can't match later left rows.
+  const RowTuple* MatchLeftRow(const table_store::schema::RowBatch& rb, int64_t row_idx,
+                               int64_t time);
+  // Drops the right rows of every key that can't match left rows at or after the time.
+  void ExpireRightRows(int64_t time);
+  Status AppendOutputRow(const table_store::schema::RowBatch& rb, int64_t row_idx,
+                         const RowTuple* right_values);
+  Status InitializeColumnBuilders();
+  Status SendOutputBatch(ExecState* exec_state, bool eos);
+
+  std::unique_ptr<plan::JoinOperator> plan_node_;
+  size_t output_rows_per_batch_ = 0;
+  bool emit_unmatched_left_rows_ = false;
+  int64_t tolerance_ns_ = 0;
+
+  // The key and time columns of each parent.
+  std::vector<int64_t> key_indices_[2];
+  int64_t time_col_indices_[2] = {-1, -1};
+  types::DataType time_data_types_[2] = {types::DataType::DATA_TYPE_UNKNOWN,
+                                         types::DataType::DATA_TYPE_UNKNOWN};
+  std::vector<types::DataType> key_data_types_;
+
+  // The right columns in the output, which are copied out of the buffered right rows.
+  std::vector<int64_t> right_value_indices_;
+  std::vector<types::DataType> right_value_types_;
+  std::vector<OutputColumn> output_columns_;
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
+  size_t num_output_rows_ = 0;
+
+  AbslRowTupleHashMap<std::unique_ptr<KeyRows>> right_rows_;
+  // The scratch key that the right rows are looked up with.
+  std::unique_ptr<RowTuple> lookup_key_;
+  // The largest right time seen so far, left rows before it can be matched.
+  int64_t right_watermark_ = std::numeric_limits<int64_t>::min();
+  bool right_eos_ = false;
+
+  // The left batches that haven't been fully matched yet, and the next row of the first one.
+  std::deque<table_store::schema::RowBatch> pending_left_batches_;
+  int64_t next_left_row_ = 0;
+  bool left_eos_ = false;
+  // The left time when the right rows of all keys were last expired.
+  int64_t last_expired_time_ = std::numeric_limits<int64_t>::min();
+  size_t left_rows_since_expiry_ = 0;
+  bool sent_eos_ = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/as_of_join_node.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+using types::Float64Value;
+using types::Int64Value;
+using types::StringValue;
+using types::Time64NSValue;
+
+// Joins [time_, key, value] on the left with [time_, key, name] on the right, on the keys and
+// with a tolerance of 10ns. The output is [time_, key, value, name].
+constexpr char kAsOfJoin[] = R"(
+  type: $0
+  equality_conditions {
+    left_column_index: 1
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 2
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 2
+  }
+  column_names: "time_"
+  column_names: "key"
+  column_names: "value"
+  column_names: "name"
+  as_of {
+    left_time_column_index: 0
+    right_time_column_index: 0
+    tolerance_ns: 10
+  }
+)";
+
+class AsOfJoinNodeTest : public ::testing::Test {
+ public:
+  AsOfJoinNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& join_type) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(planpb::testutils::kOperatorProtoTmpl, "JOIN_OPERATOR", "join_op",
+                         absl::Substitute(kAsOfJoin, join_type)),
+        &op_pb));
+    return plan::JoinOperator::FromProto(op_pb, 1);
+  }
+
+  RowDescriptor left_rd_{types::TIME64NS, types::INT64, types::FLOAT64};
+  RowDescriptor right_rd_{types::TIME64NS, types::INT64, types::STRING};
+  RowDescriptor output_rd_{types::TIME64NS, types::INT64, types::FLOAT64, types::STRING};
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(AsOfJoinNodeTest, left_join_matches_latest_right_row_within_tolerance) {
+  auto plan_node = PlanNodeFromPbtxt("LEFT_OUTER");
+  auto tester = exec::ExecNodeTester<AsOfJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd_, {left_rd_, right_rd_}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(right_rd_, 3, false, false)
+                       .AddColumn<Time64NSValue>({5, 12, 18})
+                       .AddColumn<Int64Value>({1, 2, 1})
+                       .AddColumn<StringValue>({"a", "b", "c"})
+                       .get(),
+                   1, 0)
+      // Only the first row is before the right parent, the others wait for it.
+      .ConsumeNext(RowBatchBuilder(left_rd_, 3, true, true)
+                       .AddColumn<Time64NSValue>({10, 20, 40})
+                       .AddColumn<Int64Value>({1, 1, 2})
+                       .AddColumn<Float64Value>({1.0, 2.0, 4.0})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 1, false, false)
+                          .AddColumn<Time64NSValue>({10})
+                          .AddColumn<Int64Value>({1})
+                          .AddColumn<Float64Value>({1.0})
+                          .AddColumn<StringValue>({"a"})
+                          .get())
+      // The last left row is more than the tolerance after the latest right row of its key.
+      .ConsumeNext(RowBatchBuilder(right_rd_, 2, true, true)
+                       .AddColumn<Time64NSValue>({25, 45})
+                       .AddColumn<Int64Value>({2, 1})
+                       .AddColumn<StringValue>({"d", "e"})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 2, true, true)
+                          .AddColumn<Time64NSValue>({20, 40})
+                          .AddColumn<Int64Value>({1, 2})
+                          .AddColumn<Float64Value>({2.0, 4.0})
+                          .AddColumn<StringValue>({"c", ""})
+                          .get())
+      .Close();
+}
+
+TEST_F(AsOfJoinNodeTest, inner_join_drops_unmatched_rows) {
+  auto plan_node = PlanNodeFromPbtxt("INNER");
+  auto tester = exec::ExecNodeTester<AsOfJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd_, {left_rd_, right_rd_}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(right_rd_, 4, true, true)
+                       .AddColumn<Time64NSValue>({5, 10, 10, 30})
+                       .AddColumn<Int64Value>({1, 1, 2, 1})
+                       .AddColumn<StringValue>({"a", "b", "c", "d"})
+                       .get(),
+                   1, 0)
+      // Right rows after the left row, or of other keys, don't match it.
+      .ConsumeNext(RowBatchBuilder(left_rd_, 4, true, true)
+                       .AddColumn<Time64NSValue>({4, 10, 15, 25})
+                       .AddColumn<Int64Value>({1, 1, 3, 1})
+                       .AddColumn<Float64Value>({0.5, 1.0, 1.5, 2.5})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 1, true, true)
+                          .AddColumn<Time64NSValue>({10})
+                          .AddColumn<Int64Value>({1})
+                          .AddColumn<Float64Value>({1.0})
+                          .AddColumn<StringValue>({"b"})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
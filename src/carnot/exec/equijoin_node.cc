@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <absl/strings/str_join.h>
@@ -35,6 +36,23 @@
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 
+DEFINE_int32(carnot_equijoin_num_partitions,
+             gflags::Int32FromEnv("PL_CARNOT_EQUIJOIN_NUM_PARTITIONS", 1),
+             "The number of radix partitions of the equijoin build side hash table. Must be a "
+             "power of two. With more than one partition, the partitions are built in parallel "
+             "once the build side is complete.");
+DEFINE_int32(carnot_equijoin_build_threads,
+             gflags::Int32FromEnv("PL_CARNOT_EQUIJOIN_BUILD_THREADS", 4),
+             "The maximum number of threads used to build the equijoin partitions.");
+DEFINE_bool(carnot_equijoin_build_key_filter,
+            gflags::BoolFromEnv("PL_CARNOT_EQUIJOIN_BUILD_KEY_FILTER", false),
+            "Build a bloom filter of the equijoin build keys and check probe keys against it "
+            "before probing the hash table, so that probe rows without a match skip the "
+            "hash table lookup.");
+DEFINE_double(carnot_equijoin_build_key_filter_error_rate, 0.01,
+              "The false positive rate of the equijoin build key bloom filter, for the number of "
+              "distinct build keys.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -61,9 +79,13 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
   output_rows_per_batch_ =
       plan_node_->rows_per_batch() == 0 ? kDefaultJoinRowBatchSize : plan_node_->rows_per_batch();
 
-  if (plan_node_->order_by_time() && plan_node_->time_column().parent_index() == 0) {
-    // Make the probe table the left table when we need to preserve the order of the left table in
+  if (plan_node_->order_by_time()) {
+    // Make the probe table the one with the time_ column when we need to preserve its order in
     // the output.
+    probe_table_ = plan_node_->time_column().parent_index() == 0
+                       ? EquijoinNode::JoinInputTable::kLeftTable
+                       : EquijoinNode::JoinInputTable::kRightTable;
+  } else if (plan_node_->build_side() == planpb::JoinOperator::BUILD_RIGHT) {
     probe_table_ = EquijoinNode::JoinInputTable::kLeftTable;
   } else {
     probe_table_ = EquijoinNode::JoinInputTable::kRightTable;
@@ -112,6 +134,18 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
     selected_spec.output_col_indices.emplace_back(i);
   }
 
+  int32_t num_partitions = FLAGS_carnot_equijoin_num_partitions;
+  if (num_partitions < 1 || (num_partitions & (num_partitions - 1)) != 0) {
+    return error::InvalidArgument("Equijoin partitions must be a power of two, got $0",
+                                  num_partitions);
+  }
+  partition_bits_ = 0;
+  while ((1 << partition_bits_) < num_partitions) {
+    ++partition_bits_;
+  }
+  build_partitions_.resize(num_partitions);
+  pending_build_rows_.resize(num_partitions);
+
   return Status::OK();
 }
 
@@ -124,7 +158,9 @@ Status EquijoinNode::InitializeColumnBuilders() {
   return Status::OK();
 }
 
-Status EquijoinNode::PrepareImpl(ExecState* /*exec_state*/) {
+Status EquijoinNode::PrepareImpl(ExecState* exec_state) {
+  build_memory_.set_tracker(exec_state->memory_tracker());
+  probe_buffer_memory_.set_tracker(exec_state->memory_tracker());
   column_builders_.resize(output_descriptor_->size());
   PL_RETURN_IF_ERROR(InitializeColumnBuilders());
 
@@ -135,12 +171,25 @@ Status EquijoinNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK();
 
 Status EquijoinNode::CloseImpl(ExecState* /*exec_state*/) {
   join_keys_chunk_.clear();
-  build_buffer_.clear();
-  probed_keys_.clear();
+  build_partitions_.clear();
+  build_batches_.clear();
+  pending_build_rows_.clear();
+  build_key_filter_.reset();
+  num_probe_rows_filtered_ = 0;
   key_values_pool_.Clear();
+  build_memory_.Reset();
+  probe_buffer_memory_.Reset();
   return Status::OK();
 }
 
+int64_t EquijoinNode::BuildBatchBytes(const table_store::schema::RowBatch& rb) const {
+  // Rows are counted as if they all had distinct keys, each taking a slot in the hash table.
+  int64_t key_bytes = sizeof(RowTuple) +
+                      key_data_types_.size() * sizeof(types::FixedSizeValueUnion) +
+                      sizeof(AbslRowTupleHashMap<int64_t>::value_type) + 1;
+  return rb.NumBytes() + rb.num_rows() * key_bytes;
+}
+
 template <types::DataType DT>
 void ExtractIntoRowTuples(std::vector<RowTuple*>* row_tuples, arrow::Array* input_col,
                           int rt_col_idx) {
@@ -188,6 +237,22 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   return Status::OK();
 }
 
+namespace {
+// Serializes the join key so it can be used with the build key bloom filter. This uses the same
+// bytes that RowTuple equality relies on (the fixed values are zeroed before they are set). The
+// strings are prefixed with their size, so that keys with different strings have different bytes.
+void SerializeJoinKey(const RowTuple& key, std::string* out) {
+  out->assign(reinterpret_cast<const char*>(key.fixed_values.data()),
+              sizeof(types::FixedSizeValueUnion) * key.fixed_values.size());
+  for (const auto& val : key.variable_values) {
+    const auto& str = std::get<types::StringValue>(val);
+    const uint64_t size = str.size();
+    out->append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out->append(str);
+  }
+}
+}  // namespace
+
 std::vector<types::SharedColumnWrapper>* CreateWrapper(ObjectPool* pool,
                                                        const std::vector<types::DataType>& types) {
   auto ptr = pool->Add(new std::vector<types::SharedColumnWrapper>(types.size()));
@@ -209,24 +274,16 @@ Status EquijoinNode::HashRowBatch(const table_store::schema::RowBatch& rb) {
   }
 
   // Make sure the map has constructed the necessary column wrappers for all of the tuples.
+  DCHECK(!IsPartitioned());
+  auto& partition = build_partitions_[0];
   for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
     auto& rt = join_keys_chunk_[row_idx];
-    auto& current = build_buffer_[rt];
+    auto& current = partition.build_buffer[rt];
     auto wrappers_ptr = current != nullptr ? current : build_wrappers_chunk_[row_idx];
 
-    // Now extract the values into the corresponding column wrappers.
-    for (size_t i = 0; i < build_spec_.input_col_indices.size(); ++i) {
-      const auto& rb_col_idx = build_spec_.input_col_indices[i];
-      auto arr = rb.ColumnAt(rb_col_idx).get();
-      const auto& dt = build_spec_.input_col_types[i];
-
-#define TYPE_CASE(_dt_) \
-  types::ExtractValueToColumnWrapper<_dt_>(wrappers_ptr->at(i).get(), arr, row_idx);
-      PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
-#undef TYPE_CASE
-    }
+    AppendBuildValues(rb, row_idx, wrappers_ptr);
     // Keep track of the number of rows that the build buffer matches for each key.
-    build_buffer_rows_[rt]++;
+    partition.build_buffer_rows[rt]++;
 
     if (current == nullptr) {
       std::swap(build_wrappers_chunk_[row_idx], current);
@@ -238,6 +295,77 @@ Status EquijoinNode::HashRowBatch(const table_store::schema::RowBatch& rb) {
   return Status::OK();
 }
 
+void EquijoinNode::AppendBuildValues(const RowBatch& rb, int64_t row_idx,
+                                     std::vector<types::SharedColumnWrapper>* wrappers_ptr) {
+  // Extract the values into the corresponding column wrappers.
+  for (size_t i = 0; i < build_spec_.input_col_indices.size(); ++i) {
+    const auto& rb_col_idx = build_spec_.input_col_indices[i];
+    auto arr = rb.ColumnAt(rb_col_idx).get();
+    const auto& dt = build_spec_.input_col_types[i];
+
+#define TYPE_CASE(_dt_) \
+  types::ExtractValueToColumnWrapper<_dt_>(wrappers_ptr->at(i).get(), arr, row_idx);
+    PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+size_t EquijoinNode::PartitionIndex(const RowTuple* key) const {
+  if (partition_bits_ == 0) {
+    return 0;
+  }
+  // Use the high bits, since the hash map itself relies on the low bits.
+  return static_cast<uint64_t>(key->Hash()) >> (64 - partition_bits_);
+}
+
+Status EquijoinNode::PartitionBuildBatch(const RowBatch& rb) {
+  size_t batch_idx = build_batches_.size();
+  build_batches_.push_back(rb);
+  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    auto& rt = join_keys_chunk_[row_idx];
+    pending_build_rows_[PartitionIndex(rt)].push_back({rt, batch_idx, row_idx});
+    // The pending row now owns the key, ExtractJoinKeysForBatch will allocate a new one.
+    rt = nullptr;
+  }
+  return Status::OK();
+}
+
+void EquijoinNode::BuildPartitionHashTable(size_t partition_idx) {
+  auto& partition = build_partitions_[partition_idx];
+  for (const auto& row : pending_build_rows_[partition_idx]) {
+    auto& wrappers_ptr = partition.build_buffer[row.key];
+    if (wrappers_ptr == nullptr) {
+      // The object pool is thread safe, so the partitions can safely share it.
+      wrappers_ptr = CreateWrapper(&column_values_pool_, build_spec_.input_col_types);
+    }
+    AppendBuildValues(build_batches_[row.batch_idx], row.row_idx, wrappers_ptr);
+    partition.build_buffer_rows[row.key]++;
+  }
+  pending_build_rows_[partition_idx].clear();
+}
+
+Status EquijoinNode::BuildPartitionHashTables() {
+  // Each partition only touches its own hash tables and column wrappers, so they can be built
+  // without any synchronization.
+  size_t num_threads = std::min<size_t>(build_partitions_.size(),
+                                        std::max(1, FLAGS_carnot_equijoin_build_threads));
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (size_t worker_idx = 0; worker_idx < num_threads; ++worker_idx) {
+    workers.emplace_back([this, worker_idx, num_threads] {
+      for (size_t idx = worker_idx; idx < build_partitions_.size(); idx += num_threads) {
+        BuildPartitionHashTable(idx);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  // The build values have been copied into the column wrappers.
+  build_batches_.clear();
+  return Status::OK();
+}
+
 template <types::DataType DT>
 Status AppendValuesFromWrapper(arrow::ArrayBuilder* output_builder,
                                types::SharedColumnWrapper input_wrapper, size_t start_idx,
@@ -355,13 +483,22 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
 
   if (rb.num_rows() > static_cast<int64_t>(probe_wrappers_chunk_.size())) {
     probe_wrappers_chunk_.resize(rb.num_rows());
+    probe_matching_rows_chunk_.resize(rb.num_rows());
   }
 
   for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
-    auto it = build_buffer_.find(join_keys_chunk_[row_idx]);
-    if (it != build_buffer_.end()) {
+    auto* key = join_keys_chunk_[row_idx];
+    if (!MayMatchBuildKey(*key)) {
+      ++num_probe_rows_filtered_;
+      probe_wrappers_chunk_[row_idx] = nullptr;
+      continue;
+    }
+    auto& partition = build_partitions_[PartitionIndex(key)];
+    auto it = partition.build_buffer.find(key);
+    if (it != partition.build_buffer.end()) {
       probe_wrappers_chunk_[row_idx] = it->second;
-      probed_keys_.insert(it->first);
+      probe_matching_rows_chunk_[row_idx] = partition.build_buffer_rows[it->first];
+      partition.probed_keys.insert(it->first);
     } else {
       probe_wrappers_chunk_[row_idx] = nullptr;
     }
@@ -384,8 +521,7 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
     }
 
     PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, probe_wrappers_chunk_[row_idx], rb_ptr,
-                                                row_idx,
-                                                build_buffer_rows_[join_keys_chunk_[row_idx]]));
+                                                row_idx, probe_matching_rows_chunk_[row_idx]));
   }
 
   if (probe_eos_ && queued_rows_ > 0) {
@@ -395,13 +531,46 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
   return Status::OK();
 }
 
+Status EquijoinNode::CreateBuildKeyFilter() {
+  // The hash tables hold each distinct key once, so the filter is sized for exactly the keys that
+  // it holds. The blocked layout costs a single cache miss per probe row, which keeps the check
+  // cheaper than the hash table lookup that it saves.
+  size_t num_keys = 0;
+  for (const auto& partition : build_partitions_) {
+    num_keys += partition.build_buffer.size();
+  }
+  PL_ASSIGN_OR_RETURN(build_key_filter_,
+                      bloomfilter::XXHash64BloomFilter::Create(
+                          std::max<size_t>(num_keys, 1),
+                          FLAGS_carnot_equijoin_build_key_filter_error_rate,
+                          bloomfilter::XXHash64BloomFilter::Layout::kBlocked));
+  for (const auto& partition : build_partitions_) {
+    for (const auto& [key, wrappers] : partition.build_buffer) {
+      PL_UNUSED(wrappers);
+      SerializeJoinKey(*key, &key_bytes_);
+      build_key_filter_->Insert(key_bytes_);
+    }
+  }
+  return Status::OK();
+}
+
+bool EquijoinNode::MayMatchBuildKey(const RowTuple& key) {
+  if (build_key_filter_ == nullptr) {
+    return true;
+  }
+  SerializeJoinKey(key, &key_bytes_);
+  return build_key_filter_->Contains(key_bytes_);
+}
+
 Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
-  for (auto it = build_buffer_.begin(); it != build_buffer_.end(); ++it) {
-    if (probed_keys_.find(it->first) != probed_keys_.end()) {
-      continue;
+  for (auto& partition : build_partitions_) {
+    for (auto it = partition.build_buffer.begin(); it != partition.build_buffer.end(); ++it) {
+      if (partition.probed_keys.find(it->first) != partition.probed_keys.end()) {
+        continue;
+      }
+      PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, it->second, nullptr, 0,
+                                                  partition.build_buffer_rows[it->first]));
     }
-    PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, it->second, nullptr, 0,
-                                                build_buffer_rows_[it->first]));
   }
 
   if (queued_rows_ > 0) {
@@ -417,13 +586,26 @@ Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
   }
 
   PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, false));
-  PL_RETURN_IF_ERROR(HashRowBatch(rb));
+  if (IsPartitioned()) {
+    PL_RETURN_IF_ERROR(PartitionBuildBatch(rb));
+  } else {
+    PL_RETURN_IF_ERROR(HashRowBatch(rb));
+  }
+
+  PL_RETURN_IF_ERROR(build_memory_.Add(BuildBatchBytes(rb)));
 
   if (build_eos_) {
+    if (IsPartitioned()) {
+      PL_RETURN_IF_ERROR(BuildPartitionHashTables());
+    }
+    if (FLAGS_carnot_equijoin_build_key_filter) {
+      PL_RETURN_IF_ERROR(CreateBuildKeyFilter());
+    }
     while (probe_batches_.size()) {
       PL_RETURN_IF_ERROR(DoProbe(exec_state, probe_batches_.front()));
       probe_batches_.pop();
     }
+    probe_buffer_memory_.Reset();
   }
   return Status::OK();
 }
@@ -432,7 +614,7 @@ Status EquijoinNode::ConsumeProbeBatch(ExecState* exec_state,
                                        const table_store::schema::RowBatch& rb) {
   if (!build_eos_) {
     probe_batches_.push(rb);
-    return Status::OK();
+    return probe_buffer_memory_.Add(rb.NumBytes());
   }
   return DoProbe(exec_state, rb);
 }
@@ -23,6 +23,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -30,15 +31,21 @@
 
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/memory_tracker.h"
 #include "src/carnot/exec/row_tuple.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/common/memory/memory.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_equijoin_num_partitions);
+DECLARE_int32(carnot_equijoin_build_threads);
+DECLARE_bool(carnot_equijoin_build_key_filter);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -60,10 +67,43 @@ class EquijoinNode : public ProcessingNode {
     std::vector<int64_t> output_col_indices;
   };
 
+  // The build side hash table is radix partitioned by the high bits of the key hash. When there is
+  // more than one partition the build rows are buffered until the build side is done, and then
+  // each partition is built independently on its own thread.
+  struct BuildPartition {
+    AbslRowTupleHashMap<std::vector<types::SharedColumnWrapper>*> build_buffer;
+    // Store the number of rows that match a given set of keys for the build buffer.
+    // This is necessary to store in addition to the values in `build_buffer` in
+    // the event that no columns from the build side are emitted.
+    AbslRowTupleHashMap<int64_t> build_buffer_rows;
+    // For joins where the build_buffer needs to emit any non-probed rows at the end of the join,
+    // keep track of which ones they were.
+    AbslRowTupleHashSet probed_keys;
+  };
+
+  // A build row waiting to be inserted into its partition.
+  struct PendingBuildRow {
+    RowTuple* key;
+    size_t batch_idx;
+    int64_t row_idx;
+  };
+
  public:
   EquijoinNode() = default;
   virtual ~EquijoinNode() = default;
 
+  /**
+   * A bloom filter of all the build side join keys, available once the build side is complete
+   * (and FLAGS_carnot_equijoin_build_key_filter is set). Probe rows whose key is not in the
+   * filter can't match, which is what a runtime semi-join filter relies on.
+   */
+  const bloomfilter::XXHash64BloomFilter* build_key_filter() const {
+    return build_key_filter_.get();
+  }
+
+  // The number of probe rows that the build key filter ruled out.
+  int64_t num_probe_rows_filtered() const { return num_probe_rows_filtered_; }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -79,6 +119,18 @@ class EquijoinNode : public ProcessingNode {
   Status FlushChunkedRows(ExecState* exec_state);
   Status ExtractJoinKeysForBatch(const table_store::schema::RowBatch& rb, bool is_probe);
   Status HashRowBatch(const table_store::schema::RowBatch& rb);
+  void AppendBuildValues(const table_store::schema::RowBatch& rb, int64_t row_idx,
+                         std::vector<types::SharedColumnWrapper>* wrappers_ptr);
+  size_t PartitionIndex(const RowTuple* key) const;
+  bool IsPartitioned() const { return build_partitions_.size() > 1; }
+  // Radix partitions the build batch and buffers it until the build side is complete.
+  Status PartitionBuildBatch(const table_store::schema::RowBatch& rb);
+  void BuildPartitionHashTable(size_t partition_idx);
+  Status BuildPartitionHashTables();
+  Status CreateBuildKeyFilter();
+  // An estimate of the memory the build side keeps for the batch, its values and keys.
+  int64_t BuildBatchBytes(const table_store::schema::RowBatch& rb) const;
+  bool MayMatchBuildKey(const RowTuple& key);
 
   Status DoProbe(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status MatchBuildValuesAndFlush(ExecState* exec_state,
@@ -139,17 +191,27 @@ class EquijoinNode : public ProcessingNode {
   std::vector<std::vector<types::SharedColumnWrapper>*> build_wrappers_chunk_;
 
   // Chunk of data to use when performing the probe stage of the join.
-  // This will store build table data from `build_buffer_`.
+  // This will store build table data from the build partitions, along with the number of
+  // matching build rows.
   std::vector<std::vector<types::SharedColumnWrapper>*> probe_wrappers_chunk_;
-  AbslRowTupleHashMap<std::vector<types::SharedColumnWrapper>*> build_buffer_;
-  // Store the number of rows that match a given set of keys for the build buffer.
-  // This is necessary to store in addition to the values in `build_buffer_` in
-  // the event that no columns from the build side are emitted.
-  AbslRowTupleHashMap<int64_t> build_buffer_rows_;
-
-  // For joins where the build_buffer_ needs to emit any non-probed rows at the end of the join,
-  // keep track of which ones they were.
-  AbslRowTupleHashSet probed_keys_;
+  std::vector<int64_t> probe_matching_rows_chunk_;
+
+  std::vector<BuildPartition> build_partitions_;
+  // Number of high bits of the key hash used to pick the partition.
+  int partition_bits_ = 0;
+  // Only used when partitioned: the buffered build batches and their rows, by partition.
+  std::vector<table_store::schema::RowBatch> build_batches_;
+  std::vector<std::vector<PendingBuildRow>> pending_build_rows_;
+
+  std::unique_ptr<bloomfilter::XXHash64BloomFilter> build_key_filter_;
+  int64_t num_probe_rows_filtered_ = 0;
+
+  // Hold the estimated size of the build side and of the buffered probe batches in the memory
+  // tracker of the query.
+  MemoryReservation build_memory_;
+  MemoryReservation probe_buffer_memory_;
+  // Scratch space used to serialize keys for the build key filter.
+  std::string key_bytes_;
 
   // Handle on the most recent RowBatch (in case it's the final one).
   std::unique_ptr<table_store::schema::RowBatch> pending_output_batch_;
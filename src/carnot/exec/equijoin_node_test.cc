@@ -18,6 +18,8 @@
 
 #include "src/carnot/exec/equijoin_node.h"
 
+#include <vector>
+
 #include <absl/strings/substitute.h>
 #include <gmock/gmock.h>
 #include <google/protobuf/text_format.h>
@@ -150,6 +152,90 @@ TEST_F(JoinNodeTest, ordered_inner_join) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, partitioned_ordered_inner_join) {
+  // Same as ordered_inner_join, but with the build side split into radix partitions.
+  FLAGS_carnot_equijoin_num_partitions = 4;
+  // time_ from right table, all batches from probe (right) first.
+  // Left table input: [left_0:Int, left_1:Float]
+  // Right table input: [time_:Time64Ns, right_1:Int]
+  // Output table: [left_1:Float, right_1:Int, time_:Time64Ns]
+  // Left join on left_0=right_1.
+  const char* proto = R"(
+    type: INNER
+    equality_conditions {
+      left_column_index: 0
+      right_column_index: 1
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 0
+    }
+    column_names: "left_1"
+    column_names: "right_1"
+    column_names: "time_"
+    rows_per_batch: 5
+  )";
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  // Left
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::FLOAT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::TIME64NS, types::DataType::INT64});
+  // Right[1], Left[1], Left[0]
+  RowDescriptor output_rd(
+      {types::DataType::FLOAT64, types::DataType::INT64, types::DataType::TIME64NS});
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Probe
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 4, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 20, 30, 31})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .get(),
+                   1, 0)
+      // Probe
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, true, true)
+                       .AddColumn<types::Time64NSValue>({101, 150, 190})
+                       .AddColumn<types::Int64Value>({1, 5, 9})
+                       .get(),
+                   1, 0)
+      // Build
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, false, false)
+                       .AddColumn<types::Int64Value>({1, 2, 2})
+                       .AddColumn<types::Float64Value>({1.0, 2.0, 2.1})
+                       .get(),
+                   0, 0)
+      // Build
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, true, true)
+                       .AddColumn<types::Int64Value>({9, 1, 1})
+                       .AddColumn<types::Float64Value>({9.0, 1.1, 1.2})
+                       .get(),
+                   0, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::Float64Value>({1.0, 1.1, 1.2, 2.0, 2.1})
+                          .AddColumn<types::Int64Value>({1, 1, 1, 2, 2})
+                          .AddColumn<types::Time64NSValue>({10, 10, 10, 20, 20})
+                          .get(),
+                      true)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Float64Value>({1.0, 1.1, 1.2, 9.0})
+                          .AddColumn<types::Int64Value>({1, 1, 1, 9})
+                          .AddColumn<types::Time64NSValue>({101, 101, 101, 190})
+                          .get(),
+                      true)
+      .Close();
+  FLAGS_carnot_equijoin_num_partitions = 1;
+}
+
 TEST_F(JoinNodeTest, ordered_left_join) {
   // time_ from left (probe) table, batches interleaved
   // Left table input: [time_:Time64Ns, left_1:Int]
@@ -524,6 +610,109 @@ TEST_F(JoinNodeTest, unordered_no_matches) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, unordered_build_right) {
+  // Left table input: [left_0:Int64, left_1:Int64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Int64, right_1:Int64]
+  // Inner join on left_0=right_0, building the hash table from the right table.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  rows_per_batch: 5
+  build_side: BUILD_RIGHT
+)";
+
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({10, 20})
+                       .get(),
+                   1, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 1})
+                       .AddColumn<types::Int64Value>({100, 200, 300, 400})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({100, 200, 400})
+                          .AddColumn<types::Int64Value>({10, 20, 10})
+                          .get(),
+                      /*unordered */ true)
+      .Close();
+}
+
+TEST_F(JoinNodeTest, build_side_over_memory_limit) {
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  rows_per_batch: 5
+)";
+  FLAGS_carnot_query_memory_limit_bytes = 1024;
+  auto exec_state =
+      std::make_unique<ExecState>(func_registry_.get(), std::make_shared<table_store::TableStore>(),
+                                  MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  FLAGS_carnot_query_memory_limit_bytes = 1024 * 1024 * 1024;
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd, input_rd}, exec_state.get());
+
+  std::vector<types::Int64Value> keys;
+  for (int64_t i = 0; i < 100; ++i) {
+    keys.push_back(i);
+  }
+  auto rb = RowBatchBuilder(input_rd, keys.size(), /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>(keys)
+                .AddColumn<types::Int64Value>(keys)
+                .get();
+  auto s = tester.node()->ConsumeNext(exec_state.get(), rb, 0);
+  EXPECT_EQ(statuspb::RESOURCE_UNAVAILABLE, s.code());
+  EXPECT_GT(exec_state->memory_tracker()->bytes(), 1024);
+
+  // Closing the node releases the memory of its hash table.
+  tester.Close();
+  EXPECT_EQ(0, exec_state->memory_tracker()->bytes());
+}
+
 TEST_F(JoinNodeTest, zero_row_row_batch_right) {
   // Left table input: [left_0:String, left_1:Int64]
   // Right table input: [right_0:Int64, right_1:String]
@@ -685,6 +874,187 @@ TEST_F(JoinNodeTest, unordered_many_matches) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, build_key_filter_inner_join) {
+  FLAGS_carnot_equijoin_build_key_filter = true;
+  // Left table input: [left_0:Int64, left_1:Int64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Int64, right_1:Int64]
+  // Inner join on left_0=right_0
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  rows_per_batch: 5
+)";
+
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({10, 20})
+                       .get(),
+                   0, 0);
+  ASSERT_NE(tester.node()->build_key_filter(), nullptr);
+
+  tester
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 4, true, true)
+                       .AddColumn<types::Int64Value>({3, 2, 4, 1})
+                       .AddColumn<types::Int64Value>({-3, -2, -4, -1})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({20, 10})
+                          .AddColumn<types::Int64Value>({-2, -1})
+                          .get(),
+                      true);
+  // Only the rows without a match can be filtered out.
+  EXPECT_LE(tester.node()->num_probe_rows_filtered(), 2);
+  tester.Close();
+  FLAGS_carnot_equijoin_build_key_filter = false;
+}
+
+TEST_F(JoinNodeTest, build_key_filter_false_positives) {
+  FLAGS_carnot_equijoin_build_key_filter = true;
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 0
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_0"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  constexpr int64_t kNumBuildKeys = 1000;
+  constexpr int64_t kNumProbeKeys = 10000;
+  std::vector<types::Int64Value> build_keys;
+  for (int64_t i = 0; i < kNumBuildKeys; ++i) {
+    // Repeat each key, to check that the filter is sized for the distinct keys.
+    build_keys.push_back(i);
+    build_keys.push_back(i);
+  }
+  // None of the probe keys are in the build side.
+  std::vector<types::Int64Value> probe_keys;
+  for (int64_t i = 0; i < kNumProbeKeys; ++i) {
+    probe_keys.push_back(kNumBuildKeys + i);
+  }
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd, input_rd}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd, build_keys.size(), true, true)
+                       .AddColumn<types::Int64Value>(build_keys)
+                       .get(),
+                   0, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd, probe_keys.size(), true, true)
+                       .AddColumn<types::Int64Value>(probe_keys)
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 0, true, true)
+                          .AddColumn<types::Int64Value>({})
+                          .AddColumn<types::Int64Value>({})
+                          .get(),
+                      false);
+
+  // The filter is sized for a false positive rate of 1%, so at most 2% of the absent keys should
+  // get through.
+  EXPECT_GE(tester.node()->num_probe_rows_filtered(), kNumProbeKeys * 98 / 100);
+  tester.Close();
+  FLAGS_carnot_equijoin_build_key_filter = false;
+}
+
+TEST_F(JoinNodeTest, build_key_filter_left_join) {
+  FLAGS_carnot_equijoin_build_key_filter = true;
+  // Left (probe) table input: [left_0:Int64, left_1:Int64]
+  // Right (build) table input: [right_0:Int64, right_1:Int64]
+  // Output table: [right_1:Int64, left_1:Int64]
+  // Left join on left_0=right_0
+  const char* proto = R"(
+  type: LEFT_OUTER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  column_names: "right_1"
+  column_names: "left_1"
+  rows_per_batch: 5
+)";
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd, input_rd}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({10, 20})
+                       .get(),
+                   1, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({3, 2, 4, 1})
+                       .AddColumn<types::Int64Value>({-3, -2, -4, -1})
+                       .get(),
+                   0, 1)
+      // The filtered out probe rows are still emitted without a match.
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Int64Value>({0, 20, 0, 10})
+                          .AddColumn<types::Int64Value>({-3, -2, -4, -1})
+                          .get(),
+                      true)
+      .Close();
+  FLAGS_carnot_equijoin_build_key_filter = false;
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -19,11 +19,16 @@
 #include "src/carnot/exec/exec_graph.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/as_of_join_node.h"
 #include "src/carnot/exec/empty_source_node.h"
 #include "src/carnot/exec/equijoin_node.h"
 #include "src/carnot/exec/exec_node.h"
@@ -35,6 +40,8 @@
 #include "src/carnot/exec/map_node.h"
 #include "src/carnot/exec/memory_sink_node.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/rolling_agg_node.h"
+#include "src/carnot/exec/top_k_node.h"
 #include "src/carnot/exec/udtf_source_node.h"
 #include "src/carnot/exec/union_node.h"
 #include "src/carnot/plan/operators.h"
@@ -42,6 +49,11 @@
 #include "src/common/perf/perf.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int32(carnot_grpc_sink_open_threads,
+             gflags::Int32FromEnv("PL_CARNOT_GRPC_SINK_OPEN_THREADS", 8),
+             "The number of threads that the GRPC sinks of a plan fragment are opened on, so that "
+             "fragments with many sinks don't set up their connections one after another.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -70,6 +82,9 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         return OnOperatorImpl<plan::MemorySinkOperator, MemorySinkNode>(node, &descriptors);
       })
       .OnAggregate([&](auto& node) {
+        if (node.rolling()) {
+          return OnOperatorImpl<plan::AggregateOperator, RollingAggNode>(node, &descriptors);
+        }
         return OnOperatorImpl<plan::AggregateOperator, AggNode>(node, &descriptors);
       })
       .OnMemorySource([&](auto& node) {
@@ -81,10 +96,16 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
       .OnLimit([&](auto& node) {
         return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors);
       })
+      .OnTopK([&](auto& node) {
+        return OnOperatorImpl<plan::TopKOperator, TopKNode>(node, &descriptors);
+      })
       .OnUnion([&](auto& node) {
         return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors);
       })
       .OnJoin([&](auto& node) {
+        if (node.as_of()) {
+          return OnOperatorImpl<plan::JoinOperator, AsOfJoinNode>(node, &descriptors);
+        }
         return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors);
       })
       .OnGRPCSource([&](auto& node) {
@@ -93,7 +114,7 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         grpc_sources_.insert(node.id());
         return exec_state->grpc_router()->AddGRPCSourceNode(
             exec_state->query_id(), node.id(), static_cast<GRPCSourceNode*>(nodes_[node.id()]),
-            std::bind(&ExecutionGraph::Continue, this));
+            std::bind(&ExecutionGraph::Continue, this), exec_state->memory_tracker());
       })
       .OnGRPCSink([&](auto& node) {
         grpc_sinks_.insert(node.id());
@@ -160,6 +181,7 @@ Status ExecutionGraph::CheckUpstreamGRPCConnectionHealth(GRPCSourceNode* source_
 }
 
 Status ExecutionGraph::CheckDownstreamGRPCConnectionsHealth() {
+  absl::flat_hash_set<int64_t> stopped_grpc_sinks;
   for (const auto& grpc_sink_id : grpc_sinks_) {
     auto node = nodes_.find(grpc_sink_id);
     if (node == nodes_.end()) {
@@ -167,10 +189,39 @@ Status ExecutionGraph::CheckDownstreamGRPCConnectionsHealth() {
     }
     GRPCSinkNode* grpc_sink = static_cast<GRPCSinkNode*>(node->second);
     PL_RETURN_IF_ERROR(grpc_sink->OptionallyCheckConnection(exec_state_));
+    if (grpc_sink->downstream_stopped()) {
+      stopped_grpc_sinks.insert(grpc_sink_id);
+    }
+  }
+  if (stopped_grpc_sinks.size() != num_stopped_grpc_sinks_) {
+    num_stopped_grpc_sinks_ = stopped_grpc_sinks.size();
+    StopSourcesOfStoppedSinks(stopped_grpc_sinks);
   }
   return Status::OK();
 }
 
+void ExecutionGraph::StopSourcesOfStoppedSinks(const absl::flat_hash_set<int64_t>& stopped_sinks) {
+  for (int64_t source_id : sources_) {
+    bool feeds_stopped_sink = false;
+    bool feeds_running_sink = false;
+    for (int64_t dep_id : pf_->dag().TransitiveDepsFrom(source_id)) {
+      auto node = nodes_.find(dep_id);
+      if (node == nodes_.end() || !node->second->IsSink()) {
+        continue;
+      }
+      if (stopped_sinks.contains(dep_id)) {
+        feeds_stopped_sink = true;
+      } else {
+        feeds_running_sink = true;
+      }
+    }
+    // Like a limit, the stopped sinks don't need an eos from the sources they stop.
+    if (feeds_stopped_sink && !feeds_running_sink) {
+      exec_state_->StopSource(source_id);
+    }
+  }
+}
+
 Status ExecutionGraph::ExecuteSources() {
   absl::flat_hash_set<SourceNode*> running_sources;
 
@@ -210,16 +261,26 @@ Status ExecutionGraph::ExecuteSources() {
           break;
         }
         PL_RETURN_IF_ERROR(source->GenerateNext(exec_state_));
+        PL_RETURN_IF_ERROR(exec_state_->CheckMemoryLimit());
       }
 
       // keep_running will be set to false when a downstream limit for this particular
       // source (set in exec_state) has been reached.
       if (!source->HasBatchesRemaining() || !exec_state_->keep_running()) {
+        // The limit also travels upstream of a GRPC source, to the sinks that feed it.
+        if (source->HasBatchesRemaining() && grpc_sources_.contains(source_to_id[source])) {
+          exec_state_->grpc_router()->StopGRPCSource(exec_state_->query_id(),
+                                                     source_to_id[source]);
+        }
         completed_sources_execute_loop.insert(source);
         break;
       }
     }
     PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+    // Long running queries give way to more important ones once they used up their time slice.
+    if (exec_state_->query_ticket() != nullptr) {
+      exec_state_->query_ticket()->MaybeYield();
+    }
 
     // Flush all of the completed sources.
     for (SourceNode* source : completed_sources_execute_loop) {
@@ -241,10 +302,19 @@ Status ExecutionGraph::ExecuteSources() {
       }
     }
 
+    // The query doesn't need its run slot while it waits for data.
+    if (wait_for_more_data && exec_state_->query_ticket() != nullptr) {
+      exec_state_->query_ticket()->Pause();
+    }
     while (wait_for_more_data) {
       auto timer = ElapsedTimer();
       timer.Start();
+      auto wait_start = std::chrono::steady_clock::now();
       YieldWithTimeout();
+      if (exec_state_->query_trace() != nullptr) {
+        exec_state_->query_trace()->Record(QueryTrace::EventType::kWaitForData, /* node_id */ -1,
+                                           wait_start, std::chrono::steady_clock::now());
+      }
       timer.Stop();
 
       absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
@@ -280,36 +350,97 @@ Status ExecutionGraph::ExecuteSources() {
         return Status::OK();
       }
     }
+    if (exec_state_->query_ticket() != nullptr) {
+      exec_state_->query_ticket()->Resume();
+    }
   }
 
   return Status::OK();
 }
 
-/**
- * Execute the graph starting at all of the sources.
- * @return a status of whether execution succeeded.
- */
-Status ExecutionGraph::Execute() {
-  query_start_time_ = std::chrono::system_clock::now();
-
-  // Get vector of nodes.
+std::vector<ExecNode*> ExecutionGraph::Nodes() const {
   std::vector<ExecNode*> nodes(nodes_.size());
   transform(nodes_.begin(), nodes_.end(), nodes.begin(), [](auto pair) { return pair.second; });
+  return nodes;
+}
 
-  for (auto node : nodes) {
+Status ExecutionGraph::Open() {
+  query_start_time_ = std::chrono::system_clock::now();
+
+  for (auto node : Nodes()) {
     PL_RETURN_IF_ERROR(node->Prepare(exec_state_));
   }
 
-  for (auto node : nodes) {
+  std::vector<ExecNode*> grpc_sinks;
+  for (const auto& [id, node] : nodes_) {
+    if (grpc_sinks_.contains(id)) {
+      grpc_sinks.push_back(node);
+      continue;
+    }
     PL_RETURN_IF_ERROR(node->Open(exec_state_));
   }
+  return OpenGRPCSinks(grpc_sinks);
+}
 
-  // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
-  // nodes, even if there was an error during execution.
-  Status source_status = ExecuteSources();
-  Status close_status = Status::OK();
+Status ExecutionGraph::OpenGRPCSinks(const std::vector<ExecNode*>& grpc_sinks) {
+  size_t num_threads = std::min<size_t>(
+      grpc_sinks.size(), std::max<int32_t>(FLAGS_carnot_grpc_sink_open_threads, 1));
+  if (num_threads <= 1) {
+    for (auto node : grpc_sinks) {
+      PL_RETURN_IF_ERROR(node->Open(exec_state_));
+    }
+    return Status::OK();
+  }
 
-  for (auto node : nodes) {
+  // The sinks only share the stubs of the exec state, which they created when they were prepared.
+  std::vector<Status> statuses(grpc_sinks.size());
+  std::atomic<size_t> next_sink = 0;
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (size_t j = next_sink++; j < grpc_sinks.size(); j = next_sink++) {
+        statuses[j] = grpc_sinks[j]->Open(exec_state_);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+Status ExecutionGraph::ExecuteAvailable() {
+  bool generated = true;
+  while (generated) {
+    generated = false;
+    for (auto node_id : sources_) {
+      auto node = nodes_.find(node_id);
+      if (node == nodes_.end()) {
+        return error::NotFound("Could not find SourceNode $0.", node_id);
+      }
+      SourceNode* source = static_cast<SourceNode*>(node->second);
+      exec_state_->SetCurrentSource(node_id);
+      for (auto i = 0; i < consecutive_generate_calls_per_source_; ++i) {
+        if (!source->NextBatchReady() || !exec_state_->keep_running()) {
+          break;
+        }
+        PL_RETURN_IF_ERROR(source->GenerateNext(exec_state_));
+        PL_RETURN_IF_ERROR(exec_state_->CheckMemoryLimit());
+        generated = true;
+      }
+    }
+    PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+  }
+  return Status::OK();
+}
+
+Status ExecutionGraph::Close() {
+  Status close_status = Status::OK();
+  for (auto node : Nodes()) {
     auto s = node->Close(exec_state_);
     if (!s.ok()) {
       // Since we only return a single error status if there are multiple errors,
@@ -320,6 +451,59 @@ Status ExecutionGraph::Execute() {
       close_status = s;
     }
   }
+  return close_status;
+}
+
+void ExecutionGraph::RecordSinkInputs(SinkInputs* sink_inputs) {
+  for (const auto& [id, node] : nodes_) {
+    if (node->IsSink()) {
+      node->RecordConsumedBatches(&(*sink_inputs)[id]);
+    }
+  }
+}
+
+Status ExecutionGraph::ReplaySinkInputs(const SinkInputs& sink_inputs) {
+  PL_RETURN_IF_ERROR(Open());
+
+  Status replay_status = Status::OK();
+  for (const auto& [id, node] : nodes_) {
+    if (!node->IsSink()) {
+      continue;
+    }
+    auto it = sink_inputs.find(id);
+    if (it == sink_inputs.end()) {
+      replay_status = error::NotFound("No recorded inputs for sink $0", id);
+      break;
+    }
+    for (const auto& rb : it->second) {
+      replay_status = node->ConsumeNext(exec_state_, rb, /* parent_index */ 0);
+      if (!replay_status.ok()) {
+        break;
+      }
+    }
+    if (!replay_status.ok()) {
+      break;
+    }
+  }
+  Status close_status = Close();
+
+  if (!replay_status.ok()) {
+    return replay_status;
+  }
+  return close_status;
+}
+
+/**
+ * Execute the graph starting at all of the sources.
+ * @return a status of whether execution succeeded.
+ */
+Status ExecutionGraph::Execute() {
+  PL_RETURN_IF_ERROR(Open());
+
+  // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
+  // nodes, even if there was an error during execution.
+  Status source_status = ExecuteSources();
+  Status close_status = Close();
 
   if (!source_status.ok()) {
     return source_status;
@@ -356,7 +540,7 @@ ExecutionStats ExecutionGraph::GetStats() const {
     bytes_processed += source_node->BytesProcessed();
     rows_processed += source_node->RowsProcessed();
   }
-  return ExecutionStats({bytes_processed, rows_processed});
+  return ExecutionStats({bytes_processed, rows_processed, exec_state_->PeakMemoryBytes()});
 }
 
 }  // namespace exec
@@ -28,6 +28,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/dag/dag.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
@@ -39,6 +41,8 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_grpc_sink_open_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -46,6 +50,8 @@ namespace exec {
 struct ExecutionStats {
   int64_t bytes_processed;
   int64_t rows_processed;
+  // The peak bytes held by the query, see ExecState::PeakMemoryBytes.
+  int64_t peak_memory_bytes;
 };
 
 constexpr std::chrono::milliseconds kDefaultYieldTimeoutMS{1000};
@@ -126,6 +132,25 @@ class ExecutionGraph {
    */
   Status Execute();
 
+  /**
+   * Prepares and opens all of the nodes in the graph. Execute() does this itself, this is only
+   * needed to drive the graph with ExecuteAvailable().
+   */
+  Status Open();
+
+  /**
+   * Pushes every batch that the sources have ready through the graph, without waiting for more
+   * data and without closing the nodes. Sources in infinite-stream mode keep their cursor between
+   * calls, so each call only processes the data added since the previous one.
+   */
+  Status ExecuteAvailable();
+
+  /**
+   * Closes all of the nodes in the graph. Returns the last error if any of the nodes failed to
+   * close.
+   */
+  Status Close();
+
   /**
    * Re-awakens Execute() when there is more work available to do.
    */
@@ -158,9 +183,15 @@ class ExecutionGraph {
   Status CheckUpstreamGRPCConnectionHealth(GRPCSourceNode* source_node);
   // Check the downstream GRPC connections for the query.
   // If it is not healthy, we will cancel the query.
+  // Also stops the sources that only feed GRPC sinks whose destination stopped its results.
   Status CheckDownstreamGRPCConnectionsHealth();
 
  private:
+  std::vector<ExecNode*> Nodes() const;
+  // Opens the GRPC sinks, which connect to their destinations, on up to
+  // FLAGS_carnot_grpc_sink_open_threads threads.
+  Status OpenGRPCSinks(const std::vector<ExecNode*>& grpc_sinks);
+
   /**
    * For the given operator type, creates the corresponding execution node and updates the structure
    * of the execution graph.
@@ -193,6 +224,9 @@ class ExecutionGraph {
     // Create ExecNode.
     auto execNode = pool_.Add(new TNode());
     auto s = execNode->Init(node, output_descriptor, input_descriptors, collect_exec_node_stats_);
+    if (exec_state_->query_trace() != nullptr) {
+      exec_state_->query_trace()->SetNodeName(node.id(), node.DebugString());
+    }
 
     AddNode(node.id(), execNode);
 
@@ -209,6 +243,7 @@ class ExecutionGraph {
   }
 
   Status ExecuteSources();
+  void StopSourcesOfStoppedSinks(const absl::flat_hash_set<int64_t>& stopped_sinks);
 
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
@@ -219,6 +254,7 @@ class ExecutionGraph {
   std::vector<int64_t> sinks_;
   absl::flat_hash_set<int64_t> grpc_sources_;
   absl::flat_hash_set<int64_t> grpc_sinks_;
+  size_t num_stopped_grpc_sinks_ = 0;
   std::unordered_map<int64_t, ExecNode*> nodes_;
 
   SystemTimePoint query_start_time_;
@@ -18,13 +18,19 @@
 
 #pragma once
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
+#include "src/common/metrics/named_timer.h"
 #include "src/common/perf/perf.h"
 #include "src/table_store/table_store.h"
 
@@ -38,6 +44,24 @@ enum class ExecNodeType : int8_t {
   kProcessingNode = 2,
 };
 
+/**
+ * Returns the timer of the exec nodes of the operator type. It records the time that the nodes
+ * spend on each of their input batches, without the time that their children spend on the output.
+ */
+inline metrics::NamedTimer* ExecNodeTimer(planpb::OperatorType op_type) {
+  static absl::Mutex mutex(absl::kConstInit);
+  static auto* timers =
+      new absl::flat_hash_map<planpb::OperatorType, std::unique_ptr<metrics::NamedTimer>>();
+  absl::MutexLock lock(&mutex);
+  std::unique_ptr<metrics::NamedTimer>& timer = (*timers)[op_type];
+  if (timer == nullptr) {
+    timer = std::make_unique<metrics::NamedTimer>(
+        "carnot", "exec_node",
+        std::map<std::string, std::string>{{"operator", planpb::OperatorType_Name(op_type)}});
+  }
+  return timer.get();
+}
+
 struct ExecNodeStats {
   explicit ExecNodeStats(bool collect_stats) : collect_exec_stats(collect_stats) {}
   void AddOutputStats(const table_store::schema::RowBatch& rb) {
@@ -46,7 +70,7 @@ struct ExecNodeStats {
     }
     ++batches_output;
     bytes_output += rb.NumBytes();
-    rows_output += rb.num_rows();
+    rows_output += rb.num_selected_rows();
   }
 
   void AddInputStats(const table_store::schema::RowBatch& rb) {
@@ -55,7 +79,7 @@ struct ExecNodeStats {
     }
     ++batches_input;
     bytes_input += rb.NumBytes();
-    rows_input += rb.num_rows();
+    rows_input += rb.num_selected_rows();
   }
 
   void ResumeChildTimer() {
@@ -147,9 +171,11 @@ class ExecNode {
               std::vector<table_store::schema::RowDescriptor> input_descriptors,
               bool collect_exec_stats = false) {
     is_initialized_ = true;
+    id_ = plan_node.id();
     output_descriptor_ = std::make_unique<table_store::schema::RowDescriptor>(output_descriptor);
     input_descriptors_ = input_descriptors;
     stats_ = std::make_unique<ExecNodeStats>(collect_exec_stats);
+    timer_ = ExecNodeTimer(plan_node.op_type());
     return InitImpl(plan_node);
   }
 
@@ -194,6 +220,11 @@ class ExecNode {
   Status GenerateNext(ExecState* exec_state) {
     DCHECK(is_initialized_);
     DCHECK(type() == ExecNodeType::kSourceNode);
+    if (exec_state->query_trace() != nullptr) {
+      exec_state->query_trace()->StartSourceBatch();
+    }
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kGenerate, id_);
+    ScopedSelfTimer self_timer(this);
     stats_->ResumeTotalTimer();
     PL_RETURN_IF_ERROR(GenerateNextImpl(exec_state));
     stats_->StopTotalTimer();
@@ -219,6 +250,11 @@ class ExecNode {
           "ConsumeNext received row batch with end of stream set but not end of window.");
     }
     stats_->AddInputStats(rb);
+    if (consumed_batches_ != nullptr) {
+      consumed_batches_->push_back(rb);
+    }
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kConsume, id_);
+    ScopedSelfTimer self_timer(this);
     stats_->ResumeTotalTimer();
     PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, rb, parent_index));
     stats_->StopTotalTimer();
@@ -240,6 +276,12 @@ class ExecNode {
    */
   bool IsProcessing() { return type() == ExecNodeType::kProcessingNode; }
 
+  /**
+   * Whether the node can consume row batches that have a selection. Row batches sent to nodes
+   * that don't are compacted first.
+   */
+  virtual bool SupportsSelection() const { return false; }
+
   /**
    * Get a debug string for the node.
    * @return the debug string/
@@ -275,6 +317,19 @@ class ExecNode {
 
   ExecNodeStats* stats() const { return stats_.get(); }
 
+  /**
+   * @return the ID of the plan node of the execution node.
+   */
+  int64_t id() const { return id_; }
+
+  /**
+   * Keeps a copy of each row batch that the node consumes in `consumed_batches`, which must outlive
+   * the execution of the node. The copies share the columns of the row batches.
+   */
+  void RecordConsumedBatches(std::vector<table_store::schema::RowBatch>* consumed_batches) {
+    consumed_batches_ = consumed_batches;
+  }
+
  protected:
   /**
    * Send data to children row batches.
@@ -283,11 +338,26 @@ class ExecNode {
    * @return Status of children execution.
    */
   Status SendRowBatchToChildren(ExecState* exec_state, const table_store::schema::RowBatch& rb) {
+    const auto children_start =
+        self_timed_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
     stats_->ResumeChildTimer();
+    // Only compact the selection once, even if several children need it.
+    std::unique_ptr<table_store::schema::RowBatch> compacted_rb;
     for (size_t i = 0; i < children_.size(); ++i) {
-      PL_RETURN_IF_ERROR(children_[i]->ConsumeNext(exec_state, rb, parent_ids_for_children_[i]));
+      const auto* child_rb = &rb;
+      if (rb.has_selection() && !children_[i]->SupportsSelection()) {
+        if (compacted_rb == nullptr) {
+          PL_ASSIGN_OR_RETURN(compacted_rb, rb.CompactSelection());
+        }
+        child_rb = compacted_rb.get();
+      }
+      PL_RETURN_IF_ERROR(
+          children_[i]->ConsumeNext(exec_state, *child_rb, parent_ids_for_children_[i]));
     }
     stats_->StopChildTimer();
+    if (self_timed_) {
+      children_time_ += std::chrono::steady_clock::now() - children_start;
+    }
     stats_->AddOutputStats(rb);
     if (rb.eos()) {
       DCHECK(!sent_eos_);
@@ -321,8 +391,43 @@ class ExecNode {
   bool sent_eos_ = false;
 
  private:
+  // Records the time of a call of the node into its timer, if the timer is enabled, without the
+  // time that its children spend on the batches that it sends them during the call.
+  class ScopedSelfTimer {
+   public:
+    explicit ScopedSelfTimer(ExecNode* node)
+        : node_(node->timer_ != nullptr && node->timer_->enabled() ? node : nullptr) {
+      if (node_ != nullptr) {
+        node_->self_timed_ = true;
+        children_start_ = node_->children_time_;
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~ScopedSelfTimer() {
+      if (node_ != nullptr) {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        node_->timer_->Record(elapsed - (node_->children_time_ - children_start_));
+        node_->self_timed_ = false;
+      }
+    }
+
+   private:
+    ExecNode* const node_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::nanoseconds children_start_;
+  };
+
+  // The ID of the plan node.
+  int64_t id_ = -1;
   // The stats of this exec node.
   std::unique_ptr<ExecNodeStats> stats_;
+  // The timer of the operator type of the node.
+  metrics::NamedTimer* timer_ = nullptr;
+  // Whether the current call of the node is being timed, and the time that its children have spent
+  // in the calls that were timed.
+  bool self_timed_ = false;
+  std::chrono::nanoseconds children_time_{0};
   // Unowned reference to the children. Must remain valid for the duration of query.
   std::vector<ExecNode*> children_;
   // For each of the children (which may have multiple parents) which parent is this node?
@@ -334,6 +439,8 @@ class ExecNode {
   ExecNodeType type_;
   // Whether this node has been initialized.
   bool is_initialized_ = false;
+  // Where the consumed row batches are recorded, if they are recorded at all.
+  std::vector<table_store::schema::RowBatch>* consumed_batches_ = nullptr;
 };
 
 /**
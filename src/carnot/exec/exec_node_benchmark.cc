@@ -0,0 +1,637 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Microbenchmarks of the Carnot execution nodes. Every benchmark pushes the same total number of
+// rows through a single node, with the node's output consumed by a sink that only counts rows, so
+// that items/s are comparable between nodes and batch sizes. For machine-readable results run with
+// --benchmark_out=<file> --benchmark_out_format=json.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/equijoin_node.h"
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/filter_node.h"
+#include "src/carnot/exec/limit_node.h"
+#include "src/carnot/exec/map_node.h"
+#include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/exec/udtf_source_node.h"
+#include "src/carnot/exec/union_node.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+#include "src/carnot/udf/udf.h"
+#include "src/carnot/udf/udtf.h"
+#include "src/carnot/udfspb/udfs.pb.h"
+#include "src/common/base/base.h"
+#include "src/common/datagen/datagen.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::Table;
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using types::DataType;
+using udf::FunctionContext;
+
+// The number of rows that each benchmark iteration pushes through the node.
+constexpr int64_t kTotalRows = 1 << 18;
+constexpr int64_t kBatchSizes[] = {64, 1024, 16 * 1024};
+constexpr DataType kColumnTypes[] = {DataType::INT64, DataType::FLOAT64, DataType::STRING};
+
+class LessThanUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val < v2.val;
+  }
+};
+
+class AddUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+class FloatAddUDF : public udf::ScalarUDF {
+ public:
+  types::Float64Value Exec(FunctionContext*, types::Float64Value v1, types::Float64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+class StringAddUDF : public udf::ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue v1, types::StringValue v2) {
+    return v1 + v2;
+  }
+};
+
+// Outputs [0, num_partitions * records_per_partition) as ints and floats, a partition at a time.
+class SequenceUDTF : public udf::UDTF<SequenceUDTF> {
+ public:
+  static constexpr auto InitArgs() {
+    return MakeArray(udf::UDTFArg::Make<DataType::INT64>("num_partitions", "Int arg"),
+                     udf::UDTFArg::Make<DataType::INT64>("records_per_partition", "Int arg"));
+  }
+
+  static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        udf::ColInfo("out_int", DataType::INT64, types::PatternType::GENERAL, "int result"),
+        udf::ColInfo("out_float", DataType::FLOAT64, types::PatternType::GENERAL, "float result"));
+  }
+
+  Status Init(FunctionContext*, types::Int64Value num_partitions,
+              types::Int64Value records_per_partition) {
+    num_partitions_ = num_partitions.val;
+    records_per_partition_ = records_per_partition.val;
+    return Status::OK();
+  }
+
+  int64_t NumPartitions(FunctionContext*) const { return num_partitions_; }
+
+  void GeneratePartition(FunctionContext*, int64_t partition, RecordWriter* rw) const {
+    for (int64_t i = 0; i < records_per_partition_; ++i) {
+      int64_t val = partition * records_per_partition_ + i;
+      rw->Append<IndexOf("out_int")>(val);
+      rw->Append<IndexOf("out_float")>(val * 0.5);
+    }
+  }
+
+ private:
+  int64_t num_partitions_ = 0;
+  int64_t records_per_partition_ = 0;
+};
+
+// Terminates the benchmarked node, counting the rows that it outputs.
+class CountingSinkNode : public SinkNode {
+ public:
+  int64_t rows() const { return rows_; }
+  bool eos() const { return eos_; }
+
+ protected:
+  std::string DebugStringImpl() override { return "CountingSinkNode"; }
+  Status InitImpl(const plan::Operator&) override { return Status::OK(); }
+  Status PrepareImpl(ExecState*) override { return Status::OK(); }
+  Status OpenImpl(ExecState*) override { return Status::OK(); }
+  Status CloseImpl(ExecState*) override { return Status::OK(); }
+  Status ConsumeNextImpl(ExecState*, const RowBatch& rb, size_t) override {
+    rows_ += rb.num_rows();
+    eos_ = rb.eos();
+    return Status::OK();
+  }
+
+ private:
+  int64_t rows_ = 0;
+  bool eos_ = false;
+};
+
+std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& op_type,
+                                                  const std::string& op_field,
+                                                  const std::string& pbtxt) {
+  planpb::Operator op_pb;
+  CHECK(google::protobuf::TextFormat::MergeFromString(
+      absl::Substitute(planpb::testutils::kOperatorProtoTmpl, op_type, op_field, pbtxt), &op_pb));
+  return plan::Operator::FromProto(op_pb, /*id*/ 1);
+}
+
+std::unique_ptr<udf::Registry> MakeRegistry() {
+  auto registry = std::make_unique<udf::Registry>("benchmark_registry");
+  PL_CHECK_OK(registry->Register<LessThanUDF>("lessThan"));
+  PL_CHECK_OK(registry->Register<AddUDF>("add"));
+  PL_CHECK_OK(registry->Register<FloatAddUDF>("add"));
+  PL_CHECK_OK(registry->Register<StringAddUDF>("add"));
+  PL_CHECK_OK(registry->Register<SequenceUDTF>("sequence"));
+  return registry;
+}
+
+std::unique_ptr<ExecState> MakeExecState(udf::Registry* registry) {
+  return std::make_unique<ExecState>(registry, std::make_shared<table_store::TableStore>(),
+                                     MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+}
+
+// Generates a column of the given type. Ints, floats and strings take one of key_cardinality
+// distinct values. Times increase by time_step from first_time, so that batches generated one
+// after the other are sorted.
+std::shared_ptr<arrow::Array> MakeColumn(DataType type, int64_t num_rows, int64_t key_cardinality,
+                                         int64_t first_time, int64_t time_step) {
+  switch (type) {
+    case DataType::INT64:
+      return types::ToArrow(
+          datagen::CreateLargeData<types::Int64Value>(num_rows, 0, key_cardinality - 1),
+          arrow::default_memory_pool());
+    case DataType::FLOAT64:
+      return types::ToArrow(
+          datagen::CreateLargeData<types::Float64Value>(num_rows, 0, key_cardinality - 1),
+          arrow::default_memory_pool());
+    case DataType::STRING: {
+      auto idxs = datagen::CreateLargeData<types::Int64Value>(num_rows, 0, key_cardinality - 1);
+      std::vector<types::StringValue> data(num_rows);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        data[i] = absl::StrCat("/api/v1/service/", idxs[i].val);
+      }
+      return types::ToArrow(data, arrow::default_memory_pool());
+    }
+    case DataType::TIME64NS: {
+      std::vector<types::Time64NSValue> data(num_rows);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        data[i] = first_time + i * time_step;
+      }
+      return types::ToArrow(data, arrow::default_memory_pool());
+    }
+    default:
+      break;
+  }
+  LOG(FATAL) << "Unsupported benchmark column type: " << types::DataType_Name(type);
+  return nullptr;
+}
+
+// Splits total_rows of generated data into batches of batch_size, with eow/eos set on the last.
+std::vector<std::unique_ptr<RowBatch>> MakeBatches(const RowDescriptor& rd, int64_t batch_size,
+                                                   int64_t total_rows, int64_t key_cardinality,
+                                                   int64_t first_time = 0, int64_t time_step = 1) {
+  std::vector<std::unique_ptr<RowBatch>> batches;
+  for (int64_t offset = 0; offset < total_rows; offset += batch_size) {
+    int64_t num_rows = std::min(batch_size, total_rows - offset);
+    auto rb = std::make_unique<RowBatch>(rd, num_rows);
+    for (auto type : rd.types()) {
+      PL_CHECK_OK(rb->AddColumn(MakeColumn(type, num_rows, key_cardinality,
+                                           first_time + offset * time_step, time_step)));
+    }
+    bool last = offset + batch_size >= total_rows;
+    rb->set_eow(last);
+    rb->set_eos(last);
+    batches.push_back(std::move(rb));
+  }
+  return batches;
+}
+
+// The stateless nodes are fed the same batches every iteration, and may only output eos once.
+void ClearEOS(std::vector<std::unique_ptr<RowBatch>>* batches) {
+  batches->back()->set_eow(false);
+  batches->back()->set_eos(false);
+}
+
+template <typename TNode>
+std::unique_ptr<TNode> MakeNode(const plan::Operator& plan_node, const RowDescriptor& output_rd,
+                                const std::vector<RowDescriptor>& input_rds,
+                                ExecState* exec_state, CountingSinkNode* sink) {
+  auto node = std::make_unique<TNode>();
+  PL_CHECK_OK(node->Init(plan_node, output_rd, input_rds));
+  PL_CHECK_OK(node->Prepare(exec_state));
+  PL_CHECK_OK(node->Open(exec_state));
+
+  PL_CHECK_OK(sink->Init(FakePlanNode(2), output_rd, {output_rd}));
+  PL_CHECK_OK(sink->Prepare(exec_state));
+  PL_CHECK_OK(sink->Open(exec_state));
+  node->AddChild(sink, 0);
+  return node;
+}
+
+void ReportRows(benchmark::State* state, int64_t rows_in, int64_t rows_out) {
+  state->SetItemsProcessed(state->iterations() * rows_in);
+  state->counters["rows_out"] = rows_out;
+}
+
+void BatchSizeArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch_size"});
+  for (int64_t batch_size : kBatchSizes) {
+    b->Args({batch_size});
+  }
+}
+
+void BatchSizeAndTypeArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch_size", "type"});
+  for (int64_t batch_size : kBatchSizes) {
+    for (DataType type : kColumnTypes) {
+      b->Args({batch_size, type});
+    }
+  }
+}
+
+void BatchSizeAndSelectivityArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch_size", "selectivity_pct"});
+  for (int64_t batch_size : kBatchSizes) {
+    for (int64_t selectivity : {1, 10, 50, 100}) {
+      b->Args({batch_size, selectivity});
+    }
+  }
+}
+
+void BatchSizeAndCardinalityArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch_size", "key_cardinality"});
+  for (int64_t batch_size : kBatchSizes) {
+    for (int64_t cardinality : {16, 1024, 64 * 1024}) {
+      b->Args({batch_size, cardinality});
+    }
+  }
+}
+
+void BatchSizeAndLimitArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch_size", "limit"});
+  for (int64_t batch_size : kBatchSizes) {
+    for (int64_t limit : {int64_t{100}, kTotalRows / 2, kTotalRows}) {
+      b->Args({batch_size, limit});
+    }
+  }
+}
+
+constexpr char kMemorySourcePbtxt[] = R"(
+name: "bench"
+column_idxs: 0
+column_types: TIME64NS
+column_names: "time_"
+column_idxs: 1
+column_types: $0
+column_names: "value"
+streaming: false
+)";
+
+// Args: batch size of the table, type of its value column.
+// NOLINTNEXTLINE : runtime/references.
+void BM_MemorySourceNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  auto type = static_cast<DataType>(state.range(1));
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+
+  RowDescriptor rd({DataType::TIME64NS, type});
+  table_store::schema::Relation rel(rd.types(), {"time_", "value"});
+  auto table = std::make_shared<Table>("bench", rel, /*max_table_size*/ 1UL << 32);
+  for (const auto& rb : MakeBatches(rd, batch_size, kTotalRows, /*key_cardinality*/ 1024)) {
+    PL_CHECK_OK(table->WriteRowBatch(*rb));
+  }
+  exec_state->table_store()->AddTable("bench", table);
+  auto plan_node =
+      PlanNodeFromPbtxt("MEMORY_SOURCE_OPERATOR", "mem_source_op",
+                        absl::Substitute(kMemorySourcePbtxt, types::DataType_Name(type)));
+
+  int64_t rows_out = 0;
+  for (auto _ : state) {
+    CountingSinkNode sink;
+    auto node = MakeNode<MemorySourceNode>(*plan_node, rd, {}, exec_state.get(), &sink);
+    while (node->HasBatchesRemaining()) {
+      PL_CHECK_OK(node->GenerateNext(exec_state.get()));
+    }
+    PL_CHECK_OK(node->Close(exec_state.get()));
+    rows_out = sink.rows();
+  }
+  ReportRows(&state, kTotalRows, rows_out);
+}
+
+constexpr char kFilterPbtxt[] = R"(
+expression {
+  func {
+    name: "lessThan"
+    args { column { node: 0 index: 0 } }
+    args { constant { data_type: INT64 int64_value: $0 } }
+    args_data_types: INT64
+    args_data_types: INT64
+  }
+}
+columns { node: 0 index: 0 }
+columns { node: 0 index: 1 }
+)";
+
+// Args: batch size, percentage of the rows that pass the filter.
+// NOLINTNEXTLINE : runtime/references.
+void BM_FilterNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  int64_t selectivity_pct = state.range(1);
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "lessThan", {DataType::INT64, DataType::INT64}));
+
+  // The first column is uniform in [0, 100), so that lessThan(col0, pct) keeps pct% of the rows.
+  RowDescriptor rd({DataType::INT64, DataType::FLOAT64});
+  auto batches = MakeBatches(rd, batch_size, kTotalRows, /*key_cardinality*/ 100);
+  ClearEOS(&batches);
+  auto plan_node = PlanNodeFromPbtxt("FILTER_OPERATOR", "filter_op",
+                                     absl::Substitute(kFilterPbtxt, selectivity_pct));
+
+  CountingSinkNode sink;
+  auto node = MakeNode<FilterNode>(*plan_node, rd, {rd}, exec_state.get(), &sink);
+  for (auto _ : state) {
+    for (const auto& rb : batches) {
+      PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *rb, 0));
+    }
+  }
+  ReportRows(&state, kTotalRows, sink.rows() / state.iterations());
+}
+
+constexpr char kMapPbtxt[] = R"(
+expressions {
+  func {
+    name: "add"
+    args { column { node: 0 index: 0 } }
+    args { column { node: 0 index: 1 } }
+    args_data_types: $0
+    args_data_types: $0
+  }
+}
+column_names: "sum"
+)";
+
+// Args: batch size, type of the two columns that are added.
+// NOLINTNEXTLINE : runtime/references.
+void BM_MapNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  auto type = static_cast<DataType>(state.range(1));
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "add", {type, type}));
+
+  RowDescriptor input_rd({type, type});
+  RowDescriptor output_rd({type});
+  auto batches = MakeBatches(input_rd, batch_size, kTotalRows, /*key_cardinality*/ 1024);
+  ClearEOS(&batches);
+  auto plan_node = PlanNodeFromPbtxt("MAP_OPERATOR", "map_op",
+                                     absl::Substitute(kMapPbtxt, types::DataType_Name(type)));
+
+  CountingSinkNode sink;
+  auto node = MakeNode<MapNode>(*plan_node, output_rd, {input_rd}, exec_state.get(), &sink);
+  for (auto _ : state) {
+    for (const auto& rb : batches) {
+      PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *rb, 0));
+    }
+  }
+  ReportRows(&state, kTotalRows, sink.rows() / state.iterations());
+}
+
+constexpr char kJoinPbtxt[] = R"(
+type: INNER
+equality_conditions {
+  left_column_index: 0
+  right_column_index: 0
+}
+output_columns {
+  parent_index: 0
+  column_index: 1
+}
+output_columns {
+  parent_index: 1
+  column_index: 1
+}
+column_names: "build_value"
+column_names: "probe_value"
+rows_per_batch: $0
+build_side: BUILD_LEFT
+)";
+
+// Args: batch size, number of distinct keys. The build side has one row per key, and the keys of
+// the kTotalRows probe rows are uniform over them, so every probe row matches exactly once.
+// NOLINTNEXTLINE : runtime/references.
+void BM_EquijoinNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  int64_t key_cardinality = state.range(1);
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+
+  RowDescriptor rd({DataType::INT64, DataType::FLOAT64});
+  RowDescriptor output_rd({DataType::FLOAT64, DataType::FLOAT64});
+  std::vector<std::unique_ptr<RowBatch>> build_batches;
+  for (int64_t offset = 0; offset < key_cardinality; offset += batch_size) {
+    int64_t num_rows = std::min(batch_size, key_cardinality - offset);
+    std::vector<types::Int64Value> keys(num_rows);
+    std::iota(keys.begin(), keys.end(), offset);
+    bool last = offset + batch_size >= key_cardinality;
+    auto rb = std::make_unique<RowBatch>(rd, num_rows);
+    PL_CHECK_OK(rb->AddColumn(types::ToArrow(keys, arrow::default_memory_pool())));
+    PL_CHECK_OK(rb->AddColumn(MakeColumn(DataType::FLOAT64, num_rows, key_cardinality, 0, 1)));
+    rb->set_eow(last);
+    rb->set_eos(last);
+    build_batches.push_back(std::move(rb));
+  }
+  auto probe_batches = MakeBatches(rd, batch_size, kTotalRows, key_cardinality);
+  auto plan_node =
+      PlanNodeFromPbtxt("JOIN_OPERATOR", "join_op", absl::Substitute(kJoinPbtxt, batch_size));
+
+  int64_t rows_out = 0;
+  for (auto _ : state) {
+    // The hash table is built again every iteration, which is part of the join's cost.
+    CountingSinkNode sink;
+    auto node = MakeNode<EquijoinNode>(*plan_node, output_rd, {rd, rd}, exec_state.get(), &sink);
+    for (const auto& rb : build_batches) {
+      PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *rb, 0));
+    }
+    for (const auto& rb : probe_batches) {
+      PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *rb, 1));
+    }
+    PL_CHECK_OK(node->Close(exec_state.get()));
+    rows_out = sink.rows();
+  }
+  ReportRows(&state, key_cardinality + kTotalRows, rows_out);
+}
+
+constexpr char kUnionPbtxt[] = R"(
+rows_per_batch: $0
+column_names: "time_"
+column_names: "value"
+column_mappings {
+  column_indexes: 0
+  column_indexes: 1
+}
+column_mappings {
+  column_indexes: 0
+  column_indexes: 1
+}
+)";
+
+// Args: batch size. Merges two time ordered inputs whose times interleave.
+// NOLINTNEXTLINE : runtime/references.
+void BM_UnionNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+
+  RowDescriptor rd({DataType::TIME64NS, DataType::INT64});
+  std::vector<std::unique_ptr<RowBatch>> parent_batches[2];
+  for (int64_t parent = 0; parent < 2; ++parent) {
+    parent_batches[parent] = MakeBatches(rd, batch_size, kTotalRows / 2, /*key_cardinality*/ 1024,
+                                         /*first_time*/ parent, /*time_step*/ 2);
+  }
+  auto plan_node =
+      PlanNodeFromPbtxt("UNION_OPERATOR", "union_op", absl::Substitute(kUnionPbtxt, batch_size));
+
+  int64_t rows_out = 0;
+  for (auto _ : state) {
+    CountingSinkNode sink;
+    auto node = MakeNode<UnionNode>(*plan_node, rd, {rd, rd}, exec_state.get(), &sink);
+    node->disable_data_flush_timeout();
+    for (size_t i = 0; i < parent_batches[0].size(); ++i) {
+      for (int64_t parent = 0; parent < 2; ++parent) {
+        PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *parent_batches[parent][i], parent));
+      }
+    }
+    PL_CHECK_OK(node->Close(exec_state.get()));
+    rows_out = sink.rows();
+  }
+  ReportRows(&state, kTotalRows, rows_out);
+}
+
+constexpr char kLimitPbtxt[] = R"(
+limit: $0
+columns { node: 0 index: 0 }
+columns { node: 0 index: 1 }
+)";
+
+// Args: batch size, the limit. Input stops once the limit is reached, like the sources do when a
+// limit aborts them.
+// NOLINTNEXTLINE : runtime/references.
+void BM_LimitNode(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  int64_t limit = state.range(1);
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+
+  RowDescriptor rd({DataType::INT64, DataType::STRING});
+  auto batches = MakeBatches(rd, batch_size, kTotalRows, /*key_cardinality*/ 1024);
+  auto plan_node =
+      PlanNodeFromPbtxt("LIMIT_OPERATOR", "limit_op", absl::Substitute(kLimitPbtxt, limit));
+
+  int64_t rows_in = 0;
+  int64_t rows_out = 0;
+  for (auto _ : state) {
+    CountingSinkNode sink;
+    auto node = MakeNode<LimitNode>(*plan_node, rd, {rd}, exec_state.get(), &sink);
+    rows_in = 0;
+    for (const auto& rb : batches) {
+      PL_CHECK_OK(node->ConsumeNext(exec_state.get(), *rb, 0));
+      rows_in += rb->num_rows();
+      if (sink.eos()) {
+        break;
+      }
+    }
+    PL_CHECK_OK(node->Close(exec_state.get()));
+    rows_out = sink.rows();
+  }
+  ReportRows(&state, rows_in, rows_out);
+}
+
+constexpr char kUDTFSourcePbtxt[] = R"(
+name: "sequence"
+arg_values {
+  data_type: INT64
+  int64_value: $0
+}
+arg_values {
+  data_type: INT64
+  int64_value: $1
+}
+)";
+
+// Args: number of partitions that the kTotalRows records are generated in.
+// NOLINTNEXTLINE : runtime/references.
+void BM_UDTFSourceNode(benchmark::State& state) {
+  int64_t num_partitions = state.range(0);
+  auto registry = MakeRegistry();
+  auto exec_state = MakeExecState(registry.get());
+
+  RowDescriptor rd({DataType::INT64, DataType::FLOAT64});
+  auto plan_node = PlanNodeFromPbtxt(
+      "UDTF_SOURCE_OPERATOR", "udtf_source_op",
+      absl::Substitute(kUDTFSourcePbtxt, num_partitions, kTotalRows / num_partitions));
+
+  int64_t rows_out = 0;
+  for (auto _ : state) {
+    CountingSinkNode sink;
+    auto node = MakeNode<UDTFSourceNode>(*plan_node, rd, {}, exec_state.get(), &sink);
+    while (node->HasBatchesRemaining()) {
+      PL_CHECK_OK(node->GenerateNext(exec_state.get()));
+    }
+    PL_CHECK_OK(node->Close(exec_state.get()));
+    rows_out = sink.rows();
+  }
+  ReportRows(&state, rows_out, rows_out);
+}
+
+BENCHMARK(BM_MemorySourceNode)->Apply(BatchSizeAndTypeArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FilterNode)->Apply(BatchSizeAndSelectivityArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MapNode)->Apply(BatchSizeAndTypeArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EquijoinNode)->Apply(BatchSizeAndCardinalityArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_UnionNode)->Apply(BatchSizeArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LimitNode)->Apply(BatchSizeAndLimitArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_UDTFSourceNode)
+    ->ArgNames({"partitions"})
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
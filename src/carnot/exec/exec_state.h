@@ -29,7 +29,13 @@
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/arena_memory_pool.h"
 #include "src/carnot/exec/grpc_router.h"
+#include "src/carnot/exec/memory_tracker.h"
+#include "src/carnot/exec/query_scheduler.h"
+#include "src/carnot/exec/query_trace.h"
+#include "src/carnot/exec/result_stream_mux.h"
+#include "src/carnot/exec/row_batch_queue.h"
 #include "src/carnot/exec/ml/model_pool.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
@@ -60,25 +66,83 @@ class ExecState {
       udf::Registry* func_registry, std::shared_ptr<table_store::TableStore> table_store,
       const ResultSinkStubGenerator& stub_generator, const sole::uuid& query_id,
       ml::ModelPool* model_pool, GRPCRouter* grpc_router = nullptr,
-      std::function<void(grpc::ClientContext*)> add_auth_func = [](grpc::ClientContext*) {})
+      std::function<void(grpc::ClientContext*)> add_auth_func = [](grpc::ClientContext*) {},
+      MemoryTracker* node_memory_tracker = nullptr)
       : func_registry_(func_registry),
         table_store_(std::move(table_store)),
         stub_generator_(stub_generator),
         query_id_(query_id),
         model_pool_(model_pool),
         grpc_router_(grpc_router),
-        add_auth_to_grpc_client_context_func_(add_auth_func) {}
+        add_auth_to_grpc_client_context_func_(add_auth_func),
+        memory_tracker_(std::make_shared<MemoryTracker>(
+            absl::Substitute("Query $0", query_id.str()), FLAGS_carnot_query_memory_limit_bytes,
+            node_memory_tracker)) {
+    if (FLAGS_carnot_query_arena_mem_pool) {
+      arena_mem_pool_ = ArenaMemoryPool::Create(arrow::default_memory_pool(),
+                                                ArenaMemoryPool::kDefaultChunkSize,
+                                                memory_tracker_);
+    }
+  }
 
   ~ExecState() {
     if (grpc_router_ != nullptr) {
       grpc_router_->DeleteQuery(query_id_);
     }
   }
+  /**
+   * The pool for the intermediate data of the query, which is released when the query ends.
+   */
   arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
+    if (arena_mem_pool_ != nullptr) {
+      return arena_mem_pool_.get();
+    }
     return arrow::default_memory_pool();
   }
 
+  /**
+   * The pool for data that outlives the query, e.g. arrays that tables cache.
+   */
+  arrow::MemoryPool* persistent_mem_pool() { return arrow::default_memory_pool(); }
+
+  /**
+   * Makes the query allocate all of its data from the default pool, for queries whose results
+   * outlive them. Must be called before the query starts executing.
+   */
+  void DisableArenaMemPool() { arena_mem_pool_.reset(); }
+
+  /**
+   * Tracks the memory of the query: its arena, and the data structures of its operators and of the
+   * GRPC router that register their sizes.
+   */
+  const std::shared_ptr<MemoryTracker>& memory_tracker() const { return memory_tracker_; }
+
+  /**
+   * Returns an error, which cancels the query, if it holds more memory than it is allowed to.
+   */
+  Status CheckMemoryLimit() const { return memory_tracker_->CheckLimit(); }
+
+  /**
+   * Traces the row batches of the query, see QueryTrace. Must be enabled before the execution
+   * graphs are created.
+   */
+  void EnableQueryTrace() { query_trace_ = std::make_unique<QueryTrace>(); }
+  QueryTrace* query_trace() const { return query_trace_.get(); }
+
+  /**
+   * The ticket of the query in the query scheduler, if it runs under one. The execution graphs
+   * give up its slot while they wait for data or yield to more important queries.
+   */
+  QueryScheduler::Ticket* query_ticket() const { return query_ticket_.get(); }
+  void set_query_ticket(std::shared_ptr<QueryScheduler::Ticket> ticket) {
+    query_ticket_ = std::move(ticket);
+  }
+
+  /**
+   * The peak number of bytes held by the query, as counted by its memory tracker.
+   */
+  int64_t PeakMemoryBytes() const { return memory_tracker_->peak_bytes(); }
+
   udf::Registry* func_registry() { return func_registry_; }
 
   table_store::TableStore* table_store() { return table_store_.get(); }
@@ -88,13 +152,20 @@ class ExecState {
   ml::ModelPool* model_pool() { return model_pool_; }
 
   Status AddScalarUDF(int64_t id, const std::string& name,
-                      const std::vector<types::DataType> arg_types) {
+                      const std::vector<types::DataType>& arg_types) {
+    if (id_to_scalar_udf_map_.contains(id)) {
+      return Status::OK();
+    }
     PL_ASSIGN_OR_RETURN(auto def, func_registry_->GetScalarUDFDefinition(name, arg_types));
     id_to_scalar_udf_map_[id] = def;
     return Status::OK();
   }
 
-  Status AddUDA(int64_t id, const std::string& name, const std::vector<types::DataType> arg_types) {
+  Status AddUDA(int64_t id, const std::string& name,
+                const std::vector<types::DataType>& arg_types) {
+    if (id_to_uda_map_.contains(id)) {
+      return Status::OK();
+    }
     PL_ASSIGN_OR_RETURN(auto def, func_registry_->GetUDADefinition(name, arg_types));
     id_to_uda_map_[id] = def;
     return Status::OK();
@@ -116,13 +187,19 @@ class ExecState {
     return raw;
   }
 
-  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) { return id_to_scalar_udf_map_[id]; }
+  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) const {
+    auto it = id_to_scalar_udf_map_.find(id);
+    return it == id_to_scalar_udf_map_.end() ? nullptr : it->second;
+  }
 
-  std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map() {
+  const absl::flat_hash_map<int64_t, udf::ScalarUDFDefinition*>& id_to_scalar_udf_map() const {
     return id_to_scalar_udf_map_;
   }
 
-  udf::UDADefinition* GetUDADefinition(int64_t id) { return id_to_uda_map_[id]; }
+  udf::UDADefinition* GetUDADefinition(int64_t id) const {
+    auto it = id_to_uda_map_.find(id);
+    return it == id_to_uda_map_.end() ? nullptr : it->second;
+  }
 
   std::unique_ptr<udf::FunctionContext> CreateFunctionContext() {
     auto ctx = std::make_unique<udf::FunctionContext>(metadata_state_, model_pool_);
@@ -153,6 +230,27 @@ class ExecState {
 
   GRPCRouter* grpc_router() { return grpc_router_; }
 
+  // The muxes that carry the results sent to other Carnot instances, nullptr if each GRPC sink
+  // sends its results over a stream of its own.
+  ResultStreamMuxPool* result_stream_mux_pool() { return result_stream_mux_pool_; }
+  void set_result_stream_mux_pool(ResultStreamMuxPool* pool) { result_stream_mux_pool_ = pool; }
+
+  /**
+   * The callbacks that the memory sinks of the given tables stream their batches to, instead of
+   * writing them to the table store. Set by the engine, which owns them.
+   */
+  void set_memory_sink_callbacks(
+      const absl::flat_hash_map<std::string, MemorySinkCallback>* callbacks) {
+    memory_sink_callbacks_ = callbacks;
+  }
+  const MemorySinkCallback* memory_sink_callback(const std::string& table_name) const {
+    if (memory_sink_callbacks_ == nullptr) {
+      return nullptr;
+    }
+    auto it = memory_sink_callbacks_->find(table_name);
+    return it == memory_sink_callbacks_->end() ? nullptr : &it->second;
+  }
+
   void AddAuthToGRPCClientContext(grpc::ClientContext* ctx) {
     CHECK(add_auth_to_grpc_client_context_func_);
     add_auth_to_grpc_client_context_func_(ctx);
@@ -168,12 +266,19 @@ class ExecState {
   std::shared_ptr<table_store::TableStore> table_store_;
   std::shared_ptr<const md::AgentMetadataState> metadata_state_;
   const ResultSinkStubGenerator stub_generator_;
-  std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map_;
-  std::map<int64_t, udf::UDADefinition*> id_to_uda_map_;
+  // The functions of the query by their ID in the plan.
+  absl::flat_hash_map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map_;
+  absl::flat_hash_map<int64_t, udf::UDADefinition*> id_to_uda_map_;
   const sole::uuid query_id_;
   ml::ModelPool* model_pool_;
   GRPCRouter* grpc_router_ = nullptr;
+  ResultStreamMuxPool* result_stream_mux_pool_ = nullptr;
+  const absl::flat_hash_map<std::string, MemorySinkCallback>* memory_sink_callbacks_ = nullptr;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_client_context_func_;
+  const std::shared_ptr<MemoryTracker> memory_tracker_;
+  ArenaMemoryPool::Ptr arena_mem_pool_;
+  std::shared_ptr<QueryScheduler::Ticket> query_ticket_;
+  std::unique_ptr<QueryTrace> query_trace_;
 
   int64_t current_source_ = 0;
   bool current_source_set_ = false;
@@ -157,7 +157,12 @@ Status ScalarExpressionEvaluator::InitFuncsInExpression(
   walker.OnColumn([](auto, auto) -> bool { return true; });
   walker.OnScalarFunc([&](const plan::ScalarFunc& fn, const std::vector<bool>&) -> bool {
     auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
-    auto udf = id_to_udf_map_[fn.udf_id()].get();
+    // Only the functions of the expressions are instantiated, not every function of the query.
+    auto& udf_ptr = id_to_udf_map_[fn.udf_id()];
+    if (udf_ptr == nullptr) {
+      udf_ptr = def->Make();
+    }
+    auto udf = udf_ptr.get();
 
     std::vector<std::shared_ptr<types::BaseValueType>> init_args;
     for (const auto& scalar_val : fn.init_arguments()) {
@@ -172,10 +177,6 @@ Status ScalarExpressionEvaluator::InitFuncsInExpression(
 }
 
 Status VectorNativeScalarExpressionEvaluator::Open(ExecState* exec_state) {
-  for (const auto& kv : exec_state->id_to_scalar_udf_map()) {
-    auto udf = kv.second->Make();
-    id_to_udf_map_[kv.first] = std::move(udf);
-  }
   for (auto expr : expressions_) {
     PL_RETURN_IF_ERROR(InitFuncsInExpression(exec_state, expr));
   }
@@ -187,12 +188,30 @@ Status VectorNativeScalarExpressionEvaluator::Close(ExecState*) {
   return Status();
 }
 
+FusedScalarExpression* VectorNativeScalarExpressionEvaluator::GetFusedExpression(
+    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
+  auto it = fused_exprs_.find(&expr);
+  if (it == fused_exprs_.end()) {
+    it = fused_exprs_
+             .emplace(&expr, FusedScalarExpression::Compile(exec_state, expr, input.desc()))
+             .first;
+  }
+  return it->second.get();
+}
+
 StatusOr<types::SharedColumnWrapper>
 VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
     ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
   CHECK(exec_state != nullptr);
   CHECK_GT(input.num_columns(), 0);
 
+  if (FLAGS_carnot_fuse_scalar_expressions) {
+    auto* fused = GetFusedExpression(exec_state, input, expr);
+    if (fused != nullptr) {
+      return fused->Evaluate(input);
+    }
+  }
+
   size_t num_rows = input.num_rows();
 
   // Path for scalar funcs an their dependencies to get evaluated.
@@ -274,13 +293,13 @@ Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
 }
 
 Status ArrowNativeScalarExpressionEvaluator::Open(ExecState* exec_state) {
-  for (const auto& kv : exec_state->id_to_scalar_udf_map()) {
-    auto udf = kv.second->Make();
-    id_to_udf_map_[kv.first] = std::move(udf);
-  }
   for (const auto& expr : expressions_) {
     PL_RETURN_IF_ERROR(InitFuncsInExpression(exec_state, expr));
   }
+  for (const auto& [id, udf] : id_to_udf_map_) {
+    PL_UNUSED(udf);
+    kernels_[id] = GetArrowKernel(*exec_state->GetScalarUDFDefinition(id));
+  }
   return Status::OK();
 }
 Status ArrowNativeScalarExpressionEvaluator::Close(ExecState*) {
@@ -292,28 +311,36 @@ Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
     exec::ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr,
     RowBatch* output) {
   size_t num_rows = input.num_rows();
-  plan::ExpressionWalker<std::shared_ptr<arrow::Array>> walker;
+  // Constants are only expanded into arrays when a UDF needs them as such.
+  auto to_array = [&](const ArrowKernelArg& arg) {
+    if (arg.constant != nullptr) {
+      return EvalScalarToArrow(exec_state, *arg.constant, num_rows);
+    }
+    return arg.array;
+  };
+
+  plan::ExpressionWalker<ArrowKernelArg> walker;
   walker.OnScalarValue(
-      [&](const plan::ScalarValue& val, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
+      [&](const plan::ScalarValue& val,
+          const std::vector<ArrowKernelArg>& children) -> ArrowKernelArg {
         DCHECK_EQ(children.size(), 0ULL);
-        return EvalScalarToArrow(exec_state, val, num_rows);
+        return {nullptr, &val};
       });
 
   walker.OnColumn(
-      [&](const plan::Column& col, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
+      [&](const plan::Column& col, const std::vector<ArrowKernelArg>& children) -> ArrowKernelArg {
         DCHECK_EQ(children.size(), 0ULL);
-        return input.ColumnAt(col.Index());
+        return {input.ColumnAt(col.Index()), nullptr};
       });
 
   walker.OnScalarFunc(
-      [&](const plan::ScalarFunc& fn, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
-        std::vector<types::DataType> arg_types;
-        arg_types.reserve(children.size());
-        for (const auto& child : children) {
-          arg_types.emplace_back(ArrowToDataType(child->type_id()));
+      [&](const plan::ScalarFunc& fn, const std::vector<ArrowKernelArg>& children)
+          -> ArrowKernelArg {
+        ArrowKernel kernel = kernels_[fn.udf_id()];
+        if (kernel != nullptr) {
+          auto output_array_or_s = kernel(children, num_rows);
+          PL_CHECK_OK(output_array_or_s);
+          return {output_array_or_s.ConsumeValueOrDie(), nullptr};
         }
 
         auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
@@ -321,22 +348,25 @@ Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
 
         auto output = MakeArrowBuilder(def->exec_return_type(), arrow::default_memory_pool());
 
+        std::vector<std::shared_ptr<arrow::Array>> child_arrays;
         std::vector<arrow::Array*> raw_children;
+        child_arrays.reserve(children.size());
         raw_children.reserve(children.size());
         for (const auto& child : children) {
-          raw_children.push_back(child.get());
+          child_arrays.push_back(to_array(child));
+          raw_children.push_back(child_arrays.back().get());
         }
 
         PL_CHECK_OK(def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows));
 
         std::shared_ptr<arrow::Array> output_array;
         PL_CHECK_OK(output->Finish(&output_array));
-        return output_array;
+        return {output_array, nullptr};
       });
 
   PL_ASSIGN_OR_RETURN(auto result, walker.Walk(expr));
 
-  PL_RETURN_IF_ERROR(output->AddColumn(result));
+  PL_RETURN_IF_ERROR(output->AddColumn(to_array(result)));
   return Status::OK();
 }
 
@@ -26,7 +26,11 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/exec/arrow_kernels.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/fused_expression.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
 #include "src/carnot/udf/udf.h"
@@ -149,10 +153,22 @@ class VectorNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
   Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
                                   const plan::ScalarExpression& expr,
                                   table_store::schema::RowBatch* output) override;
+
+ private:
+  // Returns the fused version of the expression, or nullptr if it can't be fused.
+  FusedScalarExpression* GetFusedExpression(ExecState* exec_state,
+                                            const table_store::schema::RowBatch& input,
+                                            const plan::ScalarExpression& expr);
+
+  // Expressions are compiled on their first row batch, since that is when the input types are
+  // known. Expressions that can't be fused map to nullptr.
+  absl::flat_hash_map<const plan::ScalarExpression*, std::unique_ptr<FusedScalarExpression>>
+      fused_exprs_;
 };
 
 /**
- * A scalar expression evaluator that uses Arrow arrays for intermediate state.
+ * A scalar expression evaluator that uses Arrow arrays for intermediate state. Builtins that have
+ * an ArrowKernel are evaluated with it, the other functions through their UDFs.
  */
 class ArrowNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
  public:
@@ -167,6 +183,10 @@ class ArrowNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
   Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
                                   const plan::ScalarExpression& expr,
                                   table_store::schema::RowBatch* output) override;
+
+ private:
+  // The kernel of each UDF, or nullptr for the UDFs that don't have one.
+  absl::flat_hash_map<int64_t, ArrowKernel> kernels_;
 };
 
 }  // namespace exec
@@ -28,6 +28,7 @@
 
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/fused_expression.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/carnot/plan/scalar_expression.h"
@@ -83,6 +84,7 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
   PL_CHECK_OK(func_registry->Register<AddUDF>("add"));
   auto exec_state = std::make_unique<ExecState>(
       func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "add", {DataType::INT64, DataType::INT64}));
 
   auto in1 = px::datagen::CreateLargeData<Int64Value>(data_size);
   auto in2 = px::datagen::CreateLargeData<Int64Value>(data_size);
@@ -108,6 +110,13 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
   state.SetBytesProcessed(int64_t(state.iterations()) * 2 * in1.size() * sizeof(int64_t));
 }
 
+// NOLINTNEXTLINE : runtime/references.
+void BM_ScalarExpressionFusion(benchmark::State& state, bool fuse, const char* pbtxt) {
+  FLAGS_carnot_fuse_scalar_expressions = fuse;
+  BM_ScalarExpressionTwoCols(state, ScalarExpressionEvaluatorType::kVectorNative, pbtxt);
+  FLAGS_carnot_fuse_scalar_expressions = true;
+}
+
 BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, eval_col_arrow,
                   ScalarExpressionEvaluatorType::kArrowNative, kColumnReferencePbtxt)
     ->RangeMultiplier(2)
@@ -143,3 +152,12 @@ BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_simple_add_vector,
                   ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt)
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionFusion, two_cols_add_nested_unfused, false,
+                  kAddScalarFuncNestedPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionFusion, two_cols_add_nested_fused, true,
+                  kAddScalarFuncNestedPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
@@ -39,6 +39,10 @@
 #include "src/shared/types/types.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 
+DEFINE_bool(carnot_filter_selection, gflags::BoolFromEnv("PL_CARNOT_FILTER_SELECTION", true),
+            "Whether filters attach a selection to their input row batches instead of copying the "
+            "rows that pass the predicate.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -132,18 +136,56 @@ Status PredicateCopyValues<types::STRING>(const types::BoolValueColumnWrapper& p
 Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
   // Current implementation does not merge across row batches, we should
   // consider this for cases where the filter has really low selectivity.
-  PL_ASSIGN_OR_RETURN(auto pred_col, evaluator_->EvaluateSingleExpression(
-                                         exec_state, rb, *plan_node_->expression()));
+  types::SharedColumnWrapper pred_col;
+  {
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kEvaluate, id());
+    PL_ASSIGN_OR_RETURN(pred_col, evaluator_->EvaluateSingleExpression(exec_state, rb,
+                                                                        *plan_node_->expression()));
+  }
 
   // Verify that the type of the column is boolean.
   DCHECK_EQ(pred_col->data_type(), types::BOOLEAN) << "Predicate expression must be a boolean";
 
   const types::BoolValueColumnWrapper& pred_col_wrapper =
       *static_cast<types::BoolValueColumnWrapper*>(pred_col.get());
-  size_t num_pred = pred_col_wrapper.Size();
+  DCHECK_EQ(static_cast<size_t>(rb.num_rows()), pred_col_wrapper.Size());
 
-  DCHECK_EQ(static_cast<size_t>(rb.num_rows()), num_pred);
+  if (FLAGS_carnot_filter_selection) {
+    return SendSelectedRows(exec_state, rb, pred_col_wrapper);
+  }
+  return SendFilteredCopy(exec_state, rb, pred_col_wrapper);
+}
 
+Status FilterNode::SendSelectedRows(ExecState* exec_state, const RowBatch& rb,
+                                    const types::BoolValueColumnWrapper& pred) {
+  // The predicate is evaluated over all of the rows, so only keep the ones that were already
+  // selected.
+  auto selection = std::make_shared<std::vector<int64_t>>();
+  selection->reserve(rb.num_selected_rows());
+  for (int64_t i = 0; i < rb.num_selected_rows(); ++i) {
+    auto row_idx = rb.SelectedRowIndex(i);
+    if (pred[row_idx].val) {
+      selection->push_back(row_idx);
+    }
+  }
+
+  RowBatch output_rb(*output_descriptor_, rb.num_rows());
+  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
+  for (auto input_col_idx : plan_node_->selected_cols()) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(rb.ColumnAt(input_col_idx)));
+  }
+  if (static_cast<int64_t>(selection->size()) != rb.num_rows()) {
+    output_rb.set_selection(std::move(selection));
+  }
+
+  output_rb.set_eow(rb.eow());
+  output_rb.set_eos(rb.eos());
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+Status FilterNode::SendFilteredCopy(ExecState* exec_state, const RowBatch& rb,
+                                    const types::BoolValueColumnWrapper& pred_col_wrapper) {
+  size_t num_pred = pred_col_wrapper.Size();
   // Find out how many of them returned true;
   size_t num_output_records = 0;
   for (size_t i = 0; i < num_pred; ++i) {
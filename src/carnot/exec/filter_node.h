@@ -30,8 +30,11 @@
 #include "src/carnot/udf/base.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
+#include "src/shared/types/column_wrapper.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_filter_selection);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -41,6 +44,8 @@ class FilterNode : public ProcessingNode {
   FilterNode() = default;
   virtual ~FilterNode() = default;
 
+  bool SupportsSelection() const override { return FLAGS_carnot_filter_selection; }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -51,6 +56,13 @@ class FilterNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
+  // Attaches the rows that pass the predicate as a selection, sharing the input columns.
+  Status SendSelectedRows(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                          const types::BoolValueColumnWrapper& pred);
+  // Copies the rows that pass the predicate into a new row batch.
+  Status SendFilteredCopy(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                          const types::BoolValueColumnWrapper& pred);
+
   std::unique_ptr<VectorNativeScalarExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::FilterOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
@@ -0,0 +1,388 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression.h"
+
+#include <arrow/array.h>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/udf/udf_definition.h"
+#include "src/shared/types/types.h"
+
+DEFINE_bool(carnot_fuse_scalar_expressions,
+            gflags::BoolFromEnv("PL_CARNOT_FUSE_SCALAR_EXPRESSIONS", true),
+            "Whether trees of builtin arithmetic and comparison functions are evaluated in a "
+            "single fused pass instead of one UDF at a time.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+// Small enough for the blocks of a typical expression tree to stay in the L1 cache.
+constexpr int64_t kFusedBlockSize = 1024;
+
+bool IsIntegerType(types::DataType data_type) {
+  return data_type == types::BOOLEAN || data_type == types::INT64 ||
+         data_type == types::TIME64NS;
+}
+
+bool IsFusableType(types::DataType data_type) {
+  return IsIntegerType(data_type) || data_type == types::FLOAT64;
+}
+
+template <types::DataType DT>
+void CopyBlockToColumnWrapper(const int64_t* int_values, const double* float_values,
+                              types::ColumnWrapper* output, int64_t offset, int64_t num_rows) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  auto* values = static_cast<ValueType*>(output->UnsafeRawData()) + offset;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if constexpr (DT == types::FLOAT64) {
+      values[i] = float_values[i];
+    } else if constexpr (DT == types::BOOLEAN) {
+      values[i] = int_values[i] != 0;
+    } else {
+      values[i] = int_values[i];
+    }
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<FusedScalarExpression> FusedScalarExpression::Compile(
+    ExecState* exec_state, const plan::ScalarExpression& expr, const RowDescriptor& input_desc) {
+  // Plain columns and constants already have fast paths in the evaluators.
+  if (expr.ExpressionType() != plan::Expression::kFunc) {
+    return nullptr;
+  }
+
+  std::unique_ptr<FusedScalarExpression> fused(new FusedScalarExpression());
+  plan::ExpressionWalker<Node*> walker;
+  walker.OnScalarValue([&](const plan::ScalarValue& val, const std::vector<Node*>&) -> Node* {
+    return fused->AddConstant(val);
+  });
+  walker.OnColumn([&](const plan::Column& col, const std::vector<Node*>&) -> Node* {
+    if (col.Index() >= input_desc.size()) {
+      return nullptr;
+    }
+    return fused->AddColumn(col.Index(), input_desc.type(col.Index()));
+  });
+  walker.OnScalarFunc([&](const plan::ScalarFunc& fn, const std::vector<Node*>& args) -> Node* {
+    return fused->AddFunc(exec_state, fn, args);
+  });
+
+  auto root_or_s = walker.Walk(expr);
+  if (!root_or_s.ok() || root_or_s.ValueOrDie() == nullptr) {
+    return nullptr;
+  }
+  DCHECK_EQ(root_or_s.ValueOrDie(), fused->nodes_.back().get());
+  return fused;
+}
+
+FusedScalarExpression::Node* FusedScalarExpression::AddColumn(int64_t col_idx,
+                                                              types::DataType data_type) {
+  if (!IsFusableType(data_type)) {
+    return nullptr;
+  }
+  auto node = std::make_unique<Node>();
+  node->kind = Node::Kind::kColumn;
+  node->data_type = data_type;
+  node->col_idx = col_idx;
+  // Booleans are bit packed in arrow, so they need to be unpacked.
+  if (data_type == types::BOOLEAN) {
+    node->int_block.resize(kFusedBlockSize);
+  }
+  nodes_.push_back(std::move(node));
+  return nodes_.back().get();
+}
+
+FusedScalarExpression::Node* FusedScalarExpression::AddConstant(const plan::ScalarValue& val) {
+  auto node = std::make_unique<Node>();
+  node->kind = Node::Kind::kConstant;
+  node->data_type = val.DataType();
+  // Constants are broadcast once, so that every block can read them like a column.
+  switch (val.DataType()) {
+    case types::BOOLEAN:
+      node->int_block.assign(kFusedBlockSize, val.BoolValue());
+      break;
+    case types::INT64:
+      node->int_block.assign(kFusedBlockSize, val.Int64Value());
+      break;
+    case types::TIME64NS:
+      node->int_block.assign(kFusedBlockSize, val.Time64NSValue());
+      break;
+    case types::FLOAT64:
+      node->float_block.assign(kFusedBlockSize, val.Float64Value());
+      break;
+    default:
+      return nullptr;
+  }
+  node->int_values = node->int_block.data();
+  node->float_values = node->float_block.data();
+  nodes_.push_back(std::move(node));
+  return nodes_.back().get();
+}
+
+FusedScalarExpression::Node* FusedScalarExpression::AddFunc(ExecState* exec_state,
+                                                            const plan::ScalarFunc& fn,
+                                                            const std::vector<Node*>& args) {
+  static const auto* const kOps = new absl::flat_hash_map<std::string, Op>({
+      {"add", Op::kAdd},
+      {"subtract", Op::kSubtract},
+      {"multiply", Op::kMultiply},
+      {"divide", Op::kDivide},
+      {"modulo", Op::kModulo},
+      {"bin", Op::kBin},
+      {"equal", Op::kEqual},
+      {"notEqual", Op::kNotEqual},
+      {"greaterThan", Op::kGreaterThan},
+      {"greaterThanEqual", Op::kGreaterThanEqual},
+      {"lessThan", Op::kLessThan},
+      {"lessThanEqual", Op::kLessThanEqual},
+      {"logicalAnd", Op::kLogicalAnd},
+      {"logicalOr", Op::kLogicalOr},
+  });
+
+  if (args.size() != 2 || args[0] == nullptr || args[1] == nullptr ||
+      !fn.init_arguments().empty()) {
+    return nullptr;
+  }
+  auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+  if (def == nullptr) {
+    return nullptr;
+  }
+  auto it = kOps->find(def->name());
+  if (it == kOps->end()) {
+    return nullptr;
+  }
+  Op op = it->second;
+  Node* lhs = args[0];
+  Node* rhs = args[1];
+  auto return_type = def->exec_return_type();
+  // The UDF reads its inputs as its argument types, so only fuse when they match the inputs.
+  if (def->exec_arguments() != std::vector<types::DataType>{lhs->data_type, rhs->data_type} ||
+      !IsFusableType(return_type)) {
+    return nullptr;
+  }
+
+  bool integer_args = IsIntegerType(lhs->data_type) && IsIntegerType(rhs->data_type);
+  switch (op) {
+    case Op::kModulo:
+    case Op::kBin:
+    case Op::kLogicalAnd:
+    case Op::kLogicalOr:
+      if (!integer_args) {
+        return nullptr;
+      }
+      break;
+    case Op::kEqual:
+    case Op::kNotEqual:
+      // Floating point equality is approximate in the builtins.
+      if (!integer_args || lhs->data_type != rhs->data_type) {
+        return nullptr;
+      }
+      break;
+    default:
+      break;
+  }
+
+  auto node = std::make_unique<Node>();
+  node->kind = Node::Kind::kFunc;
+  node->data_type = return_type;
+  node->op = op;
+  node->lhs = lhs;
+  node->rhs = rhs;
+  if (node->is_float()) {
+    node->float_block.resize(kFusedBlockSize);
+    node->float_values = node->float_block.data();
+  } else {
+    node->int_block.resize(kFusedBlockSize);
+    node->int_values = node->int_block.data();
+  }
+  nodes_.push_back(std::move(node));
+  return nodes_.back().get();
+}
+
+types::SharedColumnWrapper FusedScalarExpression::Evaluate(const RowBatch& input) {
+  int64_t num_rows = input.num_rows();
+  auto* root = nodes_.back().get();
+  auto output = types::ColumnWrapper::Make(root->data_type, num_rows);
+
+  for (int64_t offset = 0; offset < num_rows; offset += kFusedBlockSize) {
+    int64_t block_rows = std::min(kFusedBlockSize, num_rows - offset);
+    for (const auto& node : nodes_) {
+      switch (node->kind) {
+        case Node::Kind::kColumn:
+          LoadColumnBlock(input, node.get(), offset, block_rows);
+          break;
+        case Node::Kind::kFunc:
+          EvaluateFuncBlock(node.get(), block_rows);
+          break;
+        case Node::Kind::kConstant:
+          break;
+      }
+    }
+
+    switch (root->data_type) {
+      case types::BOOLEAN:
+        CopyBlockToColumnWrapper<types::BOOLEAN>(root->int_values, root->float_values,
+                                                 output.get(), offset, block_rows);
+        break;
+      case types::INT64:
+        CopyBlockToColumnWrapper<types::INT64>(root->int_values, root->float_values, output.get(),
+                                               offset, block_rows);
+        break;
+      case types::TIME64NS:
+        CopyBlockToColumnWrapper<types::TIME64NS>(root->int_values, root->float_values,
+                                                  output.get(), offset, block_rows);
+        break;
+      case types::FLOAT64:
+        CopyBlockToColumnWrapper<types::FLOAT64>(root->int_values, root->float_values,
+                                                 output.get(), offset, block_rows);
+        break;
+      default:
+        CHECK(0) << "Unexpected fused expression type";
+    }
+  }
+  return output;
+}
+
+void FusedScalarExpression::LoadColumnBlock(const RowBatch& input, Node* node, int64_t offset,
+                                            int64_t num_rows) {
+  auto* col = input.ColumnAt(node->col_idx).get();
+  DCHECK_EQ(types::ArrowToDataType(col->type_id()), node->data_type);
+  switch (node->data_type) {
+    case types::BOOLEAN: {
+      auto* bool_col = static_cast<const arrow::BooleanArray*>(col);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        node->int_block[i] = bool_col->Value(offset + i);
+      }
+      node->int_values = node->int_block.data();
+      break;
+    }
+    case types::INT64:
+    case types::TIME64NS:
+      // The arrow buffers are read in place.
+      node->int_values = static_cast<const arrow::Int64Array*>(col)->raw_values() + offset;
+      break;
+    case types::FLOAT64:
+      node->float_values = static_cast<const arrow::DoubleArray*>(col)->raw_values() + offset;
+      break;
+    default:
+      CHECK(0) << "Unexpected fused column type";
+  }
+}
+
+template <typename TOut, typename TLHS, typename TRHS>
+void FusedScalarExpression::ApplyOp(Op op, const TLHS* lhs, const TRHS* rhs, TOut* out,
+                                    int64_t num_rows) {
+  // These mirror the Exec functions of the math_ops builtins.
+  switch (op) {
+    case Op::kAdd:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = static_cast<TOut>(lhs[i] + rhs[i]);
+      break;
+    case Op::kSubtract:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = static_cast<TOut>(lhs[i] - rhs[i]);
+      break;
+    case Op::kMultiply:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = static_cast<TOut>(lhs[i] * rhs[i]);
+      break;
+    case Op::kDivide:
+      for (int64_t i = 0; i < num_rows; ++i) {
+        out[i] = static_cast<TOut>(lhs[i]) / static_cast<TOut>(rhs[i]);
+      }
+      break;
+    case Op::kModulo:
+      if constexpr (std::is_integral_v<TLHS> && std::is_integral_v<TRHS>) {
+        for (int64_t i = 0; i < num_rows; ++i) out[i] = static_cast<TOut>(lhs[i] % rhs[i]);
+      } else {
+        CHECK(0) << "Modulo is only fused for integers";
+      }
+      break;
+    case Op::kBin:
+      if constexpr (std::is_integral_v<TLHS> && std::is_integral_v<TRHS>) {
+        for (int64_t i = 0; i < num_rows; ++i) {
+          out[i] = static_cast<TOut>(lhs[i] - (lhs[i] % rhs[i]));
+        }
+      } else {
+        CHECK(0) << "Bin is only fused for integers";
+      }
+      break;
+    case Op::kEqual:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] == rhs[i];
+      break;
+    case Op::kNotEqual:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] != rhs[i];
+      break;
+    case Op::kGreaterThan:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] > rhs[i];
+      break;
+    case Op::kGreaterThanEqual:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] >= rhs[i];
+      break;
+    case Op::kLessThan:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] < rhs[i];
+      break;
+    case Op::kLessThanEqual:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] <= rhs[i];
+      break;
+    case Op::kLogicalAnd:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] && rhs[i];
+      break;
+    case Op::kLogicalOr:
+      for (int64_t i = 0; i < num_rows; ++i) out[i] = lhs[i] || rhs[i];
+      break;
+  }
+}
+
+template <typename TOut>
+void FusedScalarExpression::EvaluateFuncBlock(Node* node, TOut* out, int64_t num_rows) {
+  auto op = node->op;
+  const auto* lhs = node->lhs;
+  const auto* rhs = node->rhs;
+  if (lhs->is_float() && rhs->is_float()) {
+    ApplyOp(op, lhs->float_values, rhs->float_values, out, num_rows);
+  } else if (lhs->is_float()) {
+    ApplyOp(op, lhs->float_values, rhs->int_values, out, num_rows);
+  } else if (rhs->is_float()) {
+    ApplyOp(op, lhs->int_values, rhs->float_values, out, num_rows);
+  } else {
+    ApplyOp(op, lhs->int_values, rhs->int_values, out, num_rows);
+  }
+}
+
+void FusedScalarExpression::EvaluateFuncBlock(Node* node, int64_t num_rows) {
+  if (node->is_float()) {
+    EvaluateFuncBlock(node, node->float_block.data(), num_rows);
+  } else {
+    EvaluateFuncBlock(node, node->int_block.data(), num_rows);
+  }
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
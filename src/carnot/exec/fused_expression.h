@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_bool(carnot_fuse_scalar_expressions);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * A FusedScalarExpression evaluates a tree of builtin arithmetic, comparison and logical functions
+ * over numeric columns and constants, without calling the UDFs. The rows are evaluated in small
+ * blocks, so the intermediate results of the tree are never materialized for the entire row batch.
+ *
+ * The builtins are recognized by name, so this relies on them keeping their math_ops semantics.
+ */
+class FusedScalarExpression {
+ public:
+  /**
+   * Compiles the expression for inputs with the given descriptor.
+   * @return the fused expression or nullptr if the expression contains anything that can't be
+   * fused.
+   */
+  static std::unique_ptr<FusedScalarExpression> Compile(
+      ExecState* exec_state, const plan::ScalarExpression& expr,
+      const table_store::schema::RowDescriptor& input_desc);
+
+  types::DataType data_type() const { return nodes_.back()->data_type; }
+
+  /**
+   * Evaluates the expression for every row of the input, which has to match the descriptor that
+   * the expression was compiled for.
+   */
+  types::SharedColumnWrapper Evaluate(const table_store::schema::RowBatch& input);
+
+ private:
+  enum class Op : uint8_t {
+    kAdd,
+    kSubtract,
+    kMultiply,
+    kDivide,
+    kModulo,
+    kBin,
+    kEqual,
+    kNotEqual,
+    kGreaterThan,
+    kGreaterThanEqual,
+    kLessThan,
+    kLessThanEqual,
+    kLogicalAnd,
+    kLogicalOr,
+  };
+
+  struct Node {
+    enum class Kind : uint8_t { kColumn, kConstant, kFunc };
+    Kind kind;
+    types::DataType data_type;
+    int64_t col_idx = -1;
+    Op op = Op::kAdd;
+    Node* lhs = nullptr;
+    Node* rhs = nullptr;
+    // FLOAT64 values are stored as doubles, all other types as int64s.
+    std::vector<int64_t> int_block;
+    std::vector<double> float_block;
+    // The values of the current block.
+    const int64_t* int_values = nullptr;
+    const double* float_values = nullptr;
+
+    bool is_float() const { return data_type == types::FLOAT64; }
+  };
+
+  FusedScalarExpression() = default;
+
+  Node* AddColumn(int64_t col_idx, types::DataType data_type);
+  Node* AddConstant(const plan::ScalarValue& val);
+  Node* AddFunc(ExecState* exec_state, const plan::ScalarFunc& fn, const std::vector<Node*>& args);
+
+  void LoadColumnBlock(const table_store::schema::RowBatch& input, Node* node, int64_t offset,
+                       int64_t num_rows);
+  void EvaluateFuncBlock(Node* node, int64_t num_rows);
+  template <typename TOut>
+  void EvaluateFuncBlock(Node* node, TOut* out, int64_t num_rows);
+  template <typename TOut, typename TLHS, typename TRHS>
+  static void ApplyOp(Op op, const TLHS* lhs, const TRHS* rhs, TOut* out, int64_t num_rows);
+
+  // Nodes are stored in post-order, so children are always evaluated before their parents.
+  std::vector<std::unique_ptr<Node>> nodes_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
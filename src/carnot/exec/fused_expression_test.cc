@@ -0,0 +1,204 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression.h"
+
+#include <arrow/memory_pool.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using types::ToArrow;
+using udf::FunctionContext;
+
+class AddUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+class DivideUDF : public udf::ScalarUDF {
+ public:
+  types::Float64Value Exec(FunctionContext*, types::Int64Value v1, types::Float64Value v2) {
+    return v1.val / v2.val;
+  }
+};
+
+class GreaterThanUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::Float64Value v1, types::Float64Value v2) {
+    return v1.val > v2.val;
+  }
+};
+
+class ConcatUDF : public udf::ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue v1, types::StringValue v2) {
+    return v1 + v2;
+  }
+};
+
+// greaterThan(divide(add(col0, 1), col1), 1.5)
+constexpr char kNestedArithmeticPbtxt[] = R"(
+func {
+  name: "greaterThan"
+  id: 2
+  args {
+    func {
+      name: "divide"
+      id: 1
+      args {
+        func {
+          name: "add"
+          id: 0
+          args {
+            column {
+              node: 0
+              index: 0
+            }
+          }
+          args {
+            constant {
+              data_type: INT64
+              int64_value: 1
+            }
+          }
+        }
+      }
+      args {
+        column {
+          node: 0
+          index: 1
+        }
+      }
+    }
+  }
+  args {
+    constant {
+      data_type: FLOAT64
+      float64_value: 1.5
+    }
+  }
+})";
+
+constexpr char kConcatPbtxt[] = R"(
+func {
+  name: "concat"
+  id: 3
+  args {
+    column {
+      node: 0
+      index: 2
+    }
+  }
+  args {
+    column {
+      node: 0
+      index: 2
+    }
+  }
+})";
+
+class FusedScalarExpressionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    EXPECT_OK(func_registry_->Register<AddUDF>("add"));
+    EXPECT_OK(func_registry_->Register<DivideUDF>("divide"));
+    EXPECT_OK(func_registry_->Register<GreaterThanUDF>("greaterThan"));
+    EXPECT_OK(func_registry_->Register<ConcatUDF>("concat"));
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+    EXPECT_OK(exec_state_->AddScalarUDF(0, "add", {types::INT64, types::INT64}));
+    EXPECT_OK(exec_state_->AddScalarUDF(1, "divide", {types::INT64, types::FLOAT64}));
+    EXPECT_OK(exec_state_->AddScalarUDF(2, "greaterThan", {types::FLOAT64, types::FLOAT64}));
+    EXPECT_OK(exec_state_->AddScalarUDF(3, "concat", {types::STRING, types::STRING}));
+  }
+
+  std::shared_ptr<plan::ScalarExpression> ScalarExpressionOf(const std::string& pbtxt) {
+    planpb::ScalarExpression se_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(pbtxt, &se_pb));
+    auto s_or_se = plan::ScalarExpression::FromProto(se_pb);
+    EXPECT_OK(s_or_se);
+    return s_or_se.ConsumeValueOrDie();
+  }
+
+  std::unique_ptr<udf::Registry> func_registry_;
+  std::unique_ptr<ExecState> exec_state_;
+  RowDescriptor rd_{{types::INT64, types::FLOAT64, types::STRING}};
+};
+
+TEST_F(FusedScalarExpressionTest, nested_arithmetic_across_blocks) {
+  // Enough rows to span several blocks, with a partial block at the end.
+  int64_t num_rows = 2500;
+  std::vector<types::Int64Value> in1;
+  std::vector<types::Float64Value> in2;
+  std::vector<types::StringValue> in3;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    in1.emplace_back(i);
+    in2.emplace_back(i % 2 == 0 ? 1.0 : 4.0);
+    in3.emplace_back("a");
+  }
+  RowBatch rb(rd_, num_rows);
+  EXPECT_OK(rb.AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(ToArrow(in3, arrow::default_memory_pool())));
+
+  auto expr = ScalarExpressionOf(kNestedArithmeticPbtxt);
+  auto fused = FusedScalarExpression::Compile(exec_state_.get(), *expr, rd_);
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ(types::BOOLEAN, fused->data_type());
+
+  auto output = fused->Evaluate(rb);
+  ASSERT_EQ(static_cast<size_t>(num_rows), output->Size());
+  auto* bool_output = static_cast<types::BoolValueColumnWrapper*>(output.get());
+  for (int64_t i = 0; i < num_rows; ++i) {
+    EXPECT_EQ((i + 1) / in2[i].val > 1.5, (*bool_output)[i].val) << i;
+  }
+}
+
+TEST_F(FusedScalarExpressionTest, unsupported_types_are_not_fused) {
+  auto expr = ScalarExpressionOf(kConcatPbtxt);
+  EXPECT_EQ(nullptr, FusedScalarExpression::Compile(exec_state_.get(), *expr, rd_));
+
+  // The UDF argument types have to match the input types.
+  RowDescriptor float_rd({types::FLOAT64, types::FLOAT64, types::STRING});
+  auto arithmetic_expr = ScalarExpressionOf(kNestedArithmeticPbtxt);
+  EXPECT_EQ(nullptr, FusedScalarExpression::Compile(exec_state_.get(), *arithmetic_expr, float_rd));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -19,22 +19,89 @@
 #include "src/carnot/exec/grpc_router.h"
 
 #include <algorithm>
+#include <chrono>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <absl/base/internal/spinlock.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 #include <grpcpp/grpcpp.h>
+#include <prometheus/counter.h>
+#include <prometheus/gauge.h>
 
 #include "src/carnot/exec/grpc_source_node.h"
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/uuid/uuid.h"
 
+DEFINE_int32(carnot_grpc_router_max_queued_batches,
+             gflags::Int32FromEnv("PL_CARNOT_GRPC_ROUTER_MAX_QUEUED_BATCHES", 64),
+             "The number of row batches a GRPC source can have queued before the router stops "
+             "reading from the sink's stream, which pushes back on the sender through gRPC flow "
+             "control. 0 disables the limit.");
+DEFINE_int64(carnot_grpc_router_query_queue_budget_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_GRPC_ROUTER_QUERY_QUEUE_BUDGET_BYTES",
+                                  256 * 1024 * 1024),
+             "The bytes of row batches a single query can have queued in its GRPC sources before "
+             "the router stops reading the query's result streams. 0 disables the budget.");
+DEFINE_int64(carnot_grpc_router_queue_budget_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_GRPC_ROUTER_QUEUE_BUDGET_BYTES", 1024 * 1024 * 1024),
+             "The bytes of row batches all queries can have queued in their GRPC sources before "
+             "the router stops reading result streams. 0 disables the budget.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
+constexpr std::chrono::milliseconds kQueueSpacePollInterval{1};
+
+GRPCRouter::GRPCRouter()
+    : queued_bytes_gauge_(prometheus::BuildGauge()
+                              .Name("grpc_router_queued_bytes")
+                              .Help("Bytes of row batches not consumed by GRPC sources yet")
+                              .Register(GetMetricsRegistry())
+                              .Add({})),
+      queued_batches_gauge_(prometheus::BuildGauge()
+                                .Name("grpc_router_queued_batches")
+                                .Help("Row batches not consumed by GRPC sources yet")
+                                .Register(GetMetricsRegistry())
+                                .Add({})),
+      flow_control_pauses_counter_(
+          prometheus::BuildCounter()
+              .Name("grpc_router_flow_control_pauses")
+              .Help("Number of times a result stream stopped being read to push back on its sender")
+              .Register(GetMetricsRegistry())
+              .Add({})),
+      queued_batch_gauges_hook_([this]() {
+        queued_bytes_gauge_.Set(queued_batch_totals_.bytes);
+        queued_batches_gauge_.Set(queued_batch_totals_.batches);
+      }) {}
+
+GRPCRouter::QueryTrackerShard* GRPCRouter::ShardForQuery(const sole::uuid& query_id) {
+  // Query IDs are random, so their bits spread the queries evenly across the shards.
+  return &query_tracker_shards_[(query_id.ab ^ query_id.cd) % kNumQueryTrackerShards];
+}
+
+std::shared_ptr<GRPCRouter::QueryTracker> GRPCRouter::GetQueryTracker(const sole::uuid& query_id,
+                                                                      bool create) {
+  auto shard = ShardForQuery(query_id);
+  absl::base_internal::SpinLockHolder lock(&shard->lock);
+  auto it = shard->query_trackers.find(query_id);
+  if (it != shard->query_trackers.end()) {
+    return it->second;
+  }
+  if (!create) {
+    return nullptr;
+  }
+  auto query_tracker = std::make_shared<QueryTracker>(&queued_batch_totals_);
+  shard->query_trackers[query_id] = query_tracker;
+  return query_tracker;
+}
+
 GRPCRouter::SourceNodeTracker* GRPCRouter::GetSourceNodeTracker(QueryTracker* query_tracker,
                                                                 int64_t source_id) {
   absl::base_internal::SpinLockHolder query_lock(&query_tracker->query_lock);
@@ -43,7 +110,8 @@ GRPCRouter::SourceNodeTracker* GRPCRouter::GetSourceNodeTracker(QueryTracker* qu
 
 Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
                                    std::unique_ptr<carnotpb::TransferResultChunkRequest> req) {
-  if (!req->has_query_result() || !req->query_result().has_row_batch() ||
+  if (!req->has_query_result() ||
+      !(req->query_result().has_row_batch() || req->query_result().has_columnar_row_batch()) ||
       req->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
     return error::Internal(
@@ -57,6 +125,7 @@ Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
     // It's possible that we see row batches before we have gotten information about the query. To
     // solve this race, We store a backlog of all the pending batches.
     if (snt->source_node == nullptr) {
+      query_tracker->queued_batches->Add(req->ByteSizeLong());
       snt->response_backlog.emplace_back(std::move(req));
       return Status::OK();
     }
@@ -66,6 +135,62 @@ Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
   return Status::OK();
 }
 
+bool GRPCRouter::HasQueueSpace(QueryTracker* query_tracker, int64_t source_id) {
+  size_t max_queued_batches = FLAGS_carnot_grpc_router_max_queued_batches;
+  int64_t query_budget_bytes = FLAGS_carnot_grpc_router_query_queue_budget_bytes;
+  int64_t router_budget_bytes = FLAGS_carnot_grpc_router_queue_budget_bytes;
+  absl::base_internal::SpinLockHolder query_lock(&query_tracker->query_lock);
+  auto it = query_tracker->source_node_trackers.find(source_id);
+  if (it == query_tracker->source_node_trackers.end()) {
+    return true;
+  }
+  absl::base_internal::SpinLockHolder snt_lock(&it->second.node_lock);
+  // Batches that arrive before the source node keep going to the backlog, since nothing
+  // would drain them while we wait. A stopped source won't drain its queue either.
+  if (it->second.source_node == nullptr || it->second.stopped) {
+    return true;
+  }
+  // Only streams whose own source has batches waiting are paused. The query might need the
+  // input of a source that has drained its queue to make progress, like the build side of a
+  // join, and pausing it could stall the query while it holds the budget.
+  size_t queued_batches = it->second.source_node->NumQueuedBatches();
+  if (queued_batches == 0) {
+    return true;
+  }
+  int64_t query_bytes = query_tracker->queued_batches->bytes();
+  int64_t router_bytes = queued_batch_totals_.bytes;
+  bool over_budget = (max_queued_batches > 0 && queued_batches >= max_queued_batches) ||
+                     (query_budget_bytes > 0 && query_bytes >= query_budget_bytes) ||
+                     (router_budget_bytes > 0 && router_bytes >= router_budget_bytes);
+  return !over_budget;
+}
+
+void GRPCRouter::WaitForQueueSpace(QueryTracker* query_tracker, int64_t source_id,
+                                   ::grpc::ServerContext* context) {
+  bool paused = false;
+  // Deleting the query cancels the context, which ends the wait.
+  while (!context->IsCancelled()) {
+    if (HasQueueSpace(query_tracker, source_id)) {
+      return;
+    }
+    if (!paused) {
+      flow_control_pauses_counter_.Increment();
+      paused = true;
+    }
+    std::this_thread::sleep_for(kQueueSpacePollInterval);
+  }
+}
+
+bool GRPCRouter::IsSourceStopped(QueryTracker* query_tracker, int64_t source_id) {
+  absl::base_internal::SpinLockHolder query_lock(&query_tracker->query_lock);
+  auto it = query_tracker->source_node_trackers.find(source_id);
+  if (it == query_tracker->source_node_trackers.end()) {
+    return false;
+  }
+  absl::base_internal::SpinLockHolder snt_lock(&it->second.node_lock);
+  return it->second.stopped;
+}
+
 Status GRPCRouter::MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id) {
   auto snt = GetSourceNodeTracker(query_tracker, source_id);
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
@@ -132,24 +257,19 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
 
   ::grpc::Status result_status = ::grpc::Status::OK;
   bool registered_server_context = false;
+  bool source_stopped = false;
   std::shared_ptr<QueryTracker> query_tracker;
 
   while (reader->Read(rb.get())) {
     query_id = px::ParseUUID(rb->query_id()).ConsumeValueOrDie();
-    {
-      absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-      if (!query_node_map_.contains(query_id)) {
-        // If its an initiate_result_stream request then we can create a new QueryTracker.
-        // Otherwise, we return an error since this is likely after the QueryTracker was deleted.
-        if (rb->has_query_result() && rb->query_result().initiate_result_stream()) {
-          query_node_map_[query_id] = std::make_shared<QueryTracker>();
-        } else {
-          result_status = ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                                         "Attempting to TransferResultChunk for finished query.");
-          break;
-        }
-      }
-      query_tracker = query_node_map_[query_id];
+    // If its an initiate_result_stream request then we can create a new QueryTracker.
+    // Otherwise, we return an error since this is likely after the QueryTracker was deleted.
+    query_tracker = GetQueryTracker(
+        query_id, rb->has_query_result() && rb->query_result().initiate_result_stream());
+    if (query_tracker == nullptr) {
+      result_status = ::grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                     "Attempting to TransferResultChunk for finished query.");
+      break;
     }
 
     if (!registered_server_context) {
@@ -169,12 +289,22 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
                            absl::Substitute("Failed to record stats w/ err: $0", s.msg()));
         break;
       }
-    } else if (rb->has_query_result() && rb->query_result().has_row_batch()) {
+    } else if (rb->has_query_result() && (rb->query_result().has_row_batch() ||
+                                          rb->query_result().has_columnar_row_batch())) {
+      int64_t grpc_source_id = rb->query_result().grpc_source_id();
+      // Closing the stream of a stopped source tells the sink to stop sending it results.
+      if (IsSourceStopped(query_tracker.get(), grpc_source_id)) {
+        source_stopped = true;
+        break;
+      }
       auto s = EnqueueRowBatch(query_tracker.get(), std::move(rb));
       if (!s.ok()) {
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, "failed to enqueue batch");
         break;
       }
+      // Not reading the next request until the source catches up applies gRPC's flow control
+      // window to the sender.
+      WaitForQueueSpace(query_tracker.get(), grpc_source_id, context);
     } else if (rb->has_query_result() && rb->query_result().initiate_result_stream()) {
       if (rb->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
@@ -215,6 +345,13 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
     return ::grpc::Status::OK;
   }
 
+  if (source_stopped) {
+    MarkResultStreamContextAsComplete(query_tracker.get(), context);
+    response->set_success(true);
+    response->set_source_stopped(true);
+    return ::grpc::Status::OK;
+  }
+
   if (stream_has_query_results) {
     auto s = MarkResultStreamClosed(query_tracker.get(), source_node_id);
     if (!s.ok()) {
@@ -228,14 +365,159 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
   return ::grpc::Status::OK;
 }
 
+void GRPCRouter::MuxStreamWriter::Send(const carnotpb::ResultStreamUpdate& update) {
+  absl::MutexLock lock(&lock_);
+  if (stream_ != nullptr) {
+    stream_->Write(update);
+  }
+}
+
+void GRPCRouter::MuxStreamWriter::Detach() {
+  absl::MutexLock lock(&lock_);
+  stream_ = nullptr;
+}
+
+namespace {
+
+carnotpb::ResultStreamUpdate MakeResultStreamUpdate(const sole::uuid& query_id,
+                                                    int64_t source_id) {
+  carnotpb::ResultStreamUpdate update;
+  ToProto(query_id, update.mutable_query_id());
+  update.set_grpc_source_id(source_id);
+  return update;
+}
+
+}  // namespace
+
+// Unlike a dedicated result stream, the multiplexed stream isn't registered with the queries it
+// carries: deleting one of them mustn't cancel the results of the others. It isn't needed either,
+// the reads of a multiplexed stream never wait for a source, the result streams are paused instead.
+::grpc::Status GRPCRouter::TransferResultChunks(::grpc::ServerContext* /* context */,
+                                                MuxStream* stream) {
+  auto writer = std::make_shared<MuxStreamWriter>(stream);
+  // The result streams that were initiated and haven't been closed yet.
+  absl::flat_hash_map<std::pair<sole::uuid, int64_t>, std::shared_ptr<QueryTracker>> open_streams;
+
+  auto req = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  while (stream->Read(req.get())) {
+    auto query_id = px::ParseUUID(req->query_id()).ConsumeValueOr(sole::uuid());
+    int64_t source_id = req->query_result().grpc_source_id();
+    std::pair<sole::uuid, int64_t> key{query_id, source_id};
+    bool initiate = req->has_query_result() && req->query_result().initiate_result_stream();
+    auto query_tracker = GetQueryTracker(query_id, initiate);
+
+    if (req->has_execution_and_timing_info()) {
+      std::vector<queryresultspb::AgentExecutionStats> stats(
+          req->execution_and_timing_info().agent_execution_stats().begin(),
+          req->execution_and_timing_info().agent_execution_stats().end());
+      auto s = RecordStats(query_id, stats);
+      if (!s.ok()) {
+        LOG(ERROR) << "Failed to record stats from a multiplexed stream: " << s.msg();
+      }
+    } else if (req->query_result().destination_case() !=
+               carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
+      auto update = MakeResultStreamUpdate(query_id, source_id);
+      update.set_error("expected result stream to have grpc source ID");
+      writer->Send(update);
+    } else if (query_tracker == nullptr) {
+      // The query is done, so the source doesn't need the results anymore.
+      auto update = MakeResultStreamUpdate(query_id, source_id);
+      update.set_source_stopped(true);
+      writer->Send(update);
+    } else if (initiate) {
+      auto s = MarkResultStreamInitiated(query_tracker.get(), source_id);
+      if (!s.ok()) {
+        auto update = MakeResultStreamUpdate(query_id, source_id);
+        update.set_error(std::string(s.msg()));
+        writer->Send(update);
+      } else {
+        open_streams[key] = query_tracker;
+      }
+    } else if (req->query_result().close_result_stream()) {
+      if (open_streams.erase(key) > 0) {
+        ECHECK_OK(MarkResultStreamClosed(query_tracker.get(), source_id));
+      }
+    } else if (IsSourceStopped(query_tracker.get(), source_id)) {
+      // A stopped result stream isn't closed by the sink, like a dedicated stream closed by us.
+      open_streams.erase(key);
+      auto update = MakeResultStreamUpdate(query_id, source_id);
+      update.set_source_stopped(true);
+      writer->Send(update);
+    } else {
+      auto s = EnqueueRowBatch(query_tracker.get(), std::move(req));
+      if (!s.ok()) {
+        auto update = MakeResultStreamUpdate(query_id, source_id);
+        update.set_error(std::string(s.msg()));
+        writer->Send(update);
+      } else if (!HasQueueSpace(query_tracker.get(), source_id)) {
+        auto update = MakeResultStreamUpdate(query_id, source_id);
+        update.set_paused(true);
+        writer->Send(update);
+        PauseMuxStream({writer, query_tracker, query_id, source_id});
+      }
+    }
+    req = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  }
+  writer->Detach();
+
+  // The result streams that weren't closed lost their connection, as if their dedicated streams
+  // had ended.
+  for (const auto& [key, query_tracker] : open_streams) {
+    auto s = MarkResultStreamClosed(query_tracker.get(), key.second);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to close the result stream of a multiplexed stream: " << s.msg();
+    }
+  }
+  return ::grpc::Status::OK;
+}
+
+void GRPCRouter::PauseMuxStream(PausedMuxStream paused) {
+  flow_control_pauses_counter_.Increment();
+  absl::MutexLock lock(&paused_mux_streams_lock_);
+  PausedMuxStreamKey key{paused.writer.get(), paused.query_id, paused.source_id};
+  paused_mux_streams_.try_emplace(key, std::move(paused));
+  if (!resume_mux_streams_thread_.joinable()) {
+    resume_mux_streams_thread_ = std::thread(&GRPCRouter::ResumeMuxStreams, this);
+  }
+}
+
+void GRPCRouter::ResumeMuxStreams() {
+  absl::MutexLock lock(&paused_mux_streams_lock_);
+  while (!stop_resuming_mux_streams_) {
+    paused_mux_streams_lock_.AwaitWithTimeout(
+        absl::Condition(&stop_resuming_mux_streams_),
+        absl::FromChrono(paused_mux_streams_.empty() ? std::chrono::milliseconds(100)
+                                                     : kQueueSpacePollInterval));
+    for (auto it = paused_mux_streams_.begin(); it != paused_mux_streams_.end();) {
+      auto& paused = it->second;
+      if (!HasQueueSpace(paused.query_tracker.get(), paused.source_id)) {
+        ++it;
+        continue;
+      }
+      paused.writer->Send(MakeResultStreamUpdate(paused.query_id, paused.source_id));
+      paused_mux_streams_.erase(it++);
+    }
+  }
+}
+
+GRPCRouter::~GRPCRouter() {
+  std::thread resume_thread;
+  {
+    absl::MutexLock lock(&paused_mux_streams_lock_);
+    stop_resuming_mux_streams_ = true;
+    resume_thread = std::move(resume_mux_streams_thread_);
+  }
+  if (resume_thread.joinable()) {
+    resume_thread.join();
+  }
+}
+
 Status GRPCRouter::RecordStats(const sole::uuid& query_id,
                                const std::vector<queryresultspb::AgentExecutionStats>& stats) {
-  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-  auto it = query_node_map_.find(query_id);
-  if (it == query_node_map_.end()) {
+  auto tracker = GetQueryTracker(query_id, /* create */ false);
+  if (tracker == nullptr) {
     return error::Internal("No query ID $0 found in the GRPCRouter", query_id.str());
   }
-  auto tracker = it->second;
   absl::base_internal::SpinLockHolder query_lock(&tracker->query_lock);
   for (const auto& agent : stats) {
     auto agent_id = px::ParseUUID(agent.agent_id()).ConsumeValueOrDie();
@@ -250,15 +532,12 @@ Status GRPCRouter::RecordStats(const sole::uuid& query_id,
 
 Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
                                      GRPCSourceNode* source_node,
-                                     std::function<void()> restart_execution) {
+                                     std::function<void()> restart_execution,
+                                     std::shared_ptr<MemoryTracker> memory_tracker) {
   // We need to check and see if there is backlog data, if so flush it from the vector.
-  std::shared_ptr<QueryTracker> query_tracker;
-  {
-    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-    if (!query_node_map_.contains(query_id)) {
-      query_node_map_[query_id] = std::make_shared<QueryTracker>();
-    }
-    query_tracker = query_node_map_[query_id];
+  auto query_tracker = GetQueryTracker(query_id, /* create */ true);
+  if (memory_tracker != nullptr) {
+    query_tracker->queued_batches->set_memory_tracker(std::move(memory_tracker));
   }
 
   {
@@ -269,11 +548,14 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
 
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
   snt->source_node = source_node;
+  source_node->set_queued_batch_tracker(query_tracker->queued_batches);
   if (snt->connection_initiated_by_sink) {
     source_node->set_upstream_initiated_connection();
   }
   if (snt->response_backlog.size() > 0) {
     for (auto& rb : snt->response_backlog) {
+      // The source node counts the batch again once it's in its queue.
+      query_tracker->queued_batches->Remove(rb->ByteSizeLong());
       PL_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(rb)));
     }
     snt->response_backlog.clear();
@@ -285,16 +567,29 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
   return Status::OK();
 }
 
+void GRPCRouter::StopGRPCSource(sole::uuid query_id, int64_t source_id) {
+  auto query_tracker = GetQueryTracker(query_id, /* create */ false);
+  if (query_tracker == nullptr) {
+    return;
+  }
+  absl::base_internal::SpinLockHolder query_lock(&query_tracker->query_lock);
+  auto it = query_tracker->source_node_trackers.find(source_id);
+  if (it == query_tracker->source_node_trackers.end()) {
+    return;
+  }
+  absl::base_internal::SpinLockHolder snt_lock(&it->second.node_lock);
+  it->second.stopped = true;
+  for (const auto& rb : it->second.response_backlog) {
+    query_tracker->queued_batches->Remove(rb->ByteSizeLong());
+  }
+  it->second.response_backlog.clear();
+}
+
 StatusOr<std::vector<queryresultspb::AgentExecutionStats>> GRPCRouter::GetIncomingWorkerExecStats(
     const sole::uuid& query_id, const std::vector<uuidpb::UUID>& expected_agent_ids) {
-  std::shared_ptr<QueryTracker> query_tracker;
-  {
-    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-    auto it = query_node_map_.find(query_id);
-    if (it == query_node_map_.end()) {
-      return error::Internal("No query ID $0 found in the GRPCRouter", query_id.str());
-    }
-    query_tracker = it->second;
+  auto query_tracker = GetQueryTracker(query_id, /* create */ false);
+  if (query_tracker == nullptr) {
+    return error::Internal("No query ID $0 found in the GRPCRouter", query_id.str());
   }
 
   std::vector<queryresultspb::AgentExecutionStats> agent_exec_stats;
@@ -310,14 +605,10 @@ StatusOr<std::vector<queryresultspb::AgentExecutionStats>> GRPCRouter::GetIncomi
 }
 
 Status GRPCRouter::DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id) {
-  std::shared_ptr<QueryTracker> query_tracker;
-  {
-    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-    if (!query_node_map_.contains(query_id)) {
-      return error::Internal("Query map does not contain query ID $0 when deleting GRPC source $1",
-                             query_id.str(), source_id);
-    }
-    query_tracker = query_node_map_[query_id];
+  auto query_tracker = GetQueryTracker(query_id, /* create */ false);
+  if (query_tracker == nullptr) {
+    return error::Internal("Query map does not contain query ID $0 when deleting GRPC source $1",
+                           query_id.str(), source_id);
   }
 
   absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
@@ -334,15 +625,16 @@ void GRPCRouter::DeleteQuery(sole::uuid query_id) {
   VLOG(1) << "Deleting query ID from GRPC Router: " << query_id.str();
   std::shared_ptr<QueryTracker> query_tracker;
   {
-    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-    auto it = query_node_map_.find(query_id);
-    if (it == query_node_map_.end()) {
+    auto shard = ShardForQuery(query_id);
+    absl::base_internal::SpinLockHolder lock(&shard->lock);
+    auto it = shard->query_trackers.find(query_id);
+    if (it == shard->query_trackers.end()) {
       VLOG(1) << "No such query when deleting: " << query_id.str()
               << "(this is expected if no grpc sources are present)";
       return;
     }
     query_tracker = it->second;
-    query_node_map_.erase(it);
+    shard->query_trackers.erase(it);
   }
   absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
   query_tracker->ResetRestartExecutionFunc();
@@ -353,8 +645,12 @@ void GRPCRouter::DeleteQuery(sole::uuid query_id) {
 }
 
 size_t GRPCRouter::NumQueriesTracking() const {
-  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-  return query_node_map_.size();
+  size_t num_queries = 0;
+  for (const auto& shard : query_tracker_shards_) {
+    absl::base_internal::SpinLockHolder lock(&shard.lock);
+    num_queries += shard.query_trackers.size();
+  }
+  return num_queries;
 }
 
 }  // namespace exec
@@ -19,9 +19,13 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
 #include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
@@ -30,14 +34,23 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/container/node_hash_map.h>
 #include <absl/hash/hash.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
+#include <prometheus/counter.h>
+#include <prometheus/gauge.h>
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/queued_batch_tracker.h"
 #include "src/common/base/base.h"
+#include "src/common/metrics/sharded_metrics.h"
 #include "src/common/uuid/uuid.h"
 
+DECLARE_int32(carnot_grpc_router_max_queued_batches);
+DECLARE_int64(carnot_grpc_router_query_queue_budget_bytes);
+DECLARE_int64(carnot_grpc_router_queue_budget_bytes);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -51,6 +64,9 @@ class GRPCSourceNode;
  */
 class GRPCRouter final : public carnotpb::ResultSinkService::Service {
  public:
+  GRPCRouter();
+  ~GRPCRouter() override;
+
   /**
    * TransferResultChunk implements the RPC method.
    */
@@ -59,12 +75,20 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
       ::grpc::ServerReader<::px::carnotpb::TransferResultChunkRequest>* reader,
       ::px::carnotpb::TransferResultChunkResponse* response) override;
 
+  /**
+   * The service for the multiplexed result streams, which are routed like the dedicated ones. It
+   * is registered next to the router.
+   */
+  ::grpc::Service* mux_service() { return &mux_service_; }
+
   /**
    * Adds the specified source node to the router. Includes a function that should be called to
-   * retrigger execution of the graph if currently yielded.
+   * retrigger execution of the graph if currently yielded, and the memory tracker of the query
+   * to count its queued batches in, if any.
    */
   Status AddGRPCSourceNode(sole::uuid query_id, int64_t source_id, GRPCSourceNode* source_node,
-                           std::function<void()> restart_execution);
+                           std::function<void()> restart_execution,
+                           std::shared_ptr<MemoryTracker> memory_tracker = nullptr);
 
   /**
    * Delete all the metadata and backlog data for a query. Deleting a non-existing query is ignored.
@@ -79,6 +103,14 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
    */
   Status DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id);
 
+  /**
+   * Marks a source node of a query as no longer needing data, because a downstream limit was
+   * reached. Batches that arrive for it afterwards are dropped, and its result streams are closed
+   * with source_stopped set on their next request, so that the remote sinks stop producing them.
+   * Stopping a source that isn't tracked is ignored.
+   */
+  void StopGRPCSource(sole::uuid query_id, int64_t source_id);
+
   /**
    * @brief Get the Exec stats from the agents that are clients to this GRPC and the query_id.
    *
@@ -114,6 +146,7 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     GRPCSourceNode* source_node GUARDED_BY(node_lock) = nullptr;
     bool connection_initiated_by_sink GUARDED_BY(node_lock) = false;
     bool connection_closed_by_sink GUARDED_BY(node_lock) = false;
+    bool stopped GUARDED_BY(node_lock) = false;
     std::vector<std::unique_ptr<::px::carnotpb::TransferResultChunkRequest>> response_backlog
         GUARDED_BY(node_lock);
     absl::base_internal::SpinLock node_lock;
@@ -123,7 +156,9 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
    * Query tracker tracks execution of a single query.
    */
   struct QueryTracker {
-    QueryTracker() : create_time(std::chrono::steady_clock::now()) {}
+    explicit QueryTracker(QueuedBatchTotals* router_totals)
+        : create_time(std::chrono::steady_clock::now()),
+          queued_batches(std::make_shared<QueuedBatchTracker>(router_totals)) {}
     absl::node_hash_map<int64_t, SourceNodeTracker> source_node_trackers GUARDED_BY(query_lock);
     const std::chrono::steady_clock::time_point create_time GUARDED_BY(query_lock);
     std::function<void()> restart_execution_func_ GUARDED_BY(query_lock);
@@ -132,6 +167,8 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     absl::flat_hash_set<::grpc::ServerContext*> active_agent_contexts GUARDED_BY(query_lock);
     // The execution stats for agents that are clients to this service.
     std::vector<queryresultspb::AgentExecutionStats> agent_exec_stats GUARDED_BY(query_lock);
+    // The row batches of the query that haven't been consumed yet, shared with its source nodes.
+    const std::shared_ptr<QueuedBatchTracker> queued_batches;
     absl::base_internal::SpinLock query_lock;
 
     void ResetRestartExecutionFunc() ABSL_EXCLUSIVE_LOCKS_REQUIRED(query_lock) {
@@ -151,9 +188,67 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     }
   };
 
+  using MuxStream = ::grpc::ServerReaderWriter<::px::carnotpb::ResultStreamUpdate,
+                                               ::px::carnotpb::TransferResultChunkRequest>;
+
+  /**
+   * MuxService implements the RPC of the multiplexed result streams on behalf of the router.
+   */
+  class MuxService final : public carnotpb::ResultStreamMuxService::Service {
+   public:
+    explicit MuxService(GRPCRouter* router) : router_(router) {}
+    ::grpc::Status TransferResultChunks(::grpc::ServerContext* context,
+                                        MuxStream* stream) override {
+      return router_->TransferResultChunks(context, stream);
+    }
+
+   private:
+    GRPCRouter* router_;
+  };
+
+  /**
+   * MuxStreamWriter sends the updates of a multiplexed stream, from the thread that reads it and
+   * from the thread that resumes paused result streams.
+   */
+  class MuxStreamWriter {
+   public:
+    explicit MuxStreamWriter(MuxStream* stream) : stream_(stream) {}
+    // Sends the update, unless the stream has ended.
+    void Send(const carnotpb::ResultStreamUpdate& update);
+    // Called when the RPC returns, after which the stream can't be used anymore.
+    void Detach();
+
+   private:
+    absl::Mutex lock_;
+    MuxStream* stream_ ABSL_GUARDED_BY(lock_);
+  };
+
+  // A result stream of a multiplexed stream that was paused, because its source had too many
+  // batches queued.
+  struct PausedMuxStream {
+    std::shared_ptr<MuxStreamWriter> writer;
+    std::shared_ptr<QueryTracker> query_tracker;
+    sole::uuid query_id;
+    int64_t source_id;
+  };
+  using PausedMuxStreamKey = std::tuple<const MuxStreamWriter*, sole::uuid, int64_t>;
+
+  ::grpc::Status TransferResultChunks(::grpc::ServerContext* context, MuxStream* stream);
+  void PauseMuxStream(PausedMuxStream paused);
+  // Resumes the paused result streams once their sources have space in their queues.
+  void ResumeMuxStreams();
+
   Status EnqueueRowBatch(QueryTracker* query_tracker,
                          std::unique_ptr<carnotpb::TransferResultChunkRequest> req);
 
+  // Whether the source node can take more batches, which is the case unless it already has too
+  // many queued, or the query as a whole or the router do.
+  bool HasQueueSpace(QueryTracker* query_tracker, int64_t source_id);
+  // Blocks while the source node already has too many batches queued, or until the stream is
+  // cancelled.
+  void WaitForQueueSpace(QueryTracker* query_tracker, int64_t source_id,
+                         ::grpc::ServerContext* context);
+  bool IsSourceStopped(QueryTracker* query_tracker, int64_t source_id);
   Status MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id);
   Status MarkResultStreamClosed(QueryTracker* query_tracker, int64_t source_id);
   void RegisterResultStreamContext(QueryTracker* query_tracker, ::grpc::ServerContext* context);
@@ -161,9 +256,39 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
                                          ::grpc::ServerContext* context);
   SourceNodeTracker* GetSourceNodeTracker(QueryTracker* query_tracker, int64_t source_id);
 
-  absl::node_hash_map<sole::uuid, std::shared_ptr<QueryTracker>> query_node_map_
-      GUARDED_BY(query_node_map_lock_);
-  mutable absl::base_internal::SpinLock query_node_map_lock_;
+  /**
+   * The query trackers are sharded by query ID, so that streams for different queries don't
+   * contend on a single lock.
+   */
+  struct QueryTrackerShard {
+    absl::node_hash_map<sole::uuid, std::shared_ptr<QueryTracker>> query_trackers
+        GUARDED_BY(lock);
+    mutable absl::base_internal::SpinLock lock;
+  };
+  static constexpr size_t kNumQueryTrackerShards = 64;
+
+  QueryTrackerShard* ShardForQuery(const sole::uuid& query_id);
+  // Returns the tracker of the query, or nullptr if there isn't one and `create` is false.
+  std::shared_ptr<QueryTracker> GetQueryTracker(const sole::uuid& query_id, bool create);
+
+  // The totals outlive the query trackers, which remove their batches from them when destroyed.
+  QueuedBatchTotals queued_batch_totals_;
+  prometheus::Gauge& queued_bytes_gauge_;
+  prometheus::Gauge& queued_batches_gauge_;
+  prometheus::Counter& flow_control_pauses_counter_;
+  // Sets the gauges from the totals when the metrics are collected, rather than on every update
+  // of the totals, which many threads do for every batch.
+  metrics::CollectHook queued_batch_gauges_hook_;
+
+  std::array<QueryTrackerShard, kNumQueryTrackerShards> query_tracker_shards_;
+
+  MuxService mux_service_{this};
+  absl::Mutex paused_mux_streams_lock_;
+  absl::flat_hash_map<PausedMuxStreamKey, PausedMuxStream> paused_mux_streams_
+      ABSL_GUARDED_BY(paused_mux_streams_lock_);
+  bool stop_resuming_mux_streams_ ABSL_GUARDED_BY(paused_mux_streams_lock_) = false;
+  // Started when the first result stream is paused.
+  std::thread resume_mux_streams_thread_ ABSL_GUARDED_BY(paused_mux_streams_lock_);
 };
 
 }  // namespace exec
@@ -19,6 +19,7 @@
 #include "src/carnot/exec/grpc_router.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <thread>
@@ -225,6 +226,67 @@ TEST_F(GRPCRouterTest, basic_router_test) {
   EXPECT_TRUE(source_node.upstream_closed_connection());
 }
 
+TEST_F(GRPCRouterTest, stopped_source_closes_stream) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+
+  std::atomic<int> num_continues{0};
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node,
+                                        [&] { num_continues++; }));
+
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  initiate_stream_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  initiate_stream_req.mutable_query_result()->set_initiate_result_stream(true);
+
+  auto rb = RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  carnotpb::TransferResultChunkRequest rb_req;
+  EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+  rb_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  query_id = rb_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+
+  px::carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  ASSERT_TRUE(writer->Write(initiate_stream_req));
+  ASSERT_TRUE(writer->Write(rb_req));
+  while (num_continues == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // A downstream limit was reached, so the next batch closes the stream instead of being queued.
+  service_->StopGRPCSource(query_uuid, grpc_source_node_id);
+  writer->Write(rb_req);
+  writer->WritesDone();
+  ASSERT_TRUE(writer->Finish().ok());
+
+  EXPECT_TRUE(response.success());
+  EXPECT_TRUE(response.source_stopped());
+  EXPECT_EQ(1, source_node.row_batches.size());
+  EXPECT_EQ(1, num_continues);
+  // The stream didn't end with an eos, but the source isn't waiting for one.
+  EXPECT_FALSE(source_node.upstream_closed_connection());
+
+  // Stopping sources that the router doesn't track is ignored.
+  service_->StopGRPCSource(query_uuid, /* source_id */ 123);
+  service_->StopGRPCSource(sole::uuid4(), grpc_source_node_id);
+}
+
 TEST_F(GRPCRouterTest, router_and_stats_test) {
   int64_t grpc_source_node_id = 1;
   uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
@@ -354,6 +416,32 @@ TEST_F(GRPCRouterTest, done_query_test) {
   service_->DeleteQuery(query_uuid);
 }
 
+TEST_F(GRPCRouterTest, many_queries_router_test) {
+  int64_t grpc_source_node_id = 1;
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::BOOLEAN});
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+
+  // The queries are spread over the shards of the router, which are all counted.
+  std::vector<sole::uuid> query_ids;
+  for (int i = 0; i < 200; ++i) {
+    query_ids.push_back(sole::uuid4());
+    ASSERT_OK(
+        service_->AddGRPCSourceNode(query_ids.back(), grpc_source_node_id, &source_node, [] {}));
+  }
+  EXPECT_EQ(200, service_->NumQueriesTracking());
+
+  for (const auto& query_id : query_ids) {
+    ASSERT_OK(service_->DeleteGRPCSourceNode(query_id, grpc_source_node_id));
+    service_->DeleteQuery(query_id);
+  }
+  EXPECT_EQ(0, service_->NumQueriesTracking());
+}
+
 // This test is a TSAN test. IT should be run enough times so that all possible
 // race conditions will be met.
 TEST_F(GRPCRouterTest, threaded_router_test) {
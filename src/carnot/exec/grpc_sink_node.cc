@@ -21,16 +21,38 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <absl/strings/substitute.h>
+#include <farmhash.h>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/macros.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_bool(carnot_grpc_sink_columnar_batches,
+            gflags::BoolFromEnv("PL_CARNOT_GRPC_SINK_COLUMNAR_BATCHES", false),
+            "Whether row batches sent to other Carnot instances use the columnar wire format, "
+            "which copies whole buffers instead of serializing each value.");
+DEFINE_int64(carnot_grpc_sink_coalesce_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_GRPC_SINK_COALESCE_BYTES", 0),
+             "Small row batches are buffered by GRPCSinkNode until they add up to this many bytes, "
+             "and then sent as a single request. 0 sends every batch as it arrives.");
+DEFINE_bool(carnot_grpc_sink_multiplex_streams,
+            gflags::BoolFromEnv("PL_CARNOT_GRPC_SINK_MULTIPLEX_STREAMS", false),
+            "Whether results sent to other Carnot instances share a long-lived stream per "
+            "destination, rather than each GRPC sink opening a stream of its own. The destination "
+            "must run a version that serves the multiplexed streams.");
+DEFINE_int32(carnot_grpc_sink_coalesce_max_latency_ms,
+             gflags::Int32FromEnv("PL_CARNOT_GRPC_SINK_COALESCE_MAX_LATENCY_MS", 100),
+             "The longest a buffered row batch waits in GRPCSinkNode after the previous send.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -45,6 +67,10 @@ std::string GRPCSinkNode::DebugStringImpl() {
   } else if (plan_node_->has_grpc_source_id()) {
     destination = absl::Substitute("source_id: $0", plan_node_->grpc_source_id());
   }
+  if (plan_node_->has_partition()) {
+    destination += absl::Substitute(", partition: $0/$1", plan_node_->partition().index(),
+                                    plan_node_->partition().num_partitions());
+  }
   return absl::Substitute("Exec::GRPCSinkNode: {address: $0, $1, output: $2}",
                           plan_node_->address(), destination, input_descriptor_->DebugString());
 }
@@ -68,11 +94,15 @@ StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(
 }
 
 Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
-  if (sent_eos_ || cancelled_) {
+  if (sent_eos_ || cancelled_ || downstream_stopped_) {
     return Status::OK();
   }
 
   auto time_now = std::chrono::system_clock::now();
+  // Batches that have been buffered for too long are sent, even while the input is quiet.
+  if (!pending_batches_.empty() && time_now - last_send_time_ >= coalesce_max_latency_) {
+    return FlushPendingBatches(exec_state, /* eow */ false, /* eos */ false);
+  }
   auto since_last_flush =
       std::chrono::duration_cast<std::chrono::milliseconds>(time_now - last_send_time_);
   bool recheck_connection = since_last_flush > connection_check_timeout_;
@@ -99,10 +129,31 @@ Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
   const auto* sink_plan_node = static_cast<const plan::GRPCSinkOperator*>(&plan_node);
   plan_node_ = std::make_unique<plan::GRPCSinkOperator>(*sink_plan_node);
+  coalesce_bytes_ = FLAGS_carnot_grpc_sink_coalesce_bytes;
+  coalesce_max_latency_ = std::chrono::milliseconds(FLAGS_carnot_grpc_sink_coalesce_max_latency_ms);
+
+  if (plan_node_->has_partition()) {
+    const auto& key_cols = plan_node_->partition().key_column_indices();
+    if (key_cols.empty()) {
+      return error::InvalidArgument("GRPCSink partition has no key columns");
+    }
+    for (int64_t col_idx : key_cols) {
+      if (col_idx < 0 || col_idx >= static_cast<int64_t>(input_descriptor_->size())) {
+        return error::InvalidArgument("GRPCSink partition key column $0 is out of range", col_idx);
+      }
+    }
+    partition_key_cols_.assign(key_cols.begin(), key_cols.end());
+  }
   return Status::OK();
 }
 
-Status GRPCSinkNode::PrepareImpl(ExecState*) { return Status::OK(); }
+Status GRPCSinkNode::PrepareImpl(ExecState* exec_state) {
+  // The stubs are created up front, since the GRPC sinks of a graph may be opened concurrently.
+  if (!UsesMux(exec_state)) {
+    stub_ = exec_state->ResultSinkServiceStub(plan_node_->address(), plan_node_->ssl_targetname());
+  }
+  return Status::OK();
+}
 
 Status GRPCSinkNode::StartConnection(ExecState* exec_state, bool send_initiate_req) {
   return StartConnectionWithRetries(exec_state, send_initiate_req, kGRPCRetries);
@@ -118,8 +169,31 @@ Status GRPCSinkNode::StartConnectionWithRetries(ExecState* exec_state, bool send
         plan_node_->id(), plan_node_->address(), exec_state->query_id().str());
   }
 
-  stub_ = exec_state->ResultSinkServiceStub(plan_node_->address(), plan_node_->ssl_targetname());
+  PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
+  if (send_initiate_req) {
+    req.mutable_query_result()->set_initiate_result_stream(true);
+  } else {
+    // If this is not the first connection we've made then we send a 0-row rb instead of an
+    // initiate_result_stream request.
+    PL_ASSIGN_OR_RETURN(
+        auto rb, RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
+    PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
+  }
 
+  if (UsesMux(exec_state)) {
+    auto mux = exec_state->result_stream_mux_pool()->Get(plan_node_->address(),
+                                                        plan_node_->ssl_targetname());
+    mux_stream_ = mux->Open(exec_state->query_id(), plan_node_->grpc_source_id());
+    if (!mux_stream_->Write(req).ok()) {
+      return StartConnectionWithRetries(exec_state, send_initiate_req, n_retries - 1);
+    }
+    last_send_time_ = std::chrono::system_clock::now();
+    return Status::OK();
+  }
+
+  if (stub_ == nullptr) {
+    stub_ = exec_state->ResultSinkServiceStub(plan_node_->address(), plan_node_->ssl_targetname());
+  }
   context_ = std::make_unique<grpc::ClientContext>();
   // When we are sending the results to an external service, such as the query broker,
   // add authentication to the client context.
@@ -131,17 +205,6 @@ Status GRPCSinkNode::StartConnectionWithRetries(ExecState* exec_state, bool send
   response_.Clear();
   writer_ = stub_->TransferResultChunk(context_.get(), &response_);
 
-  PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
-  if (send_initiate_req) {
-    req.mutable_query_result()->set_initiate_result_stream(true);
-  } else {
-    // If this is not the first connection we've made then we send a 0-row rb instead of an
-    // initiate_result_stream request.
-    PL_ASSIGN_OR_RETURN(
-        auto rb, RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
-    PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
-  }
-
   if (!writer_->Write(req)) {
     return StartConnectionWithRetries(exec_state, send_initiate_req, n_retries - 1);
   }
@@ -158,8 +221,44 @@ Status GRPCSinkNode::CancelledByServer(ExecState* exec_state) {
       plan_node_->id(), exec_state->query_id().str(), plan_node_->address());
 }
 
+bool GRPCSinkNode::UsesMux(ExecState* exec_state) const {
+  // Only other Carnot instances serve multiplexed streams.
+  return FLAGS_carnot_grpc_sink_multiplex_streams && plan_node_->has_grpc_source_id() &&
+         exec_state->result_stream_mux_pool() != nullptr;
+}
+
+Status GRPCSinkNode::TryWriteMuxRequest(ExecState* exec_state,
+                                        const carnotpb::TransferResultChunkRequest& req) {
+  auto s = mux_stream_->Write(req);
+  if (s.ok() && mux_stream_->stopped()) {
+    VLOG(1) << absl::Substitute("GRPCSinkNode $0 in query $1: destination stopped its results",
+                                plan_node_->id(), exec_state->query_id().str());
+    downstream_stopped_ = true;
+    mux_stream_.reset();
+    return Status::OK();
+  }
+  if (s.ok()) {
+    last_send_time_ = std::chrono::system_clock::now();
+    return Status::OK();
+  }
+  // The destination failed to take the results, rather than the connection failing.
+  if (s.code() != statuspb::RESOURCE_UNAVAILABLE) {
+    return CancelledByServer(exec_state);
+  }
+  // Otherwise the mux lost its connection, and the result stream continues on a new one.
+  PL_RETURN_IF_ERROR(StartConnection(exec_state, /* send_initiate_req */ false));
+  if (!mux_stream_->Write(req).ok()) {
+    return CancelledByServer(exec_state);
+  }
+  last_send_time_ = std::chrono::system_clock::now();
+  return Status::OK();
+}
+
 Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
                                      const carnotpb::TransferResultChunkRequest& req) {
+  if (mux_stream_ != nullptr) {
+    return TryWriteMuxRequest(exec_state, req);
+  }
   if (writer_->Write(req)) {
     last_send_time_ = std::chrono::system_clock::now();
     return Status::OK();
@@ -169,6 +268,13 @@ Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
   // connection just died.
   writer_->WritesDone();
   auto s = writer_->Finish();
+  if (s.ok() && response_.source_stopped()) {
+    VLOG(1) << absl::Substitute("GRPCSinkNode $0 in query $1: destination stopped its results",
+                                plan_node_->id(), exec_state->query_id().str());
+    downstream_stopped_ = true;
+    writer_.reset();
+    return Status::OK();
+  }
   // If the Finish call was successful, then the server closed the connection and sent a response,
   // in which case we shouldn't try to reconnect. If there's an error from the server side
   // other than a RST_STREAM, we also shouldn't retry.
@@ -193,6 +299,11 @@ Status GRPCSinkNode::OpenImpl(ExecState* exec_state) {
 }
 
 Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
+  if (mux_stream_ != nullptr) {
+    mux_stream_->Close();
+    mux_stream_.reset();
+    return Status::OK();
+  }
   if (writer_ == nullptr) {
     return Status::OK();
   }
@@ -207,13 +318,16 @@ Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
 }
 
 Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
-  if (sent_eos_ || cancelled_) {
+  if (sent_eos_ || cancelled_ || downstream_stopped_) {
     return Status::OK();
   }
 
-  if (writer_ != nullptr) {
+  if (writer_ != nullptr || mux_stream_ != nullptr) {
     LOG(INFO) << absl::Substitute("Closing GRPCSinkNode $0 in query $1 before receiving EOS",
                                   plan_node_->id(), exec_state->query_id().str());
+    if (!pending_batches_.empty()) {
+      PL_RETURN_IF_ERROR(FlushPendingBatches(exec_state, /* eow */ false, /* eos */ false));
+    }
     PL_RETURN_IF_ERROR(CloseWriter(exec_state));
   }
 
@@ -309,21 +423,168 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
   return ConsumeNextImplNoSplit(exec_state, *output_rb, parent_idx);
 }
 
+template <types::DataType T>
+Status AppendSelectedValues(const RowBatch& rb, int64_t col_idx, arrow::ArrayBuilder* builder) {
+  auto input_col = rb.ColumnAt(col_idx).get();
+  for (int64_t idx = 0; idx < rb.num_selected_rows(); ++idx) {
+    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<T>(
+        builder, types::GetValueFromArrowArray<T>(input_col, rb.SelectedRowIndex(idx))));
+  }
+  return Status::OK();
+}
+
+// Concatenates the selected rows of the batches into a single batch.
+StatusOr<std::unique_ptr<RowBatch>> CoalesceBatches(const RowDescriptor& desc,
+                                                    const std::vector<RowBatch>& batches, bool eow,
+                                                    bool eos) {
+  int64_t num_rows = 0;
+  for (const auto& rb : batches) {
+    num_rows += rb.num_selected_rows();
+  }
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders(desc.size());
+  for (size_t col_idx = 0; col_idx < desc.size(); ++col_idx) {
+    builders[col_idx] = types::MakeArrowBuilder(desc.type(col_idx), arrow::default_memory_pool());
+    PL_RETURN_IF_ERROR(builders[col_idx]->Reserve(num_rows));
+    for (const auto& rb : batches) {
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendSelectedValues<_dt_>(rb, col_idx, builders[col_idx].get()));
+      PL_SWITCH_FOREACH_DATATYPE(desc.type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+  return RowBatch::FromColumnBuilders(desc, eow, eos, &builders);
+}
+
+Status GRPCSinkNode::FlushPendingBatches(ExecState* exec_state, bool eow, bool eos) {
+  std::vector<RowBatch> batches;
+  batches.swap(pending_batches_);
+  pending_bytes_ = 0;
+  if (batches.size() == 1) {
+    batches[0].set_eow(eow);
+    batches[0].set_eos(eos);
+    return SendBatch(exec_state, batches[0], /* parent_idx */ 0);
+  }
+  PL_ASSIGN_OR_RETURN(auto rb, CoalesceBatches(*input_descriptor_, batches, eow, eos));
+  return SendBatch(exec_state, *rb, /* parent_idx */ 0);
+}
+
+// Combines the hash of the key value of each selected row into its hash. The hash only depends on
+// the values, so that every Carnot instance that repartitions rows sends equal keys to the same
+// partition.
+template <types::DataType T>
+void HashKeyColumn(const RowBatch& rb, int64_t col_idx, std::vector<uint64_t>* hashes) {
+  auto col = rb.ColumnAt(col_idx).get();
+  for (int64_t idx = 0; idx < rb.num_selected_rows(); ++idx) {
+    auto val = types::GetValueFromArrowArray<T>(col, rb.SelectedRowIndex(idx));
+    uint64_t val_hash = ::util::Hash64(reinterpret_cast<const char*>(&val), sizeof(val));
+    (*hashes)[idx] = HashCombine((*hashes)[idx], val_hash);
+  }
+}
+
+template <>
+void HashKeyColumn<types::STRING>(const RowBatch& rb, int64_t col_idx,
+                                  std::vector<uint64_t>* hashes) {
+  auto col = static_cast<const arrow::StringArray*>(rb.ColumnAt(col_idx).get());
+  for (int64_t idx = 0; idx < rb.num_selected_rows(); ++idx) {
+    std::string_view val = col->GetView(rb.SelectedRowIndex(idx));
+    (*hashes)[idx] = HashCombine((*hashes)[idx], ::util::Hash64(val.data(), val.size()));
+  }
+}
+
+RowBatch GRPCSinkNode::SelectPartition(const RowBatch& rb) const {
+  std::vector<uint64_t> hashes(rb.num_selected_rows(), 0);
+  for (int64_t col_idx : partition_key_cols_) {
+#define TYPE_CASE(_dt_) HashKeyColumn<_dt_>(rb, col_idx, &hashes);
+    PL_SWITCH_FOREACH_DATATYPE(rb.desc().type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  const auto& partition = plan_node_->partition();
+  auto selection = std::make_shared<std::vector<int64_t>>();
+  for (const auto& [idx, hash] : Enumerate(hashes)) {
+    if (static_cast<int64_t>(hash % partition.num_partitions()) == partition.index()) {
+      selection->push_back(rb.SelectedRowIndex(idx));
+    }
+  }
+  RowBatch partition_rb = rb;
+  partition_rb.set_selection(std::move(selection));
+  return partition_rb;
+}
+
 Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
+  if (downstream_stopped_) {
+    return Status::OK();
+  }
+  if (partition_key_cols_.empty()) {
+    return BufferOrSendBatch(exec_state, rb, parent_idx);
+  }
+  RowBatch partition_rb = SelectPartition(rb);
+  // Batches without rows of the partition are only sent for their eow or eos.
+  if (partition_rb.num_selected_rows() == 0 && !rb.eow() && !rb.eos()) {
+    return Status::OK();
+  }
+  return BufferOrSendBatch(exec_state, partition_rb, parent_idx);
+}
+
+Status GRPCSinkNode::BufferOrSendBatch(ExecState* exec_state, const RowBatch& rb,
+                                       size_t parent_idx) {
+  if (coalesce_bytes_ <= 0) {
+    return SendBatch(exec_state, rb, parent_idx);
+  }
+
+  int64_t rb_bytes = rb.NumBytes();
+  // Batches that are big enough by themselves don't need to wait for more rows.
+  if (pending_batches_.empty() && rb_bytes >= coalesce_bytes_) {
+    return SendBatch(exec_state, rb, parent_idx);
+  }
+
+  pending_batches_.push_back(rb);
+  pending_bytes_ += rb_bytes;
+  // The end of a window or stream can't be held back, since the receiver waits for it.
+  if (rb.eow() || rb.eos() || pending_bytes_ >= coalesce_bytes_ ||
+      std::chrono::system_clock::now() - last_send_time_ >= coalesce_max_latency_) {
+    return FlushPendingBatches(exec_state, rb.eow(), rb.eos());
+  }
+  return Status::OK();
+}
+
+Status GRPCSinkNode::SendBatch(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
   if (rb.NumBytes() > (max_batch_size_ * batch_size_factor_)) {
-    return SplitAndSendBatch(exec_state, rb, parent_idx);
+    if (!rb.has_selection()) {
+      return SplitAndSendBatch(exec_state, rb, parent_idx);
+    }
+    // The batch is split on the underlying rows, so drop the unselected rows first.
+    PL_ASSIGN_OR_RETURN(auto compacted_rb, rb.CompactSelection());
+    return SendBatch(exec_state, *compacted_rb, parent_idx);
   }
   return ConsumeNextImplNoSplit(exec_state, rb, parent_idx);
 }
 
 Status GRPCSinkNode::ConsumeNextImplNoSplit(ExecState* exec_state, const RowBatch& rb, size_t) {
+  // The destination can stop the stream between the parts of a split batch.
+  if (downstream_stopped_) {
+    return Status::OK();
+  }
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
-  // Serialize the RowBatch.
-  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+  // Serialize the RowBatch. Only Carnot reads the columnar format, so results that go to the query
+  // broker are always sent as a RowBatchData.
+  {
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kSerialize, id());
+    if (FLAGS_carnot_grpc_sink_columnar_batches && plan_node_->has_grpc_source_id()) {
+      PL_RETURN_IF_ERROR(
+          rb.ToColumnarProto(req.mutable_query_result()->mutable_columnar_row_batch()));
+    } else {
+      PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+    }
+  }
 
-  PL_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
+  {
+    // Includes the time the write waits for the flow control of the stream.
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kGRPCSend, id());
+    PL_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
+  }
 
-  if (!rb.eos()) {
+  if (downstream_stopped_ || !rb.eos()) {
     return Status::OK();
   }
 
@@ -35,6 +35,11 @@
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 
+DECLARE_bool(carnot_grpc_sink_columnar_batches);
+DECLARE_int64(carnot_grpc_sink_coalesce_bytes);
+DECLARE_int32(carnot_grpc_sink_coalesce_max_latency_ms);
+DECLARE_bool(carnot_grpc_sink_multiplex_streams);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -58,9 +63,17 @@ class GRPCSinkNode : public SinkNode {
   GRPCSinkNode() : GRPCSinkNode(kMaxBatchSize, kBatchSizeFactor) {}
   virtual ~GRPCSinkNode() = default;
 
+  // Selected rows are serialized directly, unless the batch needs to be split.
+  bool SupportsSelection() const override { return true; }
+
   // Used to check the downstream connection after connection_check_timeout_ has elapsed.
   Status OptionallyCheckConnection(ExecState* exec_state);
 
+  // Whether the destination closed the stream because it doesn't need any more results, for
+  // example because a limit downstream of it was reached. The rest of the input is dropped, and
+  // the execution graph stops the sources that only feed stopped sinks.
+  bool downstream_stopped() const { return downstream_stopped_; }
+
   void testing_set_connection_check_timeout(const std::chrono::milliseconds& timeout) {
     connection_check_timeout_ = timeout;
   }
@@ -76,6 +89,16 @@ class GRPCSinkNode : public SinkNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  // Buffers the batch, or sends it with the buffered ones.
+  Status BufferOrSendBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                           size_t parent_index);
+  // Selects the rows of the batch that belong to the partition of this sink.
+  table_store::schema::RowBatch SelectPartition(const table_store::schema::RowBatch& rb) const;
+  // Sends the batch right away, splitting it if it's too big for one request.
+  Status SendBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                   size_t parent_index);
+  // Sends the buffered batches as a single batch with the given eow and eos.
+  Status FlushPendingBatches(ExecState* exec_state, bool eow, bool eos);
   Status ConsumeNextImplNoSplit(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                                 size_t parent_index);
   Status SplitAndSendBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb,
@@ -91,14 +114,21 @@ class GRPCSinkNode : public SinkNode {
                                     size_t n_retries);
   Status CancelledByServer(ExecState* exec_state);
   Status TryWriteRequest(ExecState* exec_state, const carnotpb::TransferResultChunkRequest& req);
+  // Whether the results are sent over a mux shared with other sinks.
+  bool UsesMux(ExecState* exec_state) const;
+  Status TryWriteMuxRequest(ExecState* exec_state,
+                            const carnotpb::TransferResultChunkRequest& req);
 
   bool cancelled_ = false;
+  bool downstream_stopped_ = false;
 
   std::unique_ptr<grpc::ClientContext> context_;
   carnotpb::TransferResultChunkResponse response_;
 
-  carnotpb::ResultSinkService::StubInterface* stub_;
+  carnotpb::ResultSinkService::StubInterface* stub_ = nullptr;
   std::unique_ptr<grpc::ClientWriterInterface<carnotpb::TransferResultChunkRequest>> writer_;
+  // Set instead of the writer when the results are sent over a mux.
+  std::shared_ptr<ResultStreamMux::ResultStream> mux_stream_;
 
   std::unique_ptr<plan::GRPCSinkOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
@@ -108,6 +138,16 @@ class GRPCSinkNode : public SinkNode {
 
   size_t max_batch_size_;
   float batch_size_factor_;
+
+  // Small batches are buffered until they add up to coalesce_bytes_, or until
+  // coalesce_max_latency_ has passed since the last send.
+  int64_t coalesce_bytes_ = 0;
+  std::chrono::milliseconds coalesce_max_latency_{0};
+  std::vector<table_store::schema::RowBatch> pending_batches_;
+  int64_t pending_bytes_ = 0;
+
+  // The key columns that rows are partitioned on, empty if the sink isn't a partition.
+  std::vector<int64_t> partition_key_cols_;
 };
 
 }  // namespace exec
@@ -16,9 +16,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <benchmark/benchmark.h>
 #include <grpcpp/test/mock_stream.h>
 #include <gtest/gtest.h>
@@ -101,3 +104,61 @@ void BM_GRPCSinkNodeSplitting(benchmark::State& state) {
 }
 
 BENCHMARK(BM_GRPCSinkNodeSplitting)->Unit(benchmark::kMillisecond);
+
+// Round trips a mixed type batch through the wire format that the sink uses when sending to
+// another Carnot instance. Arg 0 selects RowBatchData, arg 1 selects ColumnarRowBatchData.
+// NOLINTNEXTLINE : runtime/references.
+void BM_RowBatchWireFormat(benchmark::State& state) {
+  bool columnar = state.range(0);
+  auto num_rows = 64 * 1024;
+
+  RowDescriptor rd({DataType::TIME64NS, DataType::INT64, DataType::FLOAT64, DataType::BOOLEAN,
+                    DataType::STRING});
+  std::vector<px::types::Time64NSValue> times(num_rows);
+  std::vector<px::types::Int64Value> ints(num_rows);
+  std::vector<px::types::Float64Value> floats(num_rows);
+  std::vector<px::types::BoolValue> bools(num_rows);
+  std::vector<px::types::StringValue> strings(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    times[i] = i * 1000;
+    ints[i] = i;
+    floats[i] = i * 0.5;
+    bools[i] = i % 2 == 0;
+    strings[i] = absl::StrCat("/api/v1/service/", i % 128);
+  }
+  auto rb = px::carnot::exec::RowBatchBuilder(rd, num_rows, /*eow*/ true, /*eos*/ true)
+                .AddColumn<px::types::Time64NSValue>(times)
+                .AddColumn<px::types::Int64Value>(ints)
+                .AddColumn<px::types::Float64Value>(floats)
+                .AddColumn<px::types::BoolValue>(bools)
+                .AddColumn<px::types::StringValue>(strings)
+                .get();
+
+  size_t wire_bytes = 0;
+  for (auto _ : state) {
+    TransferResultChunkRequest req;
+    if (columnar) {
+      PL_CHECK_OK(rb.ToColumnarProto(req.mutable_query_result()->mutable_columnar_row_batch()));
+    } else {
+      PL_CHECK_OK(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+    }
+    std::string serialized = req.SerializeAsString();
+    wire_bytes = serialized.size();
+
+    TransferResultChunkRequest received;
+    CHECK(received.ParseFromString(serialized));
+    std::unique_ptr<RowBatch> output_rb;
+    if (columnar) {
+      output_rb = RowBatch::FromColumnarProto(
+                      received.mutable_query_result()->mutable_columnar_row_batch())
+                      .ConsumeValueOrDie();
+    } else {
+      output_rb = RowBatch::FromProto(received.query_result().row_batch()).ConsumeValueOrDie();
+    }
+    benchmark::DoNotOptimize(output_rb);
+  }
+  state.counters["wire_bytes"] = wire_bytes;
+  state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+BENCHMARK(BM_RowBatchWireFormat)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -18,9 +18,13 @@
 
 #include "src/carnot/exec/grpc_sink_node.h"
 
+#include <algorithm>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_cat.h>
 #include <grpcpp/test/mock_stream.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -436,6 +440,215 @@ TEST_F(GRPCSinkNodeTest, update_connection_time) {
   EXPECT_GT(after_flush_time, before_flush_time);
 }
 
+TEST_F(GRPCSinkNodeTest, coalesce_small_batches) {
+  FLAGS_carnot_grpc_sink_coalesce_bytes = 1024;
+  FLAGS_carnot_grpc_sink_coalesce_max_latency_ms = 60 * 1000;
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(2);
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  auto selected_rb = RowBatchBuilder(output_rd, 3, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>({1, 100, 2})
+                         .get();
+  selected_rb.set_selection(std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 2}));
+  tester.ConsumeNext(selected_rb, 5, 0);
+  tester.ConsumeNext(RowBatchBuilder(output_rd, 1, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>({3})
+                         .get(),
+                     5, 0);
+  // The end of the stream sends everything that was buffered as one batch.
+  tester.ConsumeNext(RowBatchBuilder(output_rd, 1, /*eow*/ true, /*eos*/ true)
+                         .AddColumn<types::Int64Value>({4})
+                         .get(),
+                     5, 0);
+  tester.Close();
+
+  EXPECT_THAT(actual_protos[1], EqualsProto(absl::Substitute(R"proto(
+address: "localhost:1234"
+query_id {
+  high_bits: $0
+  low_bits: $1
+}
+query_result {
+  row_batch {
+    cols {
+      int64_data {
+        data: 1
+        data: 2
+        data: 3
+        data: 4
+      }
+    }
+    num_rows: 4
+    eow: true
+    eos: true
+  }
+  grpc_source_id: 0
+})proto",
+                                                             exec_state_->query_id().ab,
+                                                             exec_state_->query_id().cd)));
+
+  FLAGS_carnot_grpc_sink_coalesce_bytes = 0;
+  FLAGS_carnot_grpc_sink_coalesce_max_latency_ms = 100;
+}
+
+// Runs the batches through a sink that keeps the given partition of their rows, partitioned on
+// the given key columns. Returns the values of the first column (an INT64) of the rows that were
+// sent, along with whether the end of the stream was sent.
+std::pair<std::vector<int64_t>, bool> SendPartition(udf::Registry* registry,
+                                                    const RowDescriptor& rd,
+                                                    const std::vector<int64_t>& key_cols,
+                                                    int64_t index,
+                                                    const std::vector<RowBatch>& batches) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto partition = op_proto.mutable_grpc_sink_op()->mutable_partition();
+  for (int64_t col : key_cols) {
+    partition->add_key_column_indices(col);
+  }
+  partition->set_index(index);
+  partition->set_num_partitions(2);
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  EXPECT_OK(plan_node->Init(op_proto.grpc_sink_op()));
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+  std::vector<int64_t> sent_rows;
+  bool sent_eos = false;
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .WillRepeatedly(Invoke([&](const TransferResultChunkRequest& req, grpc::WriteOptions) {
+        const auto& rb = req.query_result().row_batch();
+        if (rb.cols_size() > 0) {
+          sent_rows.insert(sent_rows.end(), rb.cols(0).int64_data().data().begin(),
+                           rb.cols(0).int64_data().data().end());
+        }
+        sent_eos |= rb.eos();
+        return true;
+      }));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  auto stub = std::make_unique<MockResultSinkServiceStub>();
+  EXPECT_CALL(*stub, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  ExecState exec_state(
+      registry, std::make_shared<table_store::TableStore>(),
+      [&stub](const std::string&,
+              const std::string&) -> std::unique_ptr<ResultSinkService::StubInterface> {
+        return std::move(stub);
+      },
+      sole::uuid4(), nullptr, nullptr, [](grpc::ClientContext*) {});
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(*plan_node, rd, {rd},
+                                                                           &exec_state);
+  for (const auto& rb : batches) {
+    tester.ConsumeNext(rb, 5, 0);
+  }
+  tester.Close();
+  return {sent_rows, sent_eos};
+}
+
+TEST_F(GRPCSinkNodeTest, partitioned_result) {
+  std::vector<types::Int64Value> keys;
+  for (int64_t i = 0; i < 100; ++i) {
+    keys.push_back(i % 25);
+  }
+  RowDescriptor rd({types::DataType::INT64});
+  auto half = static_cast<int64_t>(keys.size() / 2);
+  std::vector<RowBatch> batches{
+      RowBatchBuilder(rd, half, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Int64Value>(
+              std::vector<types::Int64Value>(keys.begin(), keys.begin() + half))
+          .get(),
+      RowBatchBuilder(rd, keys.size() - half, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Int64Value>(
+              std::vector<types::Int64Value>(keys.begin() + half, keys.end()))
+          .get()};
+
+  auto [partition0, eos0] = SendPartition(func_registry_.get(), rd, {0}, 0, batches);
+  auto [partition1, eos1] = SendPartition(func_registry_.get(), rd, {0}, 1, batches);
+  EXPECT_TRUE(eos0);
+  EXPECT_TRUE(eos1);
+
+  // Every row is sent to exactly one partition, and all rows of a key are sent to the same one.
+  EXPECT_EQ(keys.size(), partition0.size() + partition1.size());
+  EXPECT_FALSE(partition0.empty());
+  EXPECT_FALSE(partition1.empty());
+  for (int64_t key : partition0) {
+    EXPECT_EQ(4, std::count(partition0.begin(), partition0.end(), key));
+    EXPECT_EQ(0, std::count(partition1.begin(), partition1.end(), key));
+  }
+  for (int64_t key : partition1) {
+    EXPECT_EQ(4, std::count(partition1.begin(), partition1.end(), key));
+  }
+}
+
+TEST_F(GRPCSinkNodeTest, partitioned_result_composite_key) {
+  // Rows are identified by their id, and partitioned on (service, code).
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING, types::DataType::INT64});
+  std::vector<types::Int64Value> ids;
+  std::vector<types::StringValue> services;
+  std::vector<types::Int64Value> codes;
+  for (int64_t i = 0; i < 60; ++i) {
+    ids.push_back(i);
+    services.push_back(absl::StrCat("service-", i % 3));
+    codes.push_back(i % 4);
+  }
+  auto key_of = [&](int64_t id) { return absl::StrCat(services[id], "/", codes[id].val); };
+  std::vector<RowBatch> batches{RowBatchBuilder(rd, ids.size(), /*eow*/ true, /*eos*/ true)
+                                    .AddColumn<types::Int64Value>(ids)
+                                    .AddColumn<types::StringValue>(services)
+                                    .AddColumn<types::Int64Value>(codes)
+                                    .get()};
+
+  auto [partition0, eos0] = SendPartition(func_registry_.get(), rd, {1, 2}, 0, batches);
+  auto [partition1, eos1] = SendPartition(func_registry_.get(), rd, {1, 2}, 1, batches);
+  EXPECT_TRUE(eos0);
+  EXPECT_TRUE(eos1);
+  EXPECT_EQ(ids.size(), partition0.size() + partition1.size());
+
+  // The 12 keys are split between the partitions, without any key in both.
+  absl::flat_hash_set<std::string> keys0;
+  for (int64_t id : partition0) {
+    keys0.insert(key_of(id));
+  }
+  EXPECT_FALSE(keys0.empty());
+  EXPECT_LT(keys0.size(), 12U);
+  for (int64_t id : partition1) {
+    EXPECT_FALSE(keys0.contains(key_of(id))) << key_of(id);
+  }
+}
+
+TEST_F(GRPCSinkNodeTest, invalid_partition) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto partition = op_proto.mutable_grpc_sink_op()->mutable_partition();
+  partition->add_key_column_indices(0);
+  partition->set_index(2);
+  partition->set_num_partitions(2);
+  plan::GRPCSinkOperator plan_node(1);
+  EXPECT_NOT_OK(plan_node.Init(op_proto.grpc_sink_op()));
+}
+
 struct SplitTestCase {
   size_t max_batch_size = 4096;
   float batch_size_factor = 0.5;
@@ -732,6 +945,52 @@ TEST_F(GRPCSinkNodeTest, retry_failed_writes) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, stopped_by_destination) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+  resp.set_source_stopped(true);
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(3)
+      .WillOnce(Return(true))    // Initiate result sink
+      .WillOnce(Return(true))    // First batch.
+      .WillOnce(Return(false));  // The destination closed the stream.
+  EXPECT_CALL(*writer, WritesDone()).Times(1).WillOnce(Return(true));
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+
+  // The sink doesn't reconnect to a destination that stopped its results.
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester.node()->testing_set_connection_check_timeout(std::chrono::milliseconds(-1));
+
+  for (auto i = 0; i < 2; ++i) {
+    auto rb = RowBatchBuilder(output_rd, 1, /*eow*/ false, /*eos*/ false)
+                  .AddColumn<types::Int64Value>({i})
+                  .get();
+    tester.ConsumeNext(rb, 5, 0);
+  }
+  EXPECT_TRUE(tester.node()->downstream_stopped());
+
+  // The rest of the input is dropped without writing to the stream.
+  auto rb = RowBatchBuilder(output_rd, 1, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({2})
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  EXPECT_OK(tester.node()->OptionallyCheckConnection(exec_state_.get()));
+
+  tester.Close();
+}
+
 TEST_F(GRPCSinkNodeTest, check_connection_after_eos) {
   auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
   auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
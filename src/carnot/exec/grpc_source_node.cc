@@ -57,28 +57,51 @@ Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
 
 Status GRPCSourceNode::EnqueueRowBatch(
     std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
-  if (!row_batch_queue_.enqueue(std::move(row_batch))) {
+  // The serialized size of the request stands in for the memory it holds.
+  int64_t bytes = row_batch->ByteSizeLong();
+  if (!row_batch_queue_.enqueue({std::move(row_batch), bytes})) {
     return error::Internal("Failed to enqueue RowBatch");
   }
+  if (queued_batch_tracker_ != nullptr) {
+    queued_batch_tracker_->Add(bytes);
+  }
   return Status::OK();
 }
 
 Status GRPCSourceNode::PopRowBatch() {
   DCHECK(NextBatchReady());
-  std::unique_ptr<carnotpb::TransferResultChunkRequest> rb_request;
-  bool got_one = row_batch_queue_.try_dequeue(rb_request);
+  QueuedRequest queued;
+  bool got_one = row_batch_queue_.try_dequeue(queued);
   if (!got_one) {
     return error::Internal(
         "Called GRPCSourceNode::OptionallyPopRowBatch but there was no available row batch in the "
         "queue.");
   }
-  if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
+  if (queued_batch_tracker_ != nullptr) {
+    queued_batch_tracker_->Remove(queued.bytes);
+  }
+  auto rb_request = std::move(queued.request);
+  if (!rb_request->has_query_result()) {
+    return error::Internal(
+        "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
+        "message.");
+  }
+
+  auto* query_result = rb_request->mutable_query_result();
+  if (query_result->has_columnar_row_batch()) {
+    // The columnar batch hands its buffers to the row batch, so it doesn't copy the values again.
+    PL_ASSIGN_OR_RETURN(rb_,
+                        RowBatch::FromColumnarProto(query_result->mutable_columnar_row_batch()));
+    return Status::OK();
+  }
+  if (!query_result->has_row_batch()) {
     return error::Internal(
         "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
         "message.");
   }
 
-  PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromProto(rb_request->query_result().row_batch()));
+  // The numeric columns are moved out of the request rather than copied.
+  PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromProto(query_result->mutable_row_batch()));
   return Status::OK();
 }
 
@@ -21,16 +21,18 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/queued_batch_tracker.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/table_store/table_store.h"
 
-#include "blockingconcurrentqueue.h"
+#include "concurrentqueue.h"
 
 namespace px {
 namespace carnot {
@@ -56,6 +58,15 @@ class GRPCSourceNode : public SourceNode {
   void set_upstream_closed_connection() { upstream_closed_connection_ = true; }
   bool upstream_closed_connection() const { return upstream_closed_connection_; }
 
+  // The number of row batches that were received but not consumed yet.
+  size_t NumQueuedBatches() const { return row_batch_queue_.size_approx(); }
+
+  // Counts the queued batches against the memory budgets of the query. Set by the GRPC router
+  // before any batches are enqueued.
+  void set_queued_batch_tracker(std::shared_ptr<QueuedBatchTracker> tracker) {
+    queued_batch_tracker_ = std::move(tracker);
+  }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -68,8 +79,14 @@ class GRPCSourceNode : public SourceNode {
   Status PopRowBatch();
 
   std::unique_ptr<table_store::schema::RowBatch> rb_;
-  moodycamel::BlockingConcurrentQueue<std::unique_ptr<carnotpb::TransferResultChunkRequest>>
-      row_batch_queue_;
+  struct QueuedRequest {
+    std::unique_ptr<carnotpb::TransferResultChunkRequest> request;
+    int64_t bytes = 0;
+  };
+  // Written by the GRPCRouter's stream threads and read by the exec graph. The source never
+  // blocks on the queue, so it doesn't pay for the semaphore of a blocking queue on every enqueue.
+  moodycamel::ConcurrentQueue<QueuedRequest> row_batch_queue_;
+  std::shared_ptr<QueuedBatchTracker> queued_batch_tracker_;
 
   std::unique_ptr<plan::GRPCSourceOperator> plan_node_;
   bool upstream_initiated_connection_ = false;
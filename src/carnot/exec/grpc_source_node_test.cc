@@ -86,6 +86,60 @@ TEST_F(GRPCSourceNodeTest, basic) {
   EXPECT_FALSE(tester.node()->HasBatchesRemaining());
 }
 
+TEST_F(GRPCSourceNodeTest, columnar_batches) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  auto rb = RowBatchBuilder(output_rd, 3, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({1, 2, 3})
+                .get();
+  auto rb_wrapper = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  EXPECT_OK(
+      rb.ToColumnarProto(rb_wrapper->mutable_query_result()->mutable_columnar_row_batch()));
+  EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+
+  EXPECT_TRUE(tester.node()->NextBatchReady());
+  tester.GenerateNextResult().ExpectRowBatch(rb);
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+}
+
+TEST_F(GRPCSourceNodeTest, tracks_queued_batches) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  QueuedBatchTotals router_totals;
+  auto tracker = std::make_shared<QueuedBatchTracker>(&router_totals);
+  tester.node()->set_queued_batch_tracker(tracker);
+
+  for (auto i = 0; i < 2; ++i) {
+    auto rb = RowBatchBuilder(output_rd, 2, /*eow*/ i == 1, /*eos*/ i == 1)
+                  .AddColumn<types::Int64Value>({1, 2})
+                  .get();
+    auto rb_wrapper = std::make_unique<carnotpb::TransferResultChunkRequest>();
+    EXPECT_OK(rb.ToProto(rb_wrapper->mutable_query_result()->mutable_row_batch()));
+    EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+  }
+  EXPECT_EQ(2, router_totals.batches);
+  EXPECT_GT(tracker->bytes(), 0);
+  EXPECT_EQ(tracker->bytes(), router_totals.bytes);
+
+  tester.GenerateNextResult();
+  EXPECT_EQ(1, router_totals.batches);
+
+  // Batches that are never consumed are removed from the router's totals with the tracker.
+  tester.node()->set_queued_batch_tracker(nullptr);
+  tracker.reset();
+  EXPECT_EQ(0, router_totals.batches);
+  EXPECT_EQ(0, router_totals.bytes);
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -56,6 +56,12 @@ Status MemorySinkNode::InitImpl(const plan::Operator& plan_node) {
 }
 
 Status MemorySinkNode::PrepareImpl(ExecState* exec_state_) {
+  callback_ = exec_state_->memory_sink_callback(TableName());
+  if (callback_ != nullptr) {
+    // The batches are handed off as they are produced, without keeping them in a table.
+    return Status::OK();
+  }
+
   // Create Table.
   std::vector<std::string> col_names;
   for (size_t i = 0; i < input_descriptor_->size(); i++) {
@@ -74,9 +80,13 @@ Status MemorySinkNode::CloseImpl(ExecState*) { return Status::OK(); }
 
 Status MemorySinkNode::ConsumeNextImpl(ExecState*, const RowBatch& rb, size_t) {
   DCHECK_EQ(static_cast<size_t>(0), children().size());
-  if (rb.num_rows() > 0 || (rb.eow() || rb.eos())) {
-    PL_RETURN_IF_ERROR(table_->WriteRowBatch(rb));
+  if (rb.num_rows() == 0 && !rb.eow() && !rb.eos()) {
+    return Status::OK();
+  }
+  if (callback_ != nullptr) {
+    return (*callback_)(rb);
   }
+  PL_RETURN_IF_ERROR(table_->WriteRowBatch(rb));
   return Status::OK();
 }
 
@@ -25,6 +25,7 @@
 
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_batch_queue.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
@@ -54,6 +55,8 @@ class MemorySinkNode : public SinkNode {
   std::unique_ptr<plan::MemorySinkOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
   std::shared_ptr<table_store::Table> table_;
+  // Set when the batches are streamed to a callback rather than written to table_.
+  const MemorySinkCallback* callback_ = nullptr;
 };
 
 }  // namespace exec
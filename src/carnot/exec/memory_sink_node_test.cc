@@ -21,8 +21,11 @@
 #include <arrow/array.h>
 #include <arrow/memory_pool.h>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -180,6 +183,47 @@ TEST_F(MemorySinkNodeTest, zero_row_row_batch_eos) {
   EXPECT_EQ(0, exec_state_->table_store()->GetTable("cpu_15s")->GetTableStats().batches_added);
 }
 
+TEST_F(MemorySinkNodeTest, streams_to_callback) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::BOOLEAN});
+  RowDescriptor output_rd({});
+
+  std::vector<int64_t> num_rows;
+  absl::flat_hash_map<std::string, MemorySinkCallback> callbacks;
+  callbacks["cpu_15s"] = [&](const RowBatch& rb) {
+    num_rows.push_back(rb.num_rows());
+    return rb.eos() ? error::Cancelled("Consumer gave up") : Status::OK();
+  };
+  exec_state_->set_memory_sink_callbacks(&callbacks);
+
+  auto tester = exec::ExecNodeTester<MemorySinkNode, plan::MemorySinkOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  tester.ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>({1, 2})
+                         .AddColumn<types::BoolValue>({true, false})
+                         .get(),
+                     false, 0);
+  // Empty batches are dropped unless they end the stream.
+  tester.ConsumeNext(RowBatchBuilder(input_rd, 0, /*eow*/ false, /*eos*/ false)
+                         .AddColumn<types::Int64Value>({})
+                         .AddColumn<types::BoolValue>({})
+                         .get(),
+                     false, 0);
+  EXPECT_THAT(num_rows, ::testing::ElementsAre(2));
+
+  // The errors of the callback fail the sink.
+  auto* sink = static_cast<MemorySinkNode*>(tester.node());
+  EXPECT_NOT_OK(sink->ConsumeNext(exec_state_.get(),
+                                  RowBatchBuilder(input_rd, 0, /*eow*/ true, /*eos*/ true)
+                                      .AddColumn<types::Int64Value>({})
+                                      .AddColumn<types::BoolValue>({})
+                                      .get(),
+                                  0));
+  EXPECT_THAT(num_rows, ::testing::ElementsAre(2, 0));
+
+  // Nothing is written to the table store.
+  EXPECT_EQ(nullptr, exec_state_->table_store()->GetTable("cpu_15s"));
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
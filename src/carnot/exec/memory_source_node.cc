@@ -18,15 +18,26 @@
 
 #include "src/carnot/exec/memory_source_node.h"
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
+DEFINE_int32(carnot_memory_source_scan_threads,
+             gflags::Int32FromEnv("PL_CARNOT_MEMORY_SOURCE_SCAN_THREADS", 0),
+             "The number of threads used to materialize row batches for finite memory source "
+             "scans. 0 reads the batches on the execution thread.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -42,47 +53,292 @@ Status MemorySourceNode::InitImpl(const plan::Operator& plan_node) {
   // copy the plan node to local object;
   plan_node_ = std::make_unique<plan::MemorySourceOperator>(*source_plan_node);
 
+  if (plan_node_->evaluate_predicates()) {
+    // The operator already checked that the predicates are on columns that are read.
+    const auto cols = plan_node_->Columns();
+    for (const auto& predicate : plan_node_->predicates()) {
+      predicate_col_positions_.push_back(
+          std::distance(cols.begin(), std::find(cols.begin(), cols.end(), predicate.col_idx)));
+    }
+  }
   return Status::OK();
 }
 
 Status MemorySourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
 Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
-  table_ = exec_state->table_store()->GetTable(plan_node_->TableName(), plan_node_->Tablet());
-  DCHECK(table_ != nullptr);
-
   infinite_stream_ = plan_node_->infinite_stream();
+  if (!plan_node_->Tablets().empty()) {
+    std::vector<table_store::Table*> tablets;
+    for (const auto& tablet : plan_node_->Tablets()) {
+      auto* table = exec_state->table_store()->GetTable(plan_node_->TableName(), tablet);
+      if (table == nullptr) {
+        return error::NotFound("Tablet '$0' of table '$1' not found", tablet,
+                               plan_node_->TableName());
+      }
+      tablets.push_back(table);
+    }
+    return OpenTablets(exec_state, tablets);
+  }
+
+  if (plan_node_->Tablet().empty()) {
+    PL_ASSIGN_OR_RETURN(std::vector<table_store::Table*> tablets, SelectTablets(exec_state));
+    if (tablets.size() > 1) {
+      if (infinite_stream_) {
+        return error::Unimplemented("Streaming from the tablets of table '$0' is not supported",
+                                    plan_node_->TableName());
+      }
+      return OpenTablets(exec_state, tablets);
+    }
+    if (tablets.size() == 1) {
+      table_ = tablets.front();
+    }
+  }
+
+  if (table_ == nullptr) {
+    table_ = exec_state->table_store()->GetTable(plan_node_->TableName(), plan_node_->Tablet());
+  }
+  DCHECK(table_ != nullptr);
 
   if (table_ == nullptr) {
     return error::NotFound("Table '$0' not found", plan_node_->TableName());
   }
+  PL_RETURN_IF_ERROR(FindScanRange(exec_state, table_, &current_batch_, &stop_));
+
+  if (!infinite_stream_ && FLAGS_carnot_memory_source_scan_threads > 0) {
+    morsels_ = TableMorsels(table_, current_batch_, stop_);
+    StartParallelScan(exec_state, FLAGS_carnot_memory_source_scan_threads);
+  }
+  return Status::OK();
+}
 
+Status MemorySourceNode::FindScanRange(ExecState* exec_state, table_store::Table* table,
+                                       table_store::BatchSlice* start,
+                                       table_store::Table::StopPosition* stop) {
   if (plan_node_->HasStartTime()) {
-    PL_ASSIGN_OR_RETURN(current_batch_, table_->FindBatchSliceGreaterThanOrEqual(
-                                            plan_node_->start_time(), exec_state->exec_mem_pool()));
+    PL_ASSIGN_OR_RETURN(*start, table->FindBatchSliceGreaterThanOrEqual(
+                                    plan_node_->start_time(), exec_state->persistent_mem_pool()));
   } else {
-    current_batch_ = table_->FirstBatch();
+    *start = table->FirstBatch();
   }
 
   if (plan_node_->HasStopTime()) {
-    PL_ASSIGN_OR_RETURN(stop_, table_->FindStopPositionForTime(plan_node_->stop_time(),
-                                                               exec_state->exec_mem_pool()));
+    PL_ASSIGN_OR_RETURN(*stop, table->FindStopPositionForTime(plan_node_->stop_time(),
+                                                              exec_state->persistent_mem_pool()));
   } else {
     // Determine table_end at Open() time because Stirling may be pushing to the table
-    stop_ = table_->End();
+    *stop = table->End();
+  }
+  *start = table->SliceIfPastStop(*start, *stop);
+  return Status::OK();
+}
+
+StatusOr<std::vector<table_store::Table*>> MemorySourceNode::SelectTablets(
+    ExecState* exec_state) {
+  auto* table_store = exec_state->table_store();
+  const int64_t key_col_idx = table_store->GetTabletizationKey(plan_node_->TableName());
+  if (key_col_idx < 0) {
+    return std::vector<table_store::Table*>{};
+  }
+
+  // An equality predicate on the tabletization key selects the single tablet of its value.
+  for (const auto& predicate : plan_node_->predicates()) {
+    if (predicate.col_idx != key_col_idx ||
+        predicate.op != table_store::ColumnPredicate::Op::kEqual) {
+      continue;
+    }
+    types::TabletID tablet_id;
+    if (predicate.data_type == types::INT64) {
+      tablet_id = types::ToTabletID(types::Int64Value(predicate.int_value));
+    } else if (predicate.data_type == types::UINT128) {
+      tablet_id = types::ToTabletID(
+          types::UInt128Value(absl::Uint128High64(predicate.uint128_value),
+                              absl::Uint128Low64(predicate.uint128_value)));
+    } else {
+      continue;
+    }
+    auto* table = table_store->GetTable(plan_node_->TableName(), tablet_id);
+    if (table == nullptr) {
+      // No records with the value were written yet, the (empty) default tablet is read instead.
+      return std::vector<table_store::Table*>{};
+    }
+    return std::vector<table_store::Table*>{table};
+  }
+
+  std::vector<table_store::Table*> tablets;
+  for (const auto& [tablet_id, table] : table_store->GetTablets(plan_node_->TableName())) {
+    tablets.push_back(table);
+  }
+  return tablets;
+}
+
+Status MemorySourceNode::OpenTablets(ExecState* exec_state,
+                                     const std::vector<table_store::Table*>& tablets) {
+  std::vector<std::vector<Morsel>> tablet_morsels;
+  size_t num_morsels = 0;
+  for (auto* table : tablets) {
+    tablets_.push_back(table);
+
+    table_store::BatchSlice start;
+    table_store::Table::StopPosition stop;
+    PL_RETURN_IF_ERROR(FindScanRange(exec_state, table, &start, &stop));
+    tablet_morsels.push_back(TableMorsels(table, start, stop));
+    num_morsels += tablet_morsels.back().size();
+  }
+  table_ = tablets_.front();
+
+  morsels_.reserve(num_morsels);
+  for (size_t i = 0; morsels_.size() < num_morsels; ++i) {
+    for (auto& morsels : tablet_morsels) {
+      if (i < morsels.size()) {
+        morsels_.push_back(std::move(morsels[i]));
+      }
+    }
   }
-  current_batch_ = table_->SliceIfPastStop(current_batch_, stop_);
 
+  int64_t num_threads = plan_node_->TabletParallelism();
+  if (num_threads <= 0) {
+    num_threads = std::max<int64_t>(FLAGS_carnot_memory_source_scan_threads, 1);
+  }
+  StartParallelScan(exec_state, num_threads);
   return Status::OK();
 }
 
 Status MemorySourceNode::CloseImpl(ExecState*) {
+  StopParallelScan();
   stats()->AddExtraInfo("infinite_stream", infinite_stream_ ? "true" : "false");
+  stats()->AddExtraInfo("parallel_scan", parallel_scan_ ? "true" : "false");
+  if (!tablets_.empty()) {
+    stats()->AddExtraInfo("tablets", absl::StrCat(tablets_.size()));
+  }
+  stats()->AddExtraInfo("batches_skipped", absl::StrCat(batches_skipped_));
+  if (plan_node_->evaluate_predicates()) {
+    stats()->AddExtraInfo("rows_filtered", absl::StrCat(rows_filtered_));
+  }
   return Status::OK();
 }
 
+void MemorySourceNode::SelectMatchingRows(RowBatch* row_batch) {
+  if (predicate_col_positions_.empty()) {
+    return;
+  }
+  std::vector<int64_t> rows(row_batch->num_rows());
+  std::iota(rows.begin(), rows.end(), 0);
+  const auto& predicates = plan_node_->predicates();
+  for (size_t i = 0; i < predicates.size() && !rows.empty(); ++i) {
+    predicates[i].FilterRows(row_batch->ColumnAt(predicate_col_positions_[i]).get(), &rows);
+  }
+  rows_filtered_ += row_batch->num_rows() - static_cast<int64_t>(rows.size());
+  // Like the filter node, the rows are only selected, children that don't handle selections get
+  // a compacted copy.
+  row_batch->set_selection(std::make_shared<const std::vector<int64_t>>(std::move(rows)));
+}
+
+std::vector<MemorySourceNode::Morsel> MemorySourceNode::TableMorsels(
+    table_store::Table* table, table_store::BatchSlice start,
+    const table_store::Table::StopPosition& stop) {
+  // The stop position is fixed for finite streams, so all of the morsels are known up front.
+  std::vector<Morsel> morsels;
+  for (auto slice = start; slice.IsValid(); slice = table->NextBatch(slice, stop)) {
+    if (!table->SliceMayMatch(slice, plan_node_->predicates())) {
+      ++batches_skipped_;
+      continue;
+    }
+    Morsel morsel;
+    morsel.table = table;
+    morsel.slice = slice;
+    morsels.push_back(std::move(morsel));
+  }
+  return morsels;
+}
+
+void MemorySourceNode::StartParallelScan(ExecState* exec_state, size_t num_threads) {
+  parallel_scan_ = true;
+  num_threads = std::min<size_t>(num_threads, std::max<size_t>(morsels_.size(), 1));
+  max_morsels_in_flight_ = 2 * num_threads;
+  // The table caches the arrays it converts for other queries, so they can't come from the arena.
+  auto* mem_pool = exec_state->persistent_mem_pool();
+  for (size_t i = 0; i < num_threads; ++i) {
+    scan_threads_.emplace_back(&MemorySourceNode::ScanMorsels, this, mem_pool);
+  }
+}
+
+void MemorySourceNode::ScanMorsels(arrow::MemoryPool* mem_pool) {
+  while (true) {
+    size_t idx;
+    {
+      std::unique_lock<std::mutex> lock(scan_mutex_);
+      scan_cv_.wait(lock, [this] {
+        return stop_scan_ || next_morsel_to_scan_ >= morsels_.size() ||
+               next_morsel_to_scan_ < next_morsel_to_emit_ + max_morsels_in_flight_;
+      });
+      if (stop_scan_ || next_morsel_to_scan_ >= morsels_.size()) {
+        return;
+      }
+      idx = next_morsel_to_scan_++;
+    }
+
+    // The table handles its own locking, so morsels can be read concurrently.
+    auto row_batch_or_s = morsels_[idx].table->GetRowBatchSlice(morsels_[idx].slice,
+                                                                plan_node_->Columns(), mem_pool);
+    {
+      std::lock_guard<std::mutex> lock(scan_mutex_);
+      auto& morsel = morsels_[idx];
+      if (row_batch_or_s.ok()) {
+        morsel.row_batch = row_batch_or_s.ConsumeValueOrDie();
+      } else {
+        morsel.status = row_batch_or_s.status();
+      }
+      morsel.ready = true;
+    }
+    scan_cv_.notify_all();
+  }
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::NextMorselRowBatch() {
+  if (next_morsel_to_emit_ >= morsels_.size()) {
+    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ true, /* eos */ true);
+  }
+
+  std::unique_ptr<RowBatch> row_batch;
+  {
+    std::unique_lock<std::mutex> lock(scan_mutex_);
+    auto& morsel = morsels_[next_morsel_to_emit_];
+    scan_cv_.wait(lock, [&morsel] { return morsel.ready; });
+    PL_RETURN_IF_ERROR(morsel.status);
+    row_batch = std::move(morsel.row_batch);
+    ++next_morsel_to_emit_;
+  }
+  // Let the scan threads move on to the next morsels.
+  scan_cv_.notify_all();
+
+  rows_processed_ += row_batch->num_rows();
+  bytes_processed_ += row_batch->NumBytes();
+  SelectMatchingRows(row_batch.get());
+  if (next_morsel_to_emit_ == morsels_.size()) {
+    row_batch->set_eow(true);
+    row_batch->set_eos(true);
+  }
+  return row_batch;
+}
+
+void MemorySourceNode::StopParallelScan() {
+  {
+    std::lock_guard<std::mutex> lock(scan_mutex_);
+    stop_scan_ = true;
+  }
+  scan_cv_.notify_all();
+  for (auto& thread : scan_threads_) {
+    thread.join();
+  }
+  scan_threads_.clear();
+}
+
 StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState* exec_state) {
   DCHECK(table_ != nullptr);
+  if (parallel_scan_) {
+    return NextMorselRowBatch();
+  }
 
   if (infinite_stream_ && wait_for_valid_next_) {
     // If it's an infinite_stream that has read out all the current data in the table, we have to
@@ -97,17 +353,34 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
     wait_for_valid_next_ = false;
   }
 
+  // Skip over the batches whose zone maps show that they can't satisfy the pushed down predicates.
+  while (current_batch_.IsValid() &&
+         !table_->SliceMayMatch(current_batch_, plan_node_->predicates())) {
+    ++batches_skipped_;
+    auto next_batch = table_->NextBatch(current_batch_, stop_);
+    if (infinite_stream_ && !next_batch.IsValid()) {
+      wait_for_valid_next_ = true;
+      return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ false, /* eos */ false);
+    }
+    current_batch_ = next_batch;
+  }
+
   if (!current_batch_.IsValid()) {
     return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ !infinite_stream_,
                                   /* eos */ !infinite_stream_);
   }
 
-  PL_ASSIGN_OR_RETURN(
-      auto row_batch,
-      table_->GetRowBatchSlice(current_batch_, plan_node_->Columns(), exec_state->exec_mem_pool()));
+  std::unique_ptr<RowBatch> row_batch;
+  {
+    QueryTrace::Span span(exec_state->query_trace(), QueryTrace::EventType::kArrowConversion,
+                          id());
+    PL_ASSIGN_OR_RETURN(row_batch, table_->GetRowBatchSlice(current_batch_, plan_node_->Columns(),
+                                                            exec_state->persistent_mem_pool()));
+  }
 
   rows_processed_ += row_batch->num_rows();
   bytes_processed_ += row_batch->NumBytes();
+  SelectMatchingRows(row_batch.get());
   auto next_batch = table_->NextBatch(current_batch_, stop_);
   if (infinite_stream_ && !next_batch.IsValid()) {
     wait_for_valid_next_ = true;
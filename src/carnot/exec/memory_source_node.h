@@ -19,8 +19,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "src/carnot/exec/exec_node.h"
@@ -31,6 +34,8 @@
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_memory_source_scan_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -40,7 +45,7 @@ using table_store::schema::RowBatch;
 class MemorySourceNode : public SourceNode {
  public:
   MemorySourceNode() = default;
-  virtual ~MemorySourceNode() = default;
+  virtual ~MemorySourceNode() { StopParallelScan(); }
 
   bool NextBatchReady() override;
 
@@ -55,6 +60,37 @@ class MemorySourceNode : public SourceNode {
  private:
   StatusOr<std::unique_ptr<RowBatch>> GetNextRowBatch(ExecState* exec_state);
   bool InfiniteStreamNextBatchReady();
+  // Selects the rows of the row batch that satisfy the plan's predicates, if it evaluates them.
+  void SelectMatchingRows(RowBatch* row_batch);
+
+  // Finds the first batch and the stop position of the plan's time range in the table.
+  Status FindScanRange(ExecState* exec_state, table_store::Table* table,
+                       table_store::BatchSlice* start, table_store::Table::StopPosition* stop);
+
+  // Parallel scans split a finite scan into morsels, one per BatchSlice, when the node is opened.
+  // A pool of scan threads materializes the morsels ahead of the consumer, which still emits them
+  // in order on the execution thread.
+  struct Morsel {
+    table_store::Table* table = nullptr;
+    table_store::BatchSlice slice;
+    Status status;
+    std::unique_ptr<RowBatch> row_batch;
+    bool ready = false;
+  };
+  // Returns the morsels of the table's batches in the range that may match the plan's predicates.
+  std::vector<Morsel> TableMorsels(table_store::Table* table, table_store::BatchSlice start,
+                                   const table_store::Table::StopPosition& stop);
+  // Reads the tablets of a source that reads several tablets. Their morsels are interleaved so that
+  // the scan threads read from different tablets concurrently.
+  Status OpenTablets(ExecState* exec_state, const std::vector<table_store::Table*>& tablets);
+  // Selects the tablets of a table that the table store splits by a tabletization key, when the
+  // plan doesn't name a tablet. An equality predicate on the key selects the tablet of its value,
+  // otherwise all of the tablets are read. Returns no tablets if the table isn't split.
+  StatusOr<std::vector<table_store::Table*>> SelectTablets(ExecState* exec_state);
+  void StartParallelScan(ExecState* exec_state, size_t num_threads);
+  void ScanMorsels(arrow::MemoryPool* mem_pool);
+  StatusOr<std::unique_ptr<RowBatch>> NextMorselRowBatch();
+  void StopParallelScan();
   // Whether this memory source will stream infinitely. Can be stopped by the
   // exec_state_->keep_running() call in exec_graph.
   bool infinite_stream_ = false;
@@ -63,6 +99,27 @@ class MemorySourceNode : public SourceNode {
   bool wait_for_valid_next_ = false;
   table_store::BatchSlice current_batch_;
   table_store::Table::StopPosition stop_;
+  // Number of batches skipped because of the plan's predicates.
+  int64_t batches_skipped_ = 0;
+  // The position in the output row batches of the column of each of the plan's predicates, set
+  // when the predicates are evaluated on the rows.
+  std::vector<int64_t> predicate_col_positions_;
+  // Number of rows of the batches that weren't skipped that didn't satisfy the predicates.
+  int64_t rows_filtered_ = 0;
+
+  bool parallel_scan_ = false;
+  // The tablets read, when the source reads several tablets.
+  std::vector<table_store::Table*> tablets_;
+  std::vector<Morsel> morsels_;
+  std::vector<std::thread> scan_threads_;
+  std::mutex scan_mutex_;
+  std::condition_variable scan_cv_;
+  // The next morsel to hand to a scan thread, and the next one to emit.
+  size_t next_morsel_to_scan_ = 0;
+  size_t next_morsel_to_emit_ = 0;
+  // Scan threads only run this many morsels ahead of the consumer to bound memory.
+  size_t max_morsels_in_flight_ = 0;
+  bool stop_scan_ = false;
 
   std::unique_ptr<plan::MemorySourceOperator> plan_node_;
   table_store::Table* table_ = nullptr;
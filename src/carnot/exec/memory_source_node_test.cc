@@ -104,6 +104,31 @@ TEST_F(MemorySourceNodeTest, basic) {
   EXPECT_EQ(sizeof(int64_t) * 5, tester.node()->BytesProcessed());
 }
 
+TEST_F(MemorySourceNodeTest, parallel_scan) {
+  FLAGS_carnot_memory_source_scan_threads = 2;
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 3, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({1, 2, 3})
+          .get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(5, tester.node()->RowsProcessed());
+  EXPECT_EQ(sizeof(int64_t) * 5, tester.node()->BytesProcessed());
+  FLAGS_carnot_memory_source_scan_threads = 0;
+}
+
 TEST_F(MemorySourceNodeTest, empty_table) {
   auto op_proto = planpb::testutils::CreateTestSource1PB("empty");
   std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
@@ -323,6 +348,111 @@ TEST_F(MemorySourceNodeTabletTest, multiple_tablet_test) {
   EXPECT_EQ(0, tester.node()->BytesProcessed());
 }
 
+TEST_F(MemorySourceNodeTabletTest, reads_tablets_concurrently) {
+  types::TabletID other_tablet_id = "456";
+  std::shared_ptr<Table> other_tablet = Table::Create(table_name_, rel);
+  auto rb = RowBatch(RowDescriptor(rel.col_types()), 2);
+  std::vector<types::BoolValue> col1 = {true, true};
+  std::vector<types::Time64NSValue> col2 = {7, 8};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(col2, arrow::default_memory_pool())));
+  EXPECT_OK(other_tablet->WriteRowBatch(rb));
+  exec_state_->table_store()->AddTable(other_tablet, table_name_, table_id_, other_tablet_id);
+
+  auto op_proto = planpb::testutils::CreateTestSourceWithTablets1PB("\"\"");
+  auto* mem_source_pb = op_proto.mutable_mem_source_op();
+  mem_source_pb->add_tablets(tablet_id_);
+  mem_source_pb->add_tablets(other_tablet_id);
+  mem_source_pb->set_tablet_parallelism(2);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  // The batches of the tablets are interleaved.
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 3, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({1, 2, 3})
+          .get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({7, 8})
+          .get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(7, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTabletTest, missing_tablet_of_several_fails) {
+  auto op_proto = planpb::testutils::CreateTestSourceWithTablets1PB("\"\"");
+  op_proto.mutable_mem_source_op()->add_tablets(tablet_id_);
+  op_proto.mutable_mem_source_op()->add_tablets("223");
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  MemorySourceNode node;
+  ASSERT_OK(node.Init(*plan_node, output_rd, std::vector<RowDescriptor>({})));
+  ASSERT_OK(node.Prepare(exec_state_.get()));
+  EXPECT_NOT_OK(node.Open(exec_state_.get()));
+  EXPECT_OK(node.Close(exec_state_.get()));
+}
+
+TEST_F(MemorySourceNodeTabletTest, selects_tablets_by_tabletization_key) {
+  auto key_rel = table_store::schema::Relation({types::DataType::INT64, types::DataType::TIME64NS},
+                                               {"key", "time_"});
+  auto* table_store = exec_state_->table_store();
+  table_store->AddTable(Table::Create("keyed", key_rel), "keyed", /* table_id */ 654);
+  for (int64_t key : {1, 2}) {
+    auto tablet = Table::Create("keyed", key_rel);
+    auto rb = RowBatch(RowDescriptor(key_rel.col_types()), 2);
+    std::vector<types::Int64Value> keys = {key, key};
+    std::vector<types::Time64NSValue> times = {10 * key, 10 * key + 1};
+    EXPECT_OK(rb.AddColumn(types::ToArrow(keys, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(tablet->WriteRowBatch(rb));
+    table_store->AddTable(tablet, "keyed", 654, types::ToTabletID(types::Int64Value(key)));
+  }
+  ASSERT_OK(table_store->SetTabletizationKey("keyed", 0));
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  // An equality predicate on the key reads only the tablet of its value.
+  auto op_proto = planpb::testutils::CreateTestSourceWithTablets1PB("\"\"");
+  op_proto.mutable_mem_source_op()->set_name("keyed");
+  auto predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(0);
+  predicate->set_op(planpb::MemorySourcePredicate::EQUAL);
+  predicate->mutable_value()->set_data_type(types::DataType::INT64);
+  predicate->mutable_value()->set_int64_value(2);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  {
+    auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+        *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+    tester.GenerateNextResult().ExpectRowBatch(
+        RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+            .AddColumn<types::Time64NSValue>({20, 21})
+            .get());
+    EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+    tester.Close();
+  }
+
+  // Without one, all of the tablets are read.
+  op_proto.mutable_mem_source_op()->clear_predicates();
+  plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  {
+    auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+        *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+    while (tester.node()->HasBatchesRemaining()) {
+      tester.GenerateNextResult();
+    }
+    tester.Close();
+    EXPECT_EQ(4, tester.node()->RowsProcessed());
+  }
+}
+
 using MemorySourceNodeTabletDeathTest = MemorySourceNodeTabletTest;
 TEST_F(MemorySourceNodeTabletDeathTest, missing_tablet_fails) {
   types::TabletID non_existant_tablet_value = "223";
@@ -412,6 +542,78 @@ TEST_F(MemorySourceNodeTest, table_compact_between_open_and_exec) {
   tester.Close();
 }
 
+TEST_F(MemorySourceNodeTest, skips_cold_batches_with_predicates) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto predicate = op_proto.mutable_mem_source_op()->add_predicates();
+  predicate->set_column_idx(1);
+  predicate->set_op(planpb::MemorySourcePredicate::GREATER_THAN_EQUAL);
+  predicate->mutable_value()->set_data_type(types::DataType::TIME64NS);
+  predicate->mutable_value()->set_time64_ns_value(5);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  // Move both batches into cold storage, so that they have zone maps.
+  EXPECT_OK(cpu_table_->CompactHotToCold(arrow::default_memory_pool()));
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(2, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, evaluates_predicates_on_rows) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto mem_source_op = op_proto.mutable_mem_source_op();
+  mem_source_op->set_evaluate_predicates(true);
+  auto lower_bound = mem_source_op->add_predicates();
+  lower_bound->set_column_idx(1);
+  lower_bound->set_op(planpb::MemorySourcePredicate::GREATER_THAN_EQUAL);
+  lower_bound->mutable_value()->set_data_type(types::DataType::TIME64NS);
+  lower_bound->mutable_value()->set_time64_ns_value(2);
+  auto not_equal = mem_source_op->add_predicates();
+  not_equal->set_column_idx(1);
+  not_equal->set_op(planpb::MemorySourcePredicate::NOT_EQUAL);
+  not_equal->mutable_value()->set_data_type(types::DataType::TIME64NS);
+  not_equal->mutable_value()->set_time64_ns_value(5);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  // The batches are still hot, so only the rows are filtered.
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({2, 3})
+          .get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 1, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(5, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, evaluated_predicates_must_be_on_read_columns) {
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  auto mem_source_op = op_proto.mutable_mem_source_op();
+  mem_source_op->set_evaluate_predicates(true);
+  auto predicate = mem_source_op->add_predicates();
+  predicate->set_column_idx(0);
+  predicate->set_op(planpb::MemorySourcePredicate::EQUAL);
+  predicate->mutable_value()->set_data_type(types::DataType::BOOLEAN);
+  predicate->mutable_value()->set_bool_value(true);
+
+  auto plan_node = std::make_unique<plan::MemorySourceOperator>(1);
+  EXPECT_NOT_OK(plan_node->Init(op_proto.mem_source_op()));
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
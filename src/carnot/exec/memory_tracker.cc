@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/memory_tracker.h"
+
+#include <algorithm>
+
+DEFINE_int64(carnot_query_memory_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_LIMIT_BYTES", 1024 * 1024 * 1024),
+             "The memory a single query may use before it is cancelled, 0 for no limit. Covers "
+             "the query's memory pool, the hash tables of its joins and aggregates and its queued "
+             "GRPC row batches.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+MemoryTracker::~MemoryTracker() {
+  if (parent_ != nullptr) {
+    parent_->Release(bytes());
+  }
+}
+
+void MemoryTracker::Consume(int64_t bytes) {
+  int64_t total = bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  int64_t peak = peak_bytes_.load(std::memory_order_relaxed);
+  while (total > peak &&
+         !peak_bytes_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+  }
+  if (parent_ != nullptr) {
+    parent_->Consume(bytes);
+  }
+}
+
+Status MemoryTracker::CheckLimit() const {
+  int64_t total = bytes();
+  if (limit_bytes_ > 0 && total > limit_bytes_) {
+    return error::ResourceUnavailable(
+        "$0 exceeded its memory limit of $1 bytes, it holds $2 bytes. Try to reduce the data it "
+        "reads, e.g. with a shorter time range or a filter before joins and aggregates.",
+        label_, limit_bytes_, total);
+  }
+  return Status::OK();
+}
+
+Status MemoryReservation::Set(int64_t bytes) {
+  if (tracker_ == nullptr) {
+    bytes_ = bytes;
+    return Status::OK();
+  }
+  tracker_->Consume(bytes - bytes_);
+  bytes_ = bytes;
+  return tracker_->CheckLimit();
+}
+
+void MemoryReservation::Reset() {
+  if (tracker_ != nullptr) {
+    tracker_->Release(bytes_);
+  }
+  bytes_ = 0;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "src/common/base/base.h"
+
+DECLARE_int64(carnot_query_memory_limit_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * MemoryTracker counts the bytes held by a query, or by all of the queries of a node, when it is
+ * the parent of their trackers. The bytes consumed by a tracker are also consumed by its parent,
+ * which must outlive it.
+ *
+ * Consuming memory never fails, the owner of the tracker checks the limit at points where it can
+ * cancel the query, e.g. between row batches.
+ */
+class MemoryTracker : public NotCopyable {
+ public:
+  /**
+   * @param label Describes what is tracked, for error messages.
+   * @param limit_bytes The limit of the tracked bytes, or 0 for none.
+   * @param parent The tracker that also counts the bytes, if any.
+   */
+  MemoryTracker(std::string label, int64_t limit_bytes, MemoryTracker* parent = nullptr)
+      : label_(std::move(label)), limit_bytes_(limit_bytes), parent_(parent) {}
+  ~MemoryTracker();
+
+  void Consume(int64_t bytes);
+  void Release(int64_t bytes) { Consume(-bytes); }
+
+  int64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+  int64_t peak_bytes() const { return peak_bytes_.load(std::memory_order_relaxed); }
+  int64_t limit_bytes() const { return limit_bytes_; }
+
+  /**
+   * Returns a ResourceUnavailable error if the tracked bytes exceed the limit.
+   */
+  Status CheckLimit() const;
+
+ private:
+  const std::string label_;
+  const int64_t limit_bytes_;
+  MemoryTracker* const parent_;
+  std::atomic<int64_t> bytes_ = 0;
+  std::atomic<int64_t> peak_bytes_ = 0;
+};
+
+/**
+ * MemoryReservation holds the bytes of one data structure of a query in its tracker, like the hash
+ * table of an operator, whose size is estimated rather than allocated from the query's pool.
+ * The bytes are released when the reservation is destroyed.
+ */
+class MemoryReservation : public NotCopyable {
+ public:
+  MemoryReservation() = default;
+  ~MemoryReservation() { Reset(); }
+
+  void set_tracker(std::shared_ptr<MemoryTracker> tracker) {
+    Reset();
+    tracker_ = std::move(tracker);
+  }
+
+  /**
+   * Updates the reserved bytes, and returns an error if that puts the query over its limit.
+   */
+  Status Set(int64_t bytes);
+  Status Add(int64_t bytes) { return Set(bytes_ + bytes); }
+  // Releases all of the reserved bytes.
+  void Reset();
+
+  int64_t bytes() const { return bytes_; }
+
+ private:
+  std::shared_ptr<MemoryTracker> tracker_;
+  int64_t bytes_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
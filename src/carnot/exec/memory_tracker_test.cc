@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/carnot/exec/memory_tracker.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(MemoryTrackerTest, counts_in_parent) {
+  MemoryTracker node("Queries", /* limit_bytes */ 0);
+  {
+    MemoryTracker query("Query 1", /* limit_bytes */ 100, &node);
+    query.Consume(80);
+    query.Release(30);
+    query.Consume(40);
+    EXPECT_EQ(90, query.bytes());
+    EXPECT_EQ(90, query.peak_bytes());
+    EXPECT_EQ(90, node.bytes());
+    EXPECT_OK(query.CheckLimit());
+
+    query.Consume(20);
+    EXPECT_NOT_OK(query.CheckLimit());
+    EXPECT_OK(node.CheckLimit());
+  }
+  // The bytes of a destroyed tracker are released from its parent.
+  EXPECT_EQ(0, node.bytes());
+  EXPECT_EQ(110, node.peak_bytes());
+}
+
+TEST(MemoryTrackerTest, reservation) {
+  auto tracker = std::make_shared<MemoryTracker>("Query 1", /* limit_bytes */ 100);
+  {
+    MemoryReservation reservation;
+    reservation.set_tracker(tracker);
+    EXPECT_OK(reservation.Set(60));
+    EXPECT_OK(reservation.Add(20));
+    EXPECT_EQ(80, tracker->bytes());
+
+    auto s = reservation.Set(120);
+    EXPECT_EQ(statuspb::RESOURCE_UNAVAILABLE, s.code());
+    EXPECT_EQ(120, tracker->bytes());
+
+    EXPECT_OK(reservation.Set(10));
+    EXPECT_EQ(10, tracker->bytes());
+  }
+  EXPECT_EQ(0, tracker->bytes());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
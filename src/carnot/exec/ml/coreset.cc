@@ -16,16 +16,57 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <cstring>
 #include <memory>
+#include <string>
+
+#include <absl/strings/escaping.h>
 
 #include "src/carnot/exec/ml/coreset.h"
 #include "src/carnot/exec/ml/sampling.h"
 
+DEFINE_int32(carnot_coreset_merge_threads,
+             gflags::Int32FromEnv("PL_CARNOT_CORESET_MERGE_THREADS", 4),
+             "The number of threads that construct the coresets of merged coreset trees.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
+std::string WeightedPointSet::EncodeFloat16(const Eigen::MatrixXf& points) {
+  std::string raw(points.size() * sizeof(uint16_t), '\0');
+  char* out = raw.data();
+  for (int i = 0; i < points.rows(); i++) {
+    for (int j = 0; j < points.cols(); j++) {
+      uint16_t bits = Eigen::numext::bit_cast<uint16_t>(Eigen::half(points(i, j)));
+      std::memcpy(out, &bits, sizeof(bits));
+      out += sizeof(bits);
+    }
+  }
+  return absl::Base64Escape(raw);
+}
+
+bool WeightedPointSet::DecodeFloat16(std::string_view encoded, int rows, int cols,
+                                     Eigen::MatrixXf* points) {
+  std::string raw;
+  if (!absl::Base64Unescape(encoded, &raw) ||
+      raw.size() != static_cast<size_t>(rows) * cols * sizeof(uint16_t)) {
+    return false;
+  }
+  points->resize(rows, cols);
+  const char* in = raw.data();
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      uint16_t bits;
+      std::memcpy(&bits, in, sizeof(bits));
+      in += sizeof(bits);
+      (*points)(i, j) = static_cast<float>(Eigen::numext::bit_cast<Eigen::half>(bits));
+    }
+  }
+  return true;
+}
+
 void KMeansCoreset::Construct(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
   auto weight_sum = weights.sum();
   auto weighted_mean = ((weights.transpose() * points) / weight_sum).eval();
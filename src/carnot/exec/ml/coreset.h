@@ -24,14 +24,18 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include <absl/strings/substitute.h>
 #include "third_party/eigen3/Eigen/Core"
 
+#include "src/carnot/exec/ml/parallel.h"
 #include "src/common/base/base.h"
 
+DECLARE_int32(carnot_coreset_merge_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -39,7 +43,7 @@ namespace ml {
 
 class WeightedPointSet {
  public:
-  WeightedPointSet() : size_(0) {}
+  WeightedPointSet() : size_(0), point_size_(0) {}
   WeightedPointSet(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
     DCHECK_EQ(points.rows(), weights.rows());
     size_ = points.rows();
@@ -71,18 +75,18 @@ class WeightedPointSet {
     return union_set;
   }
 
+  /**
+   * Writes the points as base64 encoded half precision floats, which are precise enough for
+   * clustering and a fraction of the size of their decimal form. FromJSON() also reads the points
+   * as arrays of numbers.
+   */
   void ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writer) {
     writer->StartObject();
-    writer->Key("points");
-    writer->StartArray();
-    for (int i = 0; i < size_; i++) {
-      writer->StartArray();
-      for (int j = 0; j < point_size_; j++) {
-        writer->Double(points_(i, j));
-      }
-      writer->EndArray();
-    }
-    writer->EndArray();
+    writer->Key("point_size");
+    writer->Int(point_size_);
+    writer->Key("points_f16");
+    std::string points = EncodeFloat16(points_.topRows(size_));
+    writer->String(points.data(), points.size());
     writer->Key("weights");
     writer->StartArray();
     for (int i = 0; i < size_; i++) {
@@ -94,10 +98,25 @@ class WeightedPointSet {
 
   void FromJSON(const rapidjson::Document::ValueType& doc) {
     DCHECK(doc.IsObject());
-    DCHECK(doc.HasMember("points"));
-    DCHECK(doc["points"].IsArray());
     DCHECK(doc.HasMember("weights"));
     DCHECK(doc["weights"].IsArray());
+    if (doc.HasMember("points_f16")) {
+      DCHECK(doc.HasMember("point_size"));
+      const rapidjson::Value& weights = doc["weights"];
+      size_ = weights.Size();
+      point_size_ = doc["point_size"].GetInt();
+      weights_.resize(size_);
+      for (rapidjson::SizeType i = 0; i < weights.Size(); i++) {
+        weights_(i) = weights[i].GetFloat();
+      }
+      const rapidjson::Value& points = doc["points_f16"];
+      bool decoded = DecodeFloat16(std::string_view(points.GetString(), points.GetStringLength()),
+                                   size_, point_size_, &points_);
+      DCHECK(decoded) << "Invalid encoded points.";
+      return;
+    }
+    DCHECK(doc.HasMember("points"));
+    DCHECK(doc["points"].IsArray());
 
     const rapidjson::Value& points = doc["points"];
     const rapidjson::Value& weights = doc["weights"];
@@ -130,6 +149,12 @@ class WeightedPointSet {
   int point_size() const { return point_size_; }
   int size() const { return size_; }
 
+  /**
+   * Encodes the points in row major order as base64 encoded half precision floats.
+   */
+  static std::string EncodeFloat16(const Eigen::MatrixXf& points);
+  static bool DecodeFloat16(std::string_view encoded, int rows, int cols, Eigen::MatrixXf* points);
+
  protected:
   int size_;
   int point_size_;
@@ -164,24 +189,23 @@ class CoresetTree {
   CoresetTree(size_t r, size_t coreset_size) : coreset_size_(coreset_size), r_(r) {}
 
   void Update(std::shared_ptr<WeightedPointSet> set) {
+    Insert(std::move(set));
+    Compact();
+  }
+
+  /**
+   * Adds a bucket to the lowest level, without coresetting the levels that fill up. Coreset()
+   * coresets them, so that a series of merges coresets all of the levels at once.
+   */
+  void Insert(std::shared_ptr<WeightedPointSet> set) {
     if (levels_.size() == 0) {
       levels_.emplace_back();
     }
-    levels_[0].push_back(set);
-    auto i = 0UL;
-    while (levels_[i].size() >= r_) {
-      auto merged =
-          TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
-      levels_[i].clear();
-      if (levels_.size() <= i + 1) {
-        levels_.emplace_back();
-      }
-      levels_[i + 1].push_back(std::move(merged));
-      i++;
-    }
+    levels_[0].push_back(std::move(set));
   }
 
   std::shared_ptr<WeightedPointSet> Coreset() {
+    Compact();
     std::vector<std::shared_ptr<WeightedPointSet>> flat_levels;
     for (const auto& [i, level] : Enumerate(levels_)) {
       if (level.size() > 0) {
@@ -194,30 +218,46 @@ class CoresetTree {
     return WeightedPointSet::Union(flat_levels);
   }
 
+  /**
+   * Adds the buckets of the other tree to the levels of this one. The levels are coreset by the
+   * next call to Coreset(), so that merging the trees of many agents builds one tree of coresets
+   * over all of their buckets, rather than coresetting after each merge.
+   */
   void Merge(const CoresetTree<TCoreset>& other) {
-    for (auto i = 0UL; i < levels_.size(); i++) {
-      if (i < other.levels_.size() && other.levels_[i].size() > 0) {
-        levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
-      }
+    if (levels_.size() < other.levels_.size()) {
+      levels_.resize(other.levels_.size());
     }
-    for (auto i = levels_.size(); i < other.levels_.size(); i++) {
-      if (other.levels_[i].size() > 0) {
-        levels_.emplace_back();
-        levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
-      }
+    for (auto i = 0UL; i < other.levels_.size(); i++) {
+      levels_[i].insert(levels_[i].end(), other.levels_[i].begin(), other.levels_[i].end());
     }
+  }
 
-    // Fix the r-way tree by coresetting any levels that have r or more buckets after merge.
+  /**
+   * Fixes the r-way tree, by coresetting each r buckets of a level into a bucket of the next level
+   * until all of the levels have fewer than r buckets. The coresets of a level are independent of
+   * each other, so they are constructed on up to FLAGS_carnot_coreset_merge_threads threads.
+   */
+  void Compact() {
     for (auto i = 0UL; i < levels_.size(); i++) {
-      if (levels_[i].size() >= r_) {
-        auto merged =
-            TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
-        levels_[i].clear();
-        if (i == levels_.size() - 1) {
-          levels_.emplace_back();
-        }
-        levels_[i + 1].push_back(std::move(merged));
+      size_t num_groups = levels_[i].size() / r_;
+      if (num_groups == 0) {
+        continue;
+      }
+      Level merged(num_groups);
+      const Level& level = levels_[i];
+      ParallelFor(num_groups, FLAGS_carnot_coreset_merge_threads, /* min_per_thread */ 1,
+                  [&](int64_t begin, int64_t end) {
+                    for (int64_t g = begin; g < end; ++g) {
+                      Level group(level.begin() + g * r_, level.begin() + (g + 1) * r_);
+                      merged[g] = TCoreset::FromWeightedPointSet(WeightedPointSet::Union(group),
+                                                                 coreset_size_);
+                    }
+                  });
+      levels_[i].erase(levels_[i].begin(), levels_[i].begin() + num_groups * r_);
+      if (levels_.size() <= i + 1) {
+        levels_.emplace_back();
       }
+      levels_[i + 1].insert(levels_[i + 1].end(), merged.begin(), merged.end());
     }
   }
 
@@ -312,7 +352,7 @@ class CoresetDriver {
     coreset_data_.Merge(other.coreset_data_);
     auto new_set = WeightedPointSet::Union({CurrentSet(), other.CurrentSet()});
     if (new_set->size() >= m_) {
-      coreset_data_.Update(new_set);
+      coreset_data_.Insert(new_set);
       size_ = 0;
     } else {
       GatherPointsFromSet(new_set);
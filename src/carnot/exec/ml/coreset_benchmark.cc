@@ -18,6 +18,9 @@
 
 #include <benchmark/benchmark.h>
 
+#include <string>
+#include <vector>
+
 #include "src/carnot/exec/ml/coreset.h"
 #include "src/common/perf/perf.h"
 
@@ -111,9 +114,37 @@ static void BM_CoresetDeserialize(benchmark::State& state) {
   }
 }
 
+// Merges the serialized coresets of state.range(0) agents, the way Kelvin merges the partial
+// aggregates it receives from the PEMs.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetMergeAgents(benchmark::State& state) {
+  int d = 64;
+  int num_agents = state.range(0);
+  std::vector<std::string> partials;
+  for (int i = 0; i < num_agents; i++) {
+    CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+    for (int j = 0; j < 10000; j++) {
+      driver.Update(Eigen::VectorXf::Random(d));
+    }
+    partials.push_back(driver.ToJSON());
+  }
+
+  for (auto _ : state) {
+    CoresetDriver<CoresetTree<KMeansCoreset>> merged(64, d, 4, 64);
+    for (const auto& partial : partials) {
+      CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+      driver.FromJSON(partial);
+      merged.Merge(driver);
+    }
+    benchmark::DoNotOptimize(merged.Query());
+  }
+  state.counters["bytes_per_agent"] = partials[0].size();
+}
+
 BENCHMARK(BM_CoresetTreeUpdate);
 BENCHMARK(BM_CoresetFromWeightedPointSet);
 BENCHMARK(BM_CoresetTreeQuery);
 BENCHMARK(BM_CoresetTreeMerge);
 BENCHMARK(BM_CoresetSerialize);
 BENCHMARK(BM_CoresetDeserialize);
+BENCHMARK(BM_CoresetMergeAgents)->RangeMultiplier(4)->Range(1, 64);
@@ -19,6 +19,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include "src/carnot/exec/ml/coreset.h"
 
 namespace px {
@@ -105,6 +107,37 @@ TEST(CoresetDriver, serialization) {
   EXPECT_EQ(256, point_set->size());
 }
 
+TEST(CoresetTree, merge_many_trees) {
+  int d = 8;
+  CoresetTree<KMeansCoreset> merged(4, 8);
+  for (int agent = 0; agent < 16; agent++) {
+    CoresetTree<KMeansCoreset> tree(4, 8);
+    // 3 buckets stay on the first level of each tree.
+    for (int i = 0; i < 3; i++) {
+      tree.Update(std::make_shared<WeightedPointSet>(Eigen::MatrixXf::Random(8, d),
+                                                     Eigen::VectorXf::Ones(8)));
+    }
+    merged.Merge(tree);
+  }
+  // The 48 buckets of the first level are coreset into 12 buckets on the second level, which are
+  // coreset into 3 buckets on the third level.
+  auto coreset = merged.Coreset();
+  EXPECT_EQ(3 * 8, coreset->size());
+  EXPECT_EQ(d, coreset->point_size());
+}
+
+TEST(WeightedPointSet, float16_encoding) {
+  Eigen::MatrixXf points = 100 * Eigen::MatrixXf::Random(20, 5);
+  std::string encoded = WeightedPointSet::EncodeFloat16(points);
+  // Two bytes per value, base64 encoded.
+  EXPECT_EQ((20 * 5 * 2 + 2) / 3 * 4, encoded.size());
+
+  Eigen::MatrixXf decoded;
+  ASSERT_TRUE(WeightedPointSet::DecodeFloat16(encoded, 20, 5, &decoded));
+  EXPECT_TRUE(decoded.isApprox(points, 1e-3f));
+  EXPECT_FALSE(WeightedPointSet::DecodeFloat16(encoded, 20, 6, &decoded));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
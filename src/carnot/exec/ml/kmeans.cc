@@ -17,8 +17,15 @@
  */
 
 #include "src/carnot/exec/ml/kmeans.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <random>
+#include <vector>
 
+#include "src/carnot/exec/ml/parallel.h"
 #include "src/carnot/exec/ml/sampling.h"
 
 namespace px {
@@ -26,6 +33,15 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
+namespace {
+
+// Assigning fewer points than this on a thread costs more than it saves.
+constexpr int64_t kMinRowsPerThread = 1024;
+// The number of points whose distances to the centroids are computed at once.
+constexpr int64_t kBlockRows = 256;
+
+}  // namespace
+
 void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
   if (set->size() < 2) {
     LOG(ERROR) << "Fitting KMeans on less than 2 points is currently unsupported.";
@@ -40,24 +56,190 @@ void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
       KMeansPlusPlusInit(points, weights);
   }
 
-  int iter_count = 0;
-  bool changed = true;
-  while (iter_count < max_iters_ && changed) {
-    changed = LloydsIteration(points, weights);
-    iter_count++;
+  switch (algorithm_) {
+    case KMeans::kLloyd:
+      FitLloyd(points, weights);
+      break;
+    case KMeans::kHamerly:
+      FitHamerly(points, weights);
+      break;
+    case KMeans::kMiniBatch:
+      FitMiniBatch(points, weights);
+      break;
+  }
+}
+
+void KMeans::FitLloyd(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+  std::vector<Eigen::Index> assignments(points.rows());
+  for (int iter = 0; iter < max_iters_; ++iter) {
+    AssignClosest(points, &assignments);
+    if (!UpdateCentroids(points, weights, assignments)) {
+      return;
+    }
+  }
+}
+
+void KMeans::FitHamerly(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+  const int64_t n = points.rows();
+  std::vector<Eigen::Index> assignments(n);
+  // The upper bound of the distance of each point to its assigned centroid, and the lower bound of
+  // its distance to any other centroid.
+  Eigen::VectorXf upper(n);
+  Eigen::VectorXf lower(n);
+  std::vector<Eigen::Index> rows(n);
+  std::iota(rows.begin(), rows.end(), 0);
+  AssignClosestTwo(points, rows, &assignments, &upper, &lower);
+
+  std::vector<uint8_t> needs_scan(n);
+  for (int iter = 1;; ++iter) {
+    Eigen::MatrixXf prev_centroids = centroids_;
+    if (!UpdateCentroids(points, weights, assignments) || iter >= max_iters_) {
+      return;
+    }
+
+    // Moving the centroids moves the bounds by at most as much, by the triangle inequality.
+    Eigen::VectorXf moved = (centroids_ - prev_centroids).rowwise().norm();
+    Eigen::Index farthest;
+    float max_moved = moved.maxCoeff(&farthest);
+    moved(farthest) = 0.0f;
+    float second_max_moved = moved.maxCoeff();
+    moved(farthest) = max_moved;
+
+    // A point that is closer to its centroid than half the distance of that centroid to any other
+    // can't be closer to another one.
+    Eigen::VectorXf half_gap(k_);
+    for (int j = 0; j < k_; ++j) {
+      Eigen::VectorXf dists = (centroids_.rowwise() - centroids_.row(j)).rowwise().norm();
+      dists(j) = std::numeric_limits<float>::infinity();
+      half_gap(j) = dists.minCoeff() / 2;
+    }
+
+    ParallelFor(n, num_threads_, kMinRowsPerThread, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        Eigen::Index a = assignments[i];
+        upper(i) += moved(a);
+        lower(i) -= a == farthest ? second_max_moved : max_moved;
+        float bound = std::max(half_gap(a), lower(i));
+        needs_scan[i] = false;
+        if (upper(i) <= bound) {
+          continue;
+        }
+        upper(i) = (points.row(i) - centroids_.row(a)).norm();
+        needs_scan[i] = upper(i) > bound;
+      }
+    });
+
+    // Only the remaining points are compared with all of the centroids.
+    rows.clear();
+    for (int64_t i = 0; i < n; ++i) {
+      if (needs_scan[i]) {
+        rows.push_back(i);
+      }
+    }
+    AssignClosestTwo(points, rows, &assignments, &upper, &lower);
+  }
+}
+
+void KMeans::FitMiniBatch(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+  const int64_t batch_size = std::min<int64_t>(mini_batch_size_, points.rows());
+  std::uniform_int_distribution<Eigen::Index> point_dist(0, points.rows() - 1);
+  Eigen::MatrixXf batch(batch_size, points.cols());
+  Eigen::VectorXf batch_weights(batch_size);
+  std::vector<Eigen::Index> assignments(batch_size);
+  // The total weight of the points that moved each centroid so far, the more there were the less
+  // the next ones move it.
+  Eigen::VectorXf centroid_weights = Eigen::VectorXf::Zero(k_);
+
+  for (int iter = 0; iter < max_iters_; ++iter) {
+    for (int64_t b = 0; b < batch_size; ++b) {
+      Eigen::Index i = point_dist(random_gen_);
+      batch.row(b) = points.row(i);
+      batch_weights(b) = weights(i);
+    }
+    AssignClosest(batch, &assignments);
+    for (int64_t b = 0; b < batch_size; ++b) {
+      float weight = batch_weights(b);
+      if (weight <= 0.0f) {
+        continue;
+      }
+      Eigen::Index c = assignments[b];
+      centroid_weights(c) += weight;
+      float learning_rate = weight / centroid_weights(c);
+      centroids_.row(c) += learning_rate * (batch.row(b) - centroids_.row(c));
+    }
   }
 }
 
-bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+void KMeans::SquaredDistances(const Eigen::Ref<const Eigen::MatrixXf>& points,
+                              Eigen::MatrixXf* dists) const {
+  // |x - c|^2 = |x|^2 - 2 x.c + |c|^2. Computing x.c for a block of points at once is a matrix
+  // product, which Eigen vectorizes and blocks for the cache. Rounding can make tiny distances
+  // negative.
+  dists->noalias() = points * centroids_.transpose();
+  *dists = ((-2.0f * dists->array()).rowwise() +
+            centroids_.rowwise().squaredNorm().transpose().array())
+               .colwise() +
+           points.rowwise().squaredNorm().array();
+  *dists = dists->cwiseMax(0.0f);
+}
+
+void KMeans::AssignClosest(const Eigen::MatrixXf& points,
+                           std::vector<Eigen::Index>* assignments) const {
+  ParallelFor(points.rows(), num_threads_, kMinRowsPerThread, [&](int64_t begin, int64_t end) {
+    Eigen::MatrixXf dists;
+    for (int64_t block = begin; block < end; block += kBlockRows) {
+      int64_t rows = std::min(kBlockRows, end - block);
+      SquaredDistances(points.middleRows(block, rows), &dists);
+      for (int64_t i = 0; i < rows; ++i) {
+        dists.row(i).minCoeff(&(*assignments)[block + i]);
+      }
+    }
+  });
+}
+
+void KMeans::AssignClosestTwo(const Eigen::MatrixXf& points, const std::vector<Eigen::Index>& rows,
+                              std::vector<Eigen::Index>* assignments, Eigen::VectorXf* closest_dist,
+                              Eigen::VectorXf* second_closest_dist) const {
+  ParallelFor(rows.size(), num_threads_, kMinRowsPerThread, [&](int64_t begin, int64_t end) {
+    Eigen::MatrixXf block_points;
+    Eigen::MatrixXf dists;
+    for (int64_t block = begin; block < end; block += kBlockRows) {
+      int64_t num_rows = std::min(kBlockRows, end - block);
+      block_points.resize(num_rows, points.cols());
+      for (int64_t i = 0; i < num_rows; ++i) {
+        block_points.row(i) = points.row(rows[block + i]);
+      }
+      SquaredDistances(block_points, &dists);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        Eigen::Index row = rows[block + i];
+        Eigen::Index closest = 0;
+        float min_dist = std::numeric_limits<float>::infinity();
+        float second_min_dist = std::numeric_limits<float>::infinity();
+        for (int j = 0; j < k_; ++j) {
+          float dist = dists(i, j);
+          if (dist < min_dist) {
+            second_min_dist = min_dist;
+            min_dist = dist;
+            closest = j;
+          } else if (dist < second_min_dist) {
+            second_min_dist = dist;
+          }
+        }
+        (*assignments)[row] = closest;
+        (*closest_dist)(row) = std::sqrt(min_dist);
+        (*second_closest_dist)(row) = std::sqrt(second_min_dist);
+      }
+    }
+  });
+}
+
+bool KMeans::UpdateCentroids(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights,
+                             const std::vector<Eigen::Index>& assignments) {
   Eigen::MatrixXf new_centroids = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
   Eigen::ArrayXf centroid_weights = Eigen::ArrayXf::Zero(centroids_.rows());
 
   for (int i = 0; i < points.rows(); i++) {
-    Eigen::VectorXf::Index closest_centroid;
-    (centroids_.rowwise() - points(i, Eigen::all))
-        .rowwise()
-        .squaredNorm()
-        .minCoeff(&closest_centroid);
+    Eigen::Index closest_centroid = assignments[i];
     new_centroids(closest_centroid, Eigen::all) += weights(i) * points(i, Eigen::all);
     centroid_weights(closest_centroid) += weights(i);
   }
@@ -82,17 +264,15 @@ void KMeans::KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::Vect
   auto firstCentroid = dist(random_gen_);
   centroids_(0, Eigen::all) = points(firstCentroid, Eigen::all);
 
+  // The squared distance of each point to the closest of the centroids chosen so far, which only
+  // needs to be compared with the distance to the last centroid chosen.
+  Eigen::VectorXf minDist = Eigen::VectorXf::Constant(points.rows(),
+                                                      std::numeric_limits<float>::infinity());
   Eigen::VectorXf probDist(points.rows());
   for (auto i = 1; i < k_; i++) {
-    for (auto j = 0; j < probDist.rows(); j++) {
-      auto point = points(j, Eigen::all);
-      Eigen::VectorXf::Index closestCentroid;
-      auto dist = (centroids_(Eigen::seq(0, i - 1), Eigen::all).rowwise() - point)
-                      .rowwise()
-                      .squaredNorm()
-                      .minCoeff(&closestCentroid);
-      probDist(j) = weights(j) * dist;
-    }
+    minDist = minDist.cwiseMin(
+        (points.rowwise() - centroids_(i - 1, Eigen::all)).rowwise().squaredNorm());
+    probDist = weights.cwiseProduct(minDist);
     std::discrete_distribution<> pointDist(probDist.begin(), probDist.end());
     auto ind = pointDist(random_gen_);
     centroids_(i, Eigen::all) = points(ind, Eigen::all);
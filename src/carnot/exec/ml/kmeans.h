@@ -21,6 +21,7 @@
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "src/carnot/exec/ml/coreset.h"
 
@@ -34,9 +35,25 @@ class KMeans {
   enum KMeansInitType {
     kKMeansPlusPlus = 0,
   };
+  enum KMeansAlgorithm {
+    // Lloyd's iterations, which compute the distances of every point to every centroid.
+    kLloyd = 0,
+    // Lloyd's iterations that skip the points whose closest centroid can't have changed, by
+    // keeping bounds on their distances to the centroids (Hamerly, 2010). Finds the same clusters
+    // as kLloyd.
+    kHamerly = 1,
+    // Moves the centroids towards random mini-batches of the points (Sculley, 2010). Each
+    // iteration only looks at one mini-batch, which is much faster for large sets, but the
+    // clusters are approximate.
+    kMiniBatch = 2,
+  };
   explicit KMeans(int k, int max_iters = 10, KMeansInitType init_type = kKMeansPlusPlus,
-                  unsigned int seed = 42)
-      : k_(k), max_iters_(max_iters), init_type_(init_type), random_gen_(seed) {}
+                  unsigned int seed = 42, KMeansAlgorithm algorithm = kHamerly)
+      : k_(k),
+        max_iters_(max_iters),
+        init_type_(init_type),
+        algorithm_(algorithm),
+        random_gen_(seed) {}
 
   /**
    * Run kmeans on a weighted set of points.
@@ -53,16 +70,45 @@ class KMeans {
 
   const Eigen::MatrixXf& centroids() const { return centroids_; }
 
+  /**
+   * The number of threads that assign the points to their closest centroids. Sets that are too
+   * small to benefit are assigned on the calling thread.
+   */
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+  /**
+   * The number of points in each mini-batch of kMiniBatch.
+   */
+  void set_mini_batch_size(int mini_batch_size) { mini_batch_size_ = mini_batch_size; }
+
   std::string ToJSON();
   void FromJSON(std::string data);
 
  private:
-  bool LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  void FitLloyd(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  void FitHamerly(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  void FitMiniBatch(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  // Computes the squared distance of each of the points to each of the centroids.
+  void SquaredDistances(const Eigen::Ref<const Eigen::MatrixXf>& points,
+                        Eigen::MatrixXf* dists) const;
+  // Sets each assignment to the index of the centroid closest to its point.
+  void AssignClosest(const Eigen::MatrixXf& points, std::vector<Eigen::Index>* assignments) const;
+  // Sets the assignments of the given rows of the points to their closest centroids, along with
+  // their distances to the closest two centroids.
+  void AssignClosestTwo(const Eigen::MatrixXf& points, const std::vector<Eigen::Index>& rows,
+                        std::vector<Eigen::Index>* assignments, Eigen::VectorXf* closest_dist,
+                        Eigen::VectorXf* second_closest_dist) const;
+  // Moves the centroids to the weighted means of their assigned points.
+  // Returns whether they moved.
+  bool UpdateCentroids(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights,
+                       const std::vector<Eigen::Index>& assignments);
   void KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
 
   int k_;
   int max_iters_;
   KMeansInitType init_type_;
+  KMeansAlgorithm algorithm_;
+  int num_threads_ = 1;
+  int mini_batch_size_ = 1024;
   Eigen::MatrixXf centroids_;
   std::mt19937 random_gen_;
 };
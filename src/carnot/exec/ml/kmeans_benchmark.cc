@@ -40,6 +40,31 @@ static void BM_KMeansFit(benchmark::State& state) {
   }
 }
 
+// Args: algorithm, number of points, k, d, number of threads.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_KMeansFitAlgorithm(benchmark::State& state) {
+  auto algorithm = static_cast<KMeans::KMeansAlgorithm>(state.range(0));
+  int n = state.range(1);
+  int k = state.range(2);
+  int d = state.range(3);
+
+  // Clustered points, like the embeddings the scripts cluster.
+  Eigen::MatrixXf centers = Eigen::MatrixXf::Random(k, d);
+  Eigen::MatrixXf points = 0.2 * Eigen::MatrixXf::Random(n, d);
+  for (int i = 0; i < n; ++i) {
+    points.row(i) += centers.row(i % k);
+  }
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(n);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  for (auto _ : state) {
+    KMeans kmeans(k, /* max_iters */ 10, KMeans::kKMeansPlusPlus, /* seed */ 42, algorithm);
+    kmeans.set_num_threads(state.range(4));
+    kmeans.Fit(set);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_KMeansTransform(benchmark::State& state) {
   int k = 10;
@@ -59,4 +84,17 @@ static void BM_KMeansTransform(benchmark::State& state) {
 }
 
 BENCHMARK(BM_KMeansFit);
+BENCHMARK(BM_KMeansFitAlgorithm)
+    ->ArgNames({"algorithm", "n", "k", "d", "threads"})
+    ->Args({KMeans::kLloyd, 10000, 10, 64, 1})
+    ->Args({KMeans::kLloyd, 10000, 64, 64, 1})
+    ->Args({KMeans::kLloyd, 10000, 64, 256, 1})
+    ->Args({KMeans::kHamerly, 10000, 10, 64, 1})
+    ->Args({KMeans::kHamerly, 10000, 64, 64, 1})
+    ->Args({KMeans::kHamerly, 10000, 64, 256, 1})
+    ->Args({KMeans::kHamerly, 10000, 64, 256, 4})
+    ->Args({KMeans::kMiniBatch, 10000, 10, 64, 1})
+    ->Args({KMeans::kMiniBatch, 10000, 64, 64, 1})
+    ->Args({KMeans::kMiniBatch, 10000, 64, 256, 1})
+    ->Args({KMeans::kMiniBatch, 10000, 64, 256, 4});
 BENCHMARK(BM_KMeansTransform);
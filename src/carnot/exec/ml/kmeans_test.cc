@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <random>
 #include <set>
 #include <vector>
 
@@ -96,6 +97,38 @@ TEST(KMeans, trimodal_normal_dist) {
   }
 }
 
+TEST(KMeans, hamerly_matches_lloyd) {
+  int k = 8;
+  std::mt19937 gen(7);
+  std::normal_distribution<float> dist;
+  Eigen::MatrixXf points = Eigen::MatrixXf::NullaryExpr(5000, 8, [&]() { return dist(gen); });
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(5000);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  KMeans lloyd(k, /* max_iters */ 30, KMeans::kKMeansPlusPlus, /* seed */ 42, KMeans::kLloyd);
+  lloyd.Fit(set);
+  KMeans hamerly(k, /* max_iters */ 30, KMeans::kKMeansPlusPlus, /* seed */ 42, KMeans::kHamerly);
+  hamerly.set_num_threads(4);
+  hamerly.Fit(set);
+
+  EXPECT_THAT(hamerly.centroids(), IsApproxMatrix(lloyd.centroids(), 1e-4f));
+}
+
+TEST(KMeans, mini_batch_trimodal_normal_dist) {
+  int k = 3;
+
+  Eigen::MatrixXf points = kmeans_test_data();
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(60);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  KMeans kmeans(k, /* max_iters */ 20, KMeans::kKMeansPlusPlus, /* seed */ 42,
+                KMeans::kMiniBatch);
+  kmeans.set_mini_batch_size(20);
+  kmeans.Fit(set);
+
+  EXPECT_THAT(kmeans.centroids(), UnorderedRowsAre(kmeans_expected_centroids(), 0.15));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -49,6 +49,21 @@ class ModelPool {
     pool_map_[TExecutor::Type()] = std::move(pool);
   }
 
+  /**
+   * Adds num_executors executors of the model to its pool up front, so that the first queries
+   * that use the model don't pay for loading it, and concurrent queries each borrow their own.
+   */
+  template <typename TExecutor, typename... Args>
+  void WarmUp(int num_executors, Args... args) {
+    auto& pool = pool_map_[TExecutor::Type()];
+    if (pool == nullptr) {
+      pool = std::make_unique<PoolType>();
+    }
+    for (int i = 0; i < num_executors; ++i) {
+      pool->Add(std::make_unique<TExecutor>(args...));
+    }
+  }
+
   template <typename TExecutor>
   struct DerivedDeleter {
     void operator()(TExecutor* ptr) { deleter_(ptr); }
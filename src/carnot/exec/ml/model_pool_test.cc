@@ -34,6 +34,21 @@ TEST(ModelPool, basic) {
   EXPECT_EQ(kTransformer, executor->Type());
 }
 
+TEST(ModelPool, warm_up) {
+  auto p = ModelPool::Create();
+  p->WarmUp<TransformerExecutor>(2, FLAGS_embedding_dir);
+  EXPECT_EQ(2, p->pool_map_[kTransformer]->Size());
+
+  // Both of the executors can be borrowed at once, without creating another one.
+  auto executor1 = p->GetModelExecutor<TransformerExecutor>(FLAGS_embedding_dir);
+  auto executor2 = p->GetModelExecutor<TransformerExecutor>(FLAGS_embedding_dir);
+  EXPECT_NE(executor1.get(), executor2.get());
+  EXPECT_EQ(0, p->pool_map_[kTransformer]->Size());
+  executor1.reset();
+  executor2.reset();
+  EXPECT_EQ(2, p->pool_map_[kTransformer]->Size());
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
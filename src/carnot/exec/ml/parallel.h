@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace exec {
+namespace ml {
+
+/**
+ * Runs fn(begin, end) over ranges that split [0, n), on up to num_threads threads, each with at
+ * least min_per_thread of the items. Small inputs run on the calling thread only, because starting
+ * the threads would cost more than it saves.
+ */
+template <typename TFn>
+void ParallelFor(int64_t n, int num_threads, int64_t min_per_thread, TFn fn) {
+  int64_t threads = std::min<int64_t>(num_threads, n / std::max<int64_t>(min_per_thread, 1));
+  if (threads <= 1) {
+    fn(0, n);
+    return;
+  }
+  int64_t per_thread = (n + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (int64_t begin = per_thread; begin < n; begin += per_thread) {
+    workers.emplace_back(fn, begin, std::min(n, begin + per_thread));
+  }
+  fn(0, per_thread);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+}  // namespace ml
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
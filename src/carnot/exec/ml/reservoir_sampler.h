@@ -0,0 +1,267 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <absl/random/random.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+namespace ml {
+
+/**
+ * The k items with the largest random keys. Each item gets the key u^(1/w) for a uniform random u
+ * and its weight w (Efraimidis and Spirakis), so that the items are a weighted sample without
+ * replacement, and a uniform one when all of the weights are equal. The keys are kept as their
+ * logs, log(u)/w, which don't underflow for large weights.
+ *
+ * Since the sample only depends on the keys, the samples of two inputs merge into a sample of
+ * their union by keeping the k largest keys of both.
+ */
+template <typename T>
+class KeyedSample {
+ public:
+  struct Item {
+    double log_key;
+    T value;
+  };
+
+  explicit KeyedSample(size_t k) : k_(k) {}
+
+  size_t k() const { return k_; }
+  bool full() const { return items_.size() >= k_; }
+  // The items of the sample, in no particular order.
+  const std::vector<Item>& items() const { return items_; }
+
+  /**
+   * The log of the smallest key of a full sample, which the key of an item must exceed for it to
+   * enter the sample.
+   */
+  double log_threshold() const {
+    DCHECK(!items_.empty());
+    return items_.front().log_key;
+  }
+
+  /**
+   * Adds the item if its key is among the k largest, evicting the item with the smallest key.
+   */
+  void Insert(double log_key, T value) {
+    if (k_ == 0) {
+      return;
+    }
+    if (full()) {
+      if (log_key <= log_threshold()) {
+        return;
+      }
+      std::pop_heap(items_.begin(), items_.end(), SmallestKeyFirst);
+      items_.back() = Item{log_key, std::move(value)};
+    } else {
+      items_.push_back(Item{log_key, std::move(value)});
+    }
+    std::push_heap(items_.begin(), items_.end(), SmallestKeyFirst);
+  }
+
+  void Merge(const KeyedSample<T>& other) {
+    for (const auto& item : other.items_) {
+      Insert(item.log_key, item.value);
+    }
+  }
+
+ private:
+  static bool SmallestKeyFirst(const Item& a, const Item& b) { return a.log_key > b.log_key; }
+
+  size_t k_;
+  // A min-heap of the keys, so that the smallest key is at the front.
+  std::vector<Item> items_;
+};
+
+namespace internal {
+
+// A uniform random number in (0, 1).
+template <typename TGen>
+double Uniform(TGen* gen) {
+  return absl::Uniform<double>(absl::IntervalOpenOpen, *gen, 0.0, 1.0);
+}
+
+/**
+ * The log of a key u^(1/weight) for a u that is uniform in (threshold^weight, 1), which is the
+ * distribution of the key of an item that is known to enter the sample.
+ * log(t + (1 - t) * r) is computed as log(t) + log1p(expm1(-log(t)) * r), which stays accurate
+ * when the threshold t is close to one, as it is after a large number of items.
+ */
+template <typename TGen>
+double LogKeyAboveThreshold(TGen* gen, double log_threshold, double weight) {
+  double log_t = log_threshold * weight;
+  return (log_t + std::log1p(std::expm1(-log_t) * Uniform(gen))) / weight;
+}
+
+}  // namespace internal
+
+/**
+ * A uniform sample of up to k items of a stream, using Algorithm L (Li, 1994). Once the reservoir
+ * is full, it draws the number of items to skip before the next one that enters it, so that the
+ * items that are skipped cost nothing to add. The number of items that enter the reservoir grows
+ * with the log of the number of items.
+ *
+ * The items keep the keys that Algorithm L implies, so that samplers merge with Merge(), and the
+ * serialized samples of several agents merge into a uniform sample of all of their items.
+ */
+template <typename T>
+class ReservoirSampler {
+ public:
+  explicit ReservoirSampler(size_t k) : sample_(k) {}
+  ReservoirSampler(size_t k, uint64_t seed) : sample_(k), gen_(std::seed_seq{seed}) {}
+
+  void Add(const T& value) { AddBatch(&value, 1); }
+
+  void AddBatch(const T* values, size_t count) {
+    size_t i = 0;
+    for (; i < count && !sample_.full(); ++i) {
+      sample_.Insert(std::log(internal::Uniform(&gen_)), values[i]);
+    }
+    if (sample_.k() == 0) {
+      return;
+    }
+    while (i < count) {
+      if (!has_skip_) {
+        DrawSkip();
+      }
+      if (count - i <= skip_) {
+        skip_ -= count - i;
+        return;
+      }
+      i += skip_;
+      sample_.Insert(internal::LogKeyAboveThreshold(&gen_, sample_.log_threshold(), 1.0),
+                     values[i]);
+      ++i;
+      has_skip_ = false;
+    }
+  }
+
+  void Merge(const ReservoirSampler<T>& other) {
+    sample_.Merge(other.sample_);
+    // The number of items to skip is geometric, and so memoryless. It's drawn again for the new
+    // threshold.
+    has_skip_ = false;
+  }
+
+  // Adds an item that was sampled with the given key, such as one of a serialized sample.
+  void Restore(double log_key, T value) {
+    sample_.Insert(log_key, std::move(value));
+    has_skip_ = false;
+  }
+
+  size_t k() const { return sample_.k(); }
+  const std::vector<typename KeyedSample<T>::Item>& items() const { return sample_.items(); }
+
+ private:
+  void DrawSkip() {
+    // An item enters the sample with probability 1 - t, for the threshold t, so the number of
+    // items until the next one that does is geometric.
+    double skip = std::floor(std::log(internal::Uniform(&gen_)) / sample_.log_threshold());
+    skip_ = skip < kMaxSkip ? static_cast<uint64_t>(skip) : std::numeric_limits<uint64_t>::max();
+    has_skip_ = true;
+  }
+
+  static constexpr double kMaxSkip = 1e18;
+
+  KeyedSample<T> sample_;
+  absl::InsecureBitGen gen_;
+  bool has_skip_ = false;
+  uint64_t skip_ = 0;
+};
+
+/**
+ * A weighted sample of up to k items of a stream without replacement, using A-ExpJ (Efraimidis
+ * and Spirakis, 2006). Once the reservoir is full, it draws the total weight of the items to skip
+ * before the next one that enters it, so that the items that are skipped only have their weights
+ * summed. Items with weights that aren't positive are never sampled.
+ */
+template <typename T>
+class WeightedReservoirSampler {
+ public:
+  explicit WeightedReservoirSampler(size_t k) : sample_(k) {}
+  WeightedReservoirSampler(size_t k, uint64_t seed) : sample_(k), gen_(std::seed_seq{seed}) {}
+
+  void Add(const T& value, double weight) { AddBatch(&value, &weight, 1); }
+
+  template <typename TWeight>
+  void AddBatch(const T* values, const TWeight* weights, size_t count) {
+    if (sample_.k() == 0) {
+      return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      double weight = static_cast<double>(weights[i]);
+      if (!(weight > 0)) {
+        continue;
+      }
+      if (!sample_.full()) {
+        sample_.Insert(std::log(internal::Uniform(&gen_)) / weight, values[i]);
+        continue;
+      }
+      if (!has_jump_) {
+        // The weight until the next item that enters the sample is exponential.
+        jump_ = std::log(internal::Uniform(&gen_)) / sample_.log_threshold();
+        has_jump_ = true;
+      }
+      jump_ -= weight;
+      if (jump_ > 0) {
+        continue;
+      }
+      sample_.Insert(internal::LogKeyAboveThreshold(&gen_, sample_.log_threshold(), weight),
+                     values[i]);
+      has_jump_ = false;
+    }
+  }
+
+  void Merge(const WeightedReservoirSampler<T>& other) {
+    sample_.Merge(other.sample_);
+    // Like the number of items of Algorithm L, the exponential jump is memoryless.
+    has_jump_ = false;
+  }
+
+  // Adds an item that was sampled with the given key, such as one of a serialized sample.
+  void Restore(double log_key, T value) {
+    sample_.Insert(log_key, std::move(value));
+    has_jump_ = false;
+  }
+
+  size_t k() const { return sample_.k(); }
+  const std::vector<typename KeyedSample<T>::Item>& items() const { return sample_.items(); }
+
+ private:
+  KeyedSample<T> sample_;
+  absl::InsecureBitGen gen_;
+  bool has_jump_ = false;
+  double jump_ = 0;
+};
+
+}  // namespace ml
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "src/carnot/exec/ml/reservoir_sampler.h"
+
+using px::carnot::exec::ml::ReservoirSampler;
+using px::carnot::exec::ml::WeightedReservoirSampler;
+
+// Adds batches of 1024 items to a sample of state.range(0) items.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ReservoirSamplerAddBatch(benchmark::State& state) {
+  std::vector<int64_t> values(1024);
+  std::iota(values.begin(), values.end(), 0);
+  ReservoirSampler<int64_t> sampler(state.range(0));
+
+  for (auto _ : state) {
+    sampler.AddBatch(values.data(), values.size());
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ReservoirSamplerAdd(benchmark::State& state) {
+  ReservoirSampler<int64_t> sampler(state.range(0));
+  int64_t value = 0;
+
+  for (auto _ : state) {
+    sampler.Add(value++);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_WeightedReservoirSamplerAddBatch(benchmark::State& state) {
+  std::vector<int64_t> values(1024);
+  std::iota(values.begin(), values.end(), 0);
+  std::vector<double> weights(values.size());
+  std::mt19937 gen(0);
+  std::exponential_distribution<double> dist;
+  for (auto& weight : weights) {
+    weight = dist(gen);
+  }
+  WeightedReservoirSampler<int64_t> sampler(state.range(0));
+
+  for (auto _ : state) {
+    sampler.AddBatch(values.data(), weights.data(), values.size());
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// Merges the samples of state.range(0) agents, the way Kelvin merges the partial aggregates it
+// receives from the PEMs.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ReservoirSamplerMergeAgents(benchmark::State& state) {
+  int num_agents = state.range(0);
+  std::vector<int64_t> values(100000);
+  std::iota(values.begin(), values.end(), 0);
+  std::vector<ReservoirSampler<int64_t>> partials;
+  for (int i = 0; i < num_agents; i++) {
+    partials.emplace_back(100);
+    partials.back().AddBatch(values.data(), values.size());
+  }
+
+  for (auto _ : state) {
+    ReservoirSampler<int64_t> merged(100);
+    for (const auto& partial : partials) {
+      merged.Merge(partial);
+    }
+    benchmark::DoNotOptimize(merged.items());
+  }
+}
+
+BENCHMARK(BM_ReservoirSamplerAddBatch)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_ReservoirSamplerAdd)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_WeightedReservoirSamplerAddBatch)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_ReservoirSamplerMergeAgents)->RangeMultiplier(4)->Range(1, 64);
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+#include "src/carnot/exec/ml/reservoir_sampler.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+namespace ml {
+
+using ::testing::UnorderedElementsAre;
+
+template <typename TSampler>
+std::vector<int> Values(const TSampler& sampler) {
+  std::vector<int> values;
+  for (const auto& item : sampler.items()) {
+    values.push_back(item.value);
+  }
+  return values;
+}
+
+TEST(ReservoirSampler, keeps_all_items_until_full) {
+  ReservoirSampler<int> sampler(4, /*seed*/ 1);
+  sampler.Add(1);
+  sampler.Add(2);
+  sampler.Add(3);
+  EXPECT_THAT(Values(sampler), UnorderedElementsAre(1, 2, 3));
+}
+
+TEST(ReservoirSampler, samples_uniformly) {
+  constexpr int kNumItems = 100;
+  constexpr int kNumTrials = 20000;
+  std::vector<int> items(kNumItems);
+  std::iota(items.begin(), items.end(), 0);
+
+  std::vector<int> counts(kNumItems);
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    ReservoirSampler<int> sampler(10, trial);
+    // Adds the items in uneven batches, so that the skips span the batches.
+    sampler.AddBatch(items.data(), 7);
+    sampler.AddBatch(items.data() + 7, 50);
+    for (int i = 57; i < kNumItems; ++i) {
+      sampler.Add(items[i]);
+    }
+    ASSERT_EQ(10, sampler.items().size());
+    for (int value : Values(sampler)) {
+      counts[value]++;
+    }
+  }
+  // Each item is in the sample with probability 0.1.
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_NEAR(0.1, static_cast<double>(counts[i]) / kNumTrials, 0.015) << i;
+  }
+}
+
+TEST(ReservoirSampler, merge_samples_the_union_uniformly) {
+  constexpr int kNumTrials = 10000;
+  std::vector<int> large(1000, 0);
+  std::vector<int> small(100, 1);
+
+  int num_small = 0;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    ReservoirSampler<int> a(10, 2 * trial);
+    ReservoirSampler<int> b(10, 2 * trial + 1);
+    a.AddBatch(large.data(), large.size());
+    b.AddBatch(small.data(), small.size());
+    a.Merge(b);
+    ASSERT_EQ(10, a.items().size());
+    for (int value : Values(a)) {
+      num_small += value;
+    }
+  }
+  EXPECT_NEAR(100.0 / 1100, static_cast<double>(num_small) / (10 * kNumTrials), 0.01);
+}
+
+TEST(WeightedReservoirSampler, samples_proportionally_to_weight) {
+  constexpr int kNumTrials = 40000;
+  std::vector<int> items = {0, 1, 2, 3, 4};
+  std::vector<double> weights = {1, 2, 3, 4, 0};
+
+  std::vector<int> counts(items.size());
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    WeightedReservoirSampler<int> sampler(1, trial);
+    sampler.AddBatch(items.data(), weights.data(), items.size());
+    ASSERT_EQ(1, sampler.items().size());
+    counts[sampler.items()[0].value]++;
+  }
+  for (size_t i = 0; i < items.size(); ++i) {
+    EXPECT_NEAR(weights[i] / 10, static_cast<double>(counts[i]) / kNumTrials, 0.01) << i;
+  }
+}
+
+TEST(WeightedReservoirSampler, skips_items_without_weight) {
+  WeightedReservoirSampler<int> sampler(4, /*seed*/ 1);
+  sampler.Add(1, 0);
+  sampler.Add(2, -1);
+  sampler.Add(3, 0.5);
+  EXPECT_THAT(Values(sampler), UnorderedElementsAre(3));
+}
+
+TEST(WeightedReservoirSampler, merge_samples_the_union_by_weight) {
+  constexpr int kNumTrials = 10000;
+  // The heavy items have a fifth of the items and half of the weight.
+  std::vector<int> light(800, 0);
+  std::vector<int> heavy(200, 1);
+  std::vector<double> light_weights(light.size(), 1);
+  std::vector<double> heavy_weights(heavy.size(), 4);
+
+  int num_heavy = 0;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    WeightedReservoirSampler<int> a(1, 2 * trial);
+    WeightedReservoirSampler<int> b(1, 2 * trial + 1);
+    a.AddBatch(light.data(), light_weights.data(), light.size());
+    b.AddBatch(heavy.data(), heavy_weights.data(), heavy.size());
+    a.Merge(b);
+    num_heavy += a.items()[0].value;
+  }
+  EXPECT_NEAR(0.5, static_cast<double>(num_heavy) / kNumTrials, 0.02);
+}
+
+}  // namespace ml
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -18,14 +18,27 @@
 
 #include "src/carnot/exec/ml/transformer_executor.h"
 
+#include <algorithm>
+#include <vector>
+
+DEFINE_int32(carnot_transformer_max_batch_size,
+             gflags::Int32FromEnv("PL_CARNOT_TRANSFORMER_MAX_BATCH_SIZE", 32),
+             "The maximum number of docs that the Transformer model embeds per invocation.");
+DEFINE_int32(carnot_transformer_num_threads,
+             gflags::Int32FromEnv("PL_CARNOT_TRANSFORMER_NUM_THREADS", 1),
+             "The number of threads that each Transformer model invocation runs on.");
+DEFINE_bool(carnot_transformer_use_xnnpack,
+            gflags::BoolFromEnv("PL_CARNOT_TRANSFORMER_USE_XNNPACK", true),
+            "Whether to run the Transformer model with the XNNPACK delegate.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
-static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
+static int load_ints_from_json(std::string_view in, int32_t* arr, int max_num) {
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(in.data());
+  rapidjson::ParseResult ok = d.Parse(in.data(), in.size());
   // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
   if (ok == nullptr) {
     return 0;
@@ -49,57 +62,129 @@ static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
   return count;
 }
 
+void TransformerExecutor::Init(std::string model_proto_path) {
+  model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
+  if (model_ == nullptr) {
+    LOG(ERROR) << "Failed to load Transformer model from " << model_proto_path;
+    return;
+  }
+  tflite::ops::builtin::BuiltinOpResolver resolver;
+  tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
+  if (tf_interpreter_ == nullptr) {
+    LOG(ERROR) << "Failed to build Transformer interpreter";
+    return;
+  }
+  tf_interpreter_->SetNumThreads(FLAGS_carnot_transformer_num_threads);
+  if (FLAGS_carnot_transformer_use_xnnpack) {
+    TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+    options.num_threads = FLAGS_carnot_transformer_num_threads;
+    xnnpack_delegate_.reset(TfLiteXNNPackDelegateCreate(&options));
+    if (tf_interpreter_->ModifyGraphWithDelegate(xnnpack_delegate_.get()) != kTfLiteOk) {
+      // The interpreter keeps running the graph with the builtin kernels.
+      LOG(WARNING) << "Failed to apply the XNNPACK delegate to the Transformer model";
+    }
+  }
+  if (!ResizeBatch(1)) {
+    LOG(INFO) << "Failed to allocate tensors";
+  } else {
+    LOG(INFO) << "Init Transformer model";
+  }
+}
+
+bool TransformerExecutor::ResizeBatch(int batch_size) {
+  if (batch_size == batch_size_) {
+    return true;
+  }
+  batch_size_ = 0;
+  if (tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0],
+                                         {batch_size, max_length_}) != kTfLiteOk ||
+      tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  batch_size_ = batch_size;
+  return true;
+}
+
 void TransformerExecutor::Execute(std::string doc, std::string* out) {
-  // LOG(INFO) << "inputs: " << tf_interpreter_->inputs().size() << "\n";
-  // LOG(INFO) << "input(0) name: " << tf_interpreter_->GetInputName(0) << "\n";
-
-  // int t_size = tf_interpreter_->tensors_size();
-  // for (int i = 0; i < t_size; i++) {
-  //   if (tf_interpreter_->tensor(i)->name) {
-  //     LOG(INFO) << i << ": " << tf_interpreter_->tensor(i)->name << ", "
-  //               << tf_interpreter_->tensor(i)->bytes << ", "
-  //               << tf_interpreter_->tensor(i)->type;
-  //   }
-  // }
+  std::string_view doc_view = doc;
+  ExecuteChunk(1, &doc_view, out);
+}
+
+void TransformerExecutor::ExecuteBatch(const std::vector<std::string_view>& docs,
+                                       std::vector<std::string>* out) {
+  out->resize(docs.size());
+  const size_t max_batch_size = std::max(FLAGS_carnot_transformer_max_batch_size, 1);
+  for (size_t begin = 0; begin < docs.size(); begin += max_batch_size) {
+    ExecuteChunk(std::min(max_batch_size, docs.size() - begin), docs.data() + begin,
+                 out->data() + begin);
+  }
+}
+
+void TransformerExecutor::ExecuteChunk(size_t count, const std::string_view* docs,
+                                       std::string* out) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i].clear();
+  }
+  if (tf_interpreter_ == nullptr) {
+    LOG(INFO) << "Transformer model isn't initialized";
+    return;
+  }
+  if (!ResizeBatch(static_cast<int>(count))) {
+    LOG(INFO) << "Failed to allocate tensors for a batch of " << count;
+    return;
+  }
   auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
   if (input == nullptr) {
     LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
-    *out = "";
     return;
   }
 
-  auto count = load_ints_from_json(doc, input, max_length_);
-  if (count == 0) {
-    // Either input array was empty or there was an error parsing the json, either way don't
-    // continue.
-    *out = "";
-    return;
-  }
+  std::vector<bool> valid(count);
+  bool any_valid = false;
+  for (size_t i = 0; i < count; ++i) {
+    int32_t* row = input + i * max_length_;
+    auto num_tokens = load_ints_from_json(docs[i], row, max_length_);
+    // Either input array was empty or there was an error parsing the json, either way this doc
+    // gets an empty embedding, and a row of padding in the batch.
+    valid[i] = num_tokens > 0;
+    any_valid |= valid[i];
 
-  // Add 1 to each token to account for pad token.
-  for (int i = 0; i < count; i++) {
-    input[i] = input[i] + 1;
+    // Add 1 to each token to account for pad token.
+    for (int j = 0; j < num_tokens; j++) {
+      row[j] = row[j] + 1;
+    }
+    for (int j = num_tokens; j < max_length_; j++) {
+      row[j] = 0;
+    }
   }
-
-  for (int i = count; i < max_length_; i++) {
-    input[i] = 0;
+  if (!any_valid) {
+    return;
   }
 
   const int embedding_size = 256;
 
-  tf_interpreter_->Invoke();
+  if (tf_interpreter_->Invoke() != kTfLiteOk) {
+    LOG(INFO) << "Failed to invoke Transformer model";
+    return;
+  }
 
   auto output = tf_interpreter_->typed_output_tensor<float>(0);
 
-  // Copy output to json array.
-  rapidjson::StringBuffer sb;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-  writer.StartArray();
-  for (int i = 0; i < embedding_size; i++) {
-    writer.Double(output[i]);
+  // Copy each row of the output to a json array.
+  for (size_t i = 0; i < count; ++i) {
+    if (!valid[i]) {
+      continue;
+    }
+    const float* embedding = output + i * embedding_size;
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartArray();
+    for (int j = 0; j < embedding_size; j++) {
+      writer.Double(embedding[j]);
+    }
+    writer.EndArray();
+    out[i] = sb.GetString();
   }
-  writer.EndArray();
-  *out = sb.GetString();
 }
 
 }  // namespace ml
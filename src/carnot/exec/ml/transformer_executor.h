@@ -21,14 +21,22 @@
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
 #include <tensorflow/lite/interpreter.h>
 #include <tensorflow/lite/kernels/register.h>
 #include <tensorflow/lite/model.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 
+DECLARE_int32(carnot_transformer_max_batch_size);
+DECLARE_int32(carnot_transformer_num_threads);
+DECLARE_bool(carnot_transformer_use_xnnpack);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -41,24 +49,28 @@ class TransformerExecutor : public ModelExecutor {
 
   static constexpr ModelType Type() { return kTransformer; }
 
-  void Init(std::string model_proto_path) {
-    model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
-    tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {1, max_length_});
-    if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
-      LOG(INFO) << "Failed to allocate tensors";
-    } else {
-      LOG(INFO) << "Init Transformer model";
-    }
-  }
+  void Init(std::string model_proto_path);
 
   void Execute(std::string doc, std::string* out);
 
+  /**
+   * Embeds the docs, running the model on up to --carnot_transformer_max_batch_size of them
+   * per invocation. Docs that aren't valid token arrays get an empty embedding.
+   */
+  void ExecuteBatch(const std::vector<std::string_view>& docs, std::vector<std::string>* out);
+
  private:
-  std::unique_ptr<tflite::Interpreter> tf_interpreter_;
+  // Runs the model on count docs at once, resizing the batch dimension of the input if needed.
+  void ExecuteChunk(size_t count, const std::string_view* docs, std::string* out);
+  bool ResizeBatch(int batch_size);
+
+  // The model and the delegate have to outlive the interpreter.
   std::unique_ptr<tflite::FlatBufferModel> model_;
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)> xnnpack_delegate_{
+      nullptr, &TfLiteXNNPackDelegateDelete};
+  std::unique_ptr<tflite::Interpreter> tf_interpreter_;
   int max_length_ = 64;
+  int batch_size_ = 0;
 };
 
 }  // namespace ml
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/query_scheduler.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+DEFINE_int32(carnot_max_running_queries,
+             gflags::Int32FromEnv("PL_CARNOT_MAX_RUNNING_QUERIES", 3),
+             "The number of queries that run at once, 0 for no limit. Keep it below the size of "
+             "the threadpool the queries run on, so that queries waiting for data or giving way "
+             "to more important queries leave threads for the ones that take their slots.");
+DEFINE_int32(carnot_query_time_slice_ms, gflags::Int32FromEnv("PL_CARNOT_QUERY_TIME_SLICE_MS", 200),
+             "How long a query runs before it gives way to a waiting query of a higher priority, "
+             "or of a user or script that has run less.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+QueryScheduler::QueryScheduler(int max_running, std::chrono::nanoseconds time_slice)
+    : max_running_(max_running), time_slice_(time_slice) {}
+
+QueryScheduler::~QueryScheduler() {
+  // The granted tickets release their slots when they are destroyed, which needs the lock.
+  std::deque<std::shared_ptr<Ticket>> granted;
+  {
+    absl::MutexLock lock(&lock_);
+    granted.swap(granted_);
+  }
+}
+
+void QueryScheduler::set_start_callback(std::function<void()> callback) {
+  absl::MutexLock lock(&lock_);
+  start_callback_ = std::move(callback);
+}
+
+std::shared_ptr<QueryScheduler::Ticket> QueryScheduler::Register(QueryClass query_class) {
+  std::shared_ptr<Ticket> ticket;
+  bool granted;
+  {
+    absl::MutexLock lock(&lock_);
+    ticket = std::make_shared<Ticket>(this, std::move(query_class), next_seq_++);
+    AddShareLocked(&user_shares_, ticket->query_class_.user);
+    AddShareLocked(&script_shares_, ticket->script_key_);
+    waiting_.insert(ticket.get());
+    granted = GrantLocked();
+  }
+  NotifyStart(granted);
+  return ticket;
+}
+
+std::shared_ptr<QueryScheduler::Ticket> QueryScheduler::NextToStart() {
+  absl::MutexLock lock(&lock_);
+  if (granted_.empty()) {
+    return nullptr;
+  }
+  auto ticket = std::move(granted_.front());
+  granted_.pop_front();
+  return ticket;
+}
+
+int QueryScheduler::num_running() const {
+  absl::MutexLock lock(&lock_);
+  return num_running_;
+}
+
+int QueryScheduler::num_waiting() const {
+  absl::MutexLock lock(&lock_);
+  return waiting_.size();
+}
+
+QueryScheduler::Share* QueryScheduler::AddShareLocked(ShareMap* shares, const std::string& key) {
+  auto [it, inserted] = shares->try_emplace(key);
+  if (inserted) {
+    // A new share starts at the least run time of the others, rather than at zero, so that it
+    // doesn't get ahead of all of them until it catches up with the time they ran in the past.
+    int64_t min_run_time_ns = std::numeric_limits<int64_t>::max();
+    for (const auto& [other_key, share] : *shares) {
+      if (other_key != key) {
+        min_run_time_ns = std::min(min_run_time_ns, share.run_time_ns);
+      }
+    }
+    if (min_run_time_ns != std::numeric_limits<int64_t>::max()) {
+      it->second.run_time_ns = min_run_time_ns;
+    }
+  }
+  ++it->second.num_tickets;
+  return &it->second;
+}
+
+void QueryScheduler::RemoveShareLocked(ShareMap* shares, const std::string& key) {
+  auto it = shares->find(key);
+  DCHECK(it != shares->end());
+  if (--it->second.num_tickets == 0) {
+    shares->erase(it);
+  }
+}
+
+bool QueryScheduler::RunsBeforeLocked(const Ticket& a, const Ticket& b) const {
+  auto now = std::chrono::steady_clock::now();
+  auto key = [&](const Ticket& t) {
+    // The running tickets are compared with the time they have run for so far.
+    std::chrono::nanoseconds running{0};
+    if (t.state_ == Ticket::State::kRunning) {
+      running = now - t.slot_start_;
+    }
+    int64_t running_ns = running.count();
+    return std::make_tuple(-static_cast<int>(t.query_class_.priority),
+                           user_shares_.at(t.query_class_.user).run_time_ns + running_ns,
+                           script_shares_.at(t.script_key_).run_time_ns + running_ns, t.seq_);
+  };
+  return key(a) < key(b);
+}
+
+const QueryScheduler::Ticket* QueryScheduler::BestWaitingLocked() const {
+  const Ticket* best = nullptr;
+  for (const Ticket* ticket : waiting_) {
+    if (best == nullptr || RunsBeforeLocked(*ticket, *best)) {
+      best = ticket;
+    }
+  }
+  return best;
+}
+
+bool QueryScheduler::GrantLocked() {
+  bool granted_registered = false;
+  while (!waiting_.empty() && (max_running_ <= 0 || num_running_ < max_running_)) {
+    auto* ticket = const_cast<Ticket*>(BestWaitingLocked());
+    waiting_.erase(ticket);
+    if (ticket->state_ == Ticket::State::kRegistered) {
+      auto ptr = ticket->weak_from_this().lock();
+      if (ptr == nullptr) {
+        // The ticket is being destroyed, its destructor removes its shares.
+        continue;
+      }
+      granted_.push_back(std::move(ptr));
+      granted_registered = true;
+    }
+    // Waiting started tickets are woken up by the state change.
+    ticket->state_ = Ticket::State::kRunning;
+    ticket->slot_start_ = std::chrono::steady_clock::now();
+    ++num_running_;
+  }
+  return granted_registered;
+}
+
+void QueryScheduler::ReleaseLocked(Ticket* ticket) {
+  DCHECK(ticket->state_ == Ticket::State::kRunning);
+  int64_t run_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - ticket->slot_start_)
+                            .count();
+  user_shares_.at(ticket->query_class_.user).run_time_ns += run_time_ns;
+  script_shares_.at(ticket->script_key_).run_time_ns += run_time_ns;
+  --num_running_;
+}
+
+void QueryScheduler::NotifyStart(bool granted) {
+  if (!granted) {
+    return;
+  }
+  std::function<void()> callback;
+  {
+    absl::MutexLock lock(&lock_);
+    callback = start_callback_;
+  }
+  if (callback) {
+    callback();
+  }
+}
+
+bool QueryScheduler::Ticket::MaybeYield() {
+  bool granted;
+  {
+    absl::MutexLock lock(&scheduler_->lock_);
+    if (state_ != State::kRunning ||
+        std::chrono::steady_clock::now() - slot_start_ < scheduler_->time_slice_) {
+      return false;
+    }
+    const Ticket* best = scheduler_->BestWaitingLocked();
+    if (best == nullptr || !scheduler_->RunsBeforeLocked(*best, *this)) {
+      // Nothing should run first, so the query starts another time slice.
+      scheduler_->ReleaseLocked(this);
+      slot_start_ = std::chrono::steady_clock::now();
+      ++scheduler_->num_running_;
+      return false;
+    }
+    scheduler_->ReleaseLocked(this);
+    state_ = State::kWaiting;
+    scheduler_->waiting_.insert(this);
+    granted = scheduler_->GrantLocked();
+  }
+  scheduler_->NotifyStart(granted);
+  absl::MutexLock lock(&scheduler_->lock_);
+  scheduler_->lock_.Await(absl::Condition(
+      +[](State* state) { return *state == State::kRunning; }, &state_));
+  return true;
+}
+
+void QueryScheduler::Ticket::Pause() {
+  bool granted;
+  {
+    absl::MutexLock lock(&scheduler_->lock_);
+    if (state_ != State::kRunning) {
+      return;
+    }
+    scheduler_->ReleaseLocked(this);
+    state_ = State::kPaused;
+    granted = scheduler_->GrantLocked();
+  }
+  scheduler_->NotifyStart(granted);
+}
+
+void QueryScheduler::Ticket::Resume() {
+  bool granted;
+  {
+    absl::MutexLock lock(&scheduler_->lock_);
+    if (state_ != State::kPaused) {
+      return;
+    }
+    state_ = State::kWaiting;
+    scheduler_->waiting_.insert(this);
+    granted = scheduler_->GrantLocked();
+  }
+  scheduler_->NotifyStart(granted);
+  absl::MutexLock lock(&scheduler_->lock_);
+  scheduler_->lock_.Await(absl::Condition(
+      +[](State* state) { return *state == State::kRunning; }, &state_));
+}
+
+void QueryScheduler::Ticket::Finish() {
+  bool granted;
+  {
+    absl::MutexLock lock(&scheduler_->lock_);
+    switch (state_) {
+      case State::kFinished:
+        return;
+      case State::kRunning:
+        scheduler_->ReleaseLocked(this);
+        break;
+      case State::kRegistered:
+      case State::kWaiting:
+        scheduler_->waiting_.erase(this);
+        break;
+      case State::kPaused:
+        break;
+    }
+    state_ = State::kFinished;
+    scheduler_->RemoveShareLocked(&scheduler_->user_shares_, query_class_.user);
+    scheduler_->RemoveShareLocked(&scheduler_->script_shares_, script_key_);
+    granted = scheduler_->GrantLocked();
+  }
+  scheduler_->NotifyStart(granted);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_cat.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_max_running_queries);
+DECLARE_int32(carnot_query_time_slice_ms);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+enum class QueryPriority { kLow = 0, kNormal = 1, kHigh = 2 };
+
+/**
+ * How a query is scheduled. Queries of a higher priority run first. Queries of the same priority
+ * share the run slots fairly between users, and then between the scripts of a user.
+ */
+struct QueryClass {
+  QueryPriority priority = QueryPriority::kNormal;
+  std::string user;
+  std::string script;
+};
+
+/**
+ * QueryScheduler hands out a fixed number of run slots to queries.
+ *
+ * A query registers for a ticket when it arrives, and starts once the scheduler grants its ticket
+ * a slot. Waiting tickets are granted slots by priority, and within a priority to the user and then
+ * the script that have run the least, as measured by the time their queries held slots.
+ *
+ * Running queries cooperate with the scheduler: they give up their slot while they wait for data,
+ * and when they have used up their time slice while a query that should run first is waiting.
+ * They keep their thread while they wait to get a slot back.
+ */
+class QueryScheduler : public NotCopyable {
+ public:
+  class Ticket;
+
+  /**
+   * @param max_running The number of run slots, or 0 for no limit.
+   * @param time_slice How long a query runs before it gives way to a query that should run first.
+   */
+  QueryScheduler(int max_running, std::chrono::nanoseconds time_slice);
+  QueryScheduler()
+      : QueryScheduler(FLAGS_carnot_max_running_queries,
+                       std::chrono::milliseconds(FLAGS_carnot_query_time_slice_ms)) {}
+  // The scheduler must outlive the tickets that were handed out.
+  ~QueryScheduler();
+
+  /**
+   * Sets the callback that is called whenever a registered query is granted a slot, and can be
+   * returned by NextToStart(). It is called without holding any locks, from any thread.
+   */
+  void set_start_callback(std::function<void()> callback);
+
+  /**
+   * Registers a query that is about to be started, it starts once NextToStart() returns its ticket.
+   * Destroying the ticket releases its slot.
+   */
+  std::shared_ptr<Ticket> Register(QueryClass query_class);
+
+  /**
+   * Returns a registered ticket that was granted a slot, or nullptr if there is none.
+   */
+  std::shared_ptr<Ticket> NextToStart();
+
+  int num_running() const;
+  int num_waiting() const;
+
+ private:
+  friend class Ticket;
+
+  // The time the queries of a user or a script held slots.
+  struct Share {
+    int64_t run_time_ns = 0;
+    int num_tickets = 0;
+  };
+  using ShareMap = absl::flat_hash_map<std::string, Share>;
+
+  Share* AddShareLocked(ShareMap* shares, const std::string& key)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void RemoveShareLocked(ShareMap* shares, const std::string& key)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Whether ticket a should get a slot before ticket b.
+  bool RunsBeforeLocked(const Ticket& a, const Ticket& b) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  const Ticket* BestWaitingLocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Grants the free slots to the best waiting tickets. Returns true if registered tickets were
+  // granted a slot, so that the start callback needs to be called.
+  bool GrantLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Accounts the time the ticket held its slot and frees it.
+  void ReleaseLocked(Ticket* ticket) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void NotifyStart(bool granted);
+
+  const int max_running_;
+  const std::chrono::nanoseconds time_slice_;
+
+  mutable absl::Mutex lock_;
+  std::function<void()> start_callback_ ABSL_GUARDED_BY(lock_);
+  int num_running_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t next_seq_ ABSL_GUARDED_BY(lock_) = 0;
+  // The tickets waiting for a slot, both registered ones and running ones that gave up theirs.
+  absl::flat_hash_set<Ticket*> waiting_ ABSL_GUARDED_BY(lock_);
+  // The registered tickets that were granted a slot, in the order they were granted.
+  std::deque<std::shared_ptr<Ticket>> granted_ ABSL_GUARDED_BY(lock_);
+  ShareMap user_shares_ ABSL_GUARDED_BY(lock_);
+  ShareMap script_shares_ ABSL_GUARDED_BY(lock_);
+};
+
+/**
+ * The place of a query in the scheduler.
+ */
+class QueryScheduler::Ticket : public NotCopyable,
+                               public std::enable_shared_from_this<QueryScheduler::Ticket> {
+ public:
+  Ticket(QueryScheduler* scheduler, QueryClass query_class, int64_t seq)
+      : scheduler_(scheduler),
+        query_class_(std::move(query_class)),
+        script_key_(absl::StrCat(query_class_.user, "/", query_class_.script)),
+        seq_(seq) {}
+  ~Ticket() { Finish(); }
+
+  /**
+   * Gives up the slot if the query has used up its time slice and a query that should run first
+   * is waiting, and blocks until the query gets a slot again.
+   * @return true if the query gave up its slot.
+   */
+  bool MaybeYield();
+
+  /**
+   * Gives up the slot while the query waits for data, Resume() blocks until it gets one again.
+   */
+  void Pause();
+  void Resume();
+
+  /**
+   * Releases the slot of the query once it's done.
+   */
+  void Finish();
+
+  const QueryClass& query_class() const { return query_class_; }
+
+ private:
+  friend class QueryScheduler;
+
+  enum class State {
+    // Registered, and waiting for its first slot.
+    kRegistered,
+    // Holds a slot.
+    kRunning,
+    // Started, and blocked until it gets a slot again.
+    kWaiting,
+    // Started, and waiting for data without a slot.
+    kPaused,
+    kFinished,
+  };
+
+  QueryScheduler* const scheduler_;
+  const QueryClass query_class_;
+  const std::string script_key_;
+  // Breaks ties between tickets in the order they were registered.
+  const int64_t seq_;
+
+  State state_ ABSL_GUARDED_BY(scheduler_->lock_) = State::kRegistered;
+  // When the ticket got its current slot.
+  std::chrono::steady_clock::time_point slot_start_ ABSL_GUARDED_BY(scheduler_->lock_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
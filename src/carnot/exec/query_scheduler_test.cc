@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "src/carnot/exec/query_scheduler.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using std::chrono_literals::operator""ms;
+
+class QuerySchedulerTest : public ::testing::Test {
+ protected:
+  // Waits for the scheduler to grant a registered ticket a slot.
+  std::shared_ptr<QueryScheduler::Ticket> WaitToStart(QueryScheduler* scheduler) {
+    while (true) {
+      auto ticket = scheduler->NextToStart();
+      if (ticket != nullptr) {
+        return ticket;
+      }
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+};
+
+TEST_F(QuerySchedulerTest, grants_slots_by_priority) {
+  QueryScheduler scheduler(/* max_running */ 1, /* time_slice */ 0ms);
+  std::atomic<int> num_started = 0;
+  scheduler.set_start_callback([&] { ++num_started; });
+
+  auto running = scheduler.Register({QueryPriority::kNormal, "user", "script"});
+  EXPECT_EQ(running, scheduler.NextToStart());
+  EXPECT_EQ(1, num_started);
+
+  auto low = scheduler.Register({QueryPriority::kLow, "user", "script"});
+  auto high = scheduler.Register({QueryPriority::kHigh, "user", "script"});
+  EXPECT_EQ(nullptr, scheduler.NextToStart());
+  EXPECT_EQ(1, scheduler.num_running());
+  EXPECT_EQ(2, scheduler.num_waiting());
+
+  running->Finish();
+  EXPECT_EQ(high, scheduler.NextToStart());
+  high.reset();
+  EXPECT_EQ(low, scheduler.NextToStart());
+  EXPECT_EQ(3, num_started);
+}
+
+TEST_F(QuerySchedulerTest, shares_slots_between_users) {
+  QueryScheduler scheduler(/* max_running */ 1, /* time_slice */ 0ms);
+
+  auto first = scheduler.Register({QueryPriority::kNormal, "a", "script"});
+  EXPECT_EQ(first, scheduler.NextToStart());
+  auto second = scheduler.Register({QueryPriority::kNormal, "a", "script"});
+  auto other_user = scheduler.Register({QueryPriority::kNormal, "b", "script"});
+
+  // The user that has run the least goes first, even though it arrived later.
+  std::this_thread::sleep_for(5ms);
+  first->Finish();
+  EXPECT_EQ(other_user, scheduler.NextToStart());
+  other_user->Finish();
+  EXPECT_EQ(second, scheduler.NextToStart());
+}
+
+TEST_F(QuerySchedulerTest, yields_to_waiting_queries) {
+  QueryScheduler scheduler(/* max_running */ 1, /* time_slice */ 0ms);
+
+  auto low = scheduler.Register({QueryPriority::kLow, "a", "explore"});
+  EXPECT_EQ(low, scheduler.NextToStart());
+  // Nothing is waiting, so the query keeps its slot.
+  EXPECT_FALSE(low->MaybeYield());
+
+  auto high = scheduler.Register({QueryPriority::kHigh, "b", "dashboard"});
+  std::atomic<bool> yielded = false;
+  std::thread low_thread([&] { yielded = low->MaybeYield(); });
+
+  EXPECT_EQ(high, WaitToStart(&scheduler));
+  high->Finish();
+  low_thread.join();
+  EXPECT_TRUE(yielded);
+  EXPECT_EQ(1, scheduler.num_running());
+}
+
+TEST_F(QuerySchedulerTest, pauses_while_waiting_for_data) {
+  QueryScheduler scheduler(/* max_running */ 1, /* time_slice */ 0ms);
+
+  auto waiting_for_data = scheduler.Register({QueryPriority::kNormal, "a", "script"});
+  EXPECT_EQ(waiting_for_data, scheduler.NextToStart());
+  auto other = scheduler.Register({QueryPriority::kNormal, "a", "script"});
+  EXPECT_EQ(nullptr, scheduler.NextToStart());
+
+  waiting_for_data->Pause();
+  EXPECT_EQ(other, scheduler.NextToStart());
+
+  std::thread resume_thread([&] { waiting_for_data->Resume(); });
+  std::this_thread::sleep_for(5ms);
+  EXPECT_EQ(1, scheduler.num_waiting());
+  other.reset();
+  resume_thread.join();
+  EXPECT_EQ(1, scheduler.num_running());
+  EXPECT_EQ(0, scheduler.num_waiting());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
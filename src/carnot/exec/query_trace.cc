@@ -0,0 +1,159 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/query_trace.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+
+DEFINE_int32(carnot_query_trace_events,
+             gflags::Int32FromEnv("PL_CARNOT_QUERY_TRACE_EVENTS", 16384),
+             "The number of events kept in the trace of an analyzed query, the newest ones are "
+             "kept. 0 disables tracing.");
+DEFINE_int32(carnot_query_trace_sample_every,
+             gflags::Int32FromEnv("PL_CARNOT_QUERY_TRACE_SAMPLE_EVERY", 1),
+             "Traces one in this many batches generated by the sources of an analyzed query.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+QueryTrace::QueryTrace(size_t capacity, int sample_every)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      sample_every_(std::max(sample_every, 1)),
+      start_(std::chrono::steady_clock::now()) {}
+
+void QueryTrace::Record(EventType type, int64_t node_id,
+                        std::chrono::steady_clock::time_point start,
+                        std::chrono::steady_clock::time_point end) {
+  Event event{type, node_id, std::this_thread::get_id(),
+              std::chrono::duration_cast<std::chrono::nanoseconds>(start - start_).count(),
+              std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()};
+  absl::MutexLock lock(&lock_);
+  if (events_.size() < capacity_) {
+    events_.push_back(event);
+    return;
+  }
+  events_[next_] = event;
+  next_ = (next_ + 1) % capacity_;
+  ++num_dropped_;
+}
+
+void QueryTrace::SetNodeName(int64_t node_id, std::string name) {
+  absl::MutexLock lock(&lock_);
+  node_names_[node_id] = std::move(name);
+}
+
+std::vector<QueryTrace::Event> QueryTrace::Events() const {
+  absl::MutexLock lock(&lock_);
+  std::vector<Event> events(events_.begin() + next_, events_.end());
+  events.insert(events.end(), events_.begin(), events_.begin() + next_);
+  return events;
+}
+
+int64_t QueryTrace::num_dropped() const {
+  absl::MutexLock lock(&lock_);
+  return num_dropped_;
+}
+
+std::string_view QueryTrace::EventTypeName(EventType type) {
+  switch (type) {
+    case EventType::kGenerate:
+      return "generate";
+    case EventType::kConsume:
+      return "consume";
+    case EventType::kEvaluate:
+      return "evaluate";
+    case EventType::kArrowConversion:
+      return "arrow_conversion";
+    case EventType::kSerialize:
+      return "serialize";
+    case EventType::kGRPCSend:
+      return "grpc_send";
+    case EventType::kWaitForData:
+      return "wait_for_data";
+  }
+  return "unknown";
+}
+
+std::string QueryTrace::ToChromeTraceJSON() const {
+  std::vector<Event> events = Events();
+  absl::flat_hash_map<int64_t, std::string> node_names;
+  int64_t num_dropped;
+  {
+    absl::MutexLock lock(&lock_);
+    node_names = node_names_;
+    num_dropped = num_dropped_;
+  }
+
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  writer.Key("traceEvents");
+  writer.StartArray();
+  // The trace viewers want small thread IDs.
+  absl::flat_hash_map<std::thread::id, int> thread_ids;
+  for (const Event& event : events) {
+    auto [it, inserted] = thread_ids.try_emplace(event.thread_id, thread_ids.size() + 1);
+    std::string_view type_name = EventTypeName(event.type);
+    auto name_it = node_names.find(event.node_id);
+    std::string name = name_it == node_names.end()
+                           ? std::string(type_name)
+                           : absl::StrCat(name_it->second, " ", type_name);
+
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(name.data(), name.size());
+    writer.Key("cat");
+    writer.String(type_name.data(), type_name.size());
+    // Complete events, which have a start and a duration, in microseconds.
+    writer.Key("ph");
+    writer.String("X");
+    writer.Key("ts");
+    writer.Double(event.start_ns / 1000.0);
+    writer.Key("dur");
+    writer.Double(event.duration_ns / 1000.0);
+    writer.Key("pid");
+    writer.Int(0);
+    writer.Key("tid");
+    writer.Int(it->second);
+    writer.Key("args");
+    writer.StartObject();
+    writer.Key("node_id");
+    writer.Int64(event.node_id);
+    writer.EndObject();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.Key("otherData");
+  writer.StartObject();
+  writer.Key("dropped_events");
+  writer.Int64(num_dropped);
+  writer.EndObject();
+  writer.EndObject();
+  return sb.GetString();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
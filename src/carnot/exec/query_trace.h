@@ -0,0 +1,156 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_query_trace_events);
+DECLARE_int32(carnot_query_trace_sample_every);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * QueryTrace records the timings of the row batches of a query as they flow through its exec
+ * nodes, for finding where a slow query spends its time. Only every sample_every-th batch generated
+ * by the sources is traced, together with everything the batch causes downstream, so that the
+ * events of a traced batch nest. The events go to a ring buffer, which keeps the newest of them.
+ *
+ * The trace is exported in the Chrome trace event format, which both chrome://tracing and Perfetto
+ * load.
+ */
+class QueryTrace : public NotCopyable {
+ public:
+  enum class EventType : uint8_t {
+    kGenerate,
+    kConsume,
+    // Evaluating the expressions, and so the UDFs, of a batch.
+    kEvaluate,
+    // Converting the batches of a table to arrow arrays.
+    kArrowConversion,
+    // Converting a batch to the proto that is sent to another agent.
+    kSerialize,
+    kGRPCSend,
+    // Waiting for data from sources that have none ready.
+    kWaitForData,
+  };
+
+  struct Event {
+    EventType type;
+    // The exec node of the event, or -1 for events of the whole graph.
+    int64_t node_id;
+    std::thread::id thread_id;
+    // Since the start of the trace.
+    int64_t start_ns;
+    int64_t duration_ns;
+  };
+
+  /**
+   * A scope whose duration is recorded as an event, if the trace is set and its current batch is
+   * sampled.
+   */
+  class Span : public NotCopyable {
+   public:
+    Span(QueryTrace* trace, EventType type, int64_t node_id)
+        : trace_(trace != nullptr && trace->sampled() ? trace : nullptr),
+          type_(type),
+          node_id_(node_id) {
+      if (trace_ != nullptr) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+    ~Span() {
+      if (trace_ != nullptr) {
+        trace_->Record(type_, node_id_, start_, std::chrono::steady_clock::now());
+      }
+    }
+
+   private:
+    QueryTrace* const trace_;
+    const EventType type_;
+    const int64_t node_id_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  /**
+   * @param capacity The number of events kept.
+   * @param sample_every Traces one in this many batches.
+   */
+  QueryTrace(size_t capacity, int sample_every);
+  QueryTrace()
+      : QueryTrace(FLAGS_carnot_query_trace_events, FLAGS_carnot_query_trace_sample_every) {}
+
+  /**
+   * Starts the next batch generated by a source, and decides whether it is sampled. Only called by
+   * the thread that executes the query.
+   */
+  void StartSourceBatch() { sampled_ = num_batches_++ % sample_every_ == 0; }
+  bool sampled() const { return sampled_; }
+
+  /**
+   * Records an event regardless of the sampling, for events that are rare and worth seeing every
+   * time, like waiting for data.
+   */
+  void Record(EventType type, int64_t node_id, std::chrono::steady_clock::time_point start,
+              std::chrono::steady_clock::time_point end);
+
+  /**
+   * Names the exec node in the exported trace.
+   */
+  void SetNodeName(int64_t node_id, std::string name);
+
+  /**
+   * Returns the events in the buffer, oldest first.
+   */
+  std::vector<Event> Events() const;
+  // The number of events that were overwritten by newer ones.
+  int64_t num_dropped() const;
+
+  std::string ToChromeTraceJSON() const;
+
+  static std::string_view EventTypeName(EventType type);
+
+ private:
+  const size_t capacity_;
+  const int sample_every_;
+  const std::chrono::steady_clock::time_point start_;
+
+  int64_t num_batches_ = 0;
+  bool sampled_ = false;
+
+  mutable absl::Mutex lock_;
+  std::vector<Event> events_ ABSL_GUARDED_BY(lock_);
+  // Where the next event goes, once the buffer is full.
+  size_t next_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t num_dropped_ ABSL_GUARDED_BY(lock_) = 0;
+  absl::flat_hash_map<int64_t, std::string> node_names_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
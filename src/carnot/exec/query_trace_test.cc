@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <rapidjson/document.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/query_trace.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using EventType = QueryTrace::EventType;
+
+TEST(QueryTraceTest, samples_batches) {
+  QueryTrace trace(/* capacity */ 16, /* sample_every */ 3);
+  for (int i = 0; i < 6; ++i) {
+    trace.StartSourceBatch();
+    QueryTrace::Span generate(&trace, EventType::kGenerate, /* node_id */ 1);
+    QueryTrace::Span consume(&trace, EventType::kConsume, /* node_id */ 2);
+  }
+  // Only spans are sampled, recorded events are always kept.
+  auto now = std::chrono::steady_clock::now();
+  trace.Record(EventType::kWaitForData, /* node_id */ -1, now, now);
+
+  std::vector<QueryTrace::Event> events = trace.Events();
+  ASSERT_EQ(5, events.size());
+  // The inner span ends first.
+  EXPECT_EQ(EventType::kConsume, events[0].type);
+  EXPECT_EQ(2, events[0].node_id);
+  EXPECT_EQ(EventType::kGenerate, events[1].type);
+  EXPECT_EQ(1, events[1].node_id);
+  EXPECT_LE(events[1].start_ns, events[0].start_ns);
+  EXPECT_EQ(EventType::kWaitForData, events[4].type);
+}
+
+TEST(QueryTraceTest, keeps_newest_events) {
+  QueryTrace trace(/* capacity */ 3, /* sample_every */ 1);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; ++i) {
+    trace.Record(EventType::kConsume, /* node_id */ i, start, start + std::chrono::microseconds(i));
+  }
+
+  std::vector<QueryTrace::Event> events = trace.Events();
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(2, events[0].node_id);
+  EXPECT_EQ(3, events[1].node_id);
+  EXPECT_EQ(4, events[2].node_id);
+  EXPECT_EQ(4000, events[2].duration_ns);
+  EXPECT_EQ(2, trace.num_dropped());
+}
+
+TEST(QueryTraceTest, chrome_trace_json) {
+  QueryTrace trace(/* capacity */ 16, /* sample_every */ 1);
+  trace.SetNodeName(1, "Op(Map(\"a\"))");
+  auto start = std::chrono::steady_clock::now();
+  trace.Record(EventType::kEvaluate, /* node_id */ 1, start + std::chrono::microseconds(5),
+               start + std::chrono::microseconds(15));
+  trace.Record(EventType::kWaitForData, /* node_id */ -1, start, start);
+
+  std::string json = trace.ToChromeTraceJSON();
+  rapidjson::Document doc;
+  ASSERT_FALSE(doc.Parse(json.c_str()).HasParseError()) << json;
+  const auto& events = doc["traceEvents"];
+  ASSERT_EQ(2, events.Size());
+  EXPECT_EQ(std::string("Op(Map(\"a\")) evaluate"), events[0]["name"].GetString());
+  EXPECT_EQ(std::string("evaluate"), events[0]["cat"].GetString());
+  EXPECT_EQ(std::string("X"), events[0]["ph"].GetString());
+  EXPECT_DOUBLE_EQ(10.0, events[0]["dur"].GetDouble());
+  EXPECT_EQ(1, events[0]["args"]["node_id"].GetInt64());
+  EXPECT_EQ(1, events[0]["tid"].GetInt());
+  EXPECT_EQ(std::string("wait_for_data"), events[1]["name"].GetString());
+  EXPECT_EQ(0, doc["otherData"]["dropped_events"].GetInt64());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <absl/base/internal/spinlock.h>
+
+#include "src/carnot/exec/memory_tracker.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * The row batches that were received by the GRPC router but not consumed by their source nodes.
+ */
+struct QueuedBatchTotals {
+  std::atomic<int64_t> bytes{0};
+  std::atomic<int64_t> batches{0};
+};
+
+/**
+ * QueuedBatchTracker counts the queued row batches of a query, in the query's own totals and in
+ * the totals of the router. It is shared by the router and the query's source nodes; batches that
+ * are still queued when the last of them goes away are removed from the router's totals.
+ *
+ * Once the query runs on this agent, the queued bytes are also counted in its memory tracker.
+ */
+class QueuedBatchTracker : public NotCopyable {
+ public:
+  explicit QueuedBatchTracker(QueuedBatchTotals* router_totals) : router_totals_(router_totals) {}
+  ~QueuedBatchTracker() {
+    Update(router_totals_, -query_totals_.bytes, -query_totals_.batches);
+    if (memory_tracker_ != nullptr) {
+      memory_tracker_->Release(query_totals_.bytes);
+    }
+  }
+
+  void Add(int64_t bytes) { Count(bytes, 1); }
+  void Remove(int64_t bytes) { Count(-bytes, -1); }
+
+  void set_memory_tracker(std::shared_ptr<MemoryTracker> memory_tracker) {
+    absl::base_internal::SpinLockHolder lock(&memory_tracker_lock_);
+    if (memory_tracker_ != nullptr) {
+      return;
+    }
+    memory_tracker_ = std::move(memory_tracker);
+    memory_tracker_->Consume(query_totals_.bytes);
+  }
+
+  int64_t bytes() const { return query_totals_.bytes; }
+
+ private:
+  void Count(int64_t bytes, int64_t batches) {
+    // The lock keeps the memory tracker in sync with the query totals when it is set.
+    absl::base_internal::SpinLockHolder lock(&memory_tracker_lock_);
+    Update(&query_totals_, bytes, batches);
+    Update(router_totals_, bytes, batches);
+    if (memory_tracker_ != nullptr) {
+      memory_tracker_->Consume(bytes);
+    }
+  }
+
+  static void Update(QueuedBatchTotals* totals, int64_t bytes, int64_t batches) {
+    totals->bytes += bytes;
+    totals->batches += batches;
+  }
+
+  QueuedBatchTotals query_totals_;
+  QueuedBatchTotals* router_totals_;
+  absl::base_internal::SpinLock memory_tracker_lock_;
+  std::shared_ptr<MemoryTracker> memory_tracker_ ABSL_GUARDED_BY(memory_tracker_lock_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
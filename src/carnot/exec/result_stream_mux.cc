@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/result_stream_mux.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "src/common/uuid/uuid.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+ResultStreamMux::ResultStreamMux(
+    std::unique_ptr<carnotpb::ResultStreamMuxService::StubInterface> stub)
+    : stub_(std::move(stub)) {
+  stream_ = stub_->TransferResultChunks(&context_);
+  reader_thread_ = std::thread(&ResultStreamMux::ReadUpdates, this);
+}
+
+ResultStreamMux::~ResultStreamMux() {
+  {
+    absl::MutexLock lock(&write_lock_);
+    stream_->WritesDone();
+    writes_done_ = true;
+  }
+  // The destination ends the stream once it has read all of the requests.
+  reader_thread_.join();
+  auto s = stream_->Finish();
+  if (!s.ok()) {
+    LOG(ERROR) << "Multiplexed result stream finished with an error: " << s.error_message();
+  }
+}
+
+std::shared_ptr<ResultStreamMux::ResultStream> ResultStreamMux::Open(const sole::uuid& query_id,
+                                                                     int64_t source_id) {
+  auto result_stream = std::make_shared<ResultStream>(shared_from_this(), query_id, source_id);
+  absl::MutexLock lock(&lock_);
+  result_streams_[result_stream->key_] = result_stream.get();
+  return result_stream;
+}
+
+bool ResultStreamMux::ok() const {
+  absl::MutexLock lock(&lock_);
+  return !failed_;
+}
+
+bool ResultStreamMux::WriteRequest(const carnotpb::TransferResultChunkRequest& req) {
+  bool written;
+  {
+    absl::MutexLock lock(&write_lock_);
+    written = !writes_done_ && stream_->Write(req);
+  }
+  if (!written) {
+    absl::MutexLock lock(&lock_);
+    failed_ = true;
+  }
+  return written;
+}
+
+void ResultStreamMux::ReadUpdates() {
+  carnotpb::ResultStreamUpdate update;
+  while (stream_->Read(&update)) {
+    auto query_id = ParseUUID(update.query_id()).ConsumeValueOr(sole::uuid());
+    absl::MutexLock lock(&lock_);
+    auto it = result_streams_.find(Key{query_id, update.grpc_source_id()});
+    if (it == result_streams_.end()) {
+      continue;
+    }
+    ResultStream* result_stream = it->second;
+    if (!update.error().empty()) {
+      result_stream->error_ = update.error();
+    } else if (update.source_stopped()) {
+      result_stream->stopped_ = true;
+    } else {
+      result_stream->paused_ = update.paused();
+    }
+  }
+  // The writers that wait for a paused result stream are woken up by the failure.
+  absl::MutexLock lock(&lock_);
+  failed_ = true;
+}
+
+ResultStreamMux::ResultStream::~ResultStream() {
+  Close();
+  absl::MutexLock lock(&mux_->lock_);
+  mux_->result_streams_.erase(key_);
+}
+
+bool ResultStreamMux::ResultStream::Writable() const {
+  return !paused_ || stopped_ || !error_.empty() || mux_->failed_;
+}
+
+Status ResultStreamMux::ResultStream::Write(const carnotpb::TransferResultChunkRequest& req) {
+  {
+    absl::MutexLock lock(&mux_->lock_);
+    mux_->lock_.Await(absl::Condition(this, &ResultStream::Writable));
+    if (!error_.empty()) {
+      return error::Internal("Destination failed to take the results: $0", error_);
+    }
+    if (mux_->failed_) {
+      return error::ResourceUnavailable("Multiplexed result stream failed");
+    }
+    if (stopped_ || closed_) {
+      return Status::OK();
+    }
+  }
+  if (!mux_->WriteRequest(req)) {
+    return error::ResourceUnavailable("Multiplexed result stream failed");
+  }
+  return Status::OK();
+}
+
+void ResultStreamMux::ResultStream::Close() {
+  {
+    absl::MutexLock lock(&mux_->lock_);
+    if (closed_ || stopped_ || mux_->failed_) {
+      closed_ = true;
+      return;
+    }
+    closed_ = true;
+  }
+  carnotpb::TransferResultChunkRequest req;
+  ToProto(key_.first, req.mutable_query_id());
+  req.mutable_query_result()->set_grpc_source_id(key_.second);
+  req.mutable_query_result()->set_close_result_stream(true);
+  mux_->WriteRequest(req);
+}
+
+bool ResultStreamMux::ResultStream::stopped() const {
+  absl::MutexLock lock(&mux_->lock_);
+  return stopped_;
+}
+
+std::shared_ptr<ResultStreamMux> ResultStreamMuxPool::Get(const std::string& address,
+                                                          const std::string& ssl_targetname) {
+  absl::MutexLock lock(&lock_);
+  auto& mux = muxes_[address];
+  if (mux == nullptr || !mux->ok()) {
+    mux = std::make_shared<ResultStreamMux>(stub_generator_(address, ssl_targetname));
+  }
+  return mux;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <grpcpp/grpcpp.h>
+#include <sole.hpp>
+
+#include "src/carnot/carnotpb/carnot.grpc.pb.h"
+#include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using ResultStreamMuxStubGenerator =
+    std::function<std::unique_ptr<carnotpb::ResultStreamMuxService::StubInterface>(
+        const std::string& address, const std::string& ssl_targetname)>;
+
+/**
+ * ResultStreamMux carries the result streams of many GRPC sinks to the same destination over a
+ * single long-lived gRPC stream, rather than each sink opening a stream of its own. The requests
+ * of a result stream already name their query and source, which the destination routes them by.
+ *
+ * The destination pauses a result stream while its source has too many batches queued, and stops
+ * it once the source needs no more data. Pausing one result stream doesn't hold up the others.
+ */
+class ResultStreamMux : public NotCopyable,
+                        public std::enable_shared_from_this<ResultStreamMux> {
+ public:
+  class ResultStream;
+
+  explicit ResultStreamMux(std::unique_ptr<carnotpb::ResultStreamMuxService::StubInterface> stub);
+  // Waits for the destination to read the requests that were written.
+  ~ResultStreamMux();
+
+  /**
+   * Adds the result stream of the source of the query. The result stream keeps the mux alive.
+   */
+  std::shared_ptr<ResultStream> Open(const sole::uuid& query_id, int64_t source_id);
+
+  /**
+   * Whether the stream to the destination is still up. Once it fails, so do the result streams
+   * in it, and new result streams should use a new mux.
+   */
+  bool ok() const;
+
+ private:
+  using Key = std::pair<sole::uuid, int64_t>;
+
+  bool WriteRequest(const carnotpb::TransferResultChunkRequest& req);
+  void ReadUpdates();
+
+  std::unique_ptr<carnotpb::ResultStreamMuxService::StubInterface> stub_;
+  grpc::ClientContext context_;
+  std::unique_ptr<grpc::ClientReaderWriterInterface<carnotpb::TransferResultChunkRequest,
+                                                    carnotpb::ResultStreamUpdate>>
+      stream_;
+  std::thread reader_thread_;
+
+  // gRPC doesn't allow concurrent writes to a stream.
+  absl::Mutex write_lock_;
+  bool writes_done_ ABSL_GUARDED_BY(write_lock_) = false;
+
+  // Guards the state of the mux and of its result streams.
+  mutable absl::Mutex lock_;
+  bool failed_ ABSL_GUARDED_BY(lock_) = false;
+  absl::flat_hash_map<Key, ResultStream*> result_streams_ ABSL_GUARDED_BY(lock_);
+};
+
+/**
+ * A result stream in a mux, the requests of a single GRPC sink.
+ */
+class ResultStreamMux::ResultStream : public NotCopyable {
+ public:
+  ResultStream(std::shared_ptr<ResultStreamMux> mux, const sole::uuid& query_id,
+               int64_t source_id)
+      : mux_(std::move(mux)), key_(query_id, source_id) {}
+  // Closes the result stream if it wasn't already.
+  ~ResultStream();
+
+  /**
+   * Writes the request, once the destination resumes the result stream if it's paused. Nothing is
+   * written once the destination stopped the result stream.
+   * @return an error if the mux failed, or if the destination failed to take the results.
+   */
+  Status Write(const carnotpb::TransferResultChunkRequest& req);
+
+  /**
+   * Tells the destination that no more requests follow.
+   */
+  void Close();
+
+  // Whether the destination doesn't need any more results.
+  bool stopped() const;
+
+ private:
+  friend class ResultStreamMux;
+
+  bool Writable() const ABSL_SHARED_LOCKS_REQUIRED(mux_->lock_);
+
+  const std::shared_ptr<ResultStreamMux> mux_;
+  const Key key_;
+  // These are guarded by the lock of the mux.
+  bool paused_ = false;
+  bool stopped_ = false;
+  bool closed_ = false;
+  std::string error_;
+};
+
+/**
+ * ResultStreamMuxPool hands out a mux per destination address, shared by all queries.
+ */
+class ResultStreamMuxPool : public NotCopyable {
+ public:
+  explicit ResultStreamMuxPool(ResultStreamMuxStubGenerator stub_generator)
+      : stub_generator_(std::move(stub_generator)) {}
+
+  /**
+   * Returns the mux to the address, or a new one if there is none or it failed.
+   */
+  std::shared_ptr<ResultStreamMux> Get(const std::string& address,
+                                      const std::string& ssl_targetname);
+
+ private:
+  const ResultStreamMuxStubGenerator stub_generator_;
+  absl::Mutex lock_;
+  absl::flat_hash_map<std::string, std::shared_ptr<ResultStreamMux>> muxes_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
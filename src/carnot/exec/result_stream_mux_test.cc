@@ -0,0 +1,190 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/result_stream_mux.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/grpc_router.h"
+#include "src/carnot/exec/grpc_source_node.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/common/testing/testing.h"
+#include "src/common/uuid/uuid.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+class FakeGRPCSourceNode : public GRPCSourceNode {
+ public:
+  Status EnqueueRowBatch(std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
+    row_batches.emplace_back(std::move(row_batch));
+    return Status::OK();
+  }
+
+  std::vector<std::unique_ptr<carnotpb::TransferResultChunkRequest>> row_batches;
+};
+
+class ResultStreamMuxTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    router_ = std::make_unique<GRPCRouter>();
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials());
+    builder.RegisterService(router_.get());
+    builder.RegisterService(router_->mux_service());
+    server_ = builder.BuildAndStart();
+
+    grpc::ChannelArguments args;
+    mux_ = std::make_shared<ResultStreamMux>(
+        carnotpb::ResultStreamMuxService::NewStub(server_->InProcessChannel(args)));
+  }
+
+  void TearDown() override {
+    mux_.reset();
+    server_->Shutdown();
+  }
+
+  void AddSource(int64_t source_id, FakeGRPCSourceNode* source_node) {
+    auto plan_node = plan::GRPCSourceOperator::FromProto(
+        planpb::testutils::CreateTestGRPCSource1PB(), source_id);
+    ASSERT_OK(source_node->Init(*plan_node, input_rd_, {}));
+    ASSERT_OK(router_->AddGRPCSourceNode(query_id_, source_id, source_node, [] {}));
+  }
+
+  carnotpb::TransferResultChunkRequest InitiateRequest(int64_t source_id) {
+    carnotpb::TransferResultChunkRequest req;
+    ToProto(query_id_, req.mutable_query_id());
+    req.mutable_query_result()->set_grpc_source_id(source_id);
+    req.mutable_query_result()->set_initiate_result_stream(true);
+    return req;
+  }
+
+  carnotpb::TransferResultChunkRequest RowBatchRequest(int64_t source_id, int64_t value) {
+    auto rb = RowBatchBuilder(input_rd_, 1, /*eow*/ false, /*eos*/ false)
+                  .AddColumn<types::Int64Value>({value})
+                  .get();
+    carnotpb::TransferResultChunkRequest req;
+    ToProto(query_id_, req.mutable_query_id());
+    EXPECT_OK(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+    req.mutable_query_result()->set_grpc_source_id(source_id);
+    return req;
+  }
+
+  template <typename TPredicate>
+  void WaitFor(TPredicate predicate) {
+    while (!predicate()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  const sole::uuid query_id_ = sole::uuid4();
+  const RowDescriptor input_rd_{{types::DataType::INT64}};
+  std::unique_ptr<GRPCRouter> router_;
+  std::unique_ptr<grpc::Server> server_;
+  std::shared_ptr<ResultStreamMux> mux_;
+};
+
+TEST_F(ResultStreamMuxTest, shares_stream_between_sources) {
+  FakeGRPCSourceNode source1;
+  FakeGRPCSourceNode source2;
+  AddSource(1, &source1);
+  AddSource(2, &source2);
+
+  auto stream1 = mux_->Open(query_id_, 1);
+  auto stream2 = mux_->Open(query_id_, 2);
+  ASSERT_OK(stream1->Write(InitiateRequest(1)));
+  ASSERT_OK(stream2->Write(InitiateRequest(2)));
+  ASSERT_OK(stream1->Write(RowBatchRequest(1, 10)));
+  ASSERT_OK(stream2->Write(RowBatchRequest(2, 20)));
+  ASSERT_OK(stream1->Write(RowBatchRequest(1, 11)));
+  stream1->Close();
+  stream2->Close();
+
+  WaitFor([&] {
+    return source1.upstream_closed_connection() && source2.upstream_closed_connection();
+  });
+  EXPECT_TRUE(source1.upstream_initiated_connection());
+  EXPECT_TRUE(source2.upstream_initiated_connection());
+  ASSERT_EQ(2, source1.row_batches.size());
+  EXPECT_EQ(10, source1.row_batches[0]->query_result().row_batch().cols(0).int64_data().data(0));
+  EXPECT_EQ(11, source1.row_batches[1]->query_result().row_batch().cols(0).int64_data().data(0));
+  ASSERT_EQ(1, source2.row_batches.size());
+  EXPECT_EQ(20, source2.row_batches[0]->query_result().row_batch().cols(0).int64_data().data(0));
+  EXPECT_TRUE(mux_->ok());
+}
+
+TEST_F(ResultStreamMuxTest, stopped_source_stops_only_its_stream) {
+  FakeGRPCSourceNode source1;
+  FakeGRPCSourceNode source2;
+  AddSource(1, &source1);
+  AddSource(2, &source2);
+
+  auto stream1 = mux_->Open(query_id_, 1);
+  auto stream2 = mux_->Open(query_id_, 2);
+  ASSERT_OK(stream1->Write(InitiateRequest(1)));
+  ASSERT_OK(stream2->Write(InitiateRequest(2)));
+  ASSERT_OK(stream1->Write(RowBatchRequest(1, 10)));
+  WaitFor([&] { return source1.row_batches.size() == 1; });
+
+  router_->StopGRPCSource(query_id_, 1);
+  ASSERT_OK(stream1->Write(RowBatchRequest(1, 11)));
+  WaitFor([&] { return stream1->stopped(); });
+
+  // Nothing more is sent on the stopped stream, but the other one keeps going.
+  ASSERT_OK(stream1->Write(RowBatchRequest(1, 12)));
+  ASSERT_OK(stream2->Write(RowBatchRequest(2, 20)));
+  stream2->Close();
+  WaitFor([&] { return source2.upstream_closed_connection(); });
+  EXPECT_EQ(1, source1.row_batches.size());
+  EXPECT_EQ(1, source2.row_batches.size());
+  EXPECT_FALSE(stream2->stopped());
+}
+
+TEST_F(ResultStreamMuxTest, finished_query_stops_stream) {
+  auto stream = mux_->Open(sole::uuid4(), 1);
+  ASSERT_OK(stream->Write(RowBatchRequest(1, 10)));
+  WaitFor([&] { return stream->stopped(); });
+  EXPECT_TRUE(mux_->ok());
+}
+
+TEST_F(ResultStreamMuxTest, pool_reuses_mux) {
+  ResultStreamMuxPool pool([this](const std::string&, const std::string&) {
+    grpc::ChannelArguments args;
+    return carnotpb::ResultStreamMuxService::NewStub(server_->InProcessChannel(args));
+  });
+  auto mux1 = pool.Get("kelvin1:59300", "");
+  auto mux2 = pool.Get("kelvin1:59300", "");
+  auto mux3 = pool.Get("kelvin2:59300", "");
+  EXPECT_EQ(mux1, mux2);
+  EXPECT_NE(mux1, mux3);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,410 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/rolling_agg_node.h"
+
+#include <arrow/array.h>
+#include <arrow/array/builder_base.h>
+#include <arrow/array/builder_primitive.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <absl/strings/substitute.h>
+#include <magic_enum.hpp>
+
+#include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/udf_wrapper.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+template <types::DataType DT>
+void AppendKeyToBuilder(arrow::ArrayBuilder* builder, const RowTuple& rt, size_t rt_idx) {
+  using ArrowBuilder = typename types::DataTypeTraits<DT>::arrow_builder_type;
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  auto status =
+      static_cast<ArrowBuilder*>(builder)->Append(udf::UnWrap(rt.GetValue<ValueType>(rt_idx)));
+  PL_DCHECK_OK(status);
+  PL_UNUSED(status);
+}
+
+template <types::DataType DT>
+types::SharedColumnWrapper GatherRows(arrow::Array* arr, const std::vector<int64_t>& row_indices) {
+  auto wrapper = types::ColumnWrapper::Make(DT, 0);
+  wrapper->Reserve(row_indices.size());
+  for (int64_t row_idx : row_indices) {
+    types::ExtractValueToColumnWrapper<DT>(wrapper.get(), arr, row_idx);
+  }
+  return wrapper;
+}
+
+}  // namespace
+
+std::string RollingAggNode::DebugStringImpl() {
+  return absl::Substitute("Exec::RollingAggNode<$0>", plan_node_->DebugString());
+}
+
+Status RollingAggNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::AGGREGATE_OPERATOR);
+  const auto* agg_plan_node = static_cast<const plan::AggregateOperator*>(&plan_node);
+  if (!agg_plan_node->rolling()) {
+    return error::InvalidArgument("RollingAggNode expects a rolling aggregate");
+  }
+  plan_node_ = std::make_unique<plan::AggregateOperator>(*agg_plan_node);
+
+  if (input_descriptors_.size() != 1) {
+    return error::InvalidArgument("Aggregate operator expects a single input relation, got $0",
+                                  input_descriptors_.size());
+  }
+  input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
+
+  for (const auto& value : plan_node_->values()) {
+    if (value->ExpressionType() != plan::Expression::kAgg) {
+      return error::InvalidArgument("Aggregate operator can only use aggregate expressions");
+    }
+  }
+
+  // The output holds the groups, the start of the window and the values.
+  size_t output_size = plan_node_->groups().size() + 1 + plan_node_->values().size();
+  if (output_size != output_descriptor_->size()) {
+    return error::InvalidArgument("Output size mismatch in aggregate");
+  }
+
+  window_size_ns_ = plan_node_->window_size_ns();
+  slide_ns_ = plan_node_->window_slide_ns();
+  time_col_idx_ = plan_node_->window_time_column().idx;
+  if (time_col_idx_ >= static_cast<int64_t>(input_descriptor_->size())) {
+    return error::InvalidArgument("Rolling window column index $0 is out of bounds",
+                                  time_col_idx_);
+  }
+  time_data_type_ = input_descriptor_->type(time_col_idx_);
+  if (time_data_type_ != types::TIME64NS && time_data_type_ != types::INT64) {
+    return error::InvalidArgument("Rolling windows can't be computed over a $0 column",
+                                  magic_enum::enum_name(time_data_type_));
+  }
+
+  for (const auto& group : plan_node_->groups()) {
+    DCHECK(group.idx < input_descriptor_->size());
+    group_data_types_.emplace_back(input_descriptor_->type(group.idx));
+  }
+  return Status::OK();
+}
+
+Status RollingAggNode::PrepareImpl(ExecState* exec_state) {
+  function_ctx_ = exec_state->CreateFunctionContext();
+  return Status::OK();
+}
+
+Status RollingAggNode::OpenImpl(ExecState*) {
+  lookup_key_ = std::make_unique<RowTuple>(&group_data_types_);
+  return Status::OK();
+}
+
+Status RollingAggNode::CloseImpl(ExecState*) {
+  pane_rows_.clear();
+  groups_.clear();
+  pane_counts_.clear();
+  if (num_late_rows_ > 0) {
+    VLOG(1) << absl::Substitute("RollingAggNode dropped $0 late rows", num_late_rows_);
+  }
+  return Status::OK();
+}
+
+Status RollingAggNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  switch (time_data_type_) {
+    case types::TIME64NS:
+      PL_RETURN_IF_ERROR(AssignRowsToPanes<types::TIME64NS>(exec_state, rb));
+      break;
+    case types::INT64:
+      PL_RETURN_IF_ERROR(AssignRowsToPanes<types::INT64>(exec_state, rb));
+      break;
+    default:
+      return error::Internal("Unexpected rolling window column type $0",
+                             magic_enum::enum_name(time_data_type_));
+  }
+  for (const auto& [udas, row_indices] : pane_rows_) {
+    PL_RETURN_IF_ERROR(UpdatePane(exec_state, rb, *udas, row_indices));
+  }
+  pane_rows_.clear();
+  return EmitClosedWindows(exec_state, rb.eos());
+}
+
+template <types::DataType DT>
+Status RollingAggNode::AssignRowsToPanes(ExecState* exec_state, const RowBatch& rb) {
+  using ArrowArrayType = typename types::DataTypeTraits<DT>::arrow_array_type;
+  const int64_t* times =
+      static_cast<const ArrowArrayType*>(rb.ColumnAt(time_col_idx_).get())->raw_values();
+
+  // Consecutive rows usually belong to the same group and pane, so that lookup is cached.
+  PaneUDAs* last_pane = nullptr;
+  int64_t last_pane_start = 0;
+  int64_t last_row_idx = -1;
+  for (int64_t i = 0; i < rb.num_selected_rows(); ++i) {
+    int64_t row_idx = rb.SelectedRowIndex(i);
+    int64_t time = times[row_idx];
+    int64_t pane_start = PaneStart(time);
+    if (emitted_window_ && pane_start + window_size_ns_ <= last_window_end_) {
+      // Every window that this row belongs to has already been emitted.
+      ++num_late_rows_;
+      continue;
+    }
+    watermark_ = std::max(watermark_, time);
+
+    PaneUDAs* pane = nullptr;
+    if (last_pane != nullptr && pane_start == last_pane_start) {
+      bool same_group = true;
+      for (size_t g = 0; g < group_data_types_.size() && same_group; ++g) {
+        auto col = rb.ColumnAt(plan_node_->groups()[g].idx).get();
+#define TYPE_CASE(_dt_)                                                   \
+  same_group = types::GetValueFromArrowArray<_dt_>(col, row_idx) ==        \
+               types::GetValueFromArrowArray<_dt_>(col, last_row_idx);
+        PL_SWITCH_FOREACH_DATATYPE(group_data_types_[g], TYPE_CASE);
+#undef TYPE_CASE
+      }
+      if (same_group) {
+        pane = last_pane;
+      }
+    }
+    if (pane == nullptr) {
+      PL_ASSIGN_OR_RETURN(pane, GetOrCreatePane(exec_state, rb, row_idx, pane_start));
+    }
+    pane_rows_[pane].push_back(row_idx);
+    last_pane = pane;
+    last_pane_start = pane_start;
+    last_row_idx = row_idx;
+  }
+  return Status::OK();
+}
+
+StatusOr<RollingAggNode::PaneUDAs*> RollingAggNode::GetOrCreatePane(ExecState* exec_state,
+                                                                    const RowBatch& rb,
+                                                                    int64_t row_idx,
+                                                                    int64_t pane_start) {
+  lookup_key_->Reset();
+  for (size_t g = 0; g < group_data_types_.size(); ++g) {
+    auto col = rb.ColumnAt(plan_node_->groups()[g].idx).get();
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(lookup_key_.get(), col, g, row_idx);
+    PL_SWITCH_FOREACH_DATATYPE(group_data_types_[g], TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  auto it = groups_.find(lookup_key_.get());
+  if (it == groups_.end()) {
+    auto group = std::make_unique<GroupPanes>();
+    group->key = std::move(lookup_key_);
+    lookup_key_ = std::make_unique<RowTuple>(&group_data_types_);
+    RowTuple* key = group->key.get();
+    it = groups_.emplace(key, std::move(group)).first;
+  }
+
+  auto& panes = it->second->panes;
+  auto pane_it = panes.find(pane_start);
+  if (pane_it == panes.end()) {
+    pane_it = panes.emplace(pane_start, PaneUDAs()).first;
+    PL_RETURN_IF_ERROR(CreateUDAInfoValues(exec_state, &pane_it->second));
+    ++pane_counts_[pane_start];
+  }
+  return &pane_it->second;
+}
+
+Status RollingAggNode::UpdatePane(ExecState* exec_state, const RowBatch& rb, const PaneUDAs& udas,
+                                  const std::vector<int64_t>& row_indices) {
+  const auto& values = plan_node_->values();
+  // Each row belongs to a single pane, so a pane with all of the rows can use the arrays as is.
+  bool all_rows = static_cast<int64_t>(row_indices.size()) == rb.num_rows();
+  absl::flat_hash_map<int64_t, types::SharedColumnWrapper> gathered_cols;
+  for (size_t i = 0; i < values.size(); ++i) {
+    const auto& uda_info = udas[i];
+    auto deps = values[i]->Deps();
+    if (all_rows) {
+      std::vector<std::shared_ptr<arrow::Array>> arrays;
+      std::vector<const arrow::Array*> args;
+      for (auto* dep : deps) {
+        if (dep->ExpressionType() == plan::Expression::kColumn) {
+          arrays.push_back(rb.ColumnAt(static_cast<plan::Column*>(dep)->Index()));
+        } else {
+          arrays.push_back(EvalScalarToArrow(exec_state, *static_cast<plan::ScalarValue*>(dep),
+                                             row_indices.size()));
+        }
+        args.push_back(arrays.back().get());
+      }
+      PL_RETURN_IF_ERROR(
+          uda_info.def->ExecBatchUpdateArrow(uda_info.uda.get(), nullptr /* ctx */, args));
+      continue;
+    }
+
+    std::vector<types::SharedColumnWrapper> wrappers;
+    std::vector<const types::ColumnWrapper*> args;
+    for (auto* dep : deps) {
+      if (dep->ExpressionType() == plan::Expression::kColumn) {
+        auto col_idx = static_cast<plan::Column*>(dep)->Index();
+        auto& gathered = gathered_cols[col_idx];
+        if (gathered == nullptr) {
+          auto arr = rb.ColumnAt(col_idx).get();
+#define TYPE_CASE(_dt_) gathered = GatherRows<_dt_>(arr, row_indices);
+          PL_SWITCH_FOREACH_DATATYPE(input_descriptor_->type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+        }
+        wrappers.push_back(gathered);
+      } else {
+        wrappers.push_back(EvalScalarToColumnWrapper(
+            exec_state, *static_cast<plan::ScalarValue*>(dep), row_indices.size()));
+      }
+      args.push_back(wrappers.back().get());
+    }
+    PL_RETURN_IF_ERROR(uda_info.def->ExecBatchUpdate(uda_info.uda.get(), nullptr /* ctx */, args));
+  }
+  return Status::OK();
+}
+
+Status RollingAggNode::EmitClosedWindows(ExecState* exec_state, bool eos) {
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  for (const auto& group_dt : group_data_types_) {
+    builders.push_back(types::MakeArrowBuilder(group_dt, exec_state->exec_mem_pool()));
+  }
+  builders.push_back(types::MakeArrowBuilder(time_data_type_, exec_state->exec_mem_pool()));
+  for (const auto& value : plan_node_->values()) {
+    auto def = exec_state->GetUDADefinition(value->uda_id());
+    builders.push_back(
+        types::MakeArrowBuilder(def->finalize_return_type(), exec_state->exec_mem_pool()));
+  }
+
+  while (!pane_counts_.empty()) {
+    // The next window to emit is the first one that holds the oldest pane, skipping over the
+    // windows without any data.
+    int64_t window_end = pane_counts_.begin()->first + slide_ns_;
+    if (emitted_window_) {
+      window_end = std::max(window_end, last_window_end_ + slide_ns_);
+    }
+    if (!eos && window_end > watermark_) {
+      break;
+    }
+    for (auto it = groups_.begin(); it != groups_.end();) {
+      GroupPanes* group = it->second.get();
+      PL_RETURN_IF_ERROR(EmitWindow(exec_state, window_end, group, &builders));
+      ExpirePanes(group, window_end);
+      if (group->panes.empty()) {
+        groups_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    emitted_window_ = true;
+    last_window_end_ = window_end;
+  }
+
+  int64_t num_rows = builders[group_data_types_.size()]->length();
+  if (num_rows == 0 && !eos) {
+    return Status::OK();
+  }
+  RowBatch output_rb(*output_descriptor_, num_rows);
+  for (const auto& builder : builders) {
+    std::shared_ptr<arrow::Array> arr;
+    PL_RETURN_IF_ERROR(builder->Finish(&arr));
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(arr));
+  }
+  output_rb.set_eow(eos);
+  output_rb.set_eos(eos);
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+Status RollingAggNode::EmitWindow(ExecState* exec_state, int64_t window_end, GroupPanes* group,
+                                  std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders) {
+  int64_t window_start = window_end - window_size_ns_;
+  auto first = group->panes.lower_bound(window_start);
+  auto last = group->panes.lower_bound(window_end);
+  if (first == last) {
+    return Status::OK();
+  }
+
+  size_t num_groups = group_data_types_.size();
+  for (size_t g = 0; g < num_groups; ++g) {
+#define TYPE_CASE(_dt_) AppendKeyToBuilder<_dt_>((*builders)[g].get(), *group->key, g);
+    PL_SWITCH_FOREACH_DATATYPE(group_data_types_[g], TYPE_CASE);
+#undef TYPE_CASE
+  }
+  // INT64 and TIME64NS are both built with int64s.
+  PL_RETURN_IF_ERROR(
+      static_cast<arrow::Int64Builder*>((*builders)[num_groups].get())->Append(window_start));
+
+  for (size_t i = 0; i < plan_node_->values().size(); ++i) {
+    auto* builder = (*builders)[num_groups + 1 + i].get();
+    const auto& pane_uda = first->second[i];
+    if (IsTumbling()) {
+      // The window is a single pane, which is expired right after.
+      PL_RETURN_IF_ERROR(
+          pane_uda.def->FinalizeArrow(pane_uda.uda.get(), function_ctx_.get(), builder));
+      continue;
+    }
+    PaneUDAs window_udas;
+    PL_RETURN_IF_ERROR(CreateUDAInfoValues(exec_state, &window_udas));
+    auto* window_uda = window_udas[i].uda.get();
+    for (auto it = first; it != last; ++it) {
+      PL_RETURN_IF_ERROR(
+          pane_uda.def->Merge(window_uda, it->second[i].uda.get(), function_ctx_.get()));
+    }
+    PL_RETURN_IF_ERROR(pane_uda.def->FinalizeArrow(window_uda, function_ctx_.get(), builder));
+  }
+  return Status::OK();
+}
+
+void RollingAggNode::ExpirePanes(GroupPanes* group, int64_t window_end) {
+  // Panes that start before the next window are not needed anymore.
+  int64_t next_window_start = window_end - window_size_ns_ + slide_ns_;
+  auto end = group->panes.lower_bound(next_window_start);
+  for (auto it = group->panes.begin(); it != end; ++it) {
+    auto count_it = pane_counts_.find(it->first);
+    DCHECK(count_it != pane_counts_.end());
+    if (--count_it->second == 0) {
+      pane_counts_.erase(count_it);
+    }
+  }
+  group->panes.erase(group->panes.begin(), end);
+}
+
+Status RollingAggNode::CreateUDAInfoValues(ExecState* exec_state, PaneUDAs* udas) {
+  DCHECK(udas->empty());
+  for (const auto& value : plan_node_->values()) {
+    auto def = exec_state->GetUDADefinition(value->uda_id());
+    auto uda = def->Make();
+    std::vector<std::shared_ptr<types::BaseValueType>> init_args;
+    for (const auto& arg : value->init_arguments()) {
+      init_args.push_back(arg.ToBaseValueType());
+    }
+    PL_RETURN_IF_ERROR(def->ExecInit(uda.get(), nullptr, init_args));
+    udas->emplace_back(std::move(uda), def);
+  }
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
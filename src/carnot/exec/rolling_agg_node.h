@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/udf/udf.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * RollingAggNode evaluates rolling aggregates, which compute the aggregate values of each group
+ * for windows over a time column.
+ *
+ * The rows are aggregated into panes that are as wide as the window slide, so each row only
+ * updates the UDAs of a single pane. Once the time column has moved past the end of a window, the
+ * window is emitted by merging its panes, and the panes that don't belong to any later window are
+ * expired. Tumbling windows have a single pane, which is finalized directly. This keeps the state
+ * bounded by the window size on streaming inputs and no window is ever recomputed from scratch.
+ *
+ * The input is expected to be (mostly) ordered by time. Rows that arrive after all of the windows
+ * they belong to have been emitted are dropped.
+ */
+class RollingAggNode : public ProcessingNode {
+ public:
+  RollingAggNode() = default;
+  virtual ~RollingAggNode() = default;
+
+  bool SupportsSelection() const override { return true; }
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  // The UDAs of a single pane, one per aggregate value.
+  using PaneUDAs = std::vector<UDAInfo>;
+  struct GroupPanes {
+    std::unique_ptr<RowTuple> key;
+    // The panes of the group, by the start of the pane.
+    std::map<int64_t, PaneUDAs> panes;
+  };
+
+  int64_t PaneStart(int64_t time) const {
+    // Round down, including for negative times.
+    return time - (((time % slide_ns_) + slide_ns_) % slide_ns_);
+  }
+  bool IsTumbling() const { return slide_ns_ == window_size_ns_; }
+
+  template <types::DataType DT>
+  Status AssignRowsToPanes(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  StatusOr<PaneUDAs*> GetOrCreatePane(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                                      int64_t row_idx, int64_t pane_start);
+  Status UpdatePane(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                    const PaneUDAs& udas, const std::vector<int64_t>& row_indices);
+  Status CreateUDAInfoValues(ExecState* exec_state, PaneUDAs* udas);
+
+  // Emits every window that ended before the watermark, or all of the remaining windows at the end
+  // of the stream.
+  Status EmitClosedWindows(ExecState* exec_state, bool eos);
+  Status EmitWindow(ExecState* exec_state, int64_t window_end, GroupPanes* group,
+                    std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders);
+  void ExpirePanes(GroupPanes* group, int64_t window_end);
+
+  std::unique_ptr<plan::AggregateOperator> plan_node_;
+  std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
+  std::unique_ptr<udf::FunctionContext> function_ctx_;
+
+  int64_t window_size_ns_ = 0;
+  int64_t slide_ns_ = 0;
+  int64_t time_col_idx_ = -1;
+  types::DataType time_data_type_ = types::DataType::DATA_TYPE_UNKNOWN;
+  std::vector<types::DataType> group_data_types_;
+
+  AbslRowTupleHashMap<std::unique_ptr<GroupPanes>> groups_;
+  // The number of groups that have a pane, by the start of the pane.
+  std::map<int64_t, int64_t> pane_counts_;
+  // The rows of the current batch that update each pane.
+  absl::flat_hash_map<PaneUDAs*, std::vector<int64_t>> pane_rows_;
+  // The scratch key that the groups are looked up with.
+  std::unique_ptr<RowTuple> lookup_key_;
+
+  // The largest time seen so far. Windows that end at or before it are closed.
+  int64_t watermark_ = std::numeric_limits<int64_t>::min();
+  // The end of the last window that was emitted.
+  bool emitted_window_ = false;
+  int64_t last_window_end_ = 0;
+  int64_t num_late_rows_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/rolling_agg_node.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+using types::Int64Value;
+using types::Time64NSValue;
+
+class SumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg) { sum_ = sum_.val + arg.val; }
+  void Merge(udf::FunctionContext*, const SumUDA& other) { sum_ = sum_.val + other.sum_.val; }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
+// Sums col 2 grouped by col 1 in tumbling windows of 10ns over col 0.
+constexpr char kTumblingGroupedAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  values {
+    name: "sum"
+    id: 0
+    args {
+      column {
+        node: 0
+        index: 2
+      }
+    }
+  }
+  groups {
+    node: 0
+    index: 1
+  }
+  group_names: "g"
+  value_names: "sum"
+  partial_agg: true
+  finalize_results: true
+  rolling_window {
+    time_column {
+      node: 0
+      index: 0
+    }
+    time_column_name: "time_"
+    window_size_ns: 10
+  }
+})";
+
+// Sums col 1 in windows of 20ns that start every 10ns over col 0.
+constexpr char kSlidingAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  values {
+    name: "sum"
+    id: 0
+    args {
+      column {
+        node: 0
+        index: 1
+      }
+    }
+  }
+  value_names: "sum"
+  partial_agg: true
+  finalize_results: true
+  rolling_window {
+    time_column {
+      node: 0
+      index: 0
+    }
+    time_column_name: "time_"
+    window_size_ns: 20
+    slide_ns: 10
+  }
+})";
+
+class RollingAggNodeTest : public ::testing::Test {
+ public:
+  RollingAggNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test");
+    EXPECT_OK(func_registry_->Register<SumUDA>("sum"));
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+    EXPECT_OK(exec_state_->AddUDA(0, "sum", {types::INT64}));
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& pbtxt) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(pbtxt, &op_pb));
+    return plan::AggregateOperator::FromProto(op_pb, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(RollingAggNodeTest, tumbling_windows_emitted_incrementally) {
+  auto plan_node = PlanNodeFromPbtxt(kTumblingGroupedAgg);
+  RowDescriptor input_rd({types::TIME64NS, types::INT64, types::INT64});
+  RowDescriptor output_rd({types::INT64, types::TIME64NS, types::INT64});
+
+  auto tester = exec::ExecNodeTester<RollingAggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester
+      // Nothing has closed yet.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<Time64NSValue>({1, 2})
+                       .AddColumn<Int64Value>({1, 1})
+                       .AddColumn<Int64Value>({1, 2})
+                       .get(),
+                   0, 0)
+      // Time 11 closes the [0, 10) window.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, false, false)
+                       .AddColumn<Time64NSValue>({11, 12})
+                       .AddColumn<Int64Value>({1, 2})
+                       .AddColumn<Int64Value>({3, 4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<Int64Value>({1})
+                          .AddColumn<Time64NSValue>({0})
+                          .AddColumn<Int64Value>({3})
+                          .get())
+      // The row at time 5 is late, since its window was already emitted.
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, true, true)
+                       .AddColumn<Time64NSValue>({5, 15, 25})
+                       .AddColumn<Int64Value>({1, 1, 2})
+                       .AddColumn<Int64Value>({100, 5, 6})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<Int64Value>({1, 2, 2})
+                          .AddColumn<Time64NSValue>({10, 10, 20})
+                          .AddColumn<Int64Value>({8, 4, 6})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(RollingAggNodeTest, tumbling_windows_with_selection) {
+  auto plan_node = PlanNodeFromPbtxt(kTumblingGroupedAgg);
+  RowDescriptor input_rd({types::TIME64NS, types::INT64, types::INT64});
+  RowDescriptor output_rd({types::INT64, types::TIME64NS, types::INT64});
+
+  RowBatchBuilder input_rb(input_rd, 4, /*eow*/ true, /*eos*/ true);
+  input_rb.AddColumn<Time64NSValue>({1, 2, 3, 14})
+      .AddColumn<Int64Value>({1, 1, 1, 1})
+      .AddColumn<Int64Value>({1, 2, 4, 8});
+  input_rb.get().set_selection(
+      std::make_shared<std::vector<int64_t>>(std::vector<int64_t>{0, 2, 3}));
+
+  auto tester = exec::ExecNodeTester<RollingAggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester.ConsumeNext(input_rb.get(), 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<Int64Value>({1, 1})
+                          .AddColumn<Time64NSValue>({0, 10})
+                          .AddColumn<Int64Value>({5, 8})
+                          .get())
+      .Close();
+}
+
+TEST_F(RollingAggNodeTest, sliding_windows_merge_panes) {
+  auto plan_node = PlanNodeFromPbtxt(kSlidingAgg);
+  RowDescriptor input_rd({types::TIME64NS, types::INT64});
+  RowDescriptor output_rd({types::TIME64NS, types::INT64});
+
+  auto tester = exec::ExecNodeTester<RollingAggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<Time64NSValue>({1, 11, 21})
+                       .AddColumn<Int64Value>({1, 2, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<Time64NSValue>({-10, 0})
+                          .AddColumn<Int64Value>({1, 3})
+                          .get())
+      // A gap in time doesn't emit the empty windows in between.
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<Time64NSValue>({101})
+                       .AddColumn<Int64Value>({4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<Time64NSValue>({10, 20, 90, 100})
+                          .AddColumn<Int64Value>({5, 3, 4, 4})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
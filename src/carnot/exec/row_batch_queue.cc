@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/row_batch_queue.h"
+
+#include <memory>
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+Status RowBatchQueue::Push(const RowBatch& rb) {
+  absl::MutexLock lock(&lock_);
+  lock_.Await(absl::Condition(this, &RowBatchQueue::Writable));
+  if (closed_) {
+    return error::Cancelled("Row batch queue was closed");
+  }
+  batches_.push_back(std::make_shared<RowBatch>(rb));
+  if (rb.eos()) {
+    // Nothing follows the end of the stream.
+    closed_ = true;
+  }
+  return Status::OK();
+}
+
+std::shared_ptr<RowBatch> RowBatchQueue::Pop() {
+  absl::MutexLock lock(&lock_);
+  lock_.Await(absl::Condition(this, &RowBatchQueue::Readable));
+  if (batches_.empty()) {
+    return nullptr;
+  }
+  std::shared_ptr<RowBatch> rb = std::move(batches_.front());
+  batches_.pop_front();
+  return rb;
+}
+
+void RowBatchQueue::Close() {
+  absl::MutexLock lock(&lock_);
+  closed_ = true;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
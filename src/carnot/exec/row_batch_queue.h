@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Receives the row batches of a memory sink as they are produced, instead of them being written to
+ * a table. The sink waits for the callback to return, so a slow callback slows down the query.
+ * An error returned by the callback fails the query.
+ */
+using MemorySinkCallback = std::function<Status(const table_store::schema::RowBatch& rb)>;
+
+/**
+ * RowBatchQueue hands the row batches of a streaming memory sink to a consumer on another thread.
+ * It holds at most `capacity` batches: the sink blocks while the queue is full, so the query runs
+ * in constant memory however large its results are.
+ */
+class RowBatchQueue : public NotCopyable {
+ public:
+  explicit RowBatchQueue(size_t capacity) : capacity_(capacity) { DCHECK_GT(capacity, 0U); }
+
+  /**
+   * Adds the batch to the queue, waiting for room in it.
+   *
+   * @return Status: Cancelled if the queue was closed.
+   */
+  Status Push(const table_store::schema::RowBatch& rb);
+
+  /**
+   * Takes the next batch off the queue, waiting for one. The last batch of the stream is the one
+   * with eos set.
+   *
+   * @return the batch, or nullptr once the queue is closed and drained.
+   */
+  std::shared_ptr<table_store::schema::RowBatch> Pop();
+
+  /**
+   * Stops the stream, e.g. when the consumer gives up or the query failed. The batches already
+   * queued can still be popped, but further pushes fail, which cancels the query.
+   */
+  void Close();
+
+  /**
+   * The callback to register for the memory sink, which pushes its batches to this queue. The
+   * queue must outlive the queries that the callback is registered for.
+   */
+  MemorySinkCallback Callback() {
+    return [this](const table_store::schema::RowBatch& rb) { return Push(rb); };
+  }
+
+ private:
+  bool Writable() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return closed_ || batches_.size() < capacity_;
+  }
+  bool Readable() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return closed_ || !batches_.empty();
+  }
+
+  const size_t capacity_;
+  absl::Mutex lock_;
+  std::deque<std::shared_ptr<table_store::schema::RowBatch>> batches_ ABSL_GUARDED_BY(lock_);
+  bool closed_ ABSL_GUARDED_BY(lock_) = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
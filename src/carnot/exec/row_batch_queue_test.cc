@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/row_batch_queue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+RowBatch MakeRowBatch(int64_t value, bool eos) {
+  RowDescriptor rd({types::DataType::INT64});
+  return RowBatchBuilder(rd, 1, /*eow*/ eos, /*eos*/ eos)
+      .AddColumn<types::Int64Value>({value})
+      .get();
+}
+
+TEST(RowBatchQueueTest, blocks_producer_while_full) {
+  RowBatchQueue queue(/* capacity */ 2);
+  std::atomic<int> num_pushed = 0;
+  std::thread producer([&] {
+    for (int64_t i = 0; i < 5; ++i) {
+      EXPECT_OK(queue.Push(MakeRowBatch(i, /* eos */ i == 4)));
+      ++num_pushed;
+    }
+  });
+
+  std::vector<int64_t> values;
+  while (auto rb = queue.Pop()) {
+    // The producer is never more than the capacity of the queue ahead.
+    EXPECT_LE(num_pushed.load(), static_cast<int>(values.size()) + 3);
+    values.push_back(types::GetValueFromArrowArray<types::INT64>(rb->ColumnAt(0).get(), 0));
+    if (rb->eos()) {
+      break;
+    }
+  }
+  producer.join();
+  EXPECT_THAT(values, ::testing::ElementsAre(0, 1, 2, 3, 4));
+  EXPECT_EQ(5, num_pushed.load());
+  // Nothing can be pushed after the end of the stream.
+  EXPECT_NOT_OK(queue.Push(MakeRowBatch(5, /* eos */ false)));
+  EXPECT_EQ(nullptr, queue.Pop());
+}
+
+TEST(RowBatchQueueTest, close_cancels_producer) {
+  RowBatchQueue queue(/* capacity */ 1);
+  ASSERT_OK(queue.Push(MakeRowBatch(0, /* eos */ false)));
+  std::thread consumer([&] { queue.Close(); });
+  // Waits for room in the queue until it is closed.
+  EXPECT_NOT_OK(queue.Push(MakeRowBatch(1, /* eos */ false)));
+  consumer.join();
+
+  // The batches queued before closing can still be read.
+  auto rb = queue.Pop();
+  ASSERT_NE(nullptr, rb);
+  EXPECT_FALSE(rb->eos());
+  EXPECT_EQ(nullptr, queue.Pop());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/top_k_node.h"
+
+#include <arrow/array.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+template <types::DataType DT>
+int CompareValues(const arrow::Array* lhs, int64_t lhs_idx, const arrow::Array* rhs,
+                  int64_t rhs_idx) {
+  auto lhs_val = types::GetValueFromArrowArray<DT>(lhs, lhs_idx);
+  auto rhs_val = types::GetValueFromArrowArray<DT>(rhs, rhs_idx);
+  if (lhs_val < rhs_val) {
+    return -1;
+  }
+  if (rhs_val < lhs_val) {
+    return 1;
+  }
+  return 0;
+}
+
+template <types::DataType DT>
+Status GatherValues(const std::vector<const arrow::Array*>& cols,
+                    const std::vector<int64_t>& row_idxs, std::shared_ptr<arrow::Array>* output) {
+  auto builder = types::MakeArrowBuilder(DT, arrow::default_memory_pool());
+  PL_RETURN_IF_ERROR(builder->Reserve(row_idxs.size()));
+  for (size_t i = 0; i < row_idxs.size(); ++i) {
+    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<DT>(
+        builder.get(), types::GetValueFromArrowArray<DT>(cols[i], row_idxs[i])));
+  }
+  PL_RETURN_IF_ERROR(builder->Finish(output));
+  return Status::OK();
+}
+
+}  // namespace
+
+std::string TopKNode::DebugStringImpl() {
+  return absl::Substitute("Exec::TopKNode<$0>", plan_node_->DebugString());
+}
+
+Status TopKNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::TOP_K_OPERATOR);
+  const auto* top_k_plan_node = static_cast<const plan::TopKOperator*>(&plan_node);
+  // copy the plan node to local object;
+  plan_node_ = std::make_unique<plan::TopKOperator>(*top_k_plan_node);
+
+  if (input_descriptors_.size() != 1) {
+    return error::InvalidArgument("TopK operator expects a single input relation, got $0",
+                                  input_descriptors_.size());
+  }
+  input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
+
+  for (int64_t sort_col : plan_node_->sort_cols()) {
+    if (sort_col >= static_cast<int64_t>(input_descriptor_->size())) {
+      return error::InvalidArgument("Sort column $0 is out of bounds for $1 input columns",
+                                    sort_col, input_descriptor_->size());
+    }
+#define TYPE_CASE(_dt_) comparators_.push_back(&CompareValues<_dt_>);
+    PL_SWITCH_FOREACH_DATATYPE(input_descriptor_->type(sort_col), TYPE_CASE);
+#undef TYPE_CASE
+  }
+  return Status::OK();
+}
+
+Status TopKNode::PrepareImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status TopKNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status TopKNode::CloseImpl(ExecState* /*exec_state*/) {
+  top_rows_.reset();
+  return Status::OK();
+}
+
+bool TopKNode::RowLess(const RowRef& lhs, const RowRef& rhs) const {
+  const auto& sort_cols = plan_node_->sort_cols();
+  const auto& descending = plan_node_->descending();
+  for (size_t i = 0; i < sort_cols.size(); ++i) {
+    int cmp = comparators_[i](lhs.rb->ColumnAt(sort_cols[i]).get(), lhs.row_idx,
+                              rhs.rb->ColumnAt(sort_cols[i]).get(), rhs.row_idx);
+    if (cmp != 0) {
+      return descending[i] ? cmp > 0 : cmp < 0;
+    }
+  }
+  return false;
+}
+
+Status TopKNode::MaterializeTopRows(const std::vector<RowRef>& rows) {
+  auto output_rb = std::make_unique<RowBatch>(*input_descriptor_, rows.size());
+  std::vector<const arrow::Array*> cols(rows.size());
+  std::vector<int64_t> row_idxs(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    row_idxs[i] = rows[i].row_idx;
+  }
+  for (size_t col_idx = 0; col_idx < input_descriptor_->size(); ++col_idx) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      cols[i] = rows[i].rb->ColumnAt(col_idx).get();
+    }
+    std::shared_ptr<arrow::Array> output_col;
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(GatherValues<_dt_>(cols, row_idxs, &output_col));
+    PL_SWITCH_FOREACH_DATATYPE(input_descriptor_->type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  top_rows_ = std::move(output_rb);
+  return Status::OK();
+}
+
+Status TopKNode::MergeRowBatch(const RowBatch& rb) {
+  auto limit = static_cast<size_t>(plan_node_->record_limit());
+  size_t num_top_rows = top_rows_ == nullptr ? 0 : top_rows_->num_rows();
+
+  std::vector<RowRef> candidates;
+  candidates.reserve(num_top_rows + rb.num_rows());
+  for (size_t i = 0; i < num_top_rows; ++i) {
+    candidates.push_back({top_rows_.get(), static_cast<int64_t>(i)});
+  }
+  // Once we have enough rows, only the rows that sort before the current last row can make it in.
+  bool full = num_top_rows == limit;
+  RowRef last_top_row{top_rows_.get(), static_cast<int64_t>(num_top_rows) - 1};
+  for (int64_t i = 0; i < rb.num_rows(); ++i) {
+    RowRef row{&rb, i};
+    if (!full || RowLess(row, last_top_row)) {
+      candidates.push_back(row);
+    }
+  }
+  if (candidates.size() == num_top_rows) {
+    return Status::OK();
+  }
+
+  size_t num_output_rows = std::min(limit, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + num_output_rows, candidates.end(),
+                    [this](const RowRef& lhs, const RowRef& rhs) { return RowLess(lhs, rhs); });
+  candidates.resize(num_output_rows);
+  return MaterializeTopRows(candidates);
+}
+
+Status TopKNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  if (plan_node_->record_limit() > 0 && rb.num_rows() > 0) {
+    PL_RETURN_IF_ERROR(MergeRowBatch(rb));
+  }
+  if (!rb.eos()) {
+    return Status::OK();
+  }
+
+  if (top_rows_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(auto output_rb, RowBatch::WithZeroRows(*output_descriptor_, /*eow*/ true,
+                                                               /*eos*/ true));
+    return SendRowBatchToChildren(exec_state, *output_rb);
+  }
+
+  RowBatch output_rb(*output_descriptor_, top_rows_->num_rows());
+  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
+  for (int64_t input_col_idx : plan_node_->selected_cols()) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(top_rows_->ColumnAt(input_col_idx)));
+  }
+  output_rb.set_eow(true);
+  output_rb.set_eos(true);
+  top_rows_.reset();
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
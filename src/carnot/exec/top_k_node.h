@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/common/base/status.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * TopKNode keeps the first `limit` rows of its input according to the sort columns, and outputs
+ * them in sorted order once the input is exhausted. Only the current top rows are retained, so
+ * memory use is bounded by the limit rather than by the size of the input.
+ */
+class TopKNode : public ProcessingNode {
+ public:
+  TopKNode() = default;
+  virtual ~TopKNode() = default;
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  using CompareFn = int (*)(const arrow::Array* lhs, int64_t lhs_idx, const arrow::Array* rhs,
+                            int64_t rhs_idx);
+
+  struct RowRef {
+    const table_store::schema::RowBatch* rb;
+    int64_t row_idx;
+  };
+
+  // Returns true if lhs comes before rhs in the sort order.
+  bool RowLess(const RowRef& lhs, const RowRef& rhs) const;
+  // Merges the rows of the row batch into the current top rows.
+  Status MergeRowBatch(const table_store::schema::RowBatch& rb);
+  Status MaterializeTopRows(const std::vector<RowRef>& rows);
+
+  std::unique_ptr<plan::TopKOperator> plan_node_;
+  std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
+  // One comparator for each of the sort columns.
+  std::vector<CompareFn> comparators_;
+  // The current top rows in sorted order, with all of the input columns.
+  std::unique_ptr<table_store::schema::RowBatch> top_rows_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/top_k_node.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+class TopKNodeTest : public ::testing::Test {
+ public:
+  TopKNodeTest() {
+    auto op_proto = planpb::testutils::CreateTestTopK1PB();
+    plan_node_ = plan::TopKOperator::FromProto(op_proto, 1);
+
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+
+    auto table_store = std::make_shared<table_store::TableStore>();
+
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> plan_node_;
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+  RowDescriptor input_rd_{{types::DataType::INT64, types::DataType::FLOAT64}};
+  RowDescriptor output_rd_{{types::DataType::INT64, types::DataType::FLOAT64}};
+};
+
+TEST_F(TopKNodeTest, single_batch) {
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(
+      *plan_node_, output_rd_, {input_rd_}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_, 6, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                       .AddColumn<types::Float64Value>({1.5, 9.0, 0.5, 7.0, 3.0, 8.0})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 3, true, true)
+                          .AddColumn<types::Int64Value>({2, 6, 4})
+                          .AddColumn<types::Float64Value>({9.0, 8.0, 7.0})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, multiple_batches) {
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(
+      *plan_node_, output_rd_, {input_rd_}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Float64Value>({1.5, 9.0})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({3, 4, 5})
+                       .AddColumn<types::Float64Value>({0.5, 7.0, 3.0})
+                       .get(),
+                   0, 0)
+      // Only one of these rows sorts before the current top rows.
+      .ConsumeNext(RowBatchBuilder(input_rd_, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({6, 7, 8})
+                       .AddColumn<types::Float64Value>({8.0, 1.0, 2.0})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_, 0, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Float64Value>({})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 3, true, true)
+                          .AddColumn<types::Int64Value>({2, 6, 4})
+                          .AddColumn<types::Float64Value>({9.0, 8.0, 7.0})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, fewer_rows_than_limit) {
+  auto op_proto = planpb::testutils::CreateTestTopK1PB();
+  op_proto.mutable_top_k_op()->set_descending(0, false);
+  plan_node_ = plan::TopKOperator::FromProto(op_proto, 1);
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(
+      *plan_node_, output_rd_, {input_rd_}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Float64Value>({9.0, 1.5})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 2, true, true)
+                          .AddColumn<types::Int64Value>({2, 1})
+                          .AddColumn<types::Float64Value>({1.5, 9.0})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, empty_input) {
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(
+      *plan_node_, output_rd_, {input_rd_}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_, 0, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Float64Value>({})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd_, 0, true, true)
+                          .AddColumn<types::Int64Value>({})
+                          .AddColumn<types::Float64Value>({})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
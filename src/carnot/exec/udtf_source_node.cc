@@ -20,9 +20,12 @@
 
 #include <arrow/array/builder_base.h>
 #include <arrow/memory_pool.h>
+#include <algorithm>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <magic_enum.hpp>
@@ -36,10 +39,17 @@
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int32(carnot_udtf_partition_threads,
+             gflags::Int32FromEnv("PL_CARNOT_UDTF_PARTITION_THREADS", 4),
+             "The maximum number of threads used to generate the partitions of a partitionable "
+             "UDTF.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
+using table_store::schema::RowBatch;
+
 // TODO(zasgar/philkuz): we should put these in the plan.
 // The batch size to use for UDTFs by default.
 constexpr int kUDTFBatchSize = 1024;
@@ -65,6 +75,9 @@ Status UDTFSourceNode::PrepareImpl(ExecState* exec_state) {
 Status UDTFSourceNode::OpenImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
   udtf_inst_ = udtf_def_->Make();
+  partitions_generated_ = false;
+  partition_batches_.clear();
+  partition_offset_ = 0;
 
   ObjectPool init_args_pool{"udtf_init_args_pool"};
   std::vector<const types::BaseValueType*> init_args;
@@ -98,7 +111,87 @@ Status UDTFSourceNode::OpenImpl(ExecState* exec_state) {
 
 Status UDTFSourceNode::CloseImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
+Status UDTFSourceNode::GeneratePartitions() {
+  const int64_t num_partitions = udtf_def_->NumPartitions(udtf_inst_.get(), function_ctx_.get());
+  std::vector<std::unique_ptr<RowBatch>> batches(std::max<int64_t>(num_partitions, 0));
+  std::vector<Status> statuses(batches.size());
+
+  // Each partition writes to its own builders, so they can be generated without any
+  // synchronization.
+  auto generate_partition = [this, &batches, &statuses](size_t idx) {
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> outputs;
+    std::vector<arrow::ArrayBuilder*> outputs_raw;
+    for (const auto& r : udtf_def_->output_relation()) {
+      outputs.emplace_back(types::MakeArrowBuilder(r.type(), arrow::default_memory_pool()));
+      outputs_raw.emplace_back(outputs.back().get());
+    }
+    udtf_def_->ExecPartition(udtf_inst_.get(), function_ctx_.get(), idx, &outputs_raw);
+    auto rb_or_s = RowBatch::FromColumnBuilders(*output_descriptor_, /*eow*/ false,
+                                                /*eos*/ false, &outputs);
+    if (!rb_or_s.ok()) {
+      statuses[idx] = rb_or_s.status();
+      return;
+    }
+    batches[idx] = rb_or_s.ConsumeValueOrDie();
+  };
+
+  size_t num_threads =
+      std::min<size_t>(batches.size(), std::max(1, FLAGS_carnot_udtf_partition_threads));
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (size_t worker_idx = 0; worker_idx < num_threads; ++worker_idx) {
+    workers.emplace_back([&generate_partition, &batches, worker_idx, num_threads] {
+      for (size_t idx = worker_idx; idx < batches.size(); idx += num_threads) {
+        generate_partition(idx);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (size_t idx = 0; idx < batches.size(); ++idx) {
+    PL_RETURN_IF_ERROR(statuses[idx]);
+    if (batches[idx]->num_rows() > 0) {
+      partition_batches_.push_back(std::move(batches[idx]));
+    }
+  }
+  partitions_generated_ = true;
+  return Status::OK();
+}
+
+Status UDTFSourceNode::GenerateNextPartitionBatch(ExecState* exec_state) {
+  if (!partitions_generated_) {
+    PL_RETURN_IF_ERROR(GeneratePartitions());
+  }
+
+  if (partition_batches_.empty()) {
+    PL_ASSIGN_OR_RETURN(auto rb, RowBatch::WithZeroRows(*output_descriptor_, /*eow*/ true,
+                                                        /*eos*/ true));
+    return SendRowBatchToChildren(exec_state, *rb);
+  }
+
+  // Partitions larger than a batch are output in batch sized slices.
+  const RowBatch& partition = *partition_batches_.front();
+  int64_t num_rows = std::min<int64_t>(kUDTFBatchSize, partition.num_rows() - partition_offset_);
+  PL_ASSIGN_OR_RETURN(auto rb, partition.Slice(partition_offset_, num_rows));
+  partition_offset_ += num_rows;
+  if (partition_offset_ == partition.num_rows()) {
+    partition_batches_.pop_front();
+    partition_offset_ = 0;
+  }
+
+  bool last_batch = partition_batches_.empty();
+  rb->set_eow(last_batch);
+  rb->set_eos(last_batch);
+  return SendRowBatchToChildren(exec_state, *rb);
+}
+
 Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
+  if (udtf_def_->partitionable()) {
+    return GenerateNextPartitionBatch(exec_state);
+  }
+
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> outputs;
 
   for (const auto& r : udtf_def_->output_relation()) {
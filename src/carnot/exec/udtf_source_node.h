@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -31,8 +32,11 @@
 #include "src/carnot/udf/udtf.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
+#include "src/table_store/schema/row_batch.h"
 #include "src/table_store/schema/row_descriptor.h"
 
+DECLARE_int32(carnot_udtf_partition_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -53,11 +57,21 @@ class UDTFSourceNode : public SourceNode {
   Status GenerateNextImpl(ExecState* exec_state) override;
 
  private:
+  // Generates all the partitions of a partitionable UDTF, in parallel.
+  Status GeneratePartitions();
+  // Outputs the next batch of the partitions' records.
+  Status GenerateNextPartitionBatch(ExecState* exec_state);
+
   bool has_more_batches_ = true;
   udf::UDTFDefinition* udtf_def_ = nullptr;
   std::unique_ptr<plan::UDTFSourceOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
   std::unique_ptr<udf::AnyUDTF> udtf_inst_;
+
+  // The records of the non-empty partitions, and how many of the front one were output already.
+  bool partitions_generated_ = false;
+  std::deque<std::unique_ptr<table_store::schema::RowBatch>> partition_batches_;
+  int64_t partition_offset_ = 0;
 };
 
 }  // namespace exec
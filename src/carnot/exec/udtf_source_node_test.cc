@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <google/protobuf/text_format.h>
@@ -87,6 +88,43 @@ class BasicTestUDTF : public UDTF<BasicTestUDTF> {
   std::string some_string_;
 };
 
+// Outputs the ints [0, num_partitions * records_per_partition), a partition of them at a time.
+class PartitionedTestUDTF : public UDTF<PartitionedTestUDTF> {
+ public:
+  static constexpr auto InitArgs() {
+    return MakeArray(UDTFArg::Make<types::DataType::INT64>("num_partitions", "Int arg"),
+                     UDTFArg::Make<types::DataType::INT64>("records_per_partition", "Int arg"));
+  }
+
+  static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("out_int", types::DataType::INT64, types::PatternType::GENERAL, "int result"),
+        ColInfo("out_str", types::DataType::STRING, types::PatternType::GENERAL, "string result"));
+  }
+
+  Status Init(FunctionContext*, Int64Value num_partitions, Int64Value records_per_partition) {
+    num_partitions_ = num_partitions.val;
+    records_per_partition_ = records_per_partition.val;
+    return Status::OK();
+  }
+
+  int64_t NumPartitions(FunctionContext*) const { return num_partitions_; }
+
+  void GeneratePartition(FunctionContext*, int64_t partition, RecordWriter* rw) const {
+    for (int64_t i = 0; i < records_per_partition_; ++i) {
+      int64_t val = partition * records_per_partition_ + i;
+      rw->Append<IndexOf("out_int")>(val);
+      rw->Append<IndexOf("out_str")>(std::to_string(val));
+    }
+  }
+
+ private:
+  int64_t num_partitions_ = 0;
+  int64_t records_per_partition_ = 0;
+};
+
 constexpr char kUDTFTestPbtxt[] = R"proto(
   op_type: UDTF_SOURCE_OPERATOR
   udtf_source_op {
@@ -135,6 +173,103 @@ TEST_F(UDTFSourceNodeTest, single_output_batch_test) {
           .get());
 }
 
+constexpr char kPartitionedUDTFTestPbtxt[] = R"proto(
+  op_type: UDTF_SOURCE_OPERATOR
+  udtf_source_op {
+    name: "partitioned_udtf"
+    arg_values {
+      data_type: INT64
+      int64_value: $0
+    }
+    arg_values {
+      data_type: INT64
+      int64_value: $1
+    }
+  }
+)proto";
+
+class PartitionedUDTFSourceNodeTest : public ::testing::Test {
+ public:
+  PartitionedUDTFSourceNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    EXPECT_OK(func_registry_->Register<PartitionedTestUDTF>("partitioned_udtf"));
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(),
+                                              std::make_shared<table_store::TableStore>(),
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> MakePlanNode(int64_t num_partitions,
+                                               int64_t records_per_partition) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(kPartitionedUDTFTestPbtxt, num_partitions, records_per_partition),
+        &op_pb));
+    return plan::UDTFSourceOperator::FromProto(op_pb, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(PartitionedUDTFSourceNodeTest, outputs_partitions_in_order) {
+  auto plan_node = MakePlanNode(/* num_partitions */ 3, /* records_per_partition */ 2);
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+  auto tester = exec::ExecNodeTester<UDTFSourceNode, plan::UDTFSourceOperator>(
+      *plan_node, output_rd, {}, exec_state_.get());
+
+  // Each partition is output as its own batch, the last one ending the stream.
+  for (int64_t partition = 0; partition < 3; ++partition) {
+    bool last = partition == 2;
+    tester.GenerateNextResult().ExpectRowBatch(
+        RowBatchBuilder(output_rd, 2, /*eow*/ last, /*eos*/ last)
+            .AddColumn<types::Int64Value>({2 * partition, 2 * partition + 1})
+            .AddColumn<types::StringValue>(
+                {std::to_string(2 * partition), std::to_string(2 * partition + 1)})
+            .get());
+  }
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+}
+
+TEST_F(PartitionedUDTFSourceNodeTest, slices_large_partitions) {
+  // Partitions larger than a batch grow their output columns as they're written.
+  auto plan_node = MakePlanNode(/* num_partitions */ 2, /* records_per_partition */ 1500);
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+  auto tester = exec::ExecNodeTester<UDTFSourceNode, plan::UDTFSourceOperator>(
+      *plan_node, output_rd, {}, exec_state_.get());
+
+  // Each partition is output as a full batch followed by the remainder.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+    tester.GenerateNextResult();
+  }
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+
+  std::vector<types::Int64Value> ints;
+  std::vector<types::StringValue> strs;
+  for (int64_t val = 0; val < 3000; ++val) {
+    ints.push_back(val);
+    strs.push_back(std::to_string(val));
+  }
+  tester.ExpectRowBatchesData(RowBatchBuilder(output_rd, 3000, /*eow*/ true, /*eos*/ true)
+                                  .AddColumn<types::Int64Value>(ints)
+                                  .AddColumn<types::StringValue>(strs)
+                                  .get(),
+                              4);
+}
+
+TEST_F(PartitionedUDTFSourceNodeTest, no_partitions) {
+  auto plan_node = MakePlanNode(/* num_partitions */ 0, /* records_per_partition */ 2);
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+  auto tester = exec::ExecNodeTester<UDTFSourceNode, plan::UDTFSourceOperator>(
+      *plan_node, output_rd, {}, exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 0, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Int64Value>({})
+          .AddColumn<types::StringValue>({})
+          .get());
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
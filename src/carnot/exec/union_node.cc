@@ -21,8 +21,10 @@
 #include <arrow/memory_pool.h>
 #include <arrow/status.h>
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_join.h>
@@ -75,6 +77,7 @@ Status UnionNode::PrepareImpl(ExecState*) {
     parent_row_batches_.resize(num_parents_);
     row_cursors_.resize(num_parents_);
     time_columns_.resize(num_parents_);
+    loser_tree_.resize(num_parents_);
     data_columns_.resize(num_parents_, std::vector<arrow::Array*>(num_output_cols));
 
     column_builders_.resize(num_output_cols);
@@ -111,13 +114,44 @@ types::Time64NSValue UnionNode::GetTimeAtParentCursor(size_t parent_index) const
                                                         row_cursors_[parent_index]);
 }
 
-Status UnionNode::AppendRow(size_t parent) {
-  auto row = row_cursors_[parent];
+namespace {
+
+// Appends the rows [start_row, end_row) of the column to the builder.
+template <types::DataType T>
+Status AppendValues(arrow::ArrayBuilder* builder, const arrow::Array* input_col, int64_t start_row,
+                    int64_t end_row) {
+  auto* typed_builder =
+      static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(builder);
+  const auto* typed_col =
+      static_cast<const typename types::DataTypeTraits<T>::arrow_array_type*>(input_col);
+  if constexpr (T == types::DataType::INT64 || T == types::DataType::FLOAT64 ||
+                T == types::DataType::TIME64NS) {
+    // Fixed width values are copied in one go.
+    PL_RETURN_IF_ERROR(
+        typed_builder->AppendValues(typed_col->raw_values() + start_row, end_row - start_row));
+  } else {
+    PL_RETURN_IF_ERROR(typed_builder->Reserve(end_row - start_row));
+    if constexpr (T == types::DataType::STRING) {
+      int64_t size = typed_builder->value_data_length() + typed_col->value_offset(end_row) -
+                     typed_col->value_offset(start_row);
+      if (size >= typed_builder->value_data_capacity()) {
+        PL_RETURN_IF_ERROR(typed_builder->ReserveData(std::lrint(1.5 * size)));
+      }
+    }
+    for (int64_t row = start_row; row < end_row; ++row) {
+      typed_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, row));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status UnionNode::AppendRows(size_t parent, int64_t start_row, int64_t end_row) {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     auto input_col = data_columns_[parent][i];
-#define TYPE_CASE(_dt_)                                    \
-  PL_RETURN_IF_ERROR(table_store::schema::CopyValue<_dt_>( \
-      column_builders_[i].get(), types::GetValueFromArrowArray<_dt_>(input_col, row)));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendValues<_dt_>(column_builders_[i].get(), input_col, start_row, end_row));
     PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -169,71 +203,115 @@ Status UnionNode::FlushBatch(ExecState* exec_state) {
   return SendRowBatchToChildren(exec_state, *rb);
 }
 
-Status UnionNode::MergeData(ExecState* exec_state) {
-  while (!sent_eos_) {
-    // Get the smallest time out of all of the current streams.
-    std::vector<size_t> parent_streams;
-    parent_streams.reserve(row_cursors_.size());
+bool UnionNode::MergesBefore(size_t parent_a, size_t parent_b) const {
+  if (flushed_parent_eoses_[parent_a] || flushed_parent_eoses_[parent_b]) {
+    return !flushed_parent_eoses_[parent_a] ||
+           (flushed_parent_eoses_[parent_b] && parent_a < parent_b);
+  }
+  // Ties go to the parent with the lower index, so that rows are stable with respect to it.
+  auto time_a = GetTimeAtParentCursor(parent_a);
+  auto time_b = GetTimeAtParentCursor(parent_b);
+  return time_a < time_b || (time_a == time_b && parent_a < parent_b);
+}
 
-    for (size_t parent = 0; parent < row_cursors_.size(); ++parent) {
-      if (flushed_parent_eoses_[parent]) {
-        continue;
-      }
-      // If we lack necessary data, we can't merge anymore.
-      if (!parent_row_batches_[parent].size()) {
-        return Status::OK();
-      }
-      parent_streams.push_back(parent);
+void UnionNode::BuildLoserTree() {
+  // The winners of the inner nodes, followed by the leaves.
+  std::vector<size_t> winners(2 * num_parents_);
+  for (size_t parent = 0; parent < num_parents_; ++parent) {
+    winners[num_parents_ + parent] = parent;
+  }
+  for (size_t node = num_parents_ - 1; node > 0; --node) {
+    size_t left = winners[2 * node];
+    size_t right = winners[2 * node + 1];
+    bool left_wins = MergesBefore(left, right);
+    winners[node] = left_wins ? left : right;
+    loser_tree_[node] = left_wins ? right : left;
+  }
+  loser_tree_[0] = num_parents_ > 1 ? winners[1] : 0;
+}
+
+void UnionNode::ReplayLoserTree(size_t parent) {
+  size_t winner = parent;
+  for (size_t node = (num_parents_ + parent) / 2; node > 0; node /= 2) {
+    if (MergesBefore(loser_tree_[node], winner)) {
+      std::swap(loser_tree_[node], winner);
+    }
+  }
+  loser_tree_[0] = winner;
+}
+
+size_t UnionNode::LoserTreeRunnerUp() const {
+  // The runner-up can only have lost against the winner, on the winner's path to the root.
+  size_t runner_up = num_parents_;
+  for (size_t node = (num_parents_ + loser_tree_[0]) / 2; node > 0; node /= 2) {
+    size_t loser = loser_tree_[node];
+    if (!flushed_parent_eoses_[loser] &&
+        (runner_up == num_parents_ || MergesBefore(loser, runner_up))) {
+      runner_up = loser;
+    }
+  }
+  return runner_up;
+}
+
+Status UnionNode::MergeData(ExecState* exec_state) {
+  // Rows can only be merged while every parent that hasn't ended has rows to compare.
+  for (size_t parent = 0; parent < num_parents_; ++parent) {
+    if (!flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty()) {
+      return Status::OK();
     }
+  }
+  BuildLoserTree();
 
+  while (!sent_eos_) {
+    size_t parent = loser_tree_[0];
     // If we have reached end of stream for all of our inputs, flush the queue.
-    if (!parent_streams.size()) {
+    if (flushed_parent_eoses_[parent]) {
       return OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state);
     }
 
-    std::sort(parent_streams.begin(), parent_streams.end(),
-              [this](size_t parent_a, size_t parent_b) {
-                auto time_a = GetTimeAtParentCursor(parent_a);
-                auto time_b = GetTimeAtParentCursor(parent_b);
-                return time_a < time_b || (time_a == time_b && parent_a < parent_b);
-              });
-
-    bool has_limit = parent_streams.size() > 1;
-    size_t parent = parent_streams[0];
-
-    while (parent_row_batches_[parent].size()) {
-      if (has_limit) {
-        size_t next_parent = parent_streams[1];
-        // If this time is greater than another parent stream's earliest time,
-        // or if they are the same but the first parent is at a smaller index, stop merging.
-        // This way rows are always stable with respect to input parent index.
-        if (GetTimeAtParentCursor(parent) > GetTimeAtParentCursor(next_parent) ||
-            (GetTimeAtParentCursor(parent) == GetTimeAtParentCursor(next_parent) &&
-             parent > next_parent)) {
-          break;
-        }
-      }
-
-      PL_RETURN_IF_ERROR(AppendRow(parent));
-
-      // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
-      // popped.
-      const auto& rb = parent_row_batches_[parent][0];
-      bool pop_row_batch = ++row_cursors_[parent] == static_cast<size_t>(rb.num_rows());
-      if (pop_row_batch && rb.eos()) {
+    // Copy the run of rows of the winner that come before the row of the runner-up, as far as it
+    // fits in the output batch.
+    const RowBatch& rb = parent_row_batches_[parent].front();
+    const auto* times =
+        static_cast<const arrow::Int64Array*>(time_columns_[parent])->raw_values();
+    const int64_t start_row = row_cursors_[parent];
+    int64_t end_row = rb.num_rows();
+    size_t runner_up = LoserTreeRunnerUp();
+    if (runner_up != num_parents_) {
+      int64_t runner_up_time = GetTimeAtParentCursor(runner_up).val;
+      end_row = (parent < runner_up ? std::upper_bound(times + start_row, times + end_row,
+                                                       runner_up_time)
+                                    : std::lower_bound(times + start_row, times + end_row,
+                                                       runner_up_time)) -
+                times;
+    }
+    int64_t capacity =
+        static_cast<int64_t>(output_rows_per_batch_) - column_builders_[0]->length();
+    end_row = std::min(end_row, start_row + std::max<int64_t>(capacity, 1));
+    DCHECK_GT(end_row, start_row);
+    PL_RETURN_IF_ERROR(AppendRows(parent, start_row, end_row));
+
+    row_cursors_[parent] = end_row;
+    bool waiting_for_parent = false;
+    if (end_row == rb.num_rows()) {
+      // Delete the top row batch from our buffer and update the cursor.
+      if (rb.eos()) {
         flushed_parent_eoses_[parent] = true;
       }
+      parent_row_batches_[parent].pop_front();
+      row_cursors_[parent] = 0;
+      CacheNextRowBatch(parent);
+      // If we lack necessary data, we can't merge anymore.
+      waiting_for_parent =
+          !flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty();
+    }
 
-      if (pop_row_batch) {
-        // Delete the top row batch from our buffer and update the cursor.
-        parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
-        row_cursors_[parent] = 0;
-        CacheNextRowBatch(parent);
-      }
-
-      // Flush the current RowBatch if necessary.
-      PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
+    // Flush the current RowBatch if necessary.
+    PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
+    if (waiting_for_parent) {
+      return Status::OK();
     }
+    ReplayLoserTree(parent);
   }
   return Status::OK();
 }
@@ -244,7 +322,7 @@ void UnionNode::CacheNextRowBatch(size_t parent) {
     if (parent_row_batches_[parent][0].eos()) {
       flushed_parent_eoses_[parent] = true;
     }
-    parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
+    parent_row_batches_[parent].pop_front();
   }
   if (!parent_row_batches_[parent].size()) {
     return;
@@ -270,10 +348,16 @@ Status UnionNode::ConsumeNextUnordered(ExecState* exec_state, const RowBatch& rb
   if (rb.eos()) {
     flushed_parent_eoses_[parent_index] = true;
   }
+  // Batches are forwarded without copying their columns, and those without rows are dropped
+  // unless they end the output.
+  if (rb.num_selected_rows() == 0 && !InputsComplete()) {
+    return Status::OK();
+  }
   RowBatch output_rb(*output_descriptor_, rb.num_rows());
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     PL_RETURN_IF_ERROR(output_rb.AddColumn(GetInputColumn(rb, parent_index, i)));
   }
+  output_rb.set_selection(rb.selection_ptr());
 
   output_rb.set_eow(InputsComplete());
   output_rb.set_eos(InputsComplete());
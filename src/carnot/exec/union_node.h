@@ -21,6 +21,7 @@
 #include <arrow/array.h>
 #include <arrow/array/builder_base.h>
 #include <stddef.h>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
@@ -63,6 +64,11 @@ class UnionNode : public ProcessingNode {
     data_flush_timeout_ = data_flush_timeout;
   }
 
+  // Unordered unions forward the selections of their inputs along with the columns.
+  bool SupportsSelection() const override {
+    return plan_node_ != nullptr && !plan_node_->order_by_time();
+  }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -91,7 +97,15 @@ class UnionNode : public ProcessingNode {
   void CacheNextRowBatch(size_t parent);
   Status InitializeColumnBuilders();
   types::Time64NSValue GetTimeAtParentCursor(size_t parent_index) const;
-  Status AppendRow(size_t parent);
+  // Whether the row at the cursor of parent a comes before the one of parent b. Parents that have
+  // sent all of their rows come last.
+  bool MergesBefore(size_t parent_a, size_t parent_b) const;
+  void BuildLoserTree();
+  void ReplayLoserTree(size_t parent);
+  // Returns the parent whose row would come next if the winner had no more rows, or num_parents_
+  // if there is none.
+  size_t LoserTreeRunnerUp() const;
+  Status AppendRows(size_t parent, int64_t start_row, int64_t end_row);
   Status OptionallyFlushRowBatchIfMaxRowsOrEOS(ExecState* exec_state);
   Status OptionallyFlushRowBatchIfTimeout(ExecState* exec_state);
   Status FlushBatch(ExecState* exec_state);
@@ -105,7 +119,7 @@ class UnionNode : public ProcessingNode {
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
 
   // Hold onto the input row batches for every parent until we copy all of their data.
-  std::vector<std::vector<table_store::schema::RowBatch>> parent_row_batches_;
+  std::vector<std::deque<table_store::schema::RowBatch>> parent_row_batches_;
   // Keep track of where we are in the stream for each parent.
   // The row is always relative to the 'top' row batch that we have for each parent.
   std::vector<size_t> row_cursors_;
@@ -113,6 +127,11 @@ class UnionNode : public ProcessingNode {
   std::vector<arrow::Array*> time_columns_;
   std::vector<std::vector<arrow::Array*>> data_columns_;
 
+  // The parents are merged with a loser tree, laid out like a binary heap: the leaves of the
+  // parents are nodes num_parents_ to 2 * num_parents_ - 1, which aren't stored. Each inner node
+  // holds the parent that lost the comparison at that node, and node 0 holds the overall winner.
+  std::vector<size_t> loser_tree_;
+
   bool enable_data_flush_timeout_ = true;
   // When enable_data_flush_timeout_ is set to true, use this time to decide if we should
   // flush data to consumers before the output row batch reaches a certain size.
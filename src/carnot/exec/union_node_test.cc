@@ -20,6 +20,7 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <google/protobuf/text_format.h>
 #include <sole.hpp>
 
 #include "src/carnot/exec/test_utils.h"
@@ -507,6 +508,71 @@ TEST_F(UnionNodeTest, end_on_empty_rb) {
       .Close();
 }
 
+// Rows of many parents are merged by time, and ties go to the parent with the lower index.
+TEST_F(UnionNodeTest, ordered_many_parents) {
+  planpb::Operator op_proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(
+      R"(
+      op_type: UNION_OPERATOR
+      union_op {
+        rows_per_batch: 4
+        column_names: "time_"
+        column_names: "val"
+        column_mappings { column_indexes: 0 column_indexes: 1 }
+        column_mappings { column_indexes: 0 column_indexes: 1 }
+        column_mappings { column_indexes: 0 column_indexes: 1 }
+        column_mappings { column_indexes: 0 column_indexes: 1 }
+      })",
+      &op_proto));
+  plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor rd({types::DataType::TIME64NS, types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<UnionNode, plan::UnionOperator>(*plan_node_, rd,
+                                                                     {rd, rd, rd, rd},
+                                                                     exec_state_.get());
+  tester.node()->disable_data_flush_timeout();
+
+  tester
+      .ConsumeNext(RowBatchBuilder(rd, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Time64NSValue>({1, 2, 3, 10})
+                       .AddColumn<types::Int64Value>({0, 1, 2, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(rd, 3, true, true)
+                       .AddColumn<types::Time64NSValue>({2, 2, 5})
+                       .AddColumn<types::Int64Value>({100, 101, 102})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(rd, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({0, 11})
+                       .AddColumn<types::Int64Value>({200, 201})
+                       .get(),
+                   2, 0)
+      // Nothing is merged until every parent has sent rows.
+      .ConsumeNext(RowBatchBuilder(rd, 5, true, true)
+                       .AddColumn<types::Time64NSValue>({3, 4, 4, 4, 12})
+                       .AddColumn<types::Int64Value>({300, 301, 302, 303, 304})
+                       .get(),
+                   3, 4)
+      .ExpectRowBatch(RowBatchBuilder(rd, 4, false, false)
+                          .AddColumn<types::Time64NSValue>({0, 1, 2, 2})
+                          .AddColumn<types::Int64Value>({200, 0, 1, 100})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(rd, 4, false, false)
+                          .AddColumn<types::Time64NSValue>({2, 3, 3, 4})
+                          .AddColumn<types::Int64Value>({101, 2, 300, 301})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(rd, 4, false, false)
+                          .AddColumn<types::Time64NSValue>({4, 4, 5, 10})
+                          .AddColumn<types::Int64Value>({302, 303, 102, 3})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(rd, 2, true, true)
+                          .AddColumn<types::Time64NSValue>({11, 12})
+                          .AddColumn<types::Int64Value>({201, 304})
+                          .get())
+      .Close();
+}
+
 TEST_F(UnionNodeTest, ordered_timeout_not_hit) {
   auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
   plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
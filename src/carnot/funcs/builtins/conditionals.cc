@@ -18,10 +18,39 @@
 
 #include "src/carnot/funcs/builtins/conditionals.h"
 
+#include <vector>
+
 namespace px {
 namespace carnot {
 namespace builtins {
 
+void UnpackBooleanArray(const arrow::BooleanArray* arr, size_t count, std::vector<uint8_t>* out) {
+  out->resize(count);
+  const uint8_t* bits = arr->values()->data();
+  const int64_t offset = arr->offset();
+  for (size_t idx = 0; idx < count; ++idx) {
+    int64_t bit = offset + idx;
+    (*out)[idx] = (bits[bit >> 3] >> (bit & 7)) & 1;
+  }
+}
+
+Status SelectStrings(size_t count, const uint8_t* selectors, const arrow::StringArray* v1,
+                     const arrow::StringArray* v2, arrow::StringBuilder* out) {
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  int64_t data_size = 0;
+  for (size_t idx = 0; idx < count; ++idx) {
+    data_size += selectors[idx] ? v1->value_length(idx) : v2->value_length(idx);
+  }
+  PL_RETURN_IF_ERROR(out->ReserveData(data_size));
+  for (size_t idx = 0; idx < count; ++idx) {
+    const arrow::StringArray* selected = selectors[idx] ? v1 : v2;
+    int32_t length = 0;
+    const uint8_t* data = selected->GetValue(idx, &length);
+    out->UnsafeAppend(data, length);
+  }
+  return Status::OK();
+}
+
 void RegisterConditionalOpsOrDie(udf::Registry* registry) {
   // Select.
   registry->RegisterOrDie<SelectUDF<types::BoolValue>>("select");
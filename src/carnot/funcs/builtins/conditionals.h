@@ -18,6 +18,12 @@
 
 #pragma once
 
+#include <arrow/array.h>
+#include <arrow/builder.h>
+
+#include <type_traits>
+#include <vector>
+
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 
@@ -31,6 +37,19 @@ namespace builtins {
  */
 void RegisterConditionalOpsOrDie(udf::Registry* registry);
 
+/**
+ * Unpacks the first count bits of a boolean array to a byte each, so that they can be used as the
+ * mask of loops that the compiler vectorizes.
+ */
+void UnpackBooleanArray(const arrow::BooleanArray* arr, size_t count, std::vector<uint8_t>* out);
+
+/**
+ * Appends v1[i] if selectors[i] else v2[i] for each of the count records. The size of the selected
+ * strings is summed from the offsets first, so that their data is only reserved once.
+ */
+Status SelectStrings(size_t count, const uint8_t* selectors, const arrow::StringArray* v1,
+                     const arrow::StringArray* v2, arrow::StringBuilder* out);
+
 template <typename TArg>
 class SelectUDF : public udf::ScalarUDF {
  public:
@@ -43,6 +62,40 @@ class SelectUDF : public udf::ScalarUDF {
     return v2;
   }
 
+  using ArrowArray = typename types::ValueTypeTraits<TArg>::arrow_array_type;
+  using ArrowBuilder = typename types::ValueTypeTraits<TArg>::arrow_builder_type;
+  using NativeType = typename types::ValueTypeTraits<TArg>::native_type;
+
+  // Same as Exec for every record, but the values are blended without branches. Both of the value
+  // columns are already evaluated anyway.
+  Status ExecBatch(FunctionContext*, size_t count, ArrowBuilder* out, const arrow::BooleanArray* s,
+                   const ArrowArray* v1, const ArrowArray* v2) {
+    UnpackBooleanArray(s, count, &selectors_);
+    if constexpr (std::is_same_v<TArg, types::StringValue>) {
+      return SelectStrings(count, selectors_.data(), v1, v2, out);
+    } else if constexpr (std::is_same_v<TArg, types::BoolValue>) {
+      PL_RETURN_IF_ERROR(out->Reserve(count));
+      for (size_t idx = 0; idx < count; ++idx) {
+        out->UnsafeAppend(selectors_[idx] ? v1->Value(idx) : v2->Value(idx));
+      }
+      return Status::OK();
+    } else {
+      values_.resize(count);
+      const uint8_t* selectors = selectors_.data();
+      const NativeType* values1 = v1->raw_values();
+      const NativeType* values2 = v2->raw_values();
+      NativeType* values = values_.data();
+      // Both values are loaded for every record, so this vectorizes to a blend.
+      for (size_t idx = 0; idx < count; ++idx) {
+        NativeType value1 = values1[idx];
+        NativeType value2 = values2[idx];
+        values[idx] = selectors[idx] ? value1 : value2;
+      }
+      PL_RETURN_IF_ERROR(out->AppendValues(values, count));
+      return Status::OK();
+    }
+  }
+
   static udf::InfRuleVec SemanticInferenceRules() {
     // Match the 1st and 2nd arg.
     return {udf::InheritTypeFromArgs<SelectUDF>::CreateGeneric({1, 2})};
@@ -59,6 +112,11 @@ class SelectUDF : public udf::ScalarUDF {
         .Arg("v2", "The return value when s is false")
         .Returns("Return v1 if s else v2");
   }
+
+ private:
+  std::vector<uint8_t> selectors_;
+  // The blended values of the numeric types.
+  std::vector<NativeType> values_;
 };
 
 }  // namespace builtins
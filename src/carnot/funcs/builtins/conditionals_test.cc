@@ -19,10 +19,12 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <vector>
 
 #include "src/carnot/funcs/builtins/conditionals.h"
 #include "src/carnot/udf/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
 
 namespace px {
 namespace carnot {
@@ -34,6 +36,68 @@ TEST(ConditionalsTest, SelectUDF) {
   udf_tester.ForInput(true, 20, 21).Expect(20);
 }
 
+TEST(ConditionalsTest, SelectUDFExecBatch) {
+  std::vector<types::BoolValue> s = {true, false, false, true, true, false, true, false, true};
+  std::vector<types::Int64Value> ints1 = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::vector<types::Int64Value> ints2 = {-1, -2, -3, -4, -5, -6, -7, -8, -9};
+  std::vector<types::Float64Value> floats1 = {1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5};
+  std::vector<types::Float64Value> floats2(s.size(), 0.0);
+  std::vector<types::StringValue> strs1 = {"error", "", "a", "bb", "", "ccc", "d", "e", "slo"};
+  std::vector<types::StringValue> strs2 = {"ok", "ok", "", "x", "y", "", "zz", "w", ""};
+  std::vector<types::BoolValue> bools1(s.size(), true);
+  std::vector<types::BoolValue> bools2 = {true, false, true, false, true, false, true, false, true};
+
+  SelectUDF<types::Int64Value> select_int;
+  auto int_res = udf::ExecArrow<SelectUDF<types::Int64Value>, arrow::Int64Builder>(
+      &select_int, s, ints1, ints2);
+  SelectUDF<types::Float64Value> select_float;
+  auto float_res = udf::ExecArrow<SelectUDF<types::Float64Value>, arrow::DoubleBuilder>(
+      &select_float, s, floats1, floats2);
+  SelectUDF<types::StringValue> select_str;
+  auto str_res = udf::ExecArrow<SelectUDF<types::StringValue>, arrow::StringBuilder>(
+      &select_str, s, strs1, strs2);
+  SelectUDF<types::BoolValue> select_bool;
+  auto bool_res = udf::ExecArrow<SelectUDF<types::BoolValue>, arrow::BooleanBuilder>(
+      &select_bool, s, bools1, bools2);
+
+  for (size_t i = 0; i < s.size(); ++i) {
+    EXPECT_EQ(s[i].val ? ints1[i].val : ints2[i].val,
+              static_cast<arrow::Int64Array*>(int_res.get())->Value(i));
+    EXPECT_EQ(s[i].val ? floats1[i].val : floats2[i].val,
+              static_cast<arrow::DoubleArray*>(float_res.get())->Value(i));
+    EXPECT_EQ(s[i].val ? strs1[i] : strs2[i],
+              static_cast<arrow::StringArray*>(str_res.get())->GetString(i));
+    EXPECT_EQ(s[i].val ? bools1[i].val : bools2[i].val,
+              static_cast<arrow::BooleanArray*>(bool_res.get())->Value(i));
+  }
+}
+
+TEST(ConditionalsTest, SelectUDFExecBatchSliced) {
+  std::vector<types::BoolValue> s = {true,  true,  true, false, true,
+                                     false, false, true, false, true};
+  std::vector<types::Int64Value> ints1 = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::vector<types::Int64Value> ints2 = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+  // The selectors start in the middle of a byte of the bitmap.
+  auto s_arr = types::ToArrow(s, arrow::default_memory_pool())->Slice(3);
+  auto ints1_arr = types::ToArrow(ints1, arrow::default_memory_pool())->Slice(3);
+  auto ints2_arr = types::ToArrow(ints2, arrow::default_memory_pool())->Slice(3);
+
+  SelectUDF<types::Int64Value> select_int;
+  auto ctx = udf::FunctionContext(nullptr, nullptr);
+  arrow::Int64Builder builder;
+  ASSERT_OK(select_int.ExecBatch(&ctx, s_arr->length(), &builder,
+                                 static_cast<arrow::BooleanArray*>(s_arr.get()),
+                                 static_cast<arrow::Int64Array*>(ints1_arr.get()),
+                                 static_cast<arrow::Int64Array*>(ints2_arr.get())));
+  std::shared_ptr<arrow::Array> res;
+  ASSERT_TRUE(builder.Finish(&res).ok());
+  std::vector<int64_t> expected = {13, 4, 15, 16, 7, 18, 9};
+  ASSERT_EQ(expected.size(), res->length());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], static_cast<arrow::Int64Array*>(res.get())->Value(i));
+  }
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
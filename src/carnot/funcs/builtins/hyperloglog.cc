@@ -0,0 +1,211 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/hyperloglog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+PL_SUPPRESS_WARNINGS_START()
+// NOLINTNEXTLINE: build/include_subdir
+#include "xxhash.h"
+PL_SUPPRESS_WARNINGS_END()
+
+#include "src/carnot/funcs/builtins/varint.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+namespace {
+
+constexpr uint8_t kSerializationVersion = 1;
+constexpr uint8_t kSparseFormat = 0;
+constexpr uint8_t kDenseFormat = 1;
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision_(std::clamp(precision, kMinPrecision, kMaxPrecision)),
+      num_registers_(uint32_t{1} << precision_),
+      max_sparse_size_(num_registers_ / 16) {}
+
+uint64_t HyperLogLog::Hash(const void* data, size_t len) {
+  // The hash is part of the serialized state, so it must not change between releases.
+  return XXH64(data, len, /* seed */ 0);
+}
+
+void HyperLogLog::ToDense() {
+  dense_.assign(num_registers_, 0);
+  for (const auto& [idx, rank] : sparse_) {
+    dense_[idx] = rank;
+  }
+  sparse_.clear();
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  if (other.precision_ != precision_) {
+    LOG(DFATAL) << absl::Substitute("Can't merge a HyperLogLog of precision $0 into one of $1",
+                                    other.precision_, precision_);
+    return;
+  }
+  if (other.is_sparse()) {
+    for (const auto& [idx, rank] : other.sparse_) {
+      SetRegister(idx, rank);
+    }
+    return;
+  }
+  if (is_sparse()) {
+    ToDense();
+  }
+  for (uint32_t i = 0; i < num_registers_; ++i) {
+    dense_[i] = std::max(dense_[i], other.dense_[i]);
+  }
+}
+
+int64_t HyperLogLog::Estimate() const {
+  const double m = num_registers_;
+  double sum = 0;
+  uint32_t zeros = 0;
+  if (is_sparse()) {
+    zeros = num_registers_ - sparse_.size();
+    sum = zeros;
+    for (const auto& [idx, rank] : sparse_) {
+      sum += std::ldexp(1.0, -rank);
+    }
+  } else {
+    for (uint8_t rank : dense_) {
+      zeros += rank == 0;
+      sum += std::ldexp(1.0, -rank);
+    }
+  }
+
+  const double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  // Linear counting is more accurate for small cardinalities.
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / zeros);
+  }
+  return std::llround(estimate);
+}
+
+// The format is the version byte, the precision byte, and the format byte. The sparse format is
+// followed by the number of set registers and, for each of them in order of index, the delta from
+// the previous index as a varint and the rank. The dense format is followed by all of the ranks.
+std::string HyperLogLog::Serialize() const {
+  std::string out;
+  out.push_back(static_cast<char>(kSerializationVersion));
+  out.push_back(static_cast<char>(precision_));
+
+  // A sparse register takes two bytes or more.
+  if (is_sparse() && 2 * sparse_.size() < num_registers_) {
+    std::vector<std::pair<uint32_t, uint8_t>> registers(sparse_.begin(), sparse_.end());
+    std::sort(registers.begin(), registers.end());
+    out.reserve(8 + 3 * registers.size());
+    out.push_back(static_cast<char>(kSparseFormat));
+    AppendVarint(&out, registers.size());
+    uint32_t prev_idx = 0;
+    for (const auto& [idx, rank] : registers) {
+      AppendVarint(&out, idx - prev_idx);
+      out.push_back(static_cast<char>(rank));
+      prev_idx = idx;
+    }
+    return out;
+  }
+
+  out.push_back(static_cast<char>(kDenseFormat));
+  if (is_sparse()) {
+    std::string dense(num_registers_, 0);
+    for (const auto& [idx, rank] : sparse_) {
+      dense[idx] = static_cast<char>(rank);
+    }
+    out.append(dense);
+  } else {
+    out.append(reinterpret_cast<const char*>(dense_.data()), dense_.size());
+  }
+  return out;
+}
+
+Status HyperLogLog::Deserialize(std::string_view data) {
+  if (data.size() < 3) {
+    return error::InvalidArgument("Truncated HyperLogLog header");
+  }
+  uint8_t version = data[0];
+  int precision = data[1];
+  uint8_t format = data[2];
+  data.remove_prefix(3);
+  if (version != kSerializationVersion) {
+    return error::InvalidArgument("Unsupported HyperLogLog version $0", static_cast<int>(version));
+  }
+  if (precision != precision_) {
+    return error::InvalidArgument("HyperLogLog has precision $0, expected $1", precision,
+                                  precision_);
+  }
+
+  sparse_.clear();
+  dense_.clear();
+  const uint8_t max_rank = 64 - precision_ + 1;
+  if (format == kDenseFormat) {
+    if (data.size() != num_registers_) {
+      return error::InvalidArgument("HyperLogLog has $0 registers, expected $1", data.size(),
+                                    num_registers_);
+    }
+    dense_.assign(data.begin(), data.end());
+    if (*std::max_element(dense_.begin(), dense_.end()) > max_rank) {
+      dense_.clear();
+      return error::InvalidArgument("HyperLogLog has an invalid rank");
+    }
+    return Status::OK();
+  }
+  if (format != kSparseFormat) {
+    return error::InvalidArgument("Unknown HyperLogLog format $0", static_cast<int>(format));
+  }
+
+  uint64_t num_set = 0;
+  if (!ConsumeVarint(&data, &num_set) || num_set > num_registers_) {
+    return error::InvalidArgument("Invalid number of HyperLogLog registers");
+  }
+  uint64_t idx = 0;
+  for (uint64_t i = 0; i < num_set; ++i) {
+    uint64_t delta = 0;
+    if (!ConsumeVarint(&data, &delta) || data.empty()) {
+      sparse_.clear();
+      return error::InvalidArgument("Truncated HyperLogLog register");
+    }
+    idx += delta;
+    uint8_t rank = data.front();
+    data.remove_prefix(1);
+    if (idx >= num_registers_ || rank > max_rank) {
+      sparse_.clear();
+      return error::InvalidArgument("HyperLogLog has an invalid register");
+    }
+    SetRegister(idx, rank);
+  }
+  if (!data.empty()) {
+    Status s = error::InvalidArgument("HyperLogLog has $0 trailing bytes", data.size());
+    sparse_.clear();
+    dense_.clear();
+    return s;
+  }
+  return Status::OK();
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+/**
+ * HyperLogLog estimates the number of distinct values it was given, in a fixed amount of memory:
+ * http://algo.inria.fr/flajolet/Publications/FlFuGaMe07.pdf.
+ *
+ * The values are added by their 64 bit hash, which has to be stable across processes for sketches
+ * from different agents to be merged. The 2^precision registers are kept sparse, until enough of
+ * them are set that an array is smaller. The standard error is 1.04 / sqrt(2^precision).
+ */
+class HyperLogLog {
+ public:
+  static constexpr int kMinPrecision = 4;
+  static constexpr int kMaxPrecision = 16;
+
+  explicit HyperLogLog(int precision);
+
+  /**
+   * Adds a value by its bytes.
+   */
+  void Add(const void* data, size_t len) { AddHash(Hash(data, len)); }
+
+  void AddHash(uint64_t hash) {
+    uint32_t idx = hash >> (64 - precision_);
+    // Set the lowest bit of the register index so that the rank is bounded for a hash of zero.
+    uint64_t w = (hash << precision_) | (uint64_t{1} << (precision_ - 1));
+    SetRegister(idx, static_cast<uint8_t>(__builtin_clzll(w) + 1));
+  }
+
+  void Merge(const HyperLogLog& other);
+
+  int64_t Estimate() const;
+
+  /**
+   * Serializes the registers in whichever of the sparse or dense format is smaller.
+   */
+  std::string Serialize() const;
+  Status Deserialize(std::string_view data);
+
+  int precision() const { return precision_; }
+  bool is_sparse() const { return dense_.empty(); }
+
+ private:
+  void SetRegister(uint32_t idx, uint8_t rank) {
+    if (!dense_.empty()) {
+      dense_[idx] = std::max(dense_[idx], rank);
+      return;
+    }
+    uint8_t& value = sparse_[idx];
+    value = std::max(value, rank);
+    if (sparse_.size() > max_sparse_size_) {
+      ToDense();
+    }
+  }
+  void ToDense();
+
+  static uint64_t Hash(const void* data, size_t len);
+
+  int precision_;
+  uint32_t num_registers_;
+  // The sparse map takes more memory per register than the array, so it's converted at a fraction
+  // of the number of registers.
+  size_t max_sparse_size_;
+
+  // Only one of these is used at a time. The registers start out sparse.
+  absl::flat_hash_map<uint32_t, uint8_t> sparse_;
+  std::vector<uint8_t> dense_;
+};
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
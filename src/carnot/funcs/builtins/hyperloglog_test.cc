@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/carnot/funcs/builtins/hyperloglog.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+namespace {
+
+void AddRange(HyperLogLog* hll, uint64_t begin, uint64_t end) {
+  for (uint64_t i = begin; i < end; ++i) {
+    hll->Add(&i, sizeof(i));
+  }
+}
+
+}  // namespace
+
+TEST(HyperLogLog, empty) {
+  HyperLogLog hll(14);
+  EXPECT_EQ(0, hll.Estimate());
+}
+
+TEST(HyperLogLog, small_cardinalities_are_exact) {
+  HyperLogLog hll(14);
+  AddRange(&hll, 0, 100);
+  AddRange(&hll, 0, 100);
+  EXPECT_EQ(100, hll.Estimate());
+  EXPECT_TRUE(hll.is_sparse());
+}
+
+TEST(HyperLogLog, large_cardinality_within_error) {
+  HyperLogLog hll(14);
+  AddRange(&hll, 0, 1000000);
+  EXPECT_FALSE(hll.is_sparse());
+  // The standard error at precision 14 is 0.81%.
+  EXPECT_NEAR(1000000, hll.Estimate(), 1000000 * 0.03);
+}
+
+TEST(HyperLogLog, merge) {
+  HyperLogLog a(12);
+  HyperLogLog b(12);
+  AddRange(&a, 0, 50000);
+  AddRange(&b, 25000, 75000);
+  a.Merge(b);
+  EXPECT_NEAR(75000, a.Estimate(), 75000 * 0.05);
+
+  // Merging a sketch into itself changes nothing.
+  int64_t estimate = a.Estimate();
+  HyperLogLog copy = a;
+  a.Merge(copy);
+  EXPECT_EQ(estimate, a.Estimate());
+}
+
+TEST(HyperLogLog, serialize_sparse_and_dense) {
+  for (uint64_t n : {10, 100000}) {
+    HyperLogLog hll(14);
+    AddRange(&hll, 0, n);
+    std::string serialized = hll.Serialize();
+    if (n == 10) {
+      EXPECT_LT(serialized.size(), 40);
+    } else {
+      EXPECT_EQ(3 + (1 << 14), serialized.size());
+    }
+
+    HyperLogLog deserialized(14);
+    ASSERT_OK(deserialized.Deserialize(serialized));
+    EXPECT_EQ(hll.Estimate(), deserialized.Estimate());
+    EXPECT_EQ(serialized, deserialized.Serialize());
+  }
+}
+
+TEST(HyperLogLog, deserialize_invalid) {
+  HyperLogLog hll(14);
+  AddRange(&hll, 0, 10);
+  std::string serialized = hll.Serialize();
+
+  HyperLogLog other_precision(12);
+  EXPECT_NOT_OK(other_precision.Deserialize(serialized));
+
+  HyperLogLog deserialized(14);
+  EXPECT_NOT_OK(deserialized.Deserialize(""));
+  EXPECT_NOT_OK(deserialized.Deserialize(serialized.substr(0, serialized.size() - 1)));
+  EXPECT_NOT_OK(deserialized.Deserialize(serialized + "x"));
+  EXPECT_EQ(0, deserialized.Estimate());
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -18,6 +18,9 @@
 
 #include "src/carnot/funcs/builtins/json_ops.h"
 
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
 #include "src/carnot/udf/registry.h"
 
 namespace px {
@@ -26,6 +29,203 @@ namespace builtins {
 
 using types::StringValue;
 
+namespace {
+
+/**
+ * A SAX handler that picks one value out of the root object or array. Everything else is skipped
+ * without being stored, and the handler stops the parser once the value is complete. Objects and
+ * arrays are serialized as they are read.
+ */
+class PluckHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, PluckHandler> {
+ public:
+  // Selects the member of the root object with the given key.
+  explicit PluckHandler(std::string_view key) : by_key_(true), key_(key), index_(0) {}
+  // Selects the element of the root array at the given index.
+  explicit PluckHandler(int64_t index) : by_key_(false), key_(), index_(index) {}
+
+  PluckedJSONValue* value() { return &value_; }
+
+  bool Null() {
+    if (capturing_) {
+      return writer_.Null();
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    value_.type = PluckedJSONValue::kNull;
+    return false;
+  }
+  bool Bool(bool b) {
+    if (capturing_) {
+      return writer_.Bool(b);
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    writer_.Bool(b);
+    return Done(PluckedJSONValue::kOther);
+  }
+  bool Int(int i) { return Int64(i); }
+  bool Uint(unsigned u) { return Int64(u); }
+  bool Int64(int64_t i) {
+    if (capturing_) {
+      return writer_.Int64(i);
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    value_.int_value = i;
+    value_.double_value = static_cast<double>(i);
+    writer_.Int64(i);
+    return Done(PluckedJSONValue::kInt);
+  }
+  bool Uint64(uint64_t u) {
+    if (capturing_) {
+      return writer_.Uint64(u);
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    value_.int_value = static_cast<int64_t>(u);
+    value_.double_value = static_cast<double>(u);
+    writer_.Uint64(u);
+    return Done(PluckedJSONValue::kInt);
+  }
+  bool Double(double d) {
+    if (capturing_) {
+      return writer_.Double(d);
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    value_.double_value = d;
+    writer_.Double(d);
+    return Done(PluckedJSONValue::kDouble);
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool copy) {
+    if (capturing_) {
+      return writer_.String(str, length, copy);
+    }
+    if (!Selected()) {
+      return depth_ > 0;
+    }
+    value_.type = PluckedJSONValue::kString;
+    value_.str.assign(str, length);
+    return false;
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+    if (capturing_) {
+      return writer_.Key(str, length, copy);
+    }
+    if (depth_ == 1) {
+      key_matches_ = std::string_view(str, length) == key_;
+    }
+    return true;
+  }
+  bool StartObject() {
+    if (!StartContainer(/* is_object */ true)) {
+      return false;
+    }
+    return !capturing_ || writer_.StartObject();
+  }
+  bool EndObject(rapidjson::SizeType count) {
+    --depth_;
+    if (!capturing_) {
+      return true;
+    }
+    writer_.EndObject(count);
+    return depth_ != capture_depth_ || Done(PluckedJSONValue::kOther);
+  }
+  bool StartArray() {
+    if (!StartContainer(/* is_object */ false)) {
+      return false;
+    }
+    return !capturing_ || writer_.StartArray();
+  }
+  bool EndArray(rapidjson::SizeType count) {
+    --depth_;
+    if (!capturing_) {
+      return true;
+    }
+    writer_.EndArray(count);
+    return depth_ != capture_depth_ || Done(PluckedJSONValue::kOther);
+  }
+
+ private:
+  // Whether the value that starts now is the selected one. Called once for every value that isn't
+  // part of a value being captured.
+  bool Selected() {
+    if (depth_ != 1) {
+      return false;
+    }
+    if (by_key_) {
+      return key_matches_;
+    }
+    return element_idx_++ == index_;
+  }
+
+  bool StartContainer(bool is_object) {
+    if (capturing_) {
+      ++depth_;
+      return true;
+    }
+    if (depth_ == 0) {
+      // The root needs to be an object to select by key, or an array to select by index.
+      ++depth_;
+      return is_object == by_key_;
+    }
+    if (Selected()) {
+      capturing_ = true;
+      capture_depth_ = depth_;
+    }
+    ++depth_;
+    return true;
+  }
+
+  // Stops the parser, with the serialized value as the result.
+  bool Done(PluckedJSONValue::Type type) {
+    value_.type = type;
+    value_.str.assign(buffer_.GetString(), buffer_.GetSize());
+    return false;
+  }
+
+  const bool by_key_;
+  const std::string_view key_;
+  const int64_t index_;
+
+  int depth_ = 0;
+  bool key_matches_ = false;
+  int64_t element_idx_ = 0;
+
+  bool capturing_ = false;
+  int capture_depth_ = 0;
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_{buffer_};
+
+  PluckedJSONValue value_;
+};
+
+PluckedJSONValue Pluck(std::string_view json, PluckHandler* handler) {
+  rapidjson::MemoryStream stream(json.data(), json.size());
+  rapidjson::Reader reader;
+  // The handler stops the parser when it finds the value. Otherwise the document is parsed to the
+  // end (or to the first error) without it.
+  reader.Parse(stream, *handler);
+  return std::move(*handler->value());
+}
+
+}  // namespace
+
+PluckedJSONValue PluckJSONKey(std::string_view json, std::string_view key) {
+  PluckHandler handler(key);
+  return Pluck(json, &handler);
+}
+
+PluckedJSONValue PluckJSONIndex(std::string_view json, int64_t index) {
+  PluckHandler handler(index);
+  return Pluck(json, &handler);
+}
+
 void RegisterJSONOpsOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<PluckUDF>("pluck");
   registry->RegisterOrDie<PluckAsInt64UDF>("pluck_int64");
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -33,36 +34,45 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * The value that was plucked out of a JSON document.
+ */
+struct PluckedJSONValue {
+  enum Type {
+    kNotFound,
+    kNull,
+    kString,
+    kInt,
+    kDouble,
+    // Booleans, objects and arrays.
+    kOther,
+  };
+  Type type = kNotFound;
+  // The string value, or the serialized JSON of any other value.
+  std::string str;
+  int64_t int_value = 0;
+  double double_value = 0;
+};
+
+/**
+ * Finds the value of a key of the root JSON object, or of an element of the root JSON array.
+ * The document isn't built in memory, and the parsing stops as soon as the value has been read, so
+ * the rest of the document doesn't need to be valid JSON.
+ */
+PluckedJSONValue PluckJSONKey(std::string_view json, std::string_view key);
+PluckedJSONValue PluckJSONIndex(std::string_view json, int64_t index);
+
 // TODO(zasgar): PL-419 To have proper support for JSON we need structs and nullable types.
 // Revisit when we have them.
 class PluckUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    PluckedJSONValue value = PluckJSONKey(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return "";
-    }
-    if (!d.IsObject()) {
+    if (value.type == PluckedJSONValue::kNotFound || value.type == PluckedJSONValue::kNull) {
       return "";
     }
-    if (!d.HasMember(key.data())) {
-      return "";
-    }
-    const auto& plucked_value = d[key.data()];
-    if (plucked_value.IsNull()) {
-      return "";
-    }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
-    }
-
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+    return std::move(value.str);
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -87,17 +97,12 @@ class PluckUDF : public udf::ScalarUDF {
 class PluckAsInt64UDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    PluckedJSONValue value = PluckJSONKey(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0;
-    }
-    if (!d.IsObject()) {
+    if (value.type != PluckedJSONValue::kInt) {
       return 0;
     }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetInt64();
+    return value.int_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -122,17 +127,12 @@ class PluckAsInt64UDF : public udf::ScalarUDF {
 class PluckAsFloat64UDF : public udf::ScalarUDF {
  public:
   Float64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    PluckedJSONValue value = PluckJSONKey(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0.0;
-    }
-    if (!d.IsObject()) {
+    if (value.type != PluckedJSONValue::kInt && value.type != PluckedJSONValue::kDouble) {
       return 0.0;
     }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetDouble();
+    return value.double_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -160,33 +160,12 @@ class PluckAsFloat64UDF : public udf::ScalarUDF {
 class PluckArrayUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue in, Int64Value index) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    PluckedJSONValue value = PluckJSONIndex(in, index.val);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
+    if (value.type == PluckedJSONValue::kNotFound || value.type == PluckedJSONValue::kNull) {
       return "";
     }
-    if (!d.IsArray()) {
-      return "";
-    }
-    const auto& plucked_array = d.GetArray();
-    if (index < 0 || index >= plucked_array.Size()) {
-      return "";
-    }
-
-    const auto& plucked_value = plucked_array[index.val];
-    if (plucked_value.IsNull()) {
-      return "";
-    }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
-    }
-
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+    return std::move(value.str);
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
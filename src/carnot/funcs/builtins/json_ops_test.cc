@@ -62,6 +62,22 @@ TEST(JSONOps, PluckUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "str_key").Expect("");
 }
 
+TEST(JSONOps, PluckUDF_only_top_level_keys) {
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  udf_tester.ForInput(R"({"nested": {"key": 1}, "key": [true, null, {"a": 2.5}]})", "key")
+      .Expect(R"([true,null,{"a":2.5}])");
+  udf_tester.ForInput(R"({"nested": {"key": 1}})", "key").Expect("");
+  udf_tester.ForInput(R"({"key": null})", "key").Expect("");
+  udf_tester.ForInput(R"({"key": false})", "key").Expect("false");
+}
+
+TEST(JSONOps, PluckUDF_stops_after_value) {
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  // The document is only parsed up to the plucked value.
+  udf_tester.ForInput(R"({"key": "value", "truncated": [1, 2)", "key").Expect("value");
+  udf_tester.ForInput(R"({"truncated": [1, 2)", "key").Expect("");
+}
+
 TEST(JSONOps, PluckAsInt64UDF) {
   auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
   udf_tester.ForInput(kTestJSONStr, "int64_key").Expect(34243242341);
@@ -77,6 +93,13 @@ TEST(JSONOps, PluckAsIntUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "int64_key").Expect(0);
 }
 
+TEST(JSONOps, PluckAsInt64UDF_non_int_value_return_empty) {
+  auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "str_plain").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "blah").Expect(0);
+}
+
 TEST(JSONOps, PluckAsFloat64UDF) {
   auto udf_tester = udf::UDFTester<PluckAsFloat64UDF>();
   udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(123423.5234);
@@ -97,6 +120,13 @@ TEST(JSONOps, PluckArrayUDF) {
   udf_tester.ForInput(kTestJSONArray, 2).Expect(R"({"pixie":"labs"})");
 }
 
+TEST(JSONOps, PluckArrayUDF_index_of_nested_arrays) {
+  auto udf_tester = udf::UDFTester<PluckArrayUDF>();
+  udf_tester.ForInput(R"([[1, 2], {"a": [3]}, 4])", 1).Expect(R"({"a":[3]})");
+  udf_tester.ForInput(R"([[1, 2], {"a": [3]}, 4])", 2).Expect("4");
+  udf_tester.ForInput(R"([[1, 2], {"a": [3]}, 4])", -1).Expect("");
+}
+
 TEST(JSONOps, PluckArrayUDF_input_is_not_array) {
   auto udf_tester = udf::UDFTester<PluckArrayUDF>();
   udf_tester.ForInput(kTestJSONStr, 0).Expect("");
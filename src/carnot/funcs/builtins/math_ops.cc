@@ -207,7 +207,7 @@ void RegisterMathOpsOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<GreaterThanUDF<types::StringValue, types::StringValue>>(
       "greaterThanEqual");
 
-  registry->RegisterOrDie<GreaterThanUDF<types::Time64NSValue, types::Time64NSValue>>(
+  registry->RegisterOrDie<GreaterThanEqualUDF<types::Time64NSValue, types::Time64NSValue>>(
       "greaterThanEqual");
   // <
   registry->RegisterOrDie<LessThanUDF<types::Int64Value, types::Int64Value>>("lessThan");
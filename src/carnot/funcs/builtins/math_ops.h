@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -34,6 +35,11 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class AddUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val + b2.val; }
+  void ExecVector(FunctionContext*, size_t count, TReturn* out, const TArg1* b1, const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val + b2[i].val;
+    }
+  }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
         udf::InheritTypeFromArgs<AddUDF>::Create({types::ST_BYTES, types::ST_THROUGHPUT_PER_NS,
@@ -59,6 +65,11 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class SubtractUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val - b2.val; }
+  void ExecVector(FunctionContext*, size_t count, TReturn* out, const TArg1* b1, const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val - b2[i].val;
+    }
+  }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
         udf::InheritTypeFromArgs<SubtractUDF>::Create({types::ST_BYTES, types::ST_THROUGHPUT_PER_NS,
@@ -89,6 +100,11 @@ class DivideUDF : public udf::ScalarUDF {
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) {
     return ReturnValueType(b1.val) / ReturnValueType(b2.val);
   }
+  void ExecVector(FunctionContext*, size_t count, TReturn* out, const TArg1* b1, const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = ReturnValueType(b1[i].val) / ReturnValueType(b2[i].val);
+    }
+  }
 
   static udf::InfRuleVec SemanticInferenceRules() {
     return {udf::ExplicitRule::Create<DivideUDF>(types::ST_THROUGHPUT_PER_NS,
@@ -114,6 +130,11 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class MultiplyUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val * b2.val; }
+  void ExecVector(FunctionContext*, size_t count, TReturn* out, const TArg1* b1, const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val * b2[i].val;
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Multiplies the arguments.")
         .Details("Multiplies the two values together. Accessible using the `*` operator syntax.")
@@ -369,6 +390,12 @@ template <typename TArg1, typename TArg2>
 class EqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 == b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] == b2[i];
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are equal.")
         .Details(
@@ -389,6 +416,12 @@ template <typename TArg1, typename TArg2>
 class NotEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 != b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] != b2[i];
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are not equal.")
         .Details(
@@ -436,6 +469,12 @@ template <typename TArg1, typename TArg2>
 class GreaterThanUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 > b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] > b2[i];
+    }
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -455,6 +494,12 @@ template <typename TArg1, typename TArg2>
 class GreaterThanEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 >= b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] >= b2[i];
+    }
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -475,6 +520,12 @@ template <typename TArg1, typename TArg2>
 class LessThanUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 < b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] < b2[i];
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than the other.")
         .Example(R"doc(# Implict call.
@@ -491,6 +542,12 @@ template <typename TArg1, typename TArg2>
 class LessThanEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 <= b2; }
+  void ExecVector(FunctionContext*, size_t count, BoolValue* out, const TArg1* b1,
+                  const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] <= b2[i];
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than or equal to the the other.")
         .Example(R"doc(
@@ -511,6 +568,11 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class BinUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val - (b1.val % b2.val); }
+  void ExecVector(FunctionContext*, size_t count, TReturn* out, const TArg1* b1, const TArg2* b2) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val - (b1[i].val % b2[i].val);
+    }
+  }
   static udf::ScalarUDFDocBuilder Doc() { return BinDoc(); }
 };
 
@@ -553,6 +615,15 @@ class MeanUDA : public udf::UDA {
     info_.size++;
     info_.count += arg.val;
   }
+  // The values are added in order, so the result matches updating them one at a time.
+  void UpdateVector(FunctionContext*, size_t count, const TArg* args) {
+    double sum = info_.count;
+    for (size_t i = 0; i < count; ++i) {
+      sum += args[i].val;
+    }
+    info_.size += count;
+    info_.count = sum;
+  }
   void Merge(FunctionContext*, const MeanUDA& other) {
     info_.size += other.info_.size;
     info_.count += other.info_.count;
@@ -596,6 +667,13 @@ template <typename TArg, typename TAggType = TArg>
 class SumUDA : public udf::UDA {
  public:
   void Update(FunctionContext*, TArg arg) { sum_ = sum_.val + arg.val; }
+  void UpdateVector(FunctionContext*, size_t count, const TArg* args) {
+    auto sum = sum_.val;
+    for (size_t i = 0; i < count; ++i) {
+      sum += args[i].val;
+    }
+    sum_ = sum;
+  }
   void Merge(FunctionContext*, const SumUDA& other) { sum_ = sum_.val + other.sum_.val; }
   TAggType Finalize(FunctionContext*) { return sum_; }
   static udf::InfRuleVec SemanticInferenceRules() {
@@ -631,6 +709,14 @@ class MaxUDA : public udf::UDA {
       max_ = arg;
     }
   }
+  // Branchless, so that the compiler can vectorize the loop.
+  void UpdateVector(FunctionContext*, size_t count, const TArg* args) {
+    auto max = max_.val;
+    for (size_t i = 0; i < count; ++i) {
+      max = std::max(max, args[i].val);
+    }
+    max_ = max;
+  }
   void Merge(FunctionContext*, const MaxUDA& other) {
     if (other.max_.val > max_.val) {
       max_ = other.max_;
@@ -673,6 +759,14 @@ class MinUDA : public udf::UDA {
       min_ = arg;
     }
   }
+  // Branchless, so that the compiler can vectorize the loop.
+  void UpdateVector(FunctionContext*, size_t count, const TArg* args) {
+    auto min = min_.val;
+    for (size_t i = 0; i < count; ++i) {
+      min = std::min(min, args[i].val);
+    }
+    min_ = min;
+  }
   void Merge(FunctionContext*, const MinUDA& other) {
     if (other.min_.val < min_.val) {
       min_ = other.min_;
@@ -710,6 +804,7 @@ template <typename TArg>
 class CountUDA : public udf::UDA {
  public:
   void Update(FunctionContext*, TArg) { count_++; }
+  void UpdateVector(FunctionContext*, size_t count, const TArg*) { count_ += count; }
   void Merge(FunctionContext*, const CountUDA& other) { count_ += other.count_; }
   Int64Value Finalize(FunctionContext*) { return count_; }
 
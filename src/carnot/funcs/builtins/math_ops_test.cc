@@ -638,6 +638,45 @@ TEST(MathOps, partial_count_test) {
   auto uda_tester = udf::UDATester<CountUDA<types::Int64Value>>();
   uda_tester.ForInput(3).ForInput(6).ForInput(10).ForInput(5).ForInput(2).Expect(5);
 }
+
+// Updates one UDA with UpdateVector and another with Update, and checks that they finalize to the
+// same value.
+template <typename TUDA, typename TArg>
+void ExpectUpdateVectorMatchesUpdate(const std::vector<TArg>& values) {
+  TUDA vector_uda;
+  TUDA row_uda;
+  // Split the values in two batches, to also cover updating after a batch.
+  size_t half = values.size() / 2;
+  vector_uda.UpdateVector(nullptr, half, values.data());
+  vector_uda.UpdateVector(nullptr, values.size() - half, values.data() + half);
+  for (const auto& value : values) {
+    row_uda.Update(nullptr, value);
+  }
+  EXPECT_EQ(row_uda.Finalize(nullptr), vector_uda.Finalize(nullptr));
+}
+
+TEST(MathOps, uda_update_vector) {
+  std::vector<types::Int64Value> ints = {5, -2, 7, 1, 100, 3, -50};
+  std::vector<types::Float64Value> floats = {1.234, 2.442, 1.04, 5.322, 6.333};
+  std::vector<types::BoolValue> bools = {true, false, true, true};
+  std::vector<types::Time64NSValue> times = {30, 10, 20};
+
+  ExpectUpdateVectorMatchesUpdate<SumUDA<types::Int64Value>>(ints);
+  ExpectUpdateVectorMatchesUpdate<SumUDA<types::Float64Value>>(floats);
+  ExpectUpdateVectorMatchesUpdate<SumUDA<types::BoolValue, types::Int64Value>>(bools);
+  ExpectUpdateVectorMatchesUpdate<MeanUDA<types::Int64Value>>(ints);
+  ExpectUpdateVectorMatchesUpdate<MeanUDA<types::Float64Value>>(floats);
+  ExpectUpdateVectorMatchesUpdate<MeanUDA<types::BoolValue>>(bools);
+  ExpectUpdateVectorMatchesUpdate<MaxUDA<types::Int64Value>>(ints);
+  ExpectUpdateVectorMatchesUpdate<MaxUDA<types::Float64Value>>(floats);
+  ExpectUpdateVectorMatchesUpdate<MaxUDA<types::Time64NSValue>>(times);
+  ExpectUpdateVectorMatchesUpdate<MinUDA<types::Int64Value>>(ints);
+  ExpectUpdateVectorMatchesUpdate<MinUDA<types::Float64Value>>(floats);
+  ExpectUpdateVectorMatchesUpdate<MinUDA<types::Time64NSValue>>(times);
+  ExpectUpdateVectorMatchesUpdate<CountUDA<types::Int64Value>>(ints);
+  ExpectUpdateVectorMatchesUpdate<CountUDA<types::BoolValue>>(bools);
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -18,6 +18,17 @@
 
 #include "src/carnot/funcs/builtins/math_sketches.h"
 
+DEFINE_double(carnot_quantiles_compression,
+              gflags::DoubleFromEnv("PL_CARNOT_QUANTILES_COMPRESSION", 500),
+              "The compression of the t-digests behind px.quantiles. Higher values are more "
+              "accurate, and make the partial aggregates that are sent between agents larger.");
+
+DEFINE_int32(carnot_approx_count_distinct_precision,
+             gflags::Int32FromEnv("PL_CARNOT_APPROX_COUNT_DISTINCT_PRECISION", 14),
+             "The number of bits of the hash that pick the register of the HyperLogLog behind "
+             "px.approx_count_distinct, between 4 and 16. Each additional bit halves the variance "
+             "of the estimate and doubles the size of the partial aggregates.");
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -25,6 +36,12 @@ namespace builtins {
 void RegisterMathSketchesOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<QuantilesUDA<types::Int64Value>>("quantiles");
   registry->RegisterOrDie<QuantilesUDA<types::Float64Value>>("quantiles");
+  registry->RegisterOrDie<MergeQuantilesUDA>("merge_quantiles");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Int64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Float64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::StringValue>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::UInt128Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Time64NSValue>>("approx_count_distinct");
 }
 
 }  // namespace builtins
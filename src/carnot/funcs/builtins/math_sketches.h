@@ -21,37 +21,56 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <type_traits>
+
+#include "src/carnot/funcs/builtins/hyperloglog.h"
+#include "src/carnot/funcs/builtins/quantile_sketch.h"
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
-#include "tdigest/tdigest.h"
+
+DECLARE_double(carnot_quantiles_compression);
+DECLARE_int32(carnot_approx_count_distinct_precision);
 
 namespace px {
 namespace carnot {
 namespace builtins {
 
+// Serializes the percentiles that px.quantiles returns as a JSON dictionary.
+inline StringValue QuantilesToJSON(QuantileSketch* sketch) {
+  rapidjson::Document d;
+  d.SetObject();
+  d.AddMember("p01", sketch->Quantile(0.01), d.GetAllocator());
+  d.AddMember("p10", sketch->Quantile(0.10), d.GetAllocator());
+  d.AddMember("p25", sketch->Quantile(0.25), d.GetAllocator());
+  d.AddMember("p50", sketch->Quantile(0.50), d.GetAllocator());
+  d.AddMember("p75", sketch->Quantile(0.75), d.GetAllocator());
+  d.AddMember("p90", sketch->Quantile(0.90), d.GetAllocator());
+  d.AddMember("p99", sketch->Quantile(0.99), d.GetAllocator());
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  d.Accept(writer);
+  return sb.GetString();
+}
+
 // TODO(zasgar): PL-419 Replace this when we add support for structs.
 template <typename TArg>
 class QuantilesUDA : public udf::UDA {
  public:
-  QuantilesUDA() : digest_(1000) {}
-  void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
-  void Merge(FunctionContext*, const QuantilesUDA& other) { digest_.merge(&other.digest_); }
-
-  StringValue Finalize(FunctionContext*) {
-    rapidjson::Document d;
-    d.SetObject();
-    d.AddMember("p01", digest_.quantile(0.01), d.GetAllocator());
-    d.AddMember("p10", digest_.quantile(0.10), d.GetAllocator());
-    d.AddMember("p25", digest_.quantile(0.25), d.GetAllocator());
-    d.AddMember("p50", digest_.quantile(0.50), d.GetAllocator());
-    d.AddMember("p75", digest_.quantile(0.75), d.GetAllocator());
-    d.AddMember("p90", digest_.quantile(0.90), d.GetAllocator());
-    d.AddMember("p99", digest_.quantile(0.99), d.GetAllocator());
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    d.Accept(writer);
-    return sb.GetString();
+  QuantilesUDA() : sketch_(FLAGS_carnot_quantiles_compression) {}
+  void Update(FunctionContext*, TArg val) { sketch_.Add(val.val); }
+  void UpdateVector(FunctionContext*, size_t count, const TArg* vals) {
+    using NativeType = typename types::ValueTypeTraits<TArg>::native_type;
+    static_assert(sizeof(TArg) == sizeof(NativeType));
+    sketch_.AddBatch(reinterpret_cast<const NativeType*>(vals), count);
   }
+  void Merge(FunctionContext*, const QuantilesUDA& other) { sketch_.Merge(other.sketch_); }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sketch_.Deserialize(data);
+  }
+
+  StringValue Finalize(FunctionContext*) { return QuantilesToJSON(&sketch_); }
 
   static udf::InfRuleVec SemanticInferenceRules() {
     return {udf::ExplicitRule::Create<QuantilesUDA>(types::ST_QUANTILES, {types::ST_NONE}),
@@ -78,7 +97,95 @@ class QuantilesUDA : public udf::UDA {
   }
 
  protected:
-  tdigest::TDigest digest_;
+  QuantileSketch sketch_;
+};
+
+class MergeQuantilesUDA : public udf::UDA {
+ public:
+  MergeQuantilesUDA()
+      : sketch_(FLAGS_carnot_quantiles_compression), state_(FLAGS_carnot_quantiles_compression) {}
+  void Update(FunctionContext*, StringValue state) {
+    // States that aren't serialized sketches, such as nulls written as empty strings, are skipped.
+    if (state_.Deserialize(state).ok()) {
+      sketch_.Merge(state_);
+    }
+  }
+  void Merge(FunctionContext*, const MergeQuantilesUDA& other) { sketch_.Merge(other.sketch_); }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sketch_.Deserialize(data);
+  }
+
+  StringValue Finalize(FunctionContext*) { return QuantilesToJSON(&sketch_); }
+
+  static udf::InfRuleVec SemanticInferenceRules() {
+    return {udf::ExplicitRule::Create<MergeQuantilesUDA>(types::ST_QUANTILES, {types::ST_NONE})};
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Merges the serialized distributions of the aggregated data.")
+        .Details(
+            "Merges the distributions that the table store rollups keep as the <column>_quantiles "
+            "columns of their tables, and returns the same percentiles as `px.quantiles`.")
+        .Example(R"doc(
+        | # Calculate the quantiles of the latency from its rollup table.
+        | df = px.DataFrame('http_events_1m')
+        | df = df.groupby('req_path').agg(latency_dist=('latency_quantiles', px.merge_quantiles))
+        )doc")
+        .Arg("state", "The serialized distributions to merge.")
+        .Returns("The quantiles data, serialized as a JSON dictionary.");
+  }
+
+ protected:
+  QuantileSketch sketch_;
+  // The distribution that is merged by Update, kept to reuse its memory.
+  QuantileSketch state_;
+};
+
+template <typename TArg>
+class ApproxCountDistinctUDA : public udf::UDA {
+ public:
+  ApproxCountDistinctUDA() : sketch_(FLAGS_carnot_approx_count_distinct_precision) {}
+  void Update(FunctionContext*, TArg val) {
+    if constexpr (std::is_same_v<TArg, StringValue>) {
+      sketch_.Add(val.data(), val.size());
+    } else if constexpr (std::is_same_v<TArg, UInt128Value>) {
+      const uint64_t words[] = {val.High64(), val.Low64()};
+      sketch_.Add(words, sizeof(words));
+    } else {
+      sketch_.Add(&val.val, sizeof(val.val));
+    }
+  }
+  void Merge(FunctionContext*, const ApproxCountDistinctUDA& other) {
+    sketch_.Merge(other.sketch_);
+  }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sketch_.Deserialize(data);
+  }
+
+  Int64Value Finalize(FunctionContext*) { return sketch_.Estimate(); }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the number of distinct values of the aggregated data.")
+        .Details(
+            "Estimates the number of distinct values using "
+            "[HyperLogLog](https://en.wikipedia.org/wiki/HyperLogLog), in a fixed amount of "
+            "memory per group. The estimate is typically within 1% of the exact count. Unlike "
+            "counting the groups of the values, it can be aggregated on each agent before the "
+            "results are merged.")
+        .Example(R"doc(
+        | # Estimate the number of distinct remote addresses of each service.
+        | df = df.groupby('service').agg(num_clients=('remote_addr', px.approx_count_distinct))
+        )doc")
+        .Arg("val", "The data to count the distinct values of.")
+        .Returns("The approximate number of distinct values.");
+  }
+
+ protected:
+  HyperLogLog sketch_;
 };
 
 void RegisterMathSketchesOrDie(udf::Registry* registry);
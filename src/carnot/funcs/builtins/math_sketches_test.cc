@@ -19,6 +19,8 @@
 #include <gtest/gtest.h>
 #include <rapidjson/document.h>
 
+#include <vector>
+
 #include "src/carnot/funcs/builtins/math_sketches.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
@@ -69,6 +71,67 @@ TEST(MathSketches, quantiles_int64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6);
 }
 
+TEST(MathSketches, quantiles_partial_aggregate) {
+  QuantilesUDA<types::Int64Value> uda;
+  std::vector<types::Int64Value> values = {1, 2, 2, 1, 1, 5, 6};
+  uda.UpdateVector(nullptr, values.size(), values.data());
+  auto expected = uda.Finalize(nullptr);
+
+  QuantilesUDA<types::Int64Value> deserialized;
+  ASSERT_OK(deserialized.Deserialize(nullptr, uda.Serialize(nullptr)));
+  EXPECT_EQ(expected, deserialized.Finalize(nullptr));
+
+  EXPECT_NOT_OK(deserialized.Deserialize(nullptr, "not a sketch"));
+}
+
+TEST(MathSketches, merge_quantiles) {
+  QuantilesUDA<types::Int64Value> all;
+  QuantilesUDA<types::Int64Value> first;
+  QuantilesUDA<types::Int64Value> second;
+  std::vector<types::Int64Value> values = {1, 2, 2, 1, 1, 5, 6};
+  all.UpdateVector(nullptr, values.size(), values.data());
+  first.UpdateVector(nullptr, 3, values.data());
+  second.UpdateVector(nullptr, values.size() - 3, values.data() + 3);
+
+  MergeQuantilesUDA merged;
+  merged.Update(nullptr, first.Serialize(nullptr));
+  merged.Update(nullptr, second.Serialize(nullptr));
+  // States that aren't sketches are skipped.
+  merged.Update(nullptr, "");
+  EXPECT_EQ(all.Finalize(nullptr), merged.Finalize(nullptr));
+}
+
+TEST(MathSketches, approx_count_distinct) {
+  auto uda_tester = udf::UDATester<ApproxCountDistinctUDA<types::StringValue>>();
+  uda_tester.ForInput("a").ForInput("b").ForInput("a").ForInput("c").ForInput("b").Expect(3);
+
+  auto upid_tester = udf::UDATester<ApproxCountDistinctUDA<types::UInt128Value>>();
+  upid_tester.ForInput(types::UInt128Value(1, 2))
+      .ForInput(types::UInt128Value(2, 1))
+      .ForInput(types::UInt128Value(1, 2))
+      .Expect(2);
+}
+
+TEST(MathSketches, approx_count_distinct_partial_aggregate) {
+  // Each agent sees an overlapping range of values.
+  ApproxCountDistinctUDA<types::Int64Value> pem1;
+  ApproxCountDistinctUDA<types::Int64Value> pem2;
+  for (int64_t i = 0; i < 20000; ++i) {
+    pem1.Update(nullptr, i);
+    pem2.Update(nullptr, i + 10000);
+  }
+
+  ApproxCountDistinctUDA<types::Int64Value> kelvin;
+  ApproxCountDistinctUDA<types::Int64Value> partial;
+  ASSERT_OK(partial.Deserialize(nullptr, pem1.Serialize(nullptr)));
+  kelvin.Merge(nullptr, partial);
+  ASSERT_OK(partial.Deserialize(nullptr, pem2.Serialize(nullptr)));
+  kelvin.Merge(nullptr, partial);
+  EXPECT_NEAR(30000, kelvin.Finalize(nullptr).val, 30000 * 0.03);
+
+  EXPECT_NOT_OK(partial.Deserialize(nullptr, "not a sketch"));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
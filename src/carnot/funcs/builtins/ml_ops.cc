@@ -20,6 +20,11 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
+DEFINE_int32(carnot_reservoir_sample_size,
+             gflags::Int32FromEnv("PL_CARNOT_RESERVOIR_SAMPLE_SIZE", 100),
+             "The number of values that px.reservoir_sample and px.weighted_sample keep for each "
+             "group. The partial aggregates that are sent between agents grow with it.");
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -37,6 +42,26 @@ void RegisterMLOpsOrDie(udf::Registry* registry) {
    *****************************************/
   registry->RegisterOrDie<KMeansUDA>("_kmeans_fit");
   registry->RegisterOrDie<ReservoirSampleUDA<types::StringValue>>("sample");
+  registry->RegisterOrDie<ReservoirSampleValuesUDA<types::StringValue>>("reservoir_sample");
+  registry->RegisterOrDie<ReservoirSampleValuesUDA<types::Int64Value>>("reservoir_sample");
+  registry->RegisterOrDie<ReservoirSampleValuesUDA<types::Float64Value>>("reservoir_sample");
+  registry->RegisterOrDie<ReservoirSampleValuesUDA<types::Time64NSValue>>("reservoir_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::StringValue, types::Int64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::StringValue, types::Float64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Int64Value, types::Int64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Int64Value, types::Float64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Float64Value, types::Int64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Float64Value, types::Float64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Time64NSValue, types::Int64Value>>(
+      "weighted_sample");
+  registry->RegisterOrDie<WeightedSampleUDA<types::Time64NSValue, types::Float64Value>>(
+      "weighted_sample");
 }
 
 int load_floats_from_json(std::string in, Eigen::VectorXf* out, int max_num) {
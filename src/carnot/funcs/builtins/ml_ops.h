@@ -19,24 +19,33 @@
 #pragma once
 
 #include <math.h>
+#include <string.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <sentencepiece/sentencepiece_processor.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/exec/ml/coreset.h"
 #include "src/carnot/exec/ml/kmeans.h"
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/carnot/exec/ml/reservoir_sampler.h"
 #include "src/carnot/exec/ml/sampling.h"
 #include "src/carnot/exec/ml/transformer_executor.h"
+#include "src/carnot/funcs/builtins/varint.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
 
+DECLARE_int32(carnot_reservoir_sample_size);
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -61,6 +70,18 @@ class TransformerUDF : public udf::ScalarUDF {
     return output;
   }
 
+  // Embeds the docs of the batch in batches of the model, rather than invoking it for each doc.
+  void ExecVector(FunctionContext* ctx, size_t count, StringValue* out, const StringValue* docs) {
+    auto executor =
+        ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
+    std::vector<std::string_view> doc_views(docs, docs + count);
+    std::vector<std::string> outputs;
+    executor->ExecuteBatch(doc_views, &outputs);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = std::move(outputs[i]);
+    }
+  }
+
  private:
   std::string model_proto_path_;
 };
@@ -141,44 +162,191 @@ class KMeansUDF : public udf::ScalarUDF {
   std::unique_ptr<KMeans> kmeans_;
 };
 
-template <typename TArg>
-class ReservoirSampleUDA : public udf::UDA {
- public:
-  ReservoirSampleUDA() : ReservoirSampleUDA(1) {}
-  explicit ReservoirSampleUDA(size_t k) : k_(k), count_(0) {}
-  void Update(FunctionContext*, TArg val) {
-    count_++;
-    if (reservoir_.size() < k_) {
-      reservoir_.push_back(val);
-      return;
-    }
-    auto i = exec::ml::randint(count_);
-    if (i < k_) {
-      reservoir_[i] = val;
+namespace internal {
+
+/**
+ * The serialized samples are the size of the sample, the number of items, and the key and value
+ * of each item. The keys are kept so that the samples of several agents can be merged.
+ */
+template <typename TArg, typename TSampler>
+StringValue SerializeSample(const TSampler& sampler) {
+  std::string out;
+  AppendVarint(&out, sampler.k());
+  AppendVarint(&out, sampler.items().size());
+  for (const auto& item : sampler.items()) {
+    out.append(reinterpret_cast<const char*>(&item.log_key), sizeof(item.log_key));
+    if constexpr (std::is_same_v<TArg, StringValue>) {
+      AppendVarint(&out, item.value.size());
+      out.append(item.value);
+    } else {
+      out.append(reinterpret_cast<const char*>(&item.value.val), sizeof(item.value.val));
     }
   }
-  void Merge(FunctionContext*, const ReservoirSampleUDA<TArg>& other) {
-    DCHECK_EQ(k_, other.k_);
-    for (const auto& val : other.reservoir_) {
-      if (reservoir_.size() < k_) {
-        reservoir_.push_back(val);
-        continue;
+  return out;
+}
+
+template <typename TArg, typename TSampler>
+Status DeserializeSample(std::string_view data, TSampler* sampler) {
+  uint64_t k;
+  uint64_t num_items;
+  if (!ConsumeVarint(&data, &k) || !ConsumeVarint(&data, &num_items) || num_items > k) {
+    return error::InvalidArgument("Invalid serialized sample");
+  }
+  *sampler = TSampler(k);
+  for (uint64_t i = 0; i < num_items; ++i) {
+    double log_key;
+    if (data.size() < sizeof(log_key)) {
+      return error::InvalidArgument("Invalid serialized sample");
+    }
+    memcpy(&log_key, data.data(), sizeof(log_key));
+    data.remove_prefix(sizeof(log_key));
+    TArg value;
+    if constexpr (std::is_same_v<TArg, StringValue>) {
+      uint64_t size;
+      if (!ConsumeVarint(&data, &size) || size > data.size()) {
+        return error::InvalidArgument("Invalid serialized sample");
       }
-      size_t i = exec::ml::randint(count_ + other.count_);
-      if (i < other.count_) {
-        reservoir_[i % k_] = val;
+      value = StringValue(data.data(), size);
+      data.remove_prefix(size);
+    } else {
+      if (data.size() < sizeof(value.val)) {
+        return error::InvalidArgument("Invalid serialized sample");
       }
+      memcpy(&value.val, data.data(), sizeof(value.val));
+      data.remove_prefix(sizeof(value.val));
     }
-    count_ += other.count_;
+    sampler->Restore(log_key, std::move(value));
+  }
+  return Status::OK();
+}
+
+// Writes the values of the sample as a JSON array, the items with the largest keys first.
+template <typename TArg, typename TSampler>
+StringValue SampleToJSON(const TSampler& sampler) {
+  auto items = sampler.items();
+  std::sort(items.begin(), items.end(),
+            [](const auto& a, const auto& b) { return a.log_key > b.log_key; });
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartArray();
+  for (const auto& item : items) {
+    if constexpr (std::is_same_v<TArg, StringValue>) {
+      writer.String(item.value.data(), item.value.size());
+    } else if constexpr (std::is_same_v<TArg, Float64Value>) {
+      writer.Double(item.value.val);
+    } else {
+      writer.Int64(item.value.val);
+    }
+  }
+  writer.EndArray();
+  return sb.GetString();
+}
+
+}  // namespace internal
+
+template <typename TArg>
+class ReservoirSampleUDA : public udf::UDA {
+ public:
+  ReservoirSampleUDA() : sampler_(1) {}
+  void Update(FunctionContext*, TArg val) { sampler_.Add(val); }
+  void UpdateVector(FunctionContext*, size_t count, const TArg* vals) {
+    sampler_.AddBatch(vals, count);
+  }
+  void Merge(FunctionContext*, const ReservoirSampleUDA<TArg>& other) {
+    sampler_.Merge(other.sampler_);
   }
   TArg Finalize(FunctionContext*) {
-    return reservoir_[0];
+    if (sampler_.items().empty()) {
+      return TArg();
+    }
+    return sampler_.items()[0].value;
+  }
+
+  StringValue Serialize(FunctionContext*) { return internal::SerializeSample<TArg>(sampler_); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return internal::DeserializeSample<TArg>(data, &sampler_);
+  }
+
+ private:
+  exec::ml::ReservoirSampler<TArg> sampler_;
+};
+
+template <typename TArg>
+class ReservoirSampleValuesUDA : public udf::UDA {
+ public:
+  ReservoirSampleValuesUDA() : sampler_(FLAGS_carnot_reservoir_sample_size) {}
+  void Update(FunctionContext*, TArg val) { sampler_.Add(val); }
+  void UpdateVector(FunctionContext*, size_t count, const TArg* vals) {
+    sampler_.AddBatch(vals, count);
+  }
+  void Merge(FunctionContext*, const ReservoirSampleValuesUDA<TArg>& other) {
+    sampler_.Merge(other.sampler_);
+  }
+  StringValue Finalize(FunctionContext*) { return internal::SampleToJSON<TArg>(sampler_); }
+
+  StringValue Serialize(FunctionContext*) { return internal::SerializeSample<TArg>(sampler_); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return internal::DeserializeSample<TArg>(data, &sampler_);
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Samples the aggregated data uniformly.")
+        .Details(
+            "Keeps a uniform random sample of the aggregated data, without replacement, using "
+            "reservoir sampling. The size of the sample is set by the "
+            "PL_CARNOT_RESERVOIR_SAMPLE_SIZE environment variable of the agents, and is 100 by "
+            "default. Groups with fewer values return all of them. Unlike sorting the values, it "
+            "can be aggregated on each agent before the results are merged.")
+        .Example(R"doc(
+        | # Sample the request paths of each service.
+        | df = df.groupby('service').agg(paths=('req_path', px.reservoir_sample))
+        )doc")
+        .Arg("val", "The data to sample.")
+        .Returns("The sampled values, serialized as a JSON array.");
+  }
+
+ private:
+  exec::ml::ReservoirSampler<TArg> sampler_;
+};
+
+template <typename TArg, typename TWeight>
+class WeightedSampleUDA : public udf::UDA {
+ public:
+  WeightedSampleUDA() : sampler_(FLAGS_carnot_reservoir_sample_size) {}
+  void Update(FunctionContext*, TArg val, TWeight weight) { sampler_.Add(val, weight.val); }
+  void UpdateVector(FunctionContext*, size_t count, const TArg* vals, const TWeight* weights) {
+    using NativeType = typename types::ValueTypeTraits<TWeight>::native_type;
+    static_assert(sizeof(TWeight) == sizeof(NativeType));
+    sampler_.AddBatch(vals, reinterpret_cast<const NativeType*>(weights), count);
+  }
+  void Merge(FunctionContext*, const WeightedSampleUDA& other) { sampler_.Merge(other.sampler_); }
+  StringValue Finalize(FunctionContext*) { return internal::SampleToJSON<TArg>(sampler_); }
+
+  StringValue Serialize(FunctionContext*) { return internal::SerializeSample<TArg>(sampler_); }
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return internal::DeserializeSample<TArg>(data, &sampler_);
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Samples the aggregated data in proportion to a weight.")
+        .Details(
+            "Keeps a random sample of the aggregated data without replacement, where the "
+            "probability that a value is chosen is proportional to its weight. Values with weights "
+            "that aren't positive are never chosen. The size of the sample is the same as that of "
+            "`px.reservoir_sample`. The values with the highest random priorities come first, "
+            "so the heavier values tend to be at the front of the sample.")
+        .Example(R"doc(
+        | # Sample the requests of each service, favoring the slow ones.
+        | df = df.groupby('service').agg(
+        |     slow_paths=('req_path', 'latency', px.weighted_sample))
+        )doc")
+        .Arg("val", "The data to sample.")
+        .Arg("weight", "The weight of each value.")
+        .Returns("The sampled values, serialized as a JSON array.");
   }
 
  private:
-  size_t k_;
-  size_t count_;
-  std::vector<TArg> reservoir_;
+  exec::ml::WeightedReservoirSampler<TArg> sampler_;
 };
 
 void RegisterMLOpsOrDie(udf::Registry* registry);
@@ -73,6 +73,28 @@ static void BM_TransformerModel(benchmark::State& state) {
   }
 }
 
+// Embeds state.range(0) docs per call, to compare the throughput of batches of different sizes.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TransformerModelBatch(benchmark::State& state) {
+  px::carnot::builtins::TransformerUDF udf(FLAGS_embedding_dir);
+  size_t batch_size = state.range(0);
+  std::vector<px::types::StringValue> docs;
+  for (size_t i = 0; i < batch_size; ++i) {
+    auto ints = random_ints(64);
+    docs.push_back(px::carnot::builtins::write_ints_to_json(ints.data(), 64));
+  }
+  std::vector<px::types::StringValue> out(batch_size);
+  auto model_pool = px::carnot::exec::ml::ModelPool::Create();
+  model_pool->WarmUp<px::carnot::exec::ml::TransformerExecutor>(1, FLAGS_embedding_dir);
+  auto ctx = px::carnot::udf::FunctionContext(nullptr, model_pool.get());
+
+  for (auto _ : state) {
+    udf.ExecVector(&ctx, batch_size, out.data(), docs.data());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_SentencePiece(benchmark::State& state) {
   auto udf = px::carnot::builtins::SentencePieceUDF(FLAGS_sentencepiece_dir);
@@ -85,3 +107,7 @@ static void BM_SentencePiece(benchmark::State& state) {
 
 BENCHMARK(BM_SentencePiece)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_TransformerModel)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TransformerModelBatch)
+    ->RangeMultiplier(4)
+    ->Range(1, 256)
+    ->Unit(benchmark::kMillisecond);
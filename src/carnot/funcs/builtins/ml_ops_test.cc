@@ -25,6 +25,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/funcs/builtins/ml_ops.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
@@ -150,6 +152,107 @@ TEST(Transformer, basic) {
       "15099024772644044,-0.10007300972938538,1.1897741556167603]");
 }
 
+TEST(Transformer, exec_vector_matches_exec) {
+  auto pool = exec::ml::ModelPool::Create();
+  FunctionContext ctx(nullptr, pool.get());
+  TransformerUDF udf(FLAGS_embedding_dir);
+
+  // More docs than fit in one invocation of the model, and a doc that isn't a token array.
+  std::vector<StringValue> docs;
+  for (int i = 0; i < 40; ++i) {
+    docs.push_back(absl::Substitute("[4,197,$0,195,16,5001]", i));
+  }
+  docs[7] = "not a token array";
+  std::vector<StringValue> out(docs.size());
+  udf.ExecVector(&ctx, docs.size(), out.data(), docs.data());
+
+  EXPECT_EQ("", out[7]);
+  for (size_t i = 0; i < docs.size(); ++i) {
+    if (i == 7) {
+      continue;
+    }
+    // The batched kernels can round differently than the ones for a single doc.
+    Eigen::VectorXf expected(256);
+    Eigen::VectorXf actual(256);
+    ASSERT_EQ(256, load_floats_from_json(udf.Exec(&ctx, docs[i]), &expected, 256));
+    ASSERT_EQ(256, load_floats_from_json(out[i], &actual, 256));
+    EXPECT_TRUE(actual.isApprox(expected, 1e-4)) << i;
+  }
+}
+
+TEST(ReservoirSample, returns_all_values_of_small_groups) {
+  ReservoirSampleValuesUDA<types::Int64Value> uda;
+  std::vector<types::Int64Value> values = {3, 1, 2};
+  uda.UpdateVector(nullptr, values.size(), values.data());
+
+  rapidjson::Document d;
+  d.Parse(uda.Finalize(nullptr).data());
+  ASSERT_TRUE(d.IsArray());
+  std::vector<int64_t> sampled;
+  for (const auto& v : d.GetArray()) {
+    sampled.push_back(v.GetInt64());
+  }
+  EXPECT_THAT(sampled, ::testing::UnorderedElementsAre(1, 2, 3));
+}
+
+TEST(ReservoirSample, partial_aggregate) {
+  // Each agent sees a different set of values, many more than the size of the sample.
+  ReservoirSampleValuesUDA<types::StringValue> pem1;
+  ReservoirSampleValuesUDA<types::StringValue> pem2;
+  for (int i = 0; i < 10000; ++i) {
+    pem1.Update(nullptr, absl::StrCat("pem1-", i));
+    pem2.Update(nullptr, absl::StrCat("pem2-", i));
+  }
+
+  ReservoirSampleValuesUDA<types::StringValue> kelvin;
+  ReservoirSampleValuesUDA<types::StringValue> partial;
+  ASSERT_OK(partial.Deserialize(nullptr, pem1.Serialize(nullptr)));
+  kelvin.Merge(nullptr, partial);
+  ASSERT_OK(partial.Deserialize(nullptr, pem2.Serialize(nullptr)));
+  kelvin.Merge(nullptr, partial);
+
+  rapidjson::Document d;
+  d.Parse(kelvin.Finalize(nullptr).data());
+  ASSERT_TRUE(d.IsArray());
+  EXPECT_EQ(FLAGS_carnot_reservoir_sample_size, static_cast<int>(d.Size()));
+  absl::flat_hash_set<std::string> sampled;
+  for (const auto& v : d.GetArray()) {
+    sampled.insert(v.GetString());
+  }
+  EXPECT_EQ(FLAGS_carnot_reservoir_sample_size, static_cast<int>(sampled.size()));
+
+  EXPECT_NOT_OK(partial.Deserialize(nullptr, "not a sample"));
+}
+
+TEST(ReservoirSample, sample_partial_aggregate) {
+  ReservoirSampleUDA<types::StringValue> pem;
+  pem.Update(nullptr, "a");
+  pem.Update(nullptr, "b");
+
+  ReservoirSampleUDA<types::StringValue> kelvin;
+  ASSERT_OK(kelvin.Deserialize(nullptr, pem.Serialize(nullptr)));
+  EXPECT_EQ(pem.Finalize(nullptr), kelvin.Finalize(nullptr));
+}
+
+TEST(WeightedSample, skips_values_without_weight) {
+  WeightedSampleUDA<types::StringValue, types::Float64Value> uda;
+  std::vector<types::StringValue> values = {"a", "b", "c"};
+  std::vector<types::Float64Value> weights = {1.0, 0.0, 2.0};
+  uda.UpdateVector(nullptr, values.size(), values.data(), weights.data());
+
+  WeightedSampleUDA<types::StringValue, types::Float64Value> deserialized;
+  ASSERT_OK(deserialized.Deserialize(nullptr, uda.Serialize(nullptr)));
+
+  rapidjson::Document d;
+  d.Parse(deserialized.Finalize(nullptr).data());
+  ASSERT_TRUE(d.IsArray());
+  std::vector<std::string> sampled;
+  for (const auto& v : d.GetArray()) {
+    sampled.push_back(v.GetString());
+  }
+  EXPECT_THAT(sampled, ::testing::UnorderedElementsAre("a", "c"));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -17,6 +17,8 @@
  */
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "src/carnot/funcs/builtins/pii_ops.h"
@@ -235,6 +237,24 @@ static std::map<Tag::Type, std::string_view> type_to_sub_str_ = {
     SUB_STR(Tag::Type::IMEISV),
 };
 
+// Builds a set of the patterns of the taggers, in the same order.
+static const re2::RE2::Set* BuildPrefilter(const std::vector<std::unique_ptr<Tagger>>& taggers) {
+  auto prefilter = std::make_unique<re2::RE2::Set>(re2::RE2::Options(), re2::RE2::UNANCHORED);
+  for (const auto& tagger : taggers) {
+    std::string_view pattern = tagger->pattern();
+    std::string error;
+    if (prefilter->Add(re2::StringPiece(pattern.data(), pattern.size()), &error) < 0) {
+      LOG(ERROR) << "Failed to add a PII pattern to the prefilter: " << error;
+      return nullptr;
+    }
+  }
+  if (!prefilter->Compile()) {
+    LOG(ERROR) << "Failed to compile the PII prefilter.";
+    return nullptr;
+  }
+  return prefilter.release();
+}
+
 Status RedactPIIUDF::Init(FunctionContext*) {
   // Order is important here. For example, IPv6 has to go before IPv4 to support IPv6 addresses with
   // the lowest 32 bits written like IPv4. Also Email has to go before IP since IP addresses can be
@@ -246,6 +266,10 @@ Status RedactPIIUDF::Init(FunctionContext*) {
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::IMEI>>());
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::IMEISV>>());
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::CC_NUMBER>>());
+
+  // All instances have the same taggers, so the prefilter is only built once.
+  static const re2::RE2::Set* prefilter = BuildPrefilter(taggers_);
+  prefilter_ = prefilter;
   return Status::OK();
 }
 
@@ -305,9 +329,29 @@ static inline std::string ReplaceTagsWithSubs(std::string input, std::vector<Tag
 }
 
 StringValue RedactPIIUDF::Exec(FunctionContext*, StringValue input) {
+  // Without a prefilter result, e.g. when the set runs out of memory, every tagger runs.
+  std::vector<bool> candidates(taggers_.size(), true);
+  if (prefilter_ != nullptr) {
+    std::vector<int> matches;
+    re2::RE2::Set::ErrorInfo error_info;
+    prefilter_->Match(input, &matches, &error_info);
+    if (error_info.kind == re2::RE2::Set::kNoError) {
+      if (matches.empty()) {
+        return input;
+      }
+      candidates.assign(taggers_.size(), false);
+      for (int idx : matches) {
+        candidates[idx] = true;
+      }
+    }
+  }
+
   std::vector<Tag> tags;
-  for (const auto& tagger : taggers_) {
-    auto s = tagger->AddTags(&input, &tags);
+  for (size_t idx = 0; idx < taggers_.size(); ++idx) {
+    if (!candidates[idx]) {
+      continue;
+    }
+    auto s = taggers_[idx]->AddTags(&input, &tags);
     if (!s.ok()) {
       return "Invalid regex: " + s.msg();
     }
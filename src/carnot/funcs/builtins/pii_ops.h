@@ -19,9 +19,12 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "re2/re2.h"
+#include "re2/set.h"
+#include "src/carnot/funcs/builtins/regex_cache.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -55,6 +58,8 @@ class Tagger {
  public:
   virtual ~Tagger() = default;
   virtual Status AddTags(std::string* input, std::vector<Tag>* tags) = 0;
+  // A pattern that matches somewhere in every input that the tagger adds tags to.
+  virtual std::string_view pattern() const = 0;
 };
 
 class RedactPIIUDF : public udf::ScalarUDF {
@@ -78,6 +83,9 @@ class RedactPIIUDF : public udf::ScalarUDF {
 
  private:
   std::vector<std::unique_ptr<Tagger>> taggers_;
+  // Matches the patterns of all of the taggers in one pass, so that only the taggers of the PII
+  // types that are in the input run. Shared by all instances, null if it failed to compile.
+  const re2::RE2::Set* prefilter_ = nullptr;
 };
 
 void RegisterPIIOpsOrDie(udf::Registry* registry);
@@ -85,17 +93,17 @@ void RegisterPIIOpsOrDie(udf::Registry* registry);
 template <Tag::Type TTag>
 class RegexTagger : public Tagger {
  public:
-  RegexTagger() : regex_(TagTypeTraits<TTag>::BuildRegexPattern()) {
+  RegexTagger() : regex_(RegexCache::Global()->Get(TagTypeTraits<TTag>::BuildRegexPattern())) {
     // Since the regex patterns are defined at compile time, using a DCHECK is ok here.
-    DCHECK_EQ(regex_.error_code(), RE2::NoError) << regex_.error();
+    DCHECK_EQ(regex_->error_code(), RE2::NoError) << regex_->error();
   }
 
-  Status AddTags(std::string* input, std::vector<Tag>* tags) {
+  Status AddTags(std::string* input, std::vector<Tag>* tags) override {
     re2::StringPiece input_piece(input->data(), input->length());
     auto prev_length = input_piece.length();
     int curr_idx = 0;
     std::string match;
-    while (RE2::FindAndConsume(&input_piece, regex_, &match)) {
+    while (RE2::FindAndConsume(&input_piece, *regex_, &match)) {
       auto consumed = prev_length - input_piece.length();
       if (consumed == 0) {
         return Status(statuspb::Code::INVALID_ARGUMENT,
@@ -116,8 +124,10 @@ class RegexTagger : public Tagger {
     return Status::OK();
   }
 
+  std::string_view pattern() const override { return TagTypeTraits<TTag>::BuildRegexPattern(); }
+
  private:
-  re2::RE2 regex_;
+  std::shared_ptr<const re2::RE2> regex_;
 };
 
 }  // namespace builtins
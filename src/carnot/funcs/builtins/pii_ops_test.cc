@@ -217,6 +217,17 @@ TEST_P(RedactionTest, basic) {
   udf::UDFTester<RedactPIIUDF>().Init().ForInput(test_case.first).Expect(test_case.second);
 }
 
+TEST(RedactPIIUDF, prefilter_runs_only_matching_taggers) {
+  auto udf_tester = udf::UDFTester<RedactPIIUDF>();
+  udf_tester.Init();
+  // Inputs without PII are returned as is, without running any tagger.
+  udf_tester.ForInput("GET /api/v1/users?limit=10 HTTP/1.1").Expect(
+      "GET /api/v1/users?limit=10 HTTP/1.1");
+  // Inputs with several types of PII have all of them redacted.
+  udf_tester.ForInput("from 10.0.0.1 by foo@bar.com")
+      .Expect("from <REDACTED_IPV4> by <REDACTED_EMAIL>");
+}
+
 INSTANTIATE_TEST_SUITE_P(TemplatedRedactionTest, RedactionTest,
                          testing::ValuesIn(TestCaseGen({IPv4Gen(), IPv6Gen(), EmailGen(), CCGen(),
                                                         IMEIGen(), NegativeExampleGen()})));
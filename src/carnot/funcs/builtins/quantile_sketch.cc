@@ -0,0 +1,236 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/quantile_sketch.h"
+
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "src/carnot/funcs/builtins/varint.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+namespace {
+
+constexpr uint8_t kSerializationVersion = 1;
+
+// The k1 scale function of the t-digest paper, and its inverse. Centroids may span at most one unit
+// of k, which keeps the ones near the tails small.
+double ScaleK(double q, double compression) {
+  return compression / (2 * M_PI) * std::asin(2 * q - 1);
+}
+double ScaleQ(double k, double compression) {
+  double x = std::min(k * 2 * M_PI / compression, M_PI / 2);
+  return (std::sin(x) + 1) / 2;
+}
+
+// The average of x1 <= x2, weighted by w1 and w2, clamped to [x1, x2] against rounding.
+double WeightedAverage(double x1, double w1, double x2, double w2) {
+  if (w1 + w2 == 0) {
+    return x1;
+  }
+  double x = (x1 * w1 + x2 * w2) / (w1 + w2);
+  return std::max(x1, std::min(x, x2));
+}
+
+template <typename T>
+void AppendRaw(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ConsumeRaw(std::string_view* data, T* value) {
+  if (data->size() < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(value, data->data(), sizeof(T));
+  data->remove_prefix(sizeof(T));
+  return true;
+}
+
+}  // namespace
+
+QuantileSketch::QuantileSketch(double compression)
+    : compression_(compression),
+      // The buffer size recommended by the paper, trading memory for fewer merges.
+      buffer_capacity_(static_cast<size_t>(std::max(5 * compression, 16.0))),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity()) {
+  buffer_.reserve(buffer_capacity_);
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+  std::vector<Centroid> extra = other.centroids_;
+  extra.reserve(other.centroids_.size() + other.buffer_.size());
+  for (double value : other.buffer_) {
+    extra.push_back({value, 1});
+  }
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  MergeCentroids(std::move(extra));
+}
+
+void QuantileSketch::MergeCentroids(std::vector<Centroid> extra) {
+  if (buffer_.empty() && extra.empty()) {
+    return;
+  }
+  auto by_mean = [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; };
+
+  std::sort(buffer_.begin(), buffer_.end());
+  std::sort(extra.begin(), extra.end(), by_mean);
+  std::vector<Centroid> incoming;
+  incoming.reserve(buffer_.size() + extra.size());
+  std::vector<Centroid> buffered;
+  buffered.reserve(buffer_.size());
+  for (double value : buffer_) {
+    buffered.push_back({value, 1});
+  }
+  total_weight_ += buffer_.size();
+  for (const auto& c : extra) {
+    total_weight_ += c.weight;
+  }
+  buffer_.clear();
+  std::merge(buffered.begin(), buffered.end(), extra.begin(), extra.end(),
+             std::back_inserter(incoming), by_mean);
+
+  std::vector<Centroid> all;
+  all.reserve(centroids_.size() + incoming.size());
+  std::merge(centroids_.begin(), centroids_.end(), incoming.begin(), incoming.end(),
+             std::back_inserter(all), by_mean);
+
+  // Greedily merge neighbors, as long as the merged centroid spans at most one unit of k.
+  centroids_.clear();
+  double weight_so_far = 0;
+  double weight_limit = total_weight_ * ScaleQ(ScaleK(0, compression_) + 1, compression_);
+  Centroid current = all[0];
+  for (size_t i = 1; i < all.size(); ++i) {
+    const Centroid& next = all[i];
+    if (weight_so_far + current.weight + next.weight <= weight_limit) {
+      current.mean += (next.mean - current.mean) * next.weight / (current.weight + next.weight);
+      current.weight += next.weight;
+      continue;
+    }
+    weight_so_far += current.weight;
+    centroids_.push_back(current);
+    weight_limit = total_weight_ * ScaleQ(ScaleK(weight_so_far / total_weight_, compression_) + 1,
+                                          compression_);
+    current = next;
+  }
+  centroids_.push_back(current);
+}
+
+double QuantileSketch::Quantile(double q) {
+  Compress();
+  if (centroids_.empty() || q < 0 || q > 1) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (centroids_.size() == 1) {
+    return centroids_[0].mean;
+  }
+
+  // Each centroid is taken to be centered on its mean, and values between the midpoints of
+  // neighboring centroids are interpolated linearly.
+  double index = q * total_weight_;
+  const Centroid& first = centroids_.front();
+  if (index <= first.weight / 2) {
+    return min_ + 2 * index / first.weight * (first.mean - min_);
+  }
+  double prev_midpoint = first.weight / 2;
+  double weight_before = first.weight;
+  for (size_t i = 1; i < centroids_.size(); ++i) {
+    double midpoint = weight_before + centroids_[i].weight / 2;
+    if (index <= midpoint) {
+      return WeightedAverage(centroids_[i - 1].mean, midpoint - index, centroids_[i].mean,
+                             index - prev_midpoint);
+    }
+    prev_midpoint = midpoint;
+    weight_before += centroids_[i].weight;
+  }
+  return WeightedAverage(centroids_.back().mean, total_weight_ - index, max_,
+                         index - prev_midpoint);
+}
+
+// The format is the version byte, the min and max, and the number of centroids as a varint,
+// followed by the mean and the weight (as a varint) of each centroid. All values are added with a
+// weight of one, so the weights are whole numbers.
+std::string QuantileSketch::Serialize() {
+  Compress();
+  std::string out;
+  out.reserve(1 + 2 * sizeof(double) + 10 + centroids_.size() * (sizeof(double) + 2));
+  out.push_back(static_cast<char>(kSerializationVersion));
+  AppendRaw(&out, min_);
+  AppendRaw(&out, max_);
+  AppendVarint(&out, centroids_.size());
+  for (const auto& c : centroids_) {
+    AppendRaw(&out, c.mean);
+    AppendVarint(&out, static_cast<uint64_t>(std::llround(c.weight)));
+  }
+  return out;
+}
+
+Status QuantileSketch::Deserialize(std::string_view data) {
+  uint8_t version = 0;
+  if (!ConsumeRaw(&data, &version) || version != kSerializationVersion) {
+    return error::InvalidArgument("Unsupported quantile sketch version $0",
+                                  static_cast<int>(version));
+  }
+  double min = 0;
+  double max = 0;
+  uint64_t num_centroids = 0;
+  if (!ConsumeRaw(&data, &min) || !ConsumeRaw(&data, &max) ||
+      !ConsumeVarint(&data, &num_centroids)) {
+    return error::InvalidArgument("Truncated quantile sketch header");
+  }
+  // Each centroid takes at least 9 bytes.
+  if (num_centroids > data.size() / 9) {
+    return error::InvalidArgument("Quantile sketch with $0 centroids is truncated", num_centroids);
+  }
+
+  std::vector<Centroid> centroids;
+  centroids.reserve(num_centroids);
+  double total_weight = 0;
+  for (uint64_t i = 0; i < num_centroids; ++i) {
+    Centroid c;
+    uint64_t weight = 0;
+    if (!ConsumeRaw(&data, &c.mean) || !ConsumeVarint(&data, &weight)) {
+      return error::InvalidArgument("Truncated quantile sketch centroid");
+    }
+    c.weight = static_cast<double>(weight);
+    total_weight += c.weight;
+    centroids.push_back(c);
+  }
+  if (!data.empty()) {
+    return error::InvalidArgument("Quantile sketch has $0 trailing bytes", data.size());
+  }
+
+  centroids_ = std::move(centroids);
+  total_weight_ = total_weight;
+  buffer_.clear();
+  min_ = min;
+  max_ = max;
+  return Status::OK();
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+/**
+ * QuantileSketch is a merging t-digest: https://arxiv.org/abs/1902.04023.
+ *
+ * Values are appended to a buffer, which is periodically merged into a sorted list of centroids.
+ * The compression bounds the number of centroids (to at most about `compression`). Larger values
+ * are more accurate, and take more memory and space when serialized.
+ */
+class QuantileSketch {
+ public:
+  explicit QuantileSketch(double compression);
+
+  void Add(double value) {
+    buffer_.push_back(value);
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    if (buffer_.size() >= buffer_capacity_) {
+      Compress();
+    }
+  }
+
+  /**
+   * Adds a contiguous array of values. The loops over the input are simple enough for the compiler
+   * to vectorize them.
+   */
+  template <typename T>
+  void AddBatch(const T* values, size_t count) {
+    while (count > 0) {
+      size_t n = std::min(count, buffer_capacity_ - buffer_.size());
+      size_t offset = buffer_.size();
+      buffer_.resize(offset + n);
+      double* out = buffer_.data() + offset;
+      double min = min_;
+      double max = max_;
+      for (size_t i = 0; i < n; ++i) {
+        double value = static_cast<double>(values[i]);
+        out[i] = value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+      }
+      min_ = min;
+      max_ = max;
+      values += n;
+      count -= n;
+      if (buffer_.size() >= buffer_capacity_) {
+        Compress();
+      }
+    }
+  }
+
+  void Merge(const QuantileSketch& other);
+
+  /**
+   * Returns the approximate value at quantile q, in [0, 1]. NaN if the sketch is empty.
+   */
+  double Quantile(double q);
+
+  double total_weight() const { return total_weight_ + buffer_.size(); }
+  size_t num_centroids() {
+    Compress();
+    return centroids_.size();
+  }
+
+  /**
+   * Serializes the sketch in a compact binary format, for partial aggregates.
+   */
+  std::string Serialize();
+  Status Deserialize(std::string_view data);
+
+ private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  // Merges the buffered values into the centroids.
+  void Compress() { MergeCentroids({}); }
+  // Merges the buffered values, and the extra centroids, into the centroids.
+  void MergeCentroids(std::vector<Centroid> extra);
+
+  double compression_;
+  size_t buffer_capacity_;
+
+  // Sorted by mean.
+  std::vector<Centroid> centroids_;
+  double total_weight_ = 0;
+  std::vector<double> buffer_;
+
+  double min_;
+  double max_;
+};
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/quantile_sketch.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+class QuantileSketchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 rng(42);
+    std::exponential_distribution<double> dist(1.0);
+    values_.resize(100000);
+    for (auto& v : values_) {
+      v = dist(rng);
+    }
+    sorted_ = values_;
+    std::sort(sorted_.begin(), sorted_.end());
+  }
+
+  double TrueQuantile(double q) { return sorted_[static_cast<size_t>(q * sorted_.size())]; }
+
+  std::vector<double> values_;
+  std::vector<double> sorted_;
+};
+
+TEST_F(QuantileSketchTest, accuracy) {
+  QuantileSketch sketch(200);
+  for (double v : values_) {
+    sketch.Add(v);
+  }
+  EXPECT_EQ(values_.size(), sketch.total_weight());
+  EXPECT_LE(sketch.num_centroids(), 200);
+  for (double q : {0.01, 0.1, 0.5, 0.9, 0.99}) {
+    EXPECT_NEAR(TrueQuantile(q), sketch.Quantile(q), 0.01 * TrueQuantile(q)) << q;
+  }
+  EXPECT_EQ(sorted_.front(), sketch.Quantile(0));
+  EXPECT_EQ(sorted_.back(), sketch.Quantile(1));
+}
+
+TEST_F(QuantileSketchTest, batch_and_merge) {
+  // Sketches of parts of the data merge into a sketch of all of it.
+  QuantileSketch merged(200);
+  for (size_t start = 0; start < values_.size(); start += 10000) {
+    QuantileSketch part(200);
+    part.AddBatch(values_.data() + start, 10000);
+    merged.Merge(part);
+  }
+  EXPECT_EQ(values_.size(), merged.total_weight());
+  for (double q : {0.01, 0.1, 0.5, 0.9, 0.99}) {
+    EXPECT_NEAR(TrueQuantile(q), merged.Quantile(q), 0.01 * TrueQuantile(q)) << q;
+  }
+}
+
+TEST_F(QuantileSketchTest, serialize) {
+  QuantileSketch sketch(200);
+  sketch.AddBatch(values_.data(), values_.size());
+  std::string data = sketch.Serialize();
+  // About ten bytes per centroid.
+  EXPECT_LT(data.size(), 10 * sketch.num_centroids() + 32);
+
+  QuantileSketch deserialized(200);
+  ASSERT_OK(deserialized.Deserialize(data));
+  EXPECT_EQ(sketch.total_weight(), deserialized.total_weight());
+  for (double q : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+    EXPECT_DOUBLE_EQ(sketch.Quantile(q), deserialized.Quantile(q));
+  }
+
+  EXPECT_NOT_OK(deserialized.Deserialize(data.substr(0, data.size() - 1)));
+  EXPECT_NOT_OK(deserialized.Deserialize(data + "x"));
+  EXPECT_NOT_OK(deserialized.Deserialize(""));
+}
+
+TEST(QuantileSketch, empty) {
+  QuantileSketch sketch(100);
+  EXPECT_TRUE(std::isnan(sketch.Quantile(0.5)));
+
+  QuantileSketch deserialized(100);
+  ASSERT_OK(deserialized.Deserialize(sketch.Serialize()));
+  EXPECT_TRUE(std::isnan(deserialized.Quantile(0.5)));
+}
+
+TEST(QuantileSketch, int_batch) {
+  std::vector<int64_t> values(1000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  QuantileSketch sketch(100);
+  sketch.AddBatch(values.data(), values.size());
+  EXPECT_NEAR(500, sketch.Quantile(0.5), 1);
+  EXPECT_EQ(0, sketch.Quantile(0));
+  EXPECT_EQ(999, sketch.Quantile(1));
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
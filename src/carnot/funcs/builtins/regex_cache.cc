@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/regex_cache.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+
+DEFINE_int32(carnot_regex_cache_size, gflags::Int32FromEnv("PL_CARNOT_REGEX_CACHE_SIZE", 256),
+             "The number of compiled regexes that are shared between the regex UDFs of all "
+             "queries. 0 disables the cache, so that each UDF compiles its own.");
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+namespace {
+
+// The parse flags cover all of the options that change the meaning of the pattern. The memory
+// budget and logging are kept separate.
+std::string CacheKey(std::string_view pattern, const re2::RE2::Options& options) {
+  return absl::StrCat(options.ParseFlags(), ":", options.max_mem(), ":", options.log_errors(), ":",
+                      pattern);
+}
+
+}  // namespace
+
+RegexCache* RegexCache::Global() {
+  static RegexCache* cache = new RegexCache(std::max(FLAGS_carnot_regex_cache_size, 0));
+  return cache;
+}
+
+std::shared_ptr<const re2::RE2> RegexCache::Get(std::string_view pattern,
+                                                const re2::RE2::Options& options) {
+  re2::StringPiece pattern_piece(pattern.data(), pattern.size());
+  if (entries_.max_entries() == 0) {
+    return std::make_shared<const re2::RE2>(pattern_piece, options);
+  }
+
+  std::string key = CacheKey(pattern, options);
+  std::optional<std::shared_ptr<const re2::RE2>> cached = entries_.Get(key);
+  if (cached.has_value()) {
+    ++hits_;
+    return *std::move(cached);
+  }
+  ++misses_;
+
+  // Compile outside of the cache's lock, so that a large pattern doesn't block the other queries.
+  // Another caller may have compiled the same pattern in the meantime, its regex is shared then.
+  return entries_.Insert(key, std::make_shared<const re2::RE2>(pattern_piece, options));
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
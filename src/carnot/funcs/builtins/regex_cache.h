@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "re2/re2.h"
+#include "src/common/base/base.h"
+#include "src/common/base/lru_cache.h"
+
+DECLARE_int32(carnot_regex_cache_size);
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+/**
+ * RegexCache keeps recently used compiled regexes, so that the UDF instances of every fragment of
+ * every query that use the same pattern share one compiled program instead of compiling it in
+ * their Init. RE2 objects can be used from multiple threads at once, so the cached ones are shared
+ * as is.
+ *
+ * The cache holds at most `max_entries` regexes and evicts the least recently used ones. Evicted
+ * regexes stay valid for as long as a UDF holds on to them.
+ */
+class RegexCache : public NotCopyable {
+ public:
+  explicit RegexCache(size_t max_entries) : entries_(max_entries) {}
+
+  /**
+   * The cache shared by all queries of the process, sized by --carnot_regex_cache_size.
+   */
+  static RegexCache* Global();
+
+  /**
+   * Returns the compiled regex for the pattern and options, compiling it if it isn't cached yet.
+   * Patterns that fail to compile are cached as well, the caller checks the error_code().
+   */
+  std::shared_ptr<const re2::RE2> Get(std::string_view pattern,
+                                      const re2::RE2::Options& options = re2::RE2::Options());
+
+  size_t size() const { return entries_.size(); }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  LRUCache<std::string, std::shared_ptr<const re2::RE2>> entries_;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/funcs/builtins/regex_cache.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+TEST(RegexCache, shares_compiled_regexes) {
+  RegexCache cache(2);
+  auto abc = cache.Get("abc.*");
+  EXPECT_EQ(abc, cache.Get("abc.*"));
+  EXPECT_TRUE(RE2::FullMatch("abcd", *abc));
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+
+  // Options that change the meaning of the pattern get their own entry.
+  re2::RE2::Options opts;
+  opts.set_case_sensitive(false);
+  auto abc_nocase = cache.Get("abc.*", opts);
+  EXPECT_NE(abc, abc_nocase);
+  EXPECT_TRUE(RE2::FullMatch("ABCD", *abc_nocase));
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(RegexCache, evicts_least_recently_used) {
+  RegexCache cache(2);
+  auto a = cache.Get("a");
+  auto b = cache.Get("b");
+  // Use a, so that b is evicted next.
+  cache.Get("a");
+  cache.Get("c");
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(a, cache.Get("a"));
+  EXPECT_NE(b, cache.Get("b"));
+  // Evicted regexes are still usable by their holders.
+  EXPECT_TRUE(RE2::FullMatch("b", *b));
+}
+
+TEST(RegexCache, caches_invalid_patterns) {
+  RegexCache cache(2);
+  auto invalid = cache.Get(R"regex(\K)regex");
+  EXPECT_NE(RE2::NoError, invalid->error_code());
+  EXPECT_EQ(invalid, cache.Get(R"regex(\K)regex"));
+}
+
+TEST(RegexCache, disabled) {
+  RegexCache cache(0);
+  auto abc = cache.Get("abc");
+  EXPECT_NE(abc, cache.Get("abc"));
+  EXPECT_EQ(0, cache.size());
+}
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <arrow/builder.h>
 #include <rapidjson/document.h>
 
 #include <absl/strings/strip.h>
@@ -26,9 +27,11 @@
 #include <memory>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include "re2/re2.h"
+#include "src/carnot/funcs/builtins/regex_cache.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -42,7 +45,7 @@ class RegexMatchUDF : public udf::ScalarUDF {
   Status Init(FunctionContext*, StringValue regex) {
     re2::RE2::Options opts;
     opts.set_log_errors(false);
-    regex_ = std::make_unique<re2::RE2>(regex, opts);
+    regex_ = RegexCache::Global()->Get(regex, opts);
     return Status::OK();
   }
   BoolValue Exec(FunctionContext*, StringValue input) {
@@ -68,7 +71,7 @@ class RegexMatchUDF : public udf::ScalarUDF {
   }
 
  private:
-  std::unique_ptr<re2::RE2> regex_;
+  std::shared_ptr<const re2::RE2> regex_;
 };
 
 class RegexReplaceUDF : public udf::ScalarUDF {
@@ -76,7 +79,7 @@ class RegexReplaceUDF : public udf::ScalarUDF {
   Status Init(FunctionContext*, StringValue regex_pattern) {
     re2::RE2::Options opts;
     opts.set_log_errors(false);
-    regex_ = std::make_unique<re2::RE2>(regex_pattern, opts);
+    regex_ = RegexCache::Global()->Get(regex_pattern, opts);
     return Status::OK();
   }
   StringValue Exec(FunctionContext*, StringValue input, StringValue sub) {
@@ -91,6 +94,43 @@ class RegexReplaceUDF : public udf::ScalarUDF {
     return input;
   }
 
+  // Same as Exec for every record, but the inputs are read from the arrow buffers in place, the
+  // substitution string is only checked when it changes, and the replacement reuses one buffer.
+  Status ExecBatch(FunctionContext*, size_t count, arrow::StringBuilder* out,
+                   const arrow::StringArray* inputs, const arrow::StringArray* subs) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    if (regex_->error_code() != RE2::NoError) {
+      std::string err = absl::Substitute("Invalid regex expr: $0", regex_->error());
+      for (size_t idx = 0; idx < count; ++idx) {
+        PL_RETURN_IF_ERROR(out->Append(err));
+      }
+      return Status::OK();
+    }
+    for (size_t idx = 0; idx < count; ++idx) {
+      int32_t sub_length = 0;
+      const uint8_t* sub = subs->GetValue(idx, &sub_length);
+      std::string_view sub_view(reinterpret_cast<const char*>(sub), sub_length);
+      if (!sub_checked_ || sub_view != checked_sub_) {
+        checked_sub_.assign(sub_view);
+        sub_err_.clear();
+        sub_checked_ = true;
+        if (!regex_->CheckRewriteString(checked_sub_, &sub_err_)) {
+          sub_err_ = absl::Substitute("Invalid regex in substitution string: $0", sub_err_);
+        }
+      }
+      if (!sub_err_.empty()) {
+        PL_RETURN_IF_ERROR(out->Append(sub_err_));
+        continue;
+      }
+      int32_t input_length = 0;
+      const uint8_t* input = inputs->GetValue(idx, &input_length);
+      buffer_.assign(reinterpret_cast<const char*>(input), input_length);
+      RE2::GlobalReplace(&buffer_, *regex_, checked_sub_);
+      PL_RETURN_IF_ERROR(out->Append(buffer_));
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Replace all matches of a regex pattern in a string with another string.")
@@ -113,7 +153,13 @@ class RegexReplaceUDF : public udf::ScalarUDF {
   }
 
  private:
-  std::unique_ptr<re2::RE2> regex_;
+  std::shared_ptr<const re2::RE2> regex_;
+
+  // State of ExecBatch, kept across batches.
+  bool sub_checked_ = false;
+  std::string checked_sub_;
+  std::string sub_err_;
+  std::string buffer_;
 };
 
 class MatchRegexRule : public udf::ScalarUDF {
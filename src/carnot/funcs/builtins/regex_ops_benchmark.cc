@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "src/carnot/funcs/builtins/pii_ops.h"
+#include "src/carnot/funcs/builtins/regex_ops.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+static constexpr char kPodRegex[] =
+    "pod([0-9a-f]{8})[-_]([0-9a-f]{4})[-_]([0-9a-f]{4})[-_]([0-9a-f]{4})[-_]([0-9a-f]{12})";
+
+// The setup that a query does for each instance of regex_match, when each instance compiles its
+// own regex.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RegexMatchInitUncached(benchmark::State& state) {
+  for (auto _ : state) {
+    re2::RE2::Options opts;
+    opts.set_log_errors(false);
+    benchmark::DoNotOptimize(std::make_unique<re2::RE2>(kPodRegex, opts));
+  }
+}
+
+// The same setup, when the compiled regex is shared through the cache.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RegexMatchInitCached(benchmark::State& state) {
+  for (auto _ : state) {
+    RegexMatchUDF udf;
+    benchmark::DoNotOptimize(udf.Init(nullptr, kPodRegex));
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RedactPIIInit(benchmark::State& state) {
+  for (auto _ : state) {
+    RedactPIIUDF udf;
+    benchmark::DoNotOptimize(udf.Init(nullptr));
+  }
+}
+
+BENCHMARK(BM_RegexMatchInitUncached);
+BENCHMARK(BM_RegexMatchInitCached);
+BENCHMARK(BM_RedactPIIInit);
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -25,6 +25,7 @@
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
 #include "src/common/base/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
 
 namespace px {
 namespace carnot {
@@ -76,6 +77,30 @@ TEST(RegexOps, invalid_regex_replace) {
           "a digit or '\\'.");
 }
 
+TEST(RegexOps, regex_replace_exec_batch) {
+  auto ctx = udf::FunctionContext(nullptr, nullptr);
+  RegexReplaceUDF udf;
+  ASSERT_OK(udf.Init(&ctx, "abc"));
+
+  std::vector<types::StringValue> inputs = {"1abc 2abcd", "abc", "xyz", "abcabc"};
+  std::vector<types::StringValue> subs = {"__", "__", "__", R"regex(\2)regex"};
+  auto inputs_arr = types::ToArrow(inputs, arrow::default_memory_pool());
+  auto subs_arr = types::ToArrow(subs, arrow::default_memory_pool());
+
+  // ExecBatch is preferred over Exec for arrow inputs, and gives the same results.
+  arrow::StringBuilder builder;
+  ASSERT_OK(udf::ScalarUDFWrapper<RegexReplaceUDF>::ExecBatchArrow(
+      &udf, &ctx, {inputs_arr.get(), subs_arr.get()}, &builder, inputs.size()));
+  std::shared_ptr<arrow::Array> res;
+  ASSERT_TRUE(builder.Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::StringArray*>(res.get());
+  ASSERT_EQ(inputs.size(), res_arr->length());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(udf.Exec(&ctx, inputs[i], subs[i]), res_arr->GetString(i));
+  }
+  EXPECT_EQ("1__ 2__d", res_arr->GetString(0));
+}
+
 TEST(RegexOps, regex_match_rules) {
   auto udf_tester = udf::UDFTester<MatchRegexRule>();
   // Value matches regex rule.
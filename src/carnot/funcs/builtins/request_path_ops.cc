@@ -18,11 +18,20 @@
 
 
 #include "src/carnot/funcs/builtins/request_path_ops.h"
+#include <algorithm>
 #include <string_view>
+#include <utility>
 #include <vector>
+#include "src/carnot/funcs/builtins/varint.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
+DEFINE_uint32(carnot_request_path_max_clusters_per_depth,
+              gflags::Uint32FromEnv("PL_CARNOT_REQUEST_PATH_MAX_CLUSTERS_PER_DEPTH", 256),
+              "The maximum number of request path clusters of each depth that are kept while "
+              "fitting the clustering. Past it, request paths join their closest cluster. 0 means "
+              "no limit.");
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -212,34 +221,74 @@ void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writ
 
 double RequestPathClustering::MaxSimilarity(const RequestPath& request_path,
                                             int64_t* max_index) const {
-  auto it = depth_to_centroid_indices_.find(request_path.depth());
   *max_index = -1;
-  if (it == depth_to_centroid_indices_.end()) {
-    return 0.0;
+  // The number of path components that agree with the request path, for each cluster that has
+  // any. This is the numerator of RequestPath::Similarity.
+  absl::flat_hash_map<int64_t, int64_t> num_agree;
+  for (const auto& [i, path_component] : Enumerate(request_path.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto it = component_to_cluster_indices_.find(
+        CentroidComponent(request_path.depth(), i, path_component));
+    if (it == component_to_cluster_indices_.end()) {
+      continue;
+    }
+    for (auto index : it->second) {
+      ++num_agree[index];
+    }
   }
-  auto max_similarity = 0.0;
-  for (auto index : it->second) {
-    auto similarity = clusters_[index].Similarity(request_path);
-    if (similarity > max_similarity) {
+
+  // Ties go to the oldest cluster.
+  int64_t max_agree = 0;
+  for (const auto& [index, agree] : num_agree) {
+    if (agree > max_agree || (agree == max_agree && index < *max_index)) {
       *max_index = index;
-      max_similarity = similarity;
+      max_agree = agree;
     }
   }
-  return max_similarity;
+  return static_cast<double>(max_agree) / request_path.depth();
 }
 
-void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
-  auto centroid = cluster.centroid();
-  if (depth_to_centroid_indices_.find(centroid.depth()) == depth_to_centroid_indices_.end()) {
-    depth_to_centroid_indices_.emplace(centroid.depth(), std::vector<int64_t>());
+void RequestPathClustering::IndexComponents(int64_t cluster_index) {
+  const auto& centroid = clusters_[cluster_index].centroid();
+  for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    component_to_cluster_indices_[CentroidComponent(centroid.depth(), i, path_component)]
+        .push_back(cluster_index);
   }
-  depth_to_centroid_indices_[centroid.depth()].push_back(clusters_.size());
+}
+
+void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
+  auto depth = cluster.centroid().depth();
+  depth_to_centroid_indices_[depth].push_back(clusters_.size());
   clusters_.push_back(cluster);
+  IndexComponents(clusters_.size() - 1);
 }
 
 void RequestPathClustering::MergeCluster(int64_t cluster_index,
                                          const RequestPathCluster& other_cluster) {
-  clusters_[cluster_index].Merge(other_cluster);
+  auto& cluster = clusters_[cluster_index];
+  // Merging only ever replaces path components of the centroid with kAnyToken, which have to be
+  // removed from the index.
+  std::vector<std::string> old_components = cluster.centroid().path_components();
+  cluster.Merge(other_cluster);
+  const auto& centroid = cluster.centroid();
+  for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+    if (path_component == old_components[i] || old_components[i] == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto it = component_to_cluster_indices_.find(
+        CentroidComponent(centroid.depth(), i, std::move(old_components[i])));
+    DCHECK(it != component_to_cluster_indices_.end());
+    auto& indices = it->second;
+    indices.erase(std::find(indices.begin(), indices.end(), cluster_index));
+    if (indices.empty()) {
+      component_to_cluster_indices_.erase(it);
+    }
+  }
 }
 
 StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::string& json) {
@@ -261,6 +310,122 @@ StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::strin
   return clustering;
 }
 
+namespace {
+
+constexpr uint8_t kClusteringSerializationVersion = 1;
+
+void AppendPathComponents(const std::vector<std::string>& path_components,
+                          const absl::flat_hash_map<std::string_view, uint64_t>& component_ids,
+                          std::string* out) {
+  for (const auto& path_component : path_components) {
+    AppendVarint(out, component_ids.at(path_component));
+  }
+}
+
+StatusOr<RequestPath> ConsumeRequestPath(std::string_view* data,
+                                         const std::vector<std::string>& components,
+                                         uint64_t depth) {
+  std::vector<std::string> path_components;
+  path_components.reserve(depth);
+  for (uint64_t i = 0; i < depth; ++i) {
+    uint64_t id = 0;
+    if (!ConsumeVarint(data, &id) || id >= components.size()) {
+      return error::InvalidArgument("RequestPathClustering::Deserialize: invalid path component");
+    }
+    path_components.push_back(components[id]);
+  }
+  return RequestPath::FromPathComponents(std::move(path_components));
+}
+
+}  // namespace
+
+// The format is the version byte, the number of distinct path components and each of them as its
+// length and bytes, and then the number of clusters. Each cluster is the depth, the ids of the path
+// components of its centroid, the number of members and the ids of the path components of each.
+std::string RequestPathClustering::Serialize() const {
+  absl::flat_hash_map<std::string_view, uint64_t> component_ids;
+  std::string components;
+  auto add_components = [&](const RequestPath& request_path) {
+    for (const auto& path_component : request_path.path_components()) {
+      if (component_ids.try_emplace(path_component, component_ids.size()).second) {
+        AppendVarint(&components, path_component.size());
+        components.append(path_component);
+      }
+    }
+  };
+  for (const auto& cluster : clusters_) {
+    add_components(cluster.centroid());
+    for (const auto& member : cluster.members()) {
+      add_components(member);
+    }
+  }
+
+  std::string out;
+  out.push_back(static_cast<char>(kClusteringSerializationVersion));
+  AppendVarint(&out, component_ids.size());
+  out.append(components);
+  AppendVarint(&out, clusters_.size());
+  for (const auto& cluster : clusters_) {
+    AppendVarint(&out, cluster.centroid().depth());
+    AppendPathComponents(cluster.centroid().path_components(), component_ids, &out);
+    AppendVarint(&out, cluster.members().size());
+    for (const auto& member : cluster.members()) {
+      AppendPathComponents(member.path_components(), component_ids, &out);
+    }
+  }
+  return out;
+}
+
+StatusOr<RequestPathClustering> RequestPathClustering::Deserialize(std::string_view data) {
+  if (data.empty() || data[0] != kClusteringSerializationVersion) {
+    return error::InvalidArgument("RequestPathClustering::Deserialize: unsupported version");
+  }
+  data.remove_prefix(1);
+
+  uint64_t num_components = 0;
+  if (!ConsumeVarint(&data, &num_components) || num_components > data.size()) {
+    return error::InvalidArgument("RequestPathClustering::Deserialize: invalid path components");
+  }
+  std::vector<std::string> components;
+  components.reserve(num_components);
+  for (uint64_t i = 0; i < num_components; ++i) {
+    uint64_t len = 0;
+    if (!ConsumeVarint(&data, &len) || len > data.size()) {
+      return error::InvalidArgument("RequestPathClustering::Deserialize: truncated path component");
+    }
+    components.emplace_back(data.substr(0, len));
+    data.remove_prefix(len);
+  }
+
+  uint64_t num_clusters = 0;
+  if (!ConsumeVarint(&data, &num_clusters) || num_clusters > data.size()) {
+    return error::InvalidArgument("RequestPathClustering::Deserialize: invalid clusters");
+  }
+  RequestPathClustering clustering;
+  for (uint64_t i = 0; i < num_clusters; ++i) {
+    uint64_t depth = 0;
+    if (!ConsumeVarint(&data, &depth) || depth == 0 || depth > data.size()) {
+      return error::InvalidArgument("RequestPathClustering::Deserialize: invalid depth");
+    }
+    PL_ASSIGN_OR_RETURN(auto centroid, ConsumeRequestPath(&data, components, depth));
+
+    uint64_t num_members = 0;
+    if (!ConsumeVarint(&data, &num_members) || num_members > data.size()) {
+      return error::InvalidArgument("RequestPathClustering::Deserialize: invalid members");
+    }
+    absl::flat_hash_set<RequestPath> members;
+    for (uint64_t j = 0; j < num_members; ++j) {
+      PL_ASSIGN_OR_RETURN(auto member, ConsumeRequestPath(&data, components, depth));
+      members.insert(std::move(member));
+    }
+    clustering.AddNewCluster(RequestPathCluster(std::move(centroid), std::move(members)));
+  }
+  if (!data.empty()) {
+    return error::InvalidArgument("RequestPathClustering::Deserialize: trailing data");
+  }
+  return clustering;
+}
+
 std::string RequestPathClustering::ToJSON() const {
   rapidjson::StringBuffer sb;
   rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
@@ -287,10 +452,19 @@ void RequestPathClustering::Update(const RequestPathCluster& new_cluster) {
   int64_t closest_cluster_index;
   auto similarity = MaxSimilarity(new_cluster.centroid(), &closest_cluster_index);
   if (closest_cluster_index == -1 || similarity < thresh_) {
-    AddNewCluster(new_cluster);
-  } else {
-    MergeCluster(closest_cluster_index, new_cluster);
+    auto it = depth_to_centroid_indices_.find(new_cluster.centroid().depth());
+    if (max_clusters_per_depth_ == 0 || it == depth_to_centroid_indices_.end() ||
+        it->second.size() < max_clusters_per_depth_) {
+      AddNewCluster(new_cluster);
+      return;
+    }
+    // There are already as many clusters of this depth as allowed, so the new cluster joins the
+    // closest one, or the oldest one if none are similar at all.
+    if (closest_cluster_index == -1) {
+      closest_cluster_index = it->second.front();
+    }
   }
+  MergeCluster(closest_cluster_index, new_cluster);
 }
 
 void RequestPathClustering::Merge(const RequestPathClustering& other_clustering) {
@@ -306,15 +480,12 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
     }
   }
 
-  clusters_ = new_clusters;
-  // Rebuild depth_to_cluster_indices mapping.
+  // Rebuild the indices of the clusters.
+  clusters_.clear();
   depth_to_centroid_indices_.clear();
-  for (const auto& [cluster_idx, cluster] : Enumerate(clusters_)) {
-    auto depth = cluster.centroid().depth();
-    if (depth_to_centroid_indices_.find(depth) == depth_to_centroid_indices_.end()) {
-      depth_to_centroid_indices_.emplace(depth, std::vector<int64_t>());
-    }
-    depth_to_centroid_indices_[depth].push_back(cluster_idx);
+  component_to_cluster_indices_.clear();
+  for (const auto& cluster : new_clusters) {
+    AddNewCluster(cluster);
   }
 
   for (const auto& cluster : other_clustering.clusters_) {
@@ -333,6 +504,131 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
   }
 }
 
+RequestPathSplitter::RequestPathSplitter(std::string_view request_path) {
+  // Like RequestPath, the request params are chopped off.
+  auto param_index = request_path.find('?');
+  if (param_index != std::string_view::npos) {
+    request_path = request_path.substr(0, param_index);
+  }
+  if (!request_path.empty() && request_path[0] == '/') {
+    request_path.remove_prefix(1);
+  }
+  stripped_ = request_path;
+  rest_ = request_path;
+}
+
+void RequestPathTrie::Insert(const RequestPath& templ, int64_t id) {
+  DCHECK_GE(id, 0);
+  int32_t node = 0;
+  for (const auto& path_component : templ.path_components()) {
+    int32_t child;
+    if (path_component == RequestPath::kAnyToken) {
+      child = nodes_[node].any_child;
+      if (child == -1) {
+        child = nodes_.size();
+        nodes_[node].any_child = child;
+        nodes_.emplace_back();
+      }
+    } else {
+      auto [it, inserted] = nodes_[node].children.try_emplace(path_component, nodes_.size());
+      child = it->second;
+      if (inserted) {
+        nodes_.emplace_back();
+      }
+    }
+    node = child;
+  }
+  if (nodes_[node].id == -1 || id < nodes_[node].id) {
+    nodes_[node].id = id;
+  }
+}
+
+int64_t RequestPathTrie::Match(int32_t node, RequestPathSplitter splitter) const {
+  std::string_view path_component;
+  if (!splitter.Next(&path_component)) {
+    return nodes_[node].id;
+  }
+  const Node& n = nodes_[node];
+  int64_t id = -1;
+  auto it = n.children.find(path_component);
+  if (it != n.children.end()) {
+    id = Match(it->second, splitter);
+  }
+  if (n.any_child != -1) {
+    auto any_id = Match(n.any_child, splitter);
+    if (any_id != -1 && (id == -1 || any_id < id)) {
+      id = any_id;
+    }
+  }
+  return id;
+}
+
+RequestPathClusteringPredictor::RequestPathClusteringPredictor(
+    const RequestPathClustering& clustering) {
+  for (const auto& [i, cluster] : Enumerate(clustering.clusters())) {
+    const auto& centroid = cluster.centroid();
+    auto& component_index = depth_to_component_index_[centroid.depth()];
+    component_index.resize(centroid.depth());
+    for (const auto& [j, path_component] : Enumerate(centroid.path_components())) {
+      if (path_component == RequestPath::kAnyToken) {
+        continue;
+      }
+      component_index[j][path_component].push_back(i);
+    }
+    for (const auto& member : cluster.members()) {
+      member_to_cluster_indices_[absl::StrJoin(member.path_components(), "/")].push_back(i);
+    }
+    centroids_.push_back(centroid.ToString());
+  }
+  num_agree_.resize(centroids_.size());
+}
+
+std::string RequestPathClusteringPredictor::Predict(std::string_view request_path) {
+  RequestPathSplitter splitter(request_path);
+  int32_t closest_cluster_index = -1;
+  auto it = depth_to_component_index_.find(splitter.depth());
+  if (it != depth_to_component_index_.end()) {
+    const auto& component_index = it->second;
+    std::string_view path_component;
+    for (size_t i = 0; splitter.Next(&path_component); ++i) {
+      auto clusters_it = component_index[i].find(path_component);
+      if (clusters_it == component_index[i].end()) {
+        continue;
+      }
+      for (auto index : clusters_it->second) {
+        if (num_agree_[index]++ == 0) {
+          agreeing_clusters_.push_back(index);
+        }
+      }
+    }
+
+    // Ties go to the oldest cluster, as in RequestPathClustering::MaxSimilarity.
+    int32_t max_agree = 0;
+    for (auto index : agreeing_clusters_) {
+      if (num_agree_[index] > max_agree ||
+          (num_agree_[index] == max_agree && index < closest_cluster_index)) {
+        closest_cluster_index = index;
+        max_agree = num_agree_[index];
+      }
+      num_agree_[index] = 0;
+    }
+    agreeing_clusters_.clear();
+  }
+
+  // Request paths that aren't close to any cluster, and members of the closest cluster, are
+  // predicted to be their own cluster.
+  if (closest_cluster_index == -1) {
+    return absl::StrCat("/", splitter.stripped());
+  }
+  auto member_it = member_to_cluster_indices_.find(splitter.stripped());
+  if (member_it != member_to_cluster_indices_.end() &&
+      std::find(member_it->second.begin(), member_it->second.end(), closest_cluster_index) !=
+          member_it->second.end()) {
+    return absl::StrCat("/", splitter.stripped());
+  }
+  return centroids_[closest_cluster_index];
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -20,14 +20,20 @@
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "src/carnot/funcs/builtins/string_ops.h"
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 
+DECLARE_uint32(carnot_request_path_max_clusters_per_depth);
+
 namespace px {
 namespace carnot {
 namespace builtins {
@@ -46,6 +52,12 @@ class RequestPath {
  public:
   explicit RequestPath(std::string request_path);
   RequestPath() = default;
+
+  static RequestPath FromPathComponents(std::vector<std::string> path_components) {
+    RequestPath request_path;
+    request_path.path_components_ = std::move(path_components);
+    return request_path;
+  }
   /**
    * Get the similarity of this request path to another one. The similarity metric used is the
    * number of path components that are the same, ignoring kAnyTokens, normalized by the total
@@ -128,6 +140,11 @@ class RequestPathCluster {
       : centroid_(request_path), min_cardinality_(min_cardinality) {
     members_.insert(request_path);
   }
+  RequestPathCluster(RequestPath centroid, absl::flat_hash_set<RequestPath> members,
+                     size_t min_cardinality = 5)
+      : centroid_(std::move(centroid)),
+        min_cardinality_(min_cardinality),
+        members_(std::move(members)) {}
 
   /**
    * Merge another cluster into this one.
@@ -176,10 +193,26 @@ class RequestPathCluster {
 
 class RequestPathClustering {
  public:
+  /**
+   * @param max_clusters_per_depth The number of clusters of request paths of the same depth, past
+   * which new request paths are merged into their closest cluster even if they aren't similar to
+   * it. This bounds the memory of the clustering. 0 means no limit.
+   */
+  explicit RequestPathClustering(
+      size_t max_clusters_per_depth = FLAGS_carnot_request_path_max_clusters_per_depth)
+      : max_clusters_per_depth_(max_clusters_per_depth) {}
+
   static StatusOr<RequestPathClustering> FromJSON(const std::string& json);
 
   std::string ToJSON() const;
 
+  /**
+   * Serializes the clustering to a compact binary form, for partial aggregates sent between
+   * agents. Each distinct path component is written only once.
+   */
+  std::string Serialize() const;
+  static StatusOr<RequestPathClustering> Deserialize(std::string_view data);
+
   /**
    * @param request_path request path to get prediction for.
    * @return the centroid of the cluster closest to the given request path.
@@ -201,30 +234,159 @@ class RequestPathClustering {
   double MaxSimilarity(const RequestPath& request_path, int64_t* max_index) const;
   void AddNewCluster(const RequestPathCluster& cluster);
   void MergeCluster(int64_t cluster_index, const RequestPathCluster& other_cluster);
+  void IndexComponents(int64_t cluster_index);
+
   // We currently only allow request path's with the same depth to be clustered together.
   absl::flat_hash_map<int64_t, std::vector<int64_t>> depth_to_centroid_indices_;
+
+  // The (depth, index, value) of a path component of a centroid, other than kAnyToken.
+  using CentroidComponent = std::tuple<int64_t, int64_t, std::string>;
+  // The clusters whose centroids have each path component. The similarity of a request path to
+  // every centroid is counted from the clusters of its components, instead of comparing it to each
+  // centroid of its depth in turn.
+  absl::flat_hash_map<CentroidComponent, std::vector<int64_t>> component_to_cluster_indices_;
+
   std::vector<RequestPathCluster> clusters_;
   double thresh_ = 0.5;
+  size_t max_clusters_per_depth_;
+};
+
+/**
+ * Iterates over the path components of a request path in place. The request path is split the same
+ * way as by RequestPath, so request params are dropped and a leading '/' is ignored.
+ */
+class RequestPathSplitter {
+ public:
+  explicit RequestPathSplitter(std::string_view request_path);
+
+  /**
+   * @param path_component set to the next path component, which points into the request path.
+   * @return false once there are no path components left.
+   */
+  bool Next(std::string_view* path_component) {
+    if (done_) {
+      return false;
+    }
+    auto pos = rest_.find('/');
+    if (pos == std::string_view::npos) {
+      *path_component = rest_;
+      done_ = true;
+      return true;
+    }
+    *path_component = rest_.substr(0, pos);
+    rest_.remove_prefix(pos + 1);
+    return true;
+  }
+
+  // The request path without its params and leading '/', eg. "a/b/c" for "/a/b/c?k=v".
+  std::string_view stripped() const { return stripped_; }
+  int64_t depth() const { return std::count(stripped_.begin(), stripped_.end(), '/') + 1; }
+
+ private:
+  std::string_view stripped_;
+  std::string_view rest_;
+  bool done_ = false;
+};
+
+/**
+ * A trie of template request paths, with an edge for each path component. The kAnyToken path
+ * components of the templates are wildcard edges, which match any path component. Request paths
+ * are matched against all of the templates at once, without splitting them into a RequestPath.
+ */
+class RequestPathTrie {
+ public:
+  RequestPathTrie() : nodes_(1) {}
+
+  /**
+   * Adds a template request path to the trie.
+   * @param templ the template, see RequestPath::Matches.
+   * @param id the id returned by Match for the template. Must not be negative.
+   */
+  void Insert(const RequestPath& templ, int64_t id);
+
+  /**
+   * @param request_path the unparsed request path to match.
+   * @return the smallest id of the templates that the request path matches, or -1 if it matches
+   * none of them.
+   */
+  int64_t Match(std::string_view request_path) const {
+    return Match(0, RequestPathSplitter(request_path));
+  }
+
+ private:
+  struct Node {
+    absl::flat_hash_map<std::string, int32_t> children;
+    int32_t any_child = -1;
+    int64_t id = -1;
+  };
+
+  int64_t Match(int32_t node, RequestPathSplitter splitter) const;
+
+  std::vector<Node> nodes_;
+};
+
+/**
+ * The Predict of a RequestPathClustering, compiled once for a fixed clustering. The centroids are
+ * indexed by their path components at each depth, so that the similarity of a request path to them
+ * is counted from views of its path components, in counters that are reused for every prediction.
+ */
+class RequestPathClusteringPredictor {
+ public:
+  explicit RequestPathClusteringPredictor(const RequestPathClustering& clustering);
+
+  /**
+   * @param request_path unparsed request path to get prediction for.
+   * @return the same as RequestPathClustering::Predict(RequestPath(request_path)).ToString().
+   */
+  std::string Predict(std::string_view request_path);
+
+ private:
+  // The clusters whose centroids have each path component, for each index of the path components.
+  using ComponentIndex = std::vector<absl::flat_hash_map<std::string, std::vector<int32_t>>>;
+  absl::flat_hash_map<int64_t, ComponentIndex> depth_to_component_index_;
+  // The clusters that have each request path as a member, keyed by the stripped request path.
+  absl::flat_hash_map<std::string, std::vector<int32_t>> member_to_cluster_indices_;
+  std::vector<std::string> centroids_;
+
+  // The number of the path components that agree, for each cluster, and the clusters with any.
+  std::vector<int32_t> num_agree_;
+  std::vector<int32_t> agreeing_clusters_;
 };
 
 class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue request_path_str,
                    StringValue serialized_clustering) {
-    if (!clustering_init_) {
+    if (predictor_ == nullptr) {
       auto clustering_or_s = RequestPathClustering::FromJSON(serialized_clustering);
       if (!clustering_or_s.ok()) {
         return clustering_or_s.msg();
       }
-      clustering_ = clustering_or_s.ConsumeValueOrDie();
-      clustering_init_ = true;
+      predictor_ = std::make_unique<RequestPathClusteringPredictor>(clustering_or_s.ValueOrDie());
     }
-    auto request_path = RequestPath(request_path_str);
-    return clustering_.Predict(request_path).ToString();
+    return predictor_->Predict(request_path_str);
   }
 
-  RequestPathClustering clustering_;
-  bool clustering_init_ = false;
+  // Same as Exec for every record, but the request paths are read in place from the arrow buffers.
+  Status ExecBatch(FunctionContext* ctx, size_t count, arrow::StringBuilder* out,
+                   const arrow::StringArray* request_paths,
+                   const arrow::StringArray* serialized_clusterings) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      if (predictor_ == nullptr) {
+        StringValue predicted = Exec(ctx, std::string(GetStringView(request_paths, idx)),
+                                     std::string(GetStringView(serialized_clusterings, idx)));
+        PL_RETURN_IF_ERROR(out->Append(predicted));
+        continue;
+      }
+      PL_RETURN_IF_ERROR(out->Append(predictor_->Predict(GetStringView(request_paths, idx))));
+    }
+    return Status::OK();
+  }
+
+ private:
+  // The clustering is the same for every record, so it's compiled from the first one.
+  std::unique_ptr<RequestPathClusteringPredictor> predictor_;
 };
 
 class RequestPathClusteringFitUDA : public udf::UDA {
@@ -238,10 +400,10 @@ class RequestPathClusteringFitUDA : public udf::UDA {
   }
   StringValue Finalize(FunctionContext*) { return clustering_.ToJSON(); }
 
-  StringValue Serialize(FunctionContext*) { return clustering_.ToJSON(); }
+  StringValue Serialize(FunctionContext*) { return clustering_.Serialize(); }
 
   Status Deserialize(FunctionContext*, const StringValue& data) {
-    PL_ASSIGN_OR_RETURN(clustering_, RequestPathClustering::FromJSON(data));
+    PL_ASSIGN_OR_RETURN(clustering_, RequestPathClustering::Deserialize(data));
     return Status::OK();
   }
 
@@ -252,8 +414,35 @@ class RequestPathClusteringFitUDA : public udf::UDA {
 class RequestPathEndpointMatcherUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, StringValue request_path, StringValue endpoint) {
-    return RequestPath(request_path).Matches(RequestPath(endpoint));
+    return Matches(request_path, endpoint);
   }
+
+  // Same as Exec for every record, but the strings are matched in place in the arrow buffers.
+  Status ExecBatch(FunctionContext*, size_t count, arrow::BooleanBuilder* out,
+                   const arrow::StringArray* request_paths, const arrow::StringArray* endpoints) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(Matches(GetStringView(request_paths, idx), GetStringView(endpoints, idx)));
+    }
+    return Status::OK();
+  }
+
+ private:
+  bool Matches(std::string_view request_path, std::string_view endpoint) {
+    // The endpoint is almost always the same for every record, so it's only compiled when it
+    // changes.
+    if (!endpoint_init_ || endpoint != endpoint_) {
+      endpoint_ = std::string(endpoint);
+      trie_ = RequestPathTrie();
+      trie_.Insert(RequestPath(endpoint_), 0);
+      endpoint_init_ = true;
+    }
+    return trie_.Match(request_path) != -1;
+  }
+
+  RequestPathTrie trie_;
+  std::string endpoint_;
+  bool endpoint_init_ = false;
 };
 
 }  // namespace builtins
@@ -195,6 +195,123 @@ TEST(RequestPathClusteringFit, merging_clusters_complicated) {
   } while (std::next_permutation(permutation_indices.begin(), permutation_indices.end()));
 }
 
+TEST(RequestPathClustering, serialize_round_trip) {
+  RequestPathClustering clustering;
+  for (int i = 0; i < 10; ++i) {
+    clustering.Update(RequestPathCluster(RequestPath(absl::StrCat("/api/v1/users/", i))));
+  }
+  clustering.Update(RequestPathCluster(RequestPath("/healthz")));
+  clustering.Update(RequestPathCluster(RequestPath("/api/v1/orders/1/items")));
+  clustering.Update(RequestPathCluster(RequestPath("/api/v1/orders/2/items")));
+
+  std::string serialized = clustering.Serialize();
+  EXPECT_LT(serialized.size(), clustering.ToJSON().size() / 2);
+  ASSERT_OK_AND_ASSIGN(auto deserialized, RequestPathClustering::Deserialize(serialized));
+  EXPECT_THAT(deserialized, HasCentroids(std::vector<std::string>(
+                                {"/api/v1/users/*", "/healthz", "/api/v1/orders/1/items",
+                                 "/api/v1/orders/2/items"})));
+  EXPECT_EQ("/api/v1/users/*", deserialized.Predict(RequestPath("/api/v1/users/42")).ToString());
+  EXPECT_EQ("/api/v1/orders/2/items",
+            deserialized.Predict(RequestPath("/api/v1/orders/2/items")).ToString());
+
+  EXPECT_NOT_OK(RequestPathClustering::Deserialize(""));
+  EXPECT_NOT_OK(RequestPathClustering::Deserialize(clustering.ToJSON()));
+  EXPECT_NOT_OK(RequestPathClustering::Deserialize(serialized.substr(0, serialized.size() - 1)));
+}
+
+TEST(RequestPathClustering, max_clusters_per_depth) {
+  RequestPathClustering clustering(/* max_clusters_per_depth */ 2);
+  clustering.Update(RequestPathCluster(RequestPath("/a/b/c")));
+  clustering.Update(RequestPathCluster(RequestPath("/d/e/f")));
+  // Past the limit, paths join their closest cluster even if they aren't similar enough, or the
+  // oldest cluster if they aren't similar at all.
+  clustering.Update(RequestPathCluster(RequestPath("/a/x/y")));
+  EXPECT_EQ("/a/*/*", clustering.clusters()[0].centroid().ToString());
+  clustering.Update(RequestPathCluster(RequestPath("/g/h/i")));
+  // Other depths have their own limit.
+  clustering.Update(RequestPathCluster(RequestPath("/a/b")));
+
+  ASSERT_EQ(3, clustering.clusters().size());
+  EXPECT_EQ("/*/*/*", clustering.clusters()[0].centroid().ToString());
+  EXPECT_EQ("/d/e/f", clustering.clusters()[1].centroid().ToString());
+  EXPECT_EQ("/a/b", clustering.clusters()[2].centroid().ToString());
+  EXPECT_EQ("/d/e/f", clustering.Predict(RequestPath("/d/e/f")).ToString());
+}
+
+TEST(RequestPathTrie, matches_like_request_path) {
+  std::vector<std::string> templates = {"/a/b/*", "/a/*/c", "/*/b/c", "/a/b", "/*", "/x/*/*/y"};
+  RequestPathTrie trie;
+  for (const auto& [i, templ] : Enumerate(templates)) {
+    trie.Insert(RequestPath(templ), i);
+  }
+  for (const char* request_path :
+       {"/a/b/c", "a/b/c?k=v", "/a/x/c", "/z/b/c", "/a/b", "/a/b/", "/a", "", "/x/1/2/y", "/x/1/y",
+        "/a/*/d", "/*/*/*"}) {
+    int64_t expected = -1;
+    for (const auto& [i, templ] : Enumerate(templates)) {
+      if (RequestPath(request_path).Matches(RequestPath(templ))) {
+        expected = i;
+        break;
+      }
+    }
+    EXPECT_EQ(expected, trie.Match(request_path)) << request_path;
+  }
+}
+
+TEST(RequestPathClusteringPredictor, predicts_like_clustering) {
+  RequestPathClustering clustering;
+  for (int i = 0; i < 10; ++i) {
+    clustering.Update(RequestPathCluster(RequestPath(absl::StrCat("/api/v1/users/", i))));
+  }
+  clustering.Update(RequestPathCluster(RequestPath("/healthz")));
+  clustering.Update(RequestPathCluster(RequestPath("/api/v1/orders/1/items")));
+  clustering.Update(RequestPathCluster(RequestPath("/api/v1/orders/2/items")));
+  clustering.Update(RequestPathCluster(RequestPath("/a/b/c")));
+  clustering.Update(RequestPathCluster(RequestPath("/a/b/d")));
+
+  RequestPathClusteringPredictor predictor(clustering);
+  for (const char* request_path :
+       {"/api/v1/users/42", "api/v1/users/3?k=v", "/api/v1/orders/2/items",
+        "/api/v1/orders/3/items", "/healthz", "/a/b/c", "/a/b/e", "/a/x/d", "/api/v2/users/1"}) {
+    EXPECT_EQ(clustering.Predict(RequestPath(request_path)).ToString(),
+              predictor.Predict(request_path))
+        << request_path;
+  }
+  // Request paths that aren't close to any cluster are their own cluster.
+  EXPECT_EQ("/x/y", predictor.Predict("x/y?k=v"));
+}
+
+TEST(RequestPathOps, exec_batch_matches_exec) {
+  auto ctx = udf::FunctionContext(nullptr, nullptr);
+  auto serialized_clustering = udf::UDATester<RequestPathClusteringFitUDA>()
+                                   .ForInput("/a/b/c")
+                                   .ForInput("/a/b/d")
+                                   .ForInput("/a/b/e")
+                                   .ForInput("/x/y")
+                                   .Result();
+  std::vector<types::StringValue> request_paths = {"/a/b/c", "/a/b/f", "/a/c/c", "/x/y", "/x/z"};
+  std::vector<types::StringValue> endpoints = {"/a/b/*", "/a/b/*", "/a/b/*", "/x/*", "/x/*"};
+  std::vector<types::StringValue> clusterings(request_paths.size(), serialized_clustering);
+
+  RequestPathEndpointMatcherUDF matcher;
+  auto matcher_res = udf::ExecArrow<RequestPathEndpointMatcherUDF, arrow::BooleanBuilder>(
+      &matcher, request_paths, endpoints);
+  RequestPathClusteringPredictUDF predict;
+  auto predict_res = udf::ExecArrow<RequestPathClusteringPredictUDF, arrow::StringBuilder>(
+      &predict, request_paths, clusterings);
+
+  RequestPathEndpointMatcherUDF matcher_exec;
+  RequestPathClusteringPredictUDF predict_exec;
+  for (size_t i = 0; i < request_paths.size(); ++i) {
+    EXPECT_EQ(matcher_exec.Exec(&ctx, request_paths[i], endpoints[i]).val,
+              static_cast<arrow::BooleanArray*>(matcher_res.get())->Value(i));
+    EXPECT_EQ(predict_exec.Exec(&ctx, request_paths[i], clusterings[i]),
+              static_cast<arrow::StringArray*>(predict_res.get())->GetString(i));
+  }
+  EXPECT_TRUE(static_cast<arrow::BooleanArray*>(matcher_res.get())->Value(1));
+  EXPECT_FALSE(static_cast<arrow::BooleanArray*>(matcher_res.get())->Value(2));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
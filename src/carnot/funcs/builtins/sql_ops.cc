@@ -56,6 +56,12 @@ void RegisterSQLOpsOrDie(udf::Registry* registry) {
 
 types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue sql_str,
                                                  StringValue cmd_code) {
+  return cache_.GetOrNormalize(absl::StrCat(cmd_code, ":", sql_str),
+                               [&]() { return Normalize(sql_str, cmd_code); });
+}
+
+types::StringValue NormalizePostgresSQLUDF::Normalize(const StringValue& sql_str,
+                                                      const StringValue& cmd_code) {
   std::string query;
   std::vector<std::string> param_values;
 
@@ -86,6 +92,12 @@ types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue s
 
 types::StringValue NormalizeMySQLUDF::Exec(FunctionContext*, StringValue sql_str,
                                            Int64Value cmd_code) {
+  return cache_.GetOrNormalize(absl::StrCat(cmd_code.val, ":", sql_str),
+                               [&]() { return Normalize(sql_str, cmd_code); });
+}
+
+types::StringValue NormalizeMySQLUDF::Normalize(const StringValue& sql_str,
+                                                Int64Value cmd_code) {
   std::string query;
   std::vector<std::string> param_values;
 
@@ -18,9 +18,11 @@
 
 #pragma once
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/strip.h>
 #include <regex>
 #include <string>
+#include <utility>
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/status.h"
@@ -36,6 +38,30 @@ static constexpr char kPgQueryCmdCode[] = "Query";
 static constexpr int64_t kMySQLQueryCmdCode = 0x03;
 static constexpr int64_t kMySQLExecuteCmdCode = 0x17;
 
+/**
+ * NormalizedQueryCache memoizes the results of a normalization UDF, since applications tend to send
+ * the same statements over and over. It's cleared when it's full.
+ */
+class NormalizedQueryCache {
+ public:
+  static constexpr size_t kMaxSize = 1024;
+
+  template <typename TNormalizeFn>
+  const std::string& GetOrNormalize(std::string key, TNormalizeFn normalize_fn) {
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      return it->second;
+    }
+    if (cache_.size() >= kMaxSize) {
+      cache_.clear();
+    }
+    return cache_.emplace(std::move(key), normalize_fn()).first->second;
+  }
+
+ private:
+  absl::flat_hash_map<std::string, std::string> cache_;
+};
+
 class NormalizePostgresSQLUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue sql_str, StringValue cmd_code);
@@ -59,6 +85,11 @@ class NormalizePostgresSQLUDF : public udf::ScalarUDF {
             "The normalized query with the values of the parameters in the query "
             "as JSON.");
   }
+
+ private:
+  StringValue Normalize(const StringValue& sql_str, const StringValue& cmd_code);
+
+  NormalizedQueryCache cache_;
 };
 
 class NormalizeMySQLUDF : public udf::ScalarUDF {
@@ -84,6 +115,11 @@ class NormalizeMySQLUDF : public udf::ScalarUDF {
             "The normalized query with the values of the parameters in the query "
             "as JSON.");
   }
+
+ private:
+  StringValue Normalize(const StringValue& sql_str, Int64Value cmd_code);
+
+  NormalizedQueryCache cache_;
 };
 
 void RegisterSQLOpsOrDie(udf::Registry* registry);
@@ -201,6 +201,18 @@ TEST(NormMySQL, invalid_utf8) {
   udf_tester.ForInput(invalid, kMySQLQueryCmdCode).Expect(expected_result.ToJSON());
 }
 
+TEST(NormalizeMySQLUDF, memoizes_by_query_and_cmd_code) {
+  auto udf_tester = udf::UDFTester<NormalizeMySQLUDF>();
+  NormalizeResult expected{"SELECT ?", {"1"}};
+  udf_tester.ForInput("SELECT 1", kMySQLQueryCmdCode).Expect(expected.ToJSON());
+  udf_tester.ForInput("SELECT 1", kMySQLQueryCmdCode).Expect(expected.ToJSON());
+
+  NormalizeResult invalid_cmd_code;
+  invalid_cmd_code.errmsg = absl::Substitute("cmd_code must be one of '$0' or '$1'",
+                                             kMySQLQueryCmdCode, kMySQLExecuteCmdCode);
+  udf_tester.ForInput("SELECT 1", 0).Expect(invalid_cmd_code.ToJSON());
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,501 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/sql_parsing/lexer_normalization.h"
+
+#include <simdutf.h>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_cat.h>
+#include <cctype>
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+namespace {
+
+enum class Dialect {
+  kPostgres,
+  kMySQL,
+};
+
+// The statements that are normalized by the lexer. Other statements, like DDL, have literals that
+// aren't constants, like the lengths of types.
+const absl::flat_hash_set<std::string_view>& StatementKeywords(Dialect dialect) {
+  static const auto* pgsql_keywords =
+      new absl::flat_hash_set<std::string_view>({"DELETE", "INSERT", "SELECT", "UPDATE"});
+  static const auto* mysql_keywords = new absl::flat_hash_set<std::string_view>(
+      {"DELETE", "INSERT", "REPLACE", "SELECT", "UPDATE"});
+  return dialect == Dialect::kMySQL ? *mysql_keywords : *pgsql_keywords;
+}
+
+// The keywords that are followed by an expression, so that a literal right after them is a
+// constant.
+const absl::flat_hash_set<std::string_view>& ExpressionKeywords() {
+  static const auto* keywords = new absl::flat_hash_set<std::string_view>(
+      {"AND", "BETWEEN", "CASE", "DISTINCT", "ELSE", "HAVING", "ILIKE", "IN", "LIKE", "NOT", "ON",
+       "OR", "SELECT", "SET", "THEN", "VALUE", "VALUES", "WHEN", "WHERE"});
+  return *keywords;
+}
+
+// The keywords that the grammars follow with literals that aren't constants, like LIMIT 10 or
+// SUBSTRING(a FROM 1), or with types that have lengths, like CAST(a AS CHAR(10)).
+const absl::flat_hash_set<std::string_view>& ParserOnlyKeywords() {
+  static const auto* keywords = new absl::flat_hash_set<std::string_view>(
+      {"BINARY", "CAST", "CHAR", "COLLATE", "CONVERT", "EXTRACT", "FETCH", "GET_FORMAT", "INTERVAL",
+       "LIMIT", "MID", "OFFSET", "OVER", "POSITION", "SUBSTR", "SUBSTRING", "TRIM",
+       "WEIGHT_STRING"});
+  return *keywords;
+}
+
+bool IsWordStart(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || static_cast<uint8_t>(c) >= 0x80;
+}
+
+bool IsWordChar(char c) {
+  return IsWordStart(c) || std::isdigit(static_cast<unsigned char>(c)) || c == '$';
+}
+
+bool IsDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+bool IsSpace(char c) { return std::isspace(static_cast<unsigned char>(c)); }
+
+class LexerNormalizer {
+ public:
+  LexerNormalizer(Dialect dialect, std::string_view sql,
+                  const std::vector<std::string>& param_values)
+      : dialect_(dialect), sql_(sql), param_values_(param_values) {}
+
+  std::optional<NormalizeResult> Normalize() {
+    if (!simdutf::validate_utf8(sql_.data(), sql_.length())) {
+      return std::nullopt;
+    }
+    result_.normalized_query.reserve(sql_.size());
+    while (pos_ < sql_.size()) {
+      if (!NextToken()) {
+        return std::nullopt;
+      }
+    }
+    // Leave incomplete statements, which may be truncated, to the parser to fail on.
+    if (!started_ || depth_ != 0 || prev_ == TokenKind::kOperator ||
+        prev_ == TokenKind::kOpenParen || prev_ == TokenKind::kDot ||
+        prev_ == TokenKind::kExpressionKeyword) {
+      return std::nullopt;
+    }
+    result_.normalized_query.append(sql_.substr(copied_));
+    return std::move(result_);
+  }
+
+ private:
+  // The kind of the previous token, which decides whether a literal after it is a constant.
+  enum class TokenKind {
+    kNone,
+    kOperator,
+    kOpenParen,
+    kCloseParen,
+    kDot,
+    kExpressionKeyword,
+    kWord,
+    // Literals, placeholders, variables and quoted identifiers.
+    kOperand,
+  };
+
+  bool mysql() const { return dialect_ == Dialect::kMySQL; }
+
+  bool IsExpressionStart() const {
+    return prev_ == TokenKind::kOperator || prev_ == TokenKind::kOpenParen ||
+           prev_ == TokenKind::kExpressionKeyword;
+  }
+
+  char At(size_t pos) const { return pos < sql_.size() ? sql_[pos] : '\0'; }
+
+  // Returns the end of the quoted string or identifier that starts at pos, or npos if it isn't
+  // terminated.
+  size_t QuotedEnd(size_t pos, bool backslash_escapes) const {
+    const char quote = sql_[pos];
+    for (size_t i = pos + 1; i < sql_.size(); ++i) {
+      if (backslash_escapes && sql_[i] == '\\') {
+        ++i;
+      } else if (sql_[i] == quote) {
+        if (At(i + 1) != quote) {
+          return i + 1;
+        }
+        ++i;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  // Replaces sql_[begin, end) with the next placeholder, and adds value to the params.
+  void Replace(size_t begin, size_t end, std::string value) {
+    result_.normalized_query.append(sql_.substr(copied_, begin - copied_));
+    if (mysql()) {
+      result_.normalized_query.push_back('?');
+    } else {
+      absl::StrAppend(&result_.normalized_query, "$", result_.params.size() + 1);
+    }
+    result_.params.push_back(std::move(value));
+    copied_ = end;
+  }
+
+  bool AddConstant(size_t end) {
+    if (!IsExpressionStart() || end == std::string_view::npos) {
+      return false;
+    }
+    Replace(pos_, end, std::string(sql_.substr(pos_, end - pos_)));
+    pos_ = end;
+    prev_ = TokenKind::kOperand;
+    return true;
+  }
+
+  bool AddPlaceholder(size_t end, size_t index) {
+    if (index >= param_values_.size()) {
+      return false;
+    }
+    Replace(pos_, end, param_values_[index]);
+    pos_ = end;
+    prev_ = TokenKind::kOperand;
+    return true;
+  }
+
+  void AddToken(size_t end, TokenKind kind) {
+    pos_ = end;
+    prev_ = kind;
+  }
+
+  // Skips the comment at pos_, if there is one.
+  // @return whether there was a comment, and sets *ok to false if it can't be skipped.
+  bool SkipComment(bool* ok) {
+    const char c = sql_[pos_];
+    if ((c == '-' && At(pos_ + 1) == '-') || (c == '#' && mysql())) {
+      // MySQL needs whitespace after --, otherwise it's two minus signs.
+      if (c == '-' && mysql() && pos_ + 2 < sql_.size() && !IsSpace(sql_[pos_ + 2])) {
+        *ok = false;
+        return true;
+      }
+      size_t end = sql_.find('\n', pos_);
+      pos_ = end == std::string_view::npos ? sql_.size() : end + 1;
+      return true;
+    }
+    if (c == '/' && At(pos_ + 1) == '*') {
+      size_t end = sql_.find("*/", pos_ + 2);
+      // MySQL runs the contents of /*! */ comments, and Postgres nests comments.
+      if (end == std::string_view::npos || (mysql() && At(pos_ + 2) == '!') ||
+          (!mysql() &&
+           sql_.substr(pos_ + 2, end - pos_ - 2).find("/*") != std::string_view::npos)) {
+        *ok = false;
+        return true;
+      }
+      pos_ = end + 2;
+      return true;
+    }
+    return false;
+  }
+
+  bool Number() {
+    size_t end = pos_;
+    if (sql_[end] == '0' && (At(end + 1) == 'x' || At(end + 1) == 'X' || At(end + 1) == 'b' ||
+                             At(end + 1) == 'B')) {
+      if (!mysql()) {
+        return false;
+      }
+      const bool hex = At(end + 1) == 'x' || At(end + 1) == 'X';
+      end += 2;
+      const size_t digits_begin = end;
+      while (end < sql_.size() &&
+             (hex ? std::isxdigit(static_cast<unsigned char>(sql_[end])) != 0
+                  : (sql_[end] == '0' || sql_[end] == '1'))) {
+        ++end;
+      }
+      if (end == digits_begin) {
+        return false;
+      }
+    } else {
+      while (IsDigit(At(end))) {
+        ++end;
+      }
+      if (At(end) == '.') {
+        ++end;
+        while (IsDigit(At(end))) {
+          ++end;
+        }
+      }
+      if ((At(end) == 'e' || At(end) == 'E') &&
+          (IsDigit(At(end + 1)) ||
+           ((At(end + 1) == '+' || At(end + 1) == '-') && IsDigit(At(end + 2))))) {
+        end += 2;
+        while (IsDigit(At(end))) {
+          ++end;
+        }
+      }
+    }
+    // MySQL identifiers can start with digits.
+    if (IsWordChar(At(end)) || At(end) == '.') {
+      return false;
+    }
+    return AddConstant(end);
+  }
+
+  bool Word() {
+    size_t end = pos_;
+    while (end < sql_.size() && IsWordChar(sql_[end])) {
+      ++end;
+    }
+    word_.assign(sql_.substr(pos_, end - pos_));
+    absl::AsciiStrToUpper(&word_);
+
+    const char next = At(end);
+    if (next == '\'' || next == '"' || next == '`') {
+      // Prefixed strings, like E'\n' in Postgres, or X'01' in MySQL.
+      if (next == '\'' && !mysql() && word_ == "E") {
+        return AddConstant(QuotedEnd(end, /* backslash_escapes */ true));
+      }
+      if (next == '\'' && mysql() && (word_ == "X" || word_ == "B")) {
+        return AddConstant(QuotedEnd(end, /* backslash_escapes */ false));
+      }
+      return false;
+    }
+
+    if (!started_) {
+      if (!StatementKeywords(dialect_).contains(word_)) {
+        return false;
+      }
+      started_ = true;
+    }
+    if (ParserOnlyKeywords().contains(word_)) {
+      return false;
+    }
+    if (word_ == "TRUE" || word_ == "FALSE") {
+      return AddConstant(end);
+    }
+    if (word_ == "NULL") {
+      // IS [NOT] NULL is a predicate rather than a constant.
+      if (prev_word_ == "IS" || (prev_word_ == "NOT" && prev_prev_word_ == "IS")) {
+        AddWord(end);
+        return true;
+      }
+      // Postgres doesn't consider NULL a constant, and MySQL considers NOT NULL one.
+      if (!mysql() || prev_word_ == "NOT") {
+        return false;
+      }
+      return AddConstant(end);
+    }
+    AddWord(end);
+    return true;
+  }
+
+  void AddWord(size_t end) {
+    prev_prev_word_ = prev_ == TokenKind::kWord || prev_ == TokenKind::kExpressionKeyword
+                          ? std::move(prev_word_)
+                          : std::string();
+    prev_word_ = word_;
+    AddToken(end, ExpressionKeywords().contains(word_) ? TokenKind::kExpressionKeyword
+                                                       : TokenKind::kWord);
+  }
+
+  bool NextToken() {
+    const char c = sql_[pos_];
+    if (IsSpace(c)) {
+      ++pos_;
+      return true;
+    }
+    bool ok = true;
+    if (SkipComment(&ok)) {
+      return ok;
+    }
+    // Only a single statement is normalized.
+    if (ended_) {
+      return false;
+    }
+    if (!started_ && !IsWordStart(c)) {
+      return false;
+    }
+    if (prev_ != TokenKind::kWord && prev_ != TokenKind::kExpressionKeyword) {
+      prev_word_.clear();
+    }
+
+    if (IsWordStart(c)) {
+      return Word();
+    }
+    if (IsDigit(c) || (c == '.' && IsDigit(At(pos_ + 1)) && prev_ != TokenKind::kWord &&
+                       prev_ != TokenKind::kOperand && prev_ != TokenKind::kCloseParen)) {
+      return Number();
+    }
+
+    switch (c) {
+      case '\'':
+        // Postgres U&'' strings.
+        if (!mysql() && pos_ > 0 && sql_[pos_ - 1] == '&') {
+          return false;
+        }
+        return AddConstant(QuotedEnd(pos_, /* backslash_escapes */ mysql()));
+      case '"':
+        if (mysql()) {
+          return AddConstant(QuotedEnd(pos_, /* backslash_escapes */ true));
+        }
+        // Postgres quotes identifiers with double quotes.
+        [[fallthrough]];
+      case '`': {
+        if (c == '`' && !mysql()) {
+          return false;
+        }
+        size_t end = QuotedEnd(pos_, /* backslash_escapes */ false);
+        if (end == std::string_view::npos) {
+          return false;
+        }
+        AddToken(end, TokenKind::kOperand);
+        return true;
+      }
+      case '$': {
+        // Postgres placeholders. Dollar quoted strings are left to the parser.
+        if (mysql() || !IsDigit(At(pos_ + 1))) {
+          return false;
+        }
+        size_t end = pos_ + 1;
+        size_t index = 0;
+        while (IsDigit(At(end))) {
+          index = index * 10 + (sql_[end] - '0');
+          if (index > param_values_.size()) {
+            return false;
+          }
+          ++end;
+        }
+        // Postgres placeholders are 1-indexed.
+        return index > 0 && AddPlaceholder(end, index - 1);
+      }
+      case '?':
+        if (!mysql()) {
+          return false;
+        }
+        return AddPlaceholder(pos_ + 1, num_generic_placeholders_++);
+      case '@': {
+        // MySQL variables are left as is.
+        if (!mysql()) {
+          return false;
+        }
+        size_t end = pos_ + 1;
+        if (At(end) == '@') {
+          ++end;
+        }
+        const size_t name_begin = end;
+        while (end < sql_.size() && (IsWordChar(sql_[end]) || sql_[end] == '.')) {
+          ++end;
+        }
+        if (end == name_begin) {
+          return false;
+        }
+        AddToken(end, TokenKind::kOperand);
+        return true;
+      }
+      case '(':
+        ++depth_;
+        AddToken(pos_ + 1, TokenKind::kOpenParen);
+        return true;
+      case ')':
+        if (--depth_ < 0) {
+          return false;
+        }
+        AddToken(pos_ + 1, TokenKind::kCloseParen);
+        return true;
+      case '.':
+        AddToken(pos_ + 1, TokenKind::kDot);
+        return true;
+      case ';':
+        ended_ = true;
+        ++pos_;
+        return true;
+      case '-': {
+        // JSON operators are followed by paths, which aren't constants.
+        if (At(pos_ + 1) == '>') {
+          return false;
+        }
+        // MySQL considers the sign of a negative number part of the constant.
+        size_t next = pos_ + 1;
+        while (IsSpace(At(next))) {
+          ++next;
+        }
+        if (mysql() && IsExpressionStart() &&
+            (IsDigit(At(next)) || (At(next) == '.' && IsDigit(At(next + 1))))) {
+          return false;
+        }
+        AddToken(pos_ + 1, TokenKind::kOperator);
+        return true;
+      }
+      case '=':
+      case '<':
+      case '>':
+      case '!':
+      case '+':
+      case '*':
+      case '/':
+      case '%':
+      case '|':
+      case '&':
+      case '^':
+      case '~':
+      case ',':
+        AddToken(pos_ + 1, TokenKind::kOperator);
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  const Dialect dialect_;
+  const std::string_view sql_;
+  const std::vector<std::string>& param_values_;
+
+  // The position of the next token, and of the first character that hasn't been copied to the
+  // normalized query yet.
+  size_t pos_ = 0;
+  size_t copied_ = 0;
+
+  TokenKind prev_ = TokenKind::kNone;
+  // The upper case text of the current word, and the previous two words if they were the previous
+  // tokens.
+  std::string word_;
+  std::string prev_word_;
+  std::string prev_prev_word_;
+
+  bool started_ = false;
+  bool ended_ = false;
+  int depth_ = 0;
+  size_t num_generic_placeholders_ = 0;
+  NormalizeResult result_;
+};
+
+}  // namespace
+
+std::optional<NormalizeResult> lex_normalize_pgsql(std::string_view sql,
+                                                   const std::vector<std::string>& param_values) {
+  return LexerNormalizer(Dialect::kPostgres, sql, param_values).Normalize();
+}
+
+std::optional<NormalizeResult> lex_normalize_mysql(std::string_view sql,
+                                                   const std::vector<std::string>& param_values) {
+  return LexerNormalizer(Dialect::kMySQL, sql, param_values).Normalize();
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
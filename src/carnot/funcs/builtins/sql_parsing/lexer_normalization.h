@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+/**
+ * lex_normalize_pgsql and lex_normalize_mysql normalize the same way as normalize_pgsql and
+ * normalize_mysql, but with a single pass of a lexer instead of building a parse tree. A lexer
+ * can't tell the constants of the grammar apart from other literals, like numbers in a LIMIT or
+ * in a type, so they only handle DML statements where every literal follows an operator or a
+ * keyword that starts an expression.
+ * @return the normalization result, or std::nullopt if the query has to be normalized by the
+ * parser instead, because it has a construct the lexer doesn't handle or it may be invalid.
+ */
+std::optional<NormalizeResult> lex_normalize_pgsql(std::string_view sql,
+                                                   const std::vector<std::string>& param_values);
+
+std::optional<NormalizeResult> lex_normalize_mysql(std::string_view sql,
+                                                   const std::vector<std::string>& param_values);
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
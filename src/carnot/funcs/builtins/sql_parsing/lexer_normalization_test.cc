@@ -0,0 +1,201 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/lexer_normalization.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+struct LexNormSQLTestCase {
+  std::string input_sql_str;
+  std::vector<std::string> input_params;
+  NormalizeResult expected_result;
+};
+
+// The expected results are the same as those of the parser in normalization_test.cc.
+class LexNormPGSQLTest : public testing::TestWithParam<LexNormSQLTestCase> {};
+
+TEST_P(LexNormPGSQLTest, basic) {
+  auto test_case = GetParam();
+  auto result = lex_normalize_pgsql(test_case.input_sql_str, test_case.input_params);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->normalized_query, test_case.expected_result.normalized_query);
+  EXPECT_EQ(result->params, test_case.expected_result.params);
+  EXPECT_EQ(result->errmsg, "");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    LexNormPGSQLVariants, LexNormPGSQLTest,
+    testing::Values(
+        LexNormSQLTestCase{"SELECT 1", {}, NormalizeResult{"SELECT $1", {"1"}, {}}},
+        LexNormSQLTestCase{
+            "SELECT * FROM test WHERE prop=1234 AND prop2='abcd'",
+            {},
+            NormalizeResult{"SELECT * FROM test WHERE prop=$1 AND prop2=$2", {"1234", "'abcd'"}},
+        },
+        LexNormSQLTestCase{
+            "UPDATE test SET age=10 where name='abcd'",
+            {},
+            NormalizeResult{"UPDATE test SET age=$1 where name=$2", {"10", "'abcd'"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT * from test where abcd >= 11",
+            {},
+            NormalizeResult{"SELECT * from test where abcd >= $1", {"11"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT 'abcd' as col1, 1234 as col2, 1.2345 as col3 into my_new_table",
+            {},
+            NormalizeResult{"SELECT $1 as col1, $2 as col2, $3 as col3 into my_new_table",
+                            {"'abcd'", "1234", "1.2345"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT length(abcd) + 1 from test",
+            {},
+            NormalizeResult{"SELECT length(abcd) + $1 from test", {"1"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT * from test WHERE name=$1 AND tag=1234 AND property=$1",
+            {"'abcd'"},
+            NormalizeResult{"SELECT * from test WHERE name=$1 AND tag=$2 AND property=$3",
+                            {"'abcd'", "1234", "'abcd'"}},
+        },
+        LexNormSQLTestCase{
+            R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, E'\\xDEADBEEF'))",
+            {},
+            NormalizeResult{"INSERT INTO test (a, b, c, d, e) VALUES ($1, $2, $3, $4, $5)",
+                            {"1", "'abcd'", "1.23", "true", R"(E'\\xDEADBEEF')"}},
+        },
+        // Literals in comments and quoted identifiers are left as is.
+        LexNormSQLTestCase{
+            "/* app 1 */ SELECT \"col 1\" FROM t WHERE a = 'it''s' AND b IS NOT NULL -- 2",
+            {},
+            NormalizeResult{
+                "/* app 1 */ SELECT \"col 1\" FROM t WHERE a = $1 AND b IS NOT NULL -- 2",
+                {"'it''s'"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT * FROM t WHERE a IN (1, 2) AND b = -1.5e3;",
+            {},
+            NormalizeResult{"SELECT * FROM t WHERE a IN ($1, $2) AND b = -$3;",
+                            {"1", "2", "1.5e3"}},
+        }));
+
+class LexNormMySQLTest : public testing::TestWithParam<LexNormSQLTestCase> {};
+
+TEST_P(LexNormMySQLTest, basic) {
+  auto test_case = GetParam();
+  auto result = lex_normalize_mysql(test_case.input_sql_str, test_case.input_params);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->normalized_query, test_case.expected_result.normalized_query);
+  EXPECT_EQ(result->params, test_case.expected_result.params);
+  EXPECT_EQ(result->errmsg, "");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    LexNormMySQLVariants, LexNormMySQLTest,
+    testing::Values(
+        LexNormSQLTestCase{"SELECT 1", {}, NormalizeResult{"SELECT ?", {"1"}, {}}},
+        LexNormSQLTestCase{
+            "SELECT * FROM test WHERE prop=1234 AND prop2='abcd'",
+            {},
+            NormalizeResult{"SELECT * FROM test WHERE prop=? AND prop2=?", {"1234", "'abcd'"}},
+        },
+        LexNormSQLTestCase{
+            "UPDATE test SET age=10 where name='abcd'",
+            {},
+            NormalizeResult{"UPDATE test SET age=? where name=?", {"10", "'abcd'"}},
+        },
+        LexNormSQLTestCase{
+            "INSERT INTO my_new_table SELECT 'abcd' as col1, 1234 as col2, 1.2345 as col3",
+            {},
+            NormalizeResult{"INSERT INTO my_new_table SELECT ? as col1, ? as col2, ? as col3",
+                            {"'abcd'", "1234", "1.2345"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT * from test WHERE name=? AND tag=1234 AND property=?",
+            {"'abcd'", "1.23"},
+            NormalizeResult{"SELECT * from test WHERE name=? AND tag=? AND property=?",
+                            {"'abcd'", "1234", "1.23"}},
+        },
+        LexNormSQLTestCase{
+            R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, X'DEADBEEF'))",
+            {},
+            NormalizeResult{"INSERT INTO test (a, b, c, d, e) VALUES (?, ?, ?, ?, ?)",
+                            {"1", "'abcd'", "1.23", "true", "X'DEADBEEF'"}},
+        },
+        // MySQL strings can be double quoted and have backslash escapes, and NULL is a constant.
+        LexNormSQLTestCase{
+            R"(SELECT `a` FROM t WHERE b = "x\"y" AND c = NULL AND d = @v # 1)",
+            {},
+            NormalizeResult{R"(SELECT `a` FROM t WHERE b = ? AND c = ? AND d = @v # 1)",
+                            {R"("x\"y")", "NULL"}},
+        },
+        LexNormSQLTestCase{
+            "SELECT sock.sock_id FROM sock WHERE sock.sock_id =abcde GROUP BY sock.sock_id",
+            {},
+            NormalizeResult{
+                "SELECT sock.sock_id FROM sock WHERE sock.sock_id =abcde GROUP BY sock.sock_id",
+                {}},
+        }));
+
+class LexNormFallbackTest : public testing::TestWithParam<std::string> {};
+
+// These are left to the parser.
+TEST_P(LexNormFallbackTest, pgsql) {
+  EXPECT_FALSE(lex_normalize_pgsql(GetParam(), {}).has_value());
+}
+
+TEST_P(LexNormFallbackTest, mysql) {
+  EXPECT_FALSE(lex_normalize_mysql(GetParam(), {}).has_value());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    LexNormFallbackVariants, LexNormFallbackTest,
+    testing::Values(
+        // Not DML.
+        "BEGIN;", "CREATE TABLE test (name varchar(20), address text, foo int, bar text)",
+        // Numbers that aren't constants.
+        "SELECT * FROM t LIMIT 10", "SELECT CAST(a AS CHAR(10)) FROM t",
+        // Literals that don't follow an operator or keyword that starts an expression.
+        "SELECT a AS 'alias' FROM t", "SELECT DATE '2020-01-01'", "SELECT 'a' 'b'",
+        "SELECT * FROM t WHERE a = 1abc",
+        // Invalid or incomplete.
+        "SELECT * FROM t WHERE a = 'abc", "SELECT * FROM t WHERE (a = 1", "SELECT * FROM t WHERE",
+        "SELECT 1; SELECT 2",
+        // Placeholders without values.
+        "SELECT * FROM t WHERE a = $1 OR a = ?"));
+
+TEST(LexNormMySQL, negative_numbers_are_left_to_the_parser) {
+  EXPECT_FALSE(lex_normalize_mysql("SELECT * FROM t WHERE a = -1", {}).has_value());
+  auto result = lex_normalize_mysql("SELECT a - 1 FROM t", {});
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ("SELECT a - ? FROM t", result->normalized_query);
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -17,11 +17,13 @@
  */
 
 #include <string>
+#include <utility>
 
 #include "mysql_parser/MySQLLexer.h"
 #include "mysql_parser/MySQLParser.h"
 #include "pgsql_parser/PostgresSQLLexer.h"
 #include "pgsql_parser/PostgresSQLParser.h"
+#include "src/carnot/funcs/builtins/sql_parsing/lexer_normalization.h"
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
 #include "src/common/base/logging.h"
 #include "src/common/base/statusor.h"
@@ -126,12 +128,18 @@ void SQLFragmentHandler::ReplaceFragmentWithPlaceholder(const SQLFragment& fragm
 
 StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
                                           const std::vector<std::string>& param_values) {
+  if (auto result = lex_normalize_pgsql(sql, param_values)) {
+    return std::move(*result);
+  }
   return normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(
       sql, param_values);
 }
 
 StatusOr<NormalizeResult> normalize_mysql(std::string sql,
                                           const std::vector<std::string>& param_values) {
+  if (auto result = lex_normalize_mysql(sql, param_values)) {
+    return std::move(*result);
+  }
   return normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
       sql, param_values);
 }
@@ -266,6 +266,10 @@ StatusOr<NormalizeResult> normalize_sql(std::string sql,
   return result;
 }
 
+/**
+ * normalize_pgsql and normalize_mysql normalize the query with the lexer if they can, and with the
+ * parser otherwise. See lex_normalize_pgsql.
+ */
 StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
                                           const std::vector<std::string>& param_values);
 
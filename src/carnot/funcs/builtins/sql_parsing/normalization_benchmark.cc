@@ -36,6 +36,31 @@ static void BM_NormalizeMySQL(benchmark::State& state, std::string query) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizePgSQLWithParser(benchmark::State& state, std::string query) {
+  using px::carnot::builtins::sql_parsing::normalize_sql;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(query, {}));
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizeMySQLWithParser(benchmark::State& state, std::string query) {
+  using px::carnot::builtins::sql_parsing::normalize_sql;
+  using px::carnot::builtins::sql_parsing::UpperCaseCharStream;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
+            query, {}));
+  }
+}
+
+BENCHMARK_CAPTURE(BM_NormalizePgSQLWithParser, select,
+                  "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
+BENCHMARK_CAPTURE(BM_NormalizeMySQLWithParser, select,
+                  "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
+
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select,
                   "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select_1, "SELECT 1");
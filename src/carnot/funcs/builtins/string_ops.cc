@@ -17,6 +17,9 @@
  */
 
 #include "src/carnot/funcs/builtins/string_ops.h"
+
+#include <cstring>
+
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
@@ -24,6 +27,69 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+size_t SubstringSearcher::Find(std::string_view haystack) const {
+  const size_t n = needle_.size();
+  if (n == 0) {
+    return 0;
+  }
+  if (haystack.size() < n) {
+    return std::string_view::npos;
+  }
+
+  const char first = needle_.front();
+  const char last = needle_.back();
+  const char* begin = haystack.data();
+  // The last position where the needle could start, plus one.
+  const char* end = begin + haystack.size() - n + 1;
+  for (const char* pos = begin; pos < end; ++pos) {
+    pos = static_cast<const char*>(memchr(pos, first, end - pos));
+    if (pos == nullptr) {
+      return std::string_view::npos;
+    }
+    if (n == 1 || (pos[n - 1] == last && memcmp(pos + 1, needle_.data() + 1, n - 2) == 0)) {
+      return pos - begin;
+    }
+  }
+  return std::string_view::npos;
+}
+
+void ASCIIToLower(const char* src, size_t size, char* dst) {
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t c = src[i];
+    dst[i] = c + ((static_cast<uint8_t>(c - 'A') < 26) << 5);
+  }
+}
+
+void ASCIIToUpper(const char* src, size_t size, char* dst) {
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t c = src[i];
+    dst[i] = c - ((static_cast<uint8_t>(c - 'a') < 26) << 5);
+  }
+}
+
+Status ConvertASCIICaseBatch(size_t count, const arrow::StringArray* in,
+                             void (*convert)(const char*, size_t, char*), std::string* buffer,
+                             arrow::StringBuilder* out) {
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  if (count == 0) {
+    return Status::OK();
+  }
+
+  // The strings of the array are contiguous, so they are all converted in one pass.
+  const int32_t begin = in->value_offset(0);
+  const size_t size = in->value_offset(count) - begin;
+  PL_RETURN_IF_ERROR(out->ReserveData(size));
+  buffer->resize(size);
+  if (size > 0) {
+    convert(reinterpret_cast<const char*>(in->value_data()->data()) + begin, size,
+            buffer->data());
+  }
+  for (size_t idx = 0; idx < count; ++idx) {
+    out->UnsafeAppend(buffer->data() + (in->value_offset(idx) - begin), in->value_length(idx));
+  }
+  return Status::OK();
+}
+
 void RegisterStringOpsOrDie(udf::Registry* registry) {
   CHECK(registry != nullptr);
   /*****************************************
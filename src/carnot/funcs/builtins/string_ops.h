@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <arrow/builder.h>
+
 #include <absl/strings/strip.h>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -29,12 +32,56 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * Finds a needle in strings. Candidates for the first byte of the needle are found with memchr,
+ * which libc vectorizes, and the last byte is compared before the rest, so that most candidates
+ * are rejected without comparing the whole needle.
+ */
+class SubstringSearcher {
+ public:
+  std::string_view needle() const { return needle_; }
+  void set_needle(std::string_view needle) { needle_.assign(needle); }
+
+  // Returns the position of the first occurrence of the needle, or std::string_view::npos.
+  size_t Find(std::string_view haystack) const;
+
+ private:
+  std::string needle_;
+};
+
+/**
+ * Converts the ASCII letters of the size bytes at src to lower (or upper) case, into dst.
+ * The conversion is branchless, so the compiler vectorizes it. dst may be the same as src.
+ */
+void ASCIIToLower(const char* src, size_t size, char* dst);
+void ASCIIToUpper(const char* src, size_t size, char* dst);
+
+inline std::string_view GetStringView(const arrow::StringArray* arr, size_t idx) {
+  int32_t length = 0;
+  const uint8_t* data = arr->GetValue(idx, &length);
+  return std::string_view(reinterpret_cast<const char*>(data), length);
+}
+
 class ContainsUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, StringValue b1, StringValue b2) {
     return absl::StrContains(b1, b2);
   }
 
+  // Same as Exec for every record, but the strings are searched in place in the arrow buffers.
+  Status ExecBatch(FunctionContext*, size_t count, arrow::BooleanBuilder* out,
+                   const arrow::StringArray* b1, const arrow::StringArray* b2) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      std::string_view needle = GetStringView(b2, idx);
+      if (needle != searcher_.needle()) {
+        searcher_.set_needle(needle);
+      }
+      out->UnsafeAppend(searcher_.Find(GetStringView(b1, idx)) != std::string_view::npos);
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the first string contains the second string.")
         .Example("matching_df = matching_df[px.contains(matching_df.svc_names, 'my_svc')]")
@@ -42,6 +89,9 @@ class ContainsUDF : public udf::ScalarUDF {
         .Arg("arg2", "The string that should be contained in the first string.")
         .Returns("A boolean of whether the first string contains the second string.");
   }
+
+ private:
+  SubstringSearcher searcher_;
 };
 
 class LengthUDF : public udf::ScalarUDF {
@@ -63,6 +113,21 @@ class FindUDF : public udf::ScalarUDF {
     return src.find(substr);
   }
 
+  // Same as Exec for every record, but the strings are searched in place in the arrow buffers.
+  Status ExecBatch(FunctionContext*, size_t count, arrow::Int64Builder* out,
+                   const arrow::StringArray* src, const arrow::StringArray* substr) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      std::string_view needle = GetStringView(substr, idx);
+      if (needle != searcher_.needle()) {
+        searcher_.set_needle(needle);
+      }
+      // Like Exec, npos converts to -1.
+      out->UnsafeAppend(static_cast<int64_t>(searcher_.Find(GetStringView(src, idx))));
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Find the index of the first occurrence of the substring.")
         .Details(
@@ -74,6 +139,9 @@ class FindUDF : public udf::ScalarUDF {
         .Arg("arg2", "The substring to find.")
         .Returns("The index of the first occurence of the substring. -1 if no match is found.");
   }
+
+ private:
+  SubstringSearcher searcher_;
 };
 
 class SubstringUDF : public udf::ScalarUDF {
@@ -102,12 +170,25 @@ class SubstringUDF : public udf::ScalarUDF {
   }
 };
 
+/**
+ * Converts the case of all the strings of the array at once, into one buffer that is sized for the
+ * largest batch, and appends the converted strings to the output from there.
+ */
+Status ConvertASCIICaseBatch(size_t count, const arrow::StringArray* in,
+                             void (*convert)(const char*, size_t, char*), std::string* buffer,
+                             arrow::StringBuilder* out);
+
 class ToLowerUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue b1) {
-    transform(b1.begin(), b1.end(), b1.begin(), ::tolower);
+    ASCIIToLower(b1.data(), b1.size(), b1.data());
     return b1;
   }
+
+  Status ExecBatch(FunctionContext*, size_t count, arrow::StringBuilder* out,
+                   const arrow::StringArray* b1) {
+    return ConvertASCIICaseBatch(count, b1, ASCIIToLower, &buffer_, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all uppercase ascii characters in the string to lowercase.")
@@ -117,14 +198,22 @@ class ToLowerUDF : public udf::ScalarUDF {
         .Arg("string", "The string to transform.")
         .Returns("`string` with all uppercase ascii converted to lowercase.");
   }
+
+ private:
+  std::string buffer_;
 };
 
 class ToUpperUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue b1) {
-    transform(b1.begin(), b1.end(), b1.begin(), ::toupper);
+    ASCIIToUpper(b1.data(), b1.size(), b1.data());
     return b1;
   }
+
+  Status ExecBatch(FunctionContext*, size_t count, arrow::StringBuilder* out,
+                   const arrow::StringArray* b1) {
+    return ConvertASCIICaseBatch(count, b1, ASCIIToUpper, &buffer_, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all lowercase ascii characters in the string to uppercase.")
@@ -134,6 +223,9 @@ class ToUpperUDF : public udf::ScalarUDF {
         .Arg("string", "The string to transform.")
         .Returns("`string` with all lowercase ascii converted to uppercase.");
   }
+
+ private:
+  std::string buffer_;
 };
 
 class TrimUDF : public udf::ScalarUDF {
@@ -143,6 +235,19 @@ class TrimUDF : public udf::ScalarUDF {
     absl::StripAsciiWhitespace(&val);
     return val;
   }
+
+  // Same as Exec for every record, but the trimmed strings are appended straight from the arrow
+  // buffers, without a copy of each string.
+  Status ExecBatch(FunctionContext*, size_t count, arrow::StringBuilder* out,
+                   const arrow::StringArray* s) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    PL_RETURN_IF_ERROR(out->ReserveData(s->value_offset(count) - s->value_offset(0)));
+    for (size_t idx = 0; idx < count; ++idx) {
+      std::string_view val = absl::StripAsciiWhitespace(GetStringView(s, idx));
+      out->UnsafeAppend(val.data(), static_cast<int32_t>(val.size()));
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Trim ascii whitespace from before and after the string content.")
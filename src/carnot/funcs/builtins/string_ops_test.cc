@@ -24,6 +24,7 @@
 #include "src/carnot/funcs/builtins/string_ops.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
 
 namespace px {
 namespace carnot {
@@ -112,6 +113,39 @@ TEST(StringOps, StringToInt) {
   udf_tester.ForInput("+1111111", -1).Expect(1111111);
 }
 
+TEST(StringOps, exec_batch_matches_exec) {
+  auto ctx = udf::FunctionContext(nullptr, nullptr);
+  std::vector<types::StringValue> strs = {"/api/v1/Users", "", " /healthz\t", "apapi", "API"};
+  std::vector<types::StringValue> needles = {"/api", "/api", "/api", "api", ""};
+
+  ContainsUDF contains;
+  auto contains_res =
+      udf::ExecArrow<ContainsUDF, arrow::BooleanBuilder>(&contains, strs, needles);
+  FindUDF find;
+  auto find_res = udf::ExecArrow<FindUDF, arrow::Int64Builder>(&find, strs, needles);
+  ToLowerUDF to_lower;
+  auto lower_res = udf::ExecArrow<ToLowerUDF, arrow::StringBuilder>(&to_lower, strs);
+  ToUpperUDF to_upper;
+  auto upper_res = udf::ExecArrow<ToUpperUDF, arrow::StringBuilder>(&to_upper, strs);
+  TrimUDF trim;
+  auto trim_res = udf::ExecArrow<TrimUDF, arrow::StringBuilder>(&trim, strs);
+
+  for (size_t i = 0; i < strs.size(); ++i) {
+    EXPECT_EQ(contains.Exec(&ctx, strs[i], needles[i]).val,
+              static_cast<arrow::BooleanArray*>(contains_res.get())->Value(i));
+    EXPECT_EQ(find.Exec(&ctx, strs[i], needles[i]).val,
+              static_cast<arrow::Int64Array*>(find_res.get())->Value(i));
+    EXPECT_EQ(to_lower.Exec(&ctx, strs[i]),
+              static_cast<arrow::StringArray*>(lower_res.get())->GetString(i));
+    EXPECT_EQ(to_upper.Exec(&ctx, strs[i]),
+              static_cast<arrow::StringArray*>(upper_res.get())->GetString(i));
+    EXPECT_EQ(trim.Exec(&ctx, strs[i]),
+              static_cast<arrow::StringArray*>(trim_res.get())->GetString(i));
+  }
+  EXPECT_EQ("/api/v1/users", static_cast<arrow::StringArray*>(lower_res.get())->GetString(0));
+  EXPECT_EQ(2, static_cast<arrow::Int64Array*>(find_res.get())->Value(3));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -24,9 +24,13 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/numeric/int128.h>
+
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/type_inference.h"
 #include "src/shared/metadata/metadata_state.h"
@@ -62,6 +66,64 @@ inline const px::md::AgentMetadataState* GetMetadataState(px::carnot::udf::Funct
   return md;
 }
 
+/**
+ * MemoizedMetadataUDF provides the batch ExecVector for UDFs that look up the metadata of a
+ * single key, such as a UPID or a pod ID. A batch usually has only a few distinct keys, so it
+ * calls the UDF's Exec once per distinct key and copies the result to the other rows.
+ *
+ * The results are kept across batches. They stay valid as long as the metadata state is the
+ * same, which it is for the lifetime of a function context.
+ */
+template <typename TUDF, typename TArg>
+class MemoizedMetadataUDF : public ScalarUDF {
+ public:
+  void ExecVector(FunctionContext* ctx, size_t count, StringValue* out, const TArg* args) {
+    const px::md::AgentMetadataState* md = GetMetadataState(ctx);
+    if (md != cache_md_ || cache_.size() >= kMaxCacheSize) {
+      cache_.clear();
+      cache_md_ = md;
+    }
+
+    for (size_t idx = 0; idx < count; ++idx) {
+      // Rows of the same process are often next to each other.
+      if (idx > 0 && args[idx] == args[idx - 1]) {
+        out[idx] = out[idx - 1];
+        continue;
+      }
+      const CacheKey& key = ToCacheKey(args[idx]);
+      auto it = cache_.find(key);
+      if (it == cache_.end()) {
+        it = cache_.emplace(key, static_cast<TUDF*>(this)->Exec(ctx, args[idx])).first;
+      }
+      out[idx] = it->second;
+    }
+  }
+
+ private:
+  // Bounds the memory of the cache, for queries over many distinct keys.
+  static constexpr size_t kMaxCacheSize = 4096;
+
+  using CacheKey =
+      std::conditional_t<std::is_same_v<TArg, types::UInt128Value>, absl::uint128, std::string>;
+
+  static const CacheKey& ToCacheKey(const TArg& arg) {
+    if constexpr (std::is_same_v<TArg, types::UInt128Value>) {
+      return arg.val;
+    } else {
+      return arg;
+    }
+  }
+
+  const px::md::AgentMetadataState* cache_md_ = nullptr;
+  absl::flat_hash_map<CacheKey, StringValue> cache_;
+};
+
+template <typename TUDF>
+using MemoizedUPIDUDF = MemoizedMetadataUDF<TUDF, types::UInt128Value>;
+
+template <typename TUDF>
+using MemoizedStringUDF = MemoizedMetadataUDF<TUDF, types::StringValue>;
+
 class ASIDUDF : public ScalarUDF {
  public:
   Int64Value Exec(FunctionContext* ctx) {
@@ -97,7 +159,7 @@ class UPIDToASIDUDF : public ScalarUDF {
   }
 };
 
-class PodIDToPodNameUDF : public ScalarUDF {
+class PodIDToPodNameUDF : public MemoizedStringUDF<PodIDToPodNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
@@ -121,7 +183,7 @@ class PodIDToPodNameUDF : public ScalarUDF {
   }
 };
 
-class PodNameToPodIDUDF : public ScalarUDF {
+class PodNameToPodIDUDF : public MemoizedStringUDF<PodNameToPodIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
@@ -144,7 +206,7 @@ class PodNameToPodIDUDF : public ScalarUDF {
   }
 };
 
-class PodNameToPodIPUDF : public ScalarUDF {
+class PodNameToPodIPUDF : public MemoizedStringUDF<PodNameToPodIPUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
@@ -165,7 +227,7 @@ class PodNameToPodIPUDF : public ScalarUDF {
   }
 };
 
-class PodIDToNamespaceUDF : public ScalarUDF {
+class PodIDToNamespaceUDF : public MemoizedStringUDF<PodIDToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
@@ -190,7 +252,7 @@ class PodIDToNamespaceUDF : public ScalarUDF {
   }
 };
 
-class PodNameToNamespaceUDF : public ScalarUDF {
+class PodNameToNamespaceUDF : public MemoizedStringUDF<PodNameToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext*, StringValue pod_name) {
     // This UDF expects the pod name to be in the format of "<ns>/<pod-name>".
@@ -211,7 +273,7 @@ class PodNameToNamespaceUDF : public ScalarUDF {
   }
 };
 
-class UPIDToContainerIDUDF : public ScalarUDF {
+class UPIDToContainerIDUDF : public MemoizedUPIDUDF<UPIDToContainerIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -252,7 +314,7 @@ inline const md::ContainerInfo* UPIDToContainer(const px::md::AgentMetadataState
   return md->k8s_metadata_state().ContainerInfoByID(pid->cid());
 }
 
-class UPIDToContainerNameUDF : public ScalarUDF {
+class UPIDToContainerNameUDF : public MemoizedUPIDUDF<UPIDToContainerNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -317,7 +379,7 @@ inline types::StringValue StringifyVector(const std::vector<std::string>& vec) {
   return "";
 }
 
-class UPIDToNamespaceUDF : public ScalarUDF {
+class UPIDToNamespaceUDF : public MemoizedUPIDUDF<UPIDToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -349,7 +411,7 @@ class UPIDToNamespaceUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodIDUDF : public ScalarUDF {
+class UPIDToPodIDUDF : public MemoizedUPIDUDF<UPIDToPodIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -376,7 +438,7 @@ class UPIDToPodIDUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodNameUDF : public ScalarUDF {
+class UPIDToPodNameUDF : public MemoizedUPIDUDF<UPIDToPodNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -407,7 +469,7 @@ class UPIDToPodNameUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class ServiceIDToServiceNameUDF : public ScalarUDF {
+class ServiceIDToServiceNameUDF : public MemoizedStringUDF<ServiceIDToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue service_id) {
     auto md = GetMetadataState(ctx);
@@ -435,7 +497,7 @@ class ServiceIDToServiceNameUDF : public ScalarUDF {
   }
 };
 
-class ServiceIDToClusterIPUDF : public ScalarUDF {
+class ServiceIDToClusterIPUDF : public MemoizedStringUDF<ServiceIDToClusterIPUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue service_id) {
     auto md = GetMetadataState(ctx);
@@ -483,7 +545,7 @@ class ServiceIDToExternalIPsUDF : public ScalarUDF {
   }
 };
 
-class ServiceNameToServiceIDUDF : public ScalarUDF {
+class ServiceNameToServiceIDUDF : public MemoizedStringUDF<ServiceNameToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue service_name) {
     auto md = GetMetadataState(ctx);
@@ -506,7 +568,7 @@ class ServiceNameToServiceIDUDF : public ScalarUDF {
 /**
  * @brief Returns the namespace for a service.
  */
-class ServiceNameToNamespaceUDF : public ScalarUDF {
+class ServiceNameToNamespaceUDF : public MemoizedStringUDF<ServiceNameToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext*, StringValue service_name) {
     // This UDF expects the service name to be in the format of "<ns>/<svc-name>".
@@ -535,7 +597,7 @@ class ServiceNameToNamespaceUDF : public ScalarUDF {
 /**
  * @brief Returns the service ids for services that are currently running.
  */
-class UPIDToServiceIDUDF : public ScalarUDF {
+class UPIDToServiceIDUDF : public MemoizedUPIDUDF<UPIDToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -577,7 +639,7 @@ class UPIDToServiceIDUDF : public ScalarUDF {
 /**
  * @brief Returns the service names for services that are currently running.
  */
-class UPIDToServiceNameUDF : public ScalarUDF {
+class UPIDToServiceNameUDF : public MemoizedUPIDUDF<UPIDToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -623,7 +685,7 @@ class UPIDToServiceNameUDF : public ScalarUDF {
 /**
  * @brief Returns the node name for the pod associated with the input upid.
  */
-class UPIDToNodeNameUDF : public ScalarUDF {
+class UPIDToNodeNameUDF : public MemoizedUPIDUDF<UPIDToNodeNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -655,7 +717,7 @@ class UPIDToNodeNameUDF : public ScalarUDF {
 /**
  * @brief Returns the hostname for the pod associated with the input upid.
  */
-class UPIDToHostnameUDF : public ScalarUDF {
+class UPIDToHostnameUDF : public MemoizedUPIDUDF<UPIDToHostnameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -683,7 +745,7 @@ class UPIDToHostnameUDF : public ScalarUDF {
 /**
  * @brief Returns the service names for the given pod ID.
  */
-class PodIDToServiceNameUDF : public ScalarUDF {
+class PodIDToServiceNameUDF : public MemoizedStringUDF<PodIDToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
@@ -725,7 +787,7 @@ class PodIDToServiceNameUDF : public ScalarUDF {
 /**
  * @brief Returns the service ids for the given pod ID.
  */
-class PodIDToServiceIDUDF : public ScalarUDF {
+class PodIDToServiceIDUDF : public MemoizedStringUDF<PodIDToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
@@ -761,7 +823,7 @@ class PodIDToServiceIDUDF : public ScalarUDF {
 /**
  * @brief Returns the Node Name of a pod ID passed in.
  */
-class PodIDToNodeNameUDF : public ScalarUDF {
+class PodIDToNodeNameUDF : public MemoizedStringUDF<PodIDToNodeNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_id) {
     auto md = GetMetadataState(ctx);
@@ -790,7 +852,7 @@ class PodIDToNodeNameUDF : public ScalarUDF {
 /**
  * @brief Returns the service names for the given pod name.
  */
-class PodNameToServiceNameUDF : public ScalarUDF {
+class PodNameToServiceNameUDF : public MemoizedStringUDF<PodNameToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
@@ -836,7 +898,7 @@ class PodNameToServiceNameUDF : public ScalarUDF {
 /**
  * @brief Returns the service ids for the given pod name.
  */
-class PodNameToServiceIDUDF : public ScalarUDF {
+class PodNameToServiceIDUDF : public MemoizedStringUDF<PodNameToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_name) {
     auto md = GetMetadataState(ctx);
@@ -1317,7 +1379,7 @@ class ContainerIDToContainerStatusUDF : public ScalarUDF {
   }
 };
 
-class UPIDToPodStatusUDF : public ScalarUDF {
+class UPIDToPodStatusUDF : public MemoizedUPIDUDF<UPIDToPodStatusUDF> {
  public:
   /**
    * @brief Gets the Pod status for a passed in UPID.
@@ -1356,7 +1418,7 @@ class UPIDToPodStatusUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToCmdLineUDF : public ScalarUDF {
+class UPIDToCmdLineUDF : public MemoizedUPIDUDF<UPIDToCmdLineUDF> {
  public:
   /**
    * @brief Gets the cmdline for the upid.
@@ -1397,7 +1459,7 @@ inline std::string PodInfoToPodQoS(const px::md::PodInfo* pod_info) {
   return std::string(magic_enum::enum_name(pod_info->qos_class()));
 }
 
-class UPIDToPodQoSUDF : public ScalarUDF {
+class UPIDToPodQoSUDF : public MemoizedUPIDUDF<UPIDToPodQoSUDF> {
  public:
   /**
    * @brief Gets the qos for the upid's pod.
@@ -1464,7 +1526,7 @@ class HostNumCPUsUDF : public ScalarUDF {
   }
 };
 
-class IPToPodIDUDF : public ScalarUDF {
+class IPToPodIDUDF : public MemoizedStringUDF<IPToPodIDUDF> {
  public:
   /**
    * @brief Gets the pod id of pod with given pod_ip
@@ -1497,7 +1559,7 @@ class IPToPodIDUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_KELVIN; }
 };
 
-class IPToServiceIDUDF : public ScalarUDF {
+class IPToServiceIDUDF : public MemoizedStringUDF<IPToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue ip) {
     auto md = GetMetadataState(ctx);
@@ -613,6 +613,32 @@ TEST_F(MetadataOpsTest, pod_id_to_namespace_test) {
   udf_tester.ForInput("dne").Expect("");
 }
 
+TEST_F(MetadataOpsTest, memoized_exec_vector) {
+  auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
+  UPIDToPodNameUDF udf;
+  static_assert(udf::ScalarUDFTraits<UPIDToPodNameUDF>::HasExecVector());
+
+  auto upid1 = types::UInt128Value(528280977975, 89101);
+  auto upid2 = types::UInt128Value(528280977975, 468);
+  auto upid3 = types::UInt128Value(528280977975, 123);
+  std::vector<types::UInt128Value> upids = {upid1, upid1, upid2, upid3, upid1, upid2};
+  std::vector<types::StringValue> out(upids.size());
+
+  // The second batch reuses the results of the first one.
+  for (int batch = 0; batch < 2; ++batch) {
+    udf.ExecVector(function_ctx.get(), upids.size(), out.data(), upids.data());
+    EXPECT_THAT(out, ::testing::ElementsAre("pl/running_pod", "pl/running_pod",
+                                            "pl/terminating_pod", "", "pl/running_pod",
+                                            "pl/terminating_pod"));
+  }
+
+  PodIDToNamespaceUDF pod_udf;
+  std::vector<types::StringValue> pod_ids = {"1_uid", "dne", "1_uid"};
+  pod_udf.ExecVector(function_ctx.get(), pod_ids.size(), out.data(), pod_ids.data());
+  EXPECT_THAT(std::vector<types::StringValue>(out.begin(), out.begin() + pod_ids.size()),
+              ::testing::ElementsAre("pl", "", "pl"));
+}
+
 TEST_F(MetadataOpsTest, pod_name_to_namespace_test) {
   auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
   auto udf_tester = px::carnot::udf::UDFTester<PodNameToNamespaceUDF>(std::move(function_ctx));
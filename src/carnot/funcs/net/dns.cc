@@ -0,0 +1,189 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/net/dns.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include <cstring>
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+StatusOr<std::string> DNSLookup(const std::string& addr) {
+  struct sockaddr_in sa;
+
+  char node[kMaxHostnameSize];
+
+  memset(&sa, 0, sizeof sa);
+  sa.sin_family = AF_INET;
+
+  if (inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1) {
+    return error::InvalidArgument("Not an IPv4 address: $0", addr);
+  }
+
+  int res =
+      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+
+  if (res == EAI_NONAME) {
+    return error::NotFound("No hostname for $0", addr);
+  }
+  if (res) {
+    return error::Internal("Failed to resolve $0: $1", addr, gai_strerror(res));
+  }
+  return std::string(node);
+}
+
+DNSCache& DNSCache::GetInstance() {
+  // Never destroyed, so that exiting doesn't wait on the resolutions in flight.
+  static DNSCache* cache = new DNSCache(DNSLookup, Options());
+  return *cache;
+}
+
+DNSCache::DNSCache(Resolver resolver, const Options& options)
+    : resolver_(std::move(resolver)), options_(options), entries_(options.max_entries) {
+  for (size_t i = 0; i < options_.num_resolver_threads; ++i) {
+    resolver_threads_.emplace_back(&DNSCache::ResolveLoop, this);
+  }
+}
+
+DNSCache::~DNSCache() {
+  {
+    absl::MutexLock lock(&lock_);
+    stopping_ = true;
+  }
+  for (auto& thread : resolver_threads_) {
+    thread.join();
+  }
+}
+
+std::string DNSCache::Lookup(const std::string& addr) {
+  auto now = std::chrono::steady_clock::now();
+
+  absl::MutexLock lock(&lock_);
+  auto k8s_iter = k8s_hostnames_.find(addr);
+  if (k8s_iter != k8s_hostnames_.end()) {
+    return k8s_iter->second;
+  }
+
+  // A new address starts out expired, named by itself.
+  Entry entry = entries_.Get(addr).value_or(Entry{addr, now, false});
+  if (!entry.pending && now >= entry.expiry) {
+    // Until the address is resolved again, the previous hostname is kept.
+    entry.pending = true;
+    pending_.push_back(addr);
+    entries_.Put(addr, entry);
+  }
+  return entry.hostname;
+}
+
+void DNSCache::WarmFromMetadata(const md::AgentMetadataState& metadata_state) {
+  {
+    absl::MutexLock lock(&lock_);
+    if (metadata_state.epoch_id() == warmed_epoch_id_) {
+      return;
+    }
+  }
+
+  const md::K8sMetadataState& k8s_state = metadata_state.k8s_metadata_state();
+  absl::flat_hash_map<std::string, std::string> k8s_hostnames;
+  for (const auto& [ip, pod_id] : k8s_state.pods_by_ip()) {
+    const md::PodInfo* pod_info = k8s_state.PodInfoByID(pod_id);
+    if (pod_info == nullptr) {
+      continue;
+    }
+    // Pods name themselves by their hostname, which defaults to the pod name.
+    k8s_hostnames[ip] = pod_info->hostname().empty() ? pod_info->name() : pod_info->hostname();
+  }
+  for (const auto& [ip, service_id] : k8s_state.services_by_cluster_ip()) {
+    const md::ServiceInfo* service_info = k8s_state.ServiceInfoByID(service_id);
+    if (service_info == nullptr) {
+      continue;
+    }
+    k8s_hostnames[ip] = absl::Substitute("$0.$1.svc.$2", service_info->name(), service_info->ns(),
+                                         kClusterDomain);
+  }
+
+  absl::MutexLock lock(&lock_);
+  k8s_hostnames_ = std::move(k8s_hostnames);
+  warmed_epoch_id_ = metadata_state.epoch_id();
+}
+
+void DNSCache::WaitForPendingLookups() {
+  absl::MutexLock lock(&lock_);
+  lock_.Await(absl::Condition(this, &DNSCache::Idle));
+}
+
+void DNSCache::SetResolved(const std::string& addr, StatusOr<std::string> hostname,
+                           std::chrono::steady_clock::time_point now) {
+  // Nothing is updated if the address was evicted while it was resolved.
+  entries_.Update(addr, [&](Entry* entry) {
+    entry->pending = false;
+    if (hostname.ok()) {
+      entry->hostname = hostname.ConsumeValueOrDie();
+      entry->expiry = now + options_.ttl;
+    } else {
+      VLOG(1) << hostname.status().ToString();
+      entry->hostname = addr;
+      entry->expiry = now + options_.negative_ttl;
+    }
+  });
+}
+
+void DNSCache::ResolveLoop() {
+  std::vector<std::string> batch;
+  std::vector<StatusOr<std::string>> hostnames;
+  while (true) {
+    {
+      absl::MutexLock lock(&lock_);
+      lock_.Await(absl::Condition(this, &DNSCache::HasWork));
+      if (stopping_) {
+        return;
+      }
+      while (!pending_.empty() && batch.size() < options_.resolve_batch_size) {
+        batch.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+      num_resolving_ += batch.size();
+    }
+
+    for (const auto& addr : batch) {
+      hostnames.push_back(resolver_(addr));
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    absl::MutexLock lock(&lock_);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      SetResolved(batch[i], std::move(hostnames[i]), now);
+    }
+    num_resolving_ -= batch.size();
+    batch.clear();
+    hostnames.clear();
+  }
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
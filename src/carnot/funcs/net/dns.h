@@ -18,10 +18,19 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <string>
+#include <thread>
+#include <vector>
 
-#define TBB_PREVIEW_CONCURRENT_LRU_CACHE 1
-#include "tbb/concurrent_lru_cache.h"
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+#include "src/common/base/lru_cache.h"
+#include "src/shared/metadata/metadata_state.h"
 
 namespace px {
 namespace carnot {
@@ -32,39 +41,94 @@ namespace internal {
 constexpr size_t kMaxHostnameSize = 512;
 constexpr size_t kLRUCacheSize = 1024;
 
-inline std::string DNSLookup(const std::string& addr) {
-  struct sockaddr_in sa;
-
-  char node[kMaxHostnameSize];
-
-  memset(&sa, 0, sizeof sa);
-  sa.sin_family = AF_INET;
-
-  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
+// The DNS domain of the cluster, under which services are named.
+constexpr std::string_view kClusterDomain = "cluster.local";
 
-  int res =
-      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
-
-  if (res) {
-    return res == EAI_NONAME ? addr : gai_strerror(res);
-  }
-  return node;
-}
+/**
+ * Resolves the hostname of an IPv4 address with a reverse DNS lookup.
+ *
+ * @return NotFound if the address has no hostname, or an error if the lookup failed.
+ */
+StatusOr<std::string> DNSLookup(const std::string& addr);
 
+/**
+ * DNSCache caches the hostnames of IP addresses, and resolves them in the background, so that
+ * lookups never wait on DNS. Looking up an address that isn't resolved yet returns the address
+ * itself, and queues it for the resolver threads, which take the pending addresses in batches.
+ *
+ * Failed resolutions are cached for a shorter time, so that addresses without a hostname aren't
+ * resolved over and over. The IPs of pods and services are named from the K8s metadata instead,
+ * so cluster-internal IPs never reach DNS.
+ */
 class DNSCache {
  public:
-  static DNSCache& GetInstance() {
-    static DNSCache cache;
-    return cache;
+  using Resolver = std::function<StatusOr<std::string>(const std::string& addr)>;
+
+  struct Options {
+    size_t max_entries = kLRUCacheSize;
+    size_t num_resolver_threads = 4;
+    // The number of pending addresses that a resolver thread takes at a time.
+    size_t resolve_batch_size = 16;
+    std::chrono::seconds ttl{300};
+    std::chrono::seconds negative_ttl{30};
+  };
+
+  static DNSCache& GetInstance();
+
+  DNSCache(Resolver resolver, const Options& options);
+  ~DNSCache();
+
+  /**
+   * Returns the hostname of the address, or the address itself until it has been resolved.
+   */
+  std::string Lookup(const std::string& addr);
+
+  /**
+   * Names the IPs of the pods and services in the metadata, replacing the names from a previous
+   * warm. Does nothing if the metadata is of the epoch that was last warmed from.
+   */
+  void WarmFromMetadata(const md::AgentMetadataState& metadata_state);
+
+  /**
+   * Waits until all the pending addresses have been resolved. Meant for tests.
+   */
+  void WaitForPendingLookups();
+
+ private:
+  struct Entry {
+    std::string hostname;
+    std::chrono::steady_clock::time_point expiry;
+    // Whether the address is queued for, or in the middle of, a resolution.
+    bool pending = false;
+  };
+
+  void ResolveLoop();
+  void SetResolved(const std::string& addr, StatusOr<std::string> hostname,
+                   std::chrono::steady_clock::time_point now) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return !pending_.empty() || stopping_;
+  }
+  bool Idle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return pending_.empty() && num_resolving_ == 0;
   }
 
-  std::string Lookup(std::string addr) { return cache_[addr].value(); }
+  const Resolver resolver_;
+  const Options options_;
 
- private:
-  DNSCache()
-      : cache_([](std::string addr) -> std::string { return DNSLookup(addr); }, kLRUCacheSize) {}
+  absl::Mutex lock_;
+  // The entries are only changed while holding lock_, so that they stay in sync with pending_.
+  LRUCache<std::string, Entry> entries_;
+  std::deque<std::string> pending_ ABSL_GUARDED_BY(lock_);
+  size_t num_resolving_ ABSL_GUARDED_BY(lock_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(lock_) = false;
+
+  // The hostnames of the IPs of pods and services. They aren't subject to the LRU, since the
+  // metadata would just put them back.
+  absl::flat_hash_map<std::string, std::string> k8s_hostnames_ ABSL_GUARDED_BY(lock_);
+  uint64_t warmed_epoch_id_ ABSL_GUARDED_BY(lock_) = 0;
 
-  tbb::concurrent_lru_cache<std::string, std::string> cache_;
+  std::vector<std::thread> resolver_threads_;
 };
 
 }  // namespace internal
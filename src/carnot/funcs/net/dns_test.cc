@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+
+#include "src/carnot/funcs/net/dns.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+TEST(DNSCache, ResolvesInTheBackground) {
+  std::atomic<int> num_resolved = 0;
+  DNSCache cache(
+      [&num_resolved](const std::string& addr) -> StatusOr<std::string> {
+        ++num_resolved;
+        if (addr == "10.0.0.2") {
+          return error::NotFound("No hostname for $0", addr);
+        }
+        return absl::StrCat("host-", addr);
+      },
+      DNSCache::Options());
+
+  // Lookups return the address itself until it has been resolved.
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "10.0.0.1");
+  EXPECT_EQ(cache.Lookup("10.0.0.2"), "10.0.0.2");
+  // An address is only queued once.
+  cache.Lookup("10.0.0.1");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(num_resolved.load(), 2);
+
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "host-10.0.0.1");
+  // Failures are cached too, rather than resolved again.
+  EXPECT_EQ(cache.Lookup("10.0.0.2"), "10.0.0.2");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(num_resolved.load(), 2);
+}
+
+TEST(DNSCache, EvictsLeastRecentlyUsed) {
+  std::atomic<int> num_resolved = 0;
+  DNSCache::Options options;
+  options.max_entries = 2;
+  DNSCache cache(
+      [&num_resolved](const std::string& addr) -> StatusOr<std::string> {
+        ++num_resolved;
+        return absl::StrCat("host-", addr);
+      },
+      options);
+
+  cache.Lookup("10.0.0.1");
+  cache.Lookup("10.0.0.2");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "host-10.0.0.1");
+
+  // 10.0.0.2 is the least recently used, so it makes room for 10.0.0.3.
+  cache.Lookup("10.0.0.3");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "host-10.0.0.1");
+  EXPECT_EQ(cache.Lookup("10.0.0.3"), "host-10.0.0.3");
+  EXPECT_EQ(cache.Lookup("10.0.0.2"), "10.0.0.2");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(num_resolved.load(), 4);
+}
+
+TEST(DNSCache, ExpiredEntriesAreResolvedAgain) {
+  std::atomic<int> num_resolved = 0;
+  DNSCache::Options options;
+  options.ttl = std::chrono::seconds(0);
+  DNSCache cache(
+      [&num_resolved](const std::string& addr) -> StatusOr<std::string> {
+        return absl::StrCat("host-", addr, "-", ++num_resolved);
+      },
+      options);
+
+  cache.Lookup("10.0.0.1");
+  cache.WaitForPendingLookups();
+  // The previous hostname is kept until the address is resolved again.
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "host-10.0.0.1-1");
+  cache.WaitForPendingLookups();
+  EXPECT_EQ(cache.Lookup("10.0.0.1"), "host-10.0.0.1-2");
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
@@ -42,11 +42,19 @@ using ScalarUDF = px::carnot::udf::ScalarUDF;
 
 class NSLookupUDF : public ScalarUDF {
  public:
-  StringValue Exec(FunctionContext*, StringValue addr) { return cache_.Lookup(addr); }
+  StringValue Exec(FunctionContext* ctx, StringValue addr) {
+    if (ctx->metadata_state() != nullptr) {
+      cache_.WarmFromMetadata(*ctx->metadata_state());
+    }
+    return cache_.Lookup(addr);
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Perform a DNS lookup for the value (experimental).")
-        .Details("Experimental UDF to perform a DNS lookup for a given value.")
+        .Details(
+            "Experimental UDF to perform a DNS lookup for a given value. Lookups are resolved in "
+            "the background, and return the address itself until then. The IPs of pods and "
+            "services are named from the K8s metadata.")
         .Arg("addr", "An IP address")
         .Example("df.hostname = px.nslookup(df.ip_addr)")
         .Returns("The hostname.");
@@ -94,6 +94,90 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return plan, nil
 }
 
+// SetDistributedState replaces the distributed state that is kept by the planner, which
+// PlanWithStoredState plans against.
+func (cm GoPlanner) SetDistributedState(distributedState *distributedpb.DistributedState) error {
+	var resultLen C.int
+	stateBytes, err := proto.Marshal(distributedState)
+	if err != nil {
+		return err
+	}
+	stateData := C.CBytes(stateBytes)
+	defer C.free(stateData)
+
+	res := C.PlannerSetDistributedState(cm.planner, (*C.char)(stateData), C.int(len(stateBytes)), &resultLen)
+	return statusResultToError(res, resultLen)
+}
+
+// UpdateDistributedState applies changes to the distributed state that is kept by the planner.
+// The Carnot instances and schemas of upserts are added, or replace the ones with the same query
+// broker address or table name. Those of removals are removed, by query broker address and table name.
+func (cm GoPlanner) UpdateDistributedState(upserts *distributedpb.DistributedState, removals *distributedpb.DistributedState) error {
+	var resultLen C.int
+	upsertsBytes, err := proto.Marshal(upserts)
+	if err != nil {
+		return err
+	}
+	upsertsData := C.CBytes(upsertsBytes)
+	defer C.free(upsertsData)
+
+	removalsBytes, err := proto.Marshal(removals)
+	if err != nil {
+		return err
+	}
+	removalsData := C.CBytes(removalsBytes)
+	defer C.free(removalsData)
+
+	res := C.PlannerUpdateDistributedState(cm.planner, (*C.char)(upsertsData), C.int(len(upsertsBytes)), (*C.char)(removalsData), C.int(len(removalsBytes)), &resultLen)
+	return statusResultToError(res, resultLen)
+}
+
+// PlanWithStoredState plans the query like Plan, against the distributed state that is kept by the planner.
+// The distributed state of planState isn't looked at, and should be left empty.
+func (cm GoPlanner) PlanWithStoredState(planState *distributedpb.LogicalPlannerState, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	var resultLen C.int
+	stateBytes, err := proto.Marshal(planState)
+	if err != nil {
+		return nil, err
+	}
+	stateData := C.CBytes(stateBytes)
+	defer C.free(stateData)
+
+	queryRequestBytes, err := proto.Marshal(queryRequest)
+	if err != nil {
+		return nil, err
+	}
+	queryRequestData := C.CBytes(queryRequestBytes)
+	defer C.free(queryRequestData)
+
+	res := C.PlannerPlanWithStoredState(cm.planner, (*C.char)(stateData), C.int(len(stateBytes)), (*C.char)(queryRequestData), C.int(len(queryRequestBytes)), &resultLen)
+	defer C.StrFree(res)
+	lp := C.GoBytes(unsafe.Pointer(res), resultLen)
+	if resultLen == 0 {
+		return nil, errors.New("no result returned")
+	}
+
+	plan := &distributedpb.LogicalPlannerResult{}
+	if err := proto.Unmarshal(lp, plan); err != nil {
+		return plan, fmt.Errorf("error: '%s'; string: '%s'", err, string(lp))
+	}
+	return plan, nil
+}
+
+func statusResultToError(res *C.char, resultLen C.int) error {
+	defer C.StrFree(res)
+	resultBytes := C.GoBytes(unsafe.Pointer(res), resultLen)
+
+	status := &statuspb.Status{}
+	if err := proto.Unmarshal(resultBytes, status); err != nil {
+		return err
+	}
+	if status.ErrCode != statuspb.OK {
+		return fmt.Errorf("planner error (%s): %s", status.ErrCode.String(), status.Msg)
+	}
+	return nil
+}
+
 // CompileMutations compiles the query into a mutation of Pixie Data Table.
 func (cm GoPlanner) CompileMutations(planState *distributedpb.LogicalPlannerState, request *plannerpb.CompileMutationsRequest) (*plannerpb.CompileMutationsResponse, error) {
 	var resultLen C.int
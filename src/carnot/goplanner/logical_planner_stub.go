@@ -46,6 +46,22 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return nil, errorUnimplemented
 }
 
+// SetDistributedState replaces the distributed state that is kept by the planner, which
+// PlanWithStoredState plans against.
+func (cm GoPlanner) SetDistributedState(distributedState *distributedpb.DistributedState) error {
+	return errorUnimplemented
+}
+
+// UpdateDistributedState applies changes to the distributed state that is kept by the planner.
+func (cm GoPlanner) UpdateDistributedState(upserts *distributedpb.DistributedState, removals *distributedpb.DistributedState) error {
+	return errorUnimplemented
+}
+
+// PlanWithStoredState plans the query like Plan, against the distributed state that is kept by the planner.
+func (cm GoPlanner) PlanWithStoredState(planState *distributedpb.LogicalPlannerState, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	return nil, errorUnimplemented
+}
+
 // CompileMutations compiles the query into a mutation of Pixie Data Table.
 func (cm GoPlanner) CompileMutations(planState *distributedpb.LogicalPlannerState, request *plannerpb.CompileMutationsRequest) (*plannerpb.CompileMutationsResponse, error) {
 	return nil, errorUnimplemented
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
+#include <absl/time/clock.h>
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/exec/local_grpc_result_server.h"
+#include "src/common/base/base.h"
+#include "src/common/datagen/http_events_generator.h"
+#include "src/table_store/table_store.h"
+
+DEFINE_int32(ingest_query_benchmark_duration_ms, 5000,
+             "How long each configuration of the ingest-to-query benchmark runs for.");
+DEFINE_int32(ingest_query_benchmark_batch_rows, 1024,
+             "The number of rows in each record batch pushed by a simulated connector.");
+
+namespace px {
+namespace carnot {
+
+using datagen::HTTPEventsGenerator;
+using exec::LocalGRPCResultSinkServer;
+
+// A typical dashboard query: error rates and latencies of the endpoints.
+constexpr char kHTTPStatsQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-30s')
+df.failure = df.resp_status >= 400
+df = df.groupby(['req_path', 'req_method']).agg(
+    latency_quantiles=('latency', px.quantiles),
+    error_rate=('failure', px.mean),
+    throughput=('latency', px.count),
+)
+px.display(df, '$0')
+)pxl";
+
+std::unique_ptr<Carnot> SetUpCarnot(std::shared_ptr<table_store::TableStore> table_store,
+                                    LocalGRPCResultSinkServer* server) {
+  auto carnot_or_s = Carnot::Create(
+      sole::uuid4(), table_store,
+      std::bind(&LocalGRPCResultSinkServer::StubGenerator, server, std::placeholders::_1));
+  if (!carnot_or_s.ok()) {
+    LOG(FATAL) << "Failed to initialize Carnot.";
+  }
+  return carnot_or_s.ConsumeValueOrDie();
+}
+
+double Percentile(const std::vector<double>& sorted_values, double p) {
+  if (sorted_values.empty()) {
+    return 0;
+  }
+  size_t idx = static_cast<size_t>(p * (sorted_values.size() - 1));
+  return sorted_values[idx];
+}
+
+int64_t PeakRSSBytes() {
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in kilobytes.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+// Simulates connectors pushing http_events records into the table store, while PxL queries run
+// against it, and the table store compacts the pushed batches as the PEM does.
+//
+// Arguments:
+//   range(0): The number of simulated connectors, each pushing from its own thread.
+//   range(1): The number of rows per second pushed by each connector.
+//   range(2): The number of concurrent queries, each run in a loop from its own thread.
+//
+// Each query thread uses its own Carnot instance, so that the queries run independently of each
+// other, like the ones of separate clients.
+// NOLINTNEXTLINE : runtime/references.
+void BM_IngestAndQuery(benchmark::State& state) {
+  const int num_connectors = state.range(0);
+  const int64_t rows_per_sec = state.range(1);
+  const int num_queries = state.range(2);
+  const int64_t batch_rows = FLAGS_ingest_query_benchmark_batch_rows;
+  const auto batch_interval = absl::Seconds(1) * batch_rows / rows_per_sec;
+  const int64_t time_step_ns = 1'000'000'000 / rows_per_sec;
+
+  for (auto _ : state) {
+    auto table_store = std::make_shared<table_store::TableStore>();
+    auto table = table_store::Table::Create(
+        "http_events", table_store::schema::Relation(HTTPEventsGenerator::DataTypes(),
+                                                     HTTPEventsGenerator::ColumnNames()));
+    table_store->AddTable("http_events", table);
+
+    std::vector<std::unique_ptr<LocalGRPCResultSinkServer>> servers;
+    std::vector<std::unique_ptr<Carnot>> carnots;
+    for (int i = 0; i < num_queries; ++i) {
+      servers.push_back(std::make_unique<LocalGRPCResultSinkServer>());
+      carnots.push_back(SetUpCarnot(table_store, servers.back().get()));
+    }
+
+    absl::Notification done;
+    std::atomic<int64_t> rows_ingested = 0;
+    absl::Mutex latencies_lock;
+    std::vector<double> query_latencies_ms;
+    std::vector<std::thread> threads;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < num_connectors; ++i) {
+      threads.emplace_back([&, i]() {
+        HTTPEventsGenerator generator(/* seed */ i);
+        while (!done.WaitForNotificationWithTimeout(batch_interval)) {
+          auto record_batch = generator.Generate(batch_rows, CurrentTimeNS(), time_step_ns);
+          PL_CHECK_OK(table->TransferRecordBatch(std::move(record_batch)));
+          rows_ingested += batch_rows;
+        }
+      });
+    }
+
+    threads.emplace_back([&]() {
+      while (!done.WaitForNotificationWithTimeout(absl::Milliseconds(100))) {
+        PL_CHECK_OK(table_store->RunCompaction(arrow::default_memory_pool()));
+      }
+    });
+
+    for (int i = 0; i < num_queries; ++i) {
+      threads.emplace_back([&, i]() {
+        int query_num = 0;
+        while (!done.HasBeenNotified()) {
+          auto query = absl::Substitute(kHTTPStatsQuery, absl::StrCat("results_", query_num++));
+          auto query_start = std::chrono::steady_clock::now();
+          PL_CHECK_OK(carnots[i]->ExecuteQuery(query, sole::uuid4(), CurrentTimeNS()));
+          std::chrono::duration<double, std::milli> latency =
+              std::chrono::steady_clock::now() - query_start;
+          absl::MutexLock lock(&latencies_lock);
+          query_latencies_ms.push_back(latency.count());
+        }
+      });
+    }
+
+    absl::SleepFor(absl::Milliseconds(FLAGS_ingest_query_benchmark_duration_ms));
+    done.Notify();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    state.SetIterationTime(elapsed.count());
+
+    std::sort(query_latencies_ms.begin(), query_latencies_ms.end());
+    table_store::TableStats table_stats = table->GetTableStats();
+
+    state.counters["ingest_rows_per_s"] = rows_ingested / elapsed.count();
+    state.counters["ingest_bytes_per_s"] = table_stats.bytes_added / elapsed.count();
+    state.counters["queries"] = query_latencies_ms.size();
+    state.counters["query_p50_ms"] = Percentile(query_latencies_ms, 0.5);
+    state.counters["query_p90_ms"] = Percentile(query_latencies_ms, 0.9);
+    state.counters["query_p99_ms"] = Percentile(query_latencies_ms, 0.99);
+    state.counters["table_bytes"] = table_stats.bytes;
+    state.counters["table_cold_bytes"] = table_stats.cold_bytes;
+    state.counters["peak_rss_bytes"] = PeakRSSBytes();
+  }
+}
+
+BENCHMARK(BM_IngestAndQuery)
+    ->ArgNames({"connectors", "rows_per_s", "queries"})
+    ->Args({1, 10'000, 1})
+    ->Args({4, 10'000, 1})
+    ->Args({4, 10'000, 4})
+    ->Args({8, 50'000, 4})
+    ->Iterations(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace carnot
+}  // namespace px
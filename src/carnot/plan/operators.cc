@@ -74,6 +74,8 @@ std::unique_ptr<Operator> Operator::FromProto(const planpb::Operator& pb, int64_
       return CreateOperator<FilterOperator>(id, pb.filter_op());
     case planpb::LIMIT_OPERATOR:
       return CreateOperator<LimitOperator>(id, pb.limit_op());
+    case planpb::TOP_K_OPERATOR:
+      return CreateOperator<TopKOperator>(id, pb.top_k_op());
     case planpb::UNION_OPERATOR:
       return CreateOperator<UnionOperator>(id, pb.union_op());
     case planpb::JOIN_OPERATOR:
@@ -96,10 +98,55 @@ std::string MemorySourceOperator::DebugString() const { return "Op:MemorySource"
 
 Status MemorySourceOperator::Init(const planpb::MemorySourceOperator& pb) {
   pb_ = pb;
+  if (pb_.streaming() && pb_.tablets_size() > 0) {
+    return error::InvalidArgument("Streaming memory sources can't read several tablets");
+  }
   column_idxs_.reserve(static_cast<size_t>(pb_.column_idxs_size()));
   for (int i = 0; i < pb_.column_idxs_size(); ++i) {
     column_idxs_.emplace_back(pb_.column_idxs(i));
   }
+  for (const auto& predicate_pb : pb_.predicates()) {
+    table_store::ColumnPredicate predicate;
+    predicate.col_idx = predicate_pb.column_idx();
+    // CompareOp mirrors the order of ColumnPredicate::Op.
+    predicate.op = static_cast<table_store::ColumnPredicate::Op>(predicate_pb.op());
+    predicate.data_type = predicate_pb.value().data_type();
+    switch (predicate.data_type) {
+      case types::DataType::BOOLEAN:
+        predicate.int_value = predicate_pb.value().bool_value();
+        break;
+      case types::DataType::INT64:
+        predicate.int_value = predicate_pb.value().int64_value();
+        break;
+      case types::DataType::TIME64NS:
+        predicate.int_value = predicate_pb.value().time64_ns_value();
+        break;
+      case types::DataType::FLOAT64:
+        predicate.float_value = predicate_pb.value().float64_value();
+        break;
+      case types::DataType::UINT128:
+        predicate.uint128_value = absl::MakeUint128(predicate_pb.value().uint128_value().high(),
+                                                    predicate_pb.value().uint128_value().low());
+        break;
+      case types::DataType::STRING:
+        predicate.string_value = predicate_pb.value().string_value();
+        break;
+      default:
+        if (pb_.evaluate_predicates()) {
+          return error::InvalidArgument("Can't evaluate memory source predicates of type $0",
+                                        magic_enum::enum_name(predicate.data_type));
+        }
+        // Other types can neither skip batches nor be evaluated, so the predicate is dropped.
+        continue;
+    }
+    if (pb_.evaluate_predicates() &&
+        std::find(column_idxs_.begin(), column_idxs_.end(), predicate.col_idx) ==
+            column_idxs_.end()) {
+      return error::InvalidArgument("Memory source predicate on column $0 that isn't read",
+                                    predicate.col_idx);
+    }
+    predicates_.push_back(predicate);
+  }
   is_initialized_ = true;
   return Status::OK();
 }
@@ -189,6 +236,11 @@ std::string AggregateOperator::DebugString() const {
   std::vector<std::string> group_names(g.size());
   std::transform(begin(g), end(g), begin(group_names), [](auto val) { return val.name; });
 
+  if (rolling()) {
+    return absl::Substitute("Op:Aggregate(values=($0), groups=($1), rolling=($2, $3, $4))",
+                            absl::StrJoin(value_names, ", "), absl::StrJoin(group_names, ", "),
+                            window_time_column_.name, window_size_ns(), window_slide_ns());
+  }
   return absl::Substitute("Op:Aggregate(values=($0), groups=($1))",
                           absl::StrJoin(value_names, ", "), absl::StrJoin(group_names, ", "));
 }
@@ -212,11 +264,32 @@ Status AggregateOperator::Init(const planpb::AggregateOperator& pb) {
   for (int idx = 0; idx < pb_.groups_size(); ++idx) {
     groups_.emplace_back(GroupInfo{pb_.group_names(idx), pb_.groups(idx).index()});
   }
+  if (rolling()) {
+    PL_RETURN_IF_ERROR(InitRollingWindow());
+  }
 
   is_initialized_ = true;
   return Status::OK();
 }
 
+Status AggregateOperator::InitRollingWindow() {
+  const auto& window = pb_.rolling_window();
+  if (window.window_size_ns() <= 0) {
+    return error::InvalidArgument("Rolling window size must be positive, got $0",
+                                  window.window_size_ns());
+  }
+  if (window.slide_ns() < 0 || window.window_size_ns() % window_slide_ns() != 0) {
+    return error::InvalidArgument("Rolling window slide $0 must evenly divide the window size $1",
+                                  window.slide_ns(), window.window_size_ns());
+  }
+  if (!(pb_.partial_agg() && pb_.finalize_results()) || pb_.combine_partial_aggs() ||
+      pb_.windowed()) {
+    return error::InvalidArgument("Rolling aggregates must be full, non-windowed aggregates");
+  }
+  window_time_column_ = GroupInfo{window.time_column_name(), window.time_column().index()};
+  return Status::OK();
+}
+
 StatusOr<table_store::schema::Relation> AggregateOperator::OutputRelation(
     const table_store::schema::Schema& schema, const PlanState& state,
     const std::vector<int64_t>& input_ids) const {
@@ -246,10 +319,18 @@ StatusOr<table_store::schema::Relation> AggregateOperator::OutputRelation(
     output_relation.AddColumn(input_relation.GetColumnType(col_idx), pb_.group_names(idx));
   }
 
-  // If this node is a partial aggregate we output a simple schema where the last column has
-  // serialized aggregates.
+  if (rolling()) {
+    auto col_idx = window_time_column_.idx;
+    if (col_idx >= input_relation.NumColumns()) {
+      return error::InvalidArgument("Rolling window column index $0 is out of bounds", col_idx);
+    }
+    output_relation.AddColumn(input_relation.GetColumnType(col_idx), window_time_column_.name);
+  }
+
+  // If this node is a partial or combining aggregate we output a simple schema where the last
+  // column has serialized aggregates.
   // TODO(philkuz) need the column name and maybe type from somewhere else.
-  if (pb_.partial_agg() && !pb_.finalize_results()) {
+  if (pb_.combine_partial_aggs() || (pb_.partial_agg() && !pb_.finalize_results())) {
     output_relation.AddColumn(types::STRING, "serialized_expressions");
     return output_relation;
   }
@@ -320,10 +401,20 @@ std::string GRPCSinkOperator::DebugString() const {
   } else if (has_grpc_source_id()) {
     destination = absl::Substitute("source_id=$0", grpc_source_id());
   }
+  if (has_partition()) {
+    destination += absl::Substitute(", partition=$0/$1", partition().index(),
+                                    partition().num_partitions());
+  }
   return absl::Substitute("Op:GRPCSink($0, $1)", address(), destination);
 }
 
 Status GRPCSinkOperator::Init(const planpb::GRPCSinkOperator& pb) {
+  if (pb.has_partition() &&
+      (pb.partition().num_partitions() <= 0 || pb.partition().index() < 0 ||
+       pb.partition().index() >= pb.partition().num_partitions())) {
+    return error::InvalidArgument("GRPCSink partition $0 is out of range for $1 partitions",
+                                  pb.partition().index(), pb.partition().num_partitions());
+  }
   pb_ = pb;
   is_initialized_ = true;
   return Status::OK();
@@ -448,6 +539,80 @@ StatusOr<table_store::schema::Relation> LimitOperator::OutputRelation(
   return output_relation;
 }
 
+/**
+ * TopK Operator Implementation.
+ */
+std::string TopKOperator::DebugString() const {
+  std::vector<std::string> sort_strs;
+  for (const auto& [i, col] : Enumerate(sort_cols_)) {
+    sort_strs.push_back(absl::Substitute("$0$1", col, descending_[i] ? " desc" : ""));
+  }
+  return absl::Substitute("Op:TopK($0, cols: [$1], sort: [$2])", record_limit_,
+                          absl::StrJoin(selected_cols_, ","), absl::StrJoin(sort_strs, ","));
+}
+
+Status TopKOperator::Init(const planpb::TopKOperator& pb) {
+  pb_ = pb;
+  record_limit_ = pb_.limit();
+  if (record_limit_ < 0) {
+    return error::InvalidArgument("TopK limit must be non-negative, got $0", record_limit_);
+  }
+  if (pb_.sort_columns_size() == 0) {
+    return error::InvalidArgument("TopK operator must have at least one sort column");
+  }
+  if (pb_.descending_size() != pb_.sort_columns_size()) {
+    return error::InvalidArgument("TopK operator has $0 sort columns but $1 sort directions",
+                                  pb_.sort_columns_size(), pb_.descending_size());
+  }
+
+  selected_cols_.reserve(pb_.columns_size());
+  for (auto i = 0; i < pb_.columns_size(); ++i) {
+    selected_cols_.push_back(pb_.columns(i).index());
+  }
+  sort_cols_.reserve(pb_.sort_columns_size());
+  descending_.reserve(pb_.sort_columns_size());
+  for (auto i = 0; i < pb_.sort_columns_size(); ++i) {
+    sort_cols_.push_back(pb_.sort_columns(i).index());
+    descending_.push_back(pb_.descending(i));
+  }
+
+  is_initialized_ = true;
+  return Status::OK();
+}
+
+StatusOr<table_store::schema::Relation> TopKOperator::OutputRelation(
+    const table_store::schema::Schema& schema, const PlanState& /*state*/,
+    const std::vector<int64_t>& input_ids) const {
+  DCHECK(is_initialized_) << "Not initialized";
+
+  if (input_ids.size() != 1) {
+    return error::InvalidArgument("TopK operator must have exactly one input");
+  }
+  if (!schema.HasRelation(input_ids[0])) {
+    return error::NotFound("Missing relation ($0) for input of TopKOperator", input_ids[0]);
+  }
+
+  PL_ASSIGN_OR_RETURN(const table_store::schema::Relation& input_relation,
+                      schema.GetRelation(input_ids[0]));
+  for (auto sort_col_idx : sort_cols_) {
+    if (sort_col_idx >= static_cast<int64_t>(input_relation.NumColumns())) {
+      return error::InvalidArgument("Sort column index $0 is out of bounds, number of columns is $1",
+                                    sort_col_idx, input_relation.NumColumns());
+    }
+  }
+  table_store::schema::Relation output_relation;
+  for (auto selected_col_idx : selected_cols_) {
+    CHECK_LT(selected_col_idx, static_cast<int64_t>(input_relation.NumColumns()))
+        << absl::Substitute("Column index $0 is out of bounds, number of columns is $1",
+                            selected_col_idx, input_relation.NumColumns());
+
+    output_relation.AddColumn(input_relation.GetColumnType(selected_col_idx),
+                              input_relation.GetColumnName(selected_col_idx),
+                              input_relation.GetColumnDesc(selected_col_idx));
+  }
+  return output_relation;
+}
+
 /**
  * Zip Operator Implementation.
  */
@@ -565,6 +730,13 @@ std::string JoinOperator::DebugString(
 }
 
 std::string JoinOperator::DebugString() const {
+  if (as_of()) {
+    return absl::Substitute(
+        "Op:JoinOperator(type='$0', condition=($1), output_columns=($2), as_of=(parent[0][$3] - "
+        "$5 <= parent[1][$4] <= parent[0][$3]))",
+        DebugString(type()), DebugString(equality_conditions()), absl::StrJoin(column_names_, ","),
+        left_time_column_index(), right_time_column_index(), tolerance_ns());
+  }
   return absl::Substitute("Op:JoinOperator(type='$0', condition=($1), output_columns=($2))",
                           DebugString(type()), DebugString(equality_conditions()),
                           absl::StrJoin(column_names_, ","));
@@ -601,6 +773,16 @@ Status JoinOperator::Init(const planpb::JoinOperator& pb) {
     }
   }
 
+  if (as_of()) {
+    if (type() != planpb::JoinOperator::INNER && type() != planpb::JoinOperator::LEFT_OUTER) {
+      return error::InvalidArgument("As-of joins only support inner and left joins.");
+    }
+    if (tolerance_ns() < 0) {
+      return error::InvalidArgument("As-of join tolerance must not be negative, got $0",
+                                    tolerance_ns());
+    }
+  }
+
   return Status::OK();
 }
 
@@ -95,11 +95,20 @@ class MemorySourceOperator : public Operator {
   int64_t stop_time() const { return pb_.stop_time().value(); }
   std::vector<int64_t> Columns() const { return column_idxs_; }
   const types::TabletID& Tablet() const { return pb_.tablet(); }
+  // The tablets read by a source that reads several tablets, empty otherwise.
+  std::vector<types::TabletID> Tablets() const {
+    return std::vector<types::TabletID>(pb_.tablets().begin(), pb_.tablets().end());
+  }
+  int64_t TabletParallelism() const { return pb_.tablet_parallelism(); }
   bool infinite_stream() const { return pb_.streaming(); }
+  const std::vector<table_store::ColumnPredicate>& predicates() const { return predicates_; }
+  // Whether the rows that don't satisfy the predicates are dropped, rather than only the batches.
+  bool evaluate_predicates() const { return pb_.evaluate_predicates(); }
 
  private:
   planpb::MemorySourceOperator pb_;
   std::vector<int64_t> column_idxs_;
+  std::vector<table_store::ColumnPredicate> predicates_;
 };
 
 class MapOperator : public Operator {
@@ -143,10 +152,26 @@ class AggregateOperator : public Operator {
   const std::vector<GroupInfo>& groups() const { return groups_; }
   const std::vector<std::shared_ptr<AggregateExpression>>& values() const { return values_; }
   bool windowed() const { return pb_.windowed(); }
+  bool partial_agg() const { return pb_.partial_agg(); }
+  bool finalize_results() const { return pb_.finalize_results(); }
+  bool combine_partial_aggs() const { return pb_.combine_partial_aggs(); }
+  bool ordered_leading_group() const { return pb_.ordered_leading_group(); }
+
+  // Rolling aggregates compute the values for windows over the time column, see RollingAggNode.
+  bool rolling() const { return pb_.has_rolling_window(); }
+  const GroupInfo& window_time_column() const { return window_time_column_; }
+  int64_t window_size_ns() const { return pb_.rolling_window().window_size_ns(); }
+  int64_t window_slide_ns() const {
+    return pb_.rolling_window().slide_ns() > 0 ? pb_.rolling_window().slide_ns()
+                                               : window_size_ns();
+  }
 
  private:
+  Status InitRollingWindow();
+
   std::vector<std::shared_ptr<AggregateExpression>> values_;
   std::vector<GroupInfo> groups_;
+  GroupInfo window_time_column_;
   planpb::AggregateOperator pb_;
 };
 
@@ -214,6 +239,9 @@ class GRPCSinkOperator : public Operator {
   }
   std::string table_name() const { return pb_.output_table().table_name(); }
 
+  bool has_partition() const { return pb_.has_partition(); }
+  const planpb::GRPCSinkOperator::Partition& partition() const { return pb_.partition(); }
+
  private:
   planpb::GRPCSinkOperator pb_;
 };
@@ -261,6 +289,31 @@ class LimitOperator : public Operator {
   planpb::LimitOperator pb_;
 };
 
+class TopKOperator : public Operator {
+ public:
+  explicit TopKOperator(int64_t id) : Operator(id, planpb::TOP_K_OPERATOR) {}
+  ~TopKOperator() override = default;
+
+  StatusOr<table_store::schema::Relation> OutputRelation(
+      const table_store::schema::Schema& schema, const PlanState& state,
+      const std::vector<int64_t>& input_ids) const override;
+  Status Init(const planpb::TopKOperator& pb);
+  std::string DebugString() const override;
+  std::vector<int64_t> selected_cols() { return selected_cols_; }
+
+  int64_t record_limit() const { return record_limit_; }
+  // Indexes of the sort columns in the input.
+  const std::vector<int64_t>& sort_cols() const { return sort_cols_; }
+  const std::vector<bool>& descending() const { return descending_; }
+
+ private:
+  int64_t record_limit_ = 0;
+  std::vector<int64_t> selected_cols_;
+  std::vector<int64_t> sort_cols_;
+  std::vector<bool> descending_;
+  planpb::TopKOperator pb_;
+};
+
 class UnionOperator : public Operator {
  public:
   explicit UnionOperator(int64_t id) : Operator(id, planpb::UNION_OPERATOR) {}
@@ -312,10 +365,17 @@ class JoinOperator : public Operator {
   }
   std::vector<planpb::JoinOperator::ParentColumn> output_columns() const { return output_columns_; }
   size_t rows_per_batch() const { return pb_.rows_per_batch(); }
+  planpb::JoinOperator::BuildSide build_side() const { return pb_.build_side(); }
 
   bool order_by_time() const;
   planpb::JoinOperator::ParentColumn time_column() const;
 
+  // As-of joins match left rows with the latest right row before them, see AsOfJoinNode.
+  bool as_of() const { return pb_.has_as_of(); }
+  int64_t left_time_column_index() const { return pb_.as_of().left_time_column_index(); }
+  int64_t right_time_column_index() const { return pb_.as_of().right_time_column_index(); }
+  int64_t tolerance_ns() const { return pb_.as_of().tolerance_ns(); }
+
  private:
   std::vector<std::string> column_names_;
   std::vector<planpb::JoinOperator::EqualityCondition> equality_conditions_;
@@ -230,6 +230,19 @@ TEST_F(OperatorTest, from_proto_limit) {
   EXPECT_EQ(planpb::OperatorType::LIMIT_OPERATOR, limit_op->op_type());
 }
 
+TEST_F(OperatorTest, from_proto_top_k) {
+  auto top_k_pb = planpb::testutils::CreateTestTopK1PB();
+  auto top_k_op = Operator::FromProto(top_k_pb, 1);
+  EXPECT_EQ(1, top_k_op->id());
+  EXPECT_TRUE(top_k_op->is_initialized());
+  EXPECT_EQ(planpb::OperatorType::TOP_K_OPERATOR, top_k_op->op_type());
+  auto top_k_typed_op = static_cast<TopKOperator*>(top_k_op.get());
+  EXPECT_EQ(3, top_k_typed_op->record_limit());
+  EXPECT_THAT(top_k_typed_op->selected_cols(), ElementsAre(0, 1));
+  EXPECT_THAT(top_k_typed_op->sort_cols(), ElementsAre(1));
+  EXPECT_THAT(top_k_typed_op->descending(), ElementsAre(true));
+}
+
 TEST_F(OperatorTest, from_proto_drop_limit) {
   auto limit_pb = planpb::testutils::CreateTestDropLimit1PB();
   auto limit_op = Operator::FromProto(limit_pb, 1);
@@ -283,6 +296,31 @@ TEST_F(OperatorTest, from_proto_join_no_time) {
   EXPECT_FALSE(join_op->order_by_time());
 }
 
+TEST_F(OperatorTest, from_proto_join_as_of) {
+  auto join_pb = planpb::testutils::CreateTestJoinNoTimePB();
+  auto as_of_pb = join_pb.mutable_join_op()->mutable_as_of();
+  as_of_pb->set_left_time_column_index(1);
+  as_of_pb->set_right_time_column_index(2);
+  as_of_pb->set_tolerance_ns(100);
+  auto join_op = std::make_unique<JoinOperator>(1);
+  ASSERT_OK(join_op->Init(join_pb.join_op()));
+  EXPECT_TRUE(join_op->as_of());
+  EXPECT_EQ(1, join_op->left_time_column_index());
+  EXPECT_EQ(2, join_op->right_time_column_index());
+  EXPECT_EQ(100, join_op->tolerance_ns());
+
+  as_of_pb->set_tolerance_ns(-1);
+  join_op = std::make_unique<JoinOperator>(1);
+  EXPECT_NOT_OK(join_op->Init(join_pb.join_op()));
+
+  as_of_pb->set_tolerance_ns(0);
+  join_pb.mutable_join_op()->set_type(planpb::JoinOperator::FULL_OUTER);
+  join_op = std::make_unique<JoinOperator>(1);
+  auto s = join_op->Init(join_pb.join_op());
+  EXPECT_NOT_OK(s);
+  EXPECT_EQ(s.msg(), "As-of joins only support inner and left joins.");
+}
+
 TEST_F(OperatorTest, output_relation_source) {
   auto src_pb = planpb::testutils::CreateTestSource1PB();
   auto src_op = Operator::FromProto(src_pb, 1);
@@ -366,6 +404,42 @@ TEST_F(OperatorTest, output_relation_agg) {
   EXPECT_EQ(expected_relation, rel);
 }
 
+TEST_F(OperatorTest, output_relation_rolling_agg) {
+  auto agg_pb = planpb::testutils::CreateTestBlockingAgg1PB();
+  agg_pb.mutable_agg_op()->set_partial_agg(true);
+  agg_pb.mutable_agg_op()->set_finalize_results(true);
+  auto window = agg_pb.mutable_agg_op()->mutable_rolling_window();
+  window->mutable_time_column()->set_node(0);
+  window->mutable_time_column()->set_index(0);
+  window->set_time_column_name("time_");
+  window->set_window_size_ns(10);
+  auto agg_op = Operator::FromProto(agg_pb, 1);
+  ASSERT_TRUE(agg_op->is_initialized());
+  auto rolling_agg_op = static_cast<AggregateOperator*>(agg_op.get());
+  EXPECT_TRUE(rolling_agg_op->rolling());
+  EXPECT_EQ(10, rolling_agg_op->window_slide_ns());
+
+  auto rel =
+      agg_op->OutputRelation(schema_, *state_, std::vector<int64_t>({0})).ConsumeValueOrDie();
+
+  Relation expected_relation;
+  expected_relation.AddColumn(types::DataType::FLOAT64, "group1");
+  expected_relation.AddColumn(types::DataType::INT64, "time_");
+  expected_relation.AddColumn(types::DataType::INT64, "value1");
+  EXPECT_EQ(expected_relation, rel);
+}
+
+TEST_F(OperatorTest, rolling_agg_slide_must_divide_window) {
+  auto agg_pb = planpb::testutils::CreateTestBlockingAgg1PB();
+  agg_pb.mutable_agg_op()->set_partial_agg(true);
+  agg_pb.mutable_agg_op()->set_finalize_results(true);
+  auto window = agg_pb.mutable_agg_op()->mutable_rolling_window();
+  window->set_window_size_ns(10);
+  window->set_slide_ns(3);
+  AggregateOperator agg_op(1);
+  EXPECT_NOT_OK(agg_op.Init(agg_pb.agg_op()));
+}
+
 TEST_F(OperatorTest, output_relation_filter) {
   auto filter_pb = planpb::testutils::CreateTestFilter1PB();
   auto filter_op = Operator::FromProto(filter_pb, 2);
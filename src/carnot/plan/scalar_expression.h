@@ -183,7 +183,7 @@ class ScalarFunc : public ScalarExpression {
   std::string name() const { return name_; }
   int64_t udf_id() const { return udf_id_; }
   const ScalarExpressionPtrVector& arg_deps() const { return arg_deps_; }
-  const std::vector<types::DataType> registry_arg_types() const { return registry_arg_types_; }
+  const std::vector<types::DataType>& registry_arg_types() const { return registry_arg_types_; }
   const std::vector<ScalarValue> init_arguments() const { return init_arguments_; }
 
  private:
@@ -211,7 +211,7 @@ class AggregateExpression : public ScalarExpression {
   std::string name() const { return name_; }
   int64_t uda_id() const { return uda_id_; }
   const ScalarExpressionPtrVector& arg_deps() const { return arg_deps_; }
-  const std::vector<types::DataType> registry_arg_types() const { return registry_arg_types_; }
+  const std::vector<types::DataType>& registry_arg_types() const { return registry_arg_types_; }
   const std::vector<ScalarValue> init_arguments() const { return init_arguments_; }
 
  private:
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Benchmarks the compilation of every script under src/pxl_scripts against a planner state with
+// ten PEMs and one Kelvin, which all have the schemas of every Stirling table. Besides the time of
+// each compilation, reports the time of the slowest compiler rules as counters.
+//
+// bazel run -c opt //src/carnot/planner:all_scripts_benchmark -- --benchmark_filter=px/http_data
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+#include <benchmark/benchmark.h>
+#include <rapidjson/document.h>
+
+#include "src/carnot/planner/logical_planner.h"
+#include "src/carnot/planner/test_utils.h"
+#include "src/carnot/udf_exporter/udf_exporter.h"
+#include "src/common/base/base.h"
+#include "src/common/testing/test_environment.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace {
+
+constexpr char kScriptDir[] = "src/pxl_scripts";
+constexpr char kSchemaPath[] = "src/e2e_test/vizier/planner/dump_schemas/all_schemas.bin";
+constexpr int kNumPEMs = 10;
+// The number of the slowest rules of each script to report as counters.
+constexpr int kNumReportedRules = 5;
+
+struct Script {
+  std::string name;
+  plannerpb::QueryRequest query_request;
+};
+
+// The value passed to a script variable that has neither a default nor valid values. Mirrors the
+// defaults of the all scripts compile test.
+std::string DefaultForType(std::string_view type) {
+  if (type == "PX_BOOLEAN") return "True";
+  if (type == "PX_INT64") return "1";
+  if (type == "PX_FLOAT64") return "1.0";
+  if (type == "PX_SERVICE" || type == "PX_POD" || type == "PX_CONTAINER" ||
+      type == "PX_NAMESPACE" || type == "PX_NODE") {
+    return "pl";
+  }
+  if (type == "PX_LIST") return "[]";
+  if (type == "PX_STRING_LIST") return "[\"\"]";
+  return "";
+}
+
+std::string GetString(const rapidjson::Value& obj, const char* key) {
+  auto iter = obj.FindMember(key);
+  if (iter == obj.MemberEnd() || !iter->value.IsString()) {
+    return "";
+  }
+  return iter->value.GetString();
+}
+
+// Adds a function call of the vis spec of a script to the query request, with the values of its
+// variables.
+void AddExecFunc(const rapidjson::Value& func,
+                 const std::map<std::string, std::string>& variable_values,
+                 plannerpb::QueryRequest* query_request) {
+  auto* exec_func = query_request->add_exec_funcs();
+  exec_func->set_func_name(GetString(func, "name"));
+  exec_func->set_output_table_prefix(GetString(func, "name"));
+  auto args = func.FindMember("args");
+  if (args == func.MemberEnd()) {
+    return;
+  }
+  for (const auto& arg : args->value.GetArray()) {
+    auto* arg_value = exec_func->add_arg_values();
+    arg_value->set_name(GetString(arg, "name"));
+    std::string variable = GetString(arg, "variable");
+    if (!variable.empty()) {
+      auto iter = variable_values.find(variable);
+      if (iter != variable_values.end()) {
+        arg_value->set_value(iter->second);
+      }
+    } else {
+      arg_value->set_value(GetString(arg, "value"));
+    }
+  }
+}
+
+Status AddExecFuncs(const std::string& vis_json, plannerpb::QueryRequest* query_request) {
+  rapidjson::Document vis;
+  vis.Parse(vis_json.data(), vis_json.size());
+  if (vis.HasParseError() || !vis.IsObject()) {
+    return error::InvalidArgument("Failed to parse the vis spec.");
+  }
+
+  std::map<std::string, std::string> variable_values;
+  if (vis.HasMember("variables")) {
+    for (const auto& variable : vis["variables"].GetArray()) {
+      std::string value = GetString(variable, "defaultValue");
+      if (value.empty() && variable.HasMember("validValues") &&
+          !variable["validValues"].Empty()) {
+        value = variable["validValues"][0].GetString();
+      }
+      if (value.empty()) {
+        value = DefaultForType(GetString(variable, "type"));
+      }
+      variable_values[GetString(variable, "name")] = value;
+    }
+  }
+  if (vis.HasMember("globalFuncs")) {
+    for (const auto& global_func : vis["globalFuncs"].GetArray()) {
+      AddExecFunc(global_func["func"], variable_values, query_request);
+    }
+  }
+  if (vis.HasMember("widgets")) {
+    for (const auto& widget : vis["widgets"].GetArray()) {
+      if (widget.HasMember("func")) {
+        AddExecFunc(widget["func"], variable_values, query_request);
+      }
+    }
+  }
+  return Status::OK();
+}
+
+StatusOr<std::vector<Script>> LoadScripts() {
+  std::vector<Script> scripts;
+  std::filesystem::path script_dir = testing::TestFilePath(kScriptDir);
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(script_dir)) {
+    if (entry.path().extension() != ".pxl") {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(std::string query_str, ReadFileToString(entry.path().string()));
+    // Scripts that deploy tracepoints compile to mutations rather than to a plan.
+    if (absl::StrContains(query_str, "pxtrace")) {
+      continue;
+    }
+    std::filesystem::path dir = entry.path().parent_path();
+    Script script;
+    script.name = absl::StrCat(dir.parent_path().filename().string(), "/", dir.filename().string());
+    script.query_request.set_query_str(query_str);
+    std::filesystem::path vis_path = dir / "vis.json";
+    if (std::filesystem::exists(vis_path)) {
+      PL_ASSIGN_OR_RETURN(std::string vis_json, ReadFileToString(vis_path.string()));
+      PL_RETURN_IF_ERROR(AddExecFuncs(vis_json, &script.query_request));
+    }
+    scripts.push_back(std::move(script));
+  }
+  std::sort(scripts.begin(), scripts.end(),
+            [](const Script& a, const Script& b) { return a.name < b.name; });
+  return scripts;
+}
+
+StatusOr<distributedpb::LogicalPlannerState> MakePlannerState() {
+  PL_ASSIGN_OR_RETURN(std::string schema_str,
+                      ReadFileToString(testing::BazelBinTestFilePath(kSchemaPath).string()));
+  table_store::schemapb::Schema schema;
+  if (!schema.ParseFromString(schema_str)) {
+    return error::InvalidArgument("Failed to parse the schemas at $0.", kSchemaPath);
+  }
+
+  std::vector<std::string> carnot_infos;
+  for (int i = 1; i <= kNumPEMs; ++i) {
+    std::string agent_id =
+        absl::StrCat("00000001-0000-0000-0000-", absl::Dec(i, absl::kZeroPad12));
+    carnot_infos.push_back(
+        testutils::MakePEMCarnotInfo(absl::StrCat("pem", i), agent_id, /* asid */ i, {}));
+  }
+  carnot_infos.push_back(testutils::MakeKelvinCarnotInfo(
+      "kelvin", "00000002-0000-0000-0000-000000000001", "1111", kNumPEMs + 1));
+  return testutils::LoadLogicalPlannerStatePB(testutils::MakeDistributedState(carnot_infos),
+                                              schema);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void BM_CompileScript(benchmark::State& state, LogicalPlanner* planner,
+                      const distributedpb::LogicalPlannerState* planner_state,
+                      const plannerpb::QueryRequest* query_request) {
+  std::vector<distributedpb::RuleExecutionStats> rule_stats;
+  for (auto _ : state) {
+    auto plan_or_s = planner->Plan(*planner_state, *query_request);
+    if (!plan_or_s.ok()) {
+      state.SkipWithError(plan_or_s.status().msg().c_str());
+      return;
+    }
+    rule_stats = plan_or_s.ValueOrDie()->rule_execution_stats();
+  }
+
+  // Report the rules of the last compilation that took the longest.
+  std::sort(rule_stats.begin(), rule_stats.end(), [](const auto& a, const auto& b) {
+    return a.total_time_ns() > b.total_time_ns();
+  });
+  for (int i = 0; i < std::min<int>(kNumReportedRules, rule_stats.size()); ++i) {
+    state.counters[absl::StrCat(rule_stats[i].batch_name(), "/", rule_stats[i].rule_name(),
+                                "_us")] = rule_stats[i].total_time_ns() / 1000.0;
+  }
+}
+
+}  // namespace
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
+
+int main(int argc, char** argv) {
+  using px::carnot::planner::LogicalPlanner;
+
+  benchmark::Initialize(&argc, argv);
+  px::EnvironmentGuard env_guard(&argc, argv);
+
+  auto info = px::carnot::udfexporter::ExportUDFInfo().ConsumeValueOrDie()->info_pb();
+  std::unique_ptr<LogicalPlanner> planner = LogicalPlanner::Create(info).ConsumeValueOrDie();
+  auto planner_state = px::carnot::planner::MakePlannerState().ConsumeValueOrDie();
+  auto scripts = px::carnot::planner::LoadScripts().ConsumeValueOrDie();
+  for (const auto& script : scripts) {
+    benchmark::RegisterBenchmark(script.name.c_str(), px::carnot::planner::BM_CompileScript,
+                                 planner.get(), &planner_state, &script.query_request)
+        ->Unit(benchmark::kMillisecond);
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
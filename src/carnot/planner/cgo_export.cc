@@ -96,29 +96,89 @@ char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
 
   auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
 
-  auto distributed_plan_status = planner->Plan(planner_state_pb, query_request_pb);
-  if (!distributed_plan_status.ok()) {
-    return ExitEarly<LogicalPlannerResult>(distributed_plan_status.status(), resultLen);
+  auto plan_pb_status = planner->PlanToProto(planner_state_pb, query_request_pb);
+  if (!plan_pb_status.ok()) {
+    return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
-  std::unique_ptr<px::carnot::planner::distributed::DistributedPlan> distributed_plan =
-      distributed_plan_status.ConsumeValueOrDie();
 
-  // If the response is ok, then we can go ahead and set this up.
   LogicalPlannerResult planner_result_pb;
-  WrapStatus(&planner_result_pb, distributed_plan_status.status());
-  // In the future, if we actually have plan options that will actually determine how the plan is
-  // constructed, we may want to pass the planOptions to planner.Plan. However, this
-  // will need to go through many more layers (such as the coordinator), so this is fine for now.
-  distributed_plan->SetPlanOptions(planner_state_pb.plan_options());
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
+  *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
+
+  // Serialize the logical plan into bytes.
+  return PrepareResult(&planner_result_pb, resultLen);
+}
+
+char* PrepareStatusResult(const px::Status& status, int* resultLen) {
+  px::statuspb::Status status_pb;
+  status.ToProto(&status_pb);
+  return PrepareResult(&status_pb, resultLen);
+}
+
+char* PlannerSetDistributedState(PlannerPtr planner_ptr, const char* distributed_state_str_c,
+                                 int distributed_state_str_len, int* resultLen) {
+  DCHECK(distributed_state_str_c != nullptr);
+  std::string distributed_state_pb_str(distributed_state_str_c,
+                                       distributed_state_str_c + distributed_state_str_len);
+
+  px::carnot::planner::distributedpb::DistributedState distributed_state_pb;
+  px::Status s = LoadProto(distributed_state_pb_str, &distributed_state_pb,
+                           "Failed to process the distributed state");
+  if (s.ok()) {
+    auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+    s = planner->SetDistributedState(distributed_state_pb);
+  }
+  return PrepareStatusResult(s, resultLen);
+}
+
+char* PlannerUpdateDistributedState(PlannerPtr planner_ptr, const char* upserts_str_c,
+                                    int upserts_str_len, const char* removals_str_c,
+                                    int removals_str_len, int* resultLen) {
+  std::string upserts_pb_str(upserts_str_c, upserts_str_c + upserts_str_len);
+  std::string removals_pb_str(removals_str_c, removals_str_c + removals_str_len);
+
+  px::carnot::planner::distributedpb::DistributedState upserts_pb;
+  px::carnot::planner::distributedpb::DistributedState removals_pb;
+  px::Status s = LoadProto(upserts_pb_str, &upserts_pb, "Failed to process the upserted state");
+  if (s.ok()) {
+    s = LoadProto(removals_pb_str, &removals_pb, "Failed to process the removed state");
+  }
+  if (s.ok()) {
+    auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+    s = planner->UpdateDistributedState(upserts_pb, removals_pb);
+  }
+  return PrepareStatusResult(s, resultLen);
+}
+
+char* PlannerPlanWithStoredState(PlannerPtr planner_ptr, const char* planner_state_str_c,
+                                 int planner_state_str_len, const char* query_request_str_c,
+                                 int query_request_str_len, int* resultLen) {
+  DCHECK(planner_state_str_c != nullptr);
+  std::string planner_state_pb_str(planner_state_str_c,
+                                   planner_state_str_c + planner_state_str_len);
+  std::string query_request_pb_str(query_request_str_c,
+                                   query_request_str_c + query_request_str_len);
+
+  px::carnot::planner::distributedpb::LogicalPlannerState planner_state_pb;
+  PLANNER_RETURN_IF_ERROR(LogicalPlannerResult, resultLen,
+                          LoadProto(planner_state_pb_str, &planner_state_pb,
+                                    "Failed to process the logical planner state"));
 
-  auto plan_pb_status = distributed_plan->ToProto();
+  px::carnot::planner::plannerpb::QueryRequest query_request_pb;
+  PLANNER_RETURN_IF_ERROR(
+      LogicalPlannerResult, resultLen,
+      LoadProto(query_request_pb_str, &query_request_pb, "Failed to process the query request"));
+
+  auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+
+  auto plan_pb_status = planner->PlanToProtoWithStoredState(planner_state_pb, query_request_pb);
   if (!plan_pb_status.ok()) {
     return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
 
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
   *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
-
-  // Serialize the logical plan into bytes.
   return PrepareResult(&planner_result_pb, resultLen);
 }
 
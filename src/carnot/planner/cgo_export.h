@@ -45,6 +45,54 @@ PlannerPtr PlannerNew(const char* udf_info_str_data, int udf_info_str_len);
 char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
                   int planner_state_str_len, const char* query, int query_len, int* resultLen);
 
+/**
+ * @brief Replaces the distributed state that is kept by the planner, which
+ * PlannerPlanWithStoredState plans against. After this, only the changes to the state have to be
+ * passed in through PlannerUpdateDistributedState.
+ *
+ * @param planner_ptr                 Pointer to the Planner.
+ * @param distributed_state_str_c     The serialized distributedpb.DistributedState.
+ * @param distributed_state_str_len   Length of the serialized DistributedState.
+ * @param resultLen                   Variable to store the length of the return value.
+ * @return char*                      The serialized px.statuspb.Status of the call.
+ */
+char* PlannerSetDistributedState(PlannerPtr planner_ptr, const char* distributed_state_str_c,
+                                 int distributed_state_str_len, int* resultLen);
+
+/**
+ * @brief Applies changes to the distributed state that is kept by the planner.
+ *
+ * @param planner_ptr         Pointer to the Planner.
+ * @param upserts_str_c       A serialized distributedpb.DistributedState, with the Carnot
+ * instances and schemas that are added or replace the ones with the same query broker address or
+ * table name.
+ * @param upserts_str_len     Length of the serialized upserts.
+ * @param removals_str_c      A serialized distributedpb.DistributedState, with the Carnot instances
+ * and schemas to remove. Only their query broker addresses and table names are looked at.
+ * @param removals_str_len    Length of the serialized removals.
+ * @param resultLen           Variable to store the length of the return value.
+ * @return char*              The serialized px.statuspb.Status of the call.
+ */
+char* PlannerUpdateDistributedState(PlannerPtr planner_ptr, const char* upserts_str_c,
+                                    int upserts_str_len, const char* removals_str_c,
+                                    int removals_str_len, int* resultLen);
+
+/**
+ * @brief Like PlannerPlan, but plans against the distributed state that is kept by the planner.
+ * The distributed state of the planner state isn't looked at, and should be left empty, so that
+ * the call only carries the plan options and the query.
+ *
+ * @param planner_ptr             Pointer to the Planner.
+ * @param planner_state_str_c     The planner state proto, seralized as a string.
+ * @param planner_state_str_len   Length of the planner state proto serialized string.
+ * @param query_request_str_c     The query request proto to plan, seralized as a string.
+ * @param query_request_str_len   The length of the query request serialized string.
+ * @return char*                  The serialized distributedpb.LogicalPlannerResult.
+ */
+char* PlannerPlanWithStoredState(PlannerPtr planner_ptr, const char* planner_state_str_c,
+                                 int planner_state_str_len, const char* query_request_str_c,
+                                 int query_request_str_len, int* resultLen);
+
 /**
  * @brief Compiles mutations into their executable form. Takes in a serialized
  * CompileMutationsRequest and returns a serialiaed CompileMutationsResponse.
@@ -169,6 +169,62 @@ TEST_F(PlannerExportTest, pass_query_string_instead_of_req_should_fail) {
               ::testing::ContainsRegex("Failed to process the query request.*"));
 }
 
+TEST_F(PlannerExportTest, plan_with_stored_state) {
+  planner_ = MakePlanner();
+  int result_len;
+  distributedpb::LogicalPlannerState planner_state = testutils::CreateOnePEMOneKelvinPlannerState();
+  std::string distributed_state;
+  ASSERT_TRUE(planner_state.distributed_state().SerializeToString(&distributed_state));
+  planner_state.clear_distributed_state();
+  std::string logical_planner_state;
+  ASSERT_TRUE(planner_state.SerializeToString(&logical_planner_state));
+  std::string query = "import px\npx.display(px.DataFrame('table1'), 'out')";
+  std::string query_request;
+  ASSERT_TRUE(MakeQueryRequest(query).SerializeToString(&query_request));
+
+  auto plan = [&]() {
+    char* interface_result = PlannerPlanWithStoredState(
+        planner_, logical_planner_state.c_str(), logical_planner_state.length(),
+        query_request.c_str(), query_request.length(), &result_len);
+    distributedpb::LogicalPlannerResult planner_result;
+    EXPECT_TRUE(planner_result.ParseFromString(
+        std::string(interface_result, interface_result + result_len)));
+    delete[] interface_result;
+    return planner_result;
+  };
+
+  // No state was set yet.
+  EXPECT_NOT_OK(plan().status());
+
+  char* status_result = PlannerSetDistributedState(planner_, distributed_state.c_str(),
+                                                   distributed_state.length(), &result_len);
+  statuspb::Status status_pb;
+  ASSERT_TRUE(status_pb.ParseFromString(std::string(status_result, status_result + result_len)));
+  delete[] status_result;
+  ASSERT_OK(status_pb);
+
+  distributedpb::LogicalPlannerResult planner_result = plan();
+  ASSERT_OK(planner_result.status());
+  EXPECT_THAT(planner_result.plan(),
+              Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+
+  // Once the table is removed, it can't be queried anymore.
+  distributedpb::DistributedState removals;
+  removals.add_schema_info()->set_name("table1");
+  std::string removals_str;
+  ASSERT_TRUE(removals.SerializeToString(&removals_str));
+  status_result =
+      PlannerUpdateDistributedState(planner_, /* upserts_str_c */ "", 0, removals_str.c_str(),
+                                    removals_str.length(), &result_len);
+  ASSERT_TRUE(status_pb.ParseFromString(std::string(status_result, status_result + result_len)));
+  delete[] status_result;
+  ASSERT_OK(status_pb);
+
+  planner_result = plan();
+  EXPECT_NOT_OK(planner_result.status());
+  EXPECT_THAT(planner_result.status(), HasCompilerError("Table 'table1' not found."));
+}
+
 constexpr char kPxTraceQuery[] = R"pxl(
 import pxtrace
 import px
@@ -28,7 +28,10 @@
 #include "src/carnot/planner/compiler/analyzer/convert_metadata_rule.h"
 #include "src/carnot/planner/compiler/analyzer/convert_string_times_rule.h"
 #include "src/carnot/planner/compiler/analyzer/drop_to_map_rule.h"
+#include "src/carnot/planner/compiler/analyzer/fold_constant_funcs_rule.h"
 #include "src/carnot/planner/compiler/analyzer/merge_group_by_into_group_acceptor_rule.h"
+#include "src/carnot/planner/compiler/analyzer/merge_limit_into_top_k_rule.h"
+#include "src/carnot/planner/compiler/analyzer/merge_rolling_into_agg_rule.h"
 #include "src/carnot/planner/compiler/analyzer/nested_blocking_agg_fn_check_rule.h"
 #include "src/carnot/planner/compiler/analyzer/propagate_expression_annotations_rule.h"
 #include "src/carnot/planner/compiler/analyzer/remove_group_by_rule.h"
@@ -73,6 +76,7 @@ class Analyzer : public RuleExecutor<IR> {
     source_and_metadata_resolution_batch->AddRule<MergeGroupByIntoGroupAcceptorRule>(
         IRNodeType::kRolling);
     source_and_metadata_resolution_batch->AddRule<ConvertStringTimesRule>(compiler_state_);
+    source_and_metadata_resolution_batch->AddRule<MergeRollingIntoAggRule>();
     source_and_metadata_resolution_batch->AddRule<NestedBlockingAggFnCheckRule>();
     source_and_metadata_resolution_batch->AddRule<ResolveStreamRule>();
   }
@@ -91,6 +95,7 @@ class Analyzer : public RuleExecutor<IR> {
     RuleBatch* intermediate_resolution_batch =
         CreateRuleBatch<FailOnMax>("CompileTimeResolution", 100);
     intermediate_resolution_batch->AddRule<SetMemorySourceTimesRule>();
+    intermediate_resolution_batch->AddRule<FoldConstantFuncsRule>();
   }
 
   // TODO(philkuz) need to add a new optimization that combines maps.
@@ -99,6 +104,12 @@ class Analyzer : public RuleExecutor<IR> {
     consecutive_maps->AddRule<CombineConsecutiveMapsRule>();
   }
 
+  // Runs after AddLimitToBatchResultSink so that the result sink limits are folded in as well.
+  void CreateMergeLimitIntoTopKBatch() {
+    RuleBatch* merge_limit_batch = CreateRuleBatch<FailOnMax>("MergeLimitIntoTopK", 2);
+    merge_limit_batch->AddRule<MergeLimitIntoTopKRule>();
+  }
+
   void CreateDataTypeResolutionBatch() {
     RuleBatch* intermediate_resolution_batch =
         CreateRuleBatch<FailOnMax>("DataTypeResolution", 100);
@@ -134,6 +145,7 @@ class Analyzer : public RuleExecutor<IR> {
     CreateAddLimitToBatchResultSinkBatch();
     CreateOperatorCompileTimeExpressionRuleBatch();
     CreateCombineConsecutiveMapsRule();
+    CreateMergeLimitIntoTopKBatch();
     CreateDataTypeResolutionBatch();
     CreateManageColumnAccessBatch();
     CreateMetadataConversionBatch();
@@ -16,7 +16,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "src/carnot/planner/compiler/analyzer/convert_metadata_rule.h"
@@ -58,7 +60,13 @@ StatusOr<std::string> ConvertMetadataRule::FindKeyColumn(std::shared_ptr<TableTy
                                                          MetadataProperty* property,
                                                          IRNode* node_for_error) const {
   DCHECK_NE(property, nullptr);
-  for (const std::string& key_col : property->GetKeyColumnReprs()) {
+  // Pod IDs resolve with fewer lookups than UPIDs, and tables may have them resolved at ingest
+  // already, so they are preferred over the other key columns.
+  std::vector<std::string> key_columns = property->GetKeyColumnReprs();
+  const std::string pod_id_column = MetadataProperty::GetMetadataString(MetadataType::POD_ID);
+  std::stable_partition(key_columns.begin(), key_columns.end(),
+                        [&](const std::string& col) { return col == pod_id_column; });
+  for (const std::string& key_col : key_columns) {
     if (parent_type->HasColumn(key_col)) {
       return key_col;
     }
@@ -70,6 +78,20 @@ StatusOr<std::string> ConvertMetadataRule::FindKeyColumn(std::shared_ptr<TableTy
       absl::StrJoin(parent_type->ColumnNames(), ","));
 }
 
+StatusOr<bool> ConvertMetadataRule::ReplaceWithColumn(MetadataIR* metadata,
+                                                      const std::string& column_name,
+                                                      int64_t parent_op_idx) const {
+  auto graph = metadata->graph();
+  PL_ASSIGN_OR_RETURN(ColumnIR * column,
+                      graph->CreateNode<ColumnIR>(metadata->ast(), column_name, parent_op_idx));
+  for (int64_t parent_id : graph->dag().ParentsOf(metadata->id())) {
+    PL_RETURN_IF_ERROR(UpdateMetadataContainer(graph->Get(parent_id), metadata, column));
+  }
+  PL_RETURN_IF_ERROR(PropagateTypeChangesFromNode(graph, column, compiler_state_));
+  column->set_annotations(ExpressionIR::Annotations(metadata->property()->metadata_type()));
+  return true;
+}
+
 StatusOr<bool> ConvertMetadataRule::Apply(IRNode* ir_node) {
   if (!Match(ir_node, Metadata())) {
     return false;
@@ -85,6 +107,17 @@ StatusOr<bool> ConvertMetadataRule::Apply(IRNode* ir_node) {
   PL_ASSIGN_OR_RETURN(auto parent, metadata->ReferencedOperator());
   PL_ASSIGN_OR_RETURN(auto containing_ops, metadata->ContainingOperators());
 
+  // The parent may have the metadata as a column already, e.g. when it was resolved at ingest.
+  std::string md_column_name = MetadataProperty::GetMetadataString(md_type);
+  if (parent->resolved_table_type()->HasColumn(md_column_name)) {
+    PL_ASSIGN_OR_RETURN(auto md_column_type,
+                        parent->resolved_table_type()->GetColumnType(md_column_name));
+    auto md_value_type = std::static_pointer_cast<ValueType>(md_column_type);
+    if (md_column_type->IsValueType() && md_value_type->data_type() == column_type) {
+      return ReplaceWithColumn(metadata, md_column_name, parent_op_idx);
+    }
+  }
+
   PL_ASSIGN_OR_RETURN(std::string key_column_name,
                       FindKeyColumn(parent->resolved_table_type(), md_property, ir_node));
 
@@ -44,6 +44,11 @@ class ConvertMetadataRule : public Rule {
    */
   Status UpdateMetadataContainer(IRNode* container, MetadataIR* metadata,
                                  ExpressionIR* metadata_expr) const;
+  /**
+   * @brief Replaces the metadata with the column of the parent that holds it.
+   */
+  StatusOr<bool> ReplaceWithColumn(MetadataIR* metadata, const std::string& column_name,
+                                   int64_t parent_op_idx) const;
   StatusOr<std::string> FindKeyColumn(std::shared_ptr<TableType> parent_type,
                                       MetadataProperty* property, IRNode* node_for_error) const;
 };
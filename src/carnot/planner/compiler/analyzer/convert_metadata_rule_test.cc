@@ -88,6 +88,43 @@ TEST_F(ConvertMetadataRuleTest, multichild) {
   EXPECT_EQ(types::ST_POD_NAME, type->semantic_type());
 }
 
+TEST_F(ConvertMetadataRuleTest, prefers_precomputed_columns) {
+  auto relation = Relation(cpu_relation);
+  relation.AddColumn(types::DataType::UINT128, "upid");
+  relation.AddColumn(types::DataType::STRING, "pod_id");
+  compiler_state_->relation_map()->emplace("table", relation);
+
+  MetadataIR* service_ir = MakeMetadataIR("service", /* parent_op_idx */ 0);
+  service_ir->set_property(md_handler->GetProperty("service").ValueOrDie());
+  MetadataIR* pod_id_ir = MakeMetadataIR("pod_id", /* parent_op_idx */ 0);
+  pod_id_ir->set_property(md_handler->GetProperty("pod_id").ValueOrDie());
+  auto map = MakeMap(MakeMemSource(relation), {{"service", service_ir}, {"pod", pod_id_ir}});
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  ConvertMetadataRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+  EXPECT_EQ(0, graph->FindNodesThatMatch(Metadata()).size());
+
+  // The service is resolved from the pod ID rather than the UPID.
+  auto service_expr = map->col_exprs()[0].node;
+  ASSERT_MATCH(service_expr, Func());
+  auto service_func = static_cast<FuncIR*>(service_expr);
+  EXPECT_EQ("pod_id_to_service_name", service_func->func_name());
+  EXPECT_MATCH(service_func->all_args()[0], ColumnNode("pod_id"));
+  EXPECT_EQ(ExpressionIR::Annotations(MetadataType::SERVICE_NAME), service_func->annotations());
+
+  // The pod ID is read from the column directly.
+  auto pod_id_expr = map->col_exprs()[1].node;
+  EXPECT_MATCH(pod_id_expr, ColumnNode("pod_id"));
+  EXPECT_MATCH(pod_id_expr, ResolvedExpression());
+  EXPECT_EQ(ExpressionIR::Annotations(MetadataType::POD_ID),
+            static_cast<ColumnIR*>(pod_id_expr)->annotations());
+}
+
 TEST_F(ConvertMetadataRuleTest, missing_conversion_column) {
   auto relation = table_store::schema::Relation(cpu_relation);
   compiler_state_->relation_map()->emplace("table", relation);
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/analyzer/fold_constant_funcs_rule.h"
+#include "src/carnot/funcs/builtins/collections.h"
+#include "src/carnot/funcs/builtins/conditionals.h"
+#include "src/carnot/funcs/builtins/json_ops.h"
+#include "src/carnot/funcs/builtins/math_ops.h"
+#include "src/carnot/funcs/builtins/string_ops.h"
+#include "src/carnot/planner/ir/ast_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+StatusOr<udf::ScalarUDFDefinition*> GetUDFDefinition(const std::shared_ptr<udf::Registry>& registry,
+                                                     const std::string& name,
+                                                     const std::vector<ExpressionIR*>& args) {
+  std::vector<types::DataType> arg_types;
+  for (const ExpressionIR* arg : args) {
+    if (!arg->IsData()) {
+      return nullptr;
+    }
+    DCHECK(arg->IsDataTypeEvaluated());
+    arg_types.push_back(arg->EvaluatedDataType());
+  }
+  auto udf_or_s = registry->GetScalarUDFDefinition(name, arg_types);
+  if (!udf_or_s.ok() && udf_or_s.code() == statuspb::NOT_FOUND) {
+    return nullptr;
+  }
+  // UDFs with init args would need them split out of the args, those are left to run time.
+  if (udf_or_s.ok() && !udf_or_s.ValueOrDie()->init_arguments().empty()) {
+    return nullptr;
+  }
+  return udf_or_s;
+}
+
+StatusOr<ExpressionIR*> ExecUDF(IR* graph, const pypa::AstPtr& ast, udf::ScalarUDFDefinition* def,
+                                const std::vector<ExpressionIR*>& args) {
+  std::vector<std::shared_ptr<types::ColumnWrapper>> column_pool;
+  std::vector<const types::ColumnWrapper*> columns;
+  // Extract the argument values out into column wrappers.
+  for (ExpressionIR* arg : args) {
+    CHECK(arg->IsData()) << "Unexpected type for UDCF ";
+    DCHECK(arg->IsDataTypeEvaluated());
+    types::DataType arg_type = arg->EvaluatedDataType();
+    auto col = types::ColumnWrapper::Make(arg_type, 0);
+    column_pool.push_back(col);
+    switch (arg->type()) {
+      case IRNodeType::kInt:
+        col->Append<types::Int64Value>(static_cast<IntIR*>(arg)->val());
+        break;
+      case IRNodeType::kFloat:
+        col->Append<types::Float64Value>(static_cast<FloatIR*>(arg)->val());
+        break;
+      case IRNodeType::kString:
+        col->Append<types::StringValue>(static_cast<StringIR*>(arg)->str());
+        break;
+      case IRNodeType::kUInt128:
+        col->Append<types::UInt128Value>(static_cast<UInt128IR*>(arg)->val());
+        break;
+      case IRNodeType::kBool:
+        col->Append<types::BoolValue>(static_cast<BoolIR*>(arg)->val());
+        break;
+      case IRNodeType::kTime:
+        col->Append<types::Time64NSValue>(static_cast<TimeIR*>(arg)->val());
+        break;
+      default:
+        CHECK("Can't find Arg type");
+    }
+    columns.push_back(col.get());
+  }
+
+  // Execute the UDF.
+  auto output = types::ColumnWrapper::Make(def->exec_return_type(), 1);
+  auto function_ctx = std::make_unique<px::carnot::udf::FunctionContext>(nullptr, nullptr);
+  auto udf = def->Make();
+  PL_RETURN_IF_ERROR(def->ExecBatch(udf.get(), function_ctx.get(), columns, output.get(), 1));
+
+  // Convert the output type into a DataIR.
+  switch (def->exec_return_type()) {
+    case types::INT64:
+      return graph->CreateNode<IntIR>(ast, output->Get<types::Int64Value>(0).val);
+    case types::FLOAT64:
+      return graph->CreateNode<FloatIR>(ast, output->Get<types::Float64Value>(0).val);
+    case types::STRING:
+      return graph->CreateNode<StringIR>(ast, output->Get<types::StringValue>(0));
+    case types::UINT128:
+      return graph->CreateNode<UInt128IR>(ast, output->Get<types::UInt128Value>(0).val);
+    case types::BOOLEAN:
+      return graph->CreateNode<BoolIR>(ast, output->Get<types::BoolValue>(0).val);
+    case types::TIME64NS:
+      return graph->CreateNode<TimeIR>(ast, output->Get<types::Time64NSValue>(0).val);
+    default:
+      return CreateAstError(ast, "Unable to find a matching return type for the UDF");
+  }
+}
+
+FoldConstantFuncsRule::FoldConstantFuncsRule()
+    : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false),
+      udf_registry_(std::make_shared<udf::Registry>("constant_folding")) {
+  // Only deterministic UDFs that don't depend on the function context can be folded.
+  builtins::RegisterMathOpsOrDie(udf_registry_.get());
+  builtins::RegisterStringOpsOrDie(udf_registry_.get());
+  builtins::RegisterConditionalOpsOrDie(udf_registry_.get());
+  builtins::RegisterJSONOpsOrDie(udf_registry_.get());
+  builtins::RegisterCollectionOpsOrDie(udf_registry_.get());
+}
+
+StatusOr<bool> FoldConstantFuncsRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Func())) {
+    return false;
+  }
+  auto func = static_cast<FuncIR*>(ir_node);
+  PL_ASSIGN_OR_RETURN(udf::ScalarUDFDefinition * def,
+                      GetUDFDefinition(udf_registry_, func->func_name(), func->all_args()));
+  if (def == nullptr) {
+    return false;
+  }
+
+  IR* graph = func->graph();
+  std::vector<int64_t> container_ids = graph->dag().ParentsOf(func->id());
+  if (container_ids.empty()) {
+    return false;
+  }
+  for (int64_t container_id : container_ids) {
+    if (!Match(graph->Get(container_id), Func()) && !Match(graph->Get(container_id), Map()) &&
+        !Match(graph->Get(container_id), Filter())) {
+      return false;
+    }
+  }
+
+  // The containers delete the func once it's no longer referenced. Each of them gets its own
+  // result node, in case the func is shared.
+  for (int64_t container_id : container_ids) {
+    IRNode* container = graph->Get(container_id);
+    PL_ASSIGN_OR_RETURN(ExpressionIR * result, ExecUDF(graph, func->ast(), def, func->all_args()));
+    if (Match(container, Func())) {
+      PL_RETURN_IF_ERROR(static_cast<FuncIR*>(container)->UpdateArg(func, result));
+    } else if (Match(container, Map())) {
+      PL_RETURN_IF_ERROR(static_cast<MapIR*>(container)->UpdateColExpr(func, result));
+    } else {
+      PL_RETURN_IF_ERROR(static_cast<FilterIR*>(container)->SetFilterExpr(result));
+    }
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
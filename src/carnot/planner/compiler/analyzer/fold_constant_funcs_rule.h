@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/planner/ir/all_ir_nodes.h"
+#include "src/carnot/planner/rules/rules.h"
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Returns the definition of the UDF that can be evaluated on the args at compile time, or
+ * nullptr if the UDF isn't in the registry or the args aren't all constants.
+ */
+StatusOr<udf::ScalarUDFDefinition*> GetUDFDefinition(const std::shared_ptr<udf::Registry>& registry,
+                                                     const std::string& name,
+                                                     const std::vector<ExpressionIR*>& args);
+
+/**
+ * @brief Evaluates the UDF on the constant args and returns the result as a new DataIR.
+ */
+StatusOr<ExpressionIR*> ExecUDF(IR* graph, const pypa::AstPtr& ast, udf::ScalarUDFDefinition* def,
+                                const std::vector<ExpressionIR*>& args);
+
+class FoldConstantFuncsRule : public Rule {
+  /**
+   * @brief Evaluates calls of deterministic UDFs whose arguments are all constants, and replaces
+   * them with the resulting constant, so that they aren't evaluated for every row at run time.
+   * Nested calls get folded from the inside out, over repeated executions of the rule.
+   *
+   * Metadata UDFs aren't folded, they depend on the state of the agent that runs them.
+   */
+ public:
+  FoldConstantFuncsRule();
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  std::shared_ptr<udf::Registry> udf_registry_;
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
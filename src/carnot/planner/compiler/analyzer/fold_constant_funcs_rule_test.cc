@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/fold_constant_funcs_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using table_store::schema::Relation;
+
+using FoldConstantFuncsRuleTest = RulesTest;
+
+TEST_F(FoldConstantFuncsRuleTest, folds_nested_constant_funcs) {
+  auto src = MakeMemSource(MakeRelation());
+  auto nested = MakeMultFunc(MakeAddFunc(MakeInt(1), MakeInt(2)), MakeInt(3));
+  auto binned = MakeFunc("bin", {MakeInt(17), MakeInt(5)});
+  auto map = MakeMap(src, {{"folded", nested}, {"binned", binned}});
+  auto filter = MakeFilter(map, MakeEqualsFunc(MakeString("abc"), MakeString("abc")));
+
+  FoldConstantFuncsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+  // The outer func is folded once its args are.
+  while (rule.Execute(graph.get()).ConsumeValueOrDie()) {
+  }
+
+  EXPECT_EQ(0, graph->FindNodesThatMatch(Func()).size());
+  EXPECT_MATCH(map->col_exprs()[0].node, Int(9));
+  EXPECT_MATCH(map->col_exprs()[1].node, Int(15));
+  EXPECT_MATCH(filter->filter_expr(), Bool(true));
+}
+
+TEST_F(FoldConstantFuncsRuleTest, keeps_funcs_of_columns) {
+  auto src = MakeMemSource(MakeRelation());
+  auto col_func = MakeAddFunc(MakeColumn("count", 0), MakeAddFunc(MakeInt(1), MakeInt(2)));
+  auto map = MakeMap(src, {{"sum", col_func}});
+
+  FoldConstantFuncsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+
+  // Only the constant argument is folded.
+  EXPECT_EQ(col_func, map->col_exprs()[0].node);
+  EXPECT_MATCH(col_func->all_args()[0], ColumnNode("count"));
+  EXPECT_MATCH(col_func->all_args()[1], Int(3));
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ValueOrDie());
+}
+
+TEST_F(FoldConstantFuncsRuleTest, keeps_unknown_funcs) {
+  auto src = MakeMemSource(MakeRelation());
+  auto func = MakeFunc("upid_to_pod_name", {MakeUInt128("11285cdd-1de9-4ab1-ae6a-0ba08c8c676c")});
+  auto map = MakeMap(src, {{"pod", func}});
+
+  FoldConstantFuncsRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ValueOrDie());
+  EXPECT_EQ(func, map->col_exprs()[0].node);
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/analyzer/merge_limit_into_top_k_rule.h"
+
+#include <algorithm>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+StatusOr<bool> MergeLimitIntoTopKRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Limit())) {
+    return false;
+  }
+  auto limit = static_cast<LimitIR*>(ir_node);
+  // PEM only limits are placed intentionally, so leave them alone.
+  if (limit->pem_only() || !limit->limit_value_set()) {
+    return false;
+  }
+  CHECK_EQ(limit->parents().size(), 1UL);
+  auto parent_op = limit->parents()[0];
+  if (!Match(parent_op, TopK())) {
+    return false;
+  }
+  auto top_k = static_cast<TopKIR*>(parent_op);
+  // The other children of the top k still need all of its rows.
+  if (top_k->Children().size() > 1) {
+    return false;
+  }
+
+  top_k->SetLimitValue(std::min(top_k->limit_value(), limit->limit_value()));
+  PL_RETURN_IF_ERROR(limit->RemoveParent(top_k));
+  for (auto child : limit->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(limit, top_k));
+  }
+  PL_RETURN_IF_ERROR(limit->graph()->DeleteNode(limit->id()));
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
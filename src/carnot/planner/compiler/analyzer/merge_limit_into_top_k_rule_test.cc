@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/merge_limit_into_top_k_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+
+using MergeLimitIntoTopKRuleTest = RulesTest;
+TEST_F(MergeLimitIntoTopKRuleTest, merges_smaller_limit) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  TopKIR* top_k = MakeTopK(mem_src, {MakeColumn("cpu0", 0)}, {true}, 100);
+  LimitIR* limit = MakeLimit(top_k, 10);
+  auto limit_id = limit->id();
+  MemorySinkIR* sink = MakeMemSink(limit, "out");
+
+  MergeLimitIntoTopKRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  ASSERT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_FALSE(graph->HasNode(limit_id));
+  EXPECT_EQ(10, top_k->limit_value());
+  EXPECT_THAT(top_k->Children(), ElementsAre(sink));
+  EXPECT_THAT(sink->parents(), ElementsAre(top_k));
+}
+
+TEST_F(MergeLimitIntoTopKRuleTest, keeps_smaller_top_k) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  TopKIR* top_k = MakeTopK(mem_src, {MakeColumn("cpu0", 0)}, {true}, 5);
+  LimitIR* limit = MakeLimit(top_k, 10000);
+  auto limit_id = limit->id();
+  MakeMemSink(limit, "out");
+
+  MergeLimitIntoTopKRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  ASSERT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_FALSE(graph->HasNode(limit_id));
+  EXPECT_EQ(5, top_k->limit_value());
+}
+
+TEST_F(MergeLimitIntoTopKRuleTest, top_k_with_other_children) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  TopKIR* top_k = MakeTopK(mem_src, {MakeColumn("cpu0", 0)}, {true}, 100);
+  LimitIR* limit = MakeLimit(top_k, 10);
+  MakeMemSink(limit, "out");
+  MakeMemSink(top_k, "all");
+
+  MergeLimitIntoTopKRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(graph->HasNode(limit->id()));
+  EXPECT_EQ(100, top_k->limit_value());
+}
+
+TEST_F(MergeLimitIntoTopKRuleTest, pem_only_limit) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  TopKIR* top_k = MakeTopK(mem_src, {MakeColumn("cpu0", 0)}, {true}, 100);
+  LimitIR* limit = MakeLimit(top_k, 10, /* pem_only */ true);
+  MakeMemSink(limit, "out");
+
+  MergeLimitIntoTopKRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(graph->HasNode(limit->id()));
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
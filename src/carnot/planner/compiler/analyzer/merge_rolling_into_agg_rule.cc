@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/planner/compiler/analyzer/merge_rolling_into_agg_rule.h"
+
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+StatusOr<bool> MergeRollingIntoAggRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, OperatorWithParent(BlockingAgg(), Rolling()))) {
+    return false;
+  }
+  auto agg = static_cast<BlockingAggIR*>(ir_node);
+  DCHECK_EQ(agg->parents().size(), 1UL);
+  auto rolling = static_cast<RollingIR*>(agg->parents()[0]);
+  int64_t window_size;
+  if (Match(rolling->window_size(), Int())) {
+    window_size = static_cast<IntIR*>(rolling->window_size())->val();
+  } else if (rolling->window_size()->type() == IRNodeType::kTime) {
+    window_size = static_cast<TimeIR*>(rolling->window_size())->val();
+  } else {
+    return false;
+  }
+  if (window_size <= 0) {
+    return rolling->window_size()->CreateIRNodeError("Rolling window size must be positive, got $0",
+                                                     window_size);
+  }
+
+  // The groups of the rolling come before the groups of the aggregate.
+  std::vector<ColumnIR*> new_groups;
+  for (ColumnIR* g : rolling->groups()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col, CopyColumn(g));
+    new_groups.push_back(col);
+  }
+  new_groups.insert(new_groups.end(), agg->groups().begin(), agg->groups().end());
+  PL_RETURN_IF_ERROR(agg->SetGroups(new_groups));
+  PL_ASSIGN_OR_RETURN(ColumnIR * window_col, CopyColumn(rolling->window_col()));
+  PL_RETURN_IF_ERROR(agg->SetRollingWindow(window_col, window_size));
+
+  DCHECK_EQ(rolling->parents().size(), 1UL);
+  OperatorIR* rolling_parent = rolling->parents()[0];
+  PL_RETURN_IF_ERROR(agg->ReplaceParent(rolling, rolling_parent));
+  if (!rolling->Children().empty()) {
+    return true;
+  }
+  auto graph = rolling->graph();
+  auto rolling_id = rolling->id();
+  auto rolling_children = graph->dag().DependenciesOf(rolling_id);
+  PL_RETURN_IF_ERROR(graph->DeleteNode(rolling_id));
+  for (const auto& child_id : rolling_children) {
+    PL_RETURN_IF_ERROR(graph->DeleteOrphansInSubtree(child_id));
+  }
+  return true;
+}
+
+StatusOr<ColumnIR*> MergeRollingIntoAggRule::CopyColumn(ColumnIR* g) {
+  if (Match(g, Metadata())) {
+    return g->graph()->CreateNode<MetadataIR>(g->ast(), g->col_name(),
+                                              g->container_op_parent_idx());
+  }
+  return g->graph()->CreateNode<ColumnIR>(g->ast(), g->col_name(), g->container_op_parent_idx());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/merge_rolling_into_agg_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+
+using MergeRollingIntoAggRuleTest = RulesTest;
+TEST_F(MergeRollingIntoAggRuleTest, merges_rolling_and_groups) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  RollingIR* rolling = MakeRolling(mem_src, MakeColumn("time_", 0), MakeInt(1000));
+  ASSERT_OK(rolling->SetGroups({MakeColumn("col1", 0)}));
+  auto rolling_id = rolling->id();
+  BlockingAggIR* agg = MakeBlockingAgg(rolling, {MakeColumn("col2", 0)},
+                                       {{"mean", MakeMeanFunc(MakeColumn("col3", 0))}});
+  MakeMemSink(agg, "out");
+
+  MergeRollingIntoAggRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  ASSERT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_FALSE(graph->HasNode(rolling_id));
+  EXPECT_THAT(agg->parents(), ElementsAre(mem_src));
+  ASSERT_TRUE(agg->rolling());
+  EXPECT_EQ("time_", agg->window_col()->col_name());
+  EXPECT_EQ(1000, agg->window_size());
+  std::vector<std::string> group_names;
+  for (ColumnIR* g : agg->groups()) {
+    group_names.push_back(g->col_name());
+  }
+  EXPECT_THAT(group_names, ElementsAre("col1", "col2"));
+}
+
+TEST_F(MergeRollingIntoAggRuleTest, keeps_rolling_with_other_children) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  RollingIR* rolling = MakeRolling(mem_src, MakeColumn("time_", 0), MakeInt(1000));
+  BlockingAggIR* agg1 =
+      MakeBlockingAgg(rolling, {}, {{"mean", MakeMeanFunc(MakeColumn("col3", 0))}});
+  BlockingAggIR* agg2 =
+      MakeBlockingAgg(rolling, {}, {{"mean", MakeMeanFunc(MakeColumn("col4", 0))}});
+  MakeMemSink(agg1, "out1");
+  MakeMemSink(agg2, "out2");
+  auto rolling_id = rolling->id();
+
+  MergeRollingIntoAggRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  ASSERT_TRUE(result.ConsumeValueOrDie());
+
+  // The rolling is removed after the last aggregate is merged.
+  EXPECT_FALSE(graph->HasNode(rolling_id));
+  EXPECT_TRUE(agg1->rolling());
+  EXPECT_TRUE(agg2->rolling());
+  EXPECT_THAT(agg1->parents(), ElementsAre(mem_src));
+  EXPECT_THAT(agg2->parents(), ElementsAre(mem_src));
+}
+
+TEST_F(MergeRollingIntoAggRuleTest, waits_for_string_window_conversion) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  RollingIR* rolling = MakeRolling(mem_src, MakeColumn("time_", 0), MakeString("1m"));
+  BlockingAggIR* agg =
+      MakeBlockingAgg(rolling, {}, {{"mean", MakeMeanFunc(MakeColumn("col3", 0))}});
+  MakeMemSink(agg, "out");
+
+  MergeRollingIntoAggRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_FALSE(agg->rolling());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -18,6 +18,7 @@
 
 #include "src/carnot/planner/compiler/ast_visitor.h"
 
+#include "src/carnot/planner/compiler/analyzer/fold_constant_funcs_rule.h"
 #include "src/carnot/planner/compiler_error_context/compiler_error_context.h"
 #include "src/carnot/planner/ir/pattern_match.h"
 #include "src/carnot/planner/objects/collection_object.h"
@@ -931,85 +932,6 @@ StatusOr<QLObjectPtr> ASTVisitorImpl::ProcessNumber(const pypa::AstNumberPtr& no
   }
 }
 
-StatusOr<udf::ScalarUDFDefinition*> GetUDFDefinition(const std::shared_ptr<udf::Registry>& registry,
-                                                     const std::string& name,
-                                                     const std::vector<ExpressionIR*>& args) {
-  std::vector<types::DataType> arg_types;
-  for (const ExpressionIR* arg : args) {
-    if (!arg->IsData()) {
-      return nullptr;
-    }
-    DCHECK(arg->IsDataTypeEvaluated());
-    arg_types.push_back(arg->EvaluatedDataType());
-  }
-  auto udf_or_s = registry->GetScalarUDFDefinition(name, arg_types);
-  if (!udf_or_s.ok() && udf_or_s.code() == statuspb::NOT_FOUND) {
-    return nullptr;
-  }
-  return udf_or_s;
-}
-
-StatusOr<ExpressionIR*> ExecUDF(IR* graph, const pypa::AstPtr& ast, udf::ScalarUDFDefinition* def,
-                                const std::vector<ExpressionIR*>& args) {
-  std::vector<std::shared_ptr<types::ColumnWrapper>> column_pool;
-  std::vector<const types::ColumnWrapper*> columns;
-  // Extract the argument values out into column wrappers.
-  for (ExpressionIR* arg : args) {
-    CHECK(arg->IsData()) << "Unexpected type for UDCF ";
-    DCHECK(arg->IsDataTypeEvaluated());
-    types::DataType arg_type = arg->EvaluatedDataType();
-    auto col = types::ColumnWrapper::Make(arg_type, 0);
-    column_pool.push_back(col);
-    switch (arg->type()) {
-      case IRNodeType::kInt:
-        col->Append<types::Int64Value>(static_cast<IntIR*>(arg)->val());
-        break;
-      case IRNodeType::kFloat:
-        col->Append<types::Float64Value>(static_cast<FloatIR*>(arg)->val());
-        break;
-      case IRNodeType::kString:
-        col->Append<types::StringValue>(static_cast<StringIR*>(arg)->str());
-        break;
-      case IRNodeType::kUInt128:
-        col->Append<types::UInt128Value>(static_cast<UInt128IR*>(arg)->val());
-        break;
-      case IRNodeType::kBool:
-        col->Append<types::BoolValue>(static_cast<BoolIR*>(arg)->val());
-        break;
-      case IRNodeType::kTime:
-        col->Append<types::Time64NSValue>(static_cast<TimeIR*>(arg)->val());
-        break;
-      default:
-        CHECK("Can't find Arg type");
-    }
-    columns.push_back(col.get());
-  }
-
-  // Execute the UDF.
-  auto output = types::ColumnWrapper::Make(def->exec_return_type(), 1);
-  auto function_ctx = std::make_unique<px::carnot::udf::FunctionContext>(nullptr, nullptr);
-  auto udf = def->Make();
-  PL_RETURN_IF_ERROR(def->ExecBatch(udf.get(), function_ctx.get(), columns, output.get(), 1));
-
-  // Convert the output type into a DataIR.
-  switch (def->exec_return_type()) {
-    case types::INT64:
-      return graph->CreateNode<IntIR>(ast, output->Get<types::Int64Value>(0).val);
-    case types::FLOAT64:
-      return graph->CreateNode<FloatIR>(ast, output->Get<types::Float64Value>(0).val);
-    case types::STRING:
-      return graph->CreateNode<StringIR>(ast, output->Get<types::StringValue>(0));
-    case types::UINT128:
-      return graph->CreateNode<UInt128IR>(ast, output->Get<types::UInt128Value>(0).val);
-    case types::BOOLEAN:
-      return graph->CreateNode<BoolIR>(ast, output->Get<types::BoolValue>(0).val);
-    case types::TIME64NS:
-      return graph->CreateNode<TimeIR>(ast, output->Get<types::Time64NSValue>(0).val);
-    default:
-      return CreateAstError(ast, "Unable to find a matching return type for the UDF");
-  }
-}
-
 StatusOr<QLObjectPtr> ASTVisitorImpl::ProcessDataBinOp(const pypa::AstBinOpPtr& node,
                                                        const OperatorContext& op_context) {
   std::string op_str = pypa::to_string(node->op);
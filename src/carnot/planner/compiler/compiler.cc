@@ -69,12 +69,16 @@ StatusOr<std::shared_ptr<IR>> Compiler::CompileToIR(const std::string& query,
 
 Status Compiler::Analyze(IR* ir, CompilerState* compiler_state) {
   PL_ASSIGN_OR_RETURN(std::unique_ptr<Analyzer> analyzer, Analyzer::Create(compiler_state));
-  return analyzer->Execute(ir);
+  PL_RETURN_IF_ERROR(analyzer->Execute(ir));
+  compiler_state->AddRuleExecutionStats(analyzer->rule_execution_stats());
+  return Status::OK();
 }
 
 Status Compiler::Optimize(IR* ir, CompilerState* compiler_state) {
   PL_ASSIGN_OR_RETURN(std::unique_ptr<Optimizer> optimizer, Optimizer::Create(compiler_state));
-  return optimizer->Execute(ir);
+  PL_RETURN_IF_ERROR(optimizer->Execute(ir));
+  compiler_state->AddRuleExecutionStats(optimizer->rule_execution_stats());
+  return Status::OK();
 }
 
 StatusOr<std::shared_ptr<IR>> Compiler::QueryToIR(const std::string& query,
@@ -2734,6 +2734,35 @@ TEST_F(CompilerTest, RollingNonTimeUnsupported) {
               HasCompilerError("Windowing is only supported on time_ at the moment"));
 }
 
+constexpr char kRollingAggQuery[] = R"pxl(
+import px
+t1 = px.DataFrame(table='http_events', select=['time_', 'remote_port'])
+t1 = t1.rolling('3s').groupby('remote_port').agg(count=('remote_port', px.count))
+px.display(t1)
+)pxl";
+TEST_F(CompilerTest, RollingAggQuery) {
+  auto graph_or_s = compiler_.CompileToIR(kRollingAggQuery, compiler_state_.get());
+  ASSERT_OK(graph_or_s);
+  auto graph = graph_or_s.ConsumeValueOrDie();
+
+  EXPECT_EQ(0, graph->FindNodesOfType(IRNodeType::kRolling).size());
+  std::vector<IRNode*> agg_nodes = graph->FindNodesOfType(IRNodeType::kBlockingAgg);
+  ASSERT_EQ(agg_nodes.size(), 1);
+  auto agg = static_cast<BlockingAggIR*>(agg_nodes[0]);
+  ASSERT_TRUE(agg->rolling());
+  EXPECT_EQ("time_", agg->window_col()->col_name());
+  EXPECT_EQ(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(3)).count(),
+            agg->window_size());
+  Relation agg_relation({types::INT64, types::TIME64NS, types::INT64},
+                        {"remote_port", "time_", "count"});
+  EXPECT_THAT(*agg->resolved_table_type(), IsTableType(agg_relation));
+
+  planpb::Operator op;
+  ASSERT_OK(agg->ToProto(&op));
+  EXPECT_EQ("time_", op.agg_op().rolling_window().time_column_name());
+  EXPECT_EQ(agg->window_size(), op.agg_op().rolling_window().window_size_ns());
+}
+
 const char* kFunctionOptimizationQuery = R"pxl(
 import px
 bytes_per_mb = 1024.0 * 1024.0
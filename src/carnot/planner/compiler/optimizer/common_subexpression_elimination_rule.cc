@@ -0,0 +1,244 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/carnot/planner/compiler/optimizer/common_subexpression_elimination_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// A function expression of one of the children, along with the node that holds it, which is
+// either the child itself or the function that takes it as an argument.
+struct Occurrence {
+  OperatorIR* op;
+  IRNode* holder;
+  FuncIR* func;
+};
+
+bool ReadsColumn(const ExpressionIR* expr) {
+  if (Match(expr, ColumnNode())) {
+    return true;
+  }
+  if (!Match(expr, Func())) {
+    return false;
+  }
+  auto func = static_cast<const FuncIR*>(expr);
+  return std::any_of(func->all_args().begin(), func->all_args().end(), ReadsColumn);
+}
+
+// Operators like + and == are cheap to compute again, compared to writing out another column.
+bool CallsUDF(const ExpressionIR* expr) {
+  if (!Match(expr, Func())) {
+    return false;
+  }
+  auto func = static_cast<const FuncIR*>(expr);
+  return func->opcode() == FuncIR::Opcode::non_op ||
+         std::any_of(func->all_args().begin(), func->all_args().end(), CallsUDF);
+}
+
+void CollectSubtree(const ExpressionIR* expr, absl::flat_hash_set<int64_t>* ids) {
+  ids->insert(expr->id());
+  if (Match(expr, Func())) {
+    for (const ExpressionIR* arg : static_cast<const FuncIR*>(expr)->all_args()) {
+      CollectSubtree(arg, ids);
+    }
+  }
+}
+
+void CollectFuncs(OperatorIR* op, IRNode* holder, ExpressionIR* expr,
+                  std::vector<Occurrence>* occurrences) {
+  if (!Match(expr, Func())) {
+    return;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  if (ReadsColumn(func) && CallsUDF(func)) {
+    occurrences->push_back({op, holder, func});
+  }
+  for (ExpressionIR* arg : func->all_args()) {
+    CollectFuncs(op, func, arg, occurrences);
+  }
+}
+
+void ClearExpressionTypes(ExpressionIR* expr) {
+  expr->ClearResolvedType();
+  if (Match(expr, Func())) {
+    for (ExpressionIR* arg : static_cast<FuncIR*>(expr)->all_args()) {
+      ClearExpressionTypes(arg);
+    }
+  }
+}
+
+Status ReplaceExpression(const Occurrence& occurrence, ExpressionIR* new_expr) {
+  if (Match(occurrence.holder, Map())) {
+    return static_cast<MapIR*>(occurrence.holder)->UpdateColExpr(occurrence.func, new_expr);
+  }
+  if (Match(occurrence.holder, Filter())) {
+    return static_cast<FilterIR*>(occurrence.holder)->SetFilterExpr(new_expr);
+  }
+  DCHECK(Match(occurrence.holder, Func()));
+  return static_cast<FuncIR*>(occurrence.holder)->UpdateArg(occurrence.func, new_expr);
+}
+
+}  // namespace
+
+StatusOr<bool> CommonSubexpressionEliminationRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Operator())) {
+    return false;
+  }
+  auto op = static_cast<OperatorIR*>(ir_node);
+  if (!op->is_type_resolved()) {
+    return false;
+  }
+
+  std::vector<Occurrence> occurrences;
+  for (OperatorIR* child : op->Children()) {
+    if (child->parents().size() != 1) {
+      continue;
+    }
+    if (Match(child, Map())) {
+      for (const ColumnExpression& col_expr : static_cast<MapIR*>(child)->col_exprs()) {
+        CollectFuncs(child, child, col_expr.node, &occurrences);
+      }
+    } else if (Match(child, Filter())) {
+      CollectFuncs(child, child, static_cast<FilterIR*>(child)->filter_expr(), &occurrences);
+    }
+  }
+
+  // Group the occurrences by the expression they compute.
+  std::vector<std::vector<Occurrence>> groups;
+  for (const Occurrence& occurrence : occurrences) {
+    auto group = std::find_if(groups.begin(), groups.end(), [&](const auto& existing) {
+      return existing[0].func->Equals(occurrence.func);
+    });
+    if (group == groups.end()) {
+      groups.push_back({occurrence});
+    } else {
+      group->push_back(occurrence);
+    }
+  }
+
+  // Share the largest expressions first. The occurrences of smaller expressions within them are
+  // replaced along with them, so they only count if they still occur at least twice elsewhere.
+  std::vector<std::pair<int64_t, std::vector<Occurrence>>> sized_groups;
+  for (auto& group : groups) {
+    if (group.size() < 2) {
+      continue;
+    }
+    absl::flat_hash_set<int64_t> ids;
+    CollectSubtree(group[0].func, &ids);
+    sized_groups.emplace_back(ids.size(), std::move(group));
+  }
+  std::stable_sort(sized_groups.begin(), sized_groups.end(),
+                   [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  absl::flat_hash_set<int64_t> replaced_ids;
+  std::vector<std::vector<Occurrence>> shared_groups;
+  for (const auto& [size, group] : sized_groups) {
+    std::vector<Occurrence> remaining;
+    for (const Occurrence& occurrence : group) {
+      if (!replaced_ids.contains(occurrence.func->id())) {
+        remaining.push_back(occurrence);
+      }
+    }
+    if (remaining.size() < 2) {
+      continue;
+    }
+    for (const Occurrence& occurrence : remaining) {
+      CollectSubtree(occurrence.func, &replaced_ids);
+    }
+    shared_groups.push_back(std::move(remaining));
+  }
+  if (shared_groups.empty()) {
+    return false;
+  }
+
+  IR* graph = op->graph();
+  auto parent_type = op->resolved_table_type();
+  ColExpressionVector shared_exprs;
+  std::vector<std::string> names;
+  int64_t name_idx = 0;
+  for (const auto& group : shared_groups) {
+    std::string name;
+    do {
+      name = absl::StrCat(kColumnPrefix, name_idx++);
+    } while (parent_type->HasColumn(name));
+    names.push_back(name);
+    shared_exprs.emplace_back(name, group[0].func);
+  }
+
+  PL_ASSIGN_OR_RETURN(MapIR * shared_map,
+                      graph->CreateNode<MapIR>(op->ast(), op, shared_exprs,
+                                               /* keep_input_columns */ true));
+  PL_RETURN_IF_ERROR(ResolveOperatorType(shared_map, compiler_state_));
+
+  std::vector<OperatorIR*> children;
+  for (const auto& group : shared_groups) {
+    for (const Occurrence& occurrence : group) {
+      if (std::find(children.begin(), children.end(), occurrence.op) == children.end()) {
+        children.push_back(occurrence.op);
+      }
+    }
+  }
+  for (OperatorIR* child : children) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(op, shared_map));
+  }
+
+  for (const auto& [idx, group] : Enumerate(shared_groups)) {
+    for (const Occurrence& occurrence : group) {
+      PL_ASSIGN_OR_RETURN(ColumnIR * column,
+                          graph->CreateNode<ColumnIR>(occurrence.func->ast(), names[idx],
+                                                      /* parent_op_idx */ 0));
+      column->set_annotations(occurrence.func->annotations());
+      PL_RETURN_IF_ERROR(ReplaceExpression(occurrence, column));
+    }
+  }
+
+  // The children read the shared columns now, so their expressions are resolved again. Their
+  // outputs don't change, except for Filters, which pass on the shared columns unless pruned.
+  for (OperatorIR* child : children) {
+    auto output_names = child->resolved_table_type()->ColumnNames();
+    if (Match(child, Map())) {
+      for (const ColumnExpression& col_expr : static_cast<MapIR*>(child)->col_exprs()) {
+        ClearExpressionTypes(col_expr.node);
+      }
+    } else {
+      ClearExpressionTypes(static_cast<FilterIR*>(child)->filter_expr());
+    }
+    child->ClearResolvedType();
+    PL_RETURN_IF_ERROR(ResolveOperatorType(child, compiler_state_));
+    if (Match(child, Filter())) {
+      PL_RETURN_IF_ERROR(child->PruneOutputColumnsTo(
+          absl::flat_hash_set<std::string>(output_names.begin(), output_names.end())));
+    }
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Computes the function expressions that the Map and Filter children of an operator have in
+ * common only once. For example, two branches that both call px.upid_to_pod_name(df.upid) on the
+ * same dataframe:
+ *
+ *   src -> Map(pod=upid_to_pod_name(upid)) -> ...
+ *       -> Filter(upid_to_pod_name(upid) == 'pl/foo') -> ...
+ *
+ * become
+ *
+ *   src -> Map(<src columns>, _common_expr_0=upid_to_pod_name(upid))
+ *            -> Map(pod=_common_expr_0) -> ...
+ *            -> Filter(_common_expr_0 == 'pl/foo') -> ...
+ *
+ * The Filters are pruned back to their original columns, so the operators below the children are
+ * left as is. The largest common expressions are shared. Expressions that don't read any column, or
+ * that only apply operators like + and ==, are cheaper to compute again and are left to the
+ * children.
+ */
+class CommonSubexpressionEliminationRule : public Rule {
+ public:
+  static constexpr char kColumnPrefix[] = "_common_expr_";
+
+  explicit CommonSubexpressionEliminationRule(CompilerState* compiler_state)
+      : Rule(compiler_state, /*use_topo*/ true, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
+#include "src/carnot/planner/compiler/optimizer/common_subexpression_elimination_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+class CommonSubexpressionEliminationRuleTest : public RulesTest {
+ protected:
+  FuncIR* MakeSqrt(ExpressionIR* arg) { return MakeFunc("sqrt", {arg}); }
+};
+
+TEST_F(CommonSubexpressionEliminationRuleTest, shares_expression_of_map_and_filter) {
+  auto src = MakeMemSource("cpu", cpu_relation);
+  auto map = MakeMap(src, {{"sqrt", MakeSqrt(MakeColumn("cpu0", 0))}});
+  auto filter =
+      MakeFilter(src, MakeEqualsFunc(MakeSqrt(MakeColumn("cpu0", 0)), MakeColumn("cpu2", 0)));
+  MakeMemSink(map, "map");
+  MakeMemSink(filter, "filter");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  CommonSubexpressionEliminationRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_EQ(1, src->Children().size());
+  ASSERT_MATCH(src->Children()[0], Map());
+  auto shared_map = static_cast<MapIR*>(src->Children()[0]);
+  EXPECT_THAT(shared_map->Children(), ElementsAre(map, filter));
+  EXPECT_THAT(shared_map->resolved_table_type()->ColumnNames(),
+              ElementsAre("count", "cpu0", "cpu1", "cpu2", "_common_expr_0"));
+  auto shared_expr = shared_map->col_exprs()[4].node;
+  ASSERT_MATCH(shared_expr, Func());
+  EXPECT_EQ("sqrt", static_cast<FuncIR*>(shared_expr)->func_name());
+  EXPECT_MATCH(static_cast<FuncIR*>(shared_expr)->all_args()[0], ColumnNode("cpu0"));
+
+  EXPECT_MATCH(map->col_exprs()[0].node, ColumnNode("_common_expr_0"));
+  EXPECT_MATCH(map->col_exprs()[0].node, ResolvedExpression());
+  EXPECT_EQ(types::FLOAT64, map->col_exprs()[0].node->EvaluatedDataType());
+  EXPECT_MATCH(filter->filter_expr(), Equals(ColumnNode("_common_expr_0"), ColumnNode("cpu2")));
+  EXPECT_MATCH(filter->filter_expr(), ResolvedExpression());
+  // The filter doesn't pass on the shared column.
+  EXPECT_THAT(filter->resolved_table_type()->ColumnNames(),
+              ElementsAreArray(cpu_relation.col_names()));
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(CommonSubexpressionEliminationRuleTest, shares_largest_expressions) {
+  auto src = MakeMemSource("cpu", cpu_relation);
+  auto make_expr = [this]() { return MakeSubFunc(MakeSqrt(MakeColumn("cpu0", 0)), MakeInt(2)); };
+  auto map1 = MakeMap(src, {{"a", make_expr()}});
+  auto map2 = MakeMap(src, {{"b", MakeAddFunc(make_expr(), MakeInt(1))}});
+  // Only shares the square root with the other maps, where it's replaced along with the difference.
+  auto map3 = MakeMap(src, {{"c", MakeSqrt(MakeColumn("cpu0", 0))}});
+  MakeMemSink(map1, "map1");
+  MakeMemSink(map2, "map2");
+  MakeMemSink(map3, "map3");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  CommonSubexpressionEliminationRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_EQ(2, src->Children().size());
+  EXPECT_EQ(map3, src->Children()[0]);
+  ASSERT_MATCH(src->Children()[1], Map());
+  auto shared_map = static_cast<MapIR*>(src->Children()[1]);
+  EXPECT_THAT(shared_map->Children(), ElementsAre(map1, map2));
+  ASSERT_EQ(5, shared_map->col_exprs().size());
+  EXPECT_EQ("_common_expr_0", shared_map->col_exprs()[4].name);
+  EXPECT_MATCH(shared_map->col_exprs()[4].node, Subtract(Func(), Int(2)));
+
+  EXPECT_MATCH(map1->col_exprs()[0].node, ColumnNode("_common_expr_0"));
+  EXPECT_MATCH(map2->col_exprs()[0].node, Add(ColumnNode("_common_expr_0"), Int(1)));
+  EXPECT_MATCH(map3->col_exprs()[0].node, Func());
+}
+
+TEST_F(CommonSubexpressionEliminationRuleTest, skips_cheap_and_unique_expressions) {
+  auto src = MakeMemSource("cpu", cpu_relation);
+  auto map1 = MakeMap(src, {{"a", MakeSqrt(MakeColumn("cpu0", 0))},
+                            {"b", MakeAddFunc(MakeColumn("cpu2", 0), MakeInt(1))},
+                            {"c", MakeSqrt(MakeInt(4))}});
+  auto map2 = MakeMap(src, {{"a", MakeSqrt(MakeColumn("cpu1", 0))},
+                            {"b", MakeAddFunc(MakeColumn("cpu2", 0), MakeInt(1))},
+                            {"c", MakeSqrt(MakeInt(4))}});
+  MakeMemSink(map1, "map1");
+  MakeMemSink(map2, "map2");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  CommonSubexpressionEliminationRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_THAT(src->Children(), ElementsAre(map1, map2));
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
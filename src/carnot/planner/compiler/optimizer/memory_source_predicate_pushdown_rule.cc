@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/optimizer/memory_source_predicate_pushdown_rule.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+DEFINE_bool(planner_memory_source_evaluate_predicates,
+            gflags::BoolFromEnv("PL_PLANNER_MEMORY_SOURCE_EVALUATE_PREDICATES", true),
+            "Whether memory sources evaluate the predicates pushed down from a filter on their "
+            "rows, replacing the filter, when the predicates cover the whole filter expression.");
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// Returns false if the opcode isn't a comparison that zone maps can check. If the constant is on
+// the left hand side, the comparison is flipped so that it reads `column <op> constant`.
+bool ToCompareOp(FuncIR::Opcode opcode, bool flip, planpb::MemorySourcePredicate::CompareOp* op) {
+  switch (opcode) {
+    case FuncIR::Opcode::eq:
+      *op = planpb::MemorySourcePredicate::EQUAL;
+      return true;
+    case FuncIR::Opcode::neq:
+      *op = planpb::MemorySourcePredicate::NOT_EQUAL;
+      return true;
+    case FuncIR::Opcode::lt:
+      *op = flip ? planpb::MemorySourcePredicate::GREATER_THAN
+                 : planpb::MemorySourcePredicate::LESS_THAN;
+      return true;
+    case FuncIR::Opcode::lteq:
+      *op = flip ? planpb::MemorySourcePredicate::GREATER_THAN_EQUAL
+                 : planpb::MemorySourcePredicate::LESS_THAN_EQUAL;
+      return true;
+    case FuncIR::Opcode::gt:
+      *op = flip ? planpb::MemorySourcePredicate::LESS_THAN
+                 : planpb::MemorySourcePredicate::GREATER_THAN;
+      return true;
+    case FuncIR::Opcode::gteq:
+      *op = flip ? planpb::MemorySourcePredicate::LESS_THAN_EQUAL
+                 : planpb::MemorySourcePredicate::GREATER_THAN_EQUAL;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The types that the memory source can compare the rows of a column against.
+bool CanEvaluate(types::DataType data_type) {
+  switch (data_type) {
+    case types::DataType::BOOLEAN:
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+    case types::DataType::FLOAT64:
+    case types::DataType::UINT128:
+    case types::DataType::STRING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool MemorySourcePredicatePushdownRule::CollectPredicates(
+    MemorySourceIR* mem_src, ExpressionIR* expr,
+    std::vector<planpb::MemorySourcePredicate>* predicates) {
+  if (!Match(expr, Func())) {
+    return false;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  const auto& args = func->all_args();
+  if (func->opcode() == FuncIR::Opcode::logand) {
+    bool exact = true;
+    for (ExpressionIR* arg : args) {
+      exact &= CollectPredicates(mem_src, arg, predicates);
+    }
+    return exact;
+  }
+  if (args.size() != 2) {
+    return false;
+  }
+
+  bool flip = false;
+  ExpressionIR* col_expr = args[0];
+  ExpressionIR* value_expr = args[1];
+  if (Match(col_expr, DataNode()) && Match(value_expr, ColumnNode())) {
+    std::swap(col_expr, value_expr);
+    flip = true;
+  }
+  planpb::MemorySourcePredicate::CompareOp op;
+  if (!Match(col_expr, ColumnNode()) || !Match(value_expr, DataNode()) ||
+      !ToCompareOp(func->opcode(), flip, &op)) {
+    return false;
+  }
+
+  // Map the column back to its index in the table.
+  auto col_name = static_cast<ColumnIR*>(col_expr)->col_name();
+  const auto& col_names = mem_src->resolved_table_type()->ColumnNames();
+  auto it = std::find(col_names.begin(), col_names.end(), col_name);
+  if (it == col_names.end()) {
+    return false;
+  }
+  auto col_idx = mem_src->column_index_map()[std::distance(col_names.begin(), it)];
+
+  planpb::MemorySourcePredicate predicate;
+  predicate.set_column_idx(col_idx);
+  predicate.set_op(op);
+  if (!static_cast<DataIR*>(value_expr)->ToProto(predicate.mutable_value()).ok()) {
+    return false;
+  }
+  predicates->push_back(predicate);
+  // Comparisons between different types, e.g. a float column and an int, are left to the filter.
+  auto col_type_or_s = mem_src->resolved_table_type()->GetColumnType(col_name);
+  if (!col_type_or_s.ok()) {
+    return false;
+  }
+  auto col_type =
+      std::static_pointer_cast<ValueType>(col_type_or_s.ConsumeValueOrDie())->data_type();
+  return col_type == predicate.value().data_type() && CanEvaluate(col_type);
+}
+
+Status MemorySourcePredicatePushdownRule::RemoveFilter(MemorySourceIR* mem_src, FilterIR* filter) {
+  auto graph = filter->graph();
+  auto expr_id = filter->filter_expr()->id();
+  PL_RETURN_IF_ERROR(filter->RemoveParent(mem_src));
+  for (auto child : filter->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(filter, mem_src));
+  }
+  PL_RETURN_IF_ERROR(graph->DeleteNode(filter->id()));
+  return graph->DeleteOrphansInSubtree(expr_id);
+}
+
+StatusOr<bool> MemorySourcePredicatePushdownRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, MemorySource())) {
+    return false;
+  }
+  auto mem_src = static_cast<MemorySourceIR*>(ir_node);
+  // Other children of the source would need the batches the predicates skip.
+  auto children = mem_src->Children();
+  if (children.size() != 1 || !Match(children[0], Filter()) || !mem_src->predicates().empty() ||
+      !mem_src->is_type_resolved() || !mem_src->column_index_map_set()) {
+    return false;
+  }
+
+  auto filter = static_cast<FilterIR*>(children[0]);
+  std::vector<planpb::MemorySourcePredicate> predicates;
+  bool exact = CollectPredicates(mem_src, filter->filter_expr(), &predicates);
+  if (predicates.empty()) {
+    return false;
+  }
+  for (const auto& predicate : predicates) {
+    mem_src->AddPredicate(predicate);
+  }
+
+  // When the predicates are the whole filter, the source can evaluate them on the rows instead. The
+  // filter can only go if it doesn't also drop columns that its children don't need.
+  if (exact && FLAGS_planner_memory_source_evaluate_predicates && filter->is_type_resolved() &&
+      filter->resolved_table_type()->ColumnNames() ==
+          mem_src->resolved_table_type()->ColumnNames()) {
+    mem_src->set_evaluate_predicates(true);
+    PL_RETURN_IF_ERROR(RemoveFilter(mem_src, filter));
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
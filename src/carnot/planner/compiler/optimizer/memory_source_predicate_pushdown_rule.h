@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "src/carnot/planner/rules/rules.h"
+
+DECLARE_bool(planner_memory_source_evaluate_predicates);
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Copies the simple comparisons (`column <op> constant`, optionally joined by `and`) of a
+ * Filter that directly follows a MemorySource into the MemorySource's predicates. The table store
+ * uses them to skip cold batches whose zone maps show no possible matches.
+ *
+ * If the predicates cover the whole filter expression, the MemorySource also evaluates them on the
+ * rows of the batches it reads, and the Filter is removed. Otherwise the Filter is left in place
+ * since the predicates only prune whole batches.
+ */
+class MemorySourcePredicatePushdownRule : public Rule {
+ public:
+  MemorySourcePredicatePushdownRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  // Returns whether the predicates collected from the expression are equivalent to it.
+  static bool CollectPredicates(MemorySourceIR* mem_src, ExpressionIR* expr,
+                                std::vector<planpb::MemorySourcePredicate>* predicates);
+  static Status RemoveFilter(MemorySourceIR* mem_src, FilterIR* filter);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
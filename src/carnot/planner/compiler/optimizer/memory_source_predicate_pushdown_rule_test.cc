@@ -0,0 +1,173 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/optimizer/memory_source_predicate_pushdown_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+class MemorySourcePredicatePushdownRuleTest : public RulesTest {
+ protected:
+  FuncIR* MakeOpFunc(const std::string& op, ExpressionIR* left, ExpressionIR* right) {
+    return graph
+        ->CreateNode<FuncIR>(ast, FuncIR::op_map.find(op)->second,
+                             std::vector<ExpressionIR*>({left, right}))
+        .ConsumeValueOrDie();
+  }
+
+  MemorySourceIR* MakeResolvedMemSource(const std::vector<std::string>& col_names) {
+    return MakeResolvedMemSource(MakeRelation(), col_names);
+  }
+
+  MemorySourceIR* MakeResolvedMemSource(const table_store::schema::Relation& relation,
+                                        const std::vector<std::string>& col_names) {
+    MemorySourceIR* mem_src = MakeMemSource("source", relation, col_names);
+    table_store::schema::Relation selected;
+    for (const auto& col_name : col_names) {
+      selected.AddColumn(relation.GetColumnType(col_name), col_name);
+    }
+    EXPECT_OK(mem_src->SetResolvedType(TableType::Create(selected)));
+    return mem_src;
+  }
+};
+
+TEST_F(MemorySourcePredicatePushdownRuleTest, pushes_conjunction_of_comparisons) {
+  auto mem_src = MakeResolvedMemSource({"cpu0", "count"});
+  // count >= 500 and 1.5 > cpu0 and count + 1 == 2
+  auto filter_expr = MakeAndFunc(
+      MakeAndFunc(MakeOpFunc(">=", MakeColumn("count", 0), MakeInt(500)),
+                  MakeOpFunc(">", MakeFloat(1.5), MakeColumn("cpu0", 0))),
+      MakeEqualsFunc(MakeAddFunc(MakeColumn("count", 0), MakeInt(1)), MakeInt(2)));
+  auto filter = MakeFilter(mem_src, filter_expr);
+  MakeMemSink(filter, "out");
+
+  MemorySourcePredicatePushdownRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_EQ(2, mem_src->predicates().size());
+  const auto& count_pred = mem_src->predicates()[0];
+  EXPECT_EQ(0, count_pred.column_idx());
+  EXPECT_EQ(planpb::MemorySourcePredicate::GREATER_THAN_EQUAL, count_pred.op());
+  EXPECT_EQ(types::DataType::INT64, count_pred.value().data_type());
+  EXPECT_EQ(500, count_pred.value().int64_value());
+
+  // The constant was on the left, so the comparison is flipped.
+  const auto& cpu_pred = mem_src->predicates()[1];
+  EXPECT_EQ(1, cpu_pred.column_idx());
+  EXPECT_EQ(planpb::MemorySourcePredicate::LESS_THAN, cpu_pred.op());
+  EXPECT_EQ(types::DataType::FLOAT64, cpu_pred.value().data_type());
+  EXPECT_EQ(1.5, cpu_pred.value().float64_value());
+
+  // Running the rule again doesn't add duplicates.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(MemorySourcePredicatePushdownRuleTest, skips_disjunctions) {
+  auto mem_src = MakeResolvedMemSource({"count"});
+  auto filter_expr = MakeOrFunc(MakeOpFunc(">=", MakeColumn("count", 0), MakeInt(500)),
+                                MakeOpFunc("<", MakeColumn("count", 0), MakeInt(10)));
+  auto filter = MakeFilter(mem_src, filter_expr);
+  MakeMemSink(filter, "out");
+
+  MemorySourcePredicatePushdownRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, mem_src->predicates().size());
+}
+
+TEST_F(MemorySourcePredicatePushdownRuleTest, skips_sources_with_other_children) {
+  auto mem_src = MakeResolvedMemSource({"count"});
+  auto filter = MakeFilter(mem_src, MakeOpFunc(">=", MakeColumn("count", 0), MakeInt(500)));
+  MakeMemSink(filter, "filtered");
+  MakeMemSink(mem_src, "unfiltered");
+
+  MemorySourcePredicatePushdownRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, mem_src->predicates().size());
+}
+
+TEST_F(MemorySourcePredicatePushdownRuleTest, replaces_filter_covered_by_predicates) {
+  table_store::schema::Relation relation(
+      {types::DataType::TIME64NS, types::DataType::UINT128, types::DataType::STRING},
+      {"time_", "upid", "remote_addr"});
+  auto mem_src = MakeResolvedMemSource(relation, {"upid", "remote_addr"});
+  auto filter_expr =
+      MakeAndFunc(MakeEqualsFunc(MakeColumn("upid", 0),
+                                 MakeUInt128("00000001-0000-0002-0000-000000000003")),
+                  MakeOpFunc("!=", MakeString("10.0.0.1"), MakeColumn("remote_addr", 0)));
+  auto filter = MakeFilter(mem_src, filter_expr);
+  ASSERT_OK(filter->SetResolvedType(mem_src->resolved_table_type()->Copy()));
+  auto sink = MakeMemSink(filter, "out");
+
+  MemorySourcePredicatePushdownRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_EQ(2, mem_src->predicates().size());
+  const auto& upid_pred = mem_src->predicates()[0];
+  EXPECT_EQ(1, upid_pred.column_idx());
+  EXPECT_EQ(planpb::MemorySourcePredicate::EQUAL, upid_pred.op());
+  EXPECT_EQ(types::DataType::UINT128, upid_pred.value().data_type());
+  const auto& addr_pred = mem_src->predicates()[1];
+  EXPECT_EQ(2, addr_pred.column_idx());
+  EXPECT_EQ(planpb::MemorySourcePredicate::NOT_EQUAL, addr_pred.op());
+  EXPECT_EQ("10.0.0.1", addr_pred.value().string_value());
+
+  // The source evaluates the predicates on its rows, so the filter is no longer needed.
+  EXPECT_TRUE(mem_src->evaluate_predicates());
+  EXPECT_FALSE(graph->HasNode(filter->id()));
+  EXPECT_THAT(sink->parents(), ::testing::ElementsAre(mem_src));
+}
+
+TEST_F(MemorySourcePredicatePushdownRuleTest, keeps_filter_with_mismatched_types) {
+  auto mem_src = MakeResolvedMemSource({"cpu0"});
+  // The column is a float, so the int comparison is left to the filter.
+  auto filter = MakeFilter(mem_src, MakeOpFunc(">", MakeColumn("cpu0", 0), MakeInt(1)));
+  ASSERT_OK(filter->SetResolvedType(mem_src->resolved_table_type()->Copy()));
+  MakeMemSink(filter, "out");
+
+  MemorySourcePredicatePushdownRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(1, mem_src->predicates().size());
+  EXPECT_FALSE(mem_src->evaluate_predicates());
+  EXPECT_THAT(mem_src->Children(), ::testing::ElementsAre(filter));
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
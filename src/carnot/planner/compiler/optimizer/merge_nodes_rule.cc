@@ -22,7 +22,9 @@
 #include "src/carnot/planner/ir/operator_ir.h"
 
 #include <algorithm>
+#include <limits>
 #include <queue>
+#include <string>
 
 namespace px {
 namespace carnot {
@@ -116,35 +118,38 @@ bool CompareExpressionLists(const ColExpressionVector& exprs_a,
   return true;
 }
 
-bool DoTimeIntervalsMerge(MemorySourceIR* src_a, MemorySourceIR* src_b) {
-  if (src_a->IsTimeSet() != src_b->IsTimeSet()) {
+bool HasTimeColumn(CompilerState* compiler_state, const std::string& table_name) {
+  auto relation_map = compiler_state->relation_map();
+  auto relation = relation_map->find(table_name);
+  return relation != relation_map->end() && relation->second.HasColumn(MergeNodesRule::kTimeColumnName);
+}
+
+/**
+ * @brief Returns whether the time ranges of the memory sources allow them to merge.
+ *
+ * Sources that read the same range merge as is. Otherwise the merged source reads all of their
+ * ranges and each of them filters its own range back out of it (see RestrictToTimeRanges), which
+ * only pays off if the ranges overlap or are adjacent. A source without a range reads the whole
+ * table, which every other range overlaps.
+ *
+ * Overlap isn't transitive, but FindMatchingSets only compares the operators to the first operator
+ * of each set, so the ranges of a set still cover one contiguous range.
+ */
+bool DoTimeIntervalsMerge(MemorySourceIR* src_a, MemorySourceIR* src_b, bool has_time_column) {
+  if (src_a->IsTimeSet() == src_b->IsTimeSet() &&
+      (!src_a->IsTimeSet() || (src_a->time_start_ns() == src_b->time_start_ns() &&
+                               src_a->time_stop_ns() == src_b->time_stop_ns()))) {
+    return true;
+  }
+  if (!has_time_column) {
     return false;
   }
-  auto time_start_a = src_a->time_start_ns();
-  auto time_start_b = src_b->time_start_ns();
-  auto time_stop_a = src_a->time_stop_ns();
-  auto time_stop_b = src_b->time_stop_ns();
-
-  return time_start_a == time_start_b && time_stop_a == time_stop_b;
-
-  // TODO(philkuz) (PP-1812) Enable the following when we have better management of undoing a merge.
-
-  // // Check whether intervals (if set) overlap.
-  // if (src_a->IsTimeSet() && src_b->IsTimeSet()) {
-  //   auto time_start_a = src_a->time_start_ns();
-  //   auto time_start_b = src_b->time_start_ns();
-  //   auto time_stop_a = src_a->time_stop_ns();
-  //   auto time_stop_b = src_b->time_stop_ns();
-  //   // If a starts first, then b only overlaps if b starts before the end of the a interval.
-  //   if (time_start_a <= time_start_b && !(time_start_b < time_stop_a)) {
-  //     return false;
-  //   }
-
-  //   // If b starts first, then a only overlaps if a ctarts before the end of the b interval.
-  //   if (time_start_b <= time_start_a && !(time_start_a < time_stop_b)) {
-  //     return false;
-  //   }
-  // }
+  if (!src_a->IsTimeSet() || !src_b->IsTimeSet()) {
+    return true;
+  }
+  // The ranges include both their start and stop times.
+  return src_a->time_start_ns() - 1 <= src_b->time_stop_ns() &&
+         src_b->time_start_ns() - 1 <= src_a->time_stop_ns();
 }
 
 bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
@@ -158,11 +163,10 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
   } else if (Match(a, MemorySource())) {
     auto src_a = static_cast<MemorySourceIR*>(a);
     auto src_b = static_cast<MemorySourceIR*>(b);
-    if (!DoTimeIntervalsMerge(src_a, src_b)) {
+    if (src_a->table_name() != src_b->table_name() || src_a->streaming() != src_b->streaming()) {
       return false;
     }
-
-    return src_a->table_name() == src_b->table_name();
+    return DoTimeIntervalsMerge(src_a, src_b, HasTimeColumn(compiler_state_, src_a->table_name()));
   } else if (Match(a, Map())) {
     auto map_a = static_cast<MapIR*>(a);
     auto map_b = static_cast<MapIR*>(b);
@@ -193,6 +197,15 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     if (!EqualStringVector(join_a->suffix_strs(), join_b->suffix_strs())) {
       return false;
     }
+    if (join_a->is_as_of() != join_b->is_as_of()) {
+      return false;
+    }
+    if (join_a->is_as_of() &&
+        (join_a->tolerance_ns() != join_b->tolerance_ns() ||
+         !CompareColumns({join_a->left_time_column(), join_a->right_time_column()},
+                         {join_b->left_time_column(), join_b->right_time_column()}))) {
+      return false;
+    }
     return true;
   } else if (Match(a, Filter())) {
     auto filter_a = static_cast<FilterIR*>(a);
@@ -325,7 +338,7 @@ StatusOr<OperatorIR*> MergeNodesRule::MergeOps(IR* graph,
         columns.push_back(col);
         column_idx_map.push_back(other_src->column_index_map()[idx]);
       }
-      time_not_set |= !base_src->IsTimeSet();
+      time_not_set |= !other_src->IsTimeSet();
 
       if (!time_not_set) {
         start_time = std::min(other_src->time_start_ns(), start_time);
@@ -421,6 +434,94 @@ StatusOr<MapIR*> MakeNoOpMap(IR* graph, CompilerState* compiler_state, OperatorI
   return map;
 }
 
+StatusOr<ExpressionIR*> MakeTimeBound(IR* graph, MemorySourceIR* src, const std::string& op,
+                                      int64_t time_ns) {
+  PL_ASSIGN_OR_RETURN(ColumnIR * time_col,
+                      graph->CreateNode<ColumnIR>(src->ast(), MergeNodesRule::kTimeColumnName,
+                                                  /* parent_op_idx */ 0));
+  PL_ASSIGN_OR_RETURN(TimeIR * time, graph->CreateNode<TimeIR>(src->ast(), time_ns));
+  return graph->CreateNode<FuncIR>(src->ast(), FuncIR::op_map.find(op)->second,
+                                   std::vector<ExpressionIR*>{time_col, time});
+}
+
+/**
+ * @brief Inserts a Filter below the memory source that only keeps the rows of its time range, for
+ * when it's merged into a source that reads more than that. The Filter outputs the same columns
+ * as the source did, so the children of the source are left as is.
+ */
+Status AddTimeRangeFilter(CompilerState* compiler_state, IR* graph, MemorySourceIR* src,
+                          bool restrict_start, bool restrict_stop) {
+  DCHECK(restrict_start || restrict_stop);
+  auto output_names = src->resolved_table_type()->ColumnNames();
+  if (!src->resolved_table_type()->HasColumn(MergeNodesRule::kTimeColumnName)) {
+    const auto& relation = compiler_state->relation_map()->at(src->table_name());
+    auto columns = src->column_names();
+    auto column_idx_map = src->column_index_map();
+    columns.push_back(MergeNodesRule::kTimeColumnName);
+    column_idx_map.push_back(relation.GetColumnIndex(MergeNodesRule::kTimeColumnName));
+    src->SetColumnNames(columns);
+    src->SetColumnIndexMap(column_idx_map);
+    src->ClearResolvedType();
+    ResolveTypesRule rule(compiler_state);
+    PL_RETURN_IF_ERROR(rule.Apply(src));
+  }
+
+  ExpressionIR* filter_expr = nullptr;
+  if (restrict_start) {
+    PL_ASSIGN_OR_RETURN(filter_expr, MakeTimeBound(graph, src, ">=", src->time_start_ns()));
+  }
+  if (restrict_stop) {
+    PL_ASSIGN_OR_RETURN(ExpressionIR * stop_bound,
+                        MakeTimeBound(graph, src, "<=", src->time_stop_ns()));
+    if (filter_expr == nullptr) {
+      filter_expr = stop_bound;
+    } else {
+      PL_ASSIGN_OR_RETURN(filter_expr, graph->CreateNode<FuncIR>(
+                                           src->ast(), FuncIR::op_map.find("and")->second,
+                                           std::vector<ExpressionIR*>{filter_expr, stop_bound}));
+    }
+  }
+
+  auto children = src->Children();
+  PL_ASSIGN_OR_RETURN(FilterIR * filter, graph->CreateNode<FilterIR>(src->ast(), src, filter_expr));
+  for (OperatorIR* child : children) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(src, filter));
+  }
+  ResolveTypesRule rule(compiler_state);
+  PL_RETURN_IF_ERROR(rule.Apply(filter));
+  return filter->PruneOutputColumnsTo(
+      absl::flat_hash_set<std::string>(output_names.begin(), output_names.end()));
+}
+
+Status MergeNodesRule::RestrictToTimeRanges(IR* graph, const std::vector<OperatorIR*>& srcs) {
+  bool time_set = true;
+  int64_t start_time = std::numeric_limits<int64_t>::max();
+  int64_t stop_time = std::numeric_limits<int64_t>::min();
+  for (OperatorIR* op : srcs) {
+    DCHECK(Match(op, MemorySource()));
+    auto src = static_cast<MemorySourceIR*>(op);
+    time_set &= src->IsTimeSet();
+    if (src->IsTimeSet()) {
+      start_time = std::min(src->time_start_ns(), start_time);
+      stop_time = std::max(src->time_stop_ns(), stop_time);
+    }
+  }
+
+  for (OperatorIR* op : srcs) {
+    auto src = static_cast<MemorySourceIR*>(op);
+    if (!src->IsTimeSet()) {
+      continue;
+    }
+    bool restrict_start = !time_set || src->time_start_ns() > start_time;
+    bool restrict_stop = !time_set || src->time_stop_ns() < stop_time;
+    if (restrict_start || restrict_stop) {
+      PL_RETURN_IF_ERROR(
+          AddTimeRangeFilter(compiler_state_, graph, src, restrict_start, restrict_stop));
+    }
+  }
+  return Status::OK();
+}
+
 Status ReplaceOpsWithMerged(CompilerState* compiler_state, OperatorIR* merged,
                             const std::vector<OperatorIR*>& operators_to_merge) {
   absl::flat_hash_map<OperatorIR*, std::vector<OperatorIR*>> child_to_parent_map;
@@ -483,6 +584,9 @@ StatusOr<bool> MergeNodesRule::Execute(IR* graph) {
   // matching_set_q is the queue of matching sets to merge together.
   std::queue<MatchingSet> matching_set_q;
   for (const auto& s : FindMatchingSets(srcs)) {
+    if (s.operators.size() > 1) {
+      PL_RETURN_IF_ERROR(RestrictToTimeRanges(graph, s.operators));
+    }
     matching_set_q.push(s);
   }
 
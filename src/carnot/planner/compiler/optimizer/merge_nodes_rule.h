@@ -40,9 +40,14 @@ struct MatchingSet {
  * multiple sources, meaning query writers are more free in composing functions together without
  * worrying too much about optimization.
  *
+ * Memory sources of the same table merge even if they read different columns or overlapping time
+ * ranges, so that a script with several widgets over one table reads it once. Each branch filters
+ * its own time range out of the merged source and only uses the columns it selected.
  */
 class MergeNodesRule : public Rule {
  public:
+  static constexpr char kTimeColumnName[] = "time_";
+
   explicit MergeNodesRule(CompilerState* compiler_state)
       : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
 
@@ -98,6 +103,17 @@ class MergeNodesRule : public Rule {
    */
   StatusOr<OperatorIR*> MergeOps(IR* graph, const std::vector<OperatorIR*>& operators_to_merge);
 
+  /**
+   * @brief Prepares memory sources with different time ranges to be merged. The merged source
+   * reads all of their ranges, so a Filter on the time column is inserted below each source that
+   * reads less than that, to keep only the rows of its own range.
+   *
+   * @param graph: the graph to create the Filters in.
+   * @param srcs: the memory sources of a matching set.
+   * @return Status: error if the Filters couldn't be created.
+   */
+  Status RestrictToTimeRanges(IR* graph, const std::vector<OperatorIR*>& srcs);
+
  private:
   // TODO(philkuz) need to remove the dependency on Rule so we don't have to override Apply().
   StatusOr<bool> Apply(IRNode*) override {
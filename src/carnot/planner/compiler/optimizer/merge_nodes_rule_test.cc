@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <utility>
 #include <vector>
 
 #include "src/carnot/planner/compiler/analyzer/analyzer.h"
@@ -152,19 +153,27 @@ TEST_F(MergeNodesTest, merge_memory_sources_different_columns) {
   EXPECT_THAT(mem_src->column_names(), UnorderedElementsAre("upid", "cpu0", "agent_id"));
 }
 
-TEST_F(MergeNodesTest, memory_sources_with_different_ranges_fails) {
-  // TODO(philkuz) (PP-1812) remove this test as it will be incorrect.
-  // Make sure that memory sources don't match if they have different time ranges.
+void ExpectTimeBound(ExpressionIR* expr, FuncIR::Opcode opcode, int64_t time_ns) {
+  ASSERT_MATCH(expr, Func());
+  auto func = static_cast<FuncIR*>(expr);
+  EXPECT_EQ(opcode, func->opcode());
+  ASSERT_EQ(2, func->all_args().size());
+  EXPECT_MATCH(func->all_args()[0], ColumnNode("time_"));
+  ASSERT_EQ(IRNodeType::kTime, func->all_args()[1]->type());
+  EXPECT_EQ(time_ns, static_cast<TimeIR*>(func->all_args()[1])->val());
+}
+
+TEST_F(MergeNodesTest, merge_memory_sources_intersecting_time_ranges) {
   std::vector<OperatorIR*> srcs;
   {
-    auto mem_src = MakeMemSource("cpu", {"upid", "cpu0"});
+    auto mem_src = MakeMemSource("http_events", {"upid", "remote_addr"});
     mem_src->SetTimeValuesNS(10, 100);
     MakeMemSink(mem_src, "");
     srcs.push_back(mem_src);
   }
 
   {
-    auto mem_src = MakeMemSource("cpu", {"upid", "agent_id"});
+    auto mem_src = MakeMemSource("http_events", {"upid", "req_path"});
     mem_src->SetTimeValuesNS(50, 150);
     MakeMemSink(mem_src, "");
     srcs.push_back(mem_src);
@@ -173,57 +182,91 @@ TEST_F(MergeNodesTest, memory_sources_with_different_ranges_fails) {
   EXPECT_OK(Analyze(graph));
 
   MergeNodesRule rule(compiler_state_.get());
-  EXPECT_FALSE(rule.CanMerge(srcs[0], srcs[1]));
-}
+  EXPECT_TRUE(rule.CanMerge(srcs[0], srcs[1]));
 
-TEST_F(MergeNodesTest, DISABLED_merge_memory_sources_intersecting_time_ranges) {
-  // TODO(philkuz) (PP-1812) enable this when you can merge memory sources together with
-  // intersecting time ranges.
-  std::vector<OperatorIR*> srcs;
-  {
-    auto mem_src = MakeMemSource("cpu", {"upid", "cpu0"});
-    mem_src->SetTimeValuesNS(10, 100);
-    MakeMemSink(mem_src, "");
-    srcs.push_back(mem_src);
-  }
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
 
-  {
-    auto mem_src = MakeMemSource("cpu", {"upid", "agent_id"});
-    mem_src->SetTimeValuesNS(50, 150);
-    MakeMemSink(mem_src, "");
-    srcs.push_back(mem_src);
+  auto mem_srcs = graph->FindNodesThatMatch(MemorySource());
+  ASSERT_EQ(1, mem_srcs.size());
+  auto mem_src = static_cast<MemorySourceIR*>(mem_srcs[0]);
+  EXPECT_EQ(mem_src->table_name(), "http_events");
+  EXPECT_THAT(mem_src->column_names(),
+              UnorderedElementsAre("upid", "remote_addr", "time_", "req_path"));
+  EXPECT_EQ(mem_src->time_start_ns(), 10);
+  EXPECT_EQ(mem_src->time_stop_ns(), 150);
+
+  // Each branch filters its own time range out of the merged one, with its original columns.
+  ASSERT_EQ(2, mem_src->Children().size());
+  ASSERT_MATCH(mem_src->Children()[0], Filter());
+  ASSERT_MATCH(mem_src->Children()[1], Filter());
+  auto filter0 = static_cast<FilterIR*>(mem_src->Children()[0]);
+  auto filter1 = static_cast<FilterIR*>(mem_src->Children()[1]);
+  // The order of the children isn't deterministic.
+  if (filter0->resolved_table_type()->HasColumn("req_path")) {
+    std::swap(filter0, filter1);
   }
+  ExpectTimeBound(filter0->filter_expr(), FuncIR::Opcode::lteq, 100);
+  ExpectTimeBound(filter1->filter_expr(), FuncIR::Opcode::gteq, 50);
+  EXPECT_THAT(filter0->resolved_table_type()->ColumnNames(), ElementsAre("upid", "remote_addr"));
+  EXPECT_THAT(filter1->resolved_table_type()->ColumnNames(), ElementsAre("upid", "req_path"));
+}
+
+TEST_F(MergeNodesTest, merge_memory_sources_with_and_without_time_range) {
+  auto all_time = MakeMemSource("http_events", {"time_", "upid"});
+  MakeMemSink(all_time, "");
+  auto ranged = MakeMemSource("http_events", {"time_", "upid"});
+  ranged->SetTimeValuesNS(10, 100);
+  MakeMemSink(ranged, "");
 
   EXPECT_OK(Analyze(graph));
 
   MergeNodesRule rule(compiler_state_.get());
-  EXPECT_TRUE(rule.CanMerge(srcs[0], srcs[1]));
-
-  auto merged_op_or_s = rule.MergeOps(graph.get(), srcs);
-  EXPECT_OK(merged_op_or_s);
-
-  auto merged_op = merged_op_or_s.ConsumeValueOrDie();
+  EXPECT_TRUE(rule.CanMerge(all_time, ranged));
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  auto mem_srcs = graph->FindNodesThatMatch(MemorySource());
+  ASSERT_EQ(1, mem_srcs.size());
+  auto mem_src = static_cast<MemorySourceIR*>(mem_srcs[0]);
+  EXPECT_FALSE(mem_src->IsTimeSet());
+
+  auto filters = graph->FindNodesThatMatch(Filter());
+  ASSERT_EQ(1, filters.size());
+  auto filter = static_cast<FilterIR*>(filters[0]);
+  EXPECT_EQ(mem_src, filter->parents()[0]);
+  ASSERT_MATCH(filter->filter_expr(), LogicalAnd(Func(), Func()));
+  auto bounds = static_cast<FuncIR*>(filter->filter_expr())->all_args();
+  ExpectTimeBound(bounds[0], FuncIR::Opcode::gteq, 10);
+  ExpectTimeBound(bounds[1], FuncIR::Opcode::lteq, 100);
+}
 
-  ASSERT_MATCH(merged_op, MemorySource());
-  MemorySourceIR* mem_src = static_cast<MemorySourceIR*>(merged_op);
-  EXPECT_EQ(mem_src->table_name(), "cpu");
-  EXPECT_THAT(mem_src->column_names(), UnorderedElementsAre("upid", "cpu0", "agent_id"));
+TEST_F(MergeNodesTest, memory_sources_without_time_column_need_equal_ranges) {
+  auto src0 = MakeMemSource("cpu", {"upid", "cpu0"});
+  src0->SetTimeValuesNS(10, 100);
+  auto src1 = MakeMemSource("cpu", {"upid", "cpu0"});
+  src1->SetTimeValuesNS(50, 150);
+  auto src2 = MakeMemSource("cpu", {"upid", "cpu0"});
+  src2->SetTimeValuesNS(10, 100);
 
-  EXPECT_EQ(mem_src->time_start_ns(), 10);
-  EXPECT_EQ(mem_src->time_stop_ns(), 150);
+  MergeNodesRule rule(compiler_state_.get());
+  EXPECT_FALSE(rule.CanMerge(src0, src1));
+  EXPECT_TRUE(rule.CanMerge(src0, src2));
 }
 
 TEST_F(MergeNodesTest, memory_sources_with_non_intersecting_time_ranges) {
   std::vector<OperatorIR*> srcs;
   {
-    auto mem_src = MakeMemSource("cpu", {"upid", "cpu0"});
+    auto mem_src = MakeMemSource("http_events", {"upid", "remote_addr"});
     mem_src->SetTimeValuesNS(10, 50);
     MakeMemSink(mem_src, "");
     srcs.push_back(mem_src);
   }
 
   {
-    auto mem_src = MakeMemSource("cpu", {"upid", "agent_id"});
+    auto mem_src = MakeMemSource("http_events", {"upid", "req_path"});
     mem_src->SetTimeValuesNS(100, 150);
     MakeMemSink(mem_src, "");
     srcs.push_back(mem_src);
@@ -23,9 +23,12 @@
 #include <unordered_set>
 #include <vector>
 
+#include "src/carnot/planner/compiler/optimizer/common_subexpression_elimination_rule.h"
+#include "src/carnot/planner/compiler/optimizer/memory_source_predicate_pushdown_rule.h"
 #include "src/carnot/planner/compiler/optimizer/merge_nodes_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unconnected_operators_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unused_columns_rule.h"
+#include "src/carnot/planner/compiler/optimizer/select_join_build_side_rule.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
 #include "src/carnot/planner/ir/ir.h"
@@ -57,15 +60,37 @@ class Optimizer : public RuleExecutor<IR> {
     merge_nodes_batch->AddRule<MergeNodesRule>(compiler_state_);
   }
 
+  // Runs after MergeNodes, so that the branches of duplicate sources have a common parent, and
+  // before PruneUnusedColumns, which drops the inputs the shared Maps don't need.
+  void CreateCommonSubexpressionEliminationBatch() {
+    RuleBatch* cse_batch = CreateRuleBatch<FailOnMax>("CommonSubexpressionElimination", 2);
+    cse_batch->AddRule<CommonSubexpressionEliminationRule>(compiler_state_);
+  }
+
   void CreatePruneUnusedColumnsBatch() {
     RuleBatch* prune_unused_columns = CreateRuleBatch<FailOnMax>("PruneUnusedColumns", 2);
     prune_unused_columns->AddRule<PruneUnusedColumnsRule>();
   }
 
+  // Runs after MergeNodes so that merged sources can't end up with another branch's predicates.
+  void CreateMemorySourcePredicatePushdownBatch() {
+    RuleBatch* predicate_pushdown =
+        CreateRuleBatch<FailOnMax>("MemorySourcePredicatePushdown", 2);
+    predicate_pushdown->AddRule<MemorySourcePredicatePushdownRule>();
+  }
+
+  void CreateSelectJoinBuildSideBatch() {
+    RuleBatch* join_build_side = CreateRuleBatch<FailOnMax>("SelectJoinBuildSide", 2);
+    join_build_side->AddRule<SelectJoinBuildSideRule>(compiler_state_);
+  }
+
   Status Init() {
     CreatePruneUnconnectedOpsBatch();
     CreateMergeNodesBatch();
+    CreateCommonSubexpressionEliminationBatch();
     CreatePruneUnusedColumnsBatch();
+    CreateMemorySourcePredicatePushdownBatch();
+    CreateSelectJoinBuildSideBatch();
     return Status::OK();
   }
 
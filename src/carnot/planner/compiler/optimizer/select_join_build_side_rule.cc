@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/optimizer/select_join_build_side_rule.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+std::optional<double> SelectJoinBuildSideRule::EstimateRows(OperatorIR* op) {
+  auto it = estimates_.find(op->id());
+  if (it != estimates_.end()) {
+    return it->second;
+  }
+  auto estimate = EstimateRowsImpl(op);
+  estimates_[op->id()] = estimate;
+  return estimate;
+}
+
+std::optional<double> SelectJoinBuildSideRule::EstimateRowsImpl(OperatorIR* op) {
+  if (Match(op, MemorySource())) {
+    const auto& row_counts = compiler_state_->table_row_counts();
+    auto it = row_counts.find(static_cast<MemorySourceIR*>(op)->table_name());
+    if (it == row_counts.end()) {
+      return std::nullopt;
+    }
+    return static_cast<double>(it->second);
+  }
+  if (Match(op, EmptySource())) {
+    return 0;
+  }
+  if (op->parents().empty()) {
+    // Other sources, e.g. UDTFs, don't have statistics.
+    return std::nullopt;
+  }
+
+  std::vector<double> parent_rows;
+  for (OperatorIR* parent : op->parents()) {
+    auto rows = EstimateRows(parent);
+    if (!rows.has_value()) {
+      return std::nullopt;
+    }
+    parent_rows.push_back(*rows);
+  }
+
+  if (Match(op, Union())) {
+    double rows = 0;
+    for (double parent : parent_rows) {
+      rows += parent;
+    }
+    return rows;
+  }
+  if (Match(op, Join())) {
+    // Assume that every row of the larger parent matches about one row of the smaller one.
+    return *std::max_element(parent_rows.begin(), parent_rows.end());
+  }
+  if (Match(op, Filter())) {
+    return parent_rows[0] * kFilterSelectivity;
+  }
+  if (Match(op, Limit())) {
+    return std::min(parent_rows[0], static_cast<double>(static_cast<LimitIR*>(op)->limit_value()));
+  }
+  if (Match(op, TopK())) {
+    return std::min(parent_rows[0], static_cast<double>(static_cast<TopKIR*>(op)->limit_value()));
+  }
+  if (Match(op, BlockingAgg())) {
+    if (static_cast<BlockingAggIR*>(op)->groups().empty()) {
+      return 1;
+    }
+    return std::max(1.0, parent_rows[0] * kGroupBySelectivity);
+  }
+  // Maps, drops and the like output a row for every input row.
+  return parent_rows[0];
+}
+
+StatusOr<bool> SelectJoinBuildSideRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Join())) {
+    return false;
+  }
+  auto join = static_cast<JoinIR*>(ir_node);
+  // As-of joins merge their parents rather than building a hash table from either.
+  if (join->build_side() != planpb::JoinOperator::BUILD_SIDE_DEFAULT ||
+      join->parents().size() != 2 || join->is_as_of()) {
+    return false;
+  }
+  // Time ordered joins have to probe the parent with the time_ column.
+  const auto& col_names = join->column_names();
+  if (std::find(col_names.begin(), col_names.end(), "time_") != col_names.end()) {
+    return false;
+  }
+
+  auto left_rows = EstimateRows(join->parents()[0]);
+  auto right_rows = EstimateRows(join->parents()[1]);
+  if (!left_rows.has_value() || !right_rows.has_value()) {
+    return false;
+  }
+  join->set_build_side(*right_rows < *left_rows ? planpb::JoinOperator::BUILD_RIGHT
+                                                : planpb::JoinOperator::BUILD_LEFT);
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Picks the parent that a Join builds its hash table from, based on estimates of how many
+ * rows each parent produces. The smaller parent is built, so that joining a large table against
+ * a small one doesn't hash the large one.
+ *
+ * The estimates start out from the row counts of the tables in the CompilerState and are carried
+ * through the operators with fixed selectivities, through the joins of a multi-way join as well.
+ * Joins that are ordered by a time_ column, or whose parents can't be estimated, are left as is.
+ */
+class SelectJoinBuildSideRule : public Rule {
+ public:
+  // The fraction of rows estimated to pass a filter.
+  static constexpr double kFilterSelectivity = 0.5;
+  // The number of groups of an aggregate, as a fraction of its input rows.
+  static constexpr double kGroupBySelectivity = 0.1;
+
+  explicit SelectJoinBuildSideRule(CompilerState* compiler_state)
+      : Rule(compiler_state, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+  /**
+   * @return the estimated number of rows the operator outputs, or std::nullopt if it can't be
+   * estimated.
+   */
+  std::optional<double> EstimateRows(OperatorIR* op);
+
+  StatusOr<bool> Execute(IR* graph) override {
+    estimates_.clear();
+    return Rule::Execute(graph);
+  }
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  std::optional<double> EstimateRowsImpl(OperatorIR* op);
+
+  // Estimates of the operators visited so far in this execution. The rule only changes the build
+  // side of joins, so they don't change while it runs.
+  absl::flat_hash_map<int64_t, std::optional<double>> estimates_;
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/optimizer/select_join_build_side_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+class SelectJoinBuildSideRuleTest : public RulesTest {
+ protected:
+  void SetUpImpl() override {
+    RulesTest::SetUpImpl();
+    compiler_state_->set_table_row_counts({{"http_events", 1000000}, {"pods", 100}});
+  }
+
+  JoinIR* MakeInnerJoin(OperatorIR* left, OperatorIR* right) {
+    return MakeJoin({left, right}, "inner", {MakeColumn("count", 0)}, {MakeColumn("count", 1)});
+  }
+};
+
+TEST_F(SelectJoinBuildSideRuleTest, builds_smaller_parent) {
+  auto big_left = MakeInnerJoin(MakeMemSource("http_events"), MakeMemSource("pods"));
+  auto small_left = MakeInnerJoin(MakeMemSource("pods"), MakeMemSource("http_events"));
+  MakeMemSink(big_left, "big_left");
+  MakeMemSink(small_left, "small_left");
+
+  SelectJoinBuildSideRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(planpb::JoinOperator::BUILD_RIGHT, big_left->build_side());
+  EXPECT_EQ(planpb::JoinOperator::BUILD_LEFT, small_left->build_side());
+
+  // The build sides are only picked once.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(SelectJoinBuildSideRuleTest, estimates_through_operators) {
+  SelectJoinBuildSideRule rule(compiler_state_.get());
+  auto http_events = MakeMemSource("http_events");
+  EXPECT_EQ(1000000, rule.EstimateRows(http_events));
+  EXPECT_EQ(1000000 * SelectJoinBuildSideRule::kFilterSelectivity,
+            rule.EstimateRows(MakeFilter(http_events, MakeEqualsFunc(MakeColumn("count", 0),
+                                                                     MakeInt(1)))));
+  EXPECT_EQ(10, rule.EstimateRows(MakeLimit(http_events, 10)));
+  EXPECT_EQ(1000000 * SelectJoinBuildSideRule::kGroupBySelectivity,
+            rule.EstimateRows(MakeBlockingAgg(http_events, MakeColumn("count", 0),
+                                              MakeColumn("cpu0", 0))));
+  EXPECT_FALSE(rule.EstimateRows(MakeMemSource("unknown_table")).has_value());
+}
+
+TEST_F(SelectJoinBuildSideRuleTest, multi_way_join) {
+  // (http_events join pods) join (pods limit 10): the second join builds the limited pods, since
+  // the first join is estimated to output as many rows as http_events.
+  auto events_pods = MakeInnerJoin(MakeMemSource("http_events"), MakeMemSource("pods"));
+  auto limited_pods = MakeLimit(MakeMemSource("pods"), 10);
+  auto join = MakeInnerJoin(limited_pods, events_pods);
+  MakeMemSink(join, "out");
+
+  SelectJoinBuildSideRule rule(compiler_state_.get());
+  ASSERT_OK(rule.Execute(graph.get()));
+  EXPECT_EQ(planpb::JoinOperator::BUILD_RIGHT, events_pods->build_side());
+  EXPECT_EQ(planpb::JoinOperator::BUILD_LEFT, join->build_side());
+}
+
+TEST_F(SelectJoinBuildSideRuleTest, keeps_joins_without_estimates) {
+  auto join = MakeInnerJoin(MakeMemSource("http_events"), MakeMemSource("unknown_table"));
+  MakeMemSink(join, "out");
+
+  SelectJoinBuildSideRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(planpb::JoinOperator::BUILD_SIDE_DEFAULT, join->build_side());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -551,6 +551,13 @@ class OperatorTests : public ::testing::Test {
     return limit;
   }
 
+  TopKIR* MakeTopK(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+                   const std::vector<bool>& descending, int64_t limit_value) {
+    TopKIR* top_k = graph->CreateNode<TopKIR>(ast, parent, sort_columns, descending, limit_value)
+                        .ConsumeValueOrDie();
+    return top_k;
+  }
+
   LimitIR* MakeLimit(OperatorIR* parent, int64_t limit_value, bool pem_only) {
     LimitIR* limit =
         graph->CreateNode<LimitIR>(ast, parent, limit_value, pem_only).ConsumeValueOrDie();
@@ -1334,6 +1341,13 @@ void CompareCloneNode(BlockingAggIR* new_ir, BlockingAggIR* old_ir, const std::s
   for (size_t i = 0; i < new_groups.size(); ++i) {
     CompareClone(new_groups[i], old_groups[i], new_ir->graph() == old_ir->graph(), err_string);
   }
+
+  ASSERT_EQ(new_ir->rolling(), old_ir->rolling()) << err_string;
+  if (new_ir->rolling()) {
+    CompareClone(new_ir->window_col(), old_ir->window_col(), new_ir->graph() == old_ir->graph(),
+                 err_string);
+    EXPECT_EQ(new_ir->window_size(), old_ir->window_size()) << err_string;
+  }
 }
 
 template <>
@@ -1377,6 +1391,16 @@ void CompareCloneNode(LimitIR* new_ir, LimitIR* old_ir, const std::string& err_s
   EXPECT_EQ(new_ir->limit_value_set(), old_ir->limit_value_set()) << err_string;
 }
 
+template <>
+void CompareCloneNode(TopKIR* new_ir, TopKIR* old_ir, const std::string& err_string) {
+  EXPECT_EQ(new_ir->limit_value(), old_ir->limit_value()) << err_string;
+  EXPECT_EQ(new_ir->descending(), old_ir->descending()) << err_string;
+  ASSERT_EQ(new_ir->sort_columns().size(), old_ir->sort_columns().size()) << err_string;
+  for (size_t i = 0; i < new_ir->sort_columns().size(); ++i) {
+    CompareClone(new_ir->sort_columns()[i], old_ir->sort_columns()[i], err_string);
+  }
+}
+
 template <>
 void CompareCloneNode(FuncIR* new_ir, FuncIR* old_ir, const std::string& err_string) {
   EXPECT_TRUE(new_ir->Equals(old_ir)) << err_string;
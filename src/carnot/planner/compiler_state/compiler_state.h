@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "src/carnot/planner/compiler_state/registry_info.h"
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
 
 #include "src/common/base/base.h"
 #include "src/shared/types/types.h"
@@ -91,6 +92,7 @@ struct RedactionOptions {
 
 using RelationMap = std::unordered_map<std::string, table_store::schema::Relation>;
 using SensitiveColumnMap = absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>;
+using TableRowCounts = absl::flat_hash_map<std::string, int64_t>;
 class CompilerState : public NotCopyable {
  public:
   /**
@@ -158,6 +160,21 @@ class CompilerState : public NotCopyable {
   const RedactionOptions& redaction_options() { return redaction_options_; }
   void set_redaction_options(const RedactionOptions& options) { redaction_options_ = options; }
 
+  // The number of rows in each table, for the tables it is known for. Used to estimate the cost of
+  // operators, so it doesn't have to be exact.
+  const TableRowCounts& table_row_counts() const { return table_row_counts_; }
+  void set_table_row_counts(TableRowCounts table_row_counts) {
+    table_row_counts_ = std::move(table_row_counts);
+  }
+
+  // The execution stats of the rules of every rule executor that ran on the query so far.
+  const std::vector<distributedpb::RuleExecutionStats>& rule_execution_stats() const {
+    return rule_execution_stats_;
+  }
+  void AddRuleExecutionStats(const std::vector<distributedpb::RuleExecutionStats>& stats) {
+    rule_execution_stats_.insert(rule_execution_stats_.end(), stats.begin(), stats.end());
+  }
+
  private:
   std::unique_ptr<RelationMap> relation_map_;
   SensitiveColumnMap table_names_to_sensitive_columns_;
@@ -170,6 +187,8 @@ class CompilerState : public NotCopyable {
   const std::string result_address_;
   const std::string result_ssl_targetname_;
   RedactionOptions redaction_options_;
+  TableRowCounts table_row_counts_;
+  std::vector<distributedpb::RuleExecutionStats> rule_execution_stats_;
 };
 
 }  // namespace planner
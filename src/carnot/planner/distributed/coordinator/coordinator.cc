@@ -34,6 +34,11 @@
 #include "src/common/uuid/uuid.h"
 #include "src/shared/upid/upid.h"
 
+DEFINE_bool(planner_partial_aggs, gflags::BoolFromEnv("PL_PLANNER_PARTIAL_AGGS", false),
+            "Whether aggregates whose UDAs all support partial aggregation are split into partial "
+            "aggregates on the agents and a merge on the Kelvin, so that the agents send one "
+            "serialized state per group instead of their rows.");
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -158,10 +163,31 @@ Status CoordinatorImpl::RemoveSourcesAndDependentOperators(
   return plan->Prune(nodes_to_remove);
 }
 
+namespace {
+
+// Orders Carnot instances by the number of queries they have, then by their CPU usage, then by
+// their memory. Instances that didn't report their load count as idle.
+bool IsLessLoaded(const distributedpb::CarnotInfo& a, const distributedpb::CarnotInfo& b) {
+  const auto& a_load = a.load();
+  const auto& b_load = b.load();
+  int64_t a_queries = a_load.num_running_queries() + a_load.num_queued_queries();
+  int64_t b_queries = b_load.num_running_queries() + b_load.num_queued_queries();
+  if (a_queries != b_queries) {
+    return a_queries < b_queries;
+  }
+  if (a_load.cpu_usage() != b_load.cpu_usage()) {
+    return a_load.cpu_usage() < b_load.cpu_usage();
+  }
+  return a_load.memory_bytes() < b_load.memory_bytes();
+}
+
+}  // namespace
+
 const distributedpb::CarnotInfo& CoordinatorImpl::GetRemoteProcessor() const {
-  // TODO(philkuz) update this with a more sophisticated strategy in the future.
   DCHECK_GT(remote_processor_nodes_.size(), 0UL);
-  return remote_processor_nodes_[0];
+  // Ties go to the first processor, so the choice is stable when there is no load information.
+  return *std::min_element(remote_processor_nodes_.begin(), remote_processor_nodes_.end(),
+                           IsLessLoaded);
 }
 
 /**
@@ -237,9 +263,8 @@ StatusOr<SchemaToAgentsMap> LoadSchemaMap(
 }
 
 StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const IR* logical_plan) {
-  // TODO(zasgar) set support_partial_agg to true to enable partial aggs.
   PL_ASSIGN_OR_RETURN(std::unique_ptr<Splitter> splitter,
-                      Splitter::Create(compiler_state_, /* support_partial_agg */ false));
+                      Splitter::Create(compiler_state_, FLAGS_planner_partial_aggs));
   PL_ASSIGN_OR_RETURN(std::unique_ptr<BlockingSplitPlan> split_plan,
                       splitter->SplitKelvinAndAgents(logical_plan));
   auto distributed_plan = std::make_unique<DistributedPlan>();
@@ -169,6 +169,24 @@ TEST_F(CoordinatorTest, one_pem_three_kelvin) {
   }
 }
 
+TEST_F(CoordinatorTest, picks_least_loaded_kelvin) {
+  auto ps = LoadDistributedStatePb(kOnePEMThreeKelvinsDistributedState);
+  // kelvin1 has the most queries, kelvin2 and kelvin3 have as many but kelvin3 uses more CPU.
+  ps.mutable_carnot_info(1)->mutable_load()->set_num_running_queries(3);
+  ps.mutable_carnot_info(2)->mutable_load()->set_num_running_queries(1);
+  ps.mutable_carnot_info(2)->mutable_load()->set_cpu_usage(0.5);
+  ps.mutable_carnot_info(3)->mutable_load()->set_num_queued_queries(1);
+  ps.mutable_carnot_info(3)->mutable_load()->set_cpu_usage(1.5);
+  auto coordinator = Coordinator::Create(compiler_state_.get(), ps).ConsumeValueOrDie();
+
+  MakeGraph();
+
+  auto physical_plan = coordinator->Coordinate(graph.get()).ConsumeValueOrDie();
+  ASSERT_EQ(physical_plan->dag().nodes().size(), 2UL);
+  auto kelvin_instance = physical_plan->Get(0);
+  EXPECT_EQ("kelvin2", kelvin_instance->carnot_info().query_broker_address());
+}
+
 constexpr char kBadAgentSpecificationState[] = R"proto(
 carnot_info {
   query_broker_address: "pem"
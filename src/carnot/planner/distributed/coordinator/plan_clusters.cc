@@ -35,37 +35,65 @@ namespace carnot {
 namespace planner {
 namespace distributed {
 
+namespace {
+
+// Marks the operator as removed, along with the descendants that have no other parents left.
+void RemoveSubtree(OperatorIR* op, absl::flat_hash_set<int64_t>* removed) {
+  if (!removed->insert(op->id()).second) {
+    return;
+  }
+  for (OperatorIR* child : op->Children()) {
+    bool all_parents_removed = true;
+    for (OperatorIR* parent : child->parents()) {
+      all_parents_removed = all_parents_removed && removed->contains(parent->id());
+    }
+    if (all_parents_removed) {
+      RemoveSubtree(child, removed);
+    }
+  }
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<IR>> PlanCluster::CreatePlan(const IR* base_query) const {
-  // TODO(philkuz) invert this so we don't clone everything.
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> new_ir, base_query->Clone());
-  for (const auto& op : ops_to_remove) {
+  // Work out which operators remain before copying anything, so that only those get copied.
+  absl::flat_hash_set<int64_t> removed;
+  for (OperatorIR* op : ops_to_remove) {
     // Some ops to remove are dependent upon each other, so they might be removed beforehand.
-    if (!new_ir->HasNode(op->id())) {
+    if (removed.contains(op->id())) {
       continue;
     }
-    auto cur_op = new_ir->Get(op->id());
-    CHECK(cur_op != nullptr);
-    CHECK(Match(cur_op, Operator()));
+    RemoveSubtree(op, &removed);
     std::queue<OperatorIR*> ancestor_to_maybe_delete_q;
-    for (const auto& p : static_cast<OperatorIR*>(new_ir->Get(op->id()))->parents()) {
+    for (OperatorIR* p : op->parents()) {
       ancestor_to_maybe_delete_q.push(p);
     }
-
-    PL_RETURN_IF_ERROR(new_ir->DeleteSubtree(op->id()));
     while (!ancestor_to_maybe_delete_q.empty()) {
       OperatorIR* ancestor = ancestor_to_maybe_delete_q.front();
       ancestor_to_maybe_delete_q.pop();
+      if (removed.contains(ancestor->id())) {
+        continue;
+      }
       // If all the children have been deleted, clean up the ancestor.
-      if (ancestor->Children().size() != 0) {
+      auto children = ancestor->Children();
+      if (!std::all_of(children.begin(), children.end(),
+                       [&](OperatorIR* child) { return removed.contains(child->id()); })) {
         continue;
       }
-      for (const auto& p : ancestor->parents()) {
+      for (OperatorIR* p : ancestor->parents()) {
         ancestor_to_maybe_delete_q.push(p);
       }
-      PL_RETURN_IF_ERROR(new_ir->DeleteSubtree(ancestor->id()));
+      RemoveSubtree(ancestor, &removed);
+    }
+  }
+
+  absl::flat_hash_set<int64_t> remaining_ops;
+  for (IRNode* node : base_query->FindNodesThatMatch(Operator())) {
+    if (!removed.contains(node->id())) {
+      remaining_ops.insert(node->id());
     }
   }
-  return new_ir;
+  return base_query->CloneOperators(remaining_ops);
 }
 
 /**
@@ -69,9 +69,33 @@ StatusOr<bool> PruneUnavailableSourcesRule::MaybePruneMemorySource(MemorySourceI
     PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
     return true;
   }
+
+  if (!MemorySourceOverlapsTimeRange(mem_src, carnot_info_)) {
+    PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
+    return true;
+  }
   return false;
 }
 
+bool PruneUnavailableSourcesRule::MemorySourceOverlapsTimeRange(
+    MemorySourceIR* mem_src, const distributedpb::CarnotInfo& carnot_info) {
+  if (!mem_src->IsTimeSet()) {
+    return true;
+  }
+  for (const auto& table_info : carnot_info.table_info()) {
+    if (table_info.table() != mem_src->table_name() || !table_info.has_time_range()) {
+      continue;
+    }
+    const auto& time_range = table_info.time_range();
+    // Rows older than the min time have expired, and rows written since are newer than it.
+    if (mem_src->time_stop_ns() < time_range.min_time_ns()) {
+      return false;
+    }
+    return mem_src->time_start_ns() <= time_range.max_time_ns() + kMaxTimeStalenessNS;
+  }
+  return true;
+}
+
 bool PruneUnavailableSourcesRule::AgentSupportsMemorySources() {
   return carnot_info_.has_data_store() && !carnot_info_.has_grpc_server() &&
          carnot_info_.processes_data();
@@ -43,6 +43,18 @@ class PruneUnavailableSourcesRule : public Rule {
   static bool UDTFMatchesFilters(UDTFSourceIR* source,
                                  const distributedpb::CarnotInfo& carnot_info);
 
+  /**
+   * @brief Returns false if the Carnot instance can't hold rows of the memory source's table within
+   * the time range of the memory source, going by the time range it last reported for the table.
+   * Instances that didn't report a time range for the table may hold any rows.
+   */
+  static bool MemorySourceOverlapsTimeRange(MemorySourceIR* mem_src,
+                                            const distributedpb::CarnotInfo& carnot_info);
+
+  // The time ranges are reported with the heartbeats, so the table may have received newer rows
+  // since. Memory sources are only pruned by the last time when they start this much after it.
+  static constexpr int64_t kMaxTimeStalenessNS = 60LL * 1000 * 1000 * 1000;
+
  private:
   StatusOr<bool> RemoveSourceIfNotNecessary(OperatorIR* node);
   StatusOr<bool> MaybePruneMemorySource(MemorySourceIR* mem_src);
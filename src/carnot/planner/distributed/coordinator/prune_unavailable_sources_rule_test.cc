@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -421,6 +422,55 @@ TEST_F(PruneUnavailableSourcesRuleTest, UDTFOnAllAgentsFilterOutNonMatchingAgent
   EXPECT_TRUE(graph->HasNode(union_node_id));
 }
 
+TEST_F(PruneUnavailableSourcesRuleTest, MemorySourceOutsideOfTimeRangeIsRemoved) {
+  auto carnot_info = logical_state_.distributed_state().carnot_info()[0];
+  ASSERT_TRUE(IsPEM(carnot_info));
+  auto table_info = carnot_info.add_table_info();
+  table_info->set_table("http_events");
+  table_info->mutable_time_range()->set_min_time_ns(1000);
+  table_info->mutable_time_range()->set_max_time_ns(2000);
+
+  // Ranges before the rows held, and well after the last of them, are removed.
+  auto before_src = MakeMemSource("http_events");
+  before_src->SetTimeValuesNS(0, 999);
+  auto before_sink = MakeGRPCSink(before_src, 123);
+  auto after_src = MakeMemSource("http_events");
+  int64_t after_start = 2001 + PruneUnavailableSourcesRule::kMaxTimeStalenessNS;
+  after_src->SetTimeValuesNS(after_start, after_start + 1000);
+  auto after_sink = MakeGRPCSink(after_src, 456);
+
+  // Ranges that overlap the rows held, or start shortly after them, are kept.
+  auto overlap_src = MakeMemSource("http_events");
+  overlap_src->SetTimeValuesNS(1500, 2500);
+  auto overlap_sink = MakeGRPCSink(overlap_src, 789);
+  auto recent_src = MakeMemSource("http_events");
+  recent_src->SetTimeValuesNS(2001, 3000);
+  auto recent_sink = MakeGRPCSink(recent_src, 1011);
+  // As are memory sources without a time range.
+  auto untimed_src = MakeMemSource("http_events");
+  auto untimed_sink = MakeGRPCSink(untimed_src, 1213);
+
+  ASSERT_OK_AND_ASSIGN(sole::uuid uuid, ParseUUID(carnot_info.agent_id()));
+  ASSERT_OK_AND_ASSIGN(auto schema_map,
+                       LoadSchemaMap(logical_state_.distributed_state(), uuid_to_id_map_));
+  PruneUnavailableSourcesRule rule(uuid_to_id_map_[uuid], carnot_info, schema_map);
+
+  std::vector<int64_t> removed_ids{before_src->id(), before_sink->id(), after_src->id(),
+                                   after_sink->id()};
+  std::vector<int64_t> kept_ids{overlap_src->id(), overlap_sink->id(),  recent_src->id(),
+                                recent_sink->id(), untimed_src->id(), untimed_sink->id()};
+  auto rule_or_s = rule.Execute(graph.get());
+  ASSERT_OK(rule_or_s);
+  ASSERT_TRUE(rule_or_s.ConsumeValueOrDie());
+
+  for (int64_t id : removed_ids) {
+    EXPECT_FALSE(graph->HasNode(id));
+  }
+  for (int64_t id : kept_ids) {
+    EXPECT_TRUE(graph->HasNode(id));
+  }
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -218,6 +218,12 @@ StatusOr<bool> MapRemovableOperatorsRule::CheckMemorySource(MemorySourceIR* mem_
   for (const auto& pem : pem_instances_) {
     if (!mem_src_ids.contains(pem)) {
       agent_ids.insert(pem);
+      continue;
+    }
+    // Agents that only hold rows outside of the time range of the memory source are removed too.
+    if (!PruneUnavailableSourcesRule::MemorySourceOverlapsTimeRange(
+            mem_src_ir, plan_->Get(pem)->carnot_info())) {
+      agent_ids.insert(pem);
     }
   }
   if (agent_ids.empty()) {
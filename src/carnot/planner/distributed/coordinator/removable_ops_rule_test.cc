@@ -127,6 +127,44 @@ TEST_F(RemovableOpsRuleTest, udtf_removed) {
   EXPECT_THAT(removable_ops_to_agents[udtf_src], UnorderedElementsAre(0, 1, 2));
 }
 
+constexpr char kTimeRangeQuery[] = R"pxl(
+import px
+
+px.display(px.DataFrame(table='process_stats', start_time='-30m'))
+)pxl";
+
+TEST_F(RemovableOpsRuleTest, mem_src_outside_of_time_range_removed) {
+  auto distributed_state = ThreeAgentOneKelvinStateWithMetadataInfo();
+  // The first PEM only holds rows from long before the time range of the query. The others didn't
+  // report their time ranges.
+  auto* pem1 = distributed_state.mutable_carnot_info(0);
+  ASSERT_EQ("pem1", pem1->query_broker_address());
+  auto* table_info = pem1->add_table_info();
+  table_info->set_table("process_stats");
+  table_info->mutable_time_range()->set_min_time_ns(1000);
+  table_info->mutable_time_range()->set_max_time_ns(2000);
+
+  auto logical_plan = CompileSingleNodePlan(kTimeRangeQuery);
+  auto distributed_plan = AssembleDistributedPlan(distributed_state);
+  auto split_plan = SplitPlan(logical_plan.get());
+
+  absl::flat_hash_set<int64_t> source_node_ids = SourceNodeIds(distributed_plan.get());
+
+  ASSERT_OK_AND_ASSIGN(auto agent_schema_map,
+                       LoadSchemaMap(distributed_state, distributed_plan->uuid_to_id_map()));
+
+  ASSERT_OK_AND_ASSIGN(OperatorToAgentSet removable_ops_to_agents,
+                       MapRemovableOperatorsRule::GetRemovableOperators(
+                           distributed_plan.get(), agent_schema_map, source_node_ids,
+                           split_plan->before_blocking.get()));
+
+  ASSERT_EQ(removable_ops_to_agents.size(), 1);
+  auto [op, agents] = *removable_ops_to_agents.begin();
+  EXPECT_TRUE(Match(op, MemorySource()));
+  ASSERT_OK_AND_ASSIGN(sole::uuid pem1_uuid, ParseUUID(pem1->agent_id()));
+  EXPECT_THAT(agents, UnorderedElementsAre(distributed_plan->uuid_to_id_map().at(pem1_uuid)));
+}
+
 constexpr char kRemoveFilterOrTwoAgents[] = R"pxl(
 import px
 
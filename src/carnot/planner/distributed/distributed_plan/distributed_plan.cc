@@ -29,13 +29,24 @@ StatusOr<distributedpb::DistributedPlan> DistributedPlan::ToProto() const {
   auto qb_address_to_plan_pb = physical_plan_pb.mutable_qb_address_to_plan();
   auto qb_address_to_dag_id_pb = physical_plan_pb.mutable_qb_address_to_dag_id();
 
+  // Most agents share their plan with many others (see plan_to_agent_map()). Serialize each plan
+  // once and only rewrite the fields that differ between the agents in the copies.
+  absl::flat_hash_map<const IR*, planpb::Plan> plan_protos;
   for (int64_t i : dag_.TopologicalSort()) {
     CarnotInstance* carnot = Get(i);
     CHECK_EQ(carnot->id(), i) << absl::Substitute("Index in node ($1) and DAG ($0) don't agree.", i,
                                                   carnot->id());
     DCHECK(carnot->plan()) << absl::Substitute("$0 doesn't have a plan set.",
                                                carnot->DebugString());
-    PL_ASSIGN_OR_RETURN(auto plan_proto, carnot->PlanProto());
+    planpb::Plan plan_proto;
+    auto plan_proto_iter = plan_protos.find(carnot->plan());
+    if (plan_proto_iter == plan_protos.end()) {
+      PL_ASSIGN_OR_RETURN(plan_proto, carnot->PlanProto());
+      plan_protos.emplace(carnot->plan(), plan_proto);
+    } else {
+      plan_proto = plan_proto_iter->second;
+      PL_RETURN_IF_ERROR(carnot->plan()->SetAgentSpecificFields(carnot->id(), &plan_proto));
+    }
     for (int64_t parent_i : dag_.ParentsOf(i)) {
       *(plan_proto.add_incoming_agent_ids()) = Get(parent_i)->carnot_info().agent_id();
     }
@@ -46,6 +57,9 @@ StatusOr<distributedpb::DistributedPlan> DistributedPlan::ToProto() const {
     plan_opts->CopyFrom(plan_options_);
   }
   dag_.ToProto(physical_plan_dag);
+  for (const auto& stats : rule_execution_stats_) {
+    *physical_plan_pb.add_rule_execution_stats() = stats;
+  }
   return physical_plan_pb;
 }
 
@@ -130,6 +130,14 @@ class DistributedPlan {
 
   void SetPlanOptions(planpb::PlanOptions plan_options) { plan_options_.CopyFrom(plan_options); }
 
+  // The execution stats of the compiler rules that produced the plan.
+  const std::vector<distributedpb::RuleExecutionStats>& rule_execution_stats() const {
+    return rule_execution_stats_;
+  }
+  void SetRuleExecutionStats(std::vector<distributedpb::RuleExecutionStats> stats) {
+    rule_execution_stats_ = std::move(stats);
+  }
+
   void AddPlan(std::unique_ptr<IR> plan) { plan_pool_.push_back(std::move(plan)); }
   const absl::flat_hash_map<sole::uuid, int64_t>& uuid_to_id_map() const { return uuid_to_id_map_; }
 
@@ -168,6 +176,7 @@ class DistributedPlan {
   absl::flat_hash_map<sole::uuid, int64_t> uuid_to_id_map_;
   int64_t id_counter_ = 0;
   planpb::PlanOptions plan_options_;
+  std::vector<distributedpb::RuleExecutionStats> rule_execution_stats_;
 };
 
 }  // namespace distributed
@@ -20,7 +20,9 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <pypa/parser/parser.hh>
@@ -229,6 +231,54 @@ TEST_F(DistributedPlanTest, construction_test) {
   EXPECT_THAT(physical_plan_proto, Partially(EqualsProto(kIRProto)));
 }
 
+TEST_F(DistributedPlanTest, shared_plan_gets_agent_specific_destinations) {
+  constexpr char kTwoAgentsDistributedState[] = R"proto(
+    carnot_info {
+      agent_id { high_bits: 0x0000000100000000 low_bits: 0x0000000000000001 }
+      query_broker_address: "agent1"
+      has_data_store: true
+      processes_data: true
+    }
+    carnot_info {
+      agent_id { high_bits: 0x0000000100000000 low_bits: 0x0000000000000002 }
+      query_broker_address: "agent2"
+      has_data_store: true
+      processes_data: true
+    }
+  )proto";
+  auto physical_plan = std::make_unique<DistributedPlan>();
+  distributedpb::DistributedState physical_state =
+      LoadDistributedStatePb(kTwoAgentsDistributedState);
+  int64_t agent1 = physical_plan->AddCarnot(physical_state.carnot_info(0)).ConsumeValueOrDie();
+  int64_t agent2 = physical_plan->AddCarnot(physical_state.carnot_info(1)).ConsumeValueOrDie();
+
+  compiler_state_->relation_map()->emplace("table", MakeRelation());
+  auto mem_source = MakeMemSource(MakeRelation());
+  auto grpc_sink = MakeGRPCSink(mem_source, /* source_id */ 123);
+  grpc_sink->SetDestinationAddress("1111");
+  grpc_sink->AddDestinationIDMap(10, agent1);
+  grpc_sink->AddDestinationIDMap(20, agent2);
+  compiler::ResolveTypesRule rule(compiler_state_.get());
+  ASSERT_OK(rule.Execute(graph.get()));
+
+  auto shared_plan = graph->Clone().ConsumeValueOrDie();
+  physical_plan->Get(agent1)->AddPlan(shared_plan.get());
+  physical_plan->Get(agent2)->AddPlan(shared_plan.get());
+  physical_plan->AddPlan(std::move(shared_plan));
+
+  auto physical_plan_proto = physical_plan->ToProto().ConsumeValueOrDie();
+  for (const auto& [address, destination_id] :
+       std::vector<std::pair<std::string, int64_t>>{{"agent1", 10}, {"agent2", 20}}) {
+    const auto& plan = physical_plan_proto.qb_address_to_plan().at(address);
+    ASSERT_EQ(1, plan.nodes_size());
+    ASSERT_EQ(2, plan.nodes(0).nodes_size());
+    const auto& sink_op = plan.nodes(0).nodes(1).op();
+    ASSERT_EQ(planpb::GRPC_SINK_OPERATOR, sink_op.op_type());
+    EXPECT_EQ(destination_id, sink_op.grpc_sink_op().grpc_source_id());
+    EXPECT_EQ("1111", sink_op.grpc_sink_op().address());
+  }
+}
+
 }  // namespace distributed
 
 }  // namespace planner
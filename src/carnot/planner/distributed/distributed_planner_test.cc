@@ -27,6 +27,7 @@
 
 #include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
 #include "src/carnot/planner/compiler/test_utils.h"
+#include "src/carnot/planner/distributed/coordinator/coordinator.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
 #include "src/carnot/planner/ir/ir.h"
 #include "src/carnot/planner/rules/rules.h"
@@ -213,6 +214,75 @@ TEST_F(DistributedPlannerTest, three_agents_one_kelvin) {
   EXPECT_THAT(grpc_sink_destinations, UnorderedElementsAreArray(grpc_source_ids));
 }
 
+TEST_F(DistributedPlannerTest, three_agents_partial_agg) {
+  FLAGS_planner_partial_aggs = true;
+  ASSERT_OK(AddUDAToRegistry("mean", types::FLOAT64, {types::INT64}, /*supports_partial*/ true));
+  auto mem_src = MakeMemSource(MakeRelation());
+  compiler_state_->relation_map()->emplace("table", MakeRelation());
+  auto count_col = MakeColumn("count", 0);
+  auto mean_func = MakeMeanFuncWithFloatType(MakeColumn("count", 0));
+  auto agg = MakeBlockingAgg(mem_src, {count_col}, {{"mean", mean_func}});
+  MakeMemSink(agg, "out");
+
+  ResolveTypesRule rule(compiler_state_.get());
+  ASSERT_OK(rule.Execute(graph.get()));
+
+  distributedpb::DistributedState ps_pb =
+      LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  std::unique_ptr<DistributedPlanner> physical_planner =
+      DistributedPlanner::Create().ConsumeValueOrDie();
+  std::unique_ptr<DistributedPlan> physical_plan =
+      physical_planner->Plan(ps_pb, compiler_state_.get(), graph.get()).ConsumeValueOrDie();
+  FLAGS_planner_partial_aggs = false;
+
+  // Each agent sends the partial aggregate of its rows.
+  for (int64_t i = 1; i <= 3; ++i) {
+    SCOPED_TRACE(absl::Substitute("agent id = $0", i));
+    IR* agent_plan = physical_plan->Get(i)->plan();
+    std::vector<IRNode*> grpc_sinks = agent_plan->FindNodesOfType(IRNodeType::kGRPCSink);
+    ASSERT_EQ(grpc_sinks.size(), 1);
+    auto grpc_sink = static_cast<GRPCSinkIR*>(grpc_sinks[0]);
+    ASSERT_EQ(grpc_sink->parents().size(), 1);
+    EXPECT_MATCH(grpc_sink->parents()[0], PartialAgg());
+  }
+
+  // The Kelvin merges the partial aggregates of all agents, and finalizes them.
+  IR* kelvin_plan = physical_plan->Get(0)->plan();
+  std::vector<IRNode*> aggs = kelvin_plan->FindNodesThatMatch(BlockingAgg());
+  ASSERT_EQ(aggs.size(), 1);
+  EXPECT_MATCH(aggs[0], FinalizeAgg());
+  EXPECT_MATCH(static_cast<OperatorIR*>(aggs[0])->parents()[0], Union());
+}
+
+TEST_F(DistributedPlannerTest, three_agents_partial_agg_disabled) {
+  ASSERT_OK(AddUDAToRegistry("mean", types::FLOAT64, {types::INT64}, /*supports_partial*/ true));
+  auto mem_src = MakeMemSource(MakeRelation());
+  compiler_state_->relation_map()->emplace("table", MakeRelation());
+  auto count_col = MakeColumn("count", 0);
+  auto mean_func = MakeMeanFuncWithFloatType(MakeColumn("count", 0));
+  auto agg = MakeBlockingAgg(mem_src, {count_col}, {{"mean", mean_func}});
+  MakeMemSink(agg, "out");
+
+  ResolveTypesRule rule(compiler_state_.get());
+  ASSERT_OK(rule.Execute(graph.get()));
+
+  distributedpb::DistributedState ps_pb =
+      LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  std::unique_ptr<DistributedPlanner> physical_planner =
+      DistributedPlanner::Create().ConsumeValueOrDie();
+  std::unique_ptr<DistributedPlan> physical_plan =
+      physical_planner->Plan(ps_pb, compiler_state_.get(), graph.get()).ConsumeValueOrDie();
+
+  // The agents send their rows, and the whole aggregate runs on the Kelvin.
+  for (int64_t i = 1; i <= 3; ++i) {
+    SCOPED_TRACE(absl::Substitute("agent id = $0", i));
+    EXPECT_TRUE(physical_plan->Get(i)->plan()->FindNodesThatMatch(BlockingAgg()).empty());
+  }
+  std::vector<IRNode*> aggs = physical_plan->Get(0)->plan()->FindNodesThatMatch(BlockingAgg());
+  ASSERT_EQ(aggs.size(), 1);
+  EXPECT_NOT_MATCH(aggs[0], FinalizeAgg());
+}
+
 using DistributedPlannerUDTFTests = DistributedRulesTest;
 TEST_F(DistributedPlannerUDTFTests, UDTFOnlyOnPEMsDoesntRunOnKelvin) {
   uint32_t asid = 123;
@@ -44,6 +44,23 @@ StatusOr<OperatorIR*> LimitOperatorMgr::CreateMergeOperator(IR* plan, OperatorIR
   return new_limit;
 }
 
+StatusOr<OperatorIR*> TopKOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR* op) const {
+  DCHECK(Matches(op));
+  TopKIR* top_k = static_cast<TopKIR*>(op);
+  PL_ASSIGN_OR_RETURN(TopKIR * new_top_k, plan->CopyNode(top_k));
+  PL_RETURN_IF_ERROR(new_top_k->CopyParentsFrom(top_k));
+  return new_top_k;
+}
+
+StatusOr<OperatorIR*> TopKOperatorMgr::CreateMergeOperator(IR* plan, OperatorIR* new_parent,
+                                                           OperatorIR* op) const {
+  DCHECK(Matches(op));
+  TopKIR* top_k = static_cast<TopKIR*>(op);
+  PL_ASSIGN_OR_RETURN(TopKIR * new_top_k, plan->CopyNode(top_k));
+  PL_RETURN_IF_ERROR(new_top_k->AddParent(new_parent));
+  return new_top_k;
+}
+
 StatusOr<OperatorIR*> AggOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR* op) const {
   DCHECK(Matches(op));
   BlockingAggIR* agg = static_cast<BlockingAggIR*>(op);
@@ -87,6 +87,34 @@ class LimitOperatorMgr : public PartialOperatorMgr {
                                             OperatorIR* op) const override;
 };
 
+/**
+ * @brief TopKOperatorMgr manages splitting top k operators over the boundary. Each agent keeps its
+ * own top k rows, and the merge operator picks the top k out of those, so at most k rows per agent
+ * are sent over the network.
+ */
+class TopKOperatorMgr : public PartialOperatorMgr {
+ public:
+  bool Matches(OperatorIR* op) const override {
+    if (!Match(op, TopK())) {
+      return false;
+    }
+    // The merge operator orders by the sort columns, so they have to be sent over the network.
+    auto top_k = static_cast<TopKIR*>(op);
+    if (!top_k->is_type_resolved()) {
+      return false;
+    }
+    for (ColumnIR* col : top_k->sort_columns()) {
+      if (!top_k->resolved_table_type()->HasColumn(col->col_name())) {
+        return false;
+      }
+    }
+    return true;
+  }
+  StatusOr<OperatorIR*> CreatePrepareOperator(IR* plan, OperatorIR* op) const override;
+  StatusOr<OperatorIR*> CreateMergeOperator(IR* plan, OperatorIR* new_parent,
+                                            OperatorIR* op) const override;
+};
+
 /**
  * @brief AggOperatorMgr manages splitting aggregates into partial aggregate and the merging node
  * over a network boundary.
@@ -98,6 +126,10 @@ class AggOperatorMgr : public PartialOperatorMgr {
       return false;
     }
     BlockingAggIR* agg = static_cast<BlockingAggIR*>(op);
+    // Rolling aggregates keep their state per window, which isn't split up yet.
+    if (agg->rolling()) {
+      return false;
+    }
     for (const auto& col_expr : agg->aggregate_expressions()) {
       if (!Match(col_expr.node, PartialUDA())) {
         return false;
@@ -68,6 +68,37 @@ TEST_F(PartialOpMgrTest, limit_test) {
   EXPECT_NE(merge_limit, limit);
 }
 
+TEST_F(PartialOpMgrTest, top_k_test) {
+  auto relation = MakeRelation();
+  auto mem_src = MakeMemSource("source", relation);
+  compiler_state_->relation_map()->emplace("source", relation);
+  auto top_k = MakeTopK(mem_src, {MakeColumn("cpu0", 0)}, {true}, 10);
+  MakeMemSink(top_k, "out");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  TopKOperatorMgr mgr;
+  EXPECT_TRUE(mgr.Matches(top_k));
+  ASSERT_OK_AND_ASSIGN(OperatorIR * prepare_top_k_uncasted,
+                       mgr.CreatePrepareOperator(graph.get(), top_k));
+  ASSERT_MATCH(prepare_top_k_uncasted, TopK());
+  TopKIR* prepare_top_k = static_cast<TopKIR*>(prepare_top_k_uncasted);
+  EXPECT_EQ(prepare_top_k->limit_value(), top_k->limit_value());
+  EXPECT_EQ(prepare_top_k->parents(), top_k->parents());
+  EXPECT_NE(prepare_top_k, top_k);
+
+  auto mem_src2 = MakeMemSource(MakeRelation());
+  ASSERT_OK_AND_ASSIGN(OperatorIR * merge_top_k_uncasted,
+                       mgr.CreateMergeOperator(graph.get(), mem_src2, top_k));
+  ASSERT_MATCH(merge_top_k_uncasted, TopK());
+  TopKIR* merge_top_k = static_cast<TopKIR*>(merge_top_k_uncasted);
+  EXPECT_EQ(merge_top_k->limit_value(), top_k->limit_value());
+  EXPECT_EQ(merge_top_k->descending(), top_k->descending());
+  EXPECT_EQ(merge_top_k->parents()[0], mem_src2);
+  EXPECT_NE(merge_top_k, top_k);
+}
+
 TEST_F(PartialOpMgrTest, agg_test) {
   auto relation = MakeRelation();
   relation.AddColumn(types::STRING, "service");
@@ -151,6 +182,17 @@ TEST_F(PartialOpMgrTest, agg_where_fn_cant_partial) {
   AggOperatorMgr mgr;
   EXPECT_FALSE(mgr.Matches(agg));
 }
+
+TEST_F(PartialOpMgrTest, rolling_agg_isnt_split) {
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto mean_func = MakeMeanFunc(MakeColumn("count", 0));
+  auto agg = MakeBlockingAgg(mem_src, {MakeColumn("service", 0)}, {{"mean", mean_func}});
+  ASSERT_OK(agg->SetRollingWindow(MakeColumn("time_", 0), 1000));
+  MakeMemSink(agg, "out");
+
+  AggOperatorMgr mgr;
+  EXPECT_FALSE(mgr.Matches(agg));
+}
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
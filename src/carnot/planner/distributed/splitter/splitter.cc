@@ -123,10 +123,12 @@ StatusOr<std::unique_ptr<BlockingSplitPlan>> Splitter::SplitKelvinAndAgents(cons
   PL_ASSIGN_OR_RETURN(std::unique_ptr<PreSplitAnalyzer> analyzer,
                       PreSplitAnalyzer::Create(compiler_state_));
   PL_RETURN_IF_ERROR(analyzer->Execute(logical_plan.get()));
+  compiler_state_->AddRuleExecutionStats(analyzer->rule_execution_stats());
   // Run the pre-split optimization step.
   PL_ASSIGN_OR_RETURN(std::unique_ptr<PreSplitOptimizer> optimizer,
                       PreSplitOptimizer::Create(compiler_state_));
   PL_RETURN_IF_ERROR(optimizer->Execute(logical_plan.get()));
+  compiler_state_->AddRuleExecutionStats(optimizer->rule_execution_stats());
 
   // Source_ids are necessary because we will make a clone of the plan at which point we will no
   // longer be able to use IRNode pointers and only IDs will be valid.
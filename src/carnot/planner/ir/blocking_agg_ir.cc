@@ -17,13 +17,53 @@
  */
 
 #include "src/carnot/planner/ir/blocking_agg_ir.h"
+
+#include <algorithm>
+#include <string>
+
 #include "src/carnot/planner/ir/func_ir.h"
 #include "src/carnot/planner/ir/ir.h"
+#include "src/carnot/planner/ir/map_ir.h"
+#include "src/carnot/planner/ir/memory_source_ir.h"
+#include "src/carnot/planner/ir/pattern_match.h"
+#include "src/carnot/planner/ir/time_ir.h"
 
 namespace px {
 namespace carnot {
 namespace planner {
 
+namespace {
+
+constexpr char kTimeColumnName[] = "time_";
+
+// Returns the column that expr bins with a constant positive width, or expr itself if it's a
+// column. Binning keeps the order of the values. Returns nullptr for anything else.
+const ColumnIR* OrderPreservingColumn(const ExpressionIR* expr) {
+  if (Match(expr, Func("bin"))) {
+    const auto* func = static_cast<const FuncIR*>(expr);
+    if (func->all_args().size() != 2) {
+      return nullptr;
+    }
+    const ExpressionIR* width = func->all_args()[1];
+    int64_t width_val = 0;
+    if (Match(width, Int())) {
+      width_val = static_cast<const IntIR*>(width)->val();
+    } else if (width->type() == IRNodeType::kTime) {
+      width_val = static_cast<const TimeIR*>(width)->val();
+    }
+    if (width_val <= 0) {
+      return nullptr;
+    }
+    expr = func->all_args()[0];
+  }
+  if (!Match(expr, ColumnNode())) {
+    return nullptr;
+  }
+  return static_cast<const ColumnIR*>(expr);
+}
+
+}  // namespace
+
 Status BlockingAggIR::Init(OperatorIR* parent, const std::vector<ColumnIR*>& groups,
                            const ColExpressionVector& agg_expr) {
   PL_RETURN_IF_ERROR(AddParent(parent));
@@ -51,9 +91,22 @@ Status BlockingAggIR::SetAggExprs(const ColExpressionVector& agg_exprs) {
   return Status::OK();
 }
 
+Status BlockingAggIR::SetRollingWindow(ColumnIR* window_col, int64_t window_size) {
+  if (window_col_ != nullptr) {
+    PL_RETURN_IF_ERROR(graph()->DeleteEdge(this, window_col_));
+    PL_RETURN_IF_ERROR(graph()->DeleteOrphansInSubtree(window_col_->id()));
+  }
+  PL_ASSIGN_OR_RETURN(window_col_, graph()->OptionallyCloneWithEdge(this, window_col));
+  window_size_ = window_size;
+  return Status::OK();
+}
+
 StatusOr<std::vector<absl::flat_hash_set<std::string>>> BlockingAggIR::RequiredInputColumns()
     const {
   absl::flat_hash_set<std::string> required;
+  if (rolling()) {
+    required.insert(window_col_->col_name());
+  }
   for (const auto& group : groups()) {
     required.insert(group->col_name());
   }
@@ -81,6 +134,9 @@ StatusOr<absl::flat_hash_set<std::string>> BlockingAggIR::PruneOutputColumnsToIm
   for (const ColumnIR* group : groups()) {
     kept_columns.insert(group->col_name());
   }
+  if (rolling()) {
+    kept_columns.insert(window_col_->col_name());
+  }
   return kept_columns;
 }
 
@@ -106,6 +162,45 @@ Status BlockingAggIR::EvaluateAggregateExpression(planpb::AggregateExpression* e
   return Status::OK();
 }
 
+bool BlockingAggIR::LeadingGroupIsTimeOrdered() const {
+  if (groups().empty() || rolling() || parents().size() != 1) {
+    return false;
+  }
+  std::string col_name = groups()[0]->col_name();
+  const OperatorIR* op = parents()[0];
+  while (true) {
+    if (Match(op, MemorySource())) {
+      // Memory sources read a table in the order of its time column, but interleave the batches of
+      // the tablets when they read several of them.
+      return col_name == kTimeColumnName &&
+             static_cast<const MemorySourceIR*>(op)->tablets().size() <= 1;
+    }
+    if (Match(op, Map())) {
+      const auto* map = static_cast<const MapIR*>(op);
+      auto it = std::find_if(map->col_exprs().begin(), map->col_exprs().end(),
+                             [&col_name](const ColumnExpression& expr) {
+                               return expr.name == col_name;
+                             });
+      if (it != map->col_exprs().end()) {
+        const ColumnIR* col = OrderPreservingColumn(it->node);
+        if (col == nullptr) {
+          return false;
+        }
+        col_name = col->col_name();
+      } else if (!map->keep_input_columns()) {
+        return false;
+      }
+    } else if (!Match(op, Filter()) && !Match(op, Limit())) {
+      // Anything else, a GRPC source in particular, may reorder the rows.
+      return false;
+    }
+    if (op->parents().size() != 1) {
+      return false;
+    }
+    op = op->parents()[0];
+  }
+}
+
 Status BlockingAggIR::ToProto(planpb::Operator* op) const {
   auto pb = op->mutable_agg_op();
   if (finalize_results_ && !partial_agg_) {
@@ -124,9 +219,17 @@ Status BlockingAggIR::ToProto(planpb::Operator* op) const {
     pb->add_group_names(group->col_name());
   }
 
+  if (rolling()) {
+    auto window_pb = pb->mutable_rolling_window();
+    PL_RETURN_IF_ERROR(window_col_->ToProto(window_pb->mutable_time_column()));
+    window_pb->set_time_column_name(window_col_->col_name());
+    window_pb->set_window_size_ns(window_size_);
+  }
+
   pb->set_windowed(false);
   pb->set_partial_agg(partial_agg_);
   pb->set_finalize_results(finalize_results_);
+  pb->set_ordered_leading_group(LeadingGroupIsTimeOrdered());
 
   op->set_op_type(planpb::AGGREGATE_OPERATOR);
   return Status::OK();
@@ -151,6 +254,11 @@ Status BlockingAggIR::CopyFromNodeImpl(
 
   PL_RETURN_IF_ERROR(SetAggExprs(new_agg_exprs));
   PL_RETURN_IF_ERROR(SetGroups(new_groups));
+  if (blocking_agg->rolling()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * new_window_col,
+                        graph()->CopyNode(blocking_agg->window_col_, copied_nodes_map));
+    PL_RETURN_IF_ERROR(SetRollingWindow(new_window_col, blocking_agg->window_size_));
+  }
 
   finalize_results_ = blocking_agg->finalize_results_;
   partial_agg_ = blocking_agg->partial_agg_;
@@ -166,6 +274,10 @@ Status BlockingAggIR::ResolveType(CompilerState* compiler_state) {
     PL_RETURN_IF_ERROR(ResolveExpressionType(group_col, compiler_state, parent_types()));
     new_table->AddColumn(group_col->col_name(), group_col->resolved_type());
   }
+  if (rolling()) {
+    PL_RETURN_IF_ERROR(ResolveExpressionType(window_col_, compiler_state, parent_types()));
+    new_table->AddColumn(window_col_->col_name(), window_col_->resolved_type());
+  }
   for (const auto& col_expr : aggregate_expressions_) {
     PL_RETURN_IF_ERROR(ResolveExpressionType(col_expr.node, compiler_state, parent_types()));
     new_table->AddColumn(col_expr.name, col_expr.node->resolved_type());
@@ -75,6 +75,22 @@ class BlockingAggIR : public GroupAcceptorIR {
     pre_split_proto_ = pre_split_proto;
   }
 
+  /**
+   * @brief Makes this a rolling aggregate, which aggregates the values in tumbling windows of
+   * window_size over window_col. The start of each window is output as window_col.
+   */
+  Status SetRollingWindow(ColumnIR* window_col, int64_t window_size);
+  bool rolling() const { return window_col_ != nullptr; }
+  ColumnIR* window_col() const { return window_col_; }
+  int64_t window_size() const { return window_size_; }
+
+  /**
+   * @brief Whether the input arrives ordered by the first group. This holds when the first group is
+   * the time_ column of a memory source, or a px.bin() of it, and only filters, limits and maps are
+   * in between. The aggregate can then emit the groups of a time bin once the input moves past it.
+   */
+  bool LeadingGroupIsTimeOrdered() const;
+
  protected:
   StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
       const absl::flat_hash_set<std::string>& output_colnames) override;
@@ -87,6 +103,9 @@ class BlockingAggIR : public GroupAcceptorIR {
   // Whether this finalizes the result of a partial aggregate.
   bool finalize_results_ = true;
   planpb::AggregateOperator pre_split_proto_;
+  // The time column and size of the windows of a rolling aggregate.
+  ColumnIR* window_col_ = nullptr;
+  int64_t window_size_ = 0;
 };
 }  // namespace planner
 }  // namespace carnot
@@ -18,6 +18,9 @@
 
 #include "src/carnot/planner/ir/grpc_sink_ir.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -31,6 +34,9 @@ Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
   destination_ssl_targetname_ = grpc_sink->destination_ssl_targetname_;
   name_ = grpc_sink->name_;
   out_columns_ = grpc_sink->out_columns_;
+  partition_key_columns_ = grpc_sink->partition_key_columns_;
+  partition_index_ = grpc_sink->partition_index_;
+  num_partitions_ = grpc_sink->num_partitions_;
   return Status::OK();
 }
 
@@ -62,6 +68,23 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op, int64_t agent_id) const {
     return CreateIRNodeError("No agent ID '$0' found in grpc sink '$1'", agent_id, DebugString());
   }
   pb->set_grpc_source_id(agent_id_to_destination_id_.find(agent_id)->second);
+  if (!is_partitioned()) {
+    return Status::OK();
+  }
+
+  DCHECK(is_type_resolved());
+  auto partition_pb = pb->mutable_partition();
+  auto col_names = resolved_table_type()->ColumnNames();
+  for (const auto& key_col : partition_key_columns_) {
+    auto it = std::find(col_names.begin(), col_names.end(), key_col);
+    if (it == col_names.end()) {
+      return CreateIRNodeError("Partition key column '$0' not found in grpc sink '$1'", key_col,
+                               DebugString());
+    }
+    partition_pb->add_key_column_indices(std::distance(col_names.begin(), it));
+  }
+  partition_pb->set_index(partition_index_);
+  partition_pb->set_num_partitions(num_partitions_);
   return Status::OK();
 }
 
@@ -132,6 +132,21 @@ class GRPCSinkIR : public OperatorIR {
     return std::vector<absl::flat_hash_set<std::string>>{outputs};
   }
 
+  /**
+   * @brief Makes the sink send only the rows whose key columns hash to the given partition, so that
+   * the rows of an operator can be split by their keys between several destinations.
+   */
+  void SetPartition(const std::vector<std::string>& key_columns, int64_t index,
+                    int64_t num_partitions) {
+    partition_key_columns_ = key_columns;
+    partition_index_ = index;
+    num_partitions_ = num_partitions;
+  }
+  bool is_partitioned() const { return num_partitions_ > 0; }
+  const std::vector<std::string>& partition_key_columns() const { return partition_key_columns_; }
+  int64_t partition_index() const { return partition_index_; }
+  int64_t num_partitions() const { return num_partitions_; }
+
   Status ResolveType(CompilerState* compiler_state);
 
   const absl::flat_hash_map<int64_t, int64_t>& agent_id_to_destination_id() {
@@ -156,6 +171,10 @@ class GRPCSinkIR : public OperatorIR {
   std::string name_;
   std::vector<std::string> out_columns_;
   absl::flat_hash_map<int64_t, int64_t> agent_id_to_destination_id_;
+  // Used when the sink is partitioned, num_partitions_ is 0 otherwise.
+  std::vector<std::string> partition_key_columns_;
+  int64_t partition_index_ = 0;
+  int64_t num_partitions_ = 0;
 };
 
 }  // namespace planner
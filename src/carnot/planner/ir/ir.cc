@@ -186,6 +186,26 @@ StatusOr<std::unique_ptr<IR>> IR::Clone() const {
   return new_ir;
 }
 
+StatusOr<std::unique_ptr<IR>> IR::CloneOperators(
+    const absl::flat_hash_set<int64_t>& selected_ops) const {
+  auto new_ir = std::make_unique<IR>();
+  for (int64_t id : selected_ops) {
+    IRNode* node = Get(id);
+    if (node == nullptr || !node->IsOperator()) {
+      return error::InvalidArgument("$0 is not an operator of the graph.", id);
+    }
+    for (OperatorIR* parent : static_cast<OperatorIR*>(node)->parents()) {
+      if (!selected_ops.contains(parent->id())) {
+        return error::InvalidArgument("Parent $0 of $1 is not selected.", parent->DebugString(),
+                                      node->DebugString());
+      }
+    }
+  }
+  PL_RETURN_IF_ERROR(new_ir->CopySelectedNodesAndDeps(this, selected_ops));
+  new_ir->id_node_counter = std::max(new_ir->id_node_counter, id_node_counter);
+  return new_ir;
+}
+
 Status IR::CopySelectedNodesAndDeps(const IR* src,
                                     const absl::flat_hash_set<int64_t>& selected_nodes) {
   absl::flat_hash_map<const IRNode*, IRNode*> copied_nodes_map;
@@ -251,6 +271,27 @@ StatusOr<planpb::Plan> IR::ToProto(int64_t agent_id) const {
   return plan;
 }
 
+Status IR::SetAgentSpecificFields(int64_t agent_id, planpb::Plan* plan) const {
+  for (auto& plan_fragment : *plan->mutable_nodes()) {
+    for (auto& plan_node : *plan_fragment.mutable_nodes()) {
+      if (plan_node.op().op_type() != planpb::GRPC_SINK_OPERATOR) {
+        continue;
+      }
+      IRNode* node = Get(plan_node.id());
+      if (node == nullptr || !Match(node, GRPCSink())) {
+        return error::InvalidArgument("Plan node $0 is not a GRPCSink of the plan.",
+                                      plan_node.id());
+      }
+      // Only the destination of internal GRPCSinks depends on the agent.
+      const GRPCSinkIR* grpc_sink = static_cast<const GRPCSinkIR*>(node);
+      if (!grpc_sink->has_output_table()) {
+        PL_RETURN_IF_ERROR(grpc_sink->ToProto(plan_node.mutable_op(), agent_id));
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status IR::OutputProto(planpb::PlanFragment* pf, const OperatorIR* op_node,
                        int64_t agent_id) const {
   // Check to make sure that the type is resolved for this op_node, otherwise it's not connected to
@@ -36,6 +36,7 @@
 #include "src/carnot/planner/compilerpb/compiler_status.pb.h"
 #include "src/carnot/planner/ir/ir_node.h"
 #include "src/carnot/planner/ir/ir_node_traits.h"
+#include "src/carnot/planner/ir/node_pool.h"
 #include "src/carnot/planner/types/types.h"
 #include "src/carnot/udfspb/udfs.pb.h"
 #include "src/common/base/base.h"
@@ -77,15 +78,14 @@ class IR {
   template <typename TOperator>
   StatusOr<TOperator*> MakeNode(int64_t id, const pypa::AstPtr& ast) {
     id_node_counter = std::max(id + 1, id_node_counter);
-    auto node = std::make_unique<TOperator>(id);
+    TOperator* node = node_pool_.New<TOperator>(id);
     dag_.AddNode(node->id());
     node->set_graph(this);
     if (ast != nullptr) {
       node->SetLineCol(ast);
     }
-    TOperator* raw = node.get();
-    id_node_map_.emplace(node->id(), std::move(node));
-    return raw;
+    id_node_map_.emplace(node->id(), IRNodePtr(node));
+    return node;
   }
   StatusOr<IRNode*> MakeNodeWithType(IRNodeType node_type, int64_t new_node_id);
 
@@ -191,6 +191,17 @@ class IR {
 
   StatusOr<std::unique_ptr<IR>> Clone() const;
 
+  /**
+   * @brief Clones the selected operators, along with their expressions, rather than the whole
+   * graph. The parents of the selected operators must be selected as well. The clone allocates node
+   * IDs after the ones of this graph, so new nodes never take the ID of a node that wasn't copied.
+   *
+   * @param selected_ops the IDs of the operators to copy.
+   * @return StatusOr<std::unique_ptr<IR>> the clone.
+   */
+  StatusOr<std::unique_ptr<IR>> CloneOperators(
+      const absl::flat_hash_set<int64_t>& selected_ops) const;
+
   /**
    * @brief Copies the selected operators from src into the current IR, including their edges
    * and dependencies.
@@ -209,6 +220,17 @@ class IR {
   StatusOr<planpb::Plan> ToProto() const;
   StatusOr<planpb::Plan> ToProto(int64_t agent_id) const;
 
+  /**
+   * @brief Rewrites the fields of a proto of this plan, made by ToProto for some agent, that differ
+   * between agents. Lets agents that share the plan copy its proto instead of serializing the whole
+   * plan again.
+   *
+   * @param agent_id the agent to set the fields for.
+   * @param plan the proto of this plan.
+   * @return Status: error if the proto doesn't match this plan.
+   */
+  Status SetAgentSpecificFields(int64_t agent_id, planpb::Plan* plan) const;
+
   /**
    * @brief Removes the nodes and edges listed in the following set.
    *
@@ -268,6 +290,8 @@ class IR {
   Status CopySelectedNodesAndDeps(const IR* src, const absl::flat_hash_set<int64_t>& selected_ids);
 
   plan::DAG dag_;
+  // Must outlive the nodes in id_node_map_.
+  IRNodePool node_pool_;
   std::unordered_map<int64_t, IRNodePtr> id_node_map_;
   int64_t id_node_counter = 0;
 };
@@ -22,6 +22,8 @@ namespace px {
 namespace carnot {
 namespace planner {
 
+void IRNodeDestroyer::operator()(IRNode* node) const { node->~IRNode(); }
+
 Status IRNode::CopyFromNode(const IRNode* node,
                             absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) {
   line_ = node->line_;
@@ -36,7 +36,13 @@ namespace planner {
 
 class IR;
 class IRNode;
-using IRNodePtr = std::unique_ptr<IRNode>;
+
+// Nodes live in the IRNodePool of their graph, which frees their memory, so deleting a node only
+// destroys it.
+struct IRNodeDestroyer {
+  void operator()(IRNode* node) const;
+};
+using IRNodePtr = std::unique_ptr<IRNode, IRNodeDestroyer>;
 
 enum class IRNodeType {
   kAny = -1,
@@ -836,6 +836,46 @@ TEST_F(OpTests, swap_parent) {
   EXPECT_EQ(col3->ReferenceID().ConsumeValueOrDie(), parent_map->id());
 }
 
+TEST_F(OpTests, agg_leading_group_is_time_ordered) {
+  MemorySourceIR* mem_src = MakeMemSource();
+  // df.timestamp = px.bin(df.time_, 10), with a filter in between.
+  MapIR* map = MakeMap(
+      mem_src,
+      {{"timestamp", MakeFunc("bin", {MakeColumn("time_", 0), MakeInt(10)})},
+       {"service", MakeColumn("service", 0)},
+       {"latency", MakeColumn("latency", 0)}});
+  FilterIR* filter = MakeFilter(map, MakeEqualsFunc(MakeColumn("service", 0), MakeString("foo")));
+
+  auto binned_agg = MakeBlockingAgg(filter, {MakeColumn("timestamp", 0), MakeColumn("service", 0)},
+                                    {{"mean", MakeMeanFunc(MakeColumn("latency", 0))}});
+  EXPECT_TRUE(binned_agg->LeadingGroupIsTimeOrdered());
+
+  // Only the first group is ordered.
+  auto service_agg = MakeBlockingAgg(filter, {MakeColumn("service", 0), MakeColumn("timestamp", 0)},
+                                     {{"mean", MakeMeanFunc(MakeColumn("latency", 0))}});
+  EXPECT_FALSE(service_agg->LeadingGroupIsTimeOrdered());
+
+  // Binning by a column isn't order preserving.
+  MapIR* col_bin_map = MakeMap(
+      mem_src, {{"timestamp", MakeFunc("bin", {MakeColumn("time_", 0), MakeColumn("size", 0)})}});
+  auto col_bin_agg = MakeBlockingAgg(col_bin_map, {MakeColumn("timestamp", 0)},
+                                     {{"mean", MakeMeanFunc(MakeColumn("latency", 0))}});
+  EXPECT_FALSE(col_bin_agg->LeadingGroupIsTimeOrdered());
+
+  // The rows of a GRPC source are interleaved from several agents.
+  GRPCSourceGroupIR* grpc_src = MakeGRPCSourceGroup(123, TableType::Create(MakeRelation()));
+  auto grpc_agg = MakeBlockingAgg(grpc_src, {MakeColumn("time_", 0)},
+                                  {{"mean", MakeMeanFunc(MakeColumn("latency", 0))}});
+  EXPECT_FALSE(grpc_agg->LeadingGroupIsTimeOrdered());
+
+  // The batches of several tablets are interleaved.
+  MemorySourceIR* tablets_src = MakeMemSource();
+  tablets_src->SetTablets({"1", "2"}, 0);
+  auto tablets_agg = MakeBlockingAgg(tablets_src, {MakeColumn("time_", 0)},
+                                     {{"mean", MakeMeanFunc(MakeColumn("latency", 0))}});
+  EXPECT_FALSE(tablets_agg->LeadingGroupIsTimeOrdered());
+}
+
 TEST_F(OpTests, internal_grpc_ops) {
   int64_t grpc_id = 123;
   std::string source_grpc_address = "1111";
@@ -1230,6 +1270,39 @@ TEST_F(ToProtoTests, internal_grpc_sink_ir) {
                                                destination_id + 1, ssl_targetname)));
 }
 
+TEST_F(ToProtoTests, partitioned_grpc_sink_ir) {
+  auto mem_src = MakeMemSource();
+  auto grpc_sink = MakeGRPCSink(mem_src, 123);
+  grpc_sink->SetDestinationAddress("1111");
+  grpc_sink->AddDestinationIDMap(124, /* agent_id */ 0);
+  grpc_sink->SetPartition({"cpu1"}, /* index */ 1, /* num_partitions */ 3);
+
+  auto table = TableType::Create();
+  table->AddColumn("count", ValueType::Create(types::INT64, types::ST_NONE));
+  table->AddColumn("cpu0", ValueType::Create(types::FLOAT64, types::ST_PERCENT));
+  table->AddColumn("cpu1", ValueType::Create(types::FLOAT64, types::ST_PERCENT));
+  ASSERT_OK(grpc_sink->SetResolvedType(table));
+
+  planpb::Operator pb;
+  ASSERT_OK(grpc_sink->ToProto(&pb, /* agent_id */ 0));
+  EXPECT_THAT(pb, EqualsProto(R"proto(
+  op_type: GRPC_SINK_OPERATOR
+  grpc_sink_op {
+    address: "1111"
+    grpc_source_id: 124
+    connection_options {}
+    partition {
+      key_column_indices: 2
+      index: 1
+      num_partitions: 3
+    }
+  }
+)proto"));
+
+  grpc_sink->SetPartition({"missing"}, /* index */ 1, /* num_partitions */ 3);
+  EXPECT_NOT_OK(grpc_sink->ToProto(&pb, /* agent_id */ 0));
+}
+
 constexpr char kExpectedExternalGRPCSinkPb[] = R"proto(
   op_type: GRPC_SINK_OPERATOR
   grpc_sink_op {
@@ -1575,6 +1648,45 @@ TEST_F(ToProtoTests, full_outer) {
   EXPECT_THAT(pb, EqualsProto(absl::Substitute(kExpectedJoinOpPb, "FULL_OUTER")));
 }
 
+TEST_F(ToProtoTests, as_of_join) {
+  Relation relation0({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64,
+                      types::DataType::INT64},
+                     {"left_only", "col1", "col2", "col3"});
+  auto mem_src1 = MakeMemSource("source0", relation0);
+  compiler_state_->relation_map()->emplace("source0", relation0);
+
+  Relation relation1({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64,
+                      types::DataType::INT64, types::DataType::INT64},
+                     {"right_only", "col1", "col2", "col3", "col4"});
+  auto mem_src2 = MakeMemSource("source1", relation1);
+  compiler_state_->relation_map()->emplace("source1", relation1);
+
+  auto join_op = MakeJoin({mem_src1, mem_src2}, "left", relation0, relation1,
+                          std::vector<std::string>{"col1"}, std::vector<std::string>{"col2"},
+                          {"", "_right"});
+  ASSERT_OK(join_op->SetAsOf(MakeColumn("col3", 0), MakeColumn("col4", 1), 100));
+  EXPECT_TRUE(join_op->is_as_of());
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  ASSERT_OK_AND_ASSIGN(auto required_inputs, join_op->RequiredInputColumns());
+  EXPECT_TRUE(required_inputs[0].contains("col3"));
+  EXPECT_TRUE(required_inputs[1].contains("col4"));
+
+  planpb::Operator pb;
+  EXPECT_OK(join_op->ToProto(&pb));
+  ASSERT_TRUE(pb.join_op().has_as_of());
+  EXPECT_EQ(3, pb.join_op().as_of().left_time_column_index());
+  EXPECT_EQ(4, pb.join_op().as_of().right_time_column_index());
+  EXPECT_EQ(100, pb.join_op().as_of().tolerance_ns());
+
+  auto outer_join = MakeJoin({mem_src1, mem_src2}, "outer", relation0, relation1,
+                             std::vector<std::string>{"col1"}, std::vector<std::string>{"col2"},
+                             {"", "_right"});
+  EXPECT_NOT_OK(outer_join->SetAsOf(MakeColumn("col3", 0), MakeColumn("col4", 1), 100));
+}
+
 TEST_F(ToProtoTests, join_wrong_join_type) {
   Relation relation0({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64,
                       types::DataType::INT64},
@@ -1649,6 +1761,13 @@ TEST_F(OpTests, tablet_source_group) {
 
   EXPECT_THAT(tablet_source->tablets(), ElementsAreArray(tablet_values));
   EXPECT_EQ(tablet_source->ReplacedMemorySource(), mem_source);
+
+  EXPECT_EQ(1, tablet_source->ChooseParallelism(1));
+  EXPECT_EQ(2, tablet_source->ChooseParallelism(8));
+  EXPECT_EQ(1, tablet_source->ChooseParallelism(0));
+  EXPECT_EQ(mem_source, tablet_source->ConvertToParallelScan(8));
+  EXPECT_THAT(mem_source->tablets(), ElementsAreArray(tablet_values));
+  EXPECT_EQ(2, mem_source->tablet_parallelism());
 }
 
 TEST_F(OpTests, GroupByNode) {
@@ -140,6 +140,35 @@ TEST(IndependentGraphs, complex_3_src_join_bug) {
                                        join2->id(), join3->id(), sink2->id(), sink3->id())));
 }
 
+TEST(CloneOperators, copies_selected_operators) {
+  IR ir;
+  auto src1 = ir.CreateNode<MemorySourceIR>(nullptr, "table", std::vector<std::string>{})
+                  .ConsumeValueOrDie();
+  auto map1 = ir.CreateNode<MapIR>(nullptr, src1, ColExpressionVector{}, true).ConsumeValueOrDie();
+  auto sink1 = ir.CreateNode<MemorySinkIR>(nullptr, map1, "output", std::vector<std::string>{})
+                   .ConsumeValueOrDie();
+  auto src2 = ir.CreateNode<MemorySourceIR>(nullptr, "table", std::vector<std::string>{})
+                  .ConsumeValueOrDie();
+  auto sink2 = ir.CreateNode<MemorySinkIR>(nullptr, src2, "output2", std::vector<std::string>{})
+                   .ConsumeValueOrDie();
+
+  auto clone_or_s = ir.CloneOperators({src1->id(), map1->id(), sink1->id()});
+  ASSERT_OK(clone_or_s);
+  auto clone = clone_or_s.ConsumeValueOrDie();
+  EXPECT_THAT(clone->dag().nodes(), UnorderedElementsAre(src1->id(), map1->id(), sink1->id()));
+  EXPECT_TRUE(clone->HasEdge(src1->id(), map1->id()));
+  EXPECT_TRUE(clone->HasEdge(map1->id(), sink1->id()));
+  EXPECT_NE(map1, clone->Get(map1->id()));
+
+  // New nodes don't take the IDs of the operators that weren't copied.
+  auto new_src = clone->CreateNode<MemorySourceIR>(nullptr, "table", std::vector<std::string>{})
+                     .ConsumeValueOrDie();
+  EXPECT_GT(new_src->id(), sink2->id());
+
+  // The parents of the selected operators must be selected too.
+  EXPECT_NOT_OK(ir.CloneOperators({sink2->id()}));
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
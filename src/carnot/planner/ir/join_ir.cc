@@ -51,6 +51,15 @@ Status JoinIR::CopyFromNodeImpl(const IRNode* node,
 
   PL_RETURN_IF_ERROR(SetJoinColumns(new_left_columns, new_right_columns));
   suffix_strs_ = join_node->suffix_strs_;
+  build_side_ = join_node->build_side_;
+
+  if (join_node->is_as_of()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * new_left_time,
+                        graph()->CopyNode(join_node->left_time_column_, copied_nodes_map));
+    PL_ASSIGN_OR_RETURN(ColumnIR * new_right_time,
+                        graph()->CopyNode(join_node->right_time_column_, copied_nodes_map));
+    PL_RETURN_IF_ERROR(SetAsOf(new_left_time, new_right_time, join_node->tolerance_ns_));
+  }
   return Status::OK();
 }
 
@@ -114,6 +123,16 @@ Status JoinIR::ToProto(planpb::Operator* op) const {
   // NOTE: not setting value as this is set in the execution engine. Keeping this here in case it
   // needs to be modified in the future.
   // pb->set_rows_per_batch(1024);
+  pb->set_build_side(build_side_);
+
+  if (is_as_of()) {
+    auto as_of_pb = pb->mutable_as_of();
+    PL_ASSIGN_OR_RETURN(auto left_time_index, left_time_column_->GetColumnIndex());
+    PL_ASSIGN_OR_RETURN(auto right_time_index, right_time_column_->GetColumnIndex());
+    as_of_pb->set_left_time_column_index(left_time_index);
+    as_of_pb->set_right_time_column_index(right_time_index);
+    as_of_pb->set_tolerance_ns(tolerance_ns_);
+  }
 
   return Status::OK();
 }
@@ -156,6 +175,21 @@ Status JoinIR::SetJoinColumns(const std::vector<ColumnIR*>& left_columns,
   return Status::OK();
 }
 
+Status JoinIR::SetAsOf(ColumnIR* left_time_column, ColumnIR* right_time_column,
+                      int64_t tolerance_ns) {
+  if (join_type_ != JoinType::kInner && join_type_ != JoinType::kLeft) {
+    return CreateIRNodeError("As-of joins only support 'inner' and 'left' joins.");
+  }
+  if (tolerance_ns < 0) {
+    return CreateIRNodeError("As-of join tolerance must not be negative, got $0", tolerance_ns);
+  }
+  PL_ASSIGN_OR_RETURN(left_time_column_, graph()->OptionallyCloneWithEdge(this, left_time_column));
+  PL_ASSIGN_OR_RETURN(right_time_column_,
+                      graph()->OptionallyCloneWithEdge(this, right_time_column));
+  tolerance_ns_ = tolerance_ns;
+  return Status::OK();
+}
+
 StatusOr<std::vector<absl::flat_hash_set<std::string>>> JoinIR::RequiredInputColumns() const {
   DCHECK(key_columns_set_);
   DCHECK(!output_columns_.empty());
@@ -174,6 +208,10 @@ StatusOr<std::vector<absl::flat_hash_set<std::string>>> JoinIR::RequiredInputCol
     DCHECK(col->container_op_parent_idx_set());
     ret[col->container_op_parent_idx()].insert(col->col_name());
   }
+  if (is_as_of()) {
+    ret[left_time_column_->container_op_parent_idx()].insert(left_time_column_->col_name());
+    ret[right_time_column_->container_op_parent_idx()].insert(right_time_column_->col_name());
+  }
 
   return ret;
 }
@@ -312,6 +350,17 @@ Status JoinIR::ResolveType(CompilerState* compiler_state) {
     auto col_name = column_names_[idx];
     new_table->AddColumn(col_name, col->resolved_type());
   }
+  if (is_as_of()) {
+    for (ColumnIR* time_col : {left_time_column_, right_time_column_}) {
+      PL_RETURN_IF_ERROR(ResolveExpressionType(time_col, compiler_state, parent_types()));
+      auto data_type = time_col->EvaluatedDataType();
+      if (data_type != types::TIME64NS && data_type != types::INT64) {
+        return time_col->CreateIRNodeError(
+            "As-of join column '$0' must be a time or an integer, got $1", time_col->col_name(),
+            types::ToString(data_type));
+      }
+    }
+  }
 
   return SetResolvedType(new_table);
 }
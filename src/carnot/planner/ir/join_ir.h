@@ -90,6 +90,20 @@ class JoinIR : public OperatorIR {
                           const std::vector<ColumnIR*>& columns);
   bool specified_as_right() const { return specified_as_right_; }
 
+  // The parent to build the hash table from, as chosen by the optimizer.
+  planpb::JoinOperator::BuildSide build_side() const { return build_side_; }
+  void set_build_side(planpb::JoinOperator::BuildSide build_side) { build_side_ = build_side; }
+
+  /**
+   * @brief Makes this an as-of join, which matches each left row with the latest right row of the
+   * same keys whose time is at or before its time, by at most the tolerance.
+   */
+  Status SetAsOf(ColumnIR* left_time_column, ColumnIR* right_time_column, int64_t tolerance_ns);
+  bool is_as_of() const { return left_time_column_ != nullptr; }
+  ColumnIR* left_time_column() const { return left_time_column_; }
+  ColumnIR* right_time_column() const { return right_time_column_; }
+  int64_t tolerance_ns() const { return tolerance_ns_; }
+
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
 
   const std::tuple<std::shared_ptr<TableType>, std::shared_ptr<TableType>> left_right_table_types()
@@ -161,6 +175,13 @@ class JoinIR : public OperatorIR {
   // Whether this join was originally specified as a right join.
   // Used because we transform left joins into right joins but need to do some back transform.
   bool specified_as_right_ = false;
+
+  planpb::JoinOperator::BuildSide build_side_ = planpb::JoinOperator::BUILD_SIDE_DEFAULT;
+
+  // The time columns of the parents, only set for as-of joins.
+  ColumnIR* left_time_column_ = nullptr;
+  ColumnIR* right_time_column_ = nullptr;
+  int64_t tolerance_ns_ = 0;
 };
 
 }  // namespace planner
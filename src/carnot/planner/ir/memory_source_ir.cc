@@ -59,8 +59,16 @@ Status MemorySourceIR::ToProto(planpb::Operator* op) const {
   if (HasTablet()) {
     pb->set_tablet(tablet_value());
   }
+  for (const auto& tablet : tablets_) {
+    pb->add_tablets(tablet);
+  }
+  pb->set_tablet_parallelism(tablet_parallelism_);
 
   pb->set_streaming(streaming());
+  for (const auto& predicate : predicates_) {
+    *pb->add_predicates() = predicate;
+  }
+  pb->set_evaluate_predicates(evaluate_predicates_);
   return Status::OK();
 }
 
@@ -135,6 +143,10 @@ Status MemorySourceIR::CopyFromNodeImpl(
   column_index_map_ = source_ir->column_index_map_;
   has_time_expressions_ = source_ir->has_time_expressions_;
   streaming_ = source_ir->streaming_;
+  predicates_ = source_ir->predicates_;
+  evaluate_predicates_ = source_ir->evaluate_predicates_;
+  tablets_ = source_ir->tablets_;
+  tablet_parallelism_ = source_ir->tablet_parallelism_;
 
   if (has_time_expressions_) {
     PL_ASSIGN_OR_RETURN(ExpressionIR * new_start_expr,
@@ -111,6 +111,17 @@ class MemorySourceIR : public OperatorIR {
     return tablet_value_;
   }
 
+  /**
+   * @brief Makes the source read several tablets of the table, with up to parallelism of them read
+   * concurrently.
+   */
+  void SetTablets(const std::vector<types::TabletID>& tablets, int64_t parallelism) {
+    tablets_ = tablets;
+    tablet_parallelism_ = parallelism;
+  }
+  const std::vector<types::TabletID>& tablets() const { return tablets_; }
+  int64_t tablet_parallelism() const { return tablet_parallelism_; }
+
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override {
     return std::vector<absl::flat_hash_set<std::string>>{};
   }
@@ -119,6 +130,18 @@ class MemorySourceIR : public OperatorIR {
 
   bool IsSource() const override { return true; }
 
+  // Predicates taken from a filter on this source. They let the MemorySource skip batches that
+  // can't contain matching rows, the filter itself still has to run unless the predicates are
+  // evaluated on the rows as well.
+  const std::vector<planpb::MemorySourcePredicate>& predicates() const { return predicates_; }
+  void AddPredicate(const planpb::MemorySourcePredicate& predicate) {
+    predicates_.push_back(predicate);
+  }
+  bool evaluate_predicates() const { return evaluate_predicates_; }
+  void set_evaluate_predicates(bool evaluate_predicates) {
+    evaluate_predicates_ = evaluate_predicates;
+  }
+
   Status ResolveType(CompilerState* compiler_state);
 
  protected:
@@ -146,6 +169,11 @@ class MemorySourceIR : public OperatorIR {
 
   types::TabletID tablet_value_;
   bool has_tablet_value_ = false;
+  std::vector<types::TabletID> tablets_;
+  int64_t tablet_parallelism_ = 0;
+
+  std::vector<planpb::MemorySourcePredicate> predicates_;
+  bool evaluate_predicates_ = false;
 };
 
 }  // namespace planner
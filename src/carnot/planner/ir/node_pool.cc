@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/ir/node_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+void* IRNodePool::Allocate(size_t size, size_t alignment) {
+  uintptr_t aligned = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~(alignment - 1);
+  if (next_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+    // Larger nodes than a block get a block of their own.
+    size_t block_size = std::max(kBlockSize, size + alignment);
+    blocks_.push_back(std::make_unique<char[]>(block_size));
+    allocated_bytes_ += block_size;
+    next_ = blocks_.back().get();
+    end_ = next_ + block_size;
+    aligned = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~(alignment - 1);
+  }
+  next_ = reinterpret_cast<char*>(aligned + size);
+  return reinterpret_cast<void*>(aligned);
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+/**
+ * @brief IRNodePool allocates the nodes of an IR graph out of large blocks, rather than allocating
+ * every node separately.
+ *
+ * The pool only hands out memory, the graph still destroys the nodes it deletes. The memory of
+ * deleted nodes is reclaimed when the pool is destroyed, which is fine since a graph only lives
+ * for the compilation of a single query.
+ */
+class IRNodePool : public NotCopyable {
+ public:
+  static constexpr size_t kBlockSize = 32 * 1024;
+
+  /**
+   * @brief Constructs a TNode in memory owned by the pool. The caller is responsible for running
+   * the destructor of the node, but must not free it.
+   */
+  template <typename TNode, typename... Args>
+  TNode* New(Args&&... args) {
+    void* mem = Allocate(sizeof(TNode), alignof(TNode));
+    return new (mem) TNode(std::forward<Args>(args)...);
+  }
+
+  // The total number of bytes of the blocks allocated so far.
+  size_t allocated_bytes() const { return allocated_bytes_; }
+
+ private:
+  void* Allocate(size_t size, size_t alignment);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t allocated_bytes_ = 0;
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
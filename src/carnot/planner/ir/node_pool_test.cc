@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "src/carnot/planner/ir/node_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+struct alignas(64) AlignedNode {
+  explicit AlignedNode(int64_t v) : value(v) {}
+  int64_t value;
+};
+
+struct LargeNode {
+  char data[2 * IRNodePool::kBlockSize];
+};
+
+TEST(IRNodePool, allocates_aligned_nodes_from_blocks) {
+  IRNodePool pool;
+  auto* str = pool.New<std::string>("a string that doesn't fit in the small string buffer");
+  auto* node1 = pool.New<AlignedNode>(1);
+  auto* node2 = pool.New<AlignedNode>(2);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(node1) % alignof(AlignedNode));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(node2) % alignof(AlignedNode));
+  EXPECT_EQ(1, node1->value);
+  EXPECT_EQ(2, node2->value);
+  EXPECT_EQ(IRNodePool::kBlockSize, pool.allocated_bytes());
+  str->~basic_string();
+}
+
+TEST(IRNodePool, large_nodes_get_their_own_block) {
+  IRNodePool pool;
+  pool.New<AlignedNode>(1);
+  auto* large = pool.New<LargeNode>();
+  large->data[sizeof(large->data) - 1] = 'x';
+  EXPECT_GT(pool.allocated_bytes(), IRNodePool::kBlockSize + sizeof(LargeNode) - 1);
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
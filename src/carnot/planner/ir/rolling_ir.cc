@@ -73,7 +73,7 @@ Status RollingIR::CopyFromNodeImpl(const IRNode* source,
 }
 
 Status RollingIR::ToProto(planpb::Operator* /* op */) const {
-  return CreateIRNodeError("Rolling operator not yet implemented");
+  return CreateIRNodeError("'rolling()' must be followed by an 'agg()'");
 }
 
 StatusOr<std::vector<absl::flat_hash_set<std::string>>> RollingIR::RequiredInputColumns() const {
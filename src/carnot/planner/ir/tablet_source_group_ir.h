@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "src/carnot/planner/compiler_state/compiler_state.h"
+#include "src/carnot/planner/ir/memory_source_ir.h"
 #include "src/carnot/planner/ir/operator_ir.h"
 #include "src/carnot/planner/types/types.h"
 #include "src/carnot/udfspb/udfs.pb.h"
@@ -81,6 +82,25 @@ class TabletSourceGroupIR : public OperatorIR {
 
   const std::string tablet_key() const { return tablet_key_; }
 
+  /**
+   * @brief Chooses how many of the tablets are read concurrently: one thread per tablet, up to
+   * max_parallelism.
+   */
+  int64_t ChooseParallelism(int64_t max_parallelism) const {
+    return std::max<int64_t>(
+        1, std::min<int64_t>(max_parallelism, static_cast<int64_t>(tablets_.size())));
+  }
+
+  /**
+   * @brief Makes the replaced memory source read all of the tablets itself, on up to
+   * max_parallelism threads, rather than replacing it with a union of one source per tablet.
+   * @return the memory source.
+   */
+  MemorySourceIR* ConvertToParallelScan(int64_t max_parallelism) const {
+    memory_source_ir_->SetTablets(tablets_, ChooseParallelism(max_parallelism));
+    return memory_source_ir_;
+  }
+
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override {
     return error::Unimplemented("Unexpected call to TabletSourceGroupIR::RequiredInputColumns");
   }
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/ir/top_k_ir.h"
+#include "src/carnot/planner/ir/ir.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+Status TopKIR::Init(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+                    const std::vector<bool>& descending, int64_t limit_value) {
+  PL_RETURN_IF_ERROR(AddParent(parent));
+  SetLimitValue(limit_value);
+  return SetSortColumns(sort_columns, descending);
+}
+
+std::string TopKIR::DebugString() const {
+  std::vector<std::string> sort_strs;
+  for (const auto& [i, col] : Enumerate(sort_columns_)) {
+    sort_strs.push_back(absl::Substitute("$0$1", col->col_name(), descending_[i] ? " desc" : ""));
+  }
+  return absl::Substitute("$0(id=$1, n=$2, sort=[$3])", type_string(), id(), limit_value_,
+                          absl::StrJoin(sort_strs, ", "));
+}
+
+Status TopKIR::SetSortColumns(const std::vector<ColumnIR*>& sort_columns,
+                              const std::vector<bool>& descending) {
+  if (sort_columns.size() != descending.size()) {
+    return CreateIRNodeError("Got $0 sort columns but $1 sort directions", sort_columns.size(),
+                             descending.size());
+  }
+  for (ColumnIR* old_col : sort_columns_) {
+    PL_RETURN_IF_ERROR(graph()->DeleteEdge(this, old_col));
+    PL_RETURN_IF_ERROR(graph()->DeleteOrphansInSubtree(old_col->id()));
+  }
+  sort_columns_.resize(sort_columns.size());
+  for (size_t i = 0; i < sort_columns.size(); ++i) {
+    PL_ASSIGN_OR_RETURN(sort_columns_[i], graph()->OptionallyCloneWithEdge(this, sort_columns[i]));
+  }
+  descending_ = descending;
+  return Status::OK();
+}
+
+StatusOr<std::vector<absl::flat_hash_set<std::string>>> TopKIR::RequiredInputColumns() const {
+  DCHECK(is_type_resolved());
+  absl::flat_hash_set<std::string> required_cols{resolved_table_type()->ColumnNames().begin(),
+                                                 resolved_table_type()->ColumnNames().end()};
+  for (ColumnIR* col : sort_columns_) {
+    required_cols.insert(col->col_name());
+  }
+  return std::vector<absl::flat_hash_set<std::string>>{required_cols};
+}
+
+Status TopKIR::ToProto(planpb::Operator* op) const {
+  auto pb = op->mutable_top_k_op();
+  op->set_op_type(planpb::TOP_K_OPERATOR);
+  DCHECK_EQ(parents().size(), 1UL);
+
+  DCHECK(parents()[0]->is_type_resolved());
+  auto parent_table_type = parents()[0]->resolved_table_type();
+  auto parent_id = parents()[0]->id();
+
+  DCHECK(is_type_resolved());
+  for (const std::string& col_name : resolved_table_type()->ColumnNames()) {
+    planpb::Column* col_pb = pb->add_columns();
+    col_pb->set_node(parent_id);
+    DCHECK(parent_table_type->HasColumn(col_name));
+    col_pb->set_index(parent_table_type->GetColumnIndex(col_name));
+  }
+  for (const auto& [i, col] : Enumerate(sort_columns_)) {
+    PL_RETURN_IF_ERROR(col->ToProto(pb->add_sort_columns()));
+    pb->add_descending(descending_[i]);
+  }
+  pb->set_limit(limit_value_);
+  return Status::OK();
+}
+
+Status TopKIR::CopyFromNodeImpl(const IRNode* node,
+                                absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) {
+  const TopKIR* top_k = static_cast<const TopKIR*>(node);
+  std::vector<ColumnIR*> new_sort_columns;
+  for (const ColumnIR* col : top_k->sort_columns_) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * new_col, graph()->CopyNode(col, copied_nodes_map));
+    new_sort_columns.push_back(new_col);
+  }
+  PL_RETURN_IF_ERROR(SetSortColumns(new_sort_columns, top_k->descending_));
+  limit_value_ = top_k->limit_value_;
+  return Status::OK();
+}
+
+Status TopKIR::ResolveType(CompilerState* compiler_state) {
+  DCHECK_EQ(1, parent_types().size());
+  for (ColumnIR* col : sort_columns_) {
+    PL_RETURN_IF_ERROR(ResolveExpressionType(col, compiler_state, parent_types()));
+  }
+  PL_ASSIGN_OR_RETURN(auto type_ptr, OperatorIR::DefaultResolveType(parent_types()));
+  return SetResolvedType(type_ptr);
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
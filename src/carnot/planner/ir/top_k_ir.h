@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/planner/compiler_state/compiler_state.h"
+#include "src/carnot/planner/ir/column_ir.h"
+#include "src/carnot/planner/ir/operator_ir.h"
+#include "src/carnot/planner/types/types.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+/**
+ * @brief The TopKIR keeps the first n rows of its parent according to the sort columns. It's the
+ * bounded equivalent of sorting the entire input and then taking the head.
+ */
+class TopKIR : public OperatorIR {
+ public:
+  TopKIR() = delete;
+  explicit TopKIR(int64_t id) : OperatorIR(id, IRNodeType::kTopK) {}
+
+  Status Init(OperatorIR* parent, const std::vector<ColumnIR*>& sort_columns,
+              const std::vector<bool>& descending, int64_t limit_value);
+
+  std::string DebugString() const override;
+  Status ToProto(planpb::Operator*) const override;
+  Status ResolveType(CompilerState* compiler_state);
+
+  int64_t limit_value() const { return limit_value_; }
+  void SetLimitValue(int64_t value) { limit_value_ = value; }
+  const std::vector<ColumnIR*>& sort_columns() const { return sort_columns_; }
+  const std::vector<bool>& descending() const { return descending_; }
+  Status SetSortColumns(const std::vector<ColumnIR*>& sort_columns,
+                        const std::vector<bool>& descending);
+
+  Status CopyFromNodeImpl(const IRNode* node,
+                          absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
+  inline bool IsBlocking() const override { return true; }
+
+  StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
+
+ protected:
+  StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
+      const absl::flat_hash_set<std::string>& output_cols) override {
+    return output_cols;
+  }
+
+ private:
+  int64_t limit_value_ = 0;
+  std::vector<ColumnIR*> sort_columns_;
+  std::vector<bool> descending_;
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
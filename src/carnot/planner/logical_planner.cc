@@ -18,10 +18,22 @@
 
 #include "src/carnot/planner/logical_planner.h"
 
+#include <algorithm>
+#include <string>
 #include <utility>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_cat.h>
+
+#include "src/carnot/planner/plan_cache.h"
+
 #include "src/shared/scriptspb/scripts.pb.h"
 
+DEFINE_int32(planner_plan_cache_size, gflags::Int32FromEnv("PL_PLANNER_PLAN_CACHE_SIZE", 256),
+             "The number of compiled plans that the logical planner keeps around for the scripts "
+             "that it sees again. 0 disables the plan cache.");
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -58,12 +70,42 @@ static inline RedactionOptions RedactionOptionsFromPb(
   return options;
 }
 
-StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
-    const distributedpb::LogicalPlannerState& logical_state, RegistryInfo* registry_info,
-    int64_t max_output_rows_per_table) {
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
-                      MakeRelationMapFromDistributedState(logical_state.distributed_state()));
+TableRowCounts MakeTableRowCountsFromDistributedState(
+    const distributedpb::DistributedState& state_pb) {
+  TableRowCounts row_counts;
+  for (const auto& schema_info : state_pb.schema_info()) {
+    if (schema_info.num_rows() > 0) {
+      row_counts[schema_info.name()] = schema_info.num_rows();
+    }
+  }
+  return row_counts;
+}
+
+// Clears the parts of the distributed state that change with every heartbeat of the agents: their
+// load, the time ranges of their tables and the row counts of the tables. A cached plan keeps the
+// choices that it made from them until the schemas or the set of agents change.
+static void ClearHeartbeatFields(distributedpb::DistributedState* state_pb) {
+  for (auto& carnot_info : *state_pb->mutable_carnot_info()) {
+    carnot_info.clear_load();
+    for (auto& table_info : *carnot_info.mutable_table_info()) {
+      table_info.clear_time_range();
+    }
+  }
+  for (auto& schema_info : *state_pb->mutable_schema_info()) {
+    schema_info.clear_num_rows();
+  }
+}
 
+static std::string PlanCacheStateVersion(const distributedpb::LogicalPlannerState& logical_state) {
+  distributedpb::LogicalPlannerState versioned_state = logical_state;
+  ClearHeartbeatFields(versioned_state.mutable_distributed_state());
+  return DeterministicSerialize(versioned_state);
+}
+
+StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
+    const distributedpb::LogicalPlannerState& logical_state, std::unique_ptr<RelationMap> rel_map,
+    TableRowCounts row_counts, RegistryInfo* registry_info, int64_t max_output_rows_per_table,
+    types::Time64NSValue time_now) {
   SensitiveColumnMap sensitive_columns = {
       {"cql_events", {"req_body", "resp_body"}},
       {"http_events", {"req_headers", "req_body", "resp_headers", "resp_body"}},
@@ -72,12 +114,25 @@ StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
       {"nats_events.beta", {"body", "resp"}},
       {"pgsql_events", {"req", "resp"}},
       {"redis_events", {"req_args", "resp"}}};
-  // Create a CompilerState obj using the relation map and grabbing the current time.
-  return std::make_unique<planner::CompilerState>(
-      std::move(rel_map), sensitive_columns, registry_info, px::CurrentTimeNS(),
+  // Create a CompilerState obj using the relation map and the compile time.
+  auto compiler_state = std::make_unique<planner::CompilerState>(
+      std::move(rel_map), sensitive_columns, registry_info, time_now,
       max_output_rows_per_table, logical_state.result_address(),
       logical_state.result_ssl_targetname(),
       RedactionOptionsFromPb(logical_state.redaction_options()));
+  compiler_state->set_table_row_counts(std::move(row_counts));
+  return compiler_state;
+}
+
+StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
+    const distributedpb::LogicalPlannerState& logical_state, RegistryInfo* registry_info,
+    int64_t max_output_rows_per_table, types::Time64NSValue time_now) {
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
+                      MakeRelationMapFromDistributedState(logical_state.distributed_state()));
+  return CreateCompilerState(
+      logical_state, std::move(rel_map),
+      MakeTableRowCountsFromDistributedState(logical_state.distributed_state()), registry_info,
+      max_output_rows_per_table, time_now);
 }
 
 StatusOr<std::unique_ptr<LogicalPlanner>> LogicalPlanner::Create(const udfspb::UDFInfo& udf_info) {
@@ -92,26 +147,204 @@ Status LogicalPlanner::Init(const udfspb::UDFInfo& udf_info) {
   PL_RETURN_IF_ERROR(registry_info_->Init(udf_info));
 
   PL_ASSIGN_OR_RETURN(distributed_planner_, distributed::DistributedPlanner::Create());
+  plan_cache_ = std::make_unique<PlanCache<distributedpb::DistributedPlan>>(
+      std::max(FLAGS_planner_plan_cache_size, 0));
   return Status::OK();
 }
 
 StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
     const distributedpb::LogicalPlannerState& logical_state,
     const plannerpb::QueryRequest& query_request) {
+  return Plan(logical_state, query_request, px::CurrentTimeNS());
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProto(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
+                                                   query_request.exec_funcs().end());
+  // The logical state holds the schemas and the agents, so it versions the plan.
+  auto key = PlanCacheKey(query_request.query_str(), exec_funcs,
+                          PlanCacheStateVersion(logical_state));
+  return plan_cache_->GetOrCompile(
+      key, px::CurrentTimeNS(),
+      [&](types::Time64NSValue time_now) -> StatusOr<distributedpb::DistributedPlan> {
+        PL_ASSIGN_OR_RETURN(auto distributed_plan, Plan(logical_state, query_request, time_now));
+        // In the future, if we actually have plan options that will actually determine how the
+        // plan is constructed, we may want to pass the planOptions to Plan. However, this will
+        // need to go through many more layers (such as the coordinator), so this is fine for now.
+        distributed_plan->SetPlanOptions(logical_state.plan_options());
+        return distributed_plan->ToProto();
+      });
+}
+
+StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request, types::Time64NSValue time_now) {
   // Compile into the IR.
   auto ms = logical_state.plan_options().max_output_rows_per_table();
   VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      CreateCompilerState(logical_state, registry_info_.get(), ms, time_now));
+  return Plan(logical_state.distributed_state(), compiler_state.get(), query_request);
+}
 
+StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
+    const distributedpb::DistributedState& distributed_state, CompilerState* compiler_state,
+    const plannerpb::QueryRequest& query_request) {
   std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
                                                    query_request.exec_funcs().end());
-  PL_ASSIGN_OR_RETURN(
-      std::shared_ptr<IR> single_node_plan,
-      compiler_.CompileToIR(query_request.query_str(), compiler_state.get(), exec_funcs));
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<IR> single_node_plan,
+                      compiler_.CompileToIR(query_request.query_str(), compiler_state, exec_funcs));
   // Create the distributed plan.
-  return distributed_planner_->Plan(logical_state.distributed_state(), compiler_state.get(),
-                                    single_node_plan.get());
+  PL_ASSIGN_OR_RETURN(
+      std::unique_ptr<distributed::DistributedPlan> distributed_plan,
+      distributed_planner_->Plan(distributed_state, compiler_state, single_node_plan.get()));
+  distributed_plan->SetRuleExecutionStats(compiler_state->rule_execution_stats());
+  return distributed_plan;
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProtoWithStoredState(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  std::shared_ptr<const StoredDistributedState> stored_state;
+  {
+    absl::MutexLock lock(&stored_state_lock_);
+    stored_state = stored_state_;
+  }
+  if (stored_state == nullptr) {
+    return error::FailedPrecondition("No distributed state was set in the planner.");
+  }
+
+  std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
+                                                   query_request.exec_funcs().end());
+  // The stored state is versioned by a counter, so it doesn't have to be serialized for the key.
+  // The distributed state of `logical_state` is empty, so only the options are in there.
+  auto key = PlanCacheKey(
+      query_request.query_str(), exec_funcs,
+      absl::StrCat("stored:", stored_state->version, ":", DeterministicSerialize(logical_state)));
+  return plan_cache_->GetOrCompile(
+      key, px::CurrentTimeNS(),
+      [&](types::Time64NSValue time_now) -> StatusOr<distributedpb::DistributedPlan> {
+        auto ms = logical_state.plan_options().max_output_rows_per_table();
+        PL_ASSIGN_OR_RETURN(
+            std::unique_ptr<CompilerState> compiler_state,
+            CreateCompilerState(logical_state,
+                                std::make_unique<RelationMap>(stored_state->relation_map),
+                                stored_state->row_counts, registry_info_.get(), ms, time_now));
+        PL_ASSIGN_OR_RETURN(
+            auto distributed_plan,
+            Plan(stored_state->distributed_state, compiler_state.get(), query_request));
+        distributed_plan->SetPlanOptions(logical_state.plan_options());
+        return distributed_plan->ToProto();
+      });
+}
+
+Status LogicalPlanner::StoreDistributedState(std::unique_ptr<StoredDistributedState> stored_state) {
+  stored_state->row_counts =
+      MakeTableRowCountsFromDistributedState(stored_state->distributed_state);
+  distributedpb::DistributedState versioned_state = stored_state->distributed_state;
+  ClearHeartbeatFields(&versioned_state);
+  stored_state->versioned_state = DeterministicSerialize(versioned_state);
+  absl::MutexLock lock(&stored_state_lock_);
+  // The heartbeats of the agents update the state all the time, but the cached plans stay valid
+  // until the schemas or the agents change.
+  if (stored_state_ != nullptr && stored_state_->versioned_state == stored_state->versioned_state) {
+    stored_state->version = stored_state_->version;
+  } else {
+    stored_state->version = ++stored_state_version_;
+  }
+  stored_state_ = std::move(stored_state);
+  return Status::OK();
+}
+
+Status LogicalPlanner::SetDistributedState(
+    const distributedpb::DistributedState& distributed_state) {
+  absl::MutexLock update_lock(&stored_state_update_lock_);
+  auto stored_state = std::make_unique<StoredDistributedState>();
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
+                      MakeRelationMapFromDistributedState(distributed_state));
+  stored_state->relation_map = std::move(*rel_map);
+  stored_state->distributed_state = distributed_state;
+  return StoreDistributedState(std::move(stored_state));
+}
+
+Status LogicalPlanner::UpdateDistributedState(const distributedpb::DistributedState& upserts,
+                                              const distributedpb::DistributedState& removals) {
+  absl::MutexLock update_lock(&stored_state_update_lock_);
+  std::shared_ptr<const StoredDistributedState> current;
+  {
+    absl::MutexLock lock(&stored_state_lock_);
+    current = stored_state_;
+  }
+  if (current == nullptr) {
+    return error::FailedPrecondition("No distributed state was set in the planner.");
+  }
+
+  absl::flat_hash_map<std::string, const distributedpb::CarnotInfo*> upserted_carnots;
+  for (const auto& carnot_info : upserts.carnot_info()) {
+    upserted_carnots[carnot_info.query_broker_address()] = &carnot_info;
+  }
+  absl::flat_hash_map<std::string, const distributedpb::SchemaInfo*> upserted_schemas;
+  for (const auto& schema_info : upserts.schema_info()) {
+    upserted_schemas[schema_info.name()] = &schema_info;
+  }
+  absl::flat_hash_set<std::string> removed_carnots;
+  for (const auto& carnot_info : removals.carnot_info()) {
+    removed_carnots.insert(carnot_info.query_broker_address());
+  }
+  absl::flat_hash_set<std::string> removed_schemas;
+  for (const auto& schema_info : removals.schema_info()) {
+    removed_schemas.insert(schema_info.name());
+  }
+
+  auto next = std::make_unique<StoredDistributedState>();
+  next->relation_map = current->relation_map;
+
+  // Entries that are replaced keep their position, so that the plans don't change needlessly.
+  for (const auto& carnot_info : current->distributed_state.carnot_info()) {
+    auto it = upserted_carnots.find(carnot_info.query_broker_address());
+    if (it != upserted_carnots.end()) {
+      *next->distributed_state.add_carnot_info() = *it->second;
+      upserted_carnots.erase(it);
+    } else if (!removed_carnots.contains(carnot_info.query_broker_address())) {
+      *next->distributed_state.add_carnot_info() = carnot_info;
+    }
+  }
+  for (const auto& carnot_info : upserts.carnot_info()) {
+    auto it = upserted_carnots.find(carnot_info.query_broker_address());
+    if (it != upserted_carnots.end()) {
+      *next->distributed_state.add_carnot_info() = *it->second;
+      upserted_carnots.erase(it);
+    }
+  }
+
+  for (const auto& name : removed_schemas) {
+    next->relation_map.erase(name);
+  }
+  for (const auto& schema_info : upserts.schema_info()) {
+    table_store::schema::Relation rel;
+    PL_RETURN_IF_ERROR(rel.FromProto(&schema_info.relation()));
+    next->relation_map[schema_info.name()] = std::move(rel);
+  }
+  for (const auto& schema_info : current->distributed_state.schema_info()) {
+    auto it = upserted_schemas.find(schema_info.name());
+    if (it != upserted_schemas.end()) {
+      *next->distributed_state.add_schema_info() = *it->second;
+      upserted_schemas.erase(it);
+    } else if (!removed_schemas.contains(schema_info.name())) {
+      *next->distributed_state.add_schema_info() = schema_info;
+    }
+  }
+  for (const auto& schema_info : upserts.schema_info()) {
+    auto it = upserted_schemas.find(schema_info.name());
+    if (it != upserted_schemas.end()) {
+      *next->distributed_state.add_schema_info() = *it->second;
+      upserted_schemas.erase(it);
+    }
+  }
+
+  return StoreDistributedState(std::move(next));
 }
 
 StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
@@ -121,7 +354,8 @@ StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
   auto ms = logical_state.plan_options().max_output_rows_per_table();
   VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      CreateCompilerState(logical_state, registry_info_.get(), ms,
+                                          px::CurrentTimeNS()));
 
   std::vector<plannerpb::FuncToExecute> exec_funcs(mutations_req.exec_funcs().begin(),
                                                    mutations_req.exec_funcs().end());
@@ -21,14 +21,19 @@
 #include <string>
 #include <vector>
 
+#include <absl/synchronization/mutex.h>
+
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
+#include "src/carnot/planner/plan_cache.h"
 #include "src/carnot/planner/plannerpb/func_args.pb.h"
 #include "src/carnot/planner/probes/probes.h"
 #include "src/shared/scriptspb/scripts.pb.h"
 
+DECLARE_int32(planner_plan_cache_size);
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -58,20 +63,95 @@ class LogicalPlanner : public NotCopyable {
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::QueryRequest& query);
 
+  /**
+   * @brief Plans the query like Plan(), and returns the proto of the distributed plan with the plan
+   * options of the logical state. The plans are cached by the query, its arguments and the logical
+   * state, so planning a script again only binds the current time into the cached plan.
+   *
+   * @param logical_state: the distributed layout of the vizier instance.
+   * @param query: QueryRequest
+   * @return the distributed plan proto or error if one occurs during compilation.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanToProto(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query);
+
   StatusOr<std::unique_ptr<compiler::MutationsIR>> CompileTrace(
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::CompileMutationsRequest& mutations_req);
 
+  /**
+   * @brief Replaces the distributed state that is kept by the planner, for use by
+   * PlanToProtoWithStoredState(). This lets callers send the state once, and then only the changes
+   * to it, rather than sending (and the planner parsing) all of it for every query.
+   */
+  Status SetDistributedState(const distributedpb::DistributedState& distributed_state);
+
+  /**
+   * @brief Applies changes to the distributed state kept by the planner.
+   *
+   * @param upserts: Carnot instances that replace the ones with the same query broker address, or
+   * are added, and likewise schemas by table name.
+   * @param removals: Carnot instances and schemas to remove. Only the query broker addresses and
+   * the table names are looked at. Removals are applied before the upserts.
+   * @return error if no distributed state was set yet.
+   */
+  Status UpdateDistributedState(const distributedpb::DistributedState& upserts,
+                                const distributedpb::DistributedState& removals);
+
+  /**
+   * @brief Plans the query like PlanToProto(), against the distributed state kept by the planner.
+   * The distributed state of `logical_state` isn't looked at, and should be left empty.
+   *
+   * @return the distributed plan proto, or error if no distributed state was set yet or one occurs
+   * during compilation.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanToProtoWithStoredState(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query);
+
   Status Init(std::unique_ptr<planner::RegistryInfo> registry_info);
   Status Init(const udfspb::UDFInfo& udf_info);
 
+  const PlanCache<distributedpb::DistributedPlan>& plan_cache() const { return *plan_cache_; }
+
  protected:
   LogicalPlanner() {}
 
  private:
+  // The distributed state kept by the planner, along with what's derived from it for each query.
+  // It's immutable once stored, so queries keep planning against a consistent snapshot while the
+  // state is updated.
+  struct StoredDistributedState {
+    distributedpb::DistributedState distributed_state;
+    RelationMap relation_map;
+    TableRowCounts row_counts;
+    // Identifies this state in the plan cache keys. It only changes along with `versioned_state`.
+    int64_t version = 0;
+    // The serialized distributed state, without the fields that change with every heartbeat.
+    std::string versioned_state;
+  };
+
+  StatusOr<std::unique_ptr<distributed::DistributedPlan>> Plan(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query, types::Time64NSValue time_now);
+
+  StatusOr<std::unique_ptr<distributed::DistributedPlan>> Plan(
+      const distributedpb::DistributedState& distributed_state, CompilerState* compiler_state,
+      const plannerpb::QueryRequest& query);
+
+  Status StoreDistributedState(std::unique_ptr<StoredDistributedState> stored_state);
+
   compiler::Compiler compiler_;
   std::unique_ptr<distributed::Planner> distributed_planner_;
   std::unique_ptr<planner::RegistryInfo> registry_info_;
+  std::unique_ptr<PlanCache<distributedpb::DistributedPlan>> plan_cache_;
+
+  // Serializes the changes to the stored state.
+  absl::Mutex stored_state_update_lock_;
+  absl::Mutex stored_state_lock_;
+  std::shared_ptr<const StoredDistributedState> stored_state_ ABSL_GUARDED_BY(stored_state_lock_);
+  int64_t stored_state_version_ ABSL_GUARDED_BY(stored_state_lock_) = 0;
 };
 
 }  // namespace planner
@@ -20,9 +20,11 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
 #include <pypa/parser/parser.hh>
 
 #include "src/api/proto/uuidpb/uuid.pb.h"
@@ -71,6 +73,85 @@ TEST_F(LogicalPlannerTest, distributed_plan_test_basic_queries) {
   EXPECT_OK(plan->ToProto());
 }
 
+TEST_F(LogicalPlannerTest, plan_has_rule_execution_stats) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto ps = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  auto plan_pb_or_s = planner->PlanToProto(ps, MakeQueryRequest(testutils::kHttpRequestStats));
+  ASSERT_OK(plan_pb_or_s);
+  auto plan_pb = plan_pb_or_s.ConsumeValueOrDie();
+
+  // The stats cover the rules of both the single node compilation and the distributed planning.
+  absl::flat_hash_set<std::string> batch_names;
+  for (const auto& stats : plan_pb.rule_execution_stats()) {
+    EXPECT_FALSE(stats.rule_name().empty());
+    EXPECT_GT(stats.num_executions(), 0);
+    batch_names.insert(stats.batch_name());
+  }
+  EXPECT_TRUE(batch_names.contains("MergeNodes"));
+  EXPECT_TRUE(batch_names.contains("SplitPEMOnlyUDFs"));
+}
+
+constexpr char kSelectTimeQuery[] = R"pxl(
+import px
+px.display(px.DataFrame(table='http_events', select=['time_']))
+)pxl";
+
+// Changes the fields of the state that the agents update with every heartbeat.
+void SimulateHeartbeat(int64_t beat, distributedpb::DistributedState* state) {
+  for (auto& carnot_info : *state->mutable_carnot_info()) {
+    carnot_info.mutable_load()->set_cpu_usage(0.1 * beat);
+    carnot_info.mutable_load()->set_num_running_queries(beat);
+    for (auto& table_info : *carnot_info.mutable_table_info()) {
+      table_info.mutable_time_range()->set_min_time_ns(beat);
+      table_info.mutable_time_range()->set_max_time_ns(1000 * beat);
+    }
+  }
+  for (auto& schema_info : *state->mutable_schema_info()) {
+    schema_info.set_num_rows(100 * beat);
+  }
+}
+
+TEST_F(LogicalPlannerTest, plan_cache_ignores_heartbeat_fields) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto ps = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  for (int64_t beat = 1; beat <= 3; ++beat) {
+    SimulateHeartbeat(beat, ps.mutable_distributed_state());
+    ASSERT_OK(planner->PlanToProto(ps, MakeQueryRequest(kSelectTimeQuery)));
+  }
+  EXPECT_EQ(planner->plan_cache().misses(), 1);
+  EXPECT_EQ(planner->plan_cache().hits(), 2);
+
+  // The agents are still part of the key.
+  ps.mutable_distributed_state()->mutable_carnot_info(0)->set_asid(789);
+  ASSERT_OK(planner->PlanToProto(ps, MakeQueryRequest(kSelectTimeQuery)));
+  EXPECT_EQ(planner->plan_cache().misses(), 2);
+}
+
+TEST_F(LogicalPlannerTest, plan_cache_ignores_heartbeat_fields_of_stored_state) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto ps = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  distributedpb::DistributedState state = ps.distributed_state();
+  ps.clear_distributed_state();
+  ASSERT_OK(planner->SetDistributedState(state));
+  for (int64_t beat = 1; beat <= 3; ++beat) {
+    SimulateHeartbeat(beat, &state);
+    distributedpb::DistributedState upserts;
+    *upserts.mutable_carnot_info() = state.carnot_info();
+    *upserts.mutable_schema_info() = state.schema_info();
+    ASSERT_OK(planner->UpdateDistributedState(upserts, distributedpb::DistributedState()));
+    ASSERT_OK(planner->PlanToProtoWithStoredState(ps, MakeQueryRequest(kSelectTimeQuery)));
+  }
+  EXPECT_EQ(planner->plan_cache().misses(), 1);
+  EXPECT_EQ(planner->plan_cache().hits(), 2);
+
+  distributedpb::DistributedState upserts;
+  *upserts.add_carnot_info() = state.carnot_info(0);
+  upserts.mutable_carnot_info(0)->set_asid(789);
+  ASSERT_OK(planner->UpdateDistributedState(upserts, distributedpb::DistributedState()));
+  ASSERT_OK(planner->PlanToProtoWithStoredState(ps, MakeQueryRequest(kSelectTimeQuery)));
+  EXPECT_EQ(planner->plan_cache().misses(), 2);
+}
+
 constexpr char kSimpleQueryDefaultLimit[] = R"pxl(
 import px
 t1 = px.DataFrame(table='http_events', start_time='-120s', select=['time_'])
@@ -18,6 +18,7 @@
 
 #include "src/carnot/planner/objects/dataframe.h"
 #include "src/carnot/planner/ir/ast_utils.h"
+#include "src/carnot/planner/ir/time_ir.h"
 #include "src/carnot/planner/objects/collection_object.h"
 #include "src/carnot/planner/objects/expr_object.h"
 #include "src/carnot/planner/objects/funcobject.h"
@@ -107,6 +108,23 @@ StatusOr<std::vector<ColumnIR*>> ProcessCols(IR* graph, const pypa::AstPtr& ast,
   return columns;
 }
 
+StatusOr<std::vector<std::string>> ParseSuffixes(QLObjectPtr suffixes_node) {
+  // TODO(philkuz) consider using a struct instead of a vector because it's a fixed size.
+  if (!CollectionObject::IsCollection(suffixes_node)) {
+    return suffixes_node->CreateError(
+        "'suffixes' must be a list with 2 strings for the left and right suffixes. Received $0",
+        suffixes_node->name());
+  }
+
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> suffix_strs,
+                      ParseAsListOfStrings(suffixes_node, "suffixes"));
+  if (suffix_strs.size() != 2) {
+    return suffixes_node->CreateError("'suffixes' must be a list with 2 elements. Received $0",
+                                      suffix_strs.size());
+  }
+  return suffix_strs;
+}
+
 // Handles the merge() operator logic.
 StatusOr<QLObjectPtr> JoinHandler(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                   const ParsedArgs& args, ASTVisitor* visitor) {
@@ -114,31 +132,70 @@ StatusOr<QLObjectPtr> JoinHandler(IR* graph, OperatorIR* op, const pypa::AstPtr&
   // to check again.
   PL_ASSIGN_OR_RETURN(OperatorIR * right, GetArgAs<OperatorIR>(ast, args, "right"));
   PL_ASSIGN_OR_RETURN(StringIR * how, GetArgAs<StringIR>(ast, args, "how"));
-  QLObjectPtr suffixes_node = args.GetArg("suffixes");
   std::string how_type = how->str();
 
   PL_ASSIGN_OR_RETURN(std::vector<ColumnIR*> left_on_cols,
                       ProcessCols(graph, ast, args.GetArg("left_on"), "left_on", 0));
   PL_ASSIGN_OR_RETURN(std::vector<ColumnIR*> right_on_cols,
                       ProcessCols(graph, ast, args.GetArg("right_on"), "right_on", 1));
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> suffix_strs,
+                      ParseSuffixes(args.GetArg("suffixes")));
 
-  // TODO(philkuz) consider using a struct instead of a vector because it's a fixed size.
-  if (!CollectionObject::IsCollection(suffixes_node)) {
-    return suffixes_node->CreateError(
-        "'suffixes' must be a list with 2 strings for the left and right suffixes. Received $0",
-        suffixes_node->name());
+  PL_ASSIGN_OR_RETURN(JoinIR * join_op,
+                      graph->CreateNode<JoinIR>(ast, std::vector<OperatorIR*>{op, right}, how_type,
+                                                left_on_cols, right_on_cols, suffix_strs));
+  return Dataframe::Create(join_op, visitor);
+}
+
+// Parses the as-of join tolerance, either as a duration string like '5s' or as nanoseconds.
+StatusOr<int64_t> ParseTolerance(ExpressionIR* tolerance) {
+  if (Match(tolerance, Int())) {
+    return static_cast<IntIR*>(tolerance)->val();
+  }
+  if (tolerance->type() == IRNodeType::kTime) {
+    return static_cast<TimeIR*>(tolerance)->val();
+  }
+  if (Match(tolerance, String())) {
+    auto tolerance_or_s = StringToTimeInt(static_cast<StringIR*>(tolerance)->str());
+    if (tolerance_or_s.ok()) {
+      return tolerance_or_s.ConsumeValueOrDie();
+    }
   }
+  return tolerance->CreateIRNodeError(
+      "'tolerance' must be a duration like '5s' or an integer number of nanoseconds");
+}
 
-  PL_ASSIGN_OR_RETURN(std::vector<std::string> suffix_strs,
-                      ParseAsListOfStrings(suffixes_node, "suffixes"));
-  if (suffix_strs.size() != 2) {
-    return suffixes_node->CreateError("'suffixes' must be a list with 2 elements. Received $0",
-                                      suffix_strs.size());
+// Handles the merge_asof() operator logic.
+StatusOr<QLObjectPtr> MergeAsOfHandler(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                       const ParsedArgs& args, ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(OperatorIR * right, GetArgAs<OperatorIR>(ast, args, "right"));
+  PL_ASSIGN_OR_RETURN(ExpressionIR * tolerance_expr,
+                      GetArgAs<ExpressionIR>(ast, args, "tolerance"));
+  PL_ASSIGN_OR_RETURN(StringIR * on, GetArgAs<StringIR>(ast, args, "on"));
+  PL_ASSIGN_OR_RETURN(StringIR * how, GetArgAs<StringIR>(ast, args, "how"));
+  if (how->str() != "left" && how->str() != "inner") {
+    return how->CreateIRNodeError("merge_asof only supports 'left' and 'inner' joins, not '$0'",
+                                  how->str());
   }
+  PL_ASSIGN_OR_RETURN(int64_t tolerance_ns, ParseTolerance(tolerance_expr));
+
+  // The keys have the same names on both sides.
+  PL_ASSIGN_OR_RETURN(std::vector<ColumnIR*> left_by_cols,
+                      ProcessCols(graph, ast, args.GetArg("by"), "by", 0));
+  PL_ASSIGN_OR_RETURN(std::vector<ColumnIR*> right_by_cols,
+                      ProcessCols(graph, ast, args.GetArg("by"), "by", 1));
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> suffix_strs,
+                      ParseSuffixes(args.GetArg("suffixes")));
 
   PL_ASSIGN_OR_RETURN(JoinIR * join_op,
-                      graph->CreateNode<JoinIR>(ast, std::vector<OperatorIR*>{op, right}, how_type,
-                                                left_on_cols, right_on_cols, suffix_strs));
+                      graph->CreateNode<JoinIR>(ast, std::vector<OperatorIR*>{op, right},
+                                                how->str(), left_by_cols, right_by_cols,
+                                                suffix_strs));
+  PL_ASSIGN_OR_RETURN(ColumnIR * left_time_col,
+                      graph->CreateNode<ColumnIR>(ast, on->str(), /* parent_idx */ 0));
+  PL_ASSIGN_OR_RETURN(ColumnIR * right_time_col,
+                      graph->CreateNode<ColumnIR>(ast, on->str(), /* parent_idx */ 1));
+  PL_RETURN_IF_ERROR(join_op->SetAsOf(left_time_col, right_time_col, tolerance_ns));
   return Dataframe::Create(join_op, visitor);
 }
 
@@ -233,6 +290,34 @@ StatusOr<QLObjectPtr> LimitHandler(IR* graph, OperatorIR* op, const pypa::AstPtr
   return Dataframe::Create(limit_op, visitor);
 }
 
+// Handles the nlargest() and nsmallest() DataFrame logic.
+StatusOr<QLObjectPtr> TopKHandler(IR* graph, OperatorIR* op, bool descending,
+                                  const pypa::AstPtr& ast, const ParsedArgs& args,
+                                  ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(IntIR * rows_node, GetArgAs<IntIR>(ast, args, "n"));
+  if (rows_node->val() < 0) {
+    return rows_node->CreateIRNodeError("n must be non-negative, received $0", rows_node->val());
+  }
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> column_names,
+                      ParseAsListOfStrings(args.GetArg("columns"), "columns"));
+  if (column_names.empty()) {
+    return CreateAstError(ast, "Expected at least one column to order by");
+  }
+  std::vector<ColumnIR*> sort_columns;
+  sort_columns.reserve(column_names.size());
+  for (const auto& name : column_names) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col, graph->CreateNode<ColumnIR>(ast, name, /* parent_idx */ 0));
+    sort_columns.push_back(col);
+  }
+
+  PL_ASSIGN_OR_RETURN(
+      TopKIR * top_k_op,
+      graph->CreateNode<TopKIR>(ast, op, sort_columns,
+                                std::vector<bool>(sort_columns.size(), descending),
+                                rows_node->val()));
+  return Dataframe::Create(top_k_op, visitor);
+}
+
 class SubscriptHandler {
  public:
   /**
@@ -402,6 +487,26 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(mergefn->SetDocString(kMergeOpDocstring));
   AddMethod(kMergeOpID, mergefn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def merge_asof(self, right, tolerance, on='time_', by=[], how='left', suffixes=['_x', '_y']):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> merge_asof_fn,
+      FuncObject::Create(kMergeAsOfOpID, {"right", "tolerance", "on", "by", "how", "suffixes"},
+                         {{"on", "'time_'"},
+                          {"by", "[]"},
+                          {"how", "'left'"},
+                          {"suffixes", "['_x', '_y']"}},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&MergeAsOfHandler, graph(), op(), std::placeholders::_1,
+                                   std::placeholders::_2, std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(merge_asof_fn->SetDocString(kMergeAsOfOpDocstring));
+  AddMethod(kMergeAsOfOpID, merge_asof_fn);
+
   /**
    * # Equivalent to the python method method syntax:
    * def agg(self, **kwargs):
@@ -459,6 +564,40 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(limitfn->SetDocString(kLimitOpDocstring));
   AddMethod(kLimitOpID, limitfn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def nlargest(self, n, columns):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> nlargest_fn,
+      FuncObject::Create(kNLargestOpID, {"n", "columns"}, {},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&TopKHandler, graph(), op(), /* descending */ true,
+                                   std::placeholders::_1, std::placeholders::_2,
+                                   std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(nlargest_fn->SetDocString(kNLargestOpDocstring));
+  AddMethod(kNLargestOpID, nlargest_fn);
+
+  /**
+   * # Equivalent to the python method method syntax:
+   * def nsmallest(self, n, columns):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> nsmallest_fn,
+      FuncObject::Create(kNSmallestOpID, {"n", "columns"}, {},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&TopKHandler, graph(), op(), /* descending */ false,
+                                   std::placeholders::_1, std::placeholders::_2,
+                                   std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(nsmallest_fn->SetDocString(kNSmallestOpDocstring));
+  AddMethod(kNSmallestOpID, nsmallest_fn);
+
   /**
    *
    * # Equivalent to the python method method syntax:
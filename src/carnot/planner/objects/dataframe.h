@@ -266,6 +266,57 @@ class Dataframe : public QLObject {
     px.DataFrame: DataFrame with the first n rows.
   )doc";
 
+  inline static constexpr char kNLargestOpID[] = "nlargest";
+  inline static constexpr char kNLargestOpDocstring[] = R"doc(
+  Return the first n rows ordered by the columns in descending order.
+
+  Returns a DataFrame with the n rows that have the largest values in the passed in columns.
+  This is equivalent to sorting the DataFrame in descending order and calling `head(n)`, but
+  only the n largest rows are kept while processing the data.
+
+  :topic: dataframe_ops
+  :opname: N Largest
+
+  Examples:
+    df = px.DataFrame('http_events')
+    df = df.groupby('req_path').agg(latency=('latency', px.mean))
+    # Keep the 10 paths with the highest mean latency.
+    df = df.nlargest(10, 'latency')
+
+  Args:
+    n (int): The number of rows to return.
+    columns (Union[str,List[str]]): DataFrame columns to order by, either as a string
+      or a list. Later columns break ties between earlier ones.
+
+  Returns:
+    px.DataFrame: DataFrame with the n largest rows, in descending order.
+  )doc";
+
+  inline static constexpr char kNSmallestOpID[] = "nsmallest";
+  inline static constexpr char kNSmallestOpDocstring[] = R"doc(
+  Return the first n rows ordered by the columns in ascending order.
+
+  Returns a DataFrame with the n rows that have the smallest values in the passed in columns.
+  This is equivalent to sorting the DataFrame in ascending order and calling `head(n)`, but
+  only the n smallest rows are kept while processing the data.
+
+  :topic: dataframe_ops
+  :opname: N Smallest
+
+  Examples:
+    df = px.DataFrame('process_stats')
+    # Keep the 5 samples with the least resident memory.
+    df = df.nsmallest(5, 'rss_bytes')
+
+  Args:
+    n (int): The number of rows to return.
+    columns (Union[str,List[str]]): DataFrame columns to order by, either as a string
+      or a list. Later columns break ties between earlier ones.
+
+  Returns:
+    px.DataFrame: DataFrame with the n smallest rows, in ascending order.
+  )doc";
+
   inline static constexpr char kMergeOpID[] = "merge";
   inline static constexpr char kMergeOpDocstring[] = R"doc(
   Merges the input DataFrame with this one using a database-style join.
@@ -312,6 +363,39 @@ class Dataframe : public QLObject {
     px.DataFrame: Merged DataFrame with the relation
     [left_join_col, ...remaining_left_columns, ...remaining_right_columns].
   )doc";
+  inline static constexpr char kMergeAsOfOpID[] = "merge_asof";
+  inline static constexpr char kMergeAsOfOpDocstring[] = R"doc(
+  Merges the input DataFrame with this one by the nearest earlier time.
+
+  Each row of this DataFrame is joined with the latest row of the right DataFrame that has the
+  same `by` values, and whose time is at or before the time of the row, by at most the tolerance.
+  Both DataFrames are merged in time order as they stream in, so only the rows within the
+  tolerance are kept in memory.
+
+  Examples:
+    # Attach the latest memory sample of each process to its HTTP requests.
+    left_df = px.DataFrame('http_events', start_time='-30s')
+    right_df = px.DataFrame('process_stats', start_time='-30s')
+    df = left_df.merge_asof(right_df, tolerance='15s', by='upid', suffixes=['', '_stats'])
+
+  :topic: dataframe_ops
+  :opname: As-Of Join
+
+  Args:
+    right (px.DataFrame): The DataFrame to join with this DataFrame.
+    tolerance (Union[string, int]): How far back the time of a matching right row can be, either as
+      a duration string like '5s' or in nanoseconds.
+    on (string, default 'time_'): The time column of both DataFrames.
+    by (Union[string, List[string]], default []): Columns of both DataFrames that must be equal.
+    how (['left', 'inner'], default 'left'): the type of merge (join) to perform.
+      * left: keep the rows without a match, with default values for the right columns.
+      * inner: drop the rows without a match.
+    suffixes (Tuple[string, string], default ['_x', '_y']): The suffixes to apply to duplicate columns.
+
+  Returns:
+    px.DataFrame: Merged DataFrame with the relation
+    [...left_columns, ...right_columns], in the order of this DataFrame.
+  )doc";
   inline static constexpr char kGroupByOpID[] = "groupby";
   inline static constexpr char kGroupByOpDocstring[] = R"doc(
   Groups the data in preparation for an aggregate.
@@ -368,11 +452,13 @@ class Dataframe : public QLObject {
   Groups the data by rolling windows.
 
   Rolls up data into groups based on the rolling window that it belongs to. Used to define
-  window aggregates, the streaming analog of batch aggregates.
+  window aggregates, the streaming analog of batch aggregates. The windows are tumbling windows
+  over time_, and the results of a window are emitted as soon as time_ moves past its end. The
+  start of each window is in the time_ column of the result.
 
   Examples:
     df = px.DataFrame('process_stats')
-    df = df.rolling('2s').agg(...)
+    df = df.rolling('2s').groupby('upid').agg(rss=('rss_bytes', px.mean))
 
 
   :topic: dataframe_ops
@@ -109,6 +109,43 @@ TEST_F(DataframeTest, Merge_NonListKeys) {
   EXPECT_THAT(join->suffix_strs(), ElementsAre("_x", "_y"));
 }
 
+TEST_F(DataframeTest, MergeAsOf) {
+  MemorySourceIR* src2 = MakeMemSource();
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<QLObject> df2, Dataframe::Create(src2, ast_visitor.get()));
+
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj,
+                       df->GetMethod(Dataframe::kMergeAsOfOpID));
+  ArgMap args{{{"by", ToQLObject(MakeString("upid"))}}, {df2, ToQLObject(MakeString("5s"))}};
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<QLObject> obj, func_obj->Call(args, ast));
+  ASSERT_EQ(obj->type_descriptor().type(), QLObjectType::kDataframe);
+  auto join_df = static_cast<Dataframe*>(obj.get());
+
+  ASSERT_MATCH(join_df->op(), Join());
+  JoinIR* join = static_cast<JoinIR*>(join_df->op());
+  EXPECT_THAT(join->parents(), ElementsAre(src, src2));
+  EXPECT_EQ(join->join_type(), JoinIR::JoinType::kLeft);
+  ASSERT_TRUE(join->is_as_of());
+  EXPECT_MATCH(join->left_time_column(), ColumnNode("time_", 0));
+  EXPECT_MATCH(join->right_time_column(), ColumnNode("time_", 1));
+  EXPECT_EQ(5 * 1000 * 1000 * 1000LL, join->tolerance_ns());
+
+  EXPECT_EQ(1, join->left_on_columns().size());
+  EXPECT_MATCH(join->left_on_columns()[0], ColumnNode("upid", 0));
+  EXPECT_MATCH(join->right_on_columns()[0], ColumnNode("upid", 1));
+  EXPECT_THAT(join->suffix_strs(), ElementsAre("_x", "_y"));
+}
+
+TEST_F(DataframeTest, MergeAsOf_UnsupportedJoinType) {
+  MemorySourceIR* src2 = MakeMemSource();
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<QLObject> df2, Dataframe::Create(src2, ast_visitor.get()));
+
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj,
+                       df->GetMethod(Dataframe::kMergeAsOfOpID));
+  ArgMap args{{{"how", ToQLObject(MakeString("outer"))}}, {df2, ToQLObject(MakeInt(10))}};
+  EXPECT_THAT(func_obj->Call(args, ast).status(),
+              HasCompilerError("merge_asof only supports 'left' and 'inner' joins, not 'outer'"));
+}
+
 TEST_F(DataframeTest, Drop_WithList) {
   ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj, df->GetMethod(Dataframe::kDropOpID));
   ArgMap args{{}, {MakeListObj(MakeString("foo"), MakeString("bar"))}};
@@ -249,6 +286,43 @@ TEST_F(DataframeTest, LimitNonIntArgument) {
               HasCompilerError("Expected arg 'n' as type 'Int', received 'String'"));
 }
 
+TEST_F(DataframeTest, CreateNLargest) {
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj,
+                       df->GetMethod(Dataframe::kNLargestOpID));
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<QLObject> list,
+      ListObject::Create({ToQLObject(MakeString("col1")), ToQLObject(MakeString("col2"))},
+                         ast_visitor.get()));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<QLObject> obj,
+                       func_obj->Call({{}, {ToQLObject(MakeInt(10)), list}}, ast));
+  ASSERT_EQ(obj->type_descriptor().type(), QLObjectType::kDataframe);
+  auto top_k_obj = std::static_pointer_cast<Dataframe>(obj);
+
+  ASSERT_MATCH(top_k_obj->op(), TopK());
+  TopKIR* top_k = static_cast<TopKIR*>(top_k_obj->op());
+  EXPECT_EQ(top_k->limit_value(), 10);
+  ASSERT_EQ(top_k->sort_columns().size(), 2);
+  EXPECT_MATCH(top_k->sort_columns()[0], ColumnNode("col1", 0));
+  EXPECT_MATCH(top_k->sort_columns()[1], ColumnNode("col2", 0));
+  EXPECT_THAT(top_k->descending(), ::testing::ElementsAre(true, true));
+}
+
+TEST_F(DataframeTest, CreateNSmallest) {
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj,
+                       df->GetMethod(Dataframe::kNSmallestOpID));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<QLObject> obj,
+                       func_obj->Call(MakeArgMap({}, {MakeInt(3), MakeString("col1")}), ast));
+  ASSERT_EQ(obj->type_descriptor().type(), QLObjectType::kDataframe);
+  auto top_k_obj = std::static_pointer_cast<Dataframe>(obj);
+
+  ASSERT_MATCH(top_k_obj->op(), TopK());
+  TopKIR* top_k = static_cast<TopKIR*>(top_k_obj->op());
+  EXPECT_EQ(top_k->limit_value(), 3);
+  ASSERT_EQ(top_k->sort_columns().size(), 1);
+  EXPECT_MATCH(top_k->sort_columns()[0], ColumnNode("col1", 0));
+  EXPECT_THAT(top_k->descending(), ::testing::ElementsAre(false));
+}
+
 TEST_F(DataframeTest, SubscriptFilterRows) {
   ASSERT_OK_AND_ASSIGN(std::shared_ptr<FuncObject> func_obj, df->GetSubscriptMethod());
   auto eq_func = MakeEqualsFunc(MakeColumn("service", 0), MakeString("blah"));
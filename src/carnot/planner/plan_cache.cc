@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/plan_cache.h"
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/text_format.h>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+namespace {
+
+std::string MapEntryKey(const Message& entry) {
+  std::string key;
+  google::protobuf::TextFormat::PrintFieldValueToString(entry, entry.GetDescriptor()->map_key(),
+                                                        -1, &key);
+  return key;
+}
+
+bool DiffMessages(const Message& plan, const Message& probe, int64_t delta_ns,
+                  PlanFieldPath* path, std::vector<PlanFieldPath>* time_params);
+
+bool DiffValues(const Message& plan, const Message& probe, const FieldDescriptor* field, int index,
+                int64_t delta_ns, PlanFieldPath* path, std::vector<PlanFieldPath>* time_params) {
+  const Reflection* plan_reflection = plan.GetReflection();
+  const Reflection* probe_reflection = probe.GetReflection();
+  path->push_back({field, index, ""});
+  bool ok = true;
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    const Message& plan_msg = index < 0 ? plan_reflection->GetMessage(plan, field)
+                                        : plan_reflection->GetRepeatedMessage(plan, field, index);
+    const Message& probe_msg = index < 0
+                                   ? probe_reflection->GetMessage(probe, field)
+                                   : probe_reflection->GetRepeatedMessage(probe, field, index);
+    ok = DiffMessages(plan_msg, probe_msg, delta_ns, path, time_params);
+  } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_INT64) {
+    int64_t plan_val = index < 0 ? plan_reflection->GetInt64(plan, field)
+                                 : plan_reflection->GetRepeatedInt64(plan, field, index);
+    int64_t probe_val = index < 0 ? probe_reflection->GetInt64(probe, field)
+                                  : probe_reflection->GetRepeatedInt64(probe, field, index);
+    if (plan_val != probe_val) {
+      ok = probe_val - plan_val == delta_ns;
+      if (ok) {
+        time_params->push_back(*path);
+      }
+    }
+  } else {
+    std::string plan_val;
+    std::string probe_val;
+    google::protobuf::TextFormat::PrintFieldValueToString(plan, field, index, &plan_val);
+    google::protobuf::TextFormat::PrintFieldValueToString(probe, field, index, &probe_val);
+    ok = plan_val == probe_val;
+  }
+  path->pop_back();
+  return ok;
+}
+
+bool DiffMaps(const Message& plan, const Message& probe, const FieldDescriptor* field,
+              int64_t delta_ns, PlanFieldPath* path, std::vector<PlanFieldPath>* time_params) {
+  const Reflection* plan_reflection = plan.GetReflection();
+  const Reflection* probe_reflection = probe.GetReflection();
+  // The entries of the two maps aren't necessarily in the same order.
+  absl::flat_hash_map<std::string, const Message*> probe_entries;
+  for (int i = 0; i < probe_reflection->FieldSize(probe, field); ++i) {
+    const Message& entry = probe_reflection->GetRepeatedMessage(probe, field, i);
+    probe_entries[MapEntryKey(entry)] = &entry;
+  }
+  for (int i = 0; i < plan_reflection->FieldSize(plan, field); ++i) {
+    const Message& entry = plan_reflection->GetRepeatedMessage(plan, field, i);
+    std::string key = MapEntryKey(entry);
+    auto probe_entry = probe_entries.find(key);
+    if (probe_entry == probe_entries.end()) {
+      return false;
+    }
+    path->push_back({field, -1, key});
+    bool ok = DiffMessages(entry, *probe_entry->second, delta_ns, path, time_params);
+    path->pop_back();
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DiffMessages(const Message& plan, const Message& probe, int64_t delta_ns,
+                  PlanFieldPath* path, std::vector<PlanFieldPath>* time_params) {
+  std::vector<const FieldDescriptor*> plan_fields;
+  std::vector<const FieldDescriptor*> probe_fields;
+  plan.GetReflection()->ListFields(plan, &plan_fields);
+  probe.GetReflection()->ListFields(probe, &probe_fields);
+  if (plan_fields != probe_fields) {
+    return false;
+  }
+
+  for (const FieldDescriptor* field : plan_fields) {
+    if (!field->is_repeated()) {
+      if (!DiffValues(plan, probe, field, -1, delta_ns, path, time_params)) {
+        return false;
+      }
+      continue;
+    }
+    int size = plan.GetReflection()->FieldSize(plan, field);
+    if (size != probe.GetReflection()->FieldSize(probe, field)) {
+      return false;
+    }
+    if (field->is_map()) {
+      if (!DiffMaps(plan, probe, field, delta_ns, path, time_params)) {
+        return false;
+      }
+      continue;
+    }
+    for (int i = 0; i < size; ++i) {
+      if (!DiffValues(plan, probe, field, i, delta_ns, path, time_params)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool FindTimeParameters(const Message& plan, const Message& probe, int64_t delta_ns,
+                        std::vector<PlanFieldPath>* time_params) {
+  if (plan.GetDescriptor() != probe.GetDescriptor()) {
+    return false;
+  }
+  PlanFieldPath path;
+  time_params->clear();
+  if (!DiffMessages(plan, probe, delta_ns, &path, time_params)) {
+    time_params->clear();
+    return false;
+  }
+  return true;
+}
+
+void BindTimeParameters(const std::vector<PlanFieldPath>& time_params, int64_t delta_ns,
+                        Message* plan) {
+  if (delta_ns == 0) {
+    return;
+  }
+  for (const PlanFieldPath& path : time_params) {
+    Message* msg = plan;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+      const PlanFieldPathElement& elem = path[i];
+      const Reflection* reflection = msg->GetReflection();
+      if (elem.field->is_map()) {
+        Message* entry = nullptr;
+        for (int j = 0; j < reflection->FieldSize(*msg, elem.field); ++j) {
+          Message* candidate = reflection->MutableRepeatedMessage(msg, elem.field, j);
+          if (MapEntryKey(*candidate) == elem.map_key) {
+            entry = candidate;
+            break;
+          }
+        }
+        DCHECK(entry != nullptr) << "Missing map entry " << elem.map_key;
+        msg = entry;
+      } else if (elem.index < 0) {
+        msg = reflection->MutableMessage(msg, elem.field);
+      } else {
+        msg = reflection->MutableRepeatedMessage(msg, elem.field, elem.index);
+      }
+    }
+
+    const PlanFieldPathElement& leaf = path.back();
+    const Reflection* reflection = msg->GetReflection();
+    if (leaf.index < 0) {
+      reflection->SetInt64(msg, leaf.field, reflection->GetInt64(*msg, leaf.field) + delta_ns);
+    } else {
+      reflection->SetRepeatedInt64(
+          msg, leaf.field, leaf.index,
+          reflection->GetRepeatedInt64(*msg, leaf.field, leaf.index) + delta_ns);
+    }
+  }
+}
+
+std::string NormalizeQuery(std::string_view query) {
+  std::vector<std::string_view> lines = absl::StrSplit(query, '\n');
+  std::string normalized;
+  normalized.reserve(query.size());
+  for (std::string_view line : lines) {
+    line = absl::StripTrailingAsciiWhitespace(line);
+    absl::StrAppend(&normalized, line, "\n");
+  }
+  // Trailing blank lines don't change the script either.
+  return std::string(absl::StripTrailingAsciiWhitespace(normalized));
+}
+
+std::string DeterministicSerialize(const Message& msg) {
+  std::string out;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&out);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    msg.SerializeToCodedStream(&coded_stream);
+  }
+  return out;
+}
+
+std::string PlanCacheKey(std::string_view query,
+                         const std::vector<plannerpb::FuncToExecute>& exec_funcs,
+                         std::string_view state_version) {
+  // Each part is prefixed by its length, so that the parts can't run into each other.
+  std::string normalized_query = NormalizeQuery(query);
+  std::string key = absl::StrCat(normalized_query.size(), ":", normalized_query);
+  for (const auto& func : exec_funcs) {
+    std::string func_str = DeterministicSerialize(func);
+    absl::StrAppend(&key, func_str.size(), ":", func_str);
+  }
+  absl::StrAppend(&key, state_version.size(), ":", state_version);
+  return key;
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/message.h>
+
+#include "src/carnot/planner/plannerpb/func_args.pb.h"
+#include "src/common/base/base.h"
+#include "src/common/base/lru_cache.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+// The path from the root of a plan to an int64 field that was derived from the compile time.
+struct PlanFieldPathElement {
+  const google::protobuf::FieldDescriptor* field;
+  // The index into a repeated field, or -1 for singular fields.
+  int index;
+  // The key of the entry for map fields, printed in the text format.
+  std::string map_key;
+};
+using PlanFieldPath = std::vector<PlanFieldPathElement>;
+
+/**
+ * Finds the fields of two plans that were compiled from the same query, where `probe` was compiled
+ * `delta_ns` after `plan`. The int64 fields that differ by exactly `delta_ns` were derived from the
+ * compile time and are added to `time_params`.
+ *
+ * @return false if the plans differ in any other way, in which case the plan can't be rebound to a
+ * different compile time.
+ */
+bool FindTimeParameters(const google::protobuf::Message& plan,
+                        const google::protobuf::Message& probe, int64_t delta_ns,
+                        std::vector<PlanFieldPath>* time_params);
+
+/**
+ * Shifts the time parameters of the plan by `delta_ns`.
+ */
+void BindTimeParameters(const std::vector<PlanFieldPath>& time_params, int64_t delta_ns,
+                        google::protobuf::Message* plan);
+
+/**
+ * Strips the line endings and trailing whitespace that don't change the meaning of a script.
+ */
+std::string NormalizeQuery(std::string_view query);
+
+/**
+ * Serializes the message with a stable ordering of map entries, for use as a version of the state
+ * that a plan was compiled against.
+ */
+std::string DeterministicSerialize(const google::protobuf::Message& msg);
+
+/**
+ * Creates the cache key for the given query, the arguments of its functions, and the version of the
+ * schema and distributed state that it's compiled against.
+ */
+std::string PlanCacheKey(std::string_view query,
+                         const std::vector<plannerpb::FuncToExecute>& exec_funcs,
+                         std::string_view state_version);
+
+// How much later the probe compile of a query runs. This is an odd number of nanoseconds so that
+// values which are rounded from the compile time don't happen to shift by exactly this much.
+constexpr int64_t kPlanCacheProbeDeltaNS = 1'000'000'007;
+
+/**
+ * PlanCache keeps the compiled plans of recently seen queries, so that scripts which run over and
+ * over again, like the ones behind dashboards, don't have to be compiled each time.
+ *
+ * The compile time is the only parameter of a cached plan. When a query misses, it is compiled a
+ * second time with a later compile time, and the fields that moved by exactly as much are recorded.
+ * On a hit those fields are shifted to the requested time, which binds the parameter without
+ * recompiling. Queries whose plans depend on the compile time in any other way are remembered as
+ * uncacheable, and are always compiled.
+ */
+template <typename TPlan>
+class PlanCache : public NotCopyable {
+ public:
+  using CompileFunc = std::function<StatusOr<TPlan>(types::Time64NSValue time_now)>;
+
+  explicit PlanCache(size_t max_entries) : entries_(max_entries) {}
+
+  /**
+   * Returns the plan for the key, bound to `time_now`. Compiles and caches the plan if it isn't in
+   * the cache yet.
+   */
+  StatusOr<TPlan> GetOrCompile(const std::string& key, types::Time64NSValue time_now,
+                               const CompileFunc& compile) {
+    if (entries_.max_entries() == 0) {
+      return compile(time_now);
+    }
+    std::optional<Entry> cached = entries_.Get(key);
+    if (cached.has_value()) {
+      if (!cached->cacheable) {
+        return compile(time_now);
+      }
+      ++hits_;
+      BindTimeParameters(cached->time_params, time_now.val - cached->time_now, &cached->plan);
+      return std::move(cached->plan);
+    }
+    ++misses_;
+
+    PL_ASSIGN_OR_RETURN(TPlan plan, compile(time_now));
+    PL_ASSIGN_OR_RETURN(TPlan probe, compile(time_now.val + kPlanCacheProbeDeltaNS));
+    Entry entry;
+    entry.time_now = time_now.val;
+    entry.cacheable = FindTimeParameters(plan, probe, kPlanCacheProbeDeltaNS, &entry.time_params);
+    if (entry.cacheable) {
+      entry.plan = plan;
+    } else {
+      VLOG(1) << "Not caching a plan that depends on the compile time in ways that can't be "
+                 "rebound";
+    }
+    // Another caller may have compiled the same query in the meantime, its entry is kept.
+    entries_.Insert(key, std::move(entry));
+    return plan;
+  }
+
+  size_t size() const { return entries_.size(); }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    TPlan plan;
+    int64_t time_now = 0;
+    std::vector<PlanFieldPath> time_params;
+    bool cacheable = false;
+  };
+
+  LRUCache<std::string, Entry> entries_;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
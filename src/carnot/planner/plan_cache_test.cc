@@ -0,0 +1,172 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
+#include "src/carnot/planner/plan_cache.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+constexpr int64_t kWindowNS = 300'000'000'000;
+
+// A plan that reads the last 5 minutes of a table, the way relative start times compile.
+planpb::Plan MakePlan(int64_t time_now) {
+  planpb::Plan plan;
+  auto* pf = plan.add_nodes();
+  pf->set_id(1);
+  auto* node = pf->add_nodes();
+  node->set_id(1);
+  auto* mem_src = node->mutable_op()->mutable_mem_source_op();
+  node->mutable_op()->set_op_type(planpb::MEMORY_SOURCE_OPERATOR);
+  mem_src->set_name("http_events");
+  mem_src->mutable_start_time()->set_value(time_now - kWindowNS);
+  mem_src->mutable_stop_time()->set_value(time_now);
+  return plan;
+}
+
+TEST(FindTimeParametersTest, shifts_fields_derived_from_the_compile_time) {
+  std::vector<PlanFieldPath> time_params;
+  ASSERT_TRUE(FindTimeParameters(MakePlan(100), MakePlan(110), 10, &time_params));
+  EXPECT_EQ(2, time_params.size());
+
+  auto plan = MakePlan(100);
+  BindTimeParameters(time_params, 1000, &plan);
+  EXPECT_EQ(MakePlan(1100).DebugString(), plan.DebugString());
+}
+
+TEST(FindTimeParametersTest, other_differences_arent_parameters) {
+  std::vector<PlanFieldPath> time_params;
+  auto probe = MakePlan(110);
+  auto* mem_src = probe.mutable_nodes(0)->mutable_nodes(0)->mutable_op()->mutable_mem_source_op();
+  mem_src->set_name("foo");
+  EXPECT_FALSE(FindTimeParameters(MakePlan(100), probe, 10, &time_params));
+
+  // An int that moved by a different amount, like a rounded time.
+  probe = MakePlan(110);
+  mem_src = probe.mutable_nodes(0)->mutable_nodes(0)->mutable_op()->mutable_mem_source_op();
+  mem_src->mutable_stop_time()->set_value(120);
+  EXPECT_FALSE(FindTimeParameters(MakePlan(100), probe, 10, &time_params));
+  EXPECT_TRUE(time_params.empty());
+}
+
+TEST(FindTimeParametersTest, map_entries) {
+  distributedpb::DistributedPlan plan;
+  distributedpb::DistributedPlan probe;
+  for (const std::string& addr : {"agent1", "agent2", "kelvin"}) {
+    (*plan.mutable_qb_address_to_plan())[addr] = MakePlan(100);
+    (*probe.mutable_qb_address_to_plan())[addr] = MakePlan(110);
+  }
+
+  std::vector<PlanFieldPath> time_params;
+  ASSERT_TRUE(FindTimeParameters(plan, probe, 10, &time_params));
+  EXPECT_EQ(6, time_params.size());
+
+  BindTimeParameters(time_params, 10, &plan);
+  for (const auto& [addr, agent_plan] : plan.qb_address_to_plan()) {
+    EXPECT_EQ(MakePlan(110).DebugString(), agent_plan.DebugString()) << addr;
+  }
+}
+
+TEST(PlanCacheTest, hits_bind_the_time) {
+  PlanCache<planpb::Plan> cache(2);
+  int num_compiles = 0;
+  auto compile = [&](types::Time64NSValue time_now) -> StatusOr<planpb::Plan> {
+    ++num_compiles;
+    return MakePlan(time_now.val);
+  };
+
+  ASSERT_OK_AND_ASSIGN(auto plan, cache.GetOrCompile("q", 1000, compile));
+  EXPECT_EQ(MakePlan(1000).DebugString(), plan.DebugString());
+  // The miss compiles the probe too.
+  EXPECT_EQ(2, num_compiles);
+
+  ASSERT_OK_AND_ASSIGN(plan, cache.GetOrCompile("q", 5000, compile));
+  EXPECT_EQ(MakePlan(5000).DebugString(), plan.DebugString());
+  EXPECT_EQ(2, num_compiles);
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+}
+
+TEST(PlanCacheTest, evicts_least_recently_used) {
+  PlanCache<planpb::Plan> cache(2);
+  auto compile = [&](types::Time64NSValue time_now) -> StatusOr<planpb::Plan> {
+    return MakePlan(time_now.val);
+  };
+  ASSERT_OK(cache.GetOrCompile("a", 0, compile));
+  ASSERT_OK(cache.GetOrCompile("b", 0, compile));
+  ASSERT_OK(cache.GetOrCompile("a", 0, compile));
+  ASSERT_OK(cache.GetOrCompile("c", 0, compile));
+  EXPECT_EQ(2, cache.size());
+
+  // "b" was evicted, "a" wasn't.
+  ASSERT_OK(cache.GetOrCompile("a", 0, compile));
+  EXPECT_EQ(2, cache.hits());
+  ASSERT_OK(cache.GetOrCompile("b", 0, compile));
+  EXPECT_EQ(4, cache.misses());
+}
+
+TEST(PlanCacheTest, uncacheable_plans_are_compiled_every_time) {
+  PlanCache<planpb::Plan> cache(2);
+  int num_compiles = 0;
+  auto compile = [&](types::Time64NSValue time_now) -> StatusOr<planpb::Plan> {
+    ++num_compiles;
+    // Rounding to the second isn't linear in the compile time.
+    return MakePlan(time_now.val / 1'000'000'000 * 1'000'000'000);
+  };
+  ASSERT_OK(cache.GetOrCompile("q", 1, compile));
+  ASSERT_OK(cache.GetOrCompile("q", 1, compile));
+  EXPECT_EQ(3, num_compiles);
+  EXPECT_EQ(0, cache.hits());
+}
+
+TEST(PlanCacheTest, errors_arent_cached) {
+  PlanCache<planpb::Plan> cache(2);
+  auto compile = [&](types::Time64NSValue) -> StatusOr<planpb::Plan> {
+    return error::InvalidArgument("bad query");
+  };
+  EXPECT_NOT_OK(cache.GetOrCompile("q", 0, compile));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(PlanCacheKeyTest, normalizes_the_query) {
+  std::vector<plannerpb::FuncToExecute> exec_funcs(1);
+  exec_funcs[0].set_func_name("main");
+  auto* arg = exec_funcs[0].add_arg_values();
+  arg->set_name("start_time");
+  arg->set_value("-5m");
+
+  auto key = PlanCacheKey("import px\npx.display(df)\n", exec_funcs, "v1");
+  EXPECT_EQ(key, PlanCacheKey("import px  \r\npx.display(df)\n\n", exec_funcs, "v1"));
+  EXPECT_NE(key, PlanCacheKey("import px\npx.display(df)\n", exec_funcs, "v2"));
+  EXPECT_NE(key, PlanCacheKey("import px\npx.display(df)\n", {}, "v1"));
+  // Indentation is part of the script.
+  EXPECT_NE(key, PlanCacheKey("import px\n  px.display(df)\n", exec_funcs, "v1"));
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
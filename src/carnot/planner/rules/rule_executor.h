@@ -17,13 +17,19 @@
  */
 
 #pragma once
+#include <cxxabi.h>
+
+#include <chrono>
+#include <cstdlib>
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "src/carnot/planner/compiler_state/compiler_state.h"
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
 #include "src/carnot/planner/ir/ir.h"
 #include "src/carnot/planner/rules/rules.h"
 
@@ -116,6 +122,25 @@ class BaseRuleBatch {
 
 using RuleBatch = BaseRuleBatch<Rule>;
 
+/**
+ * @brief Returns the unqualified class name of the rule, used to report its execution stats.
+ */
+template <typename TRule>
+std::string RuleName(const TRule& rule) {
+  const char* mangled_name = typeid(rule).name();
+  int status = 0;
+  std::unique_ptr<char, decltype(&std::free)> demangled(
+      abi::__cxa_demangle(mangled_name, nullptr, nullptr, &status), &std::free);
+  std::string name = status == 0 ? demangled.get() : mangled_name;
+  // Strip the namespaces, but not the ones of template arguments.
+  size_t end = name.find('<');
+  size_t last_separator = name.rfind("::", end);
+  if (last_separator != std::string::npos) {
+    name = name.substr(last_separator + 2);
+  }
+  return name;
+}
+
 template <typename TPlan>
 class RuleExecutor {
   using TRule = BaseRule<TPlan>;
@@ -123,7 +148,6 @@ class RuleExecutor {
 
  public:
   virtual ~RuleExecutor() = default;
-  // TODO(philkuz) figure out how to collect stats on the execution.
   Status Execute(TPlan* ir_graph) {
     for (const auto& rb : rule_batches) {
       bool can_continue = true;
@@ -133,7 +157,10 @@ class RuleExecutor {
         iteration += 1;
         bool graph_is_updated = false;
         for (const auto& rule : rb->rules()) {
+          auto start = std::chrono::steady_clock::now();
           PL_ASSIGN_OR_RETURN(bool rule_updates_graph, rule->Execute(ir_graph));
+          RecordExecution(rb->name(), rule.get(), rule_updates_graph,
+                          std::chrono::steady_clock::now() - start);
           graph_is_updated = graph_is_updated || rule_updates_graph;
         }
         if (iteration >= rb->max_iterations() && graph_is_updated) {
@@ -160,8 +187,33 @@ class RuleExecutor {
     return out_ptr;
   }
 
+  /**
+   * @brief The execution stats of every rule that ran, in the order the rules first ran.
+   */
+  const std::vector<distributedpb::RuleExecutionStats>& rule_execution_stats() const {
+    return rule_execution_stats_;
+  }
+
  private:
+  void RecordExecution(const std::string& batch_name, const TRule* rule, bool updated_graph,
+                       std::chrono::steady_clock::duration duration) {
+    auto [iter, inserted] = rule_stats_idx_.try_emplace(rule, rule_execution_stats_.size());
+    if (inserted) {
+      auto& stats = rule_execution_stats_.emplace_back();
+      stats.set_batch_name(batch_name);
+      stats.set_rule_name(RuleName(*rule));
+    }
+    auto& stats = rule_execution_stats_[iter->second];
+    stats.set_num_executions(stats.num_executions() + 1);
+    stats.set_num_changes(stats.num_changes() + (updated_graph ? 1 : 0));
+    stats.set_total_time_ns(stats.total_time_ns() +
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  }
+
   std::vector<std::unique_ptr<TRuleBatch>> rule_batches;
+  std::vector<distributedpb::RuleExecutionStats> rule_execution_stats_;
+  // The index of the stats of each rule in rule_execution_stats_.
+  std::unordered_map<const TRule*, size_t> rule_stats_idx_;
 };
 
 }  // namespace planner
@@ -181,6 +181,33 @@ TEST_F(RuleExecutorTest, exit_early) {
   EXPECT_NOT_OK(executor->Execute(graph.get()));
 }
 
+// Tests that the executor counts the executions and changes of every rule.
+TEST_F(RuleExecutorTest, rule_execution_stats) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch1 = executor->CreateRuleBatch<FailOnMax>("resolve", 10);
+  MockRule* rule1_1 = rule_batch1->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule1_1, Execute(_))
+      .Times(3)
+      .WillOnce(Return(true))
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+  RuleBatch* rule_batch2 = executor->CreateRuleBatch<DoOnce>("optimize");
+  MockRule* rule2_1 = rule_batch2->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule2_1, Execute(_)).Times(1).WillOnce(Return(true));
+  ASSERT_OK(executor->Execute(graph.get()));
+
+  const auto& stats = executor->rule_execution_stats();
+  ASSERT_EQ(2, stats.size());
+  EXPECT_EQ("resolve", stats[0].batch_name());
+  EXPECT_EQ("MockRule", stats[0].rule_name());
+  EXPECT_EQ(3, stats[0].num_executions());
+  EXPECT_EQ(2, stats[0].num_changes());
+  EXPECT_GE(stats[0].total_time_ns(), 0);
+  EXPECT_EQ("optimize", stats[1].batch_name());
+  EXPECT_EQ(1, stats[1].num_executions());
+  EXPECT_EQ(1, stats[1].num_changes());
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
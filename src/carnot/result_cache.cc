@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/result_cache.h"
+
+#include <optional>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/carnot/planner/plan_cache.h"
+
+namespace px {
+namespace carnot {
+
+int64_t CachedResult::NumBytes() const {
+  int64_t bytes = 0;
+  for (const auto& [fragment_id, sink_inputs] : fragment_sink_inputs) {
+    for (const auto& [sink_id, row_batches] : sink_inputs) {
+      for (const auto& rb : row_batches) {
+        bytes += rb.NumBytes();
+      }
+    }
+  }
+  return bytes;
+}
+
+bool IsResultCacheable(const planpb::Plan& plan) {
+  for (const auto& pf : plan.nodes()) {
+    for (const auto& node : pf.nodes()) {
+      const auto& op = node.op();
+      switch (op.op_type()) {
+        case planpb::MEMORY_SOURCE_OPERATOR:
+          // Streaming sources keep reading data as it arrives.
+          if (op.mem_source_op().streaming()) {
+            return false;
+          }
+          break;
+        // The data of GRPC sources comes from other agents, which this agent can't tell the
+        // version of, and UDTFs read state outside of the table store.
+        case planpb::GRPC_SOURCE_OPERATOR:
+        case planpb::UDTF_SOURCE_OPERATOR:
+          return false;
+        default:
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+namespace {
+
+// Rounds towards negative infinity, so that times just before and just after `time_now_ns` don't
+// end up in the same bucket.
+int64_t FloorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+
+}  // namespace
+
+std::string ResultCacheKey(const planpb::Plan& plan, int64_t time_now_ns, int64_t bucket_ns) {
+  planpb::Plan keyed_plan = plan;
+  for (auto& pf : *keyed_plan.mutable_nodes()) {
+    for (auto& node : *pf.mutable_nodes()) {
+      if (node.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto* mem_source = node.mutable_op()->mutable_mem_source_op();
+      if (mem_source->has_start_time()) {
+        auto* start_time = mem_source->mutable_start_time();
+        start_time->set_value(FloorDiv(start_time->value() - time_now_ns, bucket_ns));
+      }
+      if (mem_source->has_stop_time()) {
+        auto* stop_time = mem_source->mutable_stop_time();
+        stop_time->set_value(FloorDiv(stop_time->value() - time_now_ns, bucket_ns));
+      }
+    }
+  }
+  return absl::StrCat(time_now_ns / bucket_ns, ":", planner::DeterministicSerialize(keyed_plan));
+}
+
+std::shared_ptr<const CachedResult> ResultCache::Get(const std::string& key) {
+  std::optional<std::shared_ptr<const CachedResult>> result = entries_.Get(key);
+  if (!result.has_value()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return *std::move(result);
+}
+
+void ResultCache::Put(const std::string& key, std::shared_ptr<const CachedResult> result) {
+  if (entries_.max_entries() == 0 || result->NumBytes() > kMaxCachedResultBytes) {
+    return;
+  }
+  // Another execution of the same plan may have finished in the meantime, the newer result wins.
+  entries_.Put(key, std::move(result));
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/exec/exec_graph.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/common/base/lru_cache.h"
+
+namespace px {
+namespace carnot {
+
+// Results larger than this aren't cached, so that a few big results can't take up the memory.
+constexpr int64_t kMaxCachedResultBytes = 16 * 1024 * 1024;
+
+/**
+ * The results of a plan, as the row batches that each of its sinks consumed.
+ */
+struct CachedResult {
+  // The inputs of the sinks of each plan fragment, by the id of the fragment.
+  absl::flat_hash_map<int64_t, exec::ExecutionGraph::SinkInputs> fragment_sink_inputs;
+
+  int64_t NumBytes() const;
+};
+
+/**
+ * Whether the results of the plan only depend on the plan and the data of the local tables it
+ * reads, which is the case if all of its sources are batch memory sources or empty sources.
+ */
+bool IsResultCacheable(const planpb::Plan& plan);
+
+/**
+ * Creates the cache key for the plan executed at `time_now_ns`. Executions of the same plan within
+ * the same time bucket of `bucket_ns` share a key.
+ *
+ * The planner resolves relative times, like start_time='-5m', against the time the plan is compiled
+ * at, so the times of the memory sources are keyed by their offset from `time_now_ns`, in whole
+ * buckets. A script that is run over and over again then gets the same key within a bucket, even
+ * though the times in its plans differ.
+ */
+std::string ResultCacheKey(const planpb::Plan& plan, int64_t time_now_ns, int64_t bucket_ns);
+
+/**
+ * ResultCache keeps the results of recently executed plans, so that identical plans that many
+ * viewers of the same dashboards run over and over again are only executed once per time bucket.
+ *
+ * The tables of an agent take in new data all the time, so a result isn't checked against the data
+ * that has arrived since it was recorded. It's served for the rest of its time bucket, which bounds
+ * how stale it gets.
+ */
+class ResultCache : public NotCopyable {
+ public:
+  explicit ResultCache(size_t max_entries) : entries_(max_entries) {}
+
+  /**
+   * Returns the result for the key, or nullptr.
+   */
+  std::shared_ptr<const CachedResult> Get(const std::string& key);
+
+  void Put(const std::string& key, std::shared_ptr<const CachedResult> result);
+
+  size_t size() const { return entries_.size(); }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  LRUCache<std::string, std::shared_ptr<const CachedResult>> entries_;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+};
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "src/carnot/result_cache.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+
+using google::protobuf::TextFormat;
+
+constexpr char kPlanTemplate[] = R"proto(
+nodes {
+  id: 1
+  nodes {
+    id: 1
+    op {
+      op_type: $0
+      $1
+    }
+  }
+}
+)proto";
+
+planpb::Plan MakePlan(std::string_view op_type, std::string_view op) {
+  planpb::Plan plan;
+  CHECK(TextFormat::ParseFromString(absl::Substitute(kPlanTemplate, op_type, op), &plan));
+  return plan;
+}
+
+TEST(ResultCacheTest, cacheable_plans) {
+  auto mem_source =
+      MakePlan("MEMORY_SOURCE_OPERATOR", "mem_source_op { name: 'http_events' tablet: '1' }");
+  EXPECT_TRUE(IsResultCacheable(mem_source));
+  EXPECT_TRUE(IsResultCacheable(MakePlan("EMPTY_SOURCE_OPERATOR", "")));
+
+  EXPECT_FALSE(IsResultCacheable(
+      MakePlan("MEMORY_SOURCE_OPERATOR", "mem_source_op { name: 'http_events' streaming: true }")));
+  EXPECT_FALSE(IsResultCacheable(MakePlan("GRPC_SOURCE_OPERATOR", "")));
+  EXPECT_FALSE(IsResultCacheable(MakePlan("UDTF_SOURCE_OPERATOR", "")));
+}
+
+TEST(ResultCacheTest, keys_share_time_buckets) {
+  auto plan = MakePlan("MEMORY_SOURCE_OPERATOR", "mem_source_op { name: 'http_events' }");
+  auto other_plan = MakePlan("MEMORY_SOURCE_OPERATOR", "mem_source_op { name: 'conn_stats' }");
+  EXPECT_EQ(ResultCacheKey(plan, 10, 100), ResultCacheKey(plan, 99, 100));
+  EXPECT_NE(ResultCacheKey(plan, 99, 100), ResultCacheKey(plan, 100, 100));
+  EXPECT_NE(ResultCacheKey(plan, 10, 100), ResultCacheKey(other_plan, 10, 100));
+}
+
+planpb::Plan MakeTimeRangePlan(int64_t start_time, int64_t stop_time) {
+  return MakePlan("MEMORY_SOURCE_OPERATOR",
+                  absl::Substitute("mem_source_op { name: 'http_events' start_time { value: $0 } "
+                                   "stop_time { value: $1 } }",
+                                   start_time, stop_time));
+}
+
+TEST(ResultCacheTest, keys_relative_times) {
+  // The same script, compiled with start_time='-300' right before each execution.
+  EXPECT_EQ(ResultCacheKey(MakeTimeRangePlan(1000 - 300, 1000), 1001, 100),
+            ResultCacheKey(MakeTimeRangePlan(1050 - 300, 1050), 1052, 100));
+  // A different time range.
+  EXPECT_NE(ResultCacheKey(MakeTimeRangePlan(1000 - 300, 1000), 1001, 100),
+            ResultCacheKey(MakeTimeRangePlan(1050 - 600, 1050), 1052, 100));
+  // Times after the execution are keyed apart from the ones before it.
+  EXPECT_NE(ResultCacheKey(MakeTimeRangePlan(700, 1000), 1001, 100),
+            ResultCacheKey(MakeTimeRangePlan(700, 1002), 1001, 100));
+}
+
+TEST(ResultCacheTest, get_and_put) {
+  ResultCache cache(2);
+  auto result = std::make_shared<CachedResult>();
+  cache.Put("a", result);
+  EXPECT_EQ(result, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+}
+
+TEST(ResultCacheTest, evicts_least_recently_used) {
+  ResultCache cache(2);
+  cache.Put("a", std::make_shared<CachedResult>());
+  cache.Put("b", std::make_shared<CachedResult>());
+  ASSERT_NE(nullptr, cache.Get("a"));
+  cache.Put("c", std::make_shared<CachedResult>());
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_NE(nullptr, cache.Get("c"));
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/table_rollup.h"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+#include <absl/time/time.h>
+
+#include "src/carnot/funcs/builtins/math_sketches.h"
+#include "src/shared/types/arrow_adapter.h"
+
+DEFINE_string(table_store_rollups, gflags::StringFromEnv("PL_TABLE_STORE_ROLLUPS", ""),
+              "The rollup tables to keep, as a semicolon-separated list of "
+              "<rollup table>=<source table>:<bin>:<group columns>:<sum columns>:<quantile "
+              "columns>, where the columns are comma-separated. For example "
+              "http_events_1m=http_events:1m:upid,req_path,resp_status:resp_body_size:latency");
+
+namespace px {
+namespace carnot {
+
+using table_store::schema::Relation;
+
+namespace {
+
+std::vector<std::string> ParseColumns(std::string_view columns) {
+  std::vector<std::string> out;
+  for (std::string_view column : absl::StrSplit(columns, ',', absl::SkipWhitespace())) {
+    out.emplace_back(absl::StripAsciiWhitespace(column));
+  }
+  return out;
+}
+
+bool IsGroupType(types::DataType type) {
+  switch (type) {
+    case types::BOOLEAN:
+    case types::INT64:
+    case types::UINT128:
+    case types::TIME64NS:
+    case types::STRING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsNumericType(types::DataType type) { return type == types::INT64 || type == types::FLOAT64; }
+
+template <typename T>
+void AppendFixed(T value, std::string* key) {
+  key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T ConsumeFixed(std::string_view* key) {
+  T value;
+  DCHECK_GE(key->size(), sizeof(value));
+  std::memcpy(&value, key->data(), sizeof(value));
+  key->remove_prefix(sizeof(value));
+  return value;
+}
+
+// Appends the value of the group column to the key of a bin.
+void AppendGroupValue(const arrow::Array* arr, types::DataType type, int64_t idx,
+                      std::string* key) {
+  switch (type) {
+    case types::BOOLEAN:
+      AppendFixed<uint8_t>(types::GetValueFromArrowArray<types::BOOLEAN>(arr, idx), key);
+      break;
+    case types::INT64:
+      AppendFixed(types::GetValueFromArrowArray<types::INT64>(arr, idx), key);
+      break;
+    case types::TIME64NS:
+      AppendFixed(types::GetValueFromArrowArray<types::TIME64NS>(arr, idx), key);
+      break;
+    case types::UINT128:
+      AppendFixed(types::GetValueFromArrowArray<types::UINT128>(arr, idx), key);
+      break;
+    case types::STRING: {
+      int32_t length = 0;
+      const uint8_t* data = static_cast<const arrow::StringArray*>(arr)->GetValue(idx, &length);
+      AppendFixed(length, key);
+      key->append(reinterpret_cast<const char*>(data), length);
+      break;
+    }
+    default:
+      DCHECK(false) << "Unexpected group column type " << types::ToString(type);
+  }
+}
+
+// Consumes the value of the group column from the key of a bin, and appends it to the column.
+void ConsumeGroupValue(types::DataType type, std::string_view* key, types::ColumnWrapper* col) {
+  switch (type) {
+    case types::BOOLEAN:
+      col->Append<types::BoolValue>(ConsumeFixed<uint8_t>(key) != 0);
+      break;
+    case types::INT64:
+      col->Append<types::Int64Value>(ConsumeFixed<int64_t>(key));
+      break;
+    case types::TIME64NS:
+      col->Append<types::Time64NSValue>(ConsumeFixed<int64_t>(key));
+      break;
+    case types::UINT128:
+      col->Append<types::UInt128Value>(ConsumeFixed<absl::uint128>(key));
+      break;
+    case types::STRING: {
+      auto length = ConsumeFixed<int32_t>(key);
+      col->Append<types::StringValue>(std::string(key->substr(0, length)));
+      key->remove_prefix(length);
+      break;
+    }
+    default:
+      DCHECK(false) << "Unexpected group column type " << types::ToString(type);
+  }
+}
+
+double GetNumericValue(const arrow::Array* arr, types::DataType type, int64_t idx) {
+  if (type == types::INT64) {
+    return types::GetValueFromArrowArray<types::INT64>(arr, idx);
+  }
+  return types::GetValueFromArrowArray<types::FLOAT64>(arr, idx);
+}
+
+}  // namespace
+
+StatusOr<std::vector<RollupSpec>> ParseRollupSpecs(std::string_view spec) {
+  std::vector<RollupSpec> specs;
+  for (std::string_view entry : absl::StrSplit(spec, ';', absl::SkipWhitespace())) {
+    std::vector<std::string_view> name_and_def = absl::StrSplit(entry, absl::MaxSplits('=', 1));
+    std::vector<std::string_view> parts;
+    if (name_and_def.size() == 2) {
+      parts = absl::StrSplit(name_and_def[1], ':');
+    }
+    absl::Duration bin;
+    if (parts.size() != 5 || !absl::ParseDuration(absl::StripAsciiWhitespace(parts[1]), &bin) ||
+        bin <= absl::ZeroDuration()) {
+      return error::InvalidArgument(
+          "Invalid rollup '$0', expected <rollup table>=<source table>:<bin > 0>:<group "
+          "columns>:<sum columns>:<quantile columns>",
+          entry);
+    }
+    RollupSpec rollup;
+    rollup.rollup_table = std::string(absl::StripAsciiWhitespace(name_and_def[0]));
+    rollup.source_table = std::string(absl::StripAsciiWhitespace(parts[0]));
+    rollup.bin_ns = absl::ToInt64Nanoseconds(bin);
+    rollup.group_columns = ParseColumns(parts[2]);
+    rollup.sum_columns = ParseColumns(parts[3]);
+    rollup.quantile_columns = ParseColumns(parts[4]);
+    specs.push_back(std::move(rollup));
+  }
+  return specs;
+}
+
+StatusOr<std::unique_ptr<TableRollup>> TableRollup::Create(RollupSpec spec,
+                                                           const Relation& source) {
+  if (!source.HasColumn("time_") || source.GetColumnType("time_") != types::TIME64NS) {
+    return error::InvalidArgument("Rollup $0: table $1 has no time_ column", spec.rollup_table,
+                                  spec.source_table);
+  }
+  std::vector<int64_t> cols = {source.GetColumnIndex("time_")};
+  std::vector<types::DataType> col_types = {types::TIME64NS};
+  Relation relation;
+  relation.AddColumn(types::TIME64NS, "time_", types::ST_NONE, "The start of the bin.");
+
+  auto add_source_column = [&](const std::string& name, bool (*valid_type)(types::DataType),
+                               std::string_view kind) -> Status {
+    if (!source.HasColumn(name) || !valid_type(source.GetColumnType(name))) {
+      return error::InvalidArgument("Rollup $0: table $1 has no $2 column $3", spec.rollup_table,
+                                    spec.source_table, kind, name);
+    }
+    cols.push_back(source.GetColumnIndex(name));
+    col_types.push_back(source.GetColumnType(name));
+    return Status::OK();
+  };
+  for (const auto& name : spec.group_columns) {
+    PL_RETURN_IF_ERROR(add_source_column(name, &IsGroupType, "group"));
+    relation.AddColumn(source.GetColumnType(name), name, source.GetColumnSemanticType(name),
+                       source.GetColumnDesc(name));
+  }
+  relation.AddColumn(types::INT64, "count", types::ST_NONE, "The number of rows.");
+  for (const auto& name : spec.sum_columns) {
+    PL_RETURN_IF_ERROR(add_source_column(name, &IsNumericType, "numeric"));
+    relation.AddColumn(source.GetColumnType(name), name + "_sum",
+                       source.GetColumnSemanticType(name),
+                       absl::Substitute("The sum of $0.", name));
+  }
+  for (const auto& name : spec.quantile_columns) {
+    PL_RETURN_IF_ERROR(add_source_column(name, &IsNumericType, "numeric"));
+    relation.AddColumn(
+        types::STRING, name + "_quantiles", types::ST_NONE,
+        absl::Substitute("The distribution of $0, to be merged with px.merge_quantiles.", name));
+  }
+  return std::unique_ptr<TableRollup>(new TableRollup(
+      std::move(spec), std::move(relation), std::move(cols), std::move(col_types)));
+}
+
+TableRollup::TableRollup(RollupSpec spec, Relation relation, std::vector<int64_t> cols,
+                         std::vector<types::DataType> col_types)
+    : spec_(std::move(spec)),
+      relation_(std::move(relation)),
+      cols_(std::move(cols)),
+      col_types_(std::move(col_types)) {}
+
+TableRollup::Bin TableRollup::NewBin() const {
+  Bin bin;
+  bin.sums.resize(spec_.sum_columns.size());
+  for (size_t i = 0; i < spec_.sum_columns.size(); ++i) {
+    if (col_types_[1 + spec_.group_columns.size() + i] == types::INT64) {
+      bin.sums[i].int64_value = 0;
+    } else {
+      bin.sums[i].float64_value = 0;
+    }
+  }
+  bin.sketches.reserve(spec_.quantile_columns.size());
+  for (size_t i = 0; i < spec_.quantile_columns.size(); ++i) {
+    bin.sketches.emplace_back(FLAGS_carnot_quantiles_compression);
+  }
+  return bin;
+}
+
+Status TableRollup::AggregateSlice(const table_store::Table& table,
+                                   const table_store::BatchSlice& slice,
+                                   arrow::MemoryPool* mem_pool) {
+  PL_ASSIGN_OR_RETURN(auto rb, table.GetRowBatchSlice(slice, cols_, mem_pool));
+  const size_t num_groups = spec_.group_columns.size();
+  const size_t num_sums = spec_.sum_columns.size();
+  const size_t sums_begin = 1 + num_groups;
+  const size_t quantiles_begin = sums_begin + num_sums;
+  const arrow::Array* times = rb->ColumnAt(0).get();
+  for (int64_t row = 0; row < rb->num_rows(); ++row) {
+    int64_t time = types::GetValueFromArrowArray<types::TIME64NS>(times, row);
+    int64_t bin_start = time - time % spec_.bin_ns;
+    if (bin_start < closed_before_) {
+      ++num_late_rows_;
+      continue;
+    }
+    max_time_ = std::max(max_time_, time);
+
+    key_.clear();
+    AppendFixed(bin_start, &key_);
+    for (size_t i = 1; i < sums_begin; ++i) {
+      AppendGroupValue(rb->ColumnAt(i).get(), col_types_[i], row, &key_);
+    }
+    auto it = open_bins_.find(key_);
+    if (it == open_bins_.end()) {
+      it = open_bins_.emplace(key_, NewBin()).first;
+    }
+    Bin& bin = it->second;
+    ++bin.count;
+    for (size_t i = 0; i < num_sums; ++i) {
+      const arrow::Array* arr = rb->ColumnAt(sums_begin + i).get();
+      if (col_types_[sums_begin + i] == types::INT64) {
+        bin.sums[i].int64_value.val += types::GetValueFromArrowArray<types::INT64>(arr, row);
+      } else {
+        bin.sums[i].float64_value.val += types::GetValueFromArrowArray<types::FLOAT64>(arr, row);
+      }
+    }
+    for (size_t i = 0; i < bin.sketches.size(); ++i) {
+      bin.sketches[i].Add(GetNumericValue(rb->ColumnAt(quantiles_begin + i).get(),
+                                          col_types_[quantiles_begin + i], row));
+    }
+  }
+  return Status::OK();
+}
+
+Status TableRollup::WriteClosedBins(table_store::Table* rollup_table) {
+  // The bin of the latest row and the bin before it stay open for the rows that arrive late.
+  int64_t closed_before = max_time_ - max_time_ % spec_.bin_ns - spec_.bin_ns;
+  if (closed_before <= closed_before_) {
+    return Status::OK();
+  }
+  closed_before_ = closed_before;
+
+  std::vector<std::pair<int64_t, decltype(open_bins_)::iterator>> closed_bins;
+  for (auto it = open_bins_.begin(); it != open_bins_.end(); ++it) {
+    int64_t bin_start;
+    std::memcpy(&bin_start, it->first.data(), sizeof(bin_start));
+    if (bin_start < closed_before_) {
+      closed_bins.emplace_back(bin_start, it);
+    }
+  }
+  if (closed_bins.empty()) {
+    return Status::OK();
+  }
+  // The rows of a table are ordered by time, and the groups of a bin by their key to keep the
+  // rollup deterministic.
+  std::sort(closed_bins.begin(), closed_bins.end(), [](const auto& a, const auto& b) {
+    return std::tie(a.first, a.second->first) < std::tie(b.first, b.second->first);
+  });
+
+  auto record_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  for (auto type : relation_.col_types()) {
+    record_batch->push_back(types::ColumnWrapper::Make(type, 0));
+    record_batch->back()->Reserve(closed_bins.size());
+  }
+  const size_t num_groups = spec_.group_columns.size();
+  const size_t num_sums = spec_.sum_columns.size();
+  for (const auto& [bin_start, it] : closed_bins) {
+    std::string_view key = it->first;
+    Bin& bin = it->second;
+    size_t col = 0;
+    (*record_batch)[col++]->Append<types::Time64NSValue>(ConsumeFixed<int64_t>(&key));
+    for (size_t i = 0; i < num_groups; ++i, ++col) {
+      ConsumeGroupValue(col_types_[1 + i], &key, (*record_batch)[col].get());
+    }
+    (*record_batch)[col++]->Append<types::Int64Value>(bin.count);
+    for (size_t i = 0; i < num_sums; ++i, ++col) {
+      if (col_types_[1 + num_groups + i] == types::INT64) {
+        (*record_batch)[col]->Append<types::Int64Value>(bin.sums[i].int64_value);
+      } else {
+        (*record_batch)[col]->Append<types::Float64Value>(bin.sums[i].float64_value);
+      }
+    }
+    for (auto& sketch : bin.sketches) {
+      (*record_batch)[col++]->Append<types::StringValue>(sketch.Serialize());
+    }
+  }
+  for (const auto& [bin_start, it] : closed_bins) {
+    open_bins_.erase(it);
+  }
+  return rollup_table->TransferRecordBatch(std::move(record_batch));
+}
+
+Status TableRollup::Update(table_store::TableStore* table_store, arrow::MemoryPool* mem_pool) {
+  table_store::Table* rollup_table = table_store->GetTable(spec_.rollup_table);
+  if (rollup_table == nullptr) {
+    return error::NotFound("Rollup table $0 doesn't exist", spec_.rollup_table);
+  }
+  for (const auto& [tablet_id, table] : table_store->GetTablets(spec_.source_table)) {
+    auto cursor = cursors_.find(tablet_id);
+    auto slice = cursor == cursors_.end() ? table->FirstBatch() : table->NextBatch(cursor->second);
+    for (; slice.IsValid(); slice = table->NextBatch(slice)) {
+      PL_RETURN_IF_ERROR(AggregateSlice(*table, slice, mem_pool));
+      cursors_[tablet_id] = slice;
+    }
+  }
+  return WriteClosedBins(rollup_table);
+}
+
+void TableRollup::ResumeFrom(const table_store::TableStore& table_store) {
+  auto time_ranges = table_store.GetTableTimeRanges();
+  auto it = time_ranges.find(spec_.rollup_table);
+  if (it != time_ranges.end()) {
+    closed_before_ = std::max(closed_before_, it->second.second + spec_.bin_ns);
+  }
+}
+
+}  // namespace carnot
+}  // namespace px
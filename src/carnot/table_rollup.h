@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/funcs/builtins/quantile_sketch.h"
+#include "src/common/base/base.h"
+#include "src/table_store/table/table_store.h"
+
+DECLARE_string(table_store_rollups);
+
+namespace px {
+namespace carnot {
+
+/**
+ * A rollup of a table into bins of time, kept in a table of its own.
+ */
+struct RollupSpec {
+  std::string rollup_table;
+  std::string source_table;
+  int64_t bin_ns = 0;
+  // The columns that the rows of each bin are grouped by.
+  std::vector<std::string> group_columns;
+  // The numeric columns that are summed for each group.
+  std::vector<std::string> sum_columns;
+  // The numeric columns whose distribution is sketched for each group.
+  std::vector<std::string> quantile_columns;
+};
+
+/**
+ * Parses a semicolon-separated list of rollups of the form
+ *   <rollup table>=<source table>:<bin>:<group columns>:<sum columns>:<quantile columns>
+ * where the bin is a duration such as 10s or 1m, and the columns are comma-separated lists.
+ */
+StatusOr<std::vector<RollupSpec>> ParseRollupSpecs(std::string_view spec);
+
+/**
+ * TableRollup keeps the rollup table of a source table up to date. Each update aggregates the rows
+ * that were written to the tablets of the source table since the previous update into bins, and
+ * writes the bins that have closed to the rollup table.
+ *
+ * The rollup table has the start of the bin as its time_ column, then the group columns, the
+ * number of rows as count, the sums as <column>_sum and the serialized state of px.quantiles as
+ * <column>_quantiles. Each row is a partial aggregate, so queries aggregate the rollup table again
+ * by summing the counts and sums, and merging the sketches with px.merge_quantiles. This keeps the
+ * bins correct even if the rows of a bin are split across rollup rows.
+ *
+ * A bin closes once the source table has rows for two bins past it. Rows that arrive for closed
+ * bins are dropped and counted in num_late_rows. Updates must not run concurrently.
+ */
+class TableRollup : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<TableRollup>> Create(RollupSpec spec,
+                                                       const table_store::schema::Relation& source);
+
+  Status Update(table_store::TableStore* table_store, arrow::MemoryPool* mem_pool);
+
+  /**
+   * Continues the rollup table that was restored from a snapshot, by closing the bins that it
+   * already holds. The next update drops the restored source rows of those bins, counting them as
+   * late rows, and aggregates the others.
+   */
+  void ResumeFrom(const table_store::TableStore& table_store);
+
+  const RollupSpec& spec() const { return spec_; }
+  const table_store::schema::Relation& relation() const { return relation_; }
+  int64_t num_open_bins() const { return open_bins_.size(); }
+  int64_t num_late_rows() const { return num_late_rows_; }
+
+ private:
+  struct Bin {
+    int64_t count = 0;
+    std::vector<types::FixedSizeValueUnion> sums;
+    std::vector<builtins::QuantileSketch> sketches;
+  };
+
+  TableRollup(RollupSpec spec, table_store::schema::Relation relation, std::vector<int64_t> cols,
+              std::vector<types::DataType> col_types);
+
+  Status AggregateSlice(const table_store::Table& table, const table_store::BatchSlice& slice,
+                        arrow::MemoryPool* mem_pool);
+  Bin NewBin() const;
+  Status WriteClosedBins(table_store::Table* rollup_table);
+
+  const RollupSpec spec_;
+  const table_store::schema::Relation relation_;
+  // The source columns that are read, which are time_, then the group, sum and quantile columns.
+  const std::vector<int64_t> cols_;
+  const std::vector<types::DataType> col_types_;
+
+  // The open bins, by their start time followed by the values of the group columns.
+  absl::flat_hash_map<std::string, Bin> open_bins_;
+  std::string key_;
+  // The last slice of each tablet of the source table that was aggregated.
+  absl::flat_hash_map<types::TabletID, table_store::BatchSlice> cursors_;
+  int64_t max_time_ = 0;
+  // Bins that start before this time are closed.
+  int64_t closed_before_ = 0;
+  int64_t num_late_rows_ = 0;
+};
+
+}  // namespace carnot
+}  // namespace px
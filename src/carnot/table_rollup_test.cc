@@ -0,0 +1,200 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "src/carnot/funcs/builtins/math_sketches.h"
+#include "src/carnot/table_rollup.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+
+using table_store::Table;
+using table_store::TableStore;
+using table_store::schema::Relation;
+using ::testing::ElementsAre;
+
+class TableRollupTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    source_relation_ =
+        Relation({types::TIME64NS, types::STRING, types::INT64, types::FLOAT64},
+                 {"time_", "service", "latency", "bytes"});
+    source_ = Table::Create("http_events", source_relation_);
+    table_store_.AddTable(source_, "http_events", 1);
+
+    RollupSpec spec;
+    spec.rollup_table = "http_events_10ns";
+    spec.source_table = "http_events";
+    spec.bin_ns = 10;
+    spec.group_columns = {"service"};
+    spec.sum_columns = {"bytes"};
+    spec.quantile_columns = {"latency"};
+    ASSERT_OK_AND_ASSIGN(rollup_, TableRollup::Create(spec, source_relation_));
+    rollup_table_ = Table::Create(spec.rollup_table, rollup_->relation());
+    table_store_.AddTable(rollup_table_, spec.rollup_table, 2);
+  }
+
+  void WriteRows(const std::vector<types::Time64NSValue>& times,
+                 const std::vector<types::StringValue>& services,
+                 const std::vector<types::Int64Value>& latencies,
+                 const std::vector<types::Float64Value>& bytes) {
+    auto rb = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto time_col = types::ColumnWrapper::Make(types::TIME64NS, 0);
+    time_col->AppendFromVector(times);
+    auto service_col = types::ColumnWrapper::Make(types::STRING, 0);
+    service_col->AppendFromVector(services);
+    auto latency_col = types::ColumnWrapper::Make(types::INT64, 0);
+    latency_col->AppendFromVector(latencies);
+    auto bytes_col = types::ColumnWrapper::Make(types::FLOAT64, 0);
+    bytes_col->AppendFromVector(bytes);
+    rb->push_back(time_col);
+    rb->push_back(service_col);
+    rb->push_back(latency_col);
+    rb->push_back(bytes_col);
+    ASSERT_OK(source_->TransferRecordBatch(std::move(rb)));
+  }
+
+  Relation source_relation_;
+  std::shared_ptr<Table> source_;
+  std::shared_ptr<Table> rollup_table_;
+  TableStore table_store_;
+  std::unique_ptr<TableRollup> rollup_;
+};
+
+TEST_F(TableRollupTest, rollup_relation) {
+  const Relation& relation = rollup_->relation();
+  EXPECT_THAT(relation.col_names(),
+              ElementsAre("time_", "service", "count", "bytes_sum", "latency_quantiles"));
+  EXPECT_THAT(relation.col_types(),
+              ElementsAre(types::TIME64NS, types::STRING, types::INT64, types::FLOAT64,
+                          types::STRING));
+}
+
+TEST_F(TableRollupTest, writes_closed_bins) {
+  WriteRows({1, 2, 11}, {"a", "b", "a"}, {10, 20, 30}, {1.5, 2.5, 3.5});
+  ASSERT_OK(rollup_->Update(&table_store_, arrow::default_memory_pool()));
+  // The bin of the latest row and the bin before it are still open.
+  EXPECT_EQ(3, rollup_->num_open_bins());
+  EXPECT_FALSE(rollup_table_->FirstBatch().IsValid());
+
+  WriteRows({3, 25}, {"a", "a"}, {40, 50}, {4.5, 5.5});
+  ASSERT_OK(rollup_->Update(&table_store_, arrow::default_memory_pool()));
+  EXPECT_EQ(2, rollup_->num_open_bins());
+
+  ASSERT_OK_AND_ASSIGN(auto rb, rollup_table_->GetRowBatchSlice(rollup_table_->FirstBatch(),
+                                                                {0, 1, 2, 3, 4},
+                                                                arrow::default_memory_pool()));
+  ASSERT_EQ(2, rb->num_rows());
+  auto times = rb->ColumnAt(0);
+  auto services = rb->ColumnAt(1);
+  auto counts = rb->ColumnAt(2);
+  auto bytes_sums = rb->ColumnAt(3);
+  EXPECT_EQ(0, types::GetValueFromArrowArray<types::TIME64NS>(times.get(), 0));
+  EXPECT_EQ(0, types::GetValueFromArrowArray<types::TIME64NS>(times.get(), 1));
+  EXPECT_EQ("a", types::GetValueFromArrowArray<types::STRING>(services.get(), 0));
+  EXPECT_EQ("b", types::GetValueFromArrowArray<types::STRING>(services.get(), 1));
+  EXPECT_EQ(2, types::GetValueFromArrowArray<types::INT64>(counts.get(), 0));
+  EXPECT_EQ(1, types::GetValueFromArrowArray<types::INT64>(counts.get(), 1));
+  EXPECT_DOUBLE_EQ(6.0, types::GetValueFromArrowArray<types::FLOAT64>(bytes_sums.get(), 0));
+  EXPECT_DOUBLE_EQ(2.5, types::GetValueFromArrowArray<types::FLOAT64>(bytes_sums.get(), 1));
+
+  // The sketches of the rollup merge into the quantiles of the source rows.
+  builtins::MergeQuantilesUDA merged;
+  merged.Update(nullptr, types::GetValueFromArrowArray<types::STRING>(rb->ColumnAt(4).get(), 0));
+  builtins::QuantilesUDA<types::Int64Value> expected;
+  expected.Update(nullptr, 10);
+  expected.Update(nullptr, 40);
+  EXPECT_EQ(expected.Finalize(nullptr), merged.Finalize(nullptr));
+
+  // Rows for bins that have closed are dropped.
+  WriteRows({4}, {"b"}, {60}, {6.5});
+  ASSERT_OK(rollup_->Update(&table_store_, arrow::default_memory_pool()));
+  EXPECT_EQ(1, rollup_->num_late_rows());
+  EXPECT_EQ(2, rollup_->num_open_bins());
+}
+
+TEST_F(TableRollupTest, resumes_restored_rollup) {
+  // The rollup table was restored with the bin at 0, and the source table with its rows.
+  auto rb = std::make_unique<types::ColumnWrapperRecordBatch>();
+  for (auto type : rollup_->relation().col_types()) {
+    rb->push_back(types::ColumnWrapper::Make(type, 0));
+  }
+  (*rb)[0]->Append<types::Time64NSValue>(0);
+  (*rb)[1]->Append<types::StringValue>("a");
+  (*rb)[2]->Append<types::Int64Value>(1);
+  (*rb)[3]->Append<types::Float64Value>(1.5);
+  (*rb)[4]->Append<types::StringValue>("");
+  ASSERT_OK(rollup_table_->TransferRecordBatch(std::move(rb)));
+  WriteRows({1, 11}, {"a", "a"}, {10, 20}, {1.5, 2.5});
+
+  rollup_->ResumeFrom(table_store_);
+  ASSERT_OK(rollup_->Update(&table_store_, arrow::default_memory_pool()));
+  // The rows of the restored bin aren't aggregated again.
+  EXPECT_EQ(1, rollup_->num_late_rows());
+  EXPECT_EQ(1, rollup_->num_open_bins());
+}
+
+TEST_F(TableRollupTest, invalid_columns) {
+  RollupSpec spec;
+  spec.rollup_table = "http_events_10ns";
+  spec.source_table = "http_events";
+  spec.bin_ns = 10;
+  spec.group_columns = {"missing"};
+  EXPECT_NOT_OK(TableRollup::Create(spec, source_relation_));
+
+  spec.group_columns = {"bytes"};
+  EXPECT_NOT_OK(TableRollup::Create(spec, source_relation_));
+
+  spec.group_columns = {};
+  spec.sum_columns = {"service"};
+  EXPECT_NOT_OK(TableRollup::Create(spec, source_relation_));
+}
+
+TEST(ParseRollupSpecs, parses_rollups) {
+  ASSERT_OK_AND_ASSIGN(
+      auto specs, ParseRollupSpecs("http_events_1m=http_events:1m:upid,req_path:resp_body_size:"
+                                   "latency; conn_10s=conn:10s:::"));
+  ASSERT_EQ(2, specs.size());
+  EXPECT_EQ("http_events_1m", specs[0].rollup_table);
+  EXPECT_EQ("http_events", specs[0].source_table);
+  EXPECT_EQ(60'000'000'000, specs[0].bin_ns);
+  EXPECT_THAT(specs[0].group_columns, ElementsAre("upid", "req_path"));
+  EXPECT_THAT(specs[0].sum_columns, ElementsAre("resp_body_size"));
+  EXPECT_THAT(specs[0].quantile_columns, ElementsAre("latency"));
+  EXPECT_EQ("conn_10s", specs[1].rollup_table);
+  EXPECT_EQ(10'000'000'000, specs[1].bin_ns);
+  EXPECT_TRUE(specs[1].group_columns.empty());
+
+  ASSERT_OK_AND_ASSIGN(specs, ParseRollupSpecs(""));
+  EXPECT_TRUE(specs.empty());
+
+  EXPECT_NOT_OK(ParseRollupSpecs("http_events_1m=http_events:1m:upid"));
+  EXPECT_NOT_OK(ParseRollupSpecs("http_events_1m=http_events:soon:upid::"));
+  EXPECT_NOT_OK(ParseRollupSpecs("http_events:1m:upid::"));
+}
+
+}  // namespace carnot
+}  // namespace px
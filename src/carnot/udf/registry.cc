@@ -160,6 +160,49 @@ std::string Registry::DebugString() const {
   return debug_string;
 }
 
+void Registry::AddDefinitionID(UDFDefinition* def) {
+  int64_t id = defs_by_id_.size();
+  defs_by_id_.push_back(def);
+  ids_by_name_[def->name()].push_back(id);
+}
+
+StatusOr<int64_t> Registry::GetDefinitionID(
+    std::string_view name, const std::vector<types::DataType>& registry_arg_types) const {
+  auto it = ids_by_name_.find(name);
+  if (it != ids_by_name_.end()) {
+    for (int64_t id : it->second) {
+      if (defs_by_id_[id]->RegistryArgTypes() == registry_arg_types) {
+        return id;
+      }
+    }
+  }
+  return error::NotFound("No UDF matching $0 found.",
+                         RegistryKey(std::string(name), registry_arg_types).DebugString());
+}
+
+StatusOr<UDFDefinition*> Registry::GetDefinitionByID(int64_t id) const {
+  if (id < 0 || id >= static_cast<int64_t>(defs_by_id_.size())) {
+    return error::NotFound("No UDF with ID $0 found.", id);
+  }
+  return defs_by_id_[id];
+}
+
+StatusOr<ScalarUDFDefinition*> Registry::GetScalarUDFDefinitionByID(int64_t id) const {
+  PL_ASSIGN_OR_RETURN(auto def, GetDefinitionByID(id));
+  if (def->kind() != UDFDefinitionKind::kScalarUDF) {
+    return error::NotFound("'$0' is not a ScalarUDF", def->name());
+  }
+  return static_cast<ScalarUDFDefinition*>(def);
+}
+
+StatusOr<UDADefinition*> Registry::GetUDADefinitionByID(int64_t id) const {
+  PL_ASSIGN_OR_RETURN(auto def, GetDefinitionByID(id));
+  if (def->kind() != UDFDefinitionKind::kUDA) {
+    return error::NotFound("'$0' is not a UDA", def->name());
+  }
+  return static_cast<UDADefinition*>(def);
+}
+
 StatusOr<UDTFDefinition*> Registry::GetUDTFDefinition(
     const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
   PL_ASSIGN_OR_RETURN(auto def, GetDefinition(name, registry_arg_types));
@@ -189,12 +232,8 @@ StatusOr<ScalarUDFDefinition*> Registry::GetScalarUDFDefinition(
 
 StatusOr<UDFDefinition*> Registry::GetDefinition(
     const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
-  auto key = RegistryKey(name, registry_arg_types);
-  auto it = map_.find(key);
-  if (it == map_.end()) {
-    return error::NotFound("No UDF matching $0 found.", key.DebugString());
-  }
-  return it->second.get();
+  PL_ASSIGN_OR_RETURN(int64_t id, GetDefinitionID(name, registry_arg_types));
+  return defs_by_id_[id];
 }
 
 }  // namespace udf
@@ -21,9 +21,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
 
 #include "src/carnot/udf/doc.h"
@@ -121,6 +123,7 @@ class Registry {
           "The UDF with name \"$0\" already exists with the same arg types \"$1\".", name,
           key.DebugString());
     }
+    AddDefinitionID(udf_def.get());
     map_[key] = std::move(udf_def);
     RegisterSemanticTypes<T>(name);
 
@@ -192,6 +195,7 @@ class Registry {
           "The UDTF with name \"$0\" already exists with same exec args \"$1\".", name,
           key.DebugString());
     }
+    AddDefinitionID(udf_def.get());
     map_[key] = std::move(udf_def);
     return Status::OK();
   }
@@ -214,6 +218,17 @@ class Registry {
   StatusOr<UDTFDefinition*> GetUDTFDefinition(
       const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
 
+  /**
+   * Gets the ID of the UDF/UDA/UDTF, which is assigned when it is registered and stays the same for
+   * the lifetime of the registry. Resolving a function once and using its ID afterwards avoids
+   * building a RegistryKey per lookup.
+   */
+  StatusOr<int64_t> GetDefinitionID(std::string_view name,
+                                    const std::vector<types::DataType>& registry_arg_types) const;
+
+  StatusOr<ScalarUDFDefinition*> GetScalarUDFDefinitionByID(int64_t id) const;
+  StatusOr<UDADefinition*> GetUDADefinitionByID(int64_t id) const;
+
   std::string DebugString() const;
   udfspb::UDFInfo ToProto();
 
@@ -233,12 +248,18 @@ class Registry {
   StatusOr<UDFDefinition*> GetDefinition(
       const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
 
+  StatusOr<UDFDefinition*> GetDefinitionByID(int64_t id) const;
+  void AddDefinitionID(UDFDefinition* def);
+
   void ToProto(const ScalarUDFDefinition& def, udfspb::ScalarUDFSpec* spec);
   void ToProto(const UDADefinition& def, udfspb::UDASpec* spec);
   void ToProto(const UDTFDefinition& def, udfspb::UDTFSourceSpec* spec);
 
   std::string name_;
   RegistryMap map_;
+  // The definitions in map_ by their ID, and the IDs of the overloads of each name.
+  std::vector<UDFDefinition*> defs_by_id_;
+  absl::flat_hash_map<std::string, std::vector<int64_t>> ids_by_name_;
   std::map<std::string, ExplicitRuleSet> semantic_type_rules_;
   udfspb::Docs docs_pb_;
 };
@@ -143,6 +143,24 @@ TEST(Registry, templated_udfs) {
   EXPECT_TRUE(error::IsNotFound(statusor.status()));
 }
 
+TEST(Registry, definition_ids) {
+  auto registry = Registry("test registry");
+  registry.RegisterOrDie<AddUDF<types::Float64Value, types::Int64Value, types::Float64Value>>(
+      "add");
+  registry.RegisterOrDie<AddUDF<types::Float64Value, types::Float64Value, types::Float64Value>>(
+      "add");
+
+  std::vector<types::DataType> arg_types({types::DataType::FLOAT64, types::DataType::FLOAT64});
+  ASSERT_OK_AND_ASSIGN(int64_t id, registry.GetDefinitionID("add", arg_types));
+  ASSERT_OK_AND_ASSIGN(auto def, registry.GetScalarUDFDefinitionByID(id));
+  EXPECT_OK_AND_EQ(registry.GetScalarUDFDefinition("add", arg_types), def);
+  EXPECT_EQ(arg_types, def->exec_arguments());
+
+  EXPECT_NOT_OK(registry.GetDefinitionID("add", {types::DataType::INT64}));
+  EXPECT_NOT_OK(registry.GetUDADefinitionByID(id));
+  EXPECT_NOT_OK(registry.GetScalarUDFDefinitionByID(2));
+}
+
 TEST(Registry, double_register) {
   auto registry = Registry("test registry");
   registry.RegisterOrDie<ScalarUDF1>("scalar1");
@@ -29,6 +29,7 @@
 
 #include <absl/strings/str_format.h>
 #include "src/carnot/udf/udf.h"
+#include "src/carnot/udf/udf_wrapper.h"
 #include "src/common/base/test_utils.h"
 #include "src/shared/types/types.h"
 
@@ -215,6 +216,24 @@ class UDATester {
   std::vector<std::unique_ptr<TUDA>> merge_udas_;
 };
 
+// Runs the UDF on arrow arrays, which prefers ExecBatch over Exec.
+template <typename TUDF, typename TBuilder, typename... TArgs>
+std::shared_ptr<arrow::Array> ExecArrow(TUDF* udf, const std::vector<TArgs>&... args) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  std::vector<std::shared_ptr<arrow::Array>> arrs = {
+      types::ToArrow(args, arrow::default_memory_pool())...};
+  std::vector<arrow::Array*> inputs;
+  for (const auto& arr : arrs) {
+    inputs.push_back(arr.get());
+  }
+  TBuilder builder;
+  EXPECT_OK(ScalarUDFWrapper<TUDF>::ExecBatchArrow(udf, &ctx, inputs, &builder,
+                                                   arrs.front()->length()));
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(builder.Finish(&res).ok());
+  return res;
+}
+
 }  // namespace udf
 }  // namespace carnot
 }  // namespace px
@@ -74,6 +74,19 @@ class AnyUDA : public BaseFunc {
  *      Status Init(FunctionContext *ctx, UDFValue... init_args) {}
  *  This function is called once during initialization of each instance (many instances
  *  may exists in a given query). The arguments are as provided by the query.
+ *
+ * It can also _optionally_ implement a batch version of Exec:
+ *      void ExecVector(FunctionContext *ctx, size_t count, UDFValue* out, const UDFValue*... args)
+ *  The arguments and output are contiguous arrays of count values, so simple loops over them can
+ *  be vectorized by the compiler. If it exists, it's used instead of calling Exec for each record.
+ *
+ * Or a batch version of Exec that works on the arrow arrays directly:
+ *      Status ExecBatch(FunctionContext *ctx, size_t count, ArrowBuilder* out,
+ *                       const ArrowArray*... args)
+ *  The builder and array types are the arrow types of the Exec return and argument types. String
+ *  arguments can be read as views into the arrow buffers and results appended without
+ *  intermediate copies, so UDFs that work on strings can avoid allocating for every record. If it
+ *  exists, it's preferred when the inputs are arrow arrays.
  */
 class ScalarUDF : public AnyUDF {
  public:
@@ -95,6 +108,10 @@ class ScalarUDF : public AnyUDF {
  * It may optionally implement:
  *     Status Init(FunctionContext *ctx, InitArgs...) {}
  *
+ * And a batch version of Update, over contiguous arrays of count values:
+ *     void UpdateVector(FunctionContext *ctx, size_t count, const Args*... args) {}
+ * If it exists, it's used instead of calling Update for each record.
+ *
  * To support partial aggregation to UDAs must also implement:
  *     StringValue Serialize(FunctionContext*) {}
  *     Status DeSerialize(FunctionContext*, const StringValue& data) {}
@@ -167,6 +184,27 @@ struct has_udf_executor_fn<T, std::void_t<decltype(&T::Executor)>> : std::true_t
       "If an executor function exists, it must have the form: UDFSourceExecutor Executor()");
 };
 
+// SFINAE test for the ExecVector fn.
+template <typename T, typename = void>
+struct has_udf_exec_vector_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_vector_fn<T, std::void_t<decltype(&T::ExecVector)>> : std::true_type {};
+
+// SFINAE test for the UpdateVector fn.
+template <typename T, typename = void>
+struct has_uda_update_vector_fn : std::false_type {};
+
+template <typename T>
+struct has_uda_update_vector_fn<T, std::void_t<decltype(&T::UpdateVector)>> : std::true_type {};
+
+// SFINAE test for the ExecBatch fn.
+template <typename T, typename = void>
+struct has_udf_exec_batch_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_batch_fn<T, std::void_t<decltype(&T::ExecBatch)>> : std::true_type {};
+
 template <typename T, typename = void>
 struct check_executor_fn {};
 
@@ -228,6 +266,18 @@ class ScalarUDFTraits {
    */
   static constexpr bool HasExecutor() { return has_udf_executor_fn<T>::value; }
 
+  /**
+   * Checks if the UDF has a batch ExecVector function.
+   * @return true if it has an ExecVector function.
+   */
+  static constexpr bool HasExecVector() { return has_udf_exec_vector_fn<T>::value; }
+
+  /**
+   * Checks if the UDF has a batch ExecBatch function over arrow arrays.
+   * @return true if it has an ExecBatch function.
+   */
+  static constexpr bool HasExecBatch() { return has_udf_exec_batch_fn<T>::value; }
+
   template <typename Q = T, std::enable_if_t<ScalarUDFTraits<Q>::HasInit(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return GetArgumentTypesHelper(&Q::Init);
@@ -368,6 +418,12 @@ class UDATraits {
     return has_uda_serialize_fn<T>() && has_uda_deserialize_fn<T>();
   }
 
+  /**
+   * Checks if the UDA has a batch UpdateVector function.
+   * @return true if it has an UpdateVector function.
+   */
+  static constexpr bool HasUpdateVector() { return has_uda_update_vector_fn<T>::value; }
+
   template <typename Q = T, std::enable_if_t<UDATraits<Q>::HasInit(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return GetArgumentTypesHelper(&Q::Init);
@@ -209,6 +209,8 @@ class UDADefinition : public UDFDefinition {
     finalize_value_fn = UDAWrapper<T>::FinalizeValue;
 
     supports_partial_ = UDAWrapper<T>::SupportsPartial;
+    serialize_fn_ = UDAWrapper<T>::Serialize;
+    deserialize_fn_ = UDAWrapper<T>::Deserialize;
     return Status::OK();
   }
 
@@ -245,6 +247,12 @@ class UDADefinition : public UDFDefinition {
   Status FinalizeArrow(UDA* uda, FunctionContext* ctx, arrow::ArrayBuilder* output) {
     return finalize_arrow_fn_(uda, ctx, output);
   }
+  StatusOr<types::StringValue> Serialize(UDA* uda, FunctionContext* ctx) {
+    return serialize_fn_(uda, ctx);
+  }
+  Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    return deserialize_fn_(uda, ctx, data);
+  }
 
  private:
   std::vector<types::DataType> init_arguments_;
@@ -267,6 +275,9 @@ class UDADefinition : public UDFDefinition {
   std::function<Status(UDA* uda, FunctionContext* ctx, types::BaseValueType* output)>
       finalize_value_fn;
   std::function<Status(UDA* uda1, UDA* uda2, FunctionContext* ctx)> merge_fn_;
+  std::function<StatusOr<types::StringValue>(UDA* uda, FunctionContext* ctx)> serialize_fn_;
+  std::function<Status(UDA* uda, FunctionContext* ctx, const types::StringValue& data)>
+      deserialize_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx,
                        const std::vector<std::shared_ptr<types::BaseValueType>>& inputs)>
       init_wrapper_fn_;
@@ -308,6 +319,9 @@ class UDTFDefinition : public UDFDefinition {
 
     exec_init_ = UDTFWrapper<T>::Init;
     exec_batch_update_ = UDTFWrapper<T>::ExecBatchUpdate;
+    partitionable_ = UDTFTraits<T>::IsPartitionable();
+    num_partitions_ = UDTFWrapper<T>::NumPartitions;
+    exec_partition_ = UDTFWrapper<T>::ExecPartition;
 
     auto init_args = UDTFTraits<T>::InitArguments();
     init_arguments_ = {init_args.begin(), init_args.end()};
@@ -339,6 +353,20 @@ class UDTFDefinition : public UDFDefinition {
     return exec_batch_update_(udtf, ctx, max_gen_records, outputs);
   }
 
+  /**
+   * Partitionable UDTFs generate their records in NumPartitions() independent partitions, with
+   * ExecPartition() instead of ExecBatchUpdate(). Different partitions of the same UDTF instance
+   * can be generated concurrently.
+   */
+  bool partitionable() const { return partitionable_; }
+
+  int64_t NumPartitions(AnyUDTF* udtf, FunctionContext* ctx) { return num_partitions_(udtf, ctx); }
+
+  void ExecPartition(AnyUDTF* udtf, FunctionContext* ctx, int64_t partition,
+                     std::vector<arrow::ArrayBuilder*>* outputs) {
+    exec_partition_(udtf, ctx, partition, outputs);
+  }
+
   const std::vector<UDTFArg>& init_arguments() const { return init_arguments_; }
   const std::vector<ColInfo>& output_relation() const { return output_relation_; }
   udfspb::UDTFSourceExecutor executor() const { return executor_; }
@@ -350,6 +378,11 @@ class UDTFDefinition : public UDFDefinition {
   std::function<bool(AnyUDTF* udtf, FunctionContext* ctx, int max_gen_records,
                      std::vector<arrow::ArrayBuilder*>* outputs)>
       exec_batch_update_;
+  bool partitionable_ = false;
+  std::function<int64_t(AnyUDTF* udtf, FunctionContext* ctx)> num_partitions_;
+  std::function<void(AnyUDTF* udtf, FunctionContext* ctx, int64_t partition,
+                     std::vector<arrow::ArrayBuilder*>* outputs)>
+      exec_partition_;
   std::vector<UDTFArg> init_arguments_;
   std::vector<ColInfo> output_relation_;
   udfspb::UDTFSourceExecutor executor_;
@@ -51,6 +51,22 @@ class AddUDF : public ScalarUDF {
   }
 };
 
+class VectorGreaterThanUDF : public ScalarUDF {
+ public:
+  types::BoolValue Exec(FunctionContext*, types::Int64Value v1, types::Float64Value v2) {
+    return v1.val > v2.val;
+  }
+  void ExecVector(FunctionContext*, size_t count, types::BoolValue* out,
+                  const types::Int64Value* v1, const types::Float64Value* v2) {
+    ++vector_calls;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = v1[i].val > v2[i].val;
+    }
+  }
+
+  int vector_calls = 0;
+};
+
 class InitArgUDF : public ScalarUDF {
  public:
   Status Init(FunctionContext*, types::StringValue str, types::Int64Value i) {
@@ -136,6 +152,45 @@ TEST(UDFDefinition, arrow_write) {
   EXPECT_EQ(6, resArr->Value(1));
 }
 
+TEST(UDFDefinition, exec_vector) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("greaterThan");
+  EXPECT_OK(def.Init<VectorGreaterThanUDF>());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3});
+  types::Float64ValueColumnWrapper v2({0.5, 2.5, 2.5});
+
+  types::BoolValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1, &v2}, &out, v1.Size()));
+  EXPECT_EQ(1, static_cast<VectorGreaterThanUDF*>(u.get())->vector_calls);
+  EXPECT_TRUE(out[0].val);
+  EXPECT_FALSE(out[1].val);
+  EXPECT_TRUE(out[2].val);
+}
+
+TEST(UDFDefinition, exec_vector_arrow) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  std::vector<types::Int64Value> v1 = {1, 2, 3};
+  std::vector<types::Float64Value> v2 = {0.5, 2.5, 2.5};
+
+  auto v1a = ToArrow(v1, arrow::default_memory_pool());
+  auto v2a = ToArrow(v2, arrow::default_memory_pool());
+
+  auto output_builder = std::make_shared<arrow::BooleanBuilder>();
+  auto u = std::make_shared<VectorGreaterThanUDF>();
+  EXPECT_OK(ScalarUDFWrapper<VectorGreaterThanUDF>::ExecBatchArrow(
+      u.get(), &ctx, {v1a.get(), v2a.get()}, output_builder.get(), 3));
+  EXPECT_EQ(1, u->vector_calls);
+
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* resArr = static_cast<arrow::BooleanArray*>(res.get());
+  EXPECT_TRUE(resArr->Value(0));
+  EXPECT_FALSE(resArr->Value(1));
+  EXPECT_TRUE(resArr->Value(2));
+}
+
 TEST(UDFDefinition, init_args) {
   auto ctx = FunctionContext(nullptr, nullptr);
   ScalarUDFDefinition def("initargudf");
@@ -49,6 +49,7 @@ TEST(ScalarUDF, basic_tests) {
               ElementsAre(types::DataType::BOOLEAN, types::DataType::INT64));
   EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::HasInit());
   EXPECT_TRUE(ScalarUDFTraits<ScalarUDF1WithInit>::HasInit());
+  EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::HasExecVector());
 }
 
 TEST(UDFDataTypes, valid_tests) {
@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "src/carnot/udf/udf.h"
@@ -68,6 +69,21 @@ Status ExecWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
   return Status::OK();
 }
 
+/**
+ * This is the inner wrapper for UDFs that implement ExecVector. It calls ExecVector once for the
+ * entire batch, after type casting the inputs.
+ *
+ * @return Status of execution.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecVectorWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                         const std::vector<const types::BaseValueType*>& args,
+                         std::index_sequence<I...>) {
+  [[maybe_unused]] constexpr auto exec_argument_types = ScalarUDFTraits<TUDF>::ExecArguments();
+  udf->ExecVector(ctx, count, out, CastToUDFValueType<exec_argument_types[I]>(args[I])...);
+  return Status::OK();
+}
+
 template <typename TUDF, std::size_t... I>
 Status InitWrapper(TUDF* udf, FunctionContext* ctx,
                    const std::vector<std::shared_ptr<types::BaseValueType>>& args,
@@ -132,6 +148,104 @@ Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput*
   return Status::OK();
 }
 
+/**
+ * Arrow stores fixed size numeric values contiguously with the same layout as the UDF value types,
+ * while booleans are bit packed and strings are stored as offsets into a data buffer.
+ */
+constexpr bool IsContiguousInArrow(types::DataType data_type) {
+  return data_type == types::INT64 || data_type == types::TIME64NS ||
+         data_type == types::FLOAT64;
+}
+
+/**
+ * Checks if the UDF's ExecVector can run directly on arrow arrays. All of the arguments need to be
+ * contiguous in arrow. The output values are appended to the builder afterwards, which also works
+ * for booleans since the BooleanBuilder accepts them as bytes.
+ */
+template <typename TUDF>
+constexpr bool CanExecVectorOnArrow() {
+  if constexpr (!ScalarUDFTraits<TUDF>::HasExecVector()) {
+    return false;
+  } else {
+    for (auto arg_type : ScalarUDFTraits<TUDF>::ExecArguments()) {
+      if (!IsContiguousInArrow(arg_type)) {
+        return false;
+      }
+    }
+    constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+    return IsContiguousInArrow(return_type) || return_type == types::BOOLEAN;
+  }
+}
+
+/**
+ * Checks if the UDA's UpdateVector can run directly on arrow arrays, which needs all of the
+ * arguments to be contiguous in arrow.
+ */
+template <typename TUDA>
+constexpr bool CanUpdateVectorOnArrow() {
+  if constexpr (!UDATraits<TUDA>::HasUpdateVector()) {
+    return false;
+  } else {
+    for (auto arg_type : UDATraits<TUDA>::UpdateArgumentTypes()) {
+      if (!IsContiguousInArrow(arg_type)) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+/**
+ * This is the inner wrapper for UDFs that implement ExecVector, with arrow inputs and outputs.
+ * The arrow buffers are passed in place to the UDF.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecVectorWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                              const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+  using ReturnValueType = typename types::DataTypeTraits<return_type>::value_type;
+  using ReturnNativeType = typename types::DataTypeTraits<return_type>::native_type;
+  static_assert(sizeof(ReturnValueType) == sizeof(ReturnNativeType));
+
+  std::vector<ReturnValueType> values(count);
+  udf->ExecVector(
+      ctx, count, values.data(),
+      reinterpret_cast<const typename types::DataTypeTraits<exec_argument_types[I]>::value_type*>(
+          static_cast<const typename types::DataTypeTraits<
+              exec_argument_types[I]>::arrow_array_type*>(args[I])
+              ->raw_values())...);
+  if constexpr (return_type == types::BOOLEAN) {
+    PL_RETURN_IF_ERROR(out->AppendValues(reinterpret_cast<const uint8_t*>(values.data()), count));
+  } else {
+    PL_RETURN_IF_ERROR(
+        out->AppendValues(reinterpret_cast<const ReturnNativeType*>(values.data()), count));
+  }
+  return Status::OK();
+}
+
+/**
+ * This is the inner wrapper for UDFs that implement ExecBatch. The arrow arrays and the output
+ * builder are passed to the UDF as their concrete types.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecBatchWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                             const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  static_assert(
+      std::is_invocable_r_v<
+          Status, decltype(&TUDF::ExecBatch), TUDF*, FunctionContext*, size_t, TOutput*,
+          const typename types::DataTypeTraits<exec_argument_types[I]>::arrow_array_type*...>,
+      "ExecBatch must have the form: Status ExecBatch(FunctionContext*, size_t, ArrowBuilder*, "
+      "const ArrowArray*...), with the arrow types of the Exec function");
+  return udf->ExecBatch(
+      ctx, count, out,
+      static_cast<const typename types::DataTypeTraits<exec_argument_types[I]>::arrow_array_type*>(
+          args[I])...);
+}
+
 /**
  * Checks types between column wrapper and array of types::UDFDataTypes.
  * @return true if all types match.
@@ -200,6 +314,17 @@ struct ScalarUDFWrapper {
     // The outer wrapper just casts the output type and UDF type. We then pass in
     // the inputs with a sequence based on the number of arguments to iterate through and
     // cast the inputs.
+    if constexpr (ScalarUDFTraits<TUDF>::HasExecBatch()) {
+      return ExecBatchWrapperArrow<TUDF>(
+          static_cast<TUDF*>(udf), ctx, count,
+          static_cast<typename types::DataTypeTraits<return_type>::arrow_builder_type*>(output),
+          inputs, std::make_index_sequence<exec_argument_types.size()>{});
+    } else if constexpr (CanExecVectorOnArrow<TUDF>()) {
+      return ExecVectorWrapperArrow<TUDF>(
+          static_cast<TUDF*>(udf), ctx, count,
+          static_cast<typename types::DataTypeTraits<return_type>::arrow_builder_type*>(output),
+          inputs, std::make_index_sequence<exec_argument_types.size()>{});
+    }
     return ExecWrapperArrow<TUDF>(
         static_cast<TUDF*>(udf), ctx, count,
         static_cast<typename types::DataTypeTraits<return_type>::arrow_builder_type*>(output),
@@ -241,6 +366,11 @@ struct ScalarUDFWrapper {
     // The outer wrapper just casts the output type and UDF type. We then pass in
     // the inputs with a sequence based on the number of arguments to iterate through and
     // cast the inputs.
+    if constexpr (ScalarUDFTraits<TUDF>::HasExecVector()) {
+      return ExecVectorWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
+                                     input_as_base_value,
+                                     std::make_index_sequence<exec_argument_types.size()>{});
+    }
     return ExecWrapper<TUDF>(static_cast<TUDF*>(udf), ctx, count, casted_output,
                              input_as_base_value,
                              std::make_index_sequence<exec_argument_types.size()>{});
@@ -289,6 +419,10 @@ Status UpdateWrapper(TUDA* uda, FunctionContext* ctx, size_t count,
                      const std::vector<const types::BaseValueType*>& args,
                      std::index_sequence<I...>) {
   constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  if constexpr (UDATraits<TUDA>::HasUpdateVector()) {
+    uda->UpdateVector(ctx, count, CastToUDFValueType<update_argument_types[I]>(args[I])...);
+    return Status::OK();
+  }
   for (size_t idx = 0; idx < count; ++idx) {
     uda->Update(ctx, CastToUDFValueType<update_argument_types[I]>(args[I])[idx]...);
   }
@@ -303,6 +437,16 @@ template <typename TUDA, std::size_t... I>
 Status UpdateWrapperArrow(TUDA* uda, FunctionContext* ctx, size_t count,
                           const std::vector<const arrow::Array*>& args, std::index_sequence<I...>) {
   constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  if constexpr (CanUpdateVectorOnArrow<TUDA>()) {
+    uda->UpdateVector(
+        ctx, count,
+        reinterpret_cast<
+            const typename types::DataTypeTraits<update_argument_types[I]>::value_type*>(
+            static_cast<const typename types::DataTypeTraits<
+                update_argument_types[I]>::arrow_array_type*>(args[I])
+                ->raw_values())...);
+    return Status::OK();
+  }
   for (size_t idx = 0; idx < count; ++idx) {
     uda->Update(ctx, types::GetValueFromArrowArray<update_argument_types[I]>(args[I], idx)...);
   }
@@ -405,6 +549,35 @@ struct UDAWrapper {
     return Status::OK();
   }
 
+  /**
+   * Serialize the partial aggregate state of the UDA.
+   * @return The serialized state, or an error if the UDA does not support partial aggregates.
+   */
+  static StatusOr<types::StringValue> Serialize(UDA* uda, FunctionContext* ctx) {
+    if constexpr (SupportsPartial) {
+      return static_cast<TUDA*>(uda)->Serialize(ctx);
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      return error::Unimplemented("UDA does not support partial aggregation");
+    }
+  }
+
+  /**
+   * Restore the partial aggregate state of the UDA from the output of Serialize.
+   * @return Status of the Deserialize.
+   */
+  static Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    if constexpr (SupportsPartial) {
+      return static_cast<TUDA*>(uda)->Deserialize(ctx, data);
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      PL_UNUSED(data);
+      return error::Unimplemented("UDA does not support partial aggregation");
+    }
+  }
+
   /**
    * Finalize the UDA into an arrow builder. The arrow builder needs to be correct type
    * for the finalize return type.
@@ -478,15 +651,47 @@ struct UDTFWrapper {
       CHECK(out->Reserve(max_gen_records).ok());
     }
 
-    auto* u = static_cast<TUDTF*>(udtf);
-    int count = 0;
-    bool more = true;
-    RecordWriterProxy<TUDTF> rw(outputs);
-    while (count < max_gen_records && more) {
-      more = u->NextRecord(ctx, &rw);
-      ++count;
+    if constexpr (UDTFTraits<TUDTF>::HasNextRecordFn()) {
+      auto* u = static_cast<TUDTF*>(udtf);
+      int count = 0;
+      bool more = true;
+      RecordWriterProxy<TUDTF> rw(outputs);
+      while (count < max_gen_records && more) {
+        more = u->NextRecord(ctx, &rw);
+        ++count;
+      }
+      return more;
+    } else {
+      // Partitionable UDTFs without NextRecord() are only run with ExecPartition().
+      PL_UNUSED(udtf);
+      PL_UNUSED(ctx);
+      LOG(DFATAL) << absl::Substitute("UDTF '$0' can only generate partitions",
+                                      typeid(TUDTF).name());
+      return false;
+    }
+  }
+
+  static int64_t NumPartitions(AnyUDTF* udtf, FunctionContext* ctx) {
+    if constexpr (UDTFTraits<TUDTF>::IsPartitionable()) {
+      return static_cast<const TUDTF*>(udtf)->NumPartitions(ctx);
+    } else {
+      PL_UNUSED(udtf);
+      PL_UNUSED(ctx);
+      return 0;
+    }
+  }
+
+  static void ExecPartition(AnyUDTF* udtf, FunctionContext* ctx, int64_t partition,
+                            std::vector<arrow::ArrayBuilder*>* outputs) {
+    if constexpr (UDTFTraits<TUDTF>::IsPartitionable()) {
+      RecordWriterProxy<TUDTF> rw(outputs);
+      static_cast<const TUDTF*>(udtf)->GeneratePartition(ctx, partition, &rw);
+    } else {
+      PL_UNUSED(udtf);
+      PL_UNUSED(ctx);
+      PL_UNUSED(partition);
+      PL_UNUSED(outputs);
     }
-    return more;
   }
 
  private:
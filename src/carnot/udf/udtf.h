@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/udf/base.h"
@@ -254,6 +256,26 @@ class UDTFTraits {
    */
   static constexpr bool HasNextRecordFn() { return NextRecordFnHelper<TUDTF>::value; }
 
+  /**
+   * Checks to see if NumPartitions() exists.
+   */
+  static constexpr bool HasNumPartitionsFn() { return NumPartitionsFnHelper<TUDTF>::value; }
+
+  /**
+   * Checks to see if GeneratePartition() exists.
+   */
+  static constexpr bool HasGeneratePartitionFn() {
+    return GeneratePartitionFnHelper<TUDTF>::value;
+  }
+
+  /**
+   * Checks to see if the records can be generated in partitions, which happens when both
+   * NumPartitions() and GeneratePartition() exist.
+   */
+  static constexpr bool IsPartitionable() {
+    return HasNumPartitionsFn() && HasGeneratePartitionFn();
+  }
+
   template <typename Q = TUDTF, std::enable_if_t<UDTFTraits<Q>::HasInitArgsFn(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return Q::InitArgs();
@@ -373,6 +395,26 @@ class UDTFTraits {
   struct NextRecordFnHelper<
       T, std::void_t<decltype (&T::NextRecord)(FunctionContext*, typename T::RecordWriter*)>>
       : std::true_type {};
+
+  /*************************************
+   * Templates to check the partition funcs.
+   *************************************/
+  template <typename T, typename = void>
+  struct NumPartitionsFnHelper : std::false_type {};
+
+  template <typename T>
+  struct NumPartitionsFnHelper<
+      T, std::void_t<decltype(std::declval<const T&>().NumPartitions(
+             std::declval<FunctionContext*>()))>> : std::true_type {};
+
+  template <typename T, typename = void>
+  struct GeneratePartitionFnHelper : std::false_type {};
+
+  template <typename T>
+  struct GeneratePartitionFnHelper<
+      T, std::void_t<decltype(std::declval<const T&>().GeneratePartition(
+             std::declval<FunctionContext*>(), int64_t{},
+             std::declval<typename T::RecordWriter*>()))>> : std::true_type {};
 };
 
 /**
@@ -423,9 +465,17 @@ class RecordWriterProxy final {
   }
 
  private:
+  // Builders that run out of capacity grow by at least this many records at a time.
+  static constexpr int64_t kMinGrowth = 1024;
+
   template <typename T, typename ValueType>
   void AppendToBuilder(T* builder, ValueType v) {
-    DCHECK(builder->length() < builder->capacity());
+    if (builder->length() == builder->capacity()) {
+      // Partitions aren't sized up front, so their builders grow as they fill up.
+      [[maybe_unused]] bool res =
+          builder->Reserve(std::max<int64_t>(builder->capacity(), kMinGrowth)).ok();
+      DCHECK(res);
+    }
     // If it's a string type we also need to allocate memory for the data.
     // This actually applies to all non-fixed data allocations.
     // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
@@ -483,9 +533,11 @@ struct UDTFChecker {
   // Check that Executor exists and returns the executor type.
   static_assert(TR::HasExecutorFn(), "UDTF must have an Executor() func");
   static_assert(TR::HasCorrectExectorFnReturnType(), "Executor() must return UDTFSourceExecutor");
-  // Check that NextRecord exists and is well formed.
+  // Check that NextRecord exists and is well formed, unless the UDTF is partitionable.
+  static_assert(TR::HasNumPartitionsFn() == TR::HasGeneratePartitionFn(),
+                "Either both or none of NumPartitions() and GeneratePartition(...) must exist");
   static_assert(
-      TR::HasNextRecordFn(),
+      TR::HasNextRecordFn() || TR::IsPartitionable(),
       "UDTF must have NextRecord func of form NextRecord(FunctionContext, RecordWriterProxy*)");
 };
 
@@ -531,6 +583,17 @@ struct UDTFChecker {
  *     int64_t count_ = 0;
  *   }
  *
+ * UDTFs whose records can be generated independently in parts, e.g. because they iterate over a
+ * large structure, can be made partitionable by defining, instead of NextRecord:
+ *
+ *     // Called once, after Init().
+ *     int64_t NumPartitions(FunctionContext*) const;
+ *     // Writes all the records of the partition. Called concurrently for different partitions.
+ *     void GeneratePartition(FunctionContext*, int64_t partition, RecordWriter* rw) const;
+ *
+ * The partitions are then generated in parallel, each into its own output columns, and their
+ * records are output one after the other.
+ *
  * @tparam Derived The name of the derived class.
  */
 template <typename Derived>
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <optional>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/mixins.h"
+
+namespace px {
+
+/**
+ * LRUCache is a thread-safe map that holds at most `max_entries` values, and evicts the least
+ * recently used one to make room for a new one. Getting or inserting a value marks it as the most
+ * recently used. A cache with a `max_entries` of 0 holds nothing.
+ *
+ * Values are copied out of the cache, so large values are best held by shared pointers.
+ */
+template <typename TKey, typename TValue>
+class LRUCache : public NotCopyable {
+ public:
+  explicit LRUCache(size_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * Returns the value of the key, or std::nullopt if it isn't cached.
+   */
+  std::optional<TValue> Get(const TKey& key) {
+    absl::MutexLock lock(&lock_);
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    return iter->second->second;
+  }
+
+  /**
+   * Inserts the value, unless the key is cached already.
+   *
+   * @return The cached value of the key, which is the given value unless the key was cached.
+   */
+  TValue Insert(const TKey& key, TValue value) {
+    absl::MutexLock lock(&lock_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, iter->second);
+      return iter->second->second;
+    }
+    if (max_entries_ > 0) {
+      Emplace(key, value);
+    }
+    return value;
+  }
+
+  /**
+   * Inserts the value, replacing the cached value of the key, if any.
+   */
+  void Put(const TKey& key, TValue value) {
+    absl::MutexLock lock(&lock_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      lru_.erase(iter->second);
+      index_.erase(iter);
+    }
+    if (max_entries_ > 0) {
+      Emplace(key, std::move(value));
+    }
+  }
+
+  /**
+   * Calls `update` on the cached value of the key, without marking it as used. The cache is locked
+   * during the call, so `update` must not access the cache.
+   *
+   * @return false if the key isn't cached.
+   */
+  template <typename TUpdateFn>
+  bool Update(const TKey& key, TUpdateFn&& update) {
+    absl::MutexLock lock(&lock_);
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return false;
+    }
+    update(&iter->second->second);
+    return true;
+  }
+
+  size_t size() const {
+    absl::MutexLock lock(&lock_);
+    return index_.size();
+  }
+
+  size_t max_entries() const { return max_entries_; }
+
+ private:
+  using LRUList = std::list<std::pair<TKey, TValue>>;
+
+  void Emplace(const TKey& key, TValue value) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    if (index_.size() >= max_entries_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    lru_.emplace_front(key, std::move(value));
+    index_.emplace(key, lru_.begin());
+  }
+
+  const size_t max_entries_;
+  mutable absl::Mutex lock_;
+  // The entries, from the most to the least recently used.
+  LRUList lru_ ABSL_GUARDED_BY(lock_);
+  absl::flat_hash_map<TKey, typename LRUList::iterator> index_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace px
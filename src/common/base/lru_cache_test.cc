@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/base/lru_cache.h"
+
+namespace px {
+
+TEST(LRUCacheTest, GetAndInsert) {
+  LRUCache<std::string, int> cache(2);
+  EXPECT_EQ(cache.Get("a"), std::nullopt);
+
+  EXPECT_EQ(cache.Insert("a", 1), 1);
+  EXPECT_EQ(cache.Get("a"), 1);
+
+  // Insert keeps the cached value.
+  EXPECT_EQ(cache.Insert("a", 2), 1);
+  EXPECT_EQ(cache.Get("a"), 1);
+
+  // Put replaces it.
+  cache.Put("a", 3);
+  EXPECT_EQ(cache.Get("a"), 3);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(LRUCacheTest, EvictsLeastRecentlyUsed) {
+  LRUCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+
+  // Using "a" leaves "b" as the least recently used.
+  EXPECT_EQ(cache.Get("a"), 1);
+  cache.Put("c", 3);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.Get("b"), std::nullopt);
+  EXPECT_EQ(cache.Get("a"), 1);
+  EXPECT_EQ(cache.Get("c"), 3);
+
+  // Replacing a value doesn't evict another one.
+  cache.Put("c", 4);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.Get("a"), 1);
+}
+
+TEST(LRUCacheTest, UpdateDoesntMarkAsUsed) {
+  LRUCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+
+  EXPECT_TRUE(cache.Update("a", [](int* value) { *value = 10; }));
+  EXPECT_FALSE(cache.Update("c", [](int* value) { *value = 30; }));
+
+  // "a" is still the least recently used.
+  cache.Put("c", 3);
+  EXPECT_EQ(cache.Get("a"), std::nullopt);
+  EXPECT_EQ(cache.Get("b"), 2);
+}
+
+TEST(LRUCacheTest, ZeroEntries) {
+  LRUCache<std::string, int> cache(0);
+  EXPECT_EQ(cache.Insert("a", 1), 1);
+  cache.Put("b", 2);
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.Get("a"), std::nullopt);
+}
+
+TEST(LRUCacheTest, ConcurrentAccess) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumKeys = 100;
+  LRUCache<int, int> cache(kNumKeys / 2);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&cache]() {
+      for (int i = 0; i < 10 * kNumKeys; ++i) {
+        int key = i % kNumKeys;
+        EXPECT_EQ(cache.Insert(key, key), key);
+        std::optional<int> value = cache.Get(key);
+        if (value.has_value()) {
+          EXPECT_EQ(*value, key);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(cache.size(), kNumKeys / 2);
+}
+
+}  // namespace px
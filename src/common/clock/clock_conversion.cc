@@ -42,5 +42,10 @@ uint64_t DefaultMonoToRealtimeConverter::Convert(uint64_t monotonic_time) const
   return mono_to_realtime_.Get(monotonic_time);
 }
 
+void DefaultMonoToRealtimeConverter::ConvertBatch(size_t count, const uint64_t* monotonic_times,
+                                                  uint64_t* out) const {
+  mono_to_realtime_.GetBatch(count, monotonic_times, out);
+}
+
 }  // namespace clock
 }  // namespace px
@@ -38,6 +38,13 @@ class ClockConverter {
  public:
   virtual ~ClockConverter() = default;
   virtual uint64_t Convert(uint64_t monotonic_time) const = 0;
+  // Converts count times at once, e.g. a whole time column. out may be the same array as
+  // monotonic_times.
+  virtual void ConvertBatch(size_t count, const uint64_t* monotonic_times, uint64_t* out) const {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = Convert(monotonic_times[i]);
+    }
+  }
   virtual void Update() = 0;
   virtual std::chrono::milliseconds UpdatePeriod() const = 0;
   // The max history is chosen as an even multiple of the default polling period, and longer than 5
@@ -69,6 +76,7 @@ class DefaultMonoToRealtimeConverter : public ClockConverter {
   DefaultMonoToRealtimeConverter();
 
   uint64_t Convert(uint64_t monotonic_time) const override;
+  void ConvertBatch(size_t count, const uint64_t* monotonic_times, uint64_t* out) const override;
   void Update() override;
   std::chrono::milliseconds UpdatePeriod() const override { return kUpdatePeriod; }
 
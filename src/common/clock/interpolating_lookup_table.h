@@ -17,7 +17,9 @@
  */
 #pragma once
 
-#include <deque>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <utility>
 #include "absl/base/internal/spinlock.h"
 
@@ -30,33 +32,128 @@ namespace clock {
  * InterpolatingLookupTable stores sorted key,value pairs in a circular buffer.
  * When accessing the map, if the key is not in the map, the closest key,value pairs are
  * interpolated to get a corresponding value.
+ *
+ * Reads are lock-free: the buffer is published through a sequence lock, so readers never block
+ * on, or slow down, Emplace(). A reader only retries when an Emplace() ran while it was reading,
+ * which happens once per update period at most.
  */
 template <size_t TCapacity>
 class InterpolatingLookupTable {
   // The Map stores a mapping from key to offset (i.e from key to (value - key))
   using MapPairType = std::pair<uint64_t, int64_t>;
-  using CircularMap = std::deque<MapPairType>;
+
+  // The buffer holds the TCapacity most recent pairs, plus the one being replaced.
+  static constexpr size_t kNumSlots = TCapacity + 1;
 
  public:
   void Emplace(uint64_t key, uint64_t val) {
-    absl::base_internal::SpinLockHolder lock(&buffer_lock_);
-    if (buffer_.size() > TCapacity) {
-      buffer_.pop_front();
+    absl::base_internal::SpinLockHolder lock(&write_lock_);
+    const uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t start = start_.load(std::memory_order_relaxed);
+    size_t size = size_.load(std::memory_order_relaxed);
+    if (size == kNumSlots) {
+      start = (start + 1) % kNumSlots;
+      --size;
     }
-    buffer_.push_back(std::make_pair(key, static_cast<int64_t>(val) - key));
+    const size_t slot = (start + size) % kNumSlots;
+    keys_[slot].store(key, std::memory_order_relaxed);
+    offsets_[slot].store(static_cast<int64_t>(val) - key, std::memory_order_relaxed);
+    start_.store(start, std::memory_order_relaxed);
+    size_.store(size + 1, std::memory_order_relaxed);
+
+    seq_.store(seq + 2, std::memory_order_release);
   }
 
   uint64_t Get(uint64_t key) const {
-    {
-      absl::base_internal::SpinLockHolder lock(&buffer_lock_);
-      if (buffer_.size() == 0) {
-        return key;
+    MapPairType a;
+    MapPairType b;
+    bool found_two_points;
+    size_t size;
+    uint64_t seq;
+    do {
+      seq = ReadBegin();
+      const size_t start = start_.load(std::memory_order_relaxed);
+      size = size_.load(std::memory_order_relaxed);
+      auto at = [this, start](size_t i) {
+        const size_t slot = (start + i) % kNumSlots;
+        return MapPairType(keys_[slot].load(std::memory_order_relaxed),
+                           offsets_[slot].load(std::memory_order_relaxed));
+      };
+      found_two_points = size > 0 && GetLeftRightInterpolationPoints(key, size, at, &a, &b);
+    } while (!ReadValidate(seq));
+
+    if (size == 0) {
+      return key;
+    }
+    return Interpolate(key, found_two_points, a, b);
+  }
+
+  /**
+   * Looks up count keys at once, writing their values to out, which may be the same array as keys.
+   * All of the keys are looked up in the same version of the table.
+   */
+  void GetBatch(size_t count, const uint64_t* keys, uint64_t* out) const {
+    std::array<MapPairType, kNumSlots> pairs;
+    size_t size;
+    uint64_t seq;
+    do {
+      seq = ReadBegin();
+      const size_t start = start_.load(std::memory_order_relaxed);
+      size = size_.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < size; ++i) {
+        const size_t slot = (start + i) % kNumSlots;
+        pairs[i] = MapPairType(keys_[slot].load(std::memory_order_relaxed),
+                               offsets_[slot].load(std::memory_order_relaxed));
       }
+    } while (!ReadValidate(seq));
+
+    if (size == 0) {
+      std::copy(keys, keys + count, out);
+      return;
+    }
+    auto at = [&pairs](size_t i) { return pairs[i]; };
+    for (size_t i = 0; i < count; ++i) {
+      MapPairType a;
+      MapPairType b;
+      bool found_two_points = GetLeftRightInterpolationPoints(keys[i], size, at, &a, &b);
+      out[i] = Interpolate(keys[i], found_two_points, a, b);
     }
+  }
 
-    MapPairType a;
-    MapPairType b;
-    auto found_two_points = GetLeftRightInterpolationPoints(key, &a, &b);
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  // Emplace() is meant to be called from one thread at a time, but the lock keeps concurrent
+  // calls from corrupting the buffer. Readers never take it.
+  absl::base_internal::SpinLock write_lock_;
+
+  // Odd while an Emplace() is modifying the buffer.
+  std::atomic<uint64_t> seq_ = 0;
+
+  std::array<std::atomic<uint64_t>, kNumSlots> keys_ = {};
+  std::array<std::atomic<int64_t>, kNumSlots> offsets_ = {};
+  std::atomic<size_t> start_ = 0;
+  std::atomic<size_t> size_ = 0;
+
+  uint64_t ReadBegin() const {
+    uint64_t seq;
+    while ((seq = seq_.load(std::memory_order_acquire)) & 1) {
+    }
+    return seq;
+  }
+
+  // Returns false if the values read since ReadBegin() may be inconsistent, and have to be read
+  // again.
+  bool ReadValidate(uint64_t seq) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq_.load(std::memory_order_relaxed) == seq;
+  }
+
+  static uint64_t Interpolate(uint64_t key, bool found_two_points, const MapPairType& a,
+                              const MapPairType& b) {
     if (!found_two_points) {
       // If we are before or after the history we have stored we just use the closest offset we can.
       return key + a.second;
@@ -64,37 +161,41 @@ class InterpolatingLookupTable {
     return key + LinearInterpolate(a.first, b.first, a.second, b.second, key);
   }
 
-  size_t size() const {
-    absl::base_internal::SpinLockHolder lock(&buffer_lock_);
-    return buffer_.size();
-  }
-
- private:
-  mutable absl::base_internal::SpinLock buffer_lock_;
-  CircularMap buffer_ ABSL_GUARDED_BY(buffer_lock_);
-
-  bool GetLeftRightInterpolationPoints(uint64_t key, MapPairType* left, MapPairType* right) const {
-    absl::base_internal::SpinLockHolder lock(&buffer_lock_);
-    if (buffer_.size() == 1) {
-      *left = *buffer_.begin();
+  // Finds the pairs around key among the size > 0 pairs returned by at(0), ..., at(size - 1),
+  // which are sorted by key.
+  template <typename TAtFn>
+  static bool GetLeftRightInterpolationPoints(uint64_t key, size_t size, TAtFn at,
+                                              MapPairType* left, MapPairType* right) {
+    if (size == 1) {
+      *left = at(0);
       return false;
     }
-    auto cmp = [](MapPairType a, uint64_t b) { return a.first < b; };
-    auto it = std::lower_bound(buffer_.begin(), buffer_.end(), key, cmp);
-    if (it == buffer_.end()) {
-      *left = *std::prev(buffer_.end());
+    // Find the first pair with a key >= key.
+    size_t lo = 0;
+    size_t hi = size;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (at(mid).first < key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == size) {
+      *left = at(size - 1);
       return false;
     }
-    if (it == buffer_.begin()) {
-      *left = *buffer_.begin();
+    MapPairType it = at(lo);
+    if (lo == 0) {
+      *left = it;
       return false;
     }
-    if (it->first == key) {
-      *left = *it;
+    if (it.first == key) {
+      *left = it;
       return false;
     }
-    *left = *std::prev(it);
-    *right = *it;
+    *left = at(lo - 1);
+    *right = it;
     return true;
   }
 };
@@ -18,6 +18,11 @@
 
 #include <benchmark/benchmark.h>
 
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "src/common/clock/clock_conversion.h"
 
 namespace {
@@ -58,8 +63,66 @@ void BM_InterpolatingLookupTableEmplace(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+void BM_InterpolatingLookupTableGetBatch(benchmark::State& state) {
+  constexpr size_t capacity =
+      ClockConverter::BufferCapacity(DefaultMonoToRealtimeConverter::kUpdatePeriod);
+  uint64_t base_val = 1640000000271885073;
+  auto table = InitTable<capacity>(base_val);
+
+  std::vector<uint64_t> keys(state.range(0));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = base_val + 100 * capacity * i / keys.size();
+  }
+  std::vector<uint64_t> vals(keys.size());
+
+  for (auto _ : state) {
+    table->GetBatch(keys.size(), keys.data(), vals.data());
+    benchmark::DoNotOptimize(vals.data());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Readers on several threads, with or without a writer updating the table as fast as it can.
+// The table is shared by all the threads, and the writer runs on a thread of its own.
+// NOLINTNEXTLINE : runtime/references.
+void BM_InterpolatingLookupTableConcurrentGet(benchmark::State& state) {
+  constexpr size_t capacity =
+      ClockConverter::BufferCapacity(DefaultMonoToRealtimeConverter::kUpdatePeriod);
+  static constexpr uint64_t kBaseVal = 1640000000271885073;
+  static std::unique_ptr<InterpolatingLookupTable<capacity>> table;
+  static std::atomic<bool> stop_writer;
+  static std::thread writer;
+  const bool with_writer = state.range(0) != 0;
+
+  if (state.thread_index == 0) {
+    table = InitTable<capacity>(kBaseVal);
+    if (with_writer) {
+      stop_writer = false;
+      writer = std::thread([]() {
+        while (!stop_writer) {
+          table->Emplace(kBaseVal, kBaseVal + 1);
+        }
+      });
+    }
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table->Get(kBaseVal + 100 * capacity / 2));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index == 0 && with_writer) {
+    stop_writer = true;
+    writer.join();
+  }
+}
+
 BENCHMARK(BM_InterpolatingLookupTableGet);
 BENCHMARK(BM_InterpolatingLookupTableEmplace);
+BENCHMARK(BM_InterpolatingLookupTableGetBatch)->Arg(16)->Arg(1024);
+BENCHMARK(BM_InterpolatingLookupTableConcurrentGet)->Arg(0)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_InterpolatingLookupTableConcurrentGet)->Arg(1)->ThreadRange(1, 8)->UseRealTime();
 
 }  // namespace clock
 }  // namespace px
@@ -16,6 +16,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "src/common/testing/testing.h"
 
 #include "src/common/clock/clock_conversion.h"
@@ -86,5 +90,79 @@ TEST(InterpolatingLookupTable, mono_and_realtime) {
   EXPECT_EQ(offset, table.Get(query) - query);
 }
 
+TEST(InterpolatingLookupTable, get_batch) {
+  InterpolatingLookupTable<64> table;
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 5, 6};
+
+  // An empty table maps keys to themselves.
+  std::vector<uint64_t> vals(keys.size());
+  table.GetBatch(keys.size(), keys.data(), vals.data());
+  EXPECT_EQ(keys, vals);
+
+  table.Emplace(1, 1);
+  table.Emplace(3, 5);
+  table.Emplace(5, 9);
+  table.GetBatch(keys.size(), keys.data(), vals.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(table.Get(keys[i]), vals[i]);
+  }
+
+  // Converting in place.
+  table.GetBatch(keys.size(), keys.data(), keys.data());
+  EXPECT_EQ(vals, keys);
+}
+
+TEST(InterpolatingLookupTable, capacity) {
+  InterpolatingLookupTable<2> table;
+  table.Emplace(0, 0);
+  table.Emplace(10, 10);
+  table.Emplace(20, 20);
+  table.Emplace(30, 130);
+  EXPECT_EQ(3, table.size());
+
+  // The oldest point was dropped, so keys before the history use the offset of (10, 10).
+  EXPECT_EQ(5, table.Get(5));
+  EXPECT_EQ(75, table.Get(25));
+}
+
+// Readers running alongside Emplace() must only ever see complete versions of the table.
+TEST(InterpolatingLookupTable, concurrent_readers) {
+  InterpolatingLookupTable<4> table;
+  constexpr int64_t kOffset = 1000;
+  table.Emplace(0, kOffset);
+
+  std::atomic<bool> done = false;
+  std::atomic<int> num_errors = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      std::vector<uint64_t> vals(8);
+      while (!done) {
+        // Every version of the table has the same offset, so any consistent read returns it.
+        uint64_t key = 12345;
+        if (table.Get(key) != key + kOffset) {
+          ++num_errors;
+        }
+        std::vector<uint64_t> keys = {0, 7, 100, 5000, 12345, 50000, 100000, 200000};
+        table.GetBatch(keys.size(), keys.data(), vals.data());
+        for (size_t i = 0; i < keys.size(); ++i) {
+          if (vals[i] != keys[i] + kOffset) {
+            ++num_errors;
+          }
+        }
+      }
+    });
+  }
+
+  for (uint64_t key = 1; key < 100000; ++key) {
+    table.Emplace(key, key + kOffset);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, num_errors);
+}
+
 }  // namespace clock
 }  // namespace px
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/datagen/http_events_generator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include <absl/random/zipf_distribution.h>
+#include <absl/strings/substitute.h>
+
+namespace px {
+namespace datagen {
+
+namespace {
+
+constexpr char kCharSet[] =
+    "0123456789"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz";
+
+std::string RandomChars(size_t length, std::mt19937_64* rng) {
+  std::uniform_int_distribution<size_t> dist(0, sizeof(kCharSet) - 2);
+  std::string str(length, 0);
+  std::generate(str.begin(), str.end(), [&]() { return kCharSet[dist(*rng)]; });
+  return str;
+}
+
+constexpr std::string_view kReqMethods[] = {"GET", "GET", "GET", "POST", "POST", "PUT", "DELETE"};
+
+constexpr std::string_view kReqHeaders =
+    R"({"Accept":"application/json","Host":"service.default.svc.cluster.local",)"
+    R"("User-Agent":"Go-http-client/1.1"})";
+
+constexpr std::string_view kRespHeaders =
+    R"({"Content-Type":"application/json","Content-Length":"512","Server":"envoy"})";
+
+struct RespStatus {
+  int64_t code;
+  std::string_view message;
+};
+
+// Mostly successful responses, with a tail of client and server errors.
+constexpr RespStatus kRespStatuses[] = {
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {200, "OK"},
+    {201, "Created"},
+    {400, "Bad Request"},
+    {404, "Not Found"},
+    {500, "Internal Server Error"},
+};
+
+}  // namespace
+
+HTTPEventsGenerator::HTTPEventsGenerator(uint64_t seed, const Options& opts)
+    : opts_(opts), rng_(seed) {
+  std::uniform_int_distribution<uint64_t> u64_dist;
+  for (int i = 0; i < opts_.num_upids; ++i) {
+    upids_.emplace_back(u64_dist(rng_), u64_dist(rng_));
+  }
+  for (int i = 0; i < opts_.num_remote_addrs; ++i) {
+    remote_addrs_.push_back(absl::Substitute("10.$0.$1.$2", i / 65536 % 256, i / 256 % 256,
+                                             i % 256));
+  }
+  for (int i = 0; i < opts_.num_req_paths; ++i) {
+    req_paths_.push_back(absl::Substitute("/api/v1/$0/$1", RandomChars(8, &rng_), i));
+  }
+  req_body_source_ = RandomChars(2 * opts_.max_req_body_size + 1, &rng_);
+  resp_body_source_ = RandomChars(2 * opts_.max_resp_body_size + 1, &rng_);
+}
+
+const std::vector<types::DataType>& HTTPEventsGenerator::DataTypes() {
+  static const std::vector<types::DataType> kDataTypes = {
+      types::DataType::TIME64NS, types::DataType::UINT128, types::DataType::STRING,
+      types::DataType::INT64,    types::DataType::INT64,   types::DataType::INT64,
+      types::DataType::INT64,    types::DataType::INT64,   types::DataType::STRING,
+      types::DataType::STRING,   types::DataType::STRING,  types::DataType::STRING,
+      types::DataType::INT64,    types::DataType::STRING,  types::DataType::INT64,
+      types::DataType::STRING,   types::DataType::STRING,  types::DataType::INT64,
+      types::DataType::INT64,
+  };
+  return kDataTypes;
+}
+
+const std::vector<std::string>& HTTPEventsGenerator::ColumnNames() {
+  static const std::vector<std::string> kColumnNames = {
+      "time_",         "upid",          "remote_addr",   "remote_port",  "trace_role",
+      "major_version", "minor_version", "content_type",  "req_headers",  "req_method",
+      "req_path",      "req_body",      "req_body_size", "resp_headers", "resp_status",
+      "resp_message",  "resp_body",     "resp_body_size", "latency",
+  };
+  return kColumnNames;
+}
+
+std::unique_ptr<types::ColumnWrapperRecordBatch> HTTPEventsGenerator::Generate(
+    size_t num_rows, int64_t start_time_ns, int64_t time_step_ns) {
+  const std::vector<types::DataType>& data_types = DataTypes();
+  auto record_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  for (types::DataType data_type : data_types) {
+    auto col = types::ColumnWrapper::Make(data_type, 0);
+    col->Reserve(num_rows);
+    record_batch->push_back(std::move(col));
+  }
+  auto string_col = [&record_batch](size_t idx) {
+    return static_cast<types::StringValueColumnWrapper*>((*record_batch)[idx].get());
+  };
+
+  // Processes and paths are skewed, so that group-bys and filters see a realistic mix.
+  absl::zipf_distribution<int> upid_dist(opts_.num_upids - 1);
+  absl::zipf_distribution<int> path_dist(opts_.num_req_paths - 1);
+  std::uniform_int_distribution<int> addr_dist(0, opts_.num_remote_addrs - 1);
+  std::uniform_int_distribution<int> method_dist(0, std::size(kReqMethods) - 1);
+  std::uniform_int_distribution<int> status_dist(0, std::size(kRespStatuses) - 1);
+  std::uniform_int_distribution<int> req_body_dist(0, opts_.max_req_body_size);
+  std::uniform_int_distribution<int> resp_body_dist(0, opts_.max_resp_body_size);
+  std::uniform_int_distribution<int> offset_dist(0, std::min(opts_.max_req_body_size,
+                                                             opts_.max_resp_body_size));
+  std::exponential_distribution<double> latency_dist(1.0 / opts_.mean_latency_ns);
+
+  for (size_t i = 0; i < num_rows; ++i) {
+    const RespStatus& status = kRespStatuses[status_dist(rng_)];
+    const std::string_view req_method = kReqMethods[method_dist(rng_)];
+    const int req_body_size = req_method == "GET" ? 0 : req_body_dist(rng_);
+    const int resp_body_size = resp_body_dist(rng_);
+    const int offset = offset_dist(rng_);
+
+    (*record_batch)[0]->Append<types::Time64NSValue>(start_time_ns + i * time_step_ns);
+    (*record_batch)[1]->Append<types::UInt128Value>(upids_[upid_dist(rng_)]);
+    string_col(2)->AppendView(remote_addrs_[addr_dist(rng_)]);
+    (*record_batch)[3]->Append<types::Int64Value>(8080);
+    // Mostly server-side tracing.
+    (*record_batch)[4]->Append<types::Int64Value>(i % 4 == 0 ? 1 : 2);
+    (*record_batch)[5]->Append<types::Int64Value>(1);
+    (*record_batch)[6]->Append<types::Int64Value>(1);
+    (*record_batch)[7]->Append<types::Int64Value>(1);
+    string_col(8)->AppendView(kReqHeaders);
+    string_col(9)->AppendView(req_method);
+    string_col(10)->AppendView(req_paths_[path_dist(rng_)]);
+    string_col(11)->AppendView(std::string_view(req_body_source_).substr(offset, req_body_size));
+    (*record_batch)[12]->Append<types::Int64Value>(req_body_size);
+    string_col(13)->AppendView(kRespHeaders);
+    (*record_batch)[14]->Append<types::Int64Value>(status.code);
+    string_col(15)->AppendView(status.message);
+    string_col(16)->AppendView(std::string_view(resp_body_source_).substr(offset, resp_body_size));
+    (*record_batch)[17]->Append<types::Int64Value>(resp_body_size);
+    (*record_batch)[18]->Append<types::Int64Value>(static_cast<int64_t>(latency_dist(rng_)));
+  }
+  return record_batch;
+}
+
+}  // namespace datagen
+}  // namespace px
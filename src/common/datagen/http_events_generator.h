@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace datagen {
+
+/**
+ * HTTPEventsGenerator produces record batches shaped like the http_events table of Stirling, with
+ * a skewed mix of processes, paths and statuses, so that benchmarks can ingest and query realistic
+ * data. The generator is seeded, so the produced data is reproducible.
+ */
+class HTTPEventsGenerator {
+ public:
+  struct Options {
+    // The number of distinct processes (UPIDs) and remote endpoints producing the events.
+    int num_upids = 64;
+    int num_remote_addrs = 256;
+    // The number of distinct request paths. Paths are picked with a Zipfian distribution.
+    int num_req_paths = 512;
+    // The sizes of the request and response bodies, in bytes.
+    int max_req_body_size = 64;
+    int max_resp_body_size = 512;
+    // The mean latency of the requests, in nanoseconds.
+    double mean_latency_ns = 5'000'000;
+  };
+
+  explicit HTTPEventsGenerator(uint64_t seed) : HTTPEventsGenerator(seed, Options()) {}
+  HTTPEventsGenerator(uint64_t seed, const Options& opts);
+
+  /**
+   * The types and names of the columns of the produced record batches.
+   */
+  static const std::vector<types::DataType>& DataTypes();
+  static const std::vector<std::string>& ColumnNames();
+
+  /**
+   * Returns a record batch of num_rows events, whose timestamps start at start_time_ns and increase
+   * by time_step_ns.
+   */
+  std::unique_ptr<types::ColumnWrapperRecordBatch> Generate(size_t num_rows, int64_t start_time_ns,
+                                                            int64_t time_step_ns);
+
+ private:
+  const Options opts_;
+  std::mt19937_64 rng_;
+
+  std::vector<types::UInt128Value> upids_;
+  std::vector<std::string> remote_addrs_;
+  std::vector<std::string> req_paths_;
+  // Bodies are sliced out of these, so that the values differ without generating each of them.
+  std::string req_body_source_;
+  std::string resp_body_source_;
+};
+
+}  // namespace datagen
+}  // namespace px
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/event/dispatcher_thread.h"
+
+namespace px {
+namespace event {
+
+void DispatcherThread::Start() {
+  DCHECK(!thread_.joinable()) << absl::Substitute("Dispatcher thread $0 already started", name_);
+  thread_ = std::thread([this]() {
+    // Each run blocks until there are events, and handles them. Unlike a single run that blocks
+    // until the loop has nothing left to do, this stops even while timers are enabled.
+    while (!stopping_) {
+      dispatcher_->Run(Dispatcher::RunType::RunUntilExit);
+    }
+  });
+}
+
+void DispatcherThread::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  stopping_ = true;
+  // Wakes up the loop, so that it sees that it is stopping.
+  dispatcher_->Post([]() {});
+  thread_.join();
+}
+
+}  // namespace event
+}  // namespace px
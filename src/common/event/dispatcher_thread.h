@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "src/common/base/base.h"
+#include "src/common/event/api.h"
+#include "src/common/event/dispatcher.h"
+
+namespace px {
+namespace event {
+
+/**
+ * DispatcherThread runs the event loop of a dispatcher on a thread of its own, so that the
+ * subsystems that are given the dispatcher aren't held up by bursts of work on the other loops
+ * of the process.
+ *
+ * The timers of the dispatcher must be created before Start() or on the loop itself, in a
+ * function that is posted to the dispatcher, since the loop isn't safe to use from other threads.
+ * The loop is stopped with Stop(), rather than the Stop() of the dispatcher, which would leave
+ * the thread spinning on a loop with nothing to wait for.
+ */
+class DispatcherThread : public NotCopyable {
+ public:
+  DispatcherThread(std::string_view name, API* api)
+      : name_(std::string(name)), dispatcher_(api->AllocateDispatcher(name)) {}
+
+  ~DispatcherThread() { Stop(); }
+
+  Dispatcher* dispatcher() { return dispatcher_.get(); }
+
+  void Start();
+
+  /**
+   * Stops running the loop after the callback that it is running, if any, and waits for the
+   * thread to exit. The timers of the dispatcher are left for their owners to delete.
+   */
+  void Stop();
+
+ private:
+  const std::string name_;
+  DispatcherUPtr dispatcher_;
+  std::atomic<bool> stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace event
+}  // namespace px
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <absl/synchronization/notification.h>
+
+#include "src/common/base/base.h"
+#include "src/common/event/dispatcher_thread.h"
+#include "src/common/event/event.h"
+
+namespace px {
+namespace event {
+
+class DispatcherThreadTest : public ::testing::Test {
+ public:
+  DispatcherThreadTest()
+      : api_(std::make_unique<APIImpl>(&time_system_)), loop_("test_loop", api_.get()) {}
+
+ protected:
+  RealTimeSystem time_system_;
+  std::unique_ptr<API> api_;
+  DispatcherThread loop_;
+};
+
+TEST_F(DispatcherThreadTest, runs_posts_and_timers_on_its_thread) {
+  std::thread::id timer_thread;
+  absl::Notification timer_ran;
+  auto timer = loop_.dispatcher()->CreateTimer([&]() {
+    timer_thread = std::this_thread::get_id();
+    timer_ran.Notify();
+  });
+  timer->EnableTimer(std::chrono::milliseconds(10));
+  loop_.Start();
+
+  std::thread::id post_thread;
+  absl::Notification post_ran;
+  loop_.dispatcher()->Post([&]() {
+    post_thread = std::this_thread::get_id();
+    post_ran.Notify();
+  });
+  post_ran.WaitForNotification();
+  timer_ran.WaitForNotification();
+
+  EXPECT_NE(std::this_thread::get_id(), post_thread);
+  EXPECT_EQ(post_thread, timer_thread);
+  loop_.Stop();
+}
+
+TEST_F(DispatcherThreadTest, stops_with_enabled_timers) {
+  std::atomic<int> timer_count = 0;
+  auto timer = loop_.dispatcher()->CreateTimer([&]() { timer_count++; });
+  timer->EnableTimer(std::chrono::minutes(1));
+  loop_.Start();
+  loop_.Stop();
+  EXPECT_EQ(0, timer_count);
+}
+
+}  // namespace event
+}  // namespace px
@@ -21,17 +21,96 @@
 #include <nats/adapters/libuv.h>
 #include <nats/nats.h>
 
+#include <algorithm>
+
+#include "src/common/zlib/zlib_wrapper.h"
+
+DEFINE_int32(nats_publish_coalesce_window_ms,
+             gflags::Int32FromEnv("PL_NATS_PUBLISH_COALESCE_WINDOW_MS", 0),
+             "The window within which messages published to a NATS topic are coalesced into one "
+             "NATS message. 0 publishes every message on its own. Receivers must decode "
+             "envelopes.");
+DEFINE_int32(nats_publish_compress_min_bytes,
+             gflags::Int32FromEnv("PL_NATS_PUBLISH_COMPRESS_MIN_BYTES", 0),
+             "The size from which published NATS messages are gzip compressed. 0 disables "
+             "compression. Receivers must decode envelopes.");
+
 namespace px {
 namespace event {
 
-Status NATSConnectorBase::ConnectBase(Dispatcher* base_dispatcher) {
-  natsOptions* nats_opts = nullptr;
-  natsOptions_Create(&nats_opts);
+void AppendToNATSEnvelopeBody(std::string_view serialized_msg, std::string* body) {
+  uint64_t size = serialized_msg.size();
+  while (size >= 0x80) {
+    body->push_back(static_cast<char>((size & 0x7f) | 0x80));
+    size >>= 7;
+  }
+  body->push_back(static_cast<char>(size));
+  body->append(serialized_msg);
+}
+
+Status BuildNATSEnvelope(std::string_view body, size_t compress_min_bytes, std::string* out) {
+  out->clear();
+  out->push_back(kNATSEnvelopeMarker);
+  if (compress_min_bytes == 0 || body.size() < compress_min_bytes) {
+    out->push_back(0);
+    out->append(body);
+    return Status::OK();
+  }
+  out->push_back(static_cast<char>(kNATSEnvelopeCompressed));
+  return zlib::Deflate(body, out);
+}
 
+Status DecodeNATSData(std::string_view data, std::string* inflated,
+                      std::vector<std::string_view>* msgs) {
+  msgs->clear();
+  if (data.empty() || data[0] != kNATSEnvelopeMarker) {
+    msgs->push_back(data);
+    return Status::OK();
+  }
+  if (data.size() < 2) {
+    return error::InvalidArgument("NATS envelope is missing its flags");
+  }
+
+  uint8_t flags = static_cast<uint8_t>(data[1]);
+  std::string_view body = data.substr(2);
+  if (flags & kNATSEnvelopeCompressed) {
+    PL_ASSIGN_OR_RETURN(*inflated, zlib::Inflate(body));
+    body = *inflated;
+  }
+
+  while (!body.empty()) {
+    uint64_t size = 0;
+    size_t pos = 0;
+    for (int shift = 0;; shift += 7) {
+      if (pos == body.size() || shift > 63) {
+        return error::InvalidArgument("Truncated message size in NATS envelope");
+      }
+      uint8_t b = static_cast<uint8_t>(body[pos++]);
+      size |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if ((b & 0x80) == 0) {
+        break;
+      }
+    }
+    if (size > body.size() - pos) {
+      return error::InvalidArgument("Truncated message in NATS envelope");
+    }
+    msgs->push_back(body.substr(pos, size));
+    body.remove_prefix(pos + size);
+  }
+  return Status::OK();
+}
+
+Status NATSConnectorBase::ConnectBase(Dispatcher* base_dispatcher) {
   LibuvDispatcher* dispatcher = dynamic_cast<LibuvDispatcher*>(base_dispatcher);
   if (dispatcher == nullptr) {
     return error::InvalidArgument("Only libuv based dispatcher is allowed");
   }
+  dispatcher_ = base_dispatcher;
+  coalesce_window_ = std::chrono::milliseconds(std::max(FLAGS_nats_publish_coalesce_window_ms, 0));
+  compress_min_bytes_ = std::max(FLAGS_nats_publish_compress_min_bytes, 0);
+
+  natsOptions* nats_opts = nullptr;
+  natsOptions_Create(&nats_opts);
 
   natsLibuv_Init();
 
@@ -70,6 +149,58 @@ Status NATSConnectorBase::ConnectBase(Dispatcher* base_dispatcher) {
   return Status::OK();
 }
 
+Status NATSConnectorBase::PublishSerialized(const std::string& pub_topic) {
+  if (coalesce_window_.count() == 0) {
+    if (compress_min_bytes_ == 0 || serialize_buf_.size() < compress_min_bytes_) {
+      return PublishData(pub_topic, serialize_buf_);
+    }
+    pending_body_.clear();
+    AppendToNATSEnvelopeBody(serialize_buf_, &pending_body_);
+    PL_RETURN_IF_ERROR(BuildNATSEnvelope(pending_body_, compress_min_bytes_, &envelope_buf_));
+    pending_body_.clear();
+    return PublishData(pub_topic, envelope_buf_);
+  }
+
+  AppendToNATSEnvelopeBody(serialize_buf_, &pending_body_);
+  ++num_pending_;
+  if (pending_body_.size() >= kMaxPendingBytes) {
+    return FlushPendingLocked(pub_topic);
+  }
+  if (num_pending_ == 1) {
+    // Publish may run on another thread than the loop of the timer, which it must be enabled on.
+    dispatcher_->Post([this]() { flush_timer_->EnableTimer(coalesce_window_); });
+  }
+  return Status::OK();
+}
+
+void NATSConnectorBase::FlushPending(const std::string& pub_topic) {
+  absl::MutexLock lock(&publish_lock_);
+  Status s = FlushPendingLocked(pub_topic);
+  LOG_IF(ERROR, !s.ok()) << "Failed to publish coalesced NATS messages: " << s.msg();
+}
+
+Status NATSConnectorBase::FlushPendingLocked(const std::string& pub_topic) {
+  if (num_pending_ == 0) {
+    return Status::OK();
+  }
+  Status s = BuildNATSEnvelope(pending_body_, compress_min_bytes_, &envelope_buf_);
+  // The messages are dropped on failure, like a failed publish of a single message.
+  pending_body_.clear();
+  num_pending_ = 0;
+  PL_RETURN_IF_ERROR(s);
+  return PublishData(pub_topic, envelope_buf_);
+}
+
+Status NATSConnectorBase::PublishData(const std::string& pub_topic, std::string_view data) {
+  auto nats_status =
+      natsConnection_Publish(nats_connection_, pub_topic.c_str(), data.data(), data.size());
+  if (nats_status != NATS_OK) {
+    nats_PrintLastErrorStack(stderr);
+    return error::Unknown("Failed to publish to NATS, nats_status=$0", nats_status);
+  }
+  return Status::OK();
+}
+
 void NATSConnectorBase::DisconnectedCB(natsConnection* nc, void* closure) {
   PL_UNUSED(nc);
   auto* connector = static_cast<NATSConnectorBase*>(closure);
@@ -21,8 +21,17 @@
 #include <nats/nats.h>
 #include "src/common/event/libuv.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(nats_publish_coalesce_window_ms);
+DECLARE_int32(nats_publish_compress_min_bytes);
 
 namespace px {
 namespace event {
@@ -33,6 +42,37 @@ struct NATSTLSConfig {
   std::string tls_cert;
 };
 
+/**
+ * Coalesced and compressed messages are published in an envelope, which starts with a zero byte.
+ * A serialized protobuf never does, since zero is not a valid field tag, so receivers can tell the
+ * two apart, and messages that are neither coalesced nor compressed are published as they were.
+ *
+ * The envelope is the marker byte, a flags byte, and the body: every message prefixed with its
+ * varint encoded length. The body is gzip compressed when kNATSEnvelopeCompressed is set.
+ * src/vizier/utils/messagebus/envelope.go decodes envelopes on the receiving side.
+ */
+constexpr char kNATSEnvelopeMarker = 0;
+constexpr uint8_t kNATSEnvelopeCompressed = 1;
+
+/**
+ * Appends a serialized message to the body of an envelope.
+ */
+void AppendToNATSEnvelopeBody(std::string_view serialized_msg, std::string* body);
+
+/**
+ * Writes the envelope of a body into out, compressing the body if it is at least
+ * compress_min_bytes long. A compress_min_bytes of 0 disables compression.
+ */
+Status BuildNATSEnvelope(std::string_view body, size_t compress_min_bytes, std::string* out);
+
+/**
+ * Splits the data of a NATS message into the serialized messages it holds. Data that is not an
+ * envelope is a single message. The views point into data, or into inflated for compressed
+ * envelopes, so both must outlive them.
+ */
+Status DecodeNATSData(std::string_view data, std::string* inflated,
+                      std::vector<std::string_view>* msgs);
+
 class NATSConnectorBase {
  protected:
   NATSConnectorBase(std::string_view nats_server, std::unique_ptr<NATSTLSConfig> tls_config)
@@ -40,16 +80,49 @@ class NATSConnectorBase {
 
   Status ConnectBase(Dispatcher* base_dispatcher);
 
+  /**
+   * Publishes the message in serialize_buf_, either on its own or, when coalescing is enabled,
+   * along with the other messages published within the coalescing window.
+   */
+  Status PublishSerialized(const std::string& pub_topic)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(publish_lock_);
+
+  /**
+   * Publishes the pending coalesced messages, if any.
+   */
+  void FlushPending(const std::string& pub_topic) ABSL_LOCKS_EXCLUDED(publish_lock_);
+
   natsConnection* nats_connection_ = nullptr;
 
+  // Publish may be called from several threads, and the buffers below are reused between calls.
+  absl::Mutex publish_lock_;
+  std::string serialize_buf_ ABSL_GUARDED_BY(publish_lock_);
+
   std::string nats_server_;
   std::unique_ptr<NATSTLSConfig> tls_config_;
   static void DisconnectedCB(natsConnection* nc, void* closure);
   static void ReconnectedCB(natsConnection* nc, void* closure);
 
  private:
+  Status FlushPendingLocked(const std::string& pub_topic)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(publish_lock_);
+  Status PublishData(const std::string& pub_topic, std::string_view data);
+
   size_t disconnect_count_ = 0;
   size_t reconnect_count_ = 0;
+
+  std::chrono::milliseconds coalesce_window_{0};
+  size_t compress_min_bytes_ = 0;
+  Dispatcher* dispatcher_ = nullptr;
+  TimerUPtr flush_timer_;
+
+  std::string envelope_buf_ ABSL_GUARDED_BY(publish_lock_);
+  // The coalesced messages, as the body of an envelope.
+  std::string pending_body_ ABSL_GUARDED_BY(publish_lock_);
+  size_t num_pending_ ABSL_GUARDED_BY(publish_lock_) = 0;
+
+  // Flush before the batch gets near the default NATS max payload of 1MB.
+  static constexpr size_t kMaxPendingBytes = 512 * 1024;
 };
 
 /**
@@ -69,6 +142,7 @@ class NATSConnector : public NATSConnectorBase {
 
   virtual ~NATSConnector() {
     if (nats_connection_ != nullptr) {
+      FlushPending(pub_topic_);
       natsConnection_Destroy(nats_connection_);
     }
 
@@ -84,6 +158,7 @@ class NATSConnector : public NATSConnectorBase {
    */
   virtual Status Connect(Dispatcher* base_dispatcher) {
     PL_RETURN_IF_ERROR(ConnectBase(base_dispatcher));
+    flush_timer_ = base_dispatcher->CreateTimer([this]() { FlushPending(pub_topic_); });
     // Attach the message reader.
     natsConnection_Subscribe(&nats_subscription_, nats_connection_, sub_topic_.c_str(),
                              NATSMessageCallbackHandler, this);
@@ -96,25 +171,34 @@ class NATSConnector : public NATSConnectorBase {
    * @param msg The natsMessage.
    */
   void NATSMessageHandler(natsConnection* /*nc*/, natsSubscription* /*sub*/, natsMsg* msg) {
-    int len = natsMsg_GetDataLength(msg);
-    const char* data = natsMsg_GetData(msg);
-    auto parsed_msg = std::make_unique<TMsg>();
-
-    bool ok = parsed_msg->ParseFromArray(data, len);
-    if (!ok) {
-      LOG(ERROR) << "Failed to parse message";
+    std::string_view data(natsMsg_GetData(msg), natsMsg_GetDataLength(msg));
+    std::string inflated;
+    std::vector<std::string_view> serialized_msgs;
+    Status s = DecodeNATSData(data, &inflated, &serialized_msgs);
+    if (!s.ok()) {
+      LOG(ERROR) << "Failed to decode message: " << s.msg();
       return;
     }
 
-    if (msg_handler_) {
-      msg_handler_(std::move(parsed_msg));
-    } else {
-      LOG(WARNING) << "Dropping message (no handler registered): " << parsed_msg->DebugString();
+    for (std::string_view serialized_msg : serialized_msgs) {
+      auto parsed_msg = std::make_unique<TMsg>();
+      bool ok = parsed_msg->ParseFromArray(serialized_msg.data(), serialized_msg.size());
+      if (!ok) {
+        LOG(ERROR) << "Failed to parse message";
+        continue;
+      }
+
+      if (msg_handler_) {
+        msg_handler_(std::move(parsed_msg));
+      } else {
+        LOG(WARNING) << "Dropping message (no handler registered): " << parsed_msg->DebugString();
+      }
     }
   }
 
   /**
-   * Publish a message to the NATS topic.
+   * Publish a message to the NATS topic. When coalescing is enabled, the message is only queued,
+   * and failures to publish it later are logged rather than returned.
    * @param msg The protobuf message.
    * @return Status of publication.
    */
@@ -122,14 +206,11 @@ class NATSConnector : public NATSConnectorBase {
     if (!nats_connection_) {
       return error::ResourceUnavailable("Not connected to NATS");
     }
-    auto serialized_msg = msg.SerializeAsString();
-    auto nats_status = natsConnection_Publish(nats_connection_, pub_topic_.c_str(),
-                                              serialized_msg.c_str(), serialized_msg.size());
-    if (nats_status != NATS_OK) {
-      nats_PrintLastErrorStack(stderr);
-      return error::Unknown("Failed to publish to NATS, nats_status=$0", nats_status);
+    absl::MutexLock lock(&publish_lock_);
+    if (!msg.SerializeToString(&serialize_buf_)) {
+      return error::Internal("Failed to serialize message");
     }
-    return Status::OK();
+    return PublishSerialized(pub_topic_);
   }
 
   /**
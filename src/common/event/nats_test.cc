@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/common/event/nats.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace event {
+
+using ::testing::ElementsAre;
+
+TEST(NATSEnvelopeTest, plain_data_is_a_single_message) {
+  std::string inflated;
+  std::vector<std::string_view> msgs;
+  ASSERT_OK(DecodeNATSData("\x0a\x03" "abc", &inflated, &msgs));
+  EXPECT_THAT(msgs, ElementsAre("\x0a\x03" "abc"));
+
+  ASSERT_OK(DecodeNATSData("", &inflated, &msgs));
+  EXPECT_THAT(msgs, ElementsAre(""));
+}
+
+TEST(NATSEnvelopeTest, coalesced_messages) {
+  std::string long_msg(300, 'x');
+  std::string body;
+  AppendToNATSEnvelopeBody("first", &body);
+  AppendToNATSEnvelopeBody("", &body);
+  AppendToNATSEnvelopeBody(long_msg, &body);
+
+  std::string envelope;
+  ASSERT_OK(BuildNATSEnvelope(body, /*compress_min_bytes*/ 0, &envelope));
+  EXPECT_EQ(envelope[0], kNATSEnvelopeMarker);
+  EXPECT_EQ(envelope.size(), body.size() + 2);
+
+  std::string inflated;
+  std::vector<std::string_view> msgs;
+  ASSERT_OK(DecodeNATSData(envelope, &inflated, &msgs));
+  EXPECT_THAT(msgs, ElementsAre("first", "", long_msg));
+}
+
+TEST(NATSEnvelopeTest, compressed_messages) {
+  std::string long_msg(4096, 'x');
+  std::string body;
+  AppendToNATSEnvelopeBody(long_msg, &body);
+  AppendToNATSEnvelopeBody("second", &body);
+
+  std::string envelope;
+  ASSERT_OK(BuildNATSEnvelope(body, /*compress_min_bytes*/ 1024, &envelope));
+  EXPECT_EQ(envelope[1], kNATSEnvelopeCompressed);
+  EXPECT_LT(envelope.size(), body.size());
+
+  std::string inflated;
+  std::vector<std::string_view> msgs;
+  ASSERT_OK(DecodeNATSData(envelope, &inflated, &msgs));
+  EXPECT_THAT(msgs, ElementsAre(long_msg, "second"));
+
+  // Bodies below the threshold are not compressed.
+  ASSERT_OK(BuildNATSEnvelope(body, /*compress_min_bytes*/ body.size() + 1, &envelope));
+  EXPECT_EQ(envelope[1], 0);
+}
+
+TEST(NATSEnvelopeTest, truncated_envelopes) {
+  std::string body;
+  AppendToNATSEnvelopeBody("message", &body);
+  std::string envelope;
+  ASSERT_OK(BuildNATSEnvelope(body, /*compress_min_bytes*/ 0, &envelope));
+
+  std::string inflated;
+  std::vector<std::string_view> msgs;
+  EXPECT_NOT_OK(DecodeNATSData(envelope.substr(0, envelope.size() - 1), &inflated, &msgs));
+  EXPECT_NOT_OK(DecodeNATSData(std::string_view("\0", 1), &inflated, &msgs));
+  EXPECT_NOT_OK(DecodeNATSData(std::string_view("\0\0\x80", 3), &inflated, &msgs));
+  EXPECT_NOT_OK(DecodeNATSData(std::string_view("\0\x01garbage", 9), &inflated, &msgs));
+}
+
+}  // namespace event
+}  // namespace px
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/event/worker_pool.h"
+
+#include <string>
+#include <utility>
+
+#include <prometheus/registry.h>
+
+#include "src/common/metrics/metrics.h"
+#include "src/common/metrics/named_timer.h"
+
+namespace px {
+namespace event {
+
+namespace {
+
+prometheus::Family<prometheus::Histogram>& QueueLatencyFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("worker_pool_queue_latency_seconds")
+                            .Help("The time that the work of a worker pool waits for a thread.")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Histogram>& RunLatencyFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("worker_pool_run_latency_seconds")
+                            .Help("The time that the work of a worker pool takes to run.")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Counter>& RejectedFamily() {
+  static auto& family = prometheus::BuildCounter()
+                            .Name("worker_pool_rejected")
+                            .Help("The work that was turned away because the queue was full.")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+prometheus::Family<prometheus::Gauge>& QueuedFamily() {
+  static auto& family = prometheus::BuildGauge()
+                            .Name("worker_pool_queued")
+                            .Help("The work that is waiting for a thread of a worker pool.")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+WorkerPool::WorkerPool(std::string_view name, int num_threads, size_t max_queued)
+    : name_(std::string(name)),
+      max_queued_(max_queued),
+      queue_latency_(
+          QueueLatencyFamily().Add({{"pool", name_}}, metrics::TimerBucketBoundaries())),
+      run_latency_(RunLatencyFamily().Add({{"pool", name_}}, metrics::TimerBucketBoundaries())),
+      rejected_(RejectedFamily().Add({{"pool", name_}})),
+      queued_(QueuedFamily().Add({{"pool", name_}})) {
+  DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkerPool::RunWorker, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    absl::MutexLock lock(&lock_);
+    stopping_ = true;
+    queue_.clear();
+    queued_.Set(0);
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+Status WorkerPool::Submit(PoolExecFunc work, PoolExecCompletionCB done, Dispatcher* dispatcher) {
+  DCHECK(done == nullptr || dispatcher != nullptr)
+      << "The completion callback needs a dispatcher to run on";
+  absl::MutexLock lock(&lock_);
+  if (queue_.size() >= max_queued_) {
+    rejected_.Increment();
+    return error::ResourceUnavailable("Worker pool $0 already has $1 functions queued", name_,
+                                      queue_.size());
+  }
+  queue_.push_back(
+      QueuedWork{std::move(work), std::move(done), dispatcher, std::chrono::steady_clock::now()});
+  queued_.Set(queue_.size());
+  return Status::OK();
+}
+
+size_t WorkerPool::num_queued() const {
+  absl::MutexLock lock(&lock_);
+  return queue_.size();
+}
+
+void WorkerPool::RunWorker() {
+  while (true) {
+    QueuedWork queued;
+    {
+      absl::MutexLock lock(&lock_);
+      lock_.Await(absl::Condition(this, &WorkerPool::HasWorkOrStopping));
+      if (stopping_) {
+        return;
+      }
+      queued = std::move(queue_.front());
+      queue_.pop_front();
+      queued_.Set(queue_.size());
+    }
+    queue_latency_.Observe(SecondsSince(queued.queue_time));
+
+    auto start = std::chrono::steady_clock::now();
+    queued.work();
+    run_latency_.Observe(SecondsSince(start));
+
+    if (queued.done != nullptr) {
+      queued.dispatcher->Post(std::move(queued.done));
+    }
+  }
+}
+
+}  // namespace event
+}  // namespace px
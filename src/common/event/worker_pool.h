@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+#include <prometheus/counter.h>
+#include <prometheus/gauge.h>
+#include <prometheus/histogram.h>
+
+#include "src/common/base/base.h"
+#include "src/common/event/dispatcher.h"
+
+namespace px {
+namespace event {
+
+/**
+ * WorkerPool runs functions on a fixed set of threads, for work that would otherwise hold up the
+ * event loop of a dispatcher. Unlike the libuv threadpool behind CreateAsyncTask, the queue of
+ * the pool is bounded, so that a burst of work is turned away instead of delaying the work that
+ * is already queued, and the pool reports how long the work waits and runs as metrics labelled
+ * with its name.
+ */
+class WorkerPool : public NotCopyable {
+ public:
+  WorkerPool(std::string_view name, int num_threads, size_t max_queued);
+
+  /**
+   * Waits for the running work to finish. Work that is still queued is dropped, without running
+   * its completion callback.
+   */
+  ~WorkerPool();
+
+  /**
+   * Queues the work to run on one of the threads of the pool. If done is set, it is posted to the
+   * dispatcher once the work has run, so that it runs on the event loop of the dispatcher.
+   * This function is safe to call from any thread.
+   * @return ResourceUnavailable if max_queued functions are already waiting to run.
+   */
+  Status Submit(PoolExecFunc work, PoolExecCompletionCB done = nullptr,
+                Dispatcher* dispatcher = nullptr);
+
+  // The number of functions that are waiting for a thread.
+  size_t num_queued() const;
+
+ private:
+  struct QueuedWork {
+    PoolExecFunc work;
+    PoolExecCompletionCB done;
+    Dispatcher* dispatcher;
+    std::chrono::steady_clock::time_point queue_time;
+  };
+
+  void RunWorker();
+  bool HasWorkOrStopping() const ABSL_SHARED_LOCKS_REQUIRED(lock_) {
+    return stopping_ || !queue_.empty();
+  }
+
+  const std::string name_;
+  const size_t max_queued_;
+
+  mutable absl::Mutex lock_;
+  std::deque<QueuedWork> queue_ ABSL_GUARDED_BY(lock_);
+  bool stopping_ ABSL_GUARDED_BY(lock_) = false;
+  std::vector<std::thread> threads_;
+
+  prometheus::Histogram& queue_latency_;
+  prometheus::Histogram& run_latency_;
+  prometheus::Counter& rejected_;
+  prometheus::Gauge& queued_;
+};
+
+}  // namespace event
+}  // namespace px
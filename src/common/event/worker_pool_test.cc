@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <absl/synchronization/notification.h>
+
+#include "src/common/base/base.h"
+#include "src/common/event/dispatcher_thread.h"
+#include "src/common/event/event.h"
+#include "src/common/event/worker_pool.h"
+
+namespace px {
+namespace event {
+
+class WorkerPoolTest : public ::testing::Test {
+ public:
+  WorkerPoolTest()
+      : api_(std::make_unique<APIImpl>(&time_system_)), loop_("test_loop", api_.get()) {}
+
+ protected:
+  RealTimeSystem time_system_;
+  std::unique_ptr<API> api_;
+  DispatcherThread loop_;
+};
+
+TEST_F(WorkerPoolTest, runs_completion_on_dispatcher) {
+  WorkerPool pool("test", /*num_threads*/ 2, /*max_queued*/ 8);
+  loop_.Start();
+
+  std::thread::id loop_thread;
+  absl::Notification loop_started;
+  loop_.dispatcher()->Post([&]() {
+    loop_thread = std::this_thread::get_id();
+    loop_started.Notify();
+  });
+  loop_started.WaitForNotification();
+
+  std::thread::id work_thread;
+  std::thread::id done_thread;
+  absl::Notification done;
+  ASSERT_OK(pool.Submit([&]() { work_thread = std::this_thread::get_id(); },
+                        [&]() {
+                          done_thread = std::this_thread::get_id();
+                          done.Notify();
+                        },
+                        loop_.dispatcher()));
+  done.WaitForNotification();
+
+  EXPECT_NE(loop_thread, work_thread);
+  EXPECT_NE(std::this_thread::get_id(), work_thread);
+  EXPECT_EQ(loop_thread, done_thread);
+}
+
+TEST_F(WorkerPoolTest, rejects_work_when_queue_is_full) {
+  WorkerPool pool("test_bounded", /*num_threads*/ 1, /*max_queued*/ 1);
+
+  absl::Notification running;
+  absl::Notification unblock;
+  ASSERT_OK(pool.Submit([&]() {
+    running.Notify();
+    unblock.WaitForNotification();
+  }));
+  running.WaitForNotification();
+
+  std::atomic<int> num_run = 0;
+  absl::Notification queued_done;
+  ASSERT_OK(pool.Submit([&]() {
+    num_run++;
+    queued_done.Notify();
+  }));
+  EXPECT_EQ(1, pool.num_queued());
+  auto s = pool.Submit([&]() { num_run++; });
+  EXPECT_EQ(statuspb::RESOURCE_UNAVAILABLE, s.code());
+
+  unblock.Notify();
+  queued_done.WaitForNotification();
+  EXPECT_EQ(1, num_run);
+}
+
+}  // namespace event
+}  // namespace px
@@ -19,8 +19,14 @@
 #include <prometheus/registry.h>
 
 #include "src/common/metrics/metrics.h"
+#include "src/common/metrics/sharded_metrics.h"
 
 prometheus::Registry& GetMetricsRegistry() {
   static prometheus::Registry registry;
   return registry;
 }
+
+std::vector<prometheus::MetricFamily> CollectMetrics() {
+  px::metrics::RunCollectHooks();
+  return GetMetricsRegistry().Collect();
+}
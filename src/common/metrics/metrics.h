@@ -18,7 +18,13 @@
 
 #pragma once
 
+#include <vector>
+
 #include <prometheus/registry.h>
 
 // Returns the global metrics registry;
 prometheus::Registry& GetMetricsRegistry();
+
+// Returns the metrics of the global registry. The sharded metrics, and other metrics that are
+// only written to the registry when they are read, are brought up to date first.
+std::vector<prometheus::MetricFamily> CollectMetrics();
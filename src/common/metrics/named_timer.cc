@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/metrics/named_timer.h"
+
+#include <cmath>
+#include <map>
+#include <string>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/container/node_hash_map.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/metrics/metrics.h"
+
+DEFINE_string(timer_subsystems, gflags::StringFromEnv("PL_TIMER_SUBSYSTEMS", ""),
+              "Comma separated subsystems (e.g. stirling,carnot,table_store) whose hot path timers "
+              "record into the timer_duration_seconds histograms, or 'all'.");
+
+namespace px {
+namespace metrics {
+
+namespace {
+
+constexpr char kAllSubsystems[] = "all";
+
+class TimerSubsystemRegistry {
+ public:
+  static TimerSubsystemRegistry& Get() {
+    static auto* registry = new TimerSubsystemRegistry(FLAGS_timer_subsystems);
+    return *registry;
+  }
+
+  // Returns the enabled flag of the subsystem, which lives as long as the process.
+  const std::atomic<bool>* Subsystem(std::string_view name) {
+    absl::MutexLock lock(&mutex_);
+    auto [iter, inserted] = subsystems_.try_emplace(name, false);
+    if (inserted) {
+      iter->second = IsEnabled(name);
+    }
+    return &iter->second;
+  }
+
+  void SetEnabled(std::string_view subsystems) {
+    absl::MutexLock lock(&mutex_);
+    ParseEnabled(subsystems);
+    for (auto& [name, enabled] : subsystems_) {
+      enabled = IsEnabled(name);
+    }
+  }
+
+  std::map<std::string, bool> Subsystems() const {
+    absl::MutexLock lock(&mutex_);
+    std::map<std::string, bool> subsystems;
+    for (const auto& [name, enabled] : subsystems_) {
+      subsystems[name] = enabled.load();
+    }
+    return subsystems;
+  }
+
+ private:
+  explicit TimerSubsystemRegistry(std::string_view subsystems) { ParseEnabled(subsystems); }
+
+  void ParseEnabled(std::string_view subsystems) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    enabled_.clear();
+    for (std::string_view name : absl::StrSplit(subsystems, ',', absl::SkipWhitespace())) {
+      enabled_.emplace(absl::StripAsciiWhitespace(name));
+    }
+  }
+
+  bool IsEnabled(std::string_view name) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return enabled_.contains(kAllSubsystems) || enabled_.contains(name);
+  }
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_set<std::string> enabled_ ABSL_GUARDED_BY(mutex_);
+  // Node based, so that the flags handed out to the timers stay in place.
+  absl::node_hash_map<std::string, std::atomic<bool>> subsystems_ ABSL_GUARDED_BY(mutex_);
+};
+
+prometheus::Family<prometheus::Histogram>& TimerFamily() {
+  static auto& family = prometheus::BuildHistogram()
+                            .Name("timer_duration_seconds")
+                            .Help("The durations recorded by the hot path timers.")
+                            .Register(GetMetricsRegistry());
+  return family;
+}
+
+}  // namespace
+
+const prometheus::Histogram::BucketBoundaries& TimerBucketBoundaries() {
+  static const auto* boundaries = [] {
+    constexpr int kBucketsPerOctave = 4;
+    constexpr int kNumOctaves = 24;
+    auto* boundaries = new prometheus::Histogram::BucketBoundaries();
+    for (int i = 0; i <= kBucketsPerOctave * kNumOctaves; ++i) {
+      boundaries->push_back(1e-6 * std::exp2(static_cast<double>(i) / kBucketsPerOctave));
+    }
+    return boundaries;
+  }();
+  return *boundaries;
+}
+
+NamedTimer::NamedTimer(std::string_view subsystem, std::string_view name,
+                       const std::map<std::string, std::string>& labels)
+    : enabled_(TimerSubsystemRegistry::Get().Subsystem(subsystem)),
+      histogram_(
+          [&] {
+            std::map<std::string, std::string> all_labels = labels;
+            all_labels["subsystem"] = std::string(subsystem);
+            all_labels["timer"] = std::string(name);
+            return &TimerFamily().Add(all_labels, TimerBucketBoundaries());
+          }(),
+          TimerBucketBoundaries()) {}
+
+void SetEnabledTimerSubsystems(std::string_view subsystems) {
+  TimerSubsystemRegistry::Get().SetEnabled(subsystems);
+}
+
+std::map<std::string, bool> GetTimerSubsystems() {
+  return TimerSubsystemRegistry::Get().Subsystems();
+}
+
+}  // namespace metrics
+}  // namespace px
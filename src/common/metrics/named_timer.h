@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include <prometheus/histogram.h>
+
+#include "src/common/base/base.h"
+#include "src/common/metrics/sharded_metrics.h"
+
+DECLARE_string(timer_subsystems);
+
+namespace px {
+namespace metrics {
+
+/**
+ * Returns the bucket boundaries of the timer histograms, in seconds. Like those of an HDR
+ * histogram, they are spaced evenly on a log scale: each power of two from 1us to ~16s is split
+ * into 4 buckets, so a percentile is known to within 19% of its value.
+ */
+const prometheus::Histogram::BucketBoundaries& TimerBucketBoundaries();
+
+/**
+ * NamedTimer records durations into the timer_duration_seconds histogram, with the subsystem and
+ * the name of the timer, and any other labels, as labels.
+ *
+ * Timers only record while their subsystem is enabled, either by --timer_subsystems or by
+ * SetEnabledTimerSubsystems(), so disabled timers only cost a relaxed atomic load.
+ */
+class NamedTimer : public NotCopyable {
+ public:
+  NamedTimer(std::string_view subsystem, std::string_view name,
+             const std::map<std::string, std::string>& labels = {});
+
+  bool enabled() const { return enabled_->load(std::memory_order_relaxed); }
+
+  void Record(std::chrono::nanoseconds duration) {
+    histogram_.Observe(std::chrono::duration<double>(duration).count());
+  }
+
+ private:
+  const std::atomic<bool>* enabled_;
+  ShardedHistogram histogram_;
+};
+
+/**
+ * Records the duration of the scope into the timer, if the timer is enabled when the scope starts.
+ * Usage:
+ *    ScopedNamedTimer timer(&transfer_data_timer_);
+ */
+class ScopedNamedTimer : public NotCopyable {
+ public:
+  explicit ScopedNamedTimer(NamedTimer* timer) : timer_(timer->enabled() ? timer : nullptr) {
+    if (timer_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedNamedTimer() {
+    if (timer_ != nullptr) {
+      timer_->Record(std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+ private:
+  NamedTimer* const timer_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Enables the timers of the comma separated subsystems, and disables those of the others.
+ * "all" enables the timers of every subsystem.
+ */
+void SetEnabledTimerSubsystems(std::string_view subsystems);
+
+/**
+ * Returns whether the timers of each subsystem that has timers are enabled, by subsystem.
+ */
+std::map<std::string, bool> GetTimerSubsystems();
+
+}  // namespace metrics
+}  // namespace px
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/common/metrics/metrics.h"
+#include "src/common/metrics/named_timer.h"
+
+namespace px {
+namespace metrics {
+
+// Returns the number of durations that the timer recorded, as collected.
+uint64_t SampleCount(const std::string& timer) {
+  for (const auto& family : CollectMetrics()) {
+    if (family.name != "timer_duration_seconds") {
+      continue;
+    }
+    for (const auto& metric : family.metric) {
+      for (const auto& label : metric.label) {
+        if (label.name == "timer" && label.value == timer) {
+          return metric.histogram.sample_count;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+TEST(NamedTimerTest, BucketBoundaries) {
+  const auto& boundaries = TimerBucketBoundaries();
+  ASSERT_EQ(97, boundaries.size());
+  EXPECT_DOUBLE_EQ(1e-6, boundaries.front());
+  EXPECT_DOUBLE_EQ(2e-6, boundaries[4]);
+  EXPECT_NEAR(16.78, boundaries.back(), 0.01);
+}
+
+TEST(NamedTimerTest, RecordsWhileSubsystemIsEnabled) {
+  NamedTimer timer("named_timer_test", "scope");
+  NamedTimer other_timer("other_subsystem", "scope");
+  EXPECT_FALSE(timer.enabled());
+  { ScopedNamedTimer scoped_timer(&timer); }
+  EXPECT_EQ(0, SampleCount("scope"));
+
+  SetEnabledTimerSubsystems("foo, named_timer_test");
+  EXPECT_TRUE(timer.enabled());
+  EXPECT_FALSE(other_timer.enabled());
+  { ScopedNamedTimer scoped_timer(&timer); }
+  { ScopedNamedTimer scoped_timer(&timer); }
+  EXPECT_EQ(2, SampleCount("scope"));
+
+  // Timers created later take on the state of their subsystem.
+  NamedTimer later_timer("named_timer_test", "later");
+  EXPECT_TRUE(later_timer.enabled());
+
+  std::map<std::string, bool> subsystems = GetTimerSubsystems();
+  EXPECT_TRUE(subsystems["named_timer_test"]);
+  EXPECT_FALSE(subsystems["other_subsystem"]);
+
+  SetEnabledTimerSubsystems("all");
+  EXPECT_TRUE(other_timer.enabled());
+
+  SetEnabledTimerSubsystems("");
+  EXPECT_FALSE(timer.enabled());
+  EXPECT_FALSE(other_timer.enabled());
+}
+
+}  // namespace metrics
+}  // namespace px
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/metrics/sharded_metrics.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace metrics {
+
+namespace {
+
+struct CollectHooks {
+  absl::Mutex mutex;
+  absl::flat_hash_set<CollectHook*> hooks ABSL_GUARDED_BY(mutex);
+};
+
+CollectHooks& GetCollectHooks() {
+  static auto* hooks = new CollectHooks;
+  return *hooks;
+}
+
+}  // namespace
+
+CollectHook::CollectHook(std::function<void()> fn) : fn_(std::move(fn)) {
+  CollectHooks& hooks = GetCollectHooks();
+  absl::MutexLock lock(&hooks.mutex);
+  hooks.hooks.insert(this);
+}
+
+CollectHook::~CollectHook() {
+  // Once this returns, the function is not running, and won't run again.
+  CollectHooks& hooks = GetCollectHooks();
+  absl::MutexLock lock(&hooks.mutex);
+  hooks.hooks.erase(this);
+}
+
+void RunCollectHooks() {
+  CollectHooks& hooks = GetCollectHooks();
+  absl::MutexLock lock(&hooks.mutex);
+  for (CollectHook* hook : hooks.hooks) {
+    hook->fn_();
+  }
+}
+
+ShardedCounter::ShardedCounter(prometheus::Counter* counter)
+    : state_(std::make_unique<State>(counter)) {}
+
+ShardedCounter::State::State(prometheus::Counter* counter) : counter(counter) {
+  hook = std::make_unique<CollectHook>([this]() { Flush(); });
+}
+
+ShardedCounter::State::~State() {
+  hook.reset();
+  // Keep the increments since the last collection.
+  Flush();
+}
+
+void ShardedCounter::State::Flush() {
+  uint64_t total = 0;
+  for (Shard& shard : shards) {
+    total += shard.value.exchange(0, std::memory_order_relaxed);
+  }
+  if (total > 0) {
+    counter->Increment(static_cast<double>(total));
+  }
+}
+
+ShardedHistogram::ShardedHistogram(prometheus::Histogram* histogram,
+                                   prometheus::Histogram::BucketBoundaries boundaries)
+    : state_(std::make_unique<State>(histogram, std::move(boundaries))) {}
+
+void ShardedHistogram::Observe(double value) {
+  // Like prometheus, buckets count the values up to and including their upper bounds.
+  const auto& boundaries = state_->boundaries;
+  const size_t bucket =
+      std::lower_bound(boundaries.begin(), boundaries.end(), value) - boundaries.begin();
+
+  Shard& shard = *state_->shards[ThisThreadShard()];
+  shard.bucket_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+  // Other threads rarely use the shard, so this seldom retries.
+  double sum = shard.sum.load(std::memory_order_relaxed);
+  while (!shard.sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+  }
+}
+
+ShardedHistogram::State::State(prometheus::Histogram* histogram,
+                               prometheus::Histogram::BucketBoundaries boundaries)
+    : histogram(histogram), boundaries(std::move(boundaries)) {
+  shards.reserve(kNumShards);
+  for (size_t i = 0; i < kNumShards; ++i) {
+    shards.push_back(std::make_unique<Shard>(this->boundaries.size() + 1));
+  }
+  hook = std::make_unique<CollectHook>([this]() { Flush(); });
+}
+
+ShardedHistogram::State::~State() {
+  hook.reset();
+  Flush();
+}
+
+void ShardedHistogram::State::Flush() {
+  std::vector<double> bucket_increments(boundaries.size() + 1, 0);
+  double sum = 0;
+  bool observed = false;
+  for (auto& shard : shards) {
+    for (size_t i = 0; i < bucket_increments.size(); ++i) {
+      const uint64_t count = shard->bucket_counts[i].exchange(0, std::memory_order_relaxed);
+      bucket_increments[i] += count;
+      observed |= count > 0;
+    }
+    sum += shard->sum.exchange(0, std::memory_order_relaxed);
+  }
+  if (observed) {
+    histogram->ObserveMultiple(bucket_increments, sum);
+  }
+}
+
+}  // namespace metrics
+}  // namespace px
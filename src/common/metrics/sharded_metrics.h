@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <prometheus/counter.h>
+#include <prometheus/histogram.h>
+
+namespace px {
+namespace metrics {
+
+// Threads are assigned to the shards of sharded metrics round-robin, so that threads that update
+// the same metric mostly write to cache lines of their own.
+inline constexpr size_t kNumShards = 16;
+
+// Returns the shard of the calling thread.
+inline size_t ThisThreadShard() {
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard;
+}
+
+/**
+ * Runs a function each time CollectMetrics() is called, before the registry is collected, for as
+ * long as the hook lives. This lets metrics be kept in cheaper forms, and only be written to the
+ * registry when they are read.
+ */
+class CollectHook {
+ public:
+  explicit CollectHook(std::function<void()> fn);
+  ~CollectHook();
+
+  CollectHook(const CollectHook&) = delete;
+  CollectHook& operator=(const CollectHook&) = delete;
+
+ private:
+  friend void RunCollectHooks();
+
+  const std::function<void()> fn_;
+};
+
+// Runs the functions of all CollectHooks. Called by CollectMetrics().
+void RunCollectHooks();
+
+/**
+ * A counter for hot paths. Increments are relaxed atomic adds to a shard of the calling thread,
+ * and are added to the prometheus counter when the metrics are collected. The prometheus counter
+ * must outlive this.
+ */
+class ShardedCounter {
+ public:
+  explicit ShardedCounter(prometheus::Counter* counter);
+
+  void Increment(uint64_t value = 1) {
+    state_->shards[ThisThreadShard()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value{0};
+  };
+
+  struct State {
+    explicit State(prometheus::Counter* counter);
+    ~State();
+
+    void Flush();
+
+    prometheus::Counter* const counter;
+    Shard shards[kNumShards];
+    std::unique_ptr<CollectHook> hook;
+  };
+
+  std::unique_ptr<State> state_;
+};
+
+/**
+ * A histogram for hot paths, sharded like ShardedCounter. The bucket boundaries must be those of
+ * the prometheus histogram, which must outlive this.
+ */
+class ShardedHistogram {
+ public:
+  ShardedHistogram(prometheus::Histogram* histogram,
+                   prometheus::Histogram::BucketBoundaries boundaries);
+
+  void Observe(double value);
+
+ private:
+  struct alignas(64) Shard {
+    explicit Shard(size_t num_buckets) : bucket_counts(num_buckets) {}
+
+    // One more than the boundaries; the last one is the +Inf bucket.
+    std::vector<std::atomic<uint64_t>> bucket_counts;
+    std::atomic<double> sum{0};
+  };
+
+  struct State {
+    State(prometheus::Histogram* histogram, prometheus::Histogram::BucketBoundaries boundaries);
+    ~State();
+
+    void Flush();
+
+    prometheus::Histogram* const histogram;
+    const prometheus::Histogram::BucketBoundaries boundaries;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::unique_ptr<CollectHook> hook;
+  };
+
+  std::unique_ptr<State> state_;
+};
+
+}  // namespace metrics
+}  // namespace px
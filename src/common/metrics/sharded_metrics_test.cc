@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <prometheus/counter.h>
+#include <prometheus/histogram.h>
+
+#include "src/common/metrics/metrics.h"
+#include "src/common/metrics/sharded_metrics.h"
+
+namespace px {
+namespace metrics {
+
+// Returns the collected metric of the family, only if it has a single one.
+const prometheus::ClientMetric* FindMetric(const std::vector<prometheus::MetricFamily>& families,
+                                           const std::string& name) {
+  for (const auto& family : families) {
+    if (family.name == name && family.metric.size() == 1) {
+      return &family.metric[0];
+    }
+  }
+  return nullptr;
+}
+
+TEST(ShardedCounterTest, IncrementsAreCollected) {
+  prometheus::Counter& counter = prometheus::BuildCounter()
+                                     .Name("sharded_counter_test")
+                                     .Register(GetMetricsRegistry())
+                                     .Add({});
+  {
+    ShardedCounter sharded_counter(&counter);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&sharded_counter]() {
+        for (int j = 0; j < 1000; ++j) {
+          sharded_counter.Increment(2);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // The increments only reach the counter when the metrics are collected.
+    EXPECT_EQ(counter.Value(), 0);
+
+    const auto* metric = FindMetric(CollectMetrics(), "sharded_counter_test");
+    ASSERT_NE(metric, nullptr);
+    EXPECT_EQ(metric->counter.value, 8000);
+
+    sharded_counter.Increment();
+  }
+  // Increments since the last collection are kept when the sharded counter goes away.
+  EXPECT_EQ(counter.Value(), 8001);
+}
+
+TEST(ShardedHistogramTest, ObservationsAreCollected) {
+  const prometheus::Histogram::BucketBoundaries boundaries = {1, 10};
+  prometheus::Histogram& histogram = prometheus::BuildHistogram()
+                                         .Name("sharded_histogram_test")
+                                         .Register(GetMetricsRegistry())
+                                         .Add({}, boundaries);
+  ShardedHistogram sharded_histogram(&histogram, boundaries);
+
+  std::thread thread([&sharded_histogram]() { sharded_histogram.Observe(10); });
+  sharded_histogram.Observe(0.5);
+  sharded_histogram.Observe(1);
+  sharded_histogram.Observe(100);
+  thread.join();
+
+  const auto* metric = FindMetric(CollectMetrics(), "sharded_histogram_test");
+  ASSERT_NE(metric, nullptr);
+  EXPECT_EQ(metric->histogram.sample_count, 4);
+  EXPECT_DOUBLE_EQ(metric->histogram.sample_sum, 111.5);
+  // Bucket counts are cumulative.
+  ASSERT_EQ(metric->histogram.bucket.size(), 3);
+  EXPECT_EQ(metric->histogram.bucket[0].cumulative_count, 2);
+  EXPECT_EQ(metric->histogram.bucket[1].cumulative_count, 3);
+  EXPECT_EQ(metric->histogram.bucket[2].cumulative_count, 4);
+
+  // Collecting again doesn't count the observations twice.
+  metric = FindMetric(CollectMetrics(), "sharded_histogram_test");
+  ASSERT_NE(metric, nullptr);
+  EXPECT_EQ(metric->histogram.sample_count, 4);
+}
+
+}  // namespace metrics
+}  // namespace px
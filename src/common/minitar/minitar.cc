@@ -28,7 +28,14 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 
@@ -72,9 +79,126 @@ Status CopyData(struct archive* ar, struct archive* aw) {
 
   return Status::OK();
 }
+
+Status ReadData(struct archive* ar, std::string* data) {
+  char buf[16384];
+  while (true) {
+    la_ssize_t size = archive_read_data(ar, buf, sizeof(buf));
+    if (size == 0) {
+      return Status::OK();
+    }
+    if (size < 0) {
+      return error::Internal(archive_error_string(ar));
+    }
+    data->append(buf, size);
+  }
+}
 }  // namespace
 
-Status Minitar::Extract(std::string_view dest_dir, int flags) {
+/**
+ * Writes regular files to disk from a pool of threads, each with its own libarchive writer.
+ * Decompression is inherently sequential, but creating and writing many small files is not.
+ */
+class Minitar::ParallelWriter {
+ public:
+  ParallelWriter(int num_threads, int flags) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back(&ParallelWriter::Run, this, flags);
+    }
+  }
+
+  ~ParallelWriter() { PL_UNUSED(Finish()); }
+
+  // Queues a file to be written. Blocks while too much data is queued already.
+  Status Write(struct archive_entry* entry, std::string data) {
+    absl::MutexLock lock(&mu_);
+    mu_.Await(absl::Condition(this, &ParallelWriter::CanQueue));
+    if (!status_.ok()) {
+      return status_;
+    }
+    queued_bytes_ += data.size();
+    queue_.push_back(File{archive_entry_clone(entry), std::move(data)});
+    return Status::OK();
+  }
+
+  // Waits for the queued files to be written, and returns the first error.
+  Status Finish() {
+    {
+      absl::MutexLock lock(&mu_);
+      done_ = true;
+    }
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+    absl::MutexLock lock(&mu_);
+    return status_;
+  }
+
+ private:
+  // Bounds the memory of the files that were decompressed but not written yet.
+  static constexpr size_t kMaxQueuedBytes = 16 * 1024 * 1024;
+
+  struct File {
+    struct archive_entry* entry;
+    std::string data;
+  };
+
+  bool CanQueue() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queued_bytes_ < kMaxQueuedBytes || !status_.ok();
+  }
+  bool CanDequeue() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) { return !queue_.empty() || done_; }
+
+  Status WriteFile(struct archive* aw, const File& file) {
+    int r = archive_write_header(aw, file.entry);
+    PL_RETURN_IF_NOT_ARCHIVE_OK(r, aw);
+    if (archive_write_data(aw, file.data.data(), file.data.size()) < 0) {
+      return error::Internal(archive_error_string(aw));
+    }
+    r = archive_write_finish_entry(aw);
+    PL_RETURN_IF_NOT_ARCHIVE_OK(r, aw);
+    return Status::OK();
+  }
+
+  void Run(int flags) {
+    struct archive* aw = archive_write_disk_new();
+    archive_write_disk_set_options(aw, flags);
+    while (true) {
+      File file;
+      {
+        absl::MutexLock lock(&mu_);
+        mu_.Await(absl::Condition(this, &ParallelWriter::CanDequeue));
+        if (queue_.empty()) {
+          break;
+        }
+        file = std::move(queue_.front());
+        queue_.pop_front();
+        queued_bytes_ -= file.data.size();
+      }
+
+      Status s = WriteFile(aw, file);
+      archive_entry_free(file.entry);
+      if (!s.ok()) {
+        absl::MutexLock lock(&mu_);
+        if (status_.ok()) {
+          status_ = s;
+        }
+      }
+    }
+    archive_write_close(aw);
+    archive_write_free(aw);
+  }
+
+  std::vector<std::thread> threads_;
+
+  absl::Mutex mu_;
+  std::deque<File> queue_ ABSL_GUARDED_BY(mu_);
+  size_t queued_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  bool done_ ABSL_GUARDED_BY(mu_) = false;
+  Status status_ ABSL_GUARDED_BY(mu_);
+};
+
+Status Minitar::Extract(std::string_view dest_dir, int flags, const ExtractOptions& options) {
   int r;
 
   // Declare the deferred closes up-front,
@@ -89,6 +213,15 @@ Status Minitar::Extract(std::string_view dest_dir, int flags) {
   r = archive_read_open_filename(a, file_.string().c_str(), 10240);
   PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
 
+  std::unique_ptr<ParallelWriter> writer;
+  if (options.num_writer_threads > 0) {
+    writer = std::make_unique<ParallelWriter>(options.num_writer_threads, flags);
+  }
+
+  // Hard links are written last, once the files they link to exist.
+  std::vector<struct archive_entry*> hard_links;
+  DEFER(for (struct archive_entry* entry : hard_links) { archive_entry_free(entry); });
+
   while (true) {
     struct archive_entry* entry;
     r = archive_read_next_header(a, &entry);
@@ -97,16 +230,45 @@ Status Minitar::Extract(std::string_view dest_dir, int flags) {
     }
     PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
 
+    if (options.filter && !options.filter(archive_entry_pathname(entry))) {
+      continue;
+    }
+
     if (!dest_dir.empty()) {
       std::string dest_path = absl::StrCat(dest_dir, "/", archive_entry_pathname(entry));
       archive_entry_set_pathname(entry, dest_path.c_str());
+      if (archive_entry_hardlink(entry) != nullptr) {
+        std::string dest_link = absl::StrCat(dest_dir, "/", archive_entry_hardlink(entry));
+        archive_entry_set_hardlink(entry, dest_link.c_str());
+      }
     }
 
+    if (writer != nullptr && archive_entry_hardlink(entry) != nullptr) {
+      hard_links.push_back(archive_entry_clone(entry));
+      continue;
+    }
+    if (writer != nullptr && archive_entry_filetype(entry) == AE_IFREG) {
+      std::string data;
+      PL_RETURN_IF_ERROR(ReadData(a, &data));
+      PL_RETURN_IF_ERROR(writer->Write(entry, std::move(data)));
+      continue;
+    }
+
+    // Directories and links are written from this thread. The times of the directories are only
+    // set when ext is closed, so the files written into them later don't change them.
     r = archive_write_header(ext, entry);
     PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
     PL_RETURN_IF_ERROR(CopyData(a, ext));
   }
 
+  if (writer != nullptr) {
+    PL_RETURN_IF_ERROR(writer->Finish());
+  }
+  for (struct archive_entry* entry : hard_links) {
+    r = archive_write_header(ext, entry);
+    PL_RETURN_IF_NOT_ARCHIVE_OK(r, ext);
+  }
+
   return Status::OK();
 }
 
@@ -21,13 +21,25 @@
 #include <archive.h>
 
 #include <filesystem>
+#include <functional>
 #include <string>
+#include <string_view>
 
 #include "src/common/base/base.h"
 
 namespace px {
 namespace tools {
 
+struct ExtractOptions {
+  // Only the entries whose path in the tarball passes the filter are extracted.
+  // All entries are extracted if it is not set.
+  std::function<bool(std::string_view path)> filter;
+
+  // The number of threads that write the regular files to disk, while the calling thread
+  // decompresses the tarball. If 0, the calling thread writes them as well.
+  int num_writer_threads = 0;
+};
+
 class Minitar {
  public:
   /**
@@ -45,12 +57,17 @@ class Minitar {
    * ARCHIVE_EXTRACT_TIME, ARCHIVE_EXTRACT_PERM, ARCHIVE_EXTRACT_ACL, ARCHIVE_EXTRACT_FFLAGS.
    * Multiple flags can be set through the or oeprator.
    * See libarchive for flag defintitions and other possible flags.
+   * @param options Selects the entries to extract and the number of threads to write them.
    * @return error if the tarball could not be extracted.
    */
-  Status Extract(std::string_view dest_dir = {}, int flags = kDefaultFlags);
+  Status Extract(std::string_view dest_dir = {}, int flags = kDefaultFlags,
+                 const ExtractOptions& options = {});
 
  private:
   static constexpr int kDefaultFlags = ARCHIVE_EXTRACT_TIME;
+
+  class ParallelWriter;
+
   struct archive* a;
   struct archive* ext;
 
@@ -18,6 +18,7 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 
 #include "src/common/base/base.h"
 #include "src/common/testing/testing.h"
@@ -59,3 +60,23 @@ TEST(Minitar, ExtractTo) {
       "identical\n";
   EXPECT_OK_AND_EQ(::px::Exec(diff_cmd), kExpectedDiffResult);
 }
+
+TEST(Minitar, ExtractFilteredWithWriterThreads) {
+  std::filesystem::path tarball = TestFilePath("src/common/minitar/testdata/a.tar.gz");
+  std::filesystem::path ref = TestFilePath("src/common/minitar/testdata/ref");
+
+  ::px::tools::ExtractOptions options;
+  options.filter = [](std::string_view path) { return path != "a/bar"; };
+  options.num_writer_threads = 2;
+
+  ::px::tools::Minitar minitar(tarball);
+  EXPECT_OK(minitar.Extract("src/common/minitar/testdata/filtered", ARCHIVE_EXTRACT_TIME, options));
+
+  std::string diff_cmd =
+      absl::Substitute("diff -rs src/common/minitar/testdata/filtered/a $0", ref.string());
+  const std::string kExpectedDiffResult =
+      "Only in src/common/minitar/testdata/ref: bar\n"
+      "Files src/common/minitar/testdata/filtered/a/foo and src/common/minitar/testdata/ref/foo "
+      "are identical\n";
+  EXPECT_OK_AND_EQ(::px::Exec(diff_cmd), kExpectedDiffResult);
+}
@@ -23,6 +23,8 @@
  */
 
 #include "src/common/perf/elapsed_timer.h"    // IWYU pragma: export
+#include "src/common/perf/pprof_server.h"     // IWYU pragma: export
+#include "src/common/perf/profile_tags.h"     // IWYU pragma: export
 #include "src/common/perf/profiler.h"         // IWYU pragma: export
 #include "src/common/perf/scoped_profiler.h"  // IWYU pragma: export
 #include "src/common/perf/scoped_timer.h"     // IWYU pragma: export
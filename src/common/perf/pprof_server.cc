@@ -0,0 +1,340 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/perf/pprof_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/debugging/symbolize.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+#include "src/common/perf/profile_tags.h"
+#include "src/common/perf/profiler.h"
+
+namespace px {
+namespace profiler {
+
+namespace {
+
+// Requests are small, except for the addresses posted to the symbol endpoint.
+constexpr size_t kMaxRequestSize = 4 * 1024 * 1024;
+constexpr int kDefaultProfileSeconds = 30;
+// How often the server checks whether it has been stopped.
+constexpr int kAcceptPollMillis = 100;
+// Clients that don't send their request in time are dropped, so that they don't hold up the server.
+constexpr int kReadTimeoutSeconds = 5;
+
+constexpr char kIndex[] =
+    "/debug/pprof/profile?seconds=<N>[&tag=<tag>[&label=<label>]]\n"
+    "/debug/pprof/heap\n"
+    "/debug/pprof/symbol\n"
+    "/debug/pprof/tags\n";
+
+struct TagFilter {
+  std::string tag;
+  std::string label;
+};
+
+int TagFilterFn(void* arg) {
+  const auto* filter = static_cast<const TagFilter*>(arg);
+  return ThreadHasProfileTag(filter->tag, filter->label) ? 1 : 0;
+}
+
+std::string_view StatusText(int code) {
+  switch (code) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+    case 409:
+      return "Conflict";
+    case 501:
+      return "Not Implemented";
+    default:
+      return "Internal Server Error";
+  }
+}
+
+bool WriteAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data.remove_prefix(n);
+  }
+  return true;
+}
+
+// Reads from the socket and appends to the buffer. Returns false when nothing could be read.
+bool ReadSome(int fd, std::string* buf) {
+  char chunk[16 * 1024];
+  ssize_t n;
+  do {
+    n = read(fd, chunk, sizeof(chunk));
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    return false;
+  }
+  buf->append(chunk, n);
+  return true;
+}
+
+std::string Symbolize(std::string_view addresses) {
+  if (addresses.empty()) {
+    // A GET of the endpoint checks whether symbolization is supported.
+    return "num_symbols: 1\n";
+  }
+  std::string out;
+  char symbol[1024];
+  for (std::string_view address : absl::StrSplit(addresses, '+', absl::SkipWhitespace())) {
+    std::string address_str(absl::StripAsciiWhitespace(address));
+    uint64_t pc = std::strtoull(address_str.c_str(), nullptr, 16);
+    if (absl::Symbolize(reinterpret_cast<void*>(pc), symbol, sizeof(symbol))) {
+      absl::StrAppend(&out, address_str, "\t", symbol, "\n");
+    }
+  }
+  return out;
+}
+
+std::string TagStats() {
+  std::string out = "tag\tcpu_seconds\tscopes\n";
+  for (const auto& [tag, stats] : GetProfileTagStats()) {
+    absl::StrAppend(&out, tag, "\t", absl::StrFormat("%.3f", stats.cpu_ns / 1e9), "\t",
+                    stats.num_scopes, "\n");
+  }
+  return out;
+}
+
+}  // namespace
+
+PProfServer::~PProfServer() { Stop(); }
+
+void PProfServer::RegisterHandler(std::string path, Handler handler) {
+  DCHECK(!thread_.joinable()) << "Handlers must be registered before the server is started.";
+  handlers_[std::move(path)] = std::move(handler);
+}
+
+Status PProfServer::Start(int port) {
+  if (listen_fd_ >= 0) {
+    return error::AlreadyExists("The pprof server is already started.");
+  }
+  int fd = socket(AF_INET, SOCK_STREAM, /* protocol */ 0);
+  if (fd < 0) {
+    return error::Internal("Failed to create the pprof server socket: $0", strerror(errno));
+  }
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), addr_len) != 0 ||
+      listen(fd, /* backlog */ 16) != 0 ||
+      getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) != 0) {
+    Status s = error::Internal("Failed to listen on port $0 for the pprof server: $1", port,
+                               strerror(errno));
+    close(fd);
+    return s;
+  }
+
+  listen_fd_ = fd;
+  port_ = ntohs(addr.sin_port);
+  thread_ = std::thread(&PProfServer::Run, this);
+  LOG(INFO) << absl::Substitute("Serving pprof profiles on 127.0.0.1:$0", port_);
+  return Status::OK();
+}
+
+void PProfServer::Stop() {
+  if (!stop_.HasBeenNotified()) {
+    stop_.Notify();
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+}
+
+void PProfServer::Run() {
+  while (!stop_.HasBeenNotified()) {
+    struct pollfd pfd = {listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, kAcceptPollMillis) <= 0) {
+      continue;
+    }
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    HandleConnection(fd);
+    close(fd);
+  }
+}
+
+void PProfServer::HandleConnection(int fd) {
+  struct timeval timeout = {kReadTimeoutSeconds, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  size_t header_end = std::string::npos;
+  while (header_end == std::string::npos) {
+    if (request.size() > kMaxRequestSize || !ReadSome(fd, &request)) {
+      return;
+    }
+    header_end = request.find("\r\n\r\n");
+  }
+
+  std::vector<std::string_view> lines =
+      absl::StrSplit(std::string_view(request).substr(0, header_end), "\r\n");
+  std::vector<std::string_view> request_line = absl::StrSplit(lines[0], ' ');
+  size_t content_length = 0;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    std::pair<std::string_view, std::string_view> header =
+        absl::StrSplit(lines[i], absl::MaxSplits(':', 1));
+    if (absl::EqualsIgnoreCase(header.first, "Content-Length") &&
+        !absl::SimpleAtoi(absl::StripAsciiWhitespace(header.second), &content_length)) {
+      content_length = 0;
+    }
+  }
+  content_length = std::min(content_length, kMaxRequestSize);
+  while (request.size() - header_end - 4 < content_length) {
+    if (!ReadSome(fd, &request)) {
+      return;
+    }
+  }
+  std::string_view body = std::string_view(request).substr(header_end + 4, content_length);
+
+  Response response;
+  if (request_line.size() < 2) {
+    response = {400, "text/plain", "Malformed request line.\n"};
+  } else if (request_line[0] != "GET" && request_line[0] != "POST") {
+    response = {405, "text/plain", "Only GET and POST are supported.\n"};
+  } else {
+    std::pair<std::string_view, std::string_view> target =
+        absl::StrSplit(request_line[1], absl::MaxSplits('?', 1));
+    Params params;
+    for (std::string_view param : absl::StrSplit(target.second, '&', absl::SkipEmpty())) {
+      std::pair<std::string, std::string> kv = absl::StrSplit(param, absl::MaxSplits('=', 1));
+      params.insert(std::move(kv));
+    }
+    response = HandleRequest(target.first, params, body);
+  }
+
+  std::string header = absl::Substitute(
+      "HTTP/1.0 $0 $1\r\nContent-Type: $2\r\nContent-Length: $3\r\nConnection: close\r\n\r\n",
+      response.code, StatusText(response.code), response.content_type, response.body.size());
+  if (WriteAll(fd, header)) {
+    WriteAll(fd, response.body);
+  }
+}
+
+PProfServer::Response PProfServer::HandleRequest(std::string_view path, const Params& params,
+                                                 std::string_view body) {
+  path = absl::StripSuffix(path, "/");
+  if (auto handler = handlers_.find(path); handler != handlers_.end()) {
+    return handler->second(params, body);
+  }
+  if (path == "/debug/pprof") {
+    return {200, "text/plain", kIndex};
+  }
+  if (path == "/debug/pprof/profile") {
+    return CPUProfile(params);
+  }
+  if (path == "/debug/pprof/heap") {
+    Response response = {200, "application/octet-stream", ""};
+    if (!Heap::Sample(&response.body)) {
+      return {501, "text/plain", "Heap profiles are not available in this build.\n"};
+    }
+    return response;
+  }
+  if (path == "/debug/pprof/symbol") {
+    return {200, "text/plain", Symbolize(body)};
+  }
+  if (path == "/debug/pprof/tags") {
+    return {200, "text/plain", TagStats()};
+  }
+  return {404, "text/plain", kIndex};
+}
+
+PProfServer::Response PProfServer::CPUProfile(const Params& params) {
+  int seconds = kDefaultProfileSeconds;
+  auto iter = params.find("seconds");
+  if (iter != params.end() && (!absl::SimpleAtoi(iter->second, &seconds) || seconds <= 0)) {
+    return {400, "text/plain", "seconds must be a positive integer.\n"};
+  }
+  seconds = std::min(seconds, kMaxProfileSeconds);
+
+  TagFilter filter;
+  if (auto tag = params.find("tag"); tag != params.end()) {
+    filter.tag = tag->second;
+  }
+  if (auto label = params.find("label"); label != params.end()) {
+    filter.label = label->second;
+  }
+
+  std::string path = (std::filesystem::temp_directory_path() /
+                      absl::StrCat("pl_pprof_cpu_", getpid(), ".prof"))
+                         .string();
+  bool started = CPU::ProfilerAvailable() && (filter.tag.empty()
+                                                  ? CPU::StartProfiler(path)
+                                                  : CPU::StartProfiler(path, &TagFilterFn, &filter));
+  if (!started) {
+    return {409, "text/plain",
+            "The CPU profiler is not available in this build, or is already running.\n"};
+  }
+  stop_.WaitForNotificationWithTimeout(absl::Seconds(seconds));
+  CPU::StopProfiler();
+
+  StatusOr<std::string> profile =
+      ReadFileToString(path, std::ios_base::in | std::ios_base::binary);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+  if (!profile.ok()) {
+    return {500, "text/plain", profile.msg() + "\n"};
+  }
+  return {200, "application/octet-stream", profile.ConsumeValueOrDie()};
+}
+
+}  // namespace profiler
+}  // namespace px
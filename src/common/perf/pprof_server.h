@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/notification.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace profiler {
+
+/**
+ * PProfServer serves the profiles of the process over HTTP, in the formats that the pprof tools
+ * fetch them:
+ *
+ *    /debug/pprof/profile?seconds=30  CPU profile. With &tag=<tag>[&label=<label>], only the
+ *                                     threads in a ScopedProfileTag of the tag are sampled.
+ *    /debug/pprof/heap                The sampled live heap allocations.
+ *    /debug/pprof/symbol              Symbolization of the addresses of the profiles.
+ *    /debug/pprof/tags                The CPU time used by each ScopedProfileTag.
+ *
+ * Other endpoints, such as metrics, can be registered with RegisterHandler().
+ *
+ * Requests are handled one at a time on the server's thread, so a CPU profile holds up the
+ * requests after it.
+ */
+class PProfServer : public NotCopyable {
+ public:
+  struct Response {
+    int code = 200;
+    std::string content_type = "text/plain";
+    std::string body;
+  };
+
+  using Params = absl::flat_hash_map<std::string, std::string>;
+  using Handler = std::function<Response(const Params& params, std::string_view body)>;
+
+  // The longest CPU profile that can be requested.
+  static constexpr int kMaxProfileSeconds = 300;
+
+  ~PProfServer();
+
+  /**
+   * Serves the path with the handler, which runs on the server's thread. Handlers must be
+   * registered before the server is started.
+   */
+  void RegisterHandler(std::string path, Handler handler);
+
+  /**
+   * Starts listening on the port of the loopback address, and serving requests.
+   * @param port The port to listen on, 0 picks any free port.
+   */
+  Status Start(int port);
+
+  /**
+   * Stops serving requests. An ongoing CPU profile is cut short.
+   */
+  void Stop();
+
+  /**
+   * @return The port that the server listens on, once started.
+   */
+  int port() const { return port_; }
+
+  /**
+   * Handles the request for the path, with its parsed query parameters and body.
+   */
+  Response HandleRequest(std::string_view path, const Params& params, std::string_view body);
+
+ private:
+  void Run();
+  void HandleConnection(int fd);
+
+  Response CPUProfile(const Params& params);
+
+  absl::flat_hash_map<std::string, Handler> handlers_;
+
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::thread thread_;
+  absl::Notification stop_;
+};
+
+}  // namespace profiler
+}  // namespace px
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "src/common/perf/pprof_server.h"
+#include "src/common/perf/profile_tags.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace profiler {
+
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
+
+// Sends the request to the server, and returns the whole response.
+std::string Fetch(int port, std::string_view request) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  EXPECT_EQ(0, connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+  EXPECT_EQ(static_cast<ssize_t>(request.size()), write(fd, request.data(), request.size()));
+
+  std::string response;
+  char buf[1024];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    response.append(buf, n);
+  }
+  close(fd);
+  return response;
+}
+
+class PProfServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_OK(server_.Start(/* port */ 0)); }
+
+  PProfServer server_;
+};
+
+TEST_F(PProfServerTest, ServesTags) {
+  { ScopedProfileTag tag("pprof_server_test"); }
+
+  std::string response = Fetch(server_.port(), "GET /debug/pprof/tags HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(response, StartsWith("HTTP/1.0 200 OK\r\n"));
+  EXPECT_THAT(response, HasSubstr("\r\n\r\ntag\tcpu_seconds\tscopes\n"));
+  EXPECT_THAT(response, HasSubstr("\npprof_server_test\t"));
+}
+
+TEST_F(PProfServerTest, ServesSymbols) {
+  EXPECT_THAT(Fetch(server_.port(), "GET /debug/pprof/symbol HTTP/1.1\r\n\r\n"),
+              HasSubstr("\r\n\r\nnum_symbols: 1\n"));
+
+  // Unknown addresses are left out.
+  EXPECT_THAT(
+      Fetch(server_.port(),
+            "POST /debug/pprof/symbol HTTP/1.1\r\nContent-Length: 3\r\n\r\n0x0"),
+      HasSubstr("Content-Length: 0\r\n"));
+}
+
+TEST_F(PProfServerTest, RejectsBadRequests) {
+  EXPECT_THAT(Fetch(server_.port(), "GET /unknown HTTP/1.1\r\n\r\n"),
+              StartsWith("HTTP/1.0 404 Not Found\r\n"));
+  EXPECT_THAT(Fetch(server_.port(), "DELETE /debug/pprof/tags HTTP/1.1\r\n\r\n"),
+              StartsWith("HTTP/1.0 405 Method Not Allowed\r\n"));
+  EXPECT_THAT(Fetch(server_.port(), "GET /debug/pprof/profile?seconds=-1 HTTP/1.1\r\n\r\n"),
+              StartsWith("HTTP/1.0 400 Bad Request\r\n"));
+}
+
+TEST(PProfServerHandlerTest, ServesRegisteredHandlers) {
+  PProfServer server;
+  server.RegisterHandler("/metrics", [](const PProfServer::Params& params, std::string_view) {
+    auto iter = params.find("name");
+    return PProfServer::Response{200, "text/plain", iter == params.end() ? "" : iter->second};
+  });
+  ASSERT_OK(server.Start(/* port */ 0));
+
+  EXPECT_THAT(Fetch(server.port(), "GET /metrics?name=foo HTTP/1.1\r\n\r\n"),
+              HasSubstr("\r\n\r\nfoo"));
+  EXPECT_THAT(Fetch(server.port(), "GET /debug/pprof/tags HTTP/1.1\r\n\r\n"),
+              StartsWith("HTTP/1.0 200 OK\r\n"));
+}
+
+TEST_F(PProfServerTest, StartTwice) { EXPECT_NOT_OK(server_.Start(/* port */ 0)); }
+
+}  // namespace profiler
+}  // namespace px
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/perf/profile_tags.h"
+
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace profiler {
+
+namespace {
+
+// Plain pointers, so that the profiling signal handler can read them without any initialization.
+thread_local const char* current_tag = nullptr;
+thread_local const std::string* current_label = nullptr;
+
+int64_t ThreadCPUTimeNS() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000 * 1000 * 1000LL + ts.tv_nsec;
+}
+
+class ProfileTagStatsRegistry {
+ public:
+  static ProfileTagStatsRegistry& Get() {
+    static auto* registry = new ProfileTagStatsRegistry();
+    return *registry;
+  }
+
+  void Add(const char* tag, int64_t cpu_ns) {
+    absl::MutexLock lock(&mutex_);
+    ProfileTagStats& stats = stats_[tag];
+    stats.cpu_ns += cpu_ns;
+    ++stats.num_scopes;
+  }
+
+  std::map<std::string, ProfileTagStats> Stats() const {
+    absl::MutexLock lock(&mutex_);
+    return std::map<std::string, ProfileTagStats>(stats_.begin(), stats_.end());
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, ProfileTagStats> stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+ScopedProfileTag::ScopedProfileTag(const char* tag, std::string label)
+    : prev_tag_(current_tag),
+      prev_label_(current_label),
+      tag_(tag),
+      label_(std::move(label)),
+      start_cpu_ns_(ThreadCPUTimeNS()) {
+  current_label = &label_;
+  current_tag = tag_;
+}
+
+ScopedProfileTag::~ScopedProfileTag() {
+  current_tag = prev_tag_;
+  current_label = prev_label_;
+  ProfileTagStatsRegistry::Get().Add(tag_, ThreadCPUTimeNS() - start_cpu_ns_);
+}
+
+std::map<std::string, ProfileTagStats> GetProfileTagStats() {
+  return ProfileTagStatsRegistry::Get().Stats();
+}
+
+bool ThreadHasProfileTag(std::string_view tag, std::string_view label) {
+  const char* thread_tag = current_tag;
+  if (thread_tag == nullptr || tag != thread_tag) {
+    return false;
+  }
+  return label.empty() || (current_label != nullptr && label == *current_label);
+}
+
+}  // namespace profiler
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace profiler {
+
+/**
+ * ScopedProfileTag attributes the work that the current thread does within the scope to a
+ * subsystem, such as the Stirling loop or the execution of a Carnot query.
+ *
+ * The CPU time of the scope is added to the stats of the tag, and CPU profiles can be restricted
+ * to the threads that are in a scope of a tag. Nested scopes count towards the stats of each of
+ * their tags, but CPU profile samples are only attributed to the innermost one.
+ *
+ * Usage:
+ *    ScopedProfileTag tag("carnot_query", query_id.str());
+ */
+class ScopedProfileTag : public NotCopyable {
+ public:
+  /**
+   * @param tag The name of the subsystem. It must outlive the scope, so string literals are
+   * expected.
+   * @param label An optional finer grained label, such as a query ID. It is only used to filter
+   * CPU profiles, so that labels with many values don't accumulate stats.
+   */
+  explicit ScopedProfileTag(const char* tag, std::string label = "");
+  ~ScopedProfileTag();
+
+ private:
+  const char* const prev_tag_;
+  const std::string* const prev_label_;
+  const char* const tag_;
+  const std::string label_;
+  const int64_t start_cpu_ns_;
+};
+
+struct ProfileTagStats {
+  // The CPU time used by the threads within the scopes of the tag.
+  int64_t cpu_ns = 0;
+  // The number of scopes of the tag that ended.
+  int64_t num_scopes = 0;
+};
+
+/**
+ * Returns the stats of each tag that has been used by the process, by tag name.
+ */
+std::map<std::string, ProfileTagStats> GetProfileTagStats();
+
+/**
+ * Returns whether the current thread is in a scope of the tag, and of the label if it isn't empty.
+ * This is async-signal-safe, so that it can be used to filter CPU profile samples.
+ */
+bool ThreadHasProfileTag(std::string_view tag, std::string_view label);
+
+}  // namespace profiler
+}  // namespace px
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <thread>
+
+#include "src/common/perf/profile_tags.h"
+
+namespace px {
+namespace profiler {
+
+TEST(ProfileTagsTest, ThreadHasTagWithinScope) {
+  EXPECT_FALSE(ThreadHasProfileTag("outer", ""));
+  {
+    ScopedProfileTag outer("outer");
+    EXPECT_TRUE(ThreadHasProfileTag("outer", ""));
+    EXPECT_FALSE(ThreadHasProfileTag("outer", "label"));
+    {
+      ScopedProfileTag inner("inner", "label");
+      EXPECT_FALSE(ThreadHasProfileTag("outer", ""));
+      EXPECT_TRUE(ThreadHasProfileTag("inner", ""));
+      EXPECT_TRUE(ThreadHasProfileTag("inner", "label"));
+      EXPECT_FALSE(ThreadHasProfileTag("inner", "other_label"));
+
+      // Tags are per thread.
+      std::thread([] { EXPECT_FALSE(ThreadHasProfileTag("inner", "")); }).join();
+    }
+    EXPECT_TRUE(ThreadHasProfileTag("outer", ""));
+  }
+  EXPECT_FALSE(ThreadHasProfileTag("outer", ""));
+}
+
+TEST(ProfileTagsTest, AccumulatesCPUTime) {
+  {
+    ScopedProfileTag tag("busy");
+    // Spin until the thread has used 20ms of CPU time.
+    auto start = std::clock();
+    while (std::clock() - start < CLOCKS_PER_SEC / 50) {
+    }
+  }
+  { ScopedProfileTag tag("busy"); }
+
+  auto stats = GetProfileTagStats();
+  ASSERT_EQ(1, stats.count("busy"));
+  EXPECT_EQ(2, stats["busy"].num_scopes);
+  EXPECT_GE(stats["busy"].cpu_ns, 20 * 1000 * 1000);
+}
+
+}  // namespace profiler
+}  // namespace px
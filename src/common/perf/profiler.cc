@@ -23,6 +23,7 @@
 #ifdef PROFILER_AVAILABLE
 
 #include "gperftools/heap-profiler.h"
+#include "gperftools/malloc_extension.h"
 #include "gperftools/profiler.h"
 
 namespace px {
@@ -34,6 +35,13 @@ bool CPU::StartProfiler(const std::string& output_path) {
   return ProfilerStart(output_path.c_str()) != 0;
 }
 
+bool CPU::StartProfiler(const std::string& output_path, int (*filter)(void*), void* filter_arg) {
+  ProfilerOptions options = {};
+  options.filter_in_thread = filter;
+  options.filter_in_thread_arg = filter_arg;
+  return ProfilerStartWithOptions(output_path.c_str(), &options) != 0;
+}
+
 void CPU::StopProfiler() { return ProfilerStop(); }
 
 bool Heap::ProfilerAvailable() { return true; }
@@ -62,6 +70,11 @@ bool Heap::StopProfiler() {
   return true;
 }
 
+bool Heap::Sample(std::string* out) {
+  MallocExtension::instance()->GetHeapSample(out);
+  return true;
+}
+
 void Heap::ForceLink() {
   // Currently this is here to force the inclusion of the heap profiler during static linking.
   // Without this call the heap profiler will not be included and cannot be started via env
@@ -79,12 +92,17 @@ namespace profiler {
 
 bool CPU::ProfilerAvailable() { return false; }
 bool CPU::StartProfiler(const std::string& /*output_path*/) { return false; }
+bool CPU::StartProfiler(const std::string& /*output_path*/, int (*/*filter*/)(void*),
+                        void* /*filter_arg*/) {
+  return false;
+}
 void CPU::StopProfiler() {}
 
 bool Heap::ProfilerAvailable() { return false; }
 bool Heap::IsProfilerStarted() { return false; }
 bool Heap::StartProfiler(const std::string& /*output_path*/) { return false; }
 bool Heap::StopProfiler() { return false; }
+bool Heap::Sample(std::string* /*out*/) { return false; }
 
 }  // namespace profiler
 }  // namespace px
@@ -44,6 +44,15 @@ class CPU {
    */
   static bool StartProfiler(const std::string& output_path);
 
+  /**
+   * Start profiler, but only sample the threads for which filter returns non-zero.
+   * The filter is called from the profiling signal handler of the sampled thread, so it must be
+   * async-signal-safe.
+   * @return bool whether the call to start the profiler succeeded.
+   */
+  static bool StartProfiler(const std::string& output_path, int (*filter)(void*),
+                            void* filter_arg);
+
   /**
    * Stop the profiler.
    */
@@ -87,6 +96,14 @@ class Heap {
    */
   static bool StopProfiler();
 
+  /**
+   * Get a profile of the sampled allocations that are currently live, in the legacy pprof heap
+   * format. Allocations are only sampled when TCMALLOC_SAMPLE_PARAMETER is set in the environment,
+   * which doesn't require the heap profiler to be started.
+   * @return bool whether a sample was written.
+   */
+  static bool Sample(std::string* out);
+
  private:
   static void ForceLink();
 };
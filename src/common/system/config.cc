@@ -56,6 +56,11 @@ class ConfigImpl final : public Config {
     return clock_converter_->Convert(monotonic_time);
   }
 
+  void ConvertBatchToRealTime(size_t count, const uint64_t* monotonic_times,
+                              uint64_t* out) const override {
+    clock_converter_->ConvertBatch(count, monotonic_times, out);
+  }
+
   const std::filesystem::path& sysfs_path() const override { return sysfs_path_; }
 
   const std::filesystem::path& host_path() const override { return host_path_; }
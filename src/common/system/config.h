@@ -74,6 +74,17 @@ class Config : public NotCopyable {
    */
   virtual uint64_t ConvertToRealTime(uint64_t monotonic_time) const = 0;
 
+  /**
+   * Converts count monotonic times to realtime at once, e.g. a whole time column.
+   * out may be the same array as monotonic_times.
+   */
+  virtual void ConvertBatchToRealTime(size_t count, const uint64_t* monotonic_times,
+                                      uint64_t* out) const {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = ConvertToRealTime(monotonic_times[i]);
+    }
+  }
+
   /**
    * Get the sysfs path.
    */
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/net_dev_stats.h"
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include "src/common/system/scoped_namespace.h"
+
+namespace px {
+namespace system {
+
+Status NetDevStatsProber::Connect() {
+  fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd_ < 0) {
+    return error::Internal("Could not create NETLINK_ROUTE connection. [errno=$0]", errno);
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<NetDevStatsProber>> NetDevStatsProber::Create() {
+  auto prober_ptr = std::unique_ptr<NetDevStatsProber>(new NetDevStatsProber);
+  PL_RETURN_IF_ERROR(prober_ptr->Connect());
+  return prober_ptr;
+}
+
+StatusOr<std::unique_ptr<NetDevStatsProber>> NetDevStatsProber::Create(int net_ns_pid) {
+  // Enter the network namespace of the provided pid. The namespace will automatically exit
+  // on termination of this scope, but the socket stays in it.
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<ScopedNamespace> scoped_namespace,
+                      ScopedNamespace::Create(net_ns_pid, "net"));
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<NetDevStatsProber> prober_ptr, Create());
+  return prober_ptr;
+}
+
+NetDevStatsProber::~NetDevStatsProber() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+Status NetDevStatsProber::SendGetLinkReq() {
+  struct {
+    struct nlmsghdr header;
+    struct ifinfomsg msg;
+  } req = {};
+  req.header.nlmsg_len = sizeof(req);
+  req.header.nlmsg_type = RTM_GETLINK;
+  req.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  req.header.nlmsg_seq = ++seq_;
+  req.msg.ifi_family = AF_UNSPEC;
+
+  struct sockaddr_nl nl_addr = {};
+  nl_addr.nl_family = AF_NETLINK;
+
+  ssize_t retval = sendto(fd_, &req, sizeof(req), 0, reinterpret_cast<struct sockaddr*>(&nl_addr),
+                          sizeof(nl_addr));
+  if (retval != sizeof(req)) {
+    return error::Internal("Failed to send NetLink messages [errno=$0]", errno);
+  }
+  return Status::OK();
+}
+
+namespace {
+
+// Accumulates the stats of one device, the same way /proc/<pid>/net/dev presents them.
+void AccumulateLinkStats(const struct rtnl_link_stats64& link_stats,
+                         ProcParser::NetworkStats* out) {
+  out->rx_bytes += link_stats.rx_bytes;
+  out->rx_packets += link_stats.rx_packets;
+  out->rx_errs += link_stats.rx_errors;
+  out->rx_drops += link_stats.rx_dropped + link_stats.rx_missed_errors;
+
+  out->tx_bytes += link_stats.tx_bytes;
+  out->tx_packets += link_stats.tx_packets;
+  out->tx_errs += link_stats.tx_errors;
+  out->tx_drops += link_stats.tx_dropped;
+}
+
+void ProcessLinkMsg(const struct nlmsghdr& msg_header, ProcParser::NetworkStats* out) {
+  if (msg_header.nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+    return;
+  }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  const auto* link_msg = reinterpret_cast<const struct ifinfomsg*>(NLMSG_DATA(&msg_header));
+  unsigned int rta_len = msg_header.nlmsg_len - NLMSG_LENGTH(sizeof(*link_msg));
+
+  std::string_view ifname;
+  const struct rtnl_link_stats64* link_stats = nullptr;
+  for (const struct rtattr* attr = IFLA_RTA(link_msg); RTA_OK(attr, rta_len);
+       attr = RTA_NEXT(attr, rta_len)) {
+    switch (attr->rta_type) {
+      case IFLA_IFNAME:
+        ifname = std::string_view(reinterpret_cast<const char*>(RTA_DATA(attr)));
+        break;
+      case IFLA_STATS64:
+        if (RTA_PAYLOAD(attr) >= sizeof(struct rtnl_link_stats64)) {
+          link_stats = reinterpret_cast<const struct rtnl_link_stats64*>(RTA_DATA(attr));
+        }
+        break;
+    }
+  }
+#pragma GCC diagnostic pop
+
+  if (link_stats == nullptr || !ShouldIncludeNetIFace(ifname)) {
+    return;
+  }
+  // The attribute isn't necessarily 8-byte aligned.
+  struct rtnl_link_stats64 aligned_stats;
+  std::memcpy(&aligned_stats, link_stats, sizeof(aligned_stats));
+  AccumulateLinkStats(aligned_stats, out);
+}
+
+}  // namespace
+
+Status NetDevStatsProber::RecvGetLinkResp(ProcParser::NetworkStats* out) {
+  // The link messages carry a lot of attributes, so use a buffer that holds several of them.
+  static constexpr int kBufSize = 32768;
+  alignas(struct nlmsghdr) uint8_t buf[kBufSize];
+
+  bool done = false;
+  while (!done) {
+    ssize_t num_bytes = recv(fd_, &buf, sizeof(buf), 0);
+    if (num_bytes < 0) {
+      return error::Internal("Receive call failed [errno=$0]", errno);
+    }
+
+    struct nlmsghdr* msg_header = reinterpret_cast<struct nlmsghdr*>(buf);
+
+    for (; NLMSG_OK(msg_header, num_bytes); msg_header = NLMSG_NEXT(msg_header, num_bytes)) {
+      if (msg_header->nlmsg_seq != seq_) {
+        // A response to an earlier request that was abandoned after an error.
+        continue;
+      }
+
+      if (msg_header->nlmsg_type == NLMSG_DONE) {
+        done = true;
+        break;
+      }
+
+      if (msg_header->nlmsg_type == NLMSG_ERROR) {
+        return error::Internal("Netlink error");
+      }
+
+      if (msg_header->nlmsg_type != RTM_NEWLINK) {
+        return error::Internal("Unexpected message type");
+      }
+
+      ProcessLinkMsg(*msg_header, out);
+    }
+  }
+
+  return Status::OK();
+}
+
+Status NetDevStatsProber::NetworkStats(ProcParser::NetworkStats* out) {
+  DCHECK(out != nullptr);
+  PL_RETURN_IF_ERROR(SendGetLinkReq());
+  return RecvGetLinkResp(out);
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "src/common/base/base.h"
+#include "src/common/system/proc_parser.h"
+
+namespace px {
+namespace system {
+
+/**
+ * NetDevStatsProber uses a NETLINK_ROUTE socket to read the stats of all the network devices of a
+ * network namespace with a single RTM_GETLINK dump. It produces the same stats as
+ * ProcParser::ParseProcPIDNetDev(), without opening and parsing /proc/<pid>/net/dev.
+ *
+ * The socket stays bound to the namespace it was created in, so a prober can be reused across
+ * reads without entering the namespace again.
+ */
+class NetDevStatsProber {
+ public:
+  /**
+   * Create a prober within the current network namespace.
+   */
+  static StatusOr<std::unique_ptr<NetDevStatsProber>> Create();
+
+  /**
+   * Create a prober within the network namespace of the provided PID.
+   * Note that this requires superuser privileges.
+   *
+   * @param net_ns_pid PID from which the network namespace is used.
+   */
+  static StatusOr<std::unique_ptr<NetDevStatsProber>> Create(int net_ns_pid);
+
+  ~NetDevStatsProber();
+
+  /**
+   * Accumulates the stats of the network devices of the namespace into the output.
+   * Only the devices that ProcParser::ParseProcPIDNetDev() would include are accumulated.
+   *
+   * @param out A valid pointer to an output struct.
+   * @return error if the stats could not be obtained from the kernel.
+   */
+  Status NetworkStats(ProcParser::NetworkStats* out);
+
+ private:
+  NetDevStatsProber() = default;
+
+  Status Connect();
+  Status SendGetLinkReq();
+  Status RecvGetLinkResp(ProcParser::NetworkStats* out);
+
+  int fd_ = -1;
+  uint32_t seq_ = 0;
+};
+
+}  // namespace system
+}  // namespace px
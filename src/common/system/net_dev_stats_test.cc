@@ -0,0 +1,52 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <unistd.h>
+
+#include "src/common/system/config.h"
+#include "src/common/system/net_dev_stats.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+TEST(NetDevStatsProberTest, MatchesProcNetDev) {
+  ProcParser parser(system::Config::GetInstance());
+
+  ProcParser::NetworkStats proc_stats;
+  ASSERT_OK(parser.ParseProcPIDNetDev(getpid(), &proc_stats));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetDevStatsProber> prober, NetDevStatsProber::Create());
+  ProcParser::NetworkStats netlink_stats;
+  ASSERT_OK(prober->NetworkStats(&netlink_stats));
+
+  // The counters only grow, and the same devices are included by both.
+  EXPECT_GE(netlink_stats.rx_bytes, proc_stats.rx_bytes);
+  EXPECT_GE(netlink_stats.rx_packets, proc_stats.rx_packets);
+  EXPECT_GE(netlink_stats.tx_bytes, proc_stats.tx_bytes);
+  EXPECT_GE(netlink_stats.tx_packets, proc_stats.tx_packets);
+
+  // The prober can be reused, and the stats are accumulated into the output.
+  ProcParser::NetworkStats accumulated_stats = netlink_stats;
+  ASSERT_OK(prober->NetworkStats(&accumulated_stats));
+  EXPECT_GE(accumulated_stats.rx_bytes, 2 * netlink_stats.rx_bytes);
+  EXPECT_GE(accumulated_stats.tx_bytes, 2 * netlink_stats.tx_bytes);
+}
+
+}  // namespace system
+}  // namespace px
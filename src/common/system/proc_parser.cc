@@ -16,6 +16,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <string>
@@ -25,6 +29,9 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
 #include <absl/strings/substitute.h>
 
 #include "src/common/fs/fs_wrapper.h"
@@ -225,46 +232,177 @@ Status ProcParser::ParseProcPIDStat(int32_t pid, ProcessStats* out) const {
   }
 
   std::string line;
-  bool ok = true;
-  if (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-    // We check less than in case more fields are added later.
-    if (split.size() < kProcStatNumFields) {
-      return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatPIDField], &out->pid);
-    // The name is surrounded by () we remove it here.
-    const std::string_view& name_field = split[kProcStatProcessNameField];
-    if (name_field.length() > 2) {
-      out->process_name = std::string(name_field.substr(1, name_field.size() - 2));
-    } else {
-      ok = false;
+  if (!std::getline(ifs, line)) {
+    return error::Internal("Failed to read proc stat file: $0", fpath);
+  }
+  return ParseProcPIDStatLine(line, fpath, out);
+}
+
+namespace {
+
+// Parses a decimal integer with an optional sign, which makes up all of the field. It's simpler
+// than absl::SimpleAtoi, which is what makes it faster on the many fields of the proc files.
+template <typename T>
+bool ScanInt(std::string_view field, T* out) {
+  const bool negative = !field.empty() && field.front() == '-';
+  if (negative) {
+    field.remove_prefix(1);
+  }
+  if (field.empty()) {
+    return false;
+  }
+  uint64_t val = 0;
+  for (char c : field) {
+    if (c < '0' || c > '9') {
+      return false;
     }
-    ok &= absl::SimpleAtoi(split[kProcStatMinorFaultsField], &out->minor_faults);
-    ok &= absl::SimpleAtoi(split[kProcStatMajorFaultsField], &out->major_faults);
+    val = val * 10 + (c - '0');
+  }
+  *out = static_cast<T>(negative ? 0 - val : val);
+  return true;
+}
 
-    ok &= absl::SimpleAtoi(split[kProcStatUTimeField], &out->utime_ns);
-    ok &= absl::SimpleAtoi(split[kProcStatKTimeField], &out->ktime_ns);
-    // The kernel tracks utime and ktime in kernel ticks.
-    out->utime_ns *= ns_per_kernel_tick_;
-    out->ktime_ns *= ns_per_kernel_tick_;
+}  // namespace
 
-    ok &= absl::SimpleAtoi(split[kProcStatNumThreadsField], &out->num_threads);
-    ok &= absl::SimpleAtoi(split[kProcStatVSizeField], &out->vsize_bytes);
-    ok &= absl::SimpleAtoi(std::string(split[kProcStatRSSField]), &out->rss_bytes);
+Status ProcParser::ParseProcPIDStatLine(std::string_view line, std::string_view fpath,
+                                        ProcessStats* out) const {
+  // The name is surrounded by (). It can contain spaces and parentheses itself, so it ends at the
+  // last ')' of the line.
+  const size_t name_begin = line.find('(');
+  const size_t name_end = line.rfind(')');
+  if (name_begin == std::string_view::npos || name_end == std::string_view::npos ||
+      name_end < name_begin) {
+    return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
+  }
 
-    // RSS is in pages.
-    out->rss_bytes *= bytes_per_page_;
+  bool ok = name_end > name_begin + 1;
+  ok &= ScanInt(absl::StripTrailingAsciiWhitespace(line.substr(0, name_begin)), &out->pid);
+  out->process_name.assign(line.data() + name_begin + 1, name_end - name_begin - 1);
 
-  } else {
-    return error::Internal("Failed to read proc stat file: $0", fpath);
+  int field_idx = kProcStatProcessNameField + 1;
+  std::string_view fields = line.substr(name_end + 1);
+  size_t pos = 0;
+  while (pos < fields.size()) {
+    if (fields[pos] == ' ' || fields[pos] == '\n') {
+      ++pos;
+      continue;
+    }
+    size_t end = std::min(fields.find_first_of(" \n", pos), fields.size());
+    std::string_view field = fields.substr(pos, end - pos);
+    switch (field_idx) {
+      case kProcStatMinorFaultsField:
+        ok &= ScanInt(field, &out->minor_faults);
+        break;
+      case kProcStatMajorFaultsField:
+        ok &= ScanInt(field, &out->major_faults);
+        break;
+      case kProcStatUTimeField:
+        ok &= ScanInt(field, &out->utime_ns);
+        break;
+      case kProcStatKTimeField:
+        ok &= ScanInt(field, &out->ktime_ns);
+        break;
+      case kProcStatNumThreadsField:
+        ok &= ScanInt(field, &out->num_threads);
+        break;
+      case kProcStatVSizeField:
+        ok &= ScanInt(field, &out->vsize_bytes);
+        break;
+      case kProcStatRSSField:
+        ok &= ScanInt(field, &out->rss_bytes);
+        break;
+      default:
+        break;
+    }
+    ++field_idx;
+    pos = end;
   }
 
+  // We check less than in case more fields are added later.
+  if (field_idx < kProcStatNumFields) {
+    return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
+  }
   if (!ok) {
     // This should never happen since it requires the file to be ill-formed
     // by the kernel.
     return error::Internal("failed to parse stat file ($0). ATOI failed.", fpath);
   }
+
+  // The kernel tracks utime and ktime in kernel ticks.
+  out->utime_ns *= ns_per_kernel_tick_;
+  out->ktime_ns *= ns_per_kernel_tick_;
+  // RSS is in pages.
+  out->rss_bytes *= bytes_per_page_;
+  return Status::OK();
+}
+
+StatusOr<std::string_view> ProcParser::ProcessStatsReader::ReadPIDFile(int32_t pid,
+                                                                      std::string_view file) {
+  path_.clear();
+  absl::StrAppend(&path_, parser_->proc_base_path_, "/", pid, "/", file);
+
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open file $0", path_);
+  }
+  size_t size = 0;
+  while (size < kBufSize) {
+    ssize_t n = read(fd, buf_ + size, kBufSize - size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      close(fd);
+      return error::Internal("Failed to read file $0", path_);
+    }
+    if (n == 0) {
+      break;
+    }
+    size += n;
+  }
+  close(fd);
+  if (size == kBufSize) {
+    return error::Internal("File $0 doesn't fit in the read buffer", path_);
+  }
+  return std::string_view(buf_, size);
+}
+
+Status ProcParser::ProcessStatsReader::ReadPIDStat(int32_t pid, ProcessStats* out) {
+  DCHECK(out != nullptr);
+  PL_ASSIGN_OR_RETURN(std::string_view content, ReadPIDFile(pid, "stat"));
+  if (content.empty()) {
+    return error::Internal("Failed to read proc stat file: $0", path_);
+  }
+  return parser_->ParseProcPIDStatLine(content, path_, out);
+}
+
+Status ProcParser::ProcessStatsReader::ReadPIDStatIO(int32_t pid, ProcessStats* out) {
+  DCHECK(out != nullptr);
+  static constexpr std::pair<std::string_view, int64_t ProcessStats::*> kIOFields[] = {
+      {"rchar", &ProcessStats::rchar_bytes},
+      {"wchar", &ProcessStats::wchar_bytes},
+      {"read_bytes", &ProcessStats::read_bytes},
+      {"write_bytes", &ProcessStats::write_bytes},
+  };
+
+  PL_ASSIGN_OR_RETURN(std::string_view content, ReadPIDFile(pid, "io"));
+  bool ok = true;
+  for (std::string_view line : absl::StrSplit(content, '\n', absl::SkipEmpty())) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    std::string_view key = line.substr(0, colon);
+    for (const auto& [name, field] : kIOFields) {
+      if (key == name) {
+        ok &= ScanInt(absl::StripAsciiWhitespace(line.substr(colon + 1)), &(out->*field));
+        break;
+      }
+    }
+  }
+  if (!ok) {
+    return error::Internal("failed to parse io file ($0).", path_);
+  }
   return Status::OK();
 }
 
@@ -22,6 +22,7 @@
 #include <istream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -153,6 +154,43 @@ class ProcParser {
    */
   Status ParseProcPIDStatIO(int32_t pid, ProcessStats* out) const;
 
+  /**
+   * ProcessStatsReader parses the same stats as ParseProcPIDStat and ParseProcPIDStatIO, for
+   * callers that read them for many processes at a time. It reads the files into a buffer that it
+   * reuses, and scans the fields in place instead of splitting them into strings, so it doesn't
+   * allocate for each process.
+   *
+   * It isn't thread-safe, since all of the reads share the buffer.
+   */
+  class ProcessStatsReader {
+   public:
+    /**
+     * @param parser The parser whose config to use. Must outlive the reader.
+     */
+    explicit ProcessStatsReader(const ProcParser* parser) : parser_(parser) {}
+
+    /**
+     * Parses /proc/<pid>/stat into the stat fields of out.
+     */
+    Status ReadPIDStat(int32_t pid, ProcessStats* out);
+
+    /**
+     * Parses /proc/<pid>/io into the IO fields of out.
+     */
+    Status ReadPIDStatIO(int32_t pid, ProcessStats* out);
+
+   private:
+    // Reads /proc/<pid>/<file> into buf_, and returns its contents.
+    StatusOr<std::string_view> ReadPIDFile(int32_t pid, std::string_view file);
+
+    // The stat file is a single line of about a thousand bytes, and the io file is shorter.
+    static constexpr size_t kBufSize = 4096;
+
+    const ProcParser* parser_;
+    std::string path_;
+    char buf_[kBufSize];
+  };
+
   /**
    * Parses /proc/<pid>/net/dev
    *
@@ -272,6 +310,10 @@ class ProcParser {
 
   std::filesystem::path ProcPidPath(pid_t pid) const;
 
+  // Parses the contents of a /proc/<pid>/stat file, read from fpath.
+  Status ParseProcPIDStatLine(std::string_view line, std::string_view fpath,
+                              ProcessStats* out) const;
+
   int64_t ns_per_kernel_tick_;
   int32_t bytes_per_page_;
 
@@ -280,5 +322,11 @@ class ProcParser {
 
 StatusOr<int64_t> GetPIDStartTimeTicks(const std::filesystem::path& proc_pid_path);
 
+/**
+ * Returns true if the stats of the network interface are included in the network stats of a
+ * process, e.g. ethernet and wireless interfaces, but not virtual, docker and lo interfaces.
+ */
+bool ShouldIncludeNetIFace(std::string_view iface);
+
 }  // namespace system
 }  // namespace px
@@ -116,6 +116,46 @@ TEST_F(ProcParserTest, ParsePidStat) {
   EXPECT_EQ(2577 * bytes_per_page_, stats.rss_bytes);
 }
 
+TEST_F(ProcParserTest, ParsePidStatNameWithSpaces) {
+  ProcParser::ProcessStats stats;
+  PL_CHECK_OK(parser_->ParseProcPIDStat(321, &stats));
+  EXPECT_EQ(2211, stats.pid);
+  EXPECT_EQ("Web Content (2)", stats.process_name);
+  EXPECT_EQ(31, stats.num_threads);
+  EXPECT_EQ(100 * bytes_per_page_, stats.rss_bytes);
+}
+
+TEST_F(ProcParserTest, ProcessStatsReader) {
+  ProcParser::ProcessStatsReader reader(parser_.get());
+
+  // The reader parses the same stats as the parser, and keeps working when reused.
+  for (int32_t pid : {123, 321, 123}) {
+    ProcParser::ProcessStats expected;
+    ProcParser::ProcessStats stats;
+    PL_CHECK_OK(parser_->ParseProcPIDStat(pid, &expected));
+    ASSERT_OK(reader.ReadPIDStat(pid, &stats));
+    EXPECT_EQ(expected.pid, stats.pid);
+    EXPECT_EQ(expected.process_name, stats.process_name);
+    EXPECT_EQ(expected.utime_ns, stats.utime_ns);
+    EXPECT_EQ(expected.ktime_ns, stats.ktime_ns);
+    EXPECT_EQ(expected.num_threads, stats.num_threads);
+    EXPECT_EQ(expected.major_faults, stats.major_faults);
+    EXPECT_EQ(expected.minor_faults, stats.minor_faults);
+    EXPECT_EQ(expected.vsize_bytes, stats.vsize_bytes);
+    EXPECT_EQ(expected.rss_bytes, stats.rss_bytes);
+  }
+
+  ProcParser::ProcessStats stats;
+  ASSERT_OK(reader.ReadPIDStatIO(123, &stats));
+  EXPECT_EQ(5405203, stats.rchar_bytes);
+  EXPECT_EQ(1239158, stats.wchar_bytes);
+  EXPECT_EQ(17838080, stats.read_bytes);
+  EXPECT_EQ(634880, stats.write_bytes);
+
+  EXPECT_NOT_OK(reader.ReadPIDStat(999, &stats));
+  EXPECT_NOT_OK(reader.ReadPIDStatIO(321, &stats));
+}
+
 TEST_F(ProcParserTest, ParseStat) {
   ProcParser::SystemStats stats;
   PL_CHECK_OK(parser_->ParseProcStat(&stats));
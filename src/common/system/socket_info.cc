@@ -33,7 +33,9 @@
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_set.h>
 
@@ -78,19 +80,21 @@ NetlinkSocketProber::~NetlinkSocketProber() {
 }
 
 template <typename TDiagReqType>
-Status NetlinkSocketProber::SendDiagReq(const TDiagReqType& msg_req) {
-  ssize_t msg_len = sizeof(struct nlmsghdr) + sizeof(TDiagReqType);
+Status NetlinkSocketProber::SendDiagReq(const TDiagReqType& msg_req, std::string_view attrs) {
+  ssize_t msg_len = sizeof(struct nlmsghdr) + sizeof(TDiagReqType) + attrs.size();
 
   struct nlmsghdr msg_header = {};
   msg_header.nlmsg_len = msg_len;
   msg_header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
   msg_header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
 
-  struct iovec iov[2];
+  struct iovec iov[3];
   iov[0].iov_base = &msg_header;
   iov[0].iov_len = sizeof(msg_header);
   iov[1].iov_base = const_cast<TDiagReqType*>(&msg_req);
   iov[1].iov_len = sizeof(msg_req);
+  iov[2].iov_base = const_cast<char*>(attrs.data());
+  iov[2].iov_len = attrs.size();
 
   struct sockaddr_nl nl_addr = {};
   nl_addr.nl_family = AF_NETLINK;
@@ -99,7 +103,7 @@ Status NetlinkSocketProber::SendDiagReq(const TDiagReqType& msg_req) {
   msg.msg_name = &nl_addr;
   msg.msg_namelen = sizeof(nl_addr);
   msg.msg_iov = iov;
-  msg.msg_iovlen = 2;
+  msg.msg_iovlen = attrs.empty() ? 2 : 3;
 
   ssize_t bytes_sent = 0;
 
@@ -117,7 +121,8 @@ Status NetlinkSocketProber::SendDiagReq(const TDiagReqType& msg_req) {
 namespace {
 
 Status ProcessDiagMsg(const struct inet_diag_msg& diag_msg, unsigned int len,
-                      std::map<int, SocketInfo>* socket_info_entries) {
+                      const absl::flat_hash_set<uint32_t>& inodes,
+                      SocketInfoEntries* socket_info_entries) {
   if (len < NLMSG_LENGTH(sizeof(diag_msg))) {
     return error::Internal("Not enough bytes");
   }
@@ -136,6 +141,11 @@ Status ProcessDiagMsg(const struct inet_diag_msg& diag_msg, unsigned int len,
     return Status::OK();
   }
 
+  if (!inodes.empty() && !inodes.contains(diag_msg.idiag_inode) &&
+      diag_msg.idiag_state != static_cast<uint8_t>(TCPConnState::kListening)) {
+    return Status::OK();
+  }
+
   auto iter = socket_info_entries->find(diag_msg.idiag_inode);
   ECHECK(iter == socket_info_entries->end())
       << absl::Substitute("Clobbering socket info at inode=$0", diag_msg.idiag_inode);
@@ -160,7 +170,8 @@ Status ProcessDiagMsg(const struct inet_diag_msg& diag_msg, unsigned int len,
 }
 
 Status ProcessDiagMsg(const struct unix_diag_msg& diag_msg, unsigned int len,
-                      std::map<int, SocketInfo>* socket_info_entries) {
+                      const absl::flat_hash_set<uint32_t>& inodes,
+                      SocketInfoEntries* socket_info_entries) {
   if (len < NLMSG_LENGTH(sizeof(diag_msg))) {
     return error::Internal("Not enough bytes");
   }
@@ -190,6 +201,10 @@ Status ProcessDiagMsg(const struct unix_diag_msg& diag_msg, unsigned int len,
     }
   }
 
+  if (!inodes.empty() && !inodes.contains(diag_msg.udiag_ino)) {
+    return Status::OK();
+  }
+
   auto iter = socket_info_entries->find(diag_msg.udiag_ino);
   ECHECK(iter == socket_info_entries->end())
       << absl::Substitute("Clobbering socket info at inode=$0", diag_msg.udiag_ino);
@@ -211,7 +226,8 @@ Status ProcessDiagMsg(const struct unix_diag_msg& diag_msg, unsigned int len,
 }  // namespace
 
 template <typename TDiagMsgType>
-Status NetlinkSocketProber::RecvDiagResp(std::map<int, SocketInfo>* socket_info_entries) {
+Status NetlinkSocketProber::RecvDiagResp(SocketInfoEntries* socket_info_entries,
+                                         const absl::flat_hash_set<uint32_t>& inodes) {
   static constexpr int kBufSize = 8192;
   uint8_t buf[kBufSize];
 
@@ -242,7 +258,8 @@ Status NetlinkSocketProber::RecvDiagResp(std::map<int, SocketInfo>* socket_info_
 #pragma GCC diagnostic ignored "-Wold-style-cast"
       TDiagMsgType* diag_msg = reinterpret_cast<TDiagMsgType*>(NLMSG_DATA(msg_header));
 #pragma GCC diagnostic pop
-      PL_RETURN_IF_ERROR(ProcessDiagMsg(*diag_msg, msg_header->nlmsg_len, socket_info_entries));
+      PL_RETURN_IF_ERROR(
+          ProcessDiagMsg(*diag_msg, msg_header->nlmsg_len, inodes, socket_info_entries));
     }
   }
 
@@ -250,7 +267,46 @@ Status NetlinkSocketProber::RecvDiagResp(std::map<int, SocketInfo>* socket_info_
 }
 
 namespace {
-void ClassifySocketRoles(std::map<int, SocketInfo>* socket_info_entries) {
+
+// Returns an INET_DIAG_REQ_BYTECODE attribute with a program that accepts the sockets with any of
+// the local ports. The kernel only accepts a socket if the program jumps exactly to its end.
+// Each port but the last is matched by:
+//   S_GE port (false: next port), S_LE port (false: next port), JMP (to the end).
+// A JMP op always takes its `no` branch at runtime. Its `yes` branch points to the next op, so that
+// the kernel's validation, which follows the `yes` branches, sees all of the ops.
+// The last port is matched without the JMP, so a failed match jumps past the end, i.e. rejects.
+std::string InetDiagLocalPortsFilter(const std::vector<uint16_t>& ports) {
+  constexpr int kOpSize = sizeof(struct inet_diag_bc_op);
+  // S_GE and S_LE are followed by an op whose `no` field holds the port.
+  constexpr int kCmpSize = 2 * kOpSize;
+
+  const int bc_len = static_cast<int>(ports.size()) * (2 * kCmpSize + kOpSize) - kOpSize;
+  std::vector<struct inet_diag_bc_op> ops;
+  ops.reserve(bc_len / kOpSize);
+  for (size_t i = 0; i < ports.size(); ++i) {
+    const bool last = (i == ports.size() - 1);
+    // Jump targets are relative to the op. A failed match jumps to the ops of the next port.
+    ops.push_back({INET_DIAG_BC_S_GE, kCmpSize, 2 * kCmpSize + kOpSize});
+    ops.push_back({0, 0, ports[i]});
+    ops.push_back({INET_DIAG_BC_S_LE, kCmpSize, kCmpSize + kOpSize});
+    ops.push_back({0, 0, ports[i]});
+    if (!last) {
+      const uint16_t to_end = bc_len - static_cast<int>(ops.size()) * kOpSize;
+      ops.push_back({INET_DIAG_BC_JMP, kOpSize, to_end});
+    }
+  }
+  DCHECK_EQ(static_cast<int>(ops.size()) * kOpSize, bc_len);
+
+  struct rtattr attr = {};
+  attr.rta_type = INET_DIAG_REQ_BYTECODE;
+  attr.rta_len = RTA_LENGTH(bc_len);
+  std::string buf(RTA_SPACE(bc_len), '\0');
+  memcpy(buf.data(), &attr, sizeof(attr));
+  memcpy(buf.data() + RTA_LENGTH(0), ops.data(), bc_len);
+  return buf;
+}
+
+void ClassifySocketRoles(SocketInfoEntries* socket_info_entries) {
   absl::flat_hash_set<SockAddrIPv4, SockAddrIPv4HashFn, SockAddrIPv4EqFn> ipv4_listening_sockets;
   absl::flat_hash_set<SockAddrIPv6, SockAddrIPv6HashFn, SockAddrIPv6EqFn> ipv6_listening_sockets;
 
@@ -302,21 +358,26 @@ void ClassifySocketRoles(std::map<int, SocketInfo>* socket_info_entries) {
 }
 }  // namespace
 
-Status NetlinkSocketProber::InetConnections(std::map<int, SocketInfo>* socket_info_entries,
-                                            int conn_states) {
+Status NetlinkSocketProber::InetConnections(SocketInfoEntries* socket_info_entries,
+                                            int conn_states, const InetConnFilter& filter) {
   struct inet_diag_req_v2 msg_req = {};
   msg_req.sdiag_protocol = IPPROTO_TCP;
   msg_req.idiag_states = conn_states;
 
+  std::string attrs;
+  if (!filter.local_ports.empty()) {
+    attrs = InetDiagLocalPortsFilter(filter.local_ports);
+  }
+
   // Run once for IPv4.
   msg_req.sdiag_family = AF_INET;
-  PL_RETURN_IF_ERROR(SendDiagReq(msg_req));
-  PL_RETURN_IF_ERROR(RecvDiagResp<struct inet_diag_msg>(socket_info_entries));
+  PL_RETURN_IF_ERROR(SendDiagReq(msg_req, attrs));
+  PL_RETURN_IF_ERROR(RecvDiagResp<struct inet_diag_msg>(socket_info_entries, filter.inodes));
 
   // Run again for IPv6.
   msg_req.sdiag_family = AF_INET6;
-  PL_RETURN_IF_ERROR(SendDiagReq(msg_req));
-  PL_RETURN_IF_ERROR(RecvDiagResp<struct inet_diag_msg>(socket_info_entries));
+  PL_RETURN_IF_ERROR(SendDiagReq(msg_req, attrs));
+  PL_RETURN_IF_ERROR(RecvDiagResp<struct inet_diag_msg>(socket_info_entries, filter.inodes));
 
   // If Listening connections were queried, then also populate the role field of the connections.
   if (conn_states & kTCPListeningState) {
@@ -326,7 +387,7 @@ Status NetlinkSocketProber::InetConnections(std::map<int, SocketInfo>* socket_in
   return Status::OK();
 }
 
-Status NetlinkSocketProber::UnixConnections(std::map<int, SocketInfo>* socket_info_entries,
+Status NetlinkSocketProber::UnixConnections(SocketInfoEntries* socket_info_entries,
                                             int conn_states) {
   struct unix_diag_req msg_req = {};
   msg_req.sdiag_family = AF_UNIX;
@@ -334,7 +395,7 @@ Status NetlinkSocketProber::UnixConnections(std::map<int, SocketInfo>* socket_in
   msg_req.udiag_show = UDIAG_SHOW_PEER;
 
   PL_RETURN_IF_ERROR(SendDiagReq(msg_req));
-  PL_RETURN_IF_ERROR(RecvDiagResp<struct unix_diag_msg>(socket_info_entries));
+  PL_RETURN_IF_ERROR(RecvDiagResp<struct unix_diag_msg>(socket_info_entries, {}));
   return Status::OK();
 }
 
@@ -386,8 +447,8 @@ std::map<uint32_t, std::vector<int>> PIDsByNetNamespace(std::filesystem::path pr
 NetlinkSocketProber* SocketProberManager::GetSocketProber(uint32_t ns) {
   auto iter = socket_probers_.find(ns);
   if (iter != socket_probers_.end()) {
-    // Update the phase (similar to an LRU touch).
-    iter->second.phase = current_phase_;
+    // Similar to an LRU touch.
+    iter->second.last_access_round = current_round_;
 
     VLOG(2) << absl::Substitute("SocketProberManager: Retrieving entry [ns=$0]", ns);
     return iter->second.socket_prober.get();
@@ -421,8 +482,8 @@ StatusOr<NetlinkSocketProber*> SocketProberManager::CreateSocketProber(
   std::unique_ptr<NetlinkSocketProber> socket_prober = socket_prober_or.ConsumeValueOrDie();
   NetlinkSocketProber* socket_prober_ptr = socket_prober.get();
   DCHECK_NE(socket_prober_ptr, nullptr);
-  socket_probers_[ns] =
-      TaggedSocketProber{.phase = current_phase_, .socket_prober = std::move(socket_prober)};
+  socket_probers_[ns] = TaggedSocketProber{.last_access_round = current_round_,
+                                           .socket_prober = std::move(socket_prober)};
   return socket_prober_ptr;
 }
 
@@ -440,19 +501,22 @@ StatusOr<NetlinkSocketProber*> SocketProberManager::GetOrCreateSocketProber(
 }
 
 void SocketProberManager::Update() {
-  // Toggle the phase.
-  current_phase_ = current_phase_ ^ 1;
+  ++current_round_;
 
-  // Remove socket probers that were not accessed in the last phase.
+  // Remove socket probers that were not accessed in the last max_idle_rounds_ rounds.
   auto iter = socket_probers_.begin();
   while (iter != socket_probers_.end()) {
-    bool remove = (iter->second.phase == current_phase_);
+    bool remove = (current_round_ - iter->second.last_access_round > max_idle_rounds_);
 
     VLOG_IF(2, remove) << absl::Substitute("SocketProberManager: Removing entry [ns=$0]",
                                            iter->first);
 
     // Update iterator, deleting if necessary as we go.
-    iter = remove ? socket_probers_.erase(iter) : ++iter;
+    if (remove) {
+      socket_probers_.erase(iter++);
+    } else {
+      ++iter;
+    }
   }
 }
 
@@ -464,16 +528,25 @@ StatusOr<std::unique_ptr<SocketInfoManager>> SocketInfoManager::Create(
     std::filesystem::path proc_path, int conn_states) {
   std::unique_ptr<SocketInfoManager> socket_info_db_ptr(
       new SocketInfoManager(proc_path, conn_states));
-  PL_ASSIGN_OR_RETURN(socket_info_db_ptr->socket_probers_, SocketProberManager::Create());
+  PL_ASSIGN_OR_RETURN(socket_info_db_ptr->socket_probers_,
+                      SocketProberManager::Create(kSocketProberMaxIdleRounds));
   return socket_info_db_ptr;
 }
 
-StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
+StatusOr<uint32_t> SocketInfoManager::NetNamespaceOf(uint32_t pid) {
+  auto iter = net_ns_by_pid_.find(pid);
+  if (iter == net_ns_by_pid_.end()) {
+    iter = net_ns_by_pid_.emplace(pid, NetNamespace(cfg_proc_path_, pid)).first;
+  }
+  return iter->second;
+}
+
+StatusOr<SocketInfoEntries*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespaceOf(pid));
 
   // Step 1: Get the map of connections for this network namespace.
   // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
+  SocketInfoEntries* namespace_conns;
 
   auto ns_iter = connections_.find(net_ns);
   if (ns_iter != connections_.end()) {
@@ -485,7 +558,7 @@ StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32
                         socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
     DCHECK(socket_prober != nullptr);
 
-    ns_iter = connections_.insert(ns_iter, {net_ns, {}});
+    ns_iter = connections_.try_emplace(net_ns).first;
     namespace_conns = &ns_iter->second;
 
     Status s;
@@ -507,7 +580,7 @@ StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32
 StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num) {
   // Step 1: Get the map of connections for this network namespace.
   // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
+  SocketInfoEntries* namespace_conns;
   PL_ASSIGN_OR_RETURN(namespace_conns, GetNamespaceConns(pid));
 
   // Step 2: Lookup the inode.
@@ -525,6 +598,7 @@ StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num
 void SocketInfoManager::Flush() {
   socket_probers_->Update();
   connections_.clear();
+  net_ns_by_pid_.clear();
   num_socket_prober_calls_ = 0;
 }
 
@@ -24,9 +24,14 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/container/node_hash_map.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/fs/inode_utils.h"
 
@@ -83,6 +88,23 @@ struct SocketInfo {
   ClientServerRole role = ClientServerRole::kUnknown;
 };
 
+// Socket information keyed by the inode number of the socket.
+using SocketInfoEntries = absl::flat_hash_map<int, SocketInfo>;
+
+/**
+ * Narrows down the sockets returned by NetlinkSocketProber::InetConnections(), so that a
+ * namespace with many sockets doesn't have to be dumped in full to resolve a few of them.
+ */
+struct InetConnFilter {
+  // Only sockets with one of these local ports (in host byte order) are returned. This filter runs
+  // in the kernel, so the other sockets are never sent over. Empty means any port.
+  std::vector<uint16_t> local_ports;
+
+  // Only sockets with one of these inode numbers are returned, along with the listening sockets,
+  // which are needed to classify the roles of the others. Empty means any inode.
+  absl::flat_hash_set<uint32_t> inodes;
+};
+
 /**
  * The NetlinkSocketProber class uses NetLink to probe the Linux kernel about active connections.
  */
@@ -111,11 +133,12 @@ class NetlinkSocketProber {
    * @param socket_info_entries map of inode to SocketInfoEntry that will be populated with
    * established connections.
    * @param conn_states bit vector of connection states to return.
+   * @param filter selects the connections to return, see InetConnFilter.
    *
    * @return error if connection information could not be obtained from kernel.
    */
-  Status InetConnections(std::map<int, SocketInfo>* socket_info_entries,
-                         int conn_states = kTCPEstablishedState);
+  Status InetConnections(SocketInfoEntries* socket_info_entries,
+                         int conn_states = kTCPEstablishedState, const InetConnFilter& filter = {});
 
   /**
    * Finds Unix domain socket connections.
@@ -126,7 +149,7 @@ class NetlinkSocketProber {
    *
    * @return error if connection information could not be obtained from kernel.
    */
-  Status UnixConnections(std::map<int, SocketInfo>* socket_info_entries,
+  Status UnixConnections(SocketInfoEntries* socket_info_entries,
                          int conn_states = kTCPEstablishedState);
 
  private:
@@ -134,11 +157,14 @@ class NetlinkSocketProber {
 
   Status Connect();
 
+  // The attributes, if any, are appended to the request as is.
   template <typename TDiagReqType>
-  Status SendDiagReq(const TDiagReqType& msg_req);
+  Status SendDiagReq(const TDiagReqType& msg_req, std::string_view attrs = {});
 
+  // Only sockets with one of the inodes (or listening sockets) are kept, unless it's empty.
   template <typename TDiagMsgType>
-  Status RecvDiagResp(std::map<int, SocketInfo>* socket_info_entries);
+  Status RecvDiagResp(SocketInfoEntries* socket_info_entries,
+                      const absl::flat_hash_set<uint32_t>& inodes);
 
   int fd_ = -1;
 };
@@ -175,15 +201,17 @@ std::map<uint32_t, std::vector<int>> PIDsByNetNamespace(std::filesystem::path pr
  * a socket prober.
  *
  * The cache is simple, and has a notion of rounds or iterations. If a socket prober is not accessed
- * in a given round, it will be removed in the next round. A round is defined by a call to Update().
+ * for more than max_idle_rounds rounds, it is removed. A round is defined by a call to Update().
+ * Probers are cheap to keep but expensive to create, since that enters the network namespace.
+ * They do keep the namespace alive though, so probers of namespaces that are gone are removed.
  */
 class SocketProberManager {
  public:
-  static StatusOr<std::unique_ptr<SocketProberManager>> Create() {
+  static StatusOr<std::unique_ptr<SocketProberManager>> Create(int max_idle_rounds = 1) {
     if (!IsRoot()) {
       return error::Internal("SocketProber requires root privileges");
     }
-    return std::unique_ptr<SocketProberManager>(new SocketProberManager);
+    return std::unique_ptr<SocketProberManager>(new SocketProberManager(max_idle_rounds));
   }
 
   /**
@@ -224,22 +252,24 @@ class SocketProberManager {
   StatusOr<NetlinkSocketProber*> GetOrCreateSocketProber(uint32_t ns, const std::vector<int>& pids);
 
   /**
-   * Removes any socket probers that were not accessed since the last call to this function.
+   * Starts a new round, and removes any socket probers that were not accessed in the last
+   * max_idle_rounds rounds.
    */
   void Update();
 
  private:
-  SocketProberManager() = default;
+  explicit SocketProberManager(int max_idle_rounds) : max_idle_rounds_(max_idle_rounds) {}
 
   struct TaggedSocketProber {
-    bool phase;
+    int64_t last_access_round;
     std::unique_ptr<NetlinkSocketProber> socket_prober;
   };
 
-  // Phase is used as a 1-bit timestamp.
+  const int max_idle_rounds_;
+
   // Used to know whether a socket_prober has been recently used.
-  bool current_phase_ = false;
-  std::map<int, TaggedSocketProber> socket_probers_;
+  int64_t current_round_ = 0;
+  absl::flat_hash_map<uint32_t, TaggedSocketProber> socket_probers_;
 };
 
 /**
@@ -275,7 +305,7 @@ class SocketInfoManager {
    * @return A map with inode number as key, and socket information as value. Returns error if
    * information could not be queried.
    */
-  StatusOr<std::map<int, system::SocketInfo>*> GetNamespaceConns(uint32_t pid);
+  StatusOr<SocketInfoEntries*> GetNamespaceConns(uint32_t pid);
 
   /**
    * Search for the socket info of a given inode number.
@@ -292,6 +322,12 @@ class SocketInfoManager {
    */
   void Flush();
 
+  /**
+   * Returns the network namespace of the PID. Cached until the next Flush(), since the many
+   * connections of a PID are usually looked up together.
+   */
+  StatusOr<uint32_t> NetNamespaceOf(uint32_t pid);
+
   /**
    * Number of socket prober queries made since the last Flush() (or init).
    * Cached responses are not included in this count.
@@ -300,6 +336,10 @@ class SocketInfoManager {
   int num_socket_prober_calls() { return num_socket_prober_calls_; }
 
  private:
+  // The number of Flush() calls for which an unused socket prober is kept around, so that the
+  // probers of namespaces that are only looked up now and then don't have to be re-created.
+  static constexpr int kSocketProberMaxIdleRounds = 30;
+
   SocketInfoManager(std::filesystem::path proc_path, int conn_states)
       : cfg_proc_path_(proc_path), cfg_conn_states_(conn_states) {}
 
@@ -312,7 +352,12 @@ class SocketInfoManager {
 
   // Two-level to socket information:
   // First key is namespace inode; second key is socket inode.
-  std::map<int, std::map<int, SocketInfo>> connections_;
+  // A node map, since GetNamespaceConns() hands out pointers to the inner maps.
+  absl::node_hash_map<uint32_t, SocketInfoEntries> connections_;
+
+  // The network namespace of each PID that was looked up since the last Flush().
+  // Failures are cached too, so that the connections of an exited PID don't each retry.
+  std::map<uint32_t, StatusOr<uint32_t>> net_ns_by_pid_;
 
   // Portal through which new connection information is gathered,
   // and populated into connections_.
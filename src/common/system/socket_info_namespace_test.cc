@@ -49,7 +49,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -63,7 +63,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create(container_.process_pid()));
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -75,7 +75,7 @@ TEST_F(NetNamespaceTest, NetlinkSocketProber) {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
 
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     int num_conns = socket_info_entries.size();
@@ -178,6 +178,13 @@ TEST_F(NetNamespaceTest, SocketInfoManager) {
     // After flush, we should have made one more call.
     EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
   }
+
+  {
+    ASSERT_OK_AND_ASSIGN(uint32_t net_ns, NetNamespace(kProcPath, kPID));
+    EXPECT_OK_AND_EQ(socket_info_db->NetNamespaceOf(kPID), net_ns);
+    // Cached, so still served once the PID is gone.
+    EXPECT_OK_AND_EQ(socket_info_db->NetNamespaceOf(kPID), net_ns);
+  }
 }
 
 }  // namespace system
@@ -86,7 +86,7 @@ TEST(NetlinkSocketProberTest, EstablishedInetConnection) {
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoEntries socket_info_entries;
   ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
 
   EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(client_endpoint)));
@@ -137,7 +137,7 @@ TEST(NetlinkSocketProberTest, EstablishedUnixConnection) {
   // Now begin the test of NetlinkSocketProber.
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoEntries socket_info_entries;
   ASSERT_OK(socket_prober->UnixConnections(&socket_info_entries));
 
   EXPECT_THAT(socket_info_entries, Contains(HasLocalUnixEndpoint(client_socket_id)));
@@ -158,7 +158,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
     EXPECT_THAT(socket_info_entries, Not(Contains(HasLocalIPEndpoint(server_endpoint))));
   }
@@ -167,7 +167,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPListeningState));
     EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(server_endpoint)));
   }
@@ -176,7 +176,7 @@ TEST(NetlinkSocketProberTest, ListeningInetConnection) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
     EXPECT_THAT(socket_info_entries, Contains(HasLocalIPEndpoint(server_endpoint)));
@@ -195,7 +195,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
 
@@ -224,7 +224,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
                                              kTCPEstablishedState | kTCPListeningState));
 
@@ -250,7 +250,7 @@ TEST(NetlinkSocketProberTest, DetectRole) {
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                          NetlinkSocketProber::Create());
-    std::map<int, SocketInfo> socket_info_entries;
+    SocketInfoEntries socket_info_entries;
     ASSERT_OK(socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState));
 
     int server_socket_count = 0;
@@ -290,12 +290,84 @@ TEST(NetlinkSocketProberTest, ClosedInetConnection) {
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
                        NetlinkSocketProber::Create());
-  std::map<int, SocketInfo> socket_info_entries;
+  SocketInfoEntries socket_info_entries;
   ASSERT_OK(socket_prober->InetConnections(&socket_info_entries));
 
   EXPECT_THAT(socket_info_entries, Not(Contains(HasLocalIPEndpoint(client_endpoint))));
 }
 
+TEST(NetlinkSocketProberTest, FilteredInetConnections) {
+  TCPSocket server1;
+  TCPSocket server2;
+  TCPSocket client1;
+  TCPSocket client2;
+
+  server1.BindAndListen();
+  server2.BindAndListen();
+  client1.Connect(server1);
+  client2.Connect(server2);
+  std::unique_ptr<TCPSocket> server1_conn = server1.Accept();
+  std::unique_ptr<TCPSocket> server2_conn = server2.Accept();
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<NetlinkSocketProber> socket_prober,
+                       NetlinkSocketProber::Create());
+
+  // Only the listening and the accepted sockets of server1 have its port.
+  {
+    InetConnFilter filter;
+    filter.local_ports = {ntohs(server1.port())};
+    SocketInfoEntries socket_info_entries;
+    ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
+                                             kTCPEstablishedState | kTCPListeningState, filter));
+    EXPECT_EQ(socket_info_entries.size(), 2);
+    for (const auto& [inode, s] : socket_info_entries) {
+      EXPECT_EQ(s.local_port, server1.port());
+      EXPECT_EQ(s.role, ClientServerRole::kServer);
+    }
+  }
+
+  // Selecting multiple ports.
+  {
+    InetConnFilter filter;
+    filter.local_ports = {ntohs(server1.port()), ntohs(client2.port())};
+    SocketInfoEntries socket_info_entries;
+    ASSERT_OK(
+        socket_prober->InetConnections(&socket_info_entries, kTCPEstablishedState, filter));
+    std::string server1_endpoint = AddrPortStr(server1.addr(), server1.port());
+    std::string client2_endpoint = AddrPortStr(client2.addr(), client2.port());
+    EXPECT_THAT(socket_info_entries, UnorderedElementsAre(HasLocalIPEndpoint(server1_endpoint),
+                                                          HasLocalIPEndpoint(client2_endpoint)));
+  }
+
+  // Selecting a socket by inode keeps the listening sockets too, so that its role is known.
+  {
+    auto proc_parser = std::make_unique<system::ProcParser>(system::Config::GetInstance());
+    std::string client2_socket_id;
+    ASSERT_OK(proc_parser->ReadProcPIDFDLink(getpid(), client2.sockfd(), &client2_socket_id));
+    ASSERT_OK_AND_ASSIGN(uint32_t client2_inode,
+                         fs::ExtractInodeNum(fs::kSocketInodePrefix, client2_socket_id));
+
+    InetConnFilter filter;
+    filter.inodes = {client2_inode};
+    SocketInfoEntries socket_info_entries;
+    ASSERT_OK(socket_prober->InetConnections(&socket_info_entries,
+                                             kTCPEstablishedState | kTCPListeningState, filter));
+    ASSERT_TRUE(socket_info_entries.contains(client2_inode));
+    EXPECT_EQ(socket_info_entries[client2_inode].local_port, client2.port());
+    EXPECT_EQ(socket_info_entries[client2_inode].role, ClientServerRole::kClient);
+    for (const auto& [inode, s] : socket_info_entries) {
+      if (inode != static_cast<int>(client2_inode)) {
+        EXPECT_EQ(s.state, TCPConnState::kListening);
+      }
+    }
+  }
+
+  client1.Close();
+  client2.Close();
+  server1.Close();
+  server2.Close();
+}
+
 class NetNamespaceTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/system/thread_placement.h"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+#include "src/common/base/file.h"
+#include "src/common/metrics/metrics.h"
+#include "src/common/system/config.h"
+
+namespace px {
+namespace system {
+
+namespace {
+
+// The placer that last placed the current thread, if any.
+thread_local const ThreadPlacer* current_placer = nullptr;
+
+constexpr int kMaxNUMANodes = 1024;
+
+std::string_view MemPolicyName(MemPolicy policy) {
+  switch (policy) {
+    case MemPolicy::kLocal:
+      return "local";
+    case MemPolicy::kBind:
+      return "bind";
+    case MemPolicy::kInterleave:
+      return "interleave";
+    case MemPolicy::kPreferred:
+      return "preferred";
+    default:
+      return "default";
+  }
+}
+
+// The CPUs of the process when the first thread was placed, which unplaced threads run on.
+const cpu_set_t& ProcessCPUs() {
+  static const cpu_set_t cpus = [] {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(getpid(), sizeof(set), &set) != 0) {
+      LOG(ERROR) << absl::Substitute("Failed to get the CPUs of the process: $0",
+                                     std::strerror(errno));
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    return set;
+  }();
+  return cpus;
+}
+
+int MemPolicyMode(MemPolicy policy) {
+  switch (policy) {
+    case MemPolicy::kLocal:
+      return MPOL_LOCAL;
+    case MemPolicy::kBind:
+      return MPOL_BIND;
+    case MemPolicy::kInterleave:
+      return MPOL_INTERLEAVE;
+    case MemPolicy::kPreferred:
+      return MPOL_PREFERRED;
+    default:
+      return MPOL_DEFAULT;
+  }
+}
+
+Status SetMemPolicy(MemPolicy policy, const std::vector<int>& nodes) {
+  constexpr int kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT(runtime/int)
+  std::array<unsigned long, kMaxNUMANodes / kBitsPerWord> mask = {};  // NOLINT(runtime/int)
+  const unsigned long* mask_ptr = nullptr;                            // NOLINT(runtime/int)
+  unsigned long max_node = 0;                                         // NOLINT(runtime/int)
+
+  if (policy == MemPolicy::kBind || policy == MemPolicy::kInterleave ||
+      policy == MemPolicy::kPreferred) {
+    if (nodes.empty()) {
+      return error::FailedPrecondition("No NUMA nodes to apply the $0 memory policy to.",
+                                       MemPolicyName(policy));
+    }
+    // A preferred policy only prefers a single node.
+    for (int node : policy == MemPolicy::kPreferred ? std::vector<int>{nodes.front()} : nodes) {
+      mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    }
+    mask_ptr = mask.data();
+    // The kernel ignores the last bit of the mask.
+    max_node = kMaxNUMANodes + 1;
+  }
+
+  if (syscall(SYS_set_mempolicy, MemPolicyMode(policy), mask_ptr, max_node) != 0) {
+    return error::Internal("Failed to set the $0 memory policy: $1", MemPolicyName(policy),
+                           std::strerror(errno));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<std::vector<int>> ParseCPUList(std::string_view list) {
+  std::vector<int> cpus;
+  for (std::string_view range : absl::StrSplit(list, ',', absl::SkipWhitespace())) {
+    range = absl::StripAsciiWhitespace(range);
+    std::vector<std::string_view> bounds = absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first = 0;
+    int last = 0;
+    if (!absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.size() > 1 ? bounds[1] : bounds[0], &last)) {
+      return error::InvalidArgument("Invalid CPU range '$0' in CPU list '$1'.", range, list);
+    }
+    if (first < 0 || last < first || last >= CPU_SETSIZE) {
+      return error::InvalidArgument("CPU range '$0' must be within [0, $1).", range, CPU_SETSIZE);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::string CPUListToString(const std::vector<int>& cpus) {
+  std::vector<std::string> ranges;
+  for (size_t i = 0; i < cpus.size();) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+      ++j;
+    }
+    ranges.push_back(j == i ? std::to_string(cpus[i]) : absl::StrCat(cpus[i], "-", cpus[j]));
+    i = j + 1;
+  }
+  return absl::StrJoin(ranges, ",");
+}
+
+StatusOr<ThreadPlacement> ParseThreadPlacement(std::string_view spec) {
+  std::vector<std::string_view> parts = absl::StrSplit(spec, absl::MaxSplits(':', 1));
+  ThreadPlacement placement;
+  PL_ASSIGN_OR_RETURN(placement.cpus, ParseCPUList(parts[0]));
+  if (parts.size() > 1) {
+    std::string_view policy = absl::StripAsciiWhitespace(parts[1]);
+    constexpr MemPolicy kPolicies[] = {MemPolicy::kDefault, MemPolicy::kLocal, MemPolicy::kBind,
+                                       MemPolicy::kInterleave, MemPolicy::kPreferred};
+    auto it = std::find_if(std::begin(kPolicies), std::end(kPolicies),
+                           [&](MemPolicy p) { return MemPolicyName(p) == policy; });
+    if (it == std::end(kPolicies)) {
+      return error::InvalidArgument(
+          "Invalid memory policy '$0', expected one of default, local, bind, interleave or "
+          "preferred.",
+          policy);
+    }
+    placement.mem_policy = *it;
+  }
+  return placement;
+}
+
+StatusOr<std::map<int, std::vector<int>>> ReadNUMANodeCPUs(
+    const std::filesystem::path& sysfs_path) {
+  std::map<int, std::vector<int>> node_cpus;
+  const std::filesystem::path node_dir = sysfs_path / "devices/system/node";
+  std::error_code ec;
+  if (!std::filesystem::exists(node_dir, ec)) {
+    return node_cpus;
+  }
+  for (const auto& entry : std::filesystem::directory_iterator(node_dir, ec)) {
+    const std::string filename = entry.path().filename().string();
+    std::string_view name = filename;
+    int node = 0;
+    if (!absl::ConsumePrefix(&name, "node") || !absl::SimpleAtoi(name, &node)) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(std::string cpulist, ReadFileToString(entry.path() / "cpulist"));
+    PL_ASSIGN_OR_RETURN(node_cpus[node], ParseCPUList(absl::StripAsciiWhitespace(cpulist)));
+  }
+  if (ec) {
+    return error::Internal("Failed to list the NUMA nodes in $0: $1", node_dir.string(),
+                           ec.message());
+  }
+  return node_cpus;
+}
+
+ThreadPlacer::ThreadPlacer(std::string_view subsystem, std::string_view spec)
+    : subsystem_(subsystem) {
+  auto placement_or = ParseThreadPlacement(spec);
+  if (!placement_or.ok()) {
+    LOG(ERROR) << absl::Substitute("Invalid $0 thread placement, its threads are not placed: $1",
+                                   subsystem_, placement_or.msg());
+    return;
+  }
+  placement_ = placement_or.ConsumeValueOrDie();
+  if (placement_.empty()) {
+    return;
+  }
+
+  auto node_cpus_or = ReadNUMANodeCPUs(Config::GetInstance().sysfs_path());
+  LOG_IF(WARNING, !node_cpus_or.ok())
+      << absl::Substitute("Failed to read the NUMA nodes of the $0 threads: $1", subsystem_,
+                          node_cpus_or.msg());
+  for (const auto& [node, cpus] : node_cpus_or.ConsumeValueOr({})) {
+    // All nodes are used when the CPUs are not restricted.
+    bool used = placement_.cpus.empty();
+    for (int cpu : cpus) {
+      used |= std::binary_search(placement_.cpus.begin(), placement_.cpus.end(), cpu);
+    }
+    if (used && node < kMaxNUMANodes) {
+      numa_nodes_.push_back(node);
+    }
+  }
+
+  threads_gauge_ = &prometheus::BuildGauge()
+                        .Name("thread_placement_threads")
+                        .Help("Number of threads of an agent subsystem placed on its CPUs and "
+                              "NUMA nodes")
+                        .Register(GetMetricsRegistry())
+                        .Add({{"subsystem", subsystem_},
+                              {"cpus", CPUListToString(placement_.cpus)},
+                              {"numa_nodes", CPUListToString(numa_nodes_)},
+                              {"mem_policy", std::string(MemPolicyName(placement_.mem_policy))}});
+  LOG(INFO) << absl::Substitute("Placing the $0 threads on CPUs [$1], NUMA nodes [$2], with the "
+                                "$3 memory policy.",
+                                subsystem_, CPUListToString(placement_.cpus),
+                                CPUListToString(numa_nodes_),
+                                MemPolicyName(placement_.mem_policy));
+}
+
+Status ThreadPlacer::Apply() const {
+  cpu_set_t set = ProcessCPUs();
+  if (!placement_.cpus.empty()) {
+    CPU_ZERO(&set);
+    for (int cpu : placement_.cpus) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    return error::Internal("Failed to set the CPUs of the thread: $0", std::strerror(err));
+  }
+  return SetMemPolicy(placement_.mem_policy, numa_nodes_);
+}
+
+void ThreadPlacer::PlaceCurrentThread() const {
+  if (current_placer == this) {
+    return;
+  }
+  // Threads that were never placed don't have to be moved back to the process CPUs.
+  if (current_placer == nullptr && placement_.empty()) {
+    current_placer = this;
+    return;
+  }
+
+  Status s = Apply();
+  if (!s.ok()) {
+    LOG_FIRST_N(ERROR, 1) << absl::Substitute("Failed to place a $0 thread: $1", subsystem_,
+                                              s.msg());
+  }
+  if (current_placer != nullptr && current_placer->threads_gauge_ != nullptr) {
+    current_placer->threads_gauge_->Decrement();
+  }
+  if (s.ok() && threads_gauge_ != nullptr) {
+    threads_gauge_->Increment();
+  }
+  current_placer = this;
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <prometheus/gauge.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace system {
+
+/**
+ * The NUMA memory policy of a thread, see set_mempolicy(2). The nodes of kBind, kInterleave and
+ * kPreferred are the nodes of the CPUs the thread is placed on.
+ */
+enum class MemPolicy { kDefault, kLocal, kBind, kInterleave, kPreferred };
+
+struct ThreadPlacement {
+  // The CPUs the thread may run on. Empty leaves the thread on the CPUs of the process.
+  std::vector<int> cpus;
+  MemPolicy mem_policy = MemPolicy::kDefault;
+
+  bool empty() const { return cpus.empty() && mem_policy == MemPolicy::kDefault; }
+};
+
+/**
+ * Parses a CPU list in the format of cpuset(7) and /sys/devices/system/node/node<N>/cpulist,
+ * e.g. "0-3,8". The returned CPUs are sorted and unique.
+ */
+StatusOr<std::vector<int>> ParseCPUList(std::string_view list);
+
+/**
+ * Formats the CPUs as a CPU list, the inverse of ParseCPUList().
+ */
+std::string CPUListToString(const std::vector<int>& cpus);
+
+/**
+ * Parses a thread placement "<cpu list>[:<mem policy>]", e.g. "0-11:bind" or ":local", where the
+ * memory policy is one of default, local, bind, interleave or preferred. An empty spec is the
+ * empty placement.
+ */
+StatusOr<ThreadPlacement> ParseThreadPlacement(std::string_view spec);
+
+/**
+ * Reads the CPUs of each NUMA node from <sysfs_path>/devices/system/node. A kernel without NUMA
+ * support has no node directories, and returns no nodes.
+ */
+StatusOr<std::map<int, std::vector<int>>> ReadNUMANodeCPUs(const std::filesystem::path& sysfs_path);
+
+/**
+ * ThreadPlacer places the threads of an agent subsystem (e.g. the Stirling core loop or the
+ * Carnot query threads) on the CPUs and NUMA nodes of its configured placement, so that the memory
+ * the threads first touch is allocated on their own node.
+ *
+ * PlaceCurrentThread() is meant to be called whenever a thread starts, or resumes, work for the
+ * subsystem. It only makes syscalls when the thread was last placed by another placer, so it can
+ * be called for each task run on a shared thread pool. Placing a thread with an empty placement
+ * moves it back to the CPUs of the process and to the default memory policy.
+ *
+ * The placement is exported as the thread_placement_threads gauge, which counts the threads that
+ * were last placed by the placer, labeled by subsystem, CPUs, NUMA nodes and memory policy.
+ */
+class ThreadPlacer : public NotCopyMoveable {
+ public:
+  /**
+   * An invalid spec is logged, and leaves the threads of the subsystem unplaced.
+   */
+  ThreadPlacer(std::string_view subsystem, std::string_view spec);
+
+  void PlaceCurrentThread() const;
+
+  const ThreadPlacement& placement() const { return placement_; }
+  const std::vector<int>& numa_nodes() const { return numa_nodes_; }
+
+ private:
+  Status Apply() const;
+
+  std::string subsystem_;
+  ThreadPlacement placement_;
+  std::vector<int> numa_nodes_;
+  prometheus::Gauge* threads_gauge_ = nullptr;
+};
+
+}  // namespace system
+}  // namespace px
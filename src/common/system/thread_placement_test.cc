@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sched.h>
+
+#include <filesystem>
+#include <thread>
+
+#include "src/common/base/file.h"
+#include "src/common/system/thread_placement.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+TEST(ParseCPUListTest, ParsesRangesAndSingleCPUs) {
+  EXPECT_OK_AND_THAT(ParseCPUList("0-3,8, 2,10-11"), ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  EXPECT_OK_AND_THAT(ParseCPUList("5"), ElementsAre(5));
+  EXPECT_OK_AND_THAT(ParseCPUList(""), IsEmpty());
+}
+
+TEST(ParseCPUListTest, RejectsInvalidRanges) {
+  EXPECT_NOT_OK(ParseCPUList("3-1"));
+  EXPECT_NOT_OK(ParseCPUList("1-"));
+  EXPECT_NOT_OK(ParseCPUList("a"));
+  EXPECT_NOT_OK(ParseCPUList("-1"));
+  EXPECT_NOT_OK(ParseCPUList("0-100000"));
+}
+
+TEST(CPUListToStringTest, CollapsesRanges) {
+  EXPECT_EQ(CPUListToString({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+  EXPECT_EQ(CPUListToString({}), "");
+}
+
+TEST(ParseThreadPlacementTest, ParsesCPUsAndMemPolicy) {
+  ASSERT_OK_AND_ASSIGN(ThreadPlacement placement, ParseThreadPlacement("0-1:bind"));
+  EXPECT_THAT(placement.cpus, ElementsAre(0, 1));
+  EXPECT_EQ(placement.mem_policy, MemPolicy::kBind);
+
+  ASSERT_OK_AND_ASSIGN(placement, ParseThreadPlacement(":interleave"));
+  EXPECT_THAT(placement.cpus, IsEmpty());
+  EXPECT_EQ(placement.mem_policy, MemPolicy::kInterleave);
+
+  ASSERT_OK_AND_ASSIGN(placement, ParseThreadPlacement("4"));
+  EXPECT_THAT(placement.cpus, ElementsAre(4));
+  EXPECT_EQ(placement.mem_policy, MemPolicy::kDefault);
+
+  ASSERT_OK_AND_ASSIGN(placement, ParseThreadPlacement(""));
+  EXPECT_TRUE(placement.empty());
+
+  EXPECT_NOT_OK(ParseThreadPlacement("0:remote"));
+}
+
+TEST(ReadNUMANodeCPUsTest, ReadsNodeCPULists) {
+  testing::TempDir sysfs;
+  const std::filesystem::path node_dir = sysfs.path() / "devices/system/node";
+  std::filesystem::create_directories(node_dir / "node0");
+  std::filesystem::create_directories(node_dir / "node1");
+  std::filesystem::create_directories(node_dir / "power");
+  ASSERT_OK(WriteFileFromString(node_dir / "node0/cpulist", "0-3,8-11\n"));
+  ASSERT_OK(WriteFileFromString(node_dir / "node1/cpulist", "4-7,12-15\n"));
+
+  EXPECT_OK_AND_THAT(ReadNUMANodeCPUs(sysfs.path()),
+                     ElementsAre(Pair(0, ElementsAre(0, 1, 2, 3, 8, 9, 10, 11)),
+                                 Pair(1, ElementsAre(4, 5, 6, 7, 12, 13, 14, 15))));
+}
+
+TEST(ReadNUMANodeCPUsTest, NoNodesWithoutNUMA) {
+  testing::TempDir sysfs;
+  EXPECT_OK_AND_THAT(ReadNUMANodeCPUs(sysfs.path()), IsEmpty());
+}
+
+TEST(ThreadPlacerTest, PinsAndUnpinsThread) {
+  cpu_set_t process_cpus;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(process_cpus), &process_cpus), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &process_cpus)) {
+    ++cpu;
+  }
+
+  ThreadPlacer pinned("test", std::to_string(cpu));
+  ThreadPlacer unpinned("test_unpinned", "");
+  EXPECT_THAT(pinned.placement().cpus, ElementsAre(cpu));
+  EXPECT_TRUE(unpinned.placement().empty());
+
+  std::thread thread([&] {
+    cpu_set_t cpus;
+    pinned.PlaceCurrentThread();
+    ASSERT_EQ(sched_getaffinity(0, sizeof(cpus), &cpus), 0);
+    EXPECT_EQ(CPU_COUNT(&cpus), 1);
+    EXPECT_TRUE(CPU_ISSET(cpu, &cpus));
+
+    unpinned.PlaceCurrentThread();
+    ASSERT_EQ(sched_getaffinity(0, sizeof(cpus), &cpus), 0);
+    EXPECT_TRUE(CPU_EQUAL(&cpus, &process_cpus));
+  });
+  thread.join();
+}
+
+TEST(ThreadPlacerTest, InvalidSpecLeavesThreadsUnplaced) {
+  ThreadPlacer placer("test_invalid", "0-:bind");
+  EXPECT_TRUE(placer.placement().empty());
+}
+
+}  // namespace system
+}  // namespace px
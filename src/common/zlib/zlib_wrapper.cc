@@ -17,48 +17,154 @@
  */
 
 #include <zlib.h>
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "src/common/base/base.h"
+#include "src/common/base/byte_utils.h"
 #include "src/common/zlib/zlib_wrapper.h"
 
 namespace px {
 namespace zlib {
 
-StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
-  z_stream zs = {};
+namespace {
+
+// The zlib stream of a thread. Its state is allocated once, and reset between uses,
+// rather than initialized and torn down for every source buffer.
+class ThreadInflateStream {
+ public:
+  ThreadInflateStream() { initialized_ = inflateInit2(&zs_, MAX_WBITS + 16) == Z_OK; }
+  ~ThreadInflateStream() {
+    if (initialized_) {
+      inflateEnd(&zs_);
+    }
+  }
+
+  // Returns the reset stream, or nullptr if it could not be initialized.
+  z_stream* Reset() {
+    if (!initialized_ || inflateReset(&zs_) != Z_OK) {
+      return nullptr;
+    }
+    return &zs_;
+  }
+
+ private:
+  z_stream zs_ = {};
+  bool initialized_ = false;
+};
+
+class ThreadDeflateStream {
+ public:
+  ThreadDeflateStream() {
+    initialized_ = deflateInit2(&zs_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16,
+                                /* memLevel */ 8, Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+  ~ThreadDeflateStream() {
+    if (initialized_) {
+      deflateEnd(&zs_);
+    }
+  }
 
-  if (inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
+  // Returns the reset stream, or nullptr if it could not be initialized.
+  z_stream* Reset() {
+    if (!initialized_ || deflateReset(&zs_) != Z_OK) {
+      return nullptr;
+    }
+    return &zs_;
+  }
+
+ private:
+  z_stream zs_ = {};
+  bool initialized_ = false;
+};
+
+StatusOr<std::string> InflateImpl(std::string_view in, size_t output_block_size,
+                                  size_t max_output_size) {
+  static thread_local ThreadInflateStream thread_stream;
+
+  z_stream* zs = thread_stream.Reset();
+  if (zs == nullptr) {
     return error::Internal("inflateInit2 failed while decompressing.");
   }
 
   // Setup input buffer.
-  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
-  zs.avail_in = in.size();
+  zs->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs->avail_in = in.size();
 
-  int ret;
+  int ret = Z_OK;
   std::string out;
 
-  // Get the decompressed bytes blockwise using repeated calls to inflate.
-  do {
-    out.resize(out.size() + output_block_size);
-    zs.next_out = reinterpret_cast<Bytef*>(out.data() + zs.total_out);
-    zs.avail_out = out.size() - zs.total_out;
-
-    ret = inflate(&zs, 0);
-  } while (ret == Z_OK);
+  // Get the decompressed bytes blockwise using repeated calls to inflate,
+  // until the end of the stream or the output limit.
+  while (ret == Z_OK && zs->total_out < max_output_size) {
+    size_t block_size = std::min(output_block_size, max_output_size - zs->total_out);
+    out.resize(zs->total_out + block_size);
+    zs->next_out = reinterpret_cast<Bytef*>(out.data() + zs->total_out);
+    zs->avail_out = block_size;
 
-  out.resize(zs.total_out);
+    ret = inflate(zs, Z_NO_FLUSH);
+  }
 
-  inflateEnd(&zs);
+  out.resize(zs->total_out);
 
-  if (ret != Z_STREAM_END) {
+  if (ret != Z_OK && ret != Z_STREAM_END) {
     // An error occurred that was not EOF.
-    return error::Internal("Exception during zlib decompression: $0", zs.msg);
+    return error::Internal("Exception during zlib decompression: $0",
+                           zs->msg != nullptr ? zs->msg : "");
   }
 
   return out;
 }
 
+}  // namespace
+
+StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
+  return InflateImpl(in, output_block_size, std::numeric_limits<size_t>::max());
+}
+
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size) {
+  constexpr size_t kOutputBlockSize = 16384;
+  return InflateImpl(in, kOutputBlockSize, max_output_size);
+}
+
+size_t GzipInflatedSize(std::string_view in) {
+  // The gzip trailer ends with the size of the decompressed content (modulo 2^32).
+  constexpr size_t kMinGzipSize = 18;
+  constexpr size_t kSizeFieldBytes = 4;
+  if (in.size() < kMinGzipSize) {
+    return 0;
+  }
+  return utils::LEndianBytesToInt<uint32_t>(in.substr(in.size() - kSizeFieldBytes));
+}
+
+Status Deflate(std::string_view in, std::string* out) {
+  static thread_local ThreadDeflateStream thread_stream;
+
+  z_stream* zs = thread_stream.Reset();
+  if (zs == nullptr) {
+    return error::Internal("deflateInit2 failed while compressing.");
+  }
+
+  zs->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs->avail_in = in.size();
+
+  // The bound covers the gzip header and trailer, so a single call compresses all of the input.
+  size_t offset = out->size();
+  out->resize(offset + deflateBound(zs, in.size()));
+  zs->next_out = reinterpret_cast<Bytef*>(out->data() + offset);
+  zs->avail_out = out->size() - offset;
+
+  int ret = deflate(zs, Z_FINISH);
+  if (ret != Z_STREAM_END) {
+    out->resize(offset);
+    return error::Internal("Exception during zlib compression: $0",
+                           zs->msg != nullptr ? zs->msg : "");
+  }
+
+  out->resize(offset + zs->total_out);
+  return Status::OK();
+}
+
 }  // namespace zlib
 }  // namespace px
@@ -35,5 +35,39 @@ namespace zlib {
  */
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size = 16384);
 
+/**
+ * @brief Inflates (gunzip) at most max_output_size bytes from the head of a source buffer.
+ * Decompression stops once the limit is reached, so callers that only keep the head of the
+ * content don't pay for the rest of it.
+ *
+ * Both Inflate() and InflatePrefix() reuse the zlib stream of the calling thread.
+ *
+ * @param in A view into the source buffer.
+ * @param max_output_size The limit of the size of the decompressed content.
+ * @return Status or the head of the decompressed content as a string.
+ */
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size);
+
+/**
+ * @brief Returns the size of the decompressed content, as recorded in the gzip trailer.
+ * The size is exact for a single gzip member smaller than 4GiB, and the trailer is not validated,
+ * so it is only an estimate for content that was not entirely inflated.
+ *
+ * @param in A view into the source buffer.
+ * @return The decompressed size, or 0 if the source is too short to hold a gzip trailer.
+ */
+size_t GzipInflatedSize(std::string_view in);
+
+/**
+ * @brief Deflates (gzip) a source buffer, and appends the compressed content to out.
+ * Like Inflate(), it reuses the zlib stream of the calling thread, and appending lets callers
+ * reuse the capacity of out, and write a header in front of the compressed content.
+ *
+ * @param in A view into the source buffer.
+ * @param out The string to append the compressed content to.
+ * @return Status of the compression. On failure, out is left as it was.
+ */
+Status Deflate(std::string_view in, std::string* out);
+
 }  // namespace zlib
 }  // namespace px
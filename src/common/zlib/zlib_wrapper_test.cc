@@ -20,6 +20,8 @@
 #include <zlib.h>
 #include <string>
 
+#include <absl/strings/match.h>
+
 #include "src/common/testing/testing.h"
 
 namespace px {
@@ -46,4 +48,38 @@ TEST_F(ZlibTest, inflate_test) {
   EXPECT_OK_AND_EQ(result, GetExpectedResult());
 }
 
+TEST_F(ZlibTest, inflate_prefix_test) {
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 4), "This");
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 1024), GetExpectedResult());
+  EXPECT_NOT_OK(px::zlib::InflatePrefix("not gzip", 1024));
+
+  // The failure above must not leave the stream of the thread in a bad state.
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(GetCompressedString()), GetExpectedResult());
+}
+
+TEST_F(ZlibTest, inflated_size_test) {
+  EXPECT_EQ(px::zlib::GzipInflatedSize(GetCompressedString()), GetExpectedResult().size());
+  EXPECT_EQ(px::zlib::GzipInflatedSize("short"), 0);
+}
+
+TEST_F(ZlibTest, deflate_test) {
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    absl::StrAppend(&content, "line ", i % 10, "\n");
+  }
+
+  std::string out = "header";
+  ASSERT_OK(px::zlib::Deflate(content, &out));
+  ASSERT_TRUE(absl::StartsWith(out, "header"));
+  std::string_view compressed = std::string_view(out).substr(6);
+  EXPECT_LT(compressed.size(), content.size());
+  EXPECT_EQ(px::zlib::GzipInflatedSize(compressed), content.size());
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(compressed), content);
+
+  // The stream of the thread is reused for the next buffer.
+  out.clear();
+  ASSERT_OK(px::zlib::Deflate(GetExpectedResult(), &out));
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(out), GetExpectedResult());
+}
+
 }  // namespace px
@@ -101,6 +101,15 @@ uint64_t GRPCClockConverter::Convert(uint64_t mono_time) const {
   return reftime;
 }
 
+void GRPCClockConverter::ConvertBatch(size_t count, const uint64_t* monotonic_times,
+                                      uint64_t* out) const {
+  mono_to_realtime_->ConvertBatch(count, monotonic_times, out);
+  if (disable_grpc_offsets_.load()) {
+    return;
+  }
+  realtime_to_reftime_.GetBatch(count, out, out);
+}
+
 }  // namespace grpc_clocksync
 }  // namespace integrations
 }  // namespace px
@@ -39,6 +39,7 @@ class GRPCClockConverter : public clock::ClockConverter {
   GRPCClockConverter();
 
   uint64_t Convert(uint64_t monotonic_time) const override;
+  void ConvertBatch(size_t count, const uint64_t* monotonic_times, uint64_t* out) const override;
   void Update() override;
   std::chrono::milliseconds UpdatePeriod() const override { return update_period_; }
 
@@ -17,6 +17,8 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -31,8 +33,40 @@ PL_SUPPRESS_WARNINGS_END()
 namespace px {
 namespace bloomfilter {
 
+namespace {
+
+// Setting a fixed number of bits in a single block is less accurate than spreading them over the
+// entire filter. This many more bits keeps blocked filters at or below the requested error rate,
+// for error rates between 0.1 and 0.0001.
+constexpr double kBlockedBitsFactor = 1.25;
+
+// The salts that pick the bit of an item in each word of its block, from the split block bloom
+// filters of Parquet.
+constexpr uint32_t kBlockSalts[XXHash64BloomFilter::kBlockWords] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// Computes the bit that the hash sets in each word of its block. The loop has a fixed size and no
+// branches, so that the compiler vectorizes it, as well as the loops over the words that use it.
+inline void BlockMasks(uint32_t hash, uint64_t* masks) {
+  for (int i = 0; i < XXHash64BloomFilter::kBlockWords; ++i) {
+    masks[i] = uint64_t{1} << ((hash * kBlockSalts[i]) >> 26);
+  }
+}
+
+}  // namespace
+
+XXHash64BloomFilter::XXHash64BloomFilter(const std::vector<uint8_t>& buffer)
+    : layout_(Layout::kBlocked), num_hashes_(kBlockWords), blocks_(buffer.size() / sizeof(Block)) {
+  DCHECK_EQ(buffer.size() % sizeof(Block), 0U);
+  // The words are serialized in the byte order of the host, which is little endian on all of the
+  // platforms that we support.
+  std::memcpy(blocks_.data(), buffer.data(), blocks_.size() * sizeof(Block));
+}
+
 StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64_t max_entries,
-                                                                           double error_rate) {
+                                                                           double error_rate,
+                                                                           Layout layout) {
   if (error_rate <= 0.0 || error_rate >= 1.0) {
     return error::Internal(
         "Bloom filter error rate must be greater than 0 and less than 1, received %e", error_rate);
@@ -46,6 +80,13 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64
   // bits per entry = ln(error_rate)/ln(2)^2
   double bpe = -(std::log(error_rate) / std::pow(std::log(2), 2));
   int64_t num_bits = static_cast<int64_t>(std::ceil(max_entries * bpe));
+  if (layout == Layout::kBlocked) {
+    int64_t block_bits = sizeof(Block) * 8;
+    int64_t num_blocks = std::max<int64_t>(
+        1, static_cast<int64_t>(std::ceil(num_bits * kBlockedBitsFactor / block_bits)));
+    return std::unique_ptr<XXHash64BloomFilter>(
+        new XXHash64BloomFilter(std::vector<uint8_t>(num_blocks * sizeof(Block), 0)));
+  }
   int64_t num_bytes = (num_bits / 8) + ((num_bits % 8) ? 1 : 0);
 
   // num hashes = ln(2) * bpe
@@ -66,12 +107,32 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::FromProto(
   }
 
   std::vector<uint8_t> data{bytes_str.begin(), bytes_str.end()};
-  return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data, pb.num_hashes()));
+  switch (pb.layout()) {
+    case XXHash64BloomFilterPB::LAYOUT_FLAT:
+      return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data, pb.num_hashes()));
+    case XXHash64BloomFilterPB::LAYOUT_BLOCKED:
+      if (data.size() % sizeof(Block) != 0) {
+        return error::Internal("Blocked BloomFilter data of $0 bytes isn't a multiple of $1 bytes",
+                               data.size(), sizeof(Block));
+      }
+      if (pb.num_hashes() != kBlockWords) {
+        return error::Internal("Blocked BloomFilter must have $0 hashes, received $1", kBlockWords,
+                               pb.num_hashes());
+      }
+      return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data));
+    default:
+      return error::Internal("Unknown BloomFilter layout $0", static_cast<int>(pb.layout()));
+  }
 }
 
 XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() {
   XXHash64BloomFilterPB output;
   output.set_num_hashes(num_hashes_);
+  if (layout_ == Layout::kBlocked) {
+    output.set_layout(XXHash64BloomFilterPB::LAYOUT_BLOCKED);
+    output.set_data(reinterpret_cast<const char*>(blocks_.data()), blocks_.size() * sizeof(Block));
+    return output;
+  }
   std::string bytes_str{buffer_.begin(), buffer_.end()};
   output.set_data(std::move(bytes_str));
   return output;
@@ -89,8 +150,22 @@ bool XXHash64BloomFilter::HasBitSet(int bit_number) const {
   return buffer_[byte_index] & mask;
 }
 
+size_t XXHash64BloomFilter::BlockIndex(uint64_t hash) const {
+  // The upper half of the hash picks the block, the lower half the bits in it.
+  return static_cast<size_t>(((hash >> 32) * blocks_.size()) >> 32);
+}
+
 void XXHash64BloomFilter::Insert(std::string_view item) {
   uint64_t a = XXH64(item.data(), item.size(), seed_);
+  if (layout_ == Layout::kBlocked) {
+    uint64_t masks[kBlockWords];
+    BlockMasks(static_cast<uint32_t>(a), masks);
+    Block& block = blocks_[BlockIndex(a)];
+    for (int i = 0; i < kBlockWords; ++i) {
+      block.words[i] |= masks[i];
+    }
+    return;
+  }
   uint64_t b = XXH64(item.data(), item.size(), a);
 
   for (auto i = 0; i < num_hashes_; ++i) {
@@ -104,6 +179,16 @@ void XXHash64BloomFilter::Insert(std::string_view item) {
 
 bool XXHash64BloomFilter::Contains(std::string_view item) const {
   uint64_t a = XXH64(item.data(), item.size(), seed_);
+  if (layout_ == Layout::kBlocked) {
+    uint64_t masks[kBlockWords];
+    BlockMasks(static_cast<uint32_t>(a), masks);
+    const Block& block = blocks_[BlockIndex(a)];
+    uint64_t missing = 0;
+    for (int i = 0; i < kBlockWords; ++i) {
+      missing |= masks[i] & ~block.words[i];
+    }
+    return missing == 0;
+  }
   uint64_t b = XXH64(item.data(), item.size(), a);
 
   for (auto i = 0; i < num_hashes_; ++i) {
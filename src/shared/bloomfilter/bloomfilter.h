@@ -33,12 +33,24 @@ using XXHash64BloomFilterPB = shared::bloomfilterpb::XXHash64BloomFilter;
 
 class XXHash64BloomFilter {
  public:
+  enum class Layout {
+    // Each hash sets a bit anywhere in the buffer.
+    kFlat,
+    // An item sets all of its bits in a single cache line sized block of the buffer, so checking
+    // it costs one cache miss instead of one per hash. It needs more bits for the same error rate.
+    kBlocked,
+  };
+
+  // The number of bits that an item sets in its block, one in each 64 bit word of the block.
+  static constexpr int kBlockWords = 8;
+
   /**
    * Create creates a bloom filter which is sized to meet the criteria for maximum number of
    * entries and the false positive error rate. The false negative error rate is always 0.
    */
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> Create(int64_t max_entries,
-                                                               double error_rate);
+                                                               double error_rate,
+                                                               Layout layout = Layout::kFlat);
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> FromProto(const XXHash64BloomFilterPB& pb);
   XXHash64BloomFilterPB ToProto();
 
@@ -58,26 +70,44 @@ class XXHash64BloomFilter {
   /**
    * Get the buffer size in bytes of the bloom filter.
    */
-  size_t buffer_size_bytes() const { return buffer_.size(); }
+  size_t buffer_size_bytes() const {
+    return layout_ == Layout::kBlocked ? blocks_.size() * sizeof(Block) : buffer_.size();
+  }
 
   /**
    * Get the number of hashes used in the bloom filter.
    */
   int num_hashes() const { return num_hashes_; }
 
+  Layout layout() const { return layout_; }
+
  protected:
   XXHash64BloomFilter(int64_t num_bytes, int num_hashes)
       : XXHash64BloomFilter(std::vector<uint8_t>(num_bytes, 0), num_hashes) {}
 
   XXHash64BloomFilter(const std::vector<uint8_t>& buffer, int32_t num_hashes)
-      : num_hashes_(num_hashes), buffer_(buffer) {}
+      : layout_(Layout::kFlat), num_hashes_(num_hashes), buffer_(buffer) {}
+
+  // Creates a blocked filter. The buffer's size has to be a multiple of the block size.
+  explicit XXHash64BloomFilter(const std::vector<uint8_t>& buffer);
 
  private:
+  struct alignas(64) Block {
+    uint64_t words[kBlockWords];
+  };
+
   void SetBit(int bit_number);
   bool HasBitSet(int bit_number) const;
 
+  // Maps the hash to the index of its block.
+  size_t BlockIndex(uint64_t hash) const;
+
+  const Layout layout_;
   const int num_hashes_;
+  // The bits of flat filters.
   std::vector<uint8_t> buffer_;
+  // The bits of blocked filters.
+  std::vector<Block> blocks_;
   const uint64_t seed_ = 3091990;
 };
 
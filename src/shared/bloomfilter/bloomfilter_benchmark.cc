@@ -35,17 +35,22 @@ class BloomFilterBenchmark : public benchmark::Fixture {
     auto num_items = state.range(0);
     auto error_rate = 1.0 / state.range(1);
     auto strlen = state.range(2);
-    insert_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
-    lookup_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
+    auto layout = static_cast<XXHash64BloomFilter::Layout>(state.range(3));
+    insert_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate, layout).ConsumeValueOrDie();
+    lookup_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate, layout).ConsumeValueOrDie();
     random_strs_.reserve(num_items);
+    missing_strs_.reserve(num_items);
     for (auto i = 0; i < num_items; ++i) {
       random_strs_.push_back(datagen::RandomString(strlen));
+      missing_strs_.push_back(datagen::RandomString(strlen));
       lookup_bf_->Insert(random_strs_[i]);
     }
   }
 
  protected:
   std::vector<std::string> random_strs_;
+  // Strings that weren't inserted, to measure the false positive rate.
+  std::vector<std::string> missing_strs_;
   std::unique_ptr<XXHash64BloomFilter> insert_bf_;
   std::unique_ptr<XXHash64BloomFilter> lookup_bf_;
 };
@@ -72,12 +77,21 @@ BENCHMARK_DEFINE_F(BloomFilterBenchmark, LookupTest)(benchmark::State& state) {
   PL_UNUSED(result);
   state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
   state.SetItemsProcessed(state.iterations() * random_strs_.size());
+
+  int64_t num_false_positives = 0;
+  for (const auto& missing_str : missing_strs_) {
+    num_false_positives += lookup_bf_->Contains(missing_str);
+  }
+  state.counters["false_positive_rate"] =
+      static_cast<double>(num_false_positives) / missing_strs_.size();
+  state.counters["bytes"] = lookup_bf_->buffer_size_bytes();
 }
 
+// The last argument is the layout of the filter: 0 for flat, 1 for blocked.
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, InsertTest)
-    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}, {0, 1}});
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, LookupTest)
-    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}, {0, 1}});
 
 }  // namespace bloomfilter
 }  // namespace px
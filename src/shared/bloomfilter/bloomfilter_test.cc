@@ -18,6 +18,12 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/common/testing/testing.h"
 #include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
@@ -113,5 +119,85 @@ TEST(XXHash64BloomFilter, test_create_from_proto) {
   }
 }
 
+TEST(XXHash64BloomFilter, test_create_blocked) {
+  auto bf1 = XXHash64BloomFilter::Create(10, 0.1, XXHash64BloomFilter::Layout::kBlocked)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf1->layout(), XXHash64BloomFilter::Layout::kBlocked);
+  EXPECT_EQ(bf1->num_hashes(), 8);
+  EXPECT_EQ(bf1->buffer_size_bytes(), 64);
+
+  auto bf2 = XXHash64BloomFilter::Create(100000, 0.01, XXHash64BloomFilter::Layout::kBlocked)
+                 .ConsumeValueOrDie();
+  EXPECT_EQ(bf2->num_hashes(), 8);
+  EXPECT_EQ(bf2->buffer_size_bytes(), 149824);
+}
+
+TEST(XXHash64BloomFilter, test_blocked) {
+  auto bf = XXHash64BloomFilter::Create(10, 0.1, XXHash64BloomFilter::Layout::kBlocked)
+                .ConsumeValueOrDie();
+  EXPECT_FALSE(bf->Contains("foo"));
+  EXPECT_FALSE(bf->Contains("bar"));
+  bf->Insert("foo");
+  bf->Insert("bar");
+  EXPECT_TRUE(bf->Contains("foo"));
+  EXPECT_TRUE(bf->Contains("bar"));
+  EXPECT_FALSE(bf->Contains("not_present"));
+  EXPECT_FALSE(bf->Contains(""));
+}
+
+TEST(XXHash64BloomFilter, test_blocked_error_rate) {
+  constexpr int kNumEntries = 10000;
+  constexpr double kErrorRate = 0.01;
+  auto bf =
+      XXHash64BloomFilter::Create(kNumEntries, kErrorRate, XXHash64BloomFilter::Layout::kBlocked)
+          .ConsumeValueOrDie();
+  for (int i = 0; i < kNumEntries; ++i) {
+    bf->Insert(absl::StrCat("inserted_", i));
+  }
+  int num_false_positives = 0;
+  for (int i = 0; i < kNumEntries; ++i) {
+    EXPECT_TRUE(bf->Contains(absl::StrCat("inserted_", i)));
+    num_false_positives += bf->Contains(absl::StrCat("missing_", i));
+  }
+  // Leave some slack for the variance of the sample.
+  EXPECT_LT(num_false_positives, 1.5 * kErrorRate * kNumEntries);
+}
+
+TEST(XXHash64BloomFilter, test_create_blocked_from_proto) {
+  std::vector<std::string> matches{"foo", "bar", "abc"};
+  std::vector<std::string> non_matches{"123", "456", "789"};
+
+  auto bf = XXHash64BloomFilter::Create(100000, 0.01, XXHash64BloomFilter::Layout::kBlocked)
+                .ConsumeValueOrDie();
+  for (const auto& match : matches) {
+    bf->Insert(match);
+  }
+
+  auto proto = bf->ToProto();
+  EXPECT_EQ(proto.layout(), XXHash64BloomFilterPB::LAYOUT_BLOCKED);
+  auto reconstructed = XXHash64BloomFilter::FromProto(proto).ConsumeValueOrDie();
+  EXPECT_EQ(reconstructed->layout(), XXHash64BloomFilter::Layout::kBlocked);
+  EXPECT_EQ(reconstructed->num_hashes(), 8);
+  EXPECT_EQ(reconstructed->buffer_size_bytes(), 149824);
+  for (const auto& match : matches) {
+    EXPECT_TRUE(reconstructed->Contains(match));
+  }
+  for (const auto& non_match : non_matches) {
+    EXPECT_FALSE(reconstructed->Contains(non_match));
+  }
+}
+
+TEST(XXHash64BloomFilter, test_invalid_blocked_proto) {
+  XXHash64BloomFilterPB proto;
+  proto.set_layout(XXHash64BloomFilterPB::LAYOUT_BLOCKED);
+  proto.set_num_hashes(8);
+  proto.set_data(std::string(100, '\0'));
+  EXPECT_NOT_OK(XXHash64BloomFilter::FromProto(proto));
+
+  proto.set_num_hashes(7);
+  proto.set_data(std::string(128, '\0'));
+  EXPECT_NOT_OK(XXHash64BloomFilter::FromProto(proto));
+}
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -20,6 +20,7 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "src/common/base/base.h"
 #include "src/common/base/file.h"
@@ -69,20 +70,55 @@ StatusOr<std::string> CGroupMetadataReader::PodPath(PodQOSClass qos_class, std::
   return error::Internal("No valid cgroup path resolver.");
 }
 
+StatusOr<const std::string*> CGroupMetadataReader::CachedPodPath(
+    PodQOSClass qos_class, std::string_view pod_id, std::string_view container_id,
+    ContainerType container_type) const {
+  auto iter = path_cache_.find(container_id);
+  if (iter == path_cache_.end() || iter->second.qos_class != qos_class) {
+    PL_ASSIGN_OR_RETURN(std::string path,
+                        PodPath(qos_class, pod_id, container_id, container_type));
+    iter = path_cache_.insert_or_assign(std::string(container_id),
+                                        CachedPath{qos_class, std::move(path), 0})
+               .first;
+  }
+  iter->second.last_read = num_reads_;
+  return &iter->second.path;
+}
+
+void CGroupMetadataReader::SweepPathCache() const {
+  // Containers are read once per metadata update, so two updates worth of reads since the previous
+  // sweep read every container that is still running.
+  if (num_reads_ - last_sweep_ < 2 * path_cache_.size()) {
+    return;
+  }
+  for (auto iter = path_cache_.begin(); iter != path_cache_.end();) {
+    if (iter->second.last_read <= last_sweep_) {
+      path_cache_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  last_sweep_ = num_reads_;
+}
+
 Status CGroupMetadataReader::ReadPIDs(PodQOSClass qos_class, std::string_view pod_id,
                                       std::string_view container_id, ContainerType container_type,
                                       absl::flat_hash_set<uint32_t>* pid_set) const {
   CHECK(pid_set != nullptr);
 
-  // The container files need to be recursively read and the PIDs needs be merge across all
-  // containers.
+  absl::MutexLock lock(&mutex_);
+  ++num_reads_;
+  SweepPathCache();
 
-  PL_ASSIGN_OR_RETURN(std::string fpath, PodPath(qos_class, pod_id, container_id, container_type));
+  PL_ASSIGN_OR_RETURN(const std::string* fpath,
+                      CachedPodPath(qos_class, pod_id, container_id, container_type));
 
-  std::ifstream ifs(fpath);
+  std::ifstream ifs(*fpath);
   if (!ifs) {
     // This might not be a real error since the pod could have disappeared.
-    return error::NotFound("Failed to open file $0", fpath);
+    Status s = error::NotFound("Failed to open file $0", *fpath);
+    path_cache_.erase(container_id);
+    return s;
   }
 
   std::string line;
@@ -92,7 +128,7 @@ Status CGroupMetadataReader::ReadPIDs(PodQOSClass qos_class, std::string_view po
     }
     int64_t pid;
     if (!absl::SimpleAtoi(line, &pid)) {
-      LOG(WARNING) << absl::Substitute("Failed to parse pid file: $0", fpath);
+      LOG(WARNING) << absl::Substitute("Failed to parse pid file: $0", *fpath);
       continue;
     }
     pid_set->emplace(pid);
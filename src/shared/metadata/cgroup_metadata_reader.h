@@ -25,6 +25,10 @@
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/cgroup_path_resolver.h"
@@ -55,11 +59,36 @@ class CGroupMetadataReader : public NotCopyable {
                           absl::flat_hash_set<uint32_t>* pid_set) const;
 
  private:
+  struct CachedPath {
+    PodQOSClass qos_class;
+    std::string path;
+    // The read that last used the path.
+    uint64_t last_read;
+  };
+
   StatusOr<std::string> PodPath(PodQOSClass qos_class, std::string_view pod_id,
                                 std::string_view container_id, ContainerType container_type) const;
 
+  // Returns the path of the container from the cache, or resolves and caches it.
+  StatusOr<const std::string*> CachedPodPath(PodQOSClass qos_class, std::string_view pod_id,
+                                             std::string_view container_id,
+                                             ContainerType container_type) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Drops the paths of the containers that weren't read since the previous sweep.
+  void SweepPathCache() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   std::unique_ptr<LegacyCGroupPathResolver> legacy_path_resolver_;
   std::unique_ptr<CGroupPathResolver> path_resolver_;
+
+  // Every container is read on every metadata update, so its path is resolved once and kept
+  // until the container stops being read.
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<std::string, CachedPath> path_cache_ ABSL_GUARDED_BY(mutex_);
+  mutable uint64_t num_reads_ ABSL_GUARDED_BY(mutex_) = 0;
+  mutable uint64_t last_sweep_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  FRIEND_TEST(CGroupMetadataReaderTest, caches_pod_paths);
 };
 
 }  // namespace md
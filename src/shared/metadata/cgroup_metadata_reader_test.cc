@@ -78,5 +78,35 @@ TEST_F(CGroupMetadataReaderTest, read_pid_list) {
   EXPECT_THAT(pid_set, ::testing::UnorderedElementsAre(123, 456, 789));
 }
 
+TEST_F(CGroupMetadataReaderTest, caches_pod_paths) {
+  absl::flat_hash_set<uint32_t> pid_set;
+  ASSERT_OK(md_reader_->ReadPIDs(PodQOSClass::kBestEffort, "abcd", "c123", ContainerType::kDocker,
+                                 &pid_set));
+  pid_set.clear();
+  ASSERT_OK(md_reader_->ReadPIDs(PodQOSClass::kBestEffort, "abcd", "c123", ContainerType::kDocker,
+                                 &pid_set));
+  EXPECT_THAT(pid_set, ::testing::UnorderedElementsAre(123, 456, 789));
+  {
+    absl::MutexLock lock(&md_reader_->mutex_);
+    EXPECT_EQ(md_reader_->path_cache_.size(), 1);
+  }
+
+  // Containers that can't be read aren't kept.
+  EXPECT_NOT_OK(md_reader_->ReadPIDs(PodQOSClass::kBestEffort, "abcd", "c456",
+                                     ContainerType::kDocker, &pid_set));
+  {
+    absl::MutexLock lock(&md_reader_->mutex_);
+    EXPECT_EQ(md_reader_->path_cache_.size(), 1);
+  }
+
+  // The path is resolved again if the QoS class of the pod changed.
+  EXPECT_NOT_OK(md_reader_->ReadPIDs(PodQOSClass::kBurstable, "abcd", "c123",
+                                     ContainerType::kDocker, &pid_set));
+  {
+    absl::MutexLock lock(&md_reader_->mutex_);
+    EXPECT_TRUE(md_reader_->path_cache_.empty());
+  }
+}
+
 }  // namespace md
 }  // namespace px
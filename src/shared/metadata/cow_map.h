@@ -0,0 +1,217 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace md {
+
+/**
+ * CowMap is a hash map whose copies share their contents, so that copying it is cheap
+ * no matter how many entries it holds. Entries are spread over a fixed number of shards, which
+ * are copied on write: a modification copies only the shard of the key, and only if the shard
+ * is still shared with another copy of the map. The cost of a batch of modifications on a copy
+ * therefore depends on the number of modifications, not on the size of the map.
+ *
+ * This is what allows metadata state snapshots to be cloned on every update. Readers of older
+ * snapshots are not affected by modifications of newer ones.
+ *
+ * The values are copied along with their shard. For values that are expensive to copy, use a
+ * std::shared_ptr, and copy the pointee before modifying it if it is shared (see Unshare()).
+ *
+ * Like the metadata state that uses it, a CowMap is not thread-safe, but distinct copies can be
+ * used by different threads.
+ */
+template <typename K, typename V, typename Hash = typename absl::flat_hash_map<K, V>::hasher,
+          typename Eq = typename absl::flat_hash_map<K, V>::key_equal>
+class CowMap {
+ public:
+  using Map = absl::flat_hash_map<K, V, Hash, Eq>;
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = typename Map::value_type;
+
+  static constexpr int kShardBits = 8;
+  static constexpr size_t kNumShards = size_t{1} << kShardBits;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return *iter_; }
+    pointer operator->() const { return &*iter_; }
+
+    const_iterator& operator++() {
+      ++iter_;
+      SkipEmptyShards();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.shard_ == b.shard_ && (a.shard_ == kNumShards || a.iter_ == b.iter_);
+    }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+
+   private:
+    friend class CowMap;
+
+    const_iterator(const CowMap* map, size_t shard, typename Map::const_iterator iter)
+        : map_(map), shard_(shard), iter_(iter) {}
+
+    // Moves to the next entry, if the iterator is at the end of a shard.
+    void SkipEmptyShards() {
+      while (shard_ < kNumShards && iter_ == map_->shards_[shard_]->end()) {
+        shard_ = map_->NextShard(shard_ + 1);
+        if (shard_ < kNumShards) {
+          iter_ = map_->shards_[shard_]->begin();
+        }
+      }
+    }
+
+    const CowMap* map_ = nullptr;
+    size_t shard_ = kNumShards;
+    typename Map::const_iterator iter_;
+  };
+  // The entries can't be modified through iterators, only through mutable_value() and the like.
+  using iterator = const_iterator;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const {
+    const size_t shard = NextShard(0);
+    if (shard == kNumShards) {
+      return end();
+    }
+    const_iterator iter(this, shard, shards_[shard]->begin());
+    iter.SkipEmptyShards();
+    return iter;
+  }
+  const_iterator end() const { return const_iterator(this, kNumShards, {}); }
+
+  template <typename Q>
+  const_iterator find(const Q& key) const {
+    const size_t shard = ShardIndex(key);
+    if (shards_[shard] == nullptr) {
+      return end();
+    }
+    auto iter = shards_[shard]->find(key);
+    if (iter == shards_[shard]->end()) {
+      return end();
+    }
+    return const_iterator(this, shard, iter);
+  }
+
+  template <typename Q>
+  bool contains(const Q& key) const {
+    return find(key) != end();
+  }
+
+  /**
+   * Returns a pointer to the value of the key, which may be modified, or nullptr if there is none.
+   */
+  template <typename Q>
+  V* mutable_value(const Q& key) {
+    if (!contains(key)) {
+      return nullptr;
+    }
+    return &MutableShard(ShardIndex(key))->find(key)->second;
+  }
+
+  /**
+   * Returns the value of the key, which is default constructed if there was none.
+   */
+  V& operator[](const K& key) {
+    auto [iter, inserted] = MutableShard(ShardIndex(key))->try_emplace(key);
+    if (inserted) {
+      ++size_;
+    }
+    return iter->second;
+  }
+
+  template <typename Q>
+  size_t erase(const Q& key) {
+    if (!contains(key)) {
+      return 0;
+    }
+    MutableShard(ShardIndex(key))->erase(key);
+    --size_;
+    return 1;
+  }
+
+ private:
+  template <typename Q>
+  static size_t ShardIndex(const Q& key) {
+    // Mix the hash, so that the shard does not depend on the same bits as the slot in the shard.
+    const uint64_t hash = Hash{}(key);
+    return (hash * 0x9E3779B97F4A7C15ULL) >> (64 - kShardBits);
+  }
+
+  // Returns the first non-empty shard, starting at the specified one.
+  size_t NextShard(size_t shard) const {
+    while (shard < kNumShards && (shards_[shard] == nullptr || shards_[shard]->empty())) {
+      ++shard;
+    }
+    return shard;
+  }
+
+  Map* MutableShard(size_t shard) {
+    std::shared_ptr<Map>& ptr = shards_[shard];
+    if (ptr == nullptr) {
+      ptr = std::make_shared<Map>();
+    } else if (ptr.use_count() > 1) {
+      ptr = std::make_shared<Map>(*ptr);
+    }
+    return ptr.get();
+  }
+
+  std::array<std::shared_ptr<Map>, kNumShards> shards_;
+  size_t size_ = 0;
+};
+
+/**
+ * Makes *ptr the sole owner of its pointee, by copying the pointee if it is shared with other
+ * copies of a CowMap, and returns the pointee for modification. T must provide Clone().
+ */
+template <typename T>
+T* Unshare(std::shared_ptr<T>* ptr) {
+  if (ptr->use_count() > 1) {
+    *ptr = std::shared_ptr<T>(static_cast<T*>((*ptr)->Clone().release()));
+  }
+  return ptr->get();
+}
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/metadata/cow_map.h"
+
+namespace px {
+namespace md {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(CowMapTest, Basic) {
+  CowMap<std::string, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+
+  map["a"] = 1;
+  map["b"] = 2;
+  map["b"] = 3;
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("a", 1), Pair("b", 3)));
+
+  // Heterogeneous lookups.
+  ASSERT_TRUE(map.find(std::string_view("a")) != map.end());
+  EXPECT_EQ(map.find(std::string_view("a"))->second, 1);
+  EXPECT_TRUE(map.find("c") == map.end());
+  EXPECT_EQ(map.mutable_value("c"), nullptr);
+
+  *map.mutable_value("a") = 4;
+  EXPECT_EQ(map.erase("b"), 1);
+  EXPECT_EQ(map.erase("b"), 0);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("a", 4)));
+}
+
+TEST(CowMapTest, CopiesAreIndependent) {
+  CowMap<int, int> map;
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = i;
+  }
+
+  CowMap<int, int> copy = map;
+  copy[1000] = 1000;
+  *copy.mutable_value(0) = -1;
+  copy.erase(1);
+
+  EXPECT_EQ(map.size(), 1000);
+  EXPECT_EQ(map.find(0)->second, 0);
+  EXPECT_TRUE(map.contains(1));
+  EXPECT_FALSE(map.contains(1000));
+
+  EXPECT_EQ(copy.size(), 1000);
+  EXPECT_EQ(copy.find(0)->second, -1);
+  EXPECT_FALSE(copy.contains(1));
+  EXPECT_TRUE(copy.contains(1000));
+
+  // Iteration visits every entry once.
+  std::map<int, int> entries(copy.begin(), copy.end());
+  EXPECT_EQ(entries.size(), copy.size());
+}
+
+struct Object {
+  explicit Object(int v) : value(v) {}
+  std::unique_ptr<Object> Clone() const { return std::make_unique<Object>(value); }
+  int value;
+};
+
+TEST(CowMapTest, UnshareCopiesSharedValues) {
+  CowMap<int, std::shared_ptr<Object>> map;
+  map[1] = std::make_shared<Object>(1);
+  const Object* orig = map.find(1)->second.get();
+
+  // Not shared with any copy: modified in place.
+  EXPECT_EQ(Unshare(map.mutable_value(1)), orig);
+
+  CowMap<int, std::shared_ptr<Object>> copy = map;
+  Object* unshared = Unshare(copy.mutable_value(1));
+  EXPECT_NE(unshared, orig);
+  unshared->value = 2;
+
+  EXPECT_EQ(map.find(1)->second->value, 1);
+  EXPECT_EQ(copy.find(1)->second->value, 2);
+}
+
+}  // namespace md
+}  // namespace px
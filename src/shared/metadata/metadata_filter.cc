@@ -22,6 +22,11 @@
 #include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
 #include "src/shared/metadata/metadata_filter.h"
 
+DEFINE_bool(metadata_filter_blocked_bloom_filter,
+            gflags::BoolFromEnv("PL_METADATA_FILTER_BLOCKED_BLOOM_FILTER", false),
+            "Whether agents store their metadata in cache line blocked bloom filters, which are "
+            "faster to query. Only enable it once every reader of the filters supports them.");
+
 namespace px {
 namespace md {
 
@@ -30,6 +30,8 @@
 #include "src/shared/bloomfilter/bloomfilter.h"
 #include "src/shared/metadatapb/metadata.pb.h"
 
+DECLARE_bool(metadata_filter_blocked_bloom_filter);
+
 namespace px {
 namespace md {
 
@@ -108,7 +110,10 @@ class AgentMetadataFilterImpl : public AgentMetadataFilter {
  public:
   static StatusOr<std::unique_ptr<AgentMetadataFilter>> Create(
       int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& types) {
-    PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::Create(max_entries, error_rate));
+    auto layout = FLAGS_metadata_filter_blocked_bloom_filter
+                      ? XXHash64BloomFilter::Layout::kBlocked
+                      : XXHash64BloomFilter::Layout::kFlat;
+    PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::Create(max_entries, error_rate, layout));
     return std::unique_ptr<AgentMetadataFilter>(new AgentMetadataFilterImpl(std::move(bf), types));
   }
 
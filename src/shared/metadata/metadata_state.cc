@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_set.h>
 
@@ -67,6 +68,26 @@ const ContainerInfo* K8sMetadataState::ContainerInfoByID(CIDView id) const {
   return it->second.get();
 }
 
+ContainerInfo* K8sMetadataState::MutableContainerInfoByID(CIDView id) {
+  auto* cinfo = containers_by_id_.mutable_value(id);
+  if (cinfo == nullptr) {
+    return nullptr;
+  }
+  return Unshare(cinfo);
+}
+
+ContainerInfo* K8sMetadataState::StopContainer(CIDView id, int64_t stop_time_ns) {
+  ContainerInfo* cinfo = MutableContainerInfoByID(id);
+  if (cinfo == nullptr) {
+    return nullptr;
+  }
+  if (cinfo->stop_time_ns() != stop_time_ns) {
+    cinfo->set_stop_time_ns(stop_time_ns);
+    stopped_containers_.Add(cinfo->cid(), stop_time_ns);
+  }
+  return cinfo;
+}
+
 UID K8sMetadataState::PodIDByName(K8sNameIdentView pod_name) const {
   auto it = pods_by_name_.find(pod_name);
   return (it == pods_by_name_.end()) ? "" : it->second;
@@ -103,22 +124,17 @@ std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
   other->pod_cidrs_ = pod_cidrs_;
   other->service_cidr_ = service_cidr_;
 
-  other->k8s_objects_by_id_.reserve(k8s_objects_by_id_.size());
-  for (const auto& [k, v] : k8s_objects_by_id_) {
-    other->k8s_objects_by_id_[k] = v->Clone();
-  }
-
-  other->containers_by_id_.reserve(containers_by_id_.size());
-  for (const auto& [k, v] : containers_by_id_) {
-    other->containers_by_id_[k] = v->Clone();
-  }
-
+  // The maps share their contents with this state. Objects are copied as they get modified.
+  other->k8s_objects_by_id_ = k8s_objects_by_id_;
+  other->containers_by_id_ = containers_by_id_;
   other->pods_by_name_ = pods_by_name_;
   other->services_by_name_ = services_by_name_;
   other->namespaces_by_name_ = namespaces_by_name_;
   other->containers_by_name_ = containers_by_name_;
   other->pods_by_ip_ = pods_by_ip_;
   other->services_by_cluster_ip_ = services_by_cluster_ip_;
+  other->stopped_objects_ = stopped_objects_;
+  other->stopped_containers_ = stopped_containers_;
 
   return other;
 }
@@ -159,13 +175,17 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(object_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto pod = std::make_unique<PodInfo>(update);
+  auto* pod_ptr = k8s_objects_by_id_.mutable_value(object_uid);
+  int64_t prev_stop_time_ns = 0;
+  if (pod_ptr != nullptr) {
+    prev_stop_time_ns = (*pod_ptr)->stop_time_ns();
+  } else {
+    auto pod = std::make_shared<PodInfo>(update);
     VLOG(1) << "Adding Pod: " << pod->DebugString();
-    it = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
+    pod_ptr = &k8s_objects_by_id_[object_uid];
+    *pod_ptr = std::move(pod);
   }
-  auto pod_info = static_cast<PodInfo*>(it->second.get());
+  auto pod_info = static_cast<PodInfo*>(Unshare(pod_ptr));
 
   // We always just add to the container set even if the container is stopped.
   // We expect all cleanup to happen periodically to allow stale objects to be queried for some
@@ -174,7 +194,8 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   // state might be periodically inconsistent.
 
   for (const auto& cid : update.container_ids()) {
-    if (containers_by_id_.find(cid) == containers_by_id_.end()) {
+    auto cinfo_it = containers_by_id_.find(cid);
+    if (cinfo_it == containers_by_id_.end()) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
@@ -183,11 +204,17 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     }
 
     pod_info->AddContainer(cid);
-    containers_by_id_[cid]->set_pod_id(object_uid);
+    // Modifications copy the container info if it is shared, so only make them when needed.
+    if (cinfo_it->second->pod_id() != object_uid) {
+      Unshare(containers_by_id_.mutable_value(cid))->set_pod_id(object_uid);
+    }
   }
 
   pod_info->set_start_time_ns(update.start_timestamp_ns());
   pod_info->set_stop_time_ns(update.stop_timestamp_ns());
+  if (update.stop_timestamp_ns() != prev_stop_time_ns) {
+    stopped_objects_.Add(object_uid, update.stop_timestamp_ns());
+  }
   pod_info->set_node_name(update.node_name());
   pod_info->set_hostname(update.hostname());
   pod_info->set_pod_ip(update.pod_ip());
@@ -208,16 +235,23 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
 Status K8sMetadataState::HandleContainerUpdate(const ContainerUpdate& update) {
   const CID& cid = update.cid();
 
-  auto it = containers_by_id_.find(cid);
-  if (it == containers_by_id_.end()) {
-    auto container = std::make_unique<ContainerInfo>(update);
+  auto* container_ptr = containers_by_id_.mutable_value(cid);
+  int64_t prev_stop_time_ns = 0;
+  if (container_ptr != nullptr) {
+    prev_stop_time_ns = (*container_ptr)->stop_time_ns();
+  } else {
+    auto container = std::make_shared<ContainerInfo>(update);
     VLOG(1) << "Adding Container: " << container->DebugString();
-    it = containers_by_id_.try_emplace(cid, std::move(container)).first;
+    container_ptr = &containers_by_id_[cid];
+    *container_ptr = std::move(container);
   }
   VLOG(1) << "container update: " << update.name();
 
-  auto* container_info = it->second.get();
+  auto* container_info = Unshare(container_ptr);
   container_info->set_stop_time_ns(update.stop_timestamp_ns());
+  if (update.stop_timestamp_ns() != prev_stop_time_ns) {
+    stopped_containers_.Add(cid, update.stop_timestamp_ns());
+  }
   container_info->set_state(ConvertToContainerState(update.container_state()));
   container_info->set_state_message(update.message());
   container_info->set_state_reason(update.reason());
@@ -232,31 +266,39 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(service_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto service = std::make_unique<ServiceInfo>(service_uid, ns, name);
+  auto* service_ptr = k8s_objects_by_id_.mutable_value(service_uid);
+  if (service_ptr == nullptr) {
+    auto service = std::make_shared<ServiceInfo>(service_uid, ns, name);
     VLOG(1) << "Adding Service: " << service->DebugString();
-    it = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
+    service_ptr = &k8s_objects_by_id_[service_uid];
+    *service_ptr = std::move(service);
   }
-  auto service_info = static_cast<ServiceInfo*>(it->second.get());
+  auto service_info = static_cast<ServiceInfo*>(Unshare(service_ptr));
 
   for (const auto& uid : update.pod_ids()) {
-    if (k8s_objects_by_id_.find(uid) == k8s_objects_by_id_.end()) {
+    auto pod_it = k8s_objects_by_id_.find(uid);
+    if (pod_it == k8s_objects_by_id_.end()) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
       LOG(INFO) << absl::Substitute("Didn't find pod UID $0 for service $1/$2", uid, ns, name);
       continue;
     }
-    ECHECK(k8s_objects_by_id_[uid]->type() == K8sObjectType::kPod);
+    ECHECK(pod_it->second->type() == K8sObjectType::kPod);
     // We add the service uid to the pod. Lifetime of service still handled by the service object.
-    PodInfo* pod_info = static_cast<PodInfo*>(k8s_objects_by_id_[uid].get());
-    pod_info->AddService(service_uid);
+    // Most updates don't change the services of the pod, so avoid copying it in that case.
+    if (!static_cast<const PodInfo*>(pod_it->second.get())->services().contains(service_uid)) {
+      auto* pod_info = static_cast<PodInfo*>(Unshare(k8s_objects_by_id_.mutable_value(uid)));
+      pod_info->AddService(service_uid);
+    }
   }
   if (update.start_timestamp_ns() != 0) {
     service_info->set_start_time_ns(update.start_timestamp_ns());
   }
   if (update.stop_timestamp_ns() != 0) {
+    if (update.stop_timestamp_ns() != service_info->stop_time_ns()) {
+      stopped_objects_.Add(service_uid, update.stop_timestamp_ns());
+    }
     service_info->set_stop_time_ns(update.stop_timestamp_ns());
   }
   if (update.cluster_ip() != "") {
@@ -279,16 +321,23 @@ Status K8sMetadataState::HandleNamespaceUpdate(const NamespaceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.name();
 
-  auto it = k8s_objects_by_id_.find(namespace_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto ns_obj = std::make_unique<NamespaceInfo>(namespace_uid, ns, name);
+  auto* ns_ptr = k8s_objects_by_id_.mutable_value(namespace_uid);
+  int64_t prev_stop_time_ns = 0;
+  if (ns_ptr != nullptr) {
+    prev_stop_time_ns = (*ns_ptr)->stop_time_ns();
+  } else {
+    auto ns_obj = std::make_shared<NamespaceInfo>(namespace_uid, ns, name);
     VLOG(1) << "Adding Namespace: " << ns_obj->DebugString();
-    it = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
+    ns_ptr = &k8s_objects_by_id_[namespace_uid];
+    *ns_ptr = std::move(ns_obj);
   }
-  auto ns_info = static_cast<NamespaceInfo*>(it->second.get());
+  auto ns_info = static_cast<NamespaceInfo*>(Unshare(ns_ptr));
 
   ns_info->set_start_time_ns(update.start_timestamp_ns());
   ns_info->set_stop_time_ns(update.stop_timestamp_ns());
+  if (update.stop_timestamp_ns() != prev_stop_time_ns) {
+    stopped_objects_.Add(namespace_uid, update.stop_timestamp_ns());
+  }
 
   VLOG(1) << "namespace update: " << update.name();
 
@@ -310,19 +359,19 @@ bool IsExpired(const T& obj, int64_t retention_time, int64_t now) {
 Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
   int64_t now = CurrentTimeNS();
 
-  for (auto iter = k8s_objects_by_id_.begin(); iter != k8s_objects_by_id_.end();) {
-    const auto& k8s_object = iter->second;
-
-    if (!IsExpired(*k8s_object, retention_time_ns, now)) {
-      ++iter;
+  // The index may hold objects whose stop time changed since, or that are already gone.
+  for (const UID& uid : stopped_objects_.PopBefore(now - retention_time_ns)) {
+    auto iter = k8s_objects_by_id_.find(uid);
+    if (iter == k8s_objects_by_id_.end() || !IsExpired(*iter->second, retention_time_ns, now)) {
       continue;
     }
-
+    // Hold on to the object, its entry is erased below.
+    std::shared_ptr<K8sMetadataObject> k8s_object = iter->second;
     switch (k8s_object->type()) {
       case K8sObjectType::kPod:
         if (PodIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          pods_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          pods_by_name_.erase(std::make_pair(k8s_object->ns(), k8s_object->name()));
         }
         if (PodIDByIP(static_cast<PodInfo*>(k8s_object.get())->pod_ip()) ==
             k8s_object
@@ -334,13 +383,13 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
       case K8sObjectType::kNamespace:
         if (NamespaceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          namespaces_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          namespaces_by_name_.erase(std::make_pair(k8s_object->ns(), k8s_object->name()));
         }
         break;
       case K8sObjectType::kService:
         if (ServiceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
             k8s_object->uid()) {
-          services_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+          services_by_name_.erase(std::make_pair(k8s_object->ns(), k8s_object->name()));
         }
         break;
       default:
@@ -348,19 +397,16 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t retention_time_ns) {
                                         static_cast<int>(k8s_object->type()));
     }
 
-    k8s_objects_by_id_.erase(iter++);
+    k8s_objects_by_id_.erase(uid);
   }
 
-  for (auto iter = containers_by_id_.begin(); iter != containers_by_id_.end();) {
-    const auto& cinfo = iter->second;
-
-    if (!IsExpired(*cinfo, retention_time_ns, now)) {
-      ++iter;
+  for (const CID& cid : stopped_containers_.PopBefore(now - retention_time_ns)) {
+    auto iter = containers_by_id_.find(cid);
+    if (iter == containers_by_id_.end() || !IsExpired(*iter->second, retention_time_ns, now)) {
       continue;
     }
-
-    containers_by_name_.erase(cinfo->name());
-    containers_by_id_.erase(iter++);
+    containers_by_name_.erase(iter->second->name());
+    containers_by_id_.erase(cid);
   }
 
   return Status::OK();
@@ -372,14 +418,22 @@ std::shared_ptr<AgentMetadataState> AgentMetadataState::CloneToShared() const {
   state->epoch_id_ = epoch_id_;
   state->asid_ = asid_;
   state->k8s_metadata_state_ = k8s_metadata_state_->Clone();
-  state->pids_by_upid_.reserve(pids_by_upid_.size());
-  for (const auto& [k, v] : pids_by_upid_) {
-    state->pids_by_upid_[k] = v->Clone();
-  }
+  state->pids_by_upid_ = pids_by_upid_;
   state->upids_ = upids_;
+  state->stopped_upids_ = stopped_upids_;
   return state;
 }
 
+void AgentMetadataState::CleanupExpiredPIDs(int64_t retention_time_ns) {
+  int64_t now = CurrentTimeNS();
+  for (const UPID& upid : stopped_upids_.PopBefore(now - retention_time_ns)) {
+    auto iter = pids_by_upid_.find(upid);
+    if (iter != pids_by_upid_.end() && IsExpired(*iter->second, retention_time_ns, now)) {
+      pids_by_upid_.erase(upid);
+    }
+  }
+}
+
 std::string AgentMetadataState::DebugString(int indent_level) const {
   std::string str;
   std::string prefix = Indent(indent_level);
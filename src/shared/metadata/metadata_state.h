@@ -28,8 +28,10 @@
 
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/cow_map.h"
 #include "src/shared/metadata/k8s_objects.h"
 #include "src/shared/metadata/pids.h"
+#include "src/shared/metadata/stop_time_index.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
@@ -38,10 +40,15 @@ namespace md {
 using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
 using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
 using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+using PIDInfoMap = CowMap<UPID, std::shared_ptr<PIDInfo>>;
 using AgentID = sole::uuid;
 
 /**
  * This class contains all kubernetes relate metadata.
+ *
+ * The maps are copy-on-write, and the objects are shared between copies until they are modified,
+ * so that Clone() is cheap and the cost of applying updates to the clone depends on the number
+ * of updates rather than on the size of the cluster.
  */
 class K8sMetadataState : NotCopyable {
  public:
@@ -90,15 +97,16 @@ class K8sMetadataState : NotCopyable {
       }
     };
   };
-  using K8sEntityByNameMap =
-      absl::flat_hash_map<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
+  using K8sEntityByNameMap = CowMap<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
 
   using PodsByNameMap = K8sEntityByNameMap;
   using ServicesByNameMap = K8sEntityByNameMap;
   using NamespacesByNameMap = K8sEntityByNameMap;
-  using ContainersByNameMap = absl::flat_hash_map<std::string, CID>;
-  using PodsByPodIpMap = absl::flat_hash_map<std::string, UID>;
-  using ServicesByServiceIpMap = absl::flat_hash_map<std::string, UID>;
+  using ContainersByNameMap = CowMap<std::string, CID>;
+  using PodsByPodIpMap = CowMap<std::string, UID>;
+  using ServicesByServiceIpMap = CowMap<std::string, UID>;
+  using K8sObjectsByIDMap = CowMap<UID, std::shared_ptr<K8sMetadataObject>>;
+  using ContainersByIDMap = CowMap<CID, std::shared_ptr<ContainerInfo>>;
 
   void set_service_cidr(CIDRBlock cidr) {
     if (!service_cidr_.has_value() || service_cidr_.value() != cidr) {
@@ -113,6 +121,8 @@ class K8sMetadataState : NotCopyable {
   const std::vector<CIDRBlock>& pod_cidrs() const { return pod_cidrs_; }
 
   const PodsByNameMap& pods_by_name() const { return pods_by_name_; }
+  const PodsByPodIpMap& pods_by_ip() const { return pods_by_ip_; }
+  const ServicesByServiceIpMap& services_by_cluster_ip() const { return services_by_cluster_ip_; }
 
   /**
    * PodInfoByID gets an unowned pointer to the Pod. This pointer will remain active
@@ -196,7 +206,26 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  const ContainersByIDMap& containers_by_id() const { return containers_by_id_; }
+
+  /**
+   * MutableContainerInfoByID returns the container info by ID, for modification. The container
+   * info is copied first if it is shared with other copies of this state.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* MutableContainerInfoByID(CIDView id);
+
+  /**
+   * StopContainer sets the stop time of the container, and returns it for further modification.
+   * Stop times must be set this way, or through updates, for CleanupExpiredMetadata() to find
+   * the container once it expires.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* StopContainer(CIDView id, int64_t stop_time_ns);
+
+
   std::string DebugString(int indent_level = 0) const;
 
  private:
@@ -209,10 +238,10 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  K8sObjectsByIDMap k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  ContainersByIDMap containers_by_id_;
 
   /**
    * Mapping of pods by name.
@@ -243,6 +272,13 @@ class K8sMetadataState : NotCopyable {
    * Mapping of Services by Cluster IP.
    */
   ServicesByServiceIpMap services_by_cluster_ip_;
+
+  /**
+   * The stopped K8s objects and containers by stop time, so that cleanup only visits the expired
+   * ones.
+   */
+  StopTimeIndex<UID> stopped_objects_;
+  StopTimeIndex<CID> stopped_containers_;
 };
 
 class AgentMetadataState : NotCopyable {
@@ -277,7 +313,7 @@ class AgentMetadataState : NotCopyable {
 
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
-  PIDInfo* GetPIDByUPID(UPID upid) const {
+  const PIDInfo* GetPIDByUPID(UPID upid) const {
     auto it = pids_by_upid_.find(upid);
     if (it != pids_by_upid_.end()) {
       return it->second.get();
@@ -294,19 +330,25 @@ class AgentMetadataState : NotCopyable {
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
+    auto* pid_info = pids_by_upid_.mutable_value(upid);
     if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
+      Unshare(pid_info)->set_stop_time_ns(ts);
+      stopped_upids_.Add(upid, ts);
       upids_.erase(upid);
     } else {
       DCHECK(!upids_.contains(upid));
     }
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const PIDInfoMap& pids_by_upid() const { return pids_by_upid_; }
 
   const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
 
+  /**
+   * Removes the PIDs that stopped more than retention_time_ns ago.
+   */
+  void CleanupExpiredPIDs(int64_t retention_time_ns);
+
   std::string DebugString(int indent_level = 0) const;
 
  private:
@@ -333,7 +375,7 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  PIDInfoMap pids_by_upid_;
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
@@ -341,6 +383,9 @@ class AgentMetadataState : NotCopyable {
    * it is tracked separately as a performance optimization.
    */
   absl::flat_hash_set<md::UPID> upids_;
+
+  // The stopped PIDs by stop time, so that cleanup only visits the expired ones.
+  StopTimeIndex<UPID> stopped_upids_;
 };
 
 }  // namespace md
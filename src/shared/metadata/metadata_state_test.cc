@@ -169,6 +169,37 @@ TEST(K8sMetadataStateTest, CloneCopiedCIDR) {
   EXPECT_EQ(service_cidr.prefix_length, state_copy->service_cidr()->prefix_length);
 }
 
+TEST(K8sMetadataStateTest, CloneIsIndependent) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update))
+      << "Failed to parse proto";
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update))
+      << "Failed to parse proto";
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  auto state_copy = state.Clone();
+  // Unmodified objects are shared by the copies.
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+
+  pod_update.set_stop_timestamp_ns(1000);
+  pod_update.set_pod_ip("1.2.3.5");
+  EXPECT_OK(state_copy->HandlePodUpdate(pod_update));
+  state_copy->MutableContainerInfoByID("container0_uid")->mutable_active_upids()->emplace(1, 2, 3);
+
+  EXPECT_EQ(1000, state_copy->PodInfoByID("pod0_uid")->stop_time_ns());
+  EXPECT_EQ("pod0_uid", state_copy->PodIDByIP("1.2.3.5"));
+  EXPECT_EQ(1, state_copy->ContainerInfoByID("container0_uid")->active_upids().size());
+
+  EXPECT_EQ(103, state.PodInfoByID("pod0_uid")->stop_time_ns());
+  EXPECT_EQ("", state.PodIDByIP("1.2.3.5"));
+  EXPECT_EQ("pod0_uid", state.PodIDByIP("1.2.3.4"));
+  EXPECT_EQ(0, state.ContainerInfoByID("container0_uid")->active_upids().size());
+}
+
 TEST(K8sMetadataStateTest, HandleContainerUpdate) {
   K8sMetadataState state;
 
@@ -421,5 +452,67 @@ TEST(K8sMetadataStateTest, CleanupExpiredMetadata) {
   }
 }
 
+TEST(K8sMetadataStateTest, CleanupExpiredMetadataAfterStopTimeChange) {
+  K8sMetadataState state;
+
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update));
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  // The pod stops again, at a time that hasn't expired yet.
+  int64_t current_time = CurrentTimeNS();
+  pod_update.set_stop_timestamp_ns(current_time);
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  int64_t retention_time = 3600LL * 1'000'000'000LL;
+  ASSERT_OK(state.CleanupExpiredMetadata(retention_time));
+  EXPECT_NE(nullptr, state.PodInfoByID("pod0_uid"));
+
+  ASSERT_OK(state.CleanupExpiredMetadata(/* retention_time_ns */ -retention_time));
+  EXPECT_EQ(nullptr, state.PodInfoByID("pod0_uid"));
+}
+
+TEST(K8sMetadataStateTest, CleanupExpiredMetadataOfStoppedContainer) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update));
+  container_update.clear_stop_timestamp_ns();
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+
+  ASSERT_OK(state.CleanupExpiredMetadata(/* retention_time_ns */ 0));
+  ASSERT_NE(nullptr, state.ContainerInfoByID("container0_uid"));
+
+  ASSERT_NE(nullptr, state.StopContainer("container0_uid", 100));
+  EXPECT_EQ(nullptr, state.StopContainer("container1_uid", 100));
+
+  // Clones keep the stopped containers of the original.
+  std::unique_ptr<K8sMetadataState> clone = state.Clone();
+  ASSERT_OK(state.CleanupExpiredMetadata(/* retention_time_ns */ 0));
+  EXPECT_EQ(nullptr, state.ContainerInfoByID("container0_uid"));
+  EXPECT_NE(nullptr, clone->ContainerInfoByID("container0_uid"));
+
+  ASSERT_OK(clone->CleanupExpiredMetadata(/* retention_time_ns */ 0));
+  EXPECT_EQ(nullptr, clone->ContainerInfoByID("container0_uid"));
+}
+
+TEST(AgentMetadataStateTest, CleanupExpiredPIDs) {
+  AgentMetadataState state(/* hostname */ "myhost", /* asid */ 1, sole::uuid4(), "mypod");
+
+  UPID upid1(1, 100, 1000);
+  UPID upid2(1, 200, 2000);
+  state.AddUPID(upid1, std::make_unique<PIDInfo>(upid1, "cmd1", "container0_uid"));
+  state.AddUPID(upid2, std::make_unique<PIDInfo>(upid2, "cmd2", "container0_uid"));
+
+  int64_t current_time = CurrentTimeNS();
+  state.MarkUPIDAsStopped(upid1, 100);
+  state.MarkUPIDAsStopped(upid2, current_time);
+
+  int64_t retention_time = 3600LL * 1'000'000'000LL;
+  state.CleanupExpiredPIDs(retention_time);
+  EXPECT_EQ(nullptr, state.GetPIDByUPID(upid1));
+  EXPECT_NE(nullptr, state.GetPIDByUPID(upid2));
+}
+
 }  // namespace md
 }  // namespace px
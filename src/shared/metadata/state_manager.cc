@@ -17,10 +17,13 @@
  */
 
 #include <memory>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include "src/shared/metadata/state_manager.h"
 
 namespace px {
@@ -128,31 +131,128 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   return Status::OK();
 }
 
+namespace {
+
+// The number of K8s updates dequeued at once.
+constexpr size_t kK8sUpdateBatchSize = 1024;
+
+// Returns the object that the update is for, or an empty ID for updates that are not coalesced.
+std::pair<ResourceUpdate::UpdateCase, std::string_view> UpdatedObject(
+    const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      return {update.update_case(), update.pod_update().uid()};
+    case ResourceUpdate::kContainerUpdate:
+      return {update.update_case(), update.container_update().cid()};
+    case ResourceUpdate::kServiceUpdate:
+      return {update.update_case(), update.service_update().uid()};
+    case ResourceUpdate::kNamespaceUpdate:
+      return {update.update_case(), update.namespace_update().uid()};
+    default:
+      return {update.update_case(), ""};
+  }
+}
+
+template <typename TRepeatedField>
+void AddMissing(const TRepeatedField& from, TRepeatedField* to) {
+  absl::flat_hash_set<std::string_view> existing(to->begin(), to->end());
+  for (const auto& value : from) {
+    if (!existing.contains(value)) {
+      *to->Add() = value;
+    }
+  }
+}
+
+// Folds an update into a later update of the same object, so that applying only the later update
+// has the same effect as applying both. Pods and services keep the containers and pods of all
+// their updates, and services only take the fields that are set.
+void MergeIntoLaterUpdate(const ResourceUpdate& earlier, ResourceUpdate* later) {
+  switch (later->update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      AddMissing(earlier.pod_update().container_ids(),
+                 later->mutable_pod_update()->mutable_container_ids());
+      break;
+    case ResourceUpdate::kServiceUpdate: {
+      const ServiceUpdate& from = earlier.service_update();
+      ServiceUpdate* to = later->mutable_service_update();
+      AddMissing(from.pod_ids(), to->mutable_pod_ids());
+      if (to->start_timestamp_ns() == 0) {
+        to->set_start_timestamp_ns(from.start_timestamp_ns());
+      }
+      if (to->stop_timestamp_ns() == 0) {
+        to->set_stop_timestamp_ns(from.stop_timestamp_ns());
+      }
+      if (to->cluster_ip().empty()) {
+        to->set_cluster_ip(from.cluster_ip());
+      }
+      if (to->external_ips().empty()) {
+        *to->mutable_external_ips() = from.external_ips();
+      }
+      break;
+    }
+    default:
+      // The later update replaces everything the earlier one sets.
+      break;
+  }
+}
+
+Status ApplyK8sUpdate(const ResourceUpdate& update, AgentMetadataState* state,
+                      AgentMetadataFilter* metadata_filter) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      return HandlePodUpdate(update.pod_update(), state, metadata_filter);
+    case ResourceUpdate::kContainerUpdate:
+      return HandleContainerUpdate(update.container_update(), state, metadata_filter);
+    case ResourceUpdate::kServiceUpdate:
+      return HandleServiceUpdate(update.service_update(), state, metadata_filter);
+    case ResourceUpdate::kNamespaceUpdate:
+      return HandleNamespaceUpdate(update.namespace_update(), state, metadata_filter);
+    default:
+      LOG(ERROR) << "Unhandled Update Type: " << update.update_case() << " (ignoring)";
+      return Status::OK();
+  }
+}
+
+}  // namespace
+
 Status ApplyK8sUpdates(
     int64_t ts, AgentMetadataState* state, AgentMetadataFilter* metadata_filter,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>>* updates) {
-  std::unique_ptr<ResourceUpdate> update(nullptr);
   PL_UNUSED(ts);
 
-  // Returns false when no more items.
-  while (updates->try_dequeue(update)) {
-    switch (update->update_case()) {
-      case ResourceUpdate::kPodUpdate:
-        PL_RETURN_IF_ERROR(HandlePodUpdate(update->pod_update(), state, metadata_filter));
-        break;
-      case ResourceUpdate::kContainerUpdate:
-        PL_RETURN_IF_ERROR(
-            HandleContainerUpdate(update->container_update(), state, metadata_filter));
-        break;
-      case ResourceUpdate::kServiceUpdate:
-        PL_RETURN_IF_ERROR(HandleServiceUpdate(update->service_update(), state, metadata_filter));
-        break;
-      case ResourceUpdate::kNamespaceUpdate:
-        PL_RETURN_IF_ERROR(
-            HandleNamespaceUpdate(update->namespace_update(), state, metadata_filter));
-        break;
-      default:
-        LOG(ERROR) << "Unhandled Update Type: " << update->update_case() << " (ignoring)";
+  // Drain the queue in bulk.
+  std::vector<std::unique_ptr<ResourceUpdate>> batch;
+  size_t num_dequeued = 0;
+  do {
+    batch.resize(batch.size() + kK8sUpdateBatchSize);
+    num_dequeued =
+        updates->try_dequeue_bulk(batch.end() - kK8sUpdateBatchSize, kK8sUpdateBatchSize);
+    batch.resize(batch.size() - kK8sUpdateBatchSize + num_dequeued);
+  } while (num_dequeued == kK8sUpdateBatchSize);
+
+  // During rollouts, the same objects get many updates. Only the last update of each object is
+  // applied, in its position, after it absorbed what the earlier updates contribute. Applying it
+  // later than the earlier updates is fine, since the objects it refers to only get added to.
+  absl::flat_hash_map<std::pair<ResourceUpdate::UpdateCase, std::string_view>, size_t>
+      last_update_of_object;
+  std::vector<bool> superseded(batch.size(), false);
+  for (size_t i = 0; i < batch.size(); ++i) {
+    auto object = UpdatedObject(*batch[i]);
+    if (object.second.empty()) {
+      continue;
+    }
+    auto [iter, inserted] = last_update_of_object.try_emplace(object, i);
+    if (!inserted) {
+      MergeIntoLaterUpdate(*batch[iter->second], batch[i].get());
+      superseded[iter->second] = true;
+      // The key views the superseded update, which stays alive until the end of the batch.
+      iter->second = i;
+    }
+  }
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (!superseded[i]) {
+      PL_RETURN_IF_ERROR(ApplyK8sUpdate(*batch[i], state, metadata_filter));
     }
   }
 
@@ -166,6 +266,20 @@ StatusOr<UPID> InitUPID(const system::ProcParser& proc_parser, uint32_t asid, ui
   return UPID(asid, pid, pid_start_time);
 }
 
+// Returns true if the PIDs in the cgroups differ from the UPIDs tracked for the container.
+bool PIDsChanged(const absl::flat_hash_set<UPID>& upids,
+                 const absl::flat_hash_set<uint32_t>& cgroups_pids) {
+  if (upids.size() != cgroups_pids.size()) {
+    return true;
+  }
+  for (const auto& upid : upids) {
+    if (!cgroups_pids.contains(upid.pid())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 void ProcessContainerPIDUpdates(
@@ -223,6 +337,10 @@ Status ProcessPIDUpdates(
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
   const auto& k8s_md_state = md->k8s_metadata_state();
 
+  // Containers are only modified when their state changes, because a modification copies the
+  // container info if it is shared with the previous metadata state. The map can't be modified
+  // while iterating over it, so collect the live containers first.
+  std::vector<CID> cids;
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
     if (cinfo->stop_time_ns() != 0) {
       // Ignore dead containers.
@@ -231,6 +349,11 @@ Status ProcessPIDUpdates(
       VLOG(1) << "Ignore dead container: " << cinfo->DebugString();
       continue;
     }
+    cids.push_back(cid);
+  }
+
+  for (const CID& cid : cids) {
+    const ContainerInfo* cinfo = k8s_md_state->ContainerInfoByID(cid);
 
     // For every container:
     //   1. Read the current PIDs (from cgroups).
@@ -249,7 +372,7 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->StopContainer(cid, pod_info->stop_time_ns());
       continue;
     }
 
@@ -267,16 +390,21 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        ContainerInfo* mutable_cinfo = k8s_md_state->StopContainer(cid, ts);
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
+    if (!PIDsChanged(cinfo->active_upids(), cgroups_active_pids)) {
+      continue;
+    }
+
+    ProcessContainerPIDUpdates(cid, ts, proc_parser, md,
+                               k8s_md_state->MutableContainerInfoByID(cid)->mutable_active_upids(),
                                &cgroups_active_pids, pid_updates);
   }
 
@@ -285,6 +413,7 @@ Status ProcessPIDUpdates(
 
 Status DeleteMetadataForDeadObjects(AgentMetadataState* state, int64_t retention_time) {
   PL_RETURN_IF_ERROR(state->k8s_metadata_state()->CleanupExpiredMetadata(retention_time));
+  state->CleanupExpiredPIDs(retention_time);
   return Status::OK();
 }
 
@@ -297,6 +297,51 @@ TEST_F(AgentMetadataStateTest, insert_into_filter) {
                           "SERVICE_NAME=pl/service1"));
 }
 
+TEST_F(AgentMetadataStateTest, coalesces_updates_to_the_same_object) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  auto enqueue = [&updates](std::string_view pbtxt) {
+    auto update = std::make_unique<ResourceUpdate>();
+    CHECK(google::protobuf::TextFormat::MergeFromString(std::string(pbtxt), update.get()));
+    updates.enqueue(std::move(update));
+  };
+  enqueue(kUpdate1_0Pbtxt);
+  enqueue(kUpdate2_0Pbtxt);
+  enqueue(R"(pod_update { name: "pod1" namespace: "pl" uid: "pod_id1" start_timestamp_ns: 1000
+                          container_ids: "container_id1" phase: PENDING })");
+  enqueue(R"(service_update { name: "service1" namespace: "pl" uid: "service_id1"
+                              start_timestamp_ns: 1000 cluster_ip: "10.0.0.1" })");
+  enqueue(R"(pod_update { name: "pod1" namespace: "pl" uid: "pod_id1" start_timestamp_ns: 1000
+                          container_ids: "container_id2" phase: RUNNING })");
+  enqueue(R"(service_update { name: "service1" namespace: "pl" uid: "service_id1"
+                              pod_ids: "pod_id1" })");
+  enqueue(R"(container_update { name: "container_name1" cid: "container_id1"
+                                start_timestamp_ns: 1001 stop_timestamp_ns: 1500
+                                container_state: CONTAINER_STATE_TERMINATED })");
+
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+  EXPECT_EQ(0, updates.size_approx());
+
+  K8sMetadataState* state = metadata_state_.k8s_metadata_state();
+  auto* pod_info = state->PodInfoByID("pod_id1");
+  ASSERT_NE(nullptr, pod_info);
+  // Containers and services of superseded updates are kept.
+  EXPECT_THAT(pod_info->containers(), UnorderedElementsAre("container_id1", "container_id2"));
+  EXPECT_EQ(PodPhase::kRunning, pod_info->phase());
+  EXPECT_THAT(pod_info->services(), UnorderedElementsAre("service_id1"));
+
+  // Fields that the last service update doesn't set are kept too.
+  auto* service_info = state->ServiceInfoByID("service_id1");
+  ASSERT_NE(nullptr, service_info);
+  EXPECT_EQ(1000, service_info->start_time_ns());
+  EXPECT_EQ("10.0.0.1", service_info->cluster_ip());
+
+  auto* container_info = state->ContainerInfoByID("container_id1");
+  ASSERT_NE(nullptr, container_info);
+  EXPECT_EQ(ContainerState::kTerminated, container_info->state());
+  EXPECT_EQ(1500, container_info->stop_time_ns());
+  EXPECT_EQ("pod_id1", container_info->pod_id());
+}
+
 TEST_F(AgentMetadataStateTest, cidr_test) {
   AgentMetadataStateManagerImpl mgr("test_host", /*asid*/ 0, "test_pod", /*id*/ sole::uuid4(),
                                     /*collects_data*/ true, px::system::Config::GetInstance(),
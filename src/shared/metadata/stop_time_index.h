@@ -0,0 +1,139 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <absl/container/btree_map.h>
+
+namespace px {
+namespace md {
+
+/**
+ * StopTimeIndex keeps the IDs of stopped objects by their stop time, so that finding the objects
+ * that stopped before a given time only visits those, instead of every object.
+ *
+ * IDs are kept in buckets of kBucketWidthNS of stop time. Entries are never updated: if the
+ * stop time of an object changes, it is added again, so callers have to check the IDs they get
+ * back against the current stop time of the object.
+ *
+ * Like CowMap, copies share their buckets, and a modification only copies the bucket list and the
+ * bucket it modifies, if they are shared with another copy.
+ */
+template <typename TID>
+class StopTimeIndex {
+ public:
+  static constexpr int64_t kBucketWidthNS = 60LL * 1'000'000'000LL;
+
+  /**
+   * Adds the ID of an object that stopped at the specified time. Does nothing if it is 0, since
+   * that means the object hasn't stopped.
+   */
+  void Add(TID id, int64_t stop_time_ns) {
+    if (stop_time_ns == 0) {
+      return;
+    }
+    std::shared_ptr<Bucket>& bucket = (*MutableBuckets())[BucketOf(stop_time_ns)];
+    if (bucket == nullptr) {
+      bucket = std::make_shared<Bucket>();
+    } else if (bucket.use_count() > 1) {
+      bucket = std::make_shared<Bucket>(*bucket);
+    }
+    bucket->push_back(Entry{std::move(id), stop_time_ns});
+  }
+
+  /**
+   * Removes and returns the IDs of the objects that stopped before the specified time.
+   */
+  std::vector<TID> PopBefore(int64_t time_ns) {
+    std::vector<TID> ids;
+    if (buckets_ == nullptr || buckets_->empty() ||
+        buckets_->begin()->first * kBucketWidthNS >= time_ns) {
+      return ids;
+    }
+
+    Buckets* buckets = MutableBuckets();
+    auto iter = buckets->begin();
+    while (iter != buckets->end() && iter->first * kBucketWidthNS < time_ns) {
+      if ((iter->first + 1) * kBucketWidthNS <= time_ns) {
+        for (const Entry& entry : *iter->second) {
+          ids.push_back(entry.id);
+        }
+        iter = buckets->erase(iter);
+        continue;
+      }
+
+      // The bucket of the time itself is the only one that may be partially before it.
+      auto remaining = std::make_shared<Bucket>();
+      for (const Entry& entry : *iter->second) {
+        if (entry.stop_time_ns < time_ns) {
+          ids.push_back(entry.id);
+        } else {
+          remaining->push_back(entry);
+        }
+      }
+      if (remaining->empty()) {
+        buckets->erase(iter);
+      } else {
+        iter->second = std::move(remaining);
+      }
+      break;
+    }
+    return ids;
+  }
+
+  // The number of entries, including the ones of objects whose stop time changed.
+  size_t size() const {
+    size_t size = 0;
+    if (buckets_ != nullptr) {
+      for (const auto& [bucket_index, bucket] : *buckets_) {
+        size += bucket->size();
+      }
+    }
+    return size;
+  }
+
+ private:
+  struct Entry {
+    TID id;
+    int64_t stop_time_ns;
+  };
+  using Bucket = std::vector<Entry>;
+  using Buckets = absl::btree_map<int64_t, std::shared_ptr<Bucket>>;
+
+  static int64_t BucketOf(int64_t time_ns) {
+    // Round down, so that the buckets of negative times are before the one of 0.
+    return time_ns >= 0 ? time_ns / kBucketWidthNS : (time_ns + 1) / kBucketWidthNS - 1;
+  }
+
+  Buckets* MutableBuckets() {
+    if (buckets_ == nullptr) {
+      buckets_ = std::make_shared<Buckets>();
+    } else if (buckets_.use_count() > 1) {
+      buckets_ = std::make_shared<Buckets>(*buckets_);
+    }
+    return buckets_.get();
+  }
+
+  std::shared_ptr<Buckets> buckets_;
+};
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/shared/metadata/stop_time_index.h"
+
+namespace px {
+namespace md {
+
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+constexpr int64_t kBucketWidthNS = StopTimeIndex<std::string>::kBucketWidthNS;
+
+TEST(StopTimeIndexTest, PopBefore) {
+  StopTimeIndex<std::string> index;
+  index.Add("a", 10);
+  index.Add("b", kBucketWidthNS + 10);
+  index.Add("c", kBucketWidthNS + 20);
+  index.Add("d", 3 * kBucketWidthNS);
+  index.Add("running", 0);
+  EXPECT_EQ(4U, index.size());
+
+  EXPECT_THAT(index.PopBefore(10), IsEmpty());
+  EXPECT_THAT(index.PopBefore(kBucketWidthNS + 20), UnorderedElementsAre("a", "b"));
+  EXPECT_EQ(2U, index.size());
+  EXPECT_THAT(index.PopBefore(kBucketWidthNS + 20), IsEmpty());
+  EXPECT_THAT(index.PopBefore(10 * kBucketWidthNS), UnorderedElementsAre("c", "d"));
+  EXPECT_EQ(0U, index.size());
+}
+
+TEST(StopTimeIndexTest, NegativeTimes) {
+  StopTimeIndex<std::string> index;
+  index.Add("a", -10);
+  index.Add("b", 10);
+
+  EXPECT_THAT(index.PopBefore(-5), UnorderedElementsAre("a"));
+  EXPECT_THAT(index.PopBefore(11), UnorderedElementsAre("b"));
+}
+
+TEST(StopTimeIndexTest, CopiesAreIndependent) {
+  StopTimeIndex<std::string> index;
+  index.Add("a", 10);
+  index.Add("b", 20);
+
+  StopTimeIndex<std::string> copy = index;
+  copy.Add("c", 30);
+  EXPECT_THAT(index.PopBefore(15), UnorderedElementsAre("a"));
+
+  EXPECT_EQ(1U, index.size());
+  EXPECT_EQ(3U, copy.size());
+  EXPECT_THAT(copy.PopBefore(kBucketWidthNS), UnorderedElementsAre("a", "b", "c"));
+  EXPECT_THAT(index.PopBefore(kBucketWidthNS), UnorderedElementsAre("b"));
+}
+
+}  // namespace md
+}  // namespace px
@@ -131,12 +131,12 @@ inline int64_t GetArrowArrayBytes(const arrow::Array* arr) {
 
 template <>
 inline int64_t GetArrowArrayBytes<types::DataType::STRING>(const arrow::Array* arr) {
-  int64_t total_bytes = 0;
-  // Loop through each string in the Arrow array.
-  for (int64_t i = 0; i < arr->length(); i++) {
-    total_bytes += sizeof(char) * GetValueFromArrowArray<types::DataType::STRING>(arr, i).length();
+  // The values of a string array are contiguous, so their total size follows from the offsets.
+  auto str_arr = static_cast<const arrow::StringArray*>(arr);
+  if (str_arr->length() == 0) {
+    return 0;
   }
-  return total_bytes;
+  return sizeof(char) * (str_arr->value_offset(str_arr->length()) - str_arr->value_offset(0));
 }
 
 template <types::DataType T>
@@ -24,10 +24,12 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/string_arena.h"
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
@@ -42,6 +44,12 @@ using ColumnWrapperRecordBatch = std::vector<types::SharedColumnWrapper>;
 using TabletID = std::string;
 using TabletIDView = std::string_view;
 
+// The ID of the tablet that holds the rows whose tabletization key has the value.
+inline TabletID ToTabletID(const Int64Value& value) { return std::to_string(value.val); }
+inline TabletID ToTabletID(const UInt128Value& value) {
+  return std::to_string(value.High64()) + ":" + std::to_string(value.Low64());
+}
+
 /**
  * Column wrapper stores underlying data so that it can be retrieved in a type erased way
  * to allow column chucks to be transparently passed.
@@ -140,6 +148,15 @@ class ColumnWrapperTmpl : public ColumnWrapper {
     }
   }
 
+  // Moves the values of src to the end of this column, leaving src empty.
+  void MoveAppend(ColumnWrapperTmpl<T>* src) {
+    data_.reserve(data_.size() + src->data_.size());
+    for (auto& value : src->data_) {
+      data_.push_back(std::move(value));
+    }
+    src->Clear();
+  }
+
   // Return a new SharedColumnWrapper with values according to the spec:
   //    { data[idx[0]], data[idx[1]], data[idx[2]], ... }
   SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const override {
@@ -173,14 +190,193 @@ int64_t ColumnWrapperTmpl<T>::Bytes() const {
   return Size() * sizeof(T);
 }
 
+/**
+ * Specialization for strings. Values appended to the column are kept in a StringArena, so that
+ * appending a row doesn't allocate a string for it, and the arena can be handed to arrow as is
+ * (see ShareAsArrow). Accessing the values mutably, through operator[] or UnsafeRawData(),
+ * moves them to a vector of StringValues, which the column keeps using until it's cleared.
+ *
+ * Columns created with a size > 0 are expected to be written in place, so they start out with
+ * the vector of StringValues.
+ */
 template <>
-inline int64_t ColumnWrapperTmpl<StringValue>::Bytes() const {
-  int64_t bytes = 0;
-  for (const auto& data : data_) {
-    bytes += data.bytes();
+class ColumnWrapperTmpl<StringValue> : public ColumnWrapper {
+ public:
+  explicit ColumnWrapperTmpl(size_t size) : values_(size), materialized_(size > 0) {}
+  explicit ColumnWrapperTmpl(size_t size, const StringValue& val)
+      : values_(size, val), materialized_(true) {}
+  explicit ColumnWrapperTmpl(const std::vector<StringValue>& vals)
+      : values_(vals), materialized_(true) {}
+
+  ~ColumnWrapperTmpl() override = default;
+
+  StringValue* UnsafeRawData() override {
+    Materialize();
+    return values_.data();
+  }
+  // Not safe to call concurrently with other accesses, since it may have to materialize the
+  // values, like the non-const version.
+  const StringValue* UnsafeRawData() const override {
+    Materialize();
+    return values_.data();
+  }
+  DataType data_type() const override { return DataType::STRING; }
+
+  size_t Size() const override { return materialized_ ? values_.size() : arena_.size(); }
+  bool Empty() const override { return Size() == 0; }
+
+  std::shared_ptr<arrow::Array> ConvertToArrow(arrow::MemoryPool* mem_pool) override {
+    if (materialized_) {
+      return ToArrow(values_, mem_pool);
+    }
+    DCHECK(mem_pool != nullptr);
+    arrow::StringBuilder builder(mem_pool);
+    PL_CHECK_OK(builder.Reserve(arena_.size()));
+    PL_CHECK_OK(builder.ReserveData(arena_.bytes()));
+    for (size_t i = 0; i < arena_.size(); ++i) {
+      std::string_view val = arena_[i];
+      builder.UnsafeAppend(val.data(), static_cast<int32_t>(val.size()));
+    }
+    std::shared_ptr<arrow::Array> arr;
+    PL_CHECK_OK(builder.Finish(&arr));
+    return arr;
+  }
+
+  StringValue operator[](size_t idx) const {
+    return materialized_ ? values_[idx] : StringValue(std::string(arena_[idx]));
+  }
+
+  StringValue& operator[](size_t idx) {
+    Materialize();
+    return values_[idx];
+  }
+
+  void Append(StringValue val) {
+    if (materialized_) {
+      values_.push_back(std::move(val));
+    } else {
+      arena_.Append(val);
+    }
+  }
+
+  // Appends a value without requiring a StringValue for it.
+  void AppendView(std::string_view val) {
+    if (materialized_) {
+      values_.emplace_back(std::string(val));
+    } else {
+      arena_.Append(val);
+    }
+  }
+
+  void Reserve(size_t size) override {
+    if (materialized_) {
+      values_.reserve(size);
+    } else {
+      arena_.Reserve(size);
+    }
+  }
+
+  void ShrinkToFit() override {
+    values_.shrink_to_fit();
+    arena_.ShrinkToFit();
+  }
+
+  void Resize(size_t size) {
+    if (materialized_) {
+      values_.resize(size);
+    } else {
+      arena_.Resize(size);
+    }
+  }
+
+  // Clearing the column also returns it to the arena.
+  void Clear() override {
+    std::vector<StringValue>().swap(values_);
+    arena_.Clear();
+    materialized_ = false;
+  }
+
+  int64_t Bytes() const override {
+    if (!materialized_) {
+      return arena_.bytes();
+    }
+    int64_t bytes = 0;
+    for (const auto& data : values_) {
+      bytes += data.bytes();
+    }
+    return bytes;
+  }
+
+  void AppendFromVector(const std::vector<StringValue>& value_vector) {
+    for (const auto& value : value_vector) {
+      AppendView(value);
+    }
   }
-  return bytes;
-}
+
+  void MoveAppend(ColumnWrapperTmpl<StringValue>* src) {
+    if (!materialized_ && !src->materialized_) {
+      arena_.Append(src->arena_);
+    } else {
+      Reserve(Size() + src->Size());
+      for (size_t i = 0; i < src->Size(); ++i) {
+        Append(std::move((*src)[i]));
+      }
+    }
+    src->Clear();
+  }
+
+  // The arena holding the values, or nullptr if they were moved to a vector of StringValues.
+  const StringArena* arena() const { return materialized_ ? nullptr : &arena_; }
+
+  SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const override {
+    DCHECK_LE(indexes.size(), Size());
+    if (materialized_) {
+      auto copy = std::make_shared<ColumnWrapperTmpl<StringValue>>(indexes.size());
+      for (size_t i = 0; i < indexes.size(); ++i) {
+        copy->values_[i] = values_[indexes[i]];
+      }
+      return copy;
+    }
+    auto copy = std::make_shared<ColumnWrapperTmpl<StringValue>>(0);
+    copy->arena_.Reserve(indexes.size(), indexes.size() == arena_.size() ? arena_.bytes() : 0);
+    for (size_t idx : indexes) {
+      copy->arena_.Append(arena_[idx]);
+    }
+    return copy;
+  }
+
+  SharedColumnWrapper MoveIndexes(const std::vector<size_t>& indexes) override {
+    if (!materialized_) {
+      // Copying out of the arena is as cheap as moving.
+      return CopyIndexes(indexes);
+    }
+    DCHECK_LE(indexes.size(), values_.size());
+    auto col = std::make_shared<ColumnWrapperTmpl<StringValue>>(indexes.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+      col->values_[i] = std::move(values_[indexes[i]]);
+    }
+    return col;
+  }
+
+ private:
+  // Moves the values from the arena to values_. It's done even by const accessors, so the
+  // members involved are mutable.
+  void Materialize() const {
+    if (materialized_) {
+      return;
+    }
+    values_.reserve(arena_.size());
+    for (size_t i = 0; i < arena_.size(); ++i) {
+      values_.emplace_back(std::string(arena_[i]));
+    }
+    arena_ = StringArena();
+    materialized_ = true;
+  }
+
+  mutable std::vector<StringValue> values_;
+  mutable StringArena arena_;
+  mutable bool materialized_;
+};
 
 // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
 using BoolValueColumnWrapper = ColumnWrapperTmpl<BoolValue>;
@@ -367,6 +563,73 @@ struct ColumnWrapperType<DataType::STRING> {
   using type = StringValueColumnWrapper;
 };
 
+/**
+ * An arrow::Buffer that references the values of a ColumnWrapper in place,
+ * and keeps the ColumnWrapper alive for as long as the buffer is referenced.
+ */
+class ColumnWrapperBuffer : public arrow::Buffer {
+ public:
+  ColumnWrapperBuffer(SharedColumnWrapper col, const uint8_t* data, int64_t size)
+      : arrow::Buffer(data, size), col_(std::move(col)) {}
+
+ private:
+  SharedColumnWrapper col_;
+};
+
+template <DataType DT>
+inline std::shared_ptr<arrow::Array> ShareFixedSizeAsArrow(const SharedColumnWrapper& col) {
+  using TValueType = typename DataTypeTraits<DT>::value_type;
+  static_assert(sizeof(TValueType) == sizeof(TValueType::val),
+                "Value type must have the same layout as its arrow representation.");
+  const auto* data = reinterpret_cast<const uint8_t*>(
+      static_cast<const ColumnWrapperTmpl<TValueType>*>(col.get())->UnsafeRawData());
+  int64_t length = col->Size();
+  auto buffer = std::make_shared<ColumnWrapperBuffer>(col, data, length * sizeof(TValueType));
+  auto array_data = arrow::ArrayData::Make(DataTypeToArrowType(DT), length,
+                                           {nullptr, std::move(buffer)}, /* null_count */ 0);
+  return arrow::MakeArray(array_data);
+}
+
+inline std::shared_ptr<arrow::Array> ShareStringsAsArrow(const SharedColumnWrapper& col,
+                                                        arrow::MemoryPool* mem_pool) {
+  const StringArena* arena = static_cast<const StringValueColumnWrapper*>(col.get())->arena();
+  if (arena == nullptr) {
+    return col->ConvertToArrow(mem_pool);
+  }
+  int64_t length = arena->size();
+  auto offsets = std::make_shared<ColumnWrapperBuffer>(
+      col, reinterpret_cast<const uint8_t*>(arena->offsets()), (length + 1) * sizeof(int32_t));
+  auto data = std::make_shared<ColumnWrapperBuffer>(
+      col, reinterpret_cast<const uint8_t*>(arena->data()), arena->bytes());
+  auto array_data =
+      arrow::ArrayData::Make(DataTypeToArrowType(DataType::STRING), length,
+                             {nullptr, std::move(offsets), std::move(data)}, /* null_count */ 0);
+  return arrow::MakeArray(array_data);
+}
+
+/**
+ * Returns an arrow array for the column. For INT64, FLOAT64 and TIME64NS, whose values are laid
+ * out in memory exactly as arrow expects, and for STRING columns whose values are still in their
+ * arena, the array references the column's values in place instead of copying them, so the
+ * column must not be modified afterwards.
+ * Other types are converted with ConvertToArrow().
+ */
+inline std::shared_ptr<arrow::Array> ShareAsArrow(const SharedColumnWrapper& col,
+                                                  arrow::MemoryPool* mem_pool) {
+  switch (col->data_type()) {
+    case DataType::INT64:
+      return ShareFixedSizeAsArrow<DataType::INT64>(col);
+    case DataType::FLOAT64:
+      return ShareFixedSizeAsArrow<DataType::FLOAT64>(col);
+    case DataType::TIME64NS:
+      return ShareFixedSizeAsArrow<DataType::TIME64NS>(col);
+    case DataType::STRING:
+      return ShareStringsAsArrow(col, mem_pool);
+    default:
+      return col->ConvertToArrow(mem_pool);
+  }
+}
+
 template <types::DataType DT>
 void ExtractValueToColumnWrapper(ColumnWrapper* wrapper, arrow::Array* arr, int64_t row_idx) {
   static_cast<typename ColumnWrapperType<DT>::type*>(wrapper)->Append(
@@ -283,5 +283,98 @@ TEST(ColumnWrapperTest, MoveIndexes) {
   }
 }
 
+TEST(ColumnWrapper, ShareAsArrowFixedSize) {
+  auto col = ColumnWrapper::Make(DataType::INT64, 0);
+  col->AppendFromVector(std::vector<Int64Value>{5, 8, 1, 9});
+
+  auto arr = ShareAsArrow(col, arrow::default_memory_pool());
+  auto expected = col->ConvertToArrow(arrow::default_memory_pool());
+  EXPECT_TRUE(arr->Equals(expected));
+
+  // The array references the column's values in place.
+  auto typed_arr = std::static_pointer_cast<arrow::Int64Array>(arr);
+  EXPECT_EQ(typed_arr->raw_values(), &col->Get<Int64Value>(0).val);
+
+  // The array keeps the column alive.
+  col.reset();
+  EXPECT_EQ(typed_arr->Value(3), 9);
+}
+
+TEST(ColumnWrapper, ShareAsArrowTime) {
+  auto col = ColumnWrapper::Make(DataType::TIME64NS, 0);
+  col->AppendFromVector(std::vector<Time64NSValue>{5, 8, 1});
+
+  auto arr = ShareAsArrow(col, arrow::default_memory_pool());
+  EXPECT_EQ(arr->type_id(), DataTypeTraits<DataType::TIME64NS>::arrow_type_id);
+  EXPECT_TRUE(arr->Equals(col->ConvertToArrow(arrow::default_memory_pool())));
+}
+
+TEST(ColumnWrapper, ShareAsArrowString) {
+  auto col = ColumnWrapper::Make(DataType::STRING, 0);
+  col->AppendFromVector(std::vector<StringValue>{"a", "bc"});
+
+  auto arr = ShareAsArrow(col, arrow::default_memory_pool());
+  EXPECT_TRUE(arr->Equals(col->ConvertToArrow(arrow::default_memory_pool())));
+}
+
+TEST(ColumnWrapper, ShareAsArrowStringArena) {
+  auto col = ColumnWrapper::Make(DataType::STRING, 0);
+  col->AppendFromVector(std::vector<StringValue>{"a", "", "bc"});
+  auto* typed_col = static_cast<StringValueColumnWrapper*>(col.get());
+  ASSERT_NE(typed_col->arena(), nullptr);
+
+  auto arr = ShareAsArrow(col, arrow::default_memory_pool());
+  EXPECT_TRUE(arr->Equals(col->ConvertToArrow(arrow::default_memory_pool())));
+
+  // The array references the arena in place.
+  auto typed_arr = std::static_pointer_cast<arrow::StringArray>(arr);
+  EXPECT_EQ(typed_arr->value_data()->data(),
+            reinterpret_cast<const uint8_t*>(typed_col->arena()->data()));
+
+  // The array keeps the column alive.
+  col.reset();
+  EXPECT_EQ(typed_arr->GetString(2), "bc");
+}
+
+TEST(ColumnWrapperTest, StringArena) {
+  StringValueColumnWrapper col(0);
+  col.Append("abc");
+  col.AppendView("de");
+  col.Append("");
+  ASSERT_NE(col.arena(), nullptr);
+  EXPECT_EQ(3, col.Size());
+  EXPECT_EQ(5, col.Bytes());
+
+  // Const accesses read the arena.
+  const StringValueColumnWrapper& const_col = col;
+  EXPECT_EQ("de", const_col[1]);
+  ASSERT_NE(col.arena(), nullptr);
+
+  // Copies and merges stay in the arena.
+  auto copy = col.CopyIndexes({2, 0});
+  EXPECT_EQ("", copy->Get<StringValue>(0));
+  EXPECT_EQ("abc", copy->Get<StringValue>(1));
+  StringValueColumnWrapper merged(0);
+  merged.Append("x");
+  merged.MoveAppend(static_cast<StringValueColumnWrapper*>(col.CopyIndexes({0, 1}).get()));
+  ASSERT_NE(merged.arena(), nullptr);
+  EXPECT_EQ(3, merged.Size());
+  EXPECT_EQ("de", const_cast<const StringValueColumnWrapper&>(merged)[2]);
+
+  // Mutable accesses move the values out of the arena.
+  col[0] = "xyz";
+  EXPECT_EQ(col.arena(), nullptr);
+  col.Append("f");
+  EXPECT_THAT(std::vector<StringValue>(col.UnsafeRawData(), col.UnsafeRawData() + col.Size()),
+              ::testing::ElementsAre("xyz", "de", "", "f"));
+  EXPECT_EQ(6, col.Bytes());
+
+  // Until the column is cleared.
+  col.Clear();
+  col.Append("g");
+  ASSERT_NE(col.arena(), nullptr);
+  EXPECT_EQ("g", col[0]);
+}
+
 }  // namespace types
 }  // namespace px
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace types {
+
+/**
+ * StringArena stores a sequence of strings back to back in a single data buffer, along with the
+ * offset of each string into that buffer. This is the layout of an arrow::StringArray, so the
+ * buffers can be handed to arrow as is, and appending a string copies its bytes instead of
+ * allocating a std::string for it.
+ *
+ * Offsets are 32-bit like arrow's, so an arena holds at most 2GB of string data.
+ */
+class StringArena {
+ public:
+  StringArena() : offsets_(1, 0) {}
+
+  size_t size() const { return offsets_.size() - 1; }
+  bool empty() const { return size() == 0; }
+
+  // The number of bytes of string data.
+  int64_t bytes() const { return data_.size(); }
+
+  std::string_view operator[](size_t idx) const {
+    DCHECK_LT(idx, size());
+    return std::string_view(data_.data() + offsets_[idx], offsets_[idx + 1] - offsets_[idx]);
+  }
+
+  void Append(std::string_view val) {
+    DCHECK_LE(data_.size() + val.size(),
+              static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+    data_.append(val);
+    offsets_.push_back(static_cast<int32_t>(data_.size()));
+  }
+
+  // Appends all the strings of other.
+  void Append(const StringArena& other) {
+    const int32_t base = offsets_.back();
+    data_.append(other.data_);
+    offsets_.reserve(offsets_.size() + other.size());
+    for (size_t i = 1; i < other.offsets_.size(); ++i) {
+      offsets_.push_back(base + other.offsets_[i]);
+    }
+  }
+
+  // Truncates to, or pads with empty strings up to, the given number of strings.
+  void Resize(size_t size) {
+    if (size < this->size()) {
+      data_.resize(offsets_[size]);
+    }
+    offsets_.resize(size + 1, offsets_.back());
+  }
+
+  void Reserve(size_t num_strings, size_t num_bytes = 0) {
+    offsets_.reserve(num_strings + 1);
+    data_.reserve(num_bytes);
+  }
+
+  void Clear() {
+    data_.clear();
+    offsets_.resize(1);
+  }
+
+  void ShrinkToFit() {
+    data_.shrink_to_fit();
+    offsets_.shrink_to_fit();
+  }
+
+  // The arrow layout: size() + 1 offsets, the first of which is 0, into data().
+  const int32_t* offsets() const { return offsets_.data(); }
+  const char* data() const { return data_.data(); }
+
+ private:
+  std::string data_;
+  std::vector<int32_t> offsets_;
+};
+
+}  // namespace types
+}  // namespace px
@@ -18,13 +18,18 @@
 
 #include <benchmark/benchmark.h>
 
+#include <memory>
 #include <random>
+#include <string>
 #include <vector>
 #include "src/common/benchmark/benchmark.h"
 #include "src/common/datagen/datagen.h"
+#include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
 
 using px::types::Int64Value;
+using px::types::StringValue;
+using px::types::StringValueColumnWrapper;
 
 // This is just a dummy function that does some work so we can use it in the benchmark.
 template <typename T>
@@ -65,3 +70,51 @@ static void BM_Int64Vector(benchmark::State& state) {  // NOLINT
 
 BENCHMARK_TEMPLATE(BM_Int64Vector, int64_t)->Arg(10000);
 BENCHMARK_TEMPLATE(BM_Int64Vector, Int64Value)->Arg(10000);
+
+std::vector<std::string> MakeStrings(int num_strings, size_t length) {
+  std::vector<std::string> strings;
+  strings.reserve(num_strings);
+  for (int i = 0; i < num_strings; ++i) {
+    strings.push_back(px::datagen::RandomString(length));
+  }
+  return strings;
+}
+
+// Appends strings to a column the way Stirling does, then converts it to arrow.
+// With kArena, the column keeps the strings in its arena, otherwise in a vector of StringValues.
+template <bool kArena>
+static void BM_StringColumnAppendToArrow(benchmark::State& state) {  // NOLINT
+  auto strings = MakeStrings(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    auto col = kArena ? std::make_shared<StringValueColumnWrapper>(0)
+                      : std::make_shared<StringValueColumnWrapper>(std::vector<StringValue>{});
+    col->Reserve(strings.size());
+    for (const auto& str : strings) {
+      col->AppendView(str);
+    }
+    auto arr = col->ConvertToArrow(arrow::default_memory_pool());
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0) * state.range(1));
+}
+
+// Similar to the above, except the arrow array shares the arena rather than copying it.
+static void BM_StringColumnAppendShareAsArrow(benchmark::State& state) {  // NOLINT
+  auto strings = MakeStrings(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    auto col = std::make_shared<StringValueColumnWrapper>(0);
+    col->Reserve(strings.size());
+    for (const auto& str : strings) {
+      col->AppendView(str);
+    }
+    auto arr = px::types::ShareAsArrow(col, arrow::default_memory_pool());
+    benchmark::DoNotOptimize(arr);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * state.range(0) * state.range(1));
+}
+
+BENCHMARK_TEMPLATE(BM_StringColumnAppendToArrow, false)->Args({10000, 8})->Args({10000, 256});
+BENCHMARK_TEMPLATE(BM_StringColumnAppendToArrow, true)->Args({10000, 8})->Args({10000, 256});
+BENCHMARK(BM_StringColumnAppendShareAsArrow)->Args({10000, 8})->Args({10000, 256});
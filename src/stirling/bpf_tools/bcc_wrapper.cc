@@ -18,20 +18,51 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <bcc/common.h>
+#include <bcc/libbpf.h>
+#include <bcc/perf_reader.h>
+#include <linux/bpf.h>
 #include <linux/perf_event.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
 #include <sys/mount.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include <absl/synchronization/mutex.h>
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/system/config.h"
 #include "src/stirling/bpf_tools/task_struct_resolver.h"
 #include "src/stirling/utils/linux_headers.h"
 
+DEFINE_string(stirling_bpf_cache_dir, gflags::StringFromEnv("PL_STIRLING_BPF_CACHE_DIR", ""),
+              "Directory where results derived from BPF programs at startup, such as the resolved "
+              "task_struct offsets, are cached for restarts on the same kernel. Mount it from the "
+              "host to persist it across PEM restarts. Empty disables the cache.");
+DEFINE_bool(stirling_data_wakeup, false,
+            "If true, event-driven sources (e.g. those backed by perf buffers) wait for data "
+            "to arrive instead of sleeping, and are sampled early once a perf buffer reaches "
+            "--stirling_data_wakeup_watermark. Requires --stirling_source_threads.");
+DEFINE_uint32(stirling_data_wakeup_watermark, 16,
+              "Number of events a per-CPU perf buffer holds before it wakes up a source that "
+              "waits for data with --stirling_data_wakeup, so that the source is sampled ahead of "
+              "its sampling period. Without --stirling_data_wakeup, perf buffers wake up on "
+              "every event.");
+
 namespace px {
 namespace stirling {
 namespace bpf_tools {
@@ -82,6 +113,41 @@ StatusOr<utils::TaskStructOffsets> ResolveTaskStructOffsets() {
   return offsets_status;
 }
 
+// Resolves the task struct offsets once per process, and once per kernel when the cache
+// directory is set. Each resolution compiles and deploys a BPF program, which is expensive enough
+// that it shouldn't be repeated by every BCCWrapper.
+StatusOr<utils::TaskStructOffsets> ResolveTaskStructOffsetsCached() {
+  static absl::Mutex mutex(absl::kConstInit);
+  static utils::TaskStructOffsets* resolved_offsets = nullptr;
+
+  absl::MutexLock lock(&mutex);
+  if (resolved_offsets != nullptr) {
+    return *resolved_offsets;
+  }
+
+  std::filesystem::path cache_file;
+  if (!FLAGS_stirling_bpf_cache_dir.empty()) {
+    cache_file = std::filesystem::path(FLAGS_stirling_bpf_cache_dir) / "task_struct_offsets";
+    StatusOr<utils::TaskStructOffsets> cached = utils::ReadCachedTaskStructOffsets(cache_file);
+    if (cached.ok()) {
+      LOG(INFO) << absl::Substitute("Using task_struct offsets cached at $0.", cache_file.string());
+      resolved_offsets = new utils::TaskStructOffsets(cached.ValueOrDie());
+      return *resolved_offsets;
+    }
+    LOG_IF(WARNING, !error::IsNotFound(cached.status())) << absl::Substitute(
+        "Ignoring the cached task_struct offsets, resolving them again: $0", cached.msg());
+  }
+
+  PL_ASSIGN_OR_RETURN(utils::TaskStructOffsets offsets, ResolveTaskStructOffsets());
+  if (!cache_file.empty()) {
+    Status s = utils::WriteCachedTaskStructOffsets(cache_file, offsets);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to cache task_struct offsets: $0",
+                                                 s.ToString());
+  }
+  resolved_offsets = new utils::TaskStructOffsets(offsets);
+  return offsets;
+}
+
 StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets(bool always_infer_task_struct_offsets) {
   // Defaults to zero offsets, which tells BPF not to use the offset overrides.
   // If the values are changed (as they are if ResolveTaskStructOffsets() is run),
@@ -100,7 +166,7 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets(bool always_infer_task_s
   if (potentially_mismatched_headers || always_infer_task_struct_offsets) {
     LOG(INFO) << "Resolving task_struct offsets.";
 
-    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsets());
+    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsetsCached());
 
     LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
                                   offsets.group_leader_offset, offsets.real_start_time_offset);
@@ -109,6 +175,10 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets(bool always_infer_task_s
   return offsets;
 }
 
+Status PrepareTaskStructOffsets() {
+  return GetTaskStructOffsets(/*always_infer_task_struct_offsets*/ false).status();
+}
+
 Status BCCWrapper::InitBPFProgram(std::string_view bpf_program, std::vector<std::string> cflags,
                                   bool requires_linux_headers,
                                   bool always_infer_task_struct_offsets) {
@@ -322,6 +392,57 @@ void BCCWrapper::DetachTracepoints() {
   tracepoints_.clear();
 }
 
+namespace {
+
+// Opens the perf event of a perf buffer on a CPU, and maps its ring.
+// This is what BCC's open_perf_buffer() does, except that BCC always wakes up on every event,
+// which is what a wakeup_events of 1 does.
+StatusOr<perf_reader*> OpenPerfReader(perf_reader_raw_cb raw_cb, perf_reader_lost_cb lost_cb,
+                                      void* cb_cookie, int cpu, int num_pages,
+                                      uint32_t wakeup_events) {
+  struct perf_event_attr attr = {};
+  attr.type = PERF_TYPE_SOFTWARE;
+  attr.config = PERF_COUNT_SW_BPF_OUTPUT;
+  attr.sample_type = PERF_SAMPLE_RAW;
+  attr.sample_period = 1;
+  attr.wakeup_events = std::max<uint32_t>(wakeup_events, 1);
+
+  const int fd = syscall(__NR_perf_event_open, &attr, /* pid */ -1, cpu, /* group_fd */ -1,
+                         PERF_FLAG_FD_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open perf event on CPU $0: $1", cpu, std::strerror(errno));
+  }
+  perf_reader* reader = perf_reader_new(raw_cb, lost_cb, cb_cookie, num_pages);
+  if (reader == nullptr) {
+    close(fd);
+    return error::Internal("Failed to create perf reader on CPU $0.", cpu);
+  }
+  // The reader owns the FD from here on, and closes it when freed.
+  perf_reader_set_fd(reader, fd);
+  if (perf_reader_mmap(reader) < 0 || ioctl(fd, PERF_EVENT_IOC_ENABLE, 0) < 0) {
+    perf_reader_free(reader);
+    return error::Internal("Failed to map perf buffer on CPU $0.", cpu);
+  }
+  return reader;
+}
+
+}  // namespace
+
+Status BCCWrapper::WatchBufferFD(int fd) {
+  if (buffer_epoll_fd_ < 0) {
+    buffer_epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (buffer_epoll_fd_ < 0) {
+      return error::Internal("Failed to create epoll set: $0", std::strerror(errno));
+    }
+  }
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  if (epoll_ctl(buffer_epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+    return error::Internal("Failed to add FD $0 to epoll set: $1", fd, std::strerror(errno));
+  }
+  return Status::OK();
+}
+
 Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
   const int kPageSizeBytes = system::Config::GetInstance().PageSize();
   int num_pages = IntRoundUpDivide(perf_buffer.size_bytes, kPageSizeBytes);
@@ -332,11 +453,41 @@ Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_co
   VLOG(1) << absl::Substitute("Opening perf buffer: $0 [requested_size=$1 num_pages=$2 size=$3]",
                               perf_buffer.name, perf_buffer.size_bytes, num_pages,
                               num_pages * kPageSizeBytes);
-  PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
-                                           perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn,
-                                           cb_cookie, num_pages));
-  perf_buffers_.push_back(perf_buffer);
+  ebpf::BPFTable table = bpf_.get_table(std::string(perf_buffer.name));
+  const int map_fd = internal::MapFD(table);
+  if (map_fd < 0) {
+    return error::NotFound("Perf buffer $0 is not declared in the BPF program.", perf_buffer.name);
+  }
+
+  auto buffer = std::unique_ptr<PerfBuffer>(new PerfBuffer{
+      perf_buffer, cb_cookie, PerfBufferMetrics(&GetMetricsRegistry(), perf_buffer.name)});
+  // The readers are freed on failures by closing the buffer, whatever it got to open.
+  perf_buffers_.push_back(std::move(buffer));
   ++num_open_perf_buffers_;
+  PerfBuffer* p = perf_buffers_.back().get();
+  // Only sources that wait for data batch their wake-ups; the others are read on every event.
+  const uint32_t wakeup_events =
+      FLAGS_stirling_data_wakeup ? FLAGS_stirling_data_wakeup_watermark : 1;
+  for (int cpu : ebpf::get_online_cpus()) {
+    auto reader_or =
+        OpenPerfReader(&BCCWrapper::HandlePerfBufferEvent, &BCCWrapper::HandlePerfBufferLoss, p,
+                       cpu, num_pages, wakeup_events);
+    Status s = reader_or.status();
+    if (s.ok()) {
+      p->readers.push_back(reader_or.ConsumeValueOrDie());
+      int fd = perf_reader_fd(p->readers.back());
+      if (bpf_update_elem(map_fd, &cpu, &fd, BPF_ANY) < 0) {
+        s = error::Internal("Failed to install perf buffer $0 on CPU $1: $2", perf_buffer.name,
+                            cpu, std::strerror(errno));
+      } else {
+        s = WatchBufferFD(fd);
+      }
+    }
+    if (!s.ok()) {
+      PL_UNUSED(ClosePerfBuffer(perf_buffer));
+      return s;
+    }
+  }
   return Status::OK();
 }
 
@@ -347,19 +498,134 @@ Status BCCWrapper::OpenPerfBuffers(const ArrayView<PerfBufferSpec>& perf_buffers
   return Status::OK();
 }
 
+bool BCCWrapper::RingBuffersSupported() {
+  static const bool kSupported = []() {
+    StatusOr<utils::KernelVersion> version = utils::GetKernelVersion();
+    if (!version.ok()) {
+      LOG(WARNING) << absl::Substitute("Could not determine the kernel version: $0",
+                                       version.msg());
+      return false;
+    }
+    utils::KernelVersion min_version = {5, 8, 0};
+    return version.ValueOrDie().code() >= min_version.code();
+  }();
+  return kSupported;
+}
+
+int BCCWrapper::RingBufferPages(int size_bytes) {
+  const int kPageSizeBytes = system::Config::GetInstance().PageSize();
+  return IntRoundUpToPow2(IntRoundUpDivide(size_bytes, kPageSizeBytes));
+}
+
+Status BCCWrapper::OpenRingBuffer(const PerfBufferSpec& ring_buffer, void* cb_cookie) {
+  VLOG(1) << absl::Substitute("Opening ring buffer: $0", ring_buffer.name);
+  auto rb = std::unique_ptr<RingBuffer>(new RingBuffer{
+      PerfBuffer{ring_buffer, cb_cookie,
+                 PerfBufferMetrics(&GetMetricsRegistry(), ring_buffer.name)},
+      bpf_.get_percpu_array_table<uint64_t>(ring_buffer.name + "_lost")});
+
+  ebpf::BPFTable table = bpf_.get_table(ring_buffer.name);
+  const int map_fd = internal::MapFD(table);
+  if (map_fd < 0) {
+    return error::NotFound("Ring buffer $0 is not declared in the BPF program.", ring_buffer.name);
+  }
+  if (ring_buffer_manager_ == nullptr) {
+    ring_buffer_manager_ = static_cast<struct ring_buffer*>(
+        bpf_new_ringbuf(map_fd, &BCCWrapper::HandleRingBufferEvent, rb.get()));
+    if (ring_buffer_manager_ == nullptr) {
+      return error::Internal("Failed to open ring buffer $0.", ring_buffer.name);
+    }
+  } else if (bpf_add_ringbuf(ring_buffer_manager_, map_fd, &BCCWrapper::HandleRingBufferEvent,
+                             rb.get()) < 0) {
+    return error::Internal("Failed to open ring buffer $0.", ring_buffer.name);
+  }
+  PL_RETURN_IF_ERROR(WatchBufferFD(map_fd));
+  ring_buffers_.push_back(std::move(rb));
+  ++num_open_perf_buffers_;
+  return Status::OK();
+}
+
+void BCCWrapper::HandlePerfBufferEvent(void* ctx, void* data, int size) {
+  auto* buffer = static_cast<PerfBuffer*>(ctx);
+  ++buffer->num_events;
+  buffer->metrics.events_counter.Increment();
+  buffer->metrics.bytes_counter.Increment(size);
+  buffer->spec.probe_output_fn(buffer->cb_cookie, data, size);
+}
+
+void BCCWrapper::HandlePerfBufferLoss(void* ctx, uint64_t lost) {
+  auto* buffer = static_cast<PerfBuffer*>(ctx);
+  buffer->metrics.lost_events_counter.Increment(lost);
+  if (buffer->spec.probe_loss_fn != nullptr) {
+    buffer->spec.probe_loss_fn(buffer->cb_cookie, lost);
+  }
+}
+
+int BCCWrapper::HandleRingBufferEvent(void* ctx, void* data, size_t size) {
+  HandlePerfBufferEvent(&static_cast<RingBuffer*>(ctx)->buffer, data, static_cast<int>(size));
+  return 0;
+}
+
+int BCCWrapper::PollRingBuffers(int timeout_ms) {
+  if (ring_buffer_manager_ == nullptr) {
+    return 0;
+  }
+  int num_events = timeout_ms > 0 ? bpf_poll_ringbuf(ring_buffer_manager_, timeout_ms)
+                                   : bpf_consume_ringbuf(ring_buffer_manager_);
+  ReportRingBufferLosses();
+  return std::max(num_events, 0);
+}
+
+void BCCWrapper::ReportRingBufferLosses() {
+  constexpr int kZero = 0;
+  for (auto& ring_buffer : ring_buffers_) {
+    std::vector<uint64_t> per_cpu_lost;
+    if (!ring_buffer->lost_counts.get_value(kZero, per_cpu_lost).ok()) {
+      continue;
+    }
+    uint64_t num_lost = 0;
+    for (uint64_t n : per_cpu_lost) {
+      num_lost += n;
+    }
+    if (num_lost > ring_buffer->num_lost) {
+      HandlePerfBufferLoss(&ring_buffer->buffer, num_lost - ring_buffer->num_lost);
+    }
+    ring_buffer->num_lost = num_lost;
+  }
+}
+
+void BCCWrapper::CloseRingBuffers() {
+  if (ring_buffer_manager_ != nullptr) {
+    VLOG(1) << "Closing ring buffers";
+    bpf_free_ringbuf(ring_buffer_manager_);
+    ring_buffer_manager_ = nullptr;
+  }
+  num_open_perf_buffers_ -= ring_buffers_.size();
+  ring_buffers_.clear();
+}
+
 Status BCCWrapper::ClosePerfBuffer(const PerfBufferSpec& perf_buffer) {
   VLOG(1) << "Closing perf buffer: " << perf_buffer.name;
-  PL_RETURN_IF_ERROR(bpf_.close_perf_buffer(std::string(perf_buffer.name)));
+  auto iter =
+      std::find_if(perf_buffers_.begin(), perf_buffers_.end(),
+                   [&perf_buffer](const auto& p) { return p->spec.name == perf_buffer.name; });
+  if (iter == perf_buffers_.end()) {
+    return error::NotFound("Perf buffer $0 is not open.", perf_buffer.name);
+  }
+  // Freeing a reader closes its perf event FD, which also removes it from the epoll set.
+  for (perf_reader* reader : (*iter)->readers) {
+    perf_reader_free(reader);
+  }
+  perf_buffers_.erase(iter);
   --num_open_perf_buffers_;
   return Status::OK();
 }
 
 void BCCWrapper::ClosePerfBuffers() {
-  for (const PerfBufferSpec& p : perf_buffers_) {
-    auto res = ClosePerfBuffer(p);
+  while (!perf_buffers_.empty()) {
+    auto res = ClosePerfBuffer(perf_buffers_.back()->spec);
     LOG_IF(ERROR, !res.ok()) << res.msg();
   }
-  perf_buffers_.clear();
 }
 
 Status BCCWrapper::AttachPerfEvent(const PerfEventSpec& perf_event) {
@@ -404,22 +670,212 @@ std::string BCCWrapper::GetKProbeTargetName(const KProbeSpec& probe) {
   return target;
 }
 
-void BCCWrapper::PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms) {
-  auto perf_buffer = bpf_.get_perf_buffer(std::string(perf_buffer_name));
-  if (perf_buffer != nullptr) {
-    perf_buffer->poll(timeout_ms);
+int BCCWrapper::ConsumePerfBuffer(PerfBuffer* buffer) {
+  const uint64_t num_events = buffer->num_events;
+  // Every reader is read, since readers below the wake-up watermark are not reported by epoll.
+  for (perf_reader* reader : buffer->readers) {
+    perf_reader_event_read(reader);
+  }
+  return static_cast<int>(buffer->num_events - num_events);
+}
+
+int BCCWrapper::PollPerfBuffer(std::string_view perf_buffer_name) {
+  for (const auto& p : perf_buffers_) {
+    if (p->spec.name == perf_buffer_name) {
+      return ConsumePerfBuffer(p.get());
+    }
+  }
+  return 0;
+}
+
+int BCCWrapper::PollPerfBuffers(int timeout_ms) {
+  if (timeout_ms > 0) {
+    WaitForPerfBufferData(timeout_ms);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  int num_events = 0;
+  for (const auto& p : perf_buffers_) {
+    num_events += ConsumePerfBuffer(p.get());
   }
+  num_events += PollRingBuffers(0);
+  poll_duration_histogram_.Observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  return num_events;
 }
 
-void BCCWrapper::PollPerfBuffers(int timeout_ms) {
-  for (const auto& spec : perf_buffers_) {
-    PollPerfBuffer(spec.name, timeout_ms);
+int BCCWrapper::WaitForPerfBufferData(int timeout_ms) {
+  if (buffer_epoll_fd_ < 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    return 0;
   }
+  constexpr int kMaxEvents = 64;
+  struct epoll_event events[kMaxEvents];
+  int num_ready = epoll_wait(buffer_epoll_fd_, events, kMaxEvents, timeout_ms);
+  // Interruptions by signals are treated like timeouts; the caller polls again on its next cycle.
+  return std::max(num_ready, 0);
+}
+
+namespace internal {
+
+namespace {
+
+// ENOTSUPP is kernel-internal, but is what map types without batch operations return.
+constexpr int kENOTSUPP = 524;
+
+int BPFMapBatch(enum bpf_cmd cmd, int map_fd, const void* in_batch, void* out_batch,
+                const void* keys, const void* values, uint32_t* count) {
+  union bpf_attr attr = {};
+  attr.batch.map_fd = map_fd;
+  attr.batch.in_batch = reinterpret_cast<uint64_t>(in_batch);
+  attr.batch.out_batch = reinterpret_cast<uint64_t>(out_batch);
+  attr.batch.keys = reinterpret_cast<uint64_t>(keys);
+  attr.batch.values = reinterpret_cast<uint64_t>(values);
+  attr.batch.count = *count;
+  int ret = syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+  // On failures, the count is the number of elements that were processed.
+  *count = attr.batch.count;
+  return ret;
+}
+
+Status BatchError(std::string_view cmd, int err) {
+  // Kernels older than 5.6 don't know the command.
+  if (err == EINVAL || err == kENOTSUPP || err == EOPNOTSUPP) {
+    return error::Unimplemented("$0 is not supported: $1", cmd, strerror(err));
+  }
+  return error::Internal("$0 failed: $1", cmd, strerror(err));
+}
+
+}  // namespace
+
+Status UpdateMapBatch(int map_fd, const void* keys, const void* values, uint32_t count) {
+  if (BPFMapBatch(BPF_MAP_UPDATE_BATCH, map_fd, nullptr, nullptr, keys, values, &count) < 0) {
+    return BatchError("BPF_MAP_UPDATE_BATCH", errno);
+  }
+  return Status::OK();
+}
+
+Status DeleteMapBatch(int map_fd, const void* keys, size_t key_size, uint32_t count) {
+  const auto* next_key = static_cast<const uint8_t*>(keys);
+  while (count > 0) {
+    uint32_t num_deleted = count;
+    if (BPFMapBatch(BPF_MAP_DELETE_BATCH, map_fd, nullptr, nullptr, next_key, nullptr,
+                    &num_deleted) == 0) {
+      return Status::OK();
+    }
+    // The batch stops at the first key that isn't in the map; skip it, and go on with the rest.
+    if (errno != ENOENT || num_deleted >= count) {
+      return BatchError("BPF_MAP_DELETE_BATCH", errno);
+    }
+    next_key += (num_deleted + 1) * key_size;
+    count -= num_deleted + 1;
+  }
+  return Status::OK();
+}
+
+StatusOr<uint32_t> LookupMapBatch(int map_fd, const void* in_batch, void* out_batch, void* keys,
+                                  void* values, uint32_t count, bool* done) {
+  *done = false;
+  if (BPFMapBatch(BPF_MAP_LOOKUP_BATCH, map_fd, in_batch, out_batch, keys, values, &count) < 0) {
+    // The last batch of the map comes with ENOENT.
+    if (errno != ENOENT) {
+      return BatchError("BPF_MAP_LOOKUP_BATCH", errno);
+    }
+    *done = true;
+  }
+  return count;
+}
+
+}  // namespace internal
+
+StatusOr<std::vector<std::pair<std::string, std::string>>> BCCWrapper::GetRawHashTableEntries(
+    const std::string& table_name) {
+  ebpf::BPFTable table = bpf_.get_table(table_name);
+  const int map_fd = internal::MapFD(table);
+  if (map_fd < 0) {
+    return error::NotFound("BPF table $0 is not declared in the BPF program.", table_name);
+  }
+  const auto [key_size, value_size] = internal::MapKeyValueSizes(table);
+
+  constexpr uint32_t kBatchSize = 1024;
+  std::string keys(kBatchSize * key_size, '\0');
+  std::string values(kBatchSize * value_size, '\0');
+  // The batch position of hash maps is a bucket index.
+  uint64_t batch = 0;
+  uint64_t next_batch = 0;
+
+  std::vector<std::pair<std::string, std::string>> entries;
+  bool done = false;
+  for (bool first = true; !done; first = false) {
+    StatusOr<uint32_t> count_or =
+        internal::LookupMapBatch(map_fd, first ? nullptr : &batch, &next_batch, keys.data(),
+                                 values.data(), kBatchSize, &done);
+    if (!count_or.ok()) {
+      if (!error::IsUnimplemented(count_or.status())) {
+        return count_or.status();
+      }
+      entries.clear();
+      break;
+    }
+    for (uint32_t i = 0; i < count_or.ValueOrDie(); ++i) {
+      entries.emplace_back(keys.substr(i * key_size, key_size),
+                           values.substr(i * value_size, value_size));
+    }
+    batch = next_batch;
+  }
+  if (done) {
+    return entries;
+  }
+
+  // Without batch operations, it takes two syscalls per entry.
+  std::string key(key_size, '\0');
+  std::string value(value_size, '\0');
+  for (int ret = bpf_get_first_key(map_fd, key.data(), key_size); ret == 0;
+       ret = bpf_get_next_key(map_fd, key.data(), key.data())) {
+    // The entry may have been removed since.
+    if (bpf_lookup_elem(map_fd, key.data(), value.data()) == 0) {
+      entries.emplace_back(key, value);
+    }
+  }
+  return entries;
+}
+
+Status BCCWrapper::RemoveRawHashTableKeys(const std::string& table_name,
+                                          const std::vector<std::string>& keys) {
+  if (keys.empty()) {
+    return Status::OK();
+  }
+  ebpf::BPFTable table = bpf_.get_table(table_name);
+  const int map_fd = internal::MapFD(table);
+  if (map_fd < 0) {
+    return error::NotFound("BPF table $0 is not declared in the BPF program.", table_name);
+  }
+  const size_t key_size = internal::MapKeyValueSizes(table).first;
+
+  std::string packed_keys;
+  packed_keys.reserve(keys.size() * key_size);
+  for (const auto& key : keys) {
+    DCHECK_EQ(key.size(), key_size);
+    packed_keys.append(key);
+  }
+  Status s = internal::DeleteMapBatch(map_fd, packed_keys.data(), key_size, keys.size());
+  if (!error::IsUnimplemented(s)) {
+    return s;
+  }
+  for (const auto& key : keys) {
+    // Missing keys are expected, so the result is ignored.
+    bpf_delete_elem(map_fd, const_cast<char*>(key.data()));
+  }
+  return Status::OK();
 }
 
 void BCCWrapper::Close() {
   DetachPerfEvents();
   ClosePerfBuffers();
+  CloseRingBuffers();
+  if (buffer_epoll_fd_ >= 0) {
+    close(buffer_epoll_fd_);
+    buffer_epoll_fd_ = -1;
+  }
   DetachKProbes();
   DetachUProbes();
   DetachTracepoints();
@@ -43,8 +43,14 @@
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
+#include "src/stirling/bpf_tools/perf_buffer_metrics.h"
 #include "src/stirling/obj_tools/elf_reader.h"
 
+DECLARE_string(stirling_bpf_cache_dir);
+DECLARE_bool(stirling_data_wakeup);
+DECLARE_uint32(stirling_data_wakeup_watermark);
+
 namespace px {
 /*
  * Status adapter for ebpf::StatusTuple.
@@ -152,6 +158,7 @@ struct SamplingProbeSpec {
 
 /**
  * Describes a BPF perf buffer, through which data is returned to user-space.
+ * Also describes BPF ring buffers, see BCCWrapper::OpenRingBuffer().
  */
 struct PerfBufferSpec {
   // Name of the perf buffer.
@@ -188,6 +195,55 @@ struct PerfEventSpec {
   uint64_t sample_period;
 };
 
+namespace internal {
+
+/**
+ * Returns the FD of a BCC table, which BCC keeps to itself.
+ */
+template <typename TMapType>
+int MapFD(const TMapType& map) {
+  struct FDAccessor : public TMapType {
+    explicit FDAccessor(const TMapType& map) : TMapType(map) {}
+    int fd() const { return static_cast<int>(this->desc.fd); }
+  };
+  return FDAccessor(map).fd();
+}
+
+/**
+ * Returns the sizes of the keys and of the values of a BCC table.
+ */
+template <typename TMapType>
+std::pair<size_t, size_t> MapKeyValueSizes(const TMapType& map) {
+  struct DescAccessor : public TMapType {
+    explicit DescAccessor(const TMapType& map) : TMapType(map) {}
+    std::pair<size_t, size_t> sizes() const { return {this->desc.key_size, this->desc.leaf_size}; }
+  };
+  return DescAccessor(map).sizes();
+}
+
+// These issue the BPF_MAP_*_BATCH commands of Linux 5.6 and newer on a map FD. They return an
+// Unimplemented error if the kernel, or the type of the map, doesn't support batch operations.
+
+Status UpdateMapBatch(int map_fd, const void* keys, const void* values, uint32_t count);
+
+// Keys that aren't in the map are skipped.
+Status DeleteMapBatch(int map_fd, const void* keys, size_t key_size, uint32_t count);
+
+// Reads up to count entries that follow the batch position in_batch (nullptr for the start of the
+// map), and sets out_batch to the position after them. Sets done once the end of the map is read.
+StatusOr<uint32_t> LookupMapBatch(int map_fd, const void* in_batch, void* out_batch, void* keys,
+                                  void* values, uint32_t count, bool* done);
+
+}  // namespace internal
+
+/**
+ * Resolves the task_struct offsets that BPF programs compiled against packaged Linux headers need,
+ * ahead of the first BCCWrapper::InitBPFProgram(), which would otherwise resolve them. The offsets
+ * are cached for the process. Does nothing if the headers aren't packaged ones, so it's only
+ * useful once the headers are installed.
+ */
+Status PrepareTaskStructOffsets();
+
 /**
  * Wrapper around BCC, as a convenience.
  */
@@ -295,6 +351,34 @@ class BCCWrapper {
    */
   Status OpenPerfBuffers(const ArrayView<PerfBufferSpec>& perf_buffers, void* cb_cookie);
 
+  /**
+   * Opens a BPF ring buffer, an alternative to a perf buffer on kernels 5.8+ that is shared by
+   * all CPUs, instead of being allocated once per CPU. The ring buffer is declared in the probe
+   * code with BPF_RINGBUF_OUTPUT, which also sets its size; see RingBufferPages().
+   *
+   * The kernel doesn't count the events that don't fit in a ring buffer, so the probe code must
+   * also declare BPF_PERCPU_ARRAY(<name>_lost, uint64_t, 1), and count them in it. They are
+   * reported to probe_loss_fn when the ring buffers are polled.
+   *
+   * Ring buffers are polled along with perf buffers, by PollPerfBuffers() and
+   * WaitForPerfBufferData().
+   *
+   * @param ring_buffer The ring buffer descriptor. Its size_bytes is not used.
+   * @param cb_cookie Raw pointer returned on callback, typically used for tracking context.
+   */
+  Status OpenRingBuffer(const PerfBufferSpec& ring_buffer, void* cb_cookie = nullptr);
+
+  /**
+   * Returns whether the kernel supports BPF ring buffers.
+   */
+  static bool RingBuffersSupported();
+
+  /**
+   * Returns the number of pages to declare a ring buffer of size_bytes with.
+   * BPF_RINGBUF_OUTPUT requires a power of 2.
+   */
+  static int RingBufferPages(int size_bytes);
+
   /**
    * Convenience function that opens multiple perf events.
    * @param probes Vector of perf event descriptors.
@@ -326,8 +410,27 @@ class BCCWrapper {
    *                   amount of time to wait for an event to arrive before returning.
    *                   Default is 0, because if nothing is ready, then we want to go back to sleep
    *                   and catch new events in the next iteration.
+   * @return The number of perf and ring buffer events that were read.
+   */
+  int PollPerfBuffers(int timeout_ms = 0);
+
+  /**
+   * Drains a single perf buffer, like PollPerfBuffers().
+   *
+   * @return The number of events that were read; 0 if the perf buffer is not open.
+   */
+  int PollPerfBuffer(std::string_view perf_buffer_name);
+
+  /**
+   * Blocks until one of the opened perf buffers holds --stirling_data_wakeup_watermark events on
+   * one of its CPUs (one event without --stirling_data_wakeup), until a ring buffer has events,
+   * or until timeout_ms expires.
+   * All buffers are waited on with a single epoll_wait(). Nothing is read, so this may be called
+   * concurrently with PollPerfBuffers(); events below the watermark are still read by the polls.
+   *
+   * @return The number of buffers that woke up the wait; 0 on timeout.
    */
-  void PollPerfBuffers(int timeout_ms = 0);
+  int WaitForPerfBufferData(int timeout_ms);
 
   /**
    * Detaches all probes, and closes all perf buffers that are open.
@@ -353,15 +456,105 @@ class BCCWrapper {
     return bpf_.get_map_in_map_table<TKeyType>(table_name);
   }
 
-  ebpf::BPFPerfBuffer* GetPerfBuffer(const std::string& perf_buffer_name) {
-    return bpf_.get_perf_buffer(perf_buffer_name);
-  }
-
   template <typename TValueType>
   ebpf::BPFPercpuArrayTable<TValueType> GetPerCPUArrayTable(const std::string& table_name) {
     return bpf_.get_percpu_array_table<TValueType>(table_name);
   }
 
+  /**
+   * Reads all entries of a hash table a few thousand entries per syscall, where BCC's
+   * get_table_offline() takes two syscalls per entry. Falls back to the latter on kernels without
+   * batch operations.
+   */
+  template <typename TKeyType, typename TValueType>
+  static std::vector<std::pair<TKeyType, TValueType>> GetHashTableEntries(
+      ebpf::BPFHashTable<TKeyType, TValueType>* table) {
+    constexpr uint32_t kBatchSize = 4096;
+    std::vector<TKeyType> keys(kBatchSize);
+    std::vector<TValueType> values(kBatchSize);
+    // The batch position of hash maps is a bucket index.
+    uint64_t batch = 0;
+    uint64_t next_batch = 0;
+
+    std::vector<std::pair<TKeyType, TValueType>> entries;
+    bool done = false;
+    for (bool first = true; !done; first = false) {
+      StatusOr<uint32_t> count_or =
+          internal::LookupMapBatch(internal::MapFD(*table), first ? nullptr : &batch, &next_batch,
+                                   keys.data(), values.data(), kBatchSize, &done);
+      if (!count_or.ok()) {
+        LOG_IF(WARNING, !error::IsUnimplemented(count_or.status()))
+            << absl::Substitute("Batch lookup failed, reading entries one by one. Message=$0",
+                                count_or.msg());
+        return table->get_table_offline();
+      }
+      for (uint32_t i = 0; i < count_or.ValueOrDie(); ++i) {
+        entries.emplace_back(keys[i], values[i]);
+      }
+      batch = next_batch;
+    }
+    return entries;
+  }
+
+  /**
+   * Sets the values of the keys of a hash table with a single syscall, or one syscall per key on
+   * kernels without batch operations.
+   */
+  template <typename TKeyType, typename TValueType>
+  static Status UpdateHashTableValues(ebpf::BPFHashTable<TKeyType, TValueType>* table,
+                                      const std::vector<TKeyType>& keys,
+                                      const std::vector<TValueType>& values) {
+    DCHECK_EQ(keys.size(), values.size());
+    if (keys.empty()) {
+      return Status::OK();
+    }
+    Status s =
+        internal::UpdateMapBatch(internal::MapFD(*table), keys.data(), values.data(), keys.size());
+    if (!error::IsUnimplemented(s)) {
+      return s;
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+      PL_RETURN_IF_ERROR(table->update_value(keys[i], values[i]));
+    }
+    return Status::OK();
+  }
+
+  /**
+   * Removes the keys from a hash table, or a map of maps, with a single syscall, or one syscall
+   * per key on kernels without batch operations. Keys that aren't in the table are ignored.
+   */
+  template <typename TKeyType, typename TMapType>
+  static Status RemoveValues(TMapType* table, const std::vector<TKeyType>& keys) {
+    if (keys.empty()) {
+      return Status::OK();
+    }
+    Status s =
+        internal::DeleteMapBatch(internal::MapFD(*table), keys.data(), sizeof(TKeyType),
+                                 keys.size());
+    if (!error::IsUnimplemented(s)) {
+      return s;
+    }
+    for (const TKeyType& key : keys) {
+      // Missing keys are expected, so the result is ignored.
+      table->remove_value(key);
+    }
+    return Status::OK();
+  }
+
+  /**
+   * Reads all entries of a hash table whose key and value types are only known at run time, like
+   * the ones of generated BPF programs. Keys and values are returned as their raw bytes.
+   */
+  StatusOr<std::vector<std::pair<std::string, std::string>>> GetRawHashTableEntries(
+      const std::string& table_name);
+
+  /**
+   * Removes raw keys, as returned by GetRawHashTableEntries(), from a hash table. Keys that aren't
+   * in the table are ignored.
+   */
+  Status RemoveRawHashTableKeys(const std::string& table_name,
+                                const std::vector<std::string>& keys);
+
   // These are static counters of attached/open probes across all instances.
   // It is meant for verification that we have cleaned-up all resources in tests.
   static size_t num_attached_probes() { return num_attached_kprobes_ + num_attached_uprobes_; }
@@ -376,7 +569,39 @@ class BCCWrapper {
   Status DetachTracepoint(const TracepointSpec& probe);
   Status ClosePerfBuffer(const PerfBufferSpec& perf_buffer);
   Status DetachPerfEvent(const PerfEventSpec& perf_event);
-  void PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms);
+
+  // An open perf or ring buffer. Its events pass through here on their way to the callbacks of
+  // the spec, so that they are counted in the metrics.
+  struct PerfBuffer {
+    PerfBufferSpec spec;
+    void* cb_cookie;
+    PerfBufferMetrics metrics;
+    // The per-CPU readers of a perf buffer; empty for ring buffers.
+    std::vector<perf_reader*> readers = {};
+    // The events that were read so far.
+    uint64_t num_events = 0;
+  };
+  // Reads all events of the perf buffer, whether or not they reached the wake-up watermark.
+  // Returns the number of events that were read.
+  static int ConsumePerfBuffer(PerfBuffer* buffer);
+  static void HandlePerfBufferEvent(void* ctx, void* data, int size);
+  static void HandlePerfBufferLoss(void* ctx, uint64_t lost);
+
+  struct RingBuffer {
+    PerfBuffer buffer;
+    ebpf::BPFPercpuArrayTable<uint64_t> lost_counts;
+    // The lost events that were reported so far.
+    uint64_t num_lost = 0;
+  };
+  static int HandleRingBufferEvent(void* ctx, void* data, size_t size);
+
+  // Reads all ring buffers, waiting up to timeout_ms for events if there are none.
+  // Returns the number of events that were read.
+  int PollRingBuffers(int timeout_ms);
+  void ReportRingBufferLosses();
+
+  // Adds the FD of a perf or ring buffer to the epoll set that WaitForPerfBufferData() waits on.
+  Status WatchBufferFD(int fd);
 
   // Detaches all kprobes/uprobes/perf buffers/perf events that were attached by the wrapper.
   // If any fails to detach, an error is logged, and the function continues.
@@ -384,6 +609,7 @@ class BCCWrapper {
   void DetachUProbes();
   void DetachTracepoints();
   void ClosePerfBuffers();
+  void CloseRingBuffers();
   void DetachPerfEvents();
 
   // Returns the name that identifies the target to attach this k-probe.
@@ -392,7 +618,14 @@ class BCCWrapper {
   std::vector<KProbeSpec> kprobes_;
   std::vector<UProbeSpec> uprobes_;
   std::vector<TracepointSpec> tracepoints_;
-  std::vector<PerfBufferSpec> perf_buffers_;
+  std::vector<std::unique_ptr<PerfBuffer>> perf_buffers_;
+  std::vector<std::unique_ptr<RingBuffer>> ring_buffers_;
+  // A single libbpf ring buffer manager polls all of the ring buffers.
+  struct ring_buffer* ring_buffer_manager_ = nullptr;
+  // The epoll set of all perf and ring buffer FDs.
+  int buffer_epoll_fd_ = -1;
+  prometheus::Histogram& poll_duration_histogram_ =
+      PerfBufferPollDurationHistogram(&GetMetricsRegistry());
   std::vector<PerfEventSpec> perf_events_;
 
   std::string system_headers_include_dir_;
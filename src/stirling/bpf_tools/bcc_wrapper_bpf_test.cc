@@ -18,6 +18,8 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <sched.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 #include "src/common/testing/testing.h"
@@ -159,6 +161,125 @@ TEST(BCCWrapperTest, GetTGIDStartTime) {
   EXPECT_EQ(proc_pid_start_time, expected_proc_pid_start_time);
 }
 
+TEST(BCCWrapperTest, RingBuffer) {
+  if (!BCCWrapper::RingBuffersSupported()) {
+    GTEST_SKIP() << "BPF ring buffers require Linux 5.8+.";
+  }
+
+  std::string_view program = R"(
+    BPF_RINGBUF_OUTPUT(values, 1);
+    BPF_PERCPU_ARRAY(values_lost, uint64_t, 1);
+
+    int push_value(struct pt_regs* ctx) {
+      uint32_t value = 42;
+      values.ringbuf_output(&value, sizeof(value), 0);
+      return 0;
+    }
+  )";
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program));
+
+  std::vector<uint32_t> values;
+  PerfBufferSpec spec = {
+      .name = "values",
+      .probe_output_fn =
+          [](void* cb_cookie, void* data, int data_size) {
+            ASSERT_EQ(data_size, static_cast<int>(sizeof(uint32_t)));
+            static_cast<std::vector<uint32_t>*>(cb_cookie)->push_back(
+                *static_cast<uint32_t*>(data));
+          },
+      .probe_loss_fn = [](void* /*cb_cookie*/, uint64_t /*lost*/) {},
+  };
+  ASSERT_OK(bcc_wrapper.OpenRingBuffer(spec, &values));
+  EXPECT_EQ(1, bcc_wrapper.num_open_perf_buffers());
+
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "push_value"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+
+  BCCWrapperTestProbeTrigger();
+  BCCWrapperTestProbeTrigger();
+
+  EXPECT_EQ(1, bcc_wrapper.WaitForPerfBufferData(/* timeout_ms */ 1000));
+  EXPECT_EQ(2, bcc_wrapper.PollPerfBuffers());
+  EXPECT_THAT(values, ::testing::ElementsAre(42, 42));
+
+  bcc_wrapper.Close();
+  EXPECT_EQ(0, bcc_wrapper.num_open_perf_buffers());
+}
+
+TEST(BCCWrapperTest, PerfBufferWakeupWatermark) {
+  constexpr int kWatermark = 4;
+  gflags::FlagSaver flag_saver;
+  FLAGS_stirling_data_wakeup = true;
+  FLAGS_stirling_data_wakeup_watermark = kWatermark;
+
+  // The watermark applies to each per-CPU buffer, so all events must be pushed from one CPU.
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(sched_getcpu(), &cpus);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(cpus), &cpus));
+
+  std::string_view program = R"(
+    BPF_PERF_OUTPUT(values);
+
+    int push_value(struct pt_regs* ctx) {
+      uint32_t value = 42;
+      values.perf_submit(ctx, &value, sizeof(value));
+      return 0;
+    }
+  )";
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program));
+
+  std::vector<uint32_t> values;
+  PerfBufferSpec spec = {
+      .name = "values",
+      .probe_output_fn =
+          [](void* cb_cookie, void* data, int data_size) {
+            ASSERT_EQ(data_size, static_cast<int>(sizeof(uint32_t)));
+            static_cast<std::vector<uint32_t>*>(cb_cookie)->push_back(
+                *static_cast<uint32_t*>(data));
+          },
+      .probe_loss_fn = [](void* /*cb_cookie*/, uint64_t /*lost*/) {},
+      .size_bytes = 4096,
+  };
+  ASSERT_OK(bcc_wrapper.OpenPerfBuffer(spec, &values));
+  EXPECT_EQ(1, bcc_wrapper.num_open_perf_buffers());
+
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "push_value"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+
+  // Below the watermark, the wait times out, but polls still read the events.
+  for (int i = 0; i < kWatermark - 1; ++i) {
+    BCCWrapperTestProbeTrigger();
+  }
+  EXPECT_EQ(0, bcc_wrapper.WaitForPerfBufferData(/* timeout_ms */ 100));
+  EXPECT_EQ(kWatermark - 1, bcc_wrapper.PollPerfBuffers());
+
+  // Reaching the watermark wakes up the wait.
+  for (int i = 0; i < kWatermark; ++i) {
+    BCCWrapperTestProbeTrigger();
+  }
+  EXPECT_EQ(1, bcc_wrapper.WaitForPerfBufferData(/* timeout_ms */ 1000));
+  EXPECT_EQ(kWatermark, bcc_wrapper.PollPerfBuffers());
+  EXPECT_THAT(values, ::testing::SizeIs(2 * kWatermark - 1));
+
+  bcc_wrapper.Close();
+  EXPECT_EQ(0, bcc_wrapper.num_open_perf_buffers());
+}
+
 TEST(BCCWrapperTest, TestMapClearingAPIs) {
   // Test to show that get_table_offline() with clear_table=true actually clears the table.
   bpf_tools::BCCWrapper bcc_wrapper;
@@ -191,6 +312,37 @@ TEST(BCCWrapperTest, TestMapClearingAPIs) {
   ASSERT_THAT(alphabet.get_table_offline(), IsEmpty());
 }
 
+TEST(BCCWrapperTest, BatchMapOperations) {
+  bpf_tools::BCCWrapper bcc_wrapper;
+  std::string_view kProgram = "BPF_HASH(squares, uint32_t, uint64_t, 10000);";
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(kProgram));
+  ebpf::BPFHashTable squares = bcc_wrapper.GetHashTable<uint32_t, uint64_t>("squares");
+
+  // More entries than a single lookup batch holds.
+  std::vector<uint32_t> keys;
+  std::vector<uint64_t> values;
+  for (uint32_t i = 0; i < 9000; ++i) {
+    keys.push_back(i);
+    values.push_back(i * i);
+  }
+  ASSERT_OK(BCCWrapper::UpdateHashTableValues(&squares, keys, values));
+
+  auto entries = BCCWrapper::GetHashTableEntries(&squares);
+  ASSERT_EQ(entries.size(), keys.size());
+  for (const auto& [key, value] : entries) {
+    EXPECT_EQ(value, static_cast<uint64_t>(key) * key);
+  }
+
+  // Keys that aren't in the table don't stop the removal of the others.
+  ASSERT_OK(BCCWrapper::RemoveValues(&squares, std::vector<uint32_t>{1, 10000, 3, 20000}));
+  entries = BCCWrapper::GetHashTableEntries(&squares);
+  EXPECT_EQ(entries.size(), keys.size() - 2);
+  uint64_t value = 0;
+  EXPECT_FALSE(squares.get_value(1, value).ok());
+  EXPECT_FALSE(squares.get_value(3, value).ok());
+  EXPECT_TRUE(squares.get_value(2, value).ok());
+}
+
 // Tests that BCCWrapper can load XDP program.
 TEST(BCCWrapperTest, LoadXDP) {
   bpf_tools::BCCWrapper bcc_wrapper;
@@ -32,12 +32,16 @@
 #include <driver.h>
 #include <tracepoint_format_parser.h>
 
+#include <fstream>
 #include <limits>
 #include <sstream>
 #include <utility>
 
 #include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/config.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/bpf_tools/task_struct_resolver.h"
 #include "src/stirling/utils/linux_headers.h"
 
 namespace px {
@@ -55,6 +59,123 @@ std::string DumpDriver(const Driver& driver) {
   return oss.str();
 }
 
+namespace {
+
+// Bump whenever the layout of the cache files changes, or the bpftrace version is updated,
+// so that programs cached by older PEMs are recompiled.
+constexpr std::string_view kBPFTraceCacheVersion = "1";
+
+void WriteSizedString(std::string_view str, std::ostream* out) {
+  uint64_t size = str.size();
+  out->write(reinterpret_cast<const char*>(&size), sizeof(size));
+  out->write(str.data(), size);
+}
+
+bool ReadSizedString(std::istream* in, std::string* str) {
+  uint64_t size = 0;
+  if (!in->read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  str->resize(size);
+  return static_cast<bool>(in->read(str->data(), size));
+}
+
+// Identifies a compiled program. Anything that changes the bytecode must be part of the key.
+StatusOr<std::string> BPFTraceCacheKey(std::string_view script,
+                                       const std::vector<std::string>& params) {
+  PL_ASSIGN_OR_RETURN(std::string kernel_build_id, utils::KernelBuildID());
+  std::ostringstream key;
+  WriteSizedString(kBPFTraceCacheVersion, &key);
+  WriteSizedString(kernel_build_id, &key);
+  for (const auto& param : params) {
+    WriteSizedString(param, &key);
+  }
+  WriteSizedString(script, &key);
+  return key.str();
+}
+
+// A stable 64-bit FNV-1a hash, to name the cache file of a key. Unlike std::hash, it doesn't change
+// across builds. Collisions are harmless, because the file holds the full key.
+uint64_t FNV1aHash(std::string_view str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : str) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+Status ReadCachedBPFTraceProgram(const std::filesystem::path& cache_file, std::string_view key,
+                                 bpftrace::RequiredResources* resources,
+                                 bpftrace::BpfBytecode* bytecode) {
+  if (!fs::Exists(cache_file).ok()) {
+    return error::NotFound("No cached bpftrace program at $0.", cache_file.string());
+  }
+  std::ifstream in(cache_file, std::ios::binary);
+
+  // The file holds the key, the serialized resources, and then the bytecode by section.
+  std::string cached_key;
+  if (!ReadSizedString(&in, &cached_key)) {
+    return error::Internal("Malformed bpftrace program cache $0.", cache_file.string());
+  }
+  if (cached_key != key) {
+    return error::NotFound("Cached bpftrace program at $0 is of another script or kernel.",
+                           cache_file.string());
+  }
+
+  std::string resources_state;
+  uint64_t num_sections = 0;
+  if (!ReadSizedString(&in, &resources_state) ||
+      !in.read(reinterpret_cast<char*>(&num_sections), sizeof(num_sections))) {
+    return error::Internal("Malformed bpftrace program cache $0.", cache_file.string());
+  }
+  bpftrace::BpfBytecode cached_bytecode;
+  for (uint64_t i = 0; i < num_sections; ++i) {
+    std::string name;
+    std::string code;
+    if (!ReadSizedString(&in, &name) || !ReadSizedString(&in, &code)) {
+      return error::Internal("Malformed bpftrace program cache $0.", cache_file.string());
+    }
+    cached_bytecode[name] = std::vector<uint8_t>(code.begin(), code.end());
+  }
+
+  bpftrace::RequiredResources cached_resources;
+  try {
+    std::istringstream resources_in(resources_state);
+    cached_resources.load_state(resources_in);
+  } catch (const std::exception& e) {
+    return error::Internal("Malformed bpftrace program cache $0: $1", cache_file.string(),
+                           e.what());
+  }
+
+  *resources = std::move(cached_resources);
+  *bytecode = std::move(cached_bytecode);
+  return Status::OK();
+}
+
+Status WriteCachedBPFTraceProgram(const std::filesystem::path& cache_file, std::string_view key,
+                                  const bpftrace::RequiredResources& resources,
+                                  const bpftrace::BpfBytecode& bytecode) {
+  std::ostringstream resources_state;
+  resources.save_state(resources_state);
+
+  std::ostringstream contents;
+  WriteSizedString(key, &contents);
+  WriteSizedString(resources_state.str(), &contents);
+  uint64_t num_sections = bytecode.size();
+  contents.write(reinterpret_cast<const char*>(&num_sections), sizeof(num_sections));
+  for (const auto& [name, code] : bytecode) {
+    WriteSizedString(name, &contents);
+    WriteSizedString(
+        std::string_view(reinterpret_cast<const char*>(code.data()), code.size()), &contents);
+  }
+
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(cache_file.parent_path()));
+  return WriteFileFromString(cache_file, contents.str());
+}
+
 // Required to support strftime() in bpftrace code.
 // Since BPF nsecs uses monotonic clock, but strftime() needs to know the real time,
 // BPFtrace requires the offset to be passed in directly.
@@ -135,8 +256,6 @@ std::vector<std::string> ClangCompileFlags(bool has_btf, std::vector<std::string
   return extra_flags;
 }
 
-// This compile function is inspired from the bpftrace project's main.cpp.
-// Changes to bpftrace may need to be reflected back to this function on a bpftrace update.
 Status BPFTraceWrapper::Compile(std::string_view script, const std::vector<std::string>& params) {
   // Because BPFTrace uses global state (related to clear_struct_list()),
   // multiple simultaneous compiles may not be safe. For now, introduce a lock for safety.
@@ -144,6 +263,38 @@ Status BPFTraceWrapper::Compile(std::string_view script, const std::vector<std::
 
   const std::lock_guard<std::mutex> lock(compilation_mutex_);
 
+  // Deployment only needs the resources and the bytecode, which are the same for the same script
+  // on the same kernel. Loading them from the cache spares the headers, clang and LLVM.
+  std::filesystem::path cache_file;
+  std::string cache_key;
+  if (!FLAGS_stirling_bpf_cache_dir.empty()) {
+    PL_ASSIGN_OR_RETURN(cache_key, BPFTraceCacheKey(script, params));
+    cache_file = std::filesystem::path(FLAGS_stirling_bpf_cache_dir) / "bpftrace" /
+                 absl::StrCat(absl::Hex(FNV1aHash(cache_key), absl::kZeroPad16));
+    Status s = ReadCachedBPFTraceProgram(cache_file, cache_key, &bpftrace_.resources, &bytecode_);
+    if (s.ok()) {
+      LOG(INFO) << absl::Substitute("Using bpftrace program cached at $0.", cache_file.string());
+      compiled_ = true;
+      return Status::OK();
+    }
+    LOG_IF(WARNING, !error::IsNotFound(s)) << s.ToString();
+  }
+
+  PL_RETURN_IF_ERROR(CompileProgram(script, params));
+  compiled_ = true;
+
+  if (!cache_file.empty()) {
+    Status s = WriteCachedBPFTraceProgram(cache_file, cache_key, bpftrace_.resources, bytecode_);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to cache bpftrace program: $0",
+                                                 s.ToString());
+  }
+  return Status::OK();
+}
+
+// This compile function is inspired from the bpftrace project's main.cpp.
+// Changes to bpftrace may need to be reflected back to this function on a bpftrace update.
+Status BPFTraceWrapper::CompileProgram(std::string_view script,
+                                       const std::vector<std::string>& params) {
   // Some functions below return errors, while others success as positive numbers.
   // For readability, use two separate variables for the two models.
   int err;
@@ -208,8 +359,6 @@ Status BPFTraceWrapper::Compile(std::string_view script, const std::vector<std::
   std::unique_ptr<bpftrace::BpfOrc> bpforc = llvm.emit();
   bytecode_ = bpforc->getBytecode();
 
-  compiled_ = true;
-
   return Status::OK();
 }
 
@@ -21,6 +21,7 @@
 #include <bpftrace.h>
 #include <driver.h>
 
+#include <filesystem>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -35,6 +36,23 @@ namespace bpf_tools {
 // Dump the bpftrace program's syntax data and other relevant internal process data.
 std::string DumpDriver(const bpftrace::Driver& driver);
 
+/**
+ * Reads a compiled bpftrace program from the cache file.
+ * The key identifies the script, its parameters and the kernel it was compiled for.
+ *
+ * Returns NotFound if there is no cache file, or if it holds a program compiled for another key.
+ */
+Status ReadCachedBPFTraceProgram(const std::filesystem::path& cache_file, std::string_view key,
+                                 bpftrace::RequiredResources* resources,
+                                 bpftrace::BpfBytecode* bytecode);
+
+/**
+ * Writes a compiled bpftrace program to the cache file, under the given key.
+ */
+Status WriteCachedBPFTraceProgram(const std::filesystem::path& cache_file, std::string_view key,
+                                  const bpftrace::RequiredResources& resources,
+                                  const bpftrace::BpfBytecode& bytecode);
+
 /**
  * Wrapper around BPFTrace, as a convenience.
  */
@@ -52,6 +70,8 @@ class BPFTraceWrapper {
 
   /**
    * Compiles the BPFTrace program, assuming the output mode is via printfs.
+   * When --stirling_bpf_cache_dir is set, programs compiled on the same kernel are loaded from
+   * the cache instead, which leaves only the attach to Deploy().
    *
    * @return error if there is a syntax or semantic error.
    *         Also errors if there is no printf statement in the compiled program,
@@ -107,6 +127,7 @@ class BPFTraceWrapper {
 
  private:
   Status Compile(std::string_view script, const std::vector<std::string>& params);
+  Status CompileProgram(std::string_view script, const std::vector<std::string>& params);
 
   // Checks the output for dynamic tracing:
   //  1) There must be at least one printf.
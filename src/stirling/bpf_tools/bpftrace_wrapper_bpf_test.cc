@@ -20,10 +20,13 @@
 
 #include "src/common/testing/testing.h"
 
+DECLARE_string(stirling_bpf_cache_dir);
+
 namespace px {
 namespace stirling {
 namespace bpf_tools {
 
+using ::px::testing::TempDir;
 using ::px::testing::status::StatusIs;
 using ::testing::HasSubstr;
 
@@ -62,6 +65,35 @@ TEST(BPFTracerWrapperTest, PerfBufferPoll) {
   bpftrace_wrapper.Stop();
 }
 
+TEST(BPFTracerWrapperTest, DeployFromCache) {
+  constexpr std::string_view kScript = R"(
+  interval:ms:100 {
+      @retval[0] = nsecs;
+  }
+  )";
+
+  TempDir cache_dir;
+  FLAGS_stirling_bpf_cache_dir = cache_dir.path().string();
+
+  {
+    BPFTraceWrapper bpftrace_wrapper;
+    ASSERT_OK(bpftrace_wrapper.CompileForMapOutput(kScript));
+  }
+  EXPECT_FALSE(std::filesystem::is_empty(cache_dir.path() / "bpftrace"));
+
+  // The second compile loads the cached program, which must deploy the same way.
+  BPFTraceWrapper bpftrace_wrapper;
+  ASSERT_OK(bpftrace_wrapper.CompileForMapOutput(kScript));
+  ASSERT_OK(bpftrace_wrapper.Deploy());
+  sleep(1);
+
+  bpftrace::BPFTraceMap entries = bpftrace_wrapper.GetBPFMap("@retval");
+  EXPECT_FALSE(entries.empty());
+
+  bpftrace_wrapper.Stop();
+  FLAGS_stirling_bpf_cache_dir = "";
+}
+
 // To show that the callback can be to a member function.
 class CallbackWrapperClass {
  public:
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/bpf_tools/bpftrace_wrapper.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+using ::px::testing::TempDir;
+
+TEST(CachedBPFTraceProgram, WriteAndRead) {
+  TempDir cache_dir;
+  const std::filesystem::path cache_file = cache_dir.path() / "bpftrace" / "program";
+
+  bpftrace::RequiredResources resources;
+  bpftrace::BpfBytecode bytecode;
+  EXPECT_TRUE(error::IsNotFound(
+      ReadCachedBPFTraceProgram(cache_file, "script", &resources, &bytecode)));
+
+  bpftrace::BpfBytecode program = {{"s_interval_ms_100_1", {0xb7, 0x00, 0x00, 0x00, 0x95}},
+                                   {"s_BEGIN_1", {}}};
+  ASSERT_OK(WriteCachedBPFTraceProgram(cache_file, "script", resources, program));
+  ASSERT_OK(ReadCachedBPFTraceProgram(cache_file, "script", &resources, &bytecode));
+  EXPECT_EQ(bytecode, program);
+
+  // Programs cached under another script or kernel are ignored.
+  EXPECT_TRUE(error::IsNotFound(
+      ReadCachedBPFTraceProgram(cache_file, "other script", &resources, &bytecode)));
+
+  ASSERT_OK(WriteFileFromString(cache_file, "garbage"));
+  EXPECT_NOT_OK(ReadCachedBPFTraceProgram(cache_file, "script", &resources, &bytecode));
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
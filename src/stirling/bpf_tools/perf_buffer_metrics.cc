@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/perf_buffer_metrics.h"
+
+#include <string>
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+PerfBufferMetrics::PerfBufferMetrics(prometheus::Registry* registry,
+                                     const std::string& buffer_name)
+    : events_counter(&prometheus::BuildCounter()
+                          .Name("stirling_perf_buffer_events")
+                          .Help("Total events read from the perf buffer")
+                          .Register(*registry)
+                          .Add({{"name", buffer_name}})),
+      bytes_counter(&prometheus::BuildCounter()
+                         .Name("stirling_perf_buffer_bytes")
+                         .Help("Total bytes of the events read from the perf buffer")
+                         .Register(*registry)
+                         .Add({{"name", buffer_name}})),
+      lost_events_counter(prometheus::BuildCounter()
+                              .Name("stirling_perf_buffer_lost_events")
+                              .Help("Total events that were dropped because the perf buffer was "
+                                    "full")
+                              .Register(*registry)
+                              .Add({{"name", buffer_name}})) {}
+
+prometheus::Histogram& PerfBufferPollDurationHistogram(prometheus::Registry* registry) {
+  return prometheus::BuildHistogram()
+      .Name("stirling_perf_buffer_poll_duration_seconds")
+      .Help("Time taken to drain the perf buffers of a BPF program, including handling the events")
+      .Register(*registry)
+      .Add({}, prometheus::Histogram::BucketBoundaries{0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05,
+                                                       0.1, 0.5, 1});
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
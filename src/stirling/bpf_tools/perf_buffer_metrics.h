@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include <prometheus/counter.h>
+#include <prometheus/histogram.h>
+#include <prometheus/registry.h>
+
+#include "src/common/metrics/sharded_metrics.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+/**
+ * The metrics of one perf or ring buffer, labeled with its name. The event counters are updated
+ * for every event, so they are sharded.
+ */
+struct PerfBufferMetrics {
+  PerfBufferMetrics(prometheus::Registry* registry, const std::string& buffer_name);
+
+  metrics::ShardedCounter events_counter;
+  metrics::ShardedCounter bytes_counter;
+  prometheus::Counter& lost_events_counter;
+};
+
+/**
+ * The time taken to drain all of the perf and ring buffers of a BCCWrapper, which includes the
+ * time spent in their callbacks.
+ */
+prometheus::Histogram& PerfBufferPollDurationHistogram(prometheus::Registry* registry);
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
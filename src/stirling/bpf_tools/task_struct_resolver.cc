@@ -19,12 +19,17 @@
 #include "src/stirling/bpf_tools/task_struct_resolver.h"
 
 #include <poll.h>
+#include <sys/utsname.h>
 
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
 #include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/proc_parser.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
@@ -293,6 +298,69 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets() {
   }
 }
 
+StatusOr<std::string> KernelBuildID() {
+  struct utsname buffer;
+  if (uname(&buffer) != 0) {
+    return error::Internal("Could not determine the kernel build (uname): $0",
+                           std::strerror(errno));
+  }
+  return absl::StrCat(buffer.release, " ", buffer.version, " ", buffer.machine);
+}
+
+namespace {
+
+// Offsets that the resolver can't have produced mean that the cache file was corrupted.
+Status ValidateTaskStructOffsets(const TaskStructOffsets& offsets) {
+  for (uint64_t offset : {offsets.real_start_time_offset, offsets.group_leader_offset}) {
+    if (offset == 0 || offset % sizeof(uint64_t) != 0 || offset >= sizeof(struct buf)) {
+      return error::InvalidArgument("Invalid task struct offsets $0.", offsets.ToString());
+    }
+  }
+  if (offsets.real_start_time_offset == offsets.group_leader_offset) {
+    return error::InvalidArgument("Invalid task struct offsets $0.", offsets.ToString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<TaskStructOffsets> ReadCachedTaskStructOffsets(const std::filesystem::path& cache_file) {
+  if (!fs::Exists(cache_file).ok()) {
+    return error::NotFound("No cached task struct offsets at $0.", cache_file.string());
+  }
+  PL_ASSIGN_OR_RETURN(std::string kernel_build_id, KernelBuildID());
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(cache_file));
+
+  // The file holds the kernel build ID on the first line, and the offsets on the second.
+  std::vector<std::string_view> lines = absl::StrSplit(contents, '\n', absl::SkipEmpty());
+  if (lines.size() != 2) {
+    return error::Internal("Malformed task struct offsets cache $0.", cache_file.string());
+  }
+  if (lines[0] != kernel_build_id) {
+    return error::NotFound("Cached task struct offsets at $0 are of another kernel [$1].",
+                           cache_file.string(), lines[0]);
+  }
+
+  TaskStructOffsets offsets;
+  std::vector<std::string_view> values = absl::StrSplit(lines[1], ' ');
+  if (values.size() != 2 || !absl::SimpleAtoi(values[0], &offsets.real_start_time_offset) ||
+      !absl::SimpleAtoi(values[1], &offsets.group_leader_offset)) {
+    return error::Internal("Malformed task struct offsets cache $0.", cache_file.string());
+  }
+  PL_RETURN_IF_ERROR(ValidateTaskStructOffsets(offsets));
+  return offsets;
+}
+
+Status WriteCachedTaskStructOffsets(const std::filesystem::path& cache_file,
+                                    const TaskStructOffsets& offsets) {
+  PL_RETURN_IF_ERROR(ValidateTaskStructOffsets(offsets));
+  PL_ASSIGN_OR_RETURN(std::string kernel_build_id, KernelBuildID());
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(cache_file.parent_path()));
+  return WriteFileFromString(
+      cache_file, absl::Substitute("$0\n$1 $2\n", kernel_build_id, offsets.real_start_time_offset,
+                                   offsets.group_leader_offset));
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <filesystem>
 #include <string>
 
 #include "src/common/base/base.h"
@@ -30,7 +31,7 @@ struct TaskStructOffsets {
   uint64_t real_start_time_offset = 0;
   uint64_t group_leader_offset = 0;
 
-  std::string ToString() {
+  std::string ToString() const {
     return absl::Substitute("{real_start_time=$0, group_leader=$1}", real_start_time_offset,
                             group_leader_offset);
   }
@@ -67,6 +68,29 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets();
  */
 StatusOr<TaskStructOffsets> ResolveTaskStructOffsetsCore();
 
+/**
+ * Identifies the running kernel build, the same way as `uname -rvm`.
+ * Results derived from BPF programs are cached under this ID.
+ */
+StatusOr<std::string> KernelBuildID();
+
+/**
+ * Reads task struct offsets that were written to the cache file on the running kernel.
+ * The offsets are only a function of the kernel build, so they can be reused across restarts,
+ * which spares the BPF compilation of the resolver.
+ *
+ * Returns NotFound if there is no cache file, or if it was written on a different kernel.
+ * Returns an error if the cached offsets fail a sanity check, in which case they must be
+ * resolved again.
+ */
+StatusOr<TaskStructOffsets> ReadCachedTaskStructOffsets(const std::filesystem::path& cache_file);
+
+/**
+ * Writes the task struct offsets to the cache file, keyed by the running kernel.
+ */
+Status WriteCachedTaskStructOffsets(const std::filesystem::path& cache_file,
+                                    const TaskStructOffsets& offsets);
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
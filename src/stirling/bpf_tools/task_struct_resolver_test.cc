@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/bpf_tools/task_struct_resolver.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+using ::px::testing::TempDir;
+
+TEST(CachedTaskStructOffsets, WriteAndRead) {
+  TempDir cache_dir;
+  const std::filesystem::path cache_file = cache_dir.path() / "bpf" / "task_struct_offsets";
+
+  EXPECT_TRUE(error::IsNotFound(ReadCachedTaskStructOffsets(cache_file).status()));
+
+  TaskStructOffsets offsets;
+  offsets.real_start_time_offset = 1432;
+  offsets.group_leader_offset = 1184;
+  ASSERT_OK(WriteCachedTaskStructOffsets(cache_file, offsets));
+  ASSERT_OK_AND_EQ(ReadCachedTaskStructOffsets(cache_file), offsets);
+
+  // Offsets cached on another kernel are ignored.
+  ASSERT_OK(WriteFileFromString(cache_file, "4.14.0 #1 SMP x86_64\n1432 1184\n"));
+  EXPECT_TRUE(error::IsNotFound(ReadCachedTaskStructOffsets(cache_file).status()));
+
+  ASSERT_OK(WriteFileFromString(cache_file, "garbage"));
+  EXPECT_NOT_OK(ReadCachedTaskStructOffsets(cache_file));
+}
+
+TEST(CachedTaskStructOffsets, RejectsInvalidOffsets) {
+  TempDir cache_dir;
+  const std::filesystem::path cache_file = cache_dir.path() / "task_struct_offsets";
+  ASSERT_OK_AND_ASSIGN(std::string kernel_build_id, KernelBuildID());
+
+  // Unaligned, beyond the resolved part of task_struct, and overlapping offsets.
+  for (std::string_view values : {"1433 1184", "1432 65536", "1184 1184", "0 1184"}) {
+    ASSERT_OK(WriteFileFromString(cache_file, absl::StrCat(kernel_build_id, "\n", values, "\n")));
+    EXPECT_NOT_OK(ReadCachedTaskStructOffsets(cache_file)) << values;
+  }
+
+  TaskStructOffsets offsets;
+  offsets.real_start_time_offset = 1432;
+  offsets.group_leader_offset = 1432;
+  EXPECT_NOT_OK(WriteCachedTaskStructOffsets(cache_file, offsets));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -68,5 +68,55 @@ absl::flat_hash_set<md::UPID> ListUPIDs(const std::filesystem::path& proc_path,
   return pids;
 }
 
+std::shared_ptr<const absl::flat_hash_set<md::UPID>> UPIDTracker::Update() {
+  absl::MutexLock lock(&mutex_);
+  const uint64_t update = ++num_updates_;
+  bool changed = false;
+
+  std::error_code ec;
+  for (const auto& p : std::filesystem::directory_iterator(proc_path_, ec)) {
+    uint32_t pid = 0;
+    if (!absl::SimpleAtoi(p.path().filename().string(), &pid)) {
+      continue;
+    }
+    auto iter = pids_.find(pid);
+    if (iter != pids_.end()) {
+      iter->second.update = update;
+      continue;
+    }
+    StatusOr<int64_t> pid_start_time = system::GetPIDStartTimeTicks(p.path());
+    if (!pid_start_time.ok()) {
+      VLOG(1) << absl::Substitute("Could not get PID start time for pid $0. Likely already dead.",
+                                  p.path().string());
+      continue;
+    }
+    pids_.emplace(pid, TrackedPID{md::UPID(asid_, pid, pid_start_time.ValueOrDie()), update});
+    changed = true;
+  }
+  if (ec) {
+    LOG(WARNING) << absl::Substitute("Failed to list $0: $1", proc_path_.string(), ec.message());
+    return upids_;
+  }
+
+  for (auto iter = pids_.begin(); iter != pids_.end();) {
+    if (iter->second.update != update) {
+      pids_.erase(iter++);
+      changed = true;
+    } else {
+      ++iter;
+    }
+  }
+
+  if (changed) {
+    auto upids = std::make_shared<absl::flat_hash_set<md::UPID>>();
+    upids->reserve(pids_.size());
+    for (const auto& [pid, tracked] : pids_) {
+      upids->insert(tracked.upid);
+    }
+    upids_ = std::move(upids);
+  }
+  return upids_;
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -23,6 +23,10 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/shared/types/types.h"
@@ -37,6 +41,42 @@ namespace stirling {
  */
 absl::flat_hash_set<md::UPID> ListUPIDs(const std::filesystem::path& proc_path, uint32_t asid = 0);
 
+/**
+ * UPIDTracker keeps the set of processes of the proc filesystem up to date across calls to
+ * Update(). An update lists the PID directories, but only reads the start times of the PIDs it
+ * hasn't seen before, where ListUPIDs reads the start time of every PID. The set is only rebuilt
+ * when a process started or exited, so contexts of consecutive updates share it otherwise.
+ *
+ * A PID that is reused between two updates keeps the UPID of its previous process until an update
+ * finds its directory gone.
+ */
+class UPIDTracker : NotCopyMoveable {
+ public:
+  explicit UPIDTracker(std::filesystem::path proc_path, uint32_t asid = 0)
+      : proc_path_(std::move(proc_path)), asid_(asid) {}
+
+  /**
+   * Rescans the proc filesystem, and returns the current set of UPIDs.
+   */
+  std::shared_ptr<const absl::flat_hash_set<md::UPID>> Update();
+
+ private:
+  struct TrackedPID {
+    md::UPID upid;
+    // The last update that saw the PID.
+    uint64_t update;
+  };
+
+  const std::filesystem::path proc_path_;
+  const uint32_t asid_;
+
+  absl::Mutex mutex_;
+  uint64_t num_updates_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::flat_hash_map<uint32_t, TrackedPID> pids_ ABSL_GUARDED_BY(mutex_);
+  std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids_ ABSL_GUARDED_BY(mutex_) =
+      std::make_shared<const absl::flat_hash_set<md::UPID>>();
+};
+
 /**
  * ConnectorContext is the information passed on every Transfer call to source connectors.
  */
@@ -57,7 +97,7 @@ class ConnectorContext {
   /**
    * Return detailed information on UPIDs.
    */
-  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const = 0;
+  virtual const md::PIDInfoMap& GetPIDInfoMap() const = 0;
 
   /**
    * Return K8s information (Pod and container information)
@@ -72,6 +112,17 @@ class ConnectorContext {
    * tracing.
    */
   virtual std::vector<CIDRBlock> GetClusterCIDRs() = 0;
+
+  /**
+   * Returns the position of the UPIDs of the context in the process event log of Stirling, if it
+   * has one. ProcTrackers use it to read the processes that started and exited since their
+   * previous update, instead of diffing the UPIDs.
+   */
+  const ProcEventLogPosition& proc_events() const { return proc_events_; }
+  void set_proc_events(ProcEventLogPosition proc_events) { proc_events_ = proc_events; }
+
+ private:
+  ProcEventLogPosition proc_events_;
 };
 
 /**
@@ -95,7 +146,7 @@ class AgentContext : public ConnectorContext {
     return agent_metadata_state_->upids();
   }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
+  const md::PIDInfoMap& GetPIDInfoMap() const override {
     return agent_metadata_state_->pids_by_upid();
   }
 
@@ -114,9 +165,17 @@ class AgentContext : public ConnectorContext {
  */
 class StandaloneContext : public ConnectorContext {
  public:
-  StandaloneContext() {
+  StandaloneContext()
+      : StandaloneContext(std::make_shared<const absl::flat_hash_set<md::UPID>>(
+            ListUPIDs(system::Config::GetInstance().proc_path(), 0))) {}
+
+  /**
+   * @param upids The current processes, such as from a UPIDTracker.
+   */
+  explicit StandaloneContext(std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids)
+      : upids_(std::move(upids)) {
     // The context consists of all PIDs, but no pods/containers.
-    upids_ = ListUPIDs(system::Config::GetInstance().proc_path(), 0);
+    DCHECK(upids_ != nullptr);
 
     // Cannot be empty, otherwise stirling will wait indefinitely. Since StandaloneContext is used
     // for local environment, set it such that localhost (127.0.0.1) will be treated as outside of
@@ -127,10 +186,10 @@ class StandaloneContext : public ConnectorContext {
 
   uint32_t GetASID() const override { return 0; }
 
-  const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return upids_; }
+  const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return *upids_; }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
-    static const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr> kEmpty;
+  const md::PIDInfoMap& GetPIDInfoMap() const override {
+    static const md::PIDInfoMap kEmpty;
     return kEmpty;
   }
 
@@ -145,7 +204,7 @@ class StandaloneContext : public ConnectorContext {
 
  private:
   std::vector<CIDRBlock> cidrs_;
-  absl::flat_hash_set<md::UPID> upids_;
+  std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids_;
 };
 
 }  // namespace stirling
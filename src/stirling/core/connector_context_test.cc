@@ -22,6 +22,7 @@
 
 #include "src/common/testing/testing.h"
 
+using ::px::testing::TempDir;
 using ::px::testing::TestFilePath;
 using ::testing::UnorderedElementsAre;
 
@@ -32,7 +33,39 @@ TEST(ListUPIDs, Basic) {
   const std::filesystem::path proc_path = TestFilePath("src/common/system/testdata/proc");
   EXPECT_THAT(ListUPIDs(proc_path),
               UnorderedElementsAre(md::UPID{0, 123, 14329}, md::UPID{0, 1, 13},
-                                   md::UPID{0, 456, 17594622}, md::UPID{0, 789, 46120203}));
+                                   md::UPID{0, 321, 17594700}, md::UPID{0, 456, 17594622},
+                                   md::UPID{0, 789, 46120203}));
+}
+
+TEST(UPIDTracker, UpdatesOnProcessChanges) {
+  const std::filesystem::path testdata_path = TestFilePath("src/common/system/testdata/proc");
+  TempDir proc_dir;
+  const auto copy_pid = [&](std::string_view pid) {
+    std::filesystem::copy(testdata_path / pid, proc_dir.path() / pid,
+                          std::filesystem::copy_options::recursive);
+  };
+  copy_pid("1");
+  copy_pid("123");
+
+  UPIDTracker tracker(proc_dir.path());
+  auto upids = tracker.Update();
+  EXPECT_THAT(*upids, UnorderedElementsAre(md::UPID{0, 1, 13}, md::UPID{0, 123, 14329}));
+
+  // The set is shared while no process started or exited.
+  EXPECT_EQ(upids, tracker.Update());
+
+  copy_pid("456");
+  upids = tracker.Update();
+  EXPECT_THAT(*upids, UnorderedElementsAre(md::UPID{0, 1, 13}, md::UPID{0, 123, 14329},
+                                           md::UPID{0, 456, 17594622}));
+
+  std::filesystem::remove_all(proc_dir.path() / "123");
+  upids = tracker.Update();
+  EXPECT_THAT(*upids, UnorderedElementsAre(md::UPID{0, 1, 13}, md::UPID{0, 456, 17594622}));
+
+  // Contexts built from the tracker see the same processes.
+  StandaloneContext ctx(upids);
+  EXPECT_EQ(&ctx.GetUPIDs(), upids.get());
 }
 
 }  // namespace stirling
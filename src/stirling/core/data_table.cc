@@ -17,11 +17,13 @@
  */
 
 #include <algorithm>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/shared/types/type_utils.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/types.h"
@@ -33,7 +35,47 @@ namespace stirling {
 using types::ColumnWrapper;
 using types::DataType;
 
-DataTable::DataTable(uint64_t id, const DataTableSchema& schema) : id_(id), table_schema_(schema) {}
+DataTable::DataTable(uint64_t id, const DataTableSchema& schema)
+    : id_(id),
+      table_schema_(schema),
+      push_policy_(schema.push_policy()),
+      subscribed_columns_(schema.elements().size(), true) {}
+
+Status DataTable::SetSubscribedColumns(const std::vector<std::string>& column_names) {
+  std::vector<bool> subscribed_columns(table_schema_.elements().size(), column_names.empty());
+  for (const auto& name : column_names) {
+    std::optional<size_t> index;
+    for (size_t i = 0; i < table_schema_.elements().size(); ++i) {
+      if (table_schema_.elements()[i].name() == name) {
+        index = i;
+        break;
+      }
+    }
+    if (!index.has_value()) {
+      return error::InvalidArgument("Table $0 has no column $1.", table_schema_.name(), name);
+    }
+    subscribed_columns[*index] = true;
+  }
+  subscribed_columns_ = std::move(subscribed_columns);
+  return Status::OK();
+}
+
+bool DataTable::PushThresholdExceeded() const {
+  if (num_records_ == 0) {
+    return false;
+  }
+  if (push_policy_.max_records != 0 && num_records_ > push_policy_.max_records) {
+    return true;
+  }
+  if (push_policy_.max_bytes != 0 && num_bytes_ > push_policy_.max_bytes) {
+    return true;
+  }
+  if (push_policy_.max_age.count() != 0 &&
+      px::chrono::coarse_steady_clock::now() - oldest_record_time_ > push_policy_.max_age) {
+    return true;
+  }
+  return false;
+}
 
 void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
   DCHECK(record_batch_ptr != nullptr);
@@ -59,10 +101,112 @@ Tablet* DataTable::GetTablet(types::TabletIDView tablet_id) {
   return &tablet;
 }
 
+namespace {
+
+template <typename TValueType>
+void MoveAppend(ColumnWrapper* src, ColumnWrapper* dst) {
+  auto* typed_src = static_cast<types::ColumnWrapperTmpl<TValueType>*>(src);
+  auto* typed_dst = static_cast<types::ColumnWrapperTmpl<TValueType>*>(dst);
+  typed_dst->MoveAppend(typed_src);
+}
+
+}  // namespace
+
+void DataTable::MergeFrom(DataTable* other) {
+  DCHECK_EQ(&table_schema_, &other->table_schema_);
+  if (other->num_records_ == 0) {
+    return;
+  }
+
+  for (auto& [tablet_id, src] : other->tablets_) {
+    if (src.times.empty()) {
+      continue;
+    }
+    Tablet* dst = GetTablet(tablet_id);
+    dst->times.insert(dst->times.end(), src.times.begin(), src.times.end());
+    src.times.clear();
+    for (size_t i = 0; i < src.records.size(); ++i) {
+      DataType type = table_schema_.elements()[i].type();
+#define TYPE_CASE(_dt_) \
+  MoveAppend<types::DataTypeTraits<_dt_>::value_type>(src.records[i].get(), dst->records[i].get());
+      PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+
+  if (num_records_ == 0 || other->oldest_record_time_ < oldest_record_time_) {
+    oldest_record_time_ = other->oldest_record_time_;
+  }
+  num_records_ += other->num_records_;
+  num_bytes_ += other->num_bytes_;
+  other->num_records_ = 0;
+  other->num_bytes_ = 0;
+}
+
+void DataTable::EnablePushDelayMetrics(std::function<uint64_t()> now_ns) {
+  if (push_delay_histogram_ != nullptr) {
+    return;
+  }
+  push_delay_histogram_ =
+      &prometheus::BuildHistogram()
+           .Name("stirling_record_push_delay_seconds")
+           .Help("Delay between the time of a record, such as when its event happened in the "
+                 "kernel, and its push out of Stirling")
+           .Register(GetMetricsRegistry())
+           .Add({{"table", std::string(table_schema_.name())}},
+                prometheus::Histogram::BucketBoundaries{0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5,
+                                                        10, 30});
+  push_delay_now_ns_ = std::move(now_ns);
+}
+
+Status DataTable::SetTabletizationKey(std::string_view column_name) {
+  if (table_schema_.tabletized()) {
+    return error::InvalidArgument("Table $0 is already tabletized.", table_schema_.name());
+  }
+  for (size_t i = 0; i < table_schema_.elements().size(); ++i) {
+    const DataElement& element = table_schema_.elements()[i];
+    if (element.name() != column_name) {
+      continue;
+    }
+    if (element.type() != types::DataType::INT64 && element.type() != types::DataType::UINT128) {
+      return error::InvalidArgument("Column $0 of table $1 can't be a tabletization key.",
+                                    column_name, table_schema_.name());
+    }
+    tabletization_key_ = i;
+    return Status::OK();
+  }
+  return error::InvalidArgument("Table $0 has no column $1.", table_schema_.name(), column_name);
+}
+
+namespace {
+
+// Groups the indexes of the records by the tablet of their tabletization key, keeping their order.
+std::vector<std::pair<types::TabletID, std::vector<size_t>>> GroupByTablet(
+    const types::ColumnWrapper& key_col, const std::vector<size_t>& indexes) {
+  std::vector<std::pair<types::TabletID, std::vector<size_t>>> groups;
+  absl::flat_hash_map<types::TabletID, size_t> group_by_tablet;
+  for (size_t idx : indexes) {
+    types::TabletID tablet_id = key_col.data_type() == types::DataType::UINT128
+                                    ? types::ToTabletID(key_col.Get<types::UInt128Value>(idx))
+                                    : types::ToTabletID(key_col.Get<types::Int64Value>(idx));
+    auto [iter, inserted] = group_by_tablet.try_emplace(tablet_id, groups.size());
+    if (inserted) {
+      groups.emplace_back(std::move(tablet_id), std::vector<size_t>());
+    }
+    groups[iter->second].second.push_back(idx);
+  }
+  return groups;
+}
+
+}  // namespace
+
 std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
+  const uint64_t push_time = push_delay_histogram_ != nullptr ? push_delay_now_ns_() : 0;
   std::vector<TaggedRecordBatch> tablets_out;
   absl::flat_hash_map<types::TabletID, Tablet> carryover_tablets;
   uint64_t next_start_time = start_time_;
+  size_t num_carryover_records = 0;
+  size_t num_carryover_bytes = 0;
 
   for (auto& [tablet_id, tablet] : tablets_) {
     // Sort based on times.
@@ -96,13 +240,30 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
       // TODO(oazizi): Consider VectorView to avoid copying.
       std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
                                        sort_indexes.end() - num_carryover);
-      types::ColumnWrapperRecordBatch pushable_records;
-      for (auto& col : tablet.records) {
-        pushable_records.push_back(col->MoveIndexes(push_indexes));
+      if (tabletization_key_.has_value()) {
+        for (auto& [key_tablet_id, indexes] :
+             GroupByTablet(*tablet.records[*tabletization_key_], push_indexes)) {
+          types::ColumnWrapperRecordBatch key_tablet_records;
+          for (auto& col : tablet.records) {
+            key_tablet_records.push_back(col->MoveIndexes(indexes));
+          }
+          tablets_out.push_back(TaggedRecordBatch{key_tablet_id, std::move(key_tablet_records)});
+        }
+      } else {
+        types::ColumnWrapperRecordBatch pushable_records;
+        for (auto& col : tablet.records) {
+          pushable_records.push_back(col->MoveIndexes(push_indexes));
+        }
+        tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
+      }
+      if (push_delay_histogram_ != nullptr) {
+        for (size_t idx : push_indexes) {
+          const uint64_t time = tablet.times[idx];
+          push_delay_histogram_->Observe(push_time > time ? (push_time - time) / 1e9 : 0);
+        }
       }
       uint64_t last_time = tablet.times[push_indexes.back()];
       next_start_time = std::max(next_start_time, last_time);
-      tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
     }
 
     // Case 3: Carryover records.
@@ -119,6 +280,10 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
       for (size_t i = 0; i < times.size(); ++i) {
         times[i] = tablet.times[carryover_indexes[i]];
       }
+      num_carryover_records += times.size();
+      for (const auto& col : carryover_records) {
+        num_carryover_bytes += col->Bytes();
+      }
       carryover_tablets[tablet_id] =
           Tablet{tablet_id, std::move(times), std::move(carryover_records)};
     }
@@ -127,6 +292,12 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
 
   start_time_ = next_start_time;
 
+  // Carried-over records restart their age from now, since their original insertion time is not
+  // tracked per record.
+  num_records_ = num_carryover_records;
+  num_bytes_ = num_carryover_bytes;
+  oldest_record_time_ = px::chrono::coarse_steady_clock::now();
+
   return tablets_out;
 }
 
@@ -19,15 +19,23 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <prometheus/histogram.h>
 
 #include "src/common/base/base.h"
 #include "src/common/base/mixins.h"
+#include "src/common/system/clock.h"
 #include "src/stirling/core/types.h"
 
 namespace px {
@@ -86,18 +94,16 @@ class DataTable : public NotCopyable {
 
   /**
    * Return current occupancy of the Data Table.
+   * Tracked incrementally as records are appended, so this is O(1).
    *
    * @return size_t occupancy
    */
-  size_t Occupancy() const {
-    size_t occupancy = 0;
-    for (auto& [tablet_id, tablet] : tablets_) {
-      if (!tablet.records.empty()) {
-        occupancy += tablet.records[0]->Size();
-      }
-    }
-    return occupancy;
-  }
+  size_t Occupancy() const { return num_records_; }
+
+  /**
+   * Approximate number of bytes held by the buffered records.
+   */
+  size_t OccupancyBytes() const { return num_bytes_; }
 
   /**
    * Occupancy of the Data Table as a percentage of size.
@@ -106,6 +112,50 @@ class DataTable : public NotCopyable {
    */
   double OccupancyPct() const { return 1.0 * Occupancy() / kTargetCapacity; }
 
+  /**
+   * Returns true if the buffered data exceeds any of the thresholds of the push policy.
+   */
+  bool PushThresholdExceeded() const;
+
+  void set_push_policy(const DataTablePushPolicy& push_policy) { push_policy_ = push_policy; }
+
+  /**
+   * Records the delay between the time of each record and the ConsumeRecords() call that pushes
+   * it, in the stirling_record_push_delay_seconds histogram of the table. Only meaningful for
+   * tables whose record times are real event times, on the clock of now_ns.
+   * Calls after the first one have no effect.
+   */
+  void EnablePushDelayMetrics(std::function<uint64_t()> now_ns);
+  const DataTablePushPolicy& push_policy() const { return push_policy_; }
+
+  /**
+   * Selects the string columns that record builders fill in. The other string columns get empty
+   * values, which saves copying columns that no query reads. Columns of other types are always
+   * filled in, they're cheap. An empty list selects all columns.
+   *
+   * @return error::InvalidArgument if a name isn't a column of the table.
+   */
+  Status SetSubscribedColumns(const std::vector<std::string>& column_names);
+
+  /**
+   * Splits the records of a table whose schema isn't tabletized into a tablet per value of the
+   * column as they're consumed, as if its schema was tabletized by the column. Only INT64 and
+   * UINT128 columns can be tabletization keys.
+   *
+   * @return error::InvalidArgument if the table has no such column, or it can't be the key.
+   */
+  Status SetTabletizationKey(std::string_view column_name);
+
+  // The index of the column set by SetTabletizationKey(), if any.
+  std::optional<size_t> tabletization_key() const { return tabletization_key_; }
+
+  // Whether each column is subscribed, by column index.
+  const std::vector<bool>& subscribed_columns() const { return subscribed_columns_; }
+  void set_subscribed_columns(const std::vector<bool>& subscribed_columns) {
+    DCHECK_EQ(subscribed_columns.size(), table_schema_.elements().size());
+    subscribed_columns_ = subscribed_columns;
+  }
+
   // Example usage:
   // DataTable::RecordBuilder<&kTable> r(data_table, time);
   // r.Append<r.ColIndex("field0")>(val0);
@@ -130,14 +180,14 @@ class DataTable : public NotCopyable {
   class RecordBuilder {
    public:
     RecordBuilder(DataTable* data_table, types::TabletIDView tablet_id, uint64_t time = 0)
-        : tablet_(*data_table->GetTablet(tablet_id)) {
+        : data_table_(*data_table), tablet_(*data_table->GetTablet(tablet_id)) {
       static_assert(schema->tabletized());
       tablet_id_ = tablet_id;
       Init(time);
     }
 
     explicit RecordBuilder(DataTable* data_table, uint64_t time = 0)
-        : tablet_(*data_table->GetTablet("")) {
+        : data_table_(*data_table), tablet_(*data_table->GetTablet("")) {
       static_assert(!schema->tabletized());
       Init(time);
     }
@@ -145,27 +195,48 @@ class DataTable : public NotCopyable {
     // For convenience, a wrapper around ColIndex() in the DataTableSchema class.
     constexpr uint32_t ColIndex(std::string_view name) { return schema->ColIndex(name); }
 
+    // Whether the value of the column is kept. Lets callers skip building values, like JSON
+    // strings, that Append() would drop.
+    template <const size_t TIndex>
+    bool Subscribed() const {
+      return data_table_.subscribed_columns_[TIndex];
+    }
+
+    template <const size_t TIndex>
+    using ValueType = typename types::DataTypeTraits<schema->elements()[TIndex].type()>::value_type;
+
+    // Strings are taken by view, since the column copies them into its arena anyway.
+    template <const size_t TIndex>
+    using ArgType = std::conditional_t<std::is_same_v<ValueType<TIndex>, types::StringValue>,
+                                       std::string_view, ValueType<TIndex>>;
+
     // The argument type is inferred by the table schema and the column index.
     // Any string larger than TMaxStringBytes size will be truncated before being placed in the
     // record.
     template <const size_t TIndex, const size_t TMaxStringBytes = 1024>
-    inline void Append(
-        typename types::DataTypeTraits<schema->elements()[TIndex].type()>::value_type val) {
+    inline void Append(ArgType<TIndex> val) {
       if constexpr (TIndex == schema->tabletization_key()) {
         // TODO(oazizi): This will probably break if val is ever StringValue.
         DCHECK(std::to_string(val.val) == tablet_id_);
       }
 
-      if constexpr (std::is_same_v<typename types::DataTypeTraits<
-                                       schema->elements()[TIndex].type()>::value_type,
-                                   types::StringValue>) {
-        if (val.size() > TMaxStringBytes) {
-          val.resize(TMaxStringBytes);
-          val.append(kTruncatedMsg);
+      if constexpr (std::is_same_v<ValueType<TIndex>, types::StringValue>) {
+        DCHECK_EQ(tablet_.records[TIndex]->data_type(), types::DataType::STRING);
+        auto* col = static_cast<types::StringValueColumnWrapper*>(tablet_.records[TIndex].get());
+        if (!data_table_.subscribed_columns_[TIndex]) {
+          col->AppendView("");
+        } else if (val.size() > TMaxStringBytes) {
+          std::string truncated = absl::StrCat(val.substr(0, TMaxStringBytes), kTruncatedMsg);
+          data_table_.num_bytes_ += truncated.size();
+          col->AppendView(truncated);
+        } else {
+          data_table_.num_bytes_ += val.size();
+          col->AppendView(val);
         }
+      } else {
+        data_table_.num_bytes_ += ValueBytes(val);
+        tablet_.records[TIndex]->Append(std::move(val));
       }
-
-      tablet_.records[TIndex]->Append(std::move(val));
       DCHECK(!signature_[TIndex]) << absl::Substitute(
           "Attempt to Append() to column $0 (name=$1) multiple times", TIndex,
           schema->ColName(TIndex));
@@ -192,8 +263,10 @@ class DataTable : public NotCopyable {
     void Init(uint64_t time) {
       DCHECK_EQ(schema->elements().size(), tablet_.records.size());
       tablet_.times.push_back(time);
+      data_table_.RecordStarted();
     }
 
+    DataTable& data_table_;
     Tablet& tablet_;
     std::bitset<schema->elements().size()> signature_;
     types::TabletIDView tablet_id_ = "";
@@ -208,14 +281,18 @@ class DataTable : public NotCopyable {
   class DynamicRecordBuilder {
    public:
     DynamicRecordBuilder(DataTable* data_table, types::TabletIDView tablet_id, uint64_t time = 0)
-        : schema_(data_table->table_schema_), tablet_(*data_table->GetTablet(tablet_id)) {
+        : schema_(data_table->table_schema_),
+          data_table_(*data_table),
+          tablet_(*data_table->GetTablet(tablet_id)) {
       DCHECK(schema_.tabletized());
       tablet_id_ = tablet_id;
       Init(time);
     }
 
     explicit DynamicRecordBuilder(DataTable* data_table, uint64_t time = 0)
-        : schema_(data_table->table_schema_), tablet_(*data_table->GetTablet("")) {
+        : schema_(data_table->table_schema_),
+          data_table_(*data_table),
+          tablet_(*data_table->GetTablet("")) {
       DCHECK(!schema_.tabletized());
       Init(time);
     }
@@ -224,12 +301,15 @@ class DataTable : public NotCopyable {
     template <typename TValueType, const size_t TMaxStringBytes = 1024>
     inline void Append(size_t col_index, TValueType val) {
       if constexpr (std::is_same_v<TValueType, types::StringValue>) {
-        if (val.size() > TMaxStringBytes) {
+        if (!data_table_.subscribed_columns_[col_index]) {
+          val.clear();
+        } else if (val.size() > TMaxStringBytes) {
           val.resize(TMaxStringBytes);
           val.append(kTruncatedMsg);
         }
       }
 
+      data_table_.num_bytes_ += ValueBytes(val);
       tablet_.records[col_index]->Append(std::move(val));
 
       DCHECK(!signature_[col_index])
@@ -248,18 +328,28 @@ class DataTable : public NotCopyable {
     void Init(uint64_t time) {
       DCHECK_EQ(schema_.elements().size(), tablet_.records.size());
       tablet_.times.push_back(time);
+      data_table_.RecordStarted();
       LOG_IF(DFATAL, schema_.elements().size() > kMaxSupportedColumns) << absl::Substitute(
           "Tables with more than $0 columns are not supported.", kMaxSupportedColumns);
     }
 
     static constexpr int kMaxSupportedColumns = 64;
     const DataTableSchema& schema_;
+    DataTable& data_table_;
     std::bitset<kMaxSupportedColumns> signature_ = 0;
     Tablet& tablet_;
     types::TabletIDView tablet_id_ = "";
   };
 
   uint64_t id() const { return id_; }
+  const DataTableSchema& table_schema() const { return table_schema_; }
+
+  /**
+   * Moves all records buffered in `other` into this table, leaving `other` empty.
+   * Both tables must have the same schema. Used to combine records that were built in parallel
+   * into separate tables.
+   */
+  void MergeFrom(DataTable* other);
 
  protected:
   // ColumnWrapper specific members
@@ -274,12 +364,41 @@ class DataTable : public NotCopyable {
   // Get a pointer to the Tablet, for appending. Used by RecordBuilder.
   Tablet* GetTablet(types::TabletIDView tablet_id);
 
+  // Approximate size of a value, for the byte occupancy of the table.
+  template <typename TValueType>
+  static size_t ValueBytes(const TValueType& val) {
+    if constexpr (std::is_same_v<TValueType, types::StringValue>) {
+      return val.size();
+    } else {
+      return sizeof(TValueType);
+    }
+  }
+
+  // Updates the occupancy state when a record builder starts a new record.
+  void RecordStarted() {
+    if (num_records_ == 0) {
+      oldest_record_time_ = px::chrono::coarse_steady_clock::now();
+    }
+    ++num_records_;
+  }
+
   // Table schema: a DataElement to describe each column.
   const DataTableSchema& table_schema_;
 
   // Key is tablet id, value is tablet records.
   absl::flat_hash_map<types::TabletID, Tablet> tablets_;
 
+  DataTablePushPolicy push_policy_;
+
+  std::vector<bool> subscribed_columns_;
+
+  std::optional<size_t> tabletization_key_;
+
+  // Occupancy state across all tablets, maintained incrementally by the record builders.
+  size_t num_records_ = 0;
+  size_t num_bytes_ = 0;
+  px::chrono::coarse_steady_clock::time_point oldest_record_time_ = {};
+
   uint64_t start_time_ = 0;
 
   // The cutoff time is an optional field that sets up to which time
@@ -287,6 +406,9 @@ class DataTable : public NotCopyable {
   // Used particularly by the socket tracer which receives asynchronous
   // events from BPF.
   std::optional<uint64_t> cutoff_time_;
+
+  prometheus::Histogram* push_delay_histogram_ = nullptr;
+  std::function<uint64_t()> push_delay_now_ns_;
 };
 
 }  // namespace stirling
@@ -20,6 +20,8 @@
 #include <random>
 #include <string>
 
+#include "src/common/metrics/metrics.h"
+#include "src/common/testing/testing.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/source_connectors/seq_gen/sequence_generator.h"
 
@@ -314,6 +316,196 @@ TEST_F(DataTableTest, Carryover) {
   }
 }
 
+TEST_F(DataTableTest, OccupancyAndPushPolicy) {
+  std::vector<int> time_vals = {0, 10, 20, 30, 40, 50, 60, 70, 80, 90};
+  std::vector<int> x_vals = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::vector<std::string> s_vals = {"a", "b", "c", "d", "e", "f", "g", "h", "i", "j"};
+
+  EXPECT_EQ(data_table_->Occupancy(), 0);
+  EXPECT_FALSE(data_table_->PushThresholdExceeded());
+
+  for (size_t i = 0; i < time_vals.size(); ++i) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), time_vals[i]);
+    r.Append<r.ColIndex("time_")>(time_vals[i]);
+    r.Append<r.ColIndex("x")>(x_vals[i]);
+    r.Append<r.ColIndex("s")>(s_vals[i]);
+  }
+
+  // Each record holds two 8-byte values, and a 1-byte string.
+  EXPECT_EQ(data_table_->Occupancy(), 10);
+  EXPECT_EQ(data_table_->OccupancyBytes(), 170);
+
+  // The default policy only pushes based on record count.
+  EXPECT_FALSE(data_table_->PushThresholdExceeded());
+
+  DataTablePushPolicy policy;
+  policy.max_records = 5;
+  data_table_->set_push_policy(policy);
+  EXPECT_TRUE(data_table_->PushThresholdExceeded());
+
+  policy.max_records = 0;
+  policy.max_bytes = 100;
+  data_table_->set_push_policy(policy);
+  EXPECT_TRUE(data_table_->PushThresholdExceeded());
+
+  policy.max_bytes = 1000;
+  data_table_->set_push_policy(policy);
+  EXPECT_FALSE(data_table_->PushThresholdExceeded());
+
+  // Records after the cutoff time are carried over, and still count towards occupancy.
+  data_table_->SetConsumeRecordsCutoffTime(40);
+  std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  EXPECT_EQ(tablets[0].records[0]->Size(), 5);
+  EXPECT_EQ(data_table_->Occupancy(), 5);
+  EXPECT_EQ(data_table_->OccupancyBytes(), 85);
+
+  data_table_->SetConsumeRecordsCutoffTime(100);
+  tablets = data_table_->ConsumeRecords();
+  EXPECT_EQ(data_table_->Occupancy(), 0);
+  EXPECT_EQ(data_table_->OccupancyBytes(), 0);
+}
+
+TEST_F(DataTableTest, PushPolicyFromSchema) {
+  static constexpr DataTablePushPolicy kPolicy = {
+      .max_records = 0,
+      .max_bytes = 100,
+      .max_age = std::chrono::milliseconds{0},
+  };
+  static constexpr auto kSchemaWithPolicy =
+      DataTableSchema("test_table", "This is the table description", kElements, kPolicy);
+  DataTable data_table(/*id*/ 0, kSchemaWithPolicy);
+  EXPECT_EQ(data_table.push_policy().max_records, 0);
+  EXPECT_EQ(data_table.push_policy().max_bytes, 100);
+
+  for (int i = 0; i < 10; ++i) {
+    DataTable::RecordBuilder<&kSchemaWithPolicy> r(&data_table, i);
+    r.Append<r.ColIndex("time_")>(i);
+    r.Append<r.ColIndex("x")>(i);
+    r.Append<r.ColIndex("s")>("a");
+  }
+  // 10 records are below the default record limit, but hold more than 100 bytes.
+  EXPECT_TRUE(data_table.PushThresholdExceeded());
+}
+
+TEST_F(DataTableTest, SubscribedColumns) {
+  EXPECT_NOT_OK(data_table_->SetSubscribedColumns({"time_", "no_such_column"}));
+  ASSERT_OK(data_table_->SetSubscribedColumns({"time_"}));
+
+  {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), 1);
+    EXPECT_TRUE(r.Subscribed<r.ColIndex("time_")>());
+    EXPECT_FALSE(r.Subscribed<r.ColIndex("s")>());
+    r.Append<r.ColIndex("time_")>(1);
+    r.Append<r.ColIndex("x")>(7);
+    r.Append<r.ColIndex("s")>("dropped");
+  }
+
+  // Selecting no columns selects all of them again.
+  ASSERT_OK(data_table_->SetSubscribedColumns({}));
+  {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), 2);
+    r.Append<r.ColIndex("time_")>(2);
+    r.Append<r.ColIndex("x")>(8);
+    r.Append<r.ColIndex("s")>("kept");
+  }
+
+  std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  const types::ColumnWrapperRecordBatch& records = tablets[0].records;
+  ASSERT_EQ(records[0]->Size(), 2);
+  // Only string columns are left out.
+  EXPECT_EQ(records[1]->Get<types::Int64Value>(0), 7);
+  EXPECT_EQ(records[2]->Get<types::StringValue>(0), "");
+  EXPECT_EQ(records[2]->Get<types::StringValue>(1), "kept");
+}
+
+TEST_F(DataTableTest, TabletizationKey) {
+  EXPECT_NOT_OK(data_table_->SetTabletizationKey("s"));
+  EXPECT_NOT_OK(data_table_->SetTabletizationKey("no_such_column"));
+  ASSERT_OK(data_table_->SetTabletizationKey("x"));
+  EXPECT_EQ(data_table_->tabletization_key(), 1);
+
+  std::vector<int> x_vals = {5, 7, 5, 7, 9};
+  for (size_t i = 0; i < x_vals.size(); ++i) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), i);
+    r.Append<r.ColIndex("time_")>(i);
+    r.Append<r.ColIndex("x")>(x_vals[i]);
+    r.Append<r.ColIndex("s")>(std::to_string(i));
+  }
+
+  // The records are split into a tablet per key value, in the order of their first record.
+  std::vector<TaggedRecordBatch> tablets = data_table_->ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 3);
+  EXPECT_EQ(tablets[0].tablet_id, "5");
+  EXPECT_EQ(tablets[1].tablet_id, "7");
+  EXPECT_EQ(tablets[2].tablet_id, "9");
+  ASSERT_EQ(tablets[0].records[0]->Size(), 2);
+  EXPECT_EQ(tablets[0].records[2]->Get<types::StringValue>(0), "0");
+  EXPECT_EQ(tablets[0].records[2]->Get<types::StringValue>(1), "2");
+  ASSERT_EQ(tablets[1].records[0]->Size(), 2);
+  EXPECT_EQ(tablets[1].records[2]->Get<types::StringValue>(0), "1");
+  EXPECT_EQ(tablets[1].records[2]->Get<types::StringValue>(1), "3");
+  ASSERT_EQ(tablets[2].records[0]->Size(), 1);
+}
+
+TEST_F(DataTableTest, PushDelayMetrics) {
+  data_table_->EnablePushDelayMetrics([]() -> uint64_t { return 3'000'000'000; });
+  for (uint64_t time : {1'000'000'000, 2'000'000'000}) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), time);
+    r.Append<r.ColIndex("time_")>(time);
+    r.Append<r.ColIndex("x")>(0);
+    r.Append<r.ColIndex("s")>("a");
+  }
+  data_table_->ConsumeRecords();
+
+  const prometheus::ClientMetric* delays = nullptr;
+  std::vector<prometheus::MetricFamily> families = GetMetricsRegistry().Collect();
+  for (const auto& family : families) {
+    if (family.name != "stirling_record_push_delay_seconds") {
+      continue;
+    }
+    for (const auto& metric : family.metric) {
+      if (metric.label.size() == 1 && metric.label[0].value == "test_table") {
+        delays = &metric;
+      }
+    }
+  }
+  ASSERT_NE(delays, nullptr);
+  EXPECT_EQ(delays->histogram.sample_count, 2);
+  EXPECT_DOUBLE_EQ(delays->histogram.sample_sum, 3.0);
+}
+
+TEST_F(DataTableTest, MergeFrom) {
+  DataTable other(/*id*/ 0, kSchema);
+  std::vector<int> time_vals = {30, 0, 20, 10};
+  for (size_t i = 0; i < time_vals.size(); ++i) {
+    // Alternate between the two tables, the way parallel record builders would.
+    DataTable* table = i % 2 == 0 ? &other : data_table_.get();
+    DataTable::RecordBuilder<&kSchema> r(table, time_vals[i]);
+    r.Append<r.ColIndex("time_")>(time_vals[i]);
+    r.Append<r.ColIndex("x")>(time_vals[i] / 10);
+    r.Append<r.ColIndex("s")>(std::string(1, 'a' + time_vals[i] / 10));
+  }
+
+  data_table_->MergeFrom(&other);
+  EXPECT_EQ(other.Occupancy(), 0);
+  EXPECT_EQ(other.OccupancyBytes(), 0);
+  EXPECT_EQ(data_table_->Occupancy(), 4);
+  EXPECT_EQ(data_table_->OccupancyBytes(), 68);
+  EXPECT_TRUE(other.ConsumeRecords().empty());
+
+  std::vector<TaggedRecordBatch> record_batches = data_table_->ConsumeRecords();
+  ASSERT_EQ(record_batches.size(), 1);
+  types::ColumnWrapperRecordBatch& rb = record_batches[0].records;
+  ASSERT_EQ(rb[0]->Size(), 4);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(rb[0]->Get<types::Time64NSValue>(i), 10 * static_cast<int>(i));
+    EXPECT_EQ(rb[1]->Get<types::Int64Value>(i), static_cast<int>(i));
+    EXPECT_EQ(rb[2]->Get<types::StringValue>(i), std::string(1, 'a' + i));
+  }
+}
+
 class DataTableStressTest : public ::testing::Test {
  private:
   std::default_random_engine rng_;
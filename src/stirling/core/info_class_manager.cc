@@ -33,6 +33,10 @@ stirlingpb::InfoClass InfoClassManager::ToProto() const {
   stirlingpb::InfoClass info_class_proto;
 
   info_class_proto.mutable_schema()->CopyFrom(schema_.ToProto());
+  if (data_table_->tabletization_key().has_value()) {
+    info_class_proto.mutable_schema()->set_tabletized(true);
+    info_class_proto.mutable_schema()->set_tabletization_key(*data_table_->tabletization_key());
+  }
   info_class_proto.set_id(id());
 
   return info_class_proto;
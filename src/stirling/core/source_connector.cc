@@ -50,12 +50,14 @@ void SourceConnector::TransferData(ConnectorContext* ctx,
   DCHECK(ctx != nullptr);
   DCHECK_EQ(data_tables.size(), table_schemas().size())
       << "DataTable objects must all be specified.";
+  metrics::ScopedNamedTimer timer(&transfer_data_timer_);
   TransferDataImpl(ctx, data_tables);
   sampling_freq_mgr_.Reset();
 }
 
 void SourceConnector::PushData(DataPushCallback agent_callback,
                                const std::vector<DataTable*>& data_tables) {
+  metrics::ScopedNamedTimer timer(&push_data_timer_);
   for (auto* data_table : data_tables) {
     auto record_batches = data_table->ConsumeRecords();
     for (auto& record_batch : record_batches) {
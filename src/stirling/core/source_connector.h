@@ -18,10 +18,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/named_timer.h"
 #include "src/common/system/system.h"
 #include "src/shared/types/types.h"
 #include "src/stirling/core/connector_context.h"
@@ -105,6 +107,13 @@ class SourceConnector : public NotCopyable {
     return sysconfig_.ConvertToRealTime(monotonic_time);
   }
 
+  /**
+   * Same as above, for count times at once. out may be the same array as monotonic_times.
+   */
+  void ConvertBatchToRealTime(size_t count, const uint64_t* monotonic_times, uint64_t* out) const {
+    sysconfig_.ConvertBatchToRealTime(count, monotonic_times, out);
+  }
+
   // Use this version of the clock, instead of CurrentTimeNS(), when generating a timestamp
   // for comparison against BPF event timestamps. This is to make sure the clocks are generated
   // in the exact same way.
@@ -114,13 +123,31 @@ class SourceConnector : public NotCopyable {
   virtual void EnablePIDTrace(int pid) { pids_to_trace_.insert(pid); }
   virtual void DisablePIDTrace(int pid) { pids_to_trace_.erase(pid); }
 
+  /**
+   * Whether the source is event-driven, and implements WaitForData().
+   */
+  virtual bool SupportsDataWakeup() const { return false; }
+
+  /**
+   * Blocks for up to the timeout waiting for new data (e.g. BPF perf buffer events).
+   * The data is not read here; it reaches the data tables on the next TransferData().
+   * Unlike the other methods, this is called without holding the source lock, so it must be
+   * safe to call concurrently with TransferData().
+   *
+   * @return The number of wake-ups observed (e.g. ready perf buffers); 0 on timeout.
+   */
+  virtual int WaitForData(std::chrono::milliseconds /* timeout */) { return 0; }
+
   const FrequencyManager& sampling_freq_mgr() const { return sampling_freq_mgr_; }
   const FrequencyManager& push_freq_mgr() const { return push_freq_mgr_; }
 
  protected:
   explicit SourceConnector(std::string_view source_name,
                            const ArrayView<DataTableSchema>& table_schemas)
-      : source_name_(source_name), table_schemas_(table_schemas) {}
+      : source_name_(source_name),
+        table_schemas_(table_schemas),
+        transfer_data_timer_("stirling", "transfer_data", {{"source", source_name_}}),
+        push_data_timer_("stirling", "push_data", {{"source", source_name_}}) {}
 
   virtual Status InitImpl() = 0;
 
@@ -158,6 +185,9 @@ class SourceConnector : public NotCopyable {
 
   const std::string source_name_;
   const ArrayView<DataTableSchema> table_schemas_;
+
+  metrics::NamedTimer transfer_data_timer_;
+  metrics::NamedTimer push_data_timer_;
 };
 
 }  // namespace stirling
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/core/startup_report.h"
+
+#include <algorithm>
+
+#include <absl/strings/str_join.h>
+
+namespace px {
+namespace stirling {
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+StartupReport::StartupReport(prometheus::Registry* registry)
+    : start_gauges_(prometheus::BuildGauge()
+                        .Name("stirling_startup_phase_start_seconds")
+                        .Help("When the phase of the startup of Stirling started, in seconds "
+                              "since the startup began")
+                        .Register(*registry)),
+      duration_gauges_(prometheus::BuildGauge()
+                           .Name("stirling_startup_phase_duration_seconds")
+                           .Help("How long the phase of the startup of Stirling took, in seconds")
+                           .Register(*registry)) {}
+
+Status StartupReport::Time(std::string_view phase, const std::function<Status()>& fn) {
+  auto start = std::chrono::steady_clock::now();
+  Status s = fn();
+  Record(phase, start, std::chrono::steady_clock::now(), s);
+  return s;
+}
+
+void StartupReport::Record(std::string_view phase, std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end, Status status) {
+  Phase p{std::string(phase), duration_cast<milliseconds>(start - start_time_),
+          duration_cast<milliseconds>(end - start), std::move(status)};
+  start_gauges_.Add({{"phase", p.name}})
+      .Set(std::chrono::duration<double>(start - start_time_).count());
+  duration_gauges_.Add({{"phase", p.name}}).Set(std::chrono::duration<double>(end - start).count());
+
+  absl::MutexLock lock(&mutex_);
+  phases_.push_back(std::move(p));
+}
+
+std::vector<StartupReport::Phase> StartupReport::phases() const {
+  std::vector<Phase> phases;
+  {
+    absl::MutexLock lock(&mutex_);
+    phases = phases_;
+  }
+  std::stable_sort(phases.begin(), phases.end(),
+                   [](const Phase& a, const Phase& b) { return a.start < b.start; });
+  return phases;
+}
+
+std::string StartupReport::ToString() const {
+  std::vector<Phase> phases = this->phases();
+  milliseconds end{0};
+  for (const Phase& p : phases) {
+    end = std::max(end, p.start + p.duration);
+  }
+  std::vector<std::string> lines;
+  lines.push_back(absl::Substitute("Stirling startup took $0 ms:", end.count()));
+  for (const Phase& p : phases) {
+    lines.push_back(absl::Substitute("  phase=$0 start_ms=$1 duration_ms=$2 status=$3", p.name,
+                                     p.start.count(), p.duration.count(),
+                                     p.status.ok() ? "OK" : p.status.msg()));
+  }
+  return absl::StrJoin(lines, "\n");
+}
+
+void StartupReport::Finish() { LOG(INFO) << ToString(); }
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+#include <prometheus/gauge.h>
+#include <prometheus/registry.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * StartupReport times the phases of the startup of Stirling, some of which run concurrently, so
+ * that the time to first data can be attributed to them.
+ *
+ * Each phase is exported as it ends, as the stirling_startup_phase_start_seconds and
+ * stirling_startup_phase_duration_seconds gauges, labeled by phase. Finish() logs the phases, one
+ * structured line per phase. Thread-safe.
+ */
+class StartupReport : public NotCopyMoveable {
+ public:
+  struct Phase {
+    std::string name;
+    // The start of the phase, since the report was created.
+    std::chrono::milliseconds start;
+    std::chrono::milliseconds duration;
+    Status status;
+  };
+
+  explicit StartupReport(prometheus::Registry* registry);
+
+  /**
+   * Runs the phase, and records its time and result.
+   */
+  Status Time(std::string_view phase, const std::function<Status()>& fn);
+
+  void Record(std::string_view phase, std::chrono::steady_clock::time_point start,
+              std::chrono::steady_clock::time_point end, Status status);
+
+  /**
+   * The recorded phases, in the order they started.
+   */
+  std::vector<Phase> phases() const;
+
+  std::string ToString() const;
+
+  /**
+   * Logs the report, once the startup is done.
+   */
+  void Finish();
+
+ private:
+  const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+  prometheus::Family<prometheus::Gauge>& start_gauges_;
+  prometheus::Family<prometheus::Gauge>& duration_gauges_;
+
+  mutable absl::Mutex mutex_;
+  std::vector<Phase> phases_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace stirling
+}  // namespace px
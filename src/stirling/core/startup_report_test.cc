@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/core/startup_report.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::HasSubstr;
+
+TEST(StartupReportTest, RecordsPhasesInStartOrder) {
+  prometheus::Registry registry;
+  StartupReport report(&registry);
+
+  std::thread thread([&] {
+    EXPECT_OK(report.Time("clean_probes", [] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      return Status::OK();
+    }));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_NOT_OK(report.Time("linux_headers", [] { return error::Internal("no headers"); }));
+  thread.join();
+
+  std::vector<StartupReport::Phase> phases = report.phases();
+  EXPECT_THAT(phases, ElementsAre(Field(&StartupReport::Phase::name, "clean_probes"),
+                                  Field(&StartupReport::Phase::name, "linux_headers")));
+  EXPECT_GE(phases[0].duration, std::chrono::milliseconds(20));
+  EXPECT_OK(phases[0].status);
+  EXPECT_NOT_OK(phases[1].status);
+
+  std::string str = report.ToString();
+  EXPECT_THAT(str, HasSubstr("phase=clean_probes start_ms=0"));
+  EXPECT_THAT(str, HasSubstr("phase=linux_headers"));
+  EXPECT_THAT(str, HasSubstr("status=no headers"));
+}
+
+TEST(StartupReportTest, ExportsPhases) {
+  prometheus::Registry registry;
+  StartupReport report(&registry);
+  auto start = std::chrono::steady_clock::now();
+  report.Record("init_source/socket_tracer", start, start + std::chrono::milliseconds(1500),
+                Status::OK());
+
+  const prometheus::ClientMetric* duration = nullptr;
+  std::vector<prometheus::MetricFamily> families = registry.Collect();
+  for (const auto& family : families) {
+    if (family.name != "stirling_startup_phase_duration_seconds") {
+      continue;
+    }
+    for (const auto& metric : family.metric) {
+      if (metric.label.size() == 1 && metric.label[0].value == "init_source/socket_tracer") {
+        duration = &metric;
+      }
+    }
+  }
+  ASSERT_NE(duration, nullptr);
+  EXPECT_DOUBLE_EQ(duration->gauge.value, 1.5);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -316,6 +316,31 @@ TEST_F(StirlingTest, hammer_time_on_stirling_on_the_fly_subs) {
   EXPECT_GT(NumProcessed(), 0);
 }
 
+// Same as above, but each source is sampled and pushed on its own thread.
+TEST_F(StirlingTest, hammer_time_on_stirling_source_threads) {
+  FLAGS_stirling_source_threads = true;
+
+  ASSERT_OK(stirling_->RunAsThread());
+  ASSERT_OK(stirling_->WaitUntilRunning(std::chrono::seconds(5)));
+
+  uint32_t i = 0;
+  while (NumProcessed() < kNumProcessedRequirement || i < kNumIterMin) {
+    std::this_thread::sleep_for(kDurationPerIter);
+
+    i++;
+
+    // In case we have a slow environment, break out of the test after some time.
+    if (i > kNumIterMax) {
+      break;
+    }
+  }
+
+  stirling_->Stop();
+  FLAGS_stirling_source_threads = false;
+
+  EXPECT_GT(NumProcessed(), 0);
+}
+
 TEST_F(StirlingTest, no_data_callback_defined) {
   stirling_->RegisterDataPushCallback(nullptr);
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <limits>
 #include <map>
 #include <memory>
@@ -92,25 +93,47 @@ class DataElement {
   const std::map<int64_t, std::string_view>* decoder_ = nullptr;
 };
 
+/**
+ * Thresholds at which the data buffered in a DataTable should be pushed out,
+ * ahead of the push period of its source connector. A value of zero disables a threshold.
+ */
+struct DataTablePushPolicy {
+  // Push once this many records are buffered.
+  size_t max_records = 1024;
+
+  // Push once the buffered records hold approximately this many bytes.
+  size_t max_bytes = 0;
+
+  // Push once the oldest buffered record has been waiting this long.
+  std::chrono::milliseconds max_age{0};
+};
+
 class DataTableSchema {
  public:
   // TODO(oazizi): This constructor should only be called at compile-time. Need to enforce this.
   template <std::size_t N>
   constexpr DataTableSchema(std::string_view name, std::string_view desc,
-                            const DataElement (&elements)[N])
-      : name_(name), desc_(desc), elements_(elements), tabletized_(false) {
+                            const DataElement (&elements)[N],
+                            const DataTablePushPolicy& push_policy = {})
+      : name_(name),
+        desc_(desc),
+        elements_(elements),
+        tabletized_(false),
+        push_policy_(push_policy) {
     CheckSchema();
   }
 
   template <std::size_t N>
   constexpr DataTableSchema(std::string_view name, std::string_view desc,
                             const DataElement (&elements)[N],
-                            std::string_view tabletization_key_name)
+                            std::string_view tabletization_key_name,
+                            const DataTablePushPolicy& push_policy = {})
       : name_(name),
         desc_(desc),
         elements_(elements),
         tabletized_(true),
-        tabletization_key_(ColIndex(tabletization_key_name)) {
+        tabletization_key_(ColIndex(tabletization_key_name)),
+        push_policy_(push_policy) {
     CheckSchema();
   }
 
@@ -125,6 +148,8 @@ class DataTableSchema {
   constexpr bool tabletized() const { return tabletized_; }
   constexpr size_t tabletization_key() const { return tabletization_key_; }
   constexpr ArrayView<DataElement> elements() const { return elements_; }
+  // The push policy that DataTables of this schema start with.
+  constexpr const DataTablePushPolicy& push_policy() const { return push_policy_; }
 
   // Warning: use at compile-time only!
   // TODO(oazizi): Convert to consteval when C++20 is supported, to ensure compile-time use only.
@@ -174,6 +199,7 @@ class DataTableSchema {
   const ArrayView<DataElement> elements_;
   const bool tabletized_ = false;
   size_t tabletization_key_ = std::numeric_limits<size_t>::max();
+  const DataTablePushPolicy push_policy_ = {};
 
   static constexpr std::chrono::milliseconds kDefaultPushPeriod{1000};
 };
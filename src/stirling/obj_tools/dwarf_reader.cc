@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include <llvm/DebugInfo/DIContext.h>
+#include <llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h>
 #include <llvm/Object/ObjectFile.h>
 
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
@@ -55,36 +56,44 @@ std::vector<DWARFDie> GetParamDIEs(const DWARFDie& function_die) {
 // https://superuser.com/questions/791506/how-to-determine-if-a-linux-binary-file-is-32-bit-or-64-bit
 uint8_t kAddressSize = sizeof(void*);
 
+namespace {
+
+StatusOr<std::unique_ptr<DWARFContext>> CreateDWARFContext(const llvm::MemoryBuffer& buffer) {
+  llvm::Expected<std::unique_ptr<llvm::object::Binary>> bin_or_err =
+      llvm::object::createBinary(buffer);
+  std::error_code ec = errorToErrorCode(bin_or_err.takeError());
+  if (ec) {
+    return error::Internal("DwarfReader $0: $1", ec.message(),
+                           buffer.getBufferIdentifier().str());
+  }
+
+  auto* obj_file = llvm::dyn_cast<llvm::object::ObjectFile>(bin_or_err->get());
+  if (!obj_file) {
+    return error::Internal("Could not create DWARFContext.");
+  }
+  return DWARFContext::create(*obj_file);
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateWithoutIndexing(
     const std::filesystem::path& path) {
   using llvm::MemoryBuffer;
 
-  std::error_code ec;
-
   std::string obj_filename = path.string();
 
   llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> buff_or_err =
       MemoryBuffer::getFileOrSTDIN(obj_filename);
-  ec = buff_or_err.getError();
+  std::error_code ec = buff_or_err.getError();
   if (ec) {
     return error::Internal("DwarfReader $0: $1", ec.message(), obj_filename);
   }
 
   std::unique_ptr<MemoryBuffer> buffer = std::move(buff_or_err.get());
-  llvm::Expected<std::unique_ptr<llvm::object::Binary>> bin_or_err =
-      llvm::object::createBinary(*buffer);
-  ec = errorToErrorCode(bin_or_err.takeError());
-  if (ec) {
-    return error::Internal("DwarfReader $0: $1", ec.message(), obj_filename);
-  }
-
-  auto* obj_file = llvm::dyn_cast<llvm::object::ObjectFile>(bin_or_err->get());
-  if (!obj_file) {
-    return error::Internal("Could not create DWARFContext.");
-  }
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<DWARFContext> dwarf_context, CreateDWARFContext(*buffer));
 
   auto dwarf_reader = std::unique_ptr<DwarfReader>(
-      new DwarfReader(std::move(buffer), DWARFContext::create(*obj_file)));
+      new DwarfReader(std::move(buffer), std::move(dwarf_context)));
 
   PL_RETURN_IF_ERROR(dwarf_reader->DetectSourceLanguage());
 
@@ -94,14 +103,14 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateWithoutIndexing(
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateIndexingAll(
     const std::filesystem::path& path) {
   PL_ASSIGN_OR_RETURN(auto dwarf_reader, CreateWithoutIndexing(path));
-  dwarf_reader->IndexDIEs(std::nullopt);
+  PL_RETURN_IF_ERROR(dwarf_reader->IndexDIEs(std::nullopt));
   return dwarf_reader;
 }
 
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::CreateWithSelectiveIndexing(
     const std::filesystem::path& path, const std::vector<SymbolSearchPattern>& symbol_patterns) {
   PL_ASSIGN_OR_RETURN(auto dwarf_reader, CreateWithoutIndexing(path));
-  dwarf_reader->IndexDIEs(symbol_patterns);
+  PL_RETURN_IF_ERROR(dwarf_reader->IndexDIEs(symbol_patterns));
   return dwarf_reader;
 }
 
@@ -146,6 +155,23 @@ bool IsIndexedType(llvm::dwarf::Tag tag) {
 
 bool IsNamespace(llvm::dwarf::Tag tag) { return tag == llvm::dwarf::DW_TAG_namespace; }
 
+// Returns the name of the DIE, qualified by the names of its enclosing namespaces and types,
+// in the same way that IndexDIEs() names DIEs.
+std::string QualifiedName(const DWARFDie& die) {
+  std::string name(GetShortName(die));
+  for (DWARFDie parent = die.getParent(); parent.isValid(); parent = parent.getParent()) {
+    if (!IsIndexedType(parent.getTag()) && !IsNamespace(parent.getTag())) {
+      break;
+    }
+    std::string_view parent_name = GetShortName(parent);
+    if (parent_name.empty()) {
+      break;
+    }
+    name = absl::StrCat(parent_name, "::", name);
+  }
+  return name;
+}
+
 }  // namespace
 
 Status DwarfReader::DetectSourceLanguage() {
@@ -172,15 +198,29 @@ Status DwarfReader::DetectSourceLanguage() {
       "any compilation unit.");
 }
 
-void DwarfReader::IndexDIEs(
+Status DwarfReader::IndexDIEs(
     const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt) {
+  // The .debug_names accelerator table is already an index from names to DIEs,
+  // so there is nothing to build. Lookups go through it directly.
+  const llvm::DWARFDebugNames& debug_names = dwarf_context_->getDebugNames();
+  if (debug_names.begin() != debug_names.end()) {
+    use_debug_names_ = true;
+    return Status::OK();
+  }
+
+  // Walking the units extracts all of their DIEs, which stay in memory for as long as the
+  // DWARFContext does. So walk them on a separate DWARFContext that is discarded afterwards,
+  // and record only DIE offsets. dwarf_context_ then extracts the units on demand, on lookup.
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<DWARFContext> index_context,
+                      CreateDWARFContext(*memory_buffer_));
+
   absl::flat_hash_map<const llvm::DWARFDebugInfoEntry*, std::string> dwarf_entry_names;
 
-  // Map from DW_AT_specification to DIE. Only DW_TAG_subprogram can have this attribute.
+  // Map from DW_AT_specification to DIE offset. Only DW_TAG_subprogram can have this attribute.
   // Also only applies to CPP binaries.
-  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+  absl::flat_hash_map<uint64_t, uint64_t> fn_spec_offsets;
 
-  DWARFContext::unit_iterator_range units = dwarf_context_->normal_units();
+  DWARFContext::unit_iterator_range units = index_context->normal_units();
   for (const std::unique_ptr<llvm::DWARFUnit>& unit : units) {
     for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
       DWARFDie die = {unit.get(), &entry};
@@ -190,7 +230,7 @@ void DwarfReader::IndexDIEs(
             AdaptLLVMOptional(llvm::dwarf::toReference(die.find(llvm::dwarf::DW_AT_specification)),
                               "Could not find attribute DW_AT_specification");
         if (spec_or.ok()) {
-          fn_spec_offsets[spec_or.ValueOrDie()] = die;
+          fn_spec_offsets[spec_or.ValueOrDie()] = die.getOffset();
         }
       }
 
@@ -231,7 +271,7 @@ void DwarfReader::IndexDIEs(
         }
 
         if (IsIndexedType(tag)) {
-          InsertToDIEMap(std::move(name), tag, die);
+          InsertToDIEMap(std::move(name), tag, die.getOffset());
         }
       }
     }
@@ -240,14 +280,15 @@ void DwarfReader::IndexDIEs(
   auto& fn_dies = die_map_[llvm::dwarf::DW_TAG_subprogram];
 
   for (auto iter = fn_dies.begin(); iter != fn_dies.end(); ++iter) {
-    uint64_t offset = iter->second.getOffset();
-    auto spec_iter = fn_spec_offsets.find(offset);
+    auto spec_iter = fn_spec_offsets.find(iter->second);
     if (spec_iter == fn_spec_offsets.end()) {
       continue;
     }
     // Replace the DIE with the DW_TAG_subprogram die that has DW_AT_specification attribute.
     iter->second = spec_iter->second;
   }
+
+  return Status::OK();
 }
 
 StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(
@@ -255,8 +296,10 @@ StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(
   DCHECK(dwarf_context_ != nullptr);
 
   // Special case for types that are indexed.
-  if (type_opt.has_value() && IsIndexedType(type_opt.value()) && !die_map_.empty()) {
-    auto die_opt = FindInDIEMap(std::string(name), type_opt.value());
+  if (type_opt.has_value() && IsIndexedType(type_opt.value()) &&
+      (use_debug_names_ || !die_map_.empty())) {
+    auto die_opt = use_debug_names_ ? FindInDebugNames(name, type_opt.value())
+                                    : FindInDIEMap(std::string(name), type_opt.value());
     if (die_opt.has_value()) {
       return std::vector<DWARFDie>{die_opt.value()};
     }
@@ -717,7 +760,7 @@ Status DwarfReader::FlattenedStructSpec(const llvm::DWARFDie& struct_die,
   return Status::OK();
 }
 
-void DwarfReader::InsertToDIEMap(std::string name, llvm::dwarf::Tag tag, llvm::DWARFDie die) {
+void DwarfReader::InsertToDIEMap(std::string name, llvm::dwarf::Tag tag, uint64_t die_offset) {
   auto& die_type_map = die_map_[tag];
   // TODO(oazizi): What's the right way to deal with duplicate names?
   // Only appears to happen with structs like the following:
@@ -726,7 +769,7 @@ void DwarfReader::InsertToDIEMap(std::string name, llvm::dwarf::Tag tag, llvm::D
   if (die_type_map.find(name) != die_type_map.end()) {
     return;
   }
-  die_type_map[name] = die;
+  die_type_map[name] = die_offset;
 }
 
 std::optional<llvm::DWARFDie> DwarfReader::FindInDIEMap(const std::string& name,
@@ -740,7 +783,56 @@ std::optional<llvm::DWARFDie> DwarfReader::FindInDIEMap(const std::string& name,
   if (die_iter == die_type_map.end()) {
     return std::nullopt;
   }
-  return die_iter->second;
+  // Extracts the DIEs of the enclosing unit, if this is the first lookup into it.
+  DWARFDie die = dwarf_context_->getDIEForOffset(die_iter->second);
+  if (!die.isValid()) {
+    return std::nullopt;
+  }
+  return die;
+}
+
+std::optional<llvm::DWARFDie> DwarfReader::FindInDebugNames(std::string_view name,
+                                                           llvm::dwarf::Tag tag) const {
+  // The accelerator table holds unqualified names.
+  std::string_view short_name = name;
+  size_t pos = name.rfind("::");
+  if (pos != std::string_view::npos) {
+    short_name.remove_prefix(pos + 2);
+  }
+
+  std::optional<DWARFDie> result;
+  for (const llvm::DWARFDebugNames::Entry& entry : dwarf_context_->getDebugNames().equal_range(
+           llvm::StringRef(short_name.data(), short_name.size()))) {
+    if (entry.tag() != tag) {
+      continue;
+    }
+    llvm::Optional<uint64_t> cu_offset = entry.getCUOffset();
+    llvm::Optional<uint64_t> die_unit_offset = entry.getDIEUnitOffset();
+    if (!cu_offset.hasValue() || !die_unit_offset.hasValue()) {
+      continue;
+    }
+
+    DWARFDie die = dwarf_context_->getDIEForOffset(cu_offset.getValue() +
+                                                   die_unit_offset.getValue());
+    if (!die.isValid()) {
+      continue;
+    }
+
+    // Out-of-line definitions are named through their declaration.
+    DWARFDie spec_die = die.getAttributeValueAsReferencedDie(llvm::dwarf::DW_AT_specification);
+    if (QualifiedName(spec_die.isValid() ? spec_die : die) != name) {
+      continue;
+    }
+
+    // Like IndexDIEs(), keep the first match, but prefer a definition over a declaration.
+    if (!result.has_value() || spec_die.isValid()) {
+      result = die;
+      if (spec_die.isValid()) {
+        break;
+      }
+    }
+  }
+  return result;
 }
 
 StatusOr<TypeInfo> DwarfReader::DereferencePointerType(std::string type_name) {
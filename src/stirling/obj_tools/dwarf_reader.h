@@ -304,9 +304,13 @@ class DwarfReader {
   // Builds an index for certain commonly used DIE types (e.g. structs and functions).
   // When making multiple DwarfReader calls, this speeds up the process at the cost of some memory.
   //
+  // If the binary has a .debug_names section, that is used as the index. Otherwise, the index maps
+  // names to DIE offsets, and the units are only extracted once a lookup lands in them.
+  //
   // If the search patterns are not provided, all DIEs of the matching tags are indexed.
   // Otherwise, only the ones whose names match are indexed.
-  void IndexDIEs(const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt);
+  Status IndexDIEs(
+      const std::optional<std::vector<SymbolSearchPattern>>& symbol_search_patterns_opt);
 
   // Walks the struct_die for all members, recursively visiting any members which are also structs,
   // to capture information of all base type members of the struct in a flattened form.
@@ -314,8 +318,9 @@ class DwarfReader {
   Status FlattenedStructSpec(const llvm::DWARFDie& struct_die, std::vector<StructSpecEntry>* output,
                              const std::string& path_prefix, int offset);
 
-  void InsertToDIEMap(std::string name, llvm::dwarf::Tag tag, llvm::DWARFDie die);
+  void InsertToDIEMap(std::string name, llvm::dwarf::Tag tag, uint64_t die_offset);
   std::optional<llvm::DWARFDie> FindInDIEMap(const std::string& name, llvm::dwarf::Tag tag) const;
+  std::optional<llvm::DWARFDie> FindInDebugNames(std::string_view name, llvm::dwarf::Tag tag) const;
 
   // Records the source language of the DWARF information.
   llvm::dwarf::SourceLanguage source_language_;
@@ -324,8 +329,11 @@ class DwarfReader {
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer_;
   std::unique_ptr<llvm::DWARFContext> dwarf_context_;
 
-  // Nested map: [tag][symbol_name] -> DWARFDie
-  absl::flat_hash_map<llvm::dwarf::Tag, absl::flat_hash_map<std::string, llvm::DWARFDie>> die_map_;
+  // Nested map: [tag][symbol_name] -> DIE offset in .debug_info
+  absl::flat_hash_map<llvm::dwarf::Tag, absl::flat_hash_map<std::string, uint64_t>> die_map_;
+
+  // Whether lookups go through the .debug_names accelerator table, instead of die_map_.
+  bool use_debug_names_ = false;
 };
 
 }  // namespace obj_tools
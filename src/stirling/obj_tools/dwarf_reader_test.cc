@@ -28,6 +28,8 @@ constexpr std::string_view kTestGo1_17Binary =
 constexpr std::string_view kGoGRPCServer =
     "src/stirling/testing/demo_apps/go_grpc_tls_pl/server/server_/server";
 constexpr std::string_view kCppBinary = "src/stirling/obj_tools/testdata/cc/test_exe";
+constexpr std::string_view kCppDebugNamesBinary =
+    "src/stirling/obj_tools/testdata/cc/test_exe_debug_names";
 constexpr std::string_view kGoBinaryUnconventional =
     "src/stirling/obj_tools/testdata/go/sockshop_payments_service";
 
@@ -61,12 +63,14 @@ class DwarfReaderTest : public ::testing::TestWithParam<DwarfReaderTestParam> {
  protected:
   DwarfReaderTest()
       : kCppBinaryPath(px::testing::BazelBinTestFilePath(kCppBinary)),
+        kCppDebugNamesBinaryPath(px::testing::BazelBinTestFilePath(kCppDebugNamesBinary)),
         kGo1_16BinaryPath(px::testing::TestFilePath(kTestGo1_16Binary)),
         kGo1_17BinaryPath(px::testing::TestFilePath(kTestGo1_17Binary)),
         kGoServerBinaryPath(px::testing::BazelBinTestFilePath(kGoGRPCServer)),
         kGoBinaryUnconventionalPath(px::testing::TestFilePath(kGoBinaryUnconventional)) {}
 
   const std::string kCppBinaryPath;
+  const std::string kCppDebugNamesBinaryPath;
   const std::string kGo1_16BinaryPath;
   const std::string kGo1_17BinaryPath;
   const std::string kGoServerBinaryPath;
@@ -447,6 +451,21 @@ TEST_P(DwarfReaderTest, CppFunctionRetValInfo) {
                    (RetValInfo{TypeInfo{VarType::kVoid, ""}, 0}));
 }
 
+// Lookups through the .debug_names accelerator table find the same DIEs as the other indexes.
+TEST_P(DwarfReaderTest, CppDebugNames) {
+  DwarfReaderTestParam p = GetParam();
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
+                       CreateDwarfReader(kCppDebugNamesBinaryPath, p.index));
+
+  EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct32"), 12);
+  EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "b"), 4);
+  EXPECT_OK_AND_EQ(dwarf_reader->GetFunctionRetValInfo("ABCSum32"),
+                   (RetValInfo{TypeInfo{VarType::kStruct, "ABCStruct32"}, 12}));
+  EXPECT_OK_AND_THAT(
+      dwarf_reader->GetMatchingDIEs("non-existent-name", llvm::dwarf::DW_TAG_structure_type),
+      IsEmpty());
+}
+
 TEST_P(DwarfReaderTest, Go1_16FunctionArgInfo) {
   DwarfReaderTestParam p = GetParam();
 
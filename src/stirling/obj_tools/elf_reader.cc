@@ -24,12 +24,14 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_set.h>
+#include <algorithm>
 #include <set>
 #include <utility>
 
 #include "src/common/base/byte_utils.h"
 #include "src/common/base/utils.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/stirling/obj_tools/go_syms.h"
 #include "src/stirling/obj_tools/init.h"
 
 namespace px {
@@ -44,10 +46,29 @@ struct LowercaseHex {
   static inline constexpr int kSizePerByte = 2;
   static inline constexpr bool kKeepPrintableChars = false;
 };
+
+// Returns the "desc" field of a note section.
+std::string_view NoteDesc(ELFIO::section* psec) {
+  // Structure of this section:
+  //    namesz :   32-bit, size of "name" field
+  //    descsz :   32-bit, size of "desc" field
+  //    type   :   32-bit, vendor specific "type"
+  //    name   :   "namesz" bytes, null-terminated string
+  //    desc   :   "descsz" bytes, binary data
+  int32_t name_size =
+      utils::LEndianBytesToInt<int32_t>(std::string_view(psec->get_data(), sizeof(int32_t)));
+  int32_t desc_size = utils::LEndianBytesToInt<int32_t>(
+      std::string_view(psec->get_data() + sizeof(int32_t), sizeof(int32_t)));
+
+  int32_t desc_pos = 3 * sizeof(int32_t) + name_size;
+  return std::string_view(psec->get_data() + desc_pos, desc_size);
+}
+
 }  // namespace
 
 Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir) {
   std::string build_id;
+  std::string go_build_id;
   std::string debug_link;
   bool found_symtab = false;
 
@@ -66,24 +87,16 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
 
     // Method 1: build-id.
     if (psec->get_name() == ".note.gnu.build-id") {
-      // Structure of this section:
-      //    namesz :   32-bit, size of "name" field
-      //    descsz :   32-bit, size of "desc" field
-      //    type   :   32-bit, vendor specific "type"
-      //    name   :   "namesz" bytes, null-terminated string
-      //    desc   :   "descsz" bytes, binary data
-      int32_t name_size =
-          utils::LEndianBytesToInt<int32_t>(std::string_view(psec->get_data(), sizeof(int32_t)));
-      int32_t desc_size = utils::LEndianBytesToInt<int32_t>(
-          std::string_view(psec->get_data() + sizeof(int32_t), sizeof(int32_t)));
-
-      int32_t desc_pos = 3 * sizeof(int32_t) + name_size;
-      std::string_view desc = std::string_view(psec->get_data() + desc_pos, desc_size);
-
-      build_id = BytesToString<LowercaseHex>(desc);
+      build_id = BytesToString<LowercaseHex>(NoteDesc(psec));
       VLOG(1) << absl::Substitute("Found build-id: $0", build_id);
     }
 
+    // Go binaries that are linked by the Go linker only have a Go build ID, which is text.
+    if (psec->get_name() == ".note.go.buildid") {
+      go_build_id = std::string(NoteDesc(psec));
+      VLOG(1) << absl::Substitute("Found Go build ID: $0", go_build_id);
+    }
+
     // Method 2: .gnu_debuglink.
     if (psec->get_name() == ".gnu_debuglink") {
       constexpr int kCRCBytes = 4;
@@ -92,6 +105,8 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
     }
   }
 
+  build_id_ = !build_id.empty() ? build_id : go_build_id;
+
   // In priority order, we try:
   //  1) Accessing included symtab section.
   //  2) Finding debug symbols via build-id.
@@ -317,38 +332,67 @@ StatusOr<std::optional<std::string>> ElfReader::AddrToSymbol(size_t sym_addr) {
   return std::optional<std::string>(std::move(name));
 }
 
-// TODO(oazizi): Optimize by indexing or switching to binary search if we can guarantee addresses
-//               are ordered.
 StatusOr<std::optional<std::string>> ElfReader::InstrAddrToSymbol(size_t sym_addr) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
-
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
-    // Call ELFIO to get symbol by index.
-    // ELFIO looks up the index and then populates name, addr, size, type, etc.
-    // We only care about the name and addr, but need to declare the other variables as well.
-    std::string name;
-    ELFIO::Elf64_Addr addr = 0;
-    ELFIO::Elf_Xword size = 0;
-    unsigned char bind = 0;
-    unsigned char type = ELFIO::STT_NOTYPE;
-    ELFIO::Elf_Half section_index;
-    unsigned char other;
-    symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
-
-    if (sym_addr >= addr && sym_addr < addr + size) {
-      return std::optional<std::string>(llvm::demangle(name));
+  if (instr_addr_index_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+
+    auto index = std::make_unique<Symbolizer>();
+    const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
+    for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
+      // Call ELFIO to get symbol by index.
+      // ELFIO looks up the index and then populates name, addr, size, type, etc.
+      // We only care about the name and addr, but need to declare the other variables as well.
+      std::string name;
+      ELFIO::Elf64_Addr addr = 0;
+      ELFIO::Elf_Xword size = 0;
+      unsigned char bind = 0;
+      unsigned char type = ELFIO::STT_NOTYPE;
+      ELFIO::Elf_Half section_index;
+      unsigned char other;
+      symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
+
+      // Symbols without a size never cover any address.
+      if (size > 0) {
+        index->AddEntry(addr, size, llvm::demangle(name));
+      }
     }
+    index->Build();
+    instr_addr_index_ = std::move(index);
   }
 
-  return std::optional<std::string>();
+  const Symbolizer::SymbolAddrInfo* entry = instr_addr_index_->Find(sym_addr);
+  if (entry == nullptr) {
+    return std::optional<std::string>();
+  }
+  return std::optional<std::string>(entry->name);
 }
 
 StatusOr<std::unique_ptr<ElfReader::Symbolizer>> ElfReader::GetSymbolizer() {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
-
   auto symbolizer = std::make_unique<ElfReader::Symbolizer>();
 
+  StatusOr<std::vector<GoFuncRange>> go_funcs = ReadGoFuncTable(this);
+  if (go_funcs.ok()) {
+    for (GoFuncRange& func : go_funcs.ValueOrDie()) {
+      symbolizer->AddEntry(func.address, func.size, std::move(func.name));
+    }
+    symbolizer->Build();
+  }
+
+  StatusOr<ELFIO::section*> symtab_section_status = SymtabSection();
+  if (!symtab_section_status.ok()) {
+    if (symbolizer->size() > 0) {
+      // A stripped Go executable.
+      return symbolizer;
+    }
+    return symtab_section_status.status();
+  }
+  ELFIO::section* symtab_section = symtab_section_status.ConsumeValueOrDie();
+
+  // The symbols of the function table that are also in the symbol table are skipped, but there
+  // may be others, like the C functions of cgo.
+  const size_t num_go_funcs = symbolizer->size();
+  std::vector<Symbolizer::SymbolAddrInfo> funcs;
+
   const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
   for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
     // Call ELFIO to get symbol by index.
@@ -363,34 +407,57 @@ StatusOr<std::unique_ptr<ElfReader::Symbolizer>> ElfReader::GetSymbolizer() {
     unsigned char other;
     symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
 
-    if (type == ELFIO::STT_FUNC) {
-      symbolizer->AddEntry(addr, size, llvm::demangle(name));
+    if (type == ELFIO::STT_FUNC && (num_go_funcs == 0 || symbolizer->Find(addr) == nullptr)) {
+      funcs.push_back(Symbolizer::SymbolAddrInfo{addr, size, llvm::demangle(name)});
     }
   }
+  for (Symbolizer::SymbolAddrInfo& func : funcs) {
+    symbolizer->AddEntry(func.addr, func.size, std::move(func.name));
+  }
+  symbolizer->Build();
 
   return symbolizer;
 }
 
 void ElfReader::Symbolizer::AddEntry(size_t addr, size_t size, std::string name) {
-  symbols_.emplace(addr, SymbolAddrInfo{size, std::move(name)});
+  symbols_.push_back(SymbolAddrInfo{addr, size, std::move(name)});
 }
 
-std::string_view ElfReader::Symbolizer::Lookup(size_t addr) const {
-  static std::string symbol_str;
+void ElfReader::Symbolizer::Build() {
+  std::stable_sort(
+      symbols_.begin(), symbols_.end(),
+      [](const SymbolAddrInfo& a, const SymbolAddrInfo& b) { return a.addr < b.addr; });
+  auto last = std::unique(
+      symbols_.begin(), symbols_.end(),
+      [](const SymbolAddrInfo& a, const SymbolAddrInfo& b) { return a.addr == b.addr; });
+  symbols_.erase(last, symbols_.end());
+  symbols_.shrink_to_fit();
+}
 
+const ElfReader::Symbolizer::SymbolAddrInfo* ElfReader::Symbolizer::Find(size_t addr) const {
   // Find the first symbol for which the address_range_start > addr.
-  auto iter = symbols_.upper_bound(addr);
+  auto iter = std::upper_bound(symbols_.begin(), symbols_.end(), addr,
+                               [](size_t a, const SymbolAddrInfo& s) { return a < s.addr; });
 
-  if (iter == symbols_.begin() || symbols_.empty()) {
-    symbol_str = absl::StrFormat("0x%016llx", addr);
-    return symbol_str;
+  if (iter == symbols_.begin()) {
+    return nullptr;
   }
 
   // std::upper_bound will make us overshoot our potential match,
   // so go back by one, and check if it is indeed a match.
   --iter;
-  if (addr >= iter->first && addr < iter->first + iter->second.size) {
-    return iter->second.name;
+  if (addr >= iter->addr && addr < iter->addr + iter->size) {
+    return &*iter;
+  }
+  return nullptr;
+}
+
+std::string_view ElfReader::Symbolizer::Lookup(size_t addr) const {
+  static std::string symbol_str;
+
+  const SymbolAddrInfo* entry = Find(addr);
+  if (entry != nullptr) {
+    return entry->name;
   }
 
   // Couldn't find the address.
@@ -449,7 +516,8 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
 
   // TODO(yzhao): This is a short-term quick way to avoid unnecessary overheads.
   // We should create LLVMDisasmContext object inside SocketTraceConnector and pass it around.
-  static const LLVMDisasmContext kLLVMDisasmContext;
+  // One context per thread, since binaries are analyzed concurrently for uprobe deployment.
+  static thread_local const LLVMDisasmContext kLLVMDisasmContext;
 
   // Size of the buffer to hold disassembled assembly code. Since we do not really use the assembly
   // code, we just provide a small buffer.
@@ -493,6 +561,22 @@ StatusOr<std::vector<uint64_t>> ElfReader::FuncRetInstAddrs(const SymbolInfo& fu
   return addrs;
 }
 
+StatusOr<ElfReader::SectionData> ElfReader::GetSectionData(std::string_view section) {
+  for (int i = 0; i < elf_reader_.sections.size(); ++i) {
+    ELFIO::section* psec = elf_reader_.sections[i];
+    if (psec->get_name() != section) {
+      continue;
+    }
+    SectionData section_data;
+    section_data.address = psec->get_address();
+    if (psec->get_type() != ELFIO::SHT_NOBITS && psec->get_data() != nullptr) {
+      section_data.data = std::string_view(psec->get_data(), psec->get_size());
+    }
+    return section_data;
+  }
+  return error::NotFound("Could not find section=$0 in binary=$1", section, binary_path_);
+}
+
 StatusOr<utils::u8string> ElfReader::SymbolByteCode(std::string_view section,
                                                     const SymbolInfo& symbol) {
   ELFIO::section* text_section = nullptr;
@@ -23,7 +23,6 @@
 #include <string>
 #include <vector>
 
-#include <absl/container/btree_map.h>
 #include <absl/container/flat_hash_map.h>
 
 #include <elfio/elfio.hpp>
@@ -50,6 +49,12 @@ class ElfReader {
 
   std::filesystem::path& debug_symbols_path() { return debug_symbols_path_; }
 
+  /**
+   * Returns the build ID of the binary, from its .note.gnu.build-id section, or else from the
+   * .note.go.buildid section of Go binaries. Empty if the binary has neither.
+   */
+  const std::string& build_id() const { return build_id_; }
+
   struct SymbolInfo {
     std::string name;
     int type = -1;
@@ -116,27 +121,49 @@ class ElfReader {
    */
   StatusOr<std::optional<std::string>> InstrAddrToSymbol(size_t addr);
 
+  /**
+   * An address-sorted index of the symbols of a binary, for resolving any address in the body of
+   * a symbol with a binary search. It only depends on the contents of the binary, so it can be
+   * shared by all the processes that run the same binary.
+   *
+   * The functions of Go executables are indexed from their function table, which stripped
+   * executables still have, and which also resolves the inlined calls. See ReadGoFuncTable().
+   */
   class Symbolizer {
    public:
-    /**
-     * Associate the address range [addr, addr+size] with the provided symbol name.
-     * No checking is performed for overlapping regions, which will result in undefined behavior.
-     */
-    void AddEntry(uintptr_t addr, size_t size, std::string name);
-
     /**
      * Lookup the symbol for the specified address.
      */
     std::string_view Lookup(uintptr_t addr) const;
 
+    size_t size() const { return symbols_.size(); }
+
    private:
+    friend class ElfReader;
+
     struct SymbolAddrInfo {
+      uintptr_t addr;
       size_t size;
       std::string name;
     };
 
-    // Key is an address.
-    absl::btree_map<uintptr_t, SymbolAddrInfo> symbols_;
+    /**
+     * Associate the address range [addr, addr+size] with the provided symbol name.
+     * Entries only become visible to lookups once Build() is called.
+     */
+    void AddEntry(uintptr_t addr, size_t size, std::string name);
+
+    /**
+     * Sorts the entries by address. Of several entries at the same address, the first one added
+     * is kept. Overlapping regions are not checked for, and result in undefined behavior.
+     */
+    void Build();
+
+    // Returns the entry whose address range covers addr, or nullptr.
+    const SymbolAddrInfo* Find(uintptr_t addr) const;
+
+    // Sorted by address.
+    std::vector<SymbolAddrInfo> symbols_;
   };
 
   StatusOr<std::unique_ptr<Symbolizer>> GetSymbolizer();
@@ -151,6 +178,17 @@ class ElfReader {
    */
   StatusOr<px::utils::u8string> SymbolByteCode(std::string_view section, const SymbolInfo& symbol);
 
+  struct SectionData {
+    uint64_t address = 0;
+    // Held by the ElfReader. Empty for sections that occupy no space in the file, like .bss.
+    std::string_view data;
+  };
+
+  /**
+   * Returns the address and contents of the specified section.
+   */
+  StatusOr<SectionData> GetSectionData(std::string_view section);
+
  private:
   ElfReader() = default;
 
@@ -174,6 +212,11 @@ class ElfReader {
 
   std::filesystem::path debug_symbols_path_;
 
+  std::string build_id_;
+
+  // Index of all the sized symbols, which InstrAddrToSymbol() builds on first use.
+  std::unique_ptr<Symbolizer> instr_addr_index_;
+
   // Set up an elf reader, so we can extract debug symbols.
   ELFIO::elfio elf_reader_;
 };
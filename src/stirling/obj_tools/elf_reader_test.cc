@@ -195,6 +195,18 @@ TEST(ElfReaderTest, ExternalDebugSymbolsBuildID) {
                      ElementsAre(SymbolNameIs("CanYouFindThis")));
 }
 
+TEST(ElfReaderTest, BuildID) {
+  const std::string stripped_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/stripped_test_exe");
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(stripped_bin));
+  EXPECT_EQ(elf_reader->build_id(), "7deb0e3f89deba61");
+
+  const std::string prebuilt_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/prebuilt_test_exe");
+  ASSERT_OK_AND_ASSIGN(elf_reader, ElfReader::Create(prebuilt_bin));
+  EXPECT_EQ(elf_reader->build_id(), "");
+}
+
 TEST(ElfReaderTest, ExternalDebugSymbolsDebugLink) {
   const std::string stripped_bin =
       px::testing::BazelBinTestFilePath("src/stirling/obj_tools/testdata/cc/test_exe_debuglink");
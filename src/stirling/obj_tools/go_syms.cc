@@ -18,7 +18,13 @@
 
 #include "src/stirling/obj_tools/go_syms.h"
 
+#include <algorithm>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "src/common/base/byte_utils.h"
 
 namespace px {
 namespace stirling {
@@ -37,6 +43,338 @@ struct gostring {
   int64_t len;
 };
 
+// The magic numbers of the versions of the pclntab header. See runtime/symtab.go.
+constexpr uint32_t kGo116Magic = 0xfffffffa;
+constexpr uint32_t kGo118Magic = 0xfffffff0;
+constexpr uint32_t kGo120Magic = 0xfffffff1;
+
+// The indexes of the inlining tables among the pcdata and funcdata of a function.
+constexpr uint32_t kPCDataInlTreeIndex = 2;
+constexpr uint32_t kFuncDataInlTree = 3;
+
+// Offsets of fields of runtime.moduledata, whose layout only changes with the pclntab version.
+// The gofunc field, which funcdata offsets are relative to since Go 1.18, moved in Go 1.20.
+constexpr size_t kModuleDataTextOffset = 176;
+constexpr size_t kGo118ModuleDataGoFuncOffset = 304;
+constexpr size_t kGo120ModuleDataGoFuncOffset = 320;
+
+// Guards against cycles in a malformed inlining tree.
+constexpr int kMaxInlineDepth = 64;
+
+template <typename T>
+bool ReadInt(std::string_view data, uint64_t offset, T* value) {
+  if (offset > data.size() || data.size() - offset < sizeof(T)) {
+    return false;
+  }
+  using TUnsigned = std::make_unsigned_t<T>;
+  *value = static_cast<T>(utils::LEndianBytesToInt<TUnsigned>(data.substr(offset, sizeof(T))));
+  return true;
+}
+
+// Reads a varint of a pcvalue table and advances the data past it.
+bool ReadVarint(std::string_view* data, uint32_t* value) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 35 && !data->empty(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(data->front());
+    data->remove_prefix(1);
+    result |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The value of a pcvalue table from a PC up to the start of the next range.
+struct PCValueRange {
+  uint64_t start_pc;
+  int32_t value;
+};
+
+/**
+ * Reads the function table of a Go executable. See runtime/symtab.go for the formats, and
+ * debug/gosym for another reader.
+ */
+class GoFuncTableReader {
+ public:
+  GoFuncTableReader(ElfReader::SectionData pclntab,
+                    std::vector<ElfReader::SectionData> data_sections)
+      : pclntab_(pclntab), data_sections_(std::move(data_sections)) {}
+
+  StatusOr<std::vector<GoFuncRange>> Read() {
+    PL_RETURN_IF_ERROR(ReadHeader());
+
+    std::vector<GoFuncRange> ranges;
+    ranges.reserve(num_funcs_);
+    uint64_t func_entry = 0;
+    uint64_t func_offset = 0;
+    PL_RETURN_IF_ERROR(ReadFuncTabEntry(0, &func_entry, &func_offset));
+    for (uint64_t i = 0; i < num_funcs_; ++i) {
+      uint64_t next_entry = 0;
+      uint64_t next_offset = 0;
+      PL_RETURN_IF_ERROR(ReadFuncTabEntry(i + 1, &next_entry, &next_offset));
+      if (next_entry > func_entry) {
+        AddFuncRanges(func_entry, next_entry, func_offset, &ranges);
+      }
+      func_entry = next_entry;
+      func_offset = next_offset;
+    }
+    return ranges;
+  }
+
+ private:
+  uint64_t HeaderWord(int i) const {
+    uint64_t word = 0;
+    ReadInt(pclntab_.data, 8 + i * sizeof(uint64_t), &word);
+    return word;
+  }
+
+  Status ReadHeader() {
+    if (!ReadInt(pclntab_.data, 0, &magic_)) {
+      return error::Internal("The pclntab is too short.");
+    }
+    if (magic_ != kGo116Magic && magic_ != kGo118Magic && magic_ != kGo120Magic) {
+      return error::Unimplemented("Unsupported pclntab magic $0.", absl::StrFormat("%x", magic_));
+    }
+    if (pclntab_.data.size() < 8 + 8 * sizeof(uint64_t) || pclntab_.data[7] != sizeof(uint64_t)) {
+      return error::Unimplemented("Only 64-bit pclntabs are supported.");
+    }
+    pc_quantum_ = static_cast<uint8_t>(pclntab_.data[6]);
+
+    num_funcs_ = HeaderWord(0);
+    int next_word = 2;
+    if (magic_ != kGo116Magic) {
+      text_start_ = HeaderWord(next_word++);
+    }
+    func_names_ = Subtable(HeaderWord(next_word++));
+    // Skip the compilation unit and file tables.
+    next_word += 2;
+    pc_tab_ = Subtable(HeaderWord(next_word++));
+    func_table_ = Subtable(HeaderWord(next_word++));
+
+    if (magic_ != kGo116Magic) {
+      go_func_ = FindGoFunc();
+    }
+    return Status::OK();
+  }
+
+  std::string_view Subtable(uint64_t offset) const {
+    return offset < pclntab_.data.size() ? pclntab_.data.substr(offset) : std::string_view();
+  }
+
+  // The funcdata of Go 1.18 and later are offsets from moduledata.gofunc. The moduledata is the
+  // one data object that starts with the address of the pclntab.
+  uint64_t FindGoFunc() const {
+    const size_t go_func_offset =
+        magic_ == kGo118Magic ? kGo118ModuleDataGoFuncOffset : kGo120ModuleDataGoFuncOffset;
+    for (const ElfReader::SectionData& section : data_sections_) {
+      for (uint64_t offset = (8 - section.address % 8) % 8;
+           offset + go_func_offset + 8 <= section.data.size(); offset += 8) {
+        uint64_t pc_header = 0;
+        uint64_t text = 0;
+        uint64_t go_func = 0;
+        ReadInt(section.data, offset, &pc_header);
+        if (pc_header != pclntab_.address) {
+          continue;
+        }
+        ReadInt(section.data, offset + kModuleDataTextOffset, &text);
+        ReadInt(section.data, offset + go_func_offset, &go_func);
+        if (text == text_start_) {
+          return go_func;
+        }
+      }
+    }
+    VLOG(1) << "Could not find the moduledata, inlined calls are not resolved.";
+    return 0;
+  }
+
+  Status ReadFuncTabEntry(uint64_t i, uint64_t* entry, uint64_t* func_offset) const {
+    bool ok = false;
+    if (magic_ == kGo116Magic) {
+      ok = ReadInt(func_table_, i * 16, entry) && ReadInt(func_table_, i * 16 + 8, func_offset);
+    } else {
+      uint32_t entry_offset = 0;
+      uint32_t offset = 0;
+      ok = ReadInt(func_table_, i * 8, &entry_offset) && ReadInt(func_table_, i * 8 + 4, &offset);
+      *entry = text_start_ + entry_offset;
+      *func_offset = offset;
+    }
+    if (!ok) {
+      return error::Internal("The function table of the pclntab is truncated.");
+    }
+    return Status::OK();
+  }
+
+  // Returns the bytes at an address of the executable, or an empty string_view.
+  std::string_view ReadMemory(uint64_t address, uint64_t size) const {
+    for (const ElfReader::SectionData& section : data_sections_) {
+      if (address >= section.address && address - section.address <= section.data.size() &&
+          section.data.size() - (address - section.address) >= size) {
+        return section.data.substr(address - section.address, size);
+      }
+    }
+    return {};
+  }
+
+  std::string_view FuncName(int32_t name_offset) const {
+    if (name_offset < 0 || static_cast<uint64_t>(name_offset) >= func_names_.size()) {
+      return "?";
+    }
+    std::string_view name = func_names_.substr(name_offset);
+    return name.substr(0, name.find('\0'));
+  }
+
+  // Decodes a pcvalue table of a function into the ranges of PCs of each value.
+  std::vector<PCValueRange> DecodePCValues(uint32_t table_offset, uint64_t entry,
+                                           uint64_t end) const {
+    std::vector<PCValueRange> ranges;
+    if (table_offset >= pc_tab_.size()) {
+      return ranges;
+    }
+    std::string_view table = pc_tab_.substr(table_offset);
+    uint64_t pc = entry;
+    int32_t value = -1;
+    for (bool first = true; pc < end; first = false) {
+      uint32_t value_delta = 0;
+      uint32_t pc_delta = 0;
+      if (!ReadVarint(&table, &value_delta) || (value_delta == 0 && !first) ||
+          !ReadVarint(&table, &pc_delta)) {
+        break;
+      }
+      value += static_cast<int32_t>(-(value_delta & 1) ^ (value_delta >> 1));
+      ranges.push_back(PCValueRange{pc, value});
+      pc += static_cast<uint64_t>(pc_delta) * pc_quantum_;
+    }
+    return ranges;
+  }
+
+  // Returns the address of the inlining tree of a function, or 0 if it has none.
+  uint64_t InlineTreeAddress(uint64_t func_offset, size_t func_header_size, uint32_t num_pc_data,
+                             uint8_t num_func_data) const {
+    if (num_func_data <= kFuncDataInlTree) {
+      return 0;
+    }
+    uint64_t func_data_offset = func_offset + func_header_size + num_pc_data * sizeof(uint32_t);
+    if (magic_ == kGo116Magic) {
+      // The funcdata are pointers, aligned in memory.
+      const uint64_t func_table_offset = pclntab_.data.size() - func_table_.size();
+      if ((pclntab_.address + func_table_offset + func_data_offset) % 8 != 0) {
+        func_data_offset += 4;
+      }
+      uint64_t address = 0;
+      ReadInt(func_table_, func_data_offset + kFuncDataInlTree * sizeof(uint64_t), &address);
+      return address;
+    }
+    uint32_t offset = 0;
+    if (go_func_ == 0 ||
+        !ReadInt(func_table_, func_data_offset + kFuncDataInlTree * sizeof(uint32_t), &offset) ||
+        offset == ~0U) {
+      return 0;
+    }
+    return go_func_ + offset;
+  }
+
+  // Returns the names of the inlined calls at a PC, from the innermost outwards.
+  std::vector<std::string_view> InlinedCalls(const std::vector<PCValueRange>& inline_indexes,
+                                            int32_t index, uint64_t entry,
+                                            uint64_t inline_tree) const {
+    // runtime.inlinedCall is {parent int16, funcID uint8, _ byte, file int32, line int32,
+    // func_ int32, parentPc int32} before Go 1.20, and since then
+    // {funcID uint8, _ [3]byte, nameOff int32, parentPc int32, startLine int32}.
+    const bool go120 = magic_ == kGo120Magic;
+    const size_t call_size = go120 ? 16 : 20;
+    const size_t name_offset = go120 ? 4 : 12;
+    const size_t parent_pc_offset = go120 ? 8 : 16;
+
+    std::vector<std::string_view> names;
+    for (int depth = 0; index >= 0 && depth < kMaxInlineDepth; ++depth) {
+      std::string_view call = ReadMemory(inline_tree + index * call_size, call_size);
+      int32_t call_name = 0;
+      int32_t parent_pc = 0;
+      if (!ReadInt(call, name_offset, &call_name) || !ReadInt(call, parent_pc_offset, &parent_pc)) {
+        break;
+      }
+      names.push_back(FuncName(call_name));
+
+      // The caller is the call whose instructions include the parent PC.
+      auto iter = std::upper_bound(
+          inline_indexes.begin(), inline_indexes.end(), entry + parent_pc,
+          [](uint64_t pc, const PCValueRange& range) { return pc < range.start_pc; });
+      if (iter == inline_indexes.begin()) {
+        break;
+      }
+      index = std::prev(iter)->value;
+    }
+    return names;
+  }
+
+  void AddFuncRanges(uint64_t entry, uint64_t end, uint64_t func_offset,
+                     std::vector<GoFuncRange>* ranges) const {
+    // The runtime._func fields that are used here; npcdata is followed by the other uint32
+    // fields, and the struct ends with nfuncdata. Go 1.20 added startLine.
+    const size_t name_field = magic_ == kGo116Magic ? 8 : 4;
+    const size_t num_pc_data_field = magic_ == kGo116Magic ? 32 : 28;
+    const size_t num_func_data_field = magic_ == kGo118Magic ? 39 : 43;
+    const size_t func_header_size = num_func_data_field + 1;
+
+    int32_t name_offset = 0;
+    uint32_t num_pc_data = 0;
+    uint8_t num_func_data = 0;
+    uint32_t inline_indexes_offset = 0;
+    ReadInt(func_table_, func_offset + name_field, &name_offset);
+    ReadInt(func_table_, func_offset + num_pc_data_field, &num_pc_data);
+    ReadInt(func_table_, func_offset + num_func_data_field, &num_func_data);
+    if (num_pc_data > kPCDataInlTreeIndex) {
+      ReadInt(func_table_, func_offset + func_header_size + kPCDataInlTreeIndex * sizeof(uint32_t),
+              &inline_indexes_offset);
+    }
+    const std::string_view func_name = FuncName(name_offset);
+
+    uint64_t inline_tree =
+        InlineTreeAddress(func_offset, func_header_size, num_pc_data, num_func_data);
+    std::vector<PCValueRange> inline_indexes;
+    if (inline_tree != 0 && inline_indexes_offset != 0) {
+      inline_indexes = DecodePCValues(inline_indexes_offset, entry, end);
+    }
+    if (inline_indexes.empty()) {
+      ranges->push_back(GoFuncRange{entry, end - entry, std::string(func_name)});
+      return;
+    }
+
+    for (size_t i = 0; i < inline_indexes.size(); ++i) {
+      const uint64_t start = inline_indexes[i].start_pc;
+      const uint64_t range_end =
+          i + 1 < inline_indexes.size() ? inline_indexes[i + 1].start_pc : end;
+      std::string name(func_name);
+      std::vector<std::string_view> calls =
+          InlinedCalls(inline_indexes, inline_indexes[i].value, entry, inline_tree);
+      for (auto iter = calls.rbegin(); iter != calls.rend(); ++iter) {
+        absl::StrAppend(&name, ";", *iter);
+      }
+      // Adjacent ranges of the same calls are merged.
+      if (!ranges->empty() && ranges->back().address + ranges->back().size == start &&
+          ranges->back().name == name) {
+        ranges->back().size += std::min(range_end, end) - start;
+      } else {
+        ranges->push_back(GoFuncRange{start, std::min(range_end, end) - start, std::move(name)});
+      }
+    }
+  }
+
+  const ElfReader::SectionData pclntab_;
+  const std::vector<ElfReader::SectionData> data_sections_;
+
+  uint32_t magic_ = 0;
+  uint8_t pc_quantum_ = 1;
+  uint64_t num_funcs_ = 0;
+  uint64_t text_start_ = 0;
+  uint64_t go_func_ = 0;
+  std::string_view func_names_;
+  std::string_view pc_tab_;
+  std::string_view func_table_;
+};
+
 }  // namespace
 
 bool IsGoExecutable(ElfReader* elf_reader) {
@@ -97,6 +435,22 @@ StatusOr<absl::flat_hash_map<std::string, std::vector<IntfImplTypeInfo>>> Extrac
   return interface_types;
 }
 
+StatusOr<std::vector<GoFuncRange>> ReadGoFuncTable(ElfReader* elf_reader) {
+  PL_ASSIGN_OR_RETURN(ElfReader::SectionData pclntab, elf_reader->GetSectionData(".gopclntab"));
+
+  // The inlining trees are in .rodata, and the moduledata in .noptrdata.
+  std::vector<ElfReader::SectionData> data_sections = {pclntab};
+  for (std::string_view name : {".rodata", ".noptrdata", ".data"}) {
+    StatusOr<ElfReader::SectionData> section = elf_reader->GetSectionData(name);
+    if (section.ok()) {
+      data_sections.push_back(section.ConsumeValueOrDie());
+    }
+  }
+
+  GoFuncTableReader reader(pclntab, std::move(data_sections));
+  return reader.Read();
+}
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
@@ -56,6 +56,22 @@ struct IntfImplTypeInfo {
 StatusOr<absl::flat_hash_map<std::string, std::vector<IntfImplTypeInfo>>> ExtractGolangInterfaces(
     ElfReader* elf_reader);
 
+// Describes an address range of a Golang function.
+struct GoFuncRange {
+  uint64_t address = 0;
+  uint64_t size = 0;
+
+  // The function name. For the instructions of inlined calls, the names of the functions of the
+  // calls are appended as well, from the outermost to the innermost and separated by ';', which
+  // makes them separate frames of folded stack traces.
+  std::string name;
+};
+
+// Returns the address ranges of the functions of a Golang executable, sorted by address, from its
+// function table (pclntab). The runtime needs this table for its own stack traces, so unlike the
+// symbol table, it is kept in stripped executables. Supports Go 1.16 and later on 64-bit targets.
+StatusOr<std::vector<GoFuncRange>> ReadGoFuncTable(ElfReader* elf_reader);
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
@@ -18,7 +18,9 @@
 
 #include "src/stirling/obj_tools/go_syms.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 
@@ -26,6 +28,8 @@ namespace px {
 namespace stirling {
 namespace obj_tools {
 
+using ::testing::AllOf;
+using ::testing::Contains;
 using ::testing::Field;
 using ::testing::StrEq;
 
@@ -86,6 +90,37 @@ TEST(ElfGolangItableTest, ExtractInterfaceTypes) {
 #endif
 }
 
+TEST(ReadGoFuncTableTest, ResolvesFunctionsAndInlinedCalls) {
+  const std::string kPath =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/go/test_go_1_17_binary");
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(kPath));
+  ASSERT_OK_AND_ASSIGN(std::vector<GoFuncRange> funcs, ReadGoFuncTable(elf_reader.get()));
+
+  EXPECT_TRUE(std::is_sorted(
+      funcs.begin(), funcs.end(),
+      [](const GoFuncRange& a, const GoFuncRange& b) { return a.address < b.address; }));
+  EXPECT_THAT(funcs, Contains(AllOf(Field(&GoFuncRange::address, 0x47f080U),
+                                    Field(&GoFuncRange::size, 0x60U),
+                                    Field(&GoFuncRange::name, "main.Vertex.Abs"))));
+  // An instruction of runtime.(*waitq).dequeue, inlined into runtime.closechan.
+  EXPECT_THAT(funcs, Contains(AllOf(Field(&GoFuncRange::address, 0x404e25U),
+                                    Field(&GoFuncRange::name,
+                                          "runtime.closechan;runtime.(*waitq).dequeue"))));
+
+  // The symbolizer of the executable resolves the same functions.
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader::Symbolizer> symbolizer,
+                       elf_reader->GetSymbolizer());
+  EXPECT_EQ(symbolizer->Lookup(0x47f090), "main.Vertex.Abs");
+  EXPECT_EQ(symbolizer->Lookup(0x404e28), "runtime.closechan;runtime.(*waitq).dequeue");
+}
+
+TEST(ReadGoFuncTableTest, NotAGoExecutable) {
+  const std::string kPath =
+      px::testing::BazelBinTestFilePath("src/stirling/obj_tools/testdata/cc/test_exe");
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(kPath));
+  EXPECT_NOT_OK(ReadGoFuncTable(elf_reader.get()));
+}
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
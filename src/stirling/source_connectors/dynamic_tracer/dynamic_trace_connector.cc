@@ -24,6 +24,9 @@
 #include <rapidjson/writer.h>
 
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
@@ -35,6 +38,7 @@ namespace stirling {
 using ::google::protobuf::RepeatedPtrField;
 
 using ::px::stirling::dynamic_tracing::ir::physical::Field;
+using ::px::stirling::dynamic_tracing::ir::physical::OutputAggregation;
 using ::px::stirling::dynamic_tracing::ir::physical::Struct;
 using ::px::stirling::dynamic_tracing::ir::physical::StructSpec;
 using ::px::stirling::dynamic_tracing::ir::shared::ScalarType;
@@ -65,7 +69,18 @@ void GenericHandleEventLoss(void* cb_cookie, uint64_t lost) {
 
 }  // namespace
 
-BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>& repeated_fields) {
+namespace {
+
+constexpr char kCountColumn[] = "count";
+
+std::string HistogramColumn(std::string_view value_field) {
+  return absl::StrCat(value_field, "_hist");
+}
+
+}  // namespace
+
+BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>& repeated_fields,
+                                 const OutputAggregation* aggregation) {
   using dynamic_tracing::ir::shared::ScalarType;
 
   // clang-format off
@@ -103,7 +118,7 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
   };
   // clang-format on
 
-  BackedDataElements elements(repeated_fields.size());
+  BackedDataElements elements(repeated_fields.size() + (aggregation != nullptr ? 2 : 0));
 
   // Insert the special upid column.
   // TODO(yzhao): Make sure to have a structured way to let the IR to express the upid.
@@ -142,6 +157,14 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
     elements.emplace_back(field.name(), "", data_type, semantic_type);
   }
 
+  if (aggregation != nullptr) {
+    elements.emplace_back(kCountColumn, "The number of records.", types::DataType::INT64);
+    elements.emplace_back(HistogramColumn(aggregation->value_field()),
+                          "JSON object of the log2 histogram of the values. Keys are the exclusive "
+                          "upper bounds of the buckets.",
+                          types::DataType::STRING);
+  }
+
   return elements;
 }
 
@@ -162,8 +185,21 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
   // so punting on that for now.
   std::string desc = absl::StrCat("Dynamic table for ", output.name);
 
-  std::unique_ptr<DynamicDataTableSchema> table_schema =
-      DynamicDataTableSchema::Create(output.name, desc, ConvertFields(output.output.fields()));
+  const OutputAggregation* aggregation = nullptr;
+  if (output.aggregation.has_value()) {
+    aggregation = &output.aggregation.value();
+    for (const auto& field : output.output.fields()) {
+      if (field.name() == kCountColumn ||
+          field.name() == HistogramColumn(aggregation->value_field())) {
+        return error::InvalidArgument("Aggregated output $0 can't have a field named $1",
+                                      output.name, field.name());
+      }
+    }
+    absl::StrAppend(&desc, ", aggregated by all fields but the ", aggregation->value_field());
+  }
+
+  std::unique_ptr<DynamicDataTableSchema> table_schema = DynamicDataTableSchema::Create(
+      output.name, desc, ConvertFields(output.output.fields(), aggregation));
 
   return std::unique_ptr<SourceConnector>(
       new DynamicTraceConnector(name, std::move(table_schema), std::move(bcc_program)));
@@ -179,6 +215,11 @@ Status DynamicTraceConnector::InitImpl() {
     PL_RETURN_IF_ERROR(AttachUProbe(uprobe_spec));
   }
 
+  if (bcc_program_.perf_buffer_specs.front().aggregation.has_value()) {
+    // The aggregates are read from their map instead.
+    return Status::OK();
+  }
+
   // TODO(yzhao/oazizi): Might need to change this if we need to support multiple perf buffers.
   bpf_tools::PerfBufferSpec spec = {
       .name = bcc_program_.perf_buffer_specs.front().name,
@@ -285,6 +326,14 @@ class StructDecoder {
     return val;
   }
 
+  Status Skip(size_t size) {
+    if (buf_.size() < size) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    buf_.remove_prefix(size);
+    return Status::OK();
+  }
+
   StatusOr<std::string> ExtractString() {
     // NOTE: This implementation must match "struct string" defined in code_gen.cc.
     // A copy is provided here for reference:
@@ -360,6 +409,44 @@ class StructDecoder {
   std::string_view buf_;
 };
 
+StatusOr<size_t> IntegerTypeSize(ScalarType type) {
+  // clang-format off
+  static const absl::flat_hash_map<ScalarType, size_t> kIntegerTypeSizes = {
+      {ScalarType::CHAR, 1}, {ScalarType::UCHAR, 1},
+      {ScalarType::SHORT, 2}, {ScalarType::USHORT, 2},
+      {ScalarType::INT, 4}, {ScalarType::UINT, 4},
+      {ScalarType::LONG, 8}, {ScalarType::ULONG, 8},
+      {ScalarType::LONGLONG, 8}, {ScalarType::ULONGLONG, 8},
+      {ScalarType::INT8, 1}, {ScalarType::UINT8, 1},
+      {ScalarType::INT16, 2}, {ScalarType::UINT16, 2},
+      {ScalarType::INT32, 4}, {ScalarType::UINT32, 4},
+      {ScalarType::INT64, 8}, {ScalarType::UINT64, 8},
+  };
+  // clang-format on
+  auto iter = kIntegerTypeSizes.find(type);
+  if (iter == kIntegerTypeSizes.end()) {
+    return error::InvalidArgument("Type $0 is not an integer", type);
+  }
+  return iter->second;
+}
+
+// Returns the JSON object of the non-empty buckets of the histogram, by their upper bounds.
+std::string HistogramToJSON(const uint64_t (&hist)[dynamic_tracing::kAggregationHistogramBuckets]) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  for (size_t i = 0; i < dynamic_tracing::kAggregationHistogramBuckets; ++i) {
+    if (hist[i] == 0) {
+      continue;
+    }
+    std::string bound = absl::StrCat(uint64_t{1} << i);
+    writer.Key(bound.c_str());
+    writer.Uint64(hist[i]);
+  }
+  writer.EndObject();
+  return std::string(sb.GetString());
+}
+
 Status FillColumn(StructDecoder* struct_decoder, DataTable::DynamicRecordBuilder* r, size_t col_idx,
                   ScalarType type, const RepeatedPtrField<StructSpec>& col_decoder) {
 #define WRITE_COLUMN(field_type, column_type)                                        \
@@ -454,7 +541,8 @@ Status FillColumn(StructDecoder* struct_decoder, DataTable::DynamicRecordBuilder
 }  // namespace
 
 Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std::string_view buf,
-                                           DataTable* data_table) {
+                                           DataTable* data_table,
+                                           const AggregateRecord* aggregate) {
   StructDecoder struct_decoder(buf);
   DataTable::DynamicRecordBuilder r(data_table);
 
@@ -464,8 +552,13 @@ Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std:
 
     if (field.name() == "time_") {
       PL_ASSIGN_OR_RETURN(uint64_t ktime_ns, struct_decoder.ExtractField<uint64_t>());
-      int64_t time = ConvertToRealTime(ktime_ns);
+      int64_t time = aggregate != nullptr ? aggregate->time : ConvertToRealTime(ktime_ns);
       r.Append(col_idx++, types::Time64NSValue(time));
+    } else if (aggregate != nullptr && field.name() == aggregate->value_field) {
+      // The field is zeroed in the key, the column has the sum of the values.
+      PL_ASSIGN_OR_RETURN(size_t size, IntegerTypeSize(field.type()));
+      PL_RETURN_IF_ERROR(struct_decoder.Skip(size));
+      r.Append(col_idx++, types::Int64Value(static_cast<int64_t>(aggregate->value.sum)));
     } else if ((field.name() == "tgid_") && (i + 1 < st.fields_size()) &&
                (st.fields(i + 1).name() == "tgid_start_time_")) {
       // If we see "tgid_" and "tgid_start_time_" back-to-back, then we automatically create UPID.
@@ -482,9 +575,56 @@ Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std:
     }
   }
 
+  if (aggregate != nullptr) {
+    r.Append(col_idx++, types::Int64Value(static_cast<int64_t>(aggregate->value.count)));
+    r.Append(col_idx++, types::StringValue(HistogramToJSON(aggregate->value.hist)));
+  }
+
   return Status::OK();
 }
 
+Status DynamicTraceConnector::TransferAggregates(uint32_t asid, DataTable* data_table) {
+  const auto& spec = bcc_program_.perf_buffer_specs.front();
+  PL_ASSIGN_OR_RETURN(auto entries, GetRawHashTableEntries(spec.name));
+
+  AggregateRecord record;
+  record.time = AdjustedSteadyClockNowNS();
+  record.value_field = spec.aggregation->value_field();
+
+  // Entries without new records are removed, so that the map keeps room for new keys. Records
+  // added between the read and the removal are lost.
+  std::vector<std::string> idle_keys;
+  absl::flat_hash_map<std::string, AggregateValue> aggregates;
+  for (auto& [key, value] : entries) {
+    if (value.size() != sizeof(AggregateValue)) {
+      return error::Internal("Aggregate of $0 has $1 bytes, expected $2", spec.name, value.size(),
+                             sizeof(AggregateValue));
+    }
+    const auto aggregate = MemCpy<AggregateValue>(value.data());
+
+    record.value = aggregate;
+    auto iter = prev_aggregates_.find(key);
+    if (iter != prev_aggregates_.end()) {
+      const AggregateValue& prev = iter->second;
+      record.value.count -= prev.count;
+      record.value.sum -= prev.sum;
+      for (size_t i = 0; i < dynamic_tracing::kAggregationHistogramBuckets; ++i) {
+        record.value.hist[i] -= prev.hist[i];
+      }
+    }
+
+    if (record.value.count == 0) {
+      idle_keys.push_back(std::move(key));
+      continue;
+    }
+    PL_RETURN_IF_ERROR(AppendRecord(spec.output, asid, key, data_table, &record));
+    aggregates.emplace(std::move(key), aggregate);
+  }
+  prev_aggregates_ = std::move(aggregates);
+
+  return RemoveRawHashTableKeys(spec.name, idle_keys);
+}
+
 void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1)
@@ -495,6 +635,11 @@ void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     return;
   }
 
+  if (bcc_program_.perf_buffer_specs.front().aggregation.has_value()) {
+    ECHECK_OK(TransferAggregates(ctx->GetASID(), data_table));
+    return;
+  }
+
   PollPerfBuffers();
 
   for (const auto& item : data_items_) {
@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/source_connector.h"
@@ -62,8 +64,28 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   Status StopImpl() override { return Status::OK(); }
 
  private:
+  // Must match the "<output>_agg_value_t" struct of aggregated outputs, defined in code_gen.cc.
+  struct AggregateValue {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t hist[dynamic_tracing::kAggregationHistogramBuckets];
+  };
+
+  // The aggregates of aggregated outputs, for the columns that follow the fields of the output.
+  struct AggregateRecord {
+    int64_t time;
+    std::string_view value_field;
+    AggregateValue value;
+  };
+
+  // Appends the record in buf to the table. If aggregate is set, buf is the key of the aggregate,
+  // whose values replace those of the time_ and aggregated fields.
   Status AppendRecord(const ::px::stirling::dynamic_tracing::ir::physical::Struct& st,
-                      uint32_t asid, std::string_view buf, DataTable* data_table);
+                      uint32_t asid, std::string_view buf, DataTable* data_table,
+                      const AggregateRecord* aggregate = nullptr);
+
+  // Reads the map of an aggregated output, and appends the changes since the previous read.
+  Status TransferAggregates(uint32_t asid, DataTable* data_table);
 
   // Describes the output table column types.
   std::unique_ptr<DynamicDataTableSchema> table_schema_;
@@ -73,13 +95,18 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
 
   // A buffer to hold raw data items from the perf buffer.
   std::deque<std::string> data_items_;
+
+  // The aggregates read by the previous TransferAggregates(), by their raw keys.
+  absl::flat_hash_map<std::string, AggregateValue> prev_aggregates_;
 };
 
 // Converts proto specification of columns into the form that is used by TableSchema.
+// Aggregated outputs have count and <value_field>_hist columns after their fields.
 // Only public for testing purposes.
 BackedDataElements ConvertFields(
     const google::protobuf::RepeatedPtrField<dynamic_tracing::ir::physical::Field>&
-        repeated_fields);
+        repeated_fields,
+    const dynamic_tracing::ir::physical::OutputAggregation* aggregation = nullptr);
 
 }  // namespace stirling
 }  // namespace px
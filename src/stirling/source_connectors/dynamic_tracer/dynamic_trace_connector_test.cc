@@ -79,5 +79,45 @@ TEST(DynamicTraceConnectorTest, ConvertFields) {
   EXPECT_EQ(elements.elements()[2].type(), types::TIME64NS);
 }
 
+TEST(DynamicTraceConnectorTest, ConvertFieldsOfAggregatedOutput) {
+  constexpr std::string_view kOutputStruct = R"(
+      name: "out_table_value_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "time_"
+        type: UINT64
+      }
+      fields {
+        name: "latency"
+        type: INT64
+      }
+  )";
+
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(std::string(kOutputStruct), &output_struct));
+  ::px::stirling::dynamic_tracing::ir::physical::OutputAggregation aggregation;
+  aggregation.set_value_field("latency");
+  aggregation.add_dropped_fields("time_");
+
+  BackedDataElements elements = ConvertFields(output_struct.fields(), &aggregation);
+
+  ASSERT_EQ(elements.elements().size(), 5);
+  EXPECT_EQ(elements.elements()[0].name(), "upid");
+  EXPECT_EQ(elements.elements()[1].name(), "time_");
+  EXPECT_EQ(elements.elements()[2].name(), "latency");
+  EXPECT_EQ(elements.elements()[3].name(), "count");
+  EXPECT_EQ(elements.elements()[3].type(), types::INT64);
+  EXPECT_EQ(elements.elements()[4].name(), "latency_hist");
+  EXPECT_EQ(elements.elements()[4].type(), types::STRING);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -41,6 +41,7 @@ using ::px::stirling::dynamic_tracing::ir::physical::BinaryExpression;
 using ::px::stirling::dynamic_tracing::ir::physical::Field;
 using ::px::stirling::dynamic_tracing::ir::physical::MapDeleteAction;
 using ::px::stirling::dynamic_tracing::ir::physical::MapStashAction;
+using ::px::stirling::dynamic_tracing::ir::physical::OutputAggregation;
 using ::px::stirling::dynamic_tracing::ir::physical::PerCPUArray;
 using ::px::stirling::dynamic_tracing::ir::physical::PerfBufferOutput;
 using ::px::stirling::dynamic_tracing::ir::physical::PerfBufferOutputAction;
@@ -182,6 +183,9 @@ class BCCCodeGenerator {
 
   // Map from Struct names to their definition.
   absl::flat_hash_map<std::string_view, const ir::physical::Struct*> structs_;
+
+  // Map from output names to their definition.
+  absl::flat_hash_map<std::string_view, const PerfBufferOutput*> outputs_;
 };
 
 // Returns the C type name of the input ScalarType.
@@ -578,14 +582,122 @@ std::string GenMapDeleteAction(const MapDeleteAction& action) {
   return absl::Substitute("$0.delete(&$1);", action.map_name(), action.key_variable_name());
 }
 
-std::string GenPerfBufferOutput(const PerfBufferOutput& output) {
-  return absl::Substitute("BPF_PERF_OUTPUT($0);", output.name());
+namespace {
+
+bool IsIntegerType(ScalarType type) {
+  static const absl::flat_hash_set<ScalarType> kIntegerTypes = {
+      ScalarType::SHORT,  ScalarType::USHORT, ScalarType::INT,      ScalarType::UINT,
+      ScalarType::LONG,   ScalarType::ULONG,  ScalarType::LONGLONG, ScalarType::ULONGLONG,
+      ScalarType::INT8,   ScalarType::INT16,  ScalarType::INT32,    ScalarType::INT64,
+      ScalarType::UINT8,  ScalarType::UINT16, ScalarType::UINT32,   ScalarType::UINT64,
+      ScalarType::CHAR,   ScalarType::UCHAR,
+  };
+  return kIntegerTypes.contains(type);
+}
+
+std::string AggregationValueStructName(std::string_view output_name) {
+  return absl::StrCat(output_name, "_agg_value_t");
+}
+
+std::string AggregationInitArrayName(std::string_view output_name) {
+  return absl::StrCat(output_name, "_agg_init");
+}
+
+// Aggregated outputs are a BPF hash map from the output struct to the aggregates. The array holds
+// the zero aggregates, that a new entry starts with; they are too large for the BPF stack.
+std::vector<std::string> GenAggregatedOutput(const PerfBufferOutput& output) {
+  const std::string value_struct_name = AggregationValueStructName(output.name());
+  return {
+      absl::Substitute("struct $0 {", value_struct_name),
+      "  uint64_t count;",
+      "  uint64_t sum;",
+      absl::Substitute("  uint64_t hist[$0];", kAggregationHistogramBuckets),
+      "};",
+      absl::Substitute("BPF_HASH($0, struct $1, struct $2, $3);", output.name(),
+                       output.struct_type(), value_struct_name, kAggregationMapCapacity),
+      absl::Substitute("BPF_ARRAY($0, struct $1, 1);", AggregationInitArrayName(output.name()),
+                       value_struct_name),
+  };
+}
+
+}  // namespace
+
+std::vector<std::string> GenPerfBufferOutput(const PerfBufferOutput& output) {
+  if (output.has_aggregation()) {
+    return GenAggregatedOutput(output);
+  }
+  return {absl::Substitute("BPF_PERF_OUTPUT($0);", output.name())};
 }
 
 namespace {
 
+// Adds the record to its entry in the map of an aggregated output. Fields that are not part of the
+// key are zeroed in the output struct, which is then the key.
+StatusOr<std::vector<std::string>> GenAggregationAction(const ir::physical::Struct& output_struct,
+                                                        const PerfBufferOutputAction& action,
+                                                        const OutputAggregation& aggregation,
+                                                        std::string_view output_var_name,
+                                                        std::string_view arr_idx_var_name) {
+  const absl::flat_hash_set<std::string_view> dropped_fields(aggregation.dropped_fields().begin(),
+                                                             aggregation.dropped_fields().end());
+
+  if (action.variable_names_size() > output_struct.fields_size()) {
+    return error::InvalidArgument("Output '$0' writes $1 variables to a struct of $2 fields",
+                                  action.perf_buffer_name(), action.variable_names_size(),
+                                  output_struct.fields_size());
+  }
+
+  std::vector<std::string> code_lines;
+  std::string_view value_var_name;
+  for (int i = 0; i < action.variable_names_size(); ++i) {
+    const Field& field = output_struct.fields(i);
+    std::string_view var_name = action.variable_names(i);
+    if (field.name() == aggregation.value_field()) {
+      if (!IsIntegerType(field.type())) {
+        return error::InvalidArgument("Aggregated field '$0' of output '$1' must be an integer",
+                                      field.name(), action.perf_buffer_name());
+      }
+      value_var_name = var_name;
+      var_name = "0";
+    } else if (dropped_fields.contains(field.name())) {
+      var_name = "0";
+    }
+    code_lines.push_back(absl::Substitute("$0->$1 = $2;", output_var_name, field.name(), var_name));
+  }
+  if (value_var_name.empty()) {
+    return error::InvalidArgument("Output '$0' has no aggregated field '$1'",
+                                  action.perf_buffer_name(), aggregation.value_field());
+  }
+
+  const std::string value_struct_name = AggregationValueStructName(action.perf_buffer_name());
+  const std::string init_var_name = absl::StrCat(output_var_name, "_agg_init");
+  const std::string agg_var_name = absl::StrCat(output_var_name, "_agg");
+  const std::string bucket_var_name = absl::StrCat(output_var_name, "_agg_bucket");
+
+  code_lines.push_back(absl::Substitute(
+      "struct $0* $1 = $2.lookup(&$3);", value_struct_name, init_var_name,
+      AggregationInitArrayName(action.perf_buffer_name()), arr_idx_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 == NULL) { return 0; }", init_var_name));
+  code_lines.push_back(absl::Substitute("struct $0* $1 = $2.lookup_or_init($3, $4);",
+                                        value_struct_name, agg_var_name,
+                                        action.perf_buffer_name(), output_var_name, init_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 == NULL) { return 0; }", agg_var_name));
+  code_lines.push_back(absl::Substitute("__sync_fetch_and_add(&$0->count, 1);", agg_var_name));
+  code_lines.push_back(
+      absl::Substitute("__sync_fetch_and_add(&$0->sum, $1);", agg_var_name, value_var_name));
+  code_lines.push_back(absl::Substitute("uint32_t $0 = bpf_log2l($1);", bucket_var_name,
+                                        value_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 >= $1) { $0 = $2; }", bucket_var_name,
+                                        kAggregationHistogramBuckets,
+                                        kAggregationHistogramBuckets - 1));
+  code_lines.push_back(
+      absl::Substitute("__sync_fetch_and_add(&$0->hist[$1], 1);", agg_var_name, bucket_var_name));
+  return code_lines;
+}
+
 StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
-    const ir::physical::Struct& output_struct, const PerfBufferOutputAction& action) {
+    const ir::physical::Struct& output_struct, const PerfBufferOutputAction& action,
+    const OutputAggregation* aggregation) {
   std::string output_var_name = absl::StrCat(action.perf_buffer_name(), "_value");
 
   std::vector<std::string> code_lines;
@@ -598,6 +710,13 @@ StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
                                         action.data_buffer_array_name(), arr_idx_var_name));
   code_lines.push_back(absl::Substitute("if ($0 == NULL) { return 0; }", output_var_name));
 
+  if (aggregation != nullptr) {
+    MOVE_BACK_STR_VEC(GenAggregationAction(output_struct, action, *aggregation, output_var_name,
+                                           arr_idx_var_name),
+                      &code_lines);
+    return code_lines;
+  }
+
   int struct_field_index = 0;
   for (const auto& f : action.variable_names()) {
     code_lines.push_back(absl::Substitute("$0->$1 = $2;", output_var_name,
@@ -857,7 +976,12 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateProbe(const Probe&
     if (iter == structs_.end()) {
       return error::InvalidArgument("Output struct '$0' is undefined", action.output_struct_name());
     }
-    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action), &code_lines);
+    const OutputAggregation* aggregation = nullptr;
+    auto output_iter = outputs_.find(action.perf_buffer_name());
+    if (output_iter != outputs_.end() && output_iter->second->has_aggregation()) {
+      aggregation = &output_iter->second->aggregation();
+    }
+    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action, aggregation), &code_lines);
   }
 
   for (const auto& printk : probe.printks()) {
@@ -1027,7 +1151,8 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
   }
 
   for (const auto& output : program_.outputs()) {
-    code_lines.push_back(GenPerfBufferOutput(output));
+    MoveBackStrVec(GenPerfBufferOutput(output), &code_lines);
+    outputs_[output.name()] = &output;
   }
 
   for (const auto& probe : program_.probes()) {
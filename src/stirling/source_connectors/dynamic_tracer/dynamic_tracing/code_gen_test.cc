@@ -39,8 +39,12 @@ using ::px::stirling::dynamic_tracing::ir::physical::Struct;
 using ::px::stirling::dynamic_tracing::ir::physical::StructVariable;
 using ::px::stirling::dynamic_tracing::ir::shared::BPFHelper;
 using ::px::stirling::dynamic_tracing::ir::shared::ScalarType;
+using ::testing::Contains;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+using ::testing::IsSupersetOf;
+using ::testing::Not;
 using ::testing::StrEq;
 
 TEST(GenStructTest, Output) {
@@ -476,6 +480,117 @@ TEST(GenProgramTest, SpecsAndCode) {
   EXPECT_THAT(bcc_code_lines, ElementsAreArray(expected_code_lines));
 }
 
+TEST(GenProgramTest, AggregatedOutput) {
+  const std::string program_protobuf = R"proto(
+                                       deployment_spec {
+                                         path: "target_binary_path"
+                                       }
+                                       structs {
+                                         name: "out_value_t"
+                                         fields {
+                                           name: "time_"
+                                           type: UINT64
+                                         }
+                                         fields {
+                                           name: "arg"
+                                           type: INT32
+                                         }
+                                         fields {
+                                           name: "latency"
+                                           type: INT64
+                                         }
+                                       }
+                                       arrays {
+                                         name: "out_data_buffer_array"
+                                         type { struct_type: "out_value_t" }
+                                         capacity: 1
+                                       }
+                                       outputs {
+                                         name: "out"
+                                         struct_type: "out_value_t"
+                                         aggregation {
+                                           value_field: "latency"
+                                           dropped_fields: "time_"
+                                         }
+                                       }
+                                       probes {
+                                         name: "probe_return"
+                                         tracepoint {
+                                           symbol: "target_symbol"
+                                           type: RETURN
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "time_"
+                                             type: UINT64
+                                             builtin: KTIME
+                                           }
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "arg"
+                                             type: INT32
+                                             reg: RC
+                                           }
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "latency"
+                                             type: INT64
+                                             constant: "10"
+                                           }
+                                         }
+                                         output_actions {
+                                           perf_buffer_name: "out"
+                                           data_buffer_array_name: "out_data_buffer_array"
+                                           output_struct_name: "out_value_t"
+                                           variable_names: "time_"
+                                           variable_names: "arg"
+                                           variable_names: "latency"
+                                         }
+                                       }
+                                       )proto";
+
+  ir::physical::Program program;
+  ASSERT_TRUE(TextFormat::ParseFromString(program_protobuf, &program));
+
+  ASSERT_OK_AND_ASSIGN(const std::string bcc_code, GenBCCProgram(program));
+  std::vector<std::string> bcc_code_lines = absl::StrSplit(bcc_code, "\n");
+
+  EXPECT_THAT(bcc_code_lines,
+              IsSupersetOf({
+                  "struct out_agg_value_t {",
+                  "  uint64_t count;",
+                  "  uint64_t sum;",
+                  "  uint64_t hist[64];",
+                  "BPF_HASH(out, struct out_value_t, struct out_agg_value_t, 10240);",
+                  "BPF_ARRAY(out_agg_init, struct out_agg_value_t, 1);",
+              }));
+  EXPECT_THAT(bcc_code_lines, Not(Contains("BPF_PERF_OUTPUT(out);")));
+
+  // The time_ and latency fields are left out of the key.
+  EXPECT_THAT(bcc_code_lines,
+              IsSupersetOf({
+                  "out_value->time_ = 0;",
+                  "out_value->arg = arg;",
+                  "out_value->latency = 0;",
+                  "struct out_agg_value_t* out_value_agg_init = "
+                  "out_agg_init.lookup(&out_value_idx);",
+                  "struct out_agg_value_t* out_value_agg = out.lookup_or_init(out_value, "
+                  "out_value_agg_init);",
+                  "__sync_fetch_and_add(&out_value_agg->count, 1);",
+                  "__sync_fetch_and_add(&out_value_agg->sum, latency);",
+                  "uint32_t out_value_agg_bucket = bpf_log2l(latency);",
+                  "if (out_value_agg_bucket >= 64) { out_value_agg_bucket = 63; }",
+                  "__sync_fetch_and_add(&out_value_agg->hist[out_value_agg_bucket], 1);",
+              }));
+  EXPECT_THAT(bcc_code_lines, Not(Contains(HasSubstr("perf_submit"))));
+
+  // The aggregated field must be a field of the output.
+  program.mutable_outputs(0)->mutable_aggregation()->set_value_field("arg2");
+  EXPECT_NOT_OK(GenBCCProgram(program));
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -19,12 +19,16 @@
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
 #include <algorithm>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 
@@ -42,6 +46,15 @@
 #include "src/stirling/utils/proc_path_tools.h"
 
 DEFINE_bool(debug_dt_pipeline, false, "Enable logging of the Dynamic Tracing pipeline IR graphs.");
+DEFINE_string(stirling_dynamic_trace_aggregate_field,
+              gflags::StringFromEnv("PL_STIRLING_DYNAMIC_TRACE_AGGREGATE_FIELD", ""),
+              "If set, outputs of dynamic tracepoints that have an integer field of this name, "
+              "like latency, are aggregated in the kernel instead of output record by record. "
+              "Each sampling period outputs the count, and the sum and histogram of the field, "
+              "of the records with the same values of the other fields.");
+DEFINE_uint32(stirling_dynamic_trace_program_cache_size, 64,
+              "The number of compiled tracepoints that are kept, so that deploying them again to "
+              "processes of the same binary skips reading its debug info. 0 disables the cache.");
 
 namespace px {
 namespace stirling {
@@ -91,64 +104,130 @@ StatusOr<BCCProgram::PerfBufferSpec> GetPerfBufferSpec(
 
   pf_spec.name = output.name();
   pf_spec.output = *iter->second;
+  if (output.has_aggregation()) {
+    pf_spec.aggregation = output.aggregation();
+  }
 
   return pf_spec;
 }
 
-// Return value for Prepare(), so we can return multiple pointers.
-struct ObjInfo {
-  std::unique_ptr<ElfReader> elf_reader;
-  std::unique_ptr<DwarfReader> dwarf_reader;
-};
+// Marks the outputs whose struct has the value field to be aggregated in the kernel. The time_ and
+// goid_ fields are left out of the aggregation key, as most records have their own values.
+void AggregateOutputs(std::string_view value_field, ir::physical::Program* program) {
+  if (value_field.empty()) {
+    return;
+  }
 
-// Prepares the input program for compilation by:
-// 1) Resolving the tracepoint target specification into an object path (e.g. UPID->path).
-// 2) Preparing the Elf and Dwarf info for the binary.
-StatusOr<ObjInfo> Prepare(const ir::logical::TracepointDeployment& input_program) {
-  ObjInfo obj_info;
+  absl::flat_hash_map<std::string_view, const ir::physical::Struct*> structs;
+  for (const auto& st : program->structs()) {
+    structs[st.name()] = &st;
+  }
 
-  const auto& binary_path = input_program.deployment_spec().path();
-  LOG(INFO) << absl::Substitute("Tracepoint binary: $0", binary_path);
+  for (auto& output : *program->mutable_outputs()) {
+    auto iter = structs.find(output.struct_type());
+    if (iter == structs.end()) {
+      continue;
+    }
+    const auto& fields = iter->second->fields();
+    auto has_field = [&fields](std::string_view name) {
+      return std::any_of(fields.begin(), fields.end(),
+                         [name](const ir::physical::Field& f) { return f.name() == name; });
+    };
+    if (!has_field(value_field)) {
+      continue;
+    }
+    auto* aggregation = output.mutable_aggregation();
+    aggregation->set_value_field(std::string(value_field));
+    for (std::string_view name : {"time_", "goid_"}) {
+      if (has_field(name)) {
+        aggregation->add_dropped_fields(std::string(name));
+      }
+    }
+  }
+}
 
-  PL_ASSIGN_OR_RETURN(obj_info.elf_reader, ElfReader::Create(binary_path));
+// The physical program and the BCC code of a tracepoint, which only depend on the binary and
+// the logical program.
+struct CompiledProgram {
+  ir::physical::Program physical_program;
+  std::string bcc_code;
+};
 
-  const auto& debug_symbols_path = obj_info.elf_reader->debug_symbols_path().string();
+// Caches compiled tracepoints, so that deploying the same tracepoint to many processes of the same
+// binary, or deploying it again, reads the DWARF info of the binary and runs the compilation
+// pipeline only once. The oldest entries are evicted first.
+class CompiledProgramCache {
+ public:
+  static CompiledProgramCache& GetInstance() {
+    static auto* cache = new CompiledProgramCache;
+    return *cache;
+  }
 
-  obj_info.dwarf_reader =
-      DwarfReader::CreateIndexingAll(debug_symbols_path).ConsumeValueOr(nullptr);
+  std::optional<CompiledProgram> Get(const std::string& key) {
+    absl::MutexLock lock(&mutex_);
+    auto iter = programs_.find(key);
+    if (iter == programs_.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
 
-  return obj_info;
-}
+  void Put(const std::string& key, const CompiledProgram& program, size_t capacity) {
+    absl::MutexLock lock(&mutex_);
+    if (capacity == 0 || !programs_.try_emplace(key, program).second) {
+      return;
+    }
+    keys_.push_back(key);
+    while (keys_.size() > capacity) {
+      programs_.erase(keys_.front());
+      keys_.pop_front();
+    }
+  }
 
-}  // namespace
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, CompiledProgram> programs_ ABSL_GUARDED_BY(mutex_);
+  // The keys of programs_, oldest first.
+  std::deque<std::string> keys_ ABSL_GUARDED_BY(mutex_);
+};
 
-StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_program) {
-  if (input_program->deployment_spec().path().empty()) {
-    return error::InvalidArgument("Must have path resolved before compiling program");
+// Returns the key of the compiled program in CompiledProgramCache. The path of the binary is left
+// out, as it differs between processes; the build ID identifies the binary. Returns an empty key
+// for binaries without a build ID, which are not cached.
+std::string CompiledProgramCacheKey(const ElfReader& elf_reader,
+                                    const ir::logical::TracepointDeployment& input_program) {
+  if (elf_reader.build_id().empty()) {
+    return "";
   }
+  ir::logical::TracepointDeployment program = input_program;
+  program.clear_deployment_spec();
+  program.clear_ttl();
+  return absl::StrCat(elf_reader.build_id(), "\n", FLAGS_stirling_dynamic_trace_aggregate_field,
+                      "\n", program.ShortDebugString());
+}
 
-  if (input_program->tracepoints_size() != 1) {
-    return error::InvalidArgument("Only one tracepoint currently supported, got '$0'",
-                                  input_program->tracepoints_size());
-  }
+// Runs the compilation pipeline of the input program into physical IR and BCC code.
+StatusOr<CompiledProgram> CompileToPhysicalProgram(
+    ElfReader* elf_reader, ir::logical::TracepointDeployment* input_program) {
+  const auto& debug_symbols_path = elf_reader->debug_symbols_path().string();
 
-  // Get the ELF and DWARF readers for the program.
-  PL_ASSIGN_OR_RETURN(ObjInfo obj_info, Prepare(*input_program));
+  std::unique_ptr<DwarfReader> dwarf_reader =
+      DwarfReader::CreateIndexingAll(debug_symbols_path).ConsumeValueOr(nullptr);
 
   // --------------------------
   // Pre-processing pipeline
   // --------------------------
 
   // Populate source language.
-  DetectSourceLanguage(obj_info.elf_reader.get(), obj_info.dwarf_reader.get(), input_program);
+  DetectSourceLanguage(elf_reader, dwarf_reader.get(), input_program);
 
   // Expand symbol.
-  PL_RETURN_IF_ERROR(ResolveProbeSymbol(obj_info.elf_reader.get(), input_program));
+  PL_RETURN_IF_ERROR(ResolveProbeSymbol(elf_reader, input_program));
 
   LOG_IF(INFO, FLAGS_debug_dt_pipeline) << input_program->DebugString();
 
   // Auto-gen probe variables
-  PL_RETURN_IF_ERROR(AutoTraceExpansion(obj_info.dwarf_reader.get(), input_program));
+  PL_RETURN_IF_ERROR(AutoTraceExpansion(dwarf_reader.get(), input_program));
 
   LOG_IF(INFO, FLAGS_debug_dt_pipeline) << input_program->DebugString();
 
@@ -161,13 +240,57 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
 
   LOG_IF(INFO, FLAGS_debug_dt_pipeline) << input_program->DebugString();
 
-  PL_ASSIGN_OR_RETURN(ir::physical::Program physical_program,
-                      GeneratePhysicalProgram(intermediate_program, obj_info.dwarf_reader.get(),
-                                              obj_info.elf_reader.get()));
+  CompiledProgram compiled;
+  PL_ASSIGN_OR_RETURN(
+      compiled.physical_program,
+      GeneratePhysicalProgram(intermediate_program, dwarf_reader.get(), elf_reader));
+  ir::physical::Program& physical_program = compiled.physical_program;
+
+  AggregateOutputs(FLAGS_stirling_dynamic_trace_aggregate_field, &physical_program);
 
   LOG_IF(INFO, FLAGS_debug_dt_pipeline) << physical_program.DebugString();
 
-  PL_ASSIGN_OR_RETURN(std::string bcc_code, GenBCCProgram(physical_program));
+  PL_ASSIGN_OR_RETURN(compiled.bcc_code, GenBCCProgram(physical_program));
+
+  return compiled;
+}
+
+}  // namespace
+
+StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_program) {
+  if (input_program->deployment_spec().path().empty()) {
+    return error::InvalidArgument("Must have path resolved before compiling program");
+  }
+
+  if (input_program->tracepoints_size() != 1) {
+    return error::InvalidArgument("Only one tracepoint currently supported, got '$0'",
+                                  input_program->tracepoints_size());
+  }
+
+  const std::string binary_path = input_program->deployment_spec().path();
+  LOG(INFO) << absl::Substitute("Tracepoint binary: $0", binary_path);
+
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(binary_path));
+
+  // The DWARF info is only read if the program was not compiled for the same binary before.
+  const std::string cache_key = CompiledProgramCacheKey(*elf_reader, *input_program);
+  std::optional<CompiledProgram> cached;
+  if (!cache_key.empty()) {
+    cached = CompiledProgramCache::GetInstance().Get(cache_key);
+  }
+  CompiledProgram compiled;
+  if (cached.has_value()) {
+    VLOG(1) << absl::Substitute("Reusing the compiled tracepoint for build ID $0",
+                                elf_reader->build_id());
+    compiled = std::move(cached.value());
+  } else {
+    PL_ASSIGN_OR_RETURN(compiled, CompileToPhysicalProgram(elf_reader.get(), input_program));
+    if (!cache_key.empty()) {
+      CompiledProgramCache::GetInstance().Put(cache_key, compiled,
+                                              FLAGS_stirling_dynamic_trace_program_cache_size);
+    }
+  }
+  const ir::physical::Program& physical_program = compiled.physical_program;
 
   // --------------------------
   // Generate BCC Program Object
@@ -176,17 +299,16 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
   // TODO(oazizi): Move the code below into its own function.
 
   BCCProgram bcc_program;
-  bcc_program.code = std::move(bcc_code);
+  bcc_program.code = std::move(compiled.bcc_code);
 
   const ir::shared::Language& language = physical_program.language();
-  const std::string& binary_path = physical_program.deployment_spec().path();
 
   // TODO(yzhao): deployment_spec.upid will be lost after calling ResolveTargetObjPath().
   // Consider adjust data structure such that both can be preserved.
 
   for (const auto& probe : physical_program.probes()) {
     PL_ASSIGN_OR_RETURN(std::vector<UProbeSpec> specs,
-                        GetUProbeSpec(binary_path, language, probe, obj_info.elf_reader.get()));
+                        GetUProbeSpec(binary_path, language, probe, elf_reader.get()));
     for (auto& spec : specs) {
       bcc_program.uprobe_specs.push_back(std::move(spec));
     }
@@ -24,6 +24,8 @@
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/physicalpb/physical.pb.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/types.h"
 
+DECLARE_string(stirling_dynamic_trace_aggregate_field);
+
 namespace px {
 namespace stirling {
 namespace dynamic_tracing {
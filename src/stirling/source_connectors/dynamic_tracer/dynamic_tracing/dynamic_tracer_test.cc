@@ -106,7 +106,7 @@ class ResolveTargetObjPathTest : public ::testing::Test {
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod0_update));
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod1_update));
 
-    k8s_mds_.containers_by_id()["container0"]->mutable_active_upids()->emplace(
+    k8s_mds_.MutableContainerInfoByID("container0")->mutable_active_upids()->emplace(
         PIDToUPID(s_.child_pid()));
   }
 
@@ -447,6 +447,31 @@ TEST(DynamicTracerTest, Compile) {
   EXPECT_THAT(code_lines, ElementsAreArray(kExpectedBCC));
 }
 
+// Tests that a program that was compiled for a binary is reused for copies of the binary.
+TEST(DynamicTracerTest, CompileCopyOfBinary) {
+  const std::filesystem::path binary_path = px::testing::BazelBinTestFilePath(kBinaryPath);
+  px::testing::TempDir temp_dir;
+  const std::filesystem::path copy_path = temp_dir.path() / "test_go_binary";
+  ASSERT_OK(fs::Copy(binary_path, copy_path));
+
+  ir::logical::TracepointDeployment input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, binary_path.string()), &input_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram bcc_program, CompileProgram(&input_program));
+
+  ir::logical::TracepointDeployment copy_input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, copy_path.string()), &copy_input_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram copy_bcc_program, CompileProgram(&copy_input_program));
+
+  EXPECT_EQ(copy_bcc_program.code, bcc_program.code);
+  ASSERT_THAT(copy_bcc_program.uprobe_specs, SizeIs(bcc_program.uprobe_specs.size()));
+  // The probes are attached to the copy.
+  for (const auto& spec : copy_bcc_program.uprobe_specs) {
+    EXPECT_EQ(spec.binary_path, copy_path);
+  }
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -53,13 +54,25 @@ constexpr size_t kStructByteArraySize = 64;
 // generated types.
 constexpr size_t kStructBlobSize = 64;
 
+// Number of the log2 buckets of the histograms of aggregated outputs. Bucket i counts the values
+// in [2^(i-1), 2^i); the last bucket also counts the larger ones.
+constexpr size_t kAggregationHistogramBuckets = 64;
+
+// Capacity of the BPF maps of aggregated outputs. Records with new keys are dropped, while the
+// map is full.
+constexpr size_t kAggregationMapCapacity = 10240;
+
 struct BCCProgram {
   struct PerfBufferSpec {
     std::string name;
     ir::physical::Struct output;
+    // Set if the output is aggregated in a BPF map of this name, instead of a perf buffer.
+    std::optional<ir::physical::OutputAggregation> aggregation;
 
     std::string ToString() const {
-      return absl::Substitute("[name=$0 Output struct=$1]", name, output.DebugString());
+      return absl::Substitute("[name=$0 Output struct=$1 aggregation=$2]", name,
+                              output.DebugString(),
+                              aggregation.has_value() ? aggregation->ShortDebugString() : "none");
     }
   };
 
@@ -45,7 +45,13 @@ Status JVMStatsConnector::InitImpl() {
 
 void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   const auto& proc_parser = system::ProcParser(system::Config::GetInstance());
-  proc_tracker_.Update(ctx.GetUPIDs());
+  proc_tracker_.Update(ctx.GetUPIDs(), ctx.proc_events());
+
+  // The hsperfdata file stays mapped after the process exits, so stop monitoring exited processes
+  // explicitly instead of waiting for the reads to fail.
+  for (const auto& upid : proc_tracker_.deleted_upids()) {
+    java_procs_.erase(upid);
+  }
 
   for (const auto& upid : proc_tracker_.new_upids()) {
     // The host PID 1 is not a Java app. However, when later invoking HsperfdataPath(), it could be
@@ -65,21 +71,24 @@ void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   }
 }
 
-Status JVMStatsConnector::ExportStats(const md::UPID& upid,
-                                      const std::filesystem::path& hsperf_data_path,
-                                      DataTable* data_table) const {
-  PL_ASSIGN_OR_RETURN(std::string hsperf_data_str, ReadFileToString(hsperf_data_path));
-
-  if (hsperf_data_str.empty()) {
-    // Assume this is a transient failure.
-    return Status::OK();
+Status JVMStatsConnector::ExportStats(const md::UPID& upid, JavaProcInfo* java_proc,
+                                      DataTable* data_table) {
+  if (java_proc->hsperf_data_reader == nullptr) {
+    auto reader_or = java::HsperfdataReader::Create(java_proc->hsperf_data_path);
+    if (error::IsResourceUnavailable(reader_or.status())) {
+      // Assume this is a transient failure.
+      return Status::OK();
+    }
+    PL_ASSIGN_OR_RETURN(java_proc->hsperf_data_reader, std::move(reader_or));
   }
 
-  java::Stats stats(std::move(hsperf_data_str));
-  if (!stats.Parse().ok()) {
-    // Assumes this is a transient failure.
+  auto stats_or = java_proc->hsperf_data_reader->ReadStats();
+  if (!stats_or.ok()) {
+    // Assumes this is a transient failure, the file is mapped again on the next sample.
+    java_proc->hsperf_data_reader.reset();
     return Status::OK();
   }
+  const java::Stats& stats = stats_or.ValueOrDie();
 
   uint64_t time = AdjustedSteadyClockNowNS();
 
@@ -111,7 +120,7 @@ void JVMStatsConnector::TransferDataImpl(ConnectorContext* ctx,
     JavaProcInfo& java_proc = iter->second;
 
     md::UPID upid_with_asid(ctx->GetASID(), upid.pid(), upid.start_ts());
-    auto status = ExportStats(upid_with_asid, java_proc.hsperf_data_path, data_table);
+    auto status = ExportStats(upid_with_asid, &java_proc, data_table);
     if (!status.ok()) {
       ++java_proc.export_failure_count;
     }
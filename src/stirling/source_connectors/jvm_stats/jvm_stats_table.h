@@ -57,11 +57,20 @@ constexpr DataElement kJVMStatsElements[] = {
          types::PatternType::METRIC_GAUGE},
 };
 
+// JVM stats are sampled once per Java process per sampling period, so there is never a burst to
+// push early; the push period alone decides when the records go out.
+constexpr DataTablePushPolicy kJVMStatsPushPolicy = {
+        .max_records = 0,
+        .max_bytes = 0,
+        .max_age = std::chrono::milliseconds{0},
+};
+
 constexpr DataTableSchema kJVMStatsTable(
         "jvm_stats",
         "Basic JVM memory management metrics for java processes. Includes information about "
         "memory use and garbage collection.",
-        kJVMStatsElements
+        kJVMStatsElements,
+        kJVMStatsPushPolicy
 );
 DEFINE_PRINT_TABLE(JVMStats);
 
@@ -18,14 +18,24 @@
 
 #include "src/stirling/source_connectors/jvm_stats/utils/java.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <absl/strings/match.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "src/common/base/byte_utils.h"
+#include "src/common/base/defer.h"
 #include "src/common/base/statusor.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/proc_parser.h"
@@ -58,33 +68,48 @@ Status Stats::Parse() {
   return Status::OK();
 }
 
-uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix("gc.collector.0.time"); }
+namespace {
+
+constexpr std::string_view kYoungGCTimeSuffix = "gc.collector.0.time";
+constexpr std::string_view kFullGCTimeSuffix = "gc.collector.1.time";
+const std::vector<std::string_view> kUsedHeapSizeSuffixes = {
+    "gc.generation.0.space.0.used",
+    "gc.generation.0.space.1.used",
+    "gc.generation.0.space.2.used",
+    "gc.generation.1.space.0.used",
+};
+const std::vector<std::string_view> kTotalHeapSizeSuffixes = {
+    "gc.generation.0.space.0.capacity",
+    "gc.generation.0.space.1.capacity",
+    "gc.generation.0.space.2.capacity",
+    "gc.generation.1.space.0.capacity",
+};
+const std::vector<std::string_view> kMaxHeapSizeSuffixes = {
+    "gc.generation.0.maxCapacity",
+    "gc.generation.1.maxCapacity",
+};
+
+bool EndsWithAny(std::string_view name, const std::vector<std::string_view>& suffixes) {
+  return std::any_of(suffixes.begin(), suffixes.end(),
+                     [name](std::string_view suffix) { return absl::EndsWith(name, suffix); });
+}
 
-uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix("gc.collector.1.time"); }
+}  // namespace
 
-uint64_t Stats::UsedHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.used",
-      "gc.generation.0.space.1.used",
-      "gc.generation.0.space.2.used",
-      "gc.generation.1.space.0.used",
-  });
-}
+uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix(kYoungGCTimeSuffix); }
 
-uint64_t Stats::TotalHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.capacity",
-      "gc.generation.0.space.1.capacity",
-      "gc.generation.0.space.2.capacity",
-      "gc.generation.1.space.0.capacity",
-  });
-}
+uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix(kFullGCTimeSuffix); }
 
-uint64_t Stats::MaxHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.maxCapacity",
-      "gc.generation.1.maxCapacity",
-  });
+uint64_t Stats::UsedHeapSizeBytes() const { return SumStatsForSuffixes(kUsedHeapSizeSuffixes); }
+
+uint64_t Stats::TotalHeapSizeBytes() const { return SumStatsForSuffixes(kTotalHeapSizeSuffixes); }
+
+uint64_t Stats::MaxHeapSizeBytes() const { return SumStatsForSuffixes(kMaxHeapSizeSuffixes); }
+
+bool Stats::IsUsedStat(std::string_view name) {
+  return absl::EndsWith(name, kYoungGCTimeSuffix) || absl::EndsWith(name, kFullGCTimeSuffix) ||
+         EndsWithAny(name, kUsedHeapSizeSuffixes) || EndsWithAny(name, kTotalHeapSizeSuffixes) ||
+         EndsWithAny(name, kMaxHeapSizeSuffixes);
 }
 
 uint64_t Stats::StatForSuffix(std::string_view suffix) const {
@@ -104,6 +129,77 @@ uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixe
   return sum;
 }
 
+StatusOr<std::unique_ptr<HsperfdataReader>> HsperfdataReader::Create(
+    const std::filesystem::path& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open $0 [errno=$1]", path.string(), errno);
+  }
+  DEFER(close(fd));
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return error::Internal("Failed to stat $0 [errno=$1]", path.string(), errno);
+  }
+  if (st.st_size < static_cast<off_t>(sizeof(hsperf::Prologue))) {
+    return error::ResourceUnavailable("$0 is not fully created yet", path.string());
+  }
+
+  // The JVM sizes the file when creating it, and doesn't truncate it afterwards, so the whole
+  // mapping stays readable until it's unmapped.
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to mmap $0 [errno=$1]", path.string(), errno);
+  }
+
+  auto reader = std::unique_ptr<HsperfdataReader>(
+      new HsperfdataReader(static_cast<const uint8_t*>(data), st.st_size));
+  Status s = reader->IndexCounters();
+  if (!s.ok()) {
+    // The JVM writes the prologue after creating the file.
+    return error::ResourceUnavailable("$0 is not initialized yet: $1", path.string(), s.msg());
+  }
+  return reader;
+}
+
+HsperfdataReader::~HsperfdataReader() { munmap(const_cast<uint8_t*>(data_), size_); }
+
+Status HsperfdataReader::IndexCounters() {
+  // Copy the file out of the mapping, so that the JVM doesn't change it while it's parsed.
+  std::string buf(reinterpret_cast<const char*>(data_), size_);
+  hsperf::HsperfData hsperf_data = {};
+  PL_RETURN_IF_ERROR(ParseHsperfData(buf, &hsperf_data));
+
+  counters_.clear();
+  for (const auto& entry : hsperf_data.data_entries) {
+    if (entry.header->data_type != static_cast<uint8_t>(hsperf::DataType::kLong) ||
+        !Stats::IsUsedStat(entry.name)) {
+      continue;
+    }
+    size_t data_offset = entry.data.data() - buf.data();
+    counters_.push_back({std::string(entry.name), data_offset});
+  }
+  num_entries_ = hsperf_data.prologue->num_entries;
+  return Status::OK();
+}
+
+StatusOr<Stats> HsperfdataReader::ReadStats() {
+  uint32_t num_entries;
+  std::memcpy(&num_entries, data_ + offsetof(hsperf::Prologue, num_entries), sizeof(num_entries));
+  if (num_entries != num_entries_) {
+    PL_RETURN_IF_ERROR(IndexCounters());
+  }
+
+  std::vector<Stats::Stat> stats;
+  stats.reserve(counters_.size());
+  for (const auto& counter : counters_) {
+    uint64_t value;
+    std::memcpy(&value, data_ + counter.data_offset, sizeof(value));
+    stats.push_back({counter.name, value});
+  }
+  return Stats(std::move(stats));
+}
+
 StatusOr<std::filesystem::path> HsperfdataPath(pid_t pid) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const std::filesystem::path& host_path = sysconfig.host_path();
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -56,6 +57,11 @@ class Stats {
   uint64_t TotalHeapSizeBytes() const;
   uint64_t MaxHeapSizeBytes() const;
 
+  /**
+   * Returns true if the stat of the name is used by any of the above.
+   */
+  static bool IsUsedStat(std::string_view name);
+
  private:
   uint64_t StatForSuffix(std::string_view suffix) const;
   uint64_t SumStatsForSuffixes(const std::vector<std::string_view>& suffixes) const;
@@ -64,6 +70,48 @@ class Stats {
   std::vector<Stat> stats_;
 };
 
+/**
+ * HsperfdataReader keeps the hsperfdata file of a JVM memory-mapped, and reads Stats from it
+ * without re-reading and re-parsing the file. The file is parsed once to find the offsets of the
+ * counters that Stats uses, and each read only copies those counters out of the mapping.
+ *
+ * The JVM adds entries to the file as it runs, so the entries are indexed again whenever their
+ * number changes.
+ */
+class HsperfdataReader {
+ public:
+  /**
+   * Maps the hsperfdata file at the path, and indexes its counters.
+   */
+  static StatusOr<std::unique_ptr<HsperfdataReader>> Create(const std::filesystem::path& path);
+
+  ~HsperfdataReader();
+
+  /**
+   * Returns the current values of the counters. The names of the returned stats refer to the
+   * reader, so they are only valid until the next call.
+   */
+  StatusOr<Stats> ReadStats();
+
+ private:
+  HsperfdataReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  // Finds the offsets of the counters used by Stats.
+  Status IndexCounters();
+
+  struct Counter {
+    std::string name;
+    size_t data_offset;
+  };
+
+  const uint8_t* data_;
+  size_t size_;
+
+  // The number of entries in the file when the counters were indexed.
+  uint32_t num_entries_ = 0;
+  std::vector<Counter> counters_;
+};
+
 /**
  * Returns the path of the hsperfdata for a JVM process.
  */
@@ -22,11 +22,14 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include <absl/strings/match.h>
 
+#include "src/common/base/file.h"
 #include "src/common/base/test_utils.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/testing/test_environment.h"
@@ -59,6 +62,31 @@ TEST(StatsTest, CommonValues) {
   EXPECT_EQ(2, stats.MaxHeapSizeBytes());
 }
 
+// Tests that the reader produces the same stats as parsing the whole file.
+TEST(HsperfdataReaderTest, MatchesParsedStats) {
+  const std::string hsperfdata_path =
+      testing::TestFilePath("src/stirling/source_connectors/jvm_stats/utils/test_hsperfdata");
+  ASSERT_OK_AND_ASSIGN(std::string hsperf_data_str, ReadFileToString(hsperfdata_path));
+  Stats parsed_stats(std::move(hsperf_data_str));
+  ASSERT_OK(parsed_stats.Parse());
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<HsperfdataReader> reader,
+                       HsperfdataReader::Create(hsperfdata_path));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(Stats stats, reader->ReadStats());
+    EXPECT_EQ(parsed_stats.YoungGCTimeNanos(), stats.YoungGCTimeNanos());
+    EXPECT_EQ(parsed_stats.FullGCTimeNanos(), stats.FullGCTimeNanos());
+    EXPECT_EQ(parsed_stats.UsedHeapSizeBytes(), stats.UsedHeapSizeBytes());
+    EXPECT_EQ(parsed_stats.TotalHeapSizeBytes(), stats.TotalHeapSizeBytes());
+    EXPECT_EQ(parsed_stats.MaxHeapSizeBytes(), stats.MaxHeapSizeBytes());
+  }
+  EXPECT_NE(0, parsed_stats.MaxHeapSizeBytes());
+}
+
+TEST(HsperfdataReaderTest, MissingFile) {
+  EXPECT_NOT_OK(HsperfdataReader::Create("/tmp/not_a_hsperfdata_file"));
+}
+
 TEST(HsperfdataPathTest, ResultIsAsExpected) {
   const char kClassPath[] = "src/stirling/source_connectors/jvm_stats/testing/HelloWorld.jar";
   const std::string class_path = testing::TestFilePath(kClassPath);
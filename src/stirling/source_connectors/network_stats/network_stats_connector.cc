@@ -23,8 +23,11 @@
 #include <iostream>
 #include <string>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/proc_parser.h"
+#include "src/common/system/socket_info.h"
 #include "src/shared/metadata/metadata.h"
 
 namespace px {
@@ -35,10 +38,15 @@ using system::ProcParser;
 Status NetworkStatsConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+  // Entering the network namespaces of the pods requires root.
+  use_netlink_ = IsRoot();
   return Status::OK();
 }
 
-Status NetworkStatsConnector::StopImpl() { return Status::OK(); }
+Status NetworkStatsConnector::StopImpl() {
+  net_dev_probers_.clear();
+  return Status::OK();
+}
 
 void NetworkStatsConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
@@ -55,6 +63,10 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
 
   int64_t timestamp = AdjustedSteadyClockNowNS();
 
+  // The stats of each network namespace are collected once per sample, and shared by all the pods
+  // in the namespace (e.g. the pods on the host network).
+  absl::flat_hash_map<uint32_t, StatusOr<ProcParser::NetworkStats>> stats_by_net_ns;
+
   for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
     PL_UNUSED(pod_name);
 
@@ -65,7 +77,7 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
     }
 
     ProcParser::NetworkStats stats;
-    auto s = GetNetworkStatsForPod(*proc_parser_, *pod_info, k8s_md, &stats);
+    auto s = GetNetworkStatsForPod(*pod_info, k8s_md, &stats_by_net_ns, &stats);
 
     if (!s.ok()) {
       VLOG(1) << absl::StrCat("Failed to get Pod network stats: ", s.msg());
@@ -85,19 +97,60 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
     r.Append<r.ColIndex("tx_errors")>(stats.tx_errs);
     r.Append<r.ColIndex("tx_drops")>(stats.tx_drops);
   }
+
+  // Drop the probers of namespaces that no longer have a live pod.
+  for (auto iter = net_dev_probers_.begin(); iter != net_dev_probers_.end();) {
+    if (stats_by_net_ns.contains(iter->first)) {
+      ++iter;
+    } else {
+      net_dev_probers_.erase(iter++);
+    }
+  }
+}
+
+StatusOr<ProcParser::NetworkStats> NetworkStatsConnector::GetNetworkStatsForNetNamespace(
+    uint32_t net_ns, int32_t pid) {
+  ProcParser::NetworkStats stats;
+
+  if (use_netlink_) {
+    auto iter = net_dev_probers_.find(net_ns);
+    if (iter == net_dev_probers_.end()) {
+      auto prober_or = system::NetDevStatsProber::Create(pid);
+      if (prober_or.ok()) {
+        iter = net_dev_probers_.emplace(net_ns, prober_or.ConsumeValueOrDie()).first;
+      } else {
+        VLOG(1) << absl::Substitute("Failed to create net dev prober for net_ns=$0: $1", net_ns,
+                                    prober_or.msg());
+      }
+    }
+    if (iter != net_dev_probers_.end()) {
+      Status s = iter->second->NetworkStats(&stats);
+      if (s.ok()) {
+        return stats;
+      }
+      VLOG(1) << absl::Substitute("Failed to probe net dev stats for net_ns=$0: $1", net_ns,
+                                  s.msg());
+      net_dev_probers_.erase(iter);
+      stats.Clear();
+    }
+  }
+
+  // Fall back to the file of the process, when the namespace can't be entered.
+  PL_RETURN_IF_ERROR(proc_parser_->ParseProcPIDNetDev(pid, &stats));
+  return stats;
 }
 
-Status NetworkStatsConnector::GetNetworkStatsForPod(const system::ProcParser& proc_parser,
-                                                    const md::PodInfo& pod_info,
-                                                    const md::K8sMetadataState& k8s_metadata_state,
-                                                    system::ProcParser::NetworkStats* stats) {
+Status NetworkStatsConnector::GetNetworkStatsForPod(
+    const md::PodInfo& pod_info, const md::K8sMetadataState& k8s_metadata_state,
+    absl::flat_hash_map<uint32_t, StatusOr<ProcParser::NetworkStats>>* stats_by_net_ns,
+    ProcParser::NetworkStats* stats) {
   DCHECK(stats != nullptr);
   // Since all the containers running in a K8s pod use the same network
   // namespace, we only need to pull stats from a single PID. The stats
   // themselves are the same for each PID since Linux only tracks networks
   // stats at a namespace level.
   //
-  // In case the read fails we try another file. This should not normally
+  // In case the read fails we try another PID. This should not normally
   // be required, but will make the code more robust to cases where the PID
   // is killed between when we update the pid list but before the network
   // data is requested.
@@ -110,13 +163,27 @@ Status NetworkStatsConnector::GetNetworkStatsForPod(const system::ProcParser& pr
     }
 
     for (const auto& upid : container_info->active_upids()) {
-      auto s = proc_parser.ParseProcPIDNetDev(upid.pid(), stats);
-      if (s.ok()) {
-        // Since we just need to read one pid, we can bail on the first successful read.
-        return s;
+      StatusOr<uint32_t> net_ns = system::NetNamespace(sysconfig_.proc_path(), upid.pid());
+      if (!net_ns.ok()) {
+        VLOG(1) << absl::Substitute("Failed to read network namespace for pod=$0, using upid=$1",
+                                    pod_info.uid(), upid.String());
+        continue;
+      }
+
+      auto iter = stats_by_net_ns->find(net_ns.ValueOrDie());
+      if (iter == stats_by_net_ns->end()) {
+        iter = stats_by_net_ns
+                   ->emplace(net_ns.ValueOrDie(),
+                             GetNetworkStatsForNetNamespace(net_ns.ValueOrDie(), upid.pid()))
+                   .first;
+      }
+      if (iter->second.ok()) {
+        // Since we just need to read one namespace, we can bail on the first successful read.
+        *stats = iter->second.ValueOrDie();
+        return Status::OK();
       }
       VLOG(1) << absl::Substitute("Failed to read network stats for pod=$0, using upid=$1",
-                                  upid.String(), pod_info.uid());
+                                  pod_info.uid(), upid.String());
     }
   }
 
@@ -24,7 +24,10 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
+#include "src/common/system/net_dev_stats.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
 #include "src/stirling/core/canonical_types.h"
@@ -64,12 +67,25 @@ class NetworkStatsConnector : public SourceConnector {
  private:
   void TransferNetworkStatsTable(ConnectorContext* ctx, DataTable* data_table);
 
-  static Status GetNetworkStatsForPod(const system::ProcParser& proc_parser,
-                                      const md::PodInfo& pod_info,
-                                      const md::K8sMetadataState& k8s_metadata_state,
-                                      system::ProcParser::NetworkStats* stats);
+  // Returns the stats of the network namespace, read with the net dev prober of the namespace,
+  // or from /proc/<pid>/net/dev if the namespace can't be probed.
+  StatusOr<system::ProcParser::NetworkStats> GetNetworkStatsForNetNamespace(uint32_t net_ns,
+                                                                            int32_t pid);
+
+  // Returns the stats of the network namespace of the pod. The stats are looked up in, or added
+  // to, stats_by_net_ns, so that each namespace is read once per sample.
+  Status GetNetworkStatsForPod(
+      const md::PodInfo& pod_info, const md::K8sMetadataState& k8s_metadata_state,
+      absl::flat_hash_map<uint32_t, StatusOr<system::ProcParser::NetworkStats>>* stats_by_net_ns,
+      system::ProcParser::NetworkStats* stats);
 
   std::unique_ptr<system::ProcParser> proc_parser_;
+
+  // Whether the stats are read through netlink, from within the network namespaces.
+  bool use_netlink_ = false;
+
+  // Net dev probers by network namespace inode number.
+  absl::flat_hash_map<uint32_t, std::unique_ptr<system::NetDevStatsProber>> net_dev_probers_;
 };
 
 }  // namespace stirling
@@ -89,11 +89,30 @@ BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 // See comments in shared header file "stack_event.h".
 BPF_ARRAY(profiler_state, uint64_t, kProfilerStateVectorSize);
 
+// Per-CPU count of sampling events, for keeping only one out of every "sample stride" events.
+// The sample stride is set by user space to hold the cost of the profiler within a budget.
+// The maps above are sized for a stride of 1, so a larger stride only lowers their occupancy.
+BPF_PERCPU_ARRAY(sampling_events, uint64_t, 1);
+
 int sample_call_stack(struct bpf_perf_event_data* ctx) {
   int transfer_count_idx = kTransferCountIdx;
   int sample_count_a_idx = kSampleCountAIdx;
   int sample_count_b_idx = kSampleCountAIdx;
   int error_status_idx = kErrorStatusIdx;
+  int sample_stride_idx = kSampleStrideIdx;
+
+  uint64_t* sample_stride_ptr = profiler_state.lookup(&sample_stride_idx);
+  if (sample_stride_ptr != NULL && *sample_stride_ptr > 1) {
+    int kZero = 0;
+    uint64_t* sampling_events_ptr = sampling_events.lookup(&kZero);
+    if (sampling_events_ptr != NULL) {
+      uint64_t sampling_event = *sampling_events_ptr;
+      *sampling_events_ptr += 1;
+      if (sampling_event % *sample_stride_ptr != 0) {
+        return 0;
+      }
+    }
+  }
 
   uint64_t* transfer_count_ptr = profiler_state.lookup(&transfer_count_idx);
   uint64_t* sample_count_a_ptr = profiler_state.lookup(&sample_count_a_idx);
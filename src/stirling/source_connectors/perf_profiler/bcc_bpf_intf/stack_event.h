@@ -27,12 +27,14 @@
 // profiler_state[1]: sample count A          # updated on BPF side, reset on user side
 // profiler_state[2]: sample count B          # updated on BPF side, reset on user side
 // profiler_state[3]: error status bitfield   # written on BPF side, read on user side
+// profiler_state[4]: sample stride           # written on user side, read on BPF side
 // TODO(jps): Consider switching to a C-style enum.
 static const uint32_t kTransferCountIdx = 0;
 static const uint32_t kSampleCountAIdx = 1;
 static const uint32_t kSampleCountBIdx = 2;
 static const uint32_t kErrorStatusIdx = 3;
-static const uint32_t kProfilerStateVectorSize = 4;
+static const uint32_t kSampleStrideIdx = 4;
+static const uint32_t kProfilerStateVectorSize = 5;
 
 // stack_trace_key_t indexes into the stack-trace histogram.
 // By tying together the user & kernel stack-trace-ids [1],
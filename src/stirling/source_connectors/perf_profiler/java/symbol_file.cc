@@ -0,0 +1,239 @@
+/*
+ * Copyright © 2018- Pixie Labs Inc.
+ * Copyright © 2020- New Relic, Inc.
+ * All Rights Reserved.
+ *
+ * NOTICE:  All information contained herein is, and remains
+ * the property of New Relic Inc. and its suppliers,
+ * if any.  The intellectual and technical concepts contained
+ * herein are proprietary to Pixie Labs Inc. and its suppliers and
+ * may be covered by U.S. and Foreign Patents, patents in process,
+ * and are protected by trade secret or copyright law. Dissemination
+ * of this information or reproduction of this material is strictly
+ * forbidden unless prior written permission is obtained from
+ * New Relic, Inc.
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include "src/stirling/source_connectors/perf_profiler/java/symbol_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include "src/stirling/source_connectors/perf_profiler/java/agent/raw_symbol_update.h"
+#include "src/stirling/source_connectors/perf_profiler/java/demangle.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+StatusOr<std::unique_ptr<JavaSymbolFile>> JavaSymbolFile::Create(
+    const std::filesystem::path& path) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Could not open Java symbol file $0 [errno=$1].", path.string(), errno);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return error::Internal("Could not stat Java symbol file $0 [errno=$1].", path.string(), errno);
+  }
+  return std::unique_ptr<JavaSymbolFile>(new JavaSymbolFile(path, fd, st.st_dev, st.st_ino));
+}
+
+JavaSymbolFile::~JavaSymbolFile() { close(fd_); }
+
+Status JavaSymbolFile::ReopenIfReplaced() {
+  struct stat st;
+  if (stat(path_.c_str(), &st) != 0) {
+    // The file was removed (or is being replaced): keep reading the open one.
+    return Status::OK();
+  }
+  if (st.st_dev == dev_ && st.st_ino == ino_) {
+    return Status::OK();
+  }
+
+  const int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Could not open Java symbol file $0 [errno=$1].", path_.string(), errno);
+  }
+  // Identify the file that was opened, in case it was replaced again since the stat() above.
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return error::Internal("Could not stat Java symbol file $0 [errno=$1].", path_.string(), errno);
+  }
+  close(fd_);
+  fd_ = fd;
+  dev_ = st.st_dev;
+  ino_ = st.st_ino;
+  Reset();
+  return Status::OK();
+}
+
+StatusOr<bool> JavaSymbolFile::IsTruncated(uint64_t file_size) const {
+  if (file_size < read_offset_) {
+    return true;
+  }
+  if (last_record_.empty()) {
+    return false;
+  }
+  // The agent truncates the file when it is attached again, and then writes all the records
+  // again, which may have taken the file past read_offset_ by now.
+  PL_ASSIGN_OR_RETURN(std::string last_record,
+                      ReadAt(read_offset_ - last_record_.size(), last_record_.size()));
+  return last_record != last_record_;
+}
+
+StatusOr<std::string> JavaSymbolFile::ReadAt(uint64_t offset, uint64_t size) const {
+  std::string buf(size, '\0');
+  size_t num_read = 0;
+  while (num_read < buf.size()) {
+    const ssize_t n = pread(fd_, buf.data() + num_read, buf.size() - num_read, offset + num_read);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return error::Internal("Could not read Java symbol file $0 [errno=$1].", path_.string(),
+                             errno);
+    }
+    if (n == 0) {
+      break;
+    }
+    num_read += n;
+  }
+  buf.resize(num_read);
+  return buf;
+}
+
+void JavaSymbolFile::Reset() {
+  read_offset_ = 0;
+  last_record_.clear();
+  code_ranges_.clear();
+}
+
+Status JavaSymbolFile::Update() {
+  PL_RETURN_IF_ERROR(ReopenIfReplaced());
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    return error::Internal("Could not stat Java symbol file $0 [errno=$1].", path_.string(), errno);
+  }
+  const uint64_t file_size = st.st_size;
+  PL_ASSIGN_OR_RETURN(bool truncated, IsTruncated(file_size));
+  if (truncated) {
+    Reset();
+  }
+  if (file_size <= read_offset_) {
+    return Status::OK();
+  }
+
+  PL_ASSIGN_OR_RETURN(std::string buf, ReadAt(read_offset_, file_size - read_offset_));
+  std::string_view data = buf;
+  std::string_view last_record;
+  while (data.size() >= sizeof(JavaRawSymbolUpdate)) {
+    JavaRawSymbolUpdate update;
+    memcpy(&update, data.data(), sizeof(update));
+
+    const uint64_t record_size = sizeof(update) + update.TotalNumSymbolBytes();
+    if (data.size() < record_size) {
+      // The agent is still writing this record.
+      break;
+    }
+
+    if (update.IsMethodUnload()) {
+      RemoveCodeRange(update.addr);
+    } else {
+      // The sizes of the strings include their null terminators.
+      std::string_view symbols = data.substr(sizeof(update), update.TotalNumSymbolBytes());
+      auto get_str = [&symbols](uint64_t offset, uint64_t size) {
+        return size == 0 ? std::string_view() : symbols.substr(offset, size - 1);
+      };
+      const std::string_view symbol = get_str(update.SymbolOffset(), update.symbol_size);
+      const std::string_view fn_sig = get_str(update.FnSigOffset(), update.fn_sig_size);
+      const std::string_view class_sig = get_str(update.ClassSigOffset(), update.class_sig_size);
+      AddCodeRange(update.addr, update.code_size, Demangle(std::string(symbol), class_sig, fn_sig));
+    }
+
+    last_record = data.substr(0, record_size);
+    data.remove_prefix(record_size);
+    read_offset_ += record_size;
+  }
+  if (!last_record.empty()) {
+    last_record_ = std::string(last_record);
+  }
+  return Status::OK();
+}
+
+void JavaSymbolFile::AddCodeRange(uint64_t addr, uint64_t size, std::string symbol) {
+  if (size == 0) {
+    return;
+  }
+
+  // Remove the ranges that the new range overlaps; their code was replaced.
+  auto iter = code_ranges_.upper_bound(addr);
+  if (iter != code_ranges_.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->first + prev->second.size > addr) {
+      iter = prev;
+    }
+  }
+  while (iter != code_ranges_.end() && iter->first < addr + size) {
+    iter = code_ranges_.erase(iter);
+  }
+
+  code_ranges_.emplace(addr, CodeRange{size, std::move(symbol)});
+}
+
+void JavaSymbolFile::RemoveCodeRange(uint64_t addr) { code_ranges_.erase(addr); }
+
+const std::string* JavaSymbolFile::Lookup(uint64_t addr) const {
+  auto iter = code_ranges_.upper_bound(addr);
+  if (iter == code_ranges_.begin()) {
+    return nullptr;
+  }
+  --iter;
+  if (addr < iter->first + iter->second.size) {
+    return &iter->second.symbol;
+  }
+  return nullptr;
+}
+
+StatusOr<std::shared_ptr<JavaSymbolFile>> JavaSymbolFileCache::Get(
+    const std::filesystem::path& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return error::Internal("Could not stat Java symbol file $0 [errno=$1].", path.string(), errno);
+  }
+
+  const std::pair<dev_t, ino_t> key = {st.st_dev, st.st_ino};
+  std::shared_ptr<JavaSymbolFile>& file = files_[key];
+  if (file == nullptr) {
+    StatusOr<std::unique_ptr<JavaSymbolFile>> file_or = JavaSymbolFile::Create(path);
+    if (!file_or.ok()) {
+      files_.erase(key);
+      return file_or.status();
+    }
+    file = file_or.ConsumeValueOrDie();
+  }
+  PL_RETURN_IF_ERROR(file->Update());
+  return file;
+}
+
+void JavaSymbolFileCache::EvictUnused() {
+  for (auto iter = files_.begin(); iter != files_.end();) {
+    if (iter->second.use_count() == 1) {
+      files_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
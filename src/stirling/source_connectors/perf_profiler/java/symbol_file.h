@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2018- Pixie Labs Inc.
+ * Copyright © 2020- New Relic, Inc.
+ * All Rights Reserved.
+ *
+ * NOTICE:  All information contained herein is, and remains
+ * the property of New Relic Inc. and its suppliers,
+ * if any.  The intellectual and technical concepts contained
+ * herein are proprietary to Pixie Labs Inc. and its suppliers and
+ * may be covered by U.S. and Foreign Patents, patents in process,
+ * and are protected by trade secret or copyright law. Dissemination
+ * of this information or reproduction of this material is strictly
+ * forbidden unless prior written permission is obtained from
+ * New Relic, Inc.
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#pragma once
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <absl/container/btree_map.h>
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+/**
+ * JavaSymbolFile follows the binary symbol file that the Java agent writes for a JVM,
+ * and maps addresses of JIT compiled code to demangled Java symbols.
+ *
+ * The agent appends to the file, so each call to Update() reads and parses just the bytes added
+ * since the previous call. A record that is still being written at the end of the file is left
+ * for the next call.
+ *
+ * The file starts over when the agent is attached again, which truncates it, or when another
+ * file replaces it at the same path (e.g. a new JVM with the same PID). Update() then drops what
+ * it read and reads the new contents from the start.
+ *
+ * The code ranges are kept in an interval map of non-overlapping ranges, keyed by start address:
+ * a method that is loaded over the range of an older method replaces it, and unloaded methods
+ * are removed.
+ */
+class JavaSymbolFile : public NotCopyMoveable {
+ public:
+  static StatusOr<std::unique_ptr<JavaSymbolFile>> Create(const std::filesystem::path& path);
+
+  ~JavaSymbolFile();
+
+  /**
+   * Reads the records that were appended since the last call, or all the records if the file
+   * started over.
+   */
+  Status Update();
+
+  /**
+   * Returns the symbol of the JIT code that covers the address, or nullptr.
+   */
+  const std::string* Lookup(uint64_t addr) const;
+
+  size_t num_code_ranges() const { return code_ranges_.size(); }
+  uint64_t read_offset() const { return read_offset_; }
+
+  // Identifies the file that is read, as long as it exists (or is open).
+  dev_t dev() const { return dev_; }
+  ino_t ino() const { return ino_; }
+
+ private:
+  struct CodeRange {
+    uint64_t size;
+    std::string symbol;
+  };
+
+  JavaSymbolFile(std::filesystem::path path, int fd, dev_t dev, ino_t ino)
+      : path_(std::move(path)), fd_(fd), dev_(dev), ino_(ino) {}
+
+  // Opens the file at the path, if it is no longer the one that is read.
+  Status ReopenIfReplaced();
+
+  // Returns true if the bytes that were read last are no longer in the file.
+  StatusOr<bool> IsTruncated(uint64_t file_size) const;
+
+  StatusOr<std::string> ReadAt(uint64_t offset, uint64_t size) const;
+
+  // Forgets what was read, so that the file is read again from the start.
+  void Reset();
+
+  void AddCodeRange(uint64_t addr, uint64_t size, std::string symbol);
+  void RemoveCodeRange(uint64_t addr);
+
+  const std::filesystem::path path_;
+
+  // Kept open, so that the file identity stays valid and no bytes are read twice.
+  int fd_;
+  dev_t dev_;
+  ino_t ino_;
+
+  uint64_t read_offset_ = 0;
+
+  // The last record that was read, which ends at read_offset_. A file that was truncated and then
+  // rewritten past read_offset_ is unlikely to have the same bytes there.
+  std::string last_record_;
+
+  // Key is the start address of the range.
+  absl::btree_map<uint64_t, CodeRange> code_ranges_;
+};
+
+/**
+ * JavaSymbolFileCache shares the symbol files that were already read, so that a process whose
+ * symbol file has the same identity (device & inode) as one that was read before, e.g. after the
+ * process was re-discovered, continues from the previous offset instead of re-reading the file.
+ * A file that replaces another one at the same path has a new identity, so it gets its own reader.
+ */
+class JavaSymbolFileCache {
+ public:
+  /**
+   * Returns the symbol file at the path, brought up to date.
+   */
+  StatusOr<std::shared_ptr<JavaSymbolFile>> Get(const std::filesystem::path& path);
+
+  /**
+   * Drops the files that are no longer used by anyone but the cache.
+   */
+  void EvictUnused();
+
+  size_t size() const { return files_.size(); }
+
+ private:
+  absl::flat_hash_map<std::pair<dev_t, ino_t>, std::shared_ptr<JavaSymbolFile>> files_;
+};
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,235 @@
+/*
+ * Copyright © 2018- Pixie Labs Inc.
+ * Copyright © 2020- New Relic, Inc.
+ * All Rights Reserved.
+ *
+ * NOTICE:  All information contained herein is, and remains
+ * the property of New Relic Inc. and its suppliers,
+ * if any.  The intellectual and technical concepts contained
+ * herein are proprietary to Pixie Labs Inc. and its suppliers and
+ * may be covered by U.S. and Foreign Patents, patents in process,
+ * and are protected by trade secret or copyright law. Dissemination
+ * of this information or reproduction of this material is strictly
+ * forbidden unless prior written permission is obtained from
+ * New Relic, Inc.
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/common/base/file.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/perf_profiler/java/agent/raw_symbol_update.h"
+#include "src/stirling/source_connectors/perf_profiler/java/symbol_file.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+using ::px::testing::TempDir;
+
+// Encodes a record the same way as WriteSymbol() in the agent.
+std::string SymbolRecord(uint64_t addr, uint64_t code_size, std::string_view symbol,
+                         std::string_view fn_sig, std::string_view class_sig,
+                         bool method_unload = false) {
+  JavaRawSymbolUpdate update = {.addr = addr,
+                                .code_size = code_size,
+                                .symbol_size = 1 + symbol.size(),
+                                .fn_sig_size = 1 + fn_sig.size(),
+                                .class_sig_size = 1 + class_sig.size(),
+                                .method_unload = method_unload};
+  std::string record(reinterpret_cast<const char*>(&update), sizeof(update));
+  for (std::string_view str : {symbol, fn_sig, class_sig}) {
+    record.append(str);
+    record.push_back('\0');
+  }
+  return record;
+}
+
+std::string UnloadRecord(uint64_t addr) { return SymbolRecord(addr, 0, "", "", "", true); }
+
+void Append(const std::filesystem::path& path, std::string_view data) {
+  ASSERT_OK(WriteFileFromString(path.string(), data, std::ios_base::app | std::ios_base::binary));
+}
+
+// Truncates the file and writes the data, like the agent when it is attached again.
+void Rewrite(const std::filesystem::path& path, std::string_view data) {
+  ASSERT_OK(WriteFileFromString(path.string(), data, std::ios_base::out | std::ios_base::binary));
+}
+
+TEST(JavaSymbolFileTest, IncrementalUpdates) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<JavaSymbolFile> file, JavaSymbolFile::Create(path));
+  ASSERT_OK(file->Update());
+  ASSERT_NE(file->Lookup(0x1080), nullptr);
+  EXPECT_EQ(*file->Lookup(0x1080), "void Foo::Bar(int)");
+  EXPECT_EQ(file->Lookup(0x1100), nullptr);
+  EXPECT_EQ(file->Lookup(0xfff), nullptr);
+
+  // A partially written record is picked up once it is complete.
+  const std::string record = SymbolRecord(0x2000, 0x10, "Interpreter", "", "");
+  Append(path, record.substr(0, 10));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->Lookup(0x2000), nullptr);
+  const uint64_t offset = file->read_offset();
+
+  Append(path, record.substr(10));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->read_offset(), offset + record.size());
+  ASSERT_NE(file->Lookup(0x2000), nullptr);
+  EXPECT_EQ(*file->Lookup(0x2000), "Interpreter");
+  EXPECT_EQ(file->num_code_ranges(), 2);
+}
+
+TEST(JavaSymbolFileTest, UnloadAndReplace) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+  Append(path, SymbolRecord(0x1100, 0x100, "Baz", "()V", "LFoo;"));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<JavaSymbolFile> file, JavaSymbolFile::Create(path));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 2);
+
+  Append(path, UnloadRecord(0x1000));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->Lookup(0x1000), nullptr);
+  EXPECT_NE(file->Lookup(0x1100), nullptr);
+
+  // New code over the range of Baz replaces it.
+  Append(path, SymbolRecord(0x10c0, 0x80, "Qux", "()V", "LFoo;"));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 1);
+  ASSERT_NE(file->Lookup(0x1100), nullptr);
+  EXPECT_EQ(*file->Lookup(0x1100), "void Foo::Qux()");
+}
+
+TEST(JavaSymbolFileTest, Truncated) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+  Append(path, SymbolRecord(0x2000, 0x100, "Baz", "()V", "LFoo;"));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<JavaSymbolFile> file, JavaSymbolFile::Create(path));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 2);
+
+  // The file is shorter than what was read.
+  const std::string record = SymbolRecord(0x3000, 0x100, "Qux", "()V", "LFoo;");
+  Rewrite(path, record);
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->read_offset(), record.size());
+  EXPECT_EQ(file->num_code_ranges(), 1);
+  EXPECT_EQ(file->Lookup(0x1000), nullptr);
+  ASSERT_NE(file->Lookup(0x3000), nullptr);
+  EXPECT_EQ(*file->Lookup(0x3000), "void Foo::Qux()");
+}
+
+TEST(JavaSymbolFileTest, TruncatedAndRewrittenPastReadOffset) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<JavaSymbolFile> file, JavaSymbolFile::Create(path));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 1);
+
+  // By the next update, the new file is already longer than the old one.
+  Rewrite(path, SymbolRecord(0x2000, 0x100, "Baz", "()V", "LFoo;") +
+                    SymbolRecord(0x3000, 0x100, "Qux", "()V", "LFoo;"));
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 2);
+  EXPECT_EQ(file->Lookup(0x1000), nullptr);
+  EXPECT_NE(file->Lookup(0x2000), nullptr);
+  EXPECT_NE(file->Lookup(0x3000), nullptr);
+
+  // Appending after a rewrite reads on from where the rewrite ended.
+  const uint64_t offset = file->read_offset();
+  const std::string record = SymbolRecord(0x4000, 0x100, "Quux", "()V", "LFoo;");
+  Append(path, record);
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->read_offset(), offset + record.size());
+  EXPECT_EQ(file->num_code_ranges(), 3);
+}
+
+TEST(JavaSymbolFileTest, Replaced) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<JavaSymbolFile> file, JavaSymbolFile::Create(path));
+  ASSERT_OK(file->Update());
+  const ino_t ino = file->ino();
+
+  // Move the file away, and write a new one at the same path.
+  std::filesystem::rename(path, temp_dir.path() / "java-symbols.bin.old");
+  Append(path, SymbolRecord(0x2000, 0x100, "Baz", "()V", "LFoo;"));
+  ASSERT_OK(file->Update());
+  EXPECT_NE(file->ino(), ino);
+  EXPECT_EQ(file->num_code_ranges(), 1);
+  EXPECT_EQ(file->Lookup(0x1000), nullptr);
+  ASSERT_NE(file->Lookup(0x2000), nullptr);
+  EXPECT_EQ(*file->Lookup(0x2000), "void Foo::Baz()");
+
+  // Once removed, the open file is still read.
+  std::filesystem::remove(path);
+  ASSERT_OK(file->Update());
+  EXPECT_EQ(file->num_code_ranges(), 1);
+}
+
+TEST(JavaSymbolFileCacheTest, ReusesFilesWithSameIdentity) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  const std::filesystem::path link = temp_dir.path() / "java-symbols-link.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+  std::filesystem::create_hard_link(path, link);
+
+  JavaSymbolFileCache cache;
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<JavaSymbolFile> file1, cache.Get(path));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<JavaSymbolFile> file2, cache.Get(link));
+  EXPECT_EQ(file1, file2);
+  EXPECT_EQ(cache.size(), 1);
+
+  // Each Get() brings the file up to date.
+  Append(path, SymbolRecord(0x2000, 0x100, "Baz", "()V", "LFoo;"));
+  ASSERT_OK_AND_ASSIGN(file2, cache.Get(link));
+  EXPECT_NE(file1->Lookup(0x2000), nullptr);
+
+  cache.EvictUnused();
+  EXPECT_EQ(cache.size(), 1);
+  file1.reset();
+  file2.reset();
+  cache.EvictUnused();
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(JavaSymbolFileCacheTest, ReplacedFile) {
+  TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "java-symbols.bin";
+  Append(path, SymbolRecord(0x1000, 0x100, "Bar", "(I)V", "LFoo;"));
+
+  JavaSymbolFileCache cache;
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<JavaSymbolFile> file1, cache.Get(path));
+
+  std::filesystem::remove(path);
+  Append(path, SymbolRecord(0x2000, 0x100, "Baz", "()V", "LFoo;"));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<JavaSymbolFile> file2, cache.Get(path));
+  EXPECT_NE(file1, file2);
+  EXPECT_EQ(file2->Lookup(0x1000), nullptr);
+  EXPECT_NE(file2->Lookup(0x2000), nullptr);
+
+  file1.reset();
+  cache.EvictUnused();
+  EXPECT_EQ(cache.size(), 1);
+}
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
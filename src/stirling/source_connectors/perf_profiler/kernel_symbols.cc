@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/perf_profiler/kernel_symbols.h"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_split.h>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+bool IsTextSymbol(std::string_view type) {
+  return type == "t" || type == "T" || type == "w" || type == "W";
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<KernelSymbolIndex>> KernelSymbolIndex::Create(std::string_view kallsyms) {
+  auto index = std::unique_ptr<KernelSymbolIndex>(new KernelSymbolIndex());
+  absl::flat_hash_map<std::string_view, uint32_t> name_offsets;
+
+  // Lines look like:
+  //   ffffffffa60b0ee0 T __x64_sys_getpid
+  //   ffffffffc0a1b000 t nf_conntrack_init [nf_conntrack]
+  // The module is dropped; stack traces only show the symbol name.
+  for (std::string_view line : absl::StrSplit(kallsyms, '\n', absl::SkipEmpty())) {
+    std::vector<std::string_view> tokens =
+        absl::StrSplit(line, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    if (tokens.size() < 3 || !IsTextSymbol(tokens[1])) {
+      continue;
+    }
+
+    uint64_t addr = 0;
+    std::string_view addr_str = tokens[0];
+    auto [ptr, ec] = std::from_chars(addr_str.data(), addr_str.data() + addr_str.size(), addr, 16);
+    if (ec != std::errc() || ptr != addr_str.data() + addr_str.size() || addr == 0) {
+      continue;
+    }
+
+    std::string_view name = tokens[2];
+    auto [iter, inserted] = name_offsets.try_emplace(name, index->names_.size());
+    if (inserted) {
+      index->names_.append(name);
+    }
+    index->symbols_.push_back(Symbol{addr, iter->second, static_cast<uint32_t>(name.size())});
+  }
+
+  if (index->symbols_.empty()) {
+    return error::NotFound("No kernel symbols with addresses found in kallsyms.");
+  }
+
+  // kallsyms is mostly sorted, except for the symbols of modules.
+  std::stable_sort(index->symbols_.begin(), index->symbols_.end(),
+                   [](const Symbol& a, const Symbol& b) { return a.addr < b.addr; });
+  index->symbols_.shrink_to_fit();
+  index->names_.shrink_to_fit();
+  return index;
+}
+
+std::string_view KernelSymbolIndex::Lookup(uintptr_t addr) const {
+  auto iter =
+      std::upper_bound(symbols_.begin(), symbols_.end(), addr,
+                       [](uint64_t addr, const Symbol& symbol) { return addr < symbol.addr; });
+  if (iter == symbols_.begin()) {
+    return {};
+  }
+  --iter;
+  return std::string_view(names_).substr(iter->name_offset, iter->name_size);
+}
+
+}  // namespace stirling
+}  // namespace px
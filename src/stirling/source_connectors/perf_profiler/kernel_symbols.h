@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * KernelSymbolIndex resolves kernel addresses to the symbols of /proc/kallsyms.
+ *
+ * The symbols are kept in one array sorted by address, so that a lookup is a binary search.
+ * Names are interned into a single buffer, since many of them are repeated across modules.
+ * kallsyms has no symbol sizes; an address resolves to the closest symbol at or below it.
+ */
+class KernelSymbolIndex : public NotCopyable {
+ public:
+  /**
+   * Builds an index from the contents of /proc/kallsyms. Only text symbols are indexed, since
+   * stack traces don't have addresses of data.
+   *
+   * Returns an error if there are no symbols with addresses, which is what kallsyms looks like
+   * when kernel addresses are hidden by kptr_restrict.
+   */
+  static StatusOr<std::unique_ptr<KernelSymbolIndex>> Create(std::string_view kallsyms);
+
+  /**
+   * Returns the symbol of the address, or an empty string_view if it is below every symbol.
+   * The returned name is valid for the lifetime of the index.
+   */
+  std::string_view Lookup(uintptr_t addr) const;
+
+  size_t size() const { return symbols_.size(); }
+
+ private:
+  struct Symbol {
+    uint64_t addr;
+    uint32_t name_offset;
+    uint32_t name_size;
+  };
+
+  KernelSymbolIndex() = default;
+
+  std::vector<Symbol> symbols_;
+  std::string names_;
+};
+
+}  // namespace stirling
+}  // namespace px
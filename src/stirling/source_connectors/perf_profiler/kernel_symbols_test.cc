@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/perf_profiler/kernel_symbols.h"
+
+namespace px {
+namespace stirling {
+
+// Modules are at higher addresses, but appear in kallsyms before some of the core symbols.
+constexpr char kKallsyms[] = R"(
+ffffffff81000000 T startup_64
+ffffffff81000040 t secondary_startup_64
+ffffffff81001000 D some_data
+ffffffffc0a1b000 t init_module	[nf_conntrack]
+ffffffffc0a1b100 t nf_conntrack_init	[nf_conntrack]
+ffffffffc0b00000 t init_module	[xfs]
+ffffffff81002000 W weak_fn
+ffffffff81003000 T __x64_sys_getpid
+)";
+
+TEST(KernelSymbolIndexTest, Lookup) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<KernelSymbolIndex> index,
+                       KernelSymbolIndex::Create(kKallsyms));
+  EXPECT_EQ(7U, index->size());
+
+  EXPECT_EQ("", index->Lookup(0xffffffff80ffffff));
+  EXPECT_EQ("startup_64", index->Lookup(0xffffffff81000000));
+  EXPECT_EQ("startup_64", index->Lookup(0xffffffff8100003f));
+  EXPECT_EQ("secondary_startup_64", index->Lookup(0xffffffff81000040));
+  // Data symbols aren't indexed.
+  EXPECT_EQ("secondary_startup_64", index->Lookup(0xffffffff81001008));
+  EXPECT_EQ("weak_fn", index->Lookup(0xffffffff81002010));
+  EXPECT_EQ("__x64_sys_getpid", index->Lookup(0xffffffff81003010));
+  EXPECT_EQ("init_module", index->Lookup(0xffffffffc0a1b010));
+  EXPECT_EQ("nf_conntrack_init", index->Lookup(0xffffffffc0a1b110));
+  EXPECT_EQ("init_module", index->Lookup(0xffffffffc0b00010));
+}
+
+TEST(KernelSymbolIndexTest, HiddenAddresses) {
+  // With kptr_restrict, all addresses read as zero.
+  constexpr char kRestrictedKallsyms[] = R"(
+0000000000000000 T startup_64
+0000000000000000 t secondary_startup_64
+)";
+  EXPECT_NOT_OK(KernelSymbolIndex::Create(kRestrictedKallsyms));
+  EXPECT_NOT_OK(KernelSymbolIndex::Create(""));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -19,6 +19,7 @@
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 
 #include <sys/sysinfo.h>
+#include <time.h>
 
 #include <memory>
 #include <string>
@@ -32,6 +33,16 @@ BPF_SRC_STRVIEW(profiler_bcc_script, profiler);
 DEFINE_string(stirling_profiler_symbolizer, "bcc",
               "Choice of which symbolizer to use. Options: bcc, elf");
 DEFINE_bool(stirling_profiler_cache_symbols, true, "Whether to cache symbols");
+DEFINE_bool(stirling_profiler_stack_trace_deltas,
+            gflags::BoolFromEnv("PL_STIRLING_PROFILER_STACK_TRACE_DELTAS", false),
+            "If true, the stack_trace column is only populated in the first record of each "
+            "stack_trace_id, and left empty in later records, which are joined on the ID instead.");
+
+DEFINE_double(stirling_profiler_cpu_budget,
+              gflags::DoubleFromEnv("PL_STIRLING_PROFILER_CPU_BUDGET", 0),
+              "The CPU that the profiler may spend on draining and symbolizing stack traces, as a "
+              "fraction of one CPU. When exceeded, the profiler keeps only a subset of the "
+              "samples, and reports the effective sampling period. 0 keeps all samples.");
 
 DEFINE_uint32(stirling_perf_profiler_stats_logging_ratio,
               std::chrono::minutes(10) / px::stirling::PerfProfileConnector::kSamplingPeriod,
@@ -43,6 +54,16 @@ namespace stirling {
 PerfProfileConnector::PerfProfileConnector(std::string_view source_name)
     : SourceConnector(source_name, kTables) {}
 
+namespace {
+
+std::chrono::nanoseconds ThreadCPUTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+}  // namespace
+
 Status PerfProfileConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
@@ -62,12 +83,17 @@ Status PerfProfileConnector::InitImpl() {
   stack_traces_a_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_a"));
   stack_traces_b_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_b"));
 
-  histogram_a_perf_buffer_ = GetPerfBuffer("histogram_a");
-  histogram_b_perf_buffer_ = GetPerfBuffer("histogram_b");
-
   profiler_state_ =
       std::make_unique<ebpf::BPFArrayTable<uint64_t>>(GetArrayTable<uint64_t>("profiler_state"));
 
+  sampling_controller_ =
+      std::make_unique<SamplingController>(FLAGS_stirling_profiler_cpu_budget, kMaxSampleStride);
+  const ebpf::StatusTuple s = profiler_state_->update_value(kSampleStrideIdx, active_sample_stride_);
+  if (!s.ok()) {
+    return error::Internal("Could not initialize the sample stride: $0", s.msg());
+  }
+  last_transfer_time_ = std::chrono::steady_clock::now();
+
   LOG(INFO) << "PerfProfiler: Stack trace profiling sampling probe successfully deployed.";
 
   // Create a symbolizer for user symbols.
@@ -80,8 +106,16 @@ Status PerfProfileConnector::InitImpl() {
   }
 
   // Create a symbolizer for kernel symbols.
-  // Kernel symbolizer always uses BCC symbolizer.
-  PL_ASSIGN_OR_RETURN(k_symbolizer_, BCCSymbolizer::Create());
+  // Falls back to the BCC symbolizer if kallsyms can't be indexed, e.g. because of kptr_restrict.
+  StatusOr<std::unique_ptr<KernelSymbolizer>> kernel_symbolizer = KernelSymbolizer::Create();
+  if (kernel_symbolizer.ok()) {
+    kernel_symbolizer_ = kernel_symbolizer.ValueOrDie().get();
+    k_symbolizer_ = kernel_symbolizer.ConsumeValueOrDie();
+  } else {
+    LOG(WARNING) << absl::Substitute("Using BCC for kernel symbols: $0",
+                                     kernel_symbolizer.ToString());
+    PL_ASSIGN_OR_RETURN(k_symbolizer_, BCCSymbolizer::Create());
+  }
 
   if (FLAGS_stirling_profiler_cache_symbols) {
     // Add a caching layer on top of the existing symbolizer.
@@ -126,6 +160,12 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
     u_symbolizer_->DeleteUPID(upid);
   }
 
+  // Symbols of newly loaded modules only resolve after a refresh. Any cached kernel symbols are
+  // dropped with it, since they may belong to a module that was unloaded.
+  if (kernel_symbolizer_ != nullptr && kernel_symbolizer_->RefreshIfModulesChanged()) {
+    k_symbolizer_->DeleteUPID(profiler::kKernelUPID);
+  }
+
   if (FLAGS_stirling_profiler_cache_symbols) {
     size_t evict_count;
 
@@ -213,12 +253,14 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 }
 
 void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                                         DataTable* data_table) {
+                                         DataTable* data_table, uint32_t sample_stride) {
   constexpr size_t kMaxSymbolSize = 512;
   constexpr size_t kMaxStackDepth = 64;
   constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
 
   const uint64_t timestamp_ns = AdjustedSteadyClockNowNS();
+  const int64_t sampling_period_ns =
+      std::chrono::nanoseconds(kBPFSamplingPeriod * sample_stride).count();
 
   // Stack traces from kernel/BPF are ordered lists of instruction pointers (addresses).
   // AggregateStackTraces() will collapse some of those into identical symbolic stack traces;
@@ -236,11 +278,21 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, Conn
   for (const auto& [key, count] : stack_trace_histogram) {
     DataTable::RecordBuilder<&kStackTraceTable> r(data_table, timestamp_ns);
 
+    bool new_id = false;
+    const uint64_t stack_trace_id = stack_trace_ids_.Lookup(key, &new_id);
+
     r.Append<r.ColIndex("time_")>(timestamp_ns);
     r.Append<r.ColIndex("upid")>(key.upid.value());
-    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_ids_.Lookup(key));
-    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id);
+    if (!FLAGS_stirling_profiler_stack_trace_deltas || new_id) {
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    } else {
+      // The string of this ID was emitted in an earlier record.
+      r.Append<r.ColIndex("stack_trace")>("");
+      stats_.Increment(StatKey::kElidedStackTraceStrings, 1);
+    }
     r.Append<r.ColIndex("count")>(count);
+    r.Append<r.ColIndex("sampling_period")>(sampling_period_ns);
   }
 }
 
@@ -248,22 +300,44 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
   // Choose the maps to consume.
   const bool using_map_set_a = transfer_count_ % 2 == 0;
   auto& stack_traces = using_map_set_a ? stack_traces_a_ : stack_traces_b_;
-  auto& histo_perf_buf = using_map_set_a ? histogram_a_perf_buffer_ : histogram_b_perf_buffer_;
+  const std::string_view histo_perf_buf = using_map_set_a ? "histogram_a" : "histogram_b";
   const uint32_t sample_count_idx = using_map_set_a ? kSampleCountAIdx : kSampleCountBIdx;
 
+  // The cost of the iteration, for the sampling controller, includes draining the perf buffer.
+  const std::chrono::nanoseconds cpu_time_start = ThreadCPUTime();
+
   // Read out the perf buffer that contains the histogram for this iteration.
-  // TODO(jps): change PollPerfBuffer() to use std::chrono.
-  constexpr int kPollTimeoutMS = 0;
-  histo_perf_buf->poll(kPollTimeoutMS);
+  PollPerfBuffer(histo_perf_buf);
 
   ++transfer_count_;
 
-  // First, tell BPF to switch the maps it writes to.
+  // The maps that are about to be consumed were filled with the active stride. Set the stride
+  // for the other maps right before switching to them, so that each map set has a single stride.
+  const uint32_t sample_stride = active_sample_stride_;
+  if (next_sample_stride_ != active_sample_stride_) {
+    const ebpf::StatusTuple s = profiler_state_->update_value(kSampleStrideIdx, next_sample_stride_);
+    LOG_IF(ERROR, !s.ok()) << "Error writing sample stride";
+    if (s.ok()) {
+      active_sample_stride_ = next_sample_stride_;
+    }
+  }
+
+  // Then, tell BPF to switch the maps it writes to.
   const ebpf::StatusTuple s = profiler_state_->update_value(kTransferCountIdx, transfer_count_);
   LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
+  const auto now = std::chrono::steady_clock::now();
+  const auto period = now - last_transfer_time_;
+  last_transfer_time_ = now;
+  const uint64_t num_samples = raw_histo_data_.size();
+
   // Read BPF stack traces & histogram, build records, incorporate records to data table.
-  CreateRecords(stack_traces.get(), ctx, data_table);
+  CreateRecords(stack_traces.get(), ctx, data_table, sample_stride);
+
+  // Pick the stride of the next map set from the cost of this one.
+  next_sample_stride_ =
+      sampling_controller_->Update(ThreadCPUTime() - cpu_time_start, period, num_samples);
+  stats_.Increment(StatKey::kSkippedSamplingEvents, num_samples * (sample_stride - 1));
 
   // Now that we've consumed the data, reset the sample count in BPF.
   profiler_state_->update_value(sample_count_idx, 0);
@@ -282,7 +356,7 @@ void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
   ProcessBPFStackTraces(ctx, data_table);
 
   // Cleanup the symbolizer so we don't leak memory.
-  proc_tracker_.Update(ctx->GetUPIDs());
+  proc_tracker_.Update(ctx->GetUPIDs(), ctx->proc_events());
   CleanupSymbolizers(proc_tracker_.deleted_upids());
 
   stats_.Increment(StatKey::kBPFMapSwitchoverEvent, 1);
@@ -29,6 +29,7 @@
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/core/types.h"
 #include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
+#include "src/stirling/source_connectors/perf_profiler/sampling_controller.h"
 #include "src/stirling/source_connectors/perf_profiler/stack_trace_id_cache.h"
 #include "src/stirling/source_connectors/perf_profiler/stack_traces_table.h"
 #include "src/stirling/source_connectors/perf_profiler/stringifier.h"
@@ -36,6 +37,9 @@
 #include "src/stirling/source_connectors/perf_profiler/types.h"
 #include "src/stirling/utils/stat_counter.h"
 
+DECLARE_bool(stirling_profiler_stack_trace_deltas);
+DECLARE_double(stirling_profiler_cpu_budget);
+
 namespace px {
 namespace stirling {
 
@@ -58,6 +62,9 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{30000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{15000};
 
+  // The largest sample stride that the sampling controller may choose.
+  static constexpr uint32_t kMaxSampleStride = 16;
+
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new PerfProfileConnector(name));
   }
@@ -78,8 +85,9 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table);
 
   // Read BPF data structures, build & incorporate records to the table.
+  // The samples were taken with one out of every sample_stride BPF sampling events.
   void CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                     DataTable* data_table);
+                     DataTable* data_table, uint32_t sample_stride);
 
   StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces);
 
@@ -94,6 +102,16 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Number of iterations, where each iteration is drains the information collectid in BPF.
   uint64_t transfer_count_ = 0;
 
+  // Chooses the sample stride from the measured cost of each iteration.
+  std::unique_ptr<SamplingController> sampling_controller_;
+
+  // The sample stride of the map set that BPF currently writes to,
+  // and the stride to switch to on the next iteration.
+  uint32_t active_sample_stride_ = 1;
+  uint32_t next_sample_stride_ = 1;
+
+  std::chrono::steady_clock::time_point last_transfer_time_;
+
   // Tracks unique stack trace ids, for the lifetime of Stirling:
   StackTraceIDCache stack_trace_ids_;
 
@@ -104,6 +122,9 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   std::unique_ptr<Symbolizer> k_symbolizer_;
   std::unique_ptr<Symbolizer> u_symbolizer_;
 
+  // The kallsyms symbolizer inside k_symbolizer_, if it is one. Not owned.
+  KernelSymbolizer* kernel_symbolizer_ = nullptr;
+
   // Keeps track of processes. Used to find destroyed processes on which to perform clean-up.
   // TODO(oazizi): Investigate ways of sharing across source_connectors.
   ProcTracker proc_tracker_;
@@ -129,13 +150,12 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
       {{"histogram_a", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries},
        {"histogram_b", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries}});
 
-  ebpf::BPFPerfBuffer* histogram_a_perf_buffer_;
-  ebpf::BPFPerfBuffer* histogram_b_perf_buffer_;
-
   enum class StatKey {
     kBPFMapSwitchoverEvent,
     kCumulativeSumOfAllStackTraces,
     kLossHistoEvent,
+    kElidedStackTraceStrings,
+    kSkippedSamplingEvents,
   };
 
   utils::StatCounter<StatKey> stats_;
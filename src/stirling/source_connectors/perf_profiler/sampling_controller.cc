@@ -0,0 +1,52 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/perf_profiler/sampling_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace px {
+namespace stirling {
+
+uint32_t SamplingController::Update(std::chrono::nanoseconds cpu_time,
+                                    std::chrono::nanoseconds period, uint64_t num_samples) {
+  if (cpu_budget_ <= 0 || num_samples == 0 || period.count() <= 0) {
+    return stride_;
+  }
+
+  const double cost = static_cast<double>(cpu_time.count()) / num_samples;
+  cost_per_sample_ns_ = cost_per_sample_ns_ == 0
+                            ? cost
+                            : kCostSmoothing * cost + (1 - kCostSmoothing) * cost_per_sample_ns_;
+  if (cost_per_sample_ns_ <= 0) {
+    return stride_;
+  }
+
+  // The number of samples the period would have had without any skipping.
+  const double unstrided_samples = static_cast<double>(num_samples) * stride_;
+  const double budget_samples = cpu_budget_ * period.count() / cost_per_sample_ns_;
+  const double target = std::ceil(unstrided_samples / std::max(budget_samples, 1.0));
+
+  const uint32_t lower = std::max<uint32_t>(1, stride_ / 2);
+  const uint32_t upper = std::min<uint32_t>(max_stride_, stride_ * 2);
+  stride_ = static_cast<uint32_t>(std::clamp<double>(target, lower, upper));
+  return stride_;
+}
+
+}  // namespace stirling
+}  // namespace px
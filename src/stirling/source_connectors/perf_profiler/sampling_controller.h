@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace px {
+namespace stirling {
+
+/**
+ * SamplingController holds the user-space CPU cost of the perf profiler within a budget,
+ * by choosing how many of the BPF sampling events are skipped for each one that is kept.
+ *
+ * After each transfer period, it is told how much CPU time it took to drain and symbolize the
+ * samples of the period, and how many samples that was. From a moving average of the cost per
+ * sample, it computes the largest number of samples that fit in the budget, and the stride
+ * (keep 1 sample out of every stride) that brings the sample count down to that number.
+ * The stride changes by at most a factor of 2 per period, to avoid oscillating on noisy costs.
+ */
+class SamplingController {
+ public:
+  /**
+   * @param cpu_budget The target CPU usage, as a fraction of one CPU. Zero disables the
+   *                   controller, which then keeps every sample.
+   * @param max_stride An upper bound on the stride, so that the profiler never goes blind.
+   */
+  SamplingController(double cpu_budget, uint32_t max_stride)
+      : cpu_budget_(cpu_budget), max_stride_(max_stride) {}
+
+  /**
+   * Updates the controller with the cost of a transfer period, which was sampled with the
+   * current stride. Returns the stride to use for the next period.
+   */
+  uint32_t Update(std::chrono::nanoseconds cpu_time, std::chrono::nanoseconds period,
+                  uint64_t num_samples);
+
+  uint32_t stride() const { return stride_; }
+
+  double cost_per_sample_ns() const { return cost_per_sample_ns_; }
+
+ private:
+  // Weight of the latest period in the moving average of the cost per sample.
+  static constexpr double kCostSmoothing = 0.5;
+
+  const double cpu_budget_;
+  const uint32_t max_stride_;
+
+  uint32_t stride_ = 1;
+  double cost_per_sample_ns_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include "src/stirling/source_connectors/perf_profiler/sampling_controller.h"
+
+namespace px {
+namespace stirling {
+
+using std::chrono_literals::operator""ms;
+using std::chrono_literals::operator""s;
+
+TEST(SamplingControllerTest, DisabledKeepsAllSamples) {
+  SamplingController controller(/*cpu_budget*/ 0, /*max_stride*/ 16);
+  EXPECT_EQ(controller.Update(10s, 30s, 1000), 1);
+  EXPECT_EQ(controller.stride(), 1);
+}
+
+TEST(SamplingControllerTest, ConvergesToBudget) {
+  // 1% of a CPU over 30s is 300ms. At 1ms per sample, that fits 300 samples.
+  SamplingController controller(/*cpu_budget*/ 0.01, /*max_stride*/ 16);
+
+  // 2400 samples per period when nothing is skipped; the target stride is 8.
+  // Steps are bounded by a factor of 2.
+  EXPECT_EQ(controller.Update(2400ms, 30s, 2400), 2);
+  EXPECT_EQ(controller.Update(1200ms, 30s, 1200), 4);
+  EXPECT_EQ(controller.Update(600ms, 30s, 600), 8);
+  EXPECT_EQ(controller.Update(300ms, 30s, 300), 8);
+
+  // Once the samples get cheaper (0.1ms), the stride comes back down, as fast as the moving
+  // average of the cost follows.
+  EXPECT_EQ(controller.Update(30ms, 30s, 300), 5);
+  EXPECT_EQ(controller.Update(48ms, 30s, 480), 3);
+}
+
+TEST(SamplingControllerTest, BoundedByMaxStride) {
+  SamplingController controller(/*cpu_budget*/ 0.01, /*max_stride*/ 4);
+  for (int i = 0; i < 5; ++i) {
+    controller.Update(30s, 30s, 1000);
+  }
+  EXPECT_EQ(controller.stride(), 4);
+
+  // No samples means no information on the cost; keep the stride.
+  EXPECT_EQ(controller.Update(0s, 30s, 0), 4);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -23,7 +23,11 @@
 namespace px {
 namespace stirling {
 
-uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace) {
+uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace, bool* new_id) {
+  if (new_id != nullptr) {
+    *new_id = false;
+  }
+
   // Case 1: Stack trace ID is in the current set. Just return it.
   const auto it = stack_trace_ids_.find(stack_trace);
   if (it != stack_trace_ids_.end()) {
@@ -42,6 +46,9 @@ uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace) {
   // Case 3: Stack trace ID is not in the current nor the previous set. Create a new ID.
   const uint64_t stack_trace_id = ++next_stack_trace_id_;
   stack_trace_ids_[stack_trace] = stack_trace_id;
+  if (new_id != nullptr) {
+    *new_id = true;
+  }
   return stack_trace_id;
 }
 
@@ -46,7 +46,11 @@ namespace stirling {
 // the UI will aggregate the identical stack traces for us in the visualization.
 class StackTraceIDCache {
  public:
-  uint64_t Lookup(const SymbolicStackTrace& stack_trace);
+  /**
+   * Returns the ID of the stack trace. If new_id is not null, it is set to whether the ID was
+   * assigned by this call, i.e. whether the ID has not been handed out before.
+   */
+  uint64_t Lookup(const SymbolicStackTrace& stack_trace, bool* new_id = nullptr);
   void AgeTick();
 
  private:
@@ -51,5 +51,27 @@ TEST(StackTraceIDCache, Basic) {
   EXPECT_NE(stack_trace_ids.Lookup(kStackTrace2), id2);
 }
 
+TEST(StackTraceIDCache, NewID) {
+  StackTraceIDCache stack_trace_ids;
+
+  const md::UPID kUPID(1, 1, 1);
+  const SymbolicStackTrace kStackTrace{kUPID, "a();b();c();"};
+
+  bool new_id = false;
+  uint64_t id = stack_trace_ids.Lookup(kStackTrace, &new_id);
+  EXPECT_TRUE(new_id);
+  EXPECT_EQ(stack_trace_ids.Lookup(kStackTrace, &new_id), id);
+  EXPECT_FALSE(new_id);
+
+  stack_trace_ids.AgeTick();
+  EXPECT_EQ(stack_trace_ids.Lookup(kStackTrace, &new_id), id);
+  EXPECT_FALSE(new_id);
+
+  stack_trace_ids.AgeTick();
+  stack_trace_ids.AgeTick();
+  EXPECT_NE(stack_trace_ids.Lookup(kStackTrace, &new_id), id);
+  EXPECT_TRUE(new_id);
+}
+
 }  // namespace stirling
 }  // namespace px
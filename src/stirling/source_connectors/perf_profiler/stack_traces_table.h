@@ -37,11 +37,18 @@ static constexpr DataElement kElements[] = {
     {"stack_trace",
      "A stack trace within the sampled process, in folded format. "
      "The call stack symbols are separated by semicolons. "
-     "If symbols cannot be resolved, addresses are populated instead.",
+     "If symbols cannot be resolved, addresses are populated instead. "
+     "Empty if the string of the stack_trace_id was reported in an earlier record "
+     "(only with --stirling_profiler_stack_trace_deltas).",
      types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"count",
      "Number of times the stack trace has been sampled.",
-     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE}
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE},
+    {"sampling_period",
+     "The effective time interval between stack trace samples of a CPU. "
+     "It grows when the profiler sheds load; count * sampling_period estimates the CPU time "
+     "spent in the stack trace, regardless of the sampling rate.",
+     types::DataType::INT64, types::SemanticType::ST_DURATION_NS, types::PatternType::METRIC_GAUGE}
 };
 
 constexpr auto kStackTraceTable = DataTableSchema(
@@ -58,6 +65,7 @@ constexpr int kStackTraceUPIDIdx = kStackTraceTable.ColIndex("upid");
 constexpr int kStackTraceStackTraceIDIdx = kStackTraceTable.ColIndex("stack_trace_id");
 constexpr int kStackTraceStackTraceStrIdx = kStackTraceTable.ColIndex("stack_trace");
 constexpr int kStackTraceCountIdx = kStackTraceTable.ColIndex("count");
+constexpr int kStackTraceSamplingPeriodIdx = kStackTraceTable.ColIndex("sampling_period");
 
 }  // namespace stirling
 }  // namespace px
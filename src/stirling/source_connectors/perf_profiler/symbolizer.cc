@@ -16,6 +16,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <sys/stat.h>
+
+#include <string>
 #include <utility>
 
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
@@ -60,9 +63,23 @@ StatusOr<std::unique_ptr<Symbolizer>> ElfSymbolizer::Create() {
   return symbolizer;
 }
 
-void ElfSymbolizer::DeleteUPID(const struct upid_t& upid) { symbolizers_.erase(upid); }
+void ElfSymbolizer::DeleteUPID(const struct upid_t& upid) {
+  auto iter = symbolizers_.find(upid);
+  if (iter == symbolizers_.end()) {
+    return;
+  }
+  const FileKey file_key = iter->second.file_key;
+  symbolizers_.erase(iter);
+
+  // Drop the binary's symbol index once the last process that runs it is gone.
+  auto file_iter = symbolizers_by_file_.find(file_key);
+  if (file_iter != symbolizers_by_file_.end() && file_iter->second.symbolizer.expired()) {
+    symbolizers_by_file_.erase(file_iter);
+  }
+}
 
-StatusOr<std::unique_ptr<ElfReader::Symbolizer>> CreateUPIDSymbolizer(const struct upid_t& upid) {
+StatusOr<ElfSymbolizer::UPIDSymbolizer> ElfSymbolizer::CreateUPIDSymbolizer(
+    const struct upid_t& upid) {
   PL_ASSIGN_OR_RETURN(std::unique_ptr<FilePathResolver> fp_resolver,
                       FilePathResolver::Create(upid.pid));
   // TODO(yzhao): Might need to check the start time.
@@ -70,12 +87,40 @@ StatusOr<std::unique_ptr<ElfReader::Symbolizer>> CreateUPIDSymbolizer(const stru
                       system::ProcParser(system::Config::GetInstance()).GetExePath(upid.pid));
   PL_ASSIGN_OR_RETURN(std::filesystem::path host_proc_exe, fp_resolver->ResolvePath(proc_exe));
   host_proc_exe = system::Config::GetInstance().ToHostPath(host_proc_exe);
+
+  struct stat st;
+  if (stat(host_proc_exe.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0 [errno=$1].", host_proc_exe.string(), errno);
+  }
+  UPIDSymbolizer upid_symbolizer;
+  upid_symbolizer.file_key = {st.st_dev, st.st_ino, st.st_size,
+                              st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec};
+
+  auto iter = symbolizers_by_file_.find(upid_symbolizer.file_key);
+  if (iter != symbolizers_by_file_.end()) {
+    upid_symbolizer.binary_id = iter->second.binary_id;
+    upid_symbolizer.symbolizer = iter->second.symbolizer.lock();
+    if (upid_symbolizer.symbolizer != nullptr) {
+      return upid_symbolizer;
+    }
+  }
+
   PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(host_proc_exe));
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader::Symbolizer> upid_symbolizer,
-                      elf_reader->GetSymbolizer());
+  PL_ASSIGN_OR_RETURN(upid_symbolizer.symbolizer, elf_reader->GetSymbolizer());
+  upid_symbolizer.binary_id = next_binary_id_++;
+  symbolizers_by_file_[upid_symbolizer.file_key] =
+      BinarySymbolizer{upid_symbolizer.binary_id, upid_symbolizer.symbolizer};
   return upid_symbolizer;
 }
 
+std::optional<uint64_t> ElfSymbolizer::SharedSymbolsKey(const struct upid_t& upid) {
+  auto iter = symbolizers_.find(upid);
+  if (iter == symbolizers_.end()) {
+    return std::nullopt;
+  }
+  return iter->second.binary_id;
+}
+
 std::string_view EmptySymbolizerFn(const uintptr_t addr) {
   static std::string symbol;
   symbol = absl::StrFormat("0x%016llx", addr);
@@ -90,11 +135,11 @@ SymbolizerFn ElfSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
     return SymbolizerFn(&(BogusKernelSymbolizerFn));
   }
 
-  std::unique_ptr<ElfReader::Symbolizer>& upid_symbolizer = symbolizers_[upid];
-  if (upid_symbolizer == nullptr) {
-    StatusOr<std::unique_ptr<ElfReader::Symbolizer>> upid_symbolizer_status =
-        CreateUPIDSymbolizer(upid);
+  UPIDSymbolizer& upid_symbolizer = symbolizers_[upid];
+  if (upid_symbolizer.symbolizer == nullptr) {
+    StatusOr<UPIDSymbolizer> upid_symbolizer_status = CreateUPIDSymbolizer(upid);
     if (!upid_symbolizer_status.ok()) {
+      symbolizers_.erase(upid);
       VLOG(1) << absl::Substitute("Failed to create Symbolizer function for $0 [error=$1]",
                                   upid.pid, upid_symbolizer_status.ToString());
       return SymbolizerFn(&(EmptySymbolizerFn));
@@ -103,7 +148,48 @@ SymbolizerFn ElfSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
     upid_symbolizer = upid_symbolizer_status.ConsumeValueOrDie();
   }
 
-  return std::bind(&ElfReader::Symbolizer::Lookup, upid_symbolizer.get(), std::placeholders::_1);
+  return std::bind(&ElfReader::Symbolizer::Lookup, upid_symbolizer.symbolizer.get(),
+                   std::placeholders::_1);
+}
+
+StatusOr<std::unique_ptr<KernelSymbolizer>> KernelSymbolizer::Create() {
+  auto symbolizer = std::unique_ptr<KernelSymbolizer>(new KernelSymbolizer());
+  PL_RETURN_IF_ERROR(symbolizer->LoadIndex());
+  return symbolizer;
+}
+
+Status KernelSymbolizer::LoadIndex() {
+  const std::filesystem::path& proc_path = system::Config::GetInstance().proc_path();
+  // Read the modules first, so that a module loaded in between triggers another refresh.
+  PL_ASSIGN_OR_RETURN(std::string modules, ReadFileToString((proc_path / "modules").string()));
+  PL_ASSIGN_OR_RETURN(std::string kallsyms, ReadFileToString((proc_path / "kallsyms").string()));
+  PL_ASSIGN_OR_RETURN(index_, KernelSymbolIndex::Create(kallsyms));
+  modules_ = std::move(modules);
+  VLOG(1) << absl::Substitute("Loaded $0 kernel symbols.", index_->size());
+  return Status::OK();
+}
+
+bool KernelSymbolizer::RefreshIfModulesChanged() {
+  StatusOr<std::string> modules =
+      ReadFileToString((system::Config::GetInstance().proc_path() / "modules").string());
+  if (!modules.ok() || modules.ValueOrDie() == modules_) {
+    return false;
+  }
+  Status s = LoadIndex();
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to reload kernel symbols: $0", s.msg());
+  return s.ok();
+}
+
+std::string_view KernelSymbolizer::Symbolize(const uintptr_t addr) {
+  std::string_view symbol = index_->Lookup(addr);
+  return symbol.empty() ? EmptySymbolizerFn(addr) : symbol;
+}
+
+SymbolizerFn KernelSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
+  if (upid.pid != profiler::kKernelUPID.pid) {
+    return SymbolizerFn(&(EmptySymbolizerFn));
+  }
+  return std::bind(&KernelSymbolizer::Symbolize, this, std::placeholders::_1);
 }
 
 StatusOr<std::unique_ptr<Symbolizer>> CachingSymbolizer::Create(
@@ -116,18 +202,42 @@ StatusOr<std::unique_ptr<Symbolizer>> CachingSymbolizer::Create(
 
 SymbolizerFn CachingSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
   using std::placeholders::_1;
-  const auto [iter, inserted] = symbol_caches_.try_emplace(upid, nullptr);
+  const auto [iter, inserted] = symbol_caches_.try_emplace(upid);
+  UPIDSymbolCache& upid_cache = iter->second;
   if (inserted) {
-    iter->second = std::make_unique<SymbolCache>(symbolizer_->GetSymbolizerFn(upid));
+    SymbolizerFn symbolizer_fn = symbolizer_->GetSymbolizerFn(upid);
+    upid_cache.shared_key = symbolizer_->SharedSymbolsKey(upid);
+    if (upid_cache.shared_key.has_value()) {
+      SharedSymbolCache& shared_cache = shared_symbol_caches_[upid_cache.shared_key.value()];
+      if (shared_cache.cache == nullptr) {
+        shared_cache.cache = std::make_unique<SymbolCache>(std::move(symbolizer_fn));
+      }
+      ++shared_cache.num_upids;
+      upid_cache.cache = shared_cache.cache.get();
+    } else {
+      upid_cache.private_cache = std::make_unique<SymbolCache>(std::move(symbolizer_fn));
+      upid_cache.cache = upid_cache.private_cache.get();
+    }
   }
-  auto& cache = iter->second;
-  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, cache.get(), _1);
+  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, upid_cache.cache, _1);
   return fn;
 }
 
 void CachingSymbolizer::DeleteUPID(const struct upid_t& upid) {
-  // The inner map is owned by a unique_ptr; this will free the memory.
-  symbol_caches_.erase(upid);
+  auto iter = symbol_caches_.find(upid);
+  if (iter != symbol_caches_.end()) {
+    // A shared cache is freed along with its last UPID. The symbolizer function of a shared cache
+    // comes from its first UPID, which the inner symbolizer keeps valid for all UPIDs of the key.
+    if (iter->second.shared_key.has_value()) {
+      auto shared_iter = shared_symbol_caches_.find(iter->second.shared_key.value());
+      DCHECK(shared_iter != shared_symbol_caches_.end());
+      if (--shared_iter->second.num_upids == 0) {
+        shared_symbol_caches_.erase(shared_iter);
+      }
+    }
+    // A private cache is owned by a unique_ptr; this will free the memory.
+    symbol_caches_.erase(iter);
+  }
 
   symbolizer_->DeleteUPID(upid);
 }
@@ -139,14 +249,24 @@ size_t CachingSymbolizer::PerformEvictions() {
   }
 
   size_t active_entries = 0;
-  for (const auto& sym_cache : symbol_caches_) {
-    active_entries += sym_cache.second->active_entries();
+  for (const auto& [upid, upid_cache] : symbol_caches_) {
+    if (upid_cache.private_cache != nullptr) {
+      active_entries += upid_cache.private_cache->active_entries();
+    }
+  }
+  for (const auto& [key, shared_cache] : shared_symbol_caches_) {
+    active_entries += shared_cache.cache->active_entries();
   }
 
   size_t evict_count = 0;
   if (active_entries > FLAGS_stirling_profiler_cache_eviction_threshold) {
-    for (const auto& sym_cache : symbol_caches_) {
-      evict_count += sym_cache.second->PerformEvictions();
+    for (const auto& [upid, upid_cache] : symbol_caches_) {
+      if (upid_cache.private_cache != nullptr) {
+        evict_count += upid_cache.private_cache->PerformEvictions();
+      }
+    }
+    for (const auto& [key, shared_cache] : shared_symbol_caches_) {
+      evict_count += shared_cache.cache->PerformEvictions();
     }
   }
 
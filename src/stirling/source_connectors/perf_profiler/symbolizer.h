@@ -19,13 +19,16 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <utility>
 
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/source_connectors/perf_profiler/kernel_symbols.h"
 #include "src/stirling/source_connectors/perf_profiler/symbol_cache.h"
 #include "src/stirling/source_connectors/perf_profiler/types.h"
 
@@ -60,6 +63,16 @@ class Symbolizer {
    * Delete the state associated with a symbolizer created by a previous call to GetSymbolizerFn
    */
   virtual void DeleteUPID(const struct upid_t& upid) = 0;
+
+  /**
+   * Returns a key that is the same for all the UPIDs whose symbolizer functions resolve every
+   * address to the same symbol, e.g. because they run the same binary, so that caches can share
+   * symbols across them. Only valid after GetSymbolizerFn() was called for the UPID, and until
+   * DeleteUPID(). Returns std::nullopt if the symbols of the UPID can not be shared.
+   */
+  virtual std::optional<uint64_t> SharedSymbolsKey(const struct upid_t& /*upid*/) {
+    return std::nullopt;
+  }
 };
 
 /**
@@ -81,6 +94,11 @@ class BCCSymbolizer : public Symbolizer, public NotCopyMoveable {
 
 /**
  * A Symbolizer using the ElfReader symbolization core.
+ *
+ * The symbol index of a binary is shared by all the processes that run it, so that a node with
+ * many copies of the same binary indexes its symbols only once. Binaries are identified by their
+ * host file (device, inode, size and modification time), which avoids parsing the ELF file for
+ * processes whose binary was indexed already.
  */
 class ElfSymbolizer : public Symbolizer, public NotCopyMoveable {
  public:
@@ -89,17 +107,86 @@ class ElfSymbolizer : public Symbolizer, public NotCopyMoveable {
   SymbolizerFn GetSymbolizerFn(const struct upid_t& upid) override;
   void DeleteUPID(const struct upid_t& upid) override;
 
+  /**
+   * The ID of the binary that the UPID runs. The symbols of a binary are resolved against its
+   * ELF symbol table without rebasing, so they are the same for all the UPIDs that run it.
+   */
+  std::optional<uint64_t> SharedSymbolsKey(const struct upid_t& upid) override;
+
+  /**
+   * The number of distinct binaries that currently have a symbol index.
+   */
+  size_t num_indexed_binaries() const { return symbolizers_by_file_.size(); }
+
  private:
+  using ElfSymbolizerPtr = std::shared_ptr<const px::stirling::obj_tools::ElfReader::Symbolizer>;
+
+  // dev, inode, size, mtime (ns).
+  using FileKey = std::tuple<uint64_t, uint64_t, int64_t, int64_t>;
+
+  struct UPIDSymbolizer {
+    FileKey file_key;
+    uint64_t binary_id = 0;
+    ElfSymbolizerPtr symbolizer;
+  };
+
+  struct BinarySymbolizer {
+    uint64_t binary_id;
+    std::weak_ptr<const px::stirling::obj_tools::ElfReader::Symbolizer> symbolizer;
+  };
+
   ElfSymbolizer() = default;
 
+  StatusOr<UPIDSymbolizer> CreateUPIDSymbolizer(const struct upid_t& upid);
+
   // A symbolizer per UPID.
-  absl::flat_hash_map<struct upid_t,
-                      std::unique_ptr<px::stirling::obj_tools::ElfReader::Symbolizer>>
-      symbolizers_;
+  absl::flat_hash_map<struct upid_t, UPIDSymbolizer> symbolizers_;
+
+  // The symbolizers of the binaries that are in use by at least one UPID.
+  absl::flat_hash_map<FileKey, BinarySymbolizer> symbolizers_by_file_;
+
+  // IDs are never reused, so that a binary that is replaced on disk gets a different ID.
+  uint64_t next_binary_id_ = 0;
+};
+
+/**
+ * A Symbolizer for kernel addresses, that resolves them against an index of /proc/kallsyms.
+ *
+ * The index is loaded once, and reloaded by RefreshIfModulesChanged() when the set of loaded
+ * kernel modules changes, since the symbols of a module only appear in kallsyms once it is loaded.
+ */
+class KernelSymbolizer : public Symbolizer, public NotCopyMoveable {
+ public:
+  static StatusOr<std::unique_ptr<KernelSymbolizer>> Create();
+
+  SymbolizerFn GetSymbolizerFn(const struct upid_t& upid) override;
+  void DeleteUPID(const struct upid_t& /*upid*/) override {}
+
+  /**
+   * Reloads the index if kernel modules were loaded or unloaded since the last load.
+   * Symbolizer functions returned earlier must not be used after a refresh.
+   * @return true if the index was reloaded.
+   */
+  bool RefreshIfModulesChanged();
+
+ private:
+  KernelSymbolizer() = default;
+
+  Status LoadIndex();
+  std::string_view Symbolize(const uintptr_t addr);
+
+  std::unique_ptr<KernelSymbolIndex> index_;
+
+  // The contents of /proc/modules when the index was loaded.
+  std::string modules_;
 };
 
 /**
  * A class that takes another symbolizer and adds a cache to it.
+ *
+ * UPIDs for which the inner symbolizer returns the same SharedSymbolsKey() share one cache,
+ * so that the symbols of a binary that runs in many processes are resolved and stored once.
+ * All other UPIDs get a cache of their own.
  */
 class CachingSymbolizer : public Symbolizer {
  public:
@@ -118,9 +205,23 @@ class CachingSymbolizer : public Symbolizer {
 
   std::string_view Symbolize(SymbolCache* symbol_cache, const uintptr_t addr);
 
+  struct SharedSymbolCache {
+    std::unique_ptr<SymbolCache> cache;
+    int num_upids = 0;
+  };
+
+  struct UPIDSymbolCache {
+    // Only set for UPIDs that have a cache of their own.
+    std::unique_ptr<SymbolCache> private_cache;
+    // Only set for UPIDs that use a cache in shared_symbol_caches_.
+    std::optional<uint64_t> shared_key;
+    SymbolCache* cache = nullptr;
+  };
+
   std::unique_ptr<Symbolizer> symbolizer_;
 
-  absl::flat_hash_map<struct upid_t, std::unique_ptr<SymbolCache>> symbol_caches_;
+  absl::flat_hash_map<struct upid_t, UPIDSymbolCache> symbol_caches_;
+  absl::flat_hash_map<uint64_t, SharedSymbolCache> shared_symbol_caches_;
 
   int64_t stat_accesses_ = 0;
   int64_t stat_hits_ = 0;
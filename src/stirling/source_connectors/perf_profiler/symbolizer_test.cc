@@ -65,6 +65,55 @@ TYPED_TEST(SymbolizerTest, UserSymbols) {
   EXPECT_EQ(symbolize(2), std::string("0x0000000000000002"));
 }
 
+TEST_F(ElfSymbolizerTest, SharedAcrossProcessesOfSameBinary) {
+  // Two UPIDs that run the same binary (here, both are this process).
+  struct upid_t upid_a = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 0};
+  struct upid_t upid_b = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 1};
+
+  auto* elf_symbolizer = static_cast<ElfSymbolizer*>(symbolizer_.get());
+
+  auto symbolize_a = symbolizer_->GetSymbolizerFn(upid_a);
+  auto symbolize_b = symbolizer_->GetSymbolizerFn(upid_b);
+  EXPECT_EQ(elf_symbolizer->num_indexed_binaries(), 1);
+  EXPECT_EQ(symbolize_a(kFooAddr), "test::foo()");
+  EXPECT_EQ(symbolize_b(kFooAddr), "test::foo()");
+
+  // The index stays around as long as one of the UPIDs uses it.
+  symbolizer_->DeleteUPID(upid_a);
+  EXPECT_EQ(elf_symbolizer->num_indexed_binaries(), 1);
+  EXPECT_EQ(symbolize_b(kBarAddr), "test::bar()");
+
+  symbolizer_->DeleteUPID(upid_b);
+  EXPECT_EQ(elf_symbolizer->num_indexed_binaries(), 0);
+}
+
+TEST_F(ElfSymbolizerTest, CachingSharedAcrossProcessesOfSameBinary) {
+  struct upid_t upid_a = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 0};
+  struct upid_t upid_b = {.pid = static_cast<uint32_t>(getpid()), .start_time_ticks = 1};
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<Symbolizer> symbolizer_uptr,
+                       CachingSymbolizer::Create(std::move(symbolizer_)));
+  CachingSymbolizer& symbolizer = *static_cast<CachingSymbolizer*>(symbolizer_uptr.get());
+
+  // The symbol resolved for the first UPID is a hit for the second one.
+  EXPECT_EQ(symbolizer.GetSymbolizerFn(upid_a)(kFooAddr), "test::foo()");
+  EXPECT_EQ(symbolizer.stat_hits(), 0);
+  EXPECT_EQ(symbolizer.GetSymbolizerFn(upid_b)(kFooAddr), "test::foo()");
+  EXPECT_EQ(symbolizer.stat_hits(), 1);
+
+  // The shared cache outlives the UPID that created it.
+  symbolizer.DeleteUPID(upid_a);
+  EXPECT_EQ(symbolizer.GetSymbolizerFn(upid_b)(kFooAddr), "test::foo()");
+  EXPECT_EQ(symbolizer.GetSymbolizerFn(upid_b)(kBarAddr), "test::bar()");
+  EXPECT_EQ(symbolizer.stat_accesses(), 4);
+  EXPECT_EQ(symbolizer.stat_hits(), 2);
+
+  // Once all the UPIDs are gone, the symbols are resolved again.
+  symbolizer.DeleteUPID(upid_b);
+  EXPECT_EQ(symbolizer.GetSymbolizerFn(upid_a)(kFooAddr), "test::foo()");
+  EXPECT_EQ(symbolizer.stat_hits(), 2);
+}
+
 TEST_F(BCCSymbolizerTest, KernelSymbols) {
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<Symbolizer> symbolizer, BCCSymbolizer::Create());
 
@@ -19,6 +19,7 @@
 #include "src/stirling/source_connectors/pid_runtime/pid_runtime_connector.h"
 
 #include <string>
+#include <vector>
 
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/macros.h"
@@ -53,7 +54,16 @@ void PIDRuntimeConnector::TransferDataImpl(ConnectorContext* /* ctx */,
   std::vector<std::pair<uint16_t, pidruntime_val_t>> items =
       GetHashTable<uint16_t, pidruntime_val_t>("pid_cpu_time").get_table_offline();
 
-  for (auto& item : items) {
+  // Convert all the timestamps at once, against the same version of the clock mapping.
+  std::vector<uint64_t> times;
+  times.reserve(items.size());
+  for (const auto& item : items) {
+    times.push_back(item.second.timestamp);
+  }
+  ConvertBatchToRealTime(times.size(), times.data(), times.data());
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    auto& item = items[i];
     // TODO(kgandhi): PL-460 Consider using other types of BPF tables to avoid a searching through
     // a map for the previously recorded run-time. Alternatively, calculate delta in the bpf code
     // if that is more efficient.
@@ -65,7 +75,7 @@ void PIDRuntimeConnector::TransferDataImpl(ConnectorContext* /* ctx */,
       prev_run_time = it->second;
     }
 
-    uint64_t time = ConvertToRealTime(item.second.timestamp);
+    uint64_t time = times[i];
 
     DataTable::RecordBuilder<&kTable> r(data_table, time);
     r.Append<r.ColIndex("time_")>(time);
@@ -42,10 +42,13 @@ Status ProcessStatsConnector::StopImpl() { return Status::OK(); }
 
 void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
                                                       DataTable* data_table) {
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
+  const md::PIDInfoMap& pid_info_by_upid = ctx->GetPIDInfoMap();
 
   int64_t timestamp = AdjustedSteadyClockNowNS();
 
+  // Reused across the processes, so that their names reuse its string. Each of them overwrites all
+  // of the fields.
+  ProcParser::ProcessStats stats;
   for (const auto& [upid, pid_info] : pid_info_by_upid) {
     // TODO(zasgar): Fix condition for dead pids after helper function is added.
     if (pid_info == nullptr || pid_info->stop_time_ns() > 0) {
@@ -53,18 +56,17 @@ void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
       continue;
     }
 
-    ProcParser::ProcessStats stats;
     int32_t pid = upid.pid();
     // TODO(zasgar): We should double check the process start time to make sure it still the same
     // PID.
-    auto s1 = proc_parser_->ParseProcPIDStat(pid, &stats);
+    auto s1 = stats_reader_->ReadPIDStat(pid, &stats);
     if (!s1.ok()) {
       VLOG(1) << absl::Substitute(
           "Failed to fetch cpu stat info for PID ($0). Error=\"$1\" skipping.", pid, s1.msg());
       continue;
     }
 
-    auto s2 = proc_parser_->ParseProcPIDStatIO(pid, &stats);
+    auto s2 = stats_reader_->ReadPIDStatIO(pid, &stats);
     if (!s2.ok()) {
       VLOG(1) << absl::Substitute(
           "Failed to fetch IO stat info for PID ($0). Error=\"$1\" skipping.", pid, s2.msg());
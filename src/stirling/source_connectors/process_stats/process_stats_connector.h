@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/system/proc_parser.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
 #include "src/stirling/core/canonical_types.h"
@@ -59,12 +60,15 @@ class ProcessStatsConnector : public SourceConnector {
   explicit ProcessStatsConnector(std::string_view source_name)
       : SourceConnector(source_name, kTables) {
     proc_parser_ = std::make_unique<system::ProcParser>(sysconfig_);
+    stats_reader_ = std::make_unique<system::ProcParser::ProcessStatsReader>(proc_parser_.get());
   }
 
  private:
   void TransferProcessStatsTable(ConnectorContext* ctx, DataTable* data_table);
 
   std::unique_ptr<system::ProcParser> proc_parser_;
+  // Reads the stats of all of the processes of a sample without allocating for each of them.
+  std::unique_ptr<system::ProcParser::ProcessStatsReader> stats_reader_;
 };
 
 }  // namespace stirling
@@ -44,9 +44,24 @@ const int32_t kInvalidFD = -1;
 const int kConnStatsDataThreshold = 65536;
 
 // This is the perf buffer for BPF program to export data from kernel to user space.
+#ifdef SOCKET_TRACE_USE_RINGBUF
+// On kernels 5.8+, data and control events can go through ring buffers shared by all CPUs instead.
+// Events that don't fit are counted in the _lost arrays, which user-space reports as lost events.
+BPF_RINGBUF_OUTPUT(socket_data_events, SOCKET_DATA_RINGBUF_PAGES);
+BPF_RINGBUF_OUTPUT(socket_control_events, SOCKET_CONTROL_RINGBUF_PAGES);
+BPF_PERCPU_ARRAY(socket_data_events_lost, uint64_t, 1);
+BPF_PERCPU_ARRAY(socket_control_events_lost, uint64_t, 1);
+#else
 BPF_PERF_OUTPUT(socket_data_events);
 BPF_PERF_OUTPUT(socket_control_events);
+#endif
+#ifdef CONN_STATS_BPF_AGG
+// Conn stats are aggregated here instead of being sent as events. User-space reads the totals every
+// sampling period, and removes the entries of processes that exited.
+BPF_HASH(conn_stats_agg_map, struct conn_stats_agg_key_t, struct conn_stats_agg_t, 65536);
+#else
 BPF_PERF_OUTPUT(conn_stats_events);
+#endif
 
 // This output is used to export notification of processes that have performed an mmap.
 BPF_PERF_OUTPUT(mmap_events);
@@ -57,6 +72,18 @@ BPF_PERF_OUTPUT(mmap_events);
 // There is a control map element for each protocol.
 BPF_PERCPU_ARRAY(control_map, uint64_t, kNumProtocols);
 
+// The fraction of connections of each protocol whose data is traced,
+// in parts per kSamplingRateScale.
+BPF_PERCPU_ARRAY(sampling_rates_map, int32_t, kNumProtocols);
+
+// The most bytes of each message of a protocol that are copied to user-space. The rest of the
+// message is only reported by its size, so that user-space can skip over it. Zero means no limit.
+BPF_PERCPU_ARRAY(capture_limits_map, int32_t, kNumProtocols);
+
+// Lower sampling rates for particular processes (e.g. those of a K8s namespace).
+// These are maintained by user-space, and apply on top of sampling_rates_map.
+BPF_HASH(tgid_sampling_rates_map, uint32_t, int32_t);
+
 // Map from user-space file descriptors to the connections obtained from accept() syscall.
 // Tracks connection from accept() -> close().
 // Key is {tgid, fd}.
@@ -105,6 +132,13 @@ BPF_HASH(active_sendfile_args_map, uint64_t, struct sendfile_args_t);
 BPF_PERCPU_ARRAY(socket_data_event_buffer_heap, struct socket_data_event_t, 1);
 BPF_PERCPU_ARRAY(conn_stats_event_buffer_heap, struct conn_stats_event_t, 1);
 
+#ifdef TLS_WRITE_COALESCE_BYTES
+// Keyed by tgid_fd. The pending writes of a connection are kept in a map rather than per CPU,
+// since the thread writing to it may move to another CPU between writes.
+BPF_HASH(tls_write_coalesce_map, uint64_t, struct tls_write_coalesce_t, 4096);
+BPF_PERCPU_ARRAY(tls_write_coalesce_heap, struct tls_write_coalesce_t, 1);
+#endif
+
 // This array records singular values that are used by probes. We group them together to reduce the
 // number of arrays with only 1 element.
 BPF_PERCPU_ARRAY(control_values, int64_t, kNumControlValues);
@@ -129,6 +163,8 @@ static __inline void init_conn_info(uint32_t tgid, int32_t fd, struct conn_info_
   // NOTE: BCC code defaults to 0, because kRoleUnknown is not 0, must explicitly initialize.
   conn_info->role = kRoleUnknown;
   conn_info->addr.sa.sa_family = PX_AF_UNKNOWN;
+  conn_info->sampling_draw = bpf_get_prandom_u32() % kSamplingRateScale;
+  conn_info->sampling_rate = kSamplingRateUnset;
 }
 
 // Be careful calling this function. The automatic creation of BPF map entries can result in a
@@ -167,6 +203,7 @@ static __inline struct socket_data_event_t* fill_socket_data_event(
   event->attr.role = conn_info->role;
   event->attr.pos = (direction == kEgress) ? conn_info->wr_bytes : conn_info->rd_bytes;
   event->attr.prepend_length_header = conn_info->prepend_length_header;
+  event->attr.sampling_rate = conn_info->sampling_rate;
   bpf_probe_read(&event->attr.length_header, 4, conn_info->prev_buf);
   return event;
 }
@@ -207,8 +244,27 @@ static __inline bool should_trace_conn(struct conn_info_t* conn_info) {
   return should_trace_sockaddr_family(conn_info->addr.sa.sa_family);
 }
 
+// Decides whether the data of the connection is sampled. The decision can only be made once the
+// protocol is known, but it's based on the draw made when the connection was opened, and it's
+// fixed from then on.
+static __inline bool is_conn_sampled(struct conn_info_t* conn_info) {
+  if (conn_info->sampling_rate == kSamplingRateUnset) {
+    uint32_t protocol = conn_info->protocol;
+    int32_t* protocol_rate = sampling_rates_map.lookup(&protocol);
+    int32_t rate = (protocol_rate == NULL) ? kSamplingRateScale : *protocol_rate;
+
+    uint32_t tgid = conn_info->conn_id.upid.tgid;
+    int32_t* tgid_rate = tgid_sampling_rates_map.lookup(&tgid);
+    if (tgid_rate != NULL && *tgid_rate < rate) {
+      rate = *tgid_rate;
+    }
+    conn_info->sampling_rate = rate;
+  }
+  return conn_info->sampling_draw < conn_info->sampling_rate;
+}
+
 // If this returns false, we still will trace summary stats.
-static __inline bool should_trace_protocol_data(const struct conn_info_t* conn_info) {
+static __inline bool should_trace_protocol_data(struct conn_info_t* conn_info) {
   if (conn_info->protocol == kProtocolUnknown) {
     return false;
   }
@@ -216,7 +272,7 @@ static __inline bool should_trace_protocol_data(const struct conn_info_t* conn_i
   uint32_t protocol = conn_info->protocol;
   uint64_t kZero = 0;
   uint64_t control = *control_map.lookup_or_init(&protocol, &kZero);
-  return control & conn_info->role;
+  return (control & conn_info->role) && is_conn_sampled(conn_info);
 }
 
 static __inline bool is_stirling_tgid(const uint32_t tgid) {
@@ -272,6 +328,15 @@ static __inline void update_traffic_class(struct conn_info_t* conn_info,
     conn_info->protocol = inferred_protocol.protocol;
   }
 
+  // The data starts a new message, so the capture limit starts over.
+  if (inferred_protocol.protocol == conn_info->protocol) {
+    if (direction == kEgress) {
+      conn_info->wr_msg_captured_bytes = 0;
+    } else {
+      conn_info->rd_msg_captured_bytes = 0;
+    }
+  }
+
   // Update role if not set.
   if (conn_info->role == kRoleUnknown &&
       // As of 2020-01, Redis protocol detection doesn't implement message type detection.
@@ -322,6 +387,36 @@ static __inline void read_sockaddr_kernel(struct conn_info_t* conn_info,
   }
 }
 
+static __inline void submit_socket_data_event(struct pt_regs* ctx,
+                                              struct socket_data_event_t* event, size_t size) {
+#ifdef SOCKET_TRACE_USE_RINGBUF
+  if (socket_data_events.ringbuf_output(event, size, 0) != 0) {
+    int kZero = 0;
+    uint64_t* lost = socket_data_events_lost.lookup(&kZero);
+    if (lost != NULL) {
+      ++(*lost);
+    }
+  }
+#else
+  socket_data_events.perf_submit(ctx, event, size);
+#endif
+}
+
+static __inline void submit_socket_control_event(struct pt_regs* ctx,
+                                                 struct socket_control_event_t* event) {
+#ifdef SOCKET_TRACE_USE_RINGBUF
+  if (socket_control_events.ringbuf_output(event, sizeof(struct socket_control_event_t), 0) != 0) {
+    int kZero = 0;
+    uint64_t* lost = socket_control_events_lost.lookup(&kZero);
+    if (lost != NULL) {
+      ++(*lost);
+    }
+  }
+#else
+  socket_control_events.perf_submit(ctx, event, sizeof(struct socket_control_event_t));
+#endif
+}
+
 static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t fd,
                                      const struct sockaddr* addr, const struct socket* socket,
                                      enum endpoint_role_t role) {
@@ -351,7 +446,7 @@ static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t
   control_event.open.addr = conn_info.addr;
   control_event.open.role = conn_info.role;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  submit_socket_control_event(ctx, &control_event);
 }
 
 static __inline void submit_close_event(struct pt_regs* ctx, struct conn_info_t* conn_info) {
@@ -362,14 +457,47 @@ static __inline void submit_close_event(struct pt_regs* ctx, struct conn_info_t*
   control_event.close.rd_bytes = conn_info->rd_bytes;
   control_event.close.wr_bytes = conn_info->wr_bytes;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  submit_socket_control_event(ctx, &control_event);
 }
 
-// Writes the input buf to event, and submits the event to the corresponding perf buffer.
-// Returns the bytes output from the input buf. Note that is not the total bytes submitted to the
-// perf buffer, which includes additional metadata.
+// Returns how many more bytes of the current message may be copied to user-space,
+// or -1 if the capture of the connection's protocol is not limited.
+static __inline int64_t get_capture_budget(const struct conn_info_t* conn_info,
+                                           enum traffic_direction_t direction) {
+  uint32_t protocol = conn_info->protocol;
+  int32_t* limit = capture_limits_map.lookup(&protocol);
+  if (limit == NULL || *limit <= 0) {
+    return -1;
+  }
+  int64_t captured = (direction == kEgress) ? conn_info->wr_msg_captured_bytes
+                                            : conn_info->rd_msg_captured_bytes;
+  return (captured >= *limit) ? 0 : *limit - captured;
+}
+
+// Returns how many bytes of a buf_size chunk to copy, and deducts them from the budget.
+static __inline size_t consume_capture_budget(int64_t* budget, size_t buf_size) {
+  if (*budget < 0) {
+    return buf_size;
+  }
+  size_t copy_size = (buf_size < *budget) ? buf_size : *budget;
+  *budget -= copy_size;
+  return copy_size;
+}
+
+static __inline void add_captured_bytes(struct conn_info_t* conn_info,
+                                        enum traffic_direction_t direction, size_t count) {
+  if (direction == kEgress) {
+    conn_info->wr_msg_captured_bytes += count;
+  } else {
+    conn_info->rd_msg_captured_bytes += count;
+  }
+}
+
+// Writes the first copy_size bytes of the input buf to event, and submits the event to the
+// corresponding perf buffer. The event still reports buf_size as the size of the data, so that
+// user-space knows how many bytes were left out.
 static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_direction_t direction,
-                                     const char* buf, size_t buf_size,
+                                     const char* buf, size_t buf_size, size_t copy_size,
                                      struct conn_info_t* conn_info,
                                      struct socket_data_event_t* event) {
   // Record original size of packet. This may get truncated below before submit.
@@ -407,25 +535,32 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_dir
     return;
   }
 
-  // Note that buf_size_minus_1 will be positive due to the if-statement above.
-  size_t buf_size_minus_1 = buf_size - 1;
+  // The capture limit of the message was reached, so only the size of the data is reported.
+  if (copy_size == 0) {
+    event->attr.msg_buf_size = 0;
+    submit_socket_data_event(ctx, event, sizeof(event->attr));
+    return;
+  }
+
+  // Note that copy_size_minus_1 will be positive due to the if-statement above.
+  size_t copy_size_minus_1 = copy_size - 1;
 
   // Clang is too smart for us, and tries to remove some of the obvious hints we are leaving for the
   // BPF verifier. So we add this NOP volatile statement, so clang can't optimize away some of our
   // if-statements below.
-  // By telling clang that buf_size_minus_1 is both an input and output to some black box assembly
+  // By telling clang that copy_size_minus_1 is both an input and output to some black box assembly
   // code, clang has to discard any assumptions on what values this variable can take.
-  asm volatile("" : "+r"(buf_size_minus_1) :);
+  asm volatile("" : "+r"(copy_size_minus_1) :);
 
-  buf_size = buf_size_minus_1 + 1;
+  copy_size = copy_size_minus_1 + 1;
 
   // 4.14 kernels reject bpf_probe_read with size that they may think is zero.
   // Without the if statement, it somehow can't reason that the bpf_probe_read is non-zero.
   size_t amount_copied = 0;
-  if (buf_size_minus_1 < MAX_MSG_SIZE) {
-    bpf_probe_read(&event->msg, buf_size, buf);
-    amount_copied = buf_size;
-  } else if (buf_size_minus_1 < 0x7fffffff) {
+  if (copy_size_minus_1 < MAX_MSG_SIZE) {
+    bpf_probe_read(&event->msg, copy_size, buf);
+    amount_copied = copy_size;
+  } else if (copy_size_minus_1 < 0x7fffffff) {
     // If-statement condition above is only required to prevent clang from optimizing
     // away the `if (amount_copied > 0)` below.
     bpf_probe_read(&event->msg, MAX_MSG_SIZE, buf);
@@ -435,7 +570,7 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_dir
   // If-statement is redundant, but is required to keep the 4.14 verifier happy.
   if (amount_copied > 0) {
     event->attr.msg_buf_size = amount_copied;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + amount_copied);
+    submit_socket_data_event(ctx, event, sizeof(event->attr) + amount_copied);
   }
 }
 
@@ -445,18 +580,29 @@ static __inline void perf_submit_wrapper(struct pt_regs* ctx,
                                          struct socket_data_event_t* event) {
   int bytes_sent = 0;
   unsigned int i;
+  int64_t budget = get_capture_budget(conn_info, direction);
+  const int64_t initial_budget = budget;
 
 #pragma unroll
   for (i = 0; i < CHUNK_LIMIT; ++i) {
     const int bytes_remaining = buf_size - bytes_sent;
-    const size_t current_size =
+    size_t current_size =
         (bytes_remaining > MAX_MSG_SIZE && (i != CHUNK_LIMIT - 1)) ? MAX_MSG_SIZE : bytes_remaining;
-    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, conn_info, event);
+    // Once the budget is spent, a single data-less event accounts for all the remaining data.
+    if (budget == 0) {
+      current_size = bytes_remaining;
+    }
+    const size_t copy_size = consume_capture_budget(&budget, current_size);
+    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, copy_size, conn_info, event);
     bytes_sent += current_size;
 
     // Move the position for the next event.
     event->attr.pos += current_size;
   }
+
+  if (initial_budget > 0) {
+    add_captured_bytes(conn_info, direction, initial_budget - budget);
+  }
 }
 
 static __inline void perf_submit_iovecs(struct pt_regs* ctx,
@@ -469,6 +615,8 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
   // size of the written or read data. Therefore, when loop through the buffers, both the number of
   // buffers and the total size need to be checked. More details can be found on their man pages.
   int bytes_sent = 0;
+  int64_t budget = get_capture_budget(conn_info, direction);
+  const int64_t initial_budget = budget;
 #pragma unroll
   for (int i = 0; i < LOOP_LIMIT && i < iovlen && bytes_sent < total_size; ++i) {
     struct iovec iov_cpy;
@@ -479,7 +627,8 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
 
     // TODO(oazizi/yzhao): Should switch this to go through perf_submit_wrapper.
     //                     We don't have the BPF instruction count to do so right now.
-    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, conn_info, event);
+    const size_t copy_size = consume_capture_budget(&budget, iov_size);
+    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, copy_size, conn_info, event);
     bytes_sent += iov_size;
 
     // Move the position for the next event.
@@ -488,7 +637,78 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
 
   // TODO(oazizi): If there is data left after the loop limit, we should still report the remainder
   //               with a data-less event.
+
+  if (initial_budget > 0) {
+    add_captured_bytes(conn_info, direction, initial_budget - budget);
+  }
+}
+
+#ifdef TLS_WRITE_COALESCE_BYTES
+// Sends the pending coalesced TLS writes of the connection, if any, as one data event.
+static __inline void flush_tls_writes(struct pt_regs* ctx, uint64_t tgid_fd,
+                                      const struct conn_info_t* conn_info) {
+  struct tls_write_coalesce_t* pending = tls_write_coalesce_map.lookup(&tgid_fd);
+  if (pending == NULL) {
+    return;
+  }
+
+  // Writes of the previous generation of the fd are dropped, like the rest of its data.
+  uint32_t size = pending->attr.msg_buf_size;
+  if (pending->attr.conn_id.tsid == conn_info->conn_id.tsid && size > 0 &&
+      size <= MAX_TLS_WRITE_COALESCE_BYTES) {
+    // The protocol may have been inferred since the first write.
+    pending->attr.protocol = conn_info->protocol;
+    pending->attr.role = conn_info->role;
+    submit_socket_data_event(ctx, (struct socket_data_event_t*)pending,
+                             sizeof(pending->attr) + size);
+  }
+  tls_write_coalesce_map.delete(&tgid_fd);
+}
+
+// Adds a TLS write to the pending writes of the connection, flushing them first if the write
+// doesn't fit or is too late to join them. Returns false if the write must be sent on its own.
+static __inline bool coalesce_tls_write(struct pt_regs* ctx, uint64_t tgid_fd,
+                                        const struct data_args_t* args, size_t count,
+                                        const struct conn_info_t* conn_info) {
+  const uint64_t now = bpf_ktime_get_ns();
+  struct tls_write_coalesce_t* pending = tls_write_coalesce_map.lookup(&tgid_fd);
+  if (pending != NULL) {
+    uint32_t len = pending->attr.msg_buf_size;
+    if (pending->attr.conn_id.tsid == conn_info->conn_id.tsid && count > 0 &&
+        len + count <= TLS_WRITE_COALESCE_BYTES &&
+        now - pending->attr.timestamp_ns < kTLSWriteCoalesceTimeoutNS) {
+      // The masks don't change the values, since len < and count <= MAX_TLS_WRITE_COALESCE_BYTES,
+      // but they let the verifier prove that the copy stays within msg.
+      size_t offset = len & (MAX_TLS_WRITE_COALESCE_BYTES - 1);
+      size_t copy_size = ((count - 1) & (MAX_TLS_WRITE_COALESCE_BYTES - 1)) + 1;
+      bpf_probe_read(pending->msg + offset, copy_size, args->buf);
+      pending->attr.msg_size += copy_size;
+      pending->attr.msg_buf_size += copy_size;
+      return true;
+    }
+    flush_tls_writes(ctx, tgid_fd, conn_info);
+  }
+
+  if (count == 0 || count > TLS_WRITE_COALESCE_BYTES) {
+    return false;
+  }
+
+  // BPF programs are limited to a 512-byte stack, so the new entry is built per CPU.
+  uint32_t kZero = 0;
+  struct tls_write_coalesce_t* first = tls_write_coalesce_heap.lookup(&kZero);
+  struct socket_data_event_t* event = fill_socket_data_event(args->source_fn, kEgress, conn_info);
+  if (first == NULL || event == NULL) {
+    return false;
+  }
+  first->attr = event->attr;
+  size_t copy_size = ((count - 1) & (MAX_TLS_WRITE_COALESCE_BYTES - 1)) + 1;
+  bpf_probe_read(first->msg, copy_size, args->buf);
+  first->attr.msg_size = copy_size;
+  first->attr.msg_buf_size = copy_size;
+  // If the map is full, the write is sent on its own.
+  return tls_write_coalesce_map.update(&tgid_fd, first) == 0;
 }
+#endif
 
 /***********************************************************
  * Map cleanup functions
@@ -522,10 +742,41 @@ int conn_cleanup_uprobe(struct pt_regs* ctx) {
     if (tsid != NULL && *tsid == conn_id.tsid) {
       conn_disabled_map.delete(&tgid_fd);
     }
+
+#ifdef TLS_WRITE_COALESCE_BYTES
+    struct tls_write_coalesce_t* pending = tls_write_coalesce_map.lookup(&tgid_fd);
+    if (pending != NULL && pending->attr.conn_id.tsid == conn_id.tsid) {
+      tls_write_coalesce_map.delete(&tgid_fd);
+    }
+#endif
+  }
+
+  return 0;
+}
+
+#ifdef TLS_WRITE_COALESCE_BYTES
+// Sends the pending TLS writes of a connection that has had no events since they timed out.
+// The pending writes of a connection that is gone are dropped.
+int tls_write_flush_uprobe(struct pt_regs* ctx) {
+  struct conn_id_t* conn_id_ptr = (struct conn_id_t*)PT_REGS_PARM1(ctx);
+  struct conn_id_t conn_id = *conn_id_ptr;
+
+  uint64_t tgid_fd = gen_tgid_fd(conn_id.upid.tgid, conn_id.fd);
+
+  struct conn_info_t* conn_info = conn_info_map.lookup(&tgid_fd);
+  if (conn_info != NULL && conn_info->conn_id.tsid == conn_id.tsid) {
+    flush_tls_writes(ctx, tgid_fd, conn_info);
+    return 0;
+  }
+
+  struct tls_write_coalesce_t* pending = tls_write_coalesce_map.lookup(&tgid_fd);
+  if (pending != NULL && pending->attr.conn_id.tsid == conn_id.tsid) {
+    tls_write_coalesce_map.delete(&tgid_fd);
   }
 
   return 0;
 }
+#endif
 
 /***********************************************************
  * BPF syscall processing functions
@@ -649,6 +900,53 @@ static __inline bool should_send_data(uint32_t tgid, uint64_t conn_disabled_tsid
   return (force_trace_tgid || should_trace_protocol_data(conn_info));
 }
 
+#ifdef CONN_STATS_BPF_AGG
+// Adds the bytes of the connection since its last update, and its open and close, to the totals
+// of its remote endpoint in conn_stats_agg_map.
+static __inline void update_conn_stats_agg(struct conn_info_t* conn_info, bool close) {
+  // Like user-space, only the connections with a known role and an IP remote endpoint count.
+  sa_family_t family = conn_info->addr.sa.sa_family;
+  if (conn_info->role == kRoleUnknown || !(family == AF_INET || family == AF_INET6)) {
+    return;
+  }
+
+  struct conn_stats_agg_key_t key = {};
+  key.tgid = conn_info->conn_id.upid.tgid;
+  key.start_time_ticks = conn_info->conn_id.upid.start_time_ticks;
+  key.family = family;
+  // Collapse the connections from the changing ports of the clients of a server.
+  if (family == AF_INET) {
+    key.port = (conn_info->role == kRoleServer) ? 0 : conn_info->addr.in4.sin_port;
+    bpf_probe_read(key.addr, sizeof(struct in_addr), &conn_info->addr.in4.sin_addr);
+  } else {
+    key.port = (conn_info->role == kRoleServer) ? 0 : conn_info->addr.in6.sin6_port;
+    bpf_probe_read(key.addr, sizeof(struct in6_addr), &conn_info->addr.in6.sin6_addr);
+  }
+
+  struct conn_stats_agg_t new_stats = {};
+  struct conn_stats_agg_t* stats = conn_stats_agg_map.lookup_or_init(&key, &new_stats);
+  if (stats == NULL) {
+    return;
+  }
+  stats->protocol = conn_info->protocol;
+  stats->role = conn_info->role;
+  stats->ssl = conn_info->ssl;
+
+  // Connections of the same endpoint can be updated from several CPUs at once.
+  if (!conn_info->agg_open_counted) {
+    __sync_fetch_and_add(&stats->conn_open, 1);
+    conn_info->agg_open_counted = true;
+  }
+  __sync_fetch_and_add(&stats->bytes_sent, conn_info->wr_bytes - conn_info->agg_wr_bytes);
+  __sync_fetch_and_add(&stats->bytes_recv, conn_info->rd_bytes - conn_info->agg_rd_bytes);
+  conn_info->agg_wr_bytes = conn_info->wr_bytes;
+  conn_info->agg_rd_bytes = conn_info->rd_bytes;
+  if (close) {
+    __sync_fetch_and_add(&stats->conn_close, 1);
+  }
+}
+#endif
+
 static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t* conn_info,
                                        enum traffic_direction_t direction, ssize_t bytes_count) {
   // Update state of the connection.
@@ -661,6 +959,9 @@ static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t*
       break;
   }
 
+#ifdef CONN_STATS_BPF_AGG
+  update_conn_stats_agg(conn_info, /* close */ false);
+#else
   // Only send event if there's been enough of a change.
   // TODO(oazizi): Add elapsed time since last send as a triggering condition too.
   uint64_t total_bytes = conn_info->wr_bytes + conn_info->rd_bytes;
@@ -674,6 +975,7 @@ static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t*
 
     conn_info->last_reported_bytes = conn_info->rd_bytes + conn_info->wr_bytes;
   }
+#endif
 }
 
 static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t id,
@@ -732,7 +1034,25 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
       update_traffic_class(conn_info, direction, iov_cpy.iov_base, buf_size);
     }
 
-    if (should_send_data(tgid, conn_disabled_tsid, force_trace_tgid, conn_info)) {
+    bool send_data = should_send_data(tgid, conn_disabled_tsid, force_trace_tgid, conn_info);
+
+#ifdef TLS_WRITE_COALESCE_BYTES
+    // Small TLS writes are coalesced. Any other data of the connection flushes the pending writes
+    // first, so that user-space still gets the data of each direction in order. Messages with a
+    // capture limit are not coalesced, to keep the accounting of their budget simple.
+    if (ssl) {
+      if (send_data && !vecs && direction == kEgress &&
+          get_capture_budget(conn_info, direction) < 0) {
+        if (coalesce_tls_write(ctx, tgid_fd, args, bytes_count, conn_info)) {
+          send_data = false;
+        }
+      } else {
+        flush_tls_writes(ctx, tgid_fd, conn_info);
+      }
+    }
+#endif
+
+    if (send_data) {
       struct socket_data_event_t* event =
           fill_socket_data_event(args->source_fn, direction, conn_info);
       if (event == NULL) {
@@ -830,7 +1150,7 @@ static __inline void process_syscall_sendfile(struct pt_regs* ctx, uint64_t id,
     event->attr.pos = conn_info->wr_bytes;
     event->attr.msg_size = bytes_count;
     event->attr.msg_buf_size = 0;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr));
+    submit_socket_data_event(ctx, event, sizeof(event->attr));
   }
 
   update_conn_stats(ctx, conn_info, kEgress, bytes_count);
@@ -866,14 +1186,22 @@ static __inline void process_syscall_close(struct pt_regs* ctx, uint64_t id,
   // This is to avoid polluting the perf buffer.
   if (should_trace_sockaddr_family(conn_info->addr.sa.sa_family) || conn_info->wr_bytes != 0 ||
       conn_info->rd_bytes != 0) {
+#ifdef TLS_WRITE_COALESCE_BYTES
+    // The pending TLS writes must reach user-space before the close event.
+    flush_tls_writes(ctx, tgid_fd, conn_info);
+#endif
     submit_close_event(ctx, conn_info);
 
     // Report final conn stats event for this connection.
+#ifdef CONN_STATS_BPF_AGG
+    update_conn_stats_agg(conn_info, /* close */ true);
+#else
     struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
     if (event != NULL) {
       event->conn_events = event->conn_events | CONN_CLOSE;
       conn_stats_events.perf_submit(ctx, event, sizeof(struct conn_stats_event_t));
     }
+#endif
   }
 
   conn_info_map.delete(&tgid_fd);
@@ -28,9 +28,18 @@
 
 const char kControlMapName[] = "control_map";
 const char kControlValuesArrayName[] = "control_values";
+const char kSamplingRatesMapName[] = "sampling_rates_map";
+const char kTGIDSamplingRatesMapName[] = "tgid_sampling_rates_map";
+const char kCaptureLimitsMapName[] = "capture_limits_map";
+const char kConnStatsAggMapName[] = "conn_stats_agg_map";
 
 const int64_t kTraceAllTGIDs = -1;
 
+// Connection sampling rates are expressed in parts per kSamplingRateScale.
+const int32_t kSamplingRateScale = 10000;
+// The sampling rate of a connection whose protocol isn't known yet.
+const int32_t kSamplingRateUnset = -1;
+
 // Note: A value of 100 results in >4096 BPF instructions, which is too much for older kernels.
 #define CONN_CLEANUP_ITERS 85
 const int kMaxConnMapCleanupItems = CONN_CLEANUP_ITERS;
@@ -85,6 +94,24 @@ struct conn_info_t {
   size_t prev_count;
   char prev_buf[4];
   bool prepend_length_header;
+
+  // A uniformly random number in [0, kSamplingRateScale), drawn when the connection is opened.
+  // The connection's data is traced if it falls below the connection's sampling rate.
+  int32_t sampling_draw;
+  // The sampling rate that applied once the protocol of the connection was known. It stays fixed
+  // afterwards, so that a connection is either traced in full or not at all.
+  int32_t sampling_rate;
+
+  // The bytes copied to user-space since the start of the last message in each direction.
+  // Compared against the protocol's capture limit.
+  int64_t wr_msg_captured_bytes;
+  int64_t rd_msg_captured_bytes;
+
+  // The bytes written/read that were added to conn_stats_agg_map, and whether the open of the
+  // connection was counted there. Only used when conn stats are aggregated in BPF.
+  int64_t agg_wr_bytes;
+  int64_t agg_rd_bytes;
+  bool agg_open_counted;
 };
 
 // This struct is a subset of conn_info_t. It is used to communicate connect/accept events.
@@ -128,6 +155,10 @@ struct close_event_t {
 // and effectively makes the maximum message size to be CHUNK_LIMIT*MAX_MSG_SIZE.
 #define CHUNK_LIMIT 4
 
+// The most bytes of small TLS writes that BPF coalesces into one data event, when enabled with
+// --stirling_socket_tracer_tls_write_coalesce_bytes. Must be a power of 2.
+#define MAX_TLS_WRITE_COALESCE_BYTES 512
+
 // Unique ID to all syscalls and a few other notable functions.
 // This applies to all data events sent to socket_data_events perf buffer.
 enum source_function_t {
@@ -202,10 +233,29 @@ struct socket_data_event_t {
     // See infer_kafka_message in protocol_inference.h for details.
     bool prepend_length_header;
     uint32_t length_header;
+
+    // The sampling rate of the connection, in parts per kSamplingRateScale.
+    int32_t sampling_rate;
   } attr;
   char msg[MAX_MSG_SIZE];
 };
 
+// Adjacent small TLS writes of a connection, which BPF sends to user-space as one data event.
+// It is laid out like a socket_data_event_t with a smaller msg. The msg has room for twice the
+// coalesced bytes only so that the verifier can bound the copies into it.
+struct tls_write_coalesce_t {
+#ifdef __cplusplus
+  socket_data_event_t::attr_t attr;
+#else
+  struct attr_t attr;
+#endif
+  char msg[2 * MAX_TLS_WRITE_COALESCE_BYTES];
+};
+
+// Writes that come later than this after the first pending one are not coalesced with it.
+// User-space sends the pending writes that are older than this, in case no other event does.
+const uint64_t kTLSWriteCoalesceTimeoutNS = 10 * 1000 * 1000;
+
 #define CONN_OPEN (1 << 0)
 #define CONN_CLOSE (1 << 1)
 
@@ -230,6 +280,33 @@ struct conn_stats_event_t {
   uint32_t conn_events;
 };
 
+// The key of conn_stats_agg_map, which aggregates the conn stats in BPF. Like ConnStats::AggKey,
+// it identifies a local process and a remote endpoint. The fields are laid out without padding,
+// since the whole struct is hashed.
+struct conn_stats_agg_key_t {
+  uint32_t tgid;
+  // AF_INET or AF_INET6.
+  uint16_t family;
+  // The remote port in network byte order, or 0 if the local process is the server.
+  uint16_t port;
+  uint64_t start_time_ticks;
+  // The in_addr or in6_addr of the remote endpoint.
+  uint8_t addr[16];
+};
+
+// The running totals of all the connections of a conn_stats_agg_key_t. User-space reads them every
+// sampling period, and reports the keys whose totals changed.
+struct conn_stats_agg_t {
+  uint64_t conn_open;
+  uint64_t conn_close;
+  uint64_t bytes_sent;
+  uint64_t bytes_recv;
+  // Taken from the most recently updated connection.
+  enum traffic_protocol_t protocol;
+  enum endpoint_role_t role;
+  bool ssl;
+};
+
 enum control_event_type_t {
   kConnOpen,
   kConnClose,
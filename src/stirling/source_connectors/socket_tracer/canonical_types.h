@@ -62,6 +62,15 @@ constexpr DataElement kLatencyNS = {
     types::PatternType::METRIC_GAUGE,
 };
 
+constexpr DataElement kSampleWeight = {
+    "sample_weight",
+    "The number of connections that the record's connection stands for, when connections are "
+    "sampled. Scale counts by it to estimate the totals.",
+    types::DataType::FLOAT64,
+    types::SemanticType::ST_NONE,
+    types::PatternType::METRIC_GAUGE,
+};
+
 constexpr DataElement kPXInfo = {
     "px_info_",
     "Pixie messages regarding the record (e.g. warnings)",
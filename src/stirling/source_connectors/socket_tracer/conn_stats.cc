@@ -18,9 +18,12 @@
 
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 
+#include <cstring>
+
 #include <absl/strings/substitute.h>
 
 #include "src/common/base/base.h"
+#include "src/common/base/inet_utils.h"
 
 namespace px {
 namespace stirling {
@@ -83,5 +86,57 @@ absl::flat_hash_map<ConnStats::AggKey, ConnStats::Stats>& ConnStats::UpdateStats
   return agg_stats_;
 }
 
+absl::flat_hash_map<ConnStats::AggKey, ConnStats::Stats>& ConnStats::UpdateStats(
+    const std::vector<std::pair<struct conn_stats_agg_key_t, struct conn_stats_agg_t>>&
+        bpf_agg_stats) {
+  ++update_counter_;
+
+  // The trackers don't hold any stats in this mode, but still wait for their final stats to be
+  // reported before they are destroyed.
+  if (conn_trackers_mgr_ != nullptr) {
+    for (const auto& tracker : conn_trackers_mgr_->active_trackers()) {
+      if (tracker->IsZombie()) {
+        tracker->MarkFinalConnStatsReported();
+      }
+    }
+  }
+
+  for (const auto& [bpf_key, bpf_stats] : bpf_agg_stats) {
+    union sockaddr_t addr = {};
+    addr.sa.sa_family = bpf_key.family;
+    if (bpf_key.family == AF_INET) {
+      addr.in4.sin_port = bpf_key.port;
+      memcpy(&addr.in4.sin_addr, bpf_key.addr, sizeof(addr.in4.sin_addr));
+    } else {
+      addr.in6.sin6_port = bpf_key.port;
+      memcpy(&addr.in6.sin6_addr, bpf_key.addr, sizeof(addr.in6.sin6_addr));
+    }
+    SockAddr remote_endpoint;
+    PopulateSockAddr(&addr.sa, &remote_endpoint);
+
+    upid_t upid = {};
+    upid.tgid = bpf_key.tgid;
+    upid.start_time_ticks = bpf_key.start_time_ticks;
+
+    AggKey key = BuildAggKey(upid, bpf_stats.role, remote_endpoint);
+    auto& stats = agg_stats_[key];
+
+    if (stats.conn_open != bpf_stats.conn_open || stats.conn_close != bpf_stats.conn_close ||
+        stats.bytes_sent != bpf_stats.bytes_sent || stats.bytes_recv != bpf_stats.bytes_recv) {
+      stats.last_update = update_counter_;
+    }
+    stats.addr_family = remote_endpoint.family;
+    stats.role = bpf_stats.role;
+    stats.protocol = bpf_stats.protocol;
+    stats.ssl = bpf_stats.ssl;
+    stats.conn_open = bpf_stats.conn_open;
+    stats.conn_close = bpf_stats.conn_close;
+    stats.bytes_sent = bpf_stats.bytes_sent;
+    stats.bytes_recv = bpf_stats.bytes_recv;
+  }
+
+  return agg_stats_;
+}
+
 }  // namespace stirling
 }  // namespace px
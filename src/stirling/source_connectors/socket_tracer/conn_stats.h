@@ -20,6 +20,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
@@ -27,6 +28,7 @@
 
 #include "src/shared/upid/upid.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 
 namespace px {
@@ -102,6 +104,17 @@ class ConnStats {
    */
   absl::flat_hash_map<AggKey, Stats>& UpdateStats();
 
+  /**
+   * Updates the internal state from the entries of conn_stats_agg_map, when the stats are
+   * aggregated in BPF rather than from the events of each tracker. The entries hold running totals,
+   * so the stats that changed since the previous readout are the active ones.
+   *
+   * @return A mutable reference to all the aggregated connection stats, as above.
+   */
+  absl::flat_hash_map<AggKey, Stats>& UpdateStats(
+      const std::vector<std::pair<struct conn_stats_agg_key_t, struct conn_stats_agg_t>>&
+          bpf_agg_stats);
+
   bool Active(const Stats& stats) { return update_counter_ == stats.last_update; }
 
  private:
@@ -418,5 +418,57 @@ TEST_F(ConnStatsBPFTest, SSLConnections) {
   }
 }
 
+class ConnStatsBPFAggTest : public ConnStatsBPFTest {
+ public:
+  ConnStatsBPFAggTest() { FLAGS_stirling_conn_stats_bpf_aggregation = true; }
+  ~ConnStatsBPFAggTest() { FLAGS_stirling_conn_stats_bpf_aggregation = false; }
+};
+
+// Checks that the stats aggregated in BPF match the ones built from conn stats events.
+TEST_F(ConnStatsBPFAggTest, UnclassifiedEvents) {
+  StartTransferDataThread();
+
+  SendRecvScript script = {{{"req1"}, {"resp1"}}, {{"req2"}, {"resp2"}}};
+
+  // The server needs to be slow, so that the client is alive long enough for it to be discovered
+  // by the TransferDataThread.
+  std::chrono::milliseconds server_response_latency{200};
+
+  ClientServerSystem cs(server_response_latency);
+  cs.RunClientServer<&TCPSocket::Read, &TCPSocket::Write>(script);
+
+  StopTransferDataThread();
+
+  std::vector<TaggedRecordBatch> tablets = ConsumeRecords(SocketTraceConnector::kConnStatsTableNum);
+  ASSERT_FALSE(tablets.empty());
+  const types::ColumnWrapperRecordBatch& rb = tablets[0].records;
+
+  {
+    auto indices = FindRecordIdxMatchesPID(rb, kUPIDIdx, cs.ServerPID());
+    ASSERT_FALSE(indices.empty());
+    int idx = indices.back();
+
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kConnOpenIdx, idx).val, 1);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kConnCloseIdx, idx).val, 1);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kBytesSentIdx, idx).val, 10);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kBytesRecvIdx, idx).val, 8);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kAddrFamilyIdx, idx).val,
+              static_cast<int>(SockAddrFamily::kIPv4));
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kRoleIdx, idx).val, kRoleServer);
+  }
+
+  {
+    auto indices = FindRecordIdxMatchesPID(rb, kUPIDIdx, cs.ClientPID());
+    ASSERT_FALSE(indices.empty());
+    int idx = indices.back();
+
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kConnOpenIdx, idx).val, 1);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kConnCloseIdx, idx).val, 1);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kBytesSentIdx, idx).val, 8);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kBytesRecvIdx, idx).val, 10);
+    EXPECT_EQ(AccessRecordBatch<types::Int64Value>(rb, kRoleIdx, idx).val, kRoleClient);
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
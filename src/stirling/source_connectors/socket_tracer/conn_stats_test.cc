@@ -396,5 +396,65 @@ TEST_F(ConnStatsTest, DisabledConnTracker) {
               ElementsAre(Pair(AggKeyIs(11111, "1.1.1.1", 80), StatsIs(1, 1, 200, 100))));
 }
 
+// Model the readout of the totals that BPF aggregates in conn_stats_agg_map.
+TEST_F(ConnStatsTest, BPFAggregatedStats) {
+  struct conn_stats_agg_key_t client_key = {};
+  client_key.tgid = 11111;
+  client_key.start_time_ticks = 1000;
+  client_key.family = AF_INET;
+  client_key.port = htons(80);
+  const uint32_t kServerAddr = 0x01010101;  // 1.1.1.1
+  memcpy(client_key.addr, &kServerAddr, sizeof(kServerAddr));
+
+  struct conn_stats_agg_t client_stats = {};
+  client_stats.protocol = kProtocolHTTP;
+  client_stats.role = kRoleClient;
+  client_stats.conn_open = 1;
+  client_stats.bytes_sent = 200;
+  client_stats.bytes_recv = 100;
+
+  // BPF zeroes the port of the clients of servers.
+  struct conn_stats_agg_key_t server_key = {};
+  server_key.tgid = 22222;
+  server_key.start_time_ticks = 2000;
+  server_key.family = AF_INET6;
+  server_key.addr[15] = 1;  // ::1
+
+  struct conn_stats_agg_t server_stats = {};
+  server_stats.role = kRoleServer;
+  server_stats.conn_open = 2;
+  server_stats.conn_close = 1;
+  server_stats.bytes_sent = 10;
+  server_stats.bytes_recv = 20;
+
+  auto& agg_stats =
+      conn_stats_.UpdateStats({{client_key, client_stats}, {server_key, server_stats}});
+  EXPECT_THAT(agg_stats,
+              UnorderedElementsAre(Pair(AggKeyIs(11111, "1.1.1.1", 80), StatsIs(1, 0, 200, 100)),
+                                   Pair(AggKeyIs(22222, "::1", 0), StatsIs(2, 1, 10, 20))));
+  for (const auto& [key, stats] : agg_stats) {
+    EXPECT_TRUE(conn_stats_.Active(stats)) << key.ToString();
+  }
+  ConnStats::AggKey client_agg_key = {
+      .upid = {.tgid = 11111, .start_time_ticks = 1000},
+      .remote_addr = "1.1.1.1",
+      .remote_port = 80,
+  };
+  EXPECT_EQ(agg_stats.at(client_agg_key).protocol, kProtocolHTTP);
+  EXPECT_EQ(agg_stats.at(client_agg_key).addr_family, SockAddrFamily::kIPv4);
+
+  // The map holds running totals. Only the stats that changed since the last readout are active.
+  client_stats.bytes_sent = 300;
+  client_stats.conn_close = 1;
+  auto& updated_stats =
+      conn_stats_.UpdateStats({{client_key, client_stats}, {server_key, server_stats}});
+  EXPECT_THAT(updated_stats,
+              UnorderedElementsAre(Pair(AggKeyIs(11111, "1.1.1.1", 80), StatsIs(1, 1, 300, 100)),
+                                   Pair(AggKeyIs(22222, "::1", 0), StatsIs(2, 1, 10, 20))));
+  for (const auto& [key, stats] : updated_stats) {
+    EXPECT_EQ(conn_stats_.Active(stats), key.upid.tgid == 11111) << key.ToString();
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
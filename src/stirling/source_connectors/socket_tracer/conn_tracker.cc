@@ -126,6 +126,7 @@ void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
   SetRole(event->attr.role, "inferred from data_event");
   SetProtocol(event->attr.protocol, "inferred from data_event");
   SetSSL(event->attr.ssl, "inferred from data_event");
+  sampling_rate_ = event->attr.sampling_rate;
 
   CheckTracker();
   UpdateTimestamps(event->attr.timestamp_ns);
@@ -562,6 +563,10 @@ void ConnTracker::MarkForDeath(int32_t countdown) {
   } else {
     death_countdown_ = countdown;
   }
+
+  if (manager_ != nullptr) {
+    manager_->ScheduleCleanup(this);
+  }
 }
 
 bool ConnTracker::IsZombie() const { return death_countdown_ >= 0; }
@@ -268,7 +268,8 @@ class ConnTracker : NotCopyMoveable {
 
     UpdateResultStats(result);
 
-    return result.records;
+    // The records are a member of the result, so they aren't implicitly moved out of it.
+    return std::move(result.records);
   }
 
   /**
@@ -308,6 +309,14 @@ class ConnTracker : NotCopyMoveable {
   bool ssl() const { return ssl_; }
   ConnStatsTracker& conn_stats() { return conn_stats_; }
 
+  /**
+   * The inverse of the fraction of connections like this one that are traced, as decided in BPF.
+   * Aggregates over the records of sampled connections are scaled by this to estimate the totals.
+   */
+  double sample_weight() const {
+    return sampling_rate_ > 0 ? static_cast<double>(kSamplingRateScale) / sampling_rate_ : 1.0;
+  }
+
   /**
    * Get remote IP endpoint of the connection.
    *
@@ -630,6 +639,8 @@ class ConnTracker : NotCopyMoveable {
   traffic_protocol_t protocol_ = kProtocolUnknown;
   endpoint_role_t role_ = kRoleUnknown;
   bool ssl_ = false;
+  // The sampling rate reported by BPF, in parts per kSamplingRateScale.
+  int32_t sampling_rate_ = 0;
   SocketOpen open_info_;
   SocketClose close_info_;
   ConnStatsTracker conn_stats_;
@@ -696,9 +707,14 @@ class ConnTracker : NotCopyMoveable {
   template <typename TProtocolTraits>
   friend std::string DebugString(const ConnTracker& c, std::string_view prefix);
 
-  // A pointer to the conn trackers manager, used for notifying a protocol change.
+  // A pointer to the conn trackers manager, used for scheduling the tracker's cleanup.
   ConnTrackersManager* manager_ = nullptr;
 
+  // Bookkeeping of the manager: the index of the tracker in its active trackers,
+  // and whether the tracker is in its cleanup wheel.
+  size_t active_index_ = 0;
+  bool cleanup_scheduled_ = false;
+
   friend class ConnTrackersManager;
   // A subclass expose private member as public.
   friend class ConnTrackerTestDouble;
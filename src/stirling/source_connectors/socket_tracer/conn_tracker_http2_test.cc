@@ -279,6 +279,26 @@ TEST_F(ConnTrackerHTTP2Test, HTTP2StreamsCleanedUpAfterBreachingSizeLimit) {
   EXPECT_EQ(tracker_.http2_server_streams_size(), 0);
 }
 
+TEST_F(ConnTrackerHTTP2Test, HTTP2StreamsEvictedOldestFirst) {
+  const int kStreamID = 7;
+  auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
+  auto header_event1 = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
+  auto header_event2 = frame_generator.GenHeader<kHeaderEventWrite>(":scheme", "https");
+  // Both streams are on the same side, the second one being more recently active.
+  header_event2->attr.stream_id = 9;
+
+  auto expiry_timestamp = std::chrono::steady_clock::now() - std::chrono::seconds(10000);
+  tracker_.AddHTTP2Header(std::move(header_event1));
+  tracker_.AddHTTP2Header(std::move(header_event2));
+  tracker_.ProcessToRecords<http2::ProtocolTraits>();
+  EXPECT_EQ(tracker_.http2_client_streams_size(), 2);
+
+  // Only the older stream, with 11 bytes of headers, has to go to fit in the limit.
+  const int size_limit_bytes = 12;
+  tracker_.Cleanup<http2::ProtocolTraits>(size_limit_bytes, expiry_timestamp);
+  EXPECT_EQ(tracker_.http2_client_streams_size(), 1);
+}
+
 TEST_F(ConnTrackerHTTP2Test, HTTP2StreamsCleanedUpAfterExpiration) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
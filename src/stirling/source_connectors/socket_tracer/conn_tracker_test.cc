@@ -96,6 +96,20 @@ TEST_F(ConnTrackerTest, timestamp_test) {
   EXPECT_EQ(8, tracker.last_bpf_timestamp_ns());
 }
 
+TEST_F(ConnTrackerTest, SampleWeight) {
+  struct socket_control_event_t conn = event_gen_.InitConn();
+  std::unique_ptr<SocketDataEvent> req0 = event_gen_.InitSendEvent<kProtocolHTTP>(kHTTPReq0);
+  // One in eight connections of this kind are traced.
+  req0->attr.sampling_rate = kSamplingRateScale / 8;
+
+  ConnTracker tracker;
+  tracker.AddControlEvent(conn);
+  // Until BPF reports a sampling rate, a record only stands for itself.
+  EXPECT_EQ(tracker.sample_weight(), 1.0);
+  tracker.AddDataEvent(std::move(req0));
+  EXPECT_EQ(tracker.sample_weight(), 8.0);
+}
+
 TEST_F(ConnTrackerTest, ReqRespMatchingSimple) {
   testing::EventGenerator event_gen(&real_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
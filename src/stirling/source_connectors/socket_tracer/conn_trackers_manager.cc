@@ -18,188 +18,160 @@
 
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 
-DEFINE_double(
-    stirling_conn_tracker_cleanup_threshold, 0.2,
-    "Percentage of trackers that are ready for destruction that will trigger a memory cleanup");
+#include <algorithm>
 
 namespace px {
 namespace stirling {
 
-//-----------------------------------------------------------------------------
-// ConnTrackerGenerations
-//-----------------------------------------------------------------------------
-
-std::pair<ConnTracker*, bool> ConnTrackerGenerations::GetOrCreate(uint64_t tsid,
-                                                                  ConnTrackerPool* tracker_pool) {
-  std::unique_ptr<ConnTracker>& conn_tracker_ptr = generations_[tsid];
-  bool created = false;
-
-  // If conn_trackers[conn_id.tsid] does not exist, a new one will be created in the map.
-  // New trackers always have TSID == 0, while BPF should never generate a TSID of zero,
-  // so we use this as a way of detecting new trackers.
-  if (conn_tracker_ptr == nullptr) {
-    conn_tracker_ptr = tracker_pool->Pop();
-    created = true;
-
-    // If there is a another generation for this conn map key,
-    // one of them needs to be marked for death.
-    if (oldest_generation_ != nullptr) {
-      // If the inserted conn_tracker is not the last generation, then mark it for death.
-      // This can happen because the events draining from the perf buffers are not ordered.
-      if (tsid < oldest_generation_->conn_id().tsid) {
-        VLOG(1) << "Marking for death because not last generation.";
-        conn_tracker_ptr->MarkForDeath();
-      } else {
-        // New tracker was the last, so the previous last should be marked for death.
-        VLOG(1) << "Marking previous generation for death.";
-        oldest_generation_->MarkForDeath();
-        oldest_generation_ = conn_tracker_ptr.get();
-      }
-    } else {
-      oldest_generation_ = conn_tracker_ptr.get();
-    }
-  }
-
-  return std::make_pair(conn_tracker_ptr.get(), created);
-}
-
-bool ConnTrackerGenerations::Contains(uint64_t tsid) const { return generations_.contains(tsid); }
-
-StatusOr<const ConnTracker*> ConnTrackerGenerations::GetActive() const {
-  // Don't return trackers that are destroyed or about to be destroyed.
-  if (oldest_generation_ == nullptr || oldest_generation_->ReadyForDestruction()) {
-    return error::NotFound("No active connection trackers found");
-  }
-
-  return oldest_generation_;
-}
-
-int ConnTrackerGenerations::CleanupGenerations(ConnTrackerPool* tracker_pool) {
-  int num_erased = 0;
-
-  auto iter = generations_.begin();
-  while (iter != generations_.end()) {
-    auto& tracker = iter->second;
-
-    // Remove any trackers that are no longer required.
-    if (tracker->ReadyForDestruction()) {
-      if (tracker.get() == oldest_generation_) {
-        oldest_generation_ = nullptr;
-      }
-
-      tracker_pool->Recycle(std::move(tracker));
-
-      generations_.erase(iter++);
-      ++num_erased;
-    } else {
-      ++iter;
-    }
-  }
-
-  return num_erased;
-}
-
-//-----------------------------------------------------------------------------
-// ConnTrackersManager
-//-----------------------------------------------------------------------------
-
 namespace {
 
-constexpr size_t kMaxConnTrackerPoolSize = 2048;
-
 uint64_t GetConnMapKey(uint32_t pid, int32_t fd) { return (static_cast<uint64_t>(pid) << 32) | fd; }
 
 }  // namespace
 
-ConnTrackersManager::ConnTrackersManager() : trackers_pool_(kMaxConnTrackerPoolSize) {}
-
 ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_id) {
   const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
   DCHECK_NE(conn_map_key, 0) << "Connection map key cannot be 0, pid must be wrong";
 
-  ConnTrackerGenerations& conn_trackers = conn_id_tracker_generations_[conn_map_key];
-  auto [conn_tracker_ptr, created] = conn_trackers.GetOrCreate(conn_id.tsid, &trackers_pool_);
+  auto [iter, inserted] = trackers_by_conn_id_.try_emplace({conn_map_key, conn_id.tsid});
+  if (!inserted) {
+    ConnTracker* conn_tracker = trackers_.Get(iter->second);
+    DCHECK(conn_tracker != nullptr);
+    return *conn_tracker;
+  }
 
-  if (created) {
-    active_trackers_.push_back(conn_tracker_ptr);
-    conn_tracker_ptr->manager_ = this;
-    conn_tracker_ptr->SetConnID(conn_id);
+  auto [handle, conn_tracker] = trackers_.Create();
+  iter->second = handle;
+  conn_tracker->SetConnID(conn_id);
+
+  // If there is a another generation for this conn map key,
+  // one of them needs to be marked for death.
+  ConnTrackerGenerations& generations = conn_id_tracker_generations_[conn_map_key];
+  ++generations.num_generations;
+  ConnTracker* latest = trackers_.Get(generations.latest);
+  if (latest != nullptr && conn_id.tsid < latest->conn_id().tsid) {
+    // If the inserted conn_tracker is not the last generation, then mark it for death.
+    // This can happen because the events draining from the perf buffers are not ordered.
+    VLOG(1) << "Marking for death because not last generation.";
+    conn_tracker->MarkForDeath();
+  } else {
+    if (latest != nullptr) {
+      // New tracker was the last, so the previous last should be marked for death.
+      VLOG(1) << "Marking previous generation for death.";
+      latest->MarkForDeath();
+    }
+    generations.latest = handle;
+  }
 
-    stats_.Increment(StatKey::kTotal);
-    stats_.Increment(StatKey::kCreated);
+  conn_tracker->active_index_ = active_trackers_.size();
+  active_trackers_.push_back(conn_tracker);
+  conn_tracker->manager_ = this;
+
+  // The tracker may have been marked for death before it had a manager.
+  if (conn_tracker->IsZombie()) {
+    ScheduleCleanup(conn_tracker);
   }
 
+  stats_.Increment(StatKey::kTotal);
+  stats_.Increment(StatKey::kCreated);
+
   DebugChecks();
-  return *conn_tracker_ptr;
+  return *conn_tracker;
 }
 
 StatusOr<const ConnTracker*> ConnTrackersManager::GetConnTracker(uint32_t pid, int32_t fd) const {
-  const uint64_t conn_map_key = GetConnMapKey(pid, fd);
-
-  auto tracker_set_it = conn_id_tracker_generations_.find(conn_map_key);
-  if (tracker_set_it == conn_id_tracker_generations_.end()) {
+  auto iter = conn_id_tracker_generations_.find(GetConnMapKey(pid, fd));
+  if (iter == conn_id_tracker_generations_.end()) {
     return error::NotFound("Could not find the tracker with pid=$0 fd=$1.", pid, fd);
   }
 
-  const auto& tracker_generations = tracker_set_it->second;
-
-  if (tracker_generations.empty()) {
-    DCHECK(false) << "Map entry with no tracker generations should never exist. Entry should be "
-                     "deleted in such cases.";
-    return error::Internal("Corrupted state: map entry with no tracker generations.");
+  // Return last connection. Don't return trackers that are destroyed or about to be destroyed.
+  const ConnTracker* latest = trackers_.Get(iter->second.latest);
+  if (latest == nullptr || latest->ReadyForDestruction()) {
+    return error::NotFound("No active connection trackers found");
   }
+  return latest;
+}
 
-  // Return last connection.
-  return tracker_generations.GetActive();
+void ConnTrackersManager::ScheduleCleanup(ConnTracker* tracker) {
+  absl::MutexLock lock(&cleanup_lock_);
+  ScheduleCleanupLocked(tracker);
+}
+
+void ConnTrackersManager::ScheduleCleanupLocked(ConnTracker* tracker) {
+  // A tracker is in the wheel at most once. If its countdown gets shortened after it was
+  // scheduled, it is destroyed when the original entry expires, a few iterations late.
+  if (tracker->cleanup_scheduled_) {
+    return;
+  }
+  tracker->cleanup_scheduled_ = true;
+  uint64_t countdown = std::max(tracker->death_countdown_, 1);
+  cleanup_wheel_.Schedule(cleanup_wheel_.now() + countdown, tracker);
 }
 
 void ConnTrackersManager::CleanupTrackers() {
   {
-    auto iter = active_trackers_.begin();
-    while (iter != active_trackers_.end()) {
-      const auto& tracker = *iter;
+    absl::MutexLock lock(&cleanup_lock_);
+    expired_trackers_.clear();
+    cleanup_wheel_.Advance(&expired_trackers_);
+
+    // Trackers that aren't ready yet (e.g. still waiting for their final conn stats report)
+    // are checked again once their remaining countdown expires.
+    size_t num_ready = 0;
+    for (ConnTracker* tracker : expired_trackers_) {
+      tracker->cleanup_scheduled_ = false;
       if (tracker->ReadyForDestruction()) {
-        active_trackers_.erase(iter++);
-        stats_.Increment(StatKey::kReadyForDestruction);
+        expired_trackers_[num_ready++] = tracker;
       } else {
-        ++iter;
+        ScheduleCleanupLocked(tracker);
       }
     }
+    expired_trackers_.resize(num_ready);
   }
 
-  // As a performance optimization, we only clean up trackers once we reach a certain threshold
-  // of trackers that are ready for destruction.
-  // Trade-off is just how quickly we release memory and BPF map entries.
-  double percent_destroyable =
-      1.0 * stats_.Get(StatKey::kReadyForDestruction) / stats_.Get(StatKey::kTotal);
-  if (percent_destroyable > FLAGS_stirling_conn_tracker_cleanup_threshold) {
-    // Outer loop iterates through tracker sets (keyed by PID+FD),
-    // while inner loop iterates through generations of trackers for that PID+FD pair.
-    auto iter = conn_id_tracker_generations_.begin();
-    while (iter != conn_id_tracker_generations_.end()) {
-      auto& tracker_generations = iter->second;
-
-      int num_erased = tracker_generations.CleanupGenerations(&trackers_pool_);
-
-      stats_.Decrement(StatKey::kTotal, num_erased);
-      stats_.Decrement(StatKey::kReadyForDestruction, num_erased);
-      stats_.Increment(StatKey::kDestroyed, num_erased);
-
-      if (tracker_generations.empty()) {
-        conn_id_tracker_generations_.erase(iter++);
-        stats_.Increment(StatKey::kDestroyedGens);
-      } else {
-        ++iter;
-      }
-    }
+  for (ConnTracker* tracker : expired_trackers_) {
+    DestroyTracker(tracker);
   }
 
   DebugChecks();
 }
 
+void ConnTrackersManager::DestroyTracker(ConnTracker* tracker) {
+  // Swap the tracker with the last one, so that it can be popped off.
+  size_t index = tracker->active_index_;
+  DCHECK_LT(index, active_trackers_.size());
+  DCHECK_EQ(active_trackers_[index], tracker);
+  active_trackers_[index] = active_trackers_.back();
+  active_trackers_[index]->active_index_ = index;
+  active_trackers_.pop_back();
+
+  const conn_id_t& conn_id = tracker->conn_id();
+  const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
+  auto tracker_iter = trackers_by_conn_id_.find({conn_map_key, conn_id.tsid});
+  auto generations_iter = conn_id_tracker_generations_.find(conn_map_key);
+  DCHECK(tracker_iter != trackers_by_conn_id_.end());
+  DCHECK(generations_iter != conn_id_tracker_generations_.end());
+  if (tracker_iter == trackers_by_conn_id_.end() ||
+      generations_iter == conn_id_tracker_generations_.end()) {
+    return;
+  }
+
+  DCHECK_EQ(trackers_.Get(tracker_iter->second), tracker);
+  trackers_.Destroy(tracker_iter->second);
+  trackers_by_conn_id_.erase(tracker_iter);
+
+  stats_.Decrement(StatKey::kTotal);
+  stats_.Increment(StatKey::kDestroyed);
+
+  if (--generations_iter->second.num_generations == 0) {
+    conn_id_tracker_generations_.erase(generations_iter);
+    stats_.Increment(StatKey::kDestroyedGens);
+  }
+}
+
 void ConnTrackersManager::DebugChecks() const {
-  DCHECK_EQ(stats_.Get(StatKey::kTotal),
-            active_trackers_.size() + stats_.Get(StatKey::kReadyForDestruction));
+  DCHECK_EQ(stats_.Get(StatKey::kTotal), active_trackers_.size());
+  DCHECK_EQ(trackers_.size(), active_trackers_.size());
 }
 
 std::string ConnTrackersManager::DebugInfo() const {
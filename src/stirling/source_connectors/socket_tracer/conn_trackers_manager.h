@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <list>
 #include <map>
 #include <memory>
 #include <set>
@@ -26,60 +25,18 @@
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
-#include "src/stirling/utils/obj_pool.h"
+#include "src/stirling/utils/slab.h"
 #include "src/stirling/utils/stat_counter.h"
-
-DECLARE_double(stirling_conn_tracker_cleanup_threshold);
+#include "src/stirling/utils/timer_wheel.h"
 
 namespace px {
 namespace stirling {
 
-using ConnTrackerPool = ObjPool<ConnTracker>;
-
-/**
- * ConnTrackersGenerations is a container of tracker generations,
- * where a generation is identified by the timestamp ID (TSID).
- *
- * It automatically handles marking older generations for death.
- */
-class ConnTrackerGenerations {
- public:
-  /**
-   * Get ConnTracker by TSID, or return a new one if the TSID does not exist.
-   *
-   * @return The pointer to the conn_tracker and whether the tracker was newly created.
-   */
-  std::pair<ConnTracker*, bool> GetOrCreate(uint64_t tsid, ConnTrackerPool* tracker_pool);
-
-  /**
-   * Return true if a ConnTracker created at the specified time stamp exists.
-   */
-  bool Contains(uint64_t tsid) const;
-
-  /**
-   * Returns the oldest tracker, or error if the oldest tracker either has been destroyed
-   * or is ReadyForDestruction().
-   */
-  StatusOr<const ConnTracker*> GetActive() const;
-
-  const auto& generations() const { return generations_; }
-  bool empty() const { return generations_.empty(); }
-
-  /**
-   * Removes all trackers that are ReadyForDestruction().
-   * Removed trackers are pushed into the tracker pool for recycling.
-   */
-  int CleanupGenerations(ConnTrackerPool* tracker_pool);
-
- private:
-  // A map of TSID to ConnTrackers.
-  absl::flat_hash_map<uint64_t, std::unique_ptr<ConnTracker>> generations_;
-
-  // Keep a pointer to the ConnTracker generation with the highest TSID.
-  ConnTracker* oldest_generation_ = nullptr;
-};
-
 /**
  * ConnTrackersManager is a container that keeps track of all ConnTrackers.
  * Interface designed for two primary operations:
@@ -90,14 +47,13 @@ class ConnTrackersManager {
  public:
   enum class StatKey {
     kTotal,
-    kReadyForDestruction,
 
     kCreated,
     kDestroyed,
     kDestroyedGens,
   };
 
-  ConnTrackersManager();
+  ConnTrackersManager() = default;
 
   /**
    * Get a connection tracker for the specified conn_id. If a tracker does not exist,
@@ -105,7 +61,7 @@ class ConnTrackersManager {
    */
   ConnTracker& GetOrCreateConnTracker(struct conn_id_t conn_id);
 
-  const std::list<ConnTracker*>& active_trackers() const { return active_trackers_; }
+  const std::vector<ConnTracker*>& active_trackers() const { return active_trackers_; }
 
   /**
    * Returns the latest generation of a connection tracker for the given pid and fd.
@@ -114,12 +70,18 @@ class ConnTrackersManager {
   StatusOr<const ConnTracker*> GetConnTracker(uint32_t pid, int32_t fd) const;
 
   /**
-   * Deletes trackers that are ReadyForDestruction().
-   * Call this only after accumulating enough trackers to clean-up, to avoid the performance
-   * impact of scanning through all trackers every iteration.
+   * Deletes trackers that are ReadyForDestruction(). Meant to be called once per iteration.
+   * Only the trackers whose death countdown expires are visited, so the cost is proportional to
+   * the number of trackers that are destroyed, not the number of trackers.
    */
   void CleanupTrackers();
 
+  /**
+   * Schedules the tracker to be checked for destruction once its death countdown expires.
+   * Called by ConnTracker::MarkForDeath(), which may run on the parser threads.
+   */
+  void ScheduleCleanup(ConnTracker* tracker);
+
   /**
    * Returns extensive debug information about the connection trackers.
    */
@@ -139,16 +101,38 @@ class ConnTrackersManager {
   // Simple consistency DCHECKs meant for enforcing invariants.
   void DebugChecks() const;
 
-  // A map from conn_id (PID+FD+TSID) to tracker. This is for easy update on BPF events.
-  // Structured as two nested maps to be explicit about "generations" of trackers per PID+FD.
-  // Key is {PID, FD} for outer map, and tsid for inner map.
+  void ScheduleCleanupLocked(ConnTracker* tracker) ABSL_EXCLUSIVE_LOCKS_REQUIRED(cleanup_lock_);
+  void DestroyTracker(ConnTracker* tracker);
+
+  using TrackerSlab = Slab<ConnTracker>;
+  using TrackerHandle = TrackerSlab::Handle;
+
+  // The generations of trackers of a {PID, FD}, where a generation is identified by the TSID.
+  struct ConnTrackerGenerations {
+    // The generation with the highest TSID. Older generations are marked for death.
+    // Resolves to nullptr once that tracker is destroyed.
+    TrackerHandle latest;
+    int num_generations = 0;
+  };
+
+  // All trackers. The slab keeps them in contiguous pages, and reuses the memory of destroyed
+  // trackers for new ones.
+  TrackerSlab trackers_;
+
+  // A map from conn_id ({PID, FD}, TSID) to tracker. This is for easy update on BPF events.
+  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, TrackerHandle> trackers_by_conn_id_;
+
+  // The generations of trackers of each {PID, FD}.
   absl::flat_hash_map<uint64_t, ConnTrackerGenerations> conn_id_tracker_generations_;
 
-  std::list<ConnTracker*> active_trackers_;
+  // All trackers, in no particular order. Each tracker knows its index, so it can be removed
+  // by swapping it with the last tracker.
+  std::vector<ConnTracker*> active_trackers_;
 
-  // A pool of unused trackers that can be recycled.
-  // This is useful for avoiding memory reallocations.
-  ConnTrackerPool trackers_pool_;
+  // Zombie trackers, keyed by the iteration in which their death countdown expires.
+  absl::Mutex cleanup_lock_;
+  TimerWheel<ConnTracker*> cleanup_wheel_ ABSL_GUARDED_BY(cleanup_lock_);
+  std::vector<ConnTracker*> expired_trackers_;
 
   // Records statistics of ConnTracker for reporting and consistency check.
   utils::StatCounter<StatKey> stats_;
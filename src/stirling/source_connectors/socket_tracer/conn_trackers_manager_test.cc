@@ -107,8 +107,8 @@ TEST_F(ConnTrackersManagerTest, DebugInfo) {
 
   trackers_mgr_.GetOrCreateConnTracker(conn_id);
   std::string debug_info = trackers_mgr_.DebugInfo();
-  EXPECT_THAT(debug_info, HasSubstr("ConnTracker count statistics: kTotal=1 kReadyForDestruction=0 "
-                                    "kCreated=1 kDestroyed=0 kDestroyedGens=0"));
+  EXPECT_THAT(debug_info, HasSubstr("ConnTracker count statistics: kTotal=1 kCreated=1 kDestroyed=0 "
+                                    "kDestroyedGens=0"));
   EXPECT_THAT(
       debug_info,
       HasSubstr("conn_tracker=conn_id=[pid=1 start_time_ticks=1 fd=1 gen=1] state=kCollecting "
@@ -116,111 +116,97 @@ TEST_F(ConnTrackersManagerTest, DebugInfo) {
                 "ready_for_destruction=false\n"));
 }
 
-class ConnTrackerGenerationsTest : public ::testing::Test {
- protected:
-  ConnTrackerGenerationsTest() : tracker_pool(1024) {
-    FLAGS_stirling_check_proc_for_conn_close = false;
-  }
+// Tests that trackers are destroyed by the first CleanupTrackers() after they are ready,
+// and not before.
+TEST_F(ConnTrackersManagerTest, CleanupAfterDeathCountdown) {
+  struct conn_id_t conn_id = {};
+  conn_id.upid.pid = 1;
+  conn_id.fd = 1;
+  conn_id.tsid = 1;
+  ConnTracker& tracker1 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  conn_id.fd = 2;
+  ConnTracker& tracker2 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  ASSERT_EQ(trackers_mgr_.active_trackers().size(), 2);
+
+  tracker1.MarkForDeath(2);
+  tracker1.MarkFinalConnStatsReported();
+
+  tracker1.IterationPostTick();
+  CleanupTrackers();
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 2);
+
+  tracker1.IterationPostTick();
+  CleanupTrackers();
+  EXPECT_THAT(trackers_mgr_.active_trackers(), ::testing::ElementsAre(&tracker2));
+  EXPECT_NOT_OK(trackers_mgr_.GetConnTracker(1, 1));
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 2), &tracker2);
+
+  // Not ready until the final conn stats are reported.
+  tracker2.MarkForDeath(0);
+  CleanupTrackers();
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 1);
+  tracker2.MarkFinalConnStatsReported();
+  CleanupTrackers();
+  EXPECT_TRUE(trackers_mgr_.active_trackers().empty());
+}
 
-  std::pair<ConnTracker*, bool> GetOrCreateTracker(uint64_t tsid) {
-    auto [tracker, created] = tracker_gens_.GetOrCreate(tsid, &tracker_pool);
-    if (created) {
-      struct conn_id_t conn_id = {};
-      conn_id.tsid = tsid;
-      tracker->SetConnID(conn_id);
-    }
-    return {tracker, created};
-  }
+// Tests that only the generation of a {PID, FD} with the highest TSID stays alive.
+TEST_F(ConnTrackersManagerTest, Generations) {
+  struct conn_id_t conn_id = {};
+  conn_id.upid.pid = 1;
+  conn_id.fd = 1;
 
-  int CleanupTrackers() {
-    // Simulate elapsed iterations, which cause trackers to become ReadyForDestruction().
-    for (auto& [tsid, tracker] : tracker_gens_.generations()) {
-      for (int i = 0; i < ConnTracker::kDeathCountdownIters; ++i) {
-        tracker->IterationPostTick();
-      }
-      tracker->MarkFinalConnStatsReported();
+  conn_id.tsid = 1;
+  ConnTracker& tracker1 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 1), &tracker1);
+  EXPECT_FALSE(tracker1.IsZombie());
+
+  // A newer generation marks the previous one for death.
+  conn_id.tsid = 3;
+  ConnTracker& tracker3 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 1), &tracker3);
+  EXPECT_TRUE(tracker1.IsZombie());
+  EXPECT_FALSE(tracker3.IsZombie());
+
+  // An older generation that arrives late is marked for death itself.
+  conn_id.tsid = 2;
+  ConnTracker& tracker2 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 1), &tracker3);
+  EXPECT_TRUE(tracker2.IsZombie());
+  EXPECT_FALSE(tracker3.IsZombie());
+
+  // Existing generations are returned as is.
+  conn_id.tsid = 1;
+  EXPECT_EQ(&trackers_mgr_.GetOrCreateConnTracker(conn_id), &tracker1);
+  conn_id.tsid = 2;
+  EXPECT_EQ(&trackers_mgr_.GetOrCreateConnTracker(conn_id), &tracker2);
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 3);
+
+  for (ConnTracker* tracker : {&tracker1, &tracker2}) {
+    for (int i = 0; i < ConnTracker::kDeathCountdownIters; ++i) {
+      tracker->IterationPostTick();
     }
-
-    return tracker_gens_.CleanupGenerations(&tracker_pool);
+    tracker->MarkFinalConnStatsReported();
   }
-
-  ConnTrackerGenerations tracker_gens_;
-  ConnTrackerPool tracker_pool;
-};
-
-TEST_F(ConnTrackerGenerationsTest, Basic) {
-  ASSERT_TRUE(tracker_gens_.empty());
-  ASSERT_FALSE(tracker_gens_.Contains(1));
-
-  auto [tracker1, created1] = GetOrCreateTracker(1);
-  ASSERT_TRUE(tracker1 != nullptr);
-  ASSERT_TRUE(created1);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_TRUE(tracker_gens_.Contains(1));
-  ASSERT_FALSE(tracker_gens_.Contains(2));
-  ASSERT_FALSE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker1);
-
-  auto [tracker3, created3] = GetOrCreateTracker(3);
-  ASSERT_TRUE(tracker3 != nullptr);
-  ASSERT_TRUE(created3);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_TRUE(tracker_gens_.Contains(1));
-  ASSERT_FALSE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  auto [tracker2, created2] = GetOrCreateTracker(2);
-  ASSERT_TRUE(tracker2 != nullptr);
-  ASSERT_TRUE(created2);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_TRUE(tracker_gens_.Contains(1));
-  ASSERT_TRUE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  auto [tracker1b, created1b] = GetOrCreateTracker(1);
-  ASSERT_EQ(tracker1b, tracker1);
-  ASSERT_FALSE(created1b);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_TRUE(tracker_gens_.Contains(1));
-  ASSERT_TRUE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  auto [tracker2b, created2b] = GetOrCreateTracker(2);
-  ASSERT_EQ(tracker2b, tracker2);
-  ASSERT_FALSE(created2b);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_TRUE(tracker_gens_.Contains(1));
-  ASSERT_TRUE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  int num_erased1 = CleanupTrackers();
-  ASSERT_EQ(num_erased1, 2);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_FALSE(tracker_gens_.Contains(1));
-  ASSERT_FALSE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  int num_erased2 = CleanupTrackers();
-  ASSERT_EQ(num_erased2, 0);
-  ASSERT_FALSE(tracker_gens_.empty());
-  ASSERT_FALSE(tracker_gens_.Contains(1));
-  ASSERT_FALSE(tracker_gens_.Contains(2));
-  ASSERT_TRUE(tracker_gens_.Contains(3));
-  ASSERT_OK_AND_EQ(tracker_gens_.GetActive(), tracker3);
-
-  tracker3->MarkForDeath();
-  int num_erased3 = CleanupTrackers();
-  ASSERT_EQ(num_erased3, 1);
-  ASSERT_TRUE(tracker_gens_.empty());
-  ASSERT_FALSE(tracker_gens_.Contains(1));
-  ASSERT_FALSE(tracker_gens_.Contains(2));
-  ASSERT_FALSE(tracker_gens_.Contains(3));
-  ASSERT_NOT_OK(tracker_gens_.GetActive());
+  for (int i = 0; i < ConnTracker::kDeathCountdownIters; ++i) {
+    CleanupTrackers();
+  }
+  EXPECT_THAT(trackers_mgr_.active_trackers(), ::testing::ElementsAre(&tracker3));
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 1), &tracker3);
+
+  tracker3.MarkForDeath(0);
+  tracker3.MarkFinalConnStatsReported();
+  CleanupTrackers();
+  EXPECT_TRUE(trackers_mgr_.active_trackers().empty());
+  EXPECT_NOT_OK(trackers_mgr_.GetConnTracker(1, 1));
+  EXPECT_THAT(trackers_mgr_.StatsString(), HasSubstr("kDestroyed=3 kDestroyedGens=1"));
+
+  // The memory of destroyed trackers is reused, but the new tracker starts fresh.
+  conn_id.tsid = 4;
+  ConnTracker& tracker4 = trackers_mgr_.GetOrCreateConnTracker(conn_id);
+  EXPECT_FALSE(tracker4.IsZombie());
+  EXPECT_EQ(tracker4.conn_id().tsid, 4U);
+  EXPECT_OK_AND_EQ(trackers_mgr_.GetConnTracker(1, 1), &tracker4);
 }
 
 }  // namespace stirling
@@ -28,17 +28,29 @@ DEFINE_uint32(datastream_buffer_retention_size,
 DEFINE_uint32(datastream_buffer_spike_size,
               gflags::Uint32FromEnv("PL_DATASTREAM_BUFFER_SPIKE_SIZE", 500 * 1024 * 1024),
               "The maximum temporary size of a data stream buffer before processing.");
+DEFINE_uint32(datastream_max_filler_size,
+              gflags::Uint32FromEnv("PL_DATASTREAM_MAX_FILLER_SIZE", 1024 * 1024),
+              "The most bytes of uncaptured data in an event that are filled with zeros, "
+              "instead of leaving a gap in the data stream.");
 
 namespace px {
 namespace stirling {
 
 void DataStream::AddData(std::unique_ptr<SocketDataEvent> event) {
-  LOG_IF(WARNING, event->attr.msg_size > event->msg.size() && !event->msg.empty())
-      << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
-                          event->attr.msg_size, event->msg.size());
-
   data_buffer_.Add(event->attr.pos, event->msg, event->attr.timestamp_ns);
 
+  // BPF leaves out the part of the data beyond the capture limits, but still reports its size.
+  // Filling it in keeps the following data contiguous, so the parsers don't need to resync.
+  if (event->attr.msg_size > event->msg.size()) {
+    size_t filler_size = event->attr.msg_size - event->msg.size();
+    VLOG(1) << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
+                                event->attr.msg_size, event->msg.size());
+    if (filler_size <= FLAGS_datastream_max_filler_size) {
+      data_buffer_.AddFiller(event->attr.pos + event->msg.size(), filler_size,
+                             event->attr.timestamp_ns);
+    }
+  }
+
   has_new_events_ = true;
 }
 
@@ -30,6 +30,7 @@
 
 DECLARE_uint32(datastream_buffer_retention_size);
 DECLARE_uint32(datastream_buffer_spike_size);
+DECLARE_uint32(datastream_max_filler_size);
 
 namespace px {
 namespace stirling {
@@ -173,6 +173,31 @@ TEST_F(DataStreamTest, PartialMessageRecovery) {
   EXPECT_EQ(requests[1].req_path, "/bar.html");
 }
 
+TEST_F(DataStreamTest, TruncatedEventIsFilled) {
+  constexpr std::string_view kResp =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 10\r\n"
+      "\r\n"
+      "0123456789";
+
+  testing::EventGenerator event_gen(&real_clock_);
+  std::unique_ptr<SocketDataEvent> resp0 = event_gen.InitRecvEvent<kProtocolHTTP>(kResp);
+  std::unique_ptr<SocketDataEvent> resp1 = event_gen.InitRecvEvent<kProtocolHTTP>(kResp);
+  // BPF only copied the first bytes of the body, but reported the full size.
+  resp0->msg.resize(kResp.size() - 6);
+  protocols::NoState state{};
+
+  DataStream stream;
+  stream.AddData(std::move(resp0));
+  stream.AddData(std::move(resp1));
+
+  stream.ProcessBytesToFrames<http::Message>(message_type_t::kResponse, &state);
+  const auto& responses = stream.Frames<http::Message>();
+  ASSERT_THAT(responses, SizeIs(2));
+  EXPECT_EQ(responses[0].body, ConstString("0123\0\0\0\0\0\0"));
+  EXPECT_EQ(responses[1].body, "0123456789");
+}
+
 TEST_F(DataStreamTest, HeadAndMiddleMissing) {
   testing::EventGenerator event_gen(&real_clock_);
   std::unique_ptr<SocketDataEvent> req0b = event_gen.InitSendEvent<kProtocolHTTP>(
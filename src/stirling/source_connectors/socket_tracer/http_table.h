@@ -97,14 +97,23 @@ constexpr DataElement kHTTPElements[] = {
          types::SemanticType::ST_BYTES,
          types::PatternType::METRIC_GAUGE},
         canonical_data_elements::kLatencyNS,
+        canonical_data_elements::kSampleWeight,
 #ifndef NDEBUG
         canonical_data_elements::kPXInfo,
 #endif
 };
 // clang-format on
 
-constexpr auto kHTTPTable =
-    DataTableSchema("http_events", "HTTP request-response pair events", kHTTPElements);
+// HTTP events carry bodies of up to kMaxBodyBytes each, so a byte limit keeps a burst of
+// large responses from piling up between pushes.
+constexpr DataTablePushPolicy kHTTPPushPolicy = {
+    .max_records = 1024,
+    .max_bytes = 4 * 1024 * 1024,
+    .max_age = std::chrono::milliseconds{0},
+};
+
+constexpr auto kHTTPTable = DataTableSchema("http_events", "HTTP request-response pair events",
+                                            kHTTPElements, kHTTPPushPolicy);
 DEFINE_PRINT_TABLE(HTTP)
 
 constexpr int kHTTPTimeIdx = kHTTPTable.ColIndex("time_");
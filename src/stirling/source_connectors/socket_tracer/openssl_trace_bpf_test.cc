@@ -19,6 +19,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <limits>
 #include <string>
 
 #include "src/common/base/base.h"
@@ -241,5 +242,64 @@ TYPED_TEST(OpenSSLTraceTest, ssl_capture_node_client) {
   EXPECT_THAT(records.remote_address, UnorderedElementsAre(StrEq("127.0.0.1")));
 }
 
+// Checks that the records are the same when BPF coalesces the small TLS writes of the server.
+class OpenSSLCoalescedWritesTraceTest
+    : public OpenSSLTraceTest<NginxOpenSSL_1_1_1_ContainerWrapper> {
+ protected:
+  OpenSSLCoalescedWritesTraceTest() {
+    FLAGS_stirling_socket_tracer_tls_write_coalesce_bytes = MAX_TLS_WRITE_COALESCE_BYTES;
+  }
+  ~OpenSSLCoalescedWritesTraceTest() { FLAGS_stirling_socket_tracer_tls_write_coalesce_bytes = 0; }
+};
+
+TEST_F(OpenSSLCoalescedWritesTraceTest, ssl_capture_curl_client) {
+  StartTransferDataThread();
+
+  ::px::stirling::testing::CurlContainer client;
+  PL_CHECK_OK(client.Run(std::chrono::seconds{60},
+                         {absl::Substitute("--network=container:$0", server_.container_name())},
+                         {"--insecure", "-s", "-S", "https://localhost:443/index.html"}));
+  client.Wait();
+  StopTransferDataThread();
+
+  TraceRecords records = GetTraceRecords(server_.PID());
+  EXPECT_THAT(records.http_records, UnorderedElementsAre(EqHTTPRecord(GetExpectedHTTPRecord())));
+}
+
+// Checks that the TLS writes are sent on their own when there is no room to coalesce them.
+TEST_F(OpenSSLCoalescedWritesTraceTest, ssl_capture_curl_client_coalesce_map_full) {
+  auto coalesce_map =
+      source_->GetHashTable<uint64_t, struct tls_write_coalesce_t>("tls_write_coalesce_map");
+
+  // Fill the map with writes of a process that doesn't exist. They are never stale, so that
+  // user-space doesn't flush them.
+  struct tls_write_coalesce_t pending = {};
+  pending.attr.timestamp_ns = std::numeric_limits<uint64_t>::max() - kTLSWriteCoalesceTimeoutNS;
+  pending.attr.conn_id.upid.tgid = std::numeric_limits<uint32_t>::max();
+  size_t num_entries = 0;
+  for (int32_t fd = 0;; ++fd) {
+    pending.attr.conn_id.fd = fd;
+    uint64_t key = (uint64_t{pending.attr.conn_id.upid.tgid} << 32) | static_cast<uint32_t>(fd);
+    if (!coalesce_map.update_value(key, pending).ok()) {
+      break;
+    }
+    ++num_entries;
+  }
+  ASSERT_GT(num_entries, 0);
+
+  StartTransferDataThread();
+
+  ::px::stirling::testing::CurlContainer client;
+  PL_CHECK_OK(client.Run(std::chrono::seconds{60},
+                         {absl::Substitute("--network=container:$0", server_.container_name())},
+                         {"--insecure", "-s", "-S", "https://localhost:443/index.html"}));
+  client.Wait();
+  StopTransferDataThread();
+
+  TraceRecords records = GetTraceRecords(server_.PID());
+  EXPECT_THAT(records.http_records, UnorderedElementsAre(EqHTTPRecord(GetExpectedHTTPRecord())));
+  EXPECT_EQ(bpf_tools::BCCWrapper::GetHashTableEntries(&coalesce_map).size(), num_entries);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/parser_pool.h"
+
+namespace px {
+namespace stirling {
+
+ParserPool::ParserPool(size_t num_workers, std::string_view thread_placement)
+    : placer_("stirling_parser", thread_placement) {
+  DCHECK_GE(num_workers, 1U);
+  for (size_t i = 1; i < num_workers; ++i) {
+    threads_.emplace_back(&ParserPool::WorkerLoop, this, i);
+  }
+}
+
+ParserPool::~ParserPool() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ParserPool::Run(const std::function<void(size_t worker)>& fn) {
+  if (threads_.empty()) {
+    fn(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    DCHECK_EQ(num_running_, 0U) << "ParserPool::Run() is not reentrant.";
+    fn_ = &fn;
+    num_running_ = threads_.size();
+    ++generation_;
+  }
+  work_cv_.notify_all();
+
+  fn(0);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  done_cv_.wait(lock, [this] { return num_running_ == 0; });
+  fn_ = nullptr;
+}
+
+void ParserPool::WorkerLoop(size_t worker) {
+  placer_.PlaceCurrentThread();
+  uint64_t generation = 0;
+  while (true) {
+    const std::function<void(size_t)>* fn = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      work_cv_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+      if (stopping_) {
+        return;
+      }
+      generation = generation_;
+      fn = fn_;
+    }
+
+    (*fn)(worker);
+
+    bool last = false;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      last = --num_running_ == 0;
+    }
+    if (last) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
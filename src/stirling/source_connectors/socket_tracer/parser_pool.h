@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/common/system/thread_placement.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * ParserPool runs the protocol parsing of the socket tracer on a fixed set of workers.
+ *
+ * Each call to Run() executes the function once per worker, and returns once all of them are done.
+ * The calling thread acts as worker 0, so a pool of one worker runs everything inline. The workers
+ * are long-lived threads, so that a connection which is always hashed to the same worker keeps its
+ * state hot in that worker's caches.
+ *
+ * The worker threads are placed on the CPUs and NUMA nodes of the thread placement, see
+ * system::ThreadPlacer. Worker 0 keeps the placement of the calling thread.
+ */
+class ParserPool : public NotCopyMoveable {
+ public:
+  explicit ParserPool(size_t num_workers, std::string_view thread_placement = "");
+  ~ParserPool();
+
+  size_t num_workers() const { return threads_.size() + 1; }
+
+  /**
+   * Calls fn(worker) for every worker in [0, num_workers()), and waits for all calls to return.
+   * Not reentrant; only one Run() may be in progress at a time.
+   */
+  void Run(const std::function<void(size_t worker)>& fn);
+
+ private:
+  void WorkerLoop(size_t worker);
+
+  std::mutex lock_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+
+  // The function of the current Run(). Bumping the generation hands it to the workers.
+  const std::function<void(size_t)>* fn_ = nullptr;
+  uint64_t generation_ = 0;
+  size_t num_running_ = 0;
+  bool stopping_ = false;
+
+  const system::ThreadPlacer placer_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace stirling
+}  // namespace px
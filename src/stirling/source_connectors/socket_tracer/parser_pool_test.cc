@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/parser_pool.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+TEST(ParserPoolTest, RunsEveryWorkerOnce) {
+  ParserPool pool(4);
+  ASSERT_EQ(pool.num_workers(), 4);
+
+  for (int iter = 0; iter < 100; ++iter) {
+    std::vector<int> calls(pool.num_workers(), 0);
+    pool.Run([&](size_t worker) { ++calls[worker]; });
+    EXPECT_THAT(calls, ::testing::Each(1));
+  }
+}
+
+TEST(ParserPoolTest, WorkersHaveStableThreads) {
+  ParserPool pool(3);
+  std::vector<std::thread::id> first(pool.num_workers());
+  pool.Run([&](size_t worker) { first[worker] = std::this_thread::get_id(); });
+
+  // Worker 0 is the calling thread.
+  EXPECT_EQ(first[0], std::this_thread::get_id());
+  EXPECT_EQ(std::set<std::thread::id>(first.begin(), first.end()).size(), 3);
+
+  std::vector<std::thread::id> second(pool.num_workers());
+  pool.Run([&](size_t worker) { second[worker] = std::this_thread::get_id(); });
+  EXPECT_EQ(first, second);
+}
+
+TEST(ParserPoolTest, SingleWorkerRunsInline) {
+  ParserPool pool(1);
+  std::atomic<int> sum = 0;
+  pool.Run([&](size_t worker) {
+    EXPECT_EQ(worker, 0);
+    sum += 1;
+  });
+  EXPECT_EQ(sum, 1);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/perf_buffer_events_replayer.h"
+#include "src/stirling/source_connectors/socket_tracer/sock_event_pb.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
+#include "src/stirling/testing/common.h"
+
+// Replays perf buffer events into a SocketTraceConnector, to profile what it spends on tracking
+// connections, parsing, stitching and appending to the data tables, without BPF or root.
+//
+// Events recorded with --perf_buffer_events_output_path=<file>.bin can be replayed with
+// --perf_buffer_events_replay_path=<file>.bin. Otherwise HTTP traffic is synthesized.
+
+DEFINE_string(perf_buffer_events_replay_path, "",
+              "The binary recording of perf buffer events to replay. If empty, HTTP traffic on "
+              "many connections is synthesized.");
+
+namespace px {
+namespace stirling {
+namespace {
+
+constexpr int kNumConns = 256;
+constexpr int kExchangesPerConn = 64;
+
+std::vector<sockeventpb::SocketEvent> GenHTTPEvents() {
+  testing::MockClock clock;
+  std::vector<sockeventpb::SocketEvent> events;
+  for (int fd = 0; fd < kNumConns; ++fd) {
+    testing::EventGenerator event_gen(&clock, testing::kPID, fd);
+    events.push_back(ToSocketEventPB(event_gen.InitConn()));
+    for (int i = 0; i < kExchangesPerConn; ++i) {
+      events.push_back(
+          ToSocketEventPB(*event_gen.InitSendEvent<kProtocolHTTP>(testing::kHTTPReq0)));
+      events.push_back(
+          ToSocketEventPB(*event_gen.InitRecvEvent<kProtocolHTTP>(testing::kHTTPResp0)));
+    }
+    events.push_back(ToSocketEventPB(event_gen.InitClose()));
+  }
+  return events;
+}
+
+std::unique_ptr<PerfBufferEventsReplayer> CreateReplayer() {
+  if (FLAGS_perf_buffer_events_replay_path.empty()) {
+    return std::make_unique<PerfBufferEventsReplayer>(GenHTTPEvents());
+  }
+  auto replayer_or = PerfBufferEventsReplayer::Load(FLAGS_perf_buffer_events_replay_path);
+  PL_CHECK_OK(replayer_or.status());
+  return replayer_or.ConsumeValueOrDie();
+}
+
+// Replays all the events per iteration, state.range(0) events at a time, with a transfer after
+// each chunk, as if they were the events of one perf buffer poll.
+// NOLINTNEXTLINE(runtime/references)
+void BM_ReplayAndTransfer(benchmark::State& state) {
+  FLAGS_stirling_check_proc_for_conn_close = false;
+  const size_t events_per_transfer = state.range(0);
+
+  static std::unique_ptr<PerfBufferEventsReplayer> replayer = CreateReplayer();
+
+  size_t num_records = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    // A new connector for each iteration, so that the replayed connections are new to it.
+    std::unique_ptr<SourceConnector> connector =
+        SocketTraceConnector::Create("socket_trace_connector");
+    auto* source = static_cast<SocketTraceConnector*>(connector.get());
+    StandaloneContext ctx;
+    testing::DataTables data_tables(SocketTraceConnector::kTables);
+    replayer->Start(*source, PerfBufferEventsReplayer::Rate::kMax);
+    state.ResumeTiming();
+
+    while (!replayer->done()) {
+      replayer->ReplayNext(source, events_per_transfer);
+      connector->TransferData(&ctx, data_tables.tables());
+    }
+
+    state.PauseTiming();
+    for (DataTable* data_table : data_tables.tables()) {
+      for (const auto& tablet : data_table->ConsumeRecords()) {
+        num_records += tablet.records.empty() ? 0 : tablet.records[0]->Size();
+      }
+    }
+    state.ResumeTiming();
+  }
+
+  state.counters["events"] = benchmark::Counter(replayer->num_events(),
+                                                benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["records"] = benchmark::Counter(num_records, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_ReplayAndTransfer)
+    ->RangeMultiplier(8)
+    ->Range(64, 4096)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace stirling
+}  // namespace px
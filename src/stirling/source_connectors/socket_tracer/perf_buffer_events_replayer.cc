@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/perf_buffer_events_replayer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include <absl/strings/match.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include "src/stirling/source_connectors/socket_tracer/sock_event_pb.h"
+
+namespace px {
+namespace stirling {
+
+StatusOr<std::unique_ptr<PerfBufferEventsReplayer>> PerfBufferEventsReplayer::Load(
+    const std::filesystem::path& path) {
+  using ::google::protobuf::io::IstreamInputStream;
+  using ::google::protobuf::util::ParseDelimitedFromZeroCopyStream;
+
+  // The text format is meant to be read by humans, and the messages in it aren't delimited.
+  if (!absl::EndsWith(path.string(), ".bin")) {
+    return error::InvalidArgument("Only recordings in binary format ('.bin') can be replayed: $0",
+                                  path.string());
+  }
+
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    return error::Internal("Failed to open file $0", path.string());
+  }
+  IstreamInputStream input(&ifs);
+
+  std::vector<sockeventpb::SocketEvent> events;
+  while (true) {
+    sockeventpb::SocketEvent event;
+    bool clean_eof = false;
+    if (!ParseDelimitedFromZeroCopyStream(&event, &input, &clean_eof)) {
+      if (clean_eof) {
+        break;
+      }
+      return error::InvalidArgument("Failed to parse event $0 of $1", events.size(),
+                                    path.string());
+    }
+    events.push_back(std::move(event));
+  }
+  return std::make_unique<PerfBufferEventsReplayer>(events);
+}
+
+PerfBufferEventsReplayer::PerfBufferEventsReplayer(
+    const std::vector<sockeventpb::SocketEvent>& events) {
+  events_.reserve(events.size());
+  for (const auto& pb : events) {
+    Event event = {};
+    switch (pb.event_case()) {
+      case sockeventpb::SocketEvent::kData:
+        event.timestamp_ns = pb.data().attr().timestamp_ns();
+        event.data_event = ToSocketDataEventBuffer(pb.data());
+        break;
+      case sockeventpb::SocketEvent::kControl:
+        event.timestamp_ns = pb.control().timestamp_ns();
+        event.control_event = ToSocketControlEvent(pb.control());
+        break;
+      default:
+        continue;
+    }
+    events_.push_back(std::move(event));
+  }
+}
+
+void PerfBufferEventsReplayer::Start(const SocketTraceConnector& connector, Rate rate) {
+  rate_ = rate;
+  next_event_idx_ = 0;
+  if (events_.empty()) {
+    return;
+  }
+
+  auto [min_iter, max_iter] = std::minmax_element(
+      events_.begin(), events_.end(),
+      [](const Event& a, const Event& b) { return a.timestamp_ns < b.timestamp_ns; });
+  const int64_t now = connector.AdjustedSteadyClockNowNS();
+  const uint64_t anchor = rate == Rate::kMax ? max_iter->timestamp_ns : min_iter->timestamp_ns;
+  timestamp_offset_ns_ = now - static_cast<int64_t>(anchor);
+}
+
+size_t PerfBufferEventsReplayer::ReplayNext(SocketTraceConnector* connector, size_t max_events) {
+  const uint64_t now = connector->AdjustedSteadyClockNowNS();
+
+  size_t num_replayed = 0;
+  for (; next_event_idx_ < events_.size() && num_replayed < max_events; ++next_event_idx_) {
+    Event& event = events_[next_event_idx_];
+    const uint64_t timestamp_ns = event.timestamp_ns + timestamp_offset_ns_;
+    if (rate_ == Rate::kRecorded && timestamp_ns > now) {
+      break;
+    }
+
+    if (!event.data_event.empty()) {
+      std::memcpy(event.data_event.data() + offsetof(socket_data_event_t, attr) +
+                      offsetof(socket_data_event_t::attr_t, timestamp_ns),
+                  &timestamp_ns, sizeof(timestamp_ns));
+      SocketTraceConnector::HandleDataEvent(connector, event.data_event.data(),
+                                            event.data_event.size());
+    } else {
+      socket_control_event_t control_event = event.control_event;
+      control_event.timestamp_ns = timestamp_ns;
+      SocketTraceConnector::HandleControlEvent(connector, &control_event, sizeof(control_event));
+    }
+    ++num_replayed;
+  }
+  return num_replayed;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * PerfBufferEventsReplayer replays the events recorded with --perf_buffer_events_output_path into
+ * a SocketTraceConnector, through the same callbacks that the perf buffers call. This exercises
+ * the connection trackers, parsers, stitchers and data tables without BPF, and so without root.
+ *
+ * The events are converted to their BPF representation when they are loaded, so that replaying
+ * them costs no more than receiving them from the perf buffers.
+ */
+class PerfBufferEventsReplayer {
+ public:
+  enum class Rate {
+    // Replays the events as fast as possible.
+    kMax,
+    // Replays the events at the pace that they were recorded at.
+    kRecorded,
+  };
+
+  /**
+   * Loads the events of a recording in binary format (a '.bin' file).
+   */
+  static StatusOr<std::unique_ptr<PerfBufferEventsReplayer>> Load(
+      const std::filesystem::path& path);
+
+  explicit PerfBufferEventsReplayer(const std::vector<sockeventpb::SocketEvent>& events);
+
+  size_t num_events() const { return events_.size(); }
+  bool done() const { return next_event_idx_ == events_.size(); }
+
+  /**
+   * Rewinds the replay. The timestamps of the events are shifted to the current time of the
+   * connector: at the max rate the recording ends now, and at the recorded rate it starts now. So
+   * the events are never ahead of the perf buffer drain time of the connector.
+   */
+  void Start(const SocketTraceConnector& connector, Rate rate);
+
+  /**
+   * Feeds up to max_events of the next events to the connector. At the recorded rate, only the
+   * events whose (shifted) time has come are fed.
+   * @return the number of events fed.
+   */
+  size_t ReplayNext(SocketTraceConnector* connector,
+                    size_t max_events = std::numeric_limits<size_t>::max());
+
+ private:
+  struct Event {
+    uint64_t timestamp_ns;
+    // Holds a socket_data_event_t, trimmed to its message, for data events.
+    std::string data_event;
+    // Set if data_event is empty.
+    socket_control_event_t control_event;
+  };
+
+  std::vector<Event> events_;
+  size_t next_event_idx_ = 0;
+
+  Rate rate_ = Rate::kMax;
+  // Added to the recorded timestamps of the events.
+  int64_t timestamp_offset_ns_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
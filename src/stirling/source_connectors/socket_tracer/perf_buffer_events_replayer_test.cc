@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/perf_buffer_events_replayer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/sock_event_pb.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
+#include "src/stirling/testing/common.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::testing::ColWrapperSizeIs;
+using ::testing::Each;
+
+class PerfBufferEventsReplayerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    connector_ = SocketTraceConnector::Create("socket_trace_connector");
+    source_ = dynamic_cast<SocketTraceConnector*>(connector_.get());
+    ASSERT_NE(nullptr, source_);
+
+    ctx_ = std::make_unique<StandaloneContext>();
+    FLAGS_stirling_check_proc_for_conn_close = false;
+    data_tables_ = std::make_unique<testing::DataTables>(SocketTraceConnector::kTables);
+    http_table_ = (*data_tables_)[SocketTraceConnector::kHTTPTableNum];
+  }
+
+  // Two HTTP requests and their responses on a connection.
+  std::vector<sockeventpb::SocketEvent> GenHTTPEvents() {
+    testing::EventGenerator event_gen(&mock_clock_);
+    std::vector<sockeventpb::SocketEvent> events;
+    events.push_back(ToSocketEventPB(event_gen.InitConn()));
+    for (int i = 0; i < 2; ++i) {
+      events.push_back(
+          ToSocketEventPB(*event_gen.InitSendEvent<kProtocolHTTP>(testing::kHTTPReq0)));
+      events.push_back(
+          ToSocketEventPB(*event_gen.InitRecvEvent<kProtocolHTTP>(testing::kHTTPResp0)));
+    }
+    events.push_back(ToSocketEventPB(event_gen.InitClose()));
+    return events;
+  }
+
+  std::unique_ptr<testing::DataTables> data_tables_;
+  DataTable* http_table_;
+
+  std::unique_ptr<SourceConnector> connector_;
+  SocketTraceConnector* source_ = nullptr;
+  std::unique_ptr<StandaloneContext> ctx_;
+  testing::MockClock mock_clock_;
+};
+
+TEST_F(PerfBufferEventsReplayerTest, ReplaysAtMaxRate) {
+  PerfBufferEventsReplayer replayer(GenHTTPEvents());
+  EXPECT_EQ(6, replayer.num_events());
+
+  replayer.Start(*source_, PerfBufferEventsReplayer::Rate::kMax);
+  EXPECT_EQ(4, replayer.ReplayNext(source_, 4));
+  EXPECT_FALSE(replayer.done());
+  EXPECT_EQ(2, replayer.ReplayNext(source_));
+  EXPECT_TRUE(replayer.done());
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_EQ(1, tablets.size());
+  EXPECT_THAT(tablets[0].records, Each(ColWrapperSizeIs(2)));
+  EXPECT_EQ("pixie", tablets[0].records[kHTTPRespBodyIdx]->Get<types::StringValue>(0));
+}
+
+TEST_F(PerfBufferEventsReplayerTest, ReplaysOnlyDueEventsAtRecordedRate) {
+  std::vector<sockeventpb::SocketEvent> events = GenHTTPEvents();
+  // Push the close event far into the future.
+  events.back().mutable_control()->set_timestamp_ns(events.back().control().timestamp_ns() +
+                                                    3600 * 1000000000ULL);
+
+  PerfBufferEventsReplayer replayer(events);
+  replayer.Start(*source_, PerfBufferEventsReplayer::Rate::kRecorded);
+  EXPECT_EQ(5, replayer.ReplayNext(source_));
+  EXPECT_FALSE(replayer.done());
+  EXPECT_EQ(0, replayer.ReplayNext(source_));
+}
+
+TEST_F(PerfBufferEventsReplayerTest, LoadsBinaryRecordings) {
+  px::testing::TempDir temp_dir;
+
+  const std::filesystem::path path = temp_dir.path() / "events.bin";
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    for (const auto& event : GenHTTPEvents()) {
+      ASSERT_TRUE(google::protobuf::util::SerializeDelimitedToOstream(event, &ofs));
+    }
+  }
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<PerfBufferEventsReplayer> replayer,
+                       PerfBufferEventsReplayer::Load(path));
+  EXPECT_EQ(6, replayer->num_events());
+
+  EXPECT_NOT_OK(PerfBufferEventsReplayer::Load(temp_dir.path() / "events.txt"));
+  EXPECT_NOT_OK(PerfBufferEventsReplayer::Load(temp_dir.path() / "missing.bin"));
+}
+
+}  // namespace stirling
+}  // namespace px
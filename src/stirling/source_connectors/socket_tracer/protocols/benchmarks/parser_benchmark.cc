@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2018- Pixie Labs Inc.
+ * Copyright © 2020- New Relic, Inc.
+ * All Rights Reserved.
+ *
+ * NOTICE:  All information contained herein is, and remains
+ * the property of New Relic Inc. and its suppliers,
+ * if any.  The intellectual and technical concepts contained
+ * herein are proprietary to Pixie Labs Inc. and its suppliers and
+ * may be covered by U.S. and Foreign Patents, patents in process,
+ * and are protected by trade secret or copyright law. Dissemination
+ * of this information or reproduction of this material is strictly
+ * forbidden unless prior written permission is obtained from
+ * New Relic, Inc.
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_utils.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/stitchers.h"
+
+// Replays a connection's worth of request/response bytes through ParseFramesLoop() and the
+// stitcher of each protocol, to measure what a ConnTracker spends per byte and per frame.
+//
+// HTTP/2 isn't covered: its frames are reconstructed from uprobe events, not parsed from bytes.
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace {
+
+// A request and its response, as the bytes that would appear on the wire.
+struct Exchange {
+  std::string req;
+  std::string resp;
+};
+
+// How many exchanges accumulate between two calls to StitchFrames(). This is roughly what a busy
+// connection collects in one transfer period.
+constexpr int kExchangesPerStitch = 16;
+
+// Appends the frames parsed from buf, and stamps them the way ParseFrames() would from the
+// timestamps of the data stream buffer. Returns the number of new frames.
+template <typename TFrameType, typename TStateType>
+size_t ParseInto(message_type_t type, std::string_view buf, uint64_t timestamp_ns,
+                 std::deque<TFrameType>* frames, TStateType* state) {
+  const size_t prev_size = frames->size();
+  ParseFramesLoop(type, buf, frames, state);
+  for (size_t i = prev_size; i < frames->size(); ++i) {
+    (*frames)[i].timestamp_ns = timestamp_ns;
+  }
+  return frames->size() - prev_size;
+}
+
+// The exchanges replayed for each protocol, specialized below.
+template <typename TProtocolTraits>
+std::vector<Exchange> Exchanges();
+
+// The state a connection of the protocol starts out with.
+template <typename TProtocolTraits>
+typename TProtocolTraits::state_type InitState() {
+  return {};
+}
+
+// Parses and stitches state.range(0) exchanges per iteration, cycling through the protocol's
+// exchanges.
+template <typename TProtocolTraits>
+// NOLINTNEXTLINE(runtime/references)
+void BM_ParseAndStitch(benchmark::State& state) {
+  using TFrameType = typename TProtocolTraits::frame_type;
+  using TRecordType = typename TProtocolTraits::record_type;
+  using TStateType = typename TProtocolTraits::state_type;
+
+  const std::vector<Exchange> exchanges = Exchanges<TProtocolTraits>();
+  const TStateType init_state = InitState<TProtocolTraits>();
+  const int num_exchanges = state.range(0);
+  int64_t bytes_per_iter = 0;
+  for (int i = 0; i < num_exchanges; ++i) {
+    const Exchange& exchange = exchanges[i % exchanges.size()];
+    bytes_per_iter += exchange.req.size() + exchange.resp.size();
+  }
+
+  int64_t num_frames = 0;
+  int64_t num_records = 0;
+  int64_t num_errors = 0;
+  for (auto _ : state) {
+    TStateType proto_state = init_state;
+    std::deque<TFrameType> reqs;
+    std::deque<TFrameType> resps;
+    for (int i = 0; i < num_exchanges; ++i) {
+      const Exchange& exchange = exchanges[i % exchanges.size()];
+      num_frames += ParseInto(kRequest, exchange.req, 2 * i, &reqs, &proto_state);
+      num_frames += ParseInto(kResponse, exchange.resp, 2 * i + 1, &resps, &proto_state);
+
+      if ((i + 1) % kExchangesPerStitch == 0 || i + 1 == num_exchanges) {
+        RecordsWithErrorCount<TRecordType> result =
+            StitchFrames<TRecordType, TFrameType, TStateType>(&reqs, &resps, &proto_state);
+        num_records += result.records.size();
+        num_errors += result.error_count;
+        benchmark::DoNotOptimize(result);
+      }
+    }
+  }
+
+  if (num_records == 0) {
+    state.SkipWithError("No records were stitched, the exchanges don't parse.");
+    return;
+  }
+  state.SetBytesProcessed(state.iterations() * bytes_per_iter);
+  state.counters["frames"] = benchmark::Counter(num_frames, benchmark::Counter::kIsRate);
+  state.counters["records"] = benchmark::Counter(num_records, benchmark::Counter::kIsRate);
+  state.counters["errors"] = benchmark::Counter(num_errors, benchmark::Counter::kAvgIterations);
+}
+
+template <size_t N>
+std::string Bytes(const uint8_t (&arr)[N]) {
+  return std::string(CreateCharArrayView<char>(arr));
+}
+
+//-----------------------------------------------------------------------------
+// Test data
+//-----------------------------------------------------------------------------
+
+template <>
+std::vector<Exchange> Exchanges<http::ProtocolTraits>() {
+  return {
+      {"GET /api/v1/users/42 HTTP/1.1\r\n"
+       "Host: users.default.svc.cluster.local\r\n"
+       "User-Agent: Go-http-client/1.1\r\n"
+       "Accept: application/json\r\n"
+       "Accept-Encoding: gzip\r\n"
+       "\r\n",
+       "HTTP/1.1 200 OK\r\n"
+       "Content-Type: application/json\r\n"
+       "Date: Mon, 12 Oct 2020 18:00:00 GMT\r\n"
+       "Content-Length: 58\r\n"
+       "\r\n"
+       R"({"id":42,"name":"octocat","email":"octocat@example.com"})"
+       "\r\n"},
+      {"POST /api/v1/orders HTTP/1.1\r\n"
+       "Host: orders.default.svc.cluster.local\r\n"
+       "Content-Type: application/json\r\n"
+       "Content-Length: 27\r\n"
+       "\r\n"
+       R"({"item":"socks","count":2})"
+       "\n",
+       "HTTP/1.1 201 Created\r\n"
+       "Location: /api/v1/orders/1234\r\n"
+       "Content-Length: 0\r\n"
+       "\r\n"},
+  };
+}
+
+template <>
+std::vector<Exchange> Exchanges<mysql::ProtocolTraits>() {
+  std::string resp;
+  for (const auto& packet : mysql::testutils::GenResultset(mysql::testdata::kQueryResultset)) {
+    resp += mysql::testutils::GenRawPacket(packet);
+  }
+  return {{mysql::testutils::GenRawPacket(mysql::testutils::GenStringRequest(
+               mysql::testdata::kQueryRequest, mysql::Command::kQuery)),
+           resp}};
+}
+
+template <>
+mysql::StateWrapper InitState<mysql::ProtocolTraits>() {
+  mysql::StateWrapper state;
+  // Connections start out inactive until the tracer is confident they're MySQL.
+  state.global.active = true;
+  return state;
+}
+
+// Prepends a CQL v4 frame header to the body.
+std::string CQLFrame(bool resp, uint16_t stream, cass::Opcode opcode, std::string_view body) {
+  std::string frame;
+  frame.push_back(resp ? 0x84 : 0x04);
+  frame.push_back(0x00);
+  frame.push_back(stream >> 8);
+  frame.push_back(stream & 0xff);
+  frame.push_back(static_cast<char>(opcode));
+  const uint32_t len = body.size();
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    frame.push_back((len >> shift) & 0xff);
+  }
+  frame.append(body);
+  return frame;
+}
+
+template <>
+std::vector<Exchange> Exchanges<cass::ProtocolTraits>() {
+  // QUERY: SELECT * FROM system.peers
+  constexpr uint8_t kQueryReq[] = {0x00, 0x00, 0x00, 0x1a, 0x53, 0x45, 0x4c, 0x45, 0x43, 0x54, 0x20,
+                                   0x2a, 0x20, 0x46, 0x52, 0x4f, 0x4d, 0x20, 0x73, 0x79, 0x73, 0x74,
+                                   0x65, 0x6d, 0x2e, 0x70, 0x65, 0x65, 0x72, 0x73, 0x00, 0x01,
+                                   0x00};
+  // RESULT of kind Void.
+  constexpr uint8_t kResultResp[] = {0x00, 0x00, 0x00, 0x01};
+  return {{CQLFrame(false, 1, cass::Opcode::kQuery, CreateCharArrayView<char>(kQueryReq)),
+           CQLFrame(true, 1, cass::Opcode::kResult, CreateCharArrayView<char>(kResultResp))}};
+}
+
+template <>
+std::vector<Exchange> Exchanges<kafka::ProtocolTraits>() {
+  return {{Bytes(kafka::testdata::kProduceRequest), Bytes(kafka::testdata::kProduceResponse)}};
+}
+
+template <>
+std::vector<Exchange> Exchanges<redis::ProtocolTraits>() {
+  return {
+      {"*2\r\n$3\r\nGET\r\n$7\r\nuser:42\r\n", "$7\r\noctocat\r\n"},
+      {"*3\r\n$3\r\nSET\r\n$7\r\nuser:43\r\n$6\r\nhubber\r\n", "+OK\r\n"},
+  };
+}
+
+template <>
+std::vector<Exchange> Exchanges<nats::ProtocolTraits>() {
+  return {{"PUB orders.new 11\r\nhello world\r\n", "+OK\r\n"}};
+}
+
+template <>
+std::vector<Exchange> Exchanges<dns::ProtocolTraits>() {
+  // A query for intellij-experiments.appspot.com, and its response with one A record.
+  constexpr uint8_t kQueryFrame[] = {
+      0xc6, 0xfa, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x14, 0x69, 0x6e,
+      0x74, 0x65, 0x6c, 0x6c, 0x69, 0x6a, 0x2d, 0x65, 0x78, 0x70, 0x65, 0x72, 0x69, 0x6d, 0x65,
+      0x6e, 0x74, 0x73, 0x07, 0x61, 0x70, 0x70, 0x73, 0x70, 0x6f, 0x74, 0x03, 0x63, 0x6f, 0x6d,
+      0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x29, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00};
+  constexpr uint8_t kRespFrame[] = {
+      0xc6, 0xfa, 0x81, 0x80, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x14, 0x69, 0x6e,
+      0x74, 0x65, 0x6c, 0x6c, 0x69, 0x6a, 0x2d, 0x65, 0x78, 0x70, 0x65, 0x72, 0x69, 0x6d, 0x65,
+      0x6e, 0x74, 0x73, 0x07, 0x61, 0x70, 0x70, 0x73, 0x70, 0x6f, 0x74, 0x03, 0x63, 0x6f, 0x6d,
+      0x00, 0x00, 0x01, 0x00, 0x01, 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x24,
+      0x00, 0x04, 0xd8, 0x3a, 0xc2, 0xb4, 0x00, 0x00, 0x29, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00};
+  // Each exchange is parsed on its own, since DNS frames are whole datagrams.
+  return {{Bytes(kQueryFrame), Bytes(kRespFrame)}};
+}
+
+template <>
+std::vector<Exchange> Exchanges<mux::ProtocolTraits>() {
+  // Tping and Rping with tag 1.
+  constexpr uint8_t kTping[] = {0x00, 0x00, 0x00, 0x04, 0x41, 0x00, 0x00, 0x01};
+  constexpr uint8_t kRping[] = {0x00, 0x00, 0x00, 0x04, 0xbf, 0x00, 0x00, 0x01};
+  return {{Bytes(kTping), Bytes(kRping)}};
+}
+
+template <>
+std::vector<Exchange> Exchanges<pgsql::ProtocolTraits>() {
+  return {{ConstString("Q\000\000\000\033select * from account;\000"),
+           absl::StrCat(ConstString("C\000\000\000\017DROP TABLE\000"),
+                        ConstString("Z\000\000\000\005I"))}};
+}
+
+}  // namespace
+
+// PROTOCOL_LIST: Requires update on new protocols.
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, http::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, mysql::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, cass::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, kafka::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, redis::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, nats::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, dns::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, mux::ProtocolTraits)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ParseAndStitch, pgsql::ProtocolTraits)->Arg(1)->Arg(1000);
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -19,11 +19,13 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
 
 #include <algorithm>
+#include <cstring>
 #include <deque>
-#include <map>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "src/common/base/base.h"
 
@@ -33,22 +35,33 @@ namespace protocols {
 
 namespace {
 
-// Get element <= key in a map.
-template <typename TMapType>
-typename TMapType::const_iterator MapLE(const TMapType& map, size_t key) {
-  auto iter = map.upper_bound(key);
-  if (iter == map.begin()) {
-    return map.cend();
+// Get the first entry with position >= pos in a position map.
+template <typename TPositionMap>
+auto PositionGE(TPositionMap& map, size_t pos) {
+  // Entries nearly always go to the back, so skip the search when they do.
+  if (map.empty() || map.back().first < pos) {
+    return map.end();
   }
-  --iter;
+  return std::lower_bound(map.begin(), map.end(), pos,
+                          [](const auto& entry, size_t key) { return entry.first < key; });
+}
 
-  return iter;
+// Get the last entry with position <= pos in a position map.
+template <typename TPositionMap>
+auto PositionLE(TPositionMap& map, size_t pos) {
+  auto iter = std::upper_bound(map.begin(), map.end(), pos,
+                               [](size_t key, const auto& entry) { return key < entry.first; });
+  if (iter == map.begin()) {
+    return map.end();
+  }
+  return std::prev(iter);
 }
 
 }  // namespace
 
 void DataStreamBuffer::Reset() {
-  buffer_.clear();
+  buffer_.Reset();
+  size_ = 0;
   chunks_.clear();
   timestamps_.clear();
   position_ = 0;
@@ -58,7 +71,7 @@ void DataStreamBuffer::Reset() {
 //               Return error in such cases.
 void DataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
   // Look for the chunks to the left and right of this new chunk.
-  auto r_iter = chunks_.lower_bound(pos);
+  auto r_iter = PositionGE(chunks_, pos);
   auto l_iter = r_iter;
   if (l_iter != chunks_.begin()) {
     --l_iter;
@@ -91,31 +104,50 @@ void DataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
     l_iter->second += size;
   } else if (right_fuse) {
     // Merge new chunk into the one on its right.
-    // Since its key changes, this requires removing and re-inserting the node.
-    auto node = chunks_.extract(r_iter);
-    node.key() = pos;
-    node.mapped() += size;
-    chunks_.insert(std::move(node));
+    // Its start moves back, but stays past the chunk on its left, so the order holds.
+    r_iter->first = pos;
+    r_iter->second += size;
+  } else if (r_iter != chunks_.end() && r_iter->first == pos) {
+    r_iter->second = size;
   } else {
     // No fusing, so just add the new chunk.
-    chunks_[pos] = size;
+    chunks_.insert(r_iter, {pos, size});
   }
 }
 
 void DataStreamBuffer::AddNewTimestamp(size_t pos, uint64_t timestamp) {
-  timestamps_[pos] = timestamp;
+  auto iter = PositionGE(timestamps_, pos);
+  if (iter != timestamps_.end() && iter->first == pos) {
+    iter->second = timestamp;
+  } else {
+    timestamps_.insert(iter, {pos, timestamp});
+  }
 }
 
 void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp) {
-  if (data.size() > capacity_) {
-    size_t oversize_amount = data.size() - capacity_;
-    data.remove_prefix(oversize_amount);
-    pos += oversize_amount;
+  AddImpl(pos, data.size(), data.data(), timestamp);
+}
+
+void DataStreamBuffer::AddFiller(size_t pos, size_t size, uint64_t timestamp) {
+  AddImpl(pos, size, /* data */ nullptr, timestamp);
+}
+
+void DataStreamBuffer::AddImpl(size_t pos, size_t size, const char* data, uint64_t timestamp) {
+  auto remove_prefix = [&pos, &size, &data](size_t n) {
+    pos += n;
+    size -= n;
+    if (data != nullptr) {
+      data += n;
+    }
+  };
+
+  if (size > capacity_) {
+    remove_prefix(size - capacity_);
   }
 
   // Calculate physical positions (ppos) where the data would live in the physical buffer.
   ssize_t ppos_front = pos - position_;
-  ssize_t ppos_back = pos + data.size() - position_;
+  ssize_t ppos_back = pos + size - position_;
 
   if (ppos_back < 0) {
     // Case 1: Data being added is too far back. Just ignore it.
@@ -133,11 +165,9 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     VLOG(1) << absl::Substitute(
         "Event is partially too far in the past [event pos=$0, current pos=$1].", pos, position_);
 
-    ssize_t prefix = 0 - ppos_front;
-    data.remove_prefix(prefix);
-    pos += prefix;
+    remove_prefix(0 - ppos_front);
     ppos_front = 0;
-  } else if (ppos_back > static_cast<ssize_t>(buffer_.size())) {
+  } else if (ppos_back > static_cast<ssize_t>(size_)) {
     // Case 3: Data being added extends the buffer. Resize the buffer.
 
     if (pos > position_ + capacity_) {
@@ -148,7 +178,7 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
                                   position_);
     }
 
-    ssize_t logical_size = pos + data.size() - position_;
+    ssize_t logical_size = pos + size - position_;
     if (logical_size > static_cast<ssize_t>(capacity_)) {
       // The movement of the buffer position will cause some bytes to "fall off",
       // remove those now.
@@ -167,13 +197,15 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     DCHECK_GE(ppos_back, 0);
     DCHECK_LE(ppos_back, capacity_);
 
-    ssize_t extension = ppos_back - buffer_.size();
+    ssize_t extension = ppos_back - size_;
     DCHECK_GE(extension, 0);
     DCHECK_LE(extension, capacity_);
 
-    buffer_.resize(buffer_.size() + extension);
-    DCHECK_GE(buffer_.size(), 0);
-    DCHECK_LE(buffer_.size(), capacity_);
+    // Gaps in the extension are zeroed, since the ring may still hold consumed bytes there.
+    buffer_.Allocate();
+    memset(buffer_.data() + size_, 0, extension);
+    size_ += extension;
+    DCHECK_LE(size_, capacity_);
   } else {
     // Case 4: Data being added is completely within the buffer. Write it directly.
 
@@ -181,16 +213,21 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
   }
 
   // Now copy the data into the buffer.
-  memcpy(buffer_.data() + ppos_front, data.data(), data.size());
+  if (data != nullptr) {
+    memcpy(buffer_.data() + ppos_front, data, size);
+  } else {
+    memset(buffer_.data() + ppos_front, 0, size);
+  }
 
   // Update the metadata.
-  AddNewChunk(pos, data.size());
+  AddNewChunk(pos, size);
   AddNewTimestamp(pos, timestamp);
 }
 
-std::map<size_t, size_t>::const_iterator DataStreamBuffer::GetChunkForPos(size_t pos) const {
+DataStreamBuffer::PositionMap<size_t>::const_iterator DataStreamBuffer::GetChunkForPos(
+    size_t pos) const {
   // Get chunk which is <= pos.
-  auto iter = MapLE(chunks_, pos);
+  auto iter = PositionLE(chunks_, pos);
   if (iter == chunks_.cend()) {
     return chunks_.cend();
   }
@@ -220,7 +257,7 @@ std::string_view DataStreamBuffer::Get(size_t pos) const {
 
   DCHECK_GE(pos, position_);
   size_t ppos = pos - position_;
-  DCHECK_LT(ppos, buffer_.size());
+  DCHECK_LT(ppos, size_);
   return std::string_view(buffer_.data() + ppos, bytes_available);
 }
 
@@ -231,7 +268,7 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
   }
 
   // Get chunk which is <= pos.
-  auto iter = MapLE(timestamps_, pos);
+  auto iter = PositionLE(timestamps_, pos);
   if (iter == timestamps_.cend()) {
     LOG(DFATAL) << absl::Substitute(
         "Specified position should have been found, since we verified we are not in a chunk gap "
@@ -245,6 +282,52 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
   return iter->second;
 }
 
+Status DataStreamBuffer::GetTimestamps(const std::vector<size_t>& positions,
+                                       std::vector<uint64_t>* timestamps) const {
+  Status status;
+  timestamps->clear();
+  timestamps->reserve(positions.size());
+
+  auto chunk_iter = chunks_.cend();
+  auto timestamp_iter = timestamps_.cend();
+  for (size_t pos : positions) {
+    // Positions of the same chunk and timestamp are the common case, so check those first.
+    if (chunk_iter == chunks_.cend() || pos < chunk_iter->first ||
+        pos - chunk_iter->first >= chunk_iter->second) {
+      chunk_iter = GetChunkForPos(pos);
+    }
+    if (chunk_iter == chunks_.cend()) {
+      if (status.ok()) {
+        status = error::Internal("Specified position not found [position=$0]", pos);
+      }
+      timestamps->push_back(0);
+      continue;
+    }
+
+    if (timestamp_iter == timestamps_.cend() || pos < timestamp_iter->first) {
+      timestamp_iter = PositionLE(timestamps_, pos);
+    } else {
+      for (auto next = std::next(timestamp_iter); next != timestamps_.cend() && next->first <= pos;
+           ++next) {
+        timestamp_iter = next;
+      }
+    }
+    if (timestamp_iter == timestamps_.cend()) {
+      LOG(DFATAL) << absl::Substitute(
+          "Specified position should have been found, since we verified we are not in a chunk "
+          "gap [position=$0]\n$1.",
+          pos, DebugInfo());
+      if (status.ok()) {
+        status = error::Internal("Specified position not found [position=$0]", pos);
+      }
+      timestamps->push_back(0);
+      continue;
+    }
+    timestamps->push_back(timestamp_iter->second);
+  }
+  return status;
+}
+
 void DataStreamBuffer::CleanupMetadata() {
   CleanupChunks();
   CleanupTimestamps();
@@ -254,7 +337,7 @@ void DataStreamBuffer::CleanupChunks() {
   // Find and remove irrelevant metadata in `chunks_`.
 
   // Get chunk which is <= position_.
-  auto iter = MapLE(chunks_, position_);
+  auto iter = PositionLE(chunks_, position_);
   if (iter == chunks_.cend()) {
     return;
   }
@@ -275,10 +358,8 @@ void DataStreamBuffer::CleanupChunks() {
 
     // Adjust the first chunk's size.
     DCHECK(!chunks_.empty());
-    auto node = chunks_.extract(chunks_.begin());
-    node.key() = position_;
-    node.mapped() = available;
-    chunks_.insert(std::move(node));
+    chunks_.front().first = position_;
+    chunks_.front().second = available;
   }
 }
 
@@ -286,7 +367,7 @@ void DataStreamBuffer::CleanupTimestamps() {
   // Find and remove irrelevant metadata in `timestamps_`.
 
   // Get timestamp which is <= position_.
-  auto iter = MapLE(timestamps_, position_);
+  auto iter = PositionLE(timestamps_, position_);
   if (iter == timestamps_.cend()) {
     return;
   }
@@ -306,7 +387,10 @@ void DataStreamBuffer::RemovePrefix(ssize_t n) {
     return;
   }
 
-  buffer_.erase(0, n);
+  // Like the data, n may extend past the end of the buffer.
+  size_t removed = std::min<size_t>(n, size_);
+  buffer_.Consume(removed);
+  size_ -= removed;
   position_ += n;
 
   CleanupMetadata();
@@ -321,7 +405,9 @@ void DataStreamBuffer::Trim() {
   DCHECK_GE(chunk_pos, position_);
   size_t trim_size = chunk_pos - position_;
 
-  buffer_.erase(0, trim_size);
+  DCHECK_LE(trim_size, size_);
+  buffer_.Consume(trim_size);
+  size_ -= trim_size;
   position_ += trim_size;
 }
 
@@ -329,7 +415,7 @@ std::string DataStreamBuffer::DebugInfo() const {
   std::string s;
 
   absl::StrAppend(&s, absl::Substitute("Position: $0\n", position_));
-  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", buffer_.size(), capacity_));
+  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", size_, capacity_));
   absl::StrAppend(&s, "Chunks:\n");
   for (const auto& [pos, size] : chunks_) {
     absl::StrAppend(&s, absl::Substitute("  position:$0 size:$1\n", pos, size));
@@ -338,7 +424,9 @@ std::string DataStreamBuffer::DebugInfo() const {
   for (const auto& [pos, timestamp] : timestamps_) {
     absl::StrAppend(&s, absl::Substitute("  position:$0 timestamp:$1\n", pos, timestamp));
   }
-  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", buffer_));
+  std::string_view contents =
+      size_ == 0 ? std::string_view() : std::string_view(buffer_.data(), size_);
+  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", contents));
 
   return s;
 }
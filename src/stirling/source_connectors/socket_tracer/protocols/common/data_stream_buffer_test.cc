@@ -18,12 +18,16 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
 
+#include <vector>
+
 #include "src/common/testing/testing.h"
 
 namespace px {
 namespace stirling {
 namespace protocols {
 
+using ::testing::ElementsAre;
+
 TEST(DataStreamTest, AddAndGet) {
   DataStreamBuffer stream_buffer(15);
 
@@ -225,6 +229,68 @@ TEST(DataStreamTest, TimestampWithGap) {
   EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(13), 10);
 }
 
+TEST(DataStreamTest, Timestamps) {
+  DataStreamBuffer stream_buffer(15);
+
+  stream_buffer.Add(0, "0123", 0);
+  stream_buffer.Add(4, "4567", 4);
+  stream_buffer.Add(10, "abcd", 10);
+  stream_buffer.RemovePrefix(1);
+
+  std::vector<uint64_t> timestamps;
+  EXPECT_OK(stream_buffer.GetTimestamps({1, 3, 4, 7, 10, 13}, &timestamps));
+  EXPECT_THAT(timestamps, ElementsAre(0, 0, 4, 4, 10, 10));
+
+  // Positions without valid data get a zero timestamp, and an error is returned.
+  EXPECT_NOT_OK(stream_buffer.GetTimestamps({0, 3, 8, 13}, &timestamps));
+  EXPECT_THAT(timestamps, ElementsAre(0, 0, 0, 10));
+
+  // Positions out of order are still looked up correctly.
+  EXPECT_OK(stream_buffer.GetTimestamps({13, 4, 2}, &timestamps));
+  EXPECT_THAT(timestamps, ElementsAre(10, 4, 0));
+}
+
+TEST(DataStreamTest, OutOfOrderMetadata) {
+  DataStreamBuffer stream_buffer(15);
+
+  // Out-of-order events are slotted between the metadata of the events around them.
+  stream_buffer.Add(8, "89", 8);
+  stream_buffer.Add(0, "01", 0);
+  stream_buffer.Add(4, "45", 4);
+  EXPECT_EQ(stream_buffer.Head(), "01");
+  EXPECT_EQ(stream_buffer.Get(4), "45");
+  EXPECT_EQ(stream_buffer.Get(8), "89");
+
+  // Events that bridge the gaps fuse the chunks on both sides.
+  stream_buffer.Add(6, "67", 6);
+  EXPECT_EQ(stream_buffer.Get(4), "456789");
+  stream_buffer.Add(2, "23", 2);
+  EXPECT_EQ(stream_buffer.Head(), "0123456789");
+
+  std::vector<uint64_t> timestamps;
+  EXPECT_OK(stream_buffer.GetTimestamps({0, 3, 4, 7, 9}, &timestamps));
+  EXPECT_EQ(timestamps, std::vector<uint64_t>({0, 2, 4, 6, 8}));
+
+  stream_buffer.RemovePrefix(5);
+  EXPECT_EQ(stream_buffer.Head(), "56789");
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(5), 4);
+}
+
+TEST(DataStreamTest, AddFiller) {
+  DataStreamBuffer stream_buffer(15);
+
+  stream_buffer.Add(0, "0123", 0);
+  stream_buffer.AddFiller(4, 4, 4);
+  stream_buffer.Add(8, "89", 8);
+  EXPECT_EQ(stream_buffer.Head(), ConstStringView("0123\0\0\0\089"));
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(5), 4);
+
+  // Filler that falls off the front of the buffer is cut off, like data.
+  stream_buffer.RemovePrefix(6);
+  stream_buffer.AddFiller(2, 8, 2);
+  EXPECT_EQ(stream_buffer.Head(), ConstStringView("\0\0\0\0"));
+}
+
 TEST(DataStreamTest, SizeAndGetPos) {
   DataStreamBuffer stream_buffer(15);
 
@@ -126,17 +126,20 @@ ParseResult ParseFrames(message_type_t type, const DataStreamBuffer& data_stream
 
   VLOG(1) << absl::Substitute("Parsed $0 new frames", frames->size() - prev_size);
 
-  // Match timestamps with the parsed frames.
-  for (size_t i = 0; i < result.frame_positions.size(); ++i) {
-    auto& f = result.frame_positions[i];
+  // Match timestamps with the parsed frames. They are looked up at once, because a pipelined
+  // buffer can hold thousands of frames, most of which share the timestamp of their event.
+  std::vector<size_t> end_positions;
+  end_positions.reserve(result.frame_positions.size());
+  for (auto& f : result.frame_positions) {
     f.start += start_pos;
     f.end += start_pos;
-
-    auto& msg = (*frames)[prev_size + i];
-    StatusOr<uint64_t> timestamp_ns_status =
-        data_stream_buffer.GetTimestamp(data_stream_buffer.position() + f.end);
-    LOG_IF(ERROR, !timestamp_ns_status.ok()) << timestamp_ns_status.ToString();
-    msg.timestamp_ns = timestamp_ns_status.ValueOr(0);
+    end_positions.push_back(data_stream_buffer.position() + f.end);
+  }
+  std::vector<uint64_t> timestamps;
+  Status s = data_stream_buffer.GetTimestamps(end_positions, &timestamps);
+  LOG_IF(ERROR, !s.ok()) << s.ToString();
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    (*frames)[prev_size + i].timestamp_ns = timestamps[i];
   }
 
   return result;
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interned_string.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+namespace {
+
+class StringTable : public NotCopyMoveable {
+ public:
+  std::shared_ptr<const std::string> Intern(std::string_view str) {
+    absl::MutexLock lock(&mutex_);
+
+    auto iter = strings_.find(str);
+    if (iter != strings_.end()) {
+      std::shared_ptr<const std::string> interned = iter->second.lock();
+      if (interned != nullptr) {
+        return interned;
+      }
+      // The last reference is being released, but its deleter hasn't removed it yet.
+      // The key views the stale string, so the entry is replaced rather than updated.
+      strings_.erase(iter);
+    }
+
+    std::shared_ptr<const std::string> interned(new std::string(str),
+                                                [this](const std::string* s) { Release(s); });
+    strings_.emplace(*interned, interned);
+    return interned;
+  }
+
+  size_t size() {
+    absl::MutexLock lock(&mutex_);
+    return strings_.size();
+  }
+
+ private:
+  void Release(const std::string* str) {
+    {
+      absl::MutexLock lock(&mutex_);
+      auto iter = strings_.find(*str);
+      // The entry may have been replaced by a newer string with the same value.
+      if (iter != strings_.end() && iter->second.expired()) {
+        strings_.erase(iter);
+      }
+    }
+    delete str;
+  }
+
+  absl::Mutex mutex_;
+  // The keys view the strings that the values point to.
+  absl::flat_hash_map<std::string_view, std::weak_ptr<const std::string>> strings_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Never destroyed, so that strings released at exit can still be removed from it.
+StringTable* GlobalStringTable() {
+  static StringTable* table = new StringTable();
+  return table;
+}
+
+}  // namespace
+
+InternedString::InternedString(std::string_view str) : str_(GlobalStringTable()->Intern(str)) {}
+
+size_t InternedString::NumInterned() { return GlobalStringTable()->size(); }
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
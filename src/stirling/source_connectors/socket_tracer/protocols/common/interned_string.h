@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * InternedString shares the storage of equal strings across connections, such as the text of the
+ * prepared statements that connection pools prepare identically on each of their connections.
+ *
+ * The strings are interned in a table shared by all connections, and are reference counted:
+ * a string is removed from the table when the last InternedString with its value goes away.
+ * This is thread-safe, since connections can be parsed in parallel.
+ */
+class InternedString {
+ public:
+  InternedString() : InternedString(std::string_view()) {}
+  // NOLINTNEXTLINE: runtime/explicit
+  InternedString(std::string_view str);
+  // NOLINTNEXTLINE: runtime/explicit
+  InternedString(const std::string& str) : InternedString(std::string_view(str)) {}
+  // NOLINTNEXTLINE: runtime/explicit
+  InternedString(const char* str) : InternedString(std::string_view(str)) {}
+
+  const std::string& str() const { return *str_; }
+
+  // NOLINTNEXTLINE: runtime/explicit
+  operator std::string_view() const { return *str_; }
+
+  bool operator==(const InternedString& other) const {
+    return str_ == other.str_ || *str_ == *other.str_;
+  }
+  bool operator!=(const InternedString& other) const { return !(*this == other); }
+
+  /**
+   * Returns the number of distinct strings that are currently interned.
+   */
+  static size_t NumInterned();
+
+ private:
+  std::shared_ptr<const std::string> str_;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interned_string.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+TEST(InternedStringTest, SharesEqualStrings) {
+  const size_t num_interned = InternedString::NumInterned();
+  {
+    InternedString a = std::string("SELECT * FROM t WHERE id = ?");
+    InternedString b("SELECT * FROM t WHERE id = ?");
+    InternedString c("SELECT 1");
+
+    EXPECT_EQ(&a.str(), &b.str());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(std::string_view(b), "SELECT * FROM t WHERE id = ?");
+    EXPECT_EQ(InternedString::NumInterned(), num_interned + 2);
+  }
+  // The strings are released with their last reference.
+  EXPECT_EQ(InternedString::NumInterned(), num_interned);
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/mirrored_ring_buffer.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "src/common/system/config.h"
+
+// Older libc headers don't define the memfd_create flags.
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+namespace {
+
+size_t RoundUpToPages(size_t n) {
+  size_t page_size = system::Config::GetInstance().PageSize();
+  return std::max<size_t>(page_size, (n + page_size - 1) / page_size * page_size);
+}
+
+}  // namespace
+
+MirroredRingBuffer::MirroredRingBuffer(size_t min_capacity)
+    : capacity_(RoundUpToPages(min_capacity)) {}
+
+MirroredRingBuffer::MirroredRingBuffer(MirroredRingBuffer&& other)
+    : capacity_(other.capacity_),
+      base_(std::exchange(other.base_, nullptr)),
+      head_(std::exchange(other.head_, 0)),
+      mirrored_(other.mirrored_) {}
+
+MirroredRingBuffer::~MirroredRingBuffer() { Release(); }
+
+void MirroredRingBuffer::Allocate() {
+  if (allocated()) {
+    return;
+  }
+  mirrored_ = MapMirrored();
+  if (!mirrored_) {
+    LOG_FIRST_N(WARNING, 1) << "Could not map a mirrored ring buffer, using a heap buffer instead.";
+    base_ = new char[2 * capacity_];
+  }
+  head_ = 0;
+}
+
+bool MirroredRingBuffer::MapMirrored() {
+  // memfd_create is called through syscall, since older libcs don't wrap it.
+  int fd = syscall(SYS_memfd_create, "data_stream_buffer", MFD_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  // The mappings keep the memory alive, so the fd isn't needed afterwards.
+  DEFER(close(fd));
+  if (ftruncate(fd, capacity_) != 0) {
+    return false;
+  }
+
+  // Reserve the address range of both halves, then map the memory into each of them.
+  void* region = mmap(nullptr, 2 * capacity_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return false;
+  }
+  char* base = static_cast<char*>(region);
+  for (char* half : {base, base + capacity_}) {
+    void* mapped =
+        mmap(half, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, /* offset */ 0);
+    if (mapped == MAP_FAILED) {
+      munmap(region, 2 * capacity_);
+      return false;
+    }
+  }
+  base_ = base;
+  return true;
+}
+
+void MirroredRingBuffer::Release() {
+  if (base_ == nullptr) {
+    return;
+  }
+  if (mirrored_) {
+    munmap(base_, 2 * capacity_);
+  } else {
+    delete[] base_;
+  }
+  base_ = nullptr;
+}
+
+void MirroredRingBuffer::Consume(size_t n) {
+  DCHECK_LE(n, capacity_);
+  head_ += n;
+  if (mirrored_) {
+    head_ %= capacity_;
+  } else if (head_ >= capacity_) {
+    // The range after the head would run past the end of the heap buffer, so move it back. This
+    // happens at most once per capacity_ bytes consumed.
+    memmove(base_, base_ + head_, 2 * capacity_ - head_);
+    head_ = 0;
+  }
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * MirroredRingBuffer is fixed size storage for a ring buffer whose contents can always be read
+ * and written as one contiguous range, starting at the head.
+ *
+ * The storage is mapped twice into adjacent virtual memory, so a range that wraps around the end of
+ * the ring continues in the second mapping. Consuming bytes only moves the head.
+ *
+ * If the mirrored mapping can't be created, the storage falls back to a heap buffer twice the size
+ * of the ring, and the contents are moved back to the start once the head passes the middle.
+ */
+class MirroredRingBuffer : public NotCopyable {
+ public:
+  /**
+   * @param min_capacity The capacity is rounded up to a number of pages. The memory is only
+   * reserved on the first call to Allocate().
+   */
+  explicit MirroredRingBuffer(size_t min_capacity);
+  MirroredRingBuffer(MirroredRingBuffer&& other);
+  ~MirroredRingBuffer();
+
+  /**
+   * Reserves the memory of the ring, if it wasn't yet.
+   */
+  void Allocate();
+  bool allocated() const { return base_ != nullptr; }
+
+  /**
+   * The head of the ring. The capacity() bytes from here on are contiguous.
+   */
+  char* data() { return base_ + head_; }
+  const char* data() const { return base_ + head_; }
+
+  /**
+   * Moves the head forward by n bytes, which must not be more than the capacity.
+   */
+  void Consume(size_t n);
+
+  /**
+   * Moves the head back to the start of the storage.
+   */
+  void Reset() { head_ = 0; }
+
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * Whether the two halves of the storage are mappings of the same memory.
+   */
+  bool mirrored() const { return mirrored_; }
+
+ private:
+  bool MapMirrored();
+  void Release();
+
+  size_t capacity_;
+  char* base_ = nullptr;
+  size_t head_ = 0;
+  bool mirrored_ = false;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/mirrored_ring_buffer.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "src/common/system/config.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+TEST(MirroredRingBufferTest, CapacityIsWholePages) {
+  const size_t page_size = system::Config::GetInstance().PageSize();
+  EXPECT_EQ(MirroredRingBuffer(1).capacity(), page_size);
+  EXPECT_EQ(MirroredRingBuffer(page_size + 1).capacity(), 2 * page_size);
+
+  MirroredRingBuffer buffer(1);
+  EXPECT_FALSE(buffer.allocated());
+  buffer.Allocate();
+  EXPECT_TRUE(buffer.allocated());
+}
+
+TEST(MirroredRingBufferTest, WrapAroundIsContiguous) {
+  MirroredRingBuffer buffer(1);
+  buffer.Allocate();
+  const size_t capacity = buffer.capacity();
+
+  // Fill the ring, then consume most of it so that the head is close to the end.
+  std::string first(capacity, 'a');
+  memcpy(buffer.data(), first.data(), first.size());
+  buffer.Consume(capacity - 4);
+
+  // This write wraps around the end of the ring.
+  std::string_view second = "bbbbbbbb";
+  memcpy(buffer.data() + 4, second.data(), second.size());
+  EXPECT_EQ(std::string_view(buffer.data(), 12), "aaaabbbbbbbb");
+
+  buffer.Consume(4);
+  EXPECT_EQ(std::string_view(buffer.data(), 8), second);
+
+  // Consuming more keeps the contents reachable from the head.
+  buffer.Consume(5);
+  EXPECT_EQ(std::string_view(buffer.data(), 3), "bbb");
+}
+
+TEST(MirroredRingBufferTest, Reset) {
+  MirroredRingBuffer buffer(1);
+  buffer.Allocate();
+  memcpy(buffer.data(), "abcd", 4);
+  buffer.Consume(2);
+  EXPECT_EQ(std::string_view(buffer.data(), 2), "cd");
+  buffer.Reset();
+  EXPECT_EQ(std::string_view(buffer.data(), 4), "abcd");
+}
+
+TEST(MirroredRingBufferTest, Move) {
+  MirroredRingBuffer buffer(1);
+  buffer.Allocate();
+  memcpy(buffer.data(), "abcd", 4);
+  buffer.Consume(1);
+
+  MirroredRingBuffer moved(std::move(buffer));
+  EXPECT_FALSE(buffer.allocated());
+  ASSERT_TRUE(moved.allocated());
+  EXPECT_EQ(std::string_view(moved.data(), 3), "bcd");
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
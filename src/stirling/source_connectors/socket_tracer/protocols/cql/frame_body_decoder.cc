@@ -48,10 +48,8 @@ StatusOr<TFloatType> ExtractFloatCore(std::string_view* buf) {
 }
 
 template <typename TCharType>
-StatusOr<std::basic_string<TCharType>> FrameBodyDecoder::ExtractBytesCore(int64_t len) {
-  PL_ASSIGN_OR_RETURN(std::basic_string_view<TCharType> tbuf,
-                      binary_decoder_.ExtractString<TCharType>(len));
-  return std::basic_string<TCharType>(tbuf);
+StatusOr<std::basic_string_view<TCharType>> FrameBodyDecoder::ExtractBytesViewCore(int64_t len) {
+  return binary_decoder_.ExtractString<TCharType>(len);
 }
 
 template <typename TCharType, size_t N>
@@ -81,16 +79,26 @@ StatusOr<float> ExtractFloat(std::string_view* buf) { return ExtractFloatCore<fl
 StatusOr<double> ExtractDouble(std::string_view* buf) { return ExtractFloatCore<double>(buf); }
 
 // [string] A [short] n, followed by n bytes representing an UTF-8 string.
-StatusOr<std::string> FrameBodyDecoder::ExtractString() {
+StatusOr<std::string_view> FrameBodyDecoder::ExtractStringView() {
   PL_ASSIGN_OR_RETURN(uint16_t len, ExtractShort());
-  return ExtractBytesCore<char>(len);
+  return ExtractBytesViewCore<char>(len);
+}
+
+StatusOr<std::string> FrameBodyDecoder::ExtractString() {
+  PL_ASSIGN_OR_RETURN(std::string_view str, ExtractStringView());
+  return std::string(str);
 }
 
 // [long string] An [int] n, followed by n bytes representing an UTF-8 string.
-StatusOr<std::string> FrameBodyDecoder::ExtractLongString() {
+StatusOr<std::string_view> FrameBodyDecoder::ExtractLongStringView() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   len = std::max(len, 0);
-  return ExtractBytesCore<char>(len);
+  return ExtractBytesViewCore<char>(len);
+}
+
+StatusOr<std::string> FrameBodyDecoder::ExtractLongString() {
+  PL_ASSIGN_OR_RETURN(std::string_view str, ExtractLongStringView());
+  return std::string(str);
 }
 
 // [uuid] A 16 bytes long uuid.
@@ -144,35 +152,50 @@ StatusOr<StringList> FrameBodyDecoder::ExtractStringList() {
 
 // [bytes] A [int] n, followed by n bytes if n >= 0. If n < 0,
 //         no byte should follow and the value represented is `null`.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractBytes() {
+StatusOr<BytesView> FrameBodyDecoder::ExtractBytesView() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   len = std::max(len, 0);
-  return ExtractBytesCore<uint8_t>(len);
+  return ExtractBytesViewCore<uint8_t>(len);
+}
+
+StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractBytes() {
+  PL_ASSIGN_OR_RETURN(BytesView bytes, ExtractBytesView());
+  return std::basic_string<uint8_t>(bytes);
 }
 
 // A [int] n, followed by n bytes if n >= 0.
 //         If n == -1 no byte should follow and the value represented is `null`.
 //         If n == -2 no byte should follow and the value represented is
 //         `not set` not resulting in any change to the existing value.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractValue() {
+StatusOr<BytesView> FrameBodyDecoder::ExtractValueView() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   if (len == -1) {
-    return std::basic_string<uint8_t>();
+    return BytesView();
   }
   if (len == -2) {
     // TODO(oazizi): Need to send back 'not set' instead.
-    return std::basic_string<uint8_t>();
+    return BytesView();
   }
   if (len < 0) {
     return error::Internal("Invalid length for value.");
   }
-  return ExtractBytesCore<uint8_t>(len);
+  return ExtractBytesViewCore<uint8_t>(len);
+}
+
+StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractValue() {
+  PL_ASSIGN_OR_RETURN(BytesView value, ExtractValueView());
+  return std::basic_string<uint8_t>(value);
 }
 
 // [short bytes]  A [short] n, followed by n bytes if n >= 0.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractShortBytes() {
+StatusOr<BytesView> FrameBodyDecoder::ExtractShortBytesView() {
   PL_ASSIGN_OR_RETURN(uint16_t len, ExtractShort());
-  return ExtractBytesCore<uint8_t>(len);
+  return ExtractBytesViewCore<uint8_t>(len);
+}
+
+StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractShortBytes() {
+  PL_ASSIGN_OR_RETURN(BytesView bytes, ExtractShortBytesView());
+  return std::basic_string<uint8_t>(bytes);
 }
 
 // [inet] An address (ip and port) to a node. It consists of one
@@ -238,7 +261,7 @@ StatusOr<Option> FrameBodyDecoder::ExtractOption() {
   PL_ASSIGN_OR_RETURN(uint16_t id, ExtractShort());
   col_spec.type = static_cast<DataType>(id);
   if (col_spec.type == DataType::kCustom) {
-    PL_ASSIGN_OR_RETURN(col_spec.value, ExtractString());
+    PL_ASSIGN_OR_RETURN(col_spec.value, ExtractStringView());
   }
   if (col_spec.type == DataType::kList || col_spec.type == DataType::kSet) {
     PL_ASSIGN_OR_RETURN(Option type, ExtractOption());
@@ -261,9 +284,9 @@ StatusOr<NameValuePair> FrameBodyDecoder::ExtractNameValuePair(bool with_names)
   NameValuePair nv;
 
   if (with_names) {
-    PL_ASSIGN_OR_RETURN(nv.name, ExtractString());
+    PL_ASSIGN_OR_RETURN(nv.name, ExtractStringView());
   }
-  PL_ASSIGN_OR_RETURN(nv.value, ExtractValue());
+  PL_ASSIGN_OR_RETURN(nv.value, ExtractValueView());
 
   return nv;
 }
@@ -304,7 +327,7 @@ StatusOr<QueryParameters> FrameBodyDecoder::ExtractQueryParameters() {
   }
 
   if (flag_with_paging_state) {
-    PL_ASSIGN_OR_RETURN(qp.paging_state, ExtractBytes());
+    PL_ASSIGN_OR_RETURN(qp.paging_state, ExtractBytesView());
   }
 
   if (flag_with_serial_consistency) {
@@ -339,22 +362,22 @@ StatusOr<ResultMetadata> FrameBodyDecoder::ExtractResultMetadata(bool prepared_r
   bool flag_no_metadata = r.flags & 0x0004;
 
   if (flag_has_more_pages) {
-    PL_ASSIGN_OR_RETURN(r.paging_state, ExtractBytes());
+    PL_ASSIGN_OR_RETURN(r.paging_state, ExtractBytesView());
   }
 
   if (!flag_no_metadata) {
     if (flag_global_tables_spec) {
-      PL_ASSIGN_OR_RETURN(r.gts_keyspace_name, ExtractString());
-      PL_ASSIGN_OR_RETURN(r.gts_table_name, ExtractString());
+      PL_ASSIGN_OR_RETURN(r.gts_keyspace_name, ExtractStringView());
+      PL_ASSIGN_OR_RETURN(r.gts_table_name, ExtractStringView());
     }
 
     for (int i = 0; i < r.columns_count; ++i) {
       ColSpec col_spec;
       if (!flag_global_tables_spec) {
-        PL_ASSIGN_OR_RETURN(col_spec.ks_name, ExtractString());
-        PL_ASSIGN_OR_RETURN(col_spec.table_name, ExtractString());
+        PL_ASSIGN_OR_RETURN(col_spec.ks_name, ExtractStringView());
+        PL_ASSIGN_OR_RETURN(col_spec.table_name, ExtractStringView());
       }
-      PL_ASSIGN_OR_RETURN(col_spec.name, ExtractString());
+      PL_ASSIGN_OR_RETURN(col_spec.name, ExtractStringView());
       PL_ASSIGN_OR_RETURN(col_spec.type, ExtractOption());
       r.col_specs.push_back(std::move(col_spec));
     }
@@ -366,13 +389,13 @@ StatusOr<ResultMetadata> FrameBodyDecoder::ExtractResultMetadata(bool prepared_r
 StatusOr<SchemaChange> FrameBodyDecoder::ExtractSchemaChange() {
   SchemaChange sc;
 
-  PL_ASSIGN_OR_RETURN(sc.change_type, ExtractString());
-  PL_ASSIGN_OR_RETURN(sc.target, ExtractString());
-  PL_ASSIGN_OR_RETURN(sc.keyspace, ExtractString());
+  PL_ASSIGN_OR_RETURN(sc.change_type, ExtractStringView());
+  PL_ASSIGN_OR_RETURN(sc.target, ExtractStringView());
+  PL_ASSIGN_OR_RETURN(sc.keyspace, ExtractStringView());
 
   if (sc.target != "KEYSPACE") {
     // Targets TABLE, TYPE, FUNCTION and AGGREGATE all have a name.
-    PL_ASSIGN_OR_RETURN(sc.name, ExtractString());
+    PL_ASSIGN_OR_RETURN(sc.name, ExtractStringView());
   }
 
   if (sc.target == "FUNCTION" || sc.target == "AGGREGATE") {
@@ -394,7 +417,7 @@ StatusOr<StartupReq> ParseStartupReq(Frame* frame) {
 StatusOr<AuthResponseReq> ParseAuthResponseReq(Frame* frame) {
   AuthResponseReq r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytes());
+  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytesView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -417,7 +440,7 @@ StatusOr<RegisterReq> ParseRegisterReq(Frame* frame) {
 StatusOr<QueryReq> ParseQueryReq(Frame* frame) {
   QueryReq r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.query, decoder.ExtractLongString());
+  PL_ASSIGN_OR_RETURN(r.query, decoder.ExtractLongStringView());
   PL_ASSIGN_OR_RETURN(r.qp, decoder.ExtractQueryParameters());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
@@ -426,7 +449,7 @@ StatusOr<QueryReq> ParseQueryReq(Frame* frame) {
 StatusOr<PrepareReq> ParsePrepareReq(Frame* frame) {
   PrepareReq r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.query, decoder.ExtractLongString());
+  PL_ASSIGN_OR_RETURN(r.query, decoder.ExtractLongStringView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -434,7 +457,7 @@ StatusOr<PrepareReq> ParsePrepareReq(Frame* frame) {
 StatusOr<ExecuteReq> ParseExecuteReq(Frame* frame) {
   ExecuteReq r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.id, decoder.ExtractShortBytes());
+  PL_ASSIGN_OR_RETURN(r.id, decoder.ExtractShortBytesView());
   PL_ASSIGN_OR_RETURN(r.qp, decoder.ExtractQueryParameters());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
@@ -455,11 +478,11 @@ StatusOr<BatchReq> ParseBatchReq(Frame* frame) {
     PL_ASSIGN_OR_RETURN(q.kind, EnumCast<BatchQueryKind>(kind_raw));
     switch (q.kind) {
       case BatchQueryKind::kString: {
-        PL_ASSIGN_OR_RETURN(q.query_or_id, decoder.ExtractLongString());
+        PL_ASSIGN_OR_RETURN(q.query_or_id, decoder.ExtractLongStringView());
         break;
       }
       case BatchQueryKind::kID: {
-        PL_ASSIGN_OR_RETURN(q.query_or_id, decoder.ExtractShortBytes());
+        PL_ASSIGN_OR_RETURN(q.query_or_id, decoder.ExtractShortBytesView());
         break;
       }
       default:
@@ -509,7 +532,7 @@ StatusOr<ErrorResp> ParseErrorResp(Frame* frame) {
   ErrorResp r;
   FrameBodyDecoder decoder(*frame);
   PL_ASSIGN_OR_RETURN(r.error_code, decoder.ExtractInt());
-  PL_ASSIGN_OR_RETURN(r.error_msg, decoder.ExtractString());
+  PL_ASSIGN_OR_RETURN(r.error_msg, decoder.ExtractStringView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -532,7 +555,7 @@ StatusOr<SupportedResp> ParseSupportedResp(Frame* frame) {
 StatusOr<AuthenticateResp> ParseAuthenticateResp(Frame* frame) {
   AuthenticateResp r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.authenticator_name, decoder.ExtractString());
+  PL_ASSIGN_OR_RETURN(r.authenticator_name, decoder.ExtractStringView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -540,7 +563,7 @@ StatusOr<AuthenticateResp> ParseAuthenticateResp(Frame* frame) {
 StatusOr<AuthSuccessResp> ParseAuthSuccessResp(Frame* frame) {
   AuthSuccessResp r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytes());
+  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytesView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -548,7 +571,7 @@ StatusOr<AuthSuccessResp> ParseAuthSuccessResp(Frame* frame) {
 StatusOr<AuthChallengeResp> ParseAuthChallengeResp(Frame* frame) {
   AuthChallengeResp r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytes());
+  PL_ASSIGN_OR_RETURN(r.token, decoder.ExtractBytesView());
   PL_RETURN_IF_ERROR(decoder.ExpectEOF());
   return r;
 }
@@ -566,21 +589,21 @@ StatusOr<ResultRowsResp> ParseResultRows(FrameBodyDecoder* decoder) {
   ResultRowsResp r;
   PL_ASSIGN_OR_RETURN(r.metadata, decoder->ExtractResultMetadata());
   PL_ASSIGN_OR_RETURN(r.rows_count, decoder->ExtractInt());
-  // Skip grabbing the row content for now.
-  // PL_RETURN_IF_ERROR(decoder->ExpectEOF());
+  // The row content is only decoded when it is read with a ResultRowsReader.
+  r.rows_content = decoder->Buf();
   return r;
 }
 
 StatusOr<ResultSetKeyspaceResp> ParseResultSetKeyspace(FrameBodyDecoder* decoder) {
   ResultSetKeyspaceResp r;
-  PL_ASSIGN_OR_RETURN(r.keyspace_name, decoder->ExtractString());
+  PL_ASSIGN_OR_RETURN(r.keyspace_name, decoder->ExtractStringView());
   PL_RETURN_IF_ERROR(decoder->ExpectEOF());
   return r;
 }
 
 StatusOr<ResultPreparedResp> ParseResultPrepared(FrameBodyDecoder* decoder) {
   ResultPreparedResp r;
-  PL_ASSIGN_OR_RETURN(r.id, decoder->ExtractShortBytes());
+  PL_ASSIGN_OR_RETURN(r.id, decoder->ExtractShortBytesView());
   // Note that two metadata are sent back. The first communicates the col specs for the Prepared
   // statement, while the second communicates the metadata for future EXECUTE statements.
   PL_ASSIGN_OR_RETURN(r.metadata, decoder->ExtractResultMetadata(/* has_pk */ true));
@@ -598,6 +621,19 @@ StatusOr<ResultSchemaChangeResp> ParseResultSchemaChange(FrameBodyDecoder* decod
 
 }  // namespace
 
+Status ResultRowsReader::NextRow(std::vector<BytesView>* values) {
+  if (rows_left_ <= 0) {
+    return error::Internal("No rows left.");
+  }
+  values->clear();
+  for (int32_t i = 0; i < columns_count_; ++i) {
+    PL_ASSIGN_OR_RETURN(BytesView value, decoder_.ExtractBytesView());
+    values->push_back(value);
+  }
+  --rows_left_;
+  return Status::OK();
+}
+
 StatusOr<ResultResp> ParseResultResp(Frame* frame) {
   ResultResp r;
   FrameBodyDecoder decoder(*frame);
@@ -636,10 +672,10 @@ StatusOr<ResultResp> ParseResultResp(Frame* frame) {
 StatusOr<EventResp> ParseEventResp(Frame* frame) {
   EventResp r;
   FrameBodyDecoder decoder(*frame);
-  PL_ASSIGN_OR_RETURN(r.event_type, decoder.ExtractString());
+  PL_ASSIGN_OR_RETURN(r.event_type, decoder.ExtractStringView());
 
   if (r.event_type == "TOPOLOGY_CHANGE" || r.event_type == "STATUS_CHANGE") {
-    PL_ASSIGN_OR_RETURN(r.change_type, decoder.ExtractString());
+    PL_ASSIGN_OR_RETURN(r.change_type, decoder.ExtractStringView());
     PL_ASSIGN_OR_RETURN(r.addr, decoder.ExtractInet());
     PL_RETURN_IF_ERROR(decoder.ExpectEOF());
     return r;
@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <sole.hpp>
@@ -39,6 +40,10 @@ namespace cass {
 // https://git-wip-us.apache.org/repos/asf?p=cassandra.git;a=blob_plain;f=doc/native_protocol_v3.spec
 // for a discussion on types.
 
+// The structs of the decoded frames below hold views into the frame body for strings and bytes, so
+// that they are only copied when they are recorded. They are valid as long as the frame is.
+using BytesView = std::basic_string_view<uint8_t>;
+
 // Some complex CQL types defined in the spec.
 using StringList = std::vector<std::string>;
 using StringMap = std::map<std::string, std::string>;
@@ -74,7 +79,7 @@ struct Option {
   DataType type;
 
   // Value is only used if DataType is kCustom.
-  std::string value;
+  std::string_view value;
 
   // TODO(oazizi): Store the additional information if DataType is kList/kMap/kSet/kUDT/kTuple.
 };
@@ -82,8 +87,8 @@ struct Option {
 // TODO(oazizi): Consider using std::optional when values are optional in the structs below.
 
 struct NameValuePair {
-  std::string name;
-  std::basic_string<uint8_t> value;
+  std::string_view name;
+  BytesView value;
 };
 
 // QueryParameters is a complex type used in QUERY and EXECUTE requests.
@@ -96,7 +101,7 @@ struct QueryParameters {
   uint16_t flags;
   std::vector<NameValuePair> values;
   int32_t page_size = 0;
-  std::basic_string<uint8_t> paging_state;
+  BytesView paging_state;
   uint16_t serial_consistency = 0;
   int64_t timestamp = 0;
 };
@@ -105,9 +110,9 @@ struct QueryParameters {
 // (<ksname><tablename>)?<name><type>
 // See section 4.2.5.2 of the spec for more details.
 struct ColSpec {
-  std::string ks_name;
-  std::string table_name;
-  std::string name;
+  std::string_view ks_name;
+  std::string_view table_name;
+  std::string_view name;
   Option type;
 };
 
@@ -117,9 +122,9 @@ struct ColSpec {
 struct ResultMetadata {
   int32_t flags;
   int32_t columns_count;
-  std::basic_string<uint8_t> paging_state;
-  std::string gts_keyspace_name;
-  std::string gts_table_name;
+  BytesView paging_state;
+  std::string_view gts_keyspace_name;
+  std::string_view gts_table_name;
   std::vector<ColSpec> col_specs;
 };
 
@@ -127,19 +132,19 @@ struct ResultMetadata {
 // See section 4.2.6 of the spec for details.
 struct SchemaChange {
   // One of "CREATED", "UPDATED" or "DROPPED"
-  std::string change_type;
+  std::string_view change_type;
 
   // One of "KEYSPACE", "TABLE", "TYPE", "FUNCTION" or "AGGREGATE"
-  std::string target;
+  std::string_view target;
 
-  std::string keyspace;
+  std::string_view keyspace;
 
   // If target is KEYSPACE, then name is unused;
   // If target is TABLE, then name is table name.
   // If target is TYPE, then name is user type name.
   // If target is FUNCTION, then name is function name.
   // If target is AGGREGATE, then name is aggregate name.
-  std::string name;
+  std::string_view name;
 
   // Only used for FUNCTION or AGGREGATE.
   StringList arg_types;
@@ -149,13 +154,13 @@ enum class BatchQueryKind : uint8_t { kString = 0, kID = 1 };
 
 struct BatchQuery {
   BatchQueryKind kind;
-  std::variant<std::string, std::basic_string<uint8_t>> query_or_id;
+  std::variant<std::string_view, BytesView> query_or_id;
   std::vector<NameValuePair> values;
 };
 
 struct ErrorResp {
   int32_t error_code;
-  std::string error_msg;
+  std::string_view error_msg;
 };
 
 struct StartupReq {
@@ -167,7 +172,7 @@ struct ReadyResp {
 };
 
 struct AuthenticateResp {
-  std::string authenticator_name;
+  std::string_view authenticator_name;
 };
 
 struct OptionsReq {
@@ -179,7 +184,7 @@ struct SupportedResp {
 };
 
 struct QueryReq {
-  std::string query;
+  std::string_view query;
   QueryParameters qp;
 };
 
@@ -188,15 +193,16 @@ struct ResultVoidResp {};
 struct ResultRowsResp {
   ResultMetadata metadata;
   int32_t rows_count;
-  // Don't actually grab the row content for now.
+  // The undecoded row content. Use ResultRowsReader to read the rows out of it.
+  std::string_view rows_content;
 };
 
 struct ResultSetKeyspaceResp {
-  std::string keyspace_name;
+  std::string_view keyspace_name;
 };
 
 struct ResultPreparedResp {
-  std::basic_string<uint8_t> id;
+  BytesView id;
   // Note that two metadata are sent back. The first communicates the col specs for the Prepared
   // statement, while the second communicates the metadata for future EXECUTE statements.
   ResultMetadata metadata;
@@ -223,11 +229,11 @@ struct ResultResp {
 };
 
 struct PrepareReq {
-  std::string query;
+  std::string_view query;
 };
 
 struct ExecuteReq {
-  std::basic_string<uint8_t> id;
+  BytesView id;
   QueryParameters qp;
 };
 
@@ -237,10 +243,10 @@ struct RegisterReq {
 
 // TODO(oazizi): Consider switching event_type string into enum for efficiency.
 struct EventResp {
-  std::string event_type;
+  std::string_view event_type;
 
   // Following fields are for (event_type == "TOPOLOGY_CHANGE" || event_type == "STATUS_CHANGE")
-  std::string change_type;
+  std::string_view change_type;
   SockAddr addr;
 
   // Following fields are for (event_type == "SCHEMA_CHANGE")
@@ -268,15 +274,15 @@ struct BatchReq {
 };
 
 struct AuthChallengeResp {
-  std::basic_string<uint8_t> token;
+  BytesView token;
 };
 
 struct AuthResponseReq {
-  std::basic_string<uint8_t> token;
+  BytesView token;
 };
 
 struct AuthSuccessResp {
-  std::basic_string<uint8_t> token;
+  BytesView token;
 };
 
 /**
@@ -319,9 +325,11 @@ class FrameBodyDecoder {
 
   // [string] A [short] n, followed by n bytes representing an UTF-8 string.
   StatusOr<std::string> ExtractString();
+  StatusOr<std::string_view> ExtractStringView();
 
   // [long string] An [int] n, followed by n bytes representing an UTF-8 string.
   StatusOr<std::string> ExtractLongString();
+  StatusOr<std::string_view> ExtractLongStringView();
 
   // [uuid] A 16 bytes long uuid.
   StatusOr<sole::uuid> ExtractUUID();
@@ -332,15 +340,18 @@ class FrameBodyDecoder {
   // [bytes] A [int] n, followed by n bytes if n >= 0. If n < 0,
   //         no byte should follow and the value represented is `null`.
   StatusOr<std::basic_string<uint8_t>> ExtractBytes();
+  StatusOr<BytesView> ExtractBytesView();
 
   // [value] A [int] n, followed by n bytes if n >= 0.
   //         If n == -1 no byte should follow and the value represented is `null`.
   //         If n == -2 no byte should follow and the value represented is
   //         `not set` not resulting in any change to the existing value.
   StatusOr<std::basic_string<uint8_t>> ExtractValue();
+  StatusOr<BytesView> ExtractValueView();
 
   // [short bytes]  A [short] n, followed by n bytes if n >= 0.
   StatusOr<std::basic_string<uint8_t>> ExtractShortBytes();
+  StatusOr<BytesView> ExtractShortBytesView();
 
   // [option] A pair of <id><value> where <id> is a [short] representing
   //          the option id and <value> depends on that option (and can be
@@ -387,6 +398,11 @@ class FrameBodyDecoder {
    */
   bool eof() { return binary_decoder_.eof(); }
 
+  /**
+   * The bytes that are yet to be processed.
+   */
+  std::string_view Buf() const { return binary_decoder_.Buf(); }
+
   Status ExpectEOF() {
     if (!eof()) {
       return error::Internal("There are still $0 bytes left", binary_decoder_.BufSize());
@@ -399,7 +415,7 @@ class FrameBodyDecoder {
   StatusOr<TIntType> ExtractIntCore();
 
   template <typename TCharType>
-  StatusOr<std::basic_string<TCharType>> ExtractBytesCore(int64_t len);
+  StatusOr<std::basic_string_view<TCharType>> ExtractBytesViewCore(int64_t len);
 
   template <typename TCharType, size_t N>
   Status ExtractBytesCore(TCharType* out);
@@ -410,6 +426,31 @@ class FrameBodyDecoder {
   const uint8_t version_;
 };
 
+/**
+ * ResultRowsReader reads the rows of a ROWS result one at a time, so that only the rows that are
+ * looked at are decoded. Each row has columns_count [bytes] values; the values are views into the
+ * frame body.
+ */
+class ResultRowsReader {
+ public:
+  explicit ResultRowsReader(const ResultRowsResp& resp)
+      : decoder_(resp.rows_content),
+        columns_count_(resp.metadata.columns_count),
+        rows_left_(resp.rows_count) {}
+
+  bool HasNext() const { return rows_left_ > 0; }
+
+  /**
+   * Reads the values of the next row into values. Null values are empty.
+   */
+  Status NextRow(std::vector<BytesView>* values);
+
+ private:
+  FrameBodyDecoder decoder_;
+  const int32_t columns_count_;
+  int32_t rows_left_;
+};
+
 StatusOr<ErrorResp> ParseErrorResp(Frame* frame);
 StatusOr<StartupReq> ParseStartupReq(Frame* frame);
 StatusOr<ReadyResp> ParseReadyResp(Frame* frame);
@@ -278,6 +278,15 @@ TEST(ExtractString, Exact) {
   ASSERT_TRUE(decoder.eof());
 }
 
+TEST(ExtractString, View) {
+  FrameBodyDecoder decoder(kString);
+  ASSERT_OK_AND_ASSIGN(std::string_view str, decoder.ExtractStringView());
+  EXPECT_EQ(str, "abcdefghijklmnopqrstuvwxyz");
+  // The view points into the frame body rather than a copy.
+  EXPECT_EQ(str.data(), kString.data() + 2);
+  ASSERT_TRUE(decoder.eof());
+}
+
 TEST(ExtractString, Empty) {
   FrameBodyDecoder decoder(kEmpty);
   ASSERT_NOT_OK(decoder.ExtractString());
@@ -766,6 +775,48 @@ TEST(ExtractSchemaChange, Basic) {
   EXPECT_THAT(sc.arg_types, IsEmpty());
 }
 
+//------------------------
+// ResultRowsReader
+//------------------------
+
+TEST(ResultRowsReader, ReadsRowsLazily) {
+  Frame frame;
+  frame.hdr.version = 4;
+  frame.msg = std::string(ConstStringView(
+      // Kind ROWS, flags no_metadata, 2 columns.
+      "\x00\x00\x00\x02"
+      "\x00\x00\x00\x04"
+      "\x00\x00\x00\x02"
+      // 2 rows.
+      "\x00\x00\x00\x02"
+      "\x00\x00\x00\x03"
+      "abc"
+      "\xff\xff\xff\xff"
+      "\x00\x00\x00\x01"
+      "d"
+      "\x00\x00\x00\x02"
+      "ef"));
+
+  ASSERT_OK_AND_ASSIGN(ResultResp result, ParseResultResp(&frame));
+  ASSERT_EQ(result.kind, ResultRespKind::kRows);
+  const auto& rows = std::get<ResultRowsResp>(result.resp);
+  EXPECT_EQ(rows.rows_count, 2);
+
+  ResultRowsReader reader(rows);
+  std::vector<BytesView> values;
+  ASSERT_TRUE(reader.HasNext());
+  ASSERT_OK(reader.NextRow(&values));
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(CreateStringView<char>(values[0]), "abc");
+  // Null values are empty.
+  EXPECT_THAT(values[1], IsEmpty());
+  ASSERT_OK(reader.NextRow(&values));
+  EXPECT_EQ(CreateStringView<char>(values[0]), "d");
+  EXPECT_EQ(CreateStringView<char>(values[1]), "ef");
+  EXPECT_FALSE(reader.HasNext());
+  EXPECT_NOT_OK(reader.NextRow(&values));
+}
+
 }  // namespace cass
 }  // namespace protocols
 }  // namespace stirling
@@ -21,9 +21,18 @@
 #include <picohttpparser.h>
 
 #include <algorithm>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <utility>
 
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
+
+DEFINE_bool(http_skip_removed_response_bodies, false,
+            "If true, the bodies of HTTP responses that would be removed by "
+            "--http_response_header_filters are not copied out of the data stream when parsing. "
+            "The response keeps the same placeholder body that it would have in the table.");
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -34,9 +43,10 @@ namespace {
 HeadersMap GetHTTPHeadersMap(const phr_header* headers, size_t num_headers) {
   HeadersMap result;
   for (size_t i = 0; i < num_headers; i++) {
-    std::string name(headers[i].name, headers[i].name_len);
-    std::string value(headers[i].value, headers[i].value_len);
-    result.insert({name, value});
+    // Construct the strings in place, so each header is only copied once.
+    result.emplace_hint(result.end(), std::piecewise_construct,
+                        std::forward_as_tuple(headers[i].name, headers[i].name_len),
+                        std::forward_as_tuple(headers[i].value, headers[i].value_len));
   }
   return result;
 }
@@ -91,7 +101,10 @@ ParseState ParseChunk(std::string_view* data, Message* result) {
 
 }  // namespace
 
-ParseState ParseBody(std::string_view* buf, Message* result) {
+// If body_placeholder is set, the body is consumed from buf, but the placeholder is stored in place
+// of the body.
+ParseState ParseBody(std::string_view* buf, Message* result,
+                     std::optional<std::string_view> body_placeholder = std::nullopt) {
   // Try to find boundary of message by looking at Content-Length and Transfer-Encoding.
 
   // From https://tools.ietf.org/html/rfc7230:
@@ -121,7 +134,7 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
       return ParseState::kNeedsMoreData;
     }
 
-    result->body = buf->substr(0, len);
+    result->body = body_placeholder.value_or(buf->substr(0, len));
     buf->remove_prefix(std::min(len, buf->size()));
     return ParseState::kSuccess;
   }
@@ -130,7 +143,11 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
   const auto transfer_encoding_iter = result->headers.find(kTransferEncoding);
   if (transfer_encoding_iter != result->headers.end() &&
       transfer_encoding_iter->second == "chunked") {
-    return ParseChunk(buf, result);
+    ParseState state = ParseChunk(buf, result);
+    if (state == ParseState::kSuccess && body_placeholder.has_value()) {
+      result->body = *body_placeholder;
+    }
+    return state;
   }
 
   // Case 3: Message has content, but no Content-Length or Transfer-Encoding.
@@ -188,7 +205,7 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
     // Only the body that is present at the time is emitted, since we don't
     // know if the data is actually complete or not without a length.
 
-    result->body = *buf;
+    result->body = body_placeholder.value_or(*buf);
     buf->remove_prefix(buf->size());
     LOG_FIRST_N(WARNING, 10)
         << "HTTP message with no Content-Length or Transfer-Encoding may produce "
@@ -259,7 +276,12 @@ ParseState ParseResponse(std::string_view* buf, Message* result) {
     result->resp_message = std::string(msg, msg_len);
     result->headers_byte_size = retval;
 
-    return ParseBody(buf, result);
+    // Bodies that will be removed anyway don't need to be copied.
+    std::optional<std::string_view> body_placeholder;
+    if (FLAGS_http_skip_removed_response_bodies) {
+      body_placeholder = RemovedBodyPlaceholder(*result);
+    }
+    return ParseBody(buf, result, body_placeholder);
   }
   if (retval == -2) {
     return ParseState::kNeedsMoreData;
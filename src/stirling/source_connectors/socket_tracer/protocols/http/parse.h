@@ -24,6 +24,8 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/types.h"
 
+DECLARE_bool(http_skip_removed_response_bodies);
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -286,6 +286,37 @@ TEST_F(HTTPParserTest, CompleteMessages) {
                                       msg_a.size() + msg_b.size() + msg_c.size() - 1}));
 }
 
+TEST_F(HTTPParserTest, SkipRemovedResponseBodies) {
+  FLAGS_http_skip_removed_response_bodies = true;
+  DEFER(FLAGS_http_skip_removed_response_bodies = false);
+
+  std::string json_resp =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/json\r\n"
+      "Content-Length: 2\r\n"
+      "\r\n"
+      "{}";
+  std::string image_resp =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: image/png\r\n"
+      "Content-Length: 4\r\n"
+      "\r\n"
+      "\x89PNG";
+  // Without a Content-Type, the chunked body is still decoded to find the end of the message.
+  std::string chunked_resp = HTTPRespWithChunkedBody({"b"});
+  std::string buf = absl::StrCat(json_resp, image_resp, chunked_resp);
+
+  std::deque<Message> parsed_messages;
+  ParseResult result = ParseFramesLoop(message_type_t::kResponse, buf, &parsed_messages);
+
+  EXPECT_EQ(ParseState::kSuccess, result.state);
+  EXPECT_EQ(buf.size(), result.end_position);
+  EXPECT_THAT(parsed_messages, ElementsAre(HasBody("{}"),
+                                           HasBody("<removed: non-text content-type>"),
+                                           HasBody("<removed: unknown content-type>")));
+  EXPECT_THAT(parsed_messages[1].headers, Contains(Pair(kContentType, "image/png")));
+}
+
 TEST_F(HTTPParserTest, PartialHeader) {
   // Partial header: Content-type value is missing, and no final \r\n.
   std::string msg =
@@ -18,8 +18,10 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
+#include <algorithm>
 #include <deque>
 #include <limits>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -43,40 +45,59 @@ namespace stirling {
 namespace protocols {
 namespace http {
 
-void PreProcessMessage(Message* message) {
+std::optional<std::string_view> RemovedBodyPlaceholder(const Message& message) {
   // Parse the flags on the first time only.
   static const HTTPHeaderFilter kHTTPResponseHeaderFilter =
       ParseHTTPHeaderFilters(FLAGS_http_response_header_filters);
 
   // Rule: Exclude anything that doesn't specify its Content-Type.
-  auto content_type_iter = message->headers.find(http::kContentType);
-  if (content_type_iter == message->headers.end()) {
-    message->body = "<removed: unknown content-type>";
-    return;
+  if (message.headers.find(http::kContentType) == message.headers.end()) {
+    return "<removed: unknown content-type>";
   }
 
   // Rule: Exclude anything that doesn't match the filter, if filter is active.
-  if (message->type == message_type_t::kResponse &&
+  if (message.type == message_type_t::kResponse &&
       (!kHTTPResponseHeaderFilter.inclusions.empty() ||
        !kHTTPResponseHeaderFilter.exclusions.empty())) {
-    if (!MatchesHTTPHeaders(message->headers, kHTTPResponseHeaderFilter)) {
-      message->body = "<removed: non-text content-type>";
-      return;
+    if (!MatchesHTTPHeaders(message.headers, kHTTPResponseHeaderFilter)) {
+      return "<removed: non-text content-type>";
     }
   }
+  return std::nullopt;
+}
+
+size_t PreProcessMessage(Message* message, size_t max_body_bytes) {
+  std::optional<std::string_view> placeholder = RemovedBodyPlaceholder(*message);
+  if (placeholder.has_value()) {
+    message->body = *placeholder;
+    return message->body.size();
+  }
 
   auto content_encoding_iter = message->headers.find(kContentEncoding);
   // Replace body with decompressed version, if required.
   if (content_encoding_iter != message->headers.end() && content_encoding_iter->second == "gzip") {
+    size_t inflated_size = px::zlib::GzipInflatedSize(message->body);
+    if (max_body_bytes == 0) {
+      message->body.clear();
+      return inflated_size;
+    }
+
+    // Only the head of the body is inflated, since the rest would be truncated anyway.
     std::string_view body_strview(message->body);
-    auto bodyOrErr = px::zlib::Inflate(body_strview);
+    auto bodyOrErr = px::zlib::InflatePrefix(body_strview, max_body_bytes);
     if (!bodyOrErr.ok()) {
       LOG(WARNING) << "Unable to gunzip HTTP body.";
       message->body = "<Failed to gunzip body>";
-    } else {
-      message->body = bodyOrErr.ValueOrDie();
+      return message->body.size();
+    }
+    message->body = bodyOrErr.ConsumeValueOrDie();
+    if (message->body.size() < max_body_bytes) {
+      // The whole body was inflated.
+      return message->body.size();
     }
+    return std::max(inflated_size, message->body.size());
   }
+  return message->body.size();
 }
 
 }  // namespace http
@@ -19,8 +19,11 @@
 #pragma once
 
 #include <deque>
+#include <limits>
 #include <map>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
@@ -45,7 +48,21 @@ namespace http {
 RecordsWithErrorCount<Record> ProcessMessages(std::deque<Message>* req_messages,
                                               std::deque<Message>* resp_messages);
 
-void PreProcessMessage(Message* message);
+/**
+ * Returns the placeholder that PreProcessMessage() puts in place of the body of the message,
+ * or std::nullopt if the body is kept. Only depends on the headers of the message.
+ */
+std::optional<std::string_view> RemovedBodyPlaceholder(const Message& message);
+
+/**
+ * Prepares the body of the message for export: removes the bodies that are filtered out, and
+ * decompresses gzip bodies, keeping at most max_body_bytes of the decompressed body.
+ * A limit of 0 skips decompression altogether, for when the body isn't exported.
+ *
+ * @return The size of the whole body, which for a gzip body is its decompressed size.
+ */
+size_t PreProcessMessage(Message* message,
+                         size_t max_body_bytes = std::numeric_limits<size_t>::max());
 
 }  // namespace http
 
@@ -40,8 +40,18 @@ TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressed) {
                                       0x85, 0x92, 0xd4, 0xe2, 0x12, 0x2e, 0x00, 0x8c, 0x2d,
                                       0xc0, 0xfa, 0x0f, 0x00, 0x00, 0x00};
   message.body.assign(reinterpret_cast<const char*>(compressed_bytes), sizeof(compressed_bytes));
-  PreProcessMessage(&message);
+  Message truncated_message = message;
+  Message skipped_message = message;
+
+  EXPECT_EQ(PreProcessMessage(&message), 15);
   EXPECT_EQ("This is a test\n", message.body);
+
+  // Only the head of the body is inflated, but the size is of the whole body.
+  EXPECT_EQ(PreProcessMessage(&truncated_message, 4), 15);
+  EXPECT_EQ("This", truncated_message.body);
+
+  EXPECT_EQ(PreProcessMessage(&skipped_message, 0), 15);
+  EXPECT_EQ("", skipped_message.body);
 }
 
 TEST(PreProcessRecordTest, ContentHeaderIsNotAdded) {
@@ -19,6 +19,8 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 DEFINE_uint32(stirling_http2_stream_id_gap_threshold, 100,
               "If a stream ID jumps by this many spots or more, an error is assumed and the entire "
@@ -29,21 +31,25 @@ namespace stirling {
 
 namespace {
 
+std::chrono::time_point<std::chrono::steady_clock> LastActivity(
+    const protocols::http2::Stream& stream) {
+  uint64_t timestamp_ns = std::max(stream.send.timestamp_ns, stream.recv.timestamp_ns);
+  return std::chrono::time_point<std::chrono::steady_clock>(std::chrono::nanoseconds(timestamp_ns));
+}
+
 void EraseExpiredStreams(std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp,
                          absl::flat_hash_map<uint32_t, protocols::http2::Stream>* streams) {
+  // The streams aren't ordered by activity, so all of them have to be checked.
   auto iter = streams->begin();
   while (iter != streams->end()) {
-    const auto& stream = iter->second;
-    uint64_t timestamp_ns = std::max(stream.send.timestamp_ns, stream.recv.timestamp_ns);
-    auto last_activity =
-        std::chrono::time_point<std::chrono::steady_clock>(std::chrono::nanoseconds(timestamp_ns));
-
-    if (expiry_timestamp < last_activity) {
-      break;
+    if (LastActivity(iter->second) <= expiry_timestamp) {
+      streams->erase(iter++);
+    } else {
+      ++iter;
     }
-    streams->erase(iter++);
   }
 }
+
 }  // namespace
 
 size_t HTTP2StreamsContainer::StreamsSize() {
@@ -56,14 +62,35 @@ size_t HTTP2StreamsContainer::StreamsSize() {
 
 void HTTP2StreamsContainer::Cleanup(
     size_t size_limit_bytes, std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp) {
+  EraseExpiredStreams(expiry_timestamp, &streams_);
+
   size_t size = StreamsSize();
-  if (size > size_limit_bytes) {
-    VLOG(1) << absl::Substitute("HTTP2 streams cleared due to size limit ($0 > $1).", size,
-                                size_limit_bytes);
-    streams_.clear();
+  if (size <= size_limit_bytes) {
+    return;
   }
 
-  EraseExpiredStreams(expiry_timestamp, &streams_);
+  // Evict the least recently active streams first, so that long-lived streaming RPCs don't take
+  // the recent streams of the connection down with them.
+  std::vector<std::pair<std::chrono::time_point<std::chrono::steady_clock>, uint32_t>>
+      streams_by_activity;
+  streams_by_activity.reserve(streams_.size());
+  for (const auto& [id, stream] : streams_) {
+    streams_by_activity.emplace_back(LastActivity(stream), id);
+  }
+  std::sort(streams_by_activity.begin(), streams_by_activity.end());
+
+  size_t num_evicted = 0;
+  for (const auto& [last_activity, id] : streams_by_activity) {
+    if (size <= size_limit_bytes) {
+      break;
+    }
+    auto iter = streams_.find(id);
+    size -= iter->second.ByteSize();
+    streams_.erase(iter);
+    ++num_evicted;
+  }
+  VLOG(1) << absl::Substitute("$0 HTTP2 streams evicted due to size limit ($1).", num_evicted,
+                              size_limit_bytes);
 }
 
 protocols::http2::HalfStream* HTTP2StreamsContainer::HalfStreamPtr(uint32_t stream_id,
@@ -85,7 +85,16 @@ StatusOr<RecordBatch> PacketDecoder::ExtractRecordBatch(int32_t* offset) {
   PL_UNUSED(producer_epoch);
   PL_UNUSED(base_sequence);
 
-  PL_ASSIGN_OR_RETURN(r.records, ExtractRegularArray(&PacketDecoder::ExtractRecordMessage));
+  if (skip_record_payloads_) {
+    // The records are skipped by the jump to the end of the batch below.
+    PL_ASSIGN_OR_RETURN(r.num_records, ExtractInt32());
+    if (r.num_records < 0) {
+      return error::Internal("Number of records cannot be negative.");
+    }
+  } else {
+    PL_ASSIGN_OR_RETURN(r.records, ExtractRegularArray(&PacketDecoder::ExtractRecordMessage));
+    r.num_records = r.records.size();
+  }
   PL_RETURN_IF_ERROR(JumpToOffset());
 
   *offset += length + kBaseOffsetLength + kLengthLength;
@@ -121,7 +130,7 @@ StatusOr<MessageSet> PacketDecoder::ExtractMessageSet() {
   while (offset < message_set.size) {
     auto record_batch_result = ExtractRecordBatch(&offset);
     if (record_batch_result.ok()) {
-      message_set.record_batches.push_back(record_batch_result.ValueOrDie());
+      message_set.record_batches.push_back(record_batch_result.ConsumeValueOrDie());
     } else {
       PL_RETURN_IF_ERROR(JumpToOffset());
       return message_set;
@@ -58,7 +58,8 @@ TEST(KafkaPacketDecoderTest, ExtractRecordBatchV8) {
   RecordBatch expected_result{{{.key = "", .value = "My first event"}}};
   PacketDecoder decoder(input);
   decoder.SetAPIInfo(APIKey::kProduce, 8);
-  EXPECT_OK_AND_EQ(decoder.ExtractRecordBatch(), expected_result);
+  int32_t offset = 0;
+  EXPECT_OK_AND_EQ(decoder.ExtractRecordBatch(&offset), expected_result);
 }
 
 TEST(KafkaPacketDecoderTest, ExtractRecordBatchV9) {
@@ -71,7 +72,25 @@ TEST(KafkaPacketDecoderTest, ExtractRecordBatchV9) {
   RecordBatch expected_result{{{.key = "", .value = "This is my first event"}}};
   PacketDecoder decoder(input);
   decoder.SetAPIInfo(APIKey::kProduce, 9);
-  EXPECT_OK_AND_EQ(decoder.ExtractRecordBatch(), expected_result);
+  int32_t offset = 0;
+  EXPECT_OK_AND_EQ(decoder.ExtractRecordBatch(&offset), expected_result);
+}
+
+TEST(KafkaPacketDecoderTest, ExtractRecordBatchSkippingRecordPayloads) {
+  const std::string_view input = CreateStringView<char>(
+      "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x46\xff\xff\xff\xff\x02\xa7\x88\x71\xd8\x00"
+      "\x00\x00\x00\x00\x00\x00\x00\x01\x7a\xb2\x0a\x70\x1d\x00\x00\x01\x7a\xb2\x0a\x70\x1d\xff"
+      "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x00\x00\x00\x01\x28\x00\x00\x00\x01"
+      "\x1c\x4d\x79\x20\x66\x69\x72\x73\x74\x20\x65\x76\x65\x6e\x74\x00");
+  PacketDecoder decoder(input);
+  decoder.SetAPIInfo(APIKey::kProduce, 8);
+  decoder.set_skip_record_payloads(true);
+  int32_t offset = 0;
+  ASSERT_OK_AND_ASSIGN(RecordBatch record_batch, decoder.ExtractRecordBatch(&offset));
+  EXPECT_THAT(record_batch.records, IsEmpty());
+  EXPECT_EQ(record_batch.num_records, 1);
+  EXPECT_EQ(offset, static_cast<int32_t>(input.size()));
+  EXPECT_TRUE(decoder.eof());
 }
 
 }  // namespace kafka
@@ -37,27 +37,16 @@ StatusOr<std::basic_string<TCharType>> PacketDecoder::ExtractBytesCore(int32_t l
 
 template <uint8_t TMaxLength>
 StatusOr<int64_t> PacketDecoder::ExtractUnsignedVarintCore() {
-  constexpr uint8_t kFirstBitMask = 0x80;
-  constexpr uint8_t kLastSevenBitMask = 0x7f;
-  constexpr uint8_t kByteLength = 7;
-
-  int64_t value = 0;
-  for (int i = 0; i < TMaxLength; i += kByteLength) {
-    PL_ASSIGN_OR_RETURN(uint64_t b, binary_decoder_.ExtractChar());
-    if (!(b & kFirstBitMask)) {
-      value |= (b << i);
-      return value;
-    }
-    value |= ((b & kLastSevenBitMask) << i);
-  }
-  return error::Internal("Extract Varint Core failure.");
+  // Each byte holds 7 bits of the value.
+  constexpr size_t kMaxBytes = (TMaxLength + 6) / 7;
+  PL_ASSIGN_OR_RETURN(uint64_t value, binary_decoder_.ExtractUnsignedVarint<kMaxBytes>());
+  return static_cast<int64_t>(value);
 }
 
 template <uint8_t TMaxLength>
 StatusOr<int64_t> PacketDecoder::ExtractVarintCore() {
-  PL_ASSIGN_OR_RETURN(int64_t value, ExtractUnsignedVarintCore<TMaxLength>());
-  // Casting to uint64_t for logical right shift.
-  return (static_cast<uint64_t>(value) >> 1) ^ (-(value & 1));
+  constexpr size_t kMaxBytes = (TMaxLength + 6) / 7;
+  return binary_decoder_.ExtractVarint<kMaxBytes>();
 }
 
 /*
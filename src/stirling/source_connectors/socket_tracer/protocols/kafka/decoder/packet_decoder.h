@@ -238,6 +238,13 @@ class PacketDecoder {
     is_flexible_ = IsFlexible(api_key, api_version);
   }
 
+  // When set, the records of record batches are only counted, because their keys and values are
+  // not reported. This avoids copying them out of the packet, and also counts the records of
+  // compressed batches, since the count precedes the compressed records.
+  void set_skip_record_payloads(bool skip_record_payloads) {
+    skip_record_payloads_ = skip_record_payloads;
+  }
+
  private:
   // Represents a sequence of characters. First the length N is given as an INT16. Then N
   // bytes follow which are the UTF-8 encoding of the character sequence.
@@ -308,6 +315,7 @@ class PacketDecoder {
   APIKey api_key_;
   int16_t api_version_ = 0;
   bool is_flexible_ = false;
+  bool skip_record_payloads_ = false;
 };
 
 }  // namespace kafka
@@ -42,7 +42,9 @@ struct RecordMessage {
 };
 
 struct RecordBatch {
+  // Left empty when the decoder skips record payloads.
   std::vector<RecordMessage> records;
+  int32_t num_records = 0;
 
   void ToJSON(utils::JSONObjectBuilder* builder) const {
     builder->WriteKVArrayRecursive<RecordMessage>("records", records);
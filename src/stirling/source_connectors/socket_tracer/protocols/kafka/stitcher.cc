@@ -91,6 +91,7 @@ Status ProcessSyncGroupResp(PacketDecoder* decoder, Response* resp) {
 Status ProcessReq(Packet* req_packet, Request* req) {
   req->timestamp_ns = req_packet->timestamp_ns;
   PacketDecoder decoder(*req_packet);
+  decoder.set_skip_record_payloads(true);
   // Extracts api_key, api_version, and correlation_id.
   PL_RETURN_IF_ERROR(decoder.ExtractReqHeader(req));
 
@@ -114,6 +115,7 @@ Status ProcessResp(Packet* resp_packet, Response* resp, APIKey api_key, int16_t
   resp->timestamp_ns = resp_packet->timestamp_ns;
   PacketDecoder decoder(*resp_packet);
   decoder.SetAPIInfo(api_key, api_version);
+  decoder.set_skip_record_payloads(true);
 
   PL_RETURN_IF_ERROR(decoder.ExtractRespHeader(resp));
 
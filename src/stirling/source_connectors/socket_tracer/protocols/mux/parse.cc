@@ -72,17 +72,23 @@ ParseState ParseFullFrame(BinaryDecoder* decoder, Frame* frame) {
 
     absl::flat_hash_map<std::string, std::string> unpacked_value;
     if (ctx_key == "com.twitter.finagle.Deadline") {
-      PL_ASSIGN_OR(int64_t timestamp, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
-      PL_ASSIGN_OR(int64_t deadline, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
+      if (decoder->BufSize() < 2 * sizeof(int64_t)) {
+        return ParseState::kInvalid;
+      }
+      int64_t timestamp = decoder->ExtractIntUnchecked<int64_t>();
+      int64_t deadline = decoder->ExtractIntUnchecked<int64_t>();
 
       unpacked_value["timestamp"] = std::to_string(timestamp / 1000);
       unpacked_value["deadline"] = std::to_string(deadline / 1000);
 
     } else if (ctx_key == "com.twitter.finagle.tracing.TraceContext") {
-      PL_ASSIGN_OR(int64_t span_id, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
-      PL_ASSIGN_OR(int64_t parent_id, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
-      PL_ASSIGN_OR(int64_t trace_id, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
-      PL_ASSIGN_OR(int64_t flags, decoder->ExtractInt<int64_t>(), return ParseState::kInvalid);
+      if (decoder->BufSize() < 4 * sizeof(int64_t)) {
+        return ParseState::kInvalid;
+      }
+      int64_t span_id = decoder->ExtractIntUnchecked<int64_t>();
+      int64_t parent_id = decoder->ExtractIntUnchecked<int64_t>();
+      int64_t trace_id = decoder->ExtractIntUnchecked<int64_t>();
+      int64_t flags = decoder->ExtractIntUnchecked<int64_t>();
 
       unpacked_value["span id"] = std::to_string(span_id);
       unpacked_value["parent id"] = std::to_string(parent_id);
@@ -30,6 +30,7 @@
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interned_string.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -342,9 +343,10 @@ struct StmtCloseRequest {
 /**
  * PreparedStatement holds a prepared statement string, and a parsed response,
  * which contains the placeholder column definitions.
+ * The string is interned, because pooled connections prepare the same statements.
  */
 struct PreparedStatement {
-  std::string request;
+  InternedString request;
   StmtPrepareOKResponse response;
 };
 
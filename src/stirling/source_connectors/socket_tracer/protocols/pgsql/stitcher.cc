@@ -261,7 +261,7 @@ Status HandleBind(const RegularMessage& bind_msg, MsgDeqIter* resp_iter, const M
         return error::InvalidArgument("Statement [name=$0] is not recorded",
                                       bind_req.src_prepared_stat_name);
       }
-      state->bound_statement = state->prepared_statements[bind_req.src_prepared_stat_name];
+      state->bound_statement = state->prepared_statements[bind_req.src_prepared_stat_name].str();
     }
     state->bound_params = bind_req.params;
     req_resp->resp.msg = CmdCmpl{.timestamp_ns = iter->timestamp_ns, .cmd_tag = "BIND COMPLETE"};
@@ -27,6 +27,7 @@
 #include <absl/container/flat_hash_map.h>
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interned_string.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -531,7 +532,8 @@ struct Record {
 };
 
 struct State {
-  absl::flat_hash_map<std::string, std::string> prepared_statements;
+  // The statements are interned, because pooled connections prepare the same statements.
+  absl::flat_hash_map<std::string, InternedString> prepared_statements;
 
   // One postgres session can only have at most one unnamed statement.
   std::string unnamed_statement;
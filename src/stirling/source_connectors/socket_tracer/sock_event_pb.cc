@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/sock_event_pb.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+void ConnIDToPB(const conn_id_t& conn_id, sockeventpb::ConnID* pb) {
+  pb->set_pid(conn_id.upid.pid);
+  pb->set_start_time_ns(conn_id.upid.start_time_ticks);
+  pb->set_fd(conn_id.fd);
+  pb->set_generation(conn_id.tsid);
+}
+
+conn_id_t ConnIDFromPB(const sockeventpb::ConnID& pb) {
+  conn_id_t conn_id = {};
+  conn_id.upid.pid = pb.pid();
+  conn_id.upid.start_time_ticks = pb.start_time_ns();
+  conn_id.fd = pb.fd();
+  conn_id.tsid = pb.generation();
+  return conn_id;
+}
+
+}  // namespace
+
+sockeventpb::SocketEvent ToSocketEventPB(const SocketDataEvent& event) {
+  sockeventpb::SocketEvent event_pb;
+  sockeventpb::SocketDataEvent* pb = event_pb.mutable_data();
+  pb->mutable_attr()->set_timestamp_ns(event.attr.timestamp_ns);
+  ConnIDToPB(event.attr.conn_id, pb->mutable_attr()->mutable_conn_id());
+  pb->mutable_attr()->set_protocol(event.attr.protocol);
+  pb->mutable_attr()->set_role(event.attr.role);
+  pb->mutable_attr()->set_direction(event.attr.direction);
+  pb->mutable_attr()->set_pos(event.attr.pos);
+  pb->mutable_attr()->set_msg_size(event.attr.msg_size);
+  pb->mutable_attr()->set_ssl(event.attr.ssl);
+  pb->mutable_attr()->set_source_fn(event.attr.source_fn);
+  pb->mutable_attr()->set_sampling_rate(event.attr.sampling_rate);
+  pb->set_msg(event.msg);
+  return event_pb;
+}
+
+sockeventpb::SocketEvent ToSocketEventPB(const socket_control_event_t& event) {
+  sockeventpb::SocketEvent event_pb;
+  sockeventpb::SocketControlEvent* pb = event_pb.mutable_control();
+  pb->set_type(event.type);
+  pb->set_timestamp_ns(event.timestamp_ns);
+  ConnIDToPB(event.conn_id, pb->mutable_conn_id());
+  switch (event.type) {
+    case kConnOpen:
+      pb->set_addr(&event.open.addr, sizeof(event.open.addr));
+      pb->set_role(event.open.role);
+      break;
+    case kConnClose:
+      pb->set_wr_bytes(event.close.wr_bytes);
+      pb->set_rd_bytes(event.close.rd_bytes);
+      break;
+  }
+  return event_pb;
+}
+
+std::string ToSocketDataEventBuffer(const sockeventpb::SocketDataEvent& pb) {
+  socket_data_event_t::attr_t attr = {};
+  attr.timestamp_ns = pb.attr().timestamp_ns();
+  attr.conn_id = ConnIDFromPB(pb.attr().conn_id());
+  attr.protocol = static_cast<traffic_protocol_t>(pb.attr().protocol());
+  attr.role = static_cast<endpoint_role_t>(pb.attr().role());
+  attr.direction = static_cast<traffic_direction_t>(pb.attr().direction());
+  attr.ssl = pb.attr().ssl();
+  attr.source_fn = static_cast<source_function_t>(pb.attr().source_fn());
+  attr.pos = pb.attr().pos();
+  attr.msg_size = pb.attr().msg_size();
+  attr.msg_buf_size = pb.msg().size();
+  attr.sampling_rate = pb.attr().sampling_rate();
+  // The recorded message already includes any prepended length header.
+  attr.prepend_length_header = false;
+
+  std::string buf(offsetof(socket_data_event_t, msg) + pb.msg().size(), '\0');
+  std::memcpy(buf.data() + offsetof(socket_data_event_t, attr), &attr, sizeof(attr));
+  std::memcpy(buf.data() + offsetof(socket_data_event_t, msg), pb.msg().data(), pb.msg().size());
+  return buf;
+}
+
+socket_control_event_t ToSocketControlEvent(const sockeventpb::SocketControlEvent& pb) {
+  socket_control_event_t event = {};
+  event.type = static_cast<control_event_type_t>(pb.type());
+  event.timestamp_ns = pb.timestamp_ns();
+  event.conn_id = ConnIDFromPB(pb.conn_id());
+  switch (event.type) {
+    case kConnOpen:
+      std::memcpy(&event.open.addr, pb.addr().data(),
+                  std::min(pb.addr().size(), sizeof(event.open.addr)));
+      event.open.role = static_cast<endpoint_role_t>(pb.role());
+      break;
+    case kConnClose:
+      event.close.wr_bytes = pb.wr_bytes();
+      event.close.rd_bytes = pb.rd_bytes();
+      break;
+  }
+  return event;
+}
+
+}  // namespace stirling
+}  // namespace px
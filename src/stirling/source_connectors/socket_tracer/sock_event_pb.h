@@ -0,0 +1,44 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+
+namespace px {
+namespace stirling {
+
+// Conversions between the events of the perf buffers and the protobufs that they are recorded
+// as, with --perf_buffer_events_output_path.
+
+sockeventpb::SocketEvent ToSocketEventPB(const SocketDataEvent& event);
+sockeventpb::SocketEvent ToSocketEventPB(const socket_control_event_t& event);
+
+/**
+ * Returns the socket_data_event_t of the protobuf, as it is output to the perf buffer: trimmed to
+ * the size of its message.
+ */
+std::string ToSocketDataEventBuffer(const sockeventpb::SocketDataEvent& pb);
+
+socket_control_event_t ToSocketControlEvent(const sockeventpb::SocketControlEvent& pb);
+
+}  // namespace stirling
+}  // namespace px
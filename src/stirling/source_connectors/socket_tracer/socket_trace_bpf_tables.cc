@@ -37,12 +37,17 @@ NO_OPT_ATTR void ConnInfoMapCleanupTrigger(int n, struct conn_id_t* conn_id_vec)
   PL_UNUSED(conn_id_vec);
   return;
 }
+
+NO_OPT_ATTR void TLSWriteFlushTrigger(struct conn_id_t* conn_id) {
+  PL_UNUSED(conn_id);
+  return;
+}
 }
 
 namespace px {
 namespace stirling {
 
-ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc)
+ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc, bool tls_write_coalesce)
     : conn_info_map_(bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
       conn_disabled_map_(bcc->GetHashTable<uint64_t, uint64_t>("conn_disabled_map")) {
   // Use address instead of symbol to specify this probe,
@@ -58,6 +63,20 @@ ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc)
                                .probe_fn = "conn_cleanup_uprobe"};
 
   PL_CHECK_OK(bcc->AttachUProbe(uprobe));
+
+  if (tls_write_coalesce) {
+    tls_write_coalesce_map_.emplace(
+        bcc->GetHashTable<uint64_t, struct tls_write_coalesce_t>("tls_write_coalesce_map"));
+
+    bpf_tools::UProbeSpec flush_uprobe{
+        .binary_path = self_path,
+        .symbol = {},  // Keep GCC happy.
+        .address = reinterpret_cast<uint64_t>(&TLSWriteFlushTrigger),
+        .attach_type = bpf_tools::BPFProbeAttachType::kEntry,
+        .probe_fn = "tls_write_flush_uprobe"};
+
+    PL_CHECK_OK(bcc->AttachUProbe(flush_uprobe));
+  }
 }
 
 void ConnInfoMapManager::ReleaseResources(struct conn_id_t conn_id) {
@@ -80,7 +99,8 @@ void ConnInfoMapManager::Disable(struct conn_id_t conn_id) {
 void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
   const auto& sysconfig = system::Config::GetInstance();
 
-  for (const auto& [pid_fd, conn_info] : conn_info_map_.get_table_offline()) {
+  for (const auto& [pid_fd, conn_info] :
+       bpf_tools::BCCWrapper::GetHashTableEntries(&conn_info_map_)) {
     uint32_t pid = pid_fd >> 32;
     int32_t fd = pid_fd;
 
@@ -103,5 +123,20 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
   }
 }
 
+void ConnInfoMapManager::FlushStaleTLSWrites(uint64_t now_ns) {
+  if (!tls_write_coalesce_map_.has_value()) {
+    return;
+  }
+
+  for (auto& [pid_fd, pending] :
+       bpf_tools::BCCWrapper::GetHashTableEntries(&tls_write_coalesce_map_.value())) {
+    PL_UNUSED(pid_fd);
+    if (now_ns < pending.attr.timestamp_ns + kTLSWriteCoalesceTimeoutNS) {
+      continue;
+    }
+    TLSWriteFlushTrigger(&pending.attr.conn_id);
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
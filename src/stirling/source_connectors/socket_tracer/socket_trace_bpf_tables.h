@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -34,7 +35,8 @@ class ConnTrackersManager;
 
 class ConnInfoMapManager {
  public:
-  explicit ConnInfoMapManager(bpf_tools::BCCWrapper* bcc);
+  // tls_write_coalesce must match whether the BPF program coalesces small TLS writes.
+  ConnInfoMapManager(bpf_tools::BCCWrapper* bcc, bool tls_write_coalesce);
 
   void ReleaseResources(struct conn_id_t conn_id);
 
@@ -42,9 +44,15 @@ class ConnInfoMapManager {
 
   void CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr);
 
+  // Has BPF send the coalesced TLS writes that have been pending for longer than
+  // kTLSWriteCoalesceTimeoutNS at now_ns (steady clock), as BPF only flushes them on the next
+  // event of the connection. Does nothing if the writes are not coalesced.
+  void FlushStaleTLSWrites(uint64_t now_ns);
+
  private:
   ebpf::BPFHashTable<uint64_t, struct conn_info_t> conn_info_map_;
   ebpf::BPFHashTable<uint64_t, uint64_t> conn_disabled_map_;
+  std::optional<ebpf::BPFHashTable<uint64_t, struct tls_write_coalesce_t>> tls_write_coalesce_map_;
 
   std::vector<struct conn_id_t> pending_release_queue_;
 
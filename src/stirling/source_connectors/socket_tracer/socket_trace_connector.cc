@@ -21,11 +21,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
+#include <tuple>
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <absl/strings/ascii.h>
 #include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/delimited_message_util.h>
 #include <magic_enum.hpp>
@@ -40,6 +48,7 @@
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 #include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/sock_event_pb.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
 #include "src/stirling/utils/proc_path_tools.h"
@@ -55,17 +64,42 @@ DEFINE_uint32(
     std::chrono::minutes(10) / px::stirling::SocketTraceConnector::kSamplingPeriod,
     "Ratio of how frequently conn_stats_table is populated relative to the base sampling period");
 
+DEFINE_uint32(stirling_socket_tracer_parse_threads, 1,
+              "Number of threads that parse and stitch the traced connections. Each connection is "
+              "always parsed by the same thread.");
+DEFINE_string(stirling_socket_tracer_parse_thread_placement, "",
+              "The CPUs and NUMA memory policy of the parse threads, other than the Stirling "
+              "thread itself, as '<cpu list>[:<default|local|bind|interleave|preferred>]'. Empty "
+              "leaves them unplaced.");
+
+DEFINE_bool(stirling_socket_tracer_use_ringbuf, false,
+            "If true, data and control events are sent through BPF ring buffers shared by all "
+            "CPUs, rather than per-CPU perf buffers. Requires Linux 5.8+; older kernels keep "
+            "using perf buffers.");
+
+DEFINE_bool(stirling_conn_stats_bpf_aggregation, false,
+            "If true, BPF aggregates the conn stats of each local process and remote endpoint in "
+            "a map that is read every conn_stats sampling period, instead of sending conn stats "
+            "events through a perf buffer.");
+
+DEFINE_int32(stirling_socket_tracer_tls_write_coalesce_bytes, 0,
+             "If positive, BPF coalesces adjacent TLS writes of a connection into one data event, "
+             "up to this many bytes (at most 512). The pending writes are sent with the next read, "
+             "close, or write that doesn't fit, or by user-space once they have been pending for "
+             "10ms. Writes of connections that find the pending-writes map full are sent on "
+             "their own, uncoalesced. 0 sends every write on its own.");
+
 DEFINE_bool(stirling_enable_periodic_bpf_map_cleanup, true,
             "Disable periodic BPF map cleanup (for testing)");
 
 DEFINE_int32(test_only_socket_trace_target_pid, kTraceAllTGIDs, "The process to trace.");
-// TODO(yzhao): If we ever need to write all events from different perf buffers, then we need either
-// write to different files for individual perf buffers, or create a protobuf message with an oneof
-// field to include all supported message types.
+// TODO(yzhao): If we ever need to write all events from different perf buffers, then we need to
+// add the other message types to sockeventpb::SocketEvent.
 DEFINE_string(perf_buffer_events_output_path, "",
               "If not empty, specifies the path & format to a file to which the socket tracer "
-              "writes data events. If the filename ends with '.bin', the events are serialized in "
-              "binary format; otherwise, text format.");
+              "writes data and control events. If the filename ends with '.bin', the events are "
+              "serialized in binary format; otherwise, text format. The events can be replayed "
+              "with PerfBufferEventsReplayer.");
 
 // PROTOCOL_LIST: Requires update on new protocols.
 DEFINE_bool(stirling_enable_http_tracing, true,
@@ -89,6 +123,18 @@ DEFINE_bool(stirling_enable_kafka_tracing, true,
 DEFINE_bool(stirling_enable_mux_tracing, false,
             "If true, stirling will trace and process Mux messages.");
 
+DEFINE_string(stirling_socket_tracer_sampling_rates, "",
+              "Comma-separated list of protocol:rate pairs, e.g. 'http:0.1,mysql:0.5'. The rate is "
+              "the fraction of the protocol's connections whose data is traced. Protocols that "
+              "aren't listed are traced in full.");
+DEFINE_string(stirling_socket_tracer_namespace_sampling_rates, "",
+              "Comma-separated list of namespace:rate pairs, e.g. 'batch:0.01'. Lowers the "
+              "sampling rate of the connections of the pods in each K8s namespace.");
+DEFINE_string(stirling_socket_tracer_capture_limits, "",
+              "Comma-separated list of protocol:bytes pairs, e.g. 'http:65536'. Only the first "
+              "bytes of each message of the protocol are copied from the kernel; the rest is "
+              "skipped over. Protocols that aren't listed are captured in full.");
+
 DEFINE_bool(stirling_disable_self_tracing, true,
             "If true, stirling will not trace and process syscalls made by itself.");
 
@@ -108,9 +154,14 @@ using ::px::stirling::protocols::kMaxBodyBytes;
 using ::px::utils::ToJSONString;
 
 SocketTraceConnector::SocketTraceConnector(std::string_view source_name)
-    : SourceConnector(source_name, kTables), conn_stats_(&conn_trackers_mgr_), uprobe_mgr_(this) {
+    : SourceConnector(source_name, kTables),
+      conn_stats_(&conn_trackers_mgr_),
+      uprobe_mgr_(this),
+      parser_pool_(std::max<uint32_t>(1, FLAGS_stirling_socket_tracer_parse_threads),
+                   FLAGS_stirling_socket_tracer_parse_thread_placement) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
   InitProtocolTransferSpecs();
+  worker_data_tables_.resize(parser_pool_.num_workers());
 }
 
 void SocketTraceConnector::InitProtocolTransferSpecs() {
@@ -189,6 +240,55 @@ void SocketTraceConnector::InitProtocolTransferSpecs() {
   }
 }
 
+namespace {
+
+// Parses a comma-separated list of name:rate pairs.
+StatusOr<absl::flat_hash_map<std::string, double>> ParseSamplingRates(std::string_view spec) {
+  absl::flat_hash_map<std::string, double> rates;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> parts = absl::StrSplit(entry, ':');
+    double rate = 0;
+    if (parts.size() != 2 || !absl::SimpleAtod(parts[1], &rate) || rate < 0 || rate > 1) {
+      return error::InvalidArgument("Invalid sampling rate '$0', expected <name>:<rate in [0, 1]>",
+                                    entry);
+    }
+    rates[absl::StripAsciiWhitespace(parts[0])] = rate;
+  }
+  return rates;
+}
+
+// Parses a comma-separated list of protocol:bytes pairs.
+StatusOr<absl::flat_hash_map<std::string, int32_t>> ParseCaptureLimits(std::string_view spec) {
+  absl::flat_hash_map<std::string, int32_t> limits;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> parts = absl::StrSplit(entry, ':');
+    int32_t limit = 0;
+    if (parts.size() != 2 || !absl::SimpleAtoi(parts[1], &limit) || limit < 0) {
+      return error::InvalidArgument("Invalid capture limit '$0', expected <protocol>:<bytes>",
+                                    entry);
+    }
+    limits[absl::StripAsciiWhitespace(parts[0])] = limit;
+  }
+  return limits;
+}
+
+StatusOr<traffic_protocol_t> ProtocolFromName(std::string_view name) {
+  for (auto protocol : magic_enum::enum_values<traffic_protocol_t>()) {
+    std::string_view protocol_name = magic_enum::enum_name(protocol);
+    absl::ConsumePrefix(&protocol_name, "kProtocol");
+    if (absl::EqualsIgnoreCase(protocol_name, name)) {
+      return protocol;
+    }
+  }
+  return error::InvalidArgument("Unknown protocol '$0'", name);
+}
+
+int32_t ToBPFSamplingRate(double rate) {
+  return static_cast<int32_t>(std::lround(std::clamp(rate, 0.0, 1.0) * kSamplingRateScale));
+}
+
+}  // namespace
+
 Status SocketTraceConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
@@ -200,13 +300,56 @@ Status SocketTraceConnector::InitImpl() {
         "timestamps in a way that matches how /proc/stat does it");
   }
 
-  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script));
+  const bool use_ringbuf = FLAGS_stirling_socket_tracer_use_ringbuf && RingBuffersSupported();
+  LOG_IF(WARNING, FLAGS_stirling_socket_tracer_use_ringbuf && !use_ringbuf)
+      << "BPF ring buffers are not supported by the kernel, using perf buffers instead.";
+  std::vector<std::string> cflags;
+  if (use_ringbuf) {
+    // The perf buffer sizes target the data of the whole host over one sampling period, yet are
+    // allocated once per CPU. A single ring buffer of the same size holds as much.
+    cflags = {"-DSOCKET_TRACE_USE_RINGBUF",
+              absl::Substitute("-DSOCKET_DATA_RINGBUF_PAGES=$0",
+                               RingBufferPages(kTargetDataBufferSize)),
+              absl::Substitute("-DSOCKET_CONTROL_RINGBUF_PAGES=$0",
+                               RingBufferPages(kTargetControlBufferSize))};
+  }
+
+  conn_stats_bpf_agg_ = FLAGS_stirling_conn_stats_bpf_aggregation;
+  if (conn_stats_bpf_agg_) {
+    cflags.push_back("-DCONN_STATS_BPF_AGG");
+  }
+
+  if (FLAGS_stirling_socket_tracer_tls_write_coalesce_bytes > 0) {
+    cflags.push_back(absl::Substitute(
+        "-DTLS_WRITE_COALESCE_BYTES=$0",
+        std::min(FLAGS_stirling_socket_tracer_tls_write_coalesce_bytes,
+                 MAX_TLS_WRITE_COALESCE_BYTES)));
+  }
+
+  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script, cflags));
   PL_RETURN_IF_ERROR(AttachKProbes(kProbeSpecs));
   LOG(INFO) << absl::Substitute("Number of kprobes deployed = $0", kProbeSpecs.size());
   LOG(INFO) << "Probes successfully deployed.";
 
-  PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
-  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", kPerfBufferSpecs.size());
+  int num_perf_buffers = 0;
+  int num_ring_buffers = 0;
+  for (const bpf_tools::PerfBufferSpec& spec : kPerfBufferSpecs) {
+    // The conn stats are read from conn_stats_agg_map instead.
+    if (conn_stats_bpf_agg_ && spec.name == "conn_stats_events") {
+      continue;
+    }
+    const bool is_ringbuf =
+        spec.name == "socket_data_events" || spec.name == "socket_control_events";
+    if (use_ringbuf && is_ringbuf) {
+      PL_RETURN_IF_ERROR(OpenRingBuffer(spec, this));
+      ++num_ring_buffers;
+    } else {
+      PL_RETURN_IF_ERROR(OpenPerfBuffer(spec, this));
+      ++num_perf_buffers;
+    }
+  }
+  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0, ring buffers opened = $1",
+                                num_perf_buffers, num_ring_buffers);
 
   // Set trace role to BPF probes.
   for (const auto& p : magic_enum::enum_values<traffic_protocol_t>()) {
@@ -219,6 +362,32 @@ Status SocketTraceConnector::InitImpl() {
     }
   }
 
+  PL_ASSIGN_OR_RETURN(auto protocol_sampling_rates,
+                      ParseSamplingRates(FLAGS_stirling_socket_tracer_sampling_rates));
+  absl::flat_hash_map<traffic_protocol_t, double> sampling_rate_by_protocol;
+  for (const auto& [name, rate] : protocol_sampling_rates) {
+    PL_ASSIGN_OR_RETURN(traffic_protocol_t protocol, ProtocolFromName(name));
+    sampling_rate_by_protocol[protocol] = rate;
+  }
+  for (const auto& p : magic_enum::enum_values<traffic_protocol_t>()) {
+    auto iter = sampling_rate_by_protocol.find(p);
+    double rate = (iter == sampling_rate_by_protocol.end()) ? 1.0 : iter->second;
+    PL_RETURN_IF_ERROR(SetProtocolSamplingRate(p, rate));
+  }
+
+  PL_ASSIGN_OR_RETURN(auto capture_limits,
+                      ParseCaptureLimits(FLAGS_stirling_socket_tracer_capture_limits));
+  for (const auto& [name, limit] : capture_limits) {
+    PL_ASSIGN_OR_RETURN(traffic_protocol_t protocol, ProtocolFromName(name));
+    PL_RETURN_IF_ERROR(SetProtocolCaptureLimit(protocol, limit));
+  }
+
+  PL_ASSIGN_OR_RETURN(auto namespace_sampling_rates,
+                      ParseSamplingRates(FLAGS_stirling_socket_tracer_namespace_sampling_rates));
+  for (const auto& [ns, rate] : namespace_sampling_rates) {
+    SetNamespaceSamplingRate(ns, rate);
+  }
+
   PL_RETURN_IF_ERROR(TestOnlySetTargetPID(FLAGS_test_only_socket_trace_target_pid));
   if (FLAGS_stirling_disable_self_tracing) {
     PL_RETURN_IF_ERROR(DisableSelfTracing());
@@ -237,7 +406,8 @@ Status SocketTraceConnector::InitImpl() {
     socket_info_mgr_ = s.ConsumeValueOrDie();
   }
 
-  conn_info_map_mgr_ = std::make_shared<ConnInfoMapManager>(this);
+  conn_info_map_mgr_ = std::make_shared<ConnInfoMapManager>(
+      this, FLAGS_stirling_socket_tracer_tls_write_coalesce_bytes > 0);
   ConnTracker::SetConnInfoMapManager(conn_info_map_mgr_);
 
   uprobe_mgr_.Init(protocol_transfer_specs_[kProtocolHTTP2].enabled,
@@ -247,7 +417,7 @@ Status SocketTraceConnector::InitImpl() {
 }
 
 void SocketTraceConnector::InitContextImpl(ConnectorContext* ctx) {
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs(), ctx->proc_events());
 
   // On the first context, we want to make sure all uprobes deploy before returning.
   if (thread.joinable()) {
@@ -272,7 +442,7 @@ Status SocketTraceConnector::StopImpl() {
 }
 
 std::thread SocketTraceConnector::RunDeployUProbesThread(
-    const absl::flat_hash_set<md::UPID>& pids) {
+    const absl::flat_hash_set<md::UPID>& pids, ProcEventLogPosition proc_events) {
   // The check that state is not uninitialized is required for socket_trace_connector_test,
   // which would otherwise try to deploy uprobes (for which it does not have permissions).
   // Also, we check that there is no other previous thread still running.
@@ -283,7 +453,7 @@ std::thread SocketTraceConnector::RunDeployUProbesThread(
   //               deployment will become asynchronous to TransferData(), and this may
   //               lead to non-determinism.
   if (state() != State::kUninitialized && !uprobe_mgr_.ThreadsRunning()) {
-    return uprobe_mgr_.RunDeployUProbesThread(pids);
+    return uprobe_mgr_.RunDeployUProbesThread(pids, proc_events);
   }
   return {};
 }
@@ -341,6 +511,12 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // to maintain consistency with how BPF generates timestamps on its events.
   perf_buffer_drain_time_ = AdjustedSteadyClockNowNS();
 
+  // BPF only sends coalesced TLS writes on a later event of their connection, so the writes of
+  // idle connections are sent here, before the perf buffers are drained.
+  if (conn_info_map_mgr_ != nullptr) {
+    conn_info_map_mgr_->FlushStaleTLSWrites(CurrentSteadyTimeNS());
+  }
+
   // This drains all perf buffers, and causes Handle() callback functions to get called.
   // Note that it drains *all* perf buffers, not just those that are required for this table,
   // so raw data will be pushed to connection trackers more aggressively.
@@ -354,12 +530,14 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   }
 
   // Deploy uprobes on newly discovered PIDs.
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs(), ctx->proc_events());
   // Let it run in the background.
   if (thread.joinable()) {
     thread.detach();
   }
 
+  UpdateTGIDSamplingRates(ctx);
+
   conn_trackers_mgr_.CleanupTrackers();
 
   // Periodically check for leaking conn_info_map entries.
@@ -386,6 +564,10 @@ void SocketTraceConnector::UpdateTrackerTraceLevel(ConnTracker* tracker) {
 void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
                                             const std::vector<DataTable*>& data_tables) {
   set_iteration_time(std::chrono::steady_clock::now());
+  {
+    absl::MutexLock lock(&filter_lock_);
+    iteration_filter_ = filter_;
+  }
 
   UpdateCommonState(ctx);
 
@@ -419,21 +601,26 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     // are assigned artificially.
     if (i != kConnStatsTableNum && data_table != nullptr) {
       data_table->SetConsumeRecordsCutoffTime(perf_buffer_drain_time_);
+      data_table->EnablePushDelayMetrics([this]() { return AdjustedSteadyClockNowNS(); });
     }
   }
 
-  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
-    const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
-    DataTable* data_table = data_tables[transfer_spec.table_num];
+  if (parser_pool_.num_workers() == 1) {
+    for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
+      const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
+      DataTable* data_table = data_tables[transfer_spec.table_num];
 
-    UpdateTrackerTraceLevel(conn_tracker);
+      UpdateTrackerTraceLevel(conn_tracker);
 
-    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
-                                   socket_info_mgr_.get());
-    if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
-      transfer_spec.transfer_fn(*this, ctx, conn_tracker, data_table);
+      conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
+                                     socket_info_mgr_.get());
+      if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
+        transfer_spec.transfer_fn(*this, ctx, conn_tracker, data_table);
+      }
+      conn_tracker->IterationPostTick();
     }
-    conn_tracker->IterationPostTick();
+  } else {
+    TransferStreamsParallel(ctx, data_tables, cluster_cidrs);
   }
 
   // Once we've cleared all the debug trace levels for this pid, we can remove it from the list.
@@ -457,6 +644,110 @@ Status SocketTraceConnector::UpdateBPFProtocolTraceRole(traffic_protocol_t proto
   return UpdatePerCPUArrayValue(static_cast<int>(protocol), role_mask, &control_map_handle);
 }
 
+Status SocketTraceConnector::SetProtocolSamplingRate(traffic_protocol_t protocol, double rate) {
+  auto sampling_rates_handle = GetPerCPUArrayTable<int32_t>(kSamplingRatesMapName);
+  return UpdatePerCPUArrayValue(static_cast<int>(protocol), ToBPFSamplingRate(rate),
+                                &sampling_rates_handle);
+}
+
+Status SocketTraceConnector::SetProtocolCaptureLimit(traffic_protocol_t protocol,
+                                                     int32_t limit_bytes) {
+  auto capture_limits_handle = GetPerCPUArrayTable<int32_t>(kCaptureLimitsMapName);
+  return UpdatePerCPUArrayValue(static_cast<int>(protocol), limit_bytes, &capture_limits_handle);
+}
+
+void SocketTraceConnector::SetNamespaceSamplingRate(std::string_view ns, double rate) {
+  int32_t bpf_rate = ToBPFSamplingRate(rate);
+  absl::MutexLock lock(&namespace_sampling_rates_lock_);
+  if (bpf_rate >= kSamplingRateScale) {
+    namespace_sampling_rates_.erase(ns);
+  } else {
+    namespace_sampling_rates_[std::string(ns)] = bpf_rate;
+  }
+}
+
+void SocketTraceConnector::SetFilter(SocketTraceFilter filter) {
+  auto new_filter =
+      filter.empty() ? nullptr : std::make_shared<const SocketTraceFilter>(std::move(filter));
+  absl::MutexLock lock(&filter_lock_);
+  filter_ = std::move(new_filter);
+}
+
+void SocketTraceConnector::UpdateTGIDSamplingRates(ConnectorContext* ctx) {
+  absl::flat_hash_map<std::string, int32_t> namespace_sampling_rates;
+  {
+    absl::MutexLock lock(&namespace_sampling_rates_lock_);
+    namespace_sampling_rates = namespace_sampling_rates_;
+  }
+  if (iteration_filter_ != nullptr) {
+    for (const auto& ns : iteration_filter_->namespaces) {
+      namespace_sampling_rates[ns] = 0;
+    }
+  }
+
+  absl::flat_hash_map<uint32_t, int32_t> tgid_sampling_rates;
+  if (!namespace_sampling_rates.empty()) {
+    const md::K8sMetadataState& k8s_md = ctx->GetK8SMetadata();
+    for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
+      auto rate_iter = namespace_sampling_rates.find(pod_name.first);
+      const md::PodInfo* pod_info = k8s_md.PodInfoByID(pod_id);
+      if (rate_iter == namespace_sampling_rates.end() || pod_info == nullptr) {
+        continue;
+      }
+      for (const auto& cid : pod_info->containers()) {
+        const md::ContainerInfo* container_info = k8s_md.ContainerInfoByID(cid);
+        if (container_info == nullptr) {
+          continue;
+        }
+        for (const auto& upid : container_info->active_upids()) {
+          tgid_sampling_rates[upid.pid()] = rate_iter->second;
+        }
+      }
+    }
+  }
+  // Matching the UPIDs against the live processes keeps a reused PID from being filtered out.
+  if (iteration_filter_ != nullptr && !iteration_filter_->upids.empty()) {
+    for (const auto& upid : ctx->GetUPIDs()) {
+      if (iteration_filter_->upids.contains(upid)) {
+        tgid_sampling_rates[upid.pid()] = 0;
+      }
+    }
+  }
+
+  // Nothing to do in the common case, where no namespace has a sampling rate.
+  if (tgid_sampling_rates == tgid_sampling_rates_) {
+    return;
+  }
+
+  std::vector<uint32_t> removed_tgids;
+  for (const auto& [tgid, rate] : tgid_sampling_rates_) {
+    if (!tgid_sampling_rates.contains(tgid)) {
+      removed_tgids.push_back(tgid);
+    }
+  }
+  std::vector<uint32_t> updated_tgids;
+  std::vector<int32_t> updated_rates;
+  for (const auto& [tgid, rate] : tgid_sampling_rates) {
+    auto iter = tgid_sampling_rates_.find(tgid);
+    if (iter != tgid_sampling_rates_.end() && iter->second == rate) {
+      continue;
+    }
+    updated_tgids.push_back(tgid);
+    updated_rates.push_back(rate);
+  }
+
+  auto tgid_sampling_rates_handle = GetHashTable<uint32_t, int32_t>(kTGIDSamplingRatesMapName);
+  Status s = bpf_tools::BCCWrapper::RemoveValues(&tgid_sampling_rates_handle, removed_tgids);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to clear sampling rates: $0", s.msg());
+  s = bpf_tools::BCCWrapper::UpdateHashTableValues(&tgid_sampling_rates_handle, updated_tgids,
+                                                   updated_rates);
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("Failed to set the sampling rates of $0 pids: $1",
+                                updated_tgids.size(), s.msg());
+  }
+  tgid_sampling_rates_ = std::move(tgid_sampling_rates);
+}
+
 Status SocketTraceConnector::TestOnlySetTargetPID(int64_t pid) {
   auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
   return UpdatePerCPUArrayValue(kTargetTGIDIndex, pid, &control_map_handle);
@@ -583,6 +874,10 @@ void SocketTraceConnector::AcceptDataEvent(std::unique_ptr<SocketDataEvent> even
 }
 
 void SocketTraceConnector::AcceptControlEvent(socket_control_event_t event) {
+  if (perf_buffer_events_output_stream_ != nullptr) {
+    WriteControlEvent(event);
+  }
+
   ConnTracker& tracker = GetOrCreateConnTracker(event.conn_id);
   tracker.AddControlEvent(event);
 }
@@ -627,10 +922,6 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   protocols::http::Message& req_message = record.req;
   protocols::http::Message& resp_message = record.resp;
 
-  // Currently decompresses gzip content, but could handle other transformations too.
-  // Note that we do this after filtering to avoid burning CPU cycles unnecessarily.
-  protocols::http::PreProcessMessage(&resp_message);
-
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -640,6 +931,14 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   }
 
   DataTable::RecordBuilder<&kHTTPTable> r(data_table, resp_message.timestamp_ns);
+
+  // Currently decompresses gzip content, but could handle other transformations too.
+  // Note that we do this after filtering to avoid burning CPU cycles unnecessarily.
+  // Only one byte more than the exported head of the body is decompressed, just enough for the
+  // body to be marked as truncated, and nothing is when resp_body isn't subscribed.
+  size_t resp_body_size = protocols::http::PreProcessMessage(
+      &resp_message, r.Subscribed<r.ColIndex("resp_body")>() ? kMaxBodyBytes + 1 : 0);
+
   r.Append<r.ColIndex("time_")>(resp_message.timestamp_ns);
   r.Append<r.ColIndex("upid")>(upid.value());
   // Note that there is a string copy here,
@@ -650,18 +949,27 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("major_version")>(1);
   r.Append<r.ColIndex("minor_version")>(resp_message.minor_version);
   r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(content_type));
-  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_message.headers));
+  if (r.Subscribed<r.ColIndex("req_headers")>()) {
+    r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_message.headers));
+  } else {
+    r.Append<r.ColIndex("req_headers")>("");
+  }
   r.Append<r.ColIndex("req_method")>(std::move(req_message.req_method));
   r.Append<r.ColIndex("req_path")>(std::move(req_message.req_path));
   r.Append<r.ColIndex("req_body_size")>(req_message.body.size());
   r.Append<r.ColIndex("req_body"), kMaxBodyBytes>(std::move(req_message.body));
-  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
+  if (r.Subscribed<r.ColIndex("resp_headers")>()) {
+    r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
+  } else {
+    r.Append<r.ColIndex("resp_headers")>("");
+  }
   r.Append<r.ColIndex("resp_status")>(resp_message.resp_status);
   r.Append<r.ColIndex("resp_message")>(std::move(resp_message.resp_message));
-  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size());
+  r.Append<r.ColIndex("resp_body_size")>(resp_body_size);
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(resp_message.body));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_message.timestamp_ns, resp_message.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -741,6 +1049,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body")>(std::move(resp_data));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_stream->timestamp_ns, resp_stream->timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -764,6 +1073,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(entry.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -787,6 +1097,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(entry.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -804,12 +1115,13 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("remote_addr")>(conn_tracker.remote_endpoint().AddrStr());
   r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
   r.Append<r.ColIndex("trace_role")>(conn_tracker.role());
-  r.Append<r.ColIndex("req_header")>(entry.req.header);
-  r.Append<r.ColIndex("req_body")>(entry.req.query);
-  r.Append<r.ColIndex("resp_header")>(entry.resp.header);
-  r.Append<r.ColIndex("resp_body")>(entry.resp.msg);
+  r.Append<r.ColIndex("req_header")>(std::move(entry.req.header));
+  r.Append<r.ColIndex("req_body")>(std::move(entry.req.query));
+  r.Append<r.ColIndex("resp_header")>(std::move(entry.resp.header));
+  r.Append<r.ColIndex("resp_body")>(std::move(entry.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -832,6 +1144,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
   r.Append<r.ColIndex("req_cmd")>(ToString(entry.req.tag, /* is_req */ true));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -852,6 +1165,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("req_type")>(entry.req.type);
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -892,10 +1206,11 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
   r.Append<r.ColIndex("trace_role")>(role);
   r.Append<r.ColIndex("req_cmd")>(std::string(entry.req.command));
-  r.Append<r.ColIndex("req_args")>(std::string(entry.req.payload));
-  r.Append<r.ColIndex("resp")>(std::string(entry.resp.payload));
+  r.Append<r.ColIndex("req_args")>(std::move(entry.req.payload));
+  r.Append<r.ColIndex("resp")>(std::move(entry.resp.payload));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -914,9 +1229,10 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("remote_addr")>(conn_tracker.remote_endpoint().AddrStr());
   r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
   r.Append<r.ColIndex("trace_role")>(role);
-  r.Append<r.ColIndex("cmd")>(record.req.command);
-  r.Append<r.ColIndex("body")>(record.req.options);
-  r.Append<r.ColIndex("resp")>(record.resp.command);
+  r.Append<r.ColIndex("cmd")>(std::move(record.req.command));
+  r.Append<r.ColIndex("body")>(std::move(record.req.options));
+  r.Append<r.ColIndex("resp")>(std::move(record.resp.command));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -943,6 +1259,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp"), kMaxKafkaBodyBytes>(std::move(record.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(record.req.timestamp_ns, record.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_weight")>(conn_tracker.sample_weight());
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -962,31 +1279,20 @@ void SocketTraceConnector::SetupOutput(const std::filesystem::path& path) {
   LOG(INFO) << absl::Substitute("Writing output to: $0 in $1 format.", abs_path.string(), format);
 }
 
-namespace {
-void SocketDataEventToPB(const SocketDataEvent& event, sockeventpb::SocketDataEvent* pb) {
-  pb->mutable_attr()->set_timestamp_ns(event.attr.timestamp_ns);
-  pb->mutable_attr()->mutable_conn_id()->set_pid(event.attr.conn_id.upid.pid);
-  pb->mutable_attr()->mutable_conn_id()->set_start_time_ns(
-      event.attr.conn_id.upid.start_time_ticks);
-  pb->mutable_attr()->mutable_conn_id()->set_fd(event.attr.conn_id.fd);
-  pb->mutable_attr()->mutable_conn_id()->set_generation(event.attr.conn_id.tsid);
-  pb->mutable_attr()->set_protocol(event.attr.protocol);
-  pb->mutable_attr()->set_role(event.attr.role);
-  pb->mutable_attr()->set_direction(event.attr.direction);
-  pb->mutable_attr()->set_pos(event.attr.pos);
-  pb->mutable_attr()->set_msg_size(event.attr.msg_size);
-  pb->set_msg(event.msg);
+void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
+  WriteEvent(ToSocketEventPB(event));
 }
-}  // namespace
 
-void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
+void SocketTraceConnector::WriteControlEvent(const socket_control_event_t& event) {
+  WriteEvent(ToSocketEventPB(event));
+}
+
+void SocketTraceConnector::WriteEvent(const sockeventpb::SocketEvent& pb) {
   using ::google::protobuf::TextFormat;
   using ::google::protobuf::util::SerializeDelimitedToOstream;
 
   DCHECK(perf_buffer_events_output_stream_ != nullptr);
 
-  sockeventpb::SocketDataEvent pb;
-  SocketDataEventToPB(event, &pb);
   std::string text;
   switch (perf_buffer_events_output_format_) {
     case OutputFormat::kTxt:
@@ -1007,6 +1313,79 @@ void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
 // TransferData Helpers
 //-----------------------------------------------------------------------------
 
+void SocketTraceConnector::TransferStreamsParallel(ConnectorContext* ctx,
+                                                   const std::vector<DataTable*>& data_tables,
+                                                   const std::vector<CIDRBlock>& cluster_cidrs) {
+  const size_t num_workers = parser_pool_.num_workers();
+
+  // Ticking a tracker uses the shared proc parser and socket info manager, so it stays on this
+  // thread. Only parsing and stitching, which touch nothing but the tracker, run in the workers.
+  std::vector<std::vector<ConnTracker*>> shards(num_workers);
+  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
+    UpdateTrackerTraceLevel(conn_tracker);
+    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
+                                   socket_info_mgr_.get());
+
+    const conn_id_t& conn_id = conn_tracker->conn_id();
+    size_t hash = absl::Hash<std::tuple<uint32_t, uint64_t, int32_t, uint64_t>>{}(
+        std::make_tuple(conn_id.upid.pid, conn_id.upid.start_time_ticks, conn_id.fd, conn_id.tsid));
+    shards[hash % num_workers].push_back(conn_tracker);
+  }
+
+  // Each worker appends to its own copy of the tables, since the record builders aren't
+  // thread-safe.
+  for (auto& worker_tables : worker_data_tables_) {
+    worker_tables.resize(data_tables.size());
+    for (size_t i = 0; i < data_tables.size(); ++i) {
+      if (data_tables[i] != nullptr && worker_tables[i] == nullptr) {
+        worker_tables[i] =
+            std::make_unique<DataTable>(data_tables[i]->id(), data_tables[i]->table_schema());
+      }
+      if (data_tables[i] != nullptr) {
+        worker_tables[i]->set_subscribed_columns(data_tables[i]->subscribed_columns());
+      }
+    }
+  }
+
+  parser_pool_.Run([&](size_t worker) {
+    for (ConnTracker* conn_tracker : shards[worker]) {
+      const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
+      DataTable* data_table = data_tables[transfer_spec.table_num];
+      if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
+        transfer_spec.transfer_fn(*this, ctx, conn_tracker,
+                                  worker_data_tables_[worker][transfer_spec.table_num].get());
+      }
+    }
+  });
+
+  // The tables sort their records by time when they're consumed, so the merge order doesn't
+  // matter.
+  for (auto& worker_tables : worker_data_tables_) {
+    for (size_t i = 0; i < data_tables.size(); ++i) {
+      if (data_tables[i] != nullptr) {
+        data_tables[i]->MergeFrom(worker_tables[i].get());
+      }
+    }
+  }
+
+  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
+    conn_tracker->IterationPostTick();
+  }
+}
+
+namespace {
+
+template <typename TRecordType>
+bool IsFilteredOut(const SocketTraceFilter& /* filter */, const TRecordType& /* record */) {
+  return false;
+}
+
+bool IsFilteredOut(const SocketTraceFilter& filter, const protocols::http::Record& record) {
+  return filter.DropsHTTP(record.req.req_path, record.resp.resp_status);
+}
+
+}  // namespace
+
 template <typename TProtocolTraits>
 void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tracker,
                                           DataTable* data_table) {
@@ -1016,7 +1395,17 @@ void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tr
     // ProcessToRecords() parses raw events and produces messages in format that are expected by
     // table store. But those messages are not cached inside ConnTracker.
     auto records = tracker->ProcessToRecords<TProtocolTraits>();
+    const SocketTraceFilter* filter = iteration_filter_.get();
+    // BPF only drops the traffic of the connections opened after the process was filtered out.
+    if (filter != nullptr && !filter->upids.empty() &&
+        filter->upids.contains(md::UPID(ctx->GetASID(), tracker->conn_id().upid.pid,
+                                        tracker->conn_id().upid.start_time_ticks))) {
+      records.clear();
+    }
     for (auto& record : records) {
+      if (filter != nullptr && IsFilteredOut(*filter, record)) {
+        continue;
+      }
       TProtocolTraits::ConvertTimestamps(
           &record, [&](uint64_t mono_time) { return ConvertToRealTime(mono_time); });
       AppendMessage(ctx, *tracker, std::move(record), data_table);
@@ -1034,7 +1423,16 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
   absl::flat_hash_set<md::UPID> upids = ctx->GetUPIDs();
   uint64_t time = AdjustedSteadyClockNowNS();
 
-  auto& agg_stats = conn_stats_.UpdateStats();
+  std::vector<std::pair<struct conn_stats_agg_key_t, struct conn_stats_agg_t>> bpf_agg_stats;
+  if (conn_stats_bpf_agg_) {
+    auto agg_map =
+        GetHashTable<struct conn_stats_agg_key_t, struct conn_stats_agg_t>(kConnStatsAggMapName);
+    bpf_agg_stats = bpf_tools::BCCWrapper::GetHashTableEntries(&agg_map);
+  }
+  auto& agg_stats =
+      conn_stats_bpf_agg_ ? conn_stats_.UpdateStats(bpf_agg_stats) : conn_stats_.UpdateStats();
+  // The processes whose stats were erased, so that their BPF map entries are removed too.
+  absl::flat_hash_set<upid_t> exited_upids;
 
   auto iter = agg_stats.begin();
   while (iter != agg_stats.end()) {
@@ -1080,6 +1478,7 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
       const auto& sysconfig = system::Config::GetInstance();
       std::filesystem::path pid_file = sysconfig.proc_path() / std::to_string(key.upid.pid);
       if (!fs::Exists(pid_file).ok()) {
+        exited_upids.insert(key.upid);
         agg_stats.erase(iter++);
         continue;
       }
@@ -1088,6 +1487,23 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
     // This is at the bottom, in order to avoid accidentally forgetting increment the iterator.
     ++iter;
   }
+
+  if (!conn_stats_bpf_agg_ || exited_upids.empty()) {
+    return;
+  }
+  std::vector<struct conn_stats_agg_key_t> exited_keys;
+  for (const auto& [bpf_key, bpf_stats] : bpf_agg_stats) {
+    upid_t upid = {};
+    upid.tgid = bpf_key.tgid;
+    upid.start_time_ticks = bpf_key.start_time_ticks;
+    if (exited_upids.contains(upid)) {
+      exited_keys.push_back(bpf_key);
+    }
+  }
+  auto agg_map =
+      GetHashTable<struct conn_stats_agg_key_t, struct conn_stats_agg_t>(kConnStatsAggMapName);
+  Status s = bpf_tools::BCCWrapper::RemoveValues(&agg_map, exited_keys);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to remove exited conn stats: $0", s.msg());
 }
 
 }  // namespace stirling
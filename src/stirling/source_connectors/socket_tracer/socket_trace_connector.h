@@ -41,13 +41,21 @@
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/parser_pool.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_filter.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
 
 DECLARE_uint32(stirling_conn_stats_sampling_ratio);
+DECLARE_uint32(stirling_socket_tracer_parse_threads);
+DECLARE_string(stirling_socket_tracer_parse_thread_placement);
+DECLARE_bool(stirling_socket_tracer_use_ringbuf);
+DECLARE_bool(stirling_conn_stats_bpf_aggregation);
+DECLARE_int32(stirling_socket_tracer_tls_write_coalesce_bytes);
 DECLARE_bool(stirling_enable_periodic_bpf_map_cleanup);
 DECLARE_string(perf_buffer_events_output_path);
 DECLARE_bool(stirling_enable_http_tracing);
@@ -59,6 +67,9 @@ DECLARE_bool(stirling_enable_redis_tracing);
 DECLARE_bool(stirling_enable_nats_tracing);
 DECLARE_bool(stirling_enable_kafka_tracing);
 DECLARE_bool(stirling_enable_mux_tracing);
+DECLARE_string(stirling_socket_tracer_sampling_rates);
+DECLARE_string(stirling_socket_tracer_namespace_sampling_rates);
+DECLARE_string(stirling_socket_tracer_capture_limits);
 DECLARE_bool(stirling_disable_self_tracing);
 DECLARE_string(stirling_role_to_trace);
 
@@ -115,11 +126,33 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   Status TestOnlySetTargetPID(int64_t pid);
   Status DisableSelfTracing();
 
+  // Sets the fraction of the protocol's connections whose data is traced. BPF decides once per
+  // connection whether it's sampled, so a new rate only applies to connections whose protocol
+  // wasn't known yet.
+  Status SetProtocolSamplingRate(traffic_protocol_t protocol, double rate);
+
+  // Limits how many bytes of each message of the protocol BPF copies to user-space.
+  // The rest of the message is skipped over. A limit of 0 removes the limit.
+  Status SetProtocolCaptureLimit(traffic_protocol_t protocol, int32_t limit_bytes);
+
+  // Lowers the sampling rate of the connections of the pods in the K8s namespace.
+  // A rate of 1 removes the namespace's sampling rate. Can be called from any thread.
+  void SetNamespaceSamplingRate(std::string_view ns, double rate);
+
+  // Replaces the filter of the traced data, from the next transfer on. Can be called from any
+  // thread.
+  void SetFilter(SocketTraceFilter filter);
+
   void DisablePIDTrace(int pid) override {
     SourceConnector::DisablePIDTrace(pid);
     pids_to_trace_disable_.insert(pid);
   }
 
+  bool SupportsDataWakeup() const override { return true; }
+  int WaitForData(std::chrono::milliseconds timeout) override {
+    return WaitForPerfBufferData(timeout.count());
+  }
+
   /**
    * Gets a pointer to the most recent ConnTracker for the given pid and fd.
    *
@@ -246,6 +279,11 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   void TransferStreams(ConnectorContext* ctx, uint32_t table_num, DataTable* data_table);
   void TransferConnStats(ConnectorContext* ctx, DataTable* data_table);
 
+  // Parses and stitches the active trackers on the parser pool. Each worker appends records to its
+  // own tables, which are merged into data_tables once all workers are done.
+  void TransferStreamsParallel(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables,
+                               const std::vector<CIDRBlock>& cluster_cidrs);
+
   template <typename TProtocolTraits>
   void TransferStream(ConnectorContext* ctx, ConnTracker* tracker, DataTable* data_table);
 
@@ -257,11 +295,16 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   void UpdateTrackerTraceLevel(ConnTracker* tracker);
 
+  // Pushes the namespace sampling rates down to BPF, as the rates of the processes in each
+  // namespace. The processes and namespaces that are filtered out get a rate of 0.
+  void UpdateTGIDSamplingRates(ConnectorContext* ctx);
+
   template <typename TRecordType>
   static void AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
                             TRecordType record, DataTable* data_table);
 
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                     ProcEventLogPosition proc_events);
 
   // Setups output file stream object writing to the input file path.
   void SetupOutput(const std::filesystem::path& file);
@@ -269,12 +312,32 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Writes data event to the specified output file.
   void WriteDataEvent(const SocketDataEvent& event);
 
+  // Writes control event to the specified output file.
+  void WriteControlEvent(const socket_control_event_t& event);
+
+  void WriteEvent(const sockeventpb::SocketEvent& pb);
+
   ConnTrackersManager conn_trackers_mgr_;
 
   ConnStats conn_stats_;
+  // Whether BPF aggregates the conn stats in conn_stats_agg_map, instead of sending events.
+  bool conn_stats_bpf_agg_ = false;
 
   absl::flat_hash_set<int> pids_to_trace_disable_;
 
+  // Sampling rates by K8s namespace, in parts per kSamplingRateScale.
+  absl::Mutex namespace_sampling_rates_lock_;
+  absl::flat_hash_map<std::string, int32_t> namespace_sampling_rates_
+      ABSL_GUARDED_BY(namespace_sampling_rates_lock_);
+
+  // The contents of tgid_sampling_rates_map in BPF.
+  absl::flat_hash_map<uint32_t, int32_t> tgid_sampling_rates_;
+
+  absl::Mutex filter_lock_;
+  std::shared_ptr<const SocketTraceFilter> filter_ ABSL_GUARDED_BY(filter_lock_);
+  // The filter of the current transfer, which the parser threads read.
+  std::shared_ptr<const SocketTraceFilter> iteration_filter_;
+
   struct TransferSpec {
     // TODO(yzhao): Enabling protocol is essentially equivalent to subscribing to DataTable. They
     // could be unified.
@@ -317,6 +380,13 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   UProbeManager uprobe_mgr_;
 
+  // Runs TransferStream() in parallel across connections, when configured with more than one
+  // worker.
+  ParserPool parser_pool_;
+
+  // The per-worker tables that the parser pool appends to, indexed by worker and then table num.
+  std::vector<std::vector<std::unique_ptr<DataTable>>> worker_data_tables_;
+
   enum class StatKey {
     kLossSocketDataEvent,
     kLossSocketControlEvent,
@@ -328,6 +398,9 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   utils::StatCounter<StatKey> stats_;
 
+  // Feeds recorded events through the perf buffer callbacks.
+  friend class PerfBufferEventsReplayer;
+
   FRIEND_TEST(SocketTraceConnectorTest, AppendNonContiguousEvents);
   FRIEND_TEST(SocketTraceConnectorTest, NoEvents);
   FRIEND_TEST(SocketTraceConnectorTest, SortedByResponseTime);
@@ -258,6 +258,86 @@ TEST_F(SocketTraceConnectorTest, HTTPBasic) {
   EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre("foo"));
 }
 
+TEST_F(SocketTraceConnectorTest, HTTPFilter) {
+  SocketTraceFilter filter;
+  filter.http_path_prefixes = {"/index"};
+  source_->SetFilter(filter);
+
+  testing::EventGenerator event_gen(&mock_clock_);
+  source_->AcceptControlEvent(event_gen.InitConn());
+  source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+  source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kResp0));
+  source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq1));
+  source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kResp1));
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(1)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPReqPathIdx]), ElementsAre("/data.html"));
+
+  // Filtering out the process drops the rest of the records of its connections.
+  filter.upids = {md::UPID(kASID, kPID, kPIDStartTimeTicks)};
+  source_->SetFilter(filter);
+  source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq2));
+  source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kResp2));
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+  EXPECT_TRUE(http_table_->ConsumeRecords().empty());
+}
+
+TEST_F(SocketTraceConnectorTest, HTTPSubscribedColumns) {
+  ASSERT_OK(http_table_->SetSubscribedColumns({"time_", "upid", "req_path"}));
+
+  testing::EventGenerator event_gen(&mock_clock_);
+  source_->AcceptControlEvent(event_gen.InitConn());
+  source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq3));
+  source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(1)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPReqPathIdx]), ElementsAre("/logs.html"));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPReqHeadersIdx]), ElementsAre(""));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPReqBodyIdx]), ElementsAre(""));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre(""));
+  // The sizes of the bodies are still collected.
+  EXPECT_THAT(ToIntVector<types::Int64Value>(record_batch[kHTTPReqBodySizeIdx]), ElementsAre(21));
+}
+
+TEST_F(SocketTraceConnectorTest, ParallelParsing) {
+  FLAGS_stirling_socket_tracer_parse_threads = 4;
+  DEFER(FLAGS_stirling_socket_tracer_parse_threads = 1);
+  // The parser pool is sized when the connector is created.
+  connector_ = SocketTraceConnector::Create("socket_trace_connector");
+  source_ = dynamic_cast<SocketTraceConnector*>(connector_.get());
+  ASSERT_NE(nullptr, source_);
+
+  constexpr int kNumConns = 32;
+  std::vector<testing::EventGenerator> event_gens;
+  for (int i = 0; i < kNumConns; ++i) {
+    event_gens.emplace_back(&mock_clock_, kPID, kFD + i);
+  }
+  for (auto& event_gen : event_gens) {
+    source_->AcceptControlEvent(event_gen.InitConn());
+    source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+    source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+  }
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(kNumConns)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), Each(std::string("foo")));
+}
+
 TEST_F(SocketTraceConnectorTest, HTTPContentType) {
   testing::EventGenerator event_gen(&mock_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_filter.h"
+
+#include <absl/strings/match.h>
+
+namespace px {
+namespace stirling {
+
+bool SocketTraceFilter::DropsHTTP(std::string_view req_path, int resp_status) const {
+  if (http_resp_statuses.contains(resp_status)) {
+    return true;
+  }
+  for (const auto& prefix : http_path_prefixes) {
+    if (absl::StartsWith(req_path, prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace stirling
+}  // namespace px
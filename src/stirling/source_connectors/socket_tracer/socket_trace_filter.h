@@ -0,0 +1,60 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/shared/upid/upid.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * SocketTraceFilter selects the traced data that nobody queries, like health checks and
+ * readiness probes, so that the socket tracer drops it as soon as it can, rather than buffering
+ * it and pushing it to the table store.
+ *
+ * The traffic of the processes and namespaces is dropped in BPF, so it's never copied to
+ * user-space. Like the sampling rates, this only applies to connections opened after the filter
+ * is set. The HTTP records are dropped right after they're stitched.
+ */
+struct SocketTraceFilter {
+  // HTTP records whose request path starts with any of these are dropped.
+  std::vector<std::string> http_path_prefixes;
+  // HTTP records whose response has any of these status codes are dropped.
+  absl::flat_hash_set<int> http_resp_statuses;
+  // The processes whose traffic isn't traced.
+  absl::flat_hash_set<md::UPID> upids;
+  // The K8s namespaces of the pods whose traffic isn't traced.
+  absl::flat_hash_set<std::string> namespaces;
+
+  bool empty() const {
+    return http_path_prefixes.empty() && http_resp_statuses.empty() && upids.empty() &&
+           namespaces.empty();
+  }
+
+  // Whether the HTTP record with the request path and response status is dropped.
+  bool DropsHTTP(std::string_view req_path, int resp_status) const;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_filter.h"
+
+#include <gtest/gtest.h>
+
+namespace px {
+namespace stirling {
+
+TEST(SocketTraceFilterTest, DropsHTTP) {
+  SocketTraceFilter filter;
+  EXPECT_TRUE(filter.empty());
+  EXPECT_FALSE(filter.DropsHTTP("/healthz", 200));
+
+  filter.http_path_prefixes = {"/healthz", "/ready"};
+  filter.http_resp_statuses = {304};
+  EXPECT_FALSE(filter.empty());
+  EXPECT_TRUE(filter.DropsHTTP("/healthz", 200));
+  EXPECT_TRUE(filter.DropsHTTP("/readyz?verbose", 200));
+  EXPECT_TRUE(filter.DropsHTTP("/index.html", 304));
+  EXPECT_FALSE(filter.DropsHTTP("/index.html", 200));
+  EXPECT_FALSE(filter.DropsHTTP("/api/healthz", 200));
+}
+
+}  // namespace stirling
+}  // namespace px
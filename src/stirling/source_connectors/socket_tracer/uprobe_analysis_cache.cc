@@ -0,0 +1,246 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/uprobe_analysis_cache.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include "src/common/base/byte_utils.h"
+#include "src/common/base/file.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/stirling/utils/binary_decoder.h"
+
+DEFINE_string(stirling_uprobe_analysis_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_UPROBE_ANALYSIS_CACHE_DIR", ""),
+              "If set, the directory in which the results of analyzing binaries for uprobes are "
+              "cached across restarts. Typically a hostPath volume.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// Bump the version whenever the layout below, or the way the symaddrs are computed, changes.
+constexpr std::string_view kMagic = "PXUPROBE";
+constexpr uint32_t kFormatVersion = 1;
+
+// Layout:
+//   header:   magic, version, fingerprint, sizeof() of each symaddrs struct, is_go
+//   symaddrs: for each of common, tls and http2: status, followed by the raw struct if OK.
+//   probes:   for each of runtime, tls and http2: status, followed by the specs if OK.
+// A status is its code and message; a spec is its attach type, address, symbol and probe_fn.
+
+template <typename T>
+void AppendPOD(const T& val, std::string* out) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+void AppendString(std::string_view str, std::string* out) {
+  AppendPOD(static_cast<uint32_t>(str.size()), out);
+  out->append(str);
+}
+
+void AppendStatus(const Status& status, std::string* out) {
+  AppendPOD(static_cast<int32_t>(status.code()), out);
+  AppendString(status.msg(), out);
+}
+
+template <typename T>
+void AppendSymAddrs(const StatusOr<T>& symaddrs, std::string* out) {
+  AppendStatus(symaddrs.status(), out);
+  if (symaddrs.ok()) {
+    AppendPOD(symaddrs.ValueOrDie(), out);
+  }
+}
+
+void AppendProbes(const StatusOr<std::vector<bpf_tools::UProbeSpec>>& probes, std::string* out) {
+  AppendStatus(probes.status(), out);
+  if (!probes.ok()) {
+    return;
+  }
+  AppendPOD(static_cast<uint32_t>(probes.ValueOrDie().size()), out);
+  for (const auto& spec : probes.ValueOrDie()) {
+    AppendPOD(static_cast<int32_t>(spec.attach_type), out);
+    AppendPOD(spec.address, out);
+    AppendString(spec.symbol, out);
+    AppendString(spec.probe_fn, out);
+  }
+}
+
+template <typename T>
+StatusOr<T> ExtractPOD(BinaryDecoder* decoder) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  PL_ASSIGN_OR_RETURN(std::string_view bytes, decoder->ExtractString(sizeof(T)));
+  return utils::MemCpy<T>(bytes);
+}
+
+StatusOr<std::string_view> ExtractString(BinaryDecoder* decoder) {
+  PL_ASSIGN_OR_RETURN(uint32_t size, ExtractPOD<uint32_t>(decoder));
+  return decoder->ExtractString(size);
+}
+
+Status ExtractStatus(BinaryDecoder* decoder, Status* status) {
+  PL_ASSIGN_OR_RETURN(int32_t code, ExtractPOD<int32_t>(decoder));
+  PL_ASSIGN_OR_RETURN(std::string_view msg, ExtractString(decoder));
+  *status = code == statuspb::OK ? Status::OK()
+                                 : Status(static_cast<statuspb::Code>(code), std::string(msg));
+  return Status::OK();
+}
+
+template <typename T>
+Status ExtractSymAddrs(BinaryDecoder* decoder, StatusOr<T>* symaddrs) {
+  Status status;
+  PL_RETURN_IF_ERROR(ExtractStatus(decoder, &status));
+  if (!status.ok()) {
+    *symaddrs = status;
+    return Status::OK();
+  }
+  PL_ASSIGN_OR_RETURN(*symaddrs, ExtractPOD<T>(decoder));
+  return Status::OK();
+}
+
+Status ExtractProbes(BinaryDecoder* decoder,
+                     StatusOr<std::vector<bpf_tools::UProbeSpec>>* probes) {
+  Status status;
+  PL_RETURN_IF_ERROR(ExtractStatus(decoder, &status));
+  if (!status.ok()) {
+    *probes = status;
+    return Status::OK();
+  }
+
+  PL_ASSIGN_OR_RETURN(uint32_t count, ExtractPOD<uint32_t>(decoder));
+  std::vector<bpf_tools::UProbeSpec> specs;
+  for (uint32_t i = 0; i < count; ++i) {
+    bpf_tools::UProbeSpec spec;
+    PL_ASSIGN_OR_RETURN(int32_t attach_type, ExtractPOD<int32_t>(decoder));
+    spec.attach_type = static_cast<bpf_tools::BPFProbeAttachType>(attach_type);
+    PL_ASSIGN_OR_RETURN(spec.address, ExtractPOD<uint64_t>(decoder));
+    PL_ASSIGN_OR_RETURN(std::string_view symbol, ExtractString(decoder));
+    spec.symbol = std::string(symbol);
+    PL_ASSIGN_OR_RETURN(std::string_view probe_fn, ExtractString(decoder));
+    spec.probe_fn = std::string(probe_fn);
+    specs.push_back(std::move(spec));
+  }
+  *probes = std::move(specs);
+  return Status::OK();
+}
+
+}  // namespace
+
+std::string SerializeGoBinaryAnalysis(const GoBinaryAnalysis& analysis, uint64_t fingerprint) {
+  std::string out(kMagic);
+  AppendPOD(kFormatVersion, &out);
+  AppendPOD(fingerprint, &out);
+  AppendPOD(static_cast<uint32_t>(sizeof(struct go_common_symaddrs_t)), &out);
+  AppendPOD(static_cast<uint32_t>(sizeof(struct go_tls_symaddrs_t)), &out);
+  AppendPOD(static_cast<uint32_t>(sizeof(struct go_http2_symaddrs_t)), &out);
+  AppendPOD(static_cast<uint8_t>(analysis.is_go), &out);
+
+  AppendSymAddrs(analysis.common_symaddrs, &out);
+  AppendSymAddrs(analysis.tls_symaddrs, &out);
+  AppendSymAddrs(analysis.http2_symaddrs, &out);
+
+  AppendProbes(analysis.runtime_probes, &out);
+  AppendProbes(analysis.tls_probes, &out);
+  AppendProbes(analysis.http2_probes, &out);
+
+  return out;
+}
+
+StatusOr<GoBinaryAnalysis> DeserializeGoBinaryAnalysis(std::string_view data,
+                                                       uint64_t fingerprint) {
+  BinaryDecoder decoder(data);
+
+  PL_ASSIGN_OR_RETURN(std::string_view magic, decoder.ExtractString(kMagic.size()));
+  if (magic != kMagic) {
+    return error::InvalidArgument("Not a uprobe analysis cache entry.");
+  }
+  PL_ASSIGN_OR_RETURN(uint32_t version, ExtractPOD<uint32_t>(&decoder));
+  if (version != kFormatVersion) {
+    return error::FailedPrecondition("Cache entry has version $0, expected $1.", version,
+                                     kFormatVersion);
+  }
+  PL_ASSIGN_OR_RETURN(uint64_t entry_fingerprint, ExtractPOD<uint64_t>(&decoder));
+  if (entry_fingerprint != fingerprint) {
+    return error::FailedPrecondition("Cache entry was created with different uprobe templates.");
+  }
+  for (size_t expected_size : {sizeof(struct go_common_symaddrs_t),
+                               sizeof(struct go_tls_symaddrs_t),
+                               sizeof(struct go_http2_symaddrs_t)}) {
+    PL_ASSIGN_OR_RETURN(uint32_t size, ExtractPOD<uint32_t>(&decoder));
+    if (size != expected_size) {
+      return error::FailedPrecondition("Cache entry has a different symaddrs layout.");
+    }
+  }
+
+  GoBinaryAnalysis analysis;
+  PL_ASSIGN_OR_RETURN(uint8_t is_go, ExtractPOD<uint8_t>(&decoder));
+  analysis.is_go = is_go != 0;
+
+  PL_RETURN_IF_ERROR(ExtractSymAddrs(&decoder, &analysis.common_symaddrs));
+  PL_RETURN_IF_ERROR(ExtractSymAddrs(&decoder, &analysis.tls_symaddrs));
+  PL_RETURN_IF_ERROR(ExtractSymAddrs(&decoder, &analysis.http2_symaddrs));
+
+  PL_RETURN_IF_ERROR(ExtractProbes(&decoder, &analysis.runtime_probes));
+  PL_RETURN_IF_ERROR(ExtractProbes(&decoder, &analysis.tls_probes));
+  PL_RETURN_IF_ERROR(ExtractProbes(&decoder, &analysis.http2_probes));
+
+  if (!decoder.eof()) {
+    return error::InvalidArgument("Cache entry has $0 trailing bytes.", decoder.BufSize());
+  }
+  return analysis;
+}
+
+std::filesystem::path UProbeAnalysisCache::EntryPath(uint64_t content_hash) const {
+  return dir_ / absl::StrFormat("%016x.uprobes", content_hash);
+}
+
+StatusOr<GoBinaryAnalysis> UProbeAnalysisCache::Load(uint64_t content_hash) const {
+  PL_ASSIGN_OR_RETURN(std::string data,
+                      ReadFileToString(EntryPath(content_hash).string(), std::ios_base::binary));
+  return DeserializeGoBinaryAnalysis(data, fingerprint_);
+}
+
+Status UProbeAnalysisCache::Store(uint64_t content_hash, const GoBinaryAnalysis& analysis) const {
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(dir_));
+
+  const std::filesystem::path path = EntryPath(content_hash);
+  // The PID makes the temporary file unique among PEMs that share the directory.
+  std::filesystem::path tmp_path = path;
+  tmp_path += absl::StrCat(".tmp.", getpid());
+
+  PL_RETURN_IF_ERROR(WriteFileFromString(tmp_path.string(),
+                                         SerializeGoBinaryAnalysis(analysis, fingerprint_),
+                                         std::ios_base::out | std::ios_base::binary));
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return error::Internal("Could not rename $0 to $1.", tmp_path.string(), path.string());
+  }
+  return Status::OK();
+}
+
+}  // namespace stirling
+}  // namespace px
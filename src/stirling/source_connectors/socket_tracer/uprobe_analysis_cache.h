@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+
+DECLARE_string(stirling_uprobe_analysis_cache_dir);
+
+namespace px {
+namespace stirling {
+
+/**
+ * The outcome of analyzing a binary for Go uprobes. It only depends on the contents of the
+ * binary, so it is shared by all copies of the binary (e.g. in the file systems of different
+ * containers). The resolved uprobe specs leave binary_path empty for the same reason.
+ */
+struct GoBinaryAnalysis {
+  bool is_go = false;
+  StatusOr<struct go_common_symaddrs_t> common_symaddrs;
+  StatusOr<struct go_tls_symaddrs_t> tls_symaddrs;
+  StatusOr<struct go_http2_symaddrs_t> http2_symaddrs;
+  StatusOr<std::vector<bpf_tools::UProbeSpec>> runtime_probes;
+  StatusOr<std::vector<bpf_tools::UProbeSpec>> tls_probes;
+  StatusOr<std::vector<bpf_tools::UProbeSpec>> http2_probes;
+};
+
+/**
+ * Encodes the analysis in a flat format, which is prefixed by a header that records the format
+ * version, the sizes of the symaddrs structs and the fingerprint of the analysis inputs.
+ * Integers and symaddrs structs are stored in host byte order, as the files never leave the node.
+ */
+std::string SerializeGoBinaryAnalysis(const GoBinaryAnalysis& analysis, uint64_t fingerprint);
+
+/**
+ * Decodes the output of SerializeGoBinaryAnalysis(). Returns error if the data is corrupt, or was
+ * written by a different version of the format, or for a different fingerprint.
+ */
+StatusOr<GoBinaryAnalysis> DeserializeGoBinaryAnalysis(std::string_view data,
+                                                       uint64_t fingerprint);
+
+/**
+ * UProbeAnalysisCache persists GoBinaryAnalysis results across restarts, so that binaries which
+ * were analyzed before skip the ELF and DWARF analysis. There is one file per binary, named after
+ * the hash of the binary's contents. The directory is typically a hostPath volume, so that it
+ * survives restarts and upgrades of the PEM.
+ *
+ * The fingerprint covers everything besides the binary that the analysis depends on, such as the
+ * uprobe templates. Entries with a different fingerprint are treated as misses, and overwritten.
+ */
+class UProbeAnalysisCache {
+ public:
+  UProbeAnalysisCache(std::filesystem::path dir, uint64_t fingerprint)
+      : dir_(std::move(dir)), fingerprint_(fingerprint) {}
+
+  /**
+   * Returns the cached analysis of the binary with the specified content hash,
+   * or error if there is no valid entry for it.
+   */
+  StatusOr<GoBinaryAnalysis> Load(uint64_t content_hash) const;
+
+  /**
+   * Writes the analysis of the binary with the specified content hash.
+   * The entry is written to a temporary file first, so that readers never see a partial entry.
+   */
+  Status Store(uint64_t content_hash, const GoBinaryAnalysis& analysis) const;
+
+ private:
+  std::filesystem::path EntryPath(uint64_t content_hash) const;
+
+  const std::filesystem::path dir_;
+  const uint64_t fingerprint_;
+};
+
+}  // namespace stirling
+}  // namespace px
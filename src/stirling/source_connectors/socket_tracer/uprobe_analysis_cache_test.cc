@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/uprobe_analysis_cache.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::testing::TempDir;
+
+constexpr uint64_t kFingerprint = 0x1234;
+
+GoBinaryAnalysis SampleAnalysis() {
+  GoBinaryAnalysis analysis;
+  analysis.is_go = true;
+
+  struct go_common_symaddrs_t common_symaddrs = {};
+  common_symaddrs.tls_Conn = 0x4000;
+  common_symaddrs.FD_Sysfd_offset = 16;
+  analysis.common_symaddrs = common_symaddrs;
+
+  struct go_tls_symaddrs_t tls_symaddrs = {};
+  tls_symaddrs.Write_c_loc = {kLocationTypeStack, 8};
+  tls_symaddrs.Read_b_loc = {kLocationTypeRegisters, 1};
+  analysis.tls_symaddrs = tls_symaddrs;
+
+  analysis.http2_symaddrs = error::NotFound("No HTTP2 symbols.");
+
+  analysis.runtime_probes = std::vector<bpf_tools::UProbeSpec>{
+      {.symbol = "runtime.casgstatus", .probe_fn = "probe_runtime_casgstatus"}};
+  analysis.tls_probes = std::vector<bpf_tools::UProbeSpec>{
+      {.symbol = "crypto/tls.(*Conn).Write", .probe_fn = "probe_entry_tls_conn_write"},
+      {.address = 0x1234,
+       .attach_type = bpf_tools::BPFProbeAttachType::kEntry,
+       .probe_fn = "probe_return_tls_conn_write"},
+  };
+  return analysis;
+}
+
+void ExpectSameAnalysis(const GoBinaryAnalysis& a, const GoBinaryAnalysis& b) {
+  EXPECT_EQ(a.is_go, b.is_go);
+
+  ASSERT_OK(b.common_symaddrs);
+  EXPECT_EQ(b.common_symaddrs.ValueOrDie().tls_Conn, a.common_symaddrs.ValueOrDie().tls_Conn);
+  EXPECT_EQ(b.common_symaddrs.ValueOrDie().FD_Sysfd_offset,
+            a.common_symaddrs.ValueOrDie().FD_Sysfd_offset);
+
+  ASSERT_OK(b.tls_symaddrs);
+  EXPECT_EQ(b.tls_symaddrs.ValueOrDie().Write_c_loc.offset,
+            a.tls_symaddrs.ValueOrDie().Write_c_loc.offset);
+  EXPECT_EQ(b.tls_symaddrs.ValueOrDie().Read_b_loc.type,
+            a.tls_symaddrs.ValueOrDie().Read_b_loc.type);
+
+  EXPECT_NOT_OK(b.http2_symaddrs);
+  EXPECT_EQ(b.http2_symaddrs.code(), a.http2_symaddrs.code());
+  EXPECT_EQ(b.http2_symaddrs.msg(), a.http2_symaddrs.msg());
+
+  for (auto [a_probes, b_probes] : {std::make_pair(&a.runtime_probes, &b.runtime_probes),
+                                    std::make_pair(&a.tls_probes, &b.tls_probes)}) {
+    ASSERT_OK(*b_probes);
+    ASSERT_EQ(b_probes->ValueOrDie().size(), a_probes->ValueOrDie().size());
+    for (size_t i = 0; i < a_probes->ValueOrDie().size(); ++i) {
+      const bpf_tools::UProbeSpec& a_spec = a_probes->ValueOrDie()[i];
+      const bpf_tools::UProbeSpec& b_spec = b_probes->ValueOrDie()[i];
+      EXPECT_EQ(b_spec.symbol, a_spec.symbol);
+      EXPECT_EQ(b_spec.address, a_spec.address);
+      EXPECT_EQ(b_spec.attach_type, a_spec.attach_type);
+      EXPECT_EQ(b_spec.probe_fn, a_spec.probe_fn);
+    }
+  }
+
+  // Default constructed in SampleAnalysis(), so still an error after the round trip.
+  EXPECT_NOT_OK(b.http2_probes);
+}
+
+TEST(UProbeAnalysisCacheTest, SerializeRoundTrip) {
+  GoBinaryAnalysis analysis = SampleAnalysis();
+  std::string data = SerializeGoBinaryAnalysis(analysis, kFingerprint);
+
+  ASSERT_OK_AND_ASSIGN(GoBinaryAnalysis decoded, DeserializeGoBinaryAnalysis(data, kFingerprint));
+  ExpectSameAnalysis(analysis, decoded);
+}
+
+TEST(UProbeAnalysisCacheTest, RejectsMismatchedOrCorruptEntries) {
+  std::string data = SerializeGoBinaryAnalysis(SampleAnalysis(), kFingerprint);
+
+  EXPECT_NOT_OK(DeserializeGoBinaryAnalysis(data, kFingerprint + 1));
+  EXPECT_NOT_OK(DeserializeGoBinaryAnalysis(data.substr(0, data.size() - 1), kFingerprint));
+  EXPECT_NOT_OK(DeserializeGoBinaryAnalysis(data + "x", kFingerprint));
+  EXPECT_NOT_OK(DeserializeGoBinaryAnalysis("garbage", kFingerprint));
+}
+
+TEST(UProbeAnalysisCacheTest, StoreAndLoad) {
+  TempDir temp_dir;
+  UProbeAnalysisCache cache(temp_dir.path() / "cache", kFingerprint);
+
+  EXPECT_NOT_OK(cache.Load(1));
+
+  GoBinaryAnalysis analysis = SampleAnalysis();
+  ASSERT_OK(cache.Store(1, analysis));
+  ASSERT_OK_AND_ASSIGN(GoBinaryAnalysis loaded, cache.Load(1));
+  ExpectSameAnalysis(analysis, loaded);
+  EXPECT_NOT_OK(cache.Load(2));
+
+  // A cache with different uprobe templates does not see the entry.
+  UProbeAnalysisCache other_cache(temp_dir.path() / "cache", kFingerprint + 1);
+  EXPECT_NOT_OK(other_cache.Load(1));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -23,9 +23,13 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <map>
 
+#include "xxhash.h"
+
 #include "src/common/base/base.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/utils.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/fs/fs_wrapper.h"
@@ -42,6 +46,10 @@ DEFINE_bool(stirling_rescan_for_dlopen, false,
 DEFINE_double(stirling_rescan_exp_backoff_factor, 2.0,
               "Exponential backoff factor used in decided how often to rescan binaries for "
               "dynamically loaded libraries");
+DEFINE_int32(stirling_uprobe_deploy_threads,
+             gflags::Int32FromEnv("PL_STIRLING_UPROBE_DEPLOY_THREADS", 4),
+             "Number of threads that analyze binaries for uprobe deployment. "
+             "Each thread may hold the debug info of one binary in memory at a time.");
 
 namespace px {
 namespace stirling {
@@ -49,6 +57,29 @@ namespace stirling {
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 
+namespace {
+
+// Covers the inputs of AnalyzeGoBinary() besides the binary itself,
+// so that cached analyses are invalidated when the uprobe templates change.
+uint64_t GoAnalysisFingerprint(bool enable_http2_tracing,
+                               const ArrayView<UProbeTmpl>& runtime_tmpls,
+                               const ArrayView<UProbeTmpl>& tls_tmpls,
+                               const ArrayView<UProbeTmpl>& http2_tmpls) {
+  uint64_t fingerprint = enable_http2_tracing;
+  for (const auto& tmpls : {runtime_tmpls, tls_tmpls, http2_tmpls}) {
+    fingerprint = HashCombine(fingerprint, tmpls.size());
+    for (const auto& tmpl : tmpls) {
+      fingerprint = HashCombine(fingerprint, XXH64(tmpl.symbol.data(), tmpl.symbol.size(), 0));
+      fingerprint = HashCombine(fingerprint, XXH64(tmpl.probe_fn.data(), tmpl.probe_fn.size(), 0));
+      fingerprint = HashCombine(fingerprint, static_cast<uint64_t>(tmpl.match_type));
+      fingerprint = HashCombine(fingerprint, static_cast<uint64_t>(tmpl.attach_type));
+    }
+  }
+  return fingerprint;
+}
+
+}  // namespace
+
 UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc) : bcc_(bcc) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
 }
@@ -57,6 +88,16 @@ void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
   cfg_enable_http2_tracing_ = enable_http2_tracing;
   cfg_disable_self_probing_ = disable_self_probing;
 
+  deploy_pool_ =
+      std::make_unique<ParserPool>(std::max<int32_t>(FLAGS_stirling_uprobe_deploy_threads, 1));
+
+  if (!FLAGS_stirling_uprobe_analysis_cache_dir.empty()) {
+    analysis_cache_ = std::make_unique<UProbeAnalysisCache>(
+        FLAGS_stirling_uprobe_analysis_cache_dir,
+        GoAnalysisFingerprint(enable_http2_tracing, kGoRuntimeUProbeTmpls, kGoTLSUProbeTmpls,
+                              kHTTP2ProbeTmpls));
+  }
+
   openssl_symaddrs_map_ = UserSpaceManagedBPFMap<uint32_t, struct openssl_symaddrs_t>::Create(
       bcc_, "openssl_symaddrs_map");
   go_common_symaddrs_map_ = UserSpaceManagedBPFMap<uint32_t, struct go_common_symaddrs_t>::Create(
@@ -74,14 +115,13 @@ void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
 
 void UProbeManager::NotifyMMapEvent(upid_t upid) { upids_with_mmap_.insert(upid); }
 
-StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                              const std::string& binary,
-                                              obj_tools::ElfReader* elf_reader) {
+StatusOr<std::vector<bpf_tools::UProbeSpec>> UProbeManager::ResolveUProbeTmpl(
+    const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader) {
   using bpf_tools::BPFProbeAttachType;
 
-  int uprobe_count = 0;
+  std::vector<bpf_tools::UProbeSpec> specs;
   for (const auto& tmpl : probe_tmpls) {
-    bpf_tools::UProbeSpec spec = {binary,
+    bpf_tools::UProbeSpec spec = {/*binary_path*/ {},
                                   /*symbol*/ {},
                                   /*address*/ 0,    bpf_tools::UProbeSpec::kDefaultPID,
                                   tmpl.attach_type, std::string(tmpl.probe_fn)};
@@ -100,8 +140,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
         case BPFProbeAttachType::kEntry:
         case BPFProbeAttachType::kReturn: {
           spec.symbol = symbol_info.name;
-          PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-          ++uprobe_count;
+          specs.push_back(spec);
           break;
         }
         case BPFProbeAttachType::kReturnInsts: {
@@ -118,8 +157,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
           for (const uint64_t& addr : ret_inst_addrs) {
             spec.attach_type = BPFProbeAttachType::kEntry;
             spec.address = addr;
-            PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-            ++uprobe_count;
+            specs.push_back(spec);
           }
           break;
         }
@@ -128,48 +166,30 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
       }
     }
   }
-  return uprobe_count;
+  return specs;
 }
 
-Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
-
-  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
-
-  return Status::OK();
-}
-
-Status UProbeManager::UpdateGoCommonSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                             const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_common_symaddrs_t symaddrs,
-                      GoCommonSymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_common_symaddrs_map_->UpdateValue(pid, symaddrs);
+StatusOr<int> UProbeManager::AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& specs,
+                                           const std::string& binary) {
+  for (auto spec : specs) {
+    spec.binary_path = binary;
+    PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
   }
-
-  return Status::OK();
+  return static_cast<int>(specs.size());
 }
 
-Status UProbeManager::UpdateGoHTTP2SymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                            const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_http2_symaddrs_t symaddrs,
-                      GoHTTP2SymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_http2_symaddrs_map_->UpdateValue(pid, symaddrs);
-  }
-
-  return Status::OK();
+StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
+                                              const std::string& binary,
+                                              obj_tools::ElfReader* elf_reader) {
+  PL_ASSIGN_OR_RETURN(std::vector<bpf_tools::UProbeSpec> specs,
+                      ResolveUProbeTmpl(probe_tmpls, elf_reader));
+  return AttachUProbes(specs, binary);
 }
 
-Status UProbeManager::UpdateGoTLSSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                          const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_tls_symaddrs_t symaddrs, GoTLSSymAddrs(elf_reader, dwarf_reader));
+Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
 
-  for (auto& pid : pids) {
-    go_tls_symaddrs_map_->UpdateValue(pid, symaddrs);
-  }
+  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
 
   return Status::OK();
 }
@@ -382,8 +402,7 @@ void UProbeManager::SetupGOIDMaps(const std::string& binary, const std::vector<i
 }
 
 StatusOr<int> UProbeManager::AttachGoRuntimeUProbes(const std::string& binary,
-                                                    obj_tools::ElfReader* elf_reader,
-                                                    obj_tools::DwarfReader* /* dwarf_reader */,
+                                                    const GoBinaryAnalysis& analysis,
                                                     const std::vector<int32_t>& /* pids */) {
   // Step 1: Update BPF symbols_map on all new PIDs.
   // TODO(oazizi): Implement this piece.
@@ -394,21 +413,23 @@ StatusOr<int> UProbeManager::AttachGoRuntimeUProbes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kGoRuntimeUProbeTmpls, binary, elf_reader);
+  PL_RETURN_IF_ERROR(analysis.runtime_probes.status());
+  return AttachUProbes(analysis.runtime_probes.ValueOrDie(), binary);
 }
 
 StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
-                                                obj_tools::ElfReader* elf_reader,
-                                                obj_tools::DwarfReader* dwarf_reader,
+                                                const GoBinaryAnalysis& analysis,
                                                 const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symbols_map on all new PIDs.
-  Status s = UpdateGoTLSSymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!analysis.tls_symaddrs.ok()) {
     // Doesn't appear to be a binary with the mandatory symbols.
     // Might not even be a golang binary.
     // Either way, not of interest to probe.
     return 0;
   }
+  for (auto& pid : pids) {
+    go_tls_symaddrs_map_->UpdateValue(pid, analysis.tls_symaddrs.ValueOrDie());
+  }
 
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_tls_probed_binaries_.insert(binary);
@@ -416,7 +437,8 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader);
+  PL_RETURN_IF_ERROR(analysis.tls_probes.status());
+  return AttachUProbes(analysis.tls_probes.ValueOrDie(), binary);
 }
 
 // TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
@@ -424,14 +446,15 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
 // cleanly. For example, right now, enabling uprobe & kprobe simultaneously can crash Stirling,
 // because of the mixed & duplicate data events from these 2 sources.
 StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
-                                                 obj_tools::ElfReader* elf_reader,
-                                                 obj_tools::DwarfReader* dwarf_reader,
+                                                 const GoBinaryAnalysis& analysis,
                                                  const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symaddrs for this binary.
-  Status s = UpdateGoHTTP2SymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!analysis.http2_symaddrs.ok()) {
     return 0;
   }
+  for (auto& pid : pids) {
+    go_http2_symaddrs_map_->UpdateValue(pid, analysis.http2_symaddrs.ValueOrDie());
+  }
 
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_http2_probed_binaries_.insert(binary);
@@ -439,7 +462,8 @@ StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader);
+  PL_RETURN_IF_ERROR(analysis.http2_probes.status());
+  return AttachUProbes(analysis.http2_probes.ValueOrDie(), binary);
 }
 
 namespace {
@@ -477,27 +501,58 @@ std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
   return pids;
 }
 
+// Hashes the contents of a file, so that copies of a binary at different paths can be recognized.
+StatusOr<uint64_t> FileContentHash(const std::string& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    return error::Internal("Could not open $0 for hashing.", path);
+  }
+
+  std::unique_ptr<XXH64_state_t, decltype(&XXH64_freeState)> state(XXH64_createState(),
+                                                                    &XXH64_freeState);
+  if (state == nullptr || XXH64_reset(state.get(), /*seed*/ 0) != XXH_OK) {
+    return error::Internal("Could not initialize the hash state.");
+  }
+
+  constexpr size_t kChunkSize = 1 << 20;
+  std::vector<char> buf(kChunkSize);
+  while (ifs) {
+    ifs.read(buf.data(), buf.size());
+    if (XXH64_update(state.get(), buf.data(), ifs.gcount()) != XXH_OK) {
+      return error::Internal("Could not hash $0.", path);
+    }
+  }
+  if (ifs.bad()) {
+    return error::Internal("Failed to read $0 for hashing.", path);
+  }
+  return XXH64_digest(state.get());
+}
+
 }  // namespace
 
-std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids) {
+std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                                  ProcEventLogPosition proc_events) {
   // Increment before starting thread to avoid race in case thread starts late.
   ++num_deploy_uprobes_threads_;
-  return std::thread([this, pids]() {
-    DeployUProbes(pids);
+  return std::thread([this, pids, proc_events]() {
+    DeployUProbes(pids, proc_events);
     --num_deploy_uprobes_threads_;
   });
   return {};
 }
 
 void UProbeManager::CleanupPIDMaps(const absl::flat_hash_set<md::UPID>& deleted_upids) {
-  for (const auto& pid : deleted_upids) {
-    openssl_symaddrs_map_->RemoveValue(pid.pid());
-    go_common_symaddrs_map_->RemoveValue(pid.pid());
-    go_tls_symaddrs_map_->RemoveValue(pid.pid());
-    go_http2_symaddrs_map_->RemoveValue(pid.pid());
-    node_tlswrap_symaddrs_map_->RemoveValue(pid.pid());
-    go_goid_map_->RemoveValue(pid.pid());
+  std::vector<uint32_t> pids;
+  pids.reserve(deleted_upids.size());
+  for (const auto& upid : deleted_upids) {
+    pids.push_back(upid.pid());
   }
+  openssl_symaddrs_map_->RemoveValues(pids);
+  go_common_symaddrs_map_->RemoveValues(pids);
+  go_tls_symaddrs_map_->RemoveValues(pids);
+  go_http2_symaddrs_map_->RemoveValues(pids);
+  node_tlswrap_symaddrs_map_->RemoveValues(pids);
+  go_goid_map_->RemoveValues(pids);
 }
 
 int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pids) {
@@ -540,97 +595,242 @@ int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pid
   return uprobe_count;
 }
 
-int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+StatusOr<GoBinaryAnalysis> UProbeManager::AnalyzeGoBinary(
+    const std::string& binary) const {
+  // Read binary's symbols.
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(binary));
+
+  GoBinaryAnalysis analysis;
+
+  // Avoid going past this point if not a golang program.
+  // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
+  analysis.is_go = IsGoExecutable(elf_reader.get());
+  if (!analysis.is_go) {
+    return analysis;
+  }
+
+  StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status =
+      DwarfReader::CreateIndexingAll(binary);
+  if (!dwarf_reader_status.ok()) {
+    analysis.common_symaddrs = error::Internal("Failed to get debug symbols. Message = $0",
+                                               dwarf_reader_status.msg());
+    return analysis;
+  }
+  std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+
+  analysis.common_symaddrs = GoCommonSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (!analysis.common_symaddrs.ok()) {
+    return analysis;
+  }
+
+  analysis.runtime_probes = ResolveUProbeTmpl(kGoRuntimeUProbeTmpls, elf_reader.get());
+
+  analysis.tls_symaddrs = GoTLSSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (analysis.tls_symaddrs.ok()) {
+    analysis.tls_probes = ResolveUProbeTmpl(kGoTLSUProbeTmpls, elf_reader.get());
+  }
+
+  if (cfg_enable_http2_tracing_) {
+    analysis.http2_symaddrs = GoHTTP2SymAddrs(elf_reader.get(), dwarf_reader.get());
+    if (analysis.http2_symaddrs.ok()) {
+      analysis.http2_probes = ResolveUProbeTmpl(kHTTP2ProbeTmpls, elf_reader.get());
+    }
+  }
+
+  return analysis;
+}
+
+int UProbeManager::AttachGoBinary(const std::string& binary, const std::vector<int32_t>& pids,
+                                  const GoBinaryAnalysis& analysis) {
+  if (!analysis.is_go) {
+    return 0;
+  }
+
+  if (!analysis.common_symaddrs.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn). Message = $1",
+        binary, analysis.common_symaddrs.msg());
+    return 0;
+  }
+  for (auto& pid : pids) {
+    go_common_symaddrs_map_->UpdateValue(pid, analysis.common_symaddrs.ValueOrDie());
+  }
+
+  // Setup thread to GOID mapping.
+  SetupGOIDMaps(binary, pids);
+
   int uprobe_count = 0;
 
-  static int32_t kPID = getpid();
+  // Go Runtime Probes.
+  {
+    StatusOr<int> attach_status = AttachGoRuntimeUProbes(binary, analysis, pids);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach Go Runtime Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
+  }
 
-  for (const auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
-    // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
-    if (!scanned_binaries_.insert(binary).second) {
-      continue;
+  // GoTLS Probes.
+  {
+    StatusOr<int> attach_status = AttachGoTLSUProbes(binary, analysis, pids);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
     }
+  }
 
-    if (cfg_disable_self_probing_) {
-      // Don't try to attach uprobes to self.
-      // This speeds up stirling_wrapper initialization significantly.
-      if (pid_vec.size() == 1 && pid_vec[0] == kPID) {
-        continue;
-      }
+  return uprobe_count;
+}
+
+int UProbeManager::DeployGoBinaryGroup(GoBinaryGroup* group) {
+  std::shared_ptr<const GoBinaryAnalysis> analysis;
+  if (group->content_hash.has_value()) {
+    absl::MutexLock lock(&attach_lock_);
+    auto iter = go_analysis_by_hash_.find(group->content_hash.value());
+    if (iter != go_analysis_by_hash_.end()) {
+      analysis = iter->second;
+    }
+  }
+
+  if (analysis == nullptr && group->content_hash.has_value() && analysis_cache_ != nullptr) {
+    StatusOr<GoBinaryAnalysis> cached = analysis_cache_->Load(group->content_hash.value());
+    if (cached.ok()) {
+      analysis = std::make_shared<const GoBinaryAnalysis>(cached.ConsumeValueOrDie());
+    } else {
+      VLOG(1) << absl::Substitute("No cached uprobe analysis for $0: $1",
+                                  group->binaries.front().first, cached.msg());
     }
+  }
 
-    // Read binary's symbols.
-    StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
-    if (!elf_reader_status.ok()) {
+  // The expensive part, which runs without holding the lock.
+  if (analysis == nullptr) {
+    const std::string& binary = group->binaries.front().first;
+    StatusOr<GoBinaryAnalysis> analysis_status = AnalyzeGoBinary(binary);
+    if (!analysis_status.ok()) {
       LOG(WARNING) << absl::Substitute(
           "Cannot analyze binary $0 for uprobe deployment. "
           "If file is under /var/lib, container may have terminated. "
           "Message = $1",
-          binary, elf_reader_status.msg());
-      continue;
+          binary, analysis_status.msg());
+      return 0;
     }
-    std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+    analysis = std::make_shared<const GoBinaryAnalysis>(analysis_status.ConsumeValueOrDie());
 
-    // Avoid going past this point if not a golang program.
-    // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
-    if (!IsGoExecutable(elf_reader.get())) {
-      continue;
+    if (group->content_hash.has_value() && analysis_cache_ != nullptr) {
+      Status s = analysis_cache_->Store(group->content_hash.value(), *analysis);
+      LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to cache uprobe analysis of $0: $1",
+                                                   binary, s.msg());
     }
+  }
 
-    StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status =
-        DwarfReader::CreateIndexingAll(binary);
-    if (!dwarf_reader_status.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
-          "Message = $1",
-          binary, dwarf_reader_status.msg());
-      continue;
-    }
-    std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+  absl::MutexLock lock(&attach_lock_);
+  if (group->content_hash.has_value()) {
+    go_analysis_by_hash_.emplace(group->content_hash.value(), analysis);
+  }
 
-    Status s = UpdateGoCommonSymAddrs(elf_reader.get(), dwarf_reader.get(), pid_vec);
-    if (!s.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+  int uprobe_count = 0;
+  for (const auto& [binary, pid_vec] : group->binaries) {
+    uprobe_count += AttachGoBinary(binary, pid_vec, *analysis);
+  }
+  group->analysis = std::move(analysis);
+  return uprobe_count;
+}
+
+int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+  static int32_t kPID = getpid();
+
+  std::vector<std::pair<std::string, std::vector<int32_t>>> binaries;
+  for (auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
+    // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
+    if (!scanned_binaries_.insert(binary).second) {
       continue;
     }
 
-    // Setup thread to GOID mapping.
-    SetupGOIDMaps(binary, pid_vec);
-
-    // Go Runtime Probes.
-    {
-      StatusOr<int> attach_status =
-          AttachGoRuntimeUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute(
-            "Failed to attach Go Runtime Uprobes to $0: $1", binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    if (cfg_disable_self_probing_) {
+      // Don't try to attach uprobes to self.
+      // This speeds up stirling_wrapper initialization significantly.
+      if (pid_vec.size() == 1 && pid_vec[0] == kPID) {
+        continue;
       }
     }
 
-    // GoTLS Probes.
-    {
-      StatusOr<int> attach_status =
-          AttachGoTLSUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    binaries.emplace_back(binary, std::move(pid_vec));
+  }
+
+  if (binaries.empty()) {
+    return 0;
+  }
+
+  // Stage 1: Hash the binaries, so that copies at different paths (e.g. in the file systems of
+  // different containers of the same image) are only analyzed once.
+  std::vector<StatusOr<uint64_t>> hashes(binaries.size());
+  {
+    std::atomic<size_t> next = 0;
+    deploy_pool_->Run([&](size_t /*worker*/) {
+      for (size_t i = next++; i < binaries.size(); i = next++) {
+        hashes[i] = FileContentHash(binaries[i].first);
+      }
+    });
+  }
+
+  std::vector<GoBinaryGroup> groups;
+  absl::flat_hash_map<uint64_t, size_t> group_index_by_hash;
+  for (size_t i = 0; i < binaries.size(); ++i) {
+    auto& binary_and_pids = binaries[i];
+    const StatusOr<uint64_t>& hash = hashes[i];
+    GoBinaryGroup* group;
+    if (hash.ok()) {
+      auto [iter, inserted] = group_index_by_hash.try_emplace(hash.ValueOrDie(), groups.size());
+      if (inserted) {
+        groups.emplace_back().content_hash = hash.ValueOrDie();
       }
+      group = &groups[iter->second];
+    } else {
+      VLOG(1) << absl::Substitute("Could not hash binary $0: $1", binary_and_pids.first,
+                                  hash.msg());
+      group = &groups.emplace_back();
     }
+    group->num_pids += binary_and_pids.second.size();
+    group->binaries.push_back(std::move(binary_and_pids));
+  }
 
-    // Go HTTP2 Probes.
-    if (cfg_enable_http2_tracing_) {
-      StatusOr<int> attach_status =
-          AttachGoHTTP2Probes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+  // Binaries with the most instances are probed first, since they likely carry the most traffic.
+  std::stable_sort(groups.begin(), groups.end(),
+                   [](const GoBinaryGroup& a, const GoBinaryGroup& b) {
+                     return a.num_pids > b.num_pids;
+                   });
+
+  // Stage 2: Analyze each group and attach its Go runtime and GoTLS probes.
+  // The workers take groups in priority order, and attach as soon as their analysis is done.
+  std::atomic<int> uprobe_count = 0;
+  {
+    std::atomic<size_t> next = 0;
+    deploy_pool_->Run([&](size_t /*worker*/) {
+      for (size_t i = next++; i < groups.size(); i = next++) {
+        uprobe_count += DeployGoBinaryGroup(&groups[i]);
+      }
+    });
+  }
+
+  // Stage 3: HTTP2 probes are more numerous, so they are attached after all the GoTLS probes.
+  if (cfg_enable_http2_tracing_) {
+    absl::MutexLock lock(&attach_lock_);
+    for (const GoBinaryGroup& group : groups) {
+      if (group.analysis == nullptr || !group.analysis->common_symaddrs.ok()) {
+        continue;
+      }
+      for (const auto& [binary, pid_vec] : group.binaries) {
+        StatusOr<int> attach_status = AttachGoHTTP2Probes(binary, *group.analysis, pid_vec);
+        if (!attach_status.ok()) {
+          LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
+                                                       binary, attach_status.ToString());
+        } else {
+          uprobe_count += attach_status.ValueOrDie();
+        }
       }
     }
   }
@@ -684,10 +884,11 @@ absl::flat_hash_set<md::UPID> UProbeManager::PIDsToRescanForUProbes() {
   return upids_to_rescan;
 }
 
-void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids,
+                                  ProcEventLogPosition proc_events) {
   const std::lock_guard<std::mutex> lock(deploy_uprobes_mutex_);
 
-  proc_tracker_.Update(pids);
+  proc_tracker_.Update(pids, proc_events);
 
   // Before deploying new probes, clean-up map entries for old processes that are now dead.
   CleanupPIDMaps(proc_tracker_.deleted_upids());
@@ -20,6 +20,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -32,6 +33,8 @@
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/source_connectors/socket_tracer/parser_pool.h"
+#include "src/stirling/source_connectors/socket_tracer/uprobe_analysis_cache.h"
 
 #include "src/stirling/utils/detect_application.h"
 #include "src/stirling/utils/proc_path_tools.h"
@@ -39,6 +42,7 @@
 
 DECLARE_bool(stirling_rescan_for_dlopen);
 DECLARE_double(stirling_rescan_exp_backoff_factor);
+DECLARE_int32(stirling_uprobe_deploy_threads);
 
 namespace px {
 namespace stirling {
@@ -82,6 +86,18 @@ class UserSpaceManagedBPFMap {
     }
   }
 
+  // Removes the keys with a single BPF access, where the kernel supports it.
+  void RemoveValues(const std::vector<TKeyType>& keys) {
+    std::vector<TKeyType> shadowed_keys;
+    for (const TKeyType& key : keys) {
+      if (shadow_keys_.erase(key) > 0) {
+        shadowed_keys.push_back(key);
+      }
+    }
+    Status s = bpf_tools::BCCWrapper::RemoveValues(map_.get(), shadowed_keys);
+    LOG_IF(WARNING, !s.ok()) << absl::StrCat("Could not remove from BPF map. Message=", s.msg());
+  }
+
  private:
   UserSpaceManagedBPFMap(bpf_tools::BCCWrapper* bcc, const std::string& map_name) {
     if constexpr (std::is_same_v<TMapType, ebpf::BPFMapInMapTable<TKeyType>>) {
@@ -125,9 +141,11 @@ class UProbeManager {
    * Runs the uprobe deployment code on the provided set of pids, as a thread.
    * @param pids New PIDs to analyze deploy uprobes on. Old PIDs can also be provided,
    *             if they need to be rescanned.
+   * @param proc_events The position of pids in the process event log, if any.
    * @return thread that handles the uprobe deployment work.
    */
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                     ProcEventLogPosition proc_events = {});
 
   /**
    * Returns true if a previously dispatched thread (via RunDeployUProbesThread is still running).
@@ -328,6 +346,17 @@ class UProbeManager {
 
   static StatusOr<std::array<UProbeTmpl, 6>> GetNodeOpensslUProbeTmpls(const SemVer& ver);
 
+  // Binaries with identical contents, which are analyzed once and then probed together.
+  struct GoBinaryGroup {
+    // Not set if the binary could not be hashed, in which case the group has a single binary.
+    std::optional<uint64_t> content_hash;
+    // The binaries, each with the PIDs that are new instances of it.
+    std::vector<std::pair<std::string, std::vector<int32_t>>> binaries;
+    size_t num_pids = 0;
+    // Filled in once the group is deployed.
+    std::shared_ptr<const GoBinaryAnalysis> analysis;
+  };
+
   // Probes for OpenSSL tracing.
   inline static const auto kOpenSSLUProbes = MakeArray<bpf_tools::UProbeSpec>({
       bpf_tools::UProbeSpec{
@@ -368,7 +397,7 @@ class UProbeManager {
    * Deploys all available uprobe types (HTTP2, OpenSSL, etc.) on new processes.
    * @param pids The list of pids to analyze and instrument with uprobes, if appropriate.
    */
-  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids);
+  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids, ProcEventLogPosition proc_events);
 
   /**
    * Deploys all OpenSSL uprobes on new processes.
@@ -379,11 +408,37 @@ class UProbeManager {
 
   /**
    * Deploys all Go uprobes on new processes.
+   * The binaries are analyzed in parallel on deploy_pool_, and the ones with the most instances
+   * are probed first. HTTP2 probes are only attached once all binaries have their GoTLS probes.
    * @param pids The list of pids to analyze and instrument with Go uprobes, if appropriate.
    * @return Number of uprobes deployed.
    */
   int DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids);
 
+  /**
+   * Analyzes a group of identical binaries, unless a previous analysis of the same contents
+   * exists in memory or in analysis_cache_, and attaches the Go runtime and GoTLS probes to each
+   * binary of the group.
+   * Called concurrently from the workers of deploy_pool_.
+   * @return Number of uprobes deployed.
+   */
+  int DeployGoBinaryGroup(GoBinaryGroup* group) ABSL_LOCKS_EXCLUDED(attach_lock_);
+
+  /**
+   * Reads the symbols and debug info of a binary to find the Go symbol addresses and uprobe
+   * locations. Does not touch BPF, so it is safe to call concurrently.
+   * @return The analysis, or error if the binary could not be read.
+   */
+  StatusOr<GoBinaryAnalysis> AnalyzeGoBinary(const std::string& binary) const;
+
+  /**
+   * Populates the symbol addresses and GOID maps of the PIDs, and attaches the Go runtime and
+   * GoTLS probes to the binary. HTTP2 probes are attached separately, via AttachGoHTTP2Probes().
+   * @return Number of uprobes deployed.
+   */
+  int AttachGoBinary(const std::string& binary, const std::vector<int32_t>& pids,
+                     const GoBinaryAnalysis& analysis) ABSL_EXCLUSIVE_LOCKS_REQUIRED(attach_lock_);
+
   /**
    * Sets up the BPF maps used for GOID tracking. Required for general Go tracing.
    *
@@ -397,49 +452,46 @@ class UProbeManager {
    * compatible Go binary.
    *
    * @param binary The path to the binary on which to deploy Go probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param analysis The analysis of the binary's contents.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not an error if the binary
    *         is not a Go binary; instead the return value will be zero.
    */
-  StatusOr<int> AttachGoRuntimeUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                       obj_tools::DwarfReader* dwarf_reader,
-                                       const std::vector<int32_t>& new_pids);
+  StatusOr<int> AttachGoRuntimeUProbes(const std::string& binary, const GoBinaryAnalysis& analysis,
+                                       const std::vector<int32_t>& new_pids)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(attach_lock_);
 
   /**
    * Attaches the required probes for Go HTTP2 tracing to the specified binary, if it is a
    * compatible Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param analysis The analysis of the binary's contents.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not considered an error if the binary
    *         is not a Go binary or doesn't use a Go HTTP2 library; instead the return value will be
    *         zero.
    */
-  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                    obj_tools::DwarfReader* dwarf_reader,
-                                    const std::vector<int32_t>& pids);
+  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, const GoBinaryAnalysis& analysis,
+                                    const std::vector<int32_t>& pids)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(attach_lock_);
 
   /**
    * Attaches the required probes for GoTLS tracing to the specified binary, if it is a compatible
    * Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param analysis The analysis of the binary's contents.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not an error if the binary
    *         is not a Go binary or doesn't use Go TLS; instead the return value will be zero.
    */
-  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                   obj_tools::DwarfReader* dwarf_reader,
-                                   const std::vector<int32_t>& new_pids);
+  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, const GoBinaryAnalysis& analysis,
+                                   const std::vector<int32_t>& new_pids)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(attach_lock_);
 
   /**
    * Attaches the required probes for OpenSSL tracing to the specified PID, if it uses OpenSSL.
@@ -475,18 +527,24 @@ class UProbeManager {
   StatusOr<int> AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
                                  const std::string& binary, obj_tools::ElfReader* elf_reader);
 
+  /**
+   * Finds the uprobe specs of the probe templates, like AttachUProbeTmpl(), without attaching
+   * anything. The binary_path of the specs is left empty.
+   */
+  static StatusOr<std::vector<bpf_tools::UProbeSpec>> ResolveUProbeTmpl(
+      const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader);
+
+  /**
+   * Attaches the uprobe specs to the binary.
+   * @return Number of uprobes deployed, or error if any uprobe failed to deploy.
+   */
+  StatusOr<int> AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& specs,
+                              const std::string& binary);
+
   // Returns set of PIDs that have had mmap called on them since the last call.
   absl::flat_hash_set<md::UPID> PIDsToRescanForUProbes();
 
   Status UpdateOpenSSLSymAddrs(std::filesystem::path container_lib, uint32_t pid);
-  Status UpdateGoCommonSymAddrs(obj_tools::ElfReader* elf_reader,
-                                obj_tools::DwarfReader* dwarf_reader,
-                                const std::vector<int32_t>& pids);
-  Status UpdateGoHTTP2SymAddrs(obj_tools::ElfReader* elf_reader,
-                               obj_tools::DwarfReader* dwarf_reader,
-                               const std::vector<int32_t>& pids);
-  Status UpdateGoTLSSymAddrs(obj_tools::ElfReader* elf_reader, obj_tools::DwarfReader* dwarf_reader,
-                             const std::vector<int32_t>& pids);
   Status UpdateNodeTLSWrapSymAddrs(int32_t pid, const std::filesystem::path& node_exe,
                                    const SemVer& ver);
 
@@ -507,6 +565,20 @@ class UProbeManager {
   std::mutex deploy_uprobes_mutex_;
   std::atomic<int> num_deploy_uprobes_threads_ = 0;
 
+  // Analyzes the Go binaries of a DeployUProbes() call in parallel.
+  std::unique_ptr<ParserPool> deploy_pool_;
+
+  // Serializes the BPF map updates and uprobe attachments made by the deploy_pool_ workers,
+  // since neither BCCWrapper nor UserSpaceManagedBPFMap is thread-safe.
+  absl::Mutex attach_lock_;
+
+  // Analyses of the Go binaries seen so far, keyed by the hash of their contents.
+  absl::flat_hash_map<uint64_t, std::shared_ptr<const GoBinaryAnalysis>> go_analysis_by_hash_
+      ABSL_GUARDED_BY(attach_lock_);
+
+  // Keeps the analyses across restarts. Only set if --stirling_uprobe_analysis_cache_dir is.
+  std::unique_ptr<UProbeAnalysisCache> analysis_cache_;
+
   std::unique_ptr<system::ProcParser> proc_parser_;
   ProcTracker proc_tracker_;
   LazyLoadedFPResolver fp_resolver_;
@@ -29,16 +29,26 @@
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
+#include "src/common/metrics/named_timer.h"
 #include "src/common/perf/elapsed_timer.h"
+#include "src/common/perf/profile_tags.h"
 #include "src/common/system/system_info.h"
+#include "src/common/system/thread_placement.h"
 
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/bpf_tools/probe_cleaner.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/pub_sub_manager.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/core/source_registry.h"
+#include "src/stirling/core/startup_report.h"
 #include "src/stirling/proto/stirling.pb.h"
 
 #include "src/stirling/source_connectors/dynamic_bpftrace/dynamic_bpftrace_connector.h"
@@ -54,6 +64,25 @@
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
+#include "src/stirling/utils/linux_headers.h"
+
+DEFINE_bool(stirling_source_threads, false,
+            "If true, each source connector is sampled and pushed on its own thread, "
+            "so that a slow source cannot delay the others. "
+            "The registered data push callback must be thread-safe.");
+DEFINE_bool(stirling_async_source_init, true,
+            "If true, Stirling is created as soon as the tables of its sources are known, and the "
+            "sources are initialized one by one on a background thread. Each source is sampled as "
+            "soon as it is initialized, so that e.g. the protocol tables don't wait for the "
+            "profiler to deploy its BPF programs.");
+DEFINE_string(stirling_thread_placement, "",
+              "The CPUs and NUMA memory policy of the Stirling core loop and source threads, as "
+              "'<cpu list>[:<default|local|bind|interleave|preferred>]', e.g. '0-3:local'. Empty "
+              "leaves them unplaced.");
+DEFINE_string(stirling_upid_tabletized_tables, "",
+              "Comma-separated names of tables, e.g. 'http_events,mysql_events', whose records "
+              "are split into a tablet per UPID, so that queries on the processes of a few "
+              "services only read their tablets.");
 
 namespace px {
 namespace stirling {
@@ -139,10 +168,167 @@ std::unique_ptr<SourceRegistry> CreateProdSourceRegistry() {
       .ConsumeValueOrDie();
 }
 
+namespace {
+
+static constexpr std::chrono::milliseconds kMinSleepDuration{1};
+static constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
+
+// Helper function: Figure out when the source needs to be serviced next.
+px::chrono::coarse_steady_clock::time_point NextTickTime(const SourceConnector& source) {
+  return std::min(source.sampling_freq_mgr().next(), source.push_freq_mgr().next());
+}
+
+// Helper function: Figure out how long to sleep until the given wake-up time.
+std::chrono::milliseconds TimeUntil(px::chrono::coarse_steady_clock::time_point wakeup_time) {
+  auto now = px::chrono::coarse_steady_clock::now();
+
+  // Worst case, wake-up every so often.
+  // This is important if there are no subscribed info classes, to avoid sleeping eternally.
+  wakeup_time = std::min(wakeup_time, now + kMaxSleepDuration);
+
+  return std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now);
+}
+
+// Returns true if any of the input tables are beyond the threshold of their push policy.
+bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
+  for (const auto* data_table : data_tables) {
+    if (data_table->PushThresholdExceeded()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The placement of the core loop and the source worker threads, which read the perf buffers.
+const system::ThreadPlacer& StirlingThreadPlacer() {
+  static const auto* placer = new system::ThreadPlacer("stirling", FLAGS_stirling_thread_placement);
+  return *placer;
+}
+
+// Runs one iteration of sampling and pushing on the source.
+// If force_sample is true, the source is sampled even if its sampling period has not expired.
+void SampleAndPush(SourceConnector* source, const std::vector<DataTable*>& data_tables,
+                   ConnectorContext* ctx, const DataPushCallback& data_push_callback,
+                   bool force_sample = false) {
+  // Phase 1: Probe the source for its data.
+  if (force_sample || source->sampling_freq_mgr().Expired()) {
+    source->TransferData(ctx, data_tables);
+  }
+  // Phase 2: Push Data upstream.
+  if (source->push_freq_mgr().Expired() || DataExceedsThreshold(data_tables)) {
+    source->PushData(data_push_callback, data_tables);
+  }
+}
+
+/**
+ * SourceWorker samples and pushes the data of a single source connector on a dedicated thread.
+ * Used when --stirling_source_threads is set, so that sources do not wait on each other.
+ */
+class SourceWorker : public NotCopyable {
+ public:
+  SourceWorker(SourceConnector* source, std::vector<DataTable*> data_tables,
+               absl::Mutex* source_lock,
+               std::function<std::unique_ptr<ConnectorContext>()> get_context,
+               DataPushCallback data_push_callback)
+      : source_(source),
+        data_tables_(std::move(data_tables)),
+        source_lock_(source_lock),
+        get_context_(std::move(get_context)),
+        data_push_callback_(std::move(data_push_callback)) {}
+
+  ~SourceWorker() { Stop(); }
+
+  void Start() {
+    absl::MutexLock lock(&stop_lock_);
+    thread_ = std::thread(&SourceWorker::Run, this);
+  }
+
+  // Signals the worker to exit, and waits for its thread to finish the current iteration.
+  // May be called from several threads; each returns once the thread has finished.
+  void Stop() {
+    absl::MutexLock lock(&stop_lock_);
+    if (!stop_.HasBeenNotified()) {
+      stop_.Notify();
+    }
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+ private:
+  void Run() {
+    StirlingThreadPlacer().PlaceCurrentThread();
+    const bool data_wakeup = FLAGS_stirling_data_wakeup && source_->SupportsDataWakeup();
+    bool force_sample = false;
+
+    while (!stop_.HasBeenNotified()) {
+      // Only fetch a new context when it will actually be used.
+      std::unique_ptr<ConnectorContext> ctx;
+      if (force_sample || source_->sampling_freq_mgr().Expired()) {
+        ctx = get_context_();
+      }
+
+      std::chrono::milliseconds sleep_duration;
+      {
+        px::profiler::ScopedProfileTag profile_tag("stirling");
+        absl::MutexLock lock(source_lock_);
+        SampleAndPush(source_, data_tables_, ctx.get(), data_push_callback_, force_sample);
+        sleep_duration = TimeUntil(NextTickTime(*source_));
+      }
+
+      if (sleep_duration <= kMinSleepDuration) {
+        force_sample = false;
+      } else if (data_wakeup) {
+        force_sample = WaitForData(sleep_duration);
+      } else {
+        stop_.WaitForNotificationWithTimeout(absl::FromChrono(sleep_duration));
+        force_sample = false;
+      }
+    }
+  }
+
+  // Waits on the source for up to the timeout, and returns true if its data reached the wake-up
+  // watermark, meaning the source should be sampled ahead of its sampling period.
+  // The source lock is not held while waiting, so that other accesses are not held up.
+  bool WaitForData(std::chrono::milliseconds timeout) {
+    return source_->WaitForData(timeout) > 0 && !stop_.HasBeenNotified();
+  }
+
+  SourceConnector* source_;
+  const std::vector<DataTable*> data_tables_;
+  absl::Mutex* source_lock_;
+  std::function<std::unique_ptr<ConnectorContext>()> get_context_;
+  DataPushCallback data_push_callback_;
+
+  absl::Notification stop_;
+  // Serializes the joins of the thread.
+  absl::Mutex stop_lock_;
+  std::thread thread_ ABSL_GUARDED_BY(stop_lock_);
+};
+
+}  // namespace
+
 // Holds InfoClassManager and DataTable.
 struct SourceOutput {
   std::vector<InfoClassManager*> info_class_mgrs;
   std::vector<DataTable*> data_tables;
+
+  // Serializes sampling and pushing of the source with other accesses to the source.
+  // A mutex rather than a spin lock, since a sampling iteration can take milliseconds.
+  // Heap-allocated so its address remains stable when the output map is rehashed.
+  std::unique_ptr<absl::Mutex> lock = std::make_unique<absl::Mutex>();
+
+  // Only set when sources run on their own threads (see --stirling_source_threads).
+  // Shared so that it can be stopped, and its thread joined, without holding
+  // info_class_mgrs_lock_.
+  std::shared_ptr<SourceWorker> worker;
+
+  // Set once RemoveSource() starts, so that no worker is started for the source any more.
+  bool removing = false;
+
+  // Whether the source is initialized and sampled. The tables of sources that are still being
+  // initialized (see --stirling_async_source_init) are published, but stay empty until then.
+  bool ready = true;
 };
 
 class StirlingImpl final : public Stirling {
@@ -163,6 +349,10 @@ class StirlingImpl final : public Stirling {
   StatusOr<stirlingpb::Publish> GetTracepointInfo(sole::uuid trace_id) override;
   Status RemoveTracepoint(sole::uuid trace_id) override;
   void GetPublishProto(stirlingpb::Publish* publish_pb) override;
+  Status SetPushPolicy(std::string_view table_name, const DataTablePushPolicy& policy) override;
+  Status SetSubscribedColumns(std::string_view table_name,
+                              const std::vector<std::string>& column_names) override;
+  Status SetSocketTraceFilter(const SocketTraceFilter& filter) override;
   void RegisterDataPushCallback(DataPushCallback f) override { data_push_callback_ = f; }
   void RegisterAgentMetadataCallback(AgentMetadataCallback f) override {
     DCHECK(f != nullptr);
@@ -188,6 +378,23 @@ class StirlingImpl final : public Stirling {
   // Adds a source to Stirling, and updates all state accordingly.
   Status AddSource(std::unique_ptr<SourceConnector> source);
 
+  // Adds the tables of the source. A source that isn't ready is not sampled until it is marked
+  // ready with MarkSourceReady().
+  SourceConnector* RegisterSource(std::unique_ptr<SourceConnector> source, bool ready);
+  void MarkSourceReady(SourceConnector* source);
+
+  // Runs on init_thread_: prepares the BPF runtime, then initializes the sources in order, and
+  // marks each ready as soon as it is initialized.
+  void InitSources(std::vector<SourceConnector*> sources);
+
+  // Cleans up the probes of a previous instance, and prepares what the BPF programs of the sources
+  // share, so that the first source to deploy BPF doesn't do it on its own.
+  void PrepareBPFRuntime();
+
+  bool RunStartedOrStopping() const ABSL_SHARED_LOCKS_REQUIRED(init_mutex_) {
+    return run_started_ || stop_init_;
+  }
+
   // Removes a source and all its info classes from stirling.
   Status RemoveSource(std::string_view source_name);
 
@@ -202,12 +409,29 @@ class StirlingImpl final : public Stirling {
   // Main run implementation.
   void RunCore();
 
+  // Run implementation when each source runs on its own SourceWorker thread.
+  void RunSourceWorkers();
+
+  // Starts a SourceWorker thread for the source.
+  void StartSourceWorker(SourceConnector* source, SourceOutput* output)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
   // Wait for Stirling to stop its main loop.
   void WaitForStop();
 
   // Main thread used to spawn off RunThread().
   std::thread run_thread_;
 
+  // Initializes the sources, when --stirling_async_source_init is set.
+  std::thread init_thread_;
+  absl::Mutex init_mutex_;
+  // The contexts of the sources can only be made once Stirling runs, when the agent metadata
+  // callback is registered.
+  bool run_started_ ABSL_GUARDED_BY(init_mutex_) = false;
+  bool stop_init_ ABSL_GUARDED_BY(init_mutex_) = false;
+
+  StartupReport startup_report_{&GetMetricsRegistry()};
+
   std::atomic<bool> run_enable_ = false;
   std::atomic<bool> running_ = false;
   std::vector<std::unique_ptr<SourceConnector>> sources_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
@@ -221,6 +445,10 @@ class StirlingImpl final : public Stirling {
   // Lock to protect both info_class_mgrs_ and sources_.
   absl::base_internal::SpinLock info_class_mgrs_lock_;
 
+  // Whether sources are being run by SourceWorker threads.
+  // New sources added while this is true get their own SourceWorker.
+  bool source_workers_enabled_ ABSL_GUARDED_BY(info_class_mgrs_lock_) = false;
+
   std::unique_ptr<SourceRegistry> registry_;
 
   /**
@@ -234,6 +462,13 @@ class StirlingImpl final : public Stirling {
   AgentMetadataCallback agent_metadata_callback_ = nullptr;
   AgentMetadataType agent_metadata_;
 
+  // Tracks the processes of the host for standalone contexts, so that each context doesn't have to
+  // read the start time of every process again.
+  UPIDTracker upid_tracker_{system::Config::GetInstance().proc_path()};
+
+  // The processes that started and exited between the contexts, shared by all source connectors.
+  ProcEventLog proc_event_log_;
+
   absl::base_internal::SpinLock dynamic_trace_status_map_lock_;
   absl::flat_hash_map<sole::uuid, StatusOr<stirlingpb::Publish>> dynamic_trace_status_map_
       ABSL_GUARDED_BY(dynamic_trace_status_map_lock_);
@@ -336,11 +571,47 @@ void StirlingImpl::RegisterUserDebugSignalHandlers(int signum) {
   sigaction(signum, &sigaction_specs, NULL);
 }
 
+namespace {
+
+// The order in which the sources are brought online. The profilers deploy the largest BPF programs,
+// and their data is the least time sensitive, so they go last.
+int InitRank(std::string_view source_name) {
+  return source_name == PerfProfileConnector::kName ||
+                 source_name == PIDCPUUseBPFTraceConnector::kName
+             ? 1
+             : 0;
+}
+
+}  // namespace
+
 Status StirlingImpl::Init() {
   system::LogSystemInfo();
 
+  if (!registry_) {
+    return error::NotFound("Source registry doesn't exist");
+  }
+
+  std::vector<std::unique_ptr<SourceConnector>> sources;
+  for (const auto& [name, registry_element] : registry_->sources()) {
+    sources.push_back(registry_element.create_source_fn(name));
+  }
+  std::sort(sources.begin(), sources.end(), [](const auto& a, const auto& b) {
+    return std::make_pair(InitRank(a->name()), a->name()) <
+           std::make_pair(InitRank(b->name()), b->name());
+  });
+
+  if (FLAGS_stirling_async_source_init) {
+    std::vector<SourceConnector*> pending_sources;
+    for (auto& source : sources) {
+      pending_sources.push_back(RegisterSource(std::move(source), /*ready*/ false));
+    }
+    init_thread_ = std::thread(&StirlingImpl::InitSources, this, std::move(pending_sources));
+    LOG(INFO) << "Stirling successfully created, its sources are initialized in the background.";
+    return Status::OK();
+  }
+
   // Clean up any probes from a previous instance.
-  Status s = utils::CleanProbes();
+  Status s = startup_report_.Time("clean_probes", [] { return utils::CleanProbes(); });
 
   // TODO(yzhao): The below logging cannot be DFATAL. Otherwise, non-OPT built stirling_wrapper
   // deployed along side PEM will always crash as the probes owned by PEM cannot be modified by
@@ -348,24 +619,106 @@ Status StirlingImpl::Init() {
   // in order to skip cleaning up those probes.
   LOG_IF(WARNING, !s.ok()) << absl::Substitute("Kprobe Cleaner failed. Message $0", s.msg());
 
-  if (!registry_) {
-    return error::NotFound("Source registry doesn't exist");
-  }
-
-  for (const auto& [name, registry_element] : registry_->sources()) {
-    Status s = AddSource(registry_element.create_source_fn(name));
+  for (auto& source : sources) {
+    std::string name(source->name());
+    Status s = startup_report_.Time(absl::StrCat("init_source/", name),
+                                    [&]() { return AddSource(std::move(source)); });
     LOG_IF(DFATAL, !s.ok()) << absl::Substitute(
         "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
   }
+  startup_report_.Finish();
   LOG(INFO) << "Stirling successfully initialized.";
   return Status::OK();
 }
 
+void StirlingImpl::PrepareBPFRuntime() {
+  // Installing the Linux headers doesn't deploy any probes, so it runs while the probes of a
+  // previous instance are cleaned up. Resolving the task_struct offsets deploys a BPF program, so
+  // it has to wait for the cleanup.
+  std::thread clean_probes_thread([this]() {
+    Status s = startup_report_.Time("clean_probes", [] { return utils::CleanProbes(); });
+    // Not DFATAL, see Init().
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Kprobe Cleaner failed. Message $0", s.msg());
+  });
+
+  // BCC requires root, sources that deploy BPF programs fail their initialization without it.
+  const bool prepare_bpf = IsRoot();
+  if (prepare_bpf) {
+    Status s = startup_report_.Time("linux_headers", [] {
+      return utils::FindOrInstallLinuxHeaders({utils::kDefaultHeaderSearchOrder}).status();
+    });
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to install Linux headers: $0", s.msg());
+  }
+  clean_probes_thread.join();
+
+  if (prepare_bpf) {
+    Status s = startup_report_.Time("task_struct_offsets",
+                                    [] { return bpf_tools::PrepareTaskStructOffsets(); });
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to resolve task_struct offsets: $0",
+                                                 s.msg());
+  }
+}
+
+void StirlingImpl::InitSources(std::vector<SourceConnector*> sources) {
+  PrepareBPFRuntime();
+
+  for (SourceConnector* source : sources) {
+    {
+      absl::MutexLock lock(&init_mutex_);
+      if (stop_init_) {
+        break;
+      }
+    }
+    const std::string name(source->name());
+    Status s = startup_report_.Time(absl::StrCat("init_source/", name),
+                                    [source]() { return source->Init(); });
+    if (!s.ok()) {
+      LOG(DFATAL) << absl::Substitute(
+          "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
+      s = RemoveSource(name);
+      LOG_IF(ERROR, !s.ok()) << s.msg();
+      continue;
+    }
+
+    bool stopping;
+    {
+      absl::MutexLock lock(&init_mutex_);
+      init_mutex_.Await(absl::Condition(this, &StirlingImpl::RunStartedOrStopping));
+      stopping = stop_init_;
+    }
+    if (stopping) {
+      // Stop() stops this source along with the ready ones. Stopping the others is a no-op.
+      break;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<ConnectorContext> ctx = GetContext();
+    source->InitContext(ctx.get());
+    startup_report_.Record(absl::StrCat("init_context/", name), start,
+                           std::chrono::steady_clock::now(), Status::OK());
+    MarkSourceReady(source);
+    LOG(INFO) << absl::Substitute("Source connector $0 is online.", name);
+  }
+  startup_report_.Finish();
+}
+
 std::unique_ptr<ConnectorContext> StirlingImpl::GetContext() {
+  static auto* timer = new metrics::NamedTimer("stirling", "get_context");
+  metrics::ScopedNamedTimer scoped_timer(timer);
+  std::unique_ptr<ConnectorContext> ctx;
+  std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids;
   if (agent_metadata_callback_ != nullptr) {
-    return std::unique_ptr<ConnectorContext>(new AgentContext(agent_metadata_callback_()));
+    std::shared_ptr<const md::AgentMetadataState> agent_metadata_state = agent_metadata_callback_();
+    // Shares ownership of the metadata state, so that the log can tell whether it has seen it.
+    upids = std::shared_ptr<const absl::flat_hash_set<md::UPID>>(agent_metadata_state,
+                                                                 &agent_metadata_state->upids());
+    ctx = std::make_unique<AgentContext>(std::move(agent_metadata_state));
+  } else {
+    upids = upid_tracker_.Update();
+    ctx = std::make_unique<StandaloneContext>(upids);
   }
-  return std::unique_ptr<ConnectorContext>(new StandaloneContext());
+  ctx->set_proc_events(proc_event_log_.Update(std::move(upids)));
+  return ctx;
 }
 
 namespace {
@@ -385,37 +738,91 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   // Step 1: Init the source.
   PL_RETURN_IF_ERROR(source->Init());
 
+  // Step 2: Add its tables.
+  RegisterSource(std::move(source), /*ready*/ true);
+  return Status::OK();
+}
+
+SourceConnector* StirlingImpl::RegisterSource(std::unique_ptr<SourceConnector> source,
+                                              bool ready) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   std::vector<InfoClassManager*> mgrs;
   mgrs.reserve(source->table_schemas().size());
 
+  const absl::flat_hash_set<std::string_view> upid_tabletized_tables =
+      absl::StrSplit(FLAGS_stirling_upid_tabletized_tables, ',', absl::SkipWhitespace());
+
   for (const DataTableSchema& schema : source->table_schemas()) {
     LOG(INFO) << absl::Substitute("Adding info class: [$0/$1]", source->name(), schema.name());
     auto mgr = std::make_unique<InfoClassManager>(schema);
     mgr->SetSourceConnector(source.get());
+    if (upid_tabletized_tables.contains(schema.name())) {
+      Status s = mgr->data_table()->SetTabletizationKey("upid");
+      LOG_IF(WARNING, !s.ok()) << absl::Substitute("Not tabletizing $0 by UPID: $1", schema.name(),
+                                                   s.msg());
+    }
     mgrs.push_back(mgr.get());
     info_class_mgrs_.push_back(std::move(mgr));
   }
 
   std::vector<DataTable*> data_tables = GetDataTables(mgrs);
 
-  source_output_map_[source.get()] = {std::move(mgrs),
-                                      // DataTable objects are created after subscribing.
-                                      std::move(data_tables)};
+  SourceOutput& output = source_output_map_[source.get()];
+  output.info_class_mgrs = std::move(mgrs);
+  output.data_tables = std::move(data_tables);
+  output.ready = ready;
+  if (ready && source_workers_enabled_) {
+    StartSourceWorker(source.get(), &output);
+  }
+  SourceConnector* source_ptr = source.get();
   sources_.push_back(std::move(source));
+  return source_ptr;
+}
 
-  return Status::OK();
+void StirlingImpl::MarkSourceReady(SourceConnector* source) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  auto iter = source_output_map_.find(source);
+  if (iter == source_output_map_.end()) {
+    return;
+  }
+  iter->second.ready = true;
+  if (source_workers_enabled_ && !iter->second.removing) {
+    StartSourceWorker(source, &iter->second);
+  }
 }
 
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
+  auto find_source = [this, &source_name]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_) {
+    return std::find_if(sources_.begin(), sources_.end(),
+                        [&source_name](const std::unique_ptr<SourceConnector>& s) {
+                          return s->name() == source_name;
+                        });
+  };
+
+  // Stop sampling the source before any of its tables go away. The worker is joined without
+  // holding the lock, since it may need the lock to finish its iteration.
+  std::shared_ptr<SourceWorker> worker;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    auto source_iter = find_source();
+    if (source_iter == sources_.end()) {
+      return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
+    }
+    auto output_iter = source_output_map_.find(source_iter->get());
+    if (output_iter != source_output_map_.end()) {
+      output_iter->second.removing = true;
+      worker = std::move(output_iter->second.worker);
+    }
+  }
+  if (worker != nullptr) {
+    worker->Stop();
+  }
+
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
-  // Find the source.
-  auto source_iter = std::find_if(sources_.begin(), sources_.end(),
-                                  [&source_name](const std::unique_ptr<SourceConnector>& s) {
-                                    return s->name() == source_name;
-                                  });
+  // Find the source again, in case it was removed in the meantime.
+  auto source_iter = find_source();
   if (source_iter == sources_.end()) {
     return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
   }
@@ -618,6 +1025,47 @@ void StirlingImpl::GetPublishProto(stirlingpb::Publish* publish_pb) {
   PopulatePublishProto(publish_pb, info_class_mgrs_);
 }
 
+Status StirlingImpl::SetPushPolicy(std::string_view table_name,
+                                   const DataTablePushPolicy& policy) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (auto& [source, output] : source_output_map_) {
+    for (InfoClassManager* mgr : output.info_class_mgrs) {
+      if (mgr->name() == table_name) {
+        absl::MutexLock source_lock(output.lock.get());
+        mgr->data_table()->set_push_policy(policy);
+        return Status::OK();
+      }
+    }
+  }
+  return error::NotFound("Table $0 not found.", table_name);
+}
+
+Status StirlingImpl::SetSubscribedColumns(std::string_view table_name,
+                                          const std::vector<std::string>& column_names) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (auto& [source, output] : source_output_map_) {
+    for (InfoClassManager* mgr : output.info_class_mgrs) {
+      if (mgr->name() == table_name) {
+        absl::MutexLock source_lock(output.lock.get());
+        return mgr->data_table()->SetSubscribedColumns(column_names);
+      }
+    }
+  }
+  return error::NotFound("Table $0 not found.", table_name);
+}
+
+Status StirlingImpl::SetSocketTraceFilter(const SocketTraceFilter& filter) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (const auto& source : sources_) {
+    auto* socket_tracer = dynamic_cast<SocketTraceConnector*>(source.get());
+    if (socket_tracer != nullptr) {
+      socket_tracer->SetFilter(filter);
+      return Status::OK();
+    }
+  }
+  return error::NotFound("Socket tracer not found.");
+}
+
 // Main call to start the data collection.
 Status StirlingImpl::RunAsThread() {
   if (data_push_callback_ == nullptr) {
@@ -673,25 +1121,18 @@ void StirlingImpl::Run() {
 
 namespace {
 
-static constexpr std::chrono::milliseconds kMinSleepDuration{1};
-static constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
-
 // Helper function: Figure out when to wake up next.
 std::chrono::milliseconds TimeUntilNextTick(
-    const absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map) {
+    const absl::flat_hash_map<SourceConnector*, SourceOutput>& source_output_map) {
   // The amount to sleep depends on when the earliest Source needs to be sampled again.
   // Do this to avoid burning CPU cycles unnecessarily
-  auto now = px::chrono::coarse_steady_clock::now();
-
-  // Worst case, wake-up every so often.
-  // This is important if there are no subscribed info classes, to avoid sleeping eternally.
-  auto wakeup_time = now + kMaxSleepDuration;
+  auto wakeup_time = px::chrono::coarse_steady_clock::time_point::max();
   for (const auto& [source, output] : source_output_map) {
-    wakeup_time = std::min(wakeup_time, source->sampling_freq_mgr().next());
-    wakeup_time = std::min(wakeup_time, source->push_freq_mgr().next());
+    if (output.ready) {
+      wakeup_time = std::min(wakeup_time, NextTickTime(*source));
+    }
   }
-
-  return std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now);
+  return TimeUntil(wakeup_time);
 }
 
 void SleepForDuration(std::chrono::milliseconds sleep_duration) {
@@ -700,25 +1141,6 @@ void SleepForDuration(std::chrono::milliseconds sleep_duration) {
   }
 }
 
-// Returns true if any of the input tables are beyond the threshold.
-bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
-  // Data push threshold, based on percentage of buffer that is filled.
-  constexpr uint32_t kDefaultOccupancyPctThreshold = 100;
-
-  // Data push threshold, based number of records after which a push.
-  constexpr uint32_t kDefaultOccupancyThreshold = 1024;
-
-  for (const auto* data_table : data_tables) {
-    if (static_cast<uint32_t>(100 * data_table->OccupancyPct()) > kDefaultOccupancyPctThreshold) {
-      return true;
-    }
-    if (data_table->Occupancy() > kDefaultOccupancyThreshold) {
-      return true;
-    }
-  }
-  return false;
-}
-
 }  // namespace
 
 // Main Data Collector loop.
@@ -726,19 +1148,38 @@ bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
 // Must run as a thread, so only call from Run() as a thread.
 void StirlingImpl::RunCore() {
   running_ = true;
+  StirlingThreadPlacer().PlaceCurrentThread();
 
   // First initialize each info class manager with context.
   {
     absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
     std::unique_ptr<ConnectorContext> initial_context = GetContext();
-    for (const auto& s : sources_) {
-      s->InitContext(initial_context.get());
+    for (const auto& [source, output] : source_output_map_) {
+      if (output.ready) {
+        source->InitContext(initial_context.get());
+      }
     }
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
+  // The sources that are initialized from now on get a context of their own, see InitSources().
+  {
+    absl::MutexLock lock(&init_mutex_);
+    run_started_ = true;
+  }
+
+  LOG_IF(WARNING, FLAGS_stirling_data_wakeup && !FLAGS_stirling_source_threads)
+      << "--stirling_data_wakeup has no effect without --stirling_source_threads.";
+
+  if (FLAGS_stirling_source_threads) {
+    RunSourceWorkers();
+    running_ = false;
+    return;
+  }
+
   while (run_enable_) {
     auto sleep_duration = std::chrono::milliseconds::zero();
+    px::profiler::ScopedProfileTag profile_tag("stirling");
 
     // Update the context/state on each iteration.
     // Note that if no changes are present, the same pointer will be returned back.
@@ -754,14 +1195,11 @@ void StirlingImpl::RunCore() {
 
       // Run through every SourceConnector and InfoClassManager being managed.
       for (auto& [source, output] : source_output_map_) {
-        // Phase 1: Probe each source for its data.
-        if (source->sampling_freq_mgr().Expired()) {
-          source->TransferData(ctx.get(), output.data_tables);
-        }
-        // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables)) {
-          source->PushData(data_push_callback_, output.data_tables);
+        if (!output.ready) {
+          continue;
         }
+        absl::MutexLock source_lock(output.lock.get());
+        SampleAndPush(source, output.data_tables, ctx.get(), data_push_callback_);
       }
 
       // Figure out how long to sleep.
@@ -773,6 +1211,54 @@ void StirlingImpl::RunCore() {
   running_ = false;
 }
 
+void StirlingImpl::StartSourceWorker(SourceConnector* source, SourceOutput* output) {
+  output->worker = std::make_shared<SourceWorker>(
+      source, output->data_tables, output->lock.get(), [this]() { return GetContext(); },
+      data_push_callback_);
+  output->worker->Start();
+}
+
+void StirlingImpl::RunSourceWorkers() {
+  // How often to check whether Stirling has been asked to stop.
+  constexpr std::chrono::milliseconds kStopPollPeriod{100};
+
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    source_workers_enabled_ = true;
+    for (auto& [source, output] : source_output_map_) {
+      if (output.ready) {
+        StartSourceWorker(source, &output);
+      }
+    }
+  }
+
+  while (run_enable_) {
+    std::this_thread::sleep_for(kStopPollPeriod);
+  }
+
+  // The workers are joined without holding the lock, since they may need it to finish their
+  // iteration. They stay in the output map until then, so that a concurrent RemoveSource() also
+  // waits for them before destroying the tables that they write to.
+  std::vector<std::shared_ptr<SourceWorker>> workers;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    source_workers_enabled_ = false;
+    for (auto& [source, output] : source_output_map_) {
+      if (output.worker != nullptr) {
+        workers.push_back(output.worker);
+      }
+    }
+  }
+  for (auto& worker : workers) {
+    worker->Stop();
+  }
+
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (auto& [source, output] : source_output_map_) {
+    output.worker.reset();
+  }
+}
+
 bool StirlingImpl::IsRunning() const { return running_; }
 
 Status StirlingImpl::WaitUntilRunning(std::chrono::milliseconds timeout) const {
@@ -789,6 +1275,15 @@ Status StirlingImpl::WaitUntilRunning(std::chrono::milliseconds timeout) const {
 }
 
 void StirlingImpl::Stop() {
+  // The source being initialized is finished first, the others are never initialized.
+  {
+    absl::MutexLock lock(&init_mutex_);
+    stop_init_ = true;
+  }
+  if (init_thread_.joinable()) {
+    init_thread_.join();
+  }
+
   run_enable_ = false;
   WaitForStop();
 
@@ -807,22 +1302,34 @@ void StirlingImpl::Stop() {
 void StirlingImpl::SetDebugLevel(int level) {
   // Lock not really required, but compiler is making sure we're safe.
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->SetDebugLevel(level);
+  for (auto& [source, output] : source_output_map_) {
+    if (!output.ready) {
+      continue;
+    }
+    absl::MutexLock source_lock(output.lock.get());
+    source->SetDebugLevel(level);
   }
 }
 
 void StirlingImpl::EnablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->EnablePIDTrace(pid);
+  for (auto& [source, output] : source_output_map_) {
+    if (!output.ready) {
+      continue;
+    }
+    absl::MutexLock source_lock(output.lock.get());
+    source->EnablePIDTrace(pid);
   }
 }
 
 void StirlingImpl::DisablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->DisablePIDTrace(pid);
+  for (auto& [source, output] : source_output_map_) {
+    if (!output.ready) {
+      continue;
+    }
+    absl::MutexLock source_lock(output.lock.get());
+    source->DisablePIDTrace(pid);
   }
 }
 
@@ -22,15 +22,24 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <sole.hpp>
 
 #include "src/common/base/base.h"
+#include "src/stirling/core/data_table.h"
 #include "src/stirling/core/pub_sub_manager.h"
 #include "src/stirling/core/source_registry.h"
 #include "src/stirling/proto/stirling.pb.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/logicalpb/logical.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_filter.h"
+
+DECLARE_bool(stirling_async_source_init);
+DECLARE_bool(stirling_source_threads);
+DECLARE_bool(stirling_data_wakeup);
+DECLARE_string(stirling_upid_tabletized_tables);
+DECLARE_string(stirling_thread_placement);
 
 namespace px {
 namespace stirling {
@@ -132,6 +141,36 @@ class Stirling : public NotCopyable {
    */
   virtual void GetPublishProto(stirlingpb::Publish* publish_pb) = 0;
 
+  /**
+   * Sets the thresholds at which the buffered data of a table is pushed to the agent,
+   * ahead of the push period of its source. Can be called while Stirling is running.
+   * Tables start with the push policy of their DataTableSchema; this overrides it.
+   *
+   * @param table_name Name of the table, as in its DataTableSchema.
+   * @return error::NotFound if no such table exists.
+   */
+  virtual Status SetPushPolicy(std::string_view table_name, const DataTablePushPolicy& policy) = 0;
+
+  /**
+   * Selects the string columns of a table that are collected, so that the sources don't copy
+   * columns that no query reads. The other string columns are left empty. An empty list selects
+   * all columns. Can be called while Stirling is running.
+   *
+   * @param table_name Name of the table, as in its DataTableSchema.
+   * @return error::NotFound if no such table exists, or error::InvalidArgument if it has no
+   *         column of one of the names.
+   */
+  virtual Status SetSubscribedColumns(std::string_view table_name,
+                                      const std::vector<std::string>& column_names) = 0;
+
+  /**
+   * Sets the filter of the data traced by the socket tracer, replacing the previous one.
+   * Can be called while Stirling is running.
+   *
+   * @return error::NotFound if the socket tracer isn't one of the sources.
+   */
+  virtual Status SetSocketTraceFilter(const SocketTraceFilter& filter) = 0;
+
   /**
    * Register call-back from Agent. Used to periodically send data.
    *
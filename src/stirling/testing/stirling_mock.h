@@ -41,6 +41,12 @@ class MockStirling : public Stirling {
   MOCK_METHOD(StatusOr<stirlingpb::Publish>, GetTracepointInfo, (sole::uuid trace_id), (override));
   MOCK_METHOD(Status, RemoveTracepoint, (sole::uuid trace_id), (override));
   MOCK_METHOD(void, GetPublishProto, (stirlingpb::Publish * publish_pb), (override));
+  MOCK_METHOD(Status, SetPushPolicy,
+              (std::string_view table_name, const DataTablePushPolicy& policy), (override));
+  MOCK_METHOD(Status, SetSubscribedColumns,
+              (std::string_view table_name, const std::vector<std::string>& column_names),
+              (override));
+  MOCK_METHOD(Status, SetSocketTraceFilter, (const SocketTraceFilter& filter), (override));
   MOCK_METHOD(void, RegisterDataPushCallback, (DataPushCallback f), (override));
   MOCK_METHOD(void, RegisterAgentMetadataCallback, (AgentMetadataCallback f), (override));
   MOCK_METHOD(void, Run, (), (override));
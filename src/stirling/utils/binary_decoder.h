@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <endian.h>
+
+#include <cstring>
 #include <string_view>
 
 #include "src/common/base/base.h"
@@ -32,6 +35,9 @@ namespace stirling {
 // src/stirling/source_connectors/socket_tracer/protocols/cql/frame_body_decoder.{h,cc}.
 class BinaryDecoder {
  public:
+  // The length of the longest varint, which encodes 64 bits.
+  static constexpr size_t kMaxVarintBytes = 10;
+
   explicit BinaryDecoder(std::string_view buf) : buf_(buf) {}
 
   bool eof() const { return buf_.empty(); }
@@ -60,6 +66,85 @@ class BinaryDecoder {
     return val;
   }
 
+  // Extracts a base-128 varint of at most TMaxBytes bytes, least significant group first, as used
+  // by protobuf and Kafka. The buffer is left as is if the varint can't be extracted.
+  template <size_t TMaxBytes = kMaxVarintBytes>
+  StatusOr<uint64_t> ExtractUnsignedVarint() {
+    static_assert(TMaxBytes > 0 && TMaxBytes <= kMaxVarintBytes);
+    if (buf_.size() >= sizeof(uint64_t)) {
+      // Finds the last byte of the varint among the next 8 bytes with a single load, and gathers
+      // the 7 bit groups without a loop. Longer varints take the bytewise path below.
+      uint64_t word;
+      std::memcpy(&word, buf_.data(), sizeof(word));
+      word = le64toh(word);
+      const uint64_t last_byte_bits = ~word & 0x8080808080808080ULL;
+      if (last_byte_bits != 0) {
+        const size_t len = (__builtin_ctzll(last_byte_bits) + 1) / 8;
+        if (len > TMaxBytes) {
+          return error::Internal("Varint is longer than $0 bytes.", TMaxBytes);
+        }
+        if (len < sizeof(uint64_t)) {
+          word &= (uint64_t{1} << (8 * len)) - 1;
+        }
+        word &= 0x7f7f7f7f7f7f7f7fULL;
+        word = ((word & 0x7f007f007f007f00ULL) >> 1) | (word & 0x007f007f007f007fULL);
+        word = ((word & 0x3fff00003fff0000ULL) >> 2) | (word & 0x00003fff00003fffULL);
+        word = ((word & 0x0fffffff00000000ULL) >> 4) | (word & 0x000000000fffffffULL);
+        buf_.remove_prefix(len);
+        return word;
+      }
+    }
+
+    uint64_t value = 0;
+    for (size_t i = 0; i < TMaxBytes; ++i) {
+      if (i == buf_.size()) {
+        return error::ResourceUnavailable("Insufficient number of bytes.");
+      }
+      const uint64_t b = static_cast<uint8_t>(buf_[i]);
+      value |= (b & 0x7f) << (7 * i);
+      if (!(b & 0x80)) {
+        buf_.remove_prefix(i + 1);
+        return value;
+      }
+    }
+    return error::Internal("Varint is longer than $0 bytes.", TMaxBytes);
+  }
+
+  // Extracts a zigzag encoded signed varint of at most TMaxBytes bytes.
+  template <size_t TMaxBytes = kMaxVarintBytes>
+  StatusOr<int64_t> ExtractVarint() {
+    PL_ASSIGN_OR_RETURN(uint64_t value, ExtractUnsignedVarint<TMaxBytes>());
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+  }
+
+  // The *Unchecked variants skip the bounds check, for callers that checked BufSize() once
+  // up-front for a series of extractions.
+  template <typename TCharType = char>
+  TCharType ExtractCharUnchecked() {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK_GE(buf_.size(), sizeof(TCharType));
+    TCharType res = buf_.front();
+    buf_.remove_prefix(1);
+    return res;
+  }
+
+  template <typename TIntType>
+  TIntType ExtractIntUnchecked() {
+    DCHECK_GE(buf_.size(), sizeof(TIntType));
+    TIntType val = ::px::utils::BEndianBytesToInt<TIntType>(buf_);
+    buf_.remove_prefix(sizeof(TIntType));
+    return val;
+  }
+
+  template <typename TCharType = char>
+  std::basic_string_view<TCharType> ExtractStringUnchecked(size_t len) {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK_GE(buf_.size(), len);
+    auto tbuf = CreateStringView<TCharType>(buf_);
+    buf_.remove_prefix(len);
+    return tbuf.substr(0, len);
+  }
+
   template <typename TCharType = char>
   StatusOr<std::basic_string_view<TCharType>> ExtractString(size_t len) {
     static_assert(sizeof(TCharType) == 1);
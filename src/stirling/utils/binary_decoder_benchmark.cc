@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+#include "src/stirling/utils/binary_decoder.h"
+
+// This benchmark measures the bulk decoding primitives of BinaryDecoder against their checked and
+// bytewise counterparts.
+
+using px::stirling::BinaryDecoder;
+
+namespace {
+
+constexpr int kNumValues = 1024;
+
+// Returns kNumValues varints, of values with up to the given number of bits.
+std::string MakeVarints(int max_bits) {
+  std::mt19937_64 rng(37);
+  std::string buf;
+  for (int i = 0; i < kNumValues; ++i) {
+    uint64_t value = rng() >> (64 - max_bits);
+    do {
+      uint8_t b = value & 0x7f;
+      value >>= 7;
+      if (value != 0) {
+        b |= 0x80;
+      }
+      buf.push_back(b);
+    } while (value != 0);
+  }
+  return buf;
+}
+
+// The bytewise decoding that BinaryDecoder::ExtractUnsignedVarint() replaces.
+px::StatusOr<uint64_t> BytewiseVarint(BinaryDecoder* decoder) {
+  uint64_t value = 0;
+  for (int i = 0; i < 70; i += 7) {
+    PL_ASSIGN_OR_RETURN(uint64_t b, decoder->ExtractChar<uint8_t>());
+    value |= (b & 0x7f) << i;
+    if (!(b & 0x80)) {
+      return value;
+    }
+  }
+  return px::error::Internal("Varint is too long.");
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_BytewiseVarint(benchmark::State& state) {
+  const std::string buf = MakeVarints(state.range(0));
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(BytewiseVarint(&decoder).ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ExtractUnsignedVarint(benchmark::State& state) {
+  const std::string buf = MakeVarints(state.range(0));
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(decoder.ExtractUnsignedVarint().ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ExtractInt(benchmark::State& state) {
+  const std::string buf(kNumValues * sizeof(int64_t), '\x5a');
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(decoder.ExtractInt<int64_t>().ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ExtractIntUnchecked(benchmark::State& state) {
+  const std::string buf(kNumValues * sizeof(int64_t), '\x5a');
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    CHECK_GE(decoder.BufSize(), kNumValues * sizeof(int64_t));
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(decoder.ExtractIntUnchecked<int64_t>());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ExtractString(benchmark::State& state) {
+  const std::string buf(kNumValues * state.range(0), 'a');
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(decoder.ExtractString(state.range(0)).ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ExtractStringUnchecked(benchmark::State& state) {
+  const std::string buf(kNumValues * state.range(0), 'a');
+  for (auto _ : state) {
+    BinaryDecoder decoder(buf);
+    CHECK_GE(decoder.BufSize(), static_cast<size_t>(kNumValues * state.range(0)));
+    for (int i = 0; i < kNumValues; ++i) {
+      benchmark::DoNotOptimize(decoder.ExtractStringUnchecked(state.range(0)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// Value widths of one byte varints, Kafka varints (int32) and varlongs of 8 and 10 bytes.
+BENCHMARK(BM_BytewiseVarint)->Arg(7)->Arg(32)->Arg(56)->Arg(64);
+BENCHMARK(BM_ExtractUnsignedVarint)->Arg(7)->Arg(32)->Arg(56)->Arg(64);
+BENCHMARK(BM_ExtractInt);
+BENCHMARK(BM_ExtractIntUnchecked);
+BENCHMARK(BM_ExtractString)->Arg(16);
+BENCHMARK(BM_ExtractStringUnchecked)->Arg(16);
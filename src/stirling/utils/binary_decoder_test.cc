@@ -51,6 +51,60 @@ TEST(BinaryDecoderTest, ExtractInt) {
   EXPECT_EQ(0, bin_decoder.BufSize());
 }
 
+TEST(BinaryDecoderTest, ExtractUnsignedVarint) {
+  // Varints of the fast path (8 or more bytes in the buffer) and of the bytewise path.
+  std::string data("\x96\x01\x00\xff\xff\xff\xff\x0f\x80\x80\x80\x80\x80\x80\x80\x80\x80\x01"
+                   "\x03",
+                   19);
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint(), 150ULL);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint(), 0ULL);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint(), 0xffffffffULL);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint(), 1ULL << 63);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint(), 3ULL);
+  EXPECT_EQ(0, bin_decoder.BufSize());
+}
+
+TEST(BinaryDecoderTest, ExtractUnsignedVarintErrors) {
+  // Truncated varints leave the buffer as is.
+  std::string_view truncated("\x80\x80");
+  BinaryDecoder bin_decoder(truncated);
+  EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint());
+  EXPECT_EQ(2, bin_decoder.BufSize());
+
+  // As do varints longer than the maximum length, in both paths.
+  std::string_view too_long("\xff\xff\xff\xff\xff\x01");
+  bin_decoder.SetBuf(too_long);
+  EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint<5>());
+  EXPECT_EQ(6, bin_decoder.BufSize());
+  std::string padded = std::string(too_long) + std::string(8, '\0');
+  bin_decoder.SetBuf(padded);
+  EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint<5>());
+  EXPECT_EQ(14, bin_decoder.BufSize());
+}
+
+TEST(BinaryDecoderTest, ExtractVarint) {
+  std::string_view data("\x01\x02\xff\x7f");
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint(), -1);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint(), 1);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint(), -8192);
+  EXPECT_EQ(0, bin_decoder.BufSize());
+}
+
+TEST(BinaryDecoderTest, ExtractUnchecked) {
+  std::string_view data("\x01\x00\x02" "abc", 6);
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_GE(bin_decoder.BufSize(), 6U);
+  EXPECT_EQ(bin_decoder.ExtractCharUnchecked(), 1);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<int16_t>(), 2);
+  EXPECT_EQ(bin_decoder.ExtractStringUnchecked(3), "abc");
+  EXPECT_EQ(0, bin_decoder.BufSize());
+}
+
 TEST(BinaryDecoderTest, ExtractString) {
   std::string_view data("abc123");
   BinaryDecoder bin_decoder(data);
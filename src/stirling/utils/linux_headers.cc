@@ -22,15 +22,23 @@
 #include <link.h>
 #include <sys/auxv.h>
 #include <sys/utsname.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <sstream>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include <absl/strings/match.h>
 #include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_replace.h>
+#include <absl/strings/strip.h>
 
 #include "src/common/base/file.h"
 #include "src/common/fs/fs_wrapper.h"
@@ -470,20 +478,94 @@ Status LinkHostLinuxHeaders(const std::filesystem::path& lib_modules_dir) {
   return Status::OK();
 }
 
+namespace {
+
+// Written into an extracted headers directory once it's fully prepared, with the stamp of the
+// package and kernel it was prepared for. A restarted PEM reuses the directory if it matches.
+constexpr char kHeadersStampFile[] = ".pl_headers_stamp";
+
+// The number of threads that write out the extracted headers.
+constexpr int kMaxHeaderWriterThreads = 4;
+
+std::string ExtractedHeadersDir(const KernelVersion& version) {
+  return absl::Substitute("/usr/src/linux-headers-$0.$1.$2-pl", version.version, version.major_rev,
+                          version.minor_rev);
+}
+
+StatusOr<std::string> PackagedHeadersStamp(const std::filesystem::path& package,
+                                           uint32_t kernel_version_code) {
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(package.string()));
+  uLong checksum = crc32(0L, Z_NULL, 0);
+  checksum = crc32(checksum, reinterpret_cast<const Bytef*>(contents.data()), contents.size());
+  return absl::Substitute("$0 $1 $2", package.string(), checksum, kernel_version_code);
+}
+
+// The name of the kernel's arch directory for the machine we run on, or empty if unknown.
+std::string_view KernelArchDir() {
+  struct utsname buffer;
+  if (uname(&buffer) != 0) {
+    return {};
+  }
+  std::string_view machine = buffer.machine;
+  if (machine == "x86_64") {
+    return "x86";
+  }
+  if (machine == "aarch64") {
+    return "arm64";
+  }
+  return {};
+}
+
+// Returns an extraction filter that skips the parts of the headers tree BPF programs can't use:
+// the directories of other architectures, and everything under arch/<arch> but its include
+// directory. Entries outside of headers_dir are always extracted.
+std::function<bool(std::string_view)> PackagedHeadersFilter(std::string_view headers_dir) {
+  std::string arch(KernelArchDir());
+  if (arch.empty()) {
+    return nullptr;
+  }
+  std::string prefix = absl::StrCat(absl::StripPrefix(headers_dir, "/"), "/");
+  return [prefix = std::move(prefix), arch = std::move(arch)](std::string_view path) {
+    path = absl::StripPrefix(path, "./");
+    if (!absl::ConsumePrefix(&path, prefix) || !absl::ConsumePrefix(&path, "arch/")) {
+      return true;
+    }
+    path = absl::StripSuffix(path, "/");
+    if (path.empty()) {
+      return true;
+    }
+    if (!absl::ConsumePrefix(&path, arch)) {
+      return false;
+    }
+    return path.empty() || path == "/include" || absl::StartsWith(path, "/include/");
+  };
+}
+
+}  // namespace
+
 Status ExtractPackagedHeaders(PackagedLinuxHeadersSpec* headers_package) {
-  std::string expected_directory =
-      absl::Substitute("/usr/src/linux-headers-$0.$1.$2-pl", headers_package->version.version,
-                       headers_package->version.major_rev, headers_package->version.minor_rev);
+  std::string expected_directory = ExtractedHeadersDir(headers_package->version);
 
-  // This is a loose check that we don't clobber what we *think* should the output directory.
-  // If someone built a tar.gz with an incorrect directory structure, this check wouldn't save us.
+  // A directory left behind by an earlier attempt that didn't finish (or that was prepared for
+  // another kernel) can't be trusted, so start over.
   if (fs::Exists(expected_directory).ok()) {
-    return error::Internal("Refusing to clobber existing directory");
+    LOG(INFO) << absl::Substitute("Removing stale headers directory $0", expected_directory);
+    std::error_code ec;
+    std::filesystem::remove_all(expected_directory, ec);
+    if (ec) {
+      return error::Internal("Could not remove stale headers directory $0: $1",
+                             expected_directory, ec.message());
+    }
   }
 
-  // Extract the files.
+  // Extract the files. The archive is decompressed as a single stream, but the files are written
+  // out by a few threads, which is where most of the time goes.
+  tools::ExtractOptions options;
+  options.filter = PackagedHeadersFilter(expected_directory);
+  const int num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+  options.num_writer_threads = num_cpus > 1 ? std::min(kMaxHeaderWriterThreads, num_cpus - 1) : 0;
   ::px::tools::Minitar minitar(headers_package->path.string());
-  PL_RETURN_IF_ERROR(minitar.Extract("/"));
+  PL_RETURN_IF_ERROR(minitar.Extract("/", ARCHIVE_EXTRACT_TIME, options));
 
   // Update the path to the extracted copy.
   headers_package->path = expected_directory;
@@ -566,9 +648,22 @@ Status InstallPackagedLinuxHeaders(const std::filesystem::path& lib_modules_dir)
   PL_ASSIGN_OR_RETURN(PackagedLinuxHeadersSpec packaged_headers,
                       FindClosestPackagedLinuxHeaders(kPackagedHeadersRoot, kernel_version));
   LOG(INFO) << absl::Substitute("Using packaged header: $0", packaged_headers.path.string());
-  PL_RETURN_IF_ERROR(ExtractPackagedHeaders(&packaged_headers));
-  PL_RETURN_IF_ERROR(ModifyKernelVersion(packaged_headers.path, kernel_version.code()));
-  PL_RETURN_IF_ERROR(ApplyConfigPatches(packaged_headers.path));
+
+  PL_ASSIGN_OR_RETURN(std::string stamp,
+                      PackagedHeadersStamp(packaged_headers.path, kernel_version.code()));
+  const std::filesystem::path extracted_dir = ExtractedHeadersDir(packaged_headers.version);
+  const std::filesystem::path stamp_file = extracted_dir / kHeadersStampFile;
+  StatusOr<std::string> existing_stamp = ReadFileToString(stamp_file.string());
+  if (existing_stamp.ok() && existing_stamp.ValueOrDie() == stamp) {
+    LOG(INFO) << absl::Substitute("Reusing previously extracted headers at $0",
+                                  extracted_dir.string());
+    packaged_headers.path = extracted_dir;
+  } else {
+    PL_RETURN_IF_ERROR(ExtractPackagedHeaders(&packaged_headers));
+    PL_RETURN_IF_ERROR(ModifyKernelVersion(packaged_headers.path, kernel_version.code()));
+    PL_RETURN_IF_ERROR(ApplyConfigPatches(packaged_headers.path));
+    PL_RETURN_IF_ERROR(WriteFileFromString(stamp_file.string(), stamp));
+  }
   PL_RETURN_IF_ERROR(fs::CreateSymlinkIfNotExists(packaged_headers.path, lib_modules_build_dir));
   LOG(INFO) << absl::Substitute("Successfully installed packaged copy of headers at $0",
                                 lib_modules_build_dir.string());
@@ -39,5 +39,79 @@ void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids) {
   upids_ = std::move(upids);
 }
 
+void ProcTracker::Update(const absl::flat_hash_set<md::UPID>& upids,
+                         ProcEventLogPosition position) {
+  if (position.log != nullptr && position.log == position_.log &&
+      position.version >= position_.version) {
+    absl::flat_hash_set<md::UPID> started;
+    absl::flat_hash_set<md::UPID> exited;
+    if (position.log->GetEvents(position_.version, position.version, &started, &exited)) {
+      for (const auto& upid : exited) {
+        upids_.erase(upid);
+      }
+      upids_.insert(started.begin(), started.end());
+      new_upids_ = std::move(started);
+      deleted_upids_ = std::move(exited);
+      position_ = position;
+      return;
+    }
+  }
+
+  Update(upids);
+  position_ = position;
+}
+
+ProcEventLogPosition ProcEventLog::Update(
+    std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids) {
+  DCHECK(upids != nullptr);
+  absl::MutexLock lock(&mutex_);
+  if (upids == upids_) {
+    return {this, version_};
+  }
+
+  Entry entry;
+  for (const auto& upid : *upids) {
+    if (!upids_->contains(upid)) {
+      entry.started.push_back(upid);
+    }
+  }
+  for (const auto& upid : *upids_) {
+    if (!upids->contains(upid)) {
+      entry.exited.push_back(upid);
+    }
+  }
+  upids_ = std::move(upids);
+
+  if (!entry.started.empty() || !entry.exited.empty()) {
+    entries_.push_back(std::move(entry));
+    ++version_;
+    if (entries_.size() > max_retained_updates_) {
+      entries_.pop_front();
+    }
+  }
+  return {this, version_};
+}
+
+bool ProcEventLog::GetEvents(uint64_t from, uint64_t to, absl::flat_hash_set<md::UPID>* started,
+                             absl::flat_hash_set<md::UPID>* exited) const {
+  absl::MutexLock lock(&mutex_);
+  // The version before the oldest retained change.
+  const uint64_t oldest_version = version_ - entries_.size();
+  if (from < oldest_version || from > to || to > version_) {
+    return false;
+  }
+
+  for (uint64_t version = from + 1; version <= to; ++version) {
+    const Entry& entry = entries_[version - oldest_version - 1];
+    started->insert(entry.started.begin(), entry.started.end());
+    for (const auto& upid : entry.exited) {
+      if (started->erase(upid) == 0) {
+        exited->insert(upid);
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -18,7 +18,13 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/system/proc_parser.h"
 #include "src/shared/upid/upid.h"
@@ -26,6 +32,61 @@
 namespace px {
 namespace stirling {
 
+class ProcEventLog;
+
+/**
+ * A version of the set of UPIDs recorded by a ProcEventLog.
+ */
+struct ProcEventLogPosition {
+  const ProcEventLog* log = nullptr;
+  uint64_t version = 0;
+};
+
+/**
+ * ProcEventLog records the processes that started and exited between consecutive sets of UPIDs.
+ * Stirling updates it once for every context it creates, so that the ProcTrackers of the source
+ * connectors read the changes from it, instead of each diffing the full sets of UPIDs.
+ *
+ * Only the most recent updates are retained. Thread-safe.
+ */
+class ProcEventLog : NotCopyMoveable {
+ public:
+  static constexpr size_t kDefaultMaxRetainedUpdates = 64;
+
+  explicit ProcEventLog(size_t max_retained_updates = kDefaultMaxRetainedUpdates)
+      : max_retained_updates_(max_retained_updates) {}
+
+  /**
+   * Records the processes that started and exited since the previous set of UPIDs. The version
+   * only changes if any did. Updating with the same set again doesn't diff it.
+   * @return The position of the set in the log.
+   */
+  ProcEventLogPosition Update(std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids);
+
+  /**
+   * Adds the processes that started and exited after version `from`, up to version `to`.
+   * Processes that both started and exited in between are in neither.
+   * @return false, and leaves the sets untouched, if the log no longer retains the changes.
+   */
+  bool GetEvents(uint64_t from, uint64_t to, absl::flat_hash_set<md::UPID>* started,
+                 absl::flat_hash_set<md::UPID>* exited) const;
+
+ private:
+  struct Entry {
+    std::vector<md::UPID> started;
+    std::vector<md::UPID> exited;
+  };
+
+  const size_t max_retained_updates_;
+
+  mutable absl::Mutex mutex_;
+  std::shared_ptr<const absl::flat_hash_set<md::UPID>> upids_ ABSL_GUARDED_BY(mutex_) =
+      std::make_shared<const absl::flat_hash_set<md::UPID>>();
+  uint64_t version_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The changes that resulted in the versions up to version_, oldest first.
+  std::deque<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
 /**
  * Keeps a list of UPIDs. Tracks newly-created and terminated processes each time an update is
  * provided, and updates its internal list of UPIDs.
@@ -38,6 +99,14 @@ class ProcTracker : NotCopyMoveable {
    */
   void Update(absl::flat_hash_set<md::UPID> upids);
 
+  /**
+   * Same as above, but reads the processes that started and exited since the previous update from
+   * the log, rather than diffing the sets. Falls back to diffing if the log doesn't have them.
+   * @param upids Current set of UPIDs.
+   * @param position The position of upids in the log, if any.
+   */
+  void Update(const absl::flat_hash_set<md::UPID>& upids, ProcEventLogPosition position);
+
   /**
    * Returns all current upids, as set by last call to Update().
    */
@@ -57,6 +126,7 @@ class ProcTracker : NotCopyMoveable {
   absl::flat_hash_set<md::UPID> upids_;
   absl::flat_hash_set<md::UPID> new_upids_;
   absl::flat_hash_set<md::UPID> deleted_upids_;
+  ProcEventLogPosition position_;
 };
 
 }  // namespace stirling
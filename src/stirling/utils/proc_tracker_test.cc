@@ -21,20 +21,23 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <utility>
+
 namespace px {
 namespace stirling {
 
 using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
 
+using UPIDSet = absl::flat_hash_set<md::UPID>;
+
 class ProcTrackerTest : public ::testing::Test {
  protected:
   ProcTracker proc_tracker_;
 };
 
 TEST_F(ProcTrackerTest, Basic) {
-  using UPIDSet = absl::flat_hash_set<md::UPID>;
-
   const md::UPID kUPID1 = md::UPID(0, 1, 111);
   const md::UPID kUPID2 = md::UPID(0, 2, 222);
   const md::UPID kUPID3 = md::UPID(0, 3, 333);
@@ -61,5 +64,88 @@ TEST_F(ProcTrackerTest, Basic) {
   EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID3));
 }
 
+TEST(ProcEventLogTest, GetEvents) {
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+  const md::UPID kUPID3 = md::UPID(0, 3, 333);
+
+  ProcEventLog log(/* max_retained_updates */ 2);
+  auto upids = std::make_shared<const UPIDSet>(UPIDSet{kUPID1, kUPID2});
+  ProcEventLogPosition position1 = log.Update(upids);
+  EXPECT_EQ(position1.log, &log);
+  EXPECT_EQ(position1.version, 1U);
+
+  // Sets without changes don't change the version.
+  EXPECT_EQ(log.Update(upids).version, 1U);
+  EXPECT_EQ(log.Update(std::make_shared<const UPIDSet>(*upids)).version, 1U);
+
+  ProcEventLogPosition position2 = log.Update(std::make_shared<const UPIDSet>(UPIDSet{kUPID1}));
+  ProcEventLogPosition position3 =
+      log.Update(std::make_shared<const UPIDSet>(UPIDSet{kUPID1, kUPID3}));
+  EXPECT_EQ(position2.version, 2U);
+  EXPECT_EQ(position3.version, 3U);
+
+  UPIDSet started;
+  UPIDSet exited;
+  ASSERT_TRUE(log.GetEvents(1, 3, &started, &exited));
+  EXPECT_THAT(started, UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(exited, UnorderedElementsAre(kUPID2));
+
+  started.clear();
+  exited.clear();
+  ASSERT_TRUE(log.GetEvents(2, 2, &started, &exited));
+  EXPECT_THAT(started, IsEmpty());
+  EXPECT_THAT(exited, IsEmpty());
+
+  // Processes that started and exited in between are left out.
+  log.Update(std::make_shared<const UPIDSet>(UPIDSet{kUPID1}));
+  ASSERT_TRUE(log.GetEvents(2, 4, &started, &exited));
+  EXPECT_THAT(started, IsEmpty());
+  EXPECT_THAT(exited, IsEmpty());
+
+  // The first updates are no longer retained.
+  EXPECT_FALSE(log.GetEvents(1, 4, &started, &exited));
+  EXPECT_FALSE(log.GetEvents(0, 1, &started, &exited));
+  EXPECT_FALSE(log.GetEvents(4, 5, &started, &exited));
+}
+
+TEST_F(ProcTrackerTest, UpdateFromProcEventLog) {
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+  const md::UPID kUPID3 = md::UPID(0, 3, 333);
+  const md::UPID kUPID4 = md::UPID(0, 4, 444);
+
+  ProcEventLog log(/* max_retained_updates */ 2);
+  auto update = [&](UPIDSet upids) {
+    auto upids_ptr = std::make_shared<const UPIDSet>(std::move(upids));
+    proc_tracker_.Update(*upids_ptr, log.Update(upids_ptr));
+  };
+
+  // The first update diffs the sets.
+  update(UPIDSet{kUPID1, kUPID2});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1, kUPID2));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1, kUPID2));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), IsEmpty());
+
+  update(UPIDSet{kUPID1, kUPID3});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1, kUPID3));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID2));
+
+  update(UPIDSet{kUPID1, kUPID3});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1, kUPID3));
+  EXPECT_THAT(proc_tracker_.new_upids(), IsEmpty());
+  EXPECT_THAT(proc_tracker_.deleted_upids(), IsEmpty());
+
+  // Falls back to diffing the sets once the log moved on too far.
+  for (const auto& upids : {UPIDSet{kUPID1}, UPIDSet{kUPID2}, UPIDSet{kUPID1, kUPID4}}) {
+    log.Update(std::make_shared<const UPIDSet>(upids));
+  }
+  update(UPIDSet{kUPID4});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID4));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID4));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1, kUPID3));
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Slab allocates objects in pages of TPageSize slots, so that the objects stay close to each other
+ * in memory, and never move. Freed slots are reused for the next objects, most recently freed
+ * first. Pages are kept until the slab is destroyed.
+ *
+ * Objects are referred to by a Handle, which holds the index of their slot and the generation of
+ * the slot. The generation changes every time a slot is freed, so a handle to a destroyed object
+ * resolves to nullptr rather than to the object that took over its slot.
+ */
+template <typename T, size_t TPageSize = 64>
+class Slab {
+ public:
+  struct Handle {
+    static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = kInvalidIndex;
+    uint32_t generation = 0;
+
+    bool operator==(const Handle& other) const {
+      return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+  };
+
+  Slab() = default;
+  Slab(const Slab&) = delete;
+  Slab& operator=(const Slab&) = delete;
+
+  ~Slab() {
+    for (uint32_t i = 0; i < pages_.size() * TPageSize; ++i) {
+      Slot& slot = SlotAt(i);
+      if (slot.live) {
+        slot.object()->~T();
+      }
+    }
+  }
+
+  /**
+   * Default constructs a new object in a free slot.
+   */
+  std::pair<Handle, T*> Create() {
+    if (free_slots_.empty()) {
+      AddPage();
+    }
+    uint32_t index = free_slots_.back();
+    free_slots_.pop_back();
+
+    Slot& slot = SlotAt(index);
+    DCHECK(!slot.live);
+    T* object = new (slot.storage) T();
+    slot.live = true;
+    ++size_;
+    return {Handle{index, slot.generation}, object};
+  }
+
+  /**
+   * @return the object of the handle, or nullptr if it was destroyed.
+   */
+  T* Get(Handle handle) const {
+    if (handle.index >= pages_.size() * TPageSize) {
+      return nullptr;
+    }
+    Slot& slot = SlotAt(handle.index);
+    if (!slot.live || slot.generation != handle.generation) {
+      return nullptr;
+    }
+    return slot.object();
+  }
+
+  /**
+   * Destroys the object of the handle, and frees its slot. Does nothing if it was destroyed.
+   */
+  void Destroy(Handle handle) {
+    if (Get(handle) == nullptr) {
+      return;
+    }
+    Slot& slot = SlotAt(handle.index);
+    slot.object()->~T();
+    slot.live = false;
+    ++slot.generation;
+    --size_;
+    free_slots_.push_back(handle.index);
+  }
+
+  // The number of live objects.
+  size_t size() const { return size_; }
+
+  // The number of slots, live or free.
+  size_t capacity() const { return pages_.size() * TPageSize; }
+
+ private:
+  struct Slot {
+    alignas(T) unsigned char storage[sizeof(T)];
+    uint32_t generation = 0;
+    bool live = false;
+
+    T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  Slot& SlotAt(uint32_t index) const { return pages_[index / TPageSize][index % TPageSize]; }
+
+  void AddPage() {
+    CHECK_LT(capacity() + TPageSize, Handle::kInvalidIndex) << "Slab is full.";
+    pages_.push_back(std::make_unique<Slot[]>(TPageSize));
+    // Pushed in reverse, so that the slots of the page are used in order.
+    const uint32_t first_index = capacity() - TPageSize;
+    for (uint32_t i = TPageSize; i > 0; --i) {
+      free_slots_.push_back(first_index + i - 1);
+    }
+  }
+
+  std::vector<std::unique_ptr<Slot[]>> pages_;
+  std::vector<uint32_t> free_slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+#include "src/stirling/utils/slab.h"
+
+namespace px {
+namespace stirling {
+
+struct TestObject {
+  TestObject() { ++num_live; }
+  ~TestObject() { --num_live; }
+
+  std::string str = "uninitialized";
+  int value = -1;
+
+  static inline int num_live = 0;
+};
+
+using TestSlab = Slab<TestObject, /* TPageSize */ 4>;
+
+TEST(SlabTest, CreateGetDestroy) {
+  TestSlab slab;
+
+  auto [handle, obj] = slab.Create();
+  obj->str = "something";
+  obj->value = 42;
+  EXPECT_EQ(slab.Get(handle), obj);
+  EXPECT_EQ(slab.size(), 1);
+
+  slab.Destroy(handle);
+  EXPECT_EQ(slab.Get(handle), nullptr);
+  EXPECT_EQ(slab.size(), 0);
+  EXPECT_EQ(TestObject::num_live, 0);
+
+  // Destroying a stale handle does nothing.
+  slab.Destroy(handle);
+  EXPECT_EQ(slab.size(), 0);
+}
+
+TEST(SlabTest, StaleHandlesDontResolveToReusedSlots) {
+  TestSlab slab;
+
+  auto [handle1, obj1] = slab.Create();
+  obj1->value = 42;
+  slab.Destroy(handle1);
+
+  // The slot is reused, and the object is initialized fresh.
+  auto [handle2, obj2] = slab.Create();
+  EXPECT_EQ(obj2, obj1);
+  EXPECT_EQ(obj2->str, "uninitialized");
+  EXPECT_EQ(obj2->value, -1);
+
+  EXPECT_EQ(handle2.index, handle1.index);
+  EXPECT_NE(handle2, handle1);
+  EXPECT_EQ(slab.Get(handle1), nullptr);
+  EXPECT_EQ(slab.Get(handle2), obj2);
+
+  slab.Destroy(handle2);
+}
+
+TEST(SlabTest, GrowsByPagesWithoutMovingObjects) {
+  TestSlab slab;
+
+  std::vector<TestSlab::Handle> handles;
+  std::vector<TestObject*> ptrs;
+  for (int i = 0; i < 10; ++i) {
+    auto [handle, obj] = slab.Create();
+    obj->value = i;
+    handles.push_back(handle);
+    ptrs.push_back(obj);
+  }
+  EXPECT_EQ(slab.size(), 10);
+  EXPECT_EQ(slab.capacity(), 12);
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(slab.Get(handles[i]), ptrs[i]);
+    EXPECT_EQ(ptrs[i]->value, i);
+  }
+
+  EXPECT_EQ(slab.Get(TestSlab::Handle{}), nullptr);
+  EXPECT_EQ(slab.Get(TestSlab::Handle{100, 0}), nullptr);
+}
+
+TEST(SlabTest, DestroysLiveObjects) {
+  {
+    TestSlab slab;
+    for (int i = 0; i < 6; ++i) {
+      slab.Create();
+    }
+    slab.Destroy(TestSlab::Handle{2, 0});
+    EXPECT_EQ(TestObject::num_live, 5);
+  }
+  EXPECT_EQ(TestObject::num_live, 0);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace stirling {
+
+/**
+ * TimerWheel is a hierarchical timer wheel, which hands back items once their expiry tick
+ * is reached. Scheduling an item and expiring it are both O(1), amortized, so that advancing
+ * the wheel costs only as much as the items that expire.
+ *
+ * Level 0 holds the items that expire within the next kNumSlots ticks, one slot per tick.
+ * Each higher level covers kNumSlots times the range of the level below it. Items of a higher
+ * level cascade down to the lower levels as their expiry approaches.
+ */
+template <typename T>
+class TimerWheel {
+ public:
+  /**
+   * Schedules the item to expire at the specified tick.
+   * Ticks that have already been reached expire on the next call to Advance().
+   */
+  void Schedule(uint64_t tick, T item) {
+    ++size_;
+    Insert({tick > now_ ? tick : now_ + 1, std::move(item)});
+  }
+
+  /**
+   * Advances the wheel by one tick, and appends the items that expire to expired.
+   */
+  void Advance(std::vector<T>* expired) {
+    ++now_;
+
+    // Cascade the slots of the higher levels that the new tick has wrapped into.
+    // Their entries all land in lower levels, or expire right away.
+    for (int level = kNumLevels - 1; level > 0; --level) {
+      if ((now_ & ((uint64_t{1} << (kSlotBits * level)) - 1)) != 0) {
+        continue;
+      }
+      if (level == kNumLevels - 1) {
+        Cascade(&overflow_, expired);
+      }
+      Cascade(&slots_[level][SlotIndex(now_, level)], expired);
+    }
+
+    std::vector<Entry>& slot = slots_[0][SlotIndex(now_, 0)];
+    for (Entry& entry : slot) {
+      expired->push_back(std::move(entry.item));
+    }
+    size_ -= slot.size();
+    slot.clear();
+  }
+
+  /**
+   * The last tick that the wheel was advanced to.
+   */
+  uint64_t now() const { return now_; }
+
+  /**
+   * The number of scheduled items that haven't expired yet.
+   */
+  size_t size() const { return size_; }
+
+ private:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kNumSlots = 1 << kSlotBits;
+  static constexpr int kNumLevels = 4;
+
+  struct Entry {
+    uint64_t tick;
+    T item;
+  };
+
+  static size_t SlotIndex(uint64_t tick, int level) {
+    return (tick >> (kSlotBits * level)) & (kNumSlots - 1);
+  }
+
+  // Entries go to the lowest level where their tick and now_ agree on all the higher bits.
+  // This places them in a slot that is strictly ahead of the current slot of that level.
+  void Insert(Entry entry) {
+    for (int level = 0; level < kNumLevels; ++level) {
+      int shift = kSlotBits * (level + 1);
+      if ((entry.tick >> shift) == (now_ >> shift)) {
+        slots_[level][SlotIndex(entry.tick, level)].push_back(std::move(entry));
+        return;
+      }
+    }
+    // Beyond the range of the wheel. Revisited whenever the top level wraps around.
+    overflow_.push_back(std::move(entry));
+  }
+
+  void Cascade(std::vector<Entry>* slot, std::vector<T>* expired) {
+    std::vector<Entry> entries = std::move(*slot);
+    slot->clear();
+    for (Entry& entry : entries) {
+      if (entry.tick == now_) {
+        expired->push_back(std::move(entry.item));
+        --size_;
+      } else {
+        Insert(std::move(entry));
+      }
+    }
+  }
+
+  std::array<std::array<std::vector<Entry>, kNumSlots>, kNumLevels> slots_;
+  std::vector<Entry> overflow_;
+  uint64_t now_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
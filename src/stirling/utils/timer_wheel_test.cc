@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+#include "src/stirling/utils/timer_wheel.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+TEST(TimerWheelTest, ExpiresAtTick) {
+  TimerWheel<int> wheel;
+  wheel.Schedule(2, 2);
+  wheel.Schedule(1, 1);
+  wheel.Schedule(2, 20);
+  EXPECT_EQ(wheel.size(), 3);
+
+  std::vector<int> expired;
+  wheel.Advance(&expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+
+  expired.clear();
+  wheel.Advance(&expired);
+  EXPECT_THAT(expired, UnorderedElementsAre(2, 20));
+  EXPECT_EQ(wheel.size(), 0);
+
+  expired.clear();
+  wheel.Advance(&expired);
+  EXPECT_THAT(expired, IsEmpty());
+}
+
+TEST(TimerWheelTest, PastTicksExpireNext) {
+  TimerWheel<int> wheel;
+  std::vector<int> expired;
+  wheel.Advance(&expired);
+  wheel.Advance(&expired);
+  ASSERT_EQ(wheel.now(), 2);
+
+  wheel.Schedule(0, 0);
+  wheel.Schedule(2, 2);
+  wheel.Advance(&expired);
+  EXPECT_THAT(expired, UnorderedElementsAre(0, 2));
+}
+
+// Schedules items across all the levels of the wheel, and beyond, and checks that each expires
+// exactly at its tick.
+TEST(TimerWheelTest, CascadesAcrossLevels) {
+  std::default_random_engine rng(37);
+  std::uniform_int_distribution<uint64_t> delay_dist(1, 1 << 25);
+
+  TimerWheel<uint64_t> wheel;
+  std::multimap<uint64_t, uint64_t> expected;
+  for (uint64_t tick : {uint64_t{63}, uint64_t{64}, uint64_t{4095}, uint64_t{4096},
+                        uint64_t{1} << 18, uint64_t{1} << 24, (uint64_t{1} << 24) + 1}) {
+    wheel.Schedule(tick, tick);
+    expected.emplace(tick, tick);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t tick = delay_dist(rng);
+    wheel.Schedule(tick, tick);
+    expected.emplace(tick, tick);
+  }
+
+  std::vector<uint64_t> expired;
+  while (!expected.empty()) {
+    expired.clear();
+    wheel.Advance(&expired);
+    for (uint64_t tick : expired) {
+      ASSERT_EQ(tick, wheel.now());
+      auto iter = expected.find(tick);
+      ASSERT_TRUE(iter != expected.end());
+      expected.erase(iter);
+    }
+    ASSERT_TRUE(expected.empty() || expected.begin()->first > wheel.now());
+  }
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+}  // namespace stirling
+}  // namespace px
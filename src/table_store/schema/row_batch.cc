@@ -18,8 +18,11 @@
 
 #include <arrow/array.h>
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_format.h>
@@ -120,13 +123,15 @@ constexpr const auto& GetPBDataColumn(const table_store::schemapb::Column& data_
 }
 
 template <DataType T>
-void CopyIntoOutputPB(table_store::schemapb::Column* output_column, arrow::Array* input_column) {
+void CopyIntoOutputPB(const RowBatch& rb, table_store::schemapb::Column* output_column,
+                      arrow::Array* input_column) {
   CHECK_NOTNULL(input_column);
   CHECK_NOTNULL(output_column);
 
-  size_t col_length = input_column->length();
+  size_t col_length = rb.num_selected_rows();
   auto casted_output_data = GetMutablePBDataColumn<T>(output_column);
-  for (size_t i = 0; i < col_length; ++i) {
+  for (size_t idx = 0; idx < col_length; ++idx) {
+    auto i = rb.SelectedRowIndex(idx);
     if constexpr (T == DataType::UINT128) {
       auto out_datum = casted_output_data->add_data();
       auto val = types::GetValueFromArrowArray<DataType::UINT128>(input_column, i);
@@ -158,8 +163,49 @@ Status CopyFromInputPB(std::shared_ptr<arrow::Array>* output_column,
   return Status::OK();
 }
 
+// An arrow buffer that owns the repeated field it points into, so that the numeric columns of a
+// proto can be moved into arrow arrays without copying them. The field is swapped out of the
+// proto, which doesn't copy it as long as the proto isn't on an arena.
+template <typename TValue>
+class RepeatedFieldBuffer : public arrow::Buffer {
+ public:
+  explicit RepeatedFieldBuffer(google::protobuf::RepeatedField<TValue>* field)
+      : arrow::Buffer(nullptr, 0) {
+    field_.Swap(field);
+    data_ = reinterpret_cast<const uint8_t*>(field_.data());
+    size_ = static_cast<int64_t>(field_.size() * sizeof(TValue));
+    capacity_ = size_;
+  }
+
+ private:
+  google::protobuf::RepeatedField<TValue> field_;
+};
+
+template <DataType T>
+Status MoveFromInputPB(std::shared_ptr<arrow::Array>* output_column,
+                       table_store::schemapb::Column* input_column) {
+  if constexpr (T == DataType::INT64 || T == DataType::TIME64NS || T == DataType::FLOAT64) {
+    // The repeated values are laid out like the values of the arrow array, so they back it as is.
+    auto* values = GetMutablePBDataColumn<T>(input_column)->mutable_data();
+    if (values->empty()) {
+      return CopyFromInputPB<T>(output_column, *input_column);
+    }
+    using ArrowType = typename types::DataTypeTraits<T>::arrow_type;
+    using PBType = typename std::remove_pointer_t<decltype(values)>::value_type;
+    static_assert(sizeof(PBType) == sizeof(typename ArrowType::c_type));
+    int64_t num_rows = values->size();
+    auto data_buffer = std::make_shared<RepeatedFieldBuffer<PBType>>(values);
+    *output_column = arrow::MakeArray(arrow::ArrayData::Make(
+        std::make_shared<ArrowType>(), num_rows, {nullptr, data_buffer}, /* null_count */ 0));
+    return Status::OK();
+  } else {
+    // Booleans are bit packed in arrow, and the other values aren't contiguous in the proto.
+    return CopyFromInputPB<T>(output_column, *input_column);
+  }
+}
+
 Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
-  proto->set_num_rows(num_rows_);
+  proto->set_num_rows(num_selected_rows());
   proto->set_eow(eow_);
   proto->set_eos(eos_);
 
@@ -168,7 +214,7 @@ Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
     auto output_col_data = proto->add_cols();
     auto dt = desc_.type(col_idx);
 
-#define TYPE_CASE(_dt_) CopyIntoOutputPB<_dt_>(output_col_data, input_col);
+#define TYPE_CASE(_dt_) CopyIntoOutputPB<_dt_>(*this, output_col_data, input_col);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -223,6 +269,214 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
   return output_rb;
 }
 
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
+    table_store::schemapb::RowBatchData* proto) {
+  std::vector<DataType> types(proto->cols_size());
+  std::vector<std::shared_ptr<arrow::Array>> data_columns(proto->cols_size());
+
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    PL_ASSIGN_OR_RETURN(types[i], ProtoDataType(proto->cols(i)));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(MoveFromInputPB<_dt_>(&data_columns[i], proto->mutable_cols(i)));
+    PL_SWITCH_FOREACH_DATATYPE(types[i], TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  RowDescriptor desc(types);
+  auto output_rb = std::make_unique<RowBatch>(desc, proto->num_rows());
+  output_rb->set_eow(proto->eow());
+  output_rb->set_eos(proto->eos());
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(data_columns[i]));
+  }
+  return output_rb;
+}
+
+// The columnar wire format.
+
+namespace {
+
+// An arrow buffer that owns the string it points into, so that the bytes fields of a proto can be
+// moved into arrow arrays without copying them.
+class StringOwningBuffer : public arrow::Buffer {
+ public:
+  explicit StringOwningBuffer(std::string&& str) : arrow::Buffer(nullptr, 0), str_(std::move(str)) {
+    data_ = reinterpret_cast<const uint8_t*>(str_.data());
+    size_ = static_cast<int64_t>(str_.size());
+    capacity_ = size_;
+  }
+
+ private:
+  std::string str_;
+};
+
+template <typename TValue>
+void AppendRaw(const TValue& value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(TValue));
+}
+
+// PL_CARNOT_UPDATE_FOR_NEW_TYPES
+template <DataType T>
+void CopyIntoColumnarPB(const RowBatch& rb, arrow::Array* input_column,
+                        table_store::schemapb::ColumnarColumn* output_column) {
+  using ArrayType = typename types::DataTypeTraits<T>::arrow_array_type;
+  int64_t col_length = rb.num_selected_rows();
+  std::string* data = output_column->mutable_data();
+  if constexpr (T == DataType::BOOLEAN) {
+    data->reserve(col_length);
+    for (int64_t idx = 0; idx < col_length; ++idx) {
+      data->push_back(types::GetValueFromArrowArray<T>(input_column, rb.SelectedRowIndex(idx)));
+    }
+  } else if constexpr (T == DataType::UINT128) {
+    data->reserve(col_length * 2 * sizeof(uint64_t));
+    for (int64_t idx = 0; idx < col_length; ++idx) {
+      auto val = types::GetValueFromArrowArray<T>(input_column, rb.SelectedRowIndex(idx));
+      AppendRaw(absl::Uint128Low64(val), data);
+      AppendRaw(absl::Uint128High64(val), data);
+    }
+  } else if constexpr (T == DataType::STRING) {
+    auto* arr = static_cast<const ArrayType*>(input_column);
+    std::string* offsets = output_column->mutable_offsets();
+    offsets->reserve((col_length + 1) * sizeof(int32_t));
+    AppendRaw<int32_t>(0, offsets);
+    if (!rb.has_selection() && col_length > 0) {
+      // The values of the array are contiguous, so they can be copied at once.
+      int32_t start = arr->value_offset(0);
+      int32_t end = arr->value_offset(col_length);
+      data->assign(reinterpret_cast<const char*>(arr->value_data()->data()) + start, end - start);
+      for (int64_t idx = 1; idx <= col_length; ++idx) {
+        AppendRaw<int32_t>(arr->value_offset(idx) - start, offsets);
+      }
+      return;
+    }
+    for (int64_t idx = 0; idx < col_length; ++idx) {
+      auto i = rb.SelectedRowIndex(idx);
+      int32_t length = arr->value_length(i);
+      data->append(reinterpret_cast<const char*>(arr->value_data()->data()) + arr->value_offset(i),
+                   length);
+      AppendRaw<int32_t>(static_cast<int32_t>(data->size()), offsets);
+    }
+  } else {
+    auto* arr = static_cast<const ArrayType*>(input_column);
+    using CType = std::remove_const_t<std::remove_pointer_t<decltype(arr->raw_values())>>;
+    if (!rb.has_selection()) {
+      data->assign(reinterpret_cast<const char*>(arr->raw_values()), col_length * sizeof(CType));
+      return;
+    }
+    data->resize(col_length * sizeof(CType));
+    auto* out = reinterpret_cast<CType*>(data->data());
+    for (int64_t idx = 0; idx < col_length; ++idx) {
+      out[idx] = arr->raw_values()[rb.SelectedRowIndex(idx)];
+    }
+  }
+}
+
+template <DataType T>
+Status CopyFromColumnarPB(int64_t num_rows, table_store::schemapb::ColumnarColumn* input_column,
+                          std::shared_ptr<arrow::Array>* output_column) {
+  const std::string& data = input_column->data();
+  if constexpr (T == DataType::BOOLEAN || T == DataType::UINT128) {
+    // These arrays don't store their values the same way as the wire format, so they are built.
+    constexpr size_t kWidth = T == DataType::BOOLEAN ? 1 : 2 * sizeof(uint64_t);
+    if (data.size() != num_rows * kWidth) {
+      return error::InvalidArgument("Expected $0 bytes of data for $1 rows, got $2",
+                                    num_rows * kWidth, num_rows, data.size());
+    }
+    auto builder = MakeArrowBuilder(T, arrow::default_memory_pool());
+    PL_RETURN_IF_ERROR(builder->Reserve(num_rows));
+    for (int64_t i = 0; i < num_rows; ++i) {
+      if constexpr (T == DataType::BOOLEAN) {
+        PL_RETURN_IF_ERROR(CopyValue<T>(builder.get(), data[i] != 0));
+      } else {
+        uint64_t low;
+        uint64_t high;
+        std::memcpy(&low, data.data() + i * kWidth, sizeof(uint64_t));
+        std::memcpy(&high, data.data() + i * kWidth + sizeof(uint64_t), sizeof(uint64_t));
+        PL_RETURN_IF_ERROR(CopyValue<T>(builder.get(), absl::MakeUint128(high, low)));
+      }
+    }
+    PL_RETURN_IF_ERROR(builder->Finish(output_column));
+    return Status::OK();
+  } else if constexpr (T == DataType::STRING) {
+    const std::string& offsets = input_column->offsets();
+    if (offsets.size() != (num_rows + 1) * sizeof(int32_t)) {
+      return error::InvalidArgument("Expected $0 string offsets, got $1 bytes of offsets",
+                                    num_rows + 1, offsets.size());
+    }
+    int32_t first_offset;
+    int32_t last_offset;
+    std::memcpy(&first_offset, offsets.data(), sizeof(int32_t));
+    std::memcpy(&last_offset, offsets.data() + num_rows * sizeof(int32_t), sizeof(int32_t));
+    if (first_offset != 0 || last_offset != static_cast<int64_t>(data.size())) {
+      return error::InvalidArgument("String offsets [$0, $1] don't cover the $2 bytes of data",
+                                    first_offset, last_offset, data.size());
+    }
+    auto offsets_buffer =
+        std::make_shared<StringOwningBuffer>(std::move(*input_column->mutable_offsets()));
+    auto data_buffer =
+        std::make_shared<StringOwningBuffer>(std::move(*input_column->mutable_data()));
+    *output_column = arrow::MakeArray(arrow::ArrayData::Make(
+        arrow::utf8(), num_rows, {nullptr, offsets_buffer, data_buffer}, /* null_count */ 0));
+    return Status::OK();
+  } else {
+    using ArrowType = typename types::DataTypeTraits<T>::arrow_type;
+    using CType = typename ArrowType::c_type;
+    if (data.size() != num_rows * sizeof(CType)) {
+      return error::InvalidArgument("Expected $0 bytes of data for $1 rows, got $2",
+                                    num_rows * sizeof(CType), num_rows, data.size());
+    }
+    auto data_buffer =
+        std::make_shared<StringOwningBuffer>(std::move(*input_column->mutable_data()));
+    *output_column = arrow::MakeArray(arrow::ArrayData::Make(
+        std::make_shared<ArrowType>(), num_rows, {nullptr, data_buffer}, /* null_count */ 0));
+    return Status::OK();
+  }
+}
+
+}  // namespace
+
+Status RowBatch::ToColumnarProto(table_store::schemapb::ColumnarRowBatchData* proto) const {
+  proto->set_num_rows(num_selected_rows());
+  proto->set_eow(eow_);
+  proto->set_eos(eos_);
+
+  for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
+    auto input_col = ColumnAt(col_idx).get();
+    auto output_col = proto->add_cols();
+    auto dt = desc_.type(col_idx);
+    output_col->set_data_type(dt);
+
+#define TYPE_CASE(_dt_) CopyIntoColumnarPB<_dt_>(*this, input_col, output_col);
+    PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromColumnarProto(
+    table_store::schemapb::ColumnarRowBatchData* proto) {
+  std::vector<DataType> types(proto->cols_size());
+  std::vector<std::shared_ptr<arrow::Array>> data_columns(proto->cols_size());
+
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    types[i] = proto->cols(i).data_type();
+#define TYPE_CASE(_dt_)  \
+  PL_RETURN_IF_ERROR( \
+      CopyFromColumnarPB<_dt_>(proto->num_rows(), proto->mutable_cols(i), &data_columns[i]));
+    PL_SWITCH_FOREACH_DATATYPE(types[i], TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  RowDescriptor desc(types);
+  auto output_rb = std::make_unique<RowBatch>(desc, proto->num_rows());
+  output_rb->set_eow(proto->eow());
+  output_rb->set_eos(proto->eos());
+  for (auto i = 0; i < proto->cols_size(); ++i) {
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(data_columns[i]));
+  }
+  return output_rb;
+}
+
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromColumnBuilders(
     const RowDescriptor& desc, bool eow, bool eos,
     std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders) {
@@ -253,6 +507,7 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::WithZeroRows(const RowDescriptor&
 }
 
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::Slice(int64_t offset, int64_t length) const {
+  DCHECK(!has_selection()) << "Slice doesn't support row batches with a selection";
   if (offset + length > num_rows() || offset < 0) {
     return error::InvalidArgument("Slice(offset=$0, length=$1) on rowbatch of length $2 is invalid",
                                   offset, length, num_rows());
@@ -265,6 +520,38 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::Slice(int64_t offset, int64_t leng
   return output_rb;
 }
 
+template <DataType T>
+Status CopySelectedValues(const arrow::Array* input_col, const std::vector<int64_t>& selection,
+                          std::shared_ptr<arrow::Array>* output_col) {
+  auto builder = MakeArrowBuilder(T, arrow::default_memory_pool());
+  PL_RETURN_IF_ERROR(builder->Reserve(selection.size()));
+  for (auto row_idx : selection) {
+    PL_RETURN_IF_ERROR(
+        CopyValue<T>(builder.get(), types::GetValueFromArrowArray<T>(input_col, row_idx)));
+  }
+  PL_RETURN_IF_ERROR(builder->Finish(output_col));
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::CompactSelection() const {
+  auto output_rb = std::make_unique<RowBatch>(desc(), num_selected_rows());
+  for (int64_t col_idx = 0; col_idx < num_columns(); ++col_idx) {
+    if (!has_selection()) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(ColumnAt(col_idx)));
+      continue;
+    }
+    std::shared_ptr<arrow::Array> output_col;
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(CopySelectedValues<_dt_>(ColumnAt(col_idx).get(), *selection_, &output_col));
+    PL_SWITCH_FOREACH_DATATYPE(desc_.type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  output_rb->set_eow(eow_);
+  output_rb->set_eos(eos_);
+  return output_rb;
+}
+
 }  // namespace schema
 }  // namespace table_store
 }  // namespace px
@@ -52,6 +52,25 @@ class RowBatch {
   Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
+  /**
+   * Like FromProto() above, but the INT64, TIME64NS and FLOAT64 values are moved out of the proto
+   * and back the arrays of the row batch directly, rather than being copied. The other columns are
+   * copied, and the values of the proto are left unspecified.
+   */
+  static StatusOr<std::unique_ptr<RowBatch>> FromProto(
+      table_store::schemapb::RowBatchData* row_batch_proto);
+
+  /**
+   * Serializes the row batch into the columnar wire format, which copies the buffers of each column
+   * rather than encoding the values one at a time.
+   */
+  Status ToColumnarProto(table_store::schemapb::ColumnarRowBatchData* row_batch_proto) const;
+  /**
+   * Deserializes a row batch from the columnar wire format. The buffers are moved out of the proto
+   * and back the arrays of the row batch directly, so the values aren't copied again.
+   */
+  static StatusOr<std::unique_ptr<RowBatch>> FromColumnarProto(
+      table_store::schemapb::ColumnarRowBatchData* row_batch_proto);
 
   static StatusOr<std::unique_ptr<RowBatch>> FromColumnBuilders(
       const RowDescriptor& desc, bool eow, bool eos,
@@ -76,6 +95,14 @@ class RowBatch {
    */
   StatusOr<std::unique_ptr<RowBatch>> Slice(int64_t offset, int64_t length) const;
 
+  /**
+   * @brief Returns a new RowBatch that only contains the selected rows of this RowBatch.
+   *
+   * The returned RowBatch has no selection and keeps the eow and eos of this RowBatch. If this
+   * RowBatch has no selection, the columns are shared instead of copied.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> CompactSelection() const;
+
   /**
    * Adds the given column to the row batch, given that it correctly fits the schema.
    * param col ptr to the arrow array that should be added to the row batch.
@@ -110,6 +137,30 @@ class RowBatch {
 
   bool eos() const { return eos_; }
   void set_eos(bool val) { eos_ = val; }
+
+  /**
+   * A selection restricts the row batch to the rows at the given sorted indices, without copying
+   * the columns. Consumers that don't handle selections should call CompactSelection() first.
+   */
+  bool has_selection() const { return selection_ != nullptr; }
+  const std::vector<int64_t>& selection() const { return *selection_; }
+  const std::shared_ptr<const std::vector<int64_t>>& selection_ptr() const { return selection_; }
+  void set_selection(std::shared_ptr<const std::vector<int64_t>> selection) {
+    selection_ = std::move(selection);
+  }
+
+  /**
+   * @ return the number of rows in the row batch after the selection is applied.
+   */
+  int64_t num_selected_rows() const {
+    return has_selection() ? static_cast<int64_t>(selection_->size()) : num_rows_;
+  }
+
+  /**
+   * @ param i the index of a selected row.
+   * @ returns the index of the row in the columns of the row batch.
+   */
+  int64_t SelectedRowIndex(int64_t i) const { return has_selection() ? (*selection_)[i] : i; }
   /**
    * @ return the row descriptor which describes the schema of the row batch.
    */
@@ -126,6 +177,7 @@ class RowBatch {
   bool eow_ = false;
   bool eos_ = false;
   std::vector<std::shared_ptr<arrow::Array>> columns_;
+  std::shared_ptr<const std::vector<int64_t>> selection_;
 };
 
 // Append a scalar value to an arrow::Array.
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/delta_encoding.h"
+
+#include <algorithm>
+
+#include <arrow/builder.h>
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+void WriteBits(std::vector<uint64_t>* words, uint64_t bit_pos, int width, uint64_t value) {
+  size_t word = bit_pos / 64;
+  int shift = bit_pos % 64;
+  (*words)[word] |= value << shift;
+  if (shift + width > 64) {
+    (*words)[word + 1] |= value >> (64 - shift);
+  }
+}
+
+uint64_t ReadBits(const std::vector<uint64_t>& words, uint64_t bit_pos, int width) {
+  if (width == 0) {
+    return 0;
+  }
+  size_t word = bit_pos / 64;
+  int shift = bit_pos % 64;
+  uint64_t value = words[word] >> shift;
+  if (shift + width > 64) {
+    value |= words[word + 1] << (64 - shift);
+  }
+  return width == 64 ? value : value & ((uint64_t{1} << width) - 1);
+}
+
+}  // namespace
+
+int64_t DeltaEncodedInts::Bytes() const {
+  return sizeof(DeltaEncodedInts) + blocks_.size() * sizeof(Block) +
+         words_.size() * sizeof(uint64_t);
+}
+
+StatusOr<std::unique_ptr<DeltaEncodedInts>> DeltaEncodedInts::Encode(const arrow::Int64Array& arr) {
+  std::unique_ptr<DeltaEncodedInts> encoded(new DeltaEncodedInts());
+  encoded->length_ = arr.length();
+  const int64_t* values = arr.raw_values();
+  // Deltas are computed with unsigned arithmetic, so overflow wraps and decodes back exactly.
+  for (int64_t start = 0; start < arr.length(); start += kBlockSize) {
+    int64_t end = std::min(start + kBlockSize, arr.length());
+    Block block{values[start], 0, static_cast<int64_t>(encoded->words_.size()), 0};
+    if (end - start > 1) {
+      block.min_delta = static_cast<int64_t>(static_cast<uint64_t>(values[start + 1]) -
+                                             static_cast<uint64_t>(values[start]));
+    }
+    for (int64_t i = start + 2; i < end; ++i) {
+      auto delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) -
+                                        static_cast<uint64_t>(values[i - 1]));
+      block.min_delta = std::min(block.min_delta, delta);
+    }
+    uint64_t max_packed = 0;
+    for (int64_t i = start + 1; i < end; ++i) {
+      uint64_t packed = static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]) -
+                        static_cast<uint64_t>(block.min_delta);
+      max_packed = std::max(max_packed, packed);
+    }
+    block.bit_width = max_packed == 0 ? 0 : 64 - __builtin_clzll(max_packed);
+
+    uint64_t num_bits = block.bit_width * (end - start - 1);
+    encoded->words_.resize(encoded->words_.size() + (num_bits + 63) / 64, 0);
+    uint64_t bit_pos = block.word_offset * 64;
+    for (int64_t i = start + 1; i < end && block.bit_width > 0; ++i) {
+      uint64_t packed = static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]) -
+                        static_cast<uint64_t>(block.min_delta);
+      WriteBits(&encoded->words_, bit_pos, block.bit_width, packed);
+      bit_pos += block.bit_width;
+    }
+    encoded->blocks_.push_back(block);
+  }
+  if (encoded->Bytes() >= encoded->UncompressedBytes()) {
+    return std::unique_ptr<DeltaEncodedInts>();
+  }
+  return encoded;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> DeltaEncodedInts::Decode(
+    int64_t offset, int64_t length, arrow::MemoryPool* mem_pool) const {
+  DCHECK_LE(offset + length, length_);
+  arrow::Int64Builder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length));
+  int64_t end = offset + length;
+  // Decoding has to start at the beginning of the block that contains the first row.
+  for (int64_t block_idx = offset / kBlockSize; block_idx * kBlockSize < end; ++block_idx) {
+    const Block& block = blocks_[block_idx];
+    int64_t block_start = block_idx * kBlockSize;
+    int64_t block_end = std::min({block_start + kBlockSize, length_, end});
+    auto value = static_cast<uint64_t>(block.first_value);
+    uint64_t bit_pos = block.word_offset * 64;
+    for (int64_t i = block_start; i < block_end; ++i) {
+      if (i > block_start) {
+        value += static_cast<uint64_t>(block.min_delta) + ReadBits(words_, bit_pos, block.bit_width);
+        bit_pos += block.bit_width;
+      }
+      if (i >= offset) {
+        builder.UnsafeAppend(static_cast<int64_t>(value));
+      }
+    }
+  }
+  std::shared_ptr<arrow::Array> out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
+}  // namespace table_store
+}  // namespace px
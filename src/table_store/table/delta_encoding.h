@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/encoded_column.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * DeltaEncodedInts stores an INT64 (or TIME64NS) column as the differences between consecutive
+ * values, bit-packed with the smallest width that fits each block of kBlockSize rows. Monotonic
+ * columns such as timestamps and counters typically shrink to a few bits per row.
+ */
+class DeltaEncodedInts : public EncodedColumn {
+ public:
+  static constexpr int64_t kBlockSize = 128;
+
+  /**
+   * Encodes the given array.
+   * @return the encoded ints, or nullptr if the encoding wouldn't be smaller than the array.
+   */
+  static StatusOr<std::unique_ptr<DeltaEncodedInts>> Encode(const arrow::Int64Array& arr);
+
+  int64_t length() const override { return length_; }
+  int64_t Bytes() const override;
+  int64_t UncompressedBytes() const override {
+    return length_ * static_cast<int64_t>(sizeof(int64_t));
+  }
+  StatusOr<std::shared_ptr<arrow::Array>> Decode(int64_t offset, int64_t length,
+                                                 arrow::MemoryPool* mem_pool) const override;
+
+ private:
+  struct Block {
+    int64_t first_value;
+    // Deltas are stored relative to the smallest delta of the block, so they are never negative.
+    int64_t min_delta;
+    // The offset of the block's packed deltas into words_.
+    int64_t word_offset;
+    int bit_width;
+  };
+
+  int64_t length_ = 0;
+  std::vector<Block> blocks_;
+  std::vector<uint64_t> words_;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/dictionary_encoding.h"
+
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <arrow/builder.h>
+
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace table_store {
+
+int64_t DictionaryEncodedStrings::Bytes() const {
+  return types::GetArrowArrayBytes<types::DataType::STRING>(dictionary_.get()) +
+         indices_->length() * static_cast<int64_t>(sizeof(int32_t));
+}
+
+StatusOr<std::unique_ptr<DictionaryEncodedStrings>> DictionaryEncodedStrings::Encode(
+    const arrow::StringArray& arr, double max_distinct_ratio, arrow::MemoryPool* mem_pool) {
+  auto max_distinct = static_cast<int64_t>(arr.length() * max_distinct_ratio);
+  absl::flat_hash_map<std::string_view, int32_t> value_to_index;
+  arrow::Int32Builder indices_builder(mem_pool);
+  PL_RETURN_IF_ERROR(indices_builder.Reserve(arr.length()));
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    int32_t length = 0;
+    const uint8_t* value = arr.GetValue(i, &length);
+    auto [it, inserted] = value_to_index.try_emplace(
+        std::string_view(reinterpret_cast<const char*>(value), length),
+        static_cast<int32_t>(value_to_index.size()));
+    if (inserted && static_cast<int64_t>(value_to_index.size()) > max_distinct) {
+      return std::unique_ptr<DictionaryEncodedStrings>();
+    }
+    indices_builder.UnsafeAppend(it->second);
+  }
+
+  // The dictionary is written in index order so that index i points at the i-th distinct value.
+  std::vector<std::string_view> values(value_to_index.size());
+  int64_t values_bytes = 0;
+  for (const auto& [value, index] : value_to_index) {
+    values[index] = value;
+    values_bytes += value.size();
+  }
+  arrow::StringBuilder dictionary_builder(mem_pool);
+  PL_RETURN_IF_ERROR(dictionary_builder.Reserve(values.size()));
+  PL_RETURN_IF_ERROR(dictionary_builder.ReserveData(values_bytes));
+  for (const auto& value : values) {
+    dictionary_builder.UnsafeAppend(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+  }
+
+  std::unique_ptr<DictionaryEncodedStrings> encoded(new DictionaryEncodedStrings());
+  std::shared_ptr<arrow::Array> dictionary;
+  std::shared_ptr<arrow::Array> indices;
+  PL_RETURN_IF_ERROR(dictionary_builder.Finish(&dictionary));
+  PL_RETURN_IF_ERROR(indices_builder.Finish(&indices));
+  encoded->dictionary_ = std::static_pointer_cast<arrow::StringArray>(dictionary);
+  encoded->indices_ = std::static_pointer_cast<arrow::Int32Array>(indices);
+  encoded->uncompressed_bytes_ = types::GetArrowArrayBytes<types::DataType::STRING>(&arr);
+  return encoded;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> DictionaryEncodedStrings::Decode(
+    int64_t offset, int64_t length, arrow::MemoryPool* mem_pool) const {
+  DCHECK_LE(offset + length, indices_->length());
+  const int32_t* raw_indices = indices_->raw_values() + offset;
+  int64_t total_bytes = 0;
+  for (int64_t i = 0; i < length; ++i) {
+    total_bytes += dictionary_->value_length(raw_indices[i]);
+  }
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length));
+  PL_RETURN_IF_ERROR(builder.ReserveData(total_bytes));
+  for (int64_t i = 0; i < length; ++i) {
+    int32_t value_length = 0;
+    const uint8_t* value = dictionary_->GetValue(raw_indices[i], &value_length);
+    builder.UnsafeAppend(value, value_length);
+  }
+  std::shared_ptr<arrow::Array> out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <memory>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/encoded_column.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * DictionaryEncodedStrings stores a string column as the distinct values it contains (dictionary)
+ * and, for every row, the index of its value in the dictionary (indices).
+ */
+class DictionaryEncodedStrings : public EncodedColumn {
+ public:
+  /**
+   * Encodes the given string array, if it has few enough distinct values to make that worthwhile.
+   * @param arr the array to encode.
+   * @param max_distinct_ratio the maximum ratio of distinct values to rows to encode the array.
+   * @param mem_pool the arrow memory pool to allocate the encoded arrays from.
+   * @return the encoded strings, or nullptr if the array shouldn't be encoded.
+   */
+  static StatusOr<std::unique_ptr<DictionaryEncodedStrings>> Encode(const arrow::StringArray& arr,
+                                                                    double max_distinct_ratio,
+                                                                    arrow::MemoryPool* mem_pool);
+
+  int64_t length() const override { return indices_->length(); }
+  int64_t Bytes() const override;
+  int64_t UncompressedBytes() const override { return uncompressed_bytes_; }
+  StatusOr<std::shared_ptr<arrow::Array>> Decode(int64_t offset, int64_t length,
+                                                 arrow::MemoryPool* mem_pool) const override;
+
+ private:
+  std::shared_ptr<arrow::StringArray> dictionary_;
+  std::shared_ptr<arrow::Int32Array> indices_;
+  int64_t uncompressed_bytes_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <memory>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * EncodedColumn is a column of a cold batch that is stored in a more compact format than a plain
+ * arrow array. Reads decode the rows they need back into a plain arrow array.
+ */
+class EncodedColumn {
+ public:
+  virtual ~EncodedColumn() = default;
+
+  // The number of rows in the column.
+  virtual int64_t length() const = 0;
+  // The number of bytes used by the encoded column.
+  virtual int64_t Bytes() const = 0;
+  // The number of bytes the column would use as a plain arrow array.
+  virtual int64_t UncompressedBytes() const = 0;
+
+  /**
+   * Decodes the rows [offset, offset + length) into a plain arrow array.
+   */
+  virtual StatusOr<std::shared_ptr<arrow::Array>> Decode(int64_t offset, int64_t length,
+                                                         arrow::MemoryPool* mem_pool) const = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/table_store/table/huge_page_memory_pool.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+DEFINE_string(table_store_huge_pages, gflags::StringFromEnv("PL_TABLE_STORE_HUGE_PAGES", "none"),
+              "The pages that back the cold batches of the tables: 'none' for the default memory "
+              "pool, 'transparent' for transparent huge pages, or 'explicit' for the huge pages "
+              "reserved in /proc/sys/vm/nr_hugepages.");
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+constexpr int64_t kAlignment = 64;
+
+// Arrow expects a valid, aligned pointer for zero-size allocations.
+alignas(kAlignment) uint8_t zero_size_area[1];
+
+int64_t RoundUp(int64_t size, int64_t multiple) {
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+HugePageMemoryPool::HugePageMemoryPool(Mode mode, int64_t chunk_size)
+    : chunk_size_(RoundUp(chunk_size, kHugePageSize)), mode_(mode) {}
+
+HugePageMemoryPool::~HugePageMemoryPool() {
+  absl::MutexLock lock(&lock_);
+  LOG_IF(WARNING, bytes_allocated_ > 0) << absl::Substitute(
+      "Huge page memory pool is deleted with $0 bytes still allocated.", bytes_allocated_);
+  for (const auto& [addr, chunk] : chunks_) {
+    munmap(addr, chunk.size);
+  }
+}
+
+arrow::Status HugePageMemoryPool::MapLocked(int64_t size, uint8_t** out) {
+  if (mode_ == Mode::kExplicit) {
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      *out = static_cast<uint8_t*>(addr);
+      reserved_bytes_ += size;
+      return arrow::Status::OK();
+    }
+    LOG(WARNING) << absl::Substitute(
+        "Failed to map $0 bytes of explicit huge pages, falling back to transparent huge pages: "
+        "$1",
+        size, std::strerror(errno));
+    mode_ = Mode::kTransparent;
+  }
+
+  // Transparent huge pages are only used for the huge page aligned parts of a mapping, so the
+  // mapping is made larger and trimmed down to an aligned range.
+  const int64_t mapped_size = size + kHugePageSize;
+  void* addr =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return arrow::Status::OutOfMemory("Failed to map ", size, " bytes: ", std::strerror(errno));
+  }
+  auto* start = static_cast<uint8_t*>(addr);
+  auto* aligned = reinterpret_cast<uint8_t*>(
+      RoundUp(reinterpret_cast<int64_t>(start), kHugePageSize));
+  if (aligned > start) {
+    munmap(start, aligned - start);
+  }
+  const int64_t tail = (start + mapped_size) - (aligned + size);
+  if (tail > 0) {
+    munmap(aligned + size, tail);
+  }
+  if (madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+    LOG_FIRST_N(WARNING, 1) << absl::Substitute(
+        "Transparent huge pages are unavailable, the huge page memory pool uses regular pages: $0",
+        std::strerror(errno));
+  }
+  *out = aligned;
+  reserved_bytes_ += size;
+  return arrow::Status::OK();
+}
+
+void HugePageMemoryPool::UnmapLocked(uint8_t* addr, int64_t size) {
+  munmap(addr, size);
+  reserved_bytes_ -= size;
+}
+
+arrow::Status HugePageMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  if (size < 0) {
+    return arrow::Status::Invalid("Negative allocation size requested.");
+  }
+  if (size == 0) {
+    *out = zero_size_area;
+    return arrow::Status::OK();
+  }
+  const int64_t aligned_size = RoundUp(size, kAlignment);
+
+  absl::MutexLock lock(&lock_);
+  if (aligned_size > chunk_size_ / 4) {
+    const int64_t mapped_size = RoundUp(aligned_size, kHugePageSize);
+    ARROW_RETURN_NOT_OK(MapLocked(mapped_size, out));
+    chunks_[*out] = Chunk{mapped_size, mapped_size, 1};
+  } else {
+    Chunk* chunk = current_chunk_ == nullptr ? nullptr : &chunks_[current_chunk_];
+    if (chunk == nullptr || chunk->size - chunk->used < aligned_size) {
+      // A chunk that is left with no buffers was unmapped when its last buffer was freed, except
+      // for the current one.
+      if (chunk != nullptr && chunk->num_buffers == 0) {
+        UnmapLocked(current_chunk_, chunk->size);
+        chunks_.erase(current_chunk_);
+        current_chunk_ = nullptr;
+      }
+      ARROW_RETURN_NOT_OK(MapLocked(chunk_size_, &current_chunk_));
+      chunk = &chunks_[current_chunk_];
+      chunk->size = chunk_size_;
+    }
+    *out = current_chunk_ + chunk->used;
+    chunk->used += aligned_size;
+    ++chunk->num_buffers;
+  }
+  bytes_allocated_ += size;
+  max_memory_ = std::max(max_memory_, bytes_allocated_);
+  return arrow::Status::OK();
+}
+
+arrow::Status HugePageMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (*ptr != zero_size_area && new_size > 0 &&
+      RoundUp(new_size, kAlignment) <= RoundUp(old_size, kAlignment)) {
+    // The buffer already holds the new size.
+    absl::MutexLock lock(&lock_);
+    bytes_allocated_ += new_size - old_size;
+    return arrow::Status::OK();
+  }
+  uint8_t* out;
+  ARROW_RETURN_NOT_OK(Allocate(new_size, &out));
+  std::memcpy(out, *ptr, std::min(old_size, new_size));
+  Free(*ptr, old_size);
+  *ptr = out;
+  return arrow::Status::OK();
+}
+
+void HugePageMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  if (buffer == zero_size_area) {
+    return;
+  }
+  absl::MutexLock lock(&lock_);
+  auto it = chunks_.upper_bound(buffer);
+  DCHECK(it != chunks_.begin()) << "Freed a buffer that wasn't allocated from the pool.";
+  --it;
+  Chunk& chunk = it->second;
+  DCHECK_LT(buffer, it->first + chunk.size);
+  bytes_allocated_ -= size;
+  if (--chunk.num_buffers > 0) {
+    return;
+  }
+  if (it->first == current_chunk_) {
+    // The current chunk is reused from its start.
+    chunk.used = 0;
+    return;
+  }
+  UnmapLocked(it->first, chunk.size);
+  chunks_.erase(it);
+}
+
+int64_t HugePageMemoryPool::bytes_allocated() const {
+  absl::MutexLock lock(&lock_);
+  return bytes_allocated_;
+}
+
+int64_t HugePageMemoryPool::max_memory() const {
+  absl::MutexLock lock(&lock_);
+  return max_memory_;
+}
+
+int64_t HugePageMemoryPool::reserved_bytes() const {
+  absl::MutexLock lock(&lock_);
+  return reserved_bytes_;
+}
+
+HugePageMemoryPool::Mode HugePageMemoryPool::mode() const {
+  absl::MutexLock lock(&lock_);
+  return mode_;
+}
+
+arrow::MemoryPool* ColdBatchMemoryPool() {
+  static arrow::MemoryPool* const pool = []() -> arrow::MemoryPool* {
+    if (FLAGS_table_store_huge_pages == "transparent") {
+      return new HugePageMemoryPool(HugePageMemoryPool::Mode::kTransparent);
+    }
+    if (FLAGS_table_store_huge_pages == "explicit") {
+      return new HugePageMemoryPool(HugePageMemoryPool::Mode::kExplicit);
+    }
+    LOG_IF(ERROR, FLAGS_table_store_huge_pages != "none")
+        << absl::Substitute("Invalid --table_store_huge_pages '$0', using regular pages.",
+                            FLAGS_table_store_huge_pages);
+    return arrow::default_memory_pool();
+  }();
+  return pool;
+}
+
+}  // namespace table_store
+}  // namespace px
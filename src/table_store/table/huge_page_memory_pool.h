@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_string(table_store_huge_pages);
+
+namespace px {
+namespace table_store {
+
+/**
+ * HugePageMemoryPool is an arrow::MemoryPool backed by huge pages, for long-lived data that is
+ * scanned often, such as the cold batches of the tables. Backing gigabytes of cold batches with
+ * huge pages rather than 4KB pages spares the TLB misses of the scans.
+ *
+ * Allocations are carved out of large chunks that are mapped with mmap(2), either as transparent
+ * huge pages (aligned to the huge page size and madvise(MADV_HUGEPAGE)'d) or as explicit huge
+ * pages (MAP_HUGETLB, which need pages reserved in /proc/sys/vm/nr_hugepages). When no explicit
+ * huge pages are available, the pool falls back to transparent huge pages.
+ *
+ * A chunk is unmapped once all of its allocations are freed. Cold batches expire from the tables
+ * in roughly the order they are compacted, so the allocations of a chunk tend to be freed
+ * together. Allocations larger than a quarter of a chunk get a mapping of their own.
+ */
+class HugePageMemoryPool : public arrow::MemoryPool {
+ public:
+  enum class Mode { kTransparent, kExplicit };
+
+  static constexpr int64_t kHugePageSize = 2 * 1024 * 1024;
+  static constexpr int64_t kDefaultChunkSize = 16 * kHugePageSize;
+
+  explicit HugePageMemoryPool(Mode mode, int64_t chunk_size = kDefaultChunkSize);
+  ~HugePageMemoryPool() override;
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  // The bytes of the buffers allocated from the pool and not freed yet.
+  int64_t bytes_allocated() const override;
+  // The peak of bytes_allocated().
+  int64_t max_memory() const override;
+  // The bytes the pool has mapped, for its chunks and large allocations.
+  int64_t reserved_bytes() const;
+
+  // The mode the pool maps its memory with, which is kTransparent if kExplicit was unavailable.
+  Mode mode() const;
+
+ private:
+  struct Chunk {
+    int64_t size = 0;
+    // The bytes of the chunk handed out so far, allocations are never moved within a chunk.
+    int64_t used = 0;
+    int64_t num_buffers = 0;
+  };
+
+  arrow::Status MapLocked(int64_t size, uint8_t** out) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void UnmapLocked(uint8_t* addr, int64_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const int64_t chunk_size_;
+
+  mutable absl::Mutex lock_;
+  Mode mode_ ABSL_GUARDED_BY(lock_);
+  // The chunks and dedicated mappings, by their start address.
+  std::map<uint8_t*, Chunk> chunks_ ABSL_GUARDED_BY(lock_);
+  // The chunk that small allocations are carved from, or nullptr.
+  uint8_t* current_chunk_ ABSL_GUARDED_BY(lock_) = nullptr;
+
+  int64_t bytes_allocated_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t max_memory_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t reserved_bytes_ ABSL_GUARDED_BY(lock_) = 0;
+};
+
+/**
+ * Returns the memory pool for the cold batches of the tables, as selected by
+ * --table_store_huge_pages: the default pool, or a process-wide HugePageMemoryPool.
+ */
+arrow::MemoryPool* ColdBatchMemoryPool();
+
+}  // namespace table_store
+}  // namespace px
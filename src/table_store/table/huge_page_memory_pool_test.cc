@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/table/huge_page_memory_pool.h"
+
+namespace px {
+namespace table_store {
+
+class HugePageMemoryPoolTest : public ::testing::TestWithParam<HugePageMemoryPool::Mode> {};
+
+TEST_P(HugePageMemoryPoolTest, AllocatesAlignedBuffers) {
+  HugePageMemoryPool pool(GetParam());
+  std::vector<uint8_t*> buffers;
+  for (int64_t size : {1, 63, 64, 1000, 4096, 100000}) {
+    uint8_t* buffer;
+    ASSERT_TRUE(pool.Allocate(size, &buffer).ok());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % 64, 0);
+    std::memset(buffer, 0xab, size);
+    buffers.push_back(buffer);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 1 + 63 + 64 + 1000 + 4096 + 100000);
+  EXPECT_EQ(pool.reserved_bytes(), HugePageMemoryPool::kDefaultChunkSize);
+
+  int i = 0;
+  for (int64_t size : {1, 63, 64, 1000, 4096, 100000}) {
+    pool.Free(buffers[i++], size);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+  EXPECT_EQ(pool.max_memory(), 1 + 63 + 64 + 1000 + 4096 + 100000);
+}
+
+TEST_P(HugePageMemoryPoolTest, UnmapsChunksOnceTheirBuffersAreFreed) {
+  constexpr int64_t kChunkSize = 2 * HugePageMemoryPool::kHugePageSize;
+  constexpr int64_t kBufferSize = 256 * 1024;
+  HugePageMemoryPool pool(GetParam(), kChunkSize);
+
+  // Fills three chunks.
+  std::vector<uint8_t*> buffers(3 * kChunkSize / kBufferSize);
+  for (auto& buffer : buffers) {
+    ASSERT_TRUE(pool.Allocate(kBufferSize, &buffer).ok());
+  }
+  EXPECT_EQ(pool.reserved_bytes(), 3 * kChunkSize);
+
+  // Freeing the buffers of the first chunk unmaps it, the current chunk stays mapped.
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    pool.Free(buffers[i], kBufferSize);
+    if (i + 1 == buffers.size() / 3) {
+      EXPECT_EQ(pool.reserved_bytes(), 2 * kChunkSize);
+    }
+  }
+  EXPECT_EQ(pool.reserved_bytes(), kChunkSize);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+TEST_P(HugePageMemoryPoolTest, LargeAllocationsAreMappedOnTheirOwn) {
+  constexpr int64_t kSize = 5 * 1024 * 1024;
+  HugePageMemoryPool pool(GetParam(), 4 * HugePageMemoryPool::kHugePageSize);
+  uint8_t* buffer;
+  ASSERT_TRUE(pool.Allocate(kSize, &buffer).ok());
+  std::memset(buffer, 1, kSize);
+  EXPECT_EQ(pool.reserved_bytes(), 3 * HugePageMemoryPool::kHugePageSize);
+  pool.Free(buffer, kSize);
+  EXPECT_EQ(pool.reserved_bytes(), 0);
+}
+
+TEST_P(HugePageMemoryPoolTest, ReallocateKeepsContents) {
+  HugePageMemoryPool pool(GetParam());
+  uint8_t* buffer;
+  ASSERT_TRUE(pool.Allocate(100, &buffer).ok());
+  for (int i = 0; i < 100; ++i) {
+    buffer[i] = i;
+  }
+  ASSERT_TRUE(pool.Reallocate(100, 120, &buffer).ok());
+  ASSERT_TRUE(pool.Reallocate(120, 10000, &buffer).ok());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(buffer[i], i);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 10000);
+  pool.Free(buffer, 10000);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+TEST_P(HugePageMemoryPoolTest, ZeroSizeAllocations) {
+  HugePageMemoryPool pool(GetParam());
+  uint8_t* buffer = nullptr;
+  ASSERT_TRUE(pool.Allocate(0, &buffer).ok());
+  EXPECT_NE(buffer, nullptr);
+  EXPECT_EQ(pool.reserved_bytes(), 0);
+  ASSERT_TRUE(pool.Reallocate(0, 10, &buffer).ok());
+  pool.Free(buffer, 10);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+// Explicit huge pages are usually not reserved on test machines, in which case the pool falls back
+// to transparent huge pages.
+INSTANTIATE_TEST_SUITE_P(Modes, HugePageMemoryPoolTest,
+                         ::testing::Values(HugePageMemoryPool::Mode::kTransparent,
+                                           HugePageMemoryPool::Mode::kExplicit));
+
+}  // namespace table_store
+}  // namespace px
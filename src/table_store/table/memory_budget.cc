@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/memory_budget.h"
+
+#include <utility>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+DEFINE_int64(table_store_memory_budget, gflags::Int64FromEnv("PL_TABLE_STORE_MEMORY_BUDGET", 0),
+             "The number of bytes that all of the tables of the table store can hold together. "
+             "The budget is split across the tables by their weights and recent write rates. "
+             "0 limits each table to --table_store_table_size_limit instead.");
+DEFINE_string(table_store_table_weights,
+              gflags::StringFromEnv("PL_TABLE_STORE_TABLE_WEIGHTS", ""),
+              "Comma separated table:weight pairs, which set how much of the table store memory "
+              "budget goes to each table. Tables that aren't listed get a weight of 1.");
+
+namespace px {
+namespace table_store {
+
+StatusOr<absl::flat_hash_map<std::string, double>> ParseTableWeights(std::string_view spec) {
+  absl::flat_hash_map<std::string, double> weights;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> parts = absl::StrSplit(entry, ':');
+    double weight = 0;
+    if (parts.size() != 2 || !absl::SimpleAtod(parts[1], &weight) || weight <= 0) {
+      return error::InvalidArgument("Invalid table weight '$0', expected <table>:<weight > 0>",
+                                    entry);
+    }
+    weights[absl::StripAsciiWhitespace(parts[0])] = weight;
+  }
+  return weights;
+}
+
+double TableMemoryBudget::Weight(const std::string& table_name) const {
+  auto it = table_weights_.find(table_name);
+  return it == table_weights_.end() ? 1.0 : it->second;
+}
+
+Status TableMemoryBudget::Rebalance(const std::vector<std::shared_ptr<Table>>& tables) {
+  if (tables.empty()) {
+    return Status::OK();
+  }
+  absl::flat_hash_map<std::string, int64_t> num_tablets;
+  for (const auto& table : tables) {
+    ++num_tablets[table->name()];
+  }
+
+  absl::flat_hash_map<const Table*, TableUsage> usage;
+  std::vector<double> weights;
+  std::vector<double> weighted_rates;
+  double total_weight = 0;
+  double total_weighted_rate = 0;
+  for (const auto& table : tables) {
+    int64_t bytes_added = table->GetTableStats().bytes_added;
+    TableUsage table_usage;
+    table_usage.bytes_added = bytes_added;
+    auto it = usage_.find(table.get());
+    // A table that has fewer bytes added than before is a new table at the same address.
+    if (it != usage_.end() && it->second.bytes_added <= bytes_added) {
+      table_usage.write_rate = kWriteRateDecay * it->second.write_rate +
+                               (1 - kWriteRateDecay) * (bytes_added - it->second.bytes_added);
+    }
+    double weight = Weight(table->name()) / num_tablets[table->name()];
+    weights.push_back(weight);
+    weighted_rates.push_back(weight * table_usage.write_rate);
+    total_weight += weight;
+    total_weighted_rate += weighted_rates.back();
+    usage[table.get()] = table_usage;
+  }
+
+  const double weight_only_bytes =
+      total_weighted_rate > 0 ? kWeightOnlyShare * budget_bytes_ : budget_bytes_;
+  const double rate_bytes = budget_bytes_ - weight_only_bytes;
+  Status status = Status::OK();
+  for (const auto& [i, table] : Enumerate(tables)) {
+    double allocation = weight_only_bytes * weights[i] / total_weight;
+    if (total_weighted_rate > 0) {
+      allocation += rate_bytes * weighted_rates[i] / total_weighted_rate;
+    }
+    TableUsage& table_usage = usage[table.get()];
+    table_usage.allocation = static_cast<int64_t>(allocation);
+    // Keep going, so that one table failing to shrink doesn't stop the others from shrinking.
+    auto s = table->SetMaxTableSize(table_usage.allocation);
+    if (!s.ok()) {
+      status = s;
+    }
+  }
+  usage_ = std::move(usage);
+  return status;
+}
+
+int64_t TableMemoryBudget::allocation(const Table* table) const {
+  auto it = usage_.find(table);
+  return it == usage_.end() ? -1 : it->second.allocation;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/table.h"
+
+DECLARE_int64(table_store_memory_budget);
+DECLARE_string(table_store_table_weights);
+
+namespace px {
+namespace table_store {
+
+/**
+ * Parses a comma-separated list of table:weight pairs, where the weights are positive.
+ */
+StatusOr<absl::flat_hash_map<std::string, double>> ParseTableWeights(std::string_view spec);
+
+/**
+ * TableMemoryBudget splits a memory budget for the whole table store across its tables, and
+ * enforces the split through the maximum size of each table.
+ *
+ * A quarter of the budget is split by the weights of the tables alone, so that every table keeps
+ * some of its data however rarely it is written to. The rest is split by the weights multiplied by
+ * the recent write rate of each table, which keeps the retention of tables with the same weight
+ * about the same. The tablets of a table share its weight.
+ */
+class TableMemoryBudget : public NotCopyable {
+ public:
+  // The share of the budget that is split by the weights alone.
+  static constexpr double kWeightOnlyShare = 0.25;
+  // How much the write rate of a table decays with each rebalance.
+  static constexpr double kWriteRateDecay = 0.5;
+
+  /**
+   * @param budget_bytes the number of bytes that all of the tables can hold together.
+   * @param table_weights the weights of the tables by name. Tables without a weight get a weight
+   * of 1.
+   */
+  TableMemoryBudget(int64_t budget_bytes, absl::flat_hash_map<std::string, double> table_weights)
+      : budget_bytes_(budget_bytes), table_weights_(std::move(table_weights)) {}
+
+  /**
+   * Splits the budget across the tables, based on the writes since the last rebalance, and sets
+   * the maximum size of each table to its allocation. Tables that shrink expire their oldest
+   * batches right away.
+   */
+  Status Rebalance(const std::vector<std::shared_ptr<Table>>& tables);
+
+  /**
+   * @return the allocation of the table from the last rebalance, or -1 if it had none.
+   */
+  int64_t allocation(const Table* table) const;
+
+ private:
+  struct TableUsage {
+    int64_t bytes_added = 0;
+    // The decayed number of bytes written per rebalance.
+    double write_rate = 0;
+    int64_t allocation = -1;
+  };
+
+  double Weight(const std::string& table_name) const;
+
+  const int64_t budget_bytes_;
+  const absl::flat_hash_map<std::string, double> table_weights_;
+  absl::flat_hash_map<const Table*, TableUsage> usage_;
+};
+
+}  // namespace table_store
+}  // namespace px
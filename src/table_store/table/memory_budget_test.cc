@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/table/memory_budget.h"
+
+namespace px {
+namespace table_store {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(ParseTableWeightsTest, parses_weights) {
+  ASSERT_OK_AND_ASSIGN(auto weights, ParseTableWeights("http_events:4, network_stats:0.5"));
+  EXPECT_THAT(weights, UnorderedElementsAre(Pair("http_events", 4), Pair("network_stats", 0.5)));
+  ASSERT_OK_AND_ASSIGN(weights, ParseTableWeights(""));
+  EXPECT_TRUE(weights.empty());
+
+  EXPECT_NOT_OK(ParseTableWeights("http_events"));
+  EXPECT_NOT_OK(ParseTableWeights("http_events:abc"));
+  EXPECT_NOT_OK(ParseTableWeights("http_events:0"));
+}
+
+class TableMemoryBudgetTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<Table> MakeTable(std::string_view name) {
+    return std::make_shared<Table>(name, rel_, /* max_table_size */ 1000);
+  }
+
+  // Writes a batch of 12 INT64 values, which is 96 bytes.
+  void Write(Table* table) {
+    schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), 12);
+    std::vector<types::Int64Value> values(12, 1);
+    ASSERT_OK(rb.AddColumn(types::ToArrow(values, arrow::default_memory_pool())));
+    ASSERT_OK(table->WriteRowBatch(rb));
+  }
+
+  schema::Relation rel_{{types::DataType::INT64}, {"col1"}};
+};
+
+TEST_F(TableMemoryBudgetTest, splits_by_weights_and_write_rates) {
+  TableMemoryBudget budget(1000, {{"a", 3}});
+  auto table_a = MakeTable("a");
+  auto table_b = MakeTable("b");
+  Write(table_b.get());
+  Write(table_b.get());
+
+  // Nothing was written since the tables were first seen, so the budget is split by the weights.
+  ASSERT_OK(budget.Rebalance({table_a, table_b}));
+  EXPECT_EQ(750, budget.allocation(table_a.get()));
+  EXPECT_EQ(250, budget.allocation(table_b.get()));
+  EXPECT_EQ(250, table_b->GetTableStats().max_table_size);
+  EXPECT_EQ(192, table_b->GetTableStats().bytes);
+
+  // Only table a was written to since, so it gets all of the budget that is split by write rates.
+  Write(table_a.get());
+  ASSERT_OK(budget.Rebalance({table_a, table_b}));
+  EXPECT_EQ(187 + 750, budget.allocation(table_a.get()));
+  EXPECT_EQ(62, budget.allocation(table_b.get()));
+
+  // Table b shrinks to its allocation right away.
+  EXPECT_EQ(0, table_b->GetTableStats().bytes);
+  EXPECT_EQ(2, table_b->GetTableStats().batches_expired);
+  EXPECT_EQ(96, table_a->GetTableStats().bytes);
+}
+
+TEST_F(TableMemoryBudgetTest, tablets_share_weights) {
+  TableMemoryBudget budget(900, {{"a", 2}});
+  auto tablet_a1 = MakeTable("a");
+  auto tablet_a2 = MakeTable("a");
+  auto table_b = MakeTable("b");
+
+  ASSERT_OK(budget.Rebalance({tablet_a1, tablet_a2, table_b}));
+  EXPECT_EQ(300, budget.allocation(tablet_a1.get()));
+  EXPECT_EQ(300, budget.allocation(tablet_a2.get()));
+  EXPECT_EQ(300, budget.allocation(table_b.get()));
+
+  // Tables that are gone are forgotten.
+  ASSERT_OK(budget.Rebalance({table_b}));
+  EXPECT_EQ(-1, budget.allocation(tablet_a1.get()));
+  EXPECT_EQ(900, budget.allocation(table_b.get()));
+}
+
+}  // namespace table_store
+}  // namespace px
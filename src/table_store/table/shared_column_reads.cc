@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/table_store/table/shared_column_reads.h"
+
+#include <memory>
+
+DEFINE_int32(table_store_shared_scan_window_ms,
+             gflags::Int32FromEnv("PL_TABLE_STORE_SHARED_SCAN_WINDOW_MS", 1000),
+             "How long the columns that a query converts or decodes from a batch of a table are "
+             "kept for other queries that scan the same batch. 0 only shares the columns while "
+             "they are being read.");
+DEFINE_int64(table_store_shared_scan_max_bytes,
+             gflags::Int64FromEnv("PL_TABLE_STORE_SHARED_SCAN_MAX_BYTES", 16 * 1024 * 1024),
+             "The maximum number of bytes of the columns that each table keeps for the queries "
+             "that scan the same batches, see --table_store_shared_scan_window_ms.");
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+int64_t ArrayBytes(const arrow::Array& array) {
+  int64_t bytes = 0;
+  for (const auto& buffer : array.data()->buffers) {
+    if (buffer != nullptr) {
+      bytes += buffer->size();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+StatusOr<std::shared_ptr<arrow::Array>> SharedColumnReads::Read(const Key& key,
+                                                                const ReadFn& read_fn,
+                                                                bool* shared) {
+  EntryPtr entry;
+  {
+    absl::MutexLock lock(&lock_);
+    EvictUnlocked(std::chrono::steady_clock::now());
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      entry = it->second;
+      lock_.Await(absl::Condition(&entry->done));
+      if (shared != nullptr) {
+        *shared = true;
+      }
+      PL_RETURN_IF_ERROR(entry->status);
+      return entry->array;
+    }
+    entry = std::make_shared<Entry>();
+    entries_[key] = entry;
+  }
+  if (shared != nullptr) {
+    *shared = false;
+  }
+
+  // The column is read without the lock, so that the reads of other columns go on meanwhile.
+  StatusOr<std::shared_ptr<arrow::Array>> array_or = read_fn();
+
+  absl::MutexLock lock(&lock_);
+  entry->done = true;
+  if (!array_or.ok()) {
+    entry->status = array_or.status();
+    EraseUnlocked(key, entry);
+    return array_or;
+  }
+  entry->array = array_or.ValueOrDie();
+  entry->bytes = ArrayBytes(*entry->array);
+  entry->done_time = std::chrono::steady_clock::now();
+  kept_entries_.emplace_back(key, entry);
+  bytes_ += entry->bytes;
+  EvictUnlocked(entry->done_time);
+  return entry->array;
+}
+
+int64_t SharedColumnReads::bytes() const {
+  absl::MutexLock lock(&lock_);
+  return bytes_;
+}
+
+void SharedColumnReads::EvictUnlocked(std::chrono::steady_clock::time_point now) {
+  while (!kept_entries_.empty()) {
+    auto& [key, entry] = kept_entries_.front();
+    if (entry->done_time + window_ > now && bytes_ <= max_bytes_) {
+      break;
+    }
+    bytes_ -= entry->bytes;
+    EraseUnlocked(key, entry);
+    kept_entries_.pop_front();
+  }
+}
+
+void SharedColumnReads::EraseUnlocked(const Key& key, const EntryPtr& entry) {
+  // The key may have been read again since, by a later entry.
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second == entry) {
+    entries_.erase(it);
+  }
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/array.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(table_store_shared_scan_window_ms);
+DECLARE_int64(table_store_shared_scan_max_bytes);
+
+namespace px {
+namespace table_store {
+
+/**
+ * SharedColumnReads lets the scans of concurrent queries share the columns they read from the same
+ * batch of a table, e.g. when several dashboards refresh at once. The first scan to read the column
+ * converts or decodes it, and the scans that ask for it while it does wait for its result instead
+ * of repeating the work. Each query then applies its own filters to the shared (immutable) arrays.
+ *
+ * Read columns are kept for a short window after they are read, so that scans that trail each
+ * other slightly also share them, up to a maximum number of bytes.
+ */
+class SharedColumnReads : public NotCopyable {
+ public:
+  // Identifies the column of a batch by the unique IDs of the first and last rows of the batch,
+  // which tell apart a hot batch from the cold batch it was compacted into.
+  struct Key {
+    int64_t first_row_id;
+    int64_t last_row_id;
+    int64_t col_idx;
+
+    bool operator==(const Key& other) const {
+      return first_row_id == other.first_row_id && last_row_id == other.last_row_id &&
+             col_idx == other.col_idx;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.first_row_id, key.last_row_id, key.col_idx);
+    }
+  };
+  using ReadFn = std::function<StatusOr<std::shared_ptr<arrow::Array>>()>;
+
+  /**
+   * @param window how long a column is kept after it was read. 0 only shares reads in flight.
+   * @param max_bytes the maximum number of bytes of the columns that are kept.
+   */
+  SharedColumnReads(std::chrono::milliseconds window, int64_t max_bytes)
+      : window_(window), max_bytes_(max_bytes) {}
+
+  /**
+   * Returns the column that another scan read or is reading, or reads it with read_fn. Failed
+   * reads aren't kept, the next scan to ask for the column reads it again.
+   * @param shared set to whether the column was read by another scan, if not null.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> Read(const Key& key, const ReadFn& read_fn,
+                                               bool* shared = nullptr);
+
+  // The number of bytes of the columns that are kept.
+  int64_t bytes() const;
+
+ private:
+  struct Entry {
+    bool done = false;
+    Status status;
+    std::shared_ptr<arrow::Array> array;
+    int64_t bytes = 0;
+    std::chrono::steady_clock::time_point done_time;
+  };
+  using EntryPtr = std::shared_ptr<Entry>;
+
+  // Drops the kept columns that are past the window, and the oldest ones while over max_bytes_.
+  void EvictUnlocked(std::chrono::steady_clock::time_point now)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void EraseUnlocked(const Key& key, const EntryPtr& entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const std::chrono::milliseconds window_;
+  const int64_t max_bytes_;
+
+  mutable absl::Mutex lock_;
+  absl::flat_hash_map<Key, EntryPtr> entries_ ABSL_GUARDED_BY(lock_);
+  // The entries that were read and are kept, oldest first.
+  std::deque<std::pair<Key, EntryPtr>> kept_entries_ ABSL_GUARDED_BY(lock_);
+  int64_t bytes_ ABSL_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <absl/synchronization/notification.h>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/shared_column_reads.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+// 10 INT64 values, which is 80 bytes.
+std::shared_ptr<arrow::Array> MakeColumn() {
+  std::vector<types::Int64Value> values(10, 1);
+  return types::ToArrow(values, arrow::default_memory_pool());
+}
+
+}  // namespace
+
+TEST(SharedColumnReadsTest, concurrent_reads_share_the_column) {
+  SharedColumnReads reads(std::chrono::milliseconds(0), /* max_bytes */ 0);
+  const SharedColumnReads::Key key{0, 9, 1};
+
+  absl::Notification reading;
+  absl::Notification finish_read;
+  int num_reads = 0;
+  auto column = MakeColumn();
+  auto read_fn = [&]() -> StatusOr<std::shared_ptr<arrow::Array>> {
+    ++num_reads;
+    reading.Notify();
+    finish_read.WaitForNotification();
+    return column;
+  };
+
+  std::shared_ptr<arrow::Array> first;
+  std::thread first_reader([&]() { first = reads.Read(key, read_fn).ConsumeValueOrDie(); });
+  reading.WaitForNotification();
+
+  bool shared = false;
+  std::shared_ptr<arrow::Array> second;
+  std::thread second_reader(
+      [&]() { second = reads.Read(key, read_fn, &shared).ConsumeValueOrDie(); });
+  // Let the second reader wait for the first one.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  finish_read.Notify();
+  first_reader.join();
+  second_reader.join();
+
+  EXPECT_EQ(num_reads, 1);
+  EXPECT_TRUE(shared);
+  EXPECT_EQ(first, column);
+  EXPECT_EQ(second, column);
+
+  // Nothing is kept without a window, the next read reads the column again.
+  EXPECT_EQ(reads.bytes(), 0);
+  ASSERT_OK(reads.Read(key, read_fn, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(num_reads, 2);
+}
+
+TEST(SharedColumnReadsTest, keeps_columns_within_window_and_bytes) {
+  SharedColumnReads reads(std::chrono::milliseconds(60000), /* max_bytes */ 160);
+  int num_reads = 0;
+  auto read_fn = [&num_reads]() -> StatusOr<std::shared_ptr<arrow::Array>> {
+    ++num_reads;
+    return MakeColumn();
+  };
+
+  bool shared = false;
+  ASSERT_OK(reads.Read({0, 9, 0}, read_fn, &shared));
+  EXPECT_FALSE(shared);
+  ASSERT_OK(reads.Read({0, 9, 0}, read_fn, &shared));
+  EXPECT_TRUE(shared);
+  EXPECT_EQ(num_reads, 1);
+
+  // Columns of other batches and other columns of the same batch are read on their own.
+  ASSERT_OK(reads.Read({0, 99, 0}, read_fn, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(reads.bytes(), 160);
+
+  // Going over max_bytes evicts the oldest column.
+  ASSERT_OK(reads.Read({0, 9, 1}, read_fn, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(reads.bytes(), 160);
+  ASSERT_OK(reads.Read({0, 9, 0}, read_fn, &shared));
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(num_reads, 4);
+}
+
+TEST(SharedColumnReadsTest, failed_reads_are_not_kept) {
+  SharedColumnReads reads(std::chrono::milliseconds(60000), /* max_bytes */ 1024);
+  int num_reads = 0;
+  auto failing_read_fn = [&num_reads]() -> StatusOr<std::shared_ptr<arrow::Array>> {
+    ++num_reads;
+    return error::Internal("decode failed");
+  };
+
+  EXPECT_NOT_OK(reads.Read({0, 9, 0}, failing_read_fn));
+  EXPECT_NOT_OK(reads.Read({0, 9, 0}, failing_read_fn));
+  EXPECT_EQ(num_reads, 2);
+  EXPECT_EQ(reads.bytes(), 0);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/spill_tier.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+// Buffers are aligned the way arrow aligns the buffers it allocates.
+constexpr int64_t kBufferAlignment = 64;
+
+int64_t AlignUp(int64_t size) { return (size + kBufferAlignment - 1) & ~(kBufferAlignment - 1); }
+
+}  // namespace
+
+/**
+ * A memory mapped segment file, which is unmapped and closed once neither the tier nor any array
+ * read from it references it.
+ */
+class SpillTier::Segment : public NotCopyable {
+ public:
+  static StatusOr<std::shared_ptr<Segment>> Create(const std::string& dir, int64_t capacity) {
+    int fd = open(dir.c_str(), O_TMPFILE | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+      return error::System("Failed to create a spill segment in $0: $1", dir,
+                           std::strerror(errno));
+    }
+    // The file is sparse, only the bytes written to it take up disk space.
+    if (ftruncate(fd, capacity) != 0) {
+      close(fd);
+      return error::System("Failed to size a spill segment in $0: $1", dir, std::strerror(errno));
+    }
+    void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, /* offset */ 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return error::System("Failed to map a spill segment in $0: $1", dir, std::strerror(errno));
+    }
+    return std::shared_ptr<Segment>(new Segment(fd, static_cast<uint8_t*>(data), capacity));
+  }
+
+  ~Segment() {
+    munmap(data_, capacity_);
+    close(fd_);
+  }
+
+  const uint8_t* data() const { return data_; }
+  int64_t size() const { return size_; }
+  int64_t Remaining() const { return capacity_ - size_; }
+
+  // Copies the bytes to the end of the segment, which must have room for them.
+  // Returns their offset in the segment.
+  int64_t Write(const uint8_t* bytes, int64_t size) {
+    DCHECK_LE(AlignUp(size), Remaining());
+    int64_t offset = size_;
+    std::memcpy(data_ + offset, bytes, size);
+    size_ += AlignUp(size);
+    return offset;
+  }
+
+ private:
+  Segment(int fd, uint8_t* data, int64_t capacity) : fd_(fd), data_(data), capacity_(capacity) {}
+
+  const int fd_;
+  uint8_t* const data_;
+  const int64_t capacity_;
+  int64_t size_ = 0;
+};
+
+namespace {
+
+/**
+ * An arrow::Buffer that references a spill segment in place, and keeps the segment mapped for as
+ * long as the buffer is referenced.
+ */
+class SpillSegmentBuffer : public arrow::Buffer {
+ public:
+  SpillSegmentBuffer(std::shared_ptr<const void> segment, const uint8_t* data, int64_t size)
+      : arrow::Buffer(data, size), segment_(std::move(segment)) {}
+
+ private:
+  std::shared_ptr<const void> segment_;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<SpillTier>> SpillTier::Create(const schema::Relation& relation,
+                                                       const std::string& dir, int64_t max_bytes,
+                                                       int64_t segment_size) {
+  if (max_bytes <= 0 || segment_size <= 0) {
+    return error::InvalidArgument("Spill tier sizes must be positive, got max=$0 segment=$1",
+                                  max_bytes, segment_size);
+  }
+  auto spill_tier =
+      std::unique_ptr<SpillTier>(new SpillTier(relation, dir, max_bytes, segment_size));
+  // Fail early if the directory can't hold segments.
+  PL_RETURN_IF_ERROR(spill_tier->StartSegment(0));
+  return spill_tier;
+}
+
+Status SpillTier::StartSegment(int64_t min_size) {
+  PL_ASSIGN_OR_RETURN(active_segment_,
+                      Segment::Create(dir_, std::max(segment_size_, AlignUp(min_size))));
+  return Status::OK();
+}
+
+StatusOr<int64_t> SpillTier::Append(const std::vector<ArrowArrayPtr>& columns,
+                                    std::vector<ColumnZoneMap> zone_maps, Interval row_ids) {
+  DCHECK_EQ(columns.size(), relation_.NumColumns());
+  int64_t batch_bytes = 0;
+  for (const auto& col : columns) {
+    // Cold batches are built from scratch, so their columns are neither sliced nor nested.
+    DCHECK_EQ(0, col->offset());
+    DCHECK(col->data()->child_data.empty());
+    for (const auto& buffer : col->data()->buffers) {
+      if (buffer != nullptr) {
+        batch_bytes += AlignUp(buffer->size());
+      }
+    }
+  }
+  if (active_segment_ == nullptr || active_segment_->Remaining() < batch_bytes) {
+    PL_RETURN_IF_ERROR(StartSegment(batch_bytes));
+  }
+
+  SpilledBatch batch;
+  batch.segment = active_segment_;
+  batch.zone_maps = std::move(zone_maps);
+  for (const auto& col : columns) {
+    SpilledColumn spilled_column;
+    spilled_column.null_count = col->null_count();
+    for (const auto& buffer : col->data()->buffers) {
+      SpilledBuffer spilled_buffer;
+      if (buffer != nullptr) {
+        spilled_buffer.offset = active_segment_->Write(buffer->data(), buffer->size());
+        spilled_buffer.size = buffer->size();
+      }
+      spilled_column.buffers.push_back(spilled_buffer);
+    }
+    batch.columns.push_back(std::move(spilled_column));
+  }
+  bytes_ += batch_bytes;
+  batches_.push_back(std::move(batch));
+  row_ids_.push_back(row_ids);
+
+  int64_t dropped = 0;
+  while (bytes_ > max_bytes_ && !batches_.empty()) {
+    dropped += DropOldestSegment();
+  }
+  return dropped;
+}
+
+int64_t SpillTier::DropOldestSegment() {
+  auto segment = batches_.front().segment;
+  int64_t dropped = 0;
+  while (!batches_.empty() && batches_.front().segment == segment) {
+    batches_.pop_front();
+    row_ids_.pop_front();
+    ++dropped;
+  }
+  bytes_ -= segment->size();
+  if (segment == active_segment_) {
+    active_segment_.reset();
+  }
+  return dropped;
+}
+
+SpillTier::ArrowArrayPtr SpillTier::Column(int64_t batch_index, int64_t col_idx) const {
+  const auto& batch = batches_[batch_index];
+  const auto& column = batch.columns[col_idx];
+  std::vector<std::shared_ptr<arrow::Buffer>> buffers;
+  for (const auto& spilled_buffer : column.buffers) {
+    if (spilled_buffer.offset == -1) {
+      buffers.push_back(nullptr);
+      continue;
+    }
+    buffers.push_back(std::make_shared<SpillSegmentBuffer>(
+        batch.segment, batch.segment->data() + spilled_buffer.offset, spilled_buffer.size));
+  }
+  auto array_data =
+      arrow::ArrayData::Make(types::DataTypeToArrowType(relation_.GetColumnType(col_idx)),
+                             BatchLength(batch_index), std::move(buffers), column.null_count);
+  return arrow::MakeArray(array_data);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * SpillTier holds the batches that a table expires from memory in files on a local disk, e.g. a
+ * hostPath volume, so that they can still be read. Batches are appended to memory mapped segment
+ * files, and their columns reference the mappings in place, so their pages are held by the page
+ * cache rather than by the table. Whole segments are dropped, oldest first, to keep the tier within
+ * its size limit.
+ *
+ * The segment files are unnamed (O_TMPFILE), so they are removed when the process exits, even if
+ * it crashes. The tier only lives as long as the process, like the rest of the table.
+ *
+ * SpillTier isn't thread-safe, the table synchronizes access to it.
+ */
+class SpillTier : public NotCopyable {
+ public:
+  using ArrowArrayPtr = std::shared_ptr<arrow::Array>;
+  using Interval = std::pair<int64_t, int64_t>;
+
+  static constexpr int64_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+  /**
+   * @param relation the relation of the table.
+   * @param dir the directory to create the segment files in.
+   * @param max_bytes the maximum number of bytes that the segments can hold.
+   * @param segment_size the size of each segment file. Larger batches get a segment of their own.
+   */
+  static StatusOr<std::unique_ptr<SpillTier>> Create(const schema::Relation& relation,
+                                                     const std::string& dir, int64_t max_bytes,
+                                                     int64_t segment_size = kDefaultSegmentSize);
+
+  /**
+   * Appends a batch after the batches held, and drops the oldest segments if the tier then holds
+   * more than its size limit.
+   * @param columns the plain (not encoded) columns of the batch.
+   * @param zone_maps the zone maps of the columns.
+   * @param row_ids the unique IDs of the first and last rows of the batch.
+   * @return the number of batches dropped.
+   */
+  StatusOr<int64_t> Append(const std::vector<ArrowArrayPtr>& columns,
+                           std::vector<ColumnZoneMap> zone_maps, Interval row_ids);
+
+  /**
+   * @return the column of the batch, which references the segment in place.
+   */
+  ArrowArrayPtr Column(int64_t batch_index, int64_t col_idx) const;
+  const ColumnZoneMap& ZoneMap(int64_t batch_index, int64_t col_idx) const {
+    return batches_[batch_index].zone_maps[col_idx];
+  }
+  int64_t BatchLength(int64_t batch_index) const {
+    return row_ids_[batch_index].second - row_ids_[batch_index].first + 1;
+  }
+
+  int64_t NumBatches() const { return static_cast<int64_t>(batches_.size()); }
+  // The number of bytes written to the segments held.
+  int64_t Bytes() const { return bytes_; }
+
+  // The unique row IDs of the batches, oldest first. Indexed like the batches.
+  const std::deque<Interval>& row_ids() const { return row_ids_; }
+
+ private:
+  class Segment;
+
+  struct SpilledBuffer {
+    // The offset of the buffer in the segment, -1 for a null buffer.
+    int64_t offset = -1;
+    int64_t size = 0;
+  };
+  struct SpilledColumn {
+    std::vector<SpilledBuffer> buffers;
+    int64_t null_count = 0;
+  };
+  struct SpilledBatch {
+    std::shared_ptr<Segment> segment;
+    std::vector<SpilledColumn> columns;
+    std::vector<ColumnZoneMap> zone_maps;
+  };
+
+  SpillTier(const schema::Relation& relation, std::string dir, int64_t max_bytes,
+            int64_t segment_size)
+      : relation_(relation),
+        dir_(std::move(dir)),
+        max_bytes_(max_bytes),
+        segment_size_(segment_size) {}
+
+  Status StartSegment(int64_t min_size);
+  int64_t DropOldestSegment();
+
+  const schema::Relation relation_;
+  const std::string dir_;
+  const int64_t max_bytes_;
+  const int64_t segment_size_;
+
+  // The segment that batches are appended to.
+  std::shared_ptr<Segment> active_segment_;
+
+  std::deque<SpilledBatch> batches_;
+  std::deque<Interval> row_ids_;
+  int64_t bytes_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
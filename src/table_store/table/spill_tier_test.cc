@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/spill_tier.h"
+
+namespace px {
+namespace table_store {
+
+using Interval = SpillTier::Interval;
+
+namespace {
+
+std::vector<std::shared_ptr<arrow::Array>> TestBatch(int64_t first_time) {
+  std::vector<types::Time64NSValue> times = {first_time, first_time + 1, first_time + 2};
+  std::vector<types::StringValue> names = {"a", "bb", "ccc"};
+  return {types::ToArrow(times, arrow::default_memory_pool()),
+          types::ToArrow(names, arrow::default_memory_pool())};
+}
+
+// Appends the test batch, with row IDs equal to its times.
+StatusOr<int64_t> AppendTestBatch(SpillTier* spill_tier, int64_t first_time) {
+  auto batch = TestBatch(first_time);
+  std::vector<ColumnZoneMap> zone_maps = {
+      ColumnZoneMap::Compute(types::DataType::TIME64NS, batch[0].get()),
+      ColumnZoneMap::Compute(types::DataType::STRING, batch[1].get())};
+  return spill_tier->Append(batch, std::move(zone_maps), Interval(first_time, first_time + 2));
+}
+
+}  // namespace
+
+class SpillTierTest : public ::testing::Test {
+ protected:
+  schema::Relation rel_{{types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "name"}};
+  px::testing::TempDir dir_;
+};
+
+TEST_F(SpillTierTest, reads_spilled_batches_in_place) {
+  ASSERT_OK_AND_ASSIGN(auto spill_tier, SpillTier::Create(rel_, dir_.path().string(), 1024 * 1024));
+  ASSERT_OK_AND_EQ(AppendTestBatch(spill_tier.get(), 10), 0);
+
+  EXPECT_EQ(1, spill_tier->NumBatches());
+  EXPECT_EQ(3, spill_tier->BatchLength(0));
+  EXPECT_GT(spill_tier->Bytes(), 0);
+  auto batch = TestBatch(10);
+  EXPECT_TRUE(spill_tier->Column(0, 0)->Equals(batch[0]));
+  EXPECT_TRUE(spill_tier->Column(0, 1)->Equals(batch[1]));
+  EXPECT_EQ(10, spill_tier->ZoneMap(0, 0).int_min);
+  EXPECT_EQ(12, spill_tier->ZoneMap(0, 0).int_max);
+  EXPECT_THAT(spill_tier->row_ids(), ::testing::ElementsAre(Interval(10, 12)));
+}
+
+TEST_F(SpillTierTest, drops_oldest_segments) {
+  // Find out how many bytes a batch takes up.
+  ASSERT_OK_AND_ASSIGN(auto probe, SpillTier::Create(rel_, dir_.path().string(), 1024 * 1024));
+  ASSERT_OK(AppendTestBatch(probe.get(), 0));
+  int64_t batch_bytes = probe->Bytes();
+
+  // Each batch gets a segment of its own, and the tier holds two of them.
+  ASSERT_OK_AND_ASSIGN(auto spill_tier, SpillTier::Create(rel_, dir_.path().string(),
+                                                          2 * batch_bytes, /* segment_size */ 1));
+  ASSERT_OK_AND_EQ(AppendTestBatch(spill_tier.get(), 0), 0);
+  ASSERT_OK_AND_EQ(AppendTestBatch(spill_tier.get(), 3), 0);
+  // Arrays read from a dropped segment remain valid.
+  auto first_times = spill_tier->Column(0, 0);
+  ASSERT_OK_AND_EQ(AppendTestBatch(spill_tier.get(), 6), 1);
+
+  EXPECT_EQ(2, spill_tier->NumBatches());
+  EXPECT_EQ(2 * batch_bytes, spill_tier->Bytes());
+  EXPECT_THAT(spill_tier->row_ids(), ::testing::ElementsAre(Interval(3, 5), Interval(6, 8)));
+  EXPECT_TRUE(spill_tier->Column(0, 0)->Equals(TestBatch(3)[0]));
+  EXPECT_TRUE(first_times->Equals(TestBatch(0)[0]));
+}
+
+TEST_F(SpillTierTest, fails_on_missing_dir) {
+  EXPECT_NOT_OK(SpillTier::Create(rel_, (dir_.path() / "missing").string(), 1024));
+}
+
+}  // namespace table_store
+}  // namespace px
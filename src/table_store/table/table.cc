@@ -21,22 +21,48 @@
 #include <cstddef>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 #include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/table/table.h"
+#include "src/table_store/table/delta_encoding.h"
+#include "src/table_store/table/dictionary_encoding.h"
 
 DEFINE_int32(table_store_table_size_limit,
              gflags::Int32FromEnv("PL_TABLE_STORE_TABLE_SIZE_LIMIT", 1024 * 1024 * 64),
              "The maximal size a table allows. When the size grows beyond this limit, "
              "old data will be discarded.");
+DEFINE_bool(table_store_dictionary_encode_strings,
+            gflags::BoolFromEnv("PL_TABLE_STORE_DICTIONARY_ENCODE_STRINGS", false),
+            "Whether to dictionary encode string columns with few distinct values when they are "
+            "compacted into cold storage.");
+DEFINE_double(table_store_dictionary_max_distinct_ratio, 0.5,
+              "The maximum ratio of distinct values to rows for a string column to be dictionary "
+              "encoded in cold storage.");
+DEFINE_bool(table_store_delta_encode_ints,
+            gflags::BoolFromEnv("PL_TABLE_STORE_DELTA_ENCODE_INTS", false),
+            "Whether to delta encode and bit-pack INT64 and TIME64NS columns when they are "
+            "compacted into cold storage.");
+DEFINE_string(table_store_spill_dir, gflags::StringFromEnv("PL_TABLE_STORE_SPILL_DIR", ""),
+              "The directory, e.g. a hostPath volume, that tables spill the batches they expire "
+              "from memory to, so that they can still be queried. Empty disables spilling.");
+DEFINE_int64(table_store_spill_size_limit,
+             gflags::Int64FromEnv("PL_TABLE_STORE_SPILL_SIZE_LIMIT", 1024LL * 1024 * 1024),
+             "The maximal number of bytes each table spills to disk. When the spilled data grows "
+             "beyond this limit, the oldest spilled data will be discarded.");
+DEFINE_string(table_store_spill_tables, gflags::StringFromEnv("PL_TABLE_STORE_SPILL_TABLES", ""),
+              "Comma separated names of the tables that spill to --table_store_spill_dir. All "
+              "tables spill if empty.");
 
 namespace px {
 namespace table_store {
@@ -57,8 +83,12 @@ Status ArrowArrayCompactor::AppendColumnTyped<types::DataType::STRING>(
   auto size = types::GetArrowArrayBytes<types::DataType::STRING>(typed_arr.get());
   PL_RETURN_IF_ERROR(builder->Reserve(typed_arr->length()));
   PL_RETURN_IF_ERROR(builder->ReserveData(size));
+  // Copy straight out of the contiguous value data using the offsets,
+  // rather than materializing a std::string per value.
   for (int i = 0; i < typed_arr->length(); ++i) {
-    builder->UnsafeAppend(typed_arr->GetString(i));
+    int32_t length = 0;
+    const uint8_t* value = typed_arr->GetValue(i, &length);
+    builder->UnsafeAppend(value, length);
   }
   bytes_ += size;
   return Status::OK();
@@ -83,18 +113,30 @@ Status ArrowArrayCompactor::Finish() {
 Table::Table(std::string_view table_name, const schema::Relation& relation, size_t max_table_size,
              size_t min_cold_batch_size)
     : metrics_(&(GetMetricsRegistry()), std::string(table_name)),
+      name_(table_name),
       rel_(relation),
       max_table_size_(max_table_size),
       min_cold_batch_size_(min_cold_batch_size),
-      ring_capacity_(max_table_size / min_cold_batch_size) {
+      ring_capacity_(max_table_size / min_cold_batch_size),
+      shared_reads_(std::chrono::milliseconds(FLAGS_table_store_shared_scan_window_ms),
+                    FLAGS_table_store_shared_scan_max_bytes) {
+  metrics_.max_table_size_gauge.Set(max_table_size);
   absl::MutexLock gen_lock(&generation_lock_);
   absl::MutexLock cold_lock(&cold_lock_);
   absl::MutexLock hot_lock(&hot_lock_);
+  if (!FLAGS_table_store_spill_dir.empty()) {
+    std::vector<std::string_view> spill_tables =
+        absl::StrSplit(FLAGS_table_store_spill_tables, ',', absl::SkipWhitespace());
+    spill_enabled_ = spill_tables.empty() || std::find(spill_tables.begin(), spill_tables.end(),
+                                                       name_) != spill_tables.end();
+  }
   for (const auto& [i, col_name] : Enumerate(rel_.col_names())) {
     if (col_name == "time_" && rel_.GetColumnType(i) == types::DataType::TIME64NS) {
       time_col_idx_ = i;
     }
     cold_column_buffers_.emplace_back(ring_capacity_);
+    cold_zone_maps_.emplace_back(ring_capacity_);
+    cold_encoded_columns_.emplace_back(ring_capacity_);
   }
 }
 
@@ -137,26 +179,41 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(
 }
 
 Status Table::ExpireRowBatches(int64_t row_batch_size) {
-  if (row_batch_size > max_table_size_) {
-    return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
-                                  row_batch_size, max_table_size_);
-  }
   int64_t bytes;
+  int64_t max_table_size;
   {
     absl::base_internal::SpinLockHolder lock(&stats_lock_);
     bytes = cold_bytes_ + hot_bytes_;
+    max_table_size = max_table_size_;
   }
-  while (bytes + row_batch_size > max_table_size_) {
+  if (row_batch_size > max_table_size) {
+    return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
+                                  row_batch_size, max_table_size);
+  }
+  while (bytes + row_batch_size > max_table_size) {
     PL_RETURN_IF_ERROR(ExpireBatch());
+    int64_t expired_bytes;
     {
       absl::base_internal::SpinLockHolder lock(&stats_lock_);
       batches_expired_++;
+      expired_bytes = bytes - (cold_bytes_ + hot_bytes_);
       bytes = cold_bytes_ + hot_bytes_;
     }
+    metrics_.batches_expired_counter.Increment();
+    metrics_.bytes_expired_counter.Increment(std::max<int64_t>(expired_bytes, 0));
   }
   return Status::OK();
 }
 
+Status Table::SetMaxTableSize(int64_t max_table_size) {
+  {
+    absl::base_internal::SpinLockHolder lock(&stats_lock_);
+    max_table_size_ = max_table_size;
+  }
+  metrics_.max_table_size_gauge.Set(max_table_size);
+  return ExpireRowBatches(0);
+}
+
 Status Table::WriteRowBatch(const schema::RowBatch& rb) {
   // Don't write empty row batches.
   if (rb.num_columns() == 0 || rb.ColumnAt(0)->length() == 0) {
@@ -185,6 +242,7 @@ Status Table::WriteRowBatch(const schema::RowBatch& rb) {
   PL_RETURN_IF_ERROR(WriteHot(rb));
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   hot_bytes_ += rb_bytes;
+  bytes_added_ += rb_bytes;
   ++batches_added_;
   return Status::OK();
 }
@@ -220,6 +278,7 @@ Status Table::TransferRecordBatch(
 
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   hot_bytes_ += rb_bytes;
+  bytes_added_ += rb_bytes;
   ++batches_added_;
 
   return Status::OK();
@@ -230,56 +289,38 @@ static inline bool IntervalComparatorLowerBound(const std::pair<int64_t, int64_t
   return interval.second < val;
 }
 
-static inline bool IntervalComparatorUpperBound(int64_t val,
-                                                const std::pair<int64_t, int64_t> interval) {
-  return val < interval.first;
-}
-
 StatusOr<BatchSlice> Table::FindBatchSliceGreaterThanOrEqual(int64_t time,
                                                              arrow::MemoryPool* mem_pool) const {
   if (time_col_idx_ == -1) {
     return error::InvalidArgument(
         "Cannot call FindBatchSliceGreaterThanOrEqual on table without a time column.");
   }
-  absl::MutexLock gen_lock(&generation_lock_);
+  std::optional<TimeIndex::Entry> entry;
+  auto slice = BatchSlice::Invalid();
+  int64_t batch_length;
+  std::vector<PinnedColumn> time_col;
   {
-    absl::MutexLock cold_lock(&cold_lock_);
-    auto it =
-        std::lower_bound(cold_time_.begin(), cold_time_.end(), time, IntervalComparatorLowerBound);
-    if (it != cold_time_.end()) {
-      auto index = std::distance(cold_time_.begin(), it);
-      auto ring_index = RingIndexUnlocked(index);
-      auto time_col = cold_column_buffers_[time_col_idx_][ring_index];
-      auto row_offset = types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(
-          time_col.get(), time);
-      auto row_ids = cold_row_ids_[index];
-      return BatchSlice::Cold(ring_index, row_offset, time_col->length() - 1, generation_,
-                              row_ids.first + row_offset, row_ids.second);
-    }
-  }
-  // If the time wasn't found in the cold batches, we look in the hot batches.
-  absl::MutexLock hot_lock(&hot_lock_);
-  auto it =
-      std::lower_bound(hot_time_.begin(), hot_time_.end(), time, IntervalComparatorLowerBound);
-  if (it == hot_time_.end()) {
-    return BatchSlice::Invalid();
-  }
-  auto index = std::distance(hot_time_.begin(), it);
-
-  ArrowArrayPtr time_col;
-  if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
-    auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
-    time_col = GetHotColumnUnlocked(record_batch_ptr, time_col_idx_, mem_pool);
-  } else {
-    auto row_batch = std::get<schema::RowBatch>(hot_batches_[index]);
-    time_col = row_batch.columns().at(time_col_idx_);
+    absl::MutexLock gen_lock(&generation_lock_);
+    entry = time_index_.FindFirstEndingAtOrAfter(time);
+    if (!entry.has_value()) {
+      return BatchSlice::Invalid();
+    }
+    PL_ASSIGN_OR_RETURN(slice, ResolveTimeIndexEntryUnlocked(entry.value()));
+    time_col = PinColumnsUnlocked(slice, {time_col_idx_}, &batch_length);
   }
-
-  auto row_offset =
-      types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
-  auto row_ids = hot_row_ids_[index];
-  return BatchSlice::Hot(index, row_offset, time_col->length() - 1, generation_,
-                         row_ids.first + row_offset, row_ids.second);
+  // The entry ends at or after the time, so the first row at or after it is among its rows. If the
+  // batch changes in the meantime, the returned slice is resolved again by its row IDs.
+  PL_ASSIGN_OR_RETURN(auto entry_times, ReadPinnedColumn(time_col[0], slice.unsafe_row_start,
+                                                         slice.Size(), mem_pool));
+  auto row_offset = slice.unsafe_row_start +
+                    types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(
+                        entry_times.get(), time);
+  auto batch_first_row_id = entry->first_row_id - slice.unsafe_row_start;
+  slice.unsafe_row_start = row_offset;
+  slice.unsafe_row_end = batch_length - 1;
+  slice.uniq_row_start_idx = batch_first_row_id + row_offset;
+  slice.uniq_row_end_idx = batch_first_row_id + batch_length - 1;
+  return slice;
 }
 
 StatusOr<Table::StopPosition> Table::FindStopPositionForTime(int64_t time,
@@ -288,7 +329,7 @@ StatusOr<Table::StopPosition> Table::FindStopPositionForTime(int64_t time,
     return error::InvalidArgument(
         "Cannot call FindStopPositionForTime on table without a time column.");
   }
-  auto stop = FindStopTime(time, mem_pool);
+  PL_ASSIGN_OR_RETURN(auto stop, FindStopTime(time, mem_pool));
   if (stop == -1) {
     // If all the data is after the stop time then we return the first unique row identifier in the
     // table, which will cause no results to be returned.
@@ -301,16 +342,38 @@ schema::Relation Table::GetRelation() const { return rel_; }
 
 TableStats Table::GetTableStats() const {
   TableStats info;
-  auto num_batches = NumBatches();
-  absl::base_internal::SpinLockHolder lock(&stats_lock_);
+  {
+    // Takes the batch locks once for both of the batch and row counts.
+    absl::MutexLock gen_lock(&generation_lock_);
+    absl::MutexLock cold_lock(&cold_lock_);
+    absl::MutexLock hot_lock(&hot_lock_);
+    info.num_batches = NumSpilledBatchesUnlocked() + RingSizeUnlocked() + hot_batches_.size();
+    info.spilled_bytes = spill_tier_ == nullptr ? 0 : spill_tier_->Bytes();
+    // Row IDs are assigned consecutively, so the rows held are the ones from the first batch on.
+    if (NumSpilledBatchesUnlocked() > 0) {
+      info.num_rows = next_row_id_ - spill_tier_->row_ids().front().first;
+    } else if (ring_back_idx_ != -1) {
+      info.num_rows = next_row_id_ - cold_row_ids_.front().first;
+    } else if (!hot_row_ids_.empty()) {
+      info.num_rows = next_row_id_ - hot_row_ids_.front().first;
+    } else {
+      info.num_rows = 0;
+    }
+  }
+
+  info.batches_added = batches_added_.load(std::memory_order_relaxed);
+  info.bytes_added = bytes_added_.load(std::memory_order_relaxed);
+  info.batches_expired = batches_expired_.load(std::memory_order_relaxed);
+  info.cold_bytes = cold_bytes_.load(std::memory_order_relaxed);
+  info.bytes = hot_bytes_.load(std::memory_order_relaxed) + info.cold_bytes;
+  info.cold_uncompressed_bytes = cold_uncompressed_bytes_.load(std::memory_order_relaxed);
+  info.compacted_batches = compacted_batches_.load(std::memory_order_relaxed);
+  info.max_table_size = max_table_size_.load(std::memory_order_relaxed);
 
-  info.batches_added = batches_added_;
-  info.batches_expired = batches_expired_;
-  info.num_batches = num_batches;
-  info.bytes = hot_bytes_ + cold_bytes_;
-  info.cold_bytes = cold_bytes_;
-  info.compacted_batches = compacted_batches_;
-  info.max_table_size = max_table_size_;
+  std::optional<TimeIndex::Entry> first = time_index_.First();
+  std::optional<TimeIndex::Entry> last = time_index_.Last();
+  info.min_time = first.has_value() ? first->first_time : -1;
+  info.max_time = last.has_value() ? last->last_time : -1;
 
   return info;
 }
@@ -321,7 +384,8 @@ Status Table::UpdateTimeRowIndices(types::ColumnWrapperRecordBatch* record_batch
   if (time_col_idx_ != -1) {
     auto first_time = record_batch->at(time_col_idx_)->Get<types::Time64NSValue>(0);
     auto last_time = record_batch->at(time_col_idx_)->Get<types::Time64NSValue>(batch_length - 1);
-    hot_time_.emplace_back(first_time.val, last_time.val);
+    time_index_.Append({first_time.val, last_time.val, next_row_id_,
+                        next_row_id_ + static_cast<int64_t>(batch_length) - 1});
   }
   auto first_row_id = next_row_id_;
   next_row_id_ += batch_length;
@@ -334,8 +398,7 @@ Status Table::WriteHot(RecordBatchPtr record_batch) {
   PL_RETURN_IF_ERROR(UpdateTimeRowIndices(record_batch.get()));
   auto rb = RecordBatchWithCache{
       std::move(record_batch),
-      std::vector<ArrowArrayPtr>(rel_.NumColumns()),
-      std::vector<bool>(rel_.NumColumns(), false),
+      std::make_shared<std::vector<ArrowArrayPtr>>(rel_.NumColumns()),
   };
   hot_batches_.emplace_back(std::move(rb));
   return Status::OK();
@@ -349,7 +412,7 @@ Status Table::UpdateTimeRowIndices(const schema::RowBatch& rb) {
     auto first_time = types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col.get(), 0);
     auto last_time =
         types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col.get(), batch_length - 1);
-    hot_time_.emplace_back(first_time, last_time);
+    time_index_.Append({first_time, last_time, next_row_id_, next_row_id_ + batch_length - 1});
   }
   auto first_row_id = next_row_id_;
   next_row_id_ += batch_length;
@@ -366,8 +429,6 @@ Status Table::WriteHot(const schema::RowBatch& rb) {
 
 Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
   ArrowArrayCompactor builder(rel_, mem_pool);
-  int64_t first_time = -1;
-  int64_t last_time = -1;
   int64_t first_row_id = -1;
   int64_t last_row_id = -1;
   absl::MutexLock gen_lock(&generation_lock_);
@@ -381,15 +442,10 @@ Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
       }
       std::vector<std::shared_ptr<arrow::Array>> column_arrays;
       if (std::holds_alternative<RecordBatchWithCache>(*it)) {
-        auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&(*it));
+        const auto& record_batch = std::get<RecordBatchWithCache>(*it);
         for (int64_t col_idx = 0; col_idx < static_cast<int64_t>(rel_.NumColumns()); ++col_idx) {
-          if (record_batch_ptr->cache_validity[col_idx]) {
-            PL_RETURN_IF_ERROR(
-                builder.AppendColumn(col_idx, record_batch_ptr->arrow_cache[col_idx]));
-          } else {
-            PL_RETURN_IF_ERROR(builder.AppendColumn(
-                col_idx, record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool)));
-          }
+          PL_RETURN_IF_ERROR(
+              builder.AppendColumn(col_idx, HotColumn(record_batch, col_idx, mem_pool)));
         }
       } else {
         auto row_batch = std::get<schema::RowBatch>(*it);
@@ -405,33 +461,38 @@ Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
 
       it = hot_batches_.erase(it);
       hot_row_ids_.pop_front();
-
-      if (time_col_idx_ != -1) {
-        auto times = hot_time_.front();
-        if (first_time == -1) {
-          first_time = times.first;
-        }
-        last_time = times.second;
-        hot_time_.pop_front();
-      }
     }
   }
   PL_RETURN_IF_ERROR(builder.Finish());
+  std::vector<ColumnZoneMap> zone_maps;
+  std::vector<std::shared_ptr<EncodedColumn>> encoded_columns(rel_.NumColumns());
+  int64_t cold_batch_bytes = builder.Size();
+  zone_maps.reserve(rel_.NumColumns());
+  for (const auto& [col_idx, col] : Enumerate(builder.output_columns())) {
+    zone_maps.push_back(ColumnZoneMap::Compute(rel_.GetColumnType(col_idx), col.get()));
+    PL_ASSIGN_OR_RETURN(encoded_columns[col_idx], EncodeColdColumn(col_idx, col, mem_pool));
+    if (encoded_columns[col_idx] != nullptr) {
+      cold_batch_bytes +=
+          encoded_columns[col_idx]->Bytes() - encoded_columns[col_idx]->UncompressedBytes();
+    }
+  }
   {
     absl::MutexLock cold_lock(&cold_lock_);
     PL_RETURN_IF_ERROR(AdvanceRingBufferUnlocked());
     for (const auto& [col_idx, col] : Enumerate(builder.output_columns())) {
-      cold_column_buffers_[col_idx][ring_back_idx_] = col;
+      if (encoded_columns[col_idx] == nullptr) {
+        cold_column_buffers_[col_idx][ring_back_idx_] = col;
+      }
+      cold_zone_maps_[col_idx][ring_back_idx_] = zone_maps[col_idx];
+      cold_encoded_columns_[col_idx][ring_back_idx_] = std::move(encoded_columns[col_idx]);
     }
     cold_row_ids_.emplace_back(first_row_id, last_row_id);
-    if (time_col_idx_ != -1) {
-      cold_time_.emplace_back(first_time, last_time);
-    }
   }
   {
     absl::base_internal::SpinLockHolder stat_lock(&stats_lock_);
     hot_bytes_ -= builder.Size();
-    cold_bytes_ += builder.Size();
+    cold_bytes_ += cold_batch_bytes;
+    cold_uncompressed_bytes_ += builder.Size();
     compacted_batches_++;
   }
   generation_++;
@@ -440,35 +501,62 @@ Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
 
 Status Table::CompactHotToCold(arrow::MemoryPool* mem_pool) {
   for (size_t i = 0; i < kMaxBatchesPerCompactionCall; ++i) {
-    {
-      absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
-      if (hot_bytes_ < min_cold_batch_size_) {
-        return Status::OK();
-      }
+    PL_ASSIGN_OR_RETURN(bool compacted, CompactNextBatch(mem_pool));
+    if (!compacted) {
+      return Status::OK();
     }
-    PL_RETURN_IF_ERROR(CompactSingleBatch(mem_pool));
   }
 
   return Status::OK();
 }
 
+StatusOr<bool> Table::CompactNextBatch(arrow::MemoryPool* mem_pool) {
+  {
+    absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
+    if (hot_bytes_ < min_cold_batch_size_) {
+      return false;
+    }
+  }
+  PL_RETURN_IF_ERROR(CompactSingleBatch(mem_pool));
+  return true;
+}
+
+int64_t Table::HotBytes() const {
+  absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
+  return hot_bytes_;
+}
+
 StatusOr<bool> Table::ExpireCold() {
   int64_t rb_bytes = 0;
+  int64_t rb_uncompressed_bytes = 0;
   {
     absl::MutexLock gen_lock(&generation_lock_);
     absl::MutexLock cold_lock(&cold_lock_);
     if (RingSizeUnlocked() == 0) {
       return false;
     }
+    bool spilled = false;
+    if (spill_enabled_) {
+      auto status = SpillColdFrontUnlocked();
+      if (status.ok()) {
+        spilled = true;
+      } else {
+        LOG(ERROR) << absl::Substitute("Table $0 stops spilling to disk: $1", name_, status.msg());
+        spill_enabled_ = false;
+      }
+    }
+    // Spilled batches are still searched by time, unless the batch couldn't be spilled, in which
+    // case the older spilled batches aren't contiguous with the rest of the table anymore.
+    time_index_.ExpireBefore(spilled ? spill_tier_->row_ids().front().first
+                                     : cold_row_ids_.front().second + 1);
     cold_row_ids_.pop_front();
-    if (time_col_idx_ != -1) cold_time_.pop_front();
 
     for (size_t col_idx = 0; col_idx < rel_.NumColumns(); col_idx++) {
-#define TYPE_CASE(_dt_) \
-  rb_bytes += types::GetArrowArrayBytes<_dt_>(cold_column_buffers_[col_idx][ring_front_idx_].get());
-      PL_SWITCH_FOREACH_DATATYPE(rel_.GetColumnType(col_idx), TYPE_CASE);
-#undef TYPE_CASE
+      rb_bytes += ColdColumnBytesUnlocked(col_idx, ring_front_idx_);
+      rb_uncompressed_bytes += ColdColumnUncompressedBytesUnlocked(col_idx, ring_front_idx_);
       cold_column_buffers_[col_idx][ring_front_idx_].reset();
+      cold_encoded_columns_[col_idx][ring_front_idx_].reset();
+      cold_zone_maps_[col_idx][ring_front_idx_] = ColumnZoneMap();
     }
     if (ring_front_idx_ == ring_back_idx_) {
       // The batch we are expiring is the last batch in the ring buffer, so we reset the indices.
@@ -481,9 +569,41 @@ StatusOr<bool> Table::ExpireCold() {
   }
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   cold_bytes_ -= rb_bytes;
+  cold_uncompressed_bytes_ -= rb_uncompressed_bytes;
   return true;
 }
 
+Status Table::SpillColdFrontUnlocked() {
+  if (spill_tier_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(spill_tier_, SpillTier::Create(rel_, FLAGS_table_store_spill_dir,
+                                                       FLAGS_table_store_spill_size_limit));
+  }
+  auto length = ColdBatchLengthUnlocked(ring_front_idx_);
+  std::vector<ArrowArrayPtr> columns;
+  std::vector<ColumnZoneMap> zone_maps;
+  for (size_t col_idx = 0; col_idx < rel_.NumColumns(); col_idx++) {
+    const auto& encoded = cold_encoded_columns_[col_idx][ring_front_idx_];
+    if (encoded != nullptr) {
+      // Spilled columns are read in place, so they are spilled decoded.
+      PL_ASSIGN_OR_RETURN(auto arr, encoded->Decode(0, length, arrow::default_memory_pool()));
+      columns.push_back(std::move(arr));
+    } else {
+      columns.push_back(cold_column_buffers_[col_idx][ring_front_idx_]);
+    }
+    zone_maps.push_back(cold_zone_maps_[col_idx][ring_front_idx_]);
+  }
+  // Dropping the oldest spilled batches moves the others, the caller increments the generation.
+  PL_ASSIGN_OR_RETURN(int64_t dropped,
+                      spill_tier_->Append(columns, std::move(zone_maps), cold_row_ids_.front()));
+  metrics_.spilled_batches_counter.Increment();
+  metrics_.spilled_batches_dropped_counter.Increment(dropped);
+  return Status::OK();
+}
+
+int64_t Table::NumSpilledBatchesUnlocked() const {
+  return spill_tier_ == nullptr ? 0 : spill_tier_->NumBatches();
+}
+
 Status Table::ExpireHot() {
   RecordOrRowBatch record_or_row_batch;
   {
@@ -492,7 +612,7 @@ Status Table::ExpireHot() {
     if (hot_batches_.size() == 0) {
       return error::InvalidArgument("Failed to expire row batch, no row batches in table");
     }
-    if (time_col_idx_ != -1) hot_time_.pop_front();
+    time_index_.ExpireBefore(hot_row_ids_.front().second + 1);
     hot_row_ids_.pop_front();
     record_or_row_batch = std::move(hot_batches_.front());
     hot_batches_.pop_front();
@@ -534,59 +654,170 @@ Status Table::ExpireBatch() {
 Status Table::AddBatchSliceToRowBatch(const BatchSlice& slice, const std::vector<int64_t>& cols,
                                       schema::RowBatch* output_rb,
                                       arrow::MemoryPool* mem_pool) const {
-  absl::MutexLock gen_lock(&generation_lock_);
-  PL_RETURN_IF_ERROR(UpdateSliceUnlocked(slice));
-  // After this point, as long as gen_lock is held, the unsafe properties of slice are valid.
+  std::vector<PinnedColumn> columns;
+  int64_t row_start;
+  int64_t num_rows;
+  {
+    absl::MutexLock gen_lock(&generation_lock_);
+    PL_RETURN_IF_ERROR(UpdateSliceUnlocked(slice));
+    // After this point, as long as gen_lock is held, the unsafe properties of slice are valid.
+    row_start = slice.unsafe_row_start;
+    num_rows = slice.unsafe_row_end + 1 - slice.unsafe_row_start;
+    columns = PinColumnsUnlocked(slice, cols, /* batch_length */ nullptr);
+  }
+  // The pinned columns are read without holding any lock.
+  for (const auto& column : columns) {
+    PL_ASSIGN_OR_RETURN(auto arr, ReadPinnedColumn(column, row_start, num_rows, mem_pool));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
+  }
+  return Status::OK();
+}
+
+std::vector<Table::PinnedColumn> Table::PinColumnsUnlocked(const BatchSlice& slice,
+                                                           const std::vector<int64_t>& cols,
+                                                           int64_t* batch_length) const {
+  std::vector<PinnedColumn> columns(cols.size());
   if (!slice.unsafe_is_hot) {
     absl::MutexLock cold_lock(&cold_lock_);
-    for (auto col_idx : cols) {
-      auto arr = cold_column_buffers_[col_idx][slice.unsafe_batch_index]->Slice(
-          slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
-      PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
+    if (slice.unsafe_is_spilled) {
+      for (const auto& [i, col_idx] : Enumerate(cols)) {
+        columns[i].array = spill_tier_->Column(slice.unsafe_batch_index, col_idx);
+      }
+      if (batch_length != nullptr) {
+        *batch_length = spill_tier_->BatchLength(slice.unsafe_batch_index);
+      }
+      return columns;
     }
-    return Status::OK();
+    const auto& row_ids = cold_row_ids_[RingVectorIndexUnlocked(slice.unsafe_batch_index)];
+    for (const auto& [i, col_idx] : Enumerate(cols)) {
+      columns[i].encoded = cold_encoded_columns_[col_idx][slice.unsafe_batch_index];
+      if (columns[i].encoded == nullptr) {
+        columns[i].array = cold_column_buffers_[col_idx][slice.unsafe_batch_index];
+      }
+      columns[i].col_idx = col_idx;
+      columns[i].batch_row_ids = row_ids;
+    }
+    if (batch_length != nullptr) {
+      *batch_length = ColdBatchLengthUnlocked(slice.unsafe_batch_index);
+    }
+    return columns;
   }
 
   absl::MutexLock hot_lock(&hot_lock_);
-  if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[slice.unsafe_batch_index])) {
-    auto record_batch_ptr =
-        std::get_if<RecordBatchWithCache>(&hot_batches_[slice.unsafe_batch_index]);
-    for (auto col_idx : cols) {
-      if (record_batch_ptr->cache_validity[col_idx]) {
-        auto arr = record_batch_ptr->arrow_cache[col_idx]->Slice(
-            slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
-        PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
-        continue;
+  const auto& hot_batch = hot_batches_[slice.unsafe_batch_index];
+  const auto& row_ids = hot_row_ids_[slice.unsafe_batch_index];
+  for (const auto& [i, col_idx] : Enumerate(cols)) {
+    if (std::holds_alternative<RecordBatchWithCache>(hot_batch)) {
+      // Arrow conversion is left to the reader, so that it doesn't happen under the hot lock.
+      columns[i].hot_batch = std::get<RecordBatchWithCache>(hot_batch);
+      columns[i].col_idx = col_idx;
+      columns[i].batch_row_ids = row_ids;
+    } else {
+      columns[i].array = std::get<schema::RowBatch>(hot_batch).ColumnAt(col_idx);
+    }
+  }
+  if (batch_length != nullptr) {
+    *batch_length = HotBatchLengthUnlocked(slice.unsafe_batch_index);
+  }
+  return columns;
+}
+
+StatusOr<Table::ArrowArrayPtr> Table::ReadPinnedColumn(const PinnedColumn& column,
+                                                       int64_t row_start, int64_t num_rows,
+                                                       arrow::MemoryPool* mem_pool) const {
+  const SharedColumnReads::Key key{column.batch_row_ids.first, column.batch_row_ids.second,
+                                   column.col_idx};
+  bool shared = false;
+  if (column.encoded != nullptr) {
+    // Only whole batches are shared, the first and last batches of a scan are usually partial.
+    if (row_start != 0 || num_rows != column.encoded->length()) {
+      return column.encoded->Decode(row_start, num_rows, mem_pool);
+    }
+    auto arr_or = shared_reads_.Read(
+        key, [&]() { return column.encoded->Decode(row_start, num_rows, mem_pool); }, &shared);
+    if (shared) {
+      metrics_.shared_column_reads_counter.Increment();
+    }
+    return arr_or;
+  }
+  if (column.hot_batch.has_value()) {
+    auto arr = std::atomic_load(&(*column.hot_batch->arrow_cache)[column.col_idx]);
+    if (arr == nullptr) {
+      PL_ASSIGN_OR_RETURN(arr, shared_reads_.Read(
+                                   key,
+                                   [&]() -> StatusOr<ArrowArrayPtr> {
+                                     return HotColumn(column.hot_batch.value(), column.col_idx,
+                                                      mem_pool);
+                                   },
+                                   &shared));
+      if (shared) {
+        metrics_.shared_column_reads_counter.Increment();
       }
-      // Arrow array wasn't in cache, Convert to arrow and then add to cache.
-      auto arr = record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool);
-      record_batch_ptr->arrow_cache[col_idx] = arr;
-      record_batch_ptr->cache_validity[col_idx] = true;
-      PL_RETURN_IF_ERROR(output_rb->AddColumn(
-          arr->Slice(slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start)));
     }
-  } else {
-    const auto& row_batch = std::get<schema::RowBatch>(hot_batches_[slice.unsafe_batch_index]);
-    for (auto col_idx : cols) {
-      auto arr = row_batch.ColumnAt(col_idx)->Slice(
-          slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
-      PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
+    return arr->Slice(row_start, num_rows);
+  }
+  return column.array->Slice(row_start, num_rows);
+}
+
+bool Table::SliceMayMatch(const BatchSlice& slice,
+                          const std::vector<ColumnPredicate>& predicates) const {
+  if (predicates.empty()) {
+    return true;
+  }
+  absl::MutexLock gen_lock(&generation_lock_);
+  if (!UpdateSliceUnlocked(slice).ok() || slice.unsafe_is_hot) {
+    return true;
+  }
+  absl::MutexLock cold_lock(&cold_lock_);
+  for (const auto& predicate : predicates) {
+    DCHECK_LT(static_cast<size_t>(predicate.col_idx), rel_.NumColumns());
+    const auto& zone_map =
+        slice.unsafe_is_spilled
+            ? spill_tier_->ZoneMap(slice.unsafe_batch_index, predicate.col_idx)
+            : cold_zone_maps_[predicate.col_idx][slice.unsafe_batch_index];
+    if (!predicate.MayMatch(zone_map)) {
+      return false;
     }
   }
-  return Status::OK();
+  return true;
 }
 
 int64_t Table::NumBatches() const {
   absl::MutexLock gen_lock(&generation_lock_);
   absl::MutexLock cold_lock(&cold_lock_);
   absl::MutexLock hot_lock(&hot_lock_);
-  return RingSizeUnlocked() + hot_batches_.size();
+  return NumSpilledBatchesUnlocked() + RingSizeUnlocked() + hot_batches_.size();
+}
+
+int64_t Table::NumRows() const {
+  // Row IDs are assigned consecutively, so the rows held are the ones from the first batch on.
+  absl::MutexLock gen_lock(&generation_lock_);
+  {
+    absl::MutexLock cold_lock(&cold_lock_);
+    if (NumSpilledBatchesUnlocked() > 0) {
+      absl::MutexLock hot_lock(&hot_lock_);
+      return next_row_id_ - spill_tier_->row_ids().front().first;
+    }
+    if (ring_back_idx_ != -1) {
+      absl::MutexLock hot_lock(&hot_lock_);
+      return next_row_id_ - cold_row_ids_.front().first;
+    }
+  }
+  absl::MutexLock hot_lock(&hot_lock_);
+  if (hot_row_ids_.empty()) {
+    return 0;
+  }
+  return next_row_id_ - hot_row_ids_.front().first;
 }
 
 BatchSlice Table::FirstBatch() const {
   absl::MutexLock gen_lock(&generation_lock_);
   {
     absl::MutexLock cold_lock(&cold_lock_);
+    if (NumSpilledBatchesUnlocked() > 0) {
+      return BatchSlice::Spilled(0, 0, spill_tier_->BatchLength(0) - 1, generation_,
+                                 spill_tier_->row_ids().front());
+    }
     if (ring_back_idx_ != -1) {
       auto row_ids = cold_row_ids_.front();
       return BatchSlice::Cold(ring_front_idx_, 0, ColdBatchLengthUnlocked(ring_front_idx_) - 1,
@@ -620,6 +851,32 @@ BatchSlice Table::NextBatchWithoutStop(const BatchSlice& slice) const {
   }
   if (!slice.unsafe_is_hot) {
     absl::MutexLock cold_lock(&cold_lock_);
+    if (slice.unsafe_is_spilled) {
+      auto batch_length = spill_tier_->BatchLength(slice.unsafe_batch_index);
+      if (slice.unsafe_row_end < batch_length - 1) {
+        auto new_batch_size = batch_length - slice.unsafe_row_end;
+        return BatchSlice::Spilled(slice.unsafe_batch_index, slice.unsafe_row_end + 1,
+                                   batch_length - 1, generation_, slice.uniq_row_end_idx + 1,
+                                   slice.uniq_row_end_idx + new_batch_size - 1);
+      }
+      auto next_index = slice.unsafe_batch_index + 1;
+      if (next_index < spill_tier_->NumBatches()) {
+        return BatchSlice::Spilled(next_index, 0, spill_tier_->BatchLength(next_index) - 1,
+                                   generation_, spill_tier_->row_ids()[next_index]);
+      }
+      // This is the last spilled batch, so continue with the first cold batch, or the first hot
+      // batch if there are no cold ones.
+      if (ring_back_idx_ != -1) {
+        return BatchSlice::Cold(ring_front_idx_, 0, ColdBatchLengthUnlocked(ring_front_idx_) - 1,
+                                generation_, cold_row_ids_.front());
+      }
+      absl::MutexLock hot_lock(&hot_lock_);
+      if (hot_batches_.size() == 0) {
+        return BatchSlice::Invalid();
+      }
+      return BatchSlice::Hot(0, 0, HotBatchLengthUnlocked(0) - 1, generation_,
+                             hot_row_ids_.front());
+    }
     auto batch_length = ColdBatchLengthUnlocked(slice.unsafe_batch_index);
     // We first check if the previous slice had already output all the rows in its batch. If it
     // didn't then we need to output a batch with the remaining rows.
@@ -664,66 +921,108 @@ BatchSlice Table::NextBatchWithoutStop(const BatchSlice& slice) const {
   return BatchSlice::Hot(next_index, 0, next_length - 1, generation_, hot_row_ids_[next_index]);
 }
 
-int64_t Table::FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const {
-  absl::MutexLock gen_lock(&generation_lock_);
+StatusOr<int64_t> Table::FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const {
+  std::optional<TimeIndex::Entry> entry;
+  int64_t row_start;
+  std::vector<PinnedColumn> time_col;
   {
-    absl::MutexLock hot_lock(&hot_lock_);
-    auto it =
-        std::upper_bound(hot_time_.begin(), hot_time_.end(), time, IntervalComparatorUpperBound);
-    if (it != hot_time_.begin()) {
-      it--;
-      auto index = std::distance(hot_time_.begin(), it);
-      ArrowArrayPtr time_col;
-      if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
-        auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
-        time_col = GetHotColumnUnlocked(record_batch_ptr, time_col_idx_, mem_pool);
-      } else {
-        auto row_batch = std::get<schema::RowBatch>(hot_batches_[index]);
-        time_col = row_batch.columns().at(time_col_idx_);
-      }
-      auto row_offset =
-          types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
-      return hot_row_ids_[index].first + row_offset;
+    absl::MutexLock gen_lock(&generation_lock_);
+    entry = time_index_.FindLastStartingAtOrBefore(time);
+    if (!entry.has_value()) {
+      return -1;
     }
+    PL_ASSIGN_OR_RETURN(auto slice, ResolveTimeIndexEntryUnlocked(entry.value()));
+    row_start = slice.unsafe_row_start;
+    time_col = PinColumnsUnlocked(slice, {time_col_idx_}, /* batch_length */ nullptr);
   }
-  absl::MutexLock cold_lock(&cold_lock_);
-  auto it =
-      std::upper_bound(cold_time_.begin(), cold_time_.end(), time, IntervalComparatorUpperBound);
-  if (it == cold_time_.begin()) {
-    return -1;
-  }
-  it--;
-  auto index = it - cold_time_.begin();
-  auto ring_index = RingIndexUnlocked(index);
-  auto time_col = cold_column_buffers_[time_col_idx_][ring_index];
+  // The entry starts at or before the time, so the last row at or before it is among its rows.
+  PL_ASSIGN_OR_RETURN(auto entry_times,
+                      ReadPinnedColumn(time_col[0], row_start,
+                                       entry->last_row_id - entry->first_row_id + 1, mem_pool));
   auto row_offset =
-      types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
-  return cold_row_ids_[index].first + row_offset;
+      types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(entry_times.get(), time);
+  return entry->first_row_id + row_offset;
+}
+
+StatusOr<BatchSlice> Table::ResolveTimeIndexEntryUnlocked(const TimeIndex::Entry& entry) const {
+  // The index expires entries under the generation lock, so the batch holding the rows is still
+  // in the table.
+  auto slice = BatchSlice::Invalid();
+  slice.uniq_row_start_idx = entry.first_row_id;
+  slice.uniq_row_end_idx = entry.last_row_id;
+  PL_RETURN_IF_ERROR(UpdateSliceUnlocked(slice));
+  return slice;
 }
 
 int64_t Table::ColdBatchLengthUnlocked(int64_t index) const {
-  return cold_column_buffers_[0].at(index)->length();
+  // Use the row IDs rather than a column, since the columns of a cold batch may be encoded.
+  const auto& row_ids = cold_row_ids_[RingVectorIndexUnlocked(index)];
+  return row_ids.second - row_ids.first + 1;
 }
+int64_t Table::ColdColumnBytesUnlocked(int64_t col_idx, int64_t ring_index) const {
+  if (cold_encoded_columns_[col_idx][ring_index] != nullptr) {
+    return cold_encoded_columns_[col_idx][ring_index]->Bytes();
+  }
+  int64_t bytes = 0;
+#define TYPE_CASE(_dt_) \
+  bytes = types::GetArrowArrayBytes<_dt_>(cold_column_buffers_[col_idx][ring_index].get());
+  PL_SWITCH_FOREACH_DATATYPE(rel_.GetColumnType(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  return bytes;
+}
+
+int64_t Table::ColdColumnUncompressedBytesUnlocked(int64_t col_idx, int64_t ring_index) const {
+  if (cold_encoded_columns_[col_idx][ring_index] != nullptr) {
+    return cold_encoded_columns_[col_idx][ring_index]->UncompressedBytes();
+  }
+  return ColdColumnBytesUnlocked(col_idx, ring_index);
+}
+
+StatusOr<std::shared_ptr<EncodedColumn>> Table::EncodeColdColumn(
+    int64_t col_idx, const ArrowArrayPtr& col, arrow::MemoryPool* mem_pool) const {
+  switch (rel_.GetColumnType(col_idx)) {
+    case types::DataType::STRING:
+      if (FLAGS_table_store_dictionary_encode_strings) {
+        return DictionaryEncodedStrings::Encode(static_cast<const arrow::StringArray&>(*col),
+                                                FLAGS_table_store_dictionary_max_distinct_ratio,
+                                                mem_pool);
+      }
+      break;
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+      // The time column stays plain, since it's searched whenever a read starts or stops at a
+      // given time.
+      if (FLAGS_table_store_delta_encode_ints && col_idx != time_col_idx_) {
+        return DeltaEncodedInts::Encode(static_cast<const arrow::Int64Array&>(*col));
+      }
+      break;
+    default:
+      break;
+  }
+  return std::shared_ptr<EncodedColumn>();
+}
+
 int64_t Table::HotBatchLengthUnlocked(int64_t index) const {
   if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
-    auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
-    return record_batch_ptr->record_batch->at(0)->Size();
+    return std::get<RecordBatchWithCache>(hot_batches_[index]).record_batch->at(0)->Size();
   } else {
-    auto row_batch = std::get<schema::RowBatch>(hot_batches_[index]);
-    return row_batch.num_rows();
+    return std::get<schema::RowBatch>(hot_batches_[index]).num_rows();
   }
 }
 
-Table::ArrowArrayPtr Table::GetHotColumnUnlocked(const RecordBatchWithCache* record_batch_ptr,
-                                                 int64_t col_idx,
-                                                 arrow::MemoryPool* mem_pool) const {
-  if (record_batch_ptr->cache_validity[col_idx]) {
-    return record_batch_ptr->arrow_cache[col_idx];
+Table::ArrowArrayPtr Table::HotColumn(const RecordBatchWithCache& batch, int64_t col_idx,
+                                      arrow::MemoryPool* mem_pool) {
+  ArrowArrayPtr* cached = &(*batch.arrow_cache)[col_idx];
+  ArrowArrayPtr arr = std::atomic_load(cached);
+  if (arr != nullptr) {
+    return arr;
   }
-  auto arrow_array_sptr = record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool);
-  record_batch_ptr->arrow_cache[col_idx] = arrow_array_sptr;
-  record_batch_ptr->cache_validity[col_idx] = true;
-  return arrow_array_sptr;
+  // Readers that convert the same column at once all convert it, and the first one caches it.
+  auto converted = types::ShareAsArrow(batch.record_batch->at(col_idx), mem_pool);
+  if (std::atomic_compare_exchange_strong(cached, &arr, converted)) {
+    return converted;
+  }
+  return arr;
 }
 
 BatchSlice Table::SliceIfPastStop(const BatchSlice& slice, int64_t stop_row_id) const {
@@ -779,21 +1078,64 @@ int64_t Table::RingNextAddrUnlocked(int64_t ring_index) const {
 }
 
 Status Table::AdvanceRingBufferUnlocked() {
-  auto next_ring_back_idx = (ring_back_idx_ + 1) % ring_capacity_;
-  if (ring_back_idx_ != -1 && next_ring_back_idx == ring_front_idx_) {
-    return error::Internal(
-        "Failed to add new cold batch, ring buffer alreadRingNextAddrUnlocked full");
+  // The ring is sized for the maximum table size that the table was created with. It grows when
+  // that size was raised, or when the cold encodings fit more batches into the table.
+  if (RingSizeUnlocked() == ring_capacity_) {
+    GrowRingBufferUnlocked();
   }
-  ring_back_idx_ = next_ring_back_idx;
+  ring_back_idx_ = (ring_back_idx_ + 1) % ring_capacity_;
   return Status::OK();
 }
 
+void Table::GrowRingBufferUnlocked() {
+  const int64_t size = RingSizeUnlocked();
+  const int64_t new_capacity = std::max<int64_t>(2 * ring_capacity_, 1);
+  for (size_t col_idx = 0; col_idx < rel_.NumColumns(); ++col_idx) {
+    ColumnBuffer column_buffer(new_capacity);
+    std::vector<ColumnZoneMap> zone_maps(new_capacity);
+    std::vector<std::shared_ptr<EncodedColumn>> encoded_columns(new_capacity);
+    for (int64_t i = 0; i < size; ++i) {
+      int64_t ring_index = RingIndexUnlocked(i);
+      column_buffer[i] = std::move(cold_column_buffers_[col_idx][ring_index]);
+      zone_maps[i] = cold_zone_maps_[col_idx][ring_index];
+      encoded_columns[i] = std::move(cold_encoded_columns_[col_idx][ring_index]);
+    }
+    cold_column_buffers_[col_idx] = std::move(column_buffer);
+    cold_zone_maps_[col_idx] = std::move(zone_maps);
+    cold_encoded_columns_[col_idx] = std::move(encoded_columns);
+  }
+  ring_capacity_ = new_capacity;
+  ring_front_idx_ = 0;
+  ring_back_idx_ = size - 1;
+  // The batches moved, which invalidates the ring indices held by BatchSlices.
+  generation_++;
+}
+
 Status Table::UpdateSliceUnlocked(const BatchSlice& slice) const {
   if (slice.generation == generation_) {
     return Status::OK();
   }
   {
     absl::MutexLock cold_lock(&cold_lock_);
+    if (NumSpilledBatchesUnlocked() > 0) {
+      const auto& spill_row_ids = spill_tier_->row_ids();
+      auto it = std::lower_bound(spill_row_ids.begin(), spill_row_ids.end(),
+                                 slice.uniq_row_start_idx, IntervalComparatorLowerBound);
+      if (it != spill_row_ids.end()) {
+        if (slice.uniq_row_end_idx < it->first) {
+          // All data in this slice has been expired from the table.
+          return error::InvalidArgument(
+              "Requested RowBatch Slice has already been expired from the table");
+        }
+        slice.unsafe_is_hot = false;
+        slice.unsafe_is_spilled = true;
+        slice.unsafe_batch_index = std::distance(spill_row_ids.begin(), it);
+        slice.unsafe_row_start = slice.uniq_row_start_idx - it->first;
+        slice.unsafe_row_end = slice.uniq_row_end_idx - it->first;
+        slice.generation = generation_;
+        return Status::OK();
+      }
+    }
     auto it = std::lower_bound(cold_row_ids_.begin(), cold_row_ids_.end(), slice.uniq_row_start_idx,
                                IntervalComparatorLowerBound);
 
@@ -806,6 +1148,7 @@ Status Table::UpdateSliceUnlocked(const BatchSlice& slice) const {
       auto vector_index = std::distance(cold_row_ids_.begin(), it);
       auto ring_index = RingIndexUnlocked(vector_index);
       slice.unsafe_is_hot = false;
+      slice.unsafe_is_spilled = false;
       slice.unsafe_batch_index = ring_index;
       slice.unsafe_row_start = slice.uniq_row_start_idx - it->first;
       slice.unsafe_row_end = slice.uniq_row_end_idx - it->first;
@@ -22,8 +22,10 @@
 #include <arrow/array.h>
 #include <arrow/record_batch.h>
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -40,9 +42,19 @@
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/schema/row_descriptor.h"
 #include "src/table_store/schemapb/schema.pb.h"
+#include "src/table_store/table/encoded_column.h"
+#include "src/table_store/table/shared_column_reads.h"
+#include "src/table_store/table/spill_tier.h"
 #include "src/table_store/table/table_metrics.h"
+#include "src/table_store/table/time_index.h"
+#include "src/table_store/table/zone_map.h"
 
 DECLARE_int32(table_store_table_size_limit);
+DECLARE_bool(table_store_dictionary_encode_strings);
+DECLARE_bool(table_store_delta_encode_ints);
+DECLARE_string(table_store_spill_dir);
+DECLARE_int64(table_store_spill_size_limit);
+DECLARE_string(table_store_spill_tables);
 
 namespace px {
 namespace table_store {
@@ -50,13 +62,26 @@ namespace table_store {
 using RecordBatchSPtr = std::shared_ptr<arrow::RecordBatch>;
 
 struct TableStats {
+  // The number of rows currently held by the table.
+  int64_t num_rows;
   int64_t bytes;
   int64_t cold_bytes;
+  // The number of bytes cold storage would use without any cold encodings.
+  int64_t cold_uncompressed_bytes;
   int64_t num_batches;
   int64_t batches_added;
+  // The number of bytes written to the table since it was created.
+  int64_t bytes_added;
   int64_t batches_expired;
   int64_t compacted_batches;
   int64_t max_table_size;
+  // The number of bytes held on disk by the spill tier, which don't count towards the table size.
+  int64_t spilled_bytes;
+  // The first and last times of the time_ column of the rows held, or -1 if the table holds no
+  // rows or has no time_ column. Rows of partially expired batches may keep the min time lower
+  // than the time of the first row held.
+  int64_t min_time;
+  int64_t max_time;
 };
 
 struct BatchSlice {
@@ -70,6 +95,8 @@ struct BatchSlice {
   mutable int64_t generation = -1;
   int64_t uniq_row_start_idx = -1;
   int64_t uniq_row_end_idx = -1;
+  // Whether the slice is in the spill tier, only meaningful if unsafe_is_hot is false.
+  mutable bool unsafe_is_spilled = false;
 
   int64_t Size() const { return uniq_row_end_idx - uniq_row_start_idx + 1; }
   bool IsValid() const { return uniq_row_start_idx != -1 && uniq_row_end_idx != -1; }
@@ -84,6 +111,18 @@ struct BatchSlice {
     return BatchSlice{false,      cold_index,         row_start,       row_end,
                       generation, uniq_row_start_idx, uniq_row_end_idx};
   }
+  static BatchSlice Spilled(int64_t spill_index, int64_t row_start, int64_t row_end,
+                            int64_t generation, std::pair<int64_t, int64_t> row_ids) {
+    return Spilled(spill_index, row_start, row_end, generation, row_ids.first, row_ids.second);
+  }
+  static BatchSlice Spilled(int64_t spill_index, int64_t row_start, int64_t row_end,
+                            int64_t generation, int64_t uniq_row_start_idx,
+                            int64_t uniq_row_end_idx) {
+    auto slice =
+        Cold(spill_index, row_start, row_end, generation, uniq_row_start_idx, uniq_row_end_idx);
+    slice.unsafe_is_spilled = true;
+    return slice;
+  }
   static BatchSlice Hot(int64_t hot_index, int64_t row_start, int64_t row_end, int64_t generation,
                         std::pair<int64_t, int64_t> row_ids) {
     return BatchSlice{true,       hot_index,     row_start,     row_end,
@@ -120,9 +159,15 @@ class ArrowArrayCompactor {
         builder_untyped);
     auto typed_arr =
         std::static_pointer_cast<typename types::DataTypeTraits<TDataType>::arrow_array_type>(arr);
-    PL_RETURN_IF_ERROR(builder->Reserve(typed_arr->length()));
-    for (int i = 0; i < typed_arr->length(); ++i) {
-      builder->UnsafeAppend(typed_arr->Value(i));
+    if constexpr (TDataType == types::DataType::INT64 || TDataType == types::DataType::FLOAT64 ||
+                  TDataType == types::DataType::TIME64NS) {
+      // Fixed-width values are contiguous, so they can be appended in bulk (a memcpy).
+      PL_RETURN_IF_ERROR(builder->AppendValues(typed_arr->raw_values(), typed_arr->length()));
+    } else {
+      PL_RETURN_IF_ERROR(builder->Reserve(typed_arr->length()));
+      for (int i = 0; i < typed_arr->length(); ++i) {
+        builder->UnsafeAppend(typed_arr->Value(i));
+      }
     }
     bytes_ += types::GetArrowArrayBytes<TDataType>(typed_arr.get());
     return Status::OK();
@@ -150,16 +195,25 @@ class ArrowArrayCompactor {
  * transferred to cold, don't also need to convert to arrow.
  *
  * Synchronization Scheme:
- * The hot and cold partitions are synchronized separately with spinlocks. Additionally, the
- * generation of the store is protected by a spinlock.
+ * The hot and cold partitions are synchronized separately with mutexes. Additionally, the
+ * generation of the store is protected by a mutex. Writers only take the hot lock, unless they
+ * expire batches. Readers hold the locks just long enough to resolve a slice and pin the columns
+ * they read, which are all reference counted and never modified in place. The columns are then
+ * converted to arrow, decoded and sliced without holding any lock, so that long reads don't stall
+ * writers, and batches compacted or expired in the meantime stay alive until the reads finish.
  *
  * Compaction Scheme:
  * Hot batches are compacted into batches of minimum size min_cold_batch_size_ bytes. The compaction
- * routine should be called periodically but that is not the responsibility of this class.
+ * routine should be called periodically but that is not the responsibility of this class. The
+ * cold arrays are allocated from the memory pool passed to the compaction, which the agent selects
+ * with --table_store_huge_pages (see ColdBatchMemoryPool).
  *
  * Time and Row Indexing:
- * The first and last values of the time columns for each batch are stored as intervals in
- * (hot/cold)_time_, which internally maintains a sorted list for O(logN) time lookup. Additionally,
+ * The first and last times and row IDs of each written batch are appended to a TimeIndex, which
+ * covers the hot, cold and spilled batches alike, since compaction and spilling keep the row IDs.
+ * Time lookups search the index without taking the hot lock, so they don't contend with writers,
+ * then resolve the row IDs to the batch holding them and search only those rows of its time
+ * column. The index drops the entries of the batches as they expire. Additionally,
  * this class supports multiple batches with the same timestamps. In order to support this, we keep
  * track of an incrementing identifier for each row (we store only the identifiers of the first and
  * last rows in a batch). This allows us to support returning only valid data even if a compaction
@@ -172,24 +226,67 @@ class ArrowArrayCompactor {
  * identifiers of the first and last row of that batch, so that when NextBatch is called on that
  * batch it can work out that it needs to return a slice of the batch with the original "second"
  * batch's data.
+ *
+ * Zone Maps:
+ * When a batch is compacted into cold storage, a ColumnZoneMap (min/max and null count) is computed
+ * for each of its columns. Readers pass simple column predicates to SliceMayMatch to skip cold
+ * batches that can't contain any matching rows.
+ *
+ * Cold Encodings:
+ * When a batch is compacted into cold storage, its columns can be stored as an EncodedColumn
+ * instead of a plain arrow array. With --table_store_dictionary_encode_strings, string columns with
+ * few distinct values are dictionary encoded. With --table_store_delta_encode_ints, INT64 and
+ * TIME64NS columns (other than the indexed time_ column, which is binary searched) are delta
+ * encoded and bit-packed. Reads decode only the requested slice back into a plain arrow array.
+ * The table size limit applies to the encoded bytes, TableStats also reports the unencoded size.
+ *
+ * Table Size:
+ * The oldest batches are expired to keep the table within its maximum size. A TableMemoryBudget
+ * changes the maximum size as it rebalances, and the cold ring buffer grows when it runs out of
+ * room.
+ *
+ * Spill Tier:
+ * With --table_store_spill_dir, the batches expired from the cold ring buffer are moved to a
+ * SpillTier on disk instead of being dropped, up to --table_store_spill_size_limit bytes per
+ * table. Spilled batches are older than the cold ones, and are read, searched by time and skipped
+ * by their zone maps the same way. Their columns are spilled decoded, and read in place from the
+ * memory mapped spill files.
+ *
+ * Snapshots:
+ * With --table_store_snapshot_dir, the agent writes every batch to a table snapshot when it stops,
+ * and writes the snapshot back with WriteRowBatch when it starts. The restored batches are hot, and
+ * read from the memory mapped snapshot until they are compacted.
  */
 class Table : public NotCopyable {
   using RecordBatchPtr = std::unique_ptr<px::types::ColumnWrapperRecordBatch>;
   using ArrowArrayPtr = std::shared_ptr<arrow::Array>;
   using ColumnBuffer = std::vector<ArrowArrayPtr>;
-  using TimeInterval = std::pair<int64_t, int64_t>;
   using RowIDInterval = std::pair<int64_t, int64_t>;
 
   struct RecordBatchWithCache {
-    RecordBatchPtr record_batch;
+    // Hot batches don't change once written, so readers share them to read them after releasing
+    // the hot lock.
+    std::shared_ptr<const px::types::ColumnWrapperRecordBatch> record_batch;
     // Whenever we have to convert a hot batch to an arrow array, we store the arrow array in
     // this cache. Compaction will eventually take these arrow arrays and move them into cold.
-    mutable std::vector<ArrowArrayPtr> arrow_cache;
-    mutable std::vector<bool> cache_validity;
+    // Entries are null until converted. Readers fill them without holding the hot lock, so they
+    // are only accessed with std::atomic_load and std::atomic_compare_exchange_strong.
+    std::shared_ptr<std::vector<ArrowArrayPtr>> arrow_cache;
   };
 
   using RecordOrRowBatch = std::variant<RecordBatchWithCache, schema::RowBatch>;
 
+  // A column of a batch, pinned while holding the table's locks, so that it can be converted,
+  // decoded and sliced after releasing them. Exactly one of the members is set.
+  struct PinnedColumn {
+    ArrowArrayPtr array;
+    std::shared_ptr<EncodedColumn> encoded;
+    std::optional<RecordBatchWithCache> hot_batch;
+    int64_t col_idx = -1;
+    // The unique IDs of the first and last rows of the batch, which key the shared reads.
+    RowIDInterval batch_row_ids;
+  };
+
   static inline constexpr int64_t kDefaultColdBatchMinSize = 64 * 1024;
 
  public:
@@ -269,6 +366,10 @@ class Table : public NotCopyable {
    */
   Status ToProto(table_store::schemapb::Table* table_proto) const;
 
+  /**
+   * Returns a snapshot of the stats of the table. The counters are read without the stats lock, so
+   * they can be off from each other by a concurrent write.
+   */
   TableStats GetTableStats() const;
 
   /**
@@ -306,6 +407,16 @@ class Table : public NotCopyable {
    */
   BatchSlice SliceIfPastStop(const BatchSlice& slice, StopPosition stop) const;
 
+  /**
+   * Checks whether any row of the given slice could satisfy all of the given predicates, based on
+   * the zone maps of its cold batch. Hot batches don't have zone maps, so this always returns true
+   * for them. Since zone maps cover the whole batch, a true result doesn't guarantee a match.
+   * @param slice the BatchSlice to check.
+   * @param predicates the predicates that a matching row must satisfy.
+   * @return false if the slice can be skipped.
+   */
+  bool SliceMayMatch(const BatchSlice& slice, const std::vector<ColumnPredicate>& predicates) const;
+
   /**
    * Compacts hot batches into min_cold_batch_size_ sized cold batches. Each call to
    * CompactHotToCold will create a maximum of kMaxBatchesPerCompactionCall cold batches.
@@ -313,19 +424,45 @@ class Table : public NotCopyable {
    */
   Status CompactHotToCold(arrow::MemoryPool* mem_pool);
 
+  /**
+   * Compacts hot batches into a single min_cold_batch_size_ sized cold batch, if the table holds
+   * enough hot bytes for one.
+   * @param mem_pool arrow MemoryPool to be used for creating the new cold batch.
+   * @return whether a cold batch was created.
+   */
+  StatusOr<bool> CompactNextBatch(arrow::MemoryPool* mem_pool);
+
+  /**
+   * Changes the maximum number of bytes that the table can hold, and expires the oldest batches
+   * right away if the table holds more than that.
+   */
+  Status SetMaxTableSize(int64_t max_table_size);
+
+  const std::string& name() const { return name_; }
+
+  /**
+   * @return the number of bytes held in hot storage, which are yet to be compacted.
+   */
+  int64_t HotBytes() const;
+
  private:
   TableMetrics metrics_;
   Status ExpireRowBatches(int64_t row_batch_size);
 
+  const std::string name_;
   schema::Relation rel_;
 
+  // Writers update the stats under stats_lock_, so that updates of several of them together are
+  // consistent with each other. They are atomic so that GetTableStats can read them without it.
   mutable absl::base_internal::SpinLock stats_lock_;
-  int64_t batches_expired_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t cold_bytes_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t hot_bytes_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t batches_added_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t compacted_batches_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t max_table_size_ = 0;
+  std::atomic<int64_t> batches_expired_ = 0;
+  std::atomic<int64_t> cold_bytes_ = 0;
+  std::atomic<int64_t> cold_uncompressed_bytes_ = 0;
+  std::atomic<int64_t> hot_bytes_ = 0;
+  std::atomic<int64_t> batches_added_ = 0;
+  std::atomic<int64_t> bytes_added_ = 0;
+  std::atomic<int64_t> compacted_batches_ = 0;
+  std::atomic<int64_t> max_table_size_ = 0;
   int64_t min_cold_batch_size_;
 
   mutable absl::Mutex hot_lock_;
@@ -333,6 +470,16 @@ class Table : public NotCopyable {
 
   mutable absl::Mutex cold_lock_;
   std::vector<ColumnBuffer> cold_column_buffers_ ABSL_GUARDED_BY(cold_lock_);
+  // Zone maps for each column of each cold batch, indexed the same way as cold_column_buffers_.
+  std::vector<std::vector<ColumnZoneMap>> cold_zone_maps_ ABSL_GUARDED_BY(cold_lock_);
+  // Encoded columns of each cold batch, indexed the same way as cold_column_buffers_. Where a
+  // column is encoded its entry in cold_column_buffers_ is null, and vice versa.
+  std::vector<std::vector<std::shared_ptr<EncodedColumn>>> cold_encoded_columns_
+      ABSL_GUARDED_BY(cold_lock_);
+  // Holds the batches expired from the ring buffer, if the table spills. Created on the first
+  // spill, and spilling stops if the tier fails.
+  bool spill_enabled_ ABSL_GUARDED_BY(cold_lock_) = false;
+  std::unique_ptr<SpillTier> spill_tier_ ABSL_GUARDED_BY(cold_lock_);
 
   // The generation lock must be held during compaction and
   // expiration, and anytime one would like to access the unsafe_ attributes of BatchSlice.
@@ -350,11 +497,14 @@ class Table : public NotCopyable {
   // accessed on a hot write.
   int64_t next_row_id_ ABSL_GUARDED_BY(hot_lock_) = 0;
   std::deque<RowIDInterval> hot_row_ids_ ABSL_GUARDED_BY(hot_lock_);
-  std::deque<TimeInterval> hot_time_ ABSL_GUARDED_BY(hot_lock_);
   std::deque<RowIDInterval> cold_row_ids_ ABSL_GUARDED_BY(cold_lock_);
-  std::deque<TimeInterval> cold_time_ ABSL_GUARDED_BY(cold_lock_);
 
   int64_t time_col_idx_ = -1;
+  // Shares the columns that concurrent queries convert or decode from the same batches.
+  mutable SharedColumnReads shared_reads_;
+  // Appended to under hot_lock_, expired under generation_lock_ so that it stays consistent with
+  // the batches for readers holding it. Searches don't need either lock.
+  TimeIndex time_index_;
 
   Status WriteHot(RecordBatchPtr record_batch);
   Status WriteHot(const schema::RowBatch& rb);
@@ -365,30 +515,58 @@ class Table : public NotCopyable {
   Status ExpireBatch();
   Status ExpireHot();
   StatusOr<bool> ExpireCold();
+  // Moves the batch at the front of the ring buffer to the spill tier.
+  Status SpillColdFrontUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_, cold_lock_);
+  int64_t NumSpilledBatchesUnlocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
   Status CompactSingleBatch(arrow::MemoryPool* mem_pool);
 
   Status AddBatchSliceToRowBatch(const BatchSlice& slice, const std::vector<int64_t>& cols,
                                  schema::RowBatch* output_rb, arrow::MemoryPool* mem_pool) const;
-  ArrowArrayPtr GetHotColumnUnlocked(const RecordBatchWithCache* record_batch_ptr, int64_t col_idx,
-                                     arrow::MemoryPool* mem_pool) const
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
+  // Returns the column of the hot batch as arrow, converting it and caching it if needed. Doesn't
+  // need the hot lock.
+  static ArrowArrayPtr HotColumn(const RecordBatchWithCache& batch, int64_t col_idx,
+                                 arrow::MemoryPool* mem_pool);
+  // Pins the columns of the (updated) slice's batch, and sets batch_length to its length if it
+  // isn't null.
+  std::vector<PinnedColumn> PinColumnsUnlocked(const BatchSlice& slice,
+                                               const std::vector<int64_t>& cols,
+                                               int64_t* batch_length) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
+  // Reads the rows of the pinned column. The hot columns that aren't converted yet, and the
+  // encoded columns of the batches that are read whole, are read through shared_reads_.
+  StatusOr<ArrowArrayPtr> ReadPinnedColumn(const PinnedColumn& column, int64_t row_start,
+                                           int64_t num_rows, arrow::MemoryPool* mem_pool) const;
 
   int64_t NumBatches() const;
+  int64_t NumRows() const;
   int64_t ColdBatchLengthUnlocked(int64_t ring_index) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  int64_t ColdColumnBytesUnlocked(int64_t col_idx, int64_t ring_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  int64_t ColdColumnUncompressedBytesUnlocked(int64_t col_idx, int64_t ring_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  StatusOr<std::shared_ptr<EncodedColumn>> EncodeColdColumn(int64_t col_idx,
+                                                            const ArrowArrayPtr& col,
+                                                            arrow::MemoryPool* mem_pool) const;
   int64_t HotBatchLengthUnlocked(int64_t hot_index) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
 
   // Returns the unique identifier of the last row less than or equal to the given time.
-  int64_t FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const;
+  StatusOr<int64_t> FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const;
+  // Resolves the rows of the time index entry to the batch holding them now. The unsafe_ row
+  // range of the returned slice covers just those rows.
+  StatusOr<BatchSlice> ResolveTimeIndexEntryUnlocked(const TimeIndex::Entry& entry) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
 
-  // Returns the index into cold_row_ids_ or cold_time_ given the ring buffer location.
+  // Returns the index into cold_row_ids_ given the ring buffer location.
   int64_t RingVectorIndexUnlocked(int64_t ring_index) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
-  // Returns the index into the ring buffer given a vector index into cold_row_ids_ or cold_time_.
+  // Returns the index into the ring buffer given a vector index into cold_row_ids_.
   int64_t RingIndexUnlocked(int64_t vector_index) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
   int64_t RingSizeUnlocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
   int64_t RingNextAddrUnlocked(int64_t ring_index) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
-  Status AdvanceRingBufferUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  Status AdvanceRingBufferUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_, cold_lock_);
+  // Doubles the capacity of the ring buffer, which moves the cold batches to new ring indices.
+  void GrowRingBufferUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_, cold_lock_);
 
   Status UpdateSliceUnlocked(const BatchSlice& slice) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
@@ -17,13 +17,17 @@
  */
 
 #include <absl/synchronization/barrier.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/synchronization/notification.h>
 #include <benchmark/benchmark.h>
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <numeric>
 #include <random>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "src/shared/types/types.h"
 #include "src/table_store/table/table.h"
@@ -230,6 +234,57 @@ static void BM_TableCompaction(benchmark::State& state) {
                           Table::kMaxBatchesPerCompactionCall);
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ArrowArrayCompactorFixedSize(benchmark::State& state) {
+  int64_t batch_length = state.range(0);
+  int64_t num_batches = 16;
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::FLOAT64}, {"time_", "float"});
+  std::vector<std::shared_ptr<arrow::Array>> time_arrs;
+  std::vector<std::shared_ptr<arrow::Array>> float_arrs;
+  for (int64_t i = 0; i < num_batches; ++i) {
+    auto batch = MakeHotBatch(batch_length);
+    time_arrs.push_back((*batch)[0]->ConvertToArrow(arrow::default_memory_pool()));
+    float_arrs.push_back((*batch)[1]->ConvertToArrow(arrow::default_memory_pool()));
+  }
+
+  for (auto _ : state) {
+    ArrowArrayCompactor compactor(rel, arrow::default_memory_pool());
+    for (int64_t i = 0; i < num_batches; ++i) {
+      PL_CHECK_OK(compactor.AppendColumn(0, time_arrs[i]));
+      PL_CHECK_OK(compactor.AppendColumn(1, float_arrs[i]));
+    }
+    PL_CHECK_OK(compactor.Finish());
+    benchmark::DoNotOptimize(compactor.output_columns());
+  }
+
+  state.SetBytesProcessed(state.iterations() * num_batches * batch_length *
+                          (sizeof(int64_t) + sizeof(double)));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ArrowArrayCompactorString(benchmark::State& state) {
+  int64_t batch_length = state.range(0);
+  int64_t num_batches = 16;
+  std::string value(32, 'a');
+  schema::Relation rel({types::DataType::STRING}, {"str"});
+  std::vector<std::shared_ptr<arrow::Array>> arrs;
+  for (int64_t i = 0; i < num_batches; ++i) {
+    auto col_wrapper = std::make_shared<types::StringValueColumnWrapper>(batch_length, value);
+    arrs.push_back(col_wrapper->ConvertToArrow(arrow::default_memory_pool()));
+  }
+
+  for (auto _ : state) {
+    ArrowArrayCompactor compactor(rel, arrow::default_memory_pool());
+    for (const auto& arr : arrs) {
+      PL_CHECK_OK(compactor.AppendColumn(0, arr));
+    }
+    PL_CHECK_OK(compactor.Finish());
+    benchmark::DoNotOptimize(compactor.output_columns());
+  }
+
+  state.SetBytesProcessed(state.iterations() * num_batches * batch_length * value.size());
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_TableThreaded(benchmark::State& state) {
   schema::Relation rel({types::DataType::TIME64NS}, {"time_"});
@@ -336,6 +391,72 @@ static void BM_TableThreaded(benchmark::State& state) {
   state.counters["Write"] = benchmark::Counter(write_average_time);
 }
 
+static inline std::unique_ptr<types::ColumnWrapperRecordBatch> MakeTimedHotBatch(
+    int64_t batch_length, int64_t first_time) {
+  auto batch = MakeHotBatch(batch_length);
+  auto times = static_cast<types::Time64NSValue*>(batch->at(0)->UnsafeRawData());
+  for (int64_t i = 0; i < batch_length; ++i) {
+    times[i] = first_time + i;
+  }
+  return batch;
+}
+
+// Looks up time ranges in a table that's half hot and half cold, while state.range(0) threads
+// write batches with later times, and the table expires its oldest batches to make room for them.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TableTimeRangeLookup(benchmark::State& state) {
+  int64_t table_size = 16 * 1024 * 1024;
+  int64_t compaction_size = 64 * 1024;
+  int64_t batch_length = 256;
+  int64_t batch_size = batch_length * sizeof(int64_t) + batch_length * sizeof(double);
+  auto table = MakeTable(table_size, compaction_size);
+
+  // Each row is one unit of time after the previous one.
+  std::atomic<int64_t> next_time = 0;
+  auto write_batch = [&](bool compact) {
+    PL_CHECK_OK(table->TransferRecordBatch(MakeTimedHotBatch(batch_length, next_time)));
+    next_time += batch_length;
+    if (compact) {
+      PL_CHECK_OK(table->CompactHotToCold(arrow::default_memory_pool()));
+    }
+  };
+  int64_t num_batches = table_size / batch_size;
+  for (int64_t i = 0; i < num_batches; ++i) {
+    write_batch(/* compact */ i < num_batches / 2);
+  }
+
+  // The writers take turns, since a table expects the times of its batches to be increasing.
+  std::atomic<bool> done = false;
+  absl::Mutex write_lock;
+  std::vector<std::thread> writers;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    writers.emplace_back([&, i]() {
+      for (int64_t batch = 0; !done; ++batch) {
+        absl::MutexLock lock(&write_lock);
+        write_batch(/* compact */ i == 0 && batch % 64 == 0);
+      }
+    });
+  }
+
+  std::mt19937_64 rng(37);
+  int64_t range_length = 16 * batch_length;
+  for (auto _ : state) {
+    // Look up a range among the rows the table holds.
+    int64_t end_time = next_time;
+    int64_t start_time = end_time - table_size / batch_size * batch_length + range_length;
+    int64_t time = start_time + static_cast<int64_t>(rng() % (end_time - start_time));
+    benchmark::DoNotOptimize(
+        table->FindBatchSliceGreaterThanOrEqual(time - range_length, arrow::default_memory_pool()));
+    benchmark::DoNotOptimize(table->FindStopPositionForTime(time, arrow::default_memory_pool()));
+  }
+
+  done = true;
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
 BENCHMARK(BM_TableReadAllHot);
 BENCHMARK(BM_TableReadAllCold);
 BENCHMARK(BM_TableReadLastBatchAllHot)->Iterations(1000);
@@ -343,6 +464,9 @@ BENCHMARK(BM_TableReadLastBatchAllCold)->Iterations(1000);
 BENCHMARK(BM_TableWriteEmpty);
 BENCHMARK(BM_TableWriteFull);
 BENCHMARK(BM_TableCompaction);
+BENCHMARK(BM_ArrowArrayCompactorFixedSize)->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(BM_ArrowArrayCompactorString)->RangeMultiplier(4)->Range(256, 16384);
 BENCHMARK(BM_TableThreaded)->UseManualTime()->Iterations(1);
+BENCHMARK(BM_TableTimeRangeLookup)->DenseRange(0, 2)->UseRealTime();
 
 }  // namespace px::table_store
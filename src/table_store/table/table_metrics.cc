@@ -51,6 +51,11 @@ TableMetrics::TableMetrics(prometheus::Registry* registry, std::string table_nam
                                   .Help("Total batches expired from the table")
                                   .Register(*registry)
                                   .Add({{"name", table_name}})),
+      bytes_expired_counter(prometheus::BuildCounter()
+                                .Name("table_bytes_expired")
+                                .Help("Total bytes expired from the table")
+                                .Register(*registry)
+                                .Add({{"name", table_name}})),
       compacted_batches_counter(prometheus::BuildCounter()
                                     .Name("table_compacted_batches")
                                     .Help("Total batches compacted in the table")
@@ -60,4 +65,20 @@ TableMetrics::TableMetrics(prometheus::Registry* registry, std::string table_nam
                                .Name("table_max_table_size")
                                .Help("The table size")
                                .Register(*registry)
-                               .Add({{"name", table_name}})) {}
+                               .Add({{"name", table_name}})),
+      spilled_batches_counter(prometheus::BuildCounter()
+                                  .Name("table_spilled_batches")
+                                  .Help("Total batches spilled to disk from the table")
+                                  .Register(*registry)
+                                  .Add({{"name", table_name}})),
+      spilled_batches_dropped_counter(prometheus::BuildCounter()
+                                          .Name("table_spilled_batches_dropped")
+                                          .Help("Total spilled batches dropped from disk")
+                                          .Register(*registry)
+                                          .Add({{"name", table_name}})),
+      shared_column_reads_counter(
+          prometheus::BuildCounter()
+              .Name("table_shared_column_reads")
+              .Help("Total column reads of the table that were shared with a concurrent query")
+              .Register(*registry)
+              .Add({{"name", table_name}})) {}
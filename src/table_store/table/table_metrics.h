@@ -31,6 +31,10 @@ struct TableMetrics {
   prometheus::Counter& num_batches_counter;
   prometheus::Counter& batches_added_counter;
   prometheus::Counter& batches_expired_counter;
+  prometheus::Counter& bytes_expired_counter;
   prometheus::Counter& compacted_batches_counter;
   prometheus::Gauge& max_table_size_gauge;
+  prometheus::Counter& spilled_batches_counter;
+  prometheus::Counter& spilled_batches_dropped_counter;
+  prometheus::Counter& shared_column_reads_counter;
 };
@@ -0,0 +1,416 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/table_store/table/table_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/shared/types/type_utils.h"
+
+DEFINE_string(table_store_snapshot_dir, gflags::StringFromEnv("PL_TABLE_STORE_SNAPSHOT_DIR", ""),
+              "The directory, e.g. a hostPath volume, that the tables are snapshotted to when the "
+              "agent stops, and restored from when it starts, so that upgrades keep the data. "
+              "Empty disables snapshots.");
+DEFINE_int32(table_store_snapshot_timeout_ms,
+             gflags::Int32FromEnv("PL_TABLE_STORE_SNAPSHOT_TIMEOUT_MS", 15000),
+             "The time that the snapshot of the tables may take when the agent stops. Keep it "
+             "within the termination grace period of the pod. Tables that don't fit in it are "
+             "snapshotted partially or not at all.");
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'P', 'X', 'T', 'B', 'L', 'S', 'N', 'P'};
+constexpr uint32_t kSnapshotVersion = 1;
+
+// Buffers are aligned the way arrow aligns the buffers it allocates.
+constexpr int64_t kBufferAlignment = 64;
+
+int64_t AlignUp(int64_t size) { return (size + kBufferAlignment - 1) & ~(kBufferAlignment - 1); }
+
+/**
+ * Writes a snapshot file sequentially, keeping track of the offset to align the buffers.
+ */
+class SnapshotWriter : public NotCopyable {
+ public:
+  explicit SnapshotWriter(int fd) : fd_(fd) {}
+
+  Status Write(const void* data, int64_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+      ssize_t written = write(fd_, bytes, size);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return error::System("Failed to write a table snapshot: $0", std::strerror(errno));
+      }
+      bytes += written;
+      size -= written;
+      offset_ += written;
+    }
+    return Status::OK();
+  }
+
+  template <typename T>
+  Status WriteValue(T value) {
+    return Write(&value, sizeof(value));
+  }
+
+  Status WriteString(std::string_view str) {
+    PL_RETURN_IF_ERROR(WriteValue<uint32_t>(str.size()));
+    return Write(str.data(), str.size());
+  }
+
+  Status Align() {
+    static constexpr uint8_t kPadding[kBufferAlignment] = {};
+    return Write(kPadding, AlignUp(offset_) - offset_);
+  }
+
+ private:
+  const int fd_;
+  int64_t offset_ = 0;
+};
+
+/**
+ * Reads a memory mapped snapshot file, checking that every read stays within the file.
+ */
+class SnapshotReader {
+ public:
+  SnapshotReader(const uint8_t* data, int64_t size, int64_t offset)
+      : data_(data), size_(size), offset_(offset) {}
+
+  bool Read(void* out, int64_t size) {
+    if (size < 0 || size > size_ - offset_) {
+      return false;
+    }
+    std::memcpy(out, data_ + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  template <typename T>
+  bool ReadValue(T* value) {
+    return Read(value, sizeof(*value));
+  }
+
+  bool ReadString(std::string* str) {
+    uint32_t size = 0;
+    if (!ReadValue(&size) || size > size_ - offset_) {
+      return false;
+    }
+    str->assign(reinterpret_cast<const char*>(data_ + offset_), size);
+    offset_ += size;
+    return true;
+  }
+
+  // Skips a buffer of the size, and returns its offset.
+  bool SkipBuffer(int64_t size, int64_t* buffer_offset) {
+    if (size < 0 || AlignUp(size) > size_ - offset_) {
+      return false;
+    }
+    *buffer_offset = offset_;
+    offset_ += AlignUp(size);
+    return true;
+  }
+
+  bool Align() {
+    int64_t aligned = AlignUp(offset_);
+    if (aligned > size_) {
+      return false;
+    }
+    offset_ = aligned;
+    return true;
+  }
+
+  bool AtEnd() const { return offset_ == size_; }
+  int64_t offset() const { return offset_; }
+
+ private:
+  const uint8_t* const data_;
+  const int64_t size_;
+  int64_t offset_;
+};
+
+Status WriteBatch(const std::vector<std::shared_ptr<arrow::Array>>& columns, int64_t num_rows,
+                  SnapshotWriter* writer) {
+  // The batch header lists the sizes of the buffers, which follow it.
+  PL_RETURN_IF_ERROR(writer->WriteValue<int64_t>(num_rows));
+  for (const auto& col : columns) {
+    PL_RETURN_IF_ERROR(writer->WriteValue<int64_t>(col->null_count()));
+    PL_RETURN_IF_ERROR(writer->WriteValue<uint32_t>(col->data()->buffers.size()));
+    for (const auto& buffer : col->data()->buffers) {
+      PL_RETURN_IF_ERROR(writer->WriteValue<int64_t>(buffer == nullptr ? -1 : buffer->size()));
+    }
+  }
+  PL_RETURN_IF_ERROR(writer->Align());
+  for (const auto& col : columns) {
+    for (const auto& buffer : col->data()->buffers) {
+      if (buffer != nullptr) {
+        PL_RETURN_IF_ERROR(writer->Write(buffer->data(), buffer->size()));
+        PL_RETURN_IF_ERROR(writer->Align());
+      }
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<int64_t> WriteTableSnapshot(const Table& table, const std::string& table_name,
+                                     const types::TabletID& tablet_id, const std::string& path,
+                                     std::chrono::steady_clock::time_point deadline,
+                                     arrow::MemoryPool* mem_pool) {
+  std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return error::System("Failed to create table snapshot $0: $1", tmp_path,
+                         std::strerror(errno));
+  }
+  auto write_snapshot = [&]() -> StatusOr<int64_t> {
+    SnapshotWriter writer(fd);
+    PL_RETURN_IF_ERROR(writer.Write(kSnapshotMagic, sizeof(kSnapshotMagic)));
+    PL_RETURN_IF_ERROR(writer.WriteValue(kSnapshotVersion));
+    PL_RETURN_IF_ERROR(writer.WriteString(table_name));
+    PL_RETURN_IF_ERROR(writer.WriteString(tablet_id));
+    schema::Relation relation = table.GetRelation();
+    PL_RETURN_IF_ERROR(writer.WriteValue<uint32_t>(relation.NumColumns()));
+    for (size_t i = 0; i < relation.NumColumns(); ++i) {
+      PL_RETURN_IF_ERROR(writer.WriteValue<int32_t>(relation.GetColumnType(i)));
+      PL_RETURN_IF_ERROR(writer.WriteString(relation.GetColumnName(i)));
+    }
+    PL_RETURN_IF_ERROR(writer.Align());
+
+    std::vector<int64_t> cols(relation.NumColumns());
+    for (size_t i = 0; i < cols.size(); ++i) {
+      cols[i] = i;
+    }
+    int64_t num_rows = 0;
+    for (auto slice = table.FirstBatch(); slice.IsValid(); slice = table.NextBatch(slice)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        LOG(WARNING) << absl::Substitute(
+            "Table snapshot $0 ran out of time, it only holds the first $1 rows.", path, num_rows);
+        break;
+      }
+      PL_ASSIGN_OR_RETURN(auto rb, table.GetRowBatchSlice(slice, cols, mem_pool));
+      if (rb->num_rows() == 0) {
+        continue;
+      }
+      std::vector<std::shared_ptr<arrow::Array>> columns = rb->columns();
+      bool sliced = false;
+      for (const auto& col : columns) {
+        sliced |= col->offset() != 0;
+      }
+      if (sliced) {
+        // The snapshot holds whole buffers, so slices that don't start at the front of their
+        // buffers are copied.
+        ArrowArrayCompactor compactor(relation, mem_pool);
+        for (size_t i = 0; i < columns.size(); ++i) {
+          PL_RETURN_IF_ERROR(compactor.AppendColumn(i, columns[i]));
+        }
+        PL_RETURN_IF_ERROR(compactor.Finish());
+        columns = compactor.output_columns();
+      }
+      PL_RETURN_IF_ERROR(WriteBatch(columns, rb->num_rows(), &writer));
+      num_rows += rb->num_rows();
+    }
+    return num_rows;
+  };
+  auto num_rows_or = write_snapshot();
+  Status s = num_rows_or.status();
+  if (close(fd) != 0 && s.ok()) {
+    s = error::System("Failed to close table snapshot $0: $1", tmp_path, std::strerror(errno));
+  }
+  // Only complete snapshots replace the previous one.
+  if (s.ok() && std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    s = error::System("Failed to rename table snapshot $0: $1", tmp_path, std::strerror(errno));
+  }
+  if (!s.ok()) {
+    unlink(tmp_path.c_str());
+    return s;
+  }
+  return num_rows_or;
+}
+
+/**
+ * A read-only memory mapping of a snapshot file, which is unmapped once neither the snapshot nor
+ * any array restored from it references it.
+ */
+class TableSnapshot::Mapping : public NotCopyable {
+ public:
+  Mapping(const uint8_t* data, int64_t size) : data_(data), size_(size) {}
+  ~Mapping() {
+    if (size_ > 0) {
+      munmap(const_cast<uint8_t*>(data_), size_);
+    }
+  }
+
+  const uint8_t* data() const { return data_; }
+  int64_t size() const { return size_; }
+
+ private:
+  const uint8_t* const data_;
+  const int64_t size_;
+};
+
+namespace {
+
+/**
+ * An arrow::Buffer that references a snapshot file in place, and keeps it mapped for as long as
+ * the buffer is referenced.
+ */
+class SnapshotBuffer : public arrow::Buffer {
+ public:
+  SnapshotBuffer(std::shared_ptr<const void> mapping, const uint8_t* data, int64_t size)
+      : arrow::Buffer(data, size), mapping_(std::move(mapping)) {}
+
+ private:
+  std::shared_ptr<const void> mapping_;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<TableSnapshot>> TableSnapshot::Open(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::System("Failed to open table snapshot $0: $1", path, std::strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return error::System("Failed to stat table snapshot $0: $1", path, std::strerror(errno));
+  }
+  const uint8_t* data = nullptr;
+  if (st.st_size > 0) {
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, /* offset */ 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      return error::System("Failed to map table snapshot $0: $1", path, std::strerror(errno));
+    }
+    data = static_cast<const uint8_t*>(mapped);
+  }
+  // The mapping outlives the file descriptor.
+  close(fd);
+  auto mapping = std::make_shared<Mapping>(data, st.st_size);
+
+  SnapshotReader reader(mapping->data(), mapping->size(), /* offset */ 0);
+  char magic[sizeof(kSnapshotMagic)];
+  uint32_t version = 0;
+  if (!reader.Read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kSnapshotMagic, sizeof(magic)) != 0 || !reader.ReadValue(&version)) {
+    return error::InvalidArgument("$0 isn't a table snapshot", path);
+  }
+  if (version != kSnapshotVersion) {
+    return error::InvalidArgument("Table snapshot $0 has unsupported version $1", path, version);
+  }
+  TableSnapshotInfo info;
+  uint32_t num_columns = 0;
+  if (!reader.ReadString(&info.table_name) || !reader.ReadString(&info.tablet_id) ||
+      !reader.ReadValue(&num_columns)) {
+    return error::InvalidArgument("Table snapshot $0 has a truncated header", path);
+  }
+  for (uint32_t i = 0; i < num_columns; ++i) {
+    int32_t type = 0;
+    std::string name;
+    if (!reader.ReadValue(&type) || !reader.ReadString(&name)) {
+      return error::InvalidArgument("Table snapshot $0 has a truncated header", path);
+    }
+    info.relation.AddColumn(static_cast<types::DataType>(type), name);
+  }
+  if (!reader.Align()) {
+    return error::InvalidArgument("Table snapshot $0 has a truncated header", path);
+  }
+  return std::unique_ptr<TableSnapshot>(
+      new TableSnapshot(std::move(mapping), std::move(info), reader.offset()));
+}
+
+StatusOr<int64_t> TableSnapshot::Restore(Table* table) const {
+  schema::Relation relation = table->GetRelation();
+  if (relation.col_types() != info_.relation.col_types() ||
+      relation.col_names() != info_.relation.col_names()) {
+    return error::FailedPrecondition(
+        "The snapshot of table $0 has columns $1, which don't match the columns $2 of the table",
+        info_.table_name, info_.relation.DebugString(), relation.DebugString());
+  }
+  const auto num_columns = static_cast<int64_t>(relation.NumColumns());
+  schema::RowDescriptor desc(relation.col_types());
+  SnapshotReader reader(mapping_->data(), mapping_->size(), batches_offset_);
+  int64_t num_rows = 0;
+  while (!reader.AtEnd()) {
+    // Each batch is checked before any of it is written, so a truncated batch is left out whole.
+    int64_t batch_rows = 0;
+    std::vector<int64_t> null_counts(num_columns);
+    std::vector<std::vector<int64_t>> buffer_sizes(num_columns);
+    bool ok = reader.ReadValue(&batch_rows) && batch_rows > 0;
+    for (int64_t i = 0; ok && i < num_columns; ++i) {
+      uint32_t num_buffers = 0;
+      // Strings have validity, offset and data buffers, the other types validity and value ones.
+      uint32_t expected_buffers = relation.GetColumnType(i) == types::STRING ? 3 : 2;
+      ok = reader.ReadValue(&null_counts[i]) && reader.ReadValue(&num_buffers) &&
+           num_buffers == expected_buffers;
+      buffer_sizes[i].resize(ok ? num_buffers : 0);
+      for (auto& size : buffer_sizes[i]) {
+        ok = ok && reader.ReadValue(&size);
+      }
+    }
+    ok = ok && reader.Align();
+
+    schema::RowBatch rb(desc, batch_rows);
+    for (int64_t i = 0; ok && i < num_columns; ++i) {
+      std::vector<std::shared_ptr<arrow::Buffer>> buffers;
+      for (int64_t size : buffer_sizes[i]) {
+        int64_t offset = 0;
+        if (size == -1) {
+          buffers.push_back(nullptr);
+        } else if ((ok = reader.SkipBuffer(size, &offset))) {
+          buffers.push_back(
+              std::make_shared<SnapshotBuffer>(mapping_, mapping_->data() + offset, size));
+        }
+      }
+      if (ok) {
+        auto array_data = arrow::ArrayData::Make(
+            types::DataTypeToArrowType(relation.GetColumnType(i)), batch_rows, std::move(buffers),
+            null_counts[i]);
+        ok = rb.AddColumn(arrow::MakeArray(array_data)).ok();
+      }
+    }
+    if (!ok) {
+      LOG(WARNING) << absl::Substitute(
+          "The snapshot of table $0 is truncated, restored its first $1 rows.", info_.table_name,
+          num_rows);
+      break;
+    }
+    PL_RETURN_IF_ERROR(table->WriteRowBatch(rb));
+    num_rows += batch_rows;
+  }
+  return num_rows;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/table.h"
+
+DECLARE_string(table_store_snapshot_dir);
+DECLARE_int32(table_store_snapshot_timeout_ms);
+
+namespace px {
+namespace table_store {
+
+/**
+ * Table snapshots keep the rows of a table across restarts of the agent, e.g. while it is upgraded.
+ * A snapshot file holds the relation of the table, and the columns of each of its batches, hot and
+ * cold, in the layout of arrow arrays. The buffers are aligned like the ones arrow allocates, so
+ * restored batches reference the memory mapped file in place, like the batches of a SpillTier.
+ *
+ * Row IDs and the time index aren't stored, the table assigns and indexes the restored rows as
+ * they are written, which only takes a pass over the batches.
+ */
+
+/**
+ * Writes the rows of the table to a snapshot file at the path. Batches are written oldest first,
+ * and once the deadline passes no more batches are written, so the snapshot is still valid but
+ * holds only the older rows. The file is written next to the path and renamed into place.
+ *
+ * @param table_name the name of the table, which is stored in the snapshot.
+ * @param tablet_id the tablet of the table, which is stored in the snapshot.
+ * @return the number of rows written.
+ */
+StatusOr<int64_t> WriteTableSnapshot(const Table& table, const std::string& table_name,
+                                     const types::TabletID& tablet_id, const std::string& path,
+                                     std::chrono::steady_clock::time_point deadline,
+                                     arrow::MemoryPool* mem_pool);
+
+/**
+ * The table that a snapshot file was written for.
+ */
+struct TableSnapshotInfo {
+  std::string table_name;
+  types::TabletID tablet_id;
+  schema::Relation relation;
+};
+
+/**
+ * A snapshot file, memory mapped to be restored. The mapping stays alive for as long as the
+ * batches restored from it reference it, even if the file is removed.
+ */
+class TableSnapshot : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<TableSnapshot>> Open(const std::string& path);
+
+  const TableSnapshotInfo& info() const { return info_; }
+
+  /**
+   * Writes the rows of the snapshot to the table, whose relation must have the same column names
+   * and types as the relation of the snapshot.
+   * @return the number of rows restored.
+   */
+  StatusOr<int64_t> Restore(Table* table) const;
+
+ private:
+  class Mapping;
+
+  TableSnapshot(std::shared_ptr<Mapping> mapping, TableSnapshotInfo info, int64_t batches_offset)
+      : mapping_(std::move(mapping)), info_(std::move(info)), batches_offset_(batches_offset) {}
+
+  const std::shared_ptr<Mapping> mapping_;
+  const TableSnapshotInfo info_;
+  // The offset of the first batch in the file.
+  const int64_t batches_offset_;
+};
+
+}  // namespace table_store
+}  // namespace px
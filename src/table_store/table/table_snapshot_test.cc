@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <arrow/array.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/table_snapshot.h"
+#include "src/table_store/table/table_store.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+constexpr auto kNoDeadline = std::chrono::steady_clock::time_point::max();
+
+void WriteTestBatch(Table* table, std::vector<types::Time64NSValue> times,
+                    std::vector<types::StringValue> names) {
+  schema::RowBatch rb(schema::RowDescriptor(table->GetRelation().col_types()), times.size());
+  PL_CHECK_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+  PL_CHECK_OK(rb.AddColumn(types::ToArrow(names, arrow::default_memory_pool())));
+  PL_CHECK_OK(table->WriteRowBatch(rb));
+}
+
+// Reads the names of the rows held by the table, oldest first.
+std::vector<std::string> ReadNames(const Table& table) {
+  std::vector<std::string> names;
+  for (auto slice = table.FirstBatch(); slice.IsValid(); slice = table.NextBatch(slice)) {
+    auto rb = table.GetRowBatchSlice(slice, {0, 1}, arrow::default_memory_pool())
+                  .ConsumeValueOrDie();
+    for (int64_t i = 0; i < rb->num_rows(); ++i) {
+      names.push_back(types::GetValueFromArrowArray<types::STRING>(rb->ColumnAt(1).get(), i));
+    }
+  }
+  return names;
+}
+
+}  // namespace
+
+class TableSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    table_ = Table::Create("test_table", rel_);
+    WriteTestBatch(table_.get(), {1, 2, 3}, {"a", "bb", "ccc"});
+    // The first batch is compacted into cold storage, the second one stays hot.
+    PL_CHECK_OK(table_->CompactHotToCold(arrow::default_memory_pool()));
+    WriteTestBatch(table_.get(), {4, 5}, {"dddd", ""});
+  }
+
+  std::string SnapshotPath() const { return (dir_.path() / "table.snapshot").string(); }
+
+  schema::Relation rel_{{types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "name"}};
+  std::shared_ptr<Table> table_;
+  px::testing::TempDir dir_;
+};
+
+TEST_F(TableSnapshotTest, restores_hot_and_cold_batches) {
+  ASSERT_OK_AND_EQ(WriteTableSnapshot(*table_, "test_table", "tablet", SnapshotPath(),
+                                      kNoDeadline, arrow::default_memory_pool()),
+                   5);
+  EXPECT_FALSE(std::filesystem::exists(SnapshotPath() + ".tmp"));
+
+  ASSERT_OK_AND_ASSIGN(auto snapshot, TableSnapshot::Open(SnapshotPath()));
+  EXPECT_EQ("test_table", snapshot->info().table_name);
+  EXPECT_EQ("tablet", snapshot->info().tablet_id);
+  EXPECT_EQ(rel_, snapshot->info().relation);
+
+  // The restored batches keep the mapping of the file alive once it's removed.
+  std::filesystem::remove(SnapshotPath());
+  auto restored = Table::Create("test_table", rel_);
+  ASSERT_OK_AND_EQ(snapshot->Restore(restored.get()), 5);
+  snapshot.reset();
+  EXPECT_THAT(ReadNames(*restored), ::testing::ElementsAre("a", "bb", "ccc", "dddd", ""));
+
+  auto stats = restored->GetTableStats();
+  EXPECT_EQ(5, stats.num_rows);
+  EXPECT_EQ(1, stats.min_time);
+  EXPECT_EQ(5, stats.max_time);
+  ASSERT_OK_AND_ASSIGN(auto slice,
+                       restored->FindBatchSliceGreaterThanOrEqual(4, arrow::default_memory_pool()));
+  EXPECT_TRUE(slice.IsValid());
+}
+
+TEST_F(TableSnapshotTest, rejects_changed_columns) {
+  ASSERT_OK(WriteTableSnapshot(*table_, "test_table", "", SnapshotPath(), kNoDeadline,
+                               arrow::default_memory_pool()));
+  ASSERT_OK_AND_ASSIGN(auto snapshot, TableSnapshot::Open(SnapshotPath()));
+
+  schema::Relation renamed({types::DataType::TIME64NS, types::DataType::STRING},
+                           {"time_", "other"});
+  auto table = Table::Create("test_table", renamed);
+  EXPECT_NOT_OK(snapshot->Restore(table.get()));
+  EXPECT_EQ(0, table->GetTableStats().num_rows);
+}
+
+TEST_F(TableSnapshotTest, stops_at_deadline) {
+  ASSERT_OK_AND_EQ(WriteTableSnapshot(*table_, "test_table", "", SnapshotPath(),
+                                      std::chrono::steady_clock::now() - std::chrono::seconds(1),
+                                      arrow::default_memory_pool()),
+                   0);
+  ASSERT_OK_AND_ASSIGN(auto snapshot, TableSnapshot::Open(SnapshotPath()));
+  auto table = Table::Create("test_table", rel_);
+  ASSERT_OK_AND_EQ(snapshot->Restore(table.get()), 0);
+}
+
+TEST_F(TableSnapshotTest, rejects_other_files) {
+  std::string path = (dir_.path() / "other").string();
+  { std::ofstream(path) << "not a snapshot"; }
+  EXPECT_NOT_OK(TableSnapshot::Open(path));
+  EXPECT_NOT_OK(TableSnapshot::Open((dir_.path() / "missing").string()));
+}
+
+TEST_F(TableSnapshotTest, table_store_round_trip) {
+  TableStore table_store;
+  table_store.AddTable(table_, "test_table", 1);
+  ASSERT_OK(table_store.SetTabletizationKey("test_table", 1));
+  auto rb = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto times = types::ColumnWrapper::Make(types::DataType::TIME64NS, 0);
+  times->Append<types::Time64NSValue>(6);
+  auto names = types::ColumnWrapper::Make(types::DataType::STRING, 0);
+  names->Append<types::StringValue>("tablet");
+  rb->push_back(times);
+  rb->push_back(names);
+  ASSERT_OK(table_store.AppendData(1, "tablet", std::move(rb)));
+  ASSERT_OK_AND_EQ(table_store.WriteSnapshot(dir_.path().string(), kNoDeadline,
+                                             arrow::default_memory_pool()),
+                   6);
+
+  TableStore restored;
+  restored.AddTable(Table::Create("test_table", rel_), "test_table", 1);
+  ASSERT_OK_AND_EQ(restored.RestoreSnapshot(dir_.path().string()), 6);
+  EXPECT_THAT(ReadNames(*restored.GetTable("test_table")),
+              ::testing::ElementsAre("a", "bb", "ccc", "dddd", ""));
+  ASSERT_NE(nullptr, restored.GetTable("test_table", "tablet"));
+  EXPECT_THAT(ReadNames(*restored.GetTable("test_table", "tablet")),
+              ::testing::ElementsAre("tablet"));
+
+  // The snapshot is only restored once.
+  TableStore restarted;
+  restarted.AddTable(Table::Create("test_table", rel_), "test_table", 1);
+  ASSERT_OK_AND_EQ(restarted.RestoreSnapshot(dir_.path().string()), 0);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -16,16 +16,48 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <time.h>
+
 #include <algorithm>
+#include <filesystem>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "src/common/metrics/named_timer.h"
+#include "src/table_store/table/table_snapshot.h"
 #include "src/table_store/table/table_store.h"
 
 namespace px {
 namespace table_store {
 
+namespace {
+
+constexpr std::string_view kSnapshotExtension = ".snapshot";
+
+// Lists the snapshot files in the directory.
+std::vector<std::filesystem::path> ListSnapshots(const std::string& dir) {
+  std::vector<std::filesystem::path> paths;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == kSnapshotExtension) {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+std::chrono::nanoseconds ThreadCPUTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+}  // namespace
+
 std::unique_ptr<std::unordered_map<std::string, schema::Relation>> TableStore::GetRelationMap() {
+  absl::ReaderMutexLock lock(&tables_lock_);
   auto map = std::make_unique<RelationMap>();
   map->reserve(name_to_relation_map_.size());
   for (auto& [table_name, relation] : name_to_relation_map_) {
@@ -34,6 +66,34 @@ std::unique_ptr<std::unordered_map<std::string, schema::Relation>> TableStore::G
   return map;
 }
 
+absl::flat_hash_map<std::string, int64_t> TableStore::GetTableRowCounts() const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  absl::flat_hash_map<std::string, int64_t> row_counts;
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    row_counts[name_tablet.name_] += table->GetTableStats().num_rows;
+  }
+  return row_counts;
+}
+
+absl::flat_hash_map<std::string, std::pair<int64_t, int64_t>> TableStore::GetTableTimeRanges()
+    const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  absl::flat_hash_map<std::string, std::pair<int64_t, int64_t>> time_ranges;
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    TableStats stats = table->GetTableStats();
+    if (stats.min_time < 0) {
+      continue;
+    }
+    auto [iter, inserted] =
+        time_ranges.try_emplace(name_tablet.name_, stats.min_time, stats.max_time);
+    if (!inserted) {
+      iter->second.first = std::min(iter->second.first, stats.min_time);
+      iter->second.second = std::max(iter->second.second, stats.max_time);
+    }
+  }
+  return time_ranges;
+}
+
 StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id) {
   auto id_to_table_info_map_iter = id_to_table_info_map_.find(table_id);
   if (id_to_table_info_map_iter == id_to_table_info_map_.end()) {
@@ -60,13 +120,51 @@ Status TableStore::AppendData(uint64_t table_id, types::TabletID tablet_id,
   Table* table = GetTable(table_id, tablet_id);
   // We create new tablets only if the table at `table_id` exists, otherwise errors out.
   if (table == nullptr) {
-    PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, tablet_id));
+    absl::MutexLock lock(&tables_lock_);
+    // The tablet might have been created since it was looked up.
+    table = GetTableLocked(table_id, tablet_id);
+    if (table == nullptr) {
+      PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, tablet_id));
+    }
   }
   return table->TransferRecordBatch(std::move(record_batch));
 }
 
+Status TableStore::SetTabletizationKey(const std::string& table_name, int64_t key_col_idx) {
+  absl::MutexLock lock(&tables_lock_);
+  auto relation_iter = name_to_relation_map_.find(table_name);
+  if (relation_iter == name_to_relation_map_.end()) {
+    return error::NotFound("Table $0 not found.", table_name);
+  }
+  if (key_col_idx < 0 || key_col_idx >= static_cast<int64_t>(relation_iter->second.NumColumns())) {
+    return error::InvalidArgument("Table $0 has no column $1.", table_name, key_col_idx);
+  }
+  tabletization_keys_[table_name] = key_col_idx;
+  return Status::OK();
+}
+
+int64_t TableStore::GetTabletizationKey(const std::string& table_name) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  auto iter = tabletization_keys_.find(table_name);
+  return iter == tabletization_keys_.end() ? -1 : iter->second;
+}
+
+std::vector<std::pair<types::TabletID, Table*>> TableStore::GetTablets(
+    const std::string& table_name) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  std::vector<std::pair<types::TabletID, Table*>> tablets;
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    if (name_tablet.name_ == table_name) {
+      tablets.emplace_back(name_tablet.tablet_id_, table.get());
+    }
+  }
+  std::sort(tablets.begin(), tablets.end());
+  return tablets;
+}
+
 table_store::Table* TableStore::GetTable(const std::string& table_name,
                                          const types::TabletID& tablet_id) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   auto name_to_table_iter = name_to_table_map_.find(NameTablet{table_name, tablet_id});
   if (name_to_table_iter == name_to_table_map_.end()) {
     return nullptr;
@@ -76,6 +174,12 @@ table_store::Table* TableStore::GetTable(const std::string& table_name,
 
 table_store::Table* TableStore::GetTable(uint64_t table_id,
                                          const types::TabletID& tablet_id) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  return GetTableLocked(table_id, tablet_id);
+}
+
+table_store::Table* TableStore::GetTableLocked(uint64_t table_id,
+                                               const types::TabletID& tablet_id) const {
   auto id_to_table_iter = id_to_table_map_.find(TableIDTablet{table_id, tablet_id});
   if (id_to_table_iter == id_to_table_map_.end()) {
     return nullptr;
@@ -116,6 +220,7 @@ void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::
                           std::optional<uint64_t> table_id, const types::TabletID& tablet_id) {
   const auto& table_relation = table->GetRelation();
 
+  absl::MutexLock lock(&tables_lock_);
   // Register the table by name.
   RegisterTableName(table_name, tablet_id, table_relation, table);
 
@@ -126,6 +231,7 @@ void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::
 }
 
 Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_name) {
+  absl::MutexLock lock(&tables_lock_);
   auto table_iter = name_to_table_map_.find({table_name, ""});
   if (table_iter == name_to_table_map_.end()) {
     return error::Internal(
@@ -147,10 +253,12 @@ Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_nam
 }
 
 Status TableStore::SchemaAsProto(schemapb::Schema* schema) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   return schema::Schema::ToProto(schema, name_to_relation_map_);
 }
 
 std::vector<uint64_t> TableStore::GetTableIDs() const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   std::vector<uint64_t> ids;
   for (const auto& it : id_to_table_map_) {
     ids.emplace_back(it.first.table_id_);
@@ -159,8 +267,125 @@ std::vector<uint64_t> TableStore::GetTableIDs() const {
 }
 
 Status TableStore::RunCompaction(arrow::MemoryPool* mem_pool) {
-  for (const auto& it : name_to_table_map_) {
-    PL_RETURN_IF_ERROR(it.second->CompactHotToCold(mem_pool));
+  static auto* timer = new metrics::NamedTimer("table_store", "run_compaction");
+  metrics::ScopedNamedTimer scoped_timer(timer);
+  // The tables are compacted without the lock, so that new tablets aren't held up.
+  for (const auto& table : GetTables()) {
+    PL_RETURN_IF_ERROR(table->CompactHotToCold(mem_pool));
+  }
+  return Status::OK();
+}
+
+std::vector<std::shared_ptr<Table>> TableStore::GetTables() const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  std::vector<std::shared_ptr<Table>> tables;
+  tables.reserve(name_to_table_map_.size());
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    tables.push_back(table);
+  }
+  return tables;
+}
+
+StatusOr<int64_t> TableStore::WriteSnapshot(const std::string& dir,
+                                            std::chrono::steady_clock::time_point deadline,
+                                            arrow::MemoryPool* mem_pool) const {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return error::System("Failed to create table snapshot directory $0: $1", dir, ec.message());
+  }
+  // Snapshots of an earlier run would be restored alongside the new ones.
+  for (const auto& path : ListSnapshots(dir)) {
+    std::filesystem::remove(path, ec);
+  }
+
+  std::vector<std::pair<NameTablet, std::shared_ptr<Table>>> tables;
+  {
+    absl::ReaderMutexLock lock(&tables_lock_);
+    tables.assign(name_to_table_map_.begin(), name_to_table_map_.end());
+  }
+  int64_t num_rows = 0;
+  for (size_t i = 0; i < tables.size(); ++i) {
+    const auto& [name_tablet, table] = tables[i];
+    if (std::chrono::steady_clock::now() > deadline) {
+      LOG(WARNING) << absl::Substitute("Table snapshot ran out of time, skipped $0 tablets.",
+                                       tables.size() - i);
+      break;
+    }
+    auto path = std::filesystem::path(dir) / absl::StrCat("table_", i, kSnapshotExtension);
+    auto rows_or = WriteTableSnapshot(*table, name_tablet.name_, name_tablet.tablet_id_, path,
+                                      deadline, mem_pool);
+    if (!rows_or.ok()) {
+      LOG(ERROR) << absl::Substitute("Failed to snapshot table $0: $1", name_tablet.name_,
+                                     rows_or.msg());
+      continue;
+    }
+    num_rows += rows_or.ValueOrDie();
+  }
+  return num_rows;
+}
+
+StatusOr<int64_t> TableStore::RestoreSnapshot(const std::string& dir) {
+  int64_t num_rows = 0;
+  for (const auto& path : ListSnapshots(dir)) {
+    auto snapshot_or = TableSnapshot::Open(path);
+    // The mapping keeps the restored batches readable once the file is removed.
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    if (!snapshot_or.ok()) {
+      LOG(ERROR) << absl::Substitute("Failed to open table snapshot $0: $1", path.string(),
+                                     snapshot_or.msg());
+      continue;
+    }
+    auto snapshot = snapshot_or.ConsumeValueOrDie();
+    const TableSnapshotInfo& info = snapshot->info();
+
+    Table* table = GetTable(info.table_name, info.tablet_id);
+    if (table == nullptr && info.tablet_id != kDefaultTablet) {
+      absl::MutexLock lock(&tables_lock_);
+      for (const auto& [table_id, table_info] : id_to_table_info_map_) {
+        if (table_info.table_name == info.table_name) {
+          PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, info.tablet_id));
+          break;
+        }
+      }
+    }
+    if (table == nullptr) {
+      LOG(WARNING) << absl::Substitute("Skipping the snapshot of table $0, it doesn't exist.",
+                                       info.table_name);
+      continue;
+    }
+    auto rows_or = snapshot->Restore(table);
+    if (!rows_or.ok()) {
+      LOG(WARNING) << absl::Substitute("Skipping the snapshot of table $0: $1", info.table_name,
+                                       rows_or.msg());
+      continue;
+    }
+    num_rows += rows_or.ValueOrDie();
+  }
+  return num_rows;
+}
+
+Status CompactTables(const std::vector<std::shared_ptr<Table>>& tables, arrow::MemoryPool* mem_pool,
+                     std::chrono::nanoseconds cpu_budget) {
+  static auto* timer = new metrics::NamedTimer("table_store", "compact_tables");
+  metrics::ScopedNamedTimer scoped_timer(timer);
+  const std::chrono::nanoseconds start = ThreadCPUTime();
+  // The tables that may still have enough hot bytes for a cold batch.
+  std::vector<Table*> candidates;
+  candidates.reserve(tables.size());
+  for (const auto& table : tables) {
+    candidates.push_back(table.get());
+  }
+  while (!candidates.empty() && ThreadCPUTime() - start < cpu_budget) {
+    // The hot bytes change as records are written, so the priority is looked up for every batch.
+    auto next = std::max_element(candidates.begin(), candidates.end(), [](Table* a, Table* b) {
+      return a->HotBytes() < b->HotBytes();
+    });
+    PL_ASSIGN_OR_RETURN(bool compacted, (*next)->CompactNextBatch(mem_pool));
+    if (!compacted) {
+      candidates.erase(next);
+    }
   }
   return Status::OK();
 }
@@ -18,13 +18,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <absl/base/thread_annotations.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
@@ -75,6 +78,9 @@ struct TableInfo {
 
 /**
  * TableStore keeps track of the tables in our system.
+ *
+ * The tablets of tabletized tables are created as their data arrives, so the tables can be looked
+ * up while data is appended.
  */
 class TableStore {
  public:
@@ -139,6 +145,17 @@ class TableStore {
    */
   std::unique_ptr<RelationMap> GetRelationMap();
 
+  /**
+   * @return A map of table name to the number of rows the table holds, summed over its tablets.
+   */
+  absl::flat_hash_map<std::string, int64_t> GetTableRowCounts() const;
+
+  /**
+   * @return A map of table name to the first and last times of the rows the table holds, over its
+   * tablets. Tables without rows or without a time_ column are left out.
+   */
+  absl::flat_hash_map<std::string, std::pair<int64_t, int64_t>> GetTableTimeRanges() const;
+
   /**
    * @brief Appends the record_batch to the sepcified table and tablet_id. If the table exists but
    * the tablet does not, then the method creates a new container for the tablet.
@@ -152,12 +169,33 @@ class TableStore {
   Status AppendData(uint64_t table_id, types::TabletID tablet_id,
                     std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch);
 
+  /**
+   * Marks the table as split into tablets by the values of the column, rather than held in its
+   * default tablet. Reads of the table that don't name tablets then read all of its tablets, or
+   * only the tablet of the key value that a predicate of the read selects.
+   *
+   * @return error::NotFound if there is no such table.
+   */
+  Status SetTabletizationKey(const std::string& table_name, int64_t key_col_idx);
+
+  /**
+   * @return the index of the tabletization key column of the table, or -1 if it isn't marked as
+   * tabletized.
+   */
+  int64_t GetTabletizationKey(const std::string& table_name) const;
+
+  /**
+   * @return the tablets of the table, including its default tablet, sorted by tablet ID.
+   */
+  std::vector<std::pair<types::TabletID, Table*>> GetTablets(const std::string& table_name) const;
+
   Status SchemaAsProto(schemapb::Schema* schema) const;
 
   /**
    * GetTableName returns the table name if the ID is found, else empty string.
    */
   std::string GetTableName(uint64_t id) const {
+    absl::ReaderMutexLock lock(&tables_lock_);
     const auto& it = id_to_table_info_map_.find(id);
     if (it != id_to_table_info_map_.end()) {
       return it->second.table_name;
@@ -167,13 +205,41 @@ class TableStore {
 
   Status RunCompaction(arrow::MemoryPool* mem_pool);
 
+  /**
+   * @return the tables of every name and tablet, so that they can be worked on without the table
+   * store.
+   */
+  std::vector<std::shared_ptr<Table>> GetTables() const;
+
+  /**
+   * Writes a snapshot of every tablet of every table to the directory, replacing the snapshots it
+   * held, see WriteTableSnapshot. Tables are skipped once the deadline passes.
+   * @return the number of rows written.
+   */
+  StatusOr<int64_t> WriteSnapshot(const std::string& dir,
+                                  std::chrono::steady_clock::time_point deadline,
+                                  arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Restores the snapshots in the directory into the tablets of the same tables, creating the
+   * tablets that are missing. Snapshots of tables that don't exist, or whose columns changed, are
+   * skipped. The snapshot files are removed once read, so they are restored only once.
+   * @return the number of rows restored.
+   */
+  StatusOr<int64_t> RestoreSnapshot(const std::string& dir);
+
  private:
   void RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
                          const schema::Relation& table_relation,
-                         std::shared_ptr<table_store::Table> table);
+                         std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
 
   void RegisterTableID(uint64_t table_id, TableInfo table_info, const types::TabletID& tablet_id,
-                       std::shared_ptr<table_store::Table> table);
+                       std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
+
+  table_store::Table* GetTableLocked(uint64_t table_id, const types::TabletID& tablet_id) const
+      ABSL_SHARED_LOCKS_REQUIRED(tables_lock_);
 
   /**
    * Create a new tablet inside of the table with table_id
@@ -182,22 +248,39 @@ class TableStore {
    * @param tablet_id: the tablet to create for the tablet.
    * @return StatusOr<Table*>: the table object or an error if the table is nonexistant.
    */
-  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id);
+  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
 
   // The default value for tablets, when tablet is not specified.
   inline static types::TabletID kDefaultTablet = "";
+
+  mutable absl::Mutex tables_lock_;
   // Map a name to a table.
-  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_;
+  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_
+      ABSL_GUARDED_BY(tables_lock_);
   // Map an id to a table.
-  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_;
+  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_
+      ABSL_GUARDED_BY(tables_lock_);
   // Mapping from name to relation for adding new tablets.
   // TODO(oazizi): value should likely be shared_ptr<schema::Relation> because the
   //               same information is in id_to_table_info_map_ TableInfo.
   //               Can avoid this copy.
-  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_;
+  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_
+      ABSL_GUARDED_BY(tables_lock_);
   // Mapping from id to name and relation pair for adding new tablets.
-  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_;
+  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_ ABSL_GUARDED_BY(tables_lock_);
+  // The tabletization key column of the tables that are split into tablets, by name.
+  absl::flat_hash_map<std::string, int64_t> tabletization_keys_ ABSL_GUARDED_BY(tables_lock_);
 };
 
+/**
+ * Compacts the hot batches of the tables into cold batches, one batch at a time, until the calling
+ * thread has used `cpu_budget` of CPU time or none of the tables holds enough hot bytes for a cold
+ * batch. Each batch is taken from the table with the most hot bytes, so that the tables that are
+ * written the fastest are drained first when the budget doesn't cover all of them.
+ */
+Status CompactTables(const std::vector<std::shared_ptr<Table>>& tables, arrow::MemoryPool* mem_pool,
+                     std::chrono::nanoseconds cpu_budget);
+
 }  // namespace table_store
 }  // namespace px
@@ -86,6 +86,71 @@ TEST_F(TableStoreTest, basic) {
   EXPECT_EQ("table2col3", lookup->at("b").GetColumnName(2));
 }
 
+TEST_F(TableStoreTest, get_table_row_counts) {
+  auto table_store = TableStore();
+  table_store.AddTable(table1, "a", 1);
+  table_store.AddTable(table2, "b", 2);
+  EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+
+  EXPECT_THAT(table_store.GetTableRowCounts(),
+              ::testing::UnorderedElementsAre(::testing::Pair("a", 6), ::testing::Pair("b", 0)));
+}
+
+TEST_F(TableStoreTest, get_table_time_ranges) {
+  schema::Relation rel({types::DataType::TIME64NS}, {"time_"});
+  auto table_store = TableStore();
+  table_store.AddTable(Table::Create("a", rel), "a", 1);
+  table_store.AddTable(Table::Create("b", rel), "b", 2);
+  // Tables without a time_ column are left out.
+  table_store.AddTable(table1, "c", 3);
+  EXPECT_OK(table_store.AppendData(3, "", MakeRel1ColumnWrapperBatch()));
+
+  auto append_times = [&](types::TabletID tablet_id, std::vector<types::Time64NSValue> times) {
+    auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col = std::make_shared<types::Time64NSValueColumnWrapper>(times.size());
+    col->Clear();
+    col->AppendFromVector(times);
+    batch->push_back(col);
+    EXPECT_OK(table_store.AppendData(1, tablet_id, std::move(batch)));
+  };
+  append_times("", {10, 20});
+  append_times("", {30, 40});
+  // The range covers all of the tablets of the table.
+  append_times("tablet", {5, 15});
+
+  // Tables without rows are left out too.
+  EXPECT_THAT(table_store.GetTableTimeRanges(),
+              ::testing::UnorderedElementsAre(
+                  ::testing::Pair("a", std::pair<int64_t, int64_t>(5, 40))));
+}
+
+TEST_F(TableStoreTest, compact_tables) {
+  auto table_a = std::make_shared<Table>("a", rel1, 128 * 1024, /* min_cold_batch_size */ 1);
+  auto table_b = std::make_shared<Table>("b", rel1, 128 * 1024, /* min_cold_batch_size */ 1);
+  auto table_store = TableStore();
+  table_store.AddTable(table_a, "a", 1);
+  table_store.AddTable(table_b, "b", 2);
+  EXPECT_THAT(table_store.GetTables(), ::testing::UnorderedElementsAre(table_a, table_b));
+
+  EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_OK(table_store.AppendData(2, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_OK(table_store.AppendData(2, "", MakeRel1ColumnWrapperBatch()));
+
+  // Without a budget, nothing is compacted.
+  EXPECT_OK(CompactTables(table_store.GetTables(), arrow::default_memory_pool(),
+                          std::chrono::nanoseconds(0)));
+  EXPECT_EQ(0, table_a->GetTableStats().compacted_batches);
+  EXPECT_EQ(0, table_b->GetTableStats().compacted_batches);
+
+  EXPECT_OK(CompactTables(table_store.GetTables(), arrow::default_memory_pool(),
+                          std::chrono::seconds(10)));
+  EXPECT_EQ(1, table_a->GetTableStats().compacted_batches);
+  EXPECT_EQ(2, table_b->GetTableStats().compacted_batches);
+  EXPECT_EQ(0, table_a->HotBytes());
+  EXPECT_EQ(0, table_b->HotBytes());
+}
+
 TEST_F(TableStoreTest, get_table_ids) {
   auto table_store = TableStore();
   table_store.AddTable(table1, "a", 1);
@@ -276,6 +341,30 @@ TEST_F(TableStoreTabletsTest, add_tablet_on_append_data) {
   EXPECT_EQ(tablet2->GetTableStats().batches_added, 0);
 }
 
+TEST_F(TableStoreTabletsTest, tabletization_key) {
+  auto table_store = TableStore();
+  uint64_t table_id = 123;
+
+  table_store.AddTable(tablet1_1, "a", table_id);
+  EXPECT_EQ(table_store.GetTabletizationKey("a"), -1);
+  EXPECT_NOT_OK(table_store.SetTabletizationKey("b", 0));
+  EXPECT_NOT_OK(table_store.SetTabletizationKey("a", rel1.NumColumns()));
+  EXPECT_OK(table_store.SetTabletizationKey("a", 1));
+  EXPECT_EQ(table_store.GetTabletizationKey("a"), 1);
+
+  EXPECT_OK(table_store.AppendData(table_id, "789", MakeRel1ColumnWrapperBatch()));
+  EXPECT_OK(table_store.AppendData(table_id, "456", MakeRel1ColumnWrapperBatch()));
+
+  auto tablets = table_store.GetTablets("a");
+  ASSERT_EQ(tablets.size(), 3);
+  EXPECT_EQ(tablets[0].first, "");
+  EXPECT_EQ(tablets[0].second, tablet1_1.get());
+  EXPECT_EQ(tablets[1].first, "456");
+  EXPECT_EQ(tablets[1].second, table_store.GetTable("a", "456"));
+  EXPECT_EQ(tablets[2].first, "789");
+  EXPECT_TRUE(table_store.GetTablets("b").empty());
+}
+
 using TableStoreTabletsDeathTest = TableStoreTabletsTest;
 TEST_F(TableStoreTabletsDeathTest, tablet_test) {
   auto table_store = TableStore();
@@ -210,6 +210,7 @@ TEST(TableTest, bytes_test_w_compaction) {
 
   EXPECT_OK(table.WriteRowBatch(rb1));
   EXPECT_EQ(table.GetTableStats().bytes, rb1_size);
+  EXPECT_EQ(3, table.GetTableStats().num_rows);
 
   EXPECT_OK(table.WriteRowBatch(rb2));
   EXPECT_EQ(table.GetTableStats().bytes, rb1_size + rb2_size);
@@ -219,6 +220,164 @@ TEST(TableTest, bytes_test_w_compaction) {
   EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
 
   EXPECT_EQ(table.GetTableStats().bytes, rb1_size + rb2_size + rb3_size);
+  // The rows are counted the same whether they are hot or cold.
+  EXPECT_EQ(8, table.GetTableStats().num_rows);
+}
+
+TEST(TableTest, zone_maps_skip_cold_batches) {
+  auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::FLOAT64});
+  schema::Relation rel(rd.types(), {"status", "latency"});
+  // Each batch is big enough to be compacted into its own cold batch.
+  int64_t batch_size = 3 * sizeof(int64_t) + 3 * sizeof(double);
+  Table table("test_table", rel, 128 * 1024, batch_size);
+
+  auto write_batch = [&](const std::vector<types::Int64Value>& status,
+                         const std::vector<types::Float64Value>& latency) {
+    schema::RowBatch rb(rd, status.size());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(status, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(latency, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+  };
+  write_batch({200, 201, 404}, {0.5, 1.0, 2.5});
+  write_batch({500, 200, 503}, {10.0, 0.1, 20.0});
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  write_batch({200}, {0.2});
+
+  ColumnPredicate status_ge_500;
+  status_ge_500.col_idx = 0;
+  status_ge_500.op = ColumnPredicate::Op::kGreaterThanEqual;
+  status_ge_500.data_type = types::DataType::INT64;
+  status_ge_500.int_value = 500;
+
+  ColumnPredicate latency_lt_1;
+  latency_lt_1.col_idx = 1;
+  latency_lt_1.op = ColumnPredicate::Op::kLessThan;
+  latency_lt_1.data_type = types::DataType::FLOAT64;
+  latency_lt_1.float_value = 1.0;
+
+  auto first_cold = table.FirstBatch();
+  auto second_cold = table.NextBatch(first_cold);
+  auto hot = table.NextBatch(second_cold);
+  ASSERT_TRUE(hot.IsValid());
+
+  EXPECT_FALSE(table.SliceMayMatch(first_cold, {status_ge_500}));
+  EXPECT_TRUE(table.SliceMayMatch(second_cold, {status_ge_500}));
+  EXPECT_TRUE(table.SliceMayMatch(first_cold, {latency_lt_1}));
+  EXPECT_TRUE(table.SliceMayMatch(second_cold, {status_ge_500, latency_lt_1}));
+  EXPECT_FALSE(table.SliceMayMatch(first_cold, {latency_lt_1, status_ge_500}));
+  // Hot batches don't have zone maps, so they can never be skipped.
+  EXPECT_TRUE(table.SliceMayMatch(hot, {status_ge_500}));
+
+  // A predicate typed differently than its column is never used to skip.
+  ColumnPredicate mistyped = status_ge_500;
+  mistyped.data_type = types::DataType::FLOAT64;
+  mistyped.float_value = 500;
+  EXPECT_TRUE(table.SliceMayMatch(first_cold, {mistyped}));
+}
+
+TEST(TableTest, dictionary_encoded_cold_strings) {
+  FLAGS_table_store_dictionary_encode_strings = true;
+  auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING});
+  schema::Relation rel(rd.types(), {"status", "req_path"});
+
+  std::vector<types::Int64Value> status = {200, 200, 404, 200, 500, 200};
+  std::vector<types::StringValue> paths = {"/healthz", "/api/v1/users", "/healthz",
+                                           "/healthz", "/api/v1/users", "/healthz"};
+  int64_t raw_bytes = 6 * sizeof(int64_t) + 4 * 8 + 2 * 13;
+  Table table("test_table", rel, 128 * 1024, raw_bytes);
+
+  schema::RowBatch rb(rd, status.size());
+  EXPECT_OK(rb.AddColumn(types::ToArrow(status, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(paths, arrow::default_memory_pool())));
+  EXPECT_OK(table.WriteRowBatch(rb));
+  EXPECT_EQ(raw_bytes, table.GetTableStats().bytes);
+
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  // Two distinct values (8 + 13 bytes) plus a 4 byte index per row.
+  int64_t encoded_bytes = 6 * sizeof(int64_t) + 8 + 13 + 6 * sizeof(int32_t);
+  EXPECT_EQ(encoded_bytes, table.GetTableStats().cold_bytes);
+  EXPECT_EQ(encoded_bytes, table.GetTableStats().bytes);
+  EXPECT_EQ(raw_bytes, table.GetTableStats().cold_uncompressed_bytes);
+
+  // Reads decode back into plain strings, including for slices that start mid batch.
+  auto slice = table.FirstBatch();
+  ASSERT_TRUE(slice.IsValid());
+  auto rb_or_s = table.GetRowBatchSlice(slice, {1}, arrow::default_memory_pool());
+  ASSERT_OK(rb_or_s);
+  auto out_rb = rb_or_s.ConsumeValueOrDie();
+  EXPECT_TRUE(out_rb->ColumnAt(0)->Equals(types::ToArrow(paths, arrow::default_memory_pool())));
+
+  auto tail_slice = BatchSlice::Cold(0, 4, 5, /*generation*/ -1, 4, 5);
+  rb_or_s = table.GetRowBatchSlice(tail_slice, {1}, arrow::default_memory_pool());
+  ASSERT_OK(rb_or_s);
+  std::vector<types::StringValue> tail = {"/api/v1/users", "/healthz"};
+  EXPECT_TRUE(rb_or_s.ConsumeValueOrDie()->ColumnAt(0)->Equals(
+      types::ToArrow(tail, arrow::default_memory_pool())));
+
+  // Expiring the batch releases exactly the encoded bytes.
+  schema::RowBatch big_rb(rd, 1);
+  EXPECT_OK(big_rb.AddColumn(types::ToArrow(std::vector<types::Int64Value>{1},
+                                            arrow::default_memory_pool())));
+  EXPECT_OK(big_rb.AddColumn(types::ToArrow(
+      std::vector<types::StringValue>{std::string(128 * 1024 - 9, 'a')},
+      arrow::default_memory_pool())));
+  EXPECT_OK(table.WriteRowBatch(big_rb));
+  EXPECT_EQ(0, table.GetTableStats().cold_bytes);
+  FLAGS_table_store_dictionary_encode_strings = false;
+}
+
+TEST(TableTest, delta_encoded_cold_ints) {
+  FLAGS_table_store_delta_encode_ints = true;
+  auto rd = schema::RowDescriptor(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::TIME64NS});
+  schema::Relation rel(rd.types(), {"time_", "bytes_sent", "latency"});
+
+  int64_t num_rows = 1000;
+  std::vector<types::Time64NSValue> times;
+  std::vector<types::Int64Value> counter;
+  std::vector<types::Time64NSValue> latency;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    times.push_back(1000000 + i * 10);
+    counter.push_back(i * i);
+    latency.push_back((i * 7919) % 5000 - 2500);
+  }
+  int64_t raw_bytes = 3 * num_rows * sizeof(int64_t);
+  Table table("test_table", rel, 128 * 1024, raw_bytes);
+
+  schema::RowBatch rb(rd, num_rows);
+  EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(counter, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(latency, arrow::default_memory_pool())));
+  EXPECT_OK(table.WriteRowBatch(rb));
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(raw_bytes, stats.cold_uncompressed_bytes);
+  EXPECT_LT(stats.cold_bytes, raw_bytes);
+  EXPECT_EQ(stats.cold_bytes, stats.bytes);
+
+  // Reads of the whole batch and of a slice across block boundaries decode the original values.
+  auto slice = table.FirstBatch();
+  auto rb_or_s = table.GetRowBatchSlice(slice, {0, 1, 2}, arrow::default_memory_pool());
+  ASSERT_OK(rb_or_s);
+  auto out_rb = rb_or_s.ConsumeValueOrDie();
+  EXPECT_TRUE(out_rb->ColumnAt(0)->Equals(types::ToArrow(times, arrow::default_memory_pool())));
+  EXPECT_TRUE(out_rb->ColumnAt(1)->Equals(types::ToArrow(counter, arrow::default_memory_pool())));
+  EXPECT_TRUE(out_rb->ColumnAt(2)->Equals(types::ToArrow(latency, arrow::default_memory_pool())));
+
+  auto mid_slice = BatchSlice::Cold(0, 100, 299, /*generation*/ -1, 100, 299);
+  rb_or_s = table.GetRowBatchSlice(mid_slice, {1}, arrow::default_memory_pool());
+  ASSERT_OK(rb_or_s);
+  std::vector<types::Int64Value> mid_counter(counter.begin() + 100, counter.begin() + 300);
+  EXPECT_TRUE(rb_or_s.ConsumeValueOrDie()->ColumnAt(0)->Equals(
+      types::ToArrow(mid_counter, arrow::default_memory_pool())));
+
+  // The time column isn't encoded, so time lookups still work.
+  auto time_slice_or_s = table.FindBatchSliceGreaterThanOrEqual(1000000 + 10 * 500,
+                                                                arrow::default_memory_pool());
+  ASSERT_OK(time_slice_or_s);
+  EXPECT_EQ(500, time_slice_or_s.ConsumeValueOrDie().uniq_row_start_idx);
+  FLAGS_table_store_delta_encode_ints = false;
 }
 
 TEST(TableTest, expiry_test) {
@@ -389,6 +548,72 @@ TEST(TableTest, expiry_test_w_compaction) {
   EXPECT_EQ(table.GetTableStats().bytes, rb5_size);
 }
 
+TEST(TableTest, spills_expired_cold_batches) {
+  px::testing::TempDir spill_dir;
+  FLAGS_table_store_spill_dir = spill_dir.path().string();
+  auto rd = schema::RowDescriptor({types::DataType::TIME64NS, types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"time_", "val"});
+  // Each batch of 4 rows is compacted into a cold batch of its own, and the table holds 2 of them.
+  Table table("test_table", rel, 128, 64);
+
+  for (int64_t batch = 0; batch < 3; ++batch) {
+    std::vector<types::Time64NSValue> times;
+    std::vector<types::Int64Value> vals;
+    for (int64_t i = 1; i <= 4; ++i) {
+      times.push_back(batch * 4 + i);
+      vals.push_back(10 * (batch * 4 + i));
+    }
+    schema::RowBatch rb(rd, 4);
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(vals, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+    EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  }
+
+  // The first batch was spilled rather than dropped.
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(128, stats.bytes);
+  EXPECT_GT(stats.spilled_bytes, 0);
+  EXPECT_EQ(12, stats.num_rows);
+  EXPECT_EQ(3, stats.num_batches);
+
+  std::vector<int64_t> times;
+  std::vector<int64_t> vals;
+  for (auto slice = table.FirstBatch(); slice.IsValid(); slice = table.NextBatch(slice)) {
+    auto rb_or_s = table.GetRowBatchSlice(slice, {0, 1}, arrow::default_memory_pool());
+    ASSERT_OK(rb_or_s);
+    auto rb = rb_or_s.ConsumeValueOrDie();
+    for (int64_t i = 0; i < rb->num_rows(); ++i) {
+      times.push_back(types::GetValueFromArrowArray<types::DataType::TIME64NS>(
+          rb->ColumnAt(0).get(), i));
+      vals.push_back(
+          types::GetValueFromArrowArray<types::DataType::INT64>(rb->ColumnAt(1).get(), i));
+    }
+  }
+  EXPECT_THAT(times, ::testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12));
+  EXPECT_EQ(120, vals.back());
+  EXPECT_EQ(10, vals.front());
+
+  // Time lookups cover the spilled batches as well.
+  auto slice_or_s = table.FindBatchSliceGreaterThanOrEqual(2, arrow::default_memory_pool());
+  ASSERT_OK(slice_or_s);
+  auto slice = slice_or_s.ConsumeValueOrDie();
+  EXPECT_EQ(1, slice.uniq_row_start_idx);
+  EXPECT_EQ(3, slice.uniq_row_end_idx);
+  auto stop_or_s = table.FindStopPositionForTime(3, arrow::default_memory_pool());
+  ASSERT_OK(stop_or_s);
+  EXPECT_EQ(3, stop_or_s.ConsumeValueOrDie());
+
+  // Zone maps of spilled batches still skip them.
+  ColumnPredicate predicate;
+  predicate.col_idx = 1;
+  predicate.op = ColumnPredicate::Op::kGreaterThan;
+  predicate.data_type = types::DataType::INT64;
+  predicate.int_value = 100;
+  EXPECT_FALSE(table.SliceMayMatch(table.FirstBatch(), {predicate}));
+  FLAGS_table_store_spill_dir = "";
+}
+
 TEST(TableTest, batch_size_too_big) {
   auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING});
   schema::Relation rel(rd.types(), {"col1", "col2"});
@@ -476,6 +701,29 @@ TEST(TableTest, hot_batches_test) {
   EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, hot_reads_share_arrow_cache) {
+  schema::Relation rel({types::DataType::INT64}, {"col1"});
+  Table table("test_table", rel, 128 * 1024, 8);
+
+  std::vector<types::Int64Value> col1_in = {1, 2, 3};
+  auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col1_in, arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper)));
+
+  // Readers convert hot columns outside of the table's locks, and share the first conversion.
+  auto slice = table.FirstBatch();
+  ASSERT_OK_AND_ASSIGN(auto rb1, table.GetRowBatchSlice(slice, {0}, arrow::default_memory_pool()));
+  ASSERT_OK_AND_ASSIGN(auto rb2, table.GetRowBatchSlice(slice, {0}, arrow::default_memory_pool()));
+  EXPECT_EQ(rb1->ColumnAt(0)->data()->buffers[1], rb2->ColumnAt(0)->data()->buffers[1]);
+
+  // Data read before compaction stays valid after it.
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  EXPECT_TRUE(rb1->ColumnAt(0)->Equals(types::ToArrow(col1_in, arrow::default_memory_pool())));
+  ASSERT_OK_AND_ASSIGN(auto rb3, table.GetRowBatchSlice(slice, {0}, arrow::default_memory_pool()));
+  EXPECT_TRUE(rb3->ColumnAt(0)->Equals(rb1->ColumnAt(0)));
+}
+
 TEST(TableTest, hot_batches_w_compaction_test) {
   schema::Relation rel({types::DataType::BOOLEAN, types::DataType::INT64}, {"col1", "col2"});
 
@@ -713,6 +961,49 @@ TEST(TableTest, find_batch_slice_greater_or_eq_w_compaction) {
   EXPECT_EQ(-1, batch_slice.uniq_row_end_idx);
 }
 
+TEST(TableTest, find_times_after_expiry) {
+  auto rd = schema::RowDescriptor({types::DataType::TIME64NS});
+  schema::Relation rel(rd.types(), {"time_"});
+  // Each batch of 2 rows is compacted into a cold batch of its own, and the table holds 3 of them.
+  Table table("test_table", rel, 48, 16);
+  EXPECT_EQ(-1, table.GetTableStats().min_time);
+  EXPECT_EQ(-1, table.GetTableStats().max_time);
+
+  auto write_batch = [&](int64_t first_time) {
+    std::vector<types::Time64NSValue> times = {first_time, first_time + 1};
+    schema::RowBatch rb(rd, 2);
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+  };
+  for (int64_t time = 0; time < 6; time += 2) {
+    write_batch(time);
+  }
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  // Expires the first two cold batches, leaving rows 4 and 5 cold and rows 6 to 9 hot.
+  write_batch(6);
+  write_batch(8);
+
+  // Times of expired rows resolve to the first row the table still holds.
+  auto slice_or_s = table.FindBatchSliceGreaterThanOrEqual(1, arrow::default_memory_pool());
+  ASSERT_OK(slice_or_s);
+  auto slice = slice_or_s.ConsumeValueOrDie();
+  EXPECT_EQ(4, slice.uniq_row_start_idx);
+  EXPECT_EQ(5, slice.uniq_row_end_idx);
+  slice_or_s = table.FindBatchSliceGreaterThanOrEqual(7, arrow::default_memory_pool());
+  ASSERT_OK(slice_or_s);
+  slice = slice_or_s.ConsumeValueOrDie();
+  EXPECT_EQ(7, slice.uniq_row_start_idx);
+  EXPECT_EQ(7, slice.uniq_row_end_idx);
+
+  EXPECT_OK_AND_EQ(table.FindStopPositionForTime(3, arrow::default_memory_pool()), 4);
+  EXPECT_OK_AND_EQ(table.FindStopPositionForTime(5, arrow::default_memory_pool()), 6);
+  EXPECT_OK_AND_EQ(table.FindStopPositionForTime(100, arrow::default_memory_pool()), 10);
+
+  // The time range only covers the rows held.
+  EXPECT_EQ(4, table.GetTableStats().min_time);
+  EXPECT_EQ(9, table.GetTableStats().max_time);
+}
+
 TEST(TableTest, ToProto) {
   auto table = TestTable();
   table_store::schemapb::Table table_proto;
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/time_index.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace px {
+namespace table_store {
+
+TimeIndex::TimeIndex() : directory_(std::make_shared<const Directory>()) {}
+
+void TimeIndex::Append(const Entry& entry) {
+  absl::MutexLock lock(&write_lock_);
+  const int64_t end = end_.load(std::memory_order_relaxed);
+  std::shared_ptr<const Directory> directory = std::atomic_load(&directory_);
+
+  int64_t chunk = end / kChunkSize;
+  if (chunk - directory->first_chunk == static_cast<int64_t>(directory->chunks.size())) {
+    // The last chunk is full. The new directory shares the chunks of the old one, so readers of
+    // either see the same entries.
+    auto next = std::make_shared<Directory>(*directory);
+    next->chunks.push_back(std::make_shared<Chunk>());
+    directory = std::move(next);
+    std::atomic_store(&directory_, directory);
+  }
+  // Readers never look at entries at or after end_, so the entry can be written in place.
+  directory->chunks.back()->entries[end % kChunkSize] = entry;
+  end_.store(end + 1, std::memory_order_release);
+}
+
+void TimeIndex::ExpireBefore(int64_t row_id) {
+  absl::MutexLock lock(&write_lock_);
+  const int64_t end = end_.load(std::memory_order_relaxed);
+  std::shared_ptr<const Directory> directory = std::atomic_load(&directory_);
+  Snapshot snapshot{directory, begin_.load(std::memory_order_relaxed), end};
+
+  int64_t begin =
+      PartitionPoint(snapshot, [row_id](const Entry& entry) { return entry.last_row_id < row_id; });
+  if (begin == snapshot.begin) {
+    return;
+  }
+  // begin_ is published before the chunks are dropped, so readers that load it after the
+  // directory never look at a dropped chunk.
+  begin_.store(begin, std::memory_order_release);
+
+  int64_t first_chunk = begin / kChunkSize;
+  if (first_chunk == directory->first_chunk) {
+    return;
+  }
+  auto next = std::make_shared<Directory>();
+  next->first_chunk = first_chunk;
+  next->chunks.assign(directory->chunks.begin() + (first_chunk - directory->first_chunk),
+                      directory->chunks.end());
+  std::atomic_store(&directory_, std::shared_ptr<const Directory>(std::move(next)));
+}
+
+TimeIndex::Snapshot TimeIndex::Load() const {
+  Snapshot snapshot;
+  // The entries before end_ were written before the directory that holds them was published, and
+  // the chunks before begin_ are only dropped after begin_ is published, so loading them in this
+  // order gives a directory holding all of [begin, end).
+  snapshot.end = end_.load(std::memory_order_acquire);
+  snapshot.directory = std::atomic_load(&directory_);
+  snapshot.begin = begin_.load(std::memory_order_acquire);
+  snapshot.begin = std::max(snapshot.begin, snapshot.directory->first_chunk * kChunkSize);
+  snapshot.end = std::max(snapshot.begin, snapshot.end);
+  return snapshot;
+}
+
+template <typename TPred>
+int64_t TimeIndex::PartitionPoint(const Snapshot& snapshot, TPred pred) {
+  if (snapshot.begin == snapshot.end) {
+    return snapshot.end;
+  }
+  // Find the chunk holding the partition point by checking the last entry of each chunk, so that
+  // the search only touches one entry per chunk until it gets down to a single chunk.
+  int64_t lo = snapshot.begin / kChunkSize;
+  int64_t hi = (snapshot.end - 1) / kChunkSize;
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (pred(snapshot.At(mid * kChunkSize + kChunkSize - 1))) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  int64_t first = std::max(snapshot.begin, lo * kChunkSize);
+  int64_t last = std::min(snapshot.end, lo * kChunkSize + kChunkSize);
+  while (first < last) {
+    int64_t mid = first + (last - first) / 2;
+    if (pred(snapshot.At(mid))) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+  return first;
+}
+
+std::optional<TimeIndex::Entry> TimeIndex::FindFirstEndingAtOrAfter(int64_t time) const {
+  Snapshot snapshot = Load();
+  int64_t index =
+      PartitionPoint(snapshot, [time](const Entry& entry) { return entry.last_time < time; });
+  if (index == snapshot.end) {
+    return std::nullopt;
+  }
+  return snapshot.At(index);
+}
+
+std::optional<TimeIndex::Entry> TimeIndex::FindLastStartingAtOrBefore(int64_t time) const {
+  Snapshot snapshot = Load();
+  int64_t index =
+      PartitionPoint(snapshot, [time](const Entry& entry) { return entry.first_time <= time; });
+  if (index == snapshot.begin) {
+    return std::nullopt;
+  }
+  return snapshot.At(index - 1);
+}
+
+std::optional<TimeIndex::Entry> TimeIndex::First() const {
+  Snapshot snapshot = Load();
+  if (snapshot.begin == snapshot.end) {
+    return std::nullopt;
+  }
+  return snapshot.At(snapshot.begin);
+}
+
+std::optional<TimeIndex::Entry> TimeIndex::Last() const {
+  Snapshot snapshot = Load();
+  if (snapshot.begin == snapshot.end) {
+    return std::nullopt;
+  }
+  return snapshot.At(snapshot.end - 1);
+}
+
+int64_t TimeIndex::size() const {
+  Snapshot snapshot = Load();
+  return snapshot.end - snapshot.begin;
+}
+
+}  // namespace table_store
+}  // namespace px
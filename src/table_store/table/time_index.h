@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * TimeIndex maps time to rows for all of the batches of a table, whichever tier they're in. It has
+ * an entry with the first and last times and row IDs of each batch written to the table. The
+ * entries stay the same when batches are compacted or spilled, because the row IDs do.
+ *
+ * Entries are appended to fixed size chunks, which are never moved. Writers (Append and
+ * ExpireBefore) are serialized by a mutex, and publish new entries and chunks atomically. Readers
+ * don't take any lock: they snapshot the chunk directory, which keeps the chunks they search
+ * alive even if the entries expire in the meantime (RCU style). Searches first bisect the chunks,
+ * then the 4KB of entries in one chunk.
+ */
+class TimeIndex : public NotCopyable {
+ public:
+  struct Entry {
+    int64_t first_time;
+    int64_t last_time;
+    int64_t first_row_id;
+    int64_t last_row_id;
+  };
+
+  static constexpr int64_t kChunkSize = 128;
+
+  TimeIndex();
+
+  /**
+   * Appends the entry of a batch written after all of the others.
+   */
+  void Append(const Entry& entry);
+
+  /**
+   * Drops the entries of the batches whose rows all precede the given row ID.
+   */
+  void ExpireBefore(int64_t row_id);
+
+  /**
+   * @return the entry of the first batch whose last time is greater than or equal to the time.
+   */
+  std::optional<Entry> FindFirstEndingAtOrAfter(int64_t time) const;
+
+  /**
+   * @return the entry of the last batch whose first time is less than or equal to the time.
+   */
+  std::optional<Entry> FindLastStartingAtOrBefore(int64_t time) const;
+
+  /**
+   * @return the entries of the first and last batches held, if there are any.
+   */
+  std::optional<Entry> First() const;
+  std::optional<Entry> Last() const;
+
+  int64_t size() const;
+
+ private:
+  struct Chunk {
+    std::array<Entry, kChunkSize> entries;
+  };
+  struct Directory {
+    // The number of the first chunk, counting from the first chunk ever appended.
+    int64_t first_chunk = 0;
+    std::vector<std::shared_ptr<Chunk>> chunks;
+  };
+  // A consistent view of the entries [begin, end) and of the chunks holding them.
+  struct Snapshot {
+    std::shared_ptr<const Directory> directory;
+    int64_t begin;
+    int64_t end;
+
+    const Entry& At(int64_t index) const {
+      return directory->chunks[index / kChunkSize - directory->first_chunk]
+          ->entries[index % kChunkSize];
+    }
+  };
+
+  Snapshot Load() const;
+
+  // Returns the index of the first entry in the snapshot for which pred is false, given that pred
+  // is true for a prefix of the entries.
+  template <typename TPred>
+  static int64_t PartitionPoint(const Snapshot& snapshot, TPred pred);
+
+  absl::Mutex write_lock_;
+  // Only replaced by writers, readers load it with std::atomic_load.
+  std::shared_ptr<const Directory> directory_;
+  // The absolute indices of the entries held, entries before begin_ are expired.
+  std::atomic<int64_t> begin_ = 0;
+  std::atomic<int64_t> end_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
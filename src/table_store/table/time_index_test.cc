@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "src/table_store/table/time_index.h"
+
+namespace px {
+namespace table_store {
+
+using Entry = TimeIndex::Entry;
+
+// Appends the entries of batches of 10 rows, each covering 10 units of time.
+void AppendBatches(TimeIndex* index, int64_t first_batch, int64_t num_batches) {
+  for (int64_t batch = first_batch; batch < first_batch + num_batches; ++batch) {
+    index->Append(Entry{batch * 10, batch * 10 + 9, batch * 10, batch * 10 + 9});
+  }
+}
+
+TEST(TimeIndexTest, finds_batches_by_time) {
+  TimeIndex index;
+  EXPECT_FALSE(index.FindFirstEndingAtOrAfter(0).has_value());
+  EXPECT_FALSE(index.FindLastStartingAtOrBefore(0).has_value());
+
+  // Span several chunks.
+  int64_t num_batches = 3 * TimeIndex::kChunkSize + 5;
+  AppendBatches(&index, 0, num_batches);
+  EXPECT_EQ(num_batches, index.size());
+
+  for (int64_t time : {int64_t{0}, int64_t{9}, int64_t{10}, int64_t{1285}, num_batches * 10 - 1}) {
+    auto first = index.FindFirstEndingAtOrAfter(time);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(time / 10 * 10, first->first_row_id);
+    auto last = index.FindLastStartingAtOrBefore(time);
+    ASSERT_TRUE(last.has_value());
+    EXPECT_EQ(time / 10 * 10, last->first_row_id);
+  }
+  EXPECT_FALSE(index.FindFirstEndingAtOrAfter(num_batches * 10).has_value());
+  EXPECT_FALSE(index.FindLastStartingAtOrBefore(-1).has_value());
+  EXPECT_EQ(0, index.FindFirstEndingAtOrAfter(-1)->first_row_id);
+  EXPECT_EQ((num_batches - 1) * 10, index.FindLastStartingAtOrBefore(1 << 30)->first_row_id);
+}
+
+TEST(TimeIndexTest, expires_batches) {
+  TimeIndex index;
+  int64_t num_batches = 2 * TimeIndex::kChunkSize + 5;
+  AppendBatches(&index, 0, num_batches);
+
+  // Rows of a batch that are only partially expired keep the whole batch.
+  index.ExpireBefore((TimeIndex::kChunkSize + 3) * 10 + 5);
+  EXPECT_EQ(num_batches - TimeIndex::kChunkSize - 3, index.size());
+  EXPECT_EQ((TimeIndex::kChunkSize + 3) * 10, index.First()->first_time);
+  EXPECT_EQ(num_batches * 10 - 1, index.Last()->last_time);
+  EXPECT_EQ((TimeIndex::kChunkSize + 3) * 10, index.FindFirstEndingAtOrAfter(0)->first_row_id);
+  EXPECT_FALSE(index.FindLastStartingAtOrBefore((TimeIndex::kChunkSize + 3) * 10 - 1).has_value());
+
+  // Expiring everything and appending again reuses the index.
+  index.ExpireBefore(num_batches * 10);
+  EXPECT_EQ(0, index.size());
+  EXPECT_FALSE(index.FindFirstEndingAtOrAfter(0).has_value());
+  EXPECT_FALSE(index.First().has_value());
+  EXPECT_FALSE(index.Last().has_value());
+  AppendBatches(&index, num_batches, 1);
+  EXPECT_EQ(1, index.size());
+  EXPECT_EQ(num_batches * 10, index.FindFirstEndingAtOrAfter(0)->first_row_id);
+}
+
+TEST(TimeIndexTest, searches_while_writing) {
+  TimeIndex index;
+  constexpr int64_t kNumBatches = 20 * TimeIndex::kChunkSize;
+  std::atomic<bool> done = false;
+
+  std::thread writer([&]() {
+    for (int64_t batch = 0; batch < kNumBatches; ++batch) {
+      AppendBatches(&index, batch, 1);
+      if (batch % 100 == 0) {
+        index.ExpireBefore((batch - 200) * 10);
+      }
+    }
+    done = true;
+  });
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        auto first = index.FindFirstEndingAtOrAfter(0);
+        if (!first.has_value()) {
+          continue;
+        }
+        // Entries are never torn, and later ones are found after the earlier ones, even if
+        // those expired in the meantime.
+        EXPECT_EQ(first->first_time, first->first_row_id);
+        EXPECT_EQ(first->last_time, first->last_row_id);
+        auto next = index.FindFirstEndingAtOrAfter(first->last_time + 1);
+        if (next.has_value()) {
+          EXPECT_GE(next->first_row_id, first->first_row_id + 10);
+          EXPECT_EQ(0, next->first_row_id % 10);
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ((kNumBatches - 1) * 10,
+            index.FindLastStartingAtOrBefore(kNumBatches * 10)->first_row_id);
+}
+
+}  // namespace table_store
+}  // namespace px
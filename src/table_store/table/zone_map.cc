@@ -0,0 +1,199 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/zone_map.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include <absl/strings/substitute.h>
+#include "src/common/base/base.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+template <types::DataType TDataType, typename TNative>
+void ComputeMinMax(const arrow::Array* arr, TNative* min, TNative* max) {
+  auto typed_arr =
+      static_cast<const typename types::DataTypeTraits<TDataType>::arrow_array_type*>(arr);
+  *min = typed_arr->Value(0);
+  *max = typed_arr->Value(0);
+  for (int64_t i = 1; i < typed_arr->length(); ++i) {
+    TNative val = typed_arr->Value(i);
+    *min = std::min(*min, val);
+    *max = std::max(*max, val);
+  }
+}
+
+template <typename TNative>
+bool RangeMayMatch(ColumnPredicate::Op op, TNative min, TNative max, TNative value) {
+  switch (op) {
+    case ColumnPredicate::Op::kEqual:
+      return min <= value && value <= max;
+    case ColumnPredicate::Op::kNotEqual:
+      return !(min == value && max == value);
+    case ColumnPredicate::Op::kLessThan:
+      return min < value;
+    case ColumnPredicate::Op::kLessThanEqual:
+      return min <= value;
+    case ColumnPredicate::Op::kGreaterThan:
+      return max > value;
+    case ColumnPredicate::Op::kGreaterThanEqual:
+      return max >= value;
+  }
+  return true;
+}
+
+template <typename TNative>
+bool Compare(ColumnPredicate::Op op, const TNative& lhs, const TNative& rhs) {
+  switch (op) {
+    case ColumnPredicate::Op::kEqual:
+      return lhs == rhs;
+    case ColumnPredicate::Op::kNotEqual:
+      return lhs != rhs;
+    case ColumnPredicate::Op::kLessThan:
+      return lhs < rhs;
+    case ColumnPredicate::Op::kLessThanEqual:
+      return lhs <= rhs;
+    case ColumnPredicate::Op::kGreaterThan:
+      return lhs > rhs;
+    case ColumnPredicate::Op::kGreaterThanEqual:
+      return lhs >= rhs;
+  }
+  return true;
+}
+
+// Compares the values of the typed array, converted to TNative, against the predicate's value.
+template <types::DataType TDataType, typename TNative>
+void FilterTypedRows(const arrow::Array* arr, ColumnPredicate::Op op, const TNative& value,
+                     std::vector<int64_t>* rows) {
+  auto typed_arr =
+      static_cast<const typename types::DataTypeTraits<TDataType>::arrow_array_type*>(arr);
+  auto matches = [&](int64_t idx) {
+    if constexpr (TDataType == types::DataType::STRING) {
+      auto view = typed_arr->GetView(idx);
+      return Compare<std::string_view>(op, std::string_view(view.data(), view.size()), value);
+    } else {
+      return Compare<TNative>(op, typed_arr->Value(idx), value);
+    }
+  };
+  rows->erase(std::remove_if(rows->begin(), rows->end(), [&](int64_t idx) { return !matches(idx); }),
+              rows->end());
+}
+
+bool IsIntegral(types::DataType data_type) {
+  return data_type == types::DataType::BOOLEAN || data_type == types::DataType::INT64 ||
+         data_type == types::DataType::TIME64NS;
+}
+
+}  // namespace
+
+ColumnZoneMap ColumnZoneMap::Compute(types::DataType data_type, const arrow::Array* arr) {
+  ColumnZoneMap zone_map;
+  zone_map.data_type = data_type;
+  zone_map.null_count = arr->null_count();
+  // Nulls aren't expected in the table store, so only summarize null-free columns.
+  if (arr->length() == 0 || zone_map.null_count > 0) {
+    return zone_map;
+  }
+  switch (data_type) {
+    case types::DataType::BOOLEAN: {
+      bool min, max;
+      ComputeMinMax<types::DataType::BOOLEAN>(arr, &min, &max);
+      zone_map.int_min = min;
+      zone_map.int_max = max;
+      break;
+    }
+    case types::DataType::INT64:
+      ComputeMinMax<types::DataType::INT64>(arr, &zone_map.int_min, &zone_map.int_max);
+      break;
+    case types::DataType::TIME64NS:
+      ComputeMinMax<types::DataType::TIME64NS>(arr, &zone_map.int_min, &zone_map.int_max);
+      break;
+    case types::DataType::FLOAT64:
+      ComputeMinMax<types::DataType::FLOAT64>(arr, &zone_map.float_min, &zone_map.float_max);
+      break;
+    default:
+      return zone_map;
+  }
+  zone_map.has_min_max = true;
+  return zone_map;
+}
+
+bool ColumnPredicate::MayMatch(const ColumnZoneMap& zone_map) const {
+  // Predicates that were typed differently than the column can't be checked against its range.
+  if (!zone_map.has_min_max || zone_map.data_type != data_type) {
+    return true;
+  }
+  if (IsIntegral(data_type)) {
+    return RangeMayMatch(op, zone_map.int_min, zone_map.int_max, int_value);
+  }
+  if (data_type == types::DataType::FLOAT64) {
+    return RangeMayMatch(op, zone_map.float_min, zone_map.float_max, float_value);
+  }
+  return true;
+}
+
+void ColumnPredicate::FilterRows(const arrow::Array* arr, std::vector<int64_t>* rows) const {
+  switch (data_type) {
+    case types::DataType::BOOLEAN:
+      FilterTypedRows<types::DataType::BOOLEAN, int64_t>(arr, op, int_value, rows);
+      break;
+    case types::DataType::INT64:
+      FilterTypedRows<types::DataType::INT64, int64_t>(arr, op, int_value, rows);
+      break;
+    case types::DataType::TIME64NS:
+      FilterTypedRows<types::DataType::TIME64NS, int64_t>(arr, op, int_value, rows);
+      break;
+    case types::DataType::FLOAT64:
+      FilterTypedRows<types::DataType::FLOAT64, double>(arr, op, float_value, rows);
+      break;
+    case types::DataType::UINT128:
+      FilterTypedRows<types::DataType::UINT128, absl::uint128>(arr, op, uint128_value, rows);
+      break;
+    case types::DataType::STRING:
+      FilterTypedRows<types::DataType::STRING, std::string_view>(arr, op, string_value, rows);
+      break;
+    default:
+      LOG(DFATAL) << absl::Substitute("Can't filter rows of type $0",
+                                      types::ToString(data_type));
+  }
+}
+
+std::string ColumnPredicate::DebugString() const {
+  static constexpr const char* kOpNames[] = {"==", "!=", "<", "<=", ">", ">="};
+  switch (data_type) {
+    case types::DataType::FLOAT64:
+      return absl::Substitute("col[$0] $1 $2", col_idx, kOpNames[static_cast<int>(op)],
+                              float_value);
+    case types::DataType::UINT128:
+      return absl::Substitute("col[$0] $1 $2:$3", col_idx, kOpNames[static_cast<int>(op)],
+                              absl::Uint128High64(uint128_value), absl::Uint128Low64(uint128_value));
+    case types::DataType::STRING:
+      return absl::Substitute("col[$0] $1 \"$2\"", col_idx, kOpNames[static_cast<int>(op)],
+                              string_value);
+    default:
+      return absl::Substitute("col[$0] $1 $2", col_idx, kOpNames[static_cast<int>(op)], int_value);
+  }
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <absl/numeric/int128.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * ColumnZoneMap summarizes the values of one column of a cold batch. Min/max are only tracked for
+ * BOOLEAN, INT64, TIME64NS (int_min/int_max) and FLOAT64 (float_min/float_max) columns.
+ */
+struct ColumnZoneMap {
+  types::DataType data_type = types::DataType::DATA_TYPE_UNKNOWN;
+  bool has_min_max = false;
+  int64_t null_count = 0;
+  int64_t int_min = 0;
+  int64_t int_max = 0;
+  double float_min = 0;
+  double float_max = 0;
+
+  static ColumnZoneMap Compute(types::DataType data_type, const arrow::Array* arr);
+};
+
+/**
+ * ColumnPredicate is a comparison of a table column against a constant, i.e. `col <op> value`.
+ * INT64, TIME64NS and BOOLEAN values are stored in int_value, FLOAT64 values in float_value,
+ * UINT128 values in uint128_value and STRING values in string_value. Zone maps only bound the
+ * numeric types, but all of them can be evaluated against the rows of a column.
+ */
+struct ColumnPredicate {
+  enum class Op {
+    kEqual,
+    kNotEqual,
+    kLessThan,
+    kLessThanEqual,
+    kGreaterThan,
+    kGreaterThanEqual,
+  };
+
+  int64_t col_idx = -1;
+  Op op = Op::kEqual;
+  types::DataType data_type = types::DataType::DATA_TYPE_UNKNOWN;
+  int64_t int_value = 0;
+  double float_value = 0;
+  absl::uint128 uint128_value = 0;
+  std::string string_value;
+
+  /**
+   * @return false only if the zone map proves that no value in the column satisfies the predicate.
+   */
+  bool MayMatch(const ColumnZoneMap& zone_map) const;
+
+  /**
+   * Removes the indices of the rows of the column that don't satisfy the predicate from the sorted
+   * rows. The column must have the predicate's data type.
+   */
+  void FilterRows(const arrow::Array* arr, std::vector<int64_t>* rows) const;
+  std::string DebugString() const;
+};
+
+}  // namespace table_store
+}  // namespace px
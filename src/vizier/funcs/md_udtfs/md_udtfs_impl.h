@@ -22,6 +22,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -109,7 +110,7 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
   GetTables() = delete;
   GetTables(std::shared_ptr<MDSStub> stub,
             std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+      : stub_(stub), add_context_authentication_func_(add_context_authentication) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -122,43 +123,37 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
 
   Status Init(FunctionContext*) {
     px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
 
     grpc::ClientContext ctx;
     add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
+    auto s = stub_->GetSchemas(&ctx, req, &resp_);
     if (!s.ok()) {
       return error::Internal("Failed to make RPC call to metadata service");
     }
 
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
-      table_info_.emplace_back(table_name, rel.desc());
-    }
+    relation_map_ = &resp_.schema().relation_map();
+    table_it_ = relation_map_->begin();
     return Status::OK();
   }
 
   bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!table_info_.size()) {
+    if (relation_map_ == nullptr || table_it_ == relation_map_->end()) {
       return false;
     }
-    const auto& r = table_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("table_desc")>(r.table_desc);
+    rw->Append<IndexOf("table_name")>(table_it_->first);
+    rw->Append<IndexOf("table_desc")>(table_it_->second.desc());
 
-    idx_++;
-    return idx_ < static_cast<int>(table_info_.size());
+    ++table_it_;
+    return table_it_ != relation_map_->end();
   }
 
  private:
-  struct TableInfo {
-    TableInfo(const std::string& table_name, const std::string& table_desc)
-        : table_name(table_name), table_desc(table_desc) {}
-    std::string table_name;
-    std::string table_desc;
-  };
+  using RelationMap = google::protobuf::Map<std::string, table_store::schemapb::Relation>;
 
-  int idx_ = 0;
-  std::vector<TableInfo> table_info_;
+  // The records are read from the response as they are written, rather than copied out of it.
+  SchemaResponse resp_;
+  const RelationMap* relation_map_ = nullptr;
+  RelationMap::const_iterator table_it_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
 };
@@ -173,7 +168,7 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
   GetTableSchemas() = delete;
   GetTableSchemas(std::shared_ptr<MDSStub> stub,
                   std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+      : stub_(stub), add_context_authentication_func_(add_context_authentication) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -190,58 +185,53 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
 
   Status Init(FunctionContext*) {
     px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
 
     grpc::ClientContext ctx;
     add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
+    auto s = stub_->GetSchemas(&ctx, req, &resp_);
     if (!s.ok()) {
       return error::Internal("Failed to make RPC call to metadata service");
     }
 
-    // TODO(zasgar): We store the data since it's hard to traverse two maps at once. We should
-    // either do that or perhaps have an interface that allows UDTFs to write multiple records in
-    // a single invocation.
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
-      for (const auto& col : rel.columns()) {
-        relation_info_.emplace_back(table_name, col.column_name(),
-                                    std::string(magic_enum::enum_name(col.column_type())),
-                                    col.column_desc());
-      }
-    }
+    relation_map_ = &resp_.schema().relation_map();
+    table_it_ = relation_map_->begin();
+    SkipTablesWithoutColumns();
     return Status::OK();
   }
 
   bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!relation_info_.size()) {
+    if (relation_map_ == nullptr || table_it_ == relation_map_->end()) {
       return false;
     }
-    const auto& r = relation_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("column_name")>(r.column_name);
-    rw->Append<IndexOf("column_type")>(r.column_type);
-    rw->Append<IndexOf("column_desc")>(r.column_desc);
-
-    idx_++;
-    return idx_ < static_cast<int>(relation_info_.size());
+    const auto& col = table_it_->second.columns(col_idx_);
+    rw->Append<IndexOf("table_name")>(table_it_->first);
+    rw->Append<IndexOf("column_name")>(col.column_name());
+    rw->Append<IndexOf("column_type")>(std::string(magic_enum::enum_name(col.column_type())));
+    rw->Append<IndexOf("column_desc")>(col.column_desc());
+
+    if (++col_idx_ == table_it_->second.columns_size()) {
+      ++table_it_;
+      col_idx_ = 0;
+      SkipTablesWithoutColumns();
+    }
+    return table_it_ != relation_map_->end();
   }
 
  private:
-  struct RelationInfo {
-    RelationInfo(const std::string& table_name, const std::string& column_name,
-                 const std::string& column_type, const std::string& column_desc)
-        : table_name(table_name),
-          column_name(column_name),
-          column_type(column_type),
-          column_desc(column_desc) {}
-    std::string table_name;
-    std::string column_name;
-    std::string column_type;
-    std::string column_desc;
-  };
+  using RelationMap = google::protobuf::Map<std::string, table_store::schemapb::Relation>;
 
-  int idx_ = 0;
-  std::vector<RelationInfo> relation_info_;
+  void SkipTablesWithoutColumns() {
+    while (table_it_ != relation_map_->end() && table_it_->second.columns_size() == 0) {
+      ++table_it_;
+    }
+  }
+
+  // The records are read from the response as they are written, walking the columns of each
+  // table in turn, rather than copied out of it.
+  SchemaResponse resp_;
+  const RelationMap* relation_map_ = nullptr;
+  RelationMap::const_iterator table_it_;
+  int col_idx_ = 0;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
 };
@@ -593,17 +583,23 @@ class GetDebugMDWithPrefix final : public carnot::udf::UDTF<GetDebugMDWithPrefix
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    for (const px::vizier::services::metadata::WithPrefixKeyResponse_KV& kv : resp_->kvs()) {
+  // The keys are output in partitions of kKeysPerPartition, generated in parallel.
+  int64_t NumPartitions(FunctionContext*) const {
+    return (resp_->kvs_size() + kKeysPerPartition - 1) / kKeysPerPartition;
+  }
+
+  void GeneratePartition(FunctionContext*, int64_t partition, RecordWriter* rw) const {
+    int64_t end = std::min<int64_t>(resp_->kvs_size(), (partition + 1) * kKeysPerPartition);
+    for (int64_t i = partition * kKeysPerPartition; i < end; ++i) {
+      const px::vizier::services::metadata::WithPrefixKeyResponse_KV& kv = resp_->kvs(i);
       rw->Append<IndexOf("key")>(kv.key());
       rw->Append<IndexOf("value")>(kv.value());
     }
-
-    // no more records.
-    return false;
   }
 
  private:
+  static constexpr int64_t kKeysPerPartition = 1024;
+
   std::unique_ptr<px::vizier::services::metadata::WithPrefixKeyResponse> resp_;
 
   std::shared_ptr<MDSStub> stub_;
@@ -639,6 +635,8 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
                 "The size of this table in bytes"),
         ColInfo("cold_size", types::DataType::INT64, types::PatternType::GENERAL,
                 "The number of bytes in cold storage"),
+        ColInfo("cold_uncompressed_size", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of bytes cold storage would use without cold encodings"),
         ColInfo("max_table_size", types::DataType::INT64, types::PatternType::GENERAL,
                 "The maximum size of this table"));
   }
@@ -665,6 +663,7 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
     rw->Append<IndexOf("compacted_batches")>(info.compacted_batches);
     rw->Append<IndexOf("size")>(info.bytes);
     rw->Append<IndexOf("cold_size")>(info.cold_bytes);
+    rw->Append<IndexOf("cold_uncompressed_size")>(info.cold_uncompressed_bytes);
     rw->Append<IndexOf("max_table_size")>(info.max_table_size);
 
     ++current_idx_;
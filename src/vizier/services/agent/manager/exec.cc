@@ -27,31 +27,75 @@
 #include "src/common/base/base.h"
 #include "src/common/event/task.h"
 #include "src/common/perf/perf.h"
+#include "src/common/system/thread_placement.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_int64(agent_query_memory_high_watermark_bytes,
+             gflags::Int64FromEnv("PL_AGENT_QUERY_MEMORY_HIGH_WATERMARK_BYTES",
+                                  2048LL * 1024 * 1024),
+             "New queries wait while the running queries hold more memory than this, so that they "
+             "don't run the agent out of memory. 0 admits all queries.");
+DEFINE_int32(agent_max_queued_queries, gflags::Int32FromEnv("PL_AGENT_MAX_QUEUED_QUERIES", 16),
+             "The number of queries that may wait for a run slot or for memory, further queries "
+             "are rejected.");
+DEFINE_string(agent_query_thread_placement,
+              gflags::StringFromEnv("PL_AGENT_QUERY_THREAD_PLACEMENT", ""),
+              "The CPUs and NUMA memory policy of the threads that execute queries, as "
+              "'<cpu list>[:<default|local|bind|interleave|preferred>]', e.g. '4-11:bind'. Empty "
+              "leaves them unplaced.");
+
 namespace px {
 namespace vizier {
 namespace agent {
 
 using ::px::event::AsyncTask;
 
+namespace {
+
+carnot::exec::QueryClass GetQueryClass(const messages::ExecuteQueryRequest& req) {
+  carnot::exec::QueryClass query_class;
+  switch (req.priority()) {
+    case messages::ExecuteQueryRequest::QUERY_PRIORITY_HIGH:
+      query_class.priority = carnot::exec::QueryPriority::kHigh;
+      break;
+    case messages::ExecuteQueryRequest::QUERY_PRIORITY_LOW:
+      query_class.priority = carnot::exec::QueryPriority::kLow;
+      break;
+    default:
+      query_class.priority = carnot::exec::QueryPriority::kNormal;
+      break;
+  }
+  query_class.user = req.user_id();
+  query_class.script = req.script_name();
+  return query_class;
+}
+
+}  // namespace
+
 class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
  public:
   ExecuteQueryTask(ExecuteQueryMessageHandler* h, carnot::Carnot* carnot,
-                   std::unique_ptr<messages::VizierMessage> msg)
+                   std::unique_ptr<messages::VizierMessage> msg, std::shared_ptr<Ticket> ticket)
       : parent_(h),
         carnot_(carnot),
         msg_(std::move(msg)),
+        ticket_(std::move(ticket)),
         req_(msg_->execute_query_request()),
         query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()) {}
 
   sole::uuid query_id() { return query_id_; }
 
   void Work() override {
+    // The queries share the threadpool with other work, so each query places its thread again.
+    static const auto* placer =
+        new system::ThreadPlacer("agent_query", FLAGS_agent_query_thread_placement);
+    placer->PlaceCurrentThread();
     LOG(INFO) << absl::Substitute("Executing query: id=$0", query_id_.str());
     VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
 
-    auto s = carnot_->ExecutePlan(req_.plan(), query_id_, req_.analyze());
+    auto s = carnot_->ExecutePlan(req_.plan(), query_id_, req_.analyze(), ticket_);
+    // Hand the slot to the next query right away, rather than once the task is deleted.
+    ticket_->Finish();
     if (!s.ok()) {
       if (s.code() == px::statuspb::Code::CANCELLED) {
         LOG(WARNING) << absl::Substitute("Cancelled query: $0", query_id_.str());
@@ -71,6 +115,7 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
   carnot::Carnot* carnot_;
 
   std::unique_ptr<messages::VizierMessage> msg_;
+  std::shared_ptr<Ticket> ticket_;
   const messages::ExecuteQueryRequest& req_;
   sole::uuid query_id_;
 };
@@ -79,11 +124,49 @@ ExecuteQueryMessageHandler::ExecuteQueryMessageHandler(px::event::Dispatcher* di
                                                        Info* agent_info,
                                                        Manager::VizierNATSConnector* nats_conn,
                                                        carnot::Carnot* carnot)
-    : MessageHandler(dispatcher, agent_info, nats_conn), carnot_(carnot) {}
+    : MessageHandler(dispatcher, agent_info, nats_conn), carnot_(carnot) {
+  // Slots are granted from the threads of the running queries, the queries are started from the
+  // dispatcher thread.
+  carnot_->query_scheduler()->set_start_callback(
+      [this]() { this->dispatcher()->Post([this]() { StartQueuedQueries(); }); });
+}
+
+ExecuteQueryMessageHandler::~ExecuteQueryMessageHandler() {
+  carnot_->query_scheduler()->set_start_callback(nullptr);
+}
 
 Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
+  auto query_id = ParseUUID(msg->execute_query_request().query_id()).ConsumeValueOr(sole::uuid());
+  if (static_cast<int64_t>(queued_queries_.size()) >= FLAGS_agent_max_queued_queries) {
+    LOG(ERROR) << absl::Substitute(
+        "Rejecting query $0, $1 queries are running, holding $2 bytes of memory, and $3 queries "
+        "are already waiting.",
+        query_id.str(), running_queries_.size(), carnot_->QueryMemoryBytes(),
+        queued_queries_.size());
+    return Status::OK();
+  }
+  auto ticket = carnot_->query_scheduler()->Register(GetQueryClass(msg->execute_query_request()));
+  const Ticket* key = ticket.get();
+  queued_queries_[key] = QueuedQuery{std::move(ticket), std::move(msg)};
+  StartQueuedQueries();
+  if (queued_queries_.contains(key)) {
+    LOG(INFO) << absl::Substitute(
+        "Queueing query $0, $1 queries are running, holding $2 bytes of memory.", query_id.str(),
+        running_queries_.size(), carnot_->QueryMemoryBytes());
+  }
+  return Status::OK();
+}
+
+bool ExecuteQueryMessageHandler::CanAdmitQuery() const {
+  // A query always runs when there are no others, otherwise it could wait forever.
+  return running_queries_.empty() || FLAGS_agent_query_memory_high_watermark_bytes <= 0 ||
+         carnot_->QueryMemoryBytes() < FLAGS_agent_query_memory_high_watermark_bytes;
+}
+
+void ExecuteQueryMessageHandler::StartQuery(std::unique_ptr<messages::VizierMessage> msg,
+                                            std::shared_ptr<Ticket> ticket) {
   // Create a task and run it on the threadpool.
-  auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg));
+  auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg), std::move(ticket));
 
   auto query_id = task->query_id();
   auto runnable = dispatcher()->CreateAsyncTask(std::move(task));
@@ -91,8 +174,22 @@ Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::Vizie
   LOG(INFO) << "Queries in flight: " << running_queries_.size();
   running_queries_[query_id] = std::move(runnable);
   runnable_ptr->Run();
+}
 
-  return Status::OK();
+void ExecuteQueryMessageHandler::StartQueuedQueries() {
+  while (!queued_queries_.empty() && CanAdmitQuery()) {
+    auto ticket = carnot_->query_scheduler()->NextToStart();
+    if (ticket == nullptr) {
+      return;
+    }
+    auto node = queued_queries_.extract(ticket.get());
+    if (node.empty()) {
+      // Only this handler registers tickets, and it does so for every query it queues.
+      LOG(DFATAL) << "Granted a slot to a query that isn't queued.";
+      continue;
+    }
+    StartQuery(std::move(node.mapped().msg), std::move(ticket));
+  }
 }
 
 void ExecuteQueryMessageHandler::HandleQueryExecutionComplete(sole::uuid query_id) {
@@ -103,6 +200,7 @@ void ExecuteQueryMessageHandler::HandleQueryExecutionComplete(sole::uuid query_i
     return;
   }
   dispatcher()->DeferredDelete(std::move(node.mapped()));
+  StartQueuedQueries();
 }
 
 }  // namespace agent
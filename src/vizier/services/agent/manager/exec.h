@@ -21,9 +21,14 @@
 #include <memory>
 
 #include <absl/container/flat_hash_map.h>
+#include "src/carnot/exec/query_scheduler.h"
 #include "src/carnot/plan/plan.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DECLARE_int64(agent_query_memory_high_watermark_bytes);
+DECLARE_int32(agent_max_queued_queries);
+DECLARE_string(agent_query_thread_placement);
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -34,13 +39,18 @@ namespace agent {
  * otherwise only query execution is performed.
  *
  * This class runs all of it's work on a thread pool and tracks pending queries internally.
+ *
+ * Queries are started once the query scheduler of carnot grants them a run slot, by their
+ * priority and fairly between users and scripts. While the running queries hold more memory than
+ * FLAGS_agent_query_memory_high_watermark_bytes, no further queries are started until enough of
+ * them complete. New queries are rejected once too many are queued.
  */
 class ExecuteQueryMessageHandler : public Manager::MessageHandler {
  public:
   ExecuteQueryMessageHandler() = delete;
   ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher, Info* agent_info,
                              Manager::VizierNATSConnector* nats_conn, carnot::Carnot* carnot);
-  ~ExecuteQueryMessageHandler() override = default;
+  ~ExecuteQueryMessageHandler() override;
 
   Status HandleMessage(std::unique_ptr<messages::VizierMessage> msg) override;
 
@@ -55,10 +65,23 @@ class ExecuteQueryMessageHandler : public Manager::MessageHandler {
   // Forward declare private task class.
   class ExecuteQueryTask;
 
+  using Ticket = carnot::exec::QueryScheduler::Ticket;
+  struct QueuedQuery {
+    std::shared_ptr<Ticket> ticket;
+    std::unique_ptr<messages::VizierMessage> msg;
+  };
+
+  // Whether the node has the memory to run another query.
+  bool CanAdmitQuery() const;
+  void StartQuery(std::unique_ptr<messages::VizierMessage> msg, std::shared_ptr<Ticket> ticket);
+  void StartQueuedQueries();
+
   carnot::Carnot* carnot_;
 
   // Map from query_id -> Running query task.
   absl::flat_hash_map<sole::uuid, px::event::RunnableAsyncTaskUPtr> running_queries_;
+  // The queries waiting for a run slot or for memory, by their ticket.
+  absl::flat_hash_map<const Ticket*, QueuedQuery> queued_queries_;
 };
 
 }  // namespace agent
@@ -18,6 +18,8 @@
 
 #include "src/vizier/services/agent/manager/heartbeat.h"
 
+#include <unistd.h>
+
 #include <memory>
 #include <utility>
 #include <vector>
@@ -31,25 +33,29 @@ namespace agent {
 using ::px::event::Dispatcher;
 using ::px::shared::k8s::metadatapb::ResourceUpdate;
 
-HeartbeatMessageHandler::HeartbeatMessageHandler(Dispatcher* d,
-                                                 px::md::AgentMetadataStateManager* mds_manager,
-                                                 RelationInfoManager* relation_info_manager,
-                                                 Info* agent_info,
-                                                 Manager::VizierNATSConnector* nats_conn)
+HeartbeatMessageHandler::HeartbeatMessageHandler(
+    Dispatcher* d, px::md::AgentMetadataStateManager* mds_manager,
+    RelationInfoManager* relation_info_manager, table_store::TableStore* table_store,
+    const carnot::exec::QueryScheduler* query_scheduler, Info* agent_info,
+    Manager::VizierNATSConnector* nats_conn)
     : MessageHandler(d, agent_info, nats_conn),
       time_source_(dispatcher()->GetTimeSource()),
       mds_manager_(mds_manager),
       relation_info_manager_(relation_info_manager),
+      table_store_(table_store),
+      query_scheduler_(query_scheduler),
       heartbeat_send_timer_(
           dispatcher()->CreateTimer(std::bind(&HeartbeatMessageHandler::SendHeartbeat, this))),
       heartbeat_watchdog_timer_(
-          dispatcher()->CreateTimer(std::bind(&HeartbeatMessageHandler::HeartbeatWatchdog, this))) {
+          dispatcher()->CreateTimer(std::bind(&HeartbeatMessageHandler::HeartbeatWatchdog, this))),
+      proc_parser_(system::Config::GetInstance()) {
   EnableHeartbeats();
 }
 
 void HeartbeatMessageHandler::DisableHeartbeats() {
   last_metadata_epoch_id_ = 0;
   sent_schema_ = false;
+  acked_schema_version_ = 0;
   heartbeat_send_timer_->DisableTimer();
   heartbeat_watchdog_timer_->DisableTimer();
 }
@@ -100,8 +106,12 @@ Status HeartbeatMessageHandler::SendHeartbeatInternal() {
   if (agent_info()->capabilities.collects_data() &&
       (!sent_schema_ || relation_info_manager_->has_updates())) {
     sent_schema_ = true;
-    relation_info_manager_->AddSchemaToUpdateInfo(update_info);
+    relation_info_manager_->AddSchemaToUpdateInfo(update_info, acked_schema_version_);
+  }
+  if (agent_info()->capabilities.collects_data()) {
+    AddTableTimeRanges(update_info->mutable_data());
   }
+  AddLoad(update_info->mutable_data());
 
   // We skip sending the metadata update when there have been no changes.
   auto current_epoch = mds_manager_->metadata_filter()->epoch_id();
@@ -117,6 +127,40 @@ Status HeartbeatMessageHandler::SendHeartbeatInternal() {
   return nats_conn()->Publish(req);
 }
 
+void HeartbeatMessageHandler::AddTableTimeRanges(messages::AgentDataInfo* data_info) {
+  for (const auto& [table_name, time_range] : table_store_->GetTableTimeRanges()) {
+    auto* table_info = data_info->add_table_info();
+    table_info->set_table(table_name);
+    table_info->mutable_time_range()->set_min_time_ns(time_range.first);
+    table_info->mutable_time_range()->set_max_time_ns(time_range.second);
+  }
+}
+
+void HeartbeatMessageHandler::AddLoad(messages::AgentDataInfo* data_info) {
+  auto* load = data_info->mutable_load();
+  load->set_num_running_queries(query_scheduler_->num_running());
+  load->set_num_queued_queries(query_scheduler_->num_waiting());
+
+  system::ProcParser::ProcessStats stats;
+  Status s = proc_parser_.ParseProcPIDStat(getpid(), &stats);
+  if (!s.ok()) {
+    LOG_FIRST_N(WARNING, 1) << "Failed to read the agent CPU and memory usage: " << s.msg();
+    return;
+  }
+  load->set_memory_bytes(stats.rss_bytes);
+
+  auto now = time_source_.MonotonicTime();
+  int64_t cpu_time_ns = stats.utime_ns + stats.ktime_ns;
+  // The first heartbeat has nothing to compare to, and reports no CPU usage.
+  if (last_cpu_time_ns_ > 0 && now > last_load_time_) {
+    auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_load_time_);
+    load->set_cpu_usage(static_cast<double>(cpu_time_ns - last_cpu_time_ns_) /
+                        elapsed_ns.count());
+  }
+  last_cpu_time_ns_ = cpu_time_ns;
+  last_load_time_ = now;
+}
+
 void HeartbeatMessageHandler::HeartbeatWatchdog() {
   if (heartbeat_info_.last_ackd_seq_num < heartbeat_info_.last_sent_seq_num) {
     auto diff = time_source_.MonotonicTime() - heartbeat_info_.last_heartbeat_send_time_;
@@ -132,6 +176,11 @@ Status HeartbeatMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMe
   CHECK(msg->has_heartbeat_ack());
   auto ack = msg->heartbeat_ack();
   heartbeat_info_.last_ackd_seq_num = ack.sequence_number();
+  if (ack.schema_version() > 0) {
+    // Later schema updates only have to carry the changes since the version the service applied.
+    acked_schema_version_ = ack.schema_version();
+    relation_info_manager_->AcknowledgeVersion(acked_schema_version_);
+  }
 
   auto time_delta = time_source_.MonotonicTime() - heartbeat_info_.last_heartbeat_send_time_;
   heartbeat_latency_moving_average_ =
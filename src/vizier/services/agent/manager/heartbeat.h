@@ -20,6 +20,9 @@
 
 #include <memory>
 
+#include "src/carnot/exec/query_scheduler.h"
+#include "src/common/system/proc_parser.h"
+#include "src/table_store/table/table_store.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
 namespace px {
@@ -31,7 +34,9 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   HeartbeatMessageHandler() = delete;
   HeartbeatMessageHandler(px::event::Dispatcher* dispatcher,
                           px::md::AgentMetadataStateManager* mds_manager,
-                          RelationInfoManager* relation_info_manager, Info* agent_info,
+                          RelationInfoManager* relation_info_manager,
+                          table_store::TableStore* table_store,
+                          const carnot::exec::QueryScheduler* query_scheduler, Info* agent_info,
                           Manager::VizierNATSConnector* nats_conn);
 
   ~HeartbeatMessageHandler() override = default;
@@ -48,6 +53,10 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   void ProcessPIDTerminatedEvent(const px::md::PIDTerminatedEvent& ev,
                                  messages::AgentUpdateInfo* update_info);
 
+  void AddTableTimeRanges(messages::AgentDataInfo* data_info);
+  // Adds the CPU and memory used by the agent, and the number of queries it runs and queues.
+  void AddLoad(messages::AgentDataInfo* data_info);
+
   void DoHeartbeats();
 
   void SendHeartbeat();
@@ -64,16 +73,25 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   std::unique_ptr<px::vizier::messages::VizierMessage> last_sent_hb_;
   int64_t last_metadata_epoch_id_ = 0;
   bool sent_schema_ = false;
+  // The schema version that the metadata service last acknowledged, or 0 if it doesn't track them.
+  int64_t acked_schema_version_ = 0;
 
   HeartbeatInfo heartbeat_info_;
   const px::event::TimeSource& time_source_;
   px::md::AgentMetadataStateManager* mds_manager_;
   RelationInfoManager* relation_info_manager_;
+  table_store::TableStore* table_store_;
+  const carnot::exec::QueryScheduler* query_scheduler_;
   std::chrono::duration<double> heartbeat_latency_moving_average_{0};
 
   px::event::TimerUPtr heartbeat_send_timer_;
   px::event::TimerUPtr heartbeat_watchdog_timer_;
 
+  const system::ProcParser proc_parser_;
+  // The CPU time of the agent when the previous load was sent, to compute its CPU usage since.
+  int64_t last_cpu_time_ns_ = 0;
+  std::chrono::steady_clock::time_point last_load_time_;
+
   static constexpr double kHbLatencyDecay = 0.25;
 
   static constexpr std::chrono::seconds kAgentHeartbeatInterval{5};
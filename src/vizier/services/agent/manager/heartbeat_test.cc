@@ -134,12 +134,16 @@ class HeartbeatMessageHandlerTest : public ::testing::Test {
       EXPECT_OK(relation_info_manager_->AddRelationInfo(relation_info));
     }
 
+    table_store_ = std::make_unique<table_store::TableStore>();
+    table_store_->AddTable(table_store::Table::Create("relation0", relation0), "relation0", 0);
+    table_store_->AddTable(table_store::Table::Create("relation1", relation1), "relation1", 1);
+
     agent_info_ = agent::Info{};
     agent_info_.capabilities.set_collects_data(true);
 
     heartbeat_handler_ = std::make_unique<HeartbeatMessageHandler>(
-        dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), &agent_info_,
-        nats_conn_.get());
+        dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), table_store_.get(),
+        &query_scheduler_, &agent_info_, nats_conn_.get());
   }
 
   void CheckFilterElements(const messages::AgentDataInfo& data_info,
@@ -161,6 +165,8 @@ class HeartbeatMessageHandlerTest : public ::testing::Test {
   std::unique_ptr<event::Dispatcher> dispatcher_;
   std::unique_ptr<FakeAgentMetadataStateManager> mds_manager_;
   std::unique_ptr<RelationInfoManager> relation_info_manager_;
+  std::unique_ptr<table_store::TableStore> table_store_;
+  carnot::exec::QueryScheduler query_scheduler_{/* max_running */ 2, std::chrono::seconds(1)};
   std::unique_ptr<HeartbeatMessageHandler> heartbeat_handler_;
   std::unique_ptr<FakeNATSConnector<px::vizier::messages::VizierMessage>> nats_conn_;
   agent::Info agent_info_;
@@ -310,6 +316,104 @@ TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatRelationUpdates) {
   EXPECT_EQ(3, hb.update_info().schema().size());
 }
 
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatRelationDeltas) {
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1, nats_conn_->published_msgs().size());
+  auto hb = nats_conn_->published_msgs()[0].heartbeat();
+  EXPECT_EQ(2, hb.update_info().schema().size());
+  EXPECT_EQ(2, hb.update_info().schema_version());
+
+  // The metadata service acknowledges the version of the schema that it applied.
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  auto hb_ack_msg = hb_ack->mutable_heartbeat_ack();
+  hb_ack_msg->set_sequence_number(0);
+  hb_ack_msg->set_schema_version(hb.update_info().schema_version());
+  ASSERT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  Relation relation2({types::TIME64NS, types::FLOAT64}, {"time_", "gauge"});
+  ASSERT_OK(relation_info_manager_->AddRelationInfo(
+      RelationInfo("relation2", /* id */ 2, "desc2", relation2)));
+  ASSERT_OK(relation_info_manager_->RemoveRelationInfo("relation0"));
+
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(5 * 5000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+
+  hb = nats_conn_->published_msgs().back().heartbeat();
+  EXPECT_EQ(1, hb.sequence_number());
+  // Only the changes since the acknowledged version are sent.
+  EXPECT_EQ(4, hb.update_info().schema_version());
+  EXPECT_EQ(2, hb.update_info().schema_base_version());
+  ASSERT_EQ(1, hb.update_info().schema().size());
+  EXPECT_EQ("relation2", hb.update_info().schema(0).name());
+  EXPECT_THAT(hb.update_info().removed_schema(), ::testing::ElementsAre("relation0"));
+}
+
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatTableTimeRanges) {
+  // Tables without rows have no time range.
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(1, nats_conn_->published_msgs().size());
+  EXPECT_EQ(0, nats_conn_->published_msgs()[0].heartbeat().update_info().data().table_info_size());
+
+  auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto times = std::make_shared<types::Time64NSValueColumnWrapper>(2);
+  times->Clear();
+  times->AppendFromVector(std::vector<types::Time64NSValue>{100, 200});
+  auto counts = std::make_shared<types::Int64ValueColumnWrapper>(2);
+  counts->Clear();
+  counts->AppendFromVector(std::vector<types::Int64Value>{1, 2});
+  batch->push_back(times);
+  batch->push_back(counts);
+  ASSERT_OK(table_store_->AppendData(0, "", std::move(batch)));
+
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(0);
+  ASSERT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  // The time ranges are sent with every heartbeat, not only when the schema changes.
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(5 * 1000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(2, nats_conn_->published_msgs().size());
+  auto hb = nats_conn_->published_msgs()[1].heartbeat();
+  EXPECT_EQ(0, hb.update_info().schema().size());
+  EXPECT_THAT(hb.update_info().data().table_info(),
+              ::testing::ElementsAre(EqualsProto(R"proto(
+                table: "relation0"
+                time_range {
+                  min_time_ns: 100
+                  max_time_ns: 200
+                }
+              )proto")));
+}
+
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatLoad) {
+  std::vector<std::shared_ptr<carnot::exec::QueryScheduler::Ticket>> tickets;
+  for (int i = 0; i < 3; ++i) {
+    tickets.push_back(query_scheduler_.Register(carnot::exec::QueryClass{}));
+  }
+
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(1, nats_conn_->published_msgs().size());
+  auto load = nats_conn_->published_msgs()[0].heartbeat().update_info().data().load();
+  EXPECT_EQ(2, load.num_running_queries());
+  EXPECT_EQ(1, load.num_queued_queries());
+  EXPECT_GT(load.memory_bytes(), 0);
+  EXPECT_EQ(0, load.cpu_usage());
+
+  // Finishing a query starts the queued one.
+  tickets[0]->Finish();
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(0);
+  ASSERT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(5 * 1000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(2, nats_conn_->published_msgs().size());
+  load = nats_conn_->published_msgs()[1].heartbeat().update_info().data().load();
+  EXPECT_EQ(2, load.num_running_queries());
+  EXPECT_EQ(0, load.num_queued_queries());
+  EXPECT_GE(load.cpu_usage(), 0);
+}
+
 class HeartbeatNackMessageHandlerTest : public ::testing::Test {
  protected:
   void TearDown() override { dispatcher_->Exit(); }
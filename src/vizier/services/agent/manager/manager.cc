@@ -26,11 +26,17 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <jwt/jwt.hpp>
+#include <prometheus/text_serializer.h>
 
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
+#include "src/common/metrics/named_timer.h"
 #include "src/common/perf/perf.h"
+#include "src/common/system/thread_placement.h"
+#include "src/table_store/table/huge_page_memory_pool.h"
 #include "src/vizier/funcs/context/vizier_context.h"
 #include "src/vizier/funcs/funcs.h"
 #include "src/vizier/services/agent/manager/chan_cache.h"
@@ -52,16 +58,97 @@ px::StatusOr<std::string> GetHostname() {
   return std::string(hostname);
 }
 
+px::profiler::PProfServer::Response ServeMetrics(const px::profiler::PProfServer::Params&,
+                                                 std::string_view) {
+  return {200, "text/plain; version=0.0.4",
+          prometheus::TextSerializer().Serialize(CollectMetrics())};
+}
+
+// Lists the timer subsystems, after enabling those of the subsystems param, if it is given.
+px::profiler::PProfServer::Response ServeTimers(const px::profiler::PProfServer::Params& params,
+                                                std::string_view) {
+  if (auto subsystems = params.find("subsystems"); subsystems != params.end()) {
+    px::metrics::SetEnabledTimerSubsystems(subsystems->second);
+  }
+  std::string body;
+  for (const auto& [subsystem, enabled] : px::metrics::GetTimerSubsystems()) {
+    absl::StrAppend(&body, subsystem, "\t", enabled ? "enabled" : "disabled", "\n");
+  }
+  return {200, "text/plain", body};
+}
+
 }  // namespace
 
 DEFINE_string(jwt_signing_key, gflags::StringFromEnv("PL_JWT_SIGNING_KEY", ""),
               "The JWT signing key for outgoing requests");
+DEFINE_int32(table_store_compaction_budget_ms,
+             gflags::Int32FromEnv("PL_TABLE_STORE_COMPACTION_BUDGET_MS", 50),
+             "The CPU time that each table store compaction pass may spend compacting hot batches "
+             "into cold batches. Tables that are left with hot batches are compacted further in "
+             "the next pass.");
+DEFINE_int32(pprof_port, gflags::Int32FromEnv("PL_PPROF_PORT", 0),
+             "The port of the loopback address on which the agent serves pprof profiles, e.g. "
+             "/debug/pprof/profile and /debug/pprof/heap, as well as its metrics on /metrics. 0, "
+             "the default, disables it.");
+DEFINE_string(table_store_compaction_thread_placement,
+              gflags::StringFromEnv("PL_TABLE_STORE_COMPACTION_THREAD_PLACEMENT", ""),
+              "The CPUs and NUMA memory policy of the threads that compact the table store, as "
+              "'<cpu list>[:<default|local|bind|interleave|preferred>]', e.g. '0-3:local'. Empty "
+              "leaves them unplaced.");
+DEFINE_int32(agent_worker_pool_threads, gflags::Int32FromEnv("PL_AGENT_WORKER_POOL_THREADS", 2),
+             "The number of threads of the pool that runs the control plane work of the agent "
+             "that would hold up its event loops, such as the table store compaction.");
+DEFINE_int32(agent_worker_pool_max_queued,
+             gflags::Int32FromEnv("PL_AGENT_WORKER_POOL_MAX_QUEUED", 64),
+             "The number of functions that may wait for a thread of the agent's worker pool. "
+             "Work that is submitted once the queue is full is turned away.");
 
 namespace px {
 namespace vizier {
 namespace agent {
 using ::px::event::Dispatcher;
 
+/**
+ * TableStoreCompactionTask rebalances the table store memory budget and compacts the tables on the
+ * worker pool, so that neither holds up the other work of the dispatcher.
+ */
+class Manager::TableStoreCompactionTask {
+ public:
+  TableStoreCompactionTask(Manager* manager, std::vector<std::shared_ptr<table_store::Table>> tables)
+      : manager_(manager), tables_(std::move(tables)) {}
+
+  void Work() {
+    // The task shares the worker pool with other work, so each pass places its thread again.
+    static const auto* placer = new system::ThreadPlacer(
+        "table_store_compaction", FLAGS_table_store_compaction_thread_placement);
+    placer->PlaceCurrentThread();
+    profiler::ScopedProfileTag profile_tag("table_store_compaction");
+    // The rollups read the hot batches before they are compacted.
+    for (auto& rollup : manager_->table_rollups_) {
+      auto status = rollup->Update(manager_->table_store(), arrow::default_memory_pool());
+      LOG_IF(ERROR, !status.ok()) << absl::Substitute("Failed to update rollup table $0: $1",
+                                                      rollup->spec().rollup_table, status.msg());
+    }
+    // Passes never overlap, so the budget is only ever rebalanced by one task at a time.
+    if (manager_->table_memory_budget_ != nullptr) {
+      auto status = manager_->table_memory_budget_->Rebalance(tables_);
+      LOG_IF(ERROR, !status.ok()) << status.msg();
+    }
+    // The cold batches outlive the pass, so they are allocated from the table store's own pool,
+    // which may be backed by huge pages.
+    auto status =
+        table_store::CompactTables(tables_, table_store::ColdBatchMemoryPool(),
+                                   std::chrono::milliseconds(FLAGS_table_store_compaction_budget_ms));
+    LOG_IF(ERROR, !status.ok()) << status.msg();
+  }
+
+  void Done() { manager_->HandleTableStoreCompactionComplete(); }
+
+ private:
+  Manager* manager_;
+  std::vector<std::shared_ptr<table_store::Table>> tables_;
+};
+
 Manager::MDSServiceSPtr CreateMDSStub(std::string_view mds_addr,
                                       std::shared_ptr<grpc::ChannelCredentials> channel_creds) {
   // TODO(zasgar): Not constructing the MDS by checking the url being empty is a bit janky. Fix
@@ -99,6 +186,8 @@ Manager::Manager(sole::uuid agent_id, std::string_view pod_name, std::string_vie
       func_context_(this, CreateMDSStub(mds_url, grpc_channel_creds_),
                     CreateMDTPStub(mds_url, grpc_channel_creds_), table_store_,
                     [](grpc::ClientContext* ctx) { AddServiceTokenToClientContext(ctx); }) {
+  // Created here, since the heartbeat loop is declared before the API that allocates its loop.
+  heartbeat_loop_ = std::make_unique<px::event::DispatcherThread>("heartbeat", api_.get());
   if (!has_nats_connection()) {
     LOG(WARNING) << "--nats_url is empty, skip connecting to NATS.";
   }
@@ -114,6 +203,8 @@ Manager::Manager(sole::uuid agent_id, std::string_view pod_name, std::string_vie
                 [](grpc::ClientContext* ctx) { AddServiceTokenToClientContext(ctx); },
                 grpc_server_port, SSL::DefaultGRPCServerCreds())
                 .ConsumeValueOrDie();
+  carnot_->RegisterResultStreamMuxStubGenerator(std::bind(
+      &Manager::ResultStreamMuxStubGenerator, this, std::placeholders::_1, std::placeholders::_2));
 
   info_.agent_id = agent_id;
   info_.capabilities = std::move(capabilities);
@@ -127,6 +218,14 @@ Status Manager::Init() {
       md::AgentMetadataFilter::Create(kMetadataFilterMaxEntries, kMetadataFilterMaxErrorRate,
                                       md::kMetadataFilterEntities));
   chan_cache_ = std::make_unique<ChanCache>(kChanIdleGracePeriod);
+  worker_pool_ = std::make_unique<px::event::WorkerPool>("agent", FLAGS_agent_worker_pool_threads,
+                                                         FLAGS_agent_worker_pool_max_queued);
+  if (FLAGS_table_store_memory_budget > 0) {
+    PL_ASSIGN_OR_RETURN(auto table_weights,
+                        table_store::ParseTableWeights(FLAGS_table_store_table_weights));
+    table_memory_budget_ = std::make_unique<table_store::TableMemoryBudget>(
+        FLAGS_table_store_memory_budget, std::move(table_weights));
+  }
   auto hostname_or_s = GetHostname();
   if (!hostname_or_s.ok()) {
     return hostname_or_s.status();
@@ -136,6 +235,18 @@ Status Manager::Init() {
 
   LOG(INFO) << "Hostname: " << info_.hostname;
 
+  if (FLAGS_pprof_port > 0) {
+    // The profiles are only a debugging aid, so the agent runs without them if the port is taken.
+    pprof_server_ = std::make_unique<profiler::PProfServer>();
+    pprof_server_->RegisterHandler("/metrics", &ServeMetrics);
+    pprof_server_->RegisterHandler("/debug/timers", &ServeTimers);
+    auto s = pprof_server_->Start(FLAGS_pprof_port);
+    if (!s.ok()) {
+      LOG(WARNING) << s.msg();
+      pprof_server_.reset();
+    }
+  }
+
   // Set up the agent NATS connector.
   if (!has_nats_connection()) {
     LOG(WARNING) << "NATS is not configured, skip connecting. Stirling and Carnot might not behave "
@@ -185,6 +296,10 @@ Status Manager::Stop(std::chrono::milliseconds timeout) {
   stop_called_ = true;
 
   dispatcher_->Stop();
+  heartbeat_loop_->Stop();
+  if (pprof_server_ != nullptr) {
+    pprof_server_->Stop();
+  }
   auto s = StopImpl(timeout);
 
   // Wait for a limited amount of time for main thread to stop processing.
@@ -197,7 +312,9 @@ Status Manager::Stop(std::chrono::milliseconds timeout) {
 }
 
 Status Manager::RegisterBackgroundHelpers() {
-  metadata_update_timer_ = dispatcher_->CreateTimer([this]() {
+  // The metadata updates share the loop of the heartbeats, which send the metadata filter that
+  // they update.
+  metadata_update_timer_ = heartbeat_dispatcher()->CreateTimer([this]() {
     VLOG(1) << "State Update";
     ECHECK_OK(mds_manager_->PerformMetadataStateUpdate());
     if (metadata_update_timer_) {
@@ -217,17 +334,20 @@ Status Manager::RegisterBackgroundHelpers() {
 
   // Add Heartbeat and execute query handlers.
   heartbeat_handler_ = std::make_shared<HeartbeatMessageHandler>(
-      dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), &info_,
-      agent_nats_connector_.get());
+      heartbeat_dispatcher(), mds_manager_.get(), relation_info_manager_.get(), table_store_.get(),
+      carnot_->query_scheduler(), &info_, agent_nats_connector_.get());
 
   auto heartbeat_nack_handler = std::make_shared<HeartbeatNackMessageHandler>(
-      dispatcher_.get(), &info_, agent_nats_connector_.get(),
+      heartbeat_dispatcher(), &info_, agent_nats_connector_.get(),
       std::bind(&Manager::ReregisterHook, this));
 
   PL_CHECK_OK(
       RegisterMessageHandler(messages::VizierMessage::MsgCase::kHeartbeatAck, heartbeat_handler_));
   PL_CHECK_OK(RegisterMessageHandler(messages::VizierMessage::MsgCase::kHeartbeatNack,
                                      heartbeat_nack_handler));
+  // The timers of the heartbeat loop are created before it starts, since they can't be created
+  // from other threads once it runs.
+  heartbeat_loop_->Start();
 
   // Attach message handler for config updates.
   auto config_manager =
@@ -240,6 +360,7 @@ Status Manager::RegisterBackgroundHelpers() {
 
 Status Manager::RegisterMessageHandler(Manager::MsgCase c, std::shared_ptr<MessageHandler> handler,
                                        bool override) {
+  absl::MutexLock lock(&message_handlers_lock_);
   if (message_handlers_.contains(c) && !override) {
     return error::AlreadyExists("message handler already exists for case: $0", c);
   }
@@ -247,15 +368,24 @@ Status Manager::RegisterMessageHandler(Manager::MsgCase c, std::shared_ptr<Messa
   return Status::OK();
 }
 
+std::shared_ptr<Manager::MessageHandler> Manager::GetMessageHandler(Manager::MsgCase c) {
+  absl::MutexLock lock(&message_handlers_lock_);
+  auto it = message_handlers_.find(c);
+  return it != message_handlers_.end() ? it->second : nullptr;
+}
+
 void Manager::NATSMessageHandler(Manager::VizierNATSConnector::MsgType msg) {
   // NATS returns data to us in an arbritrary thread. We need to handle it in the event
-  // loop thread so we post to the event loop.
+  // loop thread of its handler so we post to the dispatcher of the handler. Messages without a
+  // handler are logged on the main loop.
+  auto handler = GetMessageHandler(msg->msg_case());
+  auto* dispatcher = handler != nullptr ? handler->dispatcher() : dispatcher_.get();
 
   // This funny pointer stuff is required because we generate an std::function,
   // that requires a copy of the lambda. The release allows us to recapture the value
   // into another unique pointer.
   messages::VizierMessage* m = msg.release();
-  dispatcher_->Post(
+  dispatcher->Post(
       [m, this]() mutable { HandleMessage(std::unique_ptr<messages::VizierMessage>(m)); });
 }
 
@@ -263,9 +393,9 @@ void Manager::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
   VLOG(1) << "Manager::Run::GotMessage " << msg->DebugString();
 
   auto c = msg->msg_case();
-  auto it = message_handlers_.find(c);
-  if (it != message_handlers_.end()) {
-    ECHECK_OK(it->second->HandleMessage(std::move(msg)))
+  auto handler = GetMessageHandler(c);
+  if (handler != nullptr) {
+    ECHECK_OK(handler->HandleMessage(std::move(msg)))
         << "message handler failed... for type: " << c
         << " ignoring. Message: " << msg->DebugString();
     // Handler found.
@@ -311,12 +441,12 @@ Status Manager::PostRegisterHook(uint32_t asid) {
   }
 
   tablestore_compaction_timer_ = dispatcher()->CreateTimer([this]() {
-    // TODO(james): when we change ExecState::exec_mem_pool to not return just the default pool, we
-    // will need to figure out how to use the correct memory pool here, but for now we can just use
-    // the default pool.
-    auto status = table_store()->RunCompaction(arrow::default_memory_pool());
-    LOG_IF(ERROR, !status.ok()) << status.msg();
-    if (tablestore_compaction_timer_) {
+    // The tables are collected on the dispatcher, which is where tables are added to the store.
+    auto task = std::make_shared<TableStoreCompactionTask>(this, table_store()->GetTables());
+    auto s = worker_pool_->Submit([task]() { task->Work(); }, [task]() { task->Done(); },
+                                  dispatcher());
+    if (!s.ok()) {
+      LOG(WARNING) << "Skipping a table store compaction pass: " << s.msg();
       tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
     }
   });
@@ -325,25 +455,33 @@ Status Manager::PostRegisterHook(uint32_t asid) {
   return Status::OK();
 }
 
+void Manager::HandleTableStoreCompactionComplete() {
+  // The next pass is only scheduled once this one is done, so that passes never overlap.
+  if (tablestore_compaction_timer_) {
+    tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
+  }
+}
+
+// Called on the heartbeat loop, by the heartbeat nack handler.
 Status Manager::ReregisterHook() {
   LOG_IF(FATAL, heartbeat_handler_ == nullptr) << "Heartbeat handler is not set up";
   heartbeat_handler_->DisableHeartbeats();
-  registration_handler_->ReregisterAgent();
+  dispatcher_->Post([this]() { registration_handler_->ReregisterAgent(); });
   return Status::OK();
 }
 
 Status Manager::PostReregisterHook(uint32_t asid) {
   LOG_IF(FATAL, heartbeat_handler_ == nullptr) << "Heartbeat handler is not set up";
   LOG_IF(FATAL, asid != info_.asid) << "Received conflicting ASID after reregistration";
-  heartbeat_handler_->EnableHeartbeats();
+  heartbeat_dispatcher()->Post([this]() { heartbeat_handler_->EnableHeartbeats(); });
   return Status::OK();
 }
 
-std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
-    const std::string& remote_addr, const std::string& ssl_targetname) {
+std::shared_ptr<grpc::Channel> Manager::ResultSinkChannel(const std::string& remote_addr,
+                                                          const std::string& ssl_targetname) {
   auto chan = chan_cache_->GetChan(remote_addr);
   if (chan != nullptr) {
-    return px::carnotpb::ResultSinkService::NewStub(chan);
+    return chan;
   }
 
   grpc::ChannelArguments args;
@@ -359,7 +497,19 @@ std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
 
   chan = grpc::CreateCustomChannel(remote_addr, grpc_channel_creds_, args);
   chan_cache_->Add(remote_addr, chan);
-  return px::carnotpb::ResultSinkService::NewStub(chan);
+  return chan;
+}
+
+std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
+    const std::string& remote_addr, const std::string& ssl_targetname) {
+  return px::carnotpb::ResultSinkService::NewStub(ResultSinkChannel(remote_addr, ssl_targetname));
+}
+
+// The multiplexed streams share the channels of the dedicated ones.
+std::unique_ptr<Manager::ResultStreamMuxStub> Manager::ResultStreamMuxStubGenerator(
+    const std::string& remote_addr, const std::string& ssl_targetname) {
+  return px::carnotpb::ResultStreamMuxService::NewStub(
+      ResultSinkChannel(remote_addr, ssl_targetname));
 }
 
 Manager::MessageHandler::MessageHandler(Dispatcher* dispatcher, Info* agent_info,
@@ -24,13 +24,19 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "src/carnot/carnot.h"
+#include "src/carnot/table_rollup.h"
 #include "src/common/base/base.h"
+#include "src/common/event/dispatcher_thread.h"
 #include "src/common/event/event.h"
 #include "src/common/event/nats.h"
+#include "src/common/event/worker_pool.h"
+#include "src/common/perf/perf.h"
 #include "src/common/uuid/uuid.h"
 #include "src/shared/metadata/metadata.h"
+#include "src/table_store/table/memory_budget.h"
 #include "src/vizier/funcs/context/vizier_context.h"
 #include "src/vizier/messages/messagespb/messages.pb.h"
 #include "src/vizier/services/agent/manager/chan_cache.h"
@@ -59,7 +65,9 @@ constexpr auto kChanCacheCleanupChansionPeriod = std::chrono::minutes(5);
  */
 constexpr auto kChanIdleGracePeriod = std::chrono::minutes(1);
 
-constexpr auto kTableStoreCompactionPeriod = std::chrono::minutes(1);
+// How long to wait after a table store compaction pass before starting the next one. Each pass is
+// limited by --table_store_compaction_budget_ms of CPU time.
+constexpr auto kTableStoreCompactionPeriod = std::chrono::seconds(1);
 
 /**
  * Info tracks basic information about and agent such as:
@@ -102,6 +110,7 @@ class Manager : public px::NotCopyable {
   using MDTPService = services::metadata::MetadataTracepointService;
   using MDTPServiceSPtr = std::shared_ptr<Manager::MDTPService::Stub>;
   using ResultSinkStub = px::carnotpb::ResultSinkService::StubInterface;
+  using ResultStreamMuxStub = px::carnotpb::ResultStreamMuxService::StubInterface;
 
   Manager() = delete;
   virtual ~Manager() = default;
@@ -157,17 +166,32 @@ class Manager : public px::NotCopyable {
   px::md::AgentMetadataStateManager* mds_manager() { return mds_manager_.get(); }
   RelationInfoManager* relation_info_manager() { return relation_info_manager_.get(); }
   px::event::Dispatcher* dispatcher() { return dispatcher_.get(); }
+  // The loop of the heartbeats and metadata updates, which runs on a thread of its own so that
+  // bursts of messages on the main loop, such as tracepoint deployments, don't delay them.
+  px::event::Dispatcher* heartbeat_dispatcher() { return heartbeat_loop_->dispatcher(); }
+  // The worker pool for the control plane work that would hold up the loops, e.g. compaction.
+  px::event::WorkerPool* worker_pool() { return worker_pool_.get(); }
   carnot::Carnot* carnot() { return carnot_.get(); }
   const Info* info() const { return &info_; }
   Info* info() { return &info_; }
   VizierNATSConnector* agent_nats_connector() { return agent_nats_connector_.get(); }
 
+  // Adds a rollup that the table store compaction passes keep up to date. Must be called before
+  // the agent runs.
+  void AddTableRollup(std::unique_ptr<carnot::TableRollup> rollup) {
+    table_rollups_.push_back(std::move(rollup));
+  }
+
   // Kelvin and PEMs use different selectors to request k8s updates.
   virtual std::string k8s_update_selector() const = 0;
 
  private:
+  std::shared_ptr<grpc::Channel> ResultSinkChannel(const std::string& remote_addr,
+                                                   const std::string& ssl_targetname);
   std::unique_ptr<ResultSinkStub> ResultSinkStubGenerator(const std::string& remote_addr,
                                                           const std::string& ssl_targetname);
+  std::unique_ptr<ResultStreamMuxStub> ResultStreamMuxStubGenerator(
+      const std::string& remote_addr, const std::string& ssl_targetname);
   void NATSMessageHandler(VizierNATSConnector::MsgType msg);
   Status RegisterBackgroundHelpers();
   Status PostRegisterHook(uint32_t asid);
@@ -175,14 +199,24 @@ class Manager : public px::NotCopyable {
   Status PostReregisterHook(uint32_t asid);
   bool has_nats_connection() const { return !nats_addr_.empty(); }
 
+  class TableStoreCompactionTask;
+  void HandleTableStoreCompactionComplete();
+  std::shared_ptr<MessageHandler> GetMessageHandler(MsgCase c);
+
   static constexpr char kAgentSubTopicPattern[] = "Agent/$0";
   static constexpr char kAgentPubTopic[] = "UpdateAgent";
   static constexpr char kK8sSubTopicPattern[] = "K8sUpdates/$0";
   static constexpr char kK8sPubTopic[] = "MissingMetadataRequests";
 
+  // The heartbeat loop outlives the timers and handlers that run on it.
+  std::unique_ptr<px::event::DispatcherThread> heartbeat_loop_;
+
   // Message handlers are registered per type of Vizier message.
   // same message handler can be used for multiple different types of messages.
-  absl::flat_hash_map<MsgCase, std::shared_ptr<MessageHandler>> message_handlers_;
+  // They are looked up from the NATS threads, to post the messages to the loops of the handlers.
+  absl::Mutex message_handlers_lock_;
+  absl::flat_hash_map<MsgCase, std::shared_ptr<MessageHandler>> message_handlers_
+      ABSL_GUARDED_BY(message_handlers_lock_);
   void HandleMessage(std::unique_ptr<messages::VizierMessage> msg);
 
   // The timer to manage metadata updates.
@@ -229,6 +263,16 @@ class Manager : public px::NotCopyable {
 
   // Timer to manage table store compaction.
   px::event::TimerUPtr tablestore_compaction_timer_;
+  // Splits --table_store_memory_budget across the tables, if it is set.
+  std::unique_ptr<table_store::TableMemoryBudget> table_memory_budget_;
+  // The rollups of --table_store_rollups, which are updated by the compaction passes.
+  std::vector<std::unique_ptr<carnot::TableRollup>> table_rollups_;
+
+  // Serves the CPU and heap profiles of the agent, unless --pprof_port is 0.
+  std::unique_ptr<profiler::PProfServer> pprof_server_;
+
+  // Declared last, so that the work that is running finishes before the state it uses is deleted.
+  std::unique_ptr<px::event::WorkerPool> worker_pool_;
 };
 
 /**
@@ -252,15 +296,18 @@ class Manager::MessageHandler {
   virtual ~MessageHandler() = default;
 
   /**
-   * Handle a message of the registered type. This function is called using the event loop thread.
+   * Handle a message of the registered type. This function is called on the event loop thread of
+   * the dispatcher of the handler.
    * Do not call blocking operators while handling the message.
    */
   virtual Status HandleMessage(std::unique_ptr<messages::VizierMessage> msg) = 0;
 
+  // The dispatcher on whose loop the messages are handled.
+  px::event::Dispatcher* dispatcher() { return dispatcher_; }
+
  protected:
   const Info* agent_info() const { return agent_info_; }
   Manager::VizierNATSConnector* nats_conn() { return nats_conn_; }
-  px::event::Dispatcher* dispatcher() { return dispatcher_; }
 
  private:
   const Info* agent_info_;
@@ -16,6 +16,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <string>
 #include <utility>
 
 #include "src/vizier/services/agent/manager/relation_info_manager.h"
@@ -29,7 +31,29 @@ Status RelationInfoManager::AddRelationInfo(RelationInfo relation_info) {
     return error::AlreadyExists("Relation '$0' already exists", relation_info.name);
   }
   std::string name = relation_info.name;
-  relation_info_map_[name] = std::move(relation_info);
+  ++version_;
+  removed_relations_.erase(name);
+  relation_info_map_[name] = {std::move(relation_info), version_};
+  has_updates_ = true;
+  return Status::OK();
+}
+
+Status RelationInfoManager::RemoveRelationInfo(std::string_view name) {
+  absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
+  auto iter = relation_info_map_.find(name);
+  if (iter == relation_info_map_.end()) {
+    return error::NotFound("Relation '$0' does not exist", name);
+  }
+  relation_info_map_.erase(iter);
+  ++version_;
+  if (acknowledged_) {
+    removed_relations_[std::string(name)] = version_;
+  } else {
+    // Deltas are only made from acknowledged versions, and metadata services that don't track the
+    // versions never acknowledge one, so the removal isn't kept. Deltas can only be made from the
+    // versions after it.
+    forgotten_version_ = version_;
+  }
   has_updates_ = true;
   return Status::OK();
 }
@@ -39,33 +63,75 @@ bool RelationInfoManager::HasRelation(std::string_view name) const {
   return relation_info_map_.contains(name);
 }
 
-// TODO(philkuz) (PL-852) only send schema updates for changes to the schema.
-void RelationInfoManager::AddSchemaToUpdateInfo(messages::AgentUpdateInfo* update_info) const {
+int64_t RelationInfoManager::version() const {
+  absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
+  return version_;
+}
+
+void RelationInfoManager::AcknowledgeVersion(int64_t version) {
+  absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
+  if (version > version_) {
+    // Not a version of this schema, e.g. one from before the agent restarted.
+    return;
+  }
+  for (auto iter = removed_relations_.begin(); iter != removed_relations_.end();) {
+    if (iter->second <= version) {
+      iter = removed_relations_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  forgotten_version_ = std::max(forgotten_version_, version);
+  acknowledged_ = true;
+}
+
+void RelationInfoManager::AddSchemaToUpdateInfo(messages::AgentUpdateInfo* update_info,
+                                                int64_t acked_version) const {
   absl::base_internal::SpinLockHolder lock(&relation_info_map_lock_);
 
   update_info->set_does_update_schema(true);
-  for (const auto& [name, relation_info] : relation_info_map_) {
-    auto* schema = update_info->add_schema();
-    schema->set_name(relation_info.name);
-    schema->set_desc(relation_info.desc);
-    const table_store::schema::Relation& relation = relation_info.relation;
-    if (relation_info.tabletized) {
-      schema->set_tabletized(relation_info.tabletized);
-      schema->set_tabletization_key(relation.GetColumnName(relation_info.tabletization_key_idx));
+  update_info->set_schema_version(version_);
+
+  // The removals since the acked version have to be known to send a delta from it.
+  bool delta =
+      acked_version > 0 && acked_version >= forgotten_version_ && acked_version <= version_;
+  if (delta) {
+    update_info->set_schema_base_version(acked_version);
+    for (const auto& [name, removed_version] : removed_relations_) {
+      if (removed_version > acked_version) {
+        update_info->add_removed_schema(name);
+      }
     }
-    for (size_t i = 0; i < relation.NumColumns(); ++i) {
-      auto* column = schema->add_columns();
-      column->set_name(relation.GetColumnName(i));
-      column->set_data_type(relation.GetColumnType(i));
-      column->set_desc(relation.GetColumnDesc(i));
-      column->set_semantic_type(relation.GetColumnSemanticType(i));
-      // TODO(philkuz) (PL-850) add pattern_type to the relation somehow.
-      // column->set_pattern_type(relation.GetColumnPatternType(i));
+  }
+  for (const auto& [name, versioned_relation_info] : relation_info_map_) {
+    if (!delta || versioned_relation_info.version > acked_version) {
+      AddRelationToUpdateInfo(versioned_relation_info.relation_info, update_info);
     }
   }
   has_updates_ = false;
 }
 
+void RelationInfoManager::AddRelationToUpdateInfo(const RelationInfo& relation_info,
+                                                  messages::AgentUpdateInfo* update_info) const {
+  auto* schema = update_info->add_schema();
+  schema->set_name(relation_info.name);
+  schema->set_desc(relation_info.desc);
+  const table_store::schema::Relation& relation = relation_info.relation;
+  if (relation_info.tabletized) {
+    schema->set_tabletized(relation_info.tabletized);
+    schema->set_tabletization_key(relation.GetColumnName(relation_info.tabletization_key_idx));
+  }
+  for (size_t i = 0; i < relation.NumColumns(); ++i) {
+    auto* column = schema->add_columns();
+    column->set_name(relation.GetColumnName(i));
+    column->set_data_type(relation.GetColumnType(i));
+    column->set_desc(relation.GetColumnDesc(i));
+    column->set_semantic_type(relation.GetColumnSemanticType(i));
+    // TODO(philkuz) (PL-850) add pattern_type to the relation somehow.
+    // column->set_pattern_type(relation.GetColumnPatternType(i));
+  }
+}
+
 }  // namespace agent
 }  // namespace vizier
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
@@ -30,8 +31,10 @@ namespace px {
 namespace vizier {
 namespace agent {
 /**
- * @brief Manager of relation info for a given agent. In the future, this can be used to provide
- * diff-updates of a schema rather than passing the entire schema through the update message.
+ * @brief Manager of relation info for a given agent.
+ *
+ * The relations are versioned: each change bumps the version of the schema, so that once the
+ * metadata service has acknowledged a version, only the changes since are sent to it.
  */
 class RelationInfoManager {
  public:
@@ -44,6 +47,13 @@ class RelationInfoManager {
    */
   Status AddRelationInfo(RelationInfo relation_info);
 
+  /**
+   * @brief Removes the relation with the given name.
+   *
+   * @return Status: Error if there is no such relation.
+   */
+  Status RemoveRelationInfo(std::string_view name);
+
   /**
    * Checks to see if a relation with the given name exists.
    * @param name The name of the relation.
@@ -57,15 +67,44 @@ class RelationInfoManager {
    * Updates the has_update state.
    *
    * @param update_info: the message that should receive the updated schema info.
+   * @param acked_version: the last version of the schema that the metadata service acknowledged,
+   * or 0. If the changes since that version are still known, only those are added.
    */
-  void AddSchemaToUpdateInfo(messages::AgentUpdateInfo* update_info) const;
+  void AddSchemaToUpdateInfo(messages::AgentUpdateInfo* update_info,
+                             int64_t acked_version = 0) const;
+
+  /**
+   * @brief Records that the metadata service applied the given version of the schema. The removed
+   * relations that it already knows about are forgotten. Until the first call, removals aren't
+   * kept at all.
+   */
+  void AcknowledgeVersion(int64_t version);
 
   bool has_updates() const { return has_updates_; }
 
+  int64_t version() const;
+
  private:
+  struct VersionedRelationInfo {
+    RelationInfo relation_info;
+    // The version of the schema in which the relation was added.
+    int64_t version;
+  };
+
+  void AddRelationToUpdateInfo(const RelationInfo& relation_info,
+                               messages::AgentUpdateInfo* update_info) const;
+
   mutable std::atomic<bool> has_updates_ = false;
   mutable absl::base_internal::SpinLock relation_info_map_lock_;
-  absl::btree_map<std::string, RelationInfo> relation_info_map_ GUARDED_BY(relation_info_map_lock_);
+  absl::btree_map<std::string, VersionedRelationInfo> relation_info_map_
+      GUARDED_BY(relation_info_map_lock_);
+  // The version of the schema in which each relation was removed, until that's acknowledged.
+  absl::btree_map<std::string, int64_t> removed_relations_ GUARDED_BY(relation_info_map_lock_);
+  int64_t version_ GUARDED_BY(relation_info_map_lock_) = 0;
+  // Removals up to this version were forgotten, so deltas can only be made from later versions.
+  int64_t forgotten_version_ GUARDED_BY(relation_info_map_lock_) = 0;
+  // Whether the metadata service acknowledged a version. Removals are only kept after it did.
+  bool acknowledged_ GUARDED_BY(relation_info_map_lock_) = false;
 };
 
 }  // namespace agent
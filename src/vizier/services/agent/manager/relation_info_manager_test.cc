@@ -43,6 +43,7 @@ class RelationInfoManagerTest : public ::testing::Test {
 
 const char* kAgentUpdateInfoSchemaNoTablets = R"proto(
 does_update_schema: true
+schema_version: 2
 schema {
   name: "relation0"
   desc: "desc0"
@@ -92,6 +93,7 @@ TEST_F(RelationInfoManagerTest, test_update) {
 
 const char* kAgentUpdateInfoSchemaHasTablets = R"proto(
 does_update_schema: true
+schema_version: 2
 schema {
   name: "relation0"
   desc: "desc0"
@@ -157,6 +159,102 @@ TEST_F(RelationInfoManagerTest, test_tabletization_keys) {
   EXPECT_THAT(update_info, EqualsProto(kAgentUpdateInfoSchemaHasTablets));
 }
 
+const char* kAgentUpdateInfoSchemaDelta = R"proto(
+does_update_schema: true
+schema_version: 4
+schema_base_version: 2
+removed_schema: "relation0"
+schema {
+  name: "relation2"
+  desc: "desc2"
+  columns {
+    name: "time_"
+    data_type: TIME64NS
+    semantic_type: ST_NONE
+  }
+})proto";
+
+TEST_F(RelationInfoManagerTest, test_delta_update) {
+  Relation relation0({types::TIME64NS, types::INT64}, {"time_", "count"});
+  Relation relation1({types::TIME64NS, types::FLOAT64}, {"time_", "gauge"});
+  Relation relation2({types::TIME64NS}, {"time_"});
+  EXPECT_OK(
+      relation_info_manager_->AddRelationInfo(RelationInfo("relation0", 0, "desc0", relation0)));
+  EXPECT_OK(
+      relation_info_manager_->AddRelationInfo(RelationInfo("relation1", 1, "desc1", relation1)));
+  EXPECT_EQ(2, relation_info_manager_->version());
+  relation_info_manager_->AcknowledgeVersion(2);
+
+  EXPECT_OK(relation_info_manager_->RemoveRelationInfo("relation0"));
+  EXPECT_NOT_OK(relation_info_manager_->RemoveRelationInfo("relation0"));
+  EXPECT_FALSE(relation_info_manager_->HasRelation("relation0"));
+  EXPECT_OK(
+      relation_info_manager_->AddRelationInfo(RelationInfo("relation2", 2, "desc2", relation2)));
+  EXPECT_TRUE(relation_info_manager_->has_updates());
+
+  // Only the changes since the acked version are sent.
+  messages::AgentUpdateInfo delta;
+  relation_info_manager_->AddSchemaToUpdateInfo(&delta, /* acked_version */ 2);
+  EXPECT_THAT(delta, EqualsProto(kAgentUpdateInfoSchemaDelta));
+  EXPECT_FALSE(relation_info_manager_->has_updates());
+
+  // Without an acked version, or one that the manager doesn't know, the full schema is sent.
+  for (int64_t acked_version : {0, 5}) {
+    messages::AgentUpdateInfo full;
+    relation_info_manager_->AddSchemaToUpdateInfo(&full, acked_version);
+    EXPECT_EQ(0, full.schema_base_version());
+    EXPECT_EQ(0, full.removed_schema_size());
+    ASSERT_EQ(2, full.schema_size());
+    EXPECT_EQ("relation1", full.schema(0).name());
+    EXPECT_EQ("relation2", full.schema(1).name());
+  }
+
+  // Once the removal is acked, deltas from before it can't be made anymore.
+  relation_info_manager_->AcknowledgeVersion(3);
+  messages::AgentUpdateInfo stale;
+  relation_info_manager_->AddSchemaToUpdateInfo(&stale, /* acked_version */ 2);
+  EXPECT_EQ(0, stale.schema_base_version());
+  EXPECT_EQ(2, stale.schema_size());
+
+  messages::AgentUpdateInfo up_to_date;
+  relation_info_manager_->AddSchemaToUpdateInfo(&up_to_date, /* acked_version */ 4);
+  EXPECT_EQ(4, up_to_date.schema_base_version());
+  EXPECT_EQ(0, up_to_date.removed_schema_size());
+  EXPECT_EQ(0, up_to_date.schema_size());
+}
+
+TEST_F(RelationInfoManagerTest, test_removals_without_ack) {
+  Relation relation0({types::TIME64NS, types::INT64}, {"time_", "count"});
+  Relation relation1({types::TIME64NS, types::FLOAT64}, {"time_", "gauge"});
+  EXPECT_OK(
+      relation_info_manager_->AddRelationInfo(RelationInfo("relation0", 0, "desc0", relation0)));
+  EXPECT_OK(
+      relation_info_manager_->AddRelationInfo(RelationInfo("relation1", 1, "desc1", relation1)));
+
+  // Without any ack the removals aren't kept, so there's no delta from before them.
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_OK(relation_info_manager_->RemoveRelationInfo("relation0"));
+    EXPECT_OK(
+        relation_info_manager_->AddRelationInfo(RelationInfo("relation0", 0, "desc0", relation0)));
+  }
+  EXPECT_OK(relation_info_manager_->RemoveRelationInfo("relation0"));
+  EXPECT_EQ(203, relation_info_manager_->version());
+
+  messages::AgentUpdateInfo full;
+  relation_info_manager_->AddSchemaToUpdateInfo(&full, /* acked_version */ 2);
+  EXPECT_EQ(0, full.schema_base_version());
+  EXPECT_EQ(0, full.removed_schema_size());
+  ASSERT_EQ(1, full.schema_size());
+  EXPECT_EQ("relation1", full.schema(0).name());
+
+  // Deltas can be made from the versions after the last removal.
+  relation_info_manager_->AcknowledgeVersion(203);
+  messages::AgentUpdateInfo delta;
+  relation_info_manager_->AddSchemaToUpdateInfo(&delta, /* acked_version */ 203);
+  EXPECT_EQ(203, delta.schema_base_version());
+  EXPECT_EQ(0, delta.schema_size());
+}
+
 }  // namespace agent
 }  // namespace vizier
 }  // namespace px
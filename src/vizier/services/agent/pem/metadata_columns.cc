@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/metadata_columns.h"
+
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+DEFINE_string(table_store_metadata_columns,
+              gflags::StringFromEnv("PL_TABLE_STORE_METADATA_COLUMNS", ""),
+              "Comma separated names of tables with a upid column, to which pod_id and service_id "
+              "columns are added. Their values are resolved when the records are written, so that "
+              "queries don't have to resolve them from the upid of every row.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+absl::flat_hash_set<std::string> ParseTableNames(std::string_view tables) {
+  absl::flat_hash_set<std::string> names;
+  for (std::string_view name : absl::StrSplit(tables, ',', absl::SkipWhitespace())) {
+    names.emplace(absl::StripAsciiWhitespace(name));
+  }
+  return names;
+}
+
+}  // namespace
+
+MetadataColumns::MetadataColumns(std::string_view tables, AgentMetadataFn agent_metadata_fn)
+    : tables_(ParseTableNames(tables)),
+      agent_metadata_fn_(std::move(agent_metadata_fn)) {}
+
+bool MetadataColumns::AddColumns(uint64_t table_id, const std::string& table_name,
+                                 table_store::schema::Relation* relation) {
+  if (!tables_.contains(table_name)) {
+    return false;
+  }
+  int64_t upid_col_idx = relation->GetColumnIndex("upid");
+  if (upid_col_idx < 0 || relation->GetColumnType(upid_col_idx) != types::UINT128) {
+    LOG(WARNING) << absl::Substitute("Not adding metadata columns to $0, it has no upid column.",
+                                     table_name);
+    return false;
+  }
+  if (relation->HasColumn(kPodIDColumn) || relation->HasColumn(kServiceIDColumn)) {
+    LOG(WARNING) << absl::Substitute("Not adding metadata columns to $0, it already has them.",
+                                     table_name);
+    return false;
+  }
+
+  relation->AddColumn(types::STRING, kPodIDColumn, "The ID of the pod of the process.");
+  relation->AddColumn(types::STRING, kServiceIDColumn,
+                      "The IDs of the running services of the pod of the process.");
+  upid_col_idx_by_table_[table_id] = upid_col_idx;
+  return true;
+}
+
+void MetadataColumns::Populate(uint64_t table_id, types::ColumnWrapperRecordBatch* record_batch) {
+  auto iter = upid_col_idx_by_table_.find(table_id);
+  if (iter == upid_col_idx_by_table_.end()) {
+    return;
+  }
+  const types::ColumnWrapper& upids = *record_batch->at(iter->second);
+  const size_t num_rows = upids.Size();
+
+  auto pod_ids = types::ColumnWrapper::Make(types::STRING, num_rows);
+  auto service_ids = types::ColumnWrapper::Make(types::STRING, num_rows);
+
+  {
+    absl::MutexLock lock(&mutex_);
+    std::shared_ptr<const md::AgentMetadataState> agent_metadata = agent_metadata_fn_();
+    if (agent_metadata != nullptr) {
+      if (function_ctx_ == nullptr || function_ctx_->metadata_state() != agent_metadata.get()) {
+        function_ctx_ = std::make_unique<carnot::udf::FunctionContext>(std::move(agent_metadata),
+                                                                       /* model_pool */ nullptr);
+      }
+      const auto* upid_values = static_cast<const types::UInt128Value*>(upids.UnsafeRawData());
+      pod_id_udf_.ExecVector(function_ctx_.get(), num_rows,
+                             static_cast<types::StringValue*>(pod_ids->UnsafeRawData()),
+                             upid_values);
+      service_id_udf_.ExecVector(function_ctx_.get(), num_rows,
+                                 static_cast<types::StringValue*>(service_ids->UnsafeRawData()),
+                                 upid_values);
+    }
+  }
+
+  record_batch->push_back(std::move(pod_ids));
+  record_batch->push_back(std::move(service_ids));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/funcs/metadata/metadata_ops.h"
+#include "src/common/base/base.h"
+#include "src/shared/metadata/metadata_state.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/schema/relation.h"
+
+DECLARE_string(table_store_metadata_columns);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * MetadataColumns adds pod_id and service_id columns to selected tables that have a upid column.
+ * Their values are resolved from the agent metadata when the records are written to the table
+ * store, so that queries read them instead of resolving the UPID of every row at query time.
+ *
+ * The values reflect the metadata at the time the records are written. Records of processes whose
+ * metadata hasn't arrived yet get empty values.
+ */
+class MetadataColumns {
+ public:
+  static constexpr char kPodIDColumn[] = "pod_id";
+  static constexpr char kServiceIDColumn[] = "service_id";
+
+  using AgentMetadataFn = std::function<std::shared_ptr<const md::AgentMetadataState>()>;
+
+  /**
+   * @param tables Comma separated names of the tables to add the columns to.
+   * @param agent_metadata_fn Returns the current agent metadata.
+   */
+  MetadataColumns(std::string_view tables, AgentMetadataFn agent_metadata_fn);
+
+  /**
+   * Adds the columns to the relation, if the table is one of the selected ones.
+   * @return true if the columns were added.
+   */
+  bool AddColumns(uint64_t table_id, const std::string& table_name,
+                  table_store::schema::Relation* relation);
+
+  /**
+   * Appends the values of the columns to the record batch, if they were added to its table.
+   */
+  void Populate(uint64_t table_id, types::ColumnWrapperRecordBatch* record_batch);
+
+ private:
+  const absl::flat_hash_set<std::string> tables_;
+  const AgentMetadataFn agent_metadata_fn_;
+
+  // The index of the upid column of each table that has the columns.
+  absl::flat_hash_map<uint64_t, size_t> upid_col_idx_by_table_;
+
+  absl::Mutex mutex_;
+
+  // The UDFs memoize their results for the metadata state of the function context. Holding on to
+  // the context keeps that state alive, so a newer state can't have the same address.
+  std::unique_ptr<carnot::udf::FunctionContext> function_ctx_ ABSL_GUARDED_BY(mutex_);
+  carnot::funcs::metadata::UPIDToPodIDUDF pod_id_udf_ ABSL_GUARDED_BY(mutex_);
+  carnot::funcs::metadata::UPIDToServiceIDUDF service_id_udf_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <utility>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/k8s/metadatapb/test_proto.h"
+#include "src/shared/metadata/state_manager.h"
+#include "src/shared/metadata/test_utils.h"
+#include "src/vizier/services/agent/pem/metadata_columns.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using ResourceUpdate = px::shared::k8s::metadatapb::ResourceUpdate;
+using table_store::schema::Relation;
+
+class MetadataColumnsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    metadata_state_ = std::make_shared<md::AgentMetadataState>(/* hostname */ "myhost",
+                                                               /* asid */ 1, sole::uuid4(), "mypod");
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+    updates.enqueue(px::metadatapb::testutils::CreateRunningContainerUpdatePB());
+    updates.enqueue(px::metadatapb::testutils::CreateRunningPodUpdatePB());
+    updates.enqueue(px::metadatapb::testutils::CreateRunningServiceUpdatePB());
+    ASSERT_OK(px::md::ApplyK8sUpdates(10, metadata_state_.get(), &md_filter_, &updates));
+
+    md::UPID upid(123, 567, 89101);
+    metadata_state_->AddUPID(upid, std::make_unique<md::PIDInfo>(upid, "test", "pod1_container_1"));
+  }
+
+  std::shared_ptr<md::AgentMetadataState> metadata_state_;
+  md::TestAgentMetadataFilter md_filter_;
+};
+
+TEST_F(MetadataColumnsTest, AddsAndPopulatesColumns) {
+  MetadataColumns metadata_columns("http_events, other_table",
+                                   [this]() { return metadata_state_; });
+
+  Relation relation({types::TIME64NS, types::UINT128}, {"time_", "upid"});
+  ASSERT_TRUE(metadata_columns.AddColumns(1, "http_events", &relation));
+  EXPECT_THAT(relation.col_names(), ::testing::ElementsAre("time_", "upid", "pod_id", "service_id"));
+
+  // Tables that weren't selected, or have no upid, are left as is.
+  Relation unselected({types::TIME64NS, types::UINT128}, {"time_", "upid"});
+  EXPECT_FALSE(metadata_columns.AddColumns(2, "conn_stats", &unselected));
+  Relation no_upid({types::TIME64NS}, {"time_"});
+  EXPECT_FALSE(metadata_columns.AddColumns(3, "other_table", &no_upid));
+  EXPECT_EQ(1, no_upid.NumColumns());
+
+  types::ColumnWrapperRecordBatch record_batch;
+  auto times = types::ColumnWrapper::Make(types::TIME64NS, 3);
+  auto upids = types::ColumnWrapper::Make(types::UINT128, 3);
+  auto* upid_values = static_cast<types::UInt128Value*>(upids->UnsafeRawData());
+  upid_values[0] = types::UInt128Value(528280977975, 89101);
+  upid_values[1] = types::UInt128Value(528280977975, 123);
+  upid_values[2] = types::UInt128Value(528280977975, 89101);
+  record_batch.push_back(times);
+  record_batch.push_back(upids);
+
+  metadata_columns.Populate(1, &record_batch);
+  ASSERT_EQ(4, record_batch.size());
+  EXPECT_EQ("1_uid", record_batch[2]->Get<types::StringValue>(0));
+  EXPECT_EQ("", record_batch[2]->Get<types::StringValue>(1));
+  EXPECT_EQ("1_uid", record_batch[2]->Get<types::StringValue>(2));
+  EXPECT_EQ("3_uid", record_batch[3]->Get<types::StringValue>(0));
+  EXPECT_EQ("", record_batch[3]->Get<types::StringValue>(1));
+
+  // Batches of other tables are left as is.
+  types::ColumnWrapperRecordBatch other_batch = {types::ColumnWrapper::Make(types::TIME64NS, 1)};
+  metadata_columns.Populate(2, &other_batch);
+  EXPECT_EQ(1, other_batch.size());
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -18,9 +18,13 @@
 
 #include "src/vizier/services/agent/pem/pem_manager.h"
 
+#include <absl/time/time.h>
+
 #include "src/common/system/config.h"
+#include "src/table_store/table/table_snapshot.h"
 #include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/pem/stirling_config.h"
 
 DEFINE_int32(
     table_store_data_limit, gflags::Int32FromEnv("PL_TABLE_STORE_DATA_LIMIT_MB", 1024 + 256),
@@ -44,9 +48,15 @@ Status PEMManager::InitImpl() {
 }
 
 Status PEMManager::PostRegisterHookImpl() {
-  stirling_->RegisterDataPushCallback(std::bind(&table_store::TableStore::AppendData, table_store(),
-                                                std::placeholders::_1, std::placeholders::_2,
-                                                std::placeholders::_3));
+  metadata_columns_ = std::make_unique<MetadataColumns>(
+      FLAGS_table_store_metadata_columns,
+      std::bind(&px::md::AgentMetadataStateManager::CurrentAgentMetadataState, mds_manager()));
+  stirling_->RegisterDataPushCallback(
+      [this](uint64_t table_id, types::TabletID tablet_id,
+             std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+        metadata_columns_->Populate(table_id, record_batch.get());
+        return table_store()->AppendData(table_id, tablet_id, std::move(record_batch));
+      });
 
   // Enable use of USR1/USR2 for controlling Stirling debug.
   stirling_->RegisterUserDebugSignalHandlers();
@@ -56,6 +66,7 @@ Status PEMManager::PostRegisterHookImpl() {
       std::bind(&px::md::AgentMetadataStateManager::CurrentAgentMetadataState, mds_manager()));
 
   PL_RETURN_IF_ERROR(InitSchemas());
+  PL_RETURN_IF_ERROR(ConfigureStirling(stirling_.get()));
   PL_RETURN_IF_ERROR(stirling_->RunAsThread());
 
   auto execute_query_handler = std::make_shared<ExecuteQueryMessageHandler>(
@@ -73,6 +84,15 @@ Status PEMManager::PostRegisterHookImpl() {
 
 Status PEMManager::StopImpl(std::chrono::milliseconds) {
   stirling_->Stop();
+  if (!FLAGS_table_store_snapshot_dir.empty()) {
+    // Stirling is stopped, so the snapshot holds every row written to the tables.
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(FLAGS_table_store_snapshot_timeout_ms);
+    PL_ASSIGN_OR_RETURN(int64_t num_rows,
+                        table_store()->WriteSnapshot(FLAGS_table_store_snapshot_dir, deadline,
+                                                     arrow::default_memory_pool()));
+    LOG(INFO) << absl::Substitute("Wrote $0 rows to the table snapshot.", num_rows);
+  }
   return Status::OK();
 }
 
@@ -86,7 +106,12 @@ Status PEMManager::InitSchemas() {
   int64_t http_table_size = (FLAGS_table_store_http_events_percent * memory_limit) / 100;
   int64_t other_table_size = (memory_limit - http_table_size) / (num_tables - 1);
 
-  for (const auto& relation_info : relation_info_vec) {
+  for (auto& relation_info : relation_info_vec) {
+    if (metadata_columns_->AddColumns(relation_info.id, relation_info.name,
+                                      &relation_info.relation)) {
+      LOG(INFO) << absl::Substitute("Added metadata columns to table $0.", relation_info.name);
+    }
+
     std::shared_ptr<table_store::Table> table_ptr;
     if (relation_info.name == "http_events") {
       // Special case to set the max size of the http_events table differently from the other
@@ -100,11 +125,58 @@ Status PEMManager::InitSchemas() {
     }
 
     table_store()->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
+    if (relation_info.tabletized) {
+      PL_RETURN_IF_ERROR(table_store()->SetTabletizationKey(
+          relation_info.name, static_cast<int64_t>(relation_info.tabletization_key_idx)));
+    }
     PL_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(relation_info));
   }
+  PL_ASSIGN_OR_RETURN(auto rollups, InitTableRollups());
+
+  if (!FLAGS_table_store_snapshot_dir.empty()) {
+    // The agent runs without the old data if the snapshot can't be restored.
+    auto rows_or = table_store()->RestoreSnapshot(FLAGS_table_store_snapshot_dir);
+    if (rows_or.ok()) {
+      LOG(INFO) << absl::Substitute("Restored $0 rows from the table snapshot.",
+                                    rows_or.ValueOrDie());
+    } else {
+      LOG(ERROR) << "Failed to restore the table snapshot: " << rows_or.msg();
+    }
+  }
+  for (auto& rollup : rollups) {
+    rollup->ResumeFrom(*table_store());
+    AddTableRollup(std::move(rollup));
+  }
   return Status::OK();
 }
 
+StatusOr<std::vector<std::unique_ptr<carnot::TableRollup>>> PEMManager::InitTableRollups() {
+  std::vector<std::unique_ptr<carnot::TableRollup>> rollups;
+  PL_ASSIGN_OR_RETURN(auto specs, carnot::ParseRollupSpecs(FLAGS_table_store_rollups));
+  for (size_t i = 0; i < specs.size(); ++i) {
+    auto& spec = specs[i];
+    table_store::Table* source = table_store()->GetTable(spec.source_table);
+    if (source == nullptr) {
+      LOG(WARNING) << absl::Substitute("Skipping rollup table $0, table $1 doesn't exist.",
+                                       spec.rollup_table, spec.source_table);
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(auto rollup, carnot::TableRollup::Create(spec, source->GetRelation()));
+    uint64_t id = kTableRollupIDOffset + i;
+    auto desc = absl::Substitute("The $0 bins of $1, see --table_store_rollups.",
+                                 absl::FormatDuration(absl::Nanoseconds(spec.bin_ns)),
+                                 spec.source_table);
+    table_store()->AddTable(table_store::Table::Create(spec.rollup_table, rollup->relation()),
+                            spec.rollup_table, id);
+    PL_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(
+        RelationInfo(spec.rollup_table, id, desc, rollup->relation())));
+    LOG(INFO) << absl::Substitute("Added rollup table $0 of table $1.", spec.rollup_table,
+                                  spec.source_table);
+    rollups.push_back(std::move(rollup));
+  }
+  return rollups;
+}
+
 Status PEMManager::InitClockConverters() {
   clock_converter_timer_ = dispatcher()->CreateTimer([this]() {
     auto clock_converter = px::system::Config::GetInstance().clock_converter();
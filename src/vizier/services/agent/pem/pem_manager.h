@@ -21,9 +21,11 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "src/stirling/stirling.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/pem/metadata_columns.h"
 #include "src/vizier/services/agent/pem/tracepoint_manager.h"
 
 namespace px {
@@ -63,6 +65,7 @@ class PEMManager : public Manager {
 
  private:
   Status InitSchemas();
+  StatusOr<std::vector<std::unique_ptr<carnot::TableRollup>>> InitTableRollups();
   Status InitClockConverters();
   static services::shared::agent::AgentCapabilities Capabilities() {
     services::shared::agent::AgentCapabilities capabilities;
@@ -70,8 +73,12 @@ class PEMManager : public Manager {
     return capabilities;
   }
 
+  // The table IDs of the rollup tables start here, past the IDs of the tables of Stirling.
+  static constexpr uint64_t kTableRollupIDOffset = 1ULL << 32;
+
   std::unique_ptr<stirling::Stirling> stirling_;
   std::shared_ptr<TracepointManager> tracepoint_manager_;
+  std::unique_ptr<MetadataColumns> metadata_columns_;
 
   // Timer for triggering ClockConverter polls.
   px::event::TimerUPtr clock_converter_timer_;
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/stirling_config.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/substitute.h>
+#include <absl/strings/strip.h>
+
+DEFINE_string(stirling_filter_http_path_prefixes,
+              gflags::StringFromEnv("PL_STIRLING_FILTER_HTTP_PATH_PREFIXES", ""),
+              "Comma separated request path prefixes of the HTTP records that aren't collected, "
+              "like the paths of health checks and readiness probes.");
+DEFINE_string(stirling_filter_http_resp_statuses,
+              gflags::StringFromEnv("PL_STIRLING_FILTER_HTTP_RESP_STATUSES", ""),
+              "Comma separated response status codes of the HTTP records that aren't collected.");
+DEFINE_string(stirling_filter_namespaces,
+              gflags::StringFromEnv("PL_STIRLING_FILTER_NAMESPACES", ""),
+              "Comma separated K8s namespaces whose traffic isn't traced.");
+DEFINE_string(stirling_subscribed_columns,
+              gflags::StringFromEnv("PL_STIRLING_SUBSCRIBED_COLUMNS", ""),
+              "Comma separated table.column names of the string columns that are collected, like "
+              "http_events.req_path. The other string columns of the tables that have one of them "
+              "are left empty, and tables without any are collected in full.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+std::vector<std::string_view> SplitList(std::string_view list) {
+  std::vector<std::string_view> items;
+  for (std::string_view item : absl::StrSplit(list, ',', absl::SkipWhitespace())) {
+    items.push_back(absl::StripAsciiWhitespace(item));
+  }
+  return items;
+}
+
+}  // namespace
+
+StatusOr<stirling::SocketTraceFilter> ParseSocketTraceFilter(std::string_view http_path_prefixes,
+                                                             std::string_view http_resp_statuses,
+                                                             std::string_view namespaces) {
+  stirling::SocketTraceFilter filter;
+  for (std::string_view prefix : SplitList(http_path_prefixes)) {
+    filter.http_path_prefixes.emplace_back(prefix);
+  }
+  for (std::string_view status_str : SplitList(http_resp_statuses)) {
+    int status;
+    if (!absl::SimpleAtoi(status_str, &status)) {
+      return error::InvalidArgument("HTTP response status '$0' isn't a number.", status_str);
+    }
+    filter.http_resp_statuses.insert(status);
+  }
+  for (std::string_view ns : SplitList(namespaces)) {
+    filter.namespaces.emplace(ns);
+  }
+  return filter;
+}
+
+StatusOr<absl::flat_hash_map<std::string, std::vector<std::string>>> ParseSubscribedColumns(
+    std::string_view columns) {
+  absl::flat_hash_map<std::string, std::vector<std::string>> columns_by_table;
+  for (std::string_view name : SplitList(columns)) {
+    std::pair<std::string_view, std::string_view> table_and_column =
+        absl::StrSplit(name, absl::MaxSplits('.', 1));
+    if (table_and_column.first.empty() || table_and_column.second.empty()) {
+      return error::InvalidArgument("Column '$0' isn't of the form table.column.", name);
+    }
+    columns_by_table[table_and_column.first].emplace_back(table_and_column.second);
+  }
+  return columns_by_table;
+}
+
+Status ConfigureStirling(stirling::Stirling* stirling) {
+  PL_ASSIGN_OR_RETURN(stirling::SocketTraceFilter filter,
+                      ParseSocketTraceFilter(FLAGS_stirling_filter_http_path_prefixes,
+                                             FLAGS_stirling_filter_http_resp_statuses,
+                                             FLAGS_stirling_filter_namespaces));
+  if (!filter.empty()) {
+    // Without the socket tracer there's simply nothing to filter.
+    Status s = stirling->SetSocketTraceFilter(filter);
+    if (!s.ok()) {
+      LOG(WARNING) << "Not filtering the traced data: " << s.msg();
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(auto columns_by_table,
+                      ParseSubscribedColumns(FLAGS_stirling_subscribed_columns));
+  for (const auto& [table_name, column_names] : columns_by_table) {
+    // The tables of disabled sources don't exist, so those are skipped like the filter is.
+    Status s = stirling->SetSubscribedColumns(table_name, column_names);
+    if (!s.ok()) {
+      LOG(WARNING) << absl::Substitute("Collecting all columns of $0: $1", table_name, s.msg());
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
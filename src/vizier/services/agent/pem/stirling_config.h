@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/stirling.h"
+
+DECLARE_string(stirling_filter_http_path_prefixes);
+DECLARE_string(stirling_filter_http_resp_statuses);
+DECLARE_string(stirling_filter_namespaces);
+DECLARE_string(stirling_subscribed_columns);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * Builds the filter of the socket tracer from comma separated lists, as in the
+ * --stirling_filter_* flags.
+ *
+ * @return error::InvalidArgument if one of the statuses isn't a number.
+ */
+StatusOr<stirling::SocketTraceFilter> ParseSocketTraceFilter(std::string_view http_path_prefixes,
+                                                             std::string_view http_resp_statuses,
+                                                             std::string_view namespaces);
+
+/**
+ * Groups comma separated table.column names, as in --stirling_subscribed_columns, by table.
+ *
+ * @return error::InvalidArgument if one of the names has no table or no column.
+ */
+StatusOr<absl::flat_hash_map<std::string, std::vector<std::string>>> ParseSubscribedColumns(
+    std::string_view columns);
+
+/**
+ * Applies the --stirling_filter_* and --stirling_subscribed_columns flags to Stirling.
+ */
+Status ConfigureStirling(stirling::Stirling* stirling);
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/testing/stirling_mock.h"
+#include "src/vizier/services/agent/pem/stirling_config.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Field;
+using ::testing::Return;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(ParseSocketTraceFilterTest, ParsesLists) {
+  ASSERT_OK_AND_ASSIGN(stirling::SocketTraceFilter filter,
+                       ParseSocketTraceFilter("/healthz, /readyz", "404,503", "kube-system"));
+  EXPECT_THAT(filter.http_path_prefixes, ElementsAre("/healthz", "/readyz"));
+  EXPECT_THAT(filter.http_resp_statuses, UnorderedElementsAre(404, 503));
+  EXPECT_THAT(filter.namespaces, UnorderedElementsAre("kube-system"));
+  EXPECT_TRUE(filter.upids.empty());
+}
+
+TEST(ParseSocketTraceFilterTest, EmptyLists) {
+  ASSERT_OK_AND_ASSIGN(stirling::SocketTraceFilter filter, ParseSocketTraceFilter("", "", ""));
+  EXPECT_TRUE(filter.empty());
+}
+
+TEST(ParseSocketTraceFilterTest, RejectsBadStatus) {
+  EXPECT_NOT_OK(ParseSocketTraceFilter("", "404,ok", ""));
+}
+
+TEST(ParseSubscribedColumnsTest, GroupsColumnsByTable) {
+  ASSERT_OK_AND_ASSIGN(auto columns_by_table,
+                       ParseSubscribedColumns("http_events.req_path, http_events.resp_body, "
+                                              "mysql_events.req_body"));
+  EXPECT_THAT(columns_by_table,
+              UnorderedElementsAre(Pair("http_events", ElementsAre("req_path", "resp_body")),
+                                   Pair("mysql_events", ElementsAre("req_body"))));
+}
+
+TEST(ParseSubscribedColumnsTest, RejectsNamesWithoutTable) {
+  EXPECT_NOT_OK(ParseSubscribedColumns("req_path"));
+  EXPECT_NOT_OK(ParseSubscribedColumns(".req_path"));
+  EXPECT_NOT_OK(ParseSubscribedColumns("http_events."));
+}
+
+TEST(ConfigureStirlingTest, SetsFilterFromFlags) {
+  gflags::FlagSaver flag_saver;
+  FLAGS_stirling_filter_http_path_prefixes = "/healthz";
+  stirling::MockStirling stirling;
+  EXPECT_CALL(stirling, SetSocketTraceFilter(Field(&stirling::SocketTraceFilter::http_path_prefixes,
+                                                   ElementsAre("/healthz"))))
+      .WillOnce(Return(Status::OK()));
+  EXPECT_OK(ConfigureStirling(&stirling));
+}
+
+TEST(ConfigureStirlingTest, SetsSubscribedColumnsFromFlags) {
+  gflags::FlagSaver flag_saver;
+  FLAGS_stirling_subscribed_columns = "http_events.req_path";
+  stirling::MockStirling stirling;
+  EXPECT_CALL(stirling, SetSubscribedColumns(Eq("http_events"), ElementsAre("req_path")))
+      .WillOnce(Return(Status::OK()));
+  EXPECT_OK(ConfigureStirling(&stirling));
+}
+
+TEST(ConfigureStirlingTest, LeavesStirlingAloneByDefault) {
+  stirling::MockStirling stirling;
+  EXPECT_CALL(stirling, SetSocketTraceFilter(_)).Times(0);
+  EXPECT_CALL(stirling, SetSubscribedColumns(_, _)).Times(0);
+  EXPECT_OK(ConfigureStirling(&stirling));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -325,11 +325,16 @@ func (m *ManagerImpl) updateAgentDataInfoWrapper(agentID uuid.UUID, agentDataInf
 	// update may be missed by the agent tracker when reading the initial agent state.
 	// We cannot lock the entire call to `updateAgentDataInfoWrapper`, which would allow for perfect consistency,
 	// since the update to the metadata store may hit the network.
-	err := m.agtStore.UpdateAgentDataInfo(agentID, agentDataInfo)
-
-	if err != nil {
-		log.WithError(err).Warnf("Failed to update agent data info for agent %s", agentID.String())
-		return err
+	// The table time ranges and the load change with every heartbeat, so only the metadata info is
+	// persisted and the rest is just passed on to the agent update trackers.
+	if agentDataInfo.MetadataInfo != nil {
+		err := m.agtStore.UpdateAgentDataInfo(agentID, &messagespb.AgentDataInfo{
+			MetadataInfo: agentDataInfo.MetadataInfo,
+		})
+		if err != nil {
+			log.WithError(err).Warnf("Failed to update agent data info for agent %s", agentID.String())
+			return err
+		}
 	}
 
 	m.agentUpdateTrackersMutex.Lock()
@@ -380,7 +385,53 @@ func (m *ManagerImpl) ApplyAgentUpdate(update *Update) error {
 	if !update.UpdateInfo.DoesUpdateSchema {
 		return nil
 	}
-	return m.updateAgentSchemaWrapper(update.AgentID, update.UpdateInfo.Schema)
+	schema := update.UpdateInfo.Schema
+	if update.UpdateInfo.SchemaBaseVersion != 0 {
+		schema, err = m.applySchemaDelta(update.AgentID, update.UpdateInfo.Schema, update.UpdateInfo.RemovedSchema)
+		if err != nil {
+			return err
+		}
+	}
+	return m.updateAgentSchemaWrapper(update.AgentID, schema)
+}
+
+// applySchemaDelta returns the full schema of the agent after the tables of a schema delta were added and removed.
+func (m *ManagerImpl) applySchemaDelta(agentID uuid.UUID, added []*storepb.TableInfo, removed []string) ([]*storepb.TableInfo, error) {
+	computedSchema, err := m.agtStore.GetComputedSchema()
+	if err != nil && err != ErrNoComputedSchemas {
+		log.WithError(err).Error("Could not get old schema.")
+		return nil, err
+	}
+
+	// The tables of the delta replace the ones with the same names.
+	skip := make(map[string]bool)
+	for _, name := range removed {
+		skip[name] = true
+	}
+	for _, table := range added {
+		skip[table.Name] = true
+	}
+
+	schema := append([]*storepb.TableInfo{}, added...)
+	agentIDPb := utils.ProtoFromUUID(agentID)
+	if computedSchema != nil {
+		for _, table := range computedSchema.Tables {
+			if skip[table.Name] {
+				continue
+			}
+			agents, present := computedSchema.TableNameToAgentIDs[table.Name]
+			if !present {
+				continue
+			}
+			for _, agt := range agents.AgentID {
+				if agt.Equal(agentIDPb) {
+					schema = append(schema, table)
+					break
+				}
+			}
+		}
+	}
+	return schema, nil
 }
 
 func (m *ManagerImpl) handleCreatedProcesses(processes []*metadatapb.ProcessCreated) error {
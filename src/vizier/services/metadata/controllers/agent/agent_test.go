@@ -421,6 +421,81 @@ func TestApplyUpdates(t *testing.T) {
 	dataInfo, present := dataInfos[u]
 	assert.True(t, present)
 	assert.Equal(t, dataInfo, expectedDataInfo)
+
+	// A heartbeat that only carries table time ranges should leave the stored metadata info alone.
+	heartbeatUpdate := agent.Update{
+		UpdateInfo: &messagespb.AgentUpdateInfo{
+			Data: &messagespb.AgentDataInfo{
+				TableInfo: []*distributedpb.TableInfo{
+					{
+						Table: "a_table",
+						TimeRange: &distributedpb.TimeRange{
+							MinTimeNS: 10,
+							MaxTimeNS: 20,
+						},
+					},
+				},
+			},
+		},
+		AgentID: u,
+	}
+	err = agtMgr.ApplyAgentUpdate(&heartbeatUpdate)
+	require.NoError(t, err)
+
+	dataInfos, err = ads.GetAgentsDataInfo()
+	require.NoError(t, err)
+	assert.Equal(t, expectedDataInfo, dataInfos[u])
+}
+
+func TestApplyUpdatesSchemaDelta(t *testing.T) {
+	ads, agtMgr, _, cleanup := setupManager(t)
+	defer cleanup()
+
+	u, err := uuid.FromString(testutils.ExistingAgentUUID)
+	require.NoError(t, err)
+
+	var tables []*storepb.TableInfo
+	for _, pb := range []string{testutils.SchemaInfoPB, testutils.SchemaInfo2PB, testutils.SchemaInfo3PB} {
+		table := new(storepb.TableInfo)
+		require.NoError(t, proto.UnmarshalText(pb, table))
+		tables = append(tables, table)
+	}
+
+	// The full schema has a_table and b_table.
+	err = agtMgr.ApplyAgentUpdate(&agent.Update{
+		UpdateInfo: &messagespb.AgentUpdateInfo{
+			Schema:           tables[:2],
+			DoesUpdateSchema: true,
+			SchemaVersion:    2,
+		},
+		AgentID: u,
+	})
+	require.NoError(t, err)
+
+	// The delta removes a_table and adds c_table.
+	err = agtMgr.ApplyAgentUpdate(&agent.Update{
+		UpdateInfo: &messagespb.AgentUpdateInfo{
+			Schema:            tables[2:],
+			RemovedSchema:     []string{"a_table"},
+			DoesUpdateSchema:  true,
+			SchemaVersion:     4,
+			SchemaBaseVersion: 2,
+		},
+		AgentID: u,
+	})
+	require.NoError(t, err)
+
+	computedSchema, err := ads.GetComputedSchema()
+	require.NoError(t, err)
+	var agentTables []string
+	for name, agents := range computedSchema.TableNameToAgentIDs {
+		for _, agentID := range agents.AgentID {
+			if utils.UUIDFromProtoOrNil(agentID) == u {
+				agentTables = append(agentTables, name)
+			}
+		}
+	}
+	assert.ElementsMatch(t, []string{"b_table", "c_table"}, agentTables)
 }
 
 func TestApplyUpdatesDeleted(t *testing.T) {
@@ -94,6 +94,10 @@ type AgentHandler struct {
 	tpMgr  *tracepoint.Manager
 	atl    *AgentTopicListener
 
+	// The version of the agent's schema that was applied, which the heartbeat acks carry so that the agent
+	// only sends the changes to it.
+	schemaVersion int64
+
 	MsgChannel chan *nats.Msg
 	quitCh     chan struct{}
 
@@ -364,6 +368,8 @@ func (ah *AgentHandler) onAgentRegisterRequest(m *messagespb.RegisterAgentReques
 	// Create RegisterAgentResponse.
 	agentID := ah.id
 	log.WithField("agent", agentID.String()).Infof("Received AgentRegisterRequest for agent")
+	// The agent sends its full schema again once it's registered.
+	ah.schemaVersion = 0
 
 	// Delete agent with same hostname, if any.
 	hostname := ""
@@ -466,6 +472,7 @@ func (ah *AgentHandler) onAgentHeartbeat(m *messagespb.Heartbeat) {
 					PodCIDRs:    ah.agtMgr.GetPodCIDRs(),
 				},
 				SequenceNumber: m.SequenceNumber,
+				SchemaVersion:  ah.schemaVersion,
 			},
 		},
 	}
@@ -480,6 +487,11 @@ func (ah *AgentHandler) onAgentHeartbeat(m *messagespb.Heartbeat) {
 		err = ah.agtMgr.ApplyAgentUpdate(&agent.Update{AgentID: agentID, UpdateInfo: m.UpdateInfo})
 		if err != nil {
 			log.WithError(err).Error("Could not apply agent updates")
+			return
+		}
+		if m.UpdateInfo.DoesUpdateSchema {
+			// Acked with the next heartbeat, since this one was acked before its updates were applied.
+			ah.schemaVersion = m.UpdateInfo.SchemaVersion
 		}
 	}
 }
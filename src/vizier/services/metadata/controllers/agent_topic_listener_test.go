@@ -455,6 +455,59 @@ func TestAgentHeartbeat(t *testing.T) {
 	require.NoError(t, err)
 }
 
+func TestAgentHeartbeat_AcksSchemaVersion(t *testing.T) {
+	agentID := uuid.FromStringOrNil(testutils.UnhealthyKelvinAgentUUID)
+	makeHeartbeat := func(seq int64, updateInfo *messagespb.AgentUpdateInfo) *nats.Msg {
+		req := &messagespb.VizierMessage{
+			Msg: &messagespb.VizierMessage_Heartbeat{
+				Heartbeat: &messagespb.Heartbeat{
+					AgentID:        utils.ProtoFromUUID(agentID),
+					SequenceNumber: seq,
+					UpdateInfo:     updateInfo,
+				},
+			},
+		}
+		reqPb, err := req.Marshal()
+		require.NoError(t, err)
+		return &nats.Msg{Data: reqPb}
+	}
+
+	var wg sync.WaitGroup
+	var ackedVersions []int64
+	atl, mockAgtMgr, _, cleanup := setup(t, func(topic string, b []byte) error {
+		msg := messagespb.VizierMessage{}
+		if err := proto.Unmarshal(b, &msg); err != nil {
+			t.Fatal("Cannot Unmarshal protobuf.")
+		}
+		ackedVersions = append(ackedVersions, msg.GetHeartbeatAck().SchemaVersion)
+		wg.Done()
+		return nil
+	})
+	defer cleanup()
+
+	mockAgtMgr.EXPECT().GetServiceCIDR().Return("10.64.4.0/22").Times(2)
+	mockAgtMgr.EXPECT().GetPodCIDRs().Return([]string{"10.64.4.0/21"}).Times(2)
+	mockAgtMgr.EXPECT().UpdateHeartbeat(agentID).Return(nil).Times(2)
+	mockAgtMgr.EXPECT().ApplyAgentUpdate(gomock.Any()).DoAndReturn(func(*agent.Update) error {
+		wg.Done()
+		return nil
+	}).Times(2)
+
+	// Two acks and two applied updates.
+	wg.Add(4)
+	// The first heartbeat is acked before its schema is applied, so only the next ack carries its version.
+	err := atl.HandleMessage(makeHeartbeat(0, &messagespb.AgentUpdateInfo{
+		DoesUpdateSchema: true,
+		SchemaVersion:    5,
+	}))
+	require.NoError(t, err)
+	err = atl.HandleMessage(makeHeartbeat(1, &messagespb.AgentUpdateInfo{}))
+	require.NoError(t, err)
+	wg.Wait()
+
+	assert.Equal(t, []int64{0, 5}, ackedVersions)
+}
+
 func TestAgentHeartbeat_Failed(t *testing.T) {
 	sendMsg := assertSendMessageCalledWith(t, "Agent/"+testutils.UnhealthyKelvinAgentUUID,
 		messagespb.VizierMessage{
@@ -25,6 +25,7 @@ import (
 	"px.dev/pixie/src/vizier/services/metadata/controllers/agent"
 	"px.dev/pixie/src/vizier/services/metadata/controllers/k8smeta"
 	"px.dev/pixie/src/vizier/services/metadata/controllers/tracepoint"
+	"px.dev/pixie/src/vizier/utils/messagebus"
 )
 
 const updateAgentTopic = "UpdateAgent"
@@ -99,16 +100,34 @@ func (mc *MessageBusController) handleMessages() {
 		}
 
 		if tl, ok := mc.listeners[msg.Subject]; ok {
-			err := tl.HandleMessage(msg)
-			if err != nil {
-				log.WithError(err).Error("Error handling NATs message")
-			}
+			mc.handleTopicMessage(tl, msg)
 			continue
 		}
 		log.WithField("topic", msg.Subject).Info("No registered message bus listener")
 	}
 }
 
+// handleTopicMessage passes every message that the NATS message holds to the listener, since
+// agents may coalesce several messages into one, or compress them.
+func (mc *MessageBusController) handleTopicMessage(tl TopicListener, msg *nats.Msg) {
+	datas, err := messagebus.DecodeEnvelope(msg.Data)
+	if err != nil {
+		log.WithError(err).Error("Failed to decode NATs message")
+		return
+	}
+
+	for _, data := range datas {
+		m := msg
+		if len(datas) > 1 || len(data) != len(msg.Data) {
+			m = &nats.Msg{Subject: msg.Subject, Reply: msg.Reply, Data: data, Sub: msg.Sub}
+		}
+		err := tl.HandleMessage(m)
+		if err != nil {
+			log.WithError(err).Error("Error handling NATs message")
+		}
+	}
+}
+
 func (mc *MessageBusController) registerListeners(agtMgr agent.Manager, tpMgr *tracepoint.Manager, k8smetaHandler *k8smeta.Handler) error {
 	// Register AgentTopicListener.
 	atl, err := NewAgentTopicListener(agtMgr, tpMgr, mc.sendMessage)
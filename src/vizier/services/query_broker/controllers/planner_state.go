@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package controllers
+
+import (
+	"sync"
+
+	"github.com/gogo/protobuf/proto"
+	"google.golang.org/grpc/codes"
+	"google.golang.org/grpc/status"
+
+	"px.dev/pixie/src/carnot/planner/distributedpb"
+)
+
+// PlannerStateSyncer keeps the distributed state that is stored in the planner up to date with the one of the
+// agents tracker. Only the Carnot instances and schemas that changed are passed to the planner, so that queries
+// don't have to carry the whole state.
+type PlannerStateSyncer struct {
+	planner       Planner
+	agentsTracker AgentsTracker
+
+	mu sync.Mutex
+	// A copy of the state that was last passed to the planner, nil if the planner doesn't have one.
+	// The tracker updates its Carnot instances in place, so this can't share them.
+	synced *distributedpb.DistributedState
+}
+
+// NewPlannerStateSyncer creates a PlannerStateSyncer.
+func NewPlannerStateSyncer(planner Planner, agentsTracker AgentsTracker) *PlannerStateSyncer {
+	return &PlannerStateSyncer{
+		planner:       planner,
+		agentsTracker: agentsTracker,
+	}
+}
+
+// Sync passes the changes to the distributed state of the agents tracker since the last call on to the planner.
+func (s *PlannerStateSyncer) Sync() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	// The state is read while holding the lock, so that the stored state never goes back to an older one.
+	info := s.agentsTracker.GetAgentInfo()
+	if info == nil {
+		return status.Error(codes.Unavailable, "not ready yet")
+	}
+	ds := info.DistributedState()
+
+	if s.synced == nil {
+		if err := s.planner.SetDistributedState(&ds); err != nil {
+			return err
+		}
+		s.synced = proto.Clone(&ds).(*distributedpb.DistributedState)
+		return nil
+	}
+
+	upserts, removals := distributedStateDelta(s.synced, &ds)
+	if len(upserts.CarnotInfo) == 0 && len(upserts.SchemaInfo) == 0 &&
+		len(removals.CarnotInfo) == 0 && len(removals.SchemaInfo) == 0 {
+		return nil
+	}
+	if err := s.planner.UpdateDistributedState(upserts, removals); err != nil {
+		// Pass the whole state on the next call, rather than guessing what the planner has.
+		s.synced = nil
+		return err
+	}
+	s.synced = proto.Clone(&ds).(*distributedpb.DistributedState)
+	return nil
+}
+
+// distributedStateDelta returns the Carnot instances and schemas that were added or changed from the old state to
+// the new one, and those that were removed, keyed by query broker address and table name like the planner does.
+func distributedStateDelta(oldState, newState *distributedpb.DistributedState) (*distributedpb.DistributedState, *distributedpb.DistributedState) {
+	upserts := &distributedpb.DistributedState{}
+	removals := &distributedpb.DistributedState{}
+
+	oldCarnots := make(map[string]*distributedpb.CarnotInfo)
+	for _, carnotInfo := range oldState.CarnotInfo {
+		oldCarnots[carnotInfo.QueryBrokerAddress] = carnotInfo
+	}
+	for _, carnotInfo := range newState.CarnotInfo {
+		if oldInfo, present := oldCarnots[carnotInfo.QueryBrokerAddress]; !present || !oldInfo.Equal(carnotInfo) {
+			upserts.CarnotInfo = append(upserts.CarnotInfo, carnotInfo)
+		}
+		delete(oldCarnots, carnotInfo.QueryBrokerAddress)
+	}
+	for addr := range oldCarnots {
+		removals.CarnotInfo = append(removals.CarnotInfo, &distributedpb.CarnotInfo{QueryBrokerAddress: addr})
+	}
+
+	oldSchemas := make(map[string]*distributedpb.SchemaInfo)
+	for _, schemaInfo := range oldState.SchemaInfo {
+		oldSchemas[schemaInfo.Name] = schemaInfo
+	}
+	for _, schemaInfo := range newState.SchemaInfo {
+		if oldInfo, present := oldSchemas[schemaInfo.Name]; !present || !oldInfo.Equal(schemaInfo) {
+			upserts.SchemaInfo = append(upserts.SchemaInfo, schemaInfo)
+		}
+		delete(oldSchemas, schemaInfo.Name)
+	}
+	for name := range oldSchemas {
+		removals.SchemaInfo = append(removals.SchemaInfo, &distributedpb.SchemaInfo{Name: name})
+	}
+	return upserts, removals
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package controllers_test
+
+import (
+	"errors"
+	"testing"
+
+	"github.com/gogo/protobuf/proto"
+	"github.com/golang/mock/gomock"
+	"github.com/stretchr/testify/require"
+
+	"px.dev/pixie/src/carnot/planner/distributedpb"
+	"px.dev/pixie/src/vizier/services/query_broker/controllers"
+	mock_controllers "px.dev/pixie/src/vizier/services/query_broker/controllers/mock"
+	"px.dev/pixie/src/vizier/services/query_broker/tracker"
+)
+
+const syncerDistributedState = `
+carnot_info: {
+	query_broker_address: "agent1"
+	asid: 123
+}
+carnot_info: {
+	query_broker_address: "agent2"
+	asid: 456
+}
+schema_info: {
+	name: "table1"
+	num_rows: 10
+}
+schema_info: {
+	name: "table2"
+}
+`
+
+func makeSyncerDistributedState(t *testing.T) *distributedpb.DistributedState {
+	ds := &distributedpb.DistributedState{}
+	require.NoError(t, proto.UnmarshalText(syncerDistributedState, ds))
+	return ds
+}
+
+func TestPlannerStateSyncer_PassesChanges(t *testing.T) {
+	ctrl := gomock.NewController(t)
+	defer ctrl.Finish()
+
+	ds := makeSyncerDistributedState(t)
+	at := &fakeAgentsTracker{agentsInfo: tracker.NewTestAgentsInfo(ds)}
+	planner := mock_controllers.NewMockPlanner(ctrl)
+	syncer := controllers.NewPlannerStateSyncer(planner, at)
+
+	// The first call passes the whole state, and one without changes doesn't call the planner.
+	planner.EXPECT().SetDistributedState(ds).Return(nil)
+	require.NoError(t, syncer.Sync())
+	require.NoError(t, syncer.Sync())
+
+	// Change agent1 and table1, add agent3, and remove agent2 and table2.
+	newDS := makeSyncerDistributedState(t)
+	newDS.CarnotInfo[0].ASID = 789
+	newDS.CarnotInfo[1] = &distributedpb.CarnotInfo{QueryBrokerAddress: "agent3"}
+	newDS.SchemaInfo[0].NumRows = 20
+	newDS.SchemaInfo = newDS.SchemaInfo[:1]
+	at.agentsInfo = tracker.NewTestAgentsInfo(newDS)
+
+	planner.EXPECT().UpdateDistributedState(
+		&distributedpb.DistributedState{
+			CarnotInfo: []*distributedpb.CarnotInfo{newDS.CarnotInfo[0], newDS.CarnotInfo[1]},
+			SchemaInfo: []*distributedpb.SchemaInfo{newDS.SchemaInfo[0]},
+		},
+		&distributedpb.DistributedState{
+			CarnotInfo: []*distributedpb.CarnotInfo{{QueryBrokerAddress: "agent2"}},
+			SchemaInfo: []*distributedpb.SchemaInfo{{Name: "table2"}},
+		}).Return(nil)
+	require.NoError(t, syncer.Sync())
+	require.NoError(t, syncer.Sync())
+}
+
+func TestPlannerStateSyncer_SetsWholeStateAfterError(t *testing.T) {
+	ctrl := gomock.NewController(t)
+	defer ctrl.Finish()
+
+	ds := makeSyncerDistributedState(t)
+	at := &fakeAgentsTracker{agentsInfo: tracker.NewTestAgentsInfo(ds)}
+	planner := mock_controllers.NewMockPlanner(ctrl)
+	syncer := controllers.NewPlannerStateSyncer(planner, at)
+
+	planner.EXPECT().SetDistributedState(ds).Return(nil)
+	require.NoError(t, syncer.Sync())
+
+	// The tracker updates the Carnot instances in place, which the syncer has to notice.
+	ds.CarnotInfo[0].ASID = 789
+	at.agentsInfo = tracker.NewTestAgentsInfo(ds)
+	planner.EXPECT().UpdateDistributedState(gomock.Any(), gomock.Any()).Return(errors.New("failed"))
+	require.Error(t, syncer.Sync())
+
+	planner.EXPECT().SetDistributedState(ds).Return(nil)
+	require.NoError(t, syncer.Sync())
+}
@@ -75,6 +75,7 @@ type QueryExecutorImpl struct {
 	mdconf              metadatapb.MetadataConfigServiceClient
 	resultForwarder     QueryResultForwarder
 	planner             Planner
+	plannerStateSyncer  *PlannerStateSyncer
 
 	eg *errgroup.Group
 
@@ -97,6 +98,7 @@ func NewQueryExecutorFromServer(s *Server, mutExecFactory MutationExecFactory) Q
 		s.mdconf,
 		s.resultForwarder,
 		s.planner,
+		s.plannerStateSyncer,
 		mutExecFactory,
 	)
 }
@@ -112,6 +114,7 @@ func NewQueryExecutor(
 	mdconf metadatapb.MetadataConfigServiceClient,
 	resultForwarder QueryResultForwarder,
 	planner Planner,
+	plannerStateSyncer *PlannerStateSyncer,
 	mutExecFactory MutationExecFactory,
 ) QueryExecutor {
 	return &QueryExecutorImpl{
@@ -124,6 +127,7 @@ func NewQueryExecutor(
 		mdconf:              mdconf,
 		resultForwarder:     resultForwarder,
 		planner:             planner,
+		plannerStateSyncer:  plannerStateSyncer,
 		mutationExecFactory: mutExecFactory,
 	}
 }
@@ -263,11 +267,17 @@ func (q *QueryExecutorImpl) runMutation(ctx context.Context, resultCh chan<- *vi
 	return nil
 }
 
-func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *plannerpb.QueryRequest, planOpts *planpb.PlanOptions, distributedState *distributedpb.DistributedState) (*distributedpb.DistributedPlan, error) {
+func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *plannerpb.QueryRequest, planOpts *planpb.PlanOptions) (*distributedpb.DistributedPlan, error) {
 	info := q.agentsTracker.GetAgentInfo()
 	if info == nil {
 		return nil, status.Error(codes.Unavailable, "not ready yet")
 	}
+	// The planner keeps the distributed state, so only its changes are passed on instead of the whole
+	// state with every query.
+	if err := q.plannerStateSyncer.Sync(); err != nil {
+		log.WithError(err).Errorf("Failed to update the distributed state of the planner")
+		return nil, status.Errorf(codes.Internal, "error setting up the compiler")
+	}
 
 	redactOptions, err := q.dataPrivacy.RedactionOptions(ctx)
 	if err != nil {
@@ -275,7 +285,6 @@ func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vi
 		return nil, status.Errorf(codes.Internal, "error setting up the compiler")
 	}
 	plannerState := &distributedpb.LogicalPlannerState{
-		DistributedState:    distributedState,
 		PlanOptions:         planOpts,
 		ResultAddress:       q.resultAddress,
 		ResultSSLTargetName: q.resultSSLTargetName,
@@ -284,7 +293,7 @@ func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vi
 
 	// Compile the query plan.
 	start := time.Now()
-	plannerResultPB, err := q.planner.Plan(plannerState, req)
+	plannerResultPB, err := q.planner.PlanWithStoredState(plannerState, req)
 	if err != nil {
 		// send the compilation error and return nil.
 		return nil, err
@@ -376,9 +385,8 @@ func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *
 		return err
 	}
 
-	distributedState := q.agentsTracker.GetAgentInfo().DistributedState()
-
 	if req.Mutation {
+		distributedState := q.agentsTracker.GetAgentInfo().DistributedState()
 		if err := q.runMutation(ctx, resultCh, req, planOpts, &distributedState); err != nil {
 			return err
 		}
@@ -390,7 +398,7 @@ func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *
 		return err
 	}
 
-	plan, err := q.compilePlan(ctx, resultCh, convertedReq, planOpts, &distributedState)
+	plan, err := q.compilePlan(ctx, resultCh, convertedReq, planOpts)
 	if err != nil {
 		return err
 	}
@@ -398,13 +398,20 @@ func runTestCase(t *testing.T, test *queryExecTestCase) {
 
 	planner := mock_controllers.NewMockPlanner(ctrl)
 	if test.Req.QueryID == "" {
+		// The distributed state is stored in the planner rather than passed with the query.
+		plannerState := *test.PlannerState
+		plannerState.DistributedState = nil
 		planner.EXPECT().
-			Plan(test.PlannerState, gomock.Any()).
+			SetDistributedState(test.PlannerState.DistributedState).
+			Return(nil)
+		planner.EXPECT().
+			PlanWithStoredState(&plannerState, gomock.Any()).
 			Return(test.ExpectedPlannerResult, nil)
 	}
 
 	dp := &fakeDataPrivacy{}
-	queryExec := controllers.NewQueryExecutor("qb_address", "qb_hostname", at, dp, nc, nil, nil, rf, planner, test.MutExecFactory)
+	syncer := controllers.NewPlannerStateSyncer(planner, at)
+	queryExec := controllers.NewQueryExecutor("qb_address", "qb_hostname", at, dp, nc, nil, nil, rf, planner, syncer, test.MutExecFactory)
 	consumer := newTestConsumer(test.ConsumeErrs)
 
 	assert.Equal(t, test.QueryExecExpectedRunError, queryExec.Run(context.Background(), test.Req, consumer))
@@ -60,6 +60,9 @@ const (
 // Planner describes the interface for any planner.
 type Planner interface {
 	Plan(planState *distributedpb.LogicalPlannerState, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
+	SetDistributedState(distributedState *distributedpb.DistributedState) error
+	UpdateDistributedState(upserts, removals *distributedpb.DistributedState) error
+	PlanWithStoredState(planState *distributedpb.LogicalPlannerState, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
 	CompileMutations(planState *distributedpb.LogicalPlannerState, request *plannerpb.CompileMutationsRequest) (*plannerpb.CompileMutationsResponse, error)
 	Free()
 }
@@ -84,7 +87,8 @@ type Server struct {
 	mdconf          metadatapb.MetadataConfigServiceClient
 	resultForwarder QueryResultForwarder
 
-	planner Planner
+	planner            Planner
+	plannerStateSyncer *PlannerStateSyncer
 
 	queryExecFactory QueryExecutorFactory
 }
@@ -120,16 +124,17 @@ func NewServerWithForwarderAndPlanner(env querybrokerenv.QueryBrokerEnv,
 	planner Planner,
 	queryExecFactory QueryExecutorFactory) (*Server, error) {
 	s := &Server{
-		env:               env,
-		agentsTracker:     agentsTracker,
-		dataPrivacy:       dataPrivacy,
-		resultForwarder:   resultForwarder,
-		natsConn:          natsConn,
-		mdtp:              mds,
-		mdconf:            mdconf,
-		planner:           planner,
-		queryExecFactory:  queryExecFactory,
-		healthcheckQuitCh: make(chan struct{}),
+		env:                env,
+		agentsTracker:      agentsTracker,
+		dataPrivacy:        dataPrivacy,
+		resultForwarder:    resultForwarder,
+		natsConn:           natsConn,
+		mdtp:               mds,
+		mdconf:             mdconf,
+		planner:            planner,
+		plannerStateSyncer: NewPlannerStateSyncer(planner, agentsTracker),
+		queryExecFactory:   queryExecFactory,
+		healthcheckQuitCh:  make(chan struct{}),
 	}
 	s.hcStatus.Store(fmt.Errorf("no healthcheck has run yet"))
 	go s.runHealthcheck()
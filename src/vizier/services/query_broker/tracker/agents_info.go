@@ -118,18 +118,26 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 				createdAgents++
 			}
 
+			var load *distributedpb.CarnotLoad
+			if carnotInfo, present := carnotInfoMap[agentUUID]; present {
+				load = carnotInfo.Load
+			}
 			if agent.Info.Capabilities == nil || agent.Info.Capabilities.CollectsData {
 				var metadataInfo *distributedpb.MetadataInfo
+				var tableInfo []*distributedpb.TableInfo
 				if carnotInfo, present := carnotInfoMap[agentUUID]; present {
 					metadataInfo = carnotInfo.MetadataInfo
+					tableInfo = carnotInfo.TableInfo
 				}
 				// this is a PEM
 				carnotInfoMap[agentUUID] = makeAgentCarnotInfo(agentUUID, agent.ASID, metadataInfo)
+				carnotInfoMap[agentUUID].TableInfo = tableInfo
 			} else {
 				// this is a Kelvin
 				kelvinGRPCAddress := agent.Info.IPAddress
 				carnotInfoMap[agentUUID] = makeKelvinCarnotInfo(agentUUID, kelvinGRPCAddress, agent.ASID)
 			}
+			carnotInfoMap[agentUUID].Load = load
 		}
 		// case 2: agent data info update
 		dataInfo := agentUpdate.GetDataInfo()
@@ -146,6 +154,14 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 			if dataInfo.MetadataInfo != nil {
 				carnotInfo.MetadataInfo = dataInfo.MetadataInfo
 			}
+			// The time ranges of the tables come with every heartbeat of a PEM, and ranges that are a
+			// heartbeat stale only make the planner keep a source it could have pruned.
+			if len(dataInfo.TableInfo) > 0 {
+				carnotInfo.TableInfo = dataInfo.TableInfo
+			}
+			if dataInfo.Load != nil {
+				carnotInfo.Load = dataInfo.Load
+			}
 		}
 		// case 3: agent deleted
 		if agentUpdate.GetDeleted() {
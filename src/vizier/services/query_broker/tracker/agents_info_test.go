@@ -154,6 +154,20 @@ func makeTestAgentDataInfo() []*messagespb.AgentDataInfo {
 					},
 				},
 			},
+			TableInfo: []*distributedpb.TableInfo{
+				{
+					Table: "table1",
+					TimeRange: &distributedpb.TimeRange{
+						MinTimeNS: 10,
+						MaxTimeNS: 20,
+					},
+				},
+			},
+			Load: &distributedpb.CarnotLoad{
+				CpuUsage:          0.5,
+				MemoryBytes:       1024,
+				NumRunningQueries: 2,
+			},
 		},
 		{
 			MetadataInfo: &distributedpb.MetadataInfo{
@@ -185,6 +199,10 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 
 	agents := makeTestAgents(t)
 	agentDataInfos := makeTestAgentDataInfo()
+	kelvinLoad := &distributedpb.CarnotLoad{
+		CpuUsage:         0.25,
+		NumQueuedQueries: 1,
+	}
 
 	agentsInfo := tracker.NewAgentsInfo()
 	assert.NotNil(t, agentsInfo)
@@ -212,6 +230,14 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 				Agent: agents[1],
 			},
 		},
+		{
+			AgentID: uuidpbs[1],
+			Update: &metadatapb.AgentUpdate_DataInfo{
+				DataInfo: &messagespb.AgentDataInfo{
+					Load: kelvinLoad,
+				},
+			},
+		},
 	}
 
 	// Update schema
@@ -246,6 +272,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 		AcceptsRemoteSources: false,
 		ASID:                 123,
 		MetadataInfo:         agentDataInfos[0].MetadataInfo,
+		TableInfo:            agentDataInfos[0].TableInfo,
+		Load:                 agentDataInfos[0].Load,
 	}
 
 	expectedKelvinInfo := &distributedpb.CarnotInfo{
@@ -258,6 +286,7 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 		AcceptsRemoteSources: true,
 		ASID:                 456,
 		SSLTargetName:        "kelvin.pl.svc",
+		Load:                 kelvinLoad,
 	}
 
 	agentsMap := make(map[uuid.UUID]*distributedpb.CarnotInfo)
@@ -279,6 +308,7 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 		Info:            agents[0].Info,
 		ASID:            agents[0].ASID,
 	}
+	// The second data info has no table info or load, so those of the first one are kept.
 	expectedPEM1Info.MetadataInfo = agentDataInfos[1].MetadataInfo
 
 	expectedPEM2Info := &distributedpb.CarnotInfo{
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package messagebus
+
+import (
+	"bytes"
+	"compress/gzip"
+	"encoding/binary"
+	"errors"
+	"io"
+)
+
+// Agents may coalesce several messages into one NATS message, or compress large ones. Those are
+// sent in an envelope which starts with a zero byte, which a serialized protobuf never does.
+// The envelope is the marker byte, a flags byte, and the body: every message prefixed with its
+// varint encoded length. See src/common/event/nats.h for the encoder.
+const (
+	envelopeMarker     = 0
+	envelopeCompressed = 1
+)
+
+// DecodeEnvelope splits the data of a NATS message into the serialized messages it holds.
+// Data that is not an envelope is returned as the only message.
+func DecodeEnvelope(data []byte) ([][]byte, error) {
+	if len(data) == 0 || data[0] != envelopeMarker {
+		return [][]byte{data}, nil
+	}
+	if len(data) < 2 {
+		return nil, errors.New("envelope is missing its flags")
+	}
+
+	body := data[2:]
+	if data[1]&envelopeCompressed != 0 {
+		r, err := gzip.NewReader(bytes.NewReader(body))
+		if err != nil {
+			return nil, err
+		}
+		body, err = io.ReadAll(r)
+		if err != nil {
+			return nil, err
+		}
+	}
+
+	var msgs [][]byte
+	for len(body) > 0 {
+		size, n := binary.Uvarint(body)
+		if n <= 0 {
+			return nil, errors.New("truncated message size in envelope")
+		}
+		body = body[n:]
+		if size > uint64(len(body)) {
+			return nil, errors.New("truncated message in envelope")
+		}
+		msgs = append(msgs, body[:size])
+		body = body[size:]
+	}
+	return msgs, nil
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package messagebus_test
+
+import (
+	"bytes"
+	"compress/gzip"
+	"encoding/binary"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+
+	"px.dev/pixie/src/vizier/utils/messagebus"
+)
+
+func buildBody(msgs ...[]byte) []byte {
+	var body []byte
+	size := make([]byte, binary.MaxVarintLen64)
+	for _, m := range msgs {
+		n := binary.PutUvarint(size, uint64(len(m)))
+		body = append(body, size[:n]...)
+		body = append(body, m...)
+	}
+	return body
+}
+
+func TestDecodeEnvelope_Plain(t *testing.T) {
+	data := []byte{0x0a, 0x03, 'a', 'b', 'c'}
+	msgs, err := messagebus.DecodeEnvelope(data)
+	require.NoError(t, err)
+	assert.Equal(t, [][]byte{data}, msgs)
+}
+
+func TestDecodeEnvelope_Coalesced(t *testing.T) {
+	long := bytes.Repeat([]byte{'x'}, 300)
+	data := append([]byte{0, 0}, buildBody([]byte("first"), []byte{}, long)...)
+	msgs, err := messagebus.DecodeEnvelope(data)
+	require.NoError(t, err)
+	assert.Equal(t, [][]byte{[]byte("first"), {}, long}, msgs)
+}
+
+func TestDecodeEnvelope_Compressed(t *testing.T) {
+	long := bytes.Repeat([]byte{'x'}, 4096)
+	var buf bytes.Buffer
+	buf.Write([]byte{0, 1})
+	w := gzip.NewWriter(&buf)
+	_, err := w.Write(buildBody(long, []byte("second")))
+	require.NoError(t, err)
+	require.NoError(t, w.Close())
+
+	msgs, err := messagebus.DecodeEnvelope(buf.Bytes())
+	require.NoError(t, err)
+	assert.Equal(t, [][]byte{long, []byte("second")}, msgs)
+}
+
+func TestDecodeEnvelope_Truncated(t *testing.T) {
+	_, err := messagebus.DecodeEnvelope([]byte{0})
+	assert.Error(t, err)
+	_, err = messagebus.DecodeEnvelope([]byte{0, 0, 0x80})
+	assert.Error(t, err)
+	_, err = messagebus.DecodeEnvelope([]byte{0, 0, 5, 'a'})
+	assert.Error(t, err)
+	_, err = messagebus.DecodeEnvelope([]byte{0, 1, 'g', 'a', 'r'})
+	assert.Error(t, err)
+}